@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_frames.cpp
+//
+// Identification: src/buffer/buffer_frames.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_frames.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace bustub {
+
+namespace {
+
+/** The policy of mbind that places the memory on the node if it can, and elsewhere rather than failing. */
+constexpr int MPOL_PREFERRED_NODE = 1;
+/** The nodes the node mask of mbind can name. */
+constexpr size_t MAX_NUMA_NODES = 1024;
+constexpr size_t BITS_PER_WORD = 8 * sizeof(unsigned long);  // NOLINT
+
+size_t RoundUp(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+/** @return a private anonymous mapping of size bytes, aligned on alignment, nullptr if there is no memory */
+char *MapAligned(size_t size, size_t alignment) {
+  size_t mapped_size = size + alignment;
+  void *mapped = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) {
+    return nullptr;
+  }
+  auto begin = reinterpret_cast<uintptr_t>(mapped);
+  uintptr_t aligned = RoundUp(begin, alignment);
+  if (aligned > begin) {
+    munmap(mapped, aligned - begin);
+  }
+  uintptr_t end = begin + mapped_size;
+  if (end > aligned + size) {
+    munmap(reinterpret_cast<void *>(aligned + size), end - aligned - size);
+  }
+  return reinterpret_cast<char *>(aligned);
+}
+
+}  // namespace
+
+BufferFrames::BufferFrames(size_t num_frames, int numa_node) : num_frames_(num_frames) {
+  if (num_frames == 0) {
+    return;
+  }
+  size_t data_size = num_frames * PAGE_SIZE;
+  size_t metadata_offset = RoundUp(data_size, alignof(Page));
+  bool huge = data_size >= HUGE_PAGE_SIZE;
+  size_t alignment = huge ? HUGE_PAGE_SIZE : static_cast<size_t>(getpagesize());
+  region_size_ = RoundUp(metadata_offset + num_frames * sizeof(Page), alignment);
+
+  if (huge) {
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    void *mapped = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mapped != MAP_FAILED) {
+      region_ = static_cast<char *>(mapped);
+      huge_tlb_ = true;
+    }
+#endif
+  }
+  if (region_ == nullptr) {
+    region_ = MapAligned(region_size_, alignment);
+    if (region_ == nullptr) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge) {
+      madvise(region_, region_size_, MADV_HUGEPAGE);
+    }
+#endif
+  }
+
+  if (numa_node != NO_NUMA_NODE && GetNumNumaNodes() > 1 && BindToNode(region_, region_size_, numa_node)) {
+    numa_node_ = numa_node;
+  }
+
+  // The mapping is zeroed, which the frames need their page data to be.
+  pages_ = reinterpret_cast<Page *>(region_ + metadata_offset);
+  for (size_t i = 0; i < num_frames; i++) {
+    new (&pages_[i]) Page(region_ + i * PAGE_SIZE);
+  }
+}
+
+BufferFrames::~BufferFrames() {
+  if (region_ == nullptr) {
+    return;
+  }
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  munmap(region_, region_size_);
+}
+
+void BufferFrames::Discard(frame_id_t frame_id) {
+  if (huge_tlb_) {
+    return;
+  }
+  madvise(region_ + static_cast<size_t>(frame_id) * PAGE_SIZE, PAGE_SIZE, MADV_DONTNEED);
+}
+
+int BufferFrames::GetNumNumaNodes() {
+  static const int NUM_NUMA_NODES = [] {
+    // e.g. "0-3", or "0,2" on a machine with a node offline; the nodes are numbered up to the last one.
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (!std::getline(online, nodes)) {
+      return 1;
+    }
+    size_t last = nodes.find_last_of(",-");
+    try {
+      return std::stoi(last == std::string::npos ? nodes : nodes.substr(last + 1)) + 1;
+    } catch (const std::logic_error &e) {
+      return 1;
+    }
+  }();
+  return NUM_NUMA_NODES;
+}
+
+bool BufferFrames::BindToNode(void *region, size_t size, int numa_node) {
+#ifdef SYS_mbind
+  if (numa_node < 0 || static_cast<size_t>(numa_node) >= MAX_NUMA_NODES) {
+    return false;
+  }
+  unsigned long node_mask[MAX_NUMA_NODES / BITS_PER_WORD] = {};  // NOLINT
+  node_mask[numa_node / BITS_PER_WORD] = 1UL << (numa_node % BITS_PER_WORD);
+  return syscall(SYS_mbind, region, size, MPOL_PREFERRED_NODE, node_mask, MAX_NUMA_NODES + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
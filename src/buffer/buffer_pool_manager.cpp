@@ -12,149 +12,354 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <list>
+#include <string>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/macros.h"
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+thread_local BufferPoolManager::FetchStats BufferPoolManager::thread_fetch_stats_;
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerType replacer_type, size_t max_pool_size)
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager, replacer_type, max_pool_size) {}
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+BufferPoolManager::BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                     DiskManager *disk_manager, LogManager *log_manager, ReplacerType replacer_type,
+                                     size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      frames_(max_pool_size_, num_instances > 1 ? static_cast<int>(instance_index) % BufferFrames::GetNumNumaNodes()
+                                           : NO_NUMA_NODE),
+      pages_(frames_.GetPages()),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      page_table_(max_pool_size_),
+      retired_(max_pool_size_, false) {
+  BUSTUB_ASSERT(num_instances > 0, "a standalone buffer pool is a pool of one instance");
+  BUSTUB_ASSERT(instance_index < num_instances, "instance index must be smaller than the number of instances");
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
+  io_in_progress_ = std::make_unique<std::atomic<bool>[]>(max_pool_size_);
+  io_cv_ = std::make_unique<std::condition_variable_any[]>(max_pool_size_);
+  bgwriter_holds_ = std::make_unique<std::atomic<bool>[]>(max_pool_size_);
+  bgwriter_displaced_ = std::make_unique<std::atomic<bool>[]>(max_pool_size_);
+
+  // Initially, every page is in the free list, claimed; the frames reserved beyond the pool size are retired.
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].pin_count_ = FRAME_CLAIMED;
+    if (i < pool_size) {
+      free_list_.emplace_back(static_cast<int>(i));
+    } else {
+      retired_[i] = true;
+    }
   }
+
+  MetricsRegistry *registry = MetricsRegistry::Global();
+  registry->RegisterHistogram(this, "buffer_pool.read_latency_us", &read_latency_us_);
+  registry->RegisterHistogram(this, "buffer_pool.write_latency_us", &write_latency_us_);
+  registry->RegisterCounter(this, "buffer_pool.hits", &num_hits_);
+  registry->RegisterCounter(this, "buffer_pool.misses", &num_misses_);
+  registry->RegisterCounter(this, "buffer_pool.swizzled_hits", &num_swizzled_hits_);
+  registry->RegisterCounter(this, "buffer_pool.secondary_hits", &num_secondary_hits_);
+  registry->RegisterCounter(this, "buffer_pool.evictions", &num_evictions_);
+  registry->RegisterCounter(this, "buffer_pool.dirty_writes", &num_dirty_writes_);
+  registry->RegisterCounter(this, "buffer_pool.latch_contended", [this] { return latch_.GetNumContended(); });
+  registry->RegisterCounter(this, "memory.buffer_pool_bytes", [this] { return pool_size_ * PAGE_SIZE; });
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
+  MetricsRegistry::Global()->Unregister(this);
+  BufferPoolManager::StopPageDump();
+  BufferPoolManager::StopBackgroundWriter();
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
   delete replacer_;
 }
 
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) { return FetchPageImpl(page_id, nullptr); }
+
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id, BufferRing *ring) {
   // 1.     Search the page table for the requested page (P).
-  latch_.lock();
-  auto iter = page_table_.find(page_id);
-  if (iter != page_table_.end()) {
-    frame_id_t frameId = iter->second;
-    replacer_->Pin(frameId);
-    pages_[frameId].pin_count_++;
-    latch_.unlock();
-    return &pages_[frameId];
+  // 1.1    If P exists, pin it and return it immediately, without the latch.
+  if (Page *frame = TryPinResident(page_id); frame != nullptr) {
+    num_hits_.Add();
+    RecordFetch(page_id, true);
+    return frame;
   }
-  // 1.1    If P exists, pin it and return it immediately.
+
+  std::unique_lock<SpinMutex> lock(latch_);
+  // The page may still be on its way out of a reassigned frame; reading it from disk now could see stale data.
+  WaitForWriteBack(&lock, page_id);
+
+  // 1.1    P may have been missed, e.g. while being read in; look again with the latch held.
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id)) {
+    Page *frame = &pages_[frame_id];
+    frame->pin_count_++;
+    replacer_->Pin(frame_id);
+    if (bgwriter_holds_[frame_id]) {
+      bgwriter_displaced_[frame_id] = true;
+    }
+    // Another fetcher may still be reading P in; wait until the frame holds its contents.
+    io_cv_[frame_id].wait(lock, [&] { return !io_in_progress_[frame_id]; });
+    if (frame->page_id_ != page_id) {
+      // The read failed and P was dropped; try reading it ourselves.
+      DropPin(frame_id);
+      lock.unlock();
+      return FetchPageImpl(page_id, ring);
+    }
+    lock.unlock();
+    num_hits_.Add();
+    RecordFetch(page_id, true);
+    return frame;
+  }
+
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  Page *new_frame = nullptr;
-  frame_id_t new_frame_id;
+  //        Note that pages are always found from the free list first, unless a buffer ring has a frame to recycle.
+  const bool from_ring = FindRingFrame(ring, &frame_id);
+  if (!from_ring && !FindFreeFrame(&frame_id)) {
+    return nullptr;
+  }
+  if (ring != nullptr) {
+    ring->Advance(page_id);
+  }
+  Page *frame = &pages_[frame_id];
 
-  if (!free_list_.empty()) {
-    new_frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (!replacer_->Victim(&new_frame_id)) {
+  // 2.     Delete R from the page table and insert P, marking the frame as busy until the disk work is done. R goes
+  //        to the secondary cache if it is clean, and P comes out of it.
+  const page_id_t old_page_id = frame->page_id_;
+  const bool write_back = ReserveFrame(frame_id, page_id);
+  SecondaryCache::Ticket evicted_ticket;
+  SecondaryCache::Ticket cached_ticket;
+  const bool to_cache = !from_ring && ReserveCacheSlot(old_page_id, write_back, &evicted_ticket);
+  const bool cached = secondary_cache_ != nullptr && secondary_cache_->Take(page_id, &cached_ticket);
+
+  // 3.     Without holding the latch, write R back to the disk if it is dirty, or to the secondary cache if it is
+  //        clean, and read in the content of P, from the secondary cache if it has it.
+  lock.unlock();
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id, frame->GetData());
+    // The background writer is falling behind.
+    bgwriter_cv_.notify_one();
+  }
+  if (to_cache) {
+    secondary_cache_->Write(evicted_ticket, frame->GetData());
+  }
+  num_misses_.Add();
+  RecordFetch(page_id, false);
+  const auto read_start = std::chrono::steady_clock::now();
+  try {
+    if (cached && secondary_cache_->Read(cached_ticket, frame->data_)) {
+      num_secondary_hits_.Add();
+    } else {
+      disk_manager_->ReadPage(page_id, frame->data_);
+    }
+  } catch (ChecksumException &) {
+    lock.lock();
+    ReleaseFrame(frame_id, old_page_id, write_back);
+    DropPage(frame_id);
+    throw;
+  }
+  read_latency_us_.RecordSince(read_start);
+  lock.lock();
+
+  // 4.     Wake up whoever is waiting for P or R, and return a pointer to P.
+  ReleaseFrame(frame_id, old_page_id, write_back);
+  return frame;
+}
+
+Page *BufferPoolManager::FetchChildPageImpl(Page *parent, size_t slot, page_id_t page_id) {
+  std::atomic<Page *> *swips = nullptr;
+  if (slot < MAX_SWIZZLED_SLOTS) {
+    swips = parent->swips_.load(std::memory_order_acquire);
+    if (swips == nullptr) {
+      auto *allocated = new std::atomic<Page *>[MAX_SWIZZLED_SLOTS]();
+      if (parent->swips_.compare_exchange_strong(swips, allocated)) {
+        swips = allocated;
+      } else {
+        delete[] allocated;
+      }
+    }
+    // The reference may be to a frame of another instance of a parallel pool, if the page was in another one.
+    const auto child = reinterpret_cast<uintptr_t>(swips[slot].load(std::memory_order_relaxed));
+    const auto first = reinterpret_cast<uintptr_t>(pages_);
+    if (child >= first && child < first + max_pool_size_ * sizeof(Page)) {
+      auto frame_id = static_cast<frame_id_t>((child - first) / sizeof(Page));
+      if (Page *frame = TryPinFrame(frame_id, page_id); frame != nullptr) {
+        num_hits_.Add();
+        num_swizzled_hits_.Add();
+        RecordFetch(page_id, true);
+        return frame;
+      }
+    }
+  }
+  Page *frame = FetchPageImpl(page_id);
+  if (frame != nullptr && swips != nullptr) {
+    swips[slot].store(frame, std::memory_order_relaxed);
+  }
+  return frame;
+}
+
+Page *BufferPoolManager::TryPinResident(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
     return nullptr;
   }
-  new_frame = &pages_[new_frame_id];
+  return TryPinFrame(frame_id, page_id);
+}
 
-  // 2.     If R is dirty, write it back to the disk.
-  if (new_frame->IsDirty()) {
-    disk_manager_->WritePage(new_frame->GetPageId(), new_frame->GetData());
+Page *BufferPoolManager::TryPinFrame(frame_id_t frame_id, page_id_t page_id) {
+  Page *frame = &pages_[frame_id];
+  if (frame->pin_count_.fetch_add(1) < 0) {
+    // The frame is free or being handed to another page under the latch.
+    frame->pin_count_.fetch_sub(1);
+    return nullptr;
   }
-  // 3.     Delete R from the page table and insert P.
-  page_table_.erase(new_frame->GetPageId());
-  page_table_[page_id] = new_frame_id;
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  // Pinned, the frame keeps its page; the lookup may have been stale, or the page may still be being read in.
+  if (frame->page_id_ != page_id || io_in_progress_[frame_id]) {
+    UnpinFrame(frame_id);
+    return nullptr;
+  }
+  replacer_->Pin(frame_id);
+  // The frame left the replacer for good if the background writer holds it; the writer puts it back.
+  if (bgwriter_holds_[frame_id]) {
+    bgwriter_displaced_[frame_id] = true;
+  }
+  return frame;
+}
 
-  disk_manager_->ReadPage(page_id, new_frame->data_);
-  new_frame->is_dirty_ = false;
-  new_frame->pin_count_ = 1;
-  new_frame->page_id_ = page_id;
-  replacer_->Pin(new_frame_id);
-  latch_.unlock();
+bool BufferPoolManager::ClaimFrame(frame_id_t frame_id) {
+  int pin_count = 0;
+  return pages_[frame_id].pin_count_.compare_exchange_strong(pin_count, FRAME_CLAIMED);
+}
 
-  return new_frame;
+void BufferPoolManager::UnpinFrame(frame_id_t frame_id) {
+  // A frame may be in the replacer while pinned, and Victim skips it then; the last unpin makes sure it is back.
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+void BufferPoolManager::RecordFetch(page_id_t page_id, bool hit) {
+  thread_fetch_stats_.num_fetches_++;
+  thread_fetch_stats_.num_hits_ += hit ? 1 : 0;
+  if (FetchTrace *trace = fetch_trace_.load(std::memory_order_relaxed); trace != nullptr) {
+    trace->Record(page_id, hit);
+  }
 }
 
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
-  latch_.lock();
-  frame_id_t frame_id = page_table_[page_id];
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    // A lookup without the latch may miss a page whose entry is being moved.
+    std::scoped_lock lock(latch_);
+    if (!page_table_.Find(page_id, &frame_id)) {
+      return false;
+    }
+  }
   Page *frame = &pages_[frame_id];
-  frame->is_dirty_ = is_dirty;
 
-  if (frame->GetPinCount() <= 0) {
-    latch_.unlock();
+  // The caller's pin keeps the page in its frame; a frame holding another page, or claimed, was not pinned.
+  if (frame->page_id_ != page_id || frame->pin_count_ <= 0) {
     return false;
   }
-
-  frame->pin_count_--;
-  if (frame->pin_count_ == 0){
-    replacer_->Unpin(frame_id);
+  // Dirty before unpinned, so that the page is written back if its frame is then taken.
+  if (is_dirty) {
+    frame->is_dirty_ = true;
   }
-  latch_.unlock();
+  UnpinFrame(frame_id);
   return true;
 }
 
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  latch_.lock();
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end()) {
+  std::unique_lock<SpinMutex> lock(latch_);
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
     return false;
   }
 
-  frame_id_t frame_id = iter->second;
   auto frame = &pages_[frame_id];
+  io_cv_[frame_id].wait(lock, [&] { return !io_in_progress_[frame_id]; });
+  // The frame may have been handed to another page while we were waiting.
+  if (frame->page_id_ != page_id) {
+    return false;
+  }
 
+  ResetRecLSN(frame);
   disk_manager_->WritePage(page_id, frame->GetData());
   frame->is_dirty_ = false;
-  latch_.unlock();
-
   return true;
 }
 
 Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  return NewPageImpl(page_id, INVALID_PAGE_ID, INVALID_PAGE_ID);
+}
+
+Page *BufferPoolManager::NewPageImpl(page_id_t *page_id, page_id_t hint, page_id_t owner) {
   // 0.   Make sure you call DiskManager::AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  latch_.lock();
+  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+  std::unique_lock<SpinMutex> lock(latch_);
   frame_id_t frame_id;
-
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (!replacer_->Victim(&frame_id)) {
-    latch_.unlock();
+  if (!FindFreeFrame(&frame_id)) {
     return nullptr;
   }
-
-  *page_id = disk_manager_->AllocatePage();
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-
-
+  *page_id = AllocatePage(hint, owner);
   auto frame = &pages_[frame_id];
 
-  if (frame->page_id_ != INVALID_PAGE_ID){
-    disk_manager_->WritePage(frame->page_id_, frame->GetData());
+  // 3.   Update P's metadata and add P to the page table. The old page is written back and the memory zeroed out
+  //      without holding the latch.
+  const page_id_t old_page_id = frame->page_id_;
+  const bool write_back = ReserveFrame(frame_id, *page_id);
+  SecondaryCache::Ticket evicted_ticket;
+  const bool to_cache = ReserveCacheSlot(old_page_id, write_back, &evicted_ticket);
+  lock.unlock();
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id, frame->GetData());
+    bgwriter_cv_.notify_one();
   }
-
-  page_table_.erase(frame->page_id_);
-  frame->is_dirty_ = false;
-  frame->pin_count_ = 1;
-
-  frame->page_id_ = *page_id;
-  replacer_->Pin(frame_id);
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
+  if (to_cache) {
+    secondary_cache_->Write(evicted_ticket, frame->GetData());
+  }
+  frame->ResetMemory();
+  lock.lock();
+  ReleaseFrame(frame_id, old_page_id, write_back);
 
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  page_table_[*page_id] = frame_id;
-
-  memset(frame->data_, 0, sizeof(frame->data_));
-  latch_.unlock();
   return frame;
 }
 
@@ -162,22 +367,30 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 0.   Make sure you call DiskManager::DeallocatePage!
   // 1.   Search the page table for the requested page (P).
   latch_.lock();
-  if (page_table_.count(page_id) < 1) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    // A copy in the secondary cache would outlive the page, and be read back once its id is reused.
+    SecondaryCache::Ticket ticket;
+    if (secondary_cache_ != nullptr) {
+      secondary_cache_->Take(page_id, &ticket);
+    }
     latch_.unlock();
     return true;
   }
   // 1.   If P does not exist, return true.
-  auto frame_id = page_table_[page_id];
   auto frame = &pages_[frame_id];
-  if (frame->GetPinCount() > 0) {
+  if (!ClaimFrame(frame_id)) {
     latch_.unlock();
     return false;
   }
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page. Otherwise the frame is
+  //      claimed, free from now on.
 
   disk_manager_->DeallocatePage(page_id);
-  page_table_.erase(page_id);
-  free_list_.push_back(frame_id);
+  page_table_.Erase(page_id);
+  // The frame is no longer a candidate for eviction once it is back on the free list.
+  replacer_->Remove(frame_id);
+  FreeFrame(frame_id);
   frame->page_id_ = INVALID_PAGE_ID;
   frame->is_dirty_ = false;
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
@@ -188,15 +401,672 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
 
 void BufferPoolManager::FlushAllPagesImpl() {
   // You can do it!
-  for (size_t i = 0; i < pool_size_; i++) {
+  std::unique_lock<SpinMutex> lock(latch_);
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    io_cv_[i].wait(lock, [&] { return !io_in_progress_[i]; });
+  }
+  // Pick the pages without letting go of the latch, so that none of their frames is handed to another page before
+  // they are written, and write them all at once, in the order of their ids. A frame whose I/O started since waited
+  // on is being read in, and is skipped.
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  for (size_t i = 0; i < max_pool_size_; i++) {
     auto frame = &pages_[i];
-    if (frame->page_id_ == INVALID_PAGE_ID) {
+    if (frame->page_id_ == INVALID_PAGE_ID || io_in_progress_[i]) {
       continue;
     }
 
-    disk_manager_->WritePage(frame->GetPageId(), frame->GetData());
+    ResetRecLSN(frame);
+    writes.emplace_back(frame->GetPageId(), frame->GetData());
     frame->is_dirty_ = false;
   }
+  disk_manager_->WritePages(writes);
+}
+
+void BufferPoolManager::PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::lock_guard<std::mutex> guard(prefetch_latch_);
+  if (!prefetch_thread_.joinable()) {
+    prefetch_thread_ = std::thread(&BufferPoolManager::RunPrefetcher, this);
+  }
+  for (auto page_id : page_ids) {
+    // There is no point in queueing more pages than the pool can hold; they would only evict each other.
+    if (page_id != INVALID_PAGE_ID && prefetch_queue_.size() < pool_size_) {
+      prefetch_queue_.push_back(page_id);
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::RunPrefetcher() {
+  // The prefetch thread owns its backend, so that a batch costs as few system calls as the backend allows.
+  std::unique_ptr<DiskBackend> backend = disk_manager_->CreateDiskBackend();
+  // A batch pins its frames until it completes; keep that a small part of the pool.
+  const size_t batch_size = std::clamp<size_t>(pool_size_ / 8, 1, PREFETCH_BATCH_SIZE);
+  std::vector<page_id_t> batch;
+  std::unique_lock<std::mutex> prefetch_lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(prefetch_lock, [&] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    while (!prefetch_queue_.empty() && batch.size() < batch_size) {
+      batch.push_back(prefetch_queue_.front());
+      prefetch_queue_.pop_front();
+    }
+    prefetch_lock.unlock();
+    PrefetchBatch(batch, backend.get());
+    batch.clear();
+    prefetch_lock.lock();
+  }
+}
+
+void BufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids, DiskBackend *backend) {
+  std::vector<DiskRequest> reads;
+  for (auto page_id : page_ids) {
+    std::unique_lock<SpinMutex> lock(latch_);
+    // Pages that are resident or still being written back will be found by FetchPage without a read.
+    frame_id_t frame_id;
+    if (page_table_.Find(page_id, &frame_id) || write_back_table_.count(page_id) > 0) {
+      continue;
+    }
+    if (!FindFreeFrame(&frame_id)) {
+      break;
+    }
+    Page *frame = &pages_[frame_id];
+
+    // Reserve the frame exactly like a cache miss in FetchPageImpl. A FetchPage that arrives before the read
+    // completes pins the frame and waits for it.
+    const page_id_t old_page_id = frame->page_id_;
+    const bool write_back = ReserveFrame(frame_id, page_id);
+    SecondaryCache::Ticket evicted_ticket;
+    SecondaryCache::Ticket cached_ticket;
+    const bool to_cache = ReserveCacheSlot(old_page_id, write_back, &evicted_ticket);
+    const bool cached = secondary_cache_ != nullptr && secondary_cache_->Take(page_id, &cached_ticket);
+    lock.unlock();
+    if (write_back) {
+      disk_manager_->WritePage(old_page_id, frame->GetData());
+    }
+    if (to_cache) {
+      secondary_cache_->Write(evicted_ticket, frame->GetData());
+    }
+
+    auto complete = [this, frame, frame_id, page_id, old_page_id, write_back](bool success) {
+      const bool verified = success && disk_manager_->VerifyPageChecksum(page_id, frame->GetData());
+      std::lock_guard<SpinMutex> guard(latch_);
+      ReleaseFrame(frame_id, old_page_id, write_back);
+      if (!verified) {
+        // Leave it to FetchPage to read the page again and report the error.
+        DropPage(frame_id);
+        return;
+      }
+      // Drop the pin taken by ReserveFrame, leaving the page to whoever fetches it next.
+      UnpinFrame(frame_id);
+    };
+    if (cached && secondary_cache_->Read(cached_ticket, frame->data_)) {
+      num_secondary_hits_.Add();
+      complete(true);
+    } else if (backend == nullptr) {
+      bool success = true;
+      try {
+        disk_manager_->ReadPage(page_id, frame->data_);
+      } catch (ChecksumException &) {
+        success = false;
+      }
+      complete(success);
+    } else {
+      reads.emplace_back(DiskRequest::ReadPage(page_id, frame->data_, complete));
+    }
+  }
+  if (backend != nullptr) {
+    backend->Submit(&reads);
+    backend->Wait();
+  }
+}
+
+bool BufferPoolManager::IsPageResident(page_id_t page_id) {
+  frame_id_t frame_id;
+  return page_table_.Find(page_id, &frame_id) && pages_[frame_id].page_id_ == page_id && !io_in_progress_[frame_id];
+}
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPages() {
+  std::vector<page_id_t> page_ids;
+  std::vector<bool> listed(max_pool_size_, false);
+  std::scoped_lock lock(latch_);
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].pin_count_ > 0) {
+      page_ids.push_back(pages_[i].page_id_);
+      listed[i] = true;
+    }
+  }
+  std::vector<frame_id_t> candidates = replacer_->EvictionCandidates(max_pool_size_);
+  for (auto iter = candidates.rbegin(); iter != candidates.rend(); ++iter) {
+    if (pages_[*iter].page_id_ != INVALID_PAGE_ID && !listed[*iter]) {
+      page_ids.push_back(pages_[*iter].page_id_);
+      listed[*iter] = true;
+    }
+  }
+  // A replacer that does not rank its frames leaves the rest unordered.
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && !listed[i]) {
+      page_ids.push_back(pages_[i].page_id_);
+    }
+  }
+  return page_ids;
+}
+
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+  // Write the dump aside and rename it over the old one, so that a crash mid-dump leaves the previous dump whole.
+  const std::string temp_name = file_name + ".tmp";
+  FILE *file = fopen(temp_name.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  for (auto page_id : GetResidentPages()) {
+    fprintf(file, "%d\n", page_id);
+  }
+  if (fclose(file) != 0) {
+    remove(temp_name.c_str());
+    return false;
+  }
+  return rename(temp_name.c_str(), file_name.c_str()) == 0;
+}
+
+size_t BufferPoolManager::LoadResidentPages(const std::string &file_name) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    return 0;
+  }
+  std::vector<page_id_t> page_ids;
+  const size_t pool_size = GetPoolSize();
+  page_id_t page_id;
+  while (page_ids.size() < pool_size && file >> page_id) {
+    if (page_id != INVALID_PAGE_ID) {
+      page_ids.push_back(page_id);
+    }
+  }
+  for (size_t begin = 0; begin < page_ids.size(); begin += PAGE_LOAD_CHUNK) {
+    auto end = page_ids.begin() + std::min(begin + PAGE_LOAD_CHUNK, page_ids.size());
+    std::sort(page_ids.begin() + begin, end);
+  }
+  PrefetchPages(page_ids);
+  return page_ids.size();
+}
+
+void BufferPoolManager::StartPageDump(const std::string &file_name, std::chrono::milliseconds interval) {
+  std::lock_guard<std::mutex> guard(page_dump_latch_);
+  if (page_dump_thread_.joinable()) {
+    return;
+  }
+  page_dump_stop_ = false;
+  page_dump_thread_ = std::thread(&BufferPoolManager::RunPageDump, this, file_name, interval);
+}
+
+void BufferPoolManager::StopPageDump() {
+  {
+    std::lock_guard<std::mutex> guard(page_dump_latch_);
+    page_dump_stop_ = true;
+  }
+  page_dump_cv_.notify_all();
+  if (page_dump_thread_.joinable()) {
+    page_dump_thread_.join();
+  }
+}
+
+void BufferPoolManager::RunPageDump(const std::string &file_name, std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> page_dump_lock(page_dump_latch_);
+  while (!page_dump_cv_.wait_for(page_dump_lock, interval, [&] { return page_dump_stop_; })) {
+    page_dump_lock.unlock();
+    DumpResidentPages(file_name);
+    page_dump_lock.lock();
+  }
+  page_dump_lock.unlock();
+  DumpResidentPages(file_name);
+}
+
+bool BufferPoolManager::Resize(size_t new_size, std::chrono::milliseconds timeout) {
+  if (new_size == 0 || new_size > max_pool_size_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> resize_guard(resize_latch_);
+  std::vector<frame_id_t> retired;
+  {
+    std::scoped_lock lock(latch_);
+    // Growing: free the retired frames, and put back in the replacer those a shrink that timed out left resident.
+    for (size_t i = pool_size_; i < new_size; i++) {
+      auto frame_id = static_cast<frame_id_t>(i);
+      if (retired_[i]) {
+        retired_[i] = false;
+        free_list_.push_back(frame_id);
+      } else if (pages_[i].pin_count_ == 0) {
+        replacer_->Unpin(frame_id);
+      }
+    }
+    // Shrinking: from now on no frame past new_size is handed to a page; the free ones are retired at once.
+    pool_size_ = new_size;
+    free_list_.remove_if([&](frame_id_t frame_id) {
+      if (static_cast<size_t>(frame_id) < new_size) {
+        return false;
+      }
+      retired_[frame_id] = true;
+      retired.push_back(frame_id);
+      return true;
+    });
+  }
+
+  // Retire the others as they are unpinned, writing back the dirty ones, until none is left or the time is up.
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  bool done = false;
+  while (true) {
+    std::vector<frame_id_t> dirty_frames;
+    std::lock_guard<std::mutex> write_back_guard(write_back_latch_);
+    std::unique_lock<SpinMutex> lock(latch_);
+    done = true;
+    for (size_t i = new_size; i < max_pool_size_; i++) {
+      if (!retired_[i]) {
+        if (RetireFrame(static_cast<frame_id_t>(i), &dirty_frames)) {
+          retired.push_back(static_cast<frame_id_t>(i));
+        } else {
+          done = false;
+        }
+      }
+    }
+    if (done || std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    if (dirty_frames.empty()) {
+      lock.unlock();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } else {
+      WriteBackFrames(dirty_frames, &lock);
+    }
+  }
+  // Nobody uses a retired frame until Resize grows the pool again.
+  for (auto frame_id : retired) {
+    frames_.Discard(frame_id);
+  }
+  return done;
+}
+
+void BufferPoolManager::RunBackgroundWriter(double clean_ratio, std::chrono::milliseconds interval) {
+  std::lock_guard<std::mutex> guard(bgwriter_latch_);
+  if (bgwriter_thread_.joinable()) {
+    return;
+  }
+  bgwriter_stop_ = false;
+  bgwriter_thread_ = std::thread(&BufferPoolManager::RunBgWriter, this, clean_ratio, interval);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::lock_guard<std::mutex> guard(bgwriter_latch_);
+    bgwriter_stop_ = true;
+  }
+  bgwriter_cv_.notify_all();
+  if (bgwriter_thread_.joinable()) {
+    bgwriter_thread_.join();
+  }
+}
+
+void BufferPoolManager::RunBgWriter(double clean_ratio, std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> bgwriter_lock(bgwriter_latch_);
+  while (!bgwriter_stop_) {
+    bgwriter_lock.unlock();
+    const size_t pool_size = pool_size_;
+    const auto clean_target = static_cast<size_t>(std::ceil(clean_ratio * static_cast<double>(pool_size)));
+    WriteAheadOfEviction(std::min(clean_target, pool_size));
+    WriteBackCheckpointPages(std::chrono::steady_clock::now());
+    bgwriter_lock.lock();
+    bgwriter_cv_.wait_for(bgwriter_lock, interval);
+  }
+}
+
+size_t BufferPoolManager::WriteAheadOfEviction(size_t clean_target) {
+  // 1.   Pick the dirty frames among the next victims.
+  std::lock_guard<std::mutex> write_back_guard(write_back_latch_);
+  std::vector<frame_id_t> dirty_frames;
+  std::unique_lock<SpinMutex> lock(latch_);
+  size_t num_clean = free_list_.size();
+  for (auto frame_id : replacer_->EvictionCandidates(max_pool_size_)) {
+    if (num_clean >= clean_target) {
+      break;
+    }
+    if (pages_[frame_id].is_dirty_) {
+      dirty_frames.push_back(frame_id);
+    }
+    num_clean++;
+  }
+  // 2.   Write them back.
+  return WriteBackFrames(dirty_frames, &lock);
+}
+
+size_t BufferPoolManager::WriteBackCheckpointPages(std::chrono::steady_clock::time_point now) {
+  const lsn_t checkpoint_lsn = checkpoint_lsn_;
+  if (checkpoint_lsn == INVALID_LSN) {
+    return 0;
+  }
+  // 1.   The mean latency of the writes since the last round, of the background writer or not.
+  const HistogramSnapshot writes = write_latency_us_.Snapshot();
+  const uint64_t num_writes = writes.count_ - paced_num_writes_;
+  const uint64_t write_time_us = writes.sum_ - paced_write_time_us_;
+  const std::chrono::microseconds write_latency(num_writes == 0 ? 0 : write_time_us / num_writes);
+  paced_num_writes_ = writes.count_;
+  paced_write_time_us_ = writes.sum_;
+
+  // 2.   Pick the pages of the checkpoint still dirty, and ask the pacer how many of them to write.
+  std::lock_guard<std::mutex> write_back_guard(write_back_latch_);
+  std::vector<std::pair<lsn_t, frame_id_t>> checkpoint_frames;
+  size_t num_dirty = 0;
+  std::unique_lock<SpinMutex> lock(latch_);
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    if (!pages_[frame_id].is_dirty_) {
+      continue;
+    }
+    num_dirty++;
+    if (!io_in_progress_[frame_id] && pages_[frame_id].rec_lsn_ < checkpoint_lsn) {
+      checkpoint_frames.emplace_back(pages_[frame_id].rec_lsn_, frame_id);
+    }
+  }
+  const int64_t log_offset = disk_manager_ == nullptr ? 0 : disk_manager_->GetLogSize();
+  if (checkpoint_lsn != paced_checkpoint_lsn_) {
+    paced_checkpoint_lsn_ = checkpoint_lsn;
+    checkpoint_pacer_.BeginCheckpoint(checkpoint_frames.size(), log_offset, now);
+  }
+  const size_t num_pages =
+      checkpoint_pacer_.PagesToWrite(checkpoint_frames.size(), static_cast<double>(num_dirty) / pool_size_,
+                                     log_offset, write_latency, now);
+
+  // 3.   Write the oldest ones back, whose records keep the redo of the next checkpoint furthest back.
+  if (num_pages < checkpoint_frames.size()) {
+    std::nth_element(checkpoint_frames.begin(), checkpoint_frames.begin() + num_pages, checkpoint_frames.end());
+    checkpoint_frames.resize(num_pages);
+  }
+  std::vector<frame_id_t> dirty_frames;
+  for (const auto &[rec_lsn, frame_id] : checkpoint_frames) {
+    dirty_frames.push_back(frame_id);
+  }
+  return WriteBackFrames(dirty_frames, &lock);
+}
+
+size_t BufferPoolManager::FlushDirtyPages(size_t max_pages_per_second) {
+  if (max_pages_per_second == 0) {
+    std::lock_guard<std::mutex> write_back_guard(write_back_latch_);
+    std::vector<frame_id_t> dirty_frames;
+    std::unique_lock<SpinMutex> lock(latch_);
+    for (size_t i = 0; i < max_pool_size_; i++) {
+      auto frame_id = static_cast<frame_id_t>(i);
+      if (pages_[frame_id].is_dirty_ && !io_in_progress_[frame_id]) {
+        dirty_frames.push_back(frame_id);
+      }
+    }
+    return WriteBackFrames(dirty_frames, &lock);
+  }
+
+  // Paced: walk the dirty pages in id order, a double-write batch at a time, holding nothing between two batches.
+  // A frame may be handed to another page meanwhile, so each batch is picked again among the frames still dirty.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  {
+    std::scoped_lock lock(latch_);
+    for (size_t i = 0; i < max_pool_size_; i++) {
+      if (pages_[i].is_dirty_ && !io_in_progress_[i]) {
+        dirty_pages.emplace_back(pages_[i].page_id_, static_cast<frame_id_t>(i));
+      }
+    }
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+  const auto start = std::chrono::steady_clock::now();
+  size_t num_written = 0;
+  for (size_t begin = 0; begin < dirty_pages.size(); begin += DOUBLE_WRITE_BATCH_SIZE) {
+    std::this_thread::sleep_until(start + std::chrono::microseconds(num_written * 1000000 / max_pages_per_second));
+    const size_t end = std::min(dirty_pages.size(), begin + DOUBLE_WRITE_BATCH_SIZE);
+    std::lock_guard<std::mutex> write_back_guard(write_back_latch_);
+    std::vector<frame_id_t> dirty_frames;
+    std::unique_lock<SpinMutex> lock(latch_);
+    for (size_t i = begin; i < end; i++) {
+      const auto [page_id, frame_id] = dirty_pages[i];
+      if (pages_[frame_id].page_id_ == page_id && pages_[frame_id].is_dirty_ && !io_in_progress_[frame_id]) {
+        dirty_frames.push_back(frame_id);
+      }
+    }
+    num_written += WriteBackFrames(dirty_frames, &lock);
+  }
+  return num_written;
+}
+
+int64_t BufferPoolManager::GetDirtyPageTable(std::unordered_map<page_id_t, lsn_t> *dirty_page_table) {
+  std::scoped_lock lock(latch_);
+  int64_t rec_log_offset = INT64_MAX;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    Page *frame = &pages_[i];
+    // A pinned page may be modified before it is unpinned dirty.
+    if (frame->page_id_ != INVALID_PAGE_ID && (frame->is_dirty_ || frame->pin_count_ > 0)) {
+      (*dirty_page_table)[frame->page_id_] = frame->rec_lsn_;
+      rec_log_offset = std::min(rec_log_offset, frame->rec_log_offset_);
+    }
+  }
+  for (const auto &[page_id, rec] : write_back_rec_lsns_) {
+    (*dirty_page_table)[page_id] = rec.first;
+    rec_log_offset = std::min(rec_log_offset, rec.second);
+  }
+  return rec_log_offset;
+}
+
+size_t BufferPoolManager::WriteBackFrames(const std::vector<frame_id_t> &dirty_frames,
+                                          std::unique_lock<SpinMutex> *lock) {
+  // 0.   Sort the frames by page id, so that the batches are written mostly sequentially, adjacent pages together.
+  std::vector<frame_id_t> sorted_frames(dirty_frames);
+  std::sort(sorted_frames.begin(), sorted_frames.end(),
+            [&](frame_id_t a, frame_id_t b) { return pages_[a].page_id_ < pages_[b].page_id_; });
+
+  // 1.   Pin the frames so they stay put while being written. The unpinned ones stay in the replacer, so that writing
+  //      them does not count as an access; whoever takes one out while it is being written records that in
+  //      bgwriter_displaced_. The pinned ones are put back in the replacer by whoever unpins them last.
+  //      A hit pinning a frame without the latch sees it held, or was counted before the frame was pinned here.
+  for (auto frame_id : sorted_frames) {
+    bgwriter_holds_[frame_id] = true;
+    bgwriter_displaced_[frame_id] = false;
+    if (pages_[frame_id].pin_count_.fetch_add(1) > 0) {
+      bgwriter_displaced_[frame_id] = true;
+    }
+  }
+  lock->unlock();
+
+  // 2.   Write them without the latch, in batches of DiskManager::WritePages. The read latches of the pages of a batch
+  //      keep writers out until it is written, and the dirty flag is cleared first so that a modification made right
+  //      after is not lost. Only the first page of a batch waits for its latch: a page whose latch is taken ends the
+  //      batch before, so that no latch is waited for while others are held.
+  size_t num_written = 0;
+  std::vector<frame_id_t> batch;
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  auto write_batch = [&] {
+    if (!writes.empty()) {
+      const auto write_start = std::chrono::steady_clock::now();
+      disk_manager_->WritePages(writes);
+      write_latency_us_.RecordSince(write_start);
+    }
+    num_written += writes.size();
+    num_dirty_writes_.Add(writes.size());
+    writes.clear();
+    for (auto frame_id : batch) {
+      Page *frame = &pages_[frame_id];
+      frame->RUnlatch();
+      lock->lock();
+      if (frame->pin_count_.fetch_sub(1) == 1 && bgwriter_displaced_[frame_id]) {
+        replacer_->Unpin(frame_id);
+      }
+      bgwriter_holds_[frame_id] = false;
+      bgwriter_displaced_[frame_id] = false;
+      lock->unlock();
+    }
+    batch.clear();
+  };
+  for (auto frame_id : sorted_frames) {
+    Page *frame = &pages_[frame_id];
+    if (!frame->TryRLatch()) {
+      write_batch();
+      frame->RLatch();
+    }
+    batch.push_back(frame_id);
+    // WAL: the page may only reach the disk after the log records that modified it.
+    const bool log_is_persistent =
+        !enable_logging || log_manager_ == nullptr || frame->GetLSN() <= log_manager_->GetPersistentLSN();
+    if (log_is_persistent) {
+      lock->lock();
+      frame->is_dirty_ = false;
+      ResetRecLSN(frame);
+      lock->unlock();
+      writes.emplace_back(frame->GetPageId(), frame->GetData());
+    }
+    if (batch.size() == DOUBLE_WRITE_BATCH_SIZE) {
+      write_batch();
+    }
+  }
+  write_batch();
+  return num_written;
+}
+
+bool BufferPoolManager::FindFreeFrame(frame_id_t *frame_id) {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  while (replacer_->Victim(frame_id)) {
+    // Frames held by the background writer are still in the replacer but must not be reused; it puts them back.
+    if (bgwriter_holds_[*frame_id]) {
+      bgwriter_displaced_[*frame_id] = true;
+      continue;
+    }
+    // A frame Resize is retiring stays out of the replacer; Resize evicts its page.
+    if (static_cast<size_t>(*frame_id) >= pool_size_) {
+      continue;
+    }
+    // A frame pinned by a hit since it entered the replacer is skipped; its last unpin puts it back.
+    if (ClaimFrame(*frame_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BufferPoolManager::FindRingFrame(BufferRing *ring, frame_id_t *frame_id) {
+  if (ring == nullptr || ring->Current() == INVALID_PAGE_ID) {
+    return false;
+  }
+  if (!page_table_.Find(ring->Current(), frame_id) || static_cast<size_t>(*frame_id) >= pool_size_ ||
+      !ClaimFrame(*frame_id)) {
+    return false;
+  }
+  replacer_->Remove(*frame_id);
+  return true;
+}
+
+bool BufferPoolManager::ReserveFrame(frame_id_t frame_id, page_id_t page_id) {
+  Page *frame = &pages_[frame_id];
+  const bool write_back = frame->page_id_ != INVALID_PAGE_ID && frame->is_dirty_;
+  if (frame->page_id_ != INVALID_PAGE_ID) {
+    num_evictions_.Add();
+    page_table_.Erase(frame->page_id_);
+    if (write_back) {
+      num_dirty_writes_.Add();
+      write_back_table_[frame->page_id_] = frame_id;
+      write_back_rec_lsns_[frame->page_id_] = {frame->rec_lsn_, frame->rec_log_offset_};
+    }
+  }
+  frame->page_id_ = page_id;
+  frame->is_dirty_ = false;
+  ResetRecLSN(frame);
+  io_in_progress_[frame_id] = true;
+  page_table_.Insert(page_id, frame_id);
+  replacer_->Pin(frame_id);
+  // Release the claim, keeping the increments of the hits that are about to back off from it.
+  frame->pin_count_.fetch_add(1 - FRAME_CLAIMED);
+  return write_back;
+}
+
+void BufferPoolManager::ReleaseFrame(frame_id_t frame_id, page_id_t old_page_id, bool write_back) {
+  if (write_back) {
+    write_back_table_.erase(old_page_id);
+    write_back_rec_lsns_.erase(old_page_id);
+  }
+  io_in_progress_[frame_id] = false;
+  io_cv_[frame_id].notify_all();
+}
+
+void BufferPoolManager::ResetRecLSN(Page *frame) {
+  // The records modifying the page from now on get an LSN from the next one on, and are written past the log so far.
+  frame->rec_lsn_ = log_manager_ == nullptr ? 0 : log_manager_->GetNextLSN();
+  frame->rec_log_offset_ = disk_manager_ == nullptr ? 0 : disk_manager_->GetLogSize();
+}
+
+void BufferPoolManager::DropPage(frame_id_t frame_id) {
+  Page *frame = &pages_[frame_id];
+  page_table_.Erase(frame->page_id_);
+  frame->page_id_ = INVALID_PAGE_ID;
+  frame->is_dirty_ = false;
+  DropPin(frame_id);
+}
+
+void BufferPoolManager::DropPin(frame_id_t frame_id) {
+  // The frame is in neither the page table nor the replacer, so nobody else can take it until the last pin is gone.
+  // A stale hit may pin it meanwhile, and then puts it in the replacer with its own last unpin.
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1 && ClaimFrame(frame_id)) {
+    FreeFrame(frame_id);
+  }
+}
+
+bool BufferPoolManager::ReserveCacheSlot(page_id_t old_page_id, bool write_back, SecondaryCache::Ticket *ticket) {
+  if (secondary_cache_ == nullptr || old_page_id == INVALID_PAGE_ID || write_back) {
+    return false;
+  }
+  *ticket = secondary_cache_->Reserve(old_page_id);
+  return true;
+}
+
+void BufferPoolManager::FreeFrame(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) < pool_size_) {
+    free_list_.push_back(frame_id);
+  } else {
+    retired_[frame_id] = true;
+  }
+}
+
+bool BufferPoolManager::RetireFrame(frame_id_t frame_id, std::vector<frame_id_t> *dirty_frames) {
+  Page *frame = &pages_[frame_id];
+  if (bgwriter_holds_[frame_id] || io_in_progress_[frame_id] || !ClaimFrame(frame_id)) {
+    return false;
+  }
+  // An unpin sets the dirty flag before dropping its pin, so a claimed frame's flag is up to date.
+  if (frame->is_dirty_) {
+    frame->pin_count_.fetch_add(-FRAME_CLAIMED);
+    dirty_frames->push_back(frame_id);
+    return false;
+  }
+  replacer_->Remove(frame_id);
+  if (frame->page_id_ != INVALID_PAGE_ID) {
+    num_evictions_.Add();
+    page_table_.Erase(frame->page_id_);
+    frame->page_id_ = INVALID_PAGE_ID;
+  }
+  retired_[frame_id] = true;
+  return true;
+}
+
+void BufferPoolManager::WaitForWriteBack(std::unique_lock<SpinMutex> *lock, page_id_t page_id) {
+  for (auto iter = write_back_table_.find(page_id); iter != write_back_table_.end();
+       iter = write_back_table_.find(page_id)) {
+    io_cv_[iter->second].wait(*lock);
+  }
+}
+
+page_id_t BufferPoolManager::AllocatePage(page_id_t hint, page_id_t owner) {
+  if (num_instances_ == 1) {
+    return disk_manager_->AllocatePage(hint, owner);
+  }
+  const page_id_t next_page_id = next_page_id_;
+  next_page_id_ += static_cast<page_id_t>(num_instances_);
+  BUSTUB_ASSERT(next_page_id % static_cast<page_id_t>(num_instances_) == static_cast<page_id_t>(instance_index_),
+                "allocated page id must belong to this instance");
+  return next_page_id;
 }
 
 }  // namespace bustub
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checkpoint_pacer.cpp
+//
+// Identification: src/buffer/checkpoint_pacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/checkpoint_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bustub {
+
+void CheckpointPacer::BeginCheckpoint(size_t num_pages, int64_t log_offset,
+                                      std::chrono::steady_clock::time_point now) {
+  num_pages_ = num_pages;
+  log_offset_ = log_offset;
+  time_progress_ = 0;
+  progress_ = num_pages == 0 ? 1 : 0;
+  last_call_ = now;
+}
+
+size_t CheckpointPacer::PagesToWrite(size_t num_pages, double dirty_ratio, int64_t log_offset,
+                                     std::chrono::microseconds write_latency,
+                                     std::chrono::steady_clock::time_point now) {
+  const std::chrono::duration<double> elapsed = now - last_call_;
+  last_call_ = now;
+  const double speedup = std::max(1.0, dirty_ratio / dirty_ratio_);
+  const double slowdown =
+      std::max(1.0, static_cast<double>(write_latency.count()) / static_cast<double>(write_latency_.count()));
+  const std::chrono::duration<double> spread = spread_ * slowdown / speedup;
+  time_progress_ += elapsed / spread;
+  const double log_progress = static_cast<double>(log_offset - log_offset_) / static_cast<double>(log_spread_);
+  progress_ = std::min(1.0, std::max(progress_, std::max(time_progress_, log_progress)));
+  // The pages left past the progress, of those the checkpoint left dirty.
+  const auto num_left = static_cast<size_t>(std::floor((1 - progress_) * static_cast<double>(num_pages_)));
+  return num_pages > num_left ? num_pages - num_left : 0;
+}
+
+}  // namespace bustub
@@ -14,16 +14,85 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages),
+      ref_(std::make_unique<std::atomic<uint8_t>[]>(num_pages)),
+      in_replacer_(std::make_unique<std::atomic<uint8_t>[]>(num_pages)) {
+  for (size_t i = 0; i < num_pages_; ++i) {
+    ref_[i].store(0, std::memory_order_relaxed);
+    in_replacer_[i].store(0, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+size_t ClockReplacer::AdvanceHand() {
+  size_t hand = hand_.load(std::memory_order_relaxed);
+  while (!hand_.compare_exchange_weak(hand, (hand + 1) % num_pages_, std::memory_order_relaxed)) {
+  }
+  return hand;
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  // Every frame in the replacer has its reference bit cleared after one full sweep, so a victim is found within two
+  // sweeps unless concurrent unpins keep setting bits; re-checking the size bounds the loop when the replacer drains.
+  while (size_.load(std::memory_order_acquire) > 0) {
+    size_t frame = AdvanceHand();
+    if (in_replacer_[frame].load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    // Second chance: a referenced frame only loses its bit this time around.
+    if (ref_[frame].exchange(0, std::memory_order_acq_rel) != 0) {
+      continue;
+    }
+    uint8_t expected = 1;
+    if (in_replacer_[frame].compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_release);
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+  }
+  return false;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if (in_replacer_[frame_id].exchange(0, std::memory_order_acq_rel) != 0) {
+    size_.fetch_sub(1, std::memory_order_release);
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  // Set the reference bit before publishing the frame, so a sweeping Victim never sees it in the replacer unreferenced.
+  ref_[frame_id].store(1, std::memory_order_release);
+  if (in_replacer_[frame_id].exchange(1, std::memory_order_acq_rel) == 0) {
+    size_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+std::vector<frame_id_t> ClockReplacer::EvictionCandidates(size_t max_frames) {
+  // Unreferenced frames go first on the next sweep, referenced ones only after they lose their second chance.
+  std::vector<frame_id_t> candidates;
+  std::vector<frame_id_t> referenced;
+  const size_t hand = hand_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < num_pages_ && candidates.size() < max_frames; i++) {
+    const size_t frame = (hand + i) % num_pages_;
+    if (in_replacer_[frame].load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    if (ref_[frame].load(std::memory_order_acquire) == 0) {
+      candidates.push_back(static_cast<frame_id_t>(frame));
+    } else {
+      referenced.push_back(static_cast<frame_id_t>(frame));
+    }
+  }
+  for (size_t i = 0; i < referenced.size() && candidates.size() < max_frames; i++) {
+    candidates.push_back(referenced[i]);
+  }
+  return candidates;
+}
+
+size_t ClockReplacer::Size() {
+  return static_cast<size_t>(std::max<int64_t>(0, size_.load(std::memory_order_acquire)));
+}
 
 }  // namespace bustub
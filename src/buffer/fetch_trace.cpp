@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_trace.cpp
+//
+// Identification: src/buffer/fetch_trace.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/fetch_trace.h"
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FetchTraceWriter::FetchTraceWriter(const std::string &file_name) : file_(fopen(file_name.c_str(), "wb")) {
+  if (file_ == nullptr) {
+    throw Exception("can't open " + file_name);
+  }
+  buffer_.reserve(BUFFER_SIZE);
+}
+
+FetchTraceWriter::~FetchTraceWriter() {
+  std::scoped_lock lock(latch_);
+  WriteBuffer();
+  fclose(file_);
+}
+
+void FetchTraceWriter::Record(page_id_t page_id, bool hit) {
+  std::scoped_lock lock(latch_);
+  buffer_.push_back(page_id);
+  if (buffer_.size() == BUFFER_SIZE) {
+    WriteBuffer();
+  }
+}
+
+void FetchTraceWriter::WriteBuffer() {
+  fwrite(buffer_.data(), sizeof(page_id_t), buffer_.size(), file_);
+  buffer_.clear();
+}
+
+std::vector<page_id_t> FetchTraceWriter::Read(const std::string &file_name) {
+  std::vector<page_id_t> page_ids;
+  FILE *file = fopen(file_name.c_str(), "rb");
+  if (file == nullptr) {
+    return page_ids;
+  }
+  page_id_t chunk[BUFFER_SIZE];
+  size_t count;
+  while ((count = fread(chunk, sizeof(page_id_t), BUFFER_SIZE, file)) > 0) {
+    page_ids.insert(page_ids.end(), chunk, chunk + count);
+  }
+  fclose(file);
+  return page_ids;
+}
+
+}  // namespace bustub
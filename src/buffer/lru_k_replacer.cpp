@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : num_pages_(num_pages),
+      k_(k),
+      correlated_period_(correlated_period),
+      history_(num_pages * k, 0),
+      head_(num_pages, 0),
+      count_(num_pages, 0),
+      last_(num_pages, 0),
+      evictable_(num_pages, false) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs at least one reference per frame");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (eviction_order_.empty()) {
+    return false;
+  }
+  // Skip frames that are still within their correlated reference period, unless there is nothing else to evict.
+  auto victim = eviction_order_.begin();
+  for (auto iter = victim; iter != eviction_order_.end(); ++iter) {
+    if (current_timestamp_ - last_[std::get<2>(*iter)] > correlated_period_) {
+      victim = iter;
+      break;
+    }
+  }
+  *frame_id = std::get<2>(*victim);
+  eviction_order_.erase(victim);
+  evictable_[*frame_id] = false;
+  // The frame will hold a different page from now on, so its history no longer applies.
+  count_[*frame_id] = 0;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (static_cast<size_t>(frame_id) >= num_pages_) {
+    return;
+  }
+  if (evictable_[frame_id]) {
+    eviction_order_.erase(KeyOf(frame_id));
+    evictable_[frame_id] = false;
+  }
+
+  const uint64_t now = ++current_timestamp_;
+  if (count_[frame_id] == 0 || now - last_[frame_id] > correlated_period_) {
+    head_[frame_id] = (head_[frame_id] + 1) % k_;
+    history_[frame_id * k_ + head_[frame_id]] = now;
+    if (count_[frame_id] < k_) {
+      count_[frame_id]++;
+    }
+  }
+  last_[frame_id] = now;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (static_cast<size_t>(frame_id) >= num_pages_ || evictable_[frame_id]) {
+    return;
+  }
+  evictable_[frame_id] = true;
+  eviction_order_.insert(KeyOf(frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (static_cast<size_t>(frame_id) >= num_pages_) {
+    return;
+  }
+  if (evictable_[frame_id]) {
+    eviction_order_.erase(KeyOf(frame_id));
+    evictable_[frame_id] = false;
+  }
+  count_[frame_id] = 0;
+  last_[frame_id] = 0;
+}
+
+std::vector<frame_id_t> LRUKReplacer::EvictionCandidates(size_t max_frames) {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> candidates;
+  for (auto iter = eviction_order_.begin(); iter != eviction_order_.end() && candidates.size() < max_frames; ++iter) {
+    candidates.push_back(std::get<2>(*iter));
+  }
+  return candidates;
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return eviction_order_.size();
+}
+
+LRUKReplacer::EvictionKey LRUKReplacer::KeyOf(frame_id_t frame_id) const {
+  if (count_[frame_id] < k_) {
+    return {false, last_[frame_id], frame_id};
+  }
+  return {true, HistoryAt(frame_id, k_), frame_id};
+}
+
+}  // namespace bustub
@@ -14,60 +14,77 @@
 
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) : max_pages(num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : max_pages(num_pages),
+      sentinel(static_cast<frame_id_t>(num_pages)),
+      prev_(num_pages + 1, static_cast<frame_id_t>(num_pages)),
+      next_(num_pages + 1, static_cast<frame_id_t>(num_pages)),
+      in_replacer_(num_pages, false),
+      size_(0) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
   replacer_mutex.lock();
-  if (victim_queue.empty()) {
+  if (size_ == 0) {
     replacer_mutex.unlock();
     return false;
   }
-  *frame_id = victim_queue.front();
-  frame_in_replacer.erase(*frame_id);
-  victim_queue.pop_front();
+  *frame_id = next_[sentinel];
+  Unlink(*frame_id);
   replacer_mutex.unlock();
   return true;
 }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {
   replacer_mutex.lock();
-  if (frame_in_replacer.count(frame_id) < 1) {
-    replacer_mutex.unlock();
-    return;
-  }
-
-  for (auto it_list = victim_queue.begin(); it_list != victim_queue.end(); it_list++) {
-    if (*it_list == frame_id) {
-      victim_queue.erase(it_list);
-      frame_in_replacer.erase(frame_id);
-      break;
-    }
+  if (static_cast<size_t>(frame_id) < max_pages && in_replacer_[frame_id]) {
+    Unlink(frame_id);
   }
-
   replacer_mutex.unlock();
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
   replacer_mutex.lock();
-  if (frame_in_replacer.count(frame_id) > 0) {
-    replacer_mutex.unlock();
-    return;
+  if (static_cast<size_t>(frame_id) < max_pages && !in_replacer_[frame_id]) {
+    PushBack(frame_id);
   }
+  replacer_mutex.unlock();
+}
 
-  if (victim_queue.size() < max_pages) {
-    frame_in_replacer.insert(frame_id);
-    victim_queue.push_back(frame_id);
+std::vector<frame_id_t> LRUReplacer::EvictionCandidates(size_t max_frames) {
+  std::vector<frame_id_t> candidates;
+  replacer_mutex.lock();
+  for (frame_id_t frame_id = next_[sentinel]; frame_id != sentinel && candidates.size() < max_frames;
+       frame_id = next_[frame_id]) {
+    candidates.push_back(frame_id);
   }
   replacer_mutex.unlock();
+  return candidates;
 }
 
 size_t LRUReplacer::Size() {
   replacer_mutex.lock();
-  auto size = victim_queue.size();
+  auto size = size_;
   replacer_mutex.unlock();
   return size;
 }
 
+void LRUReplacer::PushBack(frame_id_t frame_id) {
+  frame_id_t last = prev_[sentinel];
+  prev_[frame_id] = last;
+  next_[frame_id] = sentinel;
+  next_[last] = frame_id;
+  prev_[sentinel] = frame_id;
+  in_replacer_[frame_id] = true;
+  size_++;
+}
+
+void LRUReplacer::Unlink(frame_id_t frame_id) {
+  next_[prev_[frame_id]] = next_[frame_id];
+  prev_[next_[frame_id]] = prev_[frame_id];
+  in_replacer_[frame_id] = false;
+  size_--;
+}
+
 }  // namespace bustub
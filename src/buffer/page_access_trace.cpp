@@ -0,0 +1,162 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.cpp
+//
+// Identification: src/buffer/page_access_trace.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_access_trace.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+namespace {
+
+std::atomic<uint64_t> next_tracer_id{1};
+
+/** The ring the calling thread last recorded to, and the tracer it belongs to. */
+struct CachedRing {
+  uint64_t tracer_id_{0};
+  void *ring_{nullptr};
+};
+thread_local CachedRing cached_ring;
+
+}  // namespace
+
+PageAccessTracer::PageAccessTracer(size_t ring_size)
+    : id_(next_tracer_id.fetch_add(1)), ring_size_(ring_size), start_(std::chrono::steady_clock::now()) {
+  BUSTUB_ASSERT(ring_size > 0, "A ring holds at least one access.");
+}
+
+PageAccessTracer::Ring *PageAccessTracer::ThreadRing() {
+  if (cached_ring.tracer_id_ == id_) {
+    return static_cast<Ring *>(cached_ring.ring_);
+  }
+  std::scoped_lock lock(rings_latch_);
+  std::unique_ptr<Ring> &ring = rings_[std::this_thread::get_id()];
+  if (ring == nullptr) {
+    ring = std::make_unique<Ring>(ring_size_);
+  }
+  cached_ring = {id_, ring.get()};
+  return ring.get();
+}
+
+void PageAccessTracer::Record(page_id_t page_id, bool hit) {
+  Ring *ring = ThreadRing();
+  uint64_t num_recorded = ring->num_recorded_.load(std::memory_order_relaxed);
+  auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+  ring->accesses_[num_recorded % ring_size_] = {static_cast<uint64_t>(timestamp.count()), page_id, INVALID_PAGE_ID,
+                                                hit};
+  ring->num_recorded_.store(num_recorded + 1, std::memory_order_relaxed);
+}
+
+std::vector<PageAccess> PageAccessTracer::Collect() const {
+  std::vector<PageAccess> accesses;
+  std::scoped_lock lock(rings_latch_);
+  for (const auto &[thread_id, ring] : rings_) {
+    uint64_t num_recorded = ring->num_recorded_.load(std::memory_order_relaxed);
+    uint64_t begin = num_recorded > ring_size_ ? num_recorded - ring_size_ : 0;
+    for (uint64_t i = begin; i < num_recorded; i++) {
+      accesses.push_back(ring->accesses_[i % ring_size_]);
+    }
+  }
+  std::stable_sort(accesses.begin(), accesses.end(),
+                   [](const PageAccess &a, const PageAccess &b) { return a.timestamp_ns_ < b.timestamp_ns_; });
+  return accesses;
+}
+
+uint64_t PageAccessTracer::GetNumOverwritten() const {
+  uint64_t num_overwritten = 0;
+  std::scoped_lock lock(rings_latch_);
+  for (const auto &[thread_id, ring] : rings_) {
+    uint64_t num_recorded = ring->num_recorded_.load(std::memory_order_relaxed);
+    num_overwritten += num_recorded > ring_size_ ? num_recorded - ring_size_ : 0;
+  }
+  return num_overwritten;
+}
+
+void PageTrace::ResolveOwners(const std::map<page_id_t, page_id_t> &extent_owners) {
+  std::unordered_set<page_id_t> owners;
+  for (const auto &[extent, owner] : extent_owners) {
+    owners.insert(owner);
+  }
+  for (PageAccess &access : accesses_) {
+    access.owner_ = INVALID_PAGE_ID;
+    if (owners.count(access.page_id_) != 0) {
+      access.owner_ = access.page_id_;
+      continue;
+    }
+    auto iter = extent_owners.upper_bound(access.page_id_);
+    if (iter != extent_owners.begin()) {
+      --iter;
+      if (access.page_id_ - iter->first < static_cast<page_id_t>(EXTENT_SIZE)) {
+        access.owner_ = iter->second;
+      }
+    }
+  }
+}
+
+bool PageTrace::Write(const std::string &file_name) const {
+  FILE *file = fopen(file_name.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  for (const auto &[owner, name] : owner_names_) {
+    fprintf(file, "owner %d %s\n", owner, name.c_str());
+  }
+  for (const PageAccess &access : accesses_) {
+    fprintf(file, "access %" PRIu64 " %d %d %d\n", access.timestamp_ns_, access.page_id_, access.owner_,
+            access.hit_ ? 1 : 0);
+  }
+  return fclose(file) == 0;
+}
+
+bool PageTrace::Read(const std::string &file_name, PageTrace *trace) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    return false;
+  }
+  trace->accesses_.clear();
+  trace->owner_names_.clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    if (kind == "owner") {
+      page_id_t owner;
+      std::string name;
+      if (!(fields >> owner)) {
+        return false;
+      }
+      std::getline(fields >> std::ws, name);
+      trace->owner_names_[owner] = name;
+    } else if (kind == "access") {
+      PageAccess access;
+      int hit;
+      if (!(fields >> access.timestamp_ns_ >> access.page_id_ >> access.owner_ >> hit)) {
+        return false;
+      }
+      access.hit_ = hit != 0;
+      trace->accesses_.push_back(access);
+    } else if (!kind.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  size_t num_slots = 2;
+  int bits = 1;
+  while (num_slots < 2 * num_frames) {
+    num_slots *= 2;
+    bits++;
+  }
+  mask_ = num_slots - 1;
+  shift_ = 64 - bits;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(num_slots);
+  for (size_t i = 0; i < num_slots; i++) {
+    slots_[i].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+size_t PageTable::SlotOf(page_id_t page_id) const {
+  size_t slot = Home(page_id);
+  for (uint64_t entry = slots_[slot].load(std::memory_order_relaxed); entry != EMPTY && PageOf(entry) != page_id;
+       entry = slots_[slot].load(std::memory_order_relaxed)) {
+    slot = (slot + 1) & mask_;
+  }
+  return slot;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  slots_[SlotOf(page_id)].store(MakeEntry(page_id, frame_id), std::memory_order_release);
+}
+
+void PageTable::Erase(page_id_t page_id) {
+  size_t hole = SlotOf(page_id);
+  if (slots_[hole].load(std::memory_order_relaxed) == EMPTY) {
+    return;
+  }
+  // Move back over the hole every entry after it, up to the next free slot, whose probe sequence would otherwise be
+  // cut by the hole. An entry is copied before its old slot is reused, so Find misses it at worst, and only briefly.
+  for (size_t slot = (hole + 1) & mask_;; slot = (slot + 1) & mask_) {
+    const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      break;
+    }
+    // The entry may fill the hole unless its home lies cyclically in (hole, slot].
+    const size_t home = Home(PageOf(entry));
+    if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+      slots_[hole].store(entry, std::memory_order_release);
+      hole = slot;
+    }
+  }
+  slots_[hole].store(EMPTY, std::memory_order_release);
+}
+
+}  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : BufferPoolManager(0, disk_manager, log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "a parallel buffer pool needs at least one instance");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManager>(pool_size, static_cast<uint32_t>(num_instances),
+                                                                static_cast<uint32_t>(i), disk_manager, log_manager,
+                                                                replacer_type, max_pool_size));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The dump thread lists the pages of the instances, so it has to stop before they are destroyed.
+  StopPageDump();
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto &instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+size_t ParallelBufferPoolManager::GetMaxPoolSize() {
+  size_t max_pool_size = 0;
+  for (auto &instance : instances_) {
+    max_pool_size += instance->GetMaxPoolSize();
+  }
+  return max_pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t new_size, std::chrono::milliseconds timeout) {
+  const size_t num_instances = instances_.size();
+  if (new_size < num_instances || new_size > GetMaxPoolSize()) {
+    return false;
+  }
+  // The instances reserve as many frames each, so an even split fits in every one of them.
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  bool done = true;
+  for (size_t i = 0; i < num_instances; i++) {
+    const size_t instance_size = new_size / num_instances + (i < new_size % num_instances ? 1 : 0);
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    left = std::max(left, std::chrono::milliseconds(0));
+    done = instances_[i]->Resize(instance_size, left) && done;
+  }
+  return done;
+}
+
+uint64_t ParallelBufferPoolManager::GetNumLatchContended() const {
+  uint64_t num_contended = 0;
+  for (const auto &instance : instances_) {
+    num_contended += instance->GetNumLatchContended();
+  }
+  return num_contended;
+}
+
+void ParallelBufferPoolManager::RunBackgroundWriter(double clean_ratio, std::chrono::milliseconds interval) {
+  for (auto &instance : instances_) {
+    instance->RunBackgroundWriter(clean_ratio, interval);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto &instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+size_t ParallelBufferPoolManager::FlushDirtyPages(size_t max_pages_per_second) {
+  size_t num_written = 0;
+  for (auto &instance : instances_) {
+    num_written += instance->FlushDirtyPages(max_pages_per_second);
+  }
+  return num_written;
+}
+
+int64_t ParallelBufferPoolManager::GetDirtyPageTable(std::unordered_map<page_id_t, lsn_t> *dirty_page_table) {
+  int64_t rec_log_offset = INT64_MAX;
+  for (auto &instance : instances_) {
+    rec_log_offset = std::min(rec_log_offset, instance->GetDirtyPageTable(dirty_page_table));
+  }
+  return rec_log_offset;
+}
+
+void ParallelBufferPoolManager::SetCheckpointLSN(lsn_t lsn) {
+  for (auto &instance : instances_) {
+    instance->SetCheckpointLSN(lsn);
+  }
+}
+
+bool ParallelBufferPoolManager::IsPageResident(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->IsPageResident(page_id);
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPages() {
+  // Interleave the instances' lists, so that the hottest pages of each come before the colder ones of any.
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t max_pages = 0;
+  for (auto &instance : instances_) {
+    instance_pages.emplace_back(instance->GetResidentPages());
+    max_pages = std::max(max_pages, instance_pages.back().size());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < max_pages; rank++) {
+    for (const auto &pages : instance_pages) {
+      if (rank < pages.size()) {
+        page_ids.push_back(pages[rank]);
+      }
+    }
+  }
+  return page_ids;
+}
+
+void ParallelBufferPoolManager::SetSecondaryCache(SecondaryCache *cache) {
+  for (auto &instance : instances_) {
+    instance->SetSecondaryCache(cache);
+  }
+}
+
+void ParallelBufferPoolManager::SetFetchTrace(FetchTrace *trace) {
+  for (auto &instance : instances_) {
+    instance->SetFetchTrace(trace);
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()].get();
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id, BufferRing *ring) {
+  const size_t index = static_cast<size_t>(page_id) % instances_.size();
+  BufferRing *partition = ring == nullptr ? nullptr : ring->Partition(index, instances_.size());
+  return instances_[index]->FetchPageWithRing(page_id, partition);
+}
+
+Page *ParallelBufferPoolManager::FetchChildPageImpl(Page *parent, size_t slot, page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchChildPage(parent, slot, page_id);
+}
+
+void ParallelBufferPoolManager::PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> partitions(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      partitions[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!partitions[i].empty()) {
+      instances_[i]->PrefetchPages(partitions[i]);
+    }
+  }
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id, page_id_t hint, page_id_t owner) {
+  size_t start;
+  {
+    std::lock_guard<std::mutex> guard(next_instance_latch_);
+    start = next_instance_;
+    next_instance_ = (next_instance_ + 1) % instances_.size();
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    Page *page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+}  // namespace bustub
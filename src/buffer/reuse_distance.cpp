@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// reuse_distance.cpp
+//
+// Identification: src/buffer/reuse_distance.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/reuse_distance.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace bustub {
+
+namespace {
+
+/** Counts the marked positions of a prefix of the trace in O(log n). */
+class FenwickTree {
+ public:
+  explicit FenwickTree(size_t size) : tree_(size + 1, 0) {}
+
+  void Add(size_t position, int64_t delta) {
+    for (size_t i = position + 1; i < tree_.size(); i += i & (~i + 1)) {
+      tree_[i] += delta;
+    }
+  }
+
+  /** @return the sum of the positions before end */
+  int64_t PrefixSum(size_t end) const {
+    int64_t sum = 0;
+    for (size_t i = end; i > 0; i -= i & (~i + 1)) {
+      sum += tree_[i];
+    }
+    return sum;
+  }
+
+ private:
+  std::vector<int64_t> tree_;
+};
+
+void AddReuse(ReuseProfile *profile, uint64_t distance, uint64_t time) {
+  if (profile->distance_counts_.size() <= distance) {
+    profile->distance_counts_.resize(distance + 1, 0);
+  }
+  profile->distance_counts_[distance]++;
+  profile->time_counts_[time]++;
+}
+
+}  // namespace
+
+double ReuseProfile::HitRatio(size_t pool_size) const {
+  if (num_accesses_ == 0) {
+    return 0;
+  }
+  uint64_t num_hits = 0;
+  for (size_t distance = 0; distance < std::min(pool_size, distance_counts_.size()); distance++) {
+    num_hits += distance_counts_[distance];
+  }
+  return static_cast<double>(num_hits) / static_cast<double>(num_accesses_);
+}
+
+double ReuseProfile::WorkingSetSize(uint64_t window, uint64_t num_trace_accesses) const {
+  if (num_trace_accesses == 0) {
+    return 0;
+  }
+  double sum = static_cast<double>(num_cold_) * static_cast<double>(window);
+  for (const auto &[time, count] : time_counts_) {
+    sum += static_cast<double>(std::min(time, window)) * static_cast<double>(count);
+  }
+  return sum / static_cast<double>(num_trace_accesses);
+}
+
+std::vector<uint64_t> ReuseProfile::DistanceLog2Histogram() const {
+  std::vector<uint64_t> histogram;
+  for (uint64_t distance = 0; distance < distance_counts_.size(); distance++) {
+    size_t bucket = 0;
+    while ((uint64_t{1} << bucket) <= distance) {
+      bucket++;
+    }
+    if (histogram.size() <= bucket) {
+      histogram.resize(bucket + 1, 0);
+    }
+    histogram[bucket] += distance_counts_[distance];
+  }
+  return histogram;
+}
+
+ReuseAnalysis::ReuseAnalysis(const std::vector<PageAccess> &accesses) {
+  // An access is marked while it is the last one to its page, so the marks between the previous access to a page and
+  // the current one count the distinct pages accessed in between.
+  FenwickTree last_accesses(accesses.size());
+  std::unordered_map<page_id_t, size_t> last_access;
+  for (size_t i = 0; i < accesses.size(); i++) {
+    const PageAccess &access = accesses[i];
+    ReuseProfile &owner = owners_[access.owner_];
+    total_.num_accesses_++;
+    owner.num_accesses_++;
+    auto iter = last_access.find(access.page_id_);
+    if (iter == last_access.end()) {
+      total_.num_cold_++;
+      owner.num_cold_++;
+      last_access.emplace(access.page_id_, i);
+    } else {
+      size_t previous = iter->second;
+      auto distance = static_cast<uint64_t>(last_accesses.PrefixSum(i) - last_accesses.PrefixSum(previous + 1));
+      AddReuse(&total_, distance, i - previous);
+      AddReuse(&owner, distance, i - previous);
+      last_accesses.Add(previous, -1);
+      iter->second = i;
+    }
+    last_accesses.Add(i, 1);
+  }
+}
+
+}  // namespace bustub
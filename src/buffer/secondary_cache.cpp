@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// secondary_cache.cpp
+//
+// Identification: src/buffer/secondary_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/secondary_cache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+SecondaryCache::SecondaryCache(const std::string &file_name, size_t num_pages)
+    : file_name_(file_name), num_pages_(num_pages) {
+  BUSTUB_ASSERT(num_pages > 0, "a secondary cache holds at least one page");
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw Exception("can't open secondary cache file " + file_name);
+  }
+  slot_pages_ = std::make_unique<page_id_t[]>(num_pages);
+  slot_versions_ = std::make_unique<uint64_t[]>(num_pages);
+  slot_ready_ = std::make_unique<bool[]>(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    slot_pages_[i] = INVALID_PAGE_ID;
+  }
+}
+
+SecondaryCache::~SecondaryCache() {
+  close(fd_);
+  remove(file_name_.c_str());
+}
+
+SecondaryCache::Ticket SecondaryCache::Reserve(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  const size_t slot = next_slot_;
+  next_slot_ = (next_slot_ + 1) % num_pages_;
+  if (slot_pages_[slot] != INVALID_PAGE_ID) {
+    index_.erase(slot_pages_[slot]);
+  }
+  // An exclusive cache never holds a page twice, but a page evicted again before its first copy was taken would.
+  if (auto iter = index_.find(page_id); iter != index_.end()) {
+    slot_pages_[iter->second] = INVALID_PAGE_ID;
+    slot_ready_[iter->second] = false;
+  }
+  index_[page_id] = slot;
+  slot_pages_[slot] = page_id;
+  slot_versions_[slot]++;
+  slot_ready_[slot] = false;
+  return {slot, slot_versions_[slot], page_id};
+}
+
+void SecondaryCache::Write(const Ticket &ticket, const char *page_data) {
+  const auto offset = static_cast<off_t>(ticket.slot_ * PAGE_SIZE);
+  ssize_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t n = pwrite(fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing to the secondary cache");
+      return;
+    }
+    written += n;
+  }
+  std::scoped_lock lock(latch_);
+  if (slot_versions_[ticket.slot_] == ticket.version_ && slot_pages_[ticket.slot_] == ticket.page_id_) {
+    slot_ready_[ticket.slot_] = true;
+  }
+}
+
+bool SecondaryCache::Take(page_id_t page_id, Ticket *ticket) {
+  std::scoped_lock lock(latch_);
+  auto iter = index_.find(page_id);
+  if (iter == index_.end()) {
+    return false;
+  }
+  const size_t slot = iter->second;
+  index_.erase(iter);
+  const bool ready = slot_ready_[slot];
+  slot_pages_[slot] = INVALID_PAGE_ID;
+  slot_ready_[slot] = false;
+  *ticket = {slot, slot_versions_[slot], page_id};
+  return ready;
+}
+
+bool SecondaryCache::Read(const Ticket &ticket, char *page_data) {
+  const auto offset = static_cast<off_t>(ticket.slot_ * PAGE_SIZE);
+  ssize_t read_bytes = 0;
+  while (read_bytes < PAGE_SIZE) {
+    ssize_t n = pread(fd_, page_data + read_bytes, PAGE_SIZE - read_bytes, offset + read_bytes);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while reading from the secondary cache");
+      return false;
+    }
+    read_bytes += n;
+  }
+  std::scoped_lock lock(latch_);
+  return slot_versions_[ticket.slot_] == ticket.version_;
+}
+
+size_t SecondaryCache::Size() {
+  std::scoped_lock lock(latch_);
+  return index_.size();
+}
+
+}  // namespace bustub
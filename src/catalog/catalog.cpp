@@ -0,0 +1,317 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog.cpp
+//
+// Identification: src/catalog/catalog.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/catalog.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "storage/page/header_page.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Format of a catalog page (size in byte):
+ *  -----------------------------------------------------------
+ * | NextPageId (4) | DataSize (4) | Data (up to PAGE_SIZE - 8) |
+ *  -----------------------------------------------------------
+ * The data of the pages of the chain, in order, make the stored catalog.
+ */
+constexpr size_t OFFSET_NEXT_PAGE_ID = 0;
+constexpr size_t OFFSET_DATA_SIZE = 4;
+constexpr size_t OFFSET_DATA = 8;
+constexpr size_t PAGE_DATA_CAPACITY = PAGE_SIZE - OFFSET_DATA;
+
+/** Identifies the format of the stored catalog. */
+constexpr uint32_t CATALOG_MAGIC = 0x42544332;
+
+/** Appends the fields of the catalog to its bytes. */
+class CatalogWriter {
+ public:
+  void U32(uint32_t value) { bytes_.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+  void String(const std::string &value) {
+    U32(static_cast<uint32_t>(value.size()));
+    bytes_.append(value);
+  }
+
+  void Attrs(const std::vector<uint32_t> &attrs) {
+    U32(static_cast<uint32_t>(attrs.size()));
+    for (uint32_t attr : attrs) {
+      U32(attr);
+    }
+  }
+
+  void Columns(const Schema &schema) {
+    U32(schema.GetColumnCount());
+    for (const Column &column : schema.GetColumns()) {
+      String(column.GetName());
+      U32(static_cast<uint32_t>(column.GetType()));
+      U32(column.GetLength());
+    }
+  }
+
+  const std::string &GetBytes() const { return bytes_; }
+
+ private:
+  std::string bytes_;
+};
+
+/** Reads the fields of the catalog back from its bytes. */
+class CatalogReader {
+ public:
+  explicit CatalogReader(const std::string &bytes) : bytes_(bytes) {}
+
+  uint32_t U32() {
+    uint32_t value;
+    Take(&value, sizeof(value));
+    return value;
+  }
+
+  std::string String() {
+    std::string value(U32(), '\0');
+    Take(value.data(), value.size());
+    return value;
+  }
+
+  std::vector<uint32_t> Attrs() {
+    std::vector<uint32_t> attrs(U32());
+    for (uint32_t &attr : attrs) {
+      attr = U32();
+    }
+    return attrs;
+  }
+
+  Schema Columns() {
+    std::vector<Column> columns;
+    for (uint32_t count = U32(); count > 0; count--) {
+      std::string name = String();
+      auto type = static_cast<TypeId>(U32());
+      uint32_t length = U32();
+      if (type == TypeId::VARCHAR) {
+        columns.emplace_back(name, type, length);
+      } else {
+        columns.emplace_back(name, type);
+      }
+    }
+    return Schema(columns);
+  }
+
+ private:
+  void Take(void *dest, size_t size) {
+    if (offset_ + size > bytes_.size()) {
+      throw Exception("catalog pages are corrupted");
+    }
+    memcpy(dest, bytes_.data() + offset_, size);
+    offset_ += size;
+  }
+
+  const std::string &bytes_;
+  size_t offset_{0};
+};
+
+/**
+ * @return the B+ tree index of keys of KeySize bytes stored in the database, or a new empty one if is_empty, whose
+ * first insert takes over the record of the root of the stored one
+ */
+template <size_t KeySize>
+std::unique_ptr<Index> OpenTree(IndexMetadata *metadata, BufferPoolManager *bpm, bool is_empty) {
+  auto index = std::make_unique<BPlusTreeIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>>(metadata, bpm);
+  if (!is_empty) {
+    index->Open();
+  }
+  return index;
+}
+
+}  // namespace
+
+void Catalog::Load() {
+  auto *header_page = static_cast<HeaderPage *>(bpm_->FetchPage(HEADER_PAGE_ID));
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the header page");
+  }
+  page_id_t page_id = INVALID_PAGE_ID;
+  const bool found = header_page->GetRootId(CATALOG_RECORD_NAME, &page_id);
+  bpm_->UnpinPage(HEADER_PAGE_ID, false);
+  if (!found) {
+    return;
+  }
+
+  std::string bytes;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = bpm_->FetchPage(page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a catalog page");
+    }
+    catalog_page_ids_.push_back(page_id);
+    page->RLatch();
+    uint32_t size;
+    memcpy(&page_id, page->GetData() + OFFSET_NEXT_PAGE_ID, sizeof(page_id));
+    memcpy(&size, page->GetData() + OFFSET_DATA_SIZE, sizeof(size));
+    bytes.append(page->GetData() + OFFSET_DATA, std::min<size_t>(size, PAGE_DATA_CAPACITY));
+    page->RUnlatch();
+    bpm_->UnpinPage(catalog_page_ids_.back(), false);
+  }
+
+  CatalogReader reader(bytes);
+  if (reader.U32() != CATALOG_MAGIC) {
+    throw Exception("catalog pages are corrupted");
+  }
+  next_table_oid_ = reader.U32();
+  next_index_oid_ = reader.U32();
+  for (uint32_t count = reader.U32(); count > 0; count--) {
+    const table_oid_t table_oid = reader.U32();
+    std::string name = reader.String();
+    const auto format = static_cast<TableFormat>(reader.U32());
+    const auto durability = static_cast<TableDurability>(reader.U32());
+    const auto first_page_id = static_cast<page_id_t>(reader.U32());
+    const auto free_space_map_page_id = static_cast<page_id_t>(reader.U32());
+    auto table_metadata = std::make_unique<TableMetadata>(reader.Columns(), name, nullptr, table_oid);
+    table_metadata->table_ = std::make_unique<TableHeap>(
+        bpm_, lock_manager_, LogManagerOf(durability), first_page_id, free_space_map_page_id,
+        format == TableFormat::PAX ? &table_metadata->schema_ : nullptr);
+    table_metadata->table_->SetTableOid(table_oid);
+    table_metadata->table_->SetSchema(&table_metadata->schema_);
+    table_metadata->durability_ = durability;
+    // Nothing tells whether the pages of an unlogged table were left as they were written or partly so.
+    if (durability == TableDurability::UNLOGGED) {
+      table_metadata->table_->Truncate();
+    }
+    names_[name] = table_oid;
+    tables_[table_oid] = std::move(table_metadata);
+  }
+  for (uint32_t count = reader.U32(); count > 0; count--) {
+    const index_oid_t index_oid = reader.U32();
+    std::string name = reader.String();
+    std::string table_name = reader.String();
+    const size_t key_size = reader.U32();
+    const bool unique_keys = reader.U32() != 0;
+    std::vector<uint32_t> key_attrs = reader.Attrs();
+    std::vector<uint32_t> include_attrs = reader.Attrs();
+    Schema key_schema = reader.Columns();
+    auto *metadata =
+        new IndexMetadata(name, table_name, &GetTable(table_name)->schema_, key_attrs, unique_keys, include_attrs);
+    const bool is_empty = GetTable(table_name)->durability_ == TableDurability::UNLOGGED;
+    index_names_[table_name][name] = index_oid;
+    indexes_[index_oid] = std::make_unique<IndexInfo>(
+        std::move(key_schema), name, OpenIndex(metadata, key_size, is_empty), index_oid, table_name, key_size);
+  }
+}
+
+std::unique_ptr<Index> Catalog::OpenIndex(IndexMetadata *metadata, size_t key_size, bool is_empty) {
+  switch (key_size) {
+    case 4:
+      return OpenTree<4>(metadata, bpm_, is_empty);
+    case 8:
+      return OpenTree<8>(metadata, bpm_, is_empty);
+    case 16:
+      return OpenTree<16>(metadata, bpm_, is_empty);
+    case 32:
+      return OpenTree<32>(metadata, bpm_, is_empty);
+    case 64:
+      return OpenTree<64>(metadata, bpm_, is_empty);
+    default:
+      delete metadata;
+      throw Exception("catalog pages name an index of an unknown key size");
+  }
+}
+
+void Catalog::Persist() {
+  CatalogWriter writer;
+  writer.U32(CATALOG_MAGIC);
+  writer.U32(next_table_oid_);
+  writer.U32(next_index_oid_);
+  // Temporary tables, and their indexes, are not stored.
+  auto is_stored = [this](const std::string &table_name) {
+    return GetTable(table_name)->durability_ != TableDurability::TEMPORARY;
+  };
+  writer.U32(static_cast<uint32_t>(std::count_if(
+      tables_.begin(), tables_.end(), [&](const auto &table) { return is_stored(table.second->name_); })));
+  for (const auto &[table_oid, table_metadata] : tables_) {
+    if (!is_stored(table_metadata->name_)) {
+      continue;
+    }
+    writer.U32(table_oid);
+    writer.String(table_metadata->name_);
+    writer.U32(static_cast<uint32_t>(table_metadata->table_->GetFormat()));
+    writer.U32(static_cast<uint32_t>(table_metadata->durability_));
+    writer.U32(static_cast<uint32_t>(table_metadata->table_->GetFirstPageId()));
+    writer.U32(static_cast<uint32_t>(table_metadata->table_->GetFreeSpaceMapPageId()));
+    writer.Columns(table_metadata->schema_);
+  }
+  writer.U32(static_cast<uint32_t>(std::count_if(
+      indexes_.begin(), indexes_.end(), [&](const auto &index) { return is_stored(index.second->table_name_); })));
+  for (const auto &[index_oid, index_info] : indexes_) {
+    if (!is_stored(index_info->table_name_)) {
+      continue;
+    }
+    const IndexMetadata *metadata = index_info->index_->GetMetadata();
+    const std::vector<uint32_t> &attrs = metadata->GetKeyAttrs();
+    writer.U32(index_oid);
+    writer.String(index_info->name_);
+    writer.String(index_info->table_name_);
+    writer.U32(static_cast<uint32_t>(index_info->key_size_));
+    writer.U32(metadata->HasUniqueKeys() ? 1 : 0);
+    writer.Attrs({attrs.begin(), attrs.begin() + metadata->GetIndexColumnCount()});
+    writer.Attrs({attrs.begin() + metadata->GetIndexColumnCount(), attrs.end()});
+    writer.Columns(index_info->key_schema_);
+  }
+  const std::string &bytes = writer.GetBytes();
+
+  // The chain grows or shrinks to the pages the catalog takes, keeping its first page.
+  const size_t num_pages = std::max<size_t>(1, (bytes.size() + PAGE_DATA_CAPACITY - 1) / PAGE_DATA_CAPACITY);
+  const bool is_new = catalog_page_ids_.empty();
+  while (catalog_page_ids_.size() < num_pages) {
+    page_id_t page_id;
+    if (bpm_->NewPage(&page_id) == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a catalog page");
+    }
+    bpm_->UnpinPage(page_id, true);
+    catalog_page_ids_.push_back(page_id);
+  }
+  while (catalog_page_ids_.size() > num_pages) {
+    bpm_->DeletePage(catalog_page_ids_.back());
+    catalog_page_ids_.pop_back();
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    Page *page = bpm_->FetchPage(catalog_page_ids_[i]);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a catalog page");
+    }
+    const page_id_t next_page_id = i + 1 < num_pages ? catalog_page_ids_[i + 1] : INVALID_PAGE_ID;
+    const size_t offset = i * PAGE_DATA_CAPACITY;
+    const auto size = static_cast<uint32_t>(std::min(PAGE_DATA_CAPACITY, bytes.size() - offset));
+    page->WLatch();
+    memcpy(page->GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(next_page_id));
+    memcpy(page->GetData() + OFFSET_DATA_SIZE, &size, sizeof(size));
+    memcpy(page->GetData() + OFFSET_DATA, bytes.data() + offset, size);
+    page->WUnlatch();
+    bpm_->UnpinPage(catalog_page_ids_[i], true);
+    bpm_->FlushPage(catalog_page_ids_[i]);
+  }
+
+  // The header page records the roots of the trees of the indexes too, so it is flushed every time.
+  auto *header_page = static_cast<HeaderPage *>(bpm_->FetchPage(HEADER_PAGE_ID));
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the header page");
+  }
+  if (is_new && !header_page->InsertRecord(CATALOG_RECORD_NAME, catalog_page_ids_.front())) {
+    header_page->UpdateRecord(CATALOG_RECORD_NAME, catalog_page_ids_.front());
+  }
+  bpm_->UnpinPage(HEADER_PAGE_ID, true);
+  bpm_->FlushPage(HEADER_PAGE_ID);
+}
+
+}  // namespace bustub
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialized_view.cpp
+//
+// Identification: src/catalog/materialized_view.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/materialized_view.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "execution/plans/seq_scan_plan.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+bool MaterializedView::Supports(const AggregationPlanNode *plan) {
+  const auto *scan = dynamic_cast<const SeqScanPlanNode *>(plan->GetChildPlan());
+  if (scan == nullptr || scan->GetSample().method_ != SampleMethod::NONE) {
+    return false;
+  }
+  const std::vector<AggregationType> &agg_types = plan->GetAggregateTypes();
+  return std::none_of(agg_types.begin(), agg_types.end(),
+                      [](AggregationType type) { return type == AggregationType::ApproxCountDistinctAggregate; });
+}
+
+table_oid_t MaterializedView::TableOidOf(const AggregationPlanNode *plan) {
+  return static_cast<const SeqScanPlanNode *>(plan->GetChildPlan())->GetTableOid();
+}
+
+MaterializedView::MaterializedView(std::string name, const AggregationPlanNode *plan, const Schema *table_schema)
+    : name_(std::move(name)), plan_(plan), table_schema_(table_schema) {
+  BUSTUB_ASSERT(Supports(plan), "The view cannot maintain the aggregation.");
+  const auto *scan = static_cast<const SeqScanPlanNode *>(plan->GetChildPlan());
+  predicate_ = scan->GetPredicate();
+  scan_schema_ = scan->OutputSchema();
+}
+
+bool MaterializedView::KeyEqual::operator()(const AggregateKey &a, const AggregateKey &b) const {
+  for (size_t i = 0; i < a.group_bys_.size(); i++) {
+    const Value &x = a.group_bys_[i];
+    const Value &y = b.group_bys_[i];
+    if (x.IsNull() || y.IsNull() ? x.IsNull() != y.IsNull() : x.CompareEquals(y) != CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t MaterializedView::Size() {
+  std::scoped_lock lock(latch_);
+  return groups_.size();
+}
+
+void MaterializedView::Apply(const Tuple &tuple, bool insert) {
+  if (predicate_ != nullptr) {
+    // As in SeqScanExecutor, a tuple the predicate is NULL for does not satisfy it.
+    const Value result = predicate_->Evaluate(&tuple, table_schema_);
+    if (result.IsNull() || !result.GetAs<bool>()) {
+      return;
+    }
+  }
+  // The tuple as the scan outputs it, which the group-bys and the aggregates are evaluated on.
+  std::vector<Value> values;
+  values.reserve(scan_schema_->GetColumnCount());
+  for (const Column &column : scan_schema_->GetColumns()) {
+    values.push_back(column.GetExpr()->Evaluate(&tuple, table_schema_));
+  }
+  const Tuple output(values, scan_schema_);
+  AggregateKey key;
+  for (const AbstractExpression *group_by : plan_->GetGroupBys()) {
+    key.group_bys_.push_back(group_by->Evaluate(&output, scan_schema_));
+  }
+
+  const std::vector<AggregationType> &agg_types = plan_->GetAggregateTypes();
+  auto [iter, is_new] = groups_.try_emplace(key);
+  Group &group = iter->second;
+  if (is_new) {
+    group.states_.resize(agg_types.size());
+    for (AggregateState &state : group.states_) {
+      state.sum_ = ValueFactory::GetIntegerValue(0);
+    }
+  }
+  BUSTUB_ASSERT(insert || group.num_tuples_ > 0, "A tuple is taken out of a group it is not in.");
+  group.num_tuples_ = insert ? group.num_tuples_ + 1 : group.num_tuples_ - 1;
+  if (group.num_tuples_ == 0) {
+    groups_.erase(iter);
+    return;
+  }
+  for (size_t i = 0; i < agg_types.size(); i++) {
+    if (agg_types[i] == AggregationType::CountAggregate) {
+      continue;
+    }
+    AggregateState &state = group.states_[i];
+    Value input = plan_->GetAggregateAt(i)->Evaluate(&output, scan_schema_);
+    if (input.IsNull()) {
+      state.num_nulls_ = insert ? state.num_nulls_ + 1 : state.num_nulls_ - 1;
+      continue;
+    }
+    if (agg_types[i] == AggregationType::SumAggregate) {
+      state.sum_ = insert ? state.sum_.Add(input) : state.sum_.Subtract(input);
+      continue;
+    }
+    if (insert) {
+      state.values_[input]++;
+      continue;
+    }
+    auto value = state.values_.find(input);
+    BUSTUB_ASSERT(value != state.values_.end(), "A value is taken out of a group it is not in.");
+    if (--value->second == 0) {
+      state.values_.erase(value);
+    }
+  }
+}
+
+std::vector<Value> MaterializedView::AggregatesOf(const Group &group) const {
+  std::vector<Value> aggregates;
+  const std::vector<AggregationType> &agg_types = plan_->GetAggregateTypes();
+  for (size_t i = 0; i < agg_types.size(); i++) {
+    const AggregateState &state = group.states_[i];
+    // As in AggregationExecutor, a NULL input makes a sum, a minimum or a maximum NULL.
+    const bool is_null = state.num_nulls_ > 0;
+    switch (agg_types[i]) {
+      case AggregationType::CountAggregate:
+        aggregates.push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(group.num_tuples_)));
+        break;
+      case AggregationType::SumAggregate:
+        aggregates.push_back(is_null ? ValueFactory::GetNullValueByType(state.sum_.GetTypeId()) : state.sum_);
+        break;
+      case AggregationType::MinAggregate:
+      case AggregationType::MaxAggregate:
+        if (is_null || state.values_.empty()) {
+          aggregates.push_back(ValueFactory::GetNullValueByType(plan_->GetAggregateAt(i)->GetReturnType()));
+        } else {
+          const bool is_min = agg_types[i] == AggregationType::MinAggregate;
+          aggregates.push_back(is_min ? state.values_.begin()->first : state.values_.rbegin()->first);
+        }
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        aggregates.push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(state.values_.size())));
+        break;
+    }
+  }
+  return aggregates;
+}
+
+std::vector<Tuple> MaterializedView::Read() {
+  std::scoped_lock lock(latch_);
+  const AbstractExpression *having = plan_->GetHaving();
+  const Schema *schema = plan_->OutputSchema();
+  std::vector<Tuple> tuples;
+  tuples.reserve(groups_.size());
+  for (const auto &[key, group] : groups_) {
+    const std::vector<Value> aggregates = AggregatesOf(group);
+    if (having != nullptr && !having->EvaluateAggregate(key.group_bys_, aggregates).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> values;
+    values.reserve(schema->GetColumnCount());
+    for (const Column &column : schema->GetColumns()) {
+      values.push_back(column.GetExpr()->EvaluateAggregate(key.group_bys_, aggregates));
+    }
+    tuples.emplace_back(values, schema);
+  }
+  return tuples;
+}
+
+void MaterializedView::RecordDeltas(Transaction *txn, const std::vector<MaterializedView *> &views,
+                                    const Tuple &tuple, bool insert) {
+  for (MaterializedView *view : views) {
+    txn->GetViewDeltas()->push_back(ViewDelta{view, tuple, insert});
+  }
+}
+
+void MaterializedView::CommitDeltas(std::vector<ViewDelta> *deltas) {
+  std::vector<MaterializedView *> views;
+  for (const ViewDelta &delta : *deltas) {
+    if (std::find(views.begin(), views.end(), delta.view_) == views.end()) {
+      views.push_back(delta.view_);
+    }
+  }
+  for (MaterializedView *view : views) {
+    std::scoped_lock lock(view->latch_);
+    for (const ViewDelta &delta : *deltas) {
+      if (delta.view_ == view) {
+        view->Apply(delta.tuple_, delta.insert_);
+      }
+    }
+  }
+  deltas->clear();
+}
+
+}  // namespace bustub
@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// partition_scheme.cpp
+//
+// Identification: src/catalog/partition_scheme.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/partition_scheme.h"
+
+#include <utility>
+
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+namespace {
+/** @return true for the integer types, whose values hash alike whatever their width */
+bool IsIntegerType(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+}  // namespace
+
+PartitionScheme::PartitionScheme(uint32_t col_idx, TypeId key_type, size_t num_partitions)
+    : type_(PartitionType::HASH), col_idx_(col_idx), key_type_(key_type), num_partitions_(num_partitions) {
+  BUSTUB_ASSERT(num_partitions_ > 0, "A table has at least one partition.");
+}
+
+PartitionScheme::PartitionScheme(uint32_t col_idx, std::vector<Value> bounds)
+    : type_(PartitionType::RANGE), col_idx_(col_idx), num_partitions_(bounds.size() + 1), bounds_(std::move(bounds)) {
+  for (size_t i = 0; i < bounds_.size(); i++) {
+    BUSTUB_ASSERT(!bounds_[i].IsNull(), "The bounds of the partitions are not NULL.");
+    BUSTUB_ASSERT(i == 0 || bounds_[i - 1].CompareLessThan(bounds_[i]) == CmpBool::CmpTrue,
+                  "The bounds of the partitions ascend.");
+  }
+}
+
+size_t PartitionScheme::PartitionOf(const Value &key) const {
+  if (key.IsNull()) {
+    return 0;
+  }
+  if (type_ == PartitionType::HASH) {
+    return HashUtil::HashValue(&key) % num_partitions_;
+  }
+  // The number of bounds at or below the key.
+  size_t lo = 0;
+  size_t hi = bounds_.size();
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    if (bounds_[mid].CompareLessThanEquals(key) == CmpBool::CmpTrue) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+bool PartitionScheme::IsComparable(const Value &key) const {
+  if (type_ == PartitionType::HASH) {
+    // Only equal keys of the same type, or of integer types, hash alike.
+    return key.GetTypeId() == key_type_ || (IsIntegerType(key.GetTypeId()) && IsIntegerType(key_type_));
+  }
+  return bounds_.empty() || bounds_[0].CheckComparable(key);
+}
+
+void PartitionScheme::Prune(const Value *low, const Value *high, std::vector<bool> *candidates) const {
+  if ((low != nullptr && !IsComparable(*low)) || (high != nullptr && !IsComparable(*high))) {
+    return;
+  }
+  if (type_ == PartitionType::HASH) {
+    // Only a single key narrows the partitions down, to the one it hashes to.
+    if (low == nullptr || high == nullptr || low->CompareEquals(*high) != CmpBool::CmpTrue) {
+      return;
+    }
+    const size_t partition = PartitionOf(*low);
+    for (size_t i = 0; i < num_partitions_; i++) {
+      (*candidates)[i] = (*candidates)[i] && i == partition;
+    }
+    return;
+  }
+  const size_t first = low == nullptr ? 0 : PartitionOf(*low);
+  const size_t last = high == nullptr ? num_partitions_ - 1 : PartitionOf(*high);
+  for (size_t i = 0; i < num_partitions_; i++) {
+    (*candidates)[i] = (*candidates)[i] && first <= i && i <= last;
+  }
+}
+
+}  // namespace bustub
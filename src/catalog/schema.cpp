@@ -32,6 +32,7 @@ Schema::Schema(const std::vector<Column> &columns) : tuple_is_inlined_(true) {
     curr_offset += column.GetFixedLength();
 
     // add column
+    layouts_.push_back(ColumnLayout{column.column_offset_, column.GetType(), column.IsInlined()});
     this->columns_.push_back(column);
   }
   // set tuple length
@@ -16,13 +16,21 @@ std::vector<Value> TableGenerator::GenNumericValues(ColumnInsertMeta *col_meta,
     }
     return values;
   }
-  std::default_random_engine generator;
+  if (col_meta->dist_ != Dist::Uniform) {
+    if (!col_meta->zipf_.has_value()) {
+      col_meta->zipf_.emplace(col_meta->min_, col_meta->max_, ZipfTheta(col_meta->dist_));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      values.emplace_back(Value(col_meta->type_, static_cast<CppType>((*col_meta->zipf_)(col_meta->generator_))));
+    }
+    return values;
+  }
   // TODO(Amadou): Break up in two branches if this is too weird.
   std::conditional_t<std::is_integral_v<CppType>, std::uniform_int_distribution<CppType>,
                      std::uniform_real_distribution<CppType>>
       distribution(static_cast<CppType>(col_meta->min_), static_cast<CppType>(col_meta->max_));
   for (uint32_t i = 0; i < count; i++) {
-    values.emplace_back(Value(col_meta->type_, distribution(generator)));
+    values.emplace_back(Value(col_meta->type_, distribution(col_meta->generator_)));
   }
   return values;
 }
@@ -116,19 +124,39 @@ void TableGenerator::GenerateTestTables() {
   };
 
   for (auto &table_meta : insert_meta) {
-    // Create Schema
-    std::vector<Column> cols{};
-    cols.reserve(table_meta.col_meta_.size());
-    for (const auto &col_meta : table_meta.col_meta_) {
-      if (col_meta.type_ != TypeId::VARCHAR) {
-        cols.emplace_back(col_meta.name_, col_meta.type_);
-      } else {
-        cols.emplace_back(col_meta.name_, col_meta.type_, TEST_VARLEN_SIZE);
-      }
+    GenerateTable(&table_meta);
+  }
+}
+
+double TableGenerator::ZipfTheta(Dist dist) {
+  switch (dist) {
+    case Dist::Zipf_50:
+      return 0.5;
+    case Dist::Zipf_75:
+      return 0.75;
+    case Dist::Zipf_95:
+      return 0.95;
+    case Dist::Zipf_99:
+      return 0.99;
+    default:
+      UNREACHABLE("Not a Zipfian distribution");
+  }
+}
+
+TableMetadata *TableGenerator::GenerateTable(TableInsertMeta *table_meta, TableFormat format) {
+  // Create Schema
+  std::vector<Column> cols{};
+  cols.reserve(table_meta->col_meta_.size());
+  for (const auto &col_meta : table_meta->col_meta_) {
+    if (col_meta.type_ != TypeId::VARCHAR) {
+      cols.emplace_back(col_meta.name_, col_meta.type_);
+    } else {
+      cols.emplace_back(col_meta.name_, col_meta.type_, TEST_VARLEN_SIZE);
     }
-    Schema schema(cols);
-    auto info = exec_ctx_->GetCatalog()->CreateTable(exec_ctx_->GetTransaction(), table_meta.name_, schema);
-    FillTable(info, &table_meta);
   }
+  Schema schema(cols);
+  auto info = exec_ctx_->GetCatalog()->CreateTable(exec_ctx_->GetTransaction(), table_meta->name_, schema, format);
+  FillTable(info, table_meta);
+  return info;
 }
 }  // namespace bustub
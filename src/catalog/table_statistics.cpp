@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_statistics.cpp
+//
+// Identification: src/catalog/table_statistics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/table_statistics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+
+#include "storage/table/table_heap.h"
+#include "storage/table/table_sample.h"
+#include "storage/table/toast.h"
+
+namespace bustub {
+
+TableStatistics::TableStatistics(const Schema *schema) : schema_(schema), columns_(schema->GetColumnCount()) {}
+
+void TableStatistics::Analyze(const std::vector<TableHeap *> &heaps, BufferPoolManager *bpm, Transaction *txn,
+                              double sample_fraction) {
+  const uint32_t column_count = schema_->GetColumnCount();
+  uint64_t row_count = 0;
+  std::vector<ColumnStatistics> columns(column_count);
+  std::vector<uint32_t> varlen_columns;
+  for (uint32_t i = 0; i < column_count; i++) {
+    if (!schema_->GetColumn(i).IsInlined()) {
+      varlen_columns.push_back(i);
+    }
+  }
+  // A reservoir sample of the rows, the same for the same table.
+  std::vector<Tuple> sample;
+  std::mt19937_64 random;
+  auto add_tuple = [&](Tuple tuple) {
+    if (!varlen_columns.empty() && Toast::HasToasted(tuple, schema_, varlen_columns)) {
+      tuple = Toast::Detoast(bpm, tuple, schema_);
+    }
+    row_count++;
+    for (uint32_t i = 0; i < column_count; i++) {
+      Value value = tuple.GetValue(schema_, i);
+      if (value.IsNull()) {
+        columns[i].null_count_++;
+      } else {
+        columns[i].distinct_.Add(HashForDistinct(value));
+      }
+    }
+    if (sample.size() < SAMPLE_SIZE) {
+      sample.push_back(std::move(tuple));
+    } else if (uint64_t slot = random() % row_count; slot < SAMPLE_SIZE) {
+      sample[slot] = std::move(tuple);
+    }
+  };
+  const TableSample page_sample{SampleMethod::SYSTEM, sample_fraction, 0};
+  size_t num_pages = 0;
+  size_t num_sampled_pages = 0;
+  for (TableHeap *table : heaps) {
+    if (!page_sample.SamplesPages()) {
+      for (auto iter = table->BeginPageBatch(txn); iter != table->End(); ++iter) {
+        add_tuple(*iter);
+      }
+      continue;
+    }
+    // Only the pages picked are read, straight from the page directory.
+    std::vector<Tuple> tuples;
+    for (page_id_t page_id : table->GetPageIds()) {
+      num_pages++;
+      if (!page_sample.Picks(page_id)) {
+        continue;
+      }
+      num_sampled_pages++;
+      tuples.clear();
+      table->ReadPageTuples(page_id, txn, nullptr, &tuples);
+      for (Tuple &tuple : tuples) {
+        add_tuple(std::move(tuple));
+      }
+    }
+  }
+  if (num_sampled_pages > 0) {
+    const double scale = static_cast<double>(num_pages) / static_cast<double>(num_sampled_pages);
+    for (ColumnStatistics &column : columns) {
+      const auto values = static_cast<double>(row_count - column.null_count_);
+      if (static_cast<double>(column.distinct_.Estimate()) >= UNIQUE_SAMPLE_SHARE * values) {
+        column.distinct_scale_ = scale;
+      }
+      column.null_count_ = static_cast<uint64_t>(static_cast<double>(column.null_count_) * scale);
+    }
+    row_count = static_cast<uint64_t>(static_cast<double>(row_count) * scale);
+  }
+
+  for (uint32_t i = 0; i < column_count; i++) {
+    std::vector<Value> values;
+    values.reserve(sample.size());
+    for (const Tuple &tuple : sample) {
+      Value value = tuple.GetValue(schema_, i);
+      if (!value.IsNull()) {
+        values.push_back(std::move(value));
+      }
+    }
+    std::sort(values.begin(), values.end(),
+              [](const Value &lhs, const Value &rhs) { return lhs.CompareLessThan(rhs) == CmpBool::CmpTrue; });
+    // The upper bound of each bucket is the last of its share of the sorted values.
+    const size_t buckets = std::min(HISTOGRAM_BUCKETS, values.size());
+    for (size_t bucket = 1; bucket <= buckets; bucket++) {
+      columns[i].histogram_.push_back(values[bucket * values.size() / buckets - 1]);
+    }
+  }
+
+  std::scoped_lock lock(latch_);
+  analyzed_ = true;
+  row_count_ = row_count;
+  columns_ = std::move(columns);
+}
+
+void TableStatistics::AddTuple(const Tuple &tuple) {
+  std::scoped_lock lock(latch_);
+  row_count_++;
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    Value value;
+    // A value stored out of line is not NULL, and is not read back for its hash.
+    if (!ReadValue(tuple, i, &value)) {
+      continue;
+    }
+    if (value.IsNull()) {
+      columns_[i].null_count_++;
+    } else {
+      columns_[i].distinct_.Add(HashForDistinct(value));
+    }
+  }
+}
+
+void TableStatistics::RemoveTuple(const Tuple &tuple) {
+  std::scoped_lock lock(latch_);
+  row_count_ -= row_count_ > 0 ? 1 : 0;
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    Value value;
+    if (ReadValue(tuple, i, &value) && value.IsNull() && columns_[i].null_count_ > 0) {
+      columns_[i].null_count_--;
+    }
+  }
+}
+
+bool TableStatistics::IsAnalyzed() const {
+  std::scoped_lock lock(latch_);
+  return analyzed_;
+}
+
+uint64_t TableStatistics::GetRowCount() const {
+  std::scoped_lock lock(latch_);
+  return row_count_;
+}
+
+double TableStatistics::GetNullFraction(uint32_t column_idx) const {
+  std::scoped_lock lock(latch_);
+  return 1 - NonNullFraction(columns_[column_idx]);
+}
+
+uint64_t TableStatistics::GetDistinctCount(uint32_t column_idx) const {
+  std::scoped_lock lock(latch_);
+  const ColumnStatistics &column = columns_[column_idx];
+  const auto distinct =
+      static_cast<uint64_t>(static_cast<double>(column.distinct_.Estimate()) * column.distinct_scale_);
+  return std::min(distinct, row_count_ - std::min(row_count_, column.null_count_));
+}
+
+std::vector<Value> TableStatistics::GetHistogram(uint32_t column_idx) const {
+  std::scoped_lock lock(latch_);
+  return columns_[column_idx].histogram_;
+}
+
+double TableStatistics::EstimateEqualFraction(uint32_t column_idx, const Value &value) const {
+  if (value.IsNull()) {
+    return 0;
+  }
+  uint64_t distinct = GetDistinctCount(column_idx);
+  std::scoped_lock lock(latch_);
+  return distinct == 0 ? 0 : NonNullFraction(columns_[column_idx]) / static_cast<double>(distinct);
+}
+
+double TableStatistics::EstimateLessThanFraction(uint32_t column_idx, const Value &value) const {
+  if (value.IsNull()) {
+    return 0;
+  }
+  std::scoped_lock lock(latch_);
+  const ColumnStatistics &column = columns_[column_idx];
+  if (column.histogram_.empty()) {
+    // The customary guess for a range without statistics.
+    return NonNullFraction(column) / 3;
+  }
+  // The buckets whose upper bounds are below the value count whole, the one the value falls in half.
+  auto below = static_cast<size_t>(
+      std::count_if(column.histogram_.begin(), column.histogram_.end(),
+                    [&value](const Value &bound) { return bound.CompareLessThan(value) == CmpBool::CmpTrue; }));
+  double buckets = below == column.histogram_.size() ? static_cast<double>(below) : static_cast<double>(below) + 0.5;
+  return NonNullFraction(column) * buckets / static_cast<double>(column.histogram_.size());
+}
+
+hash_t TableStatistics::HashForDistinct(const Value &value) {
+  // The HyperLogLog remixes the hash, so an integer makes a hash of its own, with no collisions.
+  switch (value.GetTypeId()) {
+    case TypeId::TINYINT:
+      return static_cast<hash_t>(value.GetAs<int8_t>());
+    case TypeId::SMALLINT:
+      return static_cast<hash_t>(value.GetAs<int16_t>());
+    case TypeId::INTEGER:
+      return static_cast<hash_t>(value.GetAs<int32_t>());
+    case TypeId::BIGINT:
+      return static_cast<hash_t>(value.GetAs<int64_t>());
+    case TypeId::TIMESTAMP:
+      return static_cast<hash_t>(value.GetAs<uint64_t>());
+    case TypeId::DECIMAL: {
+      double raw = value.GetAs<double>();
+      hash_t hash;
+      static_assert(sizeof(hash) == sizeof(raw));
+      memcpy(&hash, &raw, sizeof(hash));
+      return hash;
+    }
+    default:
+      return HashUtil::HashValue(&value);
+  }
+}
+
+bool TableStatistics::ReadValue(const Tuple &tuple, uint32_t column_idx, Value *value) const {
+  if (!schema_->GetColumn(column_idx).IsInlined() && Toast::HasToasted(tuple, schema_, {column_idx})) {
+    return false;
+  }
+  *value = tuple.GetValue(schema_, column_idx);
+  return true;
+}
+
+double TableStatistics::NonNullFraction(const ColumnStatistics &column) const {
+  if (row_count_ == 0) {
+    return 0;
+  }
+  return 1 - static_cast<double>(std::min(row_count_, column.null_count_)) / static_cast<double>(row_count_);
+}
+
+}  // namespace bustub
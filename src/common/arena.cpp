@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena.cpp
+//
+// Identification: src/common/arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/arena.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+char *Arena::Allocate(size_t size, size_t alignment) {
+  BUSTUB_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= alignof(std::max_align_t),
+                "The alignment is a power of two no larger than the one of a chunk.");
+  bytes_allocated_ += size;
+  while (chunk_idx_ < chunks_.size()) {
+    size_t begin = (offset_ + alignment - 1) & ~(alignment - 1);
+    if (begin + size <= chunks_[chunk_idx_].size_) {
+      offset_ = begin + size;
+      return chunks_[chunk_idx_].data_.get() + begin;
+    }
+    chunk_idx_++;
+    offset_ = 0;
+  }
+  // Chunks are allocated with new, which aligns them for any type.
+  size_t chunk_size = std::max(chunk_size_, size);
+  chunks_.push_back(Chunk{std::make_unique<char[]>(chunk_size), chunk_size});
+  bytes_reserved_ += chunk_size;
+  chunk_idx_ = chunks_.size() - 1;
+  offset_ = size;
+  return chunks_.back().data_.get();
+}
+
+void Arena::Reset() {
+  chunk_idx_ = 0;
+  offset_ = 0;
+  bytes_allocated_ = 0;
+}
+
+}  // namespace bustub
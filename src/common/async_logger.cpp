@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_logger.cpp
+//
+// Identification: src/common/async_logger.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/async_logger.h"
+
+#include <cstdlib>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+static_assert((AsyncLogger::RING_SIZE & (AsyncLogger::RING_SIZE - 1)) == 0, "the ring size is a power of two");
+
+AsyncLogger::AsyncLogger(FILE *stream) : stream_(stream), ring_(new Record[RING_SIZE]) {
+  for (size_t i = 0; i < RING_SIZE; i++) {
+    ring_[i].sequence_.store(i, std::memory_order_relaxed);
+  }
+  thread_ = std::thread([this] { Run(); });
+}
+
+AsyncLogger::~AsyncLogger() { Stop(); }
+
+AsyncLogger *AsyncLogger::Instance() {
+  // Never destroyed, so that the destructors of other statics can still log after it is stopped.
+  static AsyncLogger *logger = [] {
+    auto *instance = new AsyncLogger(LOG_OUTPUT_STREAM);
+    std::atexit([] { Instance()->Stop(); });
+    return instance;
+  }();
+  return logger;
+}
+
+void AsyncLogger::Append(const char *line, size_t length) {
+  if (stopped_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    fwrite(line, 1, length, stream_);
+    fflush(stream_);
+    return;
+  }
+  uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Record *record;
+  while (true) {
+    record = &ring_[pos & (RING_SIZE - 1)];
+    const uint64_t sequence = record->sequence_.load(std::memory_order_acquire);
+    if (sequence == pos) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (sequence < pos) {
+      // The ring is full until the background thread writes out the line a lap ahead.
+      Wake();
+      std::this_thread::yield();
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  record->line_.assign(line, length);
+  record->sequence_.store(pos + 1, std::memory_order_release);
+
+  // Pairs with the fence of Run, so that either the background thread sees the line or this thread sees it asleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    Wake();
+  }
+  if (stopped_.load(std::memory_order_acquire)) {
+    // The background thread may have stopped before the line was published.
+    Drain();
+  }
+}
+
+void AsyncLogger::Flush() {
+  const uint64_t ticket = enqueue_pos_.load(std::memory_order_acquire);
+  while (dequeue_pos_.load(std::memory_order_acquire) < ticket) {
+    if (stopped_.load(std::memory_order_acquire)) {
+      Drain();
+      std::this_thread::yield();
+      continue;
+    }
+    Wake();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (dequeue_pos_.load(std::memory_order_acquire) < ticket) {
+      drained_.wait_for(lock, IDLE_TIMEOUT);
+    }
+  }
+}
+
+void AsyncLogger::Stop() {
+  if (stopped_.exchange(true)) {
+    return;
+  }
+  Wake();
+  thread_.join();
+  Drain();
+}
+
+void AsyncLogger::Run() {
+  while (true) {
+    if (Drain() > 0) {
+      continue;
+    }
+    if (stopped_.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // A line published before the thread announced its sleep did not wake it up, so it looks once more.
+    if (!HasPublished() && !stopped_.load(std::memory_order_acquire)) {
+      wake_.wait_for(lock, IDLE_TIMEOUT);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+bool AsyncLogger::HasPublished() const {
+  const uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  return ring_[pos & (RING_SIZE - 1)].sequence_.load(std::memory_order_acquire) == pos + 1;
+}
+
+size_t AsyncLogger::Drain() {
+  std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+  batch_.clear();
+  uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  size_t num_lines = 0;
+  // At most one lap of the ring at a time, so that busy logging threads cannot keep the batch growing.
+  while (num_lines < RING_SIZE) {
+    Record &record = ring_[pos & (RING_SIZE - 1)];
+    if (record.sequence_.load(std::memory_order_acquire) != pos + 1) {
+      break;
+    }
+    batch_.append(record.line_);
+    record.sequence_.store(pos + RING_SIZE, std::memory_order_release);
+    pos++;
+    num_lines++;
+  }
+  if (num_lines == 0) {
+    return 0;
+  }
+  fwrite(batch_.data(), 1, batch_.size(), stream_);
+  fflush(stream_);
+  dequeue_pos_.store(pos, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  drained_.notify_all();
+  return num_lines;
+}
+
+void AsyncLogger::Wake() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_one();
+}
+
+}  // namespace bustub
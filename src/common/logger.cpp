@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// logger.cpp
+//
+// Identification: src/common/logger.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/logger.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+#include "common/async_logger.h"
+
+namespace bustub {
+
+// Output log message header in this format: [type] [file:line:function] time -
+// ex: [ERROR] [somefile.cpp:123:doSome()] 2008/07/06 10:00:00 -
+void OutputLogLine(const char *file, int line, const char *func, int level, const char *format, ...) {
+  time_t t = ::time(nullptr);
+  tm cur_time;
+  localtime_r(&t, &cur_time);
+  char time_str[32];
+  ::strftime(time_str, sizeof(time_str), LOG_LOG_TIME_FORMAT, &cur_time);
+  const char *type;
+  switch (level) {
+    case LOG_LEVEL_ERROR:
+      type = "ERROR";
+      break;
+    case LOG_LEVEL_WARN:
+      type = "WARN ";
+      break;
+    case LOG_LEVEL_INFO:
+      type = "INFO ";
+      break;
+    case LOG_LEVEL_DEBUG:
+      type = "DEBUG";
+      break;
+    case LOG_LEVEL_TRACE:
+      type = "TRACE";
+      break;
+    default:
+      type = "UNKWN";
+  }
+
+  // Most lines fit the buffer of the thread; a longer one grows it and is formatted again.
+  thread_local std::vector<char> buffer(512);
+  // PAVLO: DO NOT CHANGE THIS
+  int header = snprintf(buffer.data(), buffer.size(), "%s [%s:%d:%s] %s - ", time_str, file, line, func, type);
+  if (header < 0) {
+    return;
+  }
+  if (static_cast<size_t>(header) >= buffer.size()) {
+    buffer.resize(header + 1);
+    snprintf(buffer.data(), buffer.size(), "%s [%s:%d:%s] %s - ", time_str, file, line, func, type);
+  }
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  int message = vsnprintf(buffer.data() + header, buffer.size() - header, format, args);
+  va_end(args);
+  if (message >= 0 && static_cast<size_t>(header + message + 1) >= buffer.size()) {
+    // One more byte for the newline.
+    buffer.resize(header + message + 2);
+    vsnprintf(buffer.data() + header, buffer.size() - header, format, retry);
+  }
+  va_end(retry);
+  if (message < 0) {
+    message = 0;
+  }
+  size_t length = header + message;
+  buffer[length++] = '\n';
+
+  AsyncLogger *logger = AsyncLogger::Instance();
+  logger->Append(buffer.data(), length);
+  if (level == LOG_LEVEL_ERROR) {
+    logger->Flush();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_tracker.cpp
+//
+// Identification: src/common/memory_tracker.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/memory_tracker.h"
+
+#include <array>
+#include <string>
+
+namespace bustub {
+
+MemoryTracker *MemoryTracker::Of(MemoryTag tag) {
+  // Never destroyed, since the static containers of the subsystems free their memory at exit.
+  static auto *trackers = [] {
+    constexpr auto num_tags = static_cast<size_t>(MemoryTag::NUM_TAGS);
+    auto *trackers = new std::array<MemoryTracker, num_tags>();
+    for (size_t i = 0; i < num_tags; i++) {
+      MemoryTracker *tracker = &(*trackers)[i];
+      MetricsRegistry::Global()->RegisterCounter(
+          tracker, std::string("memory.") + NameOf(static_cast<MemoryTag>(i)) + "_bytes",
+          [tracker] { return tracker->GetBytes(); });
+    }
+    return trackers;
+  }();
+  return &(*trackers)[static_cast<size_t>(tag)];
+}
+
+void *MemoryTracker::AllocateObject(MemoryTag tag, size_t size) {
+  void *data = ::operator new(size);
+  Of(tag)->Allocate(size);
+  return data;
+}
+
+void MemoryTracker::FreeObject(MemoryTag tag, void *data, size_t size) {
+  Of(tag)->Free(size);
+  ::operator delete(data);
+}
+
+const char *MemoryTracker::NameOf(MemoryTag tag) {
+  switch (tag) {
+    case MemoryTag::LOCK_MANAGER:
+      return "lock_manager";
+    case MemoryTag::TRANSACTIONS:
+      return "transactions";
+    case MemoryTag::EXECUTION:
+      return "execution";
+    case MemoryTag::TUPLES:
+      return "tuples";
+    case MemoryTag::CATALOG:
+      return "catalog";
+    case MemoryTag::LOG_BUFFERS:
+      return "log_buffers";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.cpp
+//
+// Identification: src/common/metrics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+void HistogramSnapshot::Merge(const HistogramSnapshot &other) {
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+uint64_t HistogramSnapshot::Percentile(double fraction) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(Histogram::BucketTop(i), max_);
+    }
+  }
+  return max_;
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++) {
+    snapshot.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  snapshot.count_ = count_.load(std::memory_order_relaxed);
+  snapshot.sum_ = sum_.load(std::memory_order_relaxed);
+  snapshot.max_ = max_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+MetricsRegistry *MetricsRegistry::Global() {
+  static MetricsRegistry registry;
+  return &registry;
+}
+
+void MetricsRegistry::RegisterHistogram(const void *owner, const std::string &name, const Histogram *histogram) {
+  std::scoped_lock latch(latch_);
+  metrics_.emplace(name, Metric{owner, histogram, nullptr});
+}
+
+void MetricsRegistry::RegisterCounter(const void *owner, const std::string &name, std::function<uint64_t()> read) {
+  std::scoped_lock latch(latch_);
+  metrics_.emplace(name, Metric{owner, nullptr, std::move(read)});
+}
+
+void MetricsRegistry::Unregister(const void *owner) {
+  std::scoped_lock latch(latch_);
+  for (auto iter = metrics_.begin(); iter != metrics_.end();) {
+    iter = iter->second.owner_ == owner ? metrics_.erase(iter) : std::next(iter);
+  }
+}
+
+HistogramSnapshot MetricsRegistry::GetHistogram(const std::string &name) {
+  std::scoped_lock latch(latch_);
+  HistogramSnapshot merged;
+  auto [begin, end] = metrics_.equal_range(name);
+  for (auto iter = begin; iter != end; ++iter) {
+    if (iter->second.histogram_ != nullptr) {
+      merged.Merge(iter->second.histogram_->Snapshot());
+    }
+  }
+  return merged;
+}
+
+uint64_t MetricsRegistry::GetCounter(const std::string &name) {
+  std::scoped_lock latch(latch_);
+  uint64_t sum = 0;
+  auto [begin, end] = metrics_.equal_range(name);
+  for (auto iter = begin; iter != end; ++iter) {
+    if (iter->second.histogram_ == nullptr) {
+      sum += iter->second.read_();
+    }
+  }
+  return sum;
+}
+
+std::string MetricsRegistry::Dump() {
+  // The names first, the metrics of each read by name after, under the latch again.
+  std::vector<std::pair<std::string, bool>> names;
+  {
+    std::scoped_lock latch(latch_);
+    for (auto iter = metrics_.begin(); iter != metrics_.end(); iter = metrics_.upper_bound(iter->first)) {
+      names.emplace_back(iter->first, iter->second.histogram_ != nullptr);
+    }
+  }
+  std::ostringstream out;
+  for (const auto &[name, is_histogram] : names) {
+    if (is_histogram) {
+      const HistogramSnapshot snapshot = GetHistogram(name);
+      out << name << " count=" << snapshot.count_ << " mean=" << snapshot.Mean() << " p50=" << snapshot.Percentile(0.5)
+          << " p99=" << snapshot.Percentile(0.99) << " max=" << snapshot.max_ << "\n";
+    } else {
+      out << name << " " << GetCounter(name) << "\n";
+    }
+  }
+  return out.str();
+}
+
+}  // namespace bustub
@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool.cpp
+//
+// Identification: src/common/thread_pool.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+/** The pool whose task the calling thread runs, nullptr if none, and the class of the task, see ThreadPool::Yield. */
+thread_local ThreadPool *current_pool = nullptr;
+thread_local WorkloadClass current_class = WorkloadClass::INTERACTIVE;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  BUSTUB_ASSERT(num_threads > 0, "A thread pool needs at least one thread.");
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPool::Work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(latch_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task, WorkloadClass workload_class) {
+  {
+    std::scoped_lock lock(latch_);
+    const auto idx = static_cast<size_t>(workload_class);
+    if (tasks_[idx].empty()) {
+      // An idle class does not bank the turns it did not take.
+      pass_[idx] = std::max(pass_[idx], global_pass_);
+    }
+    tasks_[idx].push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::RunAll(size_t n, const std::function<void(size_t)> &task, WorkloadClass workload_class) {
+  std::mutex latch;
+  std::condition_variable done;
+  size_t remaining = n;
+  std::exception_ptr error;
+  for (size_t i = 0; i < n; i++) {
+    Submit(
+        [&, i] {
+          std::exception_ptr task_error;
+          try {
+            task(i);
+          } catch (...) {
+            task_error = std::current_exception();
+          }
+          std::scoped_lock lock(latch);
+          if (error == nullptr) {
+            error = task_error;
+          }
+          if (--remaining == 0) {
+            done.notify_one();
+          }
+        },
+        workload_class);
+  }
+  std::unique_lock lock(latch);
+  done.wait(lock, [&] { return remaining == 0; });
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::SetTickets(WorkloadClass workload_class, uint32_t tickets) {
+  BUSTUB_ASSERT(tickets > 0, "A workload class needs at least one ticket.");
+  std::scoped_lock lock(latch_);
+  tickets_[static_cast<size_t>(workload_class)] = tickets;
+}
+
+void ThreadPool::Yield() {
+  ThreadPool *pool = current_pool;
+  const auto limit = static_cast<size_t>(current_class);
+  if (pool == nullptr || limit == 0) {
+    return;
+  }
+  while (true) {
+    std::function<void()> task;
+    WorkloadClass workload_class;
+    {
+      std::scoped_lock lock(pool->latch_);
+      if (!pool->PopTask(limit, &task, &workload_class)) {
+        return;
+      }
+    }
+    pool->RunTask(task, workload_class);
+  }
+}
+
+bool ThreadPool::PopTask(size_t limit, std::function<void()> *task, WorkloadClass *workload_class) {
+  size_t next = limit;
+  for (size_t idx = 0; idx < limit; idx++) {
+    if (!tasks_[idx].empty() && (next == limit || pass_[idx] < pass_[next])) {
+      next = idx;
+    }
+  }
+  if (next == limit) {
+    return false;
+  }
+  *task = std::move(tasks_[next].front());
+  tasks_[next].pop_front();
+  *workload_class = static_cast<WorkloadClass>(next);
+  global_pass_ = pass_[next];
+  pass_[next] += STRIDE / tickets_[next];
+  return true;
+}
+
+void ThreadPool::RunTask(const std::function<void()> &task, WorkloadClass workload_class) {
+  ThreadPool *saved_pool = current_pool;
+  const WorkloadClass saved_class = current_class;
+  current_pool = this;
+  current_class = workload_class;
+  task();
+  current_pool = saved_pool;
+  current_class = saved_class;
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    std::function<void()> task;
+    WorkloadClass workload_class;
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [&] {
+        return shutdown_ || std::any_of(tasks_.begin(), tasks_.end(), [](const auto &tasks) { return !tasks.empty(); });
+      });
+      if (!PopTask(NUM_WORKLOAD_CLASSES, &task, &workload_class)) {
+        return;
+      }
+    }
+    RunTask(task, workload_class);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// deterministic_scheduler.cpp
+//
+// Identification: src/concurrency/deterministic_scheduler.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/deterministic_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+DeterministicScheduler::~DeterministicScheduler() {
+  StopSequencerThread();
+  SequenceBatch();
+  WaitForIdle();
+}
+
+std::future<bool> DeterministicScheduler::Submit(DeterministicTxn txn) {
+  auto entry = std::make_unique<Entry>();
+  entry->txn_ = std::move(txn);
+  std::future<bool> outcome = entry->outcome_.get_future();
+  std::scoped_lock submit_latch(submit_latch_);
+  submitted_.push_back(std::move(entry));
+  return outcome;
+}
+
+void DeterministicScheduler::RunSequencerThread() {
+  if (sequencer_thread_ == nullptr) {
+    enable_sequencer_ = true;
+    sequencer_thread_ = new std::thread(&DeterministicScheduler::RunSequencer, this);
+  }
+}
+
+void DeterministicScheduler::StopSequencerThread() {
+  if (sequencer_thread_ != nullptr) {
+    enable_sequencer_ = false;
+    sequencer_thread_->join();
+    delete sequencer_thread_;
+    sequencer_thread_ = nullptr;
+  }
+}
+
+size_t DeterministicScheduler::SequenceBatch() {
+  std::vector<std::unique_ptr<Entry>> batch;
+  {
+    std::scoped_lock submit_latch(submit_latch_);
+    batch.swap(submitted_);
+  }
+  if (batch.empty()) {
+    return 0;
+  }
+  // The batch order is the order of submission.
+  std::vector<Entry *> ready;
+  {
+    std::scoped_lock latch(latch_);
+    num_running_ += batch.size();
+    for (std::unique_ptr<Entry> &entry : batch) {
+      RequestLocks(entry.release(), &ready);
+    }
+  }
+  num_batches_++;
+  for (Entry *entry : ready) {
+    Dispatch(entry);
+  }
+  return batch.size();
+}
+
+void DeterministicScheduler::WaitForIdle() {
+  std::unique_lock latch(latch_);
+  idle_cv_.wait(latch, [this] { return num_running_ == 0; });
+}
+
+void DeterministicScheduler::RequestLocks(Entry *entry, std::vector<Entry *> *ready) {
+  // A row both read and written is locked once, exclusive.
+  for (const RID &rid : entry->txn_.write_set_) {
+    entry->rows_.emplace_back(rid, true);
+  }
+  for (const RID &rid : entry->txn_.read_set_) {
+    entry->rows_.emplace_back(rid, false);
+  }
+  std::stable_sort(entry->rows_.begin(), entry->rows_.end(),
+                   [](const auto &a, const auto &b) { return a.first.Get() < b.first.Get(); });
+  entry->rows_.erase(std::unique(entry->rows_.begin(), entry->rows_.end(),
+                                 [](const auto &a, const auto &b) { return a.first == b.first; }),
+                     entry->rows_.end());
+
+  entry->num_waiting_ = entry->rows_.size() + 1;
+  for (const auto &[rid, exclusive] : entry->rows_) {
+    std::deque<Request> &queue = lock_table_[rid];
+    queue.push_back(Request{entry, exclusive});
+    GrantLocks(&queue, ready);
+  }
+  // The last count keeps the transaction from running before all its requests are queued.
+  if (--entry->num_waiting_ == 0) {
+    ready->push_back(entry);
+  }
+}
+
+void DeterministicScheduler::GrantLocks(std::deque<Request> *queue, std::vector<Entry *> *ready) {
+  for (size_t i = 0; i < queue->size(); i++) {
+    Request &request = (*queue)[i];
+    // Granted after shared requests only, and only if shared itself.
+    if (i > 0 && (request.exclusive_ || (*queue)[i - 1].exclusive_)) {
+      return;
+    }
+    if (!request.granted_) {
+      request.granted_ = true;
+      if (--request.entry_->num_waiting_ == 0) {
+        ready->push_back(request.entry_);
+      }
+    }
+  }
+}
+
+void DeterministicScheduler::Dispatch(Entry *entry) {
+  thread_pool_->Submit([this, entry] { Execute(entry); });
+}
+
+void DeterministicScheduler::Execute(Entry *entry) {
+  Transaction *txn = transaction_manager_->Begin();
+  // The locks of the scheduler, which the storage takes as those of the lock manager.
+  for (const auto &[rid, exclusive] : entry->rows_) {
+    if (exclusive) {
+      txn->GetExclusiveLockSet()->emplace(rid);
+    } else {
+      txn->GetSharedLockSet()->emplace(rid);
+    }
+  }
+  bool committed;
+  try {
+    committed = entry->txn_.logic_(txn) && txn->GetState() != TransactionState::ABORTED;
+  } catch (TransactionAbortException &e) {
+    // On a lock of the lock manager, of a row the transaction did not declare.
+    committed = false;
+  }
+  if (committed) {
+    committed = transaction_manager_->Commit(txn);
+  } else {
+    transaction_manager_->Abort(txn);
+  }
+  delete txn;
+
+  std::vector<Entry *> ready;
+  {
+    std::scoped_lock latch(latch_);
+    for (const auto &[rid, exclusive] : entry->rows_) {
+      auto queue_iter = lock_table_.find(rid);
+      std::deque<Request> &queue = queue_iter->second;
+      queue.erase(std::find_if(queue.begin(), queue.end(),
+                               [entry](const Request &request) { return request.entry_ == entry; }));
+      if (queue.empty()) {
+        lock_table_.erase(queue_iter);
+      } else {
+        GrantLocks(&queue, &ready);
+      }
+    }
+  }
+  for (Entry *next : ready) {
+    Dispatch(next);
+  }
+  entry->outcome_.set_value(committed);
+  delete entry;
+  std::scoped_lock latch(latch_);
+  if (--num_running_ == 0) {
+    idle_cv_.notify_all();
+  }
+}
+
+void DeterministicScheduler::RunSequencer() {
+  while (enable_sequencer_) {
+    std::this_thread::sleep_for(batch_interval_);
+    SequenceBatch();
+  }
+  SequenceBatch();
+}
+
+}  // namespace bustub
@@ -15,45 +15,630 @@
 #include <utility>
 #include <vector>
 
+#include "concurrency/transaction_manager.h"
+
 namespace bustub {
 
 bool LockManager::LockShared(Transaction *txn, const RID &rid) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED) {
+    AbortImplicitly(txn, AbortReason::LOCKSHARED_ON_READ_UNCOMMITTED);
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsIncrementLocked(rid)) {
+    // The row holds the increments of the others, the read waits them out.
+    return LockUpgrade(txn, rid);
+  }
+  if (!Acquire(txn, &GetShard(rid), rid, LockMode::SHARED, false)) {
+    return false;
+  }
   txn->GetSharedLockSet()->emplace(rid);
   return true;
 }
 
 bool LockManager::LockExclusive(Transaction *txn, const RID &rid) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsIncrementLocked(rid)) {
+    return LockUpgrade(txn, rid);
+  }
+  if (!Acquire(txn, &GetShard(rid), rid, LockMode::EXCLUSIVE, false)) {
+    return false;
+  }
   txn->GetExclusiveLockSet()->emplace(rid);
   return true;
 }
 
+bool LockManager::LockIncrement(Transaction *txn, const RID &rid) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->IsExclusiveLocked(rid) || txn->IsIncrementLocked(rid)) {
+    return true;
+  }
+  if (txn->IsSharedLocked(rid)) {
+    // The transaction read the row, no other may add to it until it is done.
+    return LockUpgrade(txn, rid);
+  }
+  if (!Acquire(txn, &GetShard(rid), rid, LockMode::INCREMENT, false)) {
+    return false;
+  }
+  txn->GetIncrementLockSet()->emplace(rid);
+  return true;
+}
+
 bool LockManager::LockUpgrade(Transaction *txn, const RID &rid) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  // The shared or increment request is replaced by the upgrade request whether the upgrade is granted or not.
+  const bool granted = Acquire(txn, &GetShard(rid), rid, LockMode::EXCLUSIVE, true);
   txn->GetSharedLockSet()->erase(rid);
-  txn->GetExclusiveLockSet()->emplace(rid);
-  return true;
+  txn->GetIncrementLockSet()->erase(rid);
+  if (granted) {
+    txn->GetExclusiveLockSet()->emplace(rid);
+  }
+  return granted;
 }
 
 bool LockManager::Unlock(Transaction *txn, const RID &rid) {
+  const bool shared = txn->IsSharedLocked(rid);
+  if (!shared && !txn->IsExclusiveLocked(rid) && !txn->IsIncrementLocked(rid)) {
+    return false;
+  }
+  // Under READ_COMMITTED, shared locks are released early without ending the growing phase.
+  if (txn->GetState() == TransactionState::GROWING &&
+      !(shared && txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED)) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  return ReleaseRowLock(txn, rid);
+}
+
+bool LockManager::LockKeyRange(Transaction *txn, const KeyRange &range, LockMode lock_mode) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->IsKeyRangeLocked(range, lock_mode)) {
+    return true;
+  }
+  // A transaction scanning a gap it inserts into, or deleting a key it scanned, keeps the others from doing either.
+  auto &range_locks = *txn->GetKeyRangeLockMap();
+  const bool upgrade = range_locks.count(range) != 0;
+  const LockMode mode = upgrade ? LockMode::EXCLUSIVE : lock_mode;
+  if (!Acquire(txn, &GetShard(range), range, mode, upgrade)) {
+    range_locks.erase(range);
+    return false;
+  }
+  range_locks[range] = mode;
+  return true;
+}
+
+void LockManager::UnlockKeyRanges(Transaction *txn) {
+  auto &range_locks = *txn->GetKeyRangeLockMap();
+  for (const auto &[range, lock_mode] : range_locks) {
+    Release(txn, txn->GetCommitLSN(), &GetShard(range), range);
+  }
+  range_locks.clear();
+}
+
+bool LockManager::RecordRowLock(Transaction *txn, table_oid_t table_oid, const RID &rid) {
+  if (txn->GetState() != TransactionState::GROWING ||
+      (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !txn->IsIncrementLocked(rid))) {
+    return true;
+  }
+  auto &row_locks = (*txn->GetTableRowLockMap())[table_oid];
+  row_locks.insert(rid);
+  if (row_locks.size() <= escalation_threshold_) {
+    return true;
+  }
+  // An increment lock is escalated as an exclusive one, the table lock having no increment mode.
+  auto writes = [txn](const RID &locked) { return txn->IsExclusiveLocked(locked) || txn->IsIncrementLocked(locked); };
+  const bool exclusive = std::any_of(row_locks.begin(), row_locks.end(), writes);
+  if (!exclusive && txn->GetIsolationLevel() != IsolationLevel::REPEATABLE_READ) {
+    return true;
+  }
+  if (!LockTable(txn, exclusive ? LockMode::EXCLUSIVE : LockMode::SHARED, table_oid)) {
+    return false;
+  }
+  // LockTable may have combined SHARED with a held INTENTION_EXCLUSIVE into SHARED_INTENTION_EXCLUSIVE, which only
+  // covers the shared row locks, the exclusive ones stay.
+  std::vector<RID> covered;
+  for (const RID &locked : row_locks) {
+    if (txn->IsRowLockCovered(table_oid, writes(locked))) {
+      covered.push_back(locked);
+    }
+  }
+  for (const RID &locked : covered) {
+    ReleaseRowLock(txn, locked);
+  }
+  return true;
+}
+
+bool LockManager::LockTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED && lock_mode != LockMode::INTENTION_EXCLUSIVE &&
+      lock_mode != LockMode::EXCLUSIVE) {
+    AbortImplicitly(txn, AbortReason::LOCKSHARED_ON_READ_UNCOMMITTED);
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    AbortImplicitly(txn, AbortReason::LOCK_ON_SHRINKING);
+  }
+  LockMode held;
+  const bool upgrade = txn->GetTableLockMode(table_oid, &held);
+  const LockMode mode = upgrade ? Combine(held, lock_mode) : lock_mode;
+  if (upgrade && mode == held) {
+    return true;
+  }
+  if (!Acquire(txn, &table_locks_, table_oid, mode, upgrade)) {
+    txn->GetTableLockMap()->erase(table_oid);
+    return false;
+  }
+  (*txn->GetTableLockMap())[table_oid] = mode;
+  return true;
+}
+
+bool LockManager::UnlockTable(Transaction *txn, table_oid_t table_oid) {
+  LockMode held;
+  if (!txn->GetTableLockMode(table_oid, &held)) {
+    return false;
+  }
+  txn->GetTableLockMap()->erase(table_oid);
+  // Releasing a lock that only reads ends the growing phase as its row locks would.
+  const bool reads = held == LockMode::INTENTION_SHARED || held == LockMode::SHARED;
+  if (txn->GetState() == TransactionState::GROWING && held != LockMode::INTENTION_SHARED &&
+      !(reads && txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED)) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  // The intention locks protect no tuple of their own, their row locks carry the dependency on the commit.
+  const bool intention = held == LockMode::INTENTION_SHARED || held == LockMode::INTENTION_EXCLUSIVE;
+  return Release(txn, intention ? INVALID_LSN : txn->GetCommitLSN(), &table_locks_, table_oid);
+}
+
+bool LockManager::ReleaseRowLock(Transaction *txn, const RID &rid) {
   txn->GetSharedLockSet()->erase(rid);
   txn->GetExclusiveLockSet()->erase(rid);
+  txn->GetIncrementLockSet()->erase(rid);
+  for (auto &[table_oid, row_locks] : *txn->GetTableRowLockMap()) {
+    if (row_locks.erase(rid) != 0) {
+      break;
+    }
+  }
+  return Release(txn, txn->GetCommitLSN(), &GetShard(rid), rid);
+}
+
+bool LockManager::AreCompatible(LockMode held, LockMode requested) {
+  switch (held) {
+    case LockMode::INTENTION_SHARED:
+      return requested != LockMode::EXCLUSIVE && requested != LockMode::INCREMENT &&
+             requested != LockMode::INSERT_INTENTION;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::SHARED;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED;
+    case LockMode::EXCLUSIVE:
+      return false;
+    case LockMode::INCREMENT:
+      return requested == LockMode::INCREMENT;
+    case LockMode::INSERT_INTENTION:
+      return requested == LockMode::INSERT_INTENTION;
+  }
+  return false;
+}
+
+LockMode LockManager::Combine(LockMode a, LockMode b) {
+  if (a == b || b == LockMode::INTENTION_SHARED) {
+    return a;
+  }
+  if (a == LockMode::INTENTION_SHARED) {
+    return b;
+  }
+  if (a == LockMode::EXCLUSIVE || b == LockMode::EXCLUSIVE) {
+    return LockMode::EXCLUSIVE;
+  }
+  // Two different modes of SHARED, INTENTION_EXCLUSIVE and SHARED_INTENTION_EXCLUSIVE.
+  return LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+template <typename Key>
+bool LockManager::Acquire(Transaction *txn, LockTableShard<Key> *shard, const Key &key, LockMode lock_mode,
+                          bool upgrade) {
+  const txn_id_t txn_id = txn->GetTransactionId();
+  LockRequest *request = txn->NewLockRequest(lock_mode);
+  std::unique_lock<SpinMutex> latch(shard->latch_);
+  // The queue is not erased while it holds the request of txn, so the reference outlives the waits.
+  LockRequestQueue &queue = shard->lock_table_[key];
+  if (upgrade) {
+    if (queue.upgrading_) {
+      latch.unlock();
+      txn->FreeLockRequest(request);
+      AbortImplicitly(txn, AbortReason::UPGRADE_CONFLICT);
+    }
+    LockRequest *held = FindRequest(queue, txn_id);
+    if (held != nullptr) {
+      Unlink(&queue, held);
+      txn->FreeLockRequest(held);
+    }
+    Link(&queue, request, queue.first_waiting_);
+    queue.upgrading_ = true;
+  } else {
+    Link(&queue, request, nullptr);
+  }
+
+  // A new request at the tail that is grantable conflicts with no request, ahead of it or behind it.
+  const bool grantable = IsGrantable(queue, request);
+  if (deadlock_mode_ != DeadlockMode::DETECTION && (upgrade || !grantable)) {
+    std::vector<txn_id_t> aborted;
+    if (!PreventDeadlock(queue, request, &aborted)) {
+      num_deadlock_aborts_.Add(1 + aborted.size());
+      txn->SetState(TransactionState::ABORTED);
+    } else if (!aborted.empty()) {
+      num_deadlock_aborts_.Add(aborted.size());
+      // The aborted wake up on the latches of their own queues, this one among them.
+      latch.unlock();
+      for (txn_id_t aborted_id : aborted) {
+        AbortWaiting(aborted_id);
+      }
+      latch.lock();
+    }
+  }
+  if (txn->GetState() != TransactionState::ABORTED && !IsGrantable(queue, request)) {
+    {
+      std::scoped_lock waiting_latch(waiting_latch_);
+      abort_waiting_[txn_id] = [shard, key, txn_id] {
+        std::scoped_lock latch(shard->latch_);
+        auto queue = shard->lock_table_.find(key);
+        if (queue == shard->lock_table_.end()) {
+          return;
+        }
+        LockRequest *waiting = FindRequest(queue->second, txn_id);
+        if (waiting != nullptr && !waiting->granted_) {
+          TransactionManager::GetTransaction(txn_id)->SetState(TransactionState::ABORTED);
+          waiting->cv_.notify_all();
+        }
+      };
+    }
+    // Under DETECTION, the edges of txn in the waits-for graph follow the requests it waits for, at every wake up.
+    const bool detection = deadlock_mode_ == DeadlockMode::DETECTION;
+    std::vector<txn_id_t> blockers;
+    std::vector<txn_id_t> waits_for;
+    num_waits_.Add();
+    const auto wait_start = std::chrono::steady_clock::now();
+    request->cv_.wait(latch, [&] {
+      if (txn->GetState() == TransactionState::ABORTED || IsGrantable(queue, request)) {
+        return true;
+      }
+      if (detection) {
+        GetBlockers(queue, request, &blockers);
+        if (blockers != waits_for) {
+          SetWaitsFor(txn_id, blockers);
+          waits_for = blockers;
+        }
+      }
+      return false;
+    });
+    lock_wait_us_.RecordSince(wait_start);
+    if (!waits_for.empty()) {
+      SetWaitsFor(txn_id, {});
+    }
+    std::scoped_lock waiting_latch(waiting_latch_);
+    abort_waiting_.erase(txn_id);
+  }
+  if (upgrade) {
+    queue.upgrading_ = false;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    // Aborted by the deadlock policy, before or while waiting: the requests behind this one may be grantable now.
+    Unlink(&queue, request);
+    txn->FreeLockRequest(request);
+    if (queue.head_ == nullptr) {
+      shard->lock_table_.erase(key);
+    } else {
+      NotifyWaiting(queue);
+    }
+    return false;
+  }
+  // The first waiting request, compatible with the granted ones: the granted requests stay ahead of the waiting ones.
+  request->granted_ = true;
+  queue.num_granted_[static_cast<size_t>(request->lock_mode_)]++;
+  queue.first_waiting_ = request->next_;
+  // Whatever the lock protects may have been written by a commit that is not durable yet.
+  txn->AddDependencyLSN(shard->release_lsn_);
+  // The requests behind it that wait for its grant may be grantable now.
+  if (queue.first_waiting_ != nullptr) {
+    NotifyWaiting(queue);
+  }
   return true;
 }
 
-void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {}
+template <typename Key>
+bool LockManager::Release(Transaction *txn, lsn_t release_lsn, LockTableShard<Key> *shard, const Key &key) {
+  std::scoped_lock latch(shard->latch_);
+  auto queue_iter = shard->lock_table_.find(key);
+  if (queue_iter == shard->lock_table_.end()) {
+    return false;
+  }
+  LockRequestQueue &queue = queue_iter->second;
+  LockRequest *request = FindRequest(queue, txn->GetTransactionId());
+  if (request == nullptr) {
+    return false;
+  }
+  Unlink(&queue, request);
+  txn->FreeLockRequest(request);
+  shard->release_lsn_ = std::max(shard->release_lsn_, release_lsn);
+  if (queue.head_ == nullptr) {
+    shard->lock_table_.erase(queue_iter);
+  } else {
+    NotifyWaiting(queue);
+  }
+  return true;
+}
 
-void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {}
+void LockManager::Link(LockRequestQueue *queue, LockRequest *request, LockRequest *pos) {
+  request->next_ = pos;
+  request->prev_ = pos == nullptr ? queue->tail_ : pos->prev_;
+  (request->prev_ == nullptr ? queue->head_ : request->prev_->next_) = request;
+  (pos == nullptr ? queue->tail_ : pos->prev_) = request;
+  // Linked ahead of the first waiting request, or at the tail behind granted ones only, it is the first waiting now.
+  if (queue->first_waiting_ == pos) {
+    queue->first_waiting_ = request;
+  }
+}
+
+void LockManager::Unlink(LockRequestQueue *queue, LockRequest *request) {
+  if (request->granted_) {
+    queue->num_granted_[static_cast<size_t>(request->lock_mode_)]--;
+  }
+  if (queue->first_waiting_ == request) {
+    queue->first_waiting_ = request->next_;
+  }
+  (request->prev_ == nullptr ? queue->head_ : request->prev_->next_) = request->next_;
+  (request->next_ == nullptr ? queue->tail_ : request->next_->prev_) = request->prev_;
+  request->prev_ = nullptr;
+  request->next_ = nullptr;
+}
 
-bool LockManager::HasCycle(txn_id_t *txn_id) { return false; }
+LockRequest *LockManager::FindRequest(const LockRequestQueue &queue, txn_id_t txn_id) {
+  for (LockRequest *request = queue.head_; request != nullptr; request = request->next_) {
+    if (request->txn_id_ == txn_id) {
+      return request;
+    }
+  }
+  return nullptr;
+}
 
-std::vector<std::pair<txn_id_t, txn_id_t>> LockManager::GetEdgeList() { return {}; }
+bool LockManager::IsGrantable(const LockRequestQueue &queue, const LockRequest *request) {
+  if (request != queue.first_waiting_) {
+    return false;
+  }
+  for (size_t mode = 0; mode < NUM_LOCK_MODES; mode++) {
+    if (queue.num_granted_[mode] > 0 && !AreCompatible(static_cast<LockMode>(mode), request->lock_mode_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LockManager::NotifyWaiting(const LockRequestQueue &queue) const {
+  if (deadlock_mode_ != DeadlockMode::DETECTION) {
+    if (queue.first_waiting_ != nullptr) {
+      queue.first_waiting_->cv_.notify_all();
+    }
+    return;
+  }
+  for (LockRequest *request = queue.first_waiting_; request != nullptr; request = request->next_) {
+    request->cv_.notify_all();
+  }
+}
+
+bool LockManager::PreventDeadlock(const LockRequestQueue &queue, const LockRequest *request,
+                                  std::vector<txn_id_t> *aborted) {
+  const txn_id_t txn_id = request->txn_id_;
+  // Transaction older waits for younger: the older wounds the younger under WOUND_WAIT, waits under WAIT_DIE; and
+  // younger waits for older: the younger waits under WOUND_WAIT, dies under WAIT_DIE.
+  auto resolve = [&](txn_id_t waiter, txn_id_t holder) {
+    const bool older_waits = waiter < holder;
+    if (older_waits != (deadlock_mode_ == DeadlockMode::WOUND_WAIT)) {
+      return true;
+    }
+    const txn_id_t victim = older_waits ? holder : waiter;
+    if (victim == txn_id) {
+      return false;
+    }
+    Transaction *other = TransactionManager::GetTransaction(victim);
+    if (other->GetState() != TransactionState::ABORTED) {
+      other->SetState(TransactionState::ABORTED);
+      aborted->push_back(victim);
+    }
+    return true;
+  };
+  // The request waits for every request ahead of it that is waiting itself or incompatible with it.
+  for (const LockRequest *ahead = queue.head_; ahead != request; ahead = ahead->next_) {
+    const bool waits = !ahead->granted_ || !AreCompatible(ahead->lock_mode_, request->lock_mode_);
+    if (waits && !resolve(txn_id, ahead->txn_id_)) {
+      return false;
+    }
+  }
+  // An upgrade request goes ahead of the waiting requests, which then wait for it as well.
+  for (const LockRequest *behind = request->next_; behind != nullptr; behind = behind->next_) {
+    if (!resolve(behind->txn_id_, txn_id)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LockManager::AbortWaiting(txn_id_t txn_id) {
+  std::function<void()> abort;
+  {
+    std::scoped_lock waiting_latch(waiting_latch_);
+    auto waiting = abort_waiting_.find(txn_id);
+    if (waiting == abort_waiting_.end()) {
+      return;
+    }
+    abort = waiting->second;
+  }
+  // An aborted transaction that waits on no queue sees its state at its next lock request.
+  abort();
+}
+
+void LockManager::GetBlockers(const LockRequestQueue &queue, const LockRequest *request,
+                              std::vector<txn_id_t> *blockers) {
+  blockers->clear();
+  for (const LockRequest *ahead = queue.head_; ahead != request; ahead = ahead->next_) {
+    if (!ahead->granted_ || !AreCompatible(ahead->lock_mode_, request->lock_mode_)) {
+      blockers->push_back(ahead->txn_id_);
+    }
+  }
+  std::sort(blockers->begin(), blockers->end());
+}
+
+void LockManager::AbortImplicitly(Transaction *txn, AbortReason reason) {
+  txn->SetState(TransactionState::ABORTED);
+  throw TransactionAbortException(txn->GetTransactionId(), reason);
+}
+
+void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {
+  std::scoped_lock latch(waits_for_latch_);
+  std::vector<txn_id_t> &targets = waits_for_[t1];
+  auto pos = std::lower_bound(targets.begin(), targets.end(), t2);
+  if (pos == targets.end() || *pos != t2) {
+    targets.insert(pos, t2);
+    touched_.insert(t1);
+  }
+}
+
+void LockManager::SetWaitsFor(txn_id_t txn_id, const std::vector<txn_id_t> &targets) {
+  std::scoped_lock latch(waits_for_latch_);
+  if (targets.empty()) {
+    waits_for_.erase(txn_id);
+    return;
+  }
+  std::vector<txn_id_t> &edges = waits_for_[txn_id];
+  // Only new edges can close a new cycle.
+  if (!std::includes(edges.begin(), edges.end(), targets.begin(), targets.end())) {
+    touched_.insert(txn_id);
+  }
+  edges = targets;
+}
+
+void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
+  std::scoped_lock latch(waits_for_latch_);
+  auto edges = waits_for_.find(t1);
+  if (edges == waits_for_.end()) {
+    return;
+  }
+  auto pos = std::lower_bound(edges->second.begin(), edges->second.end(), t2);
+  if (pos != edges->second.end() && *pos == t2) {
+    edges->second.erase(pos);
+  }
+  if (edges->second.empty()) {
+    waits_for_.erase(edges);
+  }
+}
+
+bool LockManager::HasCycle(txn_id_t *txn_id) {
+  std::scoped_lock latch(waits_for_latch_);
+  std::unordered_set<txn_id_t> visited;
+  for (const auto &[source, targets] : waits_for_) {
+    std::vector<txn_id_t> path;
+    if (visited.count(source) == 0 && FindCycle(source, &path, &visited, txn_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LockManager::HasTouchedCycle(txn_id_t *txn_id) {
+  std::scoped_lock latch(waits_for_latch_);
+  std::unordered_set<txn_id_t> visited;
+  // A source stays touched until no cycle is found from it, the search resumes there once the victim is gone.
+  while (!touched_.empty()) {
+    std::vector<txn_id_t> path;
+    if (visited.count(*touched_.begin()) == 0 && FindCycle(*touched_.begin(), &path, &visited, txn_id)) {
+      return true;
+    }
+    touched_.erase(touched_.begin());
+  }
+  return false;
+}
+
+bool LockManager::FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::unordered_set<txn_id_t> *visited,
+                            txn_id_t *cycle_txn_id) {
+  visited->insert(txn_id);
+  path->push_back(txn_id);
+  auto edges = waits_for_.find(txn_id);
+  if (edges != waits_for_.end()) {
+    for (txn_id_t next : edges->second) {
+      auto on_path = std::find(path->begin(), path->end(), next);
+      if (on_path != path->end()) {
+        *cycle_txn_id = *std::max_element(on_path, path->end());
+        return true;
+      }
+      if (visited->count(next) == 0 && FindCycle(next, path, visited, cycle_txn_id)) {
+        return true;
+      }
+    }
+  }
+  path->pop_back();
+  return false;
+}
+
+std::vector<std::pair<txn_id_t, txn_id_t>> LockManager::GetEdgeList() {
+  std::scoped_lock latch(waits_for_latch_);
+  std::vector<std::pair<txn_id_t, txn_id_t>> edges;
+  for (const auto &[source, targets] : waits_for_) {
+    for (txn_id_t target : targets) {
+      edges.emplace_back(source, target);
+    }
+  }
+  return edges;
+}
 
 void LockManager::RunCycleDetection() {
   while (enable_cycle_detection_) {
     std::this_thread::sleep_for(cycle_detection_interval);
-    {
-      std::unique_lock<std::mutex> l(latch_);
-      // TODO(student): remove the continue and add your cycle detection and abort code here
-      continue;
+
+    // The waiting transactions keep their own edges up to date, so a pass only searches from the transactions whose
+    // edges changed since the last one: every new cycle goes through a new edge. An edge may be gone by the time its
+    // cycle is found, so a victim is only aborted if it is still waiting.
+    txn_id_t victim;
+    while (HasTouchedCycle(&victim)) {
+      {
+        std::scoped_lock latch(waits_for_latch_);
+        waits_for_.erase(victim);
+      }
+      num_deadlock_aborts_.Add();
+      AbortWaiting(victim);
     }
   }
 }
@@ -12,51 +12,227 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
+std::array<TransactionManager::TxnMapShard, TransactionManager::NUM_TXN_MAP_SHARDS>
+    TransactionManager::txn_map_shards = {};
 
-Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level) {
-  // Acquire the global transaction latch in shared mode.
-  global_txn_latch_.RLock();
+Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level,
+                                       ConcurrencyMode concurrency_mode) {
+  // Join the running transactions, unless a checkpoint blocks them.
+  EnterBarrier();
 
   if (txn == nullptr) {
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
+  if (log_manager_ != nullptr && log_manager_->GetDiskManager() != nullptr) {
+    txn->SetBeginLogOffset(log_manager_->GetDiskManager()->GetLogSize());
+  }
+  if (concurrency_mode != ConcurrencyMode::LOCKING) {
+    // Under the snapshot latch, so that the vacuum never misses a snapshot about to read the last commit. It keeps the
+    // versions committed after an optimistic transaction began as well, against which that one is validated.
+    std::scoped_lock snapshot_latch(snapshot_latch_);
+    txn->SetReadTs(concurrency_mode, last_commit_ts_.load());
+    snapshots_.insert(txn->GetReadTs());
+  }
 
-  txn_map[txn->GetTransactionId()] = txn;
+  TxnMapShard &shard = GetTxnMapShard(txn->GetTransactionId());
+  shard.latch_.WLock();
+  shard.txns_[txn->GetTransactionId()] = txn;
+  shard.latch_.WUnlock();
   return txn;
 }
 
-void TransactionManager::Commit(Transaction *txn) {
-  txn->SetState(TransactionState::COMMITTED);
+Transaction *TransactionManager::BeginReadOnly() {
+  Transaction *txn = nullptr;
+  {
+    std::scoped_lock read_only_latch(read_only_latch_);
+    if (!free_read_only_txns_.empty()) {
+      txn = free_read_only_txns_.back();
+      free_read_only_txns_.pop_back();
+    }
+  }
+  if (txn == nullptr) {
+    auto new_txn = std::make_unique<Transaction>(next_txn_id_++);
+    new_txn->SetReadOnly();
+    txn = new_txn.get();
+    std::scoped_lock read_only_latch(read_only_latch_);
+    read_only_txns_.push_back(std::move(new_txn));
+  } else {
+    txn->Renew(next_txn_id_++);
+  }
+  std::scoped_lock snapshot_latch(snapshot_latch_);
+  txn->SetReadTs(ConcurrencyMode::SNAPSHOT, last_commit_ts_.load());
+  snapshots_.insert(txn->GetReadTs());
+  return txn;
+}
+
+void TransactionManager::EndReadOnly(Transaction *txn, TransactionState state) {
+  txn->SetState(state);
+  EndSnapshot(txn);
+  std::scoped_lock read_only_latch(read_only_latch_);
+  free_read_only_txns_.push_back(txn);
+}
+
+size_t TransactionManager::GetNumRunningTransactions() {
+  size_t count = 0;
+  for (TxnMapShard &shard : txn_map_shards) {
+    shard.latch_.RLock();
+    count += shard.txns_.size();
+    shard.latch_.RUnlock();
+  }
+  return count;
+}
+
+int64_t TransactionManager::GetTransactionTable(std::unordered_map<txn_id_t, lsn_t> *txn_table) {
+  std::scoped_lock commit_latch(commit_latch_);
+  int64_t begin_log_offset = INT64_MAX;
+  for (TxnMapShard &shard : txn_map_shards) {
+    shard.latch_.RLock();
+    for (const auto &[txn_id, txn] : shard.txns_) {
+      if (txn->GetPrevLSN() != INVALID_LSN && txn->GetCommitLSN() == INVALID_LSN) {
+        (*txn_table)[txn_id] = txn->GetPrevLSN();
+        begin_log_offset = std::min(begin_log_offset, txn->GetBeginLogOffset());
+      }
+    }
+    shard.latch_.RUnlock();
+  }
+  return begin_log_offset;
+}
 
-  // Perform all deletes before we commit.
+void TransactionManager::RemoveTransaction(Transaction *txn) {
+  TxnMapShard &shard = GetTxnMapShard(txn->GetTransactionId());
+  shard.latch_.WLock();
+  // Another transaction manager may have registered a transaction of the same ID since.
+  auto iter = shard.txns_.find(txn->GetTransactionId());
+  if (iter != shard.txns_.end() && iter->second == txn) {
+    shard.txns_.erase(iter);
+  }
+  shard.latch_.WUnlock();
+}
+
+bool TransactionManager::Commit(Transaction *txn) {
+  if (txn->IsReadOnly()) {
+    // The snapshot may have read the versions of commits not yet durable, at most the last one.
+    const lsn_t durable_lsn = last_commit_lsn_.load();
+    EndReadOnly(txn, TransactionState::COMMITTED);
+    if (durable_lsn != INVALID_LSN && log_manager_ != nullptr) {
+      log_manager_->WaitUntilPersistent(durable_lsn);
+    }
+    return true;
+  }
+  // Stamp the writes with the commit timestamp, which the new snapshots only see once all are stamped. The commits
+  // stamping theirs meanwhile are ordered before an optimistic transaction, which is validated against them.
   auto write_set = txn->GetWriteSet();
-  while (!write_set->empty()) {
-    auto &item = write_set->back();
-    auto table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
-      // Note that this also releases the lock when holding the page latch.
-      table->ApplyDelete(item.rid_, txn);
+  std::chrono::steady_clock::time_point commit_appended;
+  if (!write_set->empty() || txn->IsOptimistic()) {
+    std::unique_lock commit_latch(commit_latch_);
+    if (txn->IsOptimistic() && !Validate(txn)) {
+      commit_latch.unlock();
+      Abort(txn);
+      return false;
     }
-    write_set->pop_back();
+    const timestamp_t commit_ts = last_commit_ts_.load() + 1;
+    for (const TableWriteRecord &item : *write_set) {
+      item.table_->CommitVersion(item.rid_, txn, commit_ts);
+      item.table_->SetLastCommitTs(commit_ts);
+    }
+    if (!write_set->empty()) {
+      AppendCommitRecord(txn);
+      commit_appended = std::chrono::steady_clock::now();
+    }
+    last_commit_ts_.store(commit_ts);
+  }
+  // The changes to the base tables of materialized views are folded into the views once committed.
+  MaterializedView::CommitDeltas(txn->GetViewDeltas());
+  if (txn->ReadsVersions()) {
+    // The versions read without locks may be those of commits not yet durable, at most the last one.
+    txn->AddDependencyLSN(last_commit_lsn_.load());
   }
+  txn->SetState(TransactionState::COMMITTED);
+
+  // The overflow chains the updates no longer point to, and those of the deleted tuples, are freed once unreachable.
+  std::vector<TableHeap *> retiring_tables;
+  for (const TableWriteRecord &item : *write_set) {
+    if (item.wtype_ == WType::UPDATE) {
+      item.table_->RetireReplaced(item.rid_, item.tuple_, txn);
+    }
+    if ((item.wtype_ == WType::UPDATE || item.wtype_ == WType::DELETE) &&
+        std::find(retiring_tables.begin(), retiring_tables.end(), item.table_) == retiring_tables.end()) {
+      retiring_tables.push_back(item.table_);
+    }
+  }
+  // Perform all deletes before we commit, those of a page at once.
+  ApplyDeletes(txn);
   write_set->clear();
+  // The index changes stay.
+  txn->GetIndexWriteSet()->clear();
 
-  // Release all the locks.
+  // Release all the locks, early: the commit record is in the log buffer, but may not be durable yet. The transactions
+  // taking them over depend on this commit, and wait for its record before they report their own.
   ReleaseLocks(txn);
-  // Release the global transaction latch.
-  global_txn_latch_.RUnlock();
+  RemoveTransaction(txn);
+  EndSnapshot(txn);
+  // Leave the running transactions, a checkpoint does not wait for the log flush.
+  LeaveBarrier();
+
+  // The commit is only reported once the log holds it, and the commits it depends on before it.
+  const lsn_t durable_lsn = std::max(txn->GetCommitLSN(), txn->GetDependencyLSN());
+  if (durable_lsn != INVALID_LSN && log_manager_ != nullptr) {
+    log_manager_->WaitUntilPersistent(durable_lsn);
+    if (txn->GetCommitLSN() != INVALID_LSN) {
+      log_manager_->RecordCommitLatency(commit_appended);
+    }
+  }
+  // Durable, the commit frees its retired chains no snapshot reads, and those of the commits before it.
+  if (!retiring_tables.empty()) {
+    const timestamp_t oldest_ts = GetOldestSnapshotTs();
+    for (TableHeap *table : retiring_tables) {
+      table->FreeRetiredChains(oldest_ts);
+    }
+  }
+  return true;
+}
+
+void TransactionManager::ApplyDeletes(Transaction *txn) {
+  std::vector<std::pair<TableHeap *, RID>> deletes;
+  for (const TableWriteRecord &item : *txn->GetWriteSet()) {
+    if (item.wtype_ == WType::DELETE) {
+      deletes.emplace_back(item.table_, item.rid_);
+    }
+  }
+  std::sort(deletes.begin(), deletes.end(), [](const auto &a, const auto &b) {
+    return a.first != b.first ? std::less<>()(a.first, b.first) : a.second.GetPageId() < b.second.GetPageId();
+  });
+  std::vector<RID> rids;
+  for (size_t i = 0; i < deletes.size(); i++) {
+    rids.push_back(deletes[i].second);
+    if (i + 1 == deletes.size() || deletes[i + 1].first != deletes[i].first ||
+        deletes[i + 1].second.GetPageId() != deletes[i].second.GetPageId()) {
+      // Note that this also releases the locks when holding the page latch.
+      deletes[i].first->ApplyDeletes(rids, txn);
+      rids.clear();
+    }
+  }
 }
 
 void TransactionManager::Abort(Transaction *txn) {
+  if (txn->IsReadOnly()) {
+    // A snapshot is aborted before it writes anything, see TableHeap::CanWrite.
+    EndReadOnly(txn, TransactionState::ABORTED);
+    return;
+  }
   txn->SetState(TransactionState::ABORTED);
   // Rollback before releasing the lock.
   auto table_write_set = txn->GetWriteSet();
@@ -70,10 +246,13 @@ void TransactionManager::Abort(Transaction *txn) {
       table->ApplyDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::UPDATE) {
       table->UpdateTuple(item.tuple_, item.rid_, txn);
+    } else if (item.wtype_ == WType::INCREMENT) {
+      table->RollbackIncrement(item.rid_, item.increments_, txn);
     }
     table_write_set->pop_back();
   }
   table_write_set->clear();
+  txn->GetViewDeltas()->clear();
   // Rollback index updates
   auto index_write_set = txn->GetIndexWriteSet();
   while (!index_write_set->empty()) {
@@ -102,12 +281,86 @@ void TransactionManager::Abort(Transaction *txn) {
 
   // Release all the locks.
   ReleaseLocks(txn);
-  // Release the global transaction latch.
-  global_txn_latch_.RUnlock();
+  RemoveTransaction(txn);
+  // Once out of the running transactions: a checkpoint that misses the abort record finds the rollback done.
+  if (enable_logging && log_manager_ != nullptr && txn->GetPrevLSN() != INVALID_LSN) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+  EndSnapshot(txn);
+  // Leave the running transactions.
+  LeaveBarrier();
+}
+
+timestamp_t TransactionManager::GetOldestSnapshotTs() {
+  std::scoped_lock snapshot_latch(snapshot_latch_);
+  return snapshots_.empty() ? last_commit_ts_.load() : *snapshots_.begin();
+}
+
+bool TransactionManager::Validate(Transaction *txn) {
+  // Backward validation: no transaction committed a write to a tuple read since the version read.
+  for (const TableReadRecord &item : *txn->GetReadSet()) {
+    if (item.table_->GetVersionStore()->GetLatestCommitTs(item.rid_) > item.version_ts_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TransactionManager::AppendCommitRecord(Transaction *txn) {
+  if (!enable_logging || log_manager_ == nullptr) {
+    return;
+  }
+  LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+  const lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+  txn->SetPrevLSN(lsn);
+  txn->SetCommitLSN(lsn);
+  if (lsn != INVALID_LSN) {
+    last_commit_lsn_.store(lsn);
+  }
+}
+
+void TransactionManager::EndSnapshot(Transaction *txn) {
+  if (txn->ReadsVersions()) {
+    std::scoped_lock snapshot_latch(snapshot_latch_);
+    snapshots_.erase(snapshots_.find(txn->GetReadTs()));
+  }
 }
 
-void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
+void TransactionManager::EnterBarrier() {
+  // The fast path is one increment: a transaction counts itself in, then looks for a checkpoint, which raises its flag
+  // before counting the transactions, so one of them sees the other.
+  while (true) {
+    num_in_barrier_.fetch_add(1);
+    if (!blocking_.load()) {
+      return;
+    }
+    LeaveBarrier();
+    std::unique_lock barrier_latch(barrier_latch_);
+    barrier_cv_.wait(barrier_latch, [this] { return !blocking_.load(); });
+  }
+}
 
-void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
+void TransactionManager::LeaveBarrier() {
+  if (num_in_barrier_.fetch_sub(1) == 1 && blocking_.load()) {
+    // Under the latch, so that the checkpoint cannot miss the notification between its check and its wait.
+    std::scoped_lock barrier_latch(barrier_latch_);
+    barrier_cv_.notify_all();
+  }
+}
+
+void TransactionManager::BlockAllTransactions() {
+  std::unique_lock barrier_latch(barrier_latch_);
+  // One checkpoint at a time.
+  barrier_cv_.wait(barrier_latch, [this] { return !blocking_.load(); });
+  blocking_.store(true);
+  barrier_cv_.wait(barrier_latch, [this] { return num_in_barrier_.load() == 0; });
+}
+
+void TransactionManager::ResumeTransactions() {
+  std::scoped_lock barrier_latch(barrier_latch_);
+  blocking_.store(false);
+  barrier_cv_.notify_all();
+}
 
 }  // namespace bustub
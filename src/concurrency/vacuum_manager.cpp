@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vacuum_manager.cpp
+//
+// Identification: src/concurrency/vacuum_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/vacuum_manager.h"
+
+namespace bustub {
+
+void VacuumManager::RunVacuumThread() {
+  if (vacuum_thread_ == nullptr) {
+    enable_vacuum_ = true;
+    vacuum_thread_ = new std::thread(&VacuumManager::RunVacuum, this);
+  }
+}
+
+void VacuumManager::StopVacuumThread() {
+  if (vacuum_thread_ != nullptr) {
+    enable_vacuum_ = false;
+    vacuum_thread_->join();
+    delete vacuum_thread_;
+    vacuum_thread_ = nullptr;
+  }
+}
+
+size_t VacuumManager::VacuumStep() {
+  // Taken once for all the tables: a snapshot beginning meanwhile reads at this timestamp or later.
+  const timestamp_t oldest_ts = transaction_manager_->GetOldestSnapshotTs();
+  size_t num_reclaimed = 0;
+  for (TableMetadata *table_metadata : catalog_->GetTables()) {
+    // The partitions of a partitioned table are vacuumed as tables of their own.
+    if (table_metadata->IsPartitioned()) {
+      continue;
+    }
+    num_reclaimed += table_metadata->table_->GetVersionStore()->Vacuum(oldest_ts, pages_per_step_);
+    // Those the commits left to the snapshots running then.
+    table_metadata->table_->FreeRetiredChains(oldest_ts);
+    for (IndexInfo *index_info : catalog_->GetTableIndexes(table_metadata->name_)) {
+      index_info->index_->MergeChanges(pages_per_step_);
+    }
+  }
+  return num_reclaimed;
+}
+
+void VacuumManager::RunVacuum() {
+  while (enable_vacuum_) {
+    std::this_thread::sleep_for(vacuum_interval_);
+    VacuumStep();
+  }
+}
+
+}  // namespace bustub
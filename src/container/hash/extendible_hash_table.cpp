@@ -0,0 +1,273 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.cpp
+//
+// Identification: src/container/hash/extendible_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "container/hash/extendible_hash_table.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  page_id_t bucket_page_id;
+  Page *bucket_page = buffer_pool_manager_->NewPage(&bucket_page_id);
+  if (bucket_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new hash table bucket page");
+  }
+  BucketOf(bucket_page)->Init();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+
+  Page *dir_page = buffer_pool_manager_->NewPage(&directory_page_id_);
+  if (dir_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new hash table directory page");
+  }
+  reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData())->Init(directory_page_id_, bucket_page_id);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::Hash(const KeyType &key) {
+  return static_cast<uint32_t>(hash_fn_.GetHash(key));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableDirectoryPage *EXTENDIBLE_HASH_TABLE_TYPE::FetchDirectoryPage() {
+  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table directory page");
+  }
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *EXTENDIBLE_HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table bucket page");
+  }
+  return page;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                          std::vector<ValueType> *result) {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  const page_id_t bucket_page_id = dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->RLatch();
+  const bool found = BucketOf(page)->GetValue(key, comparator_, result);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  const page_id_t bucket_page_id = dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->WLatch();
+  HASH_TABLE_BUCKET_TYPE *bucket = BucketOf(page);
+  const bool full = bucket->IsFull();
+  const bool inserted = !full && bucket->Insert(key, value, comparator_);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (!full) {
+    return inserted;
+  }
+  return SplitInsert(transaction, key, value);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool dir_dirty = false;
+  bool inserted = false;
+  // Another split may have made room in the meantime; the bucket is looked up afresh after each split.
+  while (true) {
+    const uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    const page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    Page *page = FetchBucketPage(bucket_page_id);
+    HASH_TABLE_BUCKET_TYPE *bucket = BucketOf(page);
+    if (!bucket->IsFull()) {
+      inserted = bucket->Insert(key, value, comparator_);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+    std::vector<ValueType> values;
+    bucket->GetValue(key, comparator_, &values);
+    const uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (std::find(values.begin(), values.end(), value) != values.end() || local_depth == DIRECTORY_MAX_DEPTH) {
+      // The pair is there already, or the bucket holds keys of a single hash the directory cannot tell apart.
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    if (local_depth == dir_page->GetGlobalDepth()) {
+      dir_page->IncrGlobalDepth();
+    }
+
+    // Move the pairs with the new local depth bit set to the split image.
+    page_id_t image_page_id;
+    Page *image_page = buffer_pool_manager_->NewPage(&image_page_id);
+    if (image_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+      table_latch_.WUnlock();
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new hash table bucket page");
+    }
+    HASH_TABLE_BUCKET_TYPE *image = BucketOf(image_page);
+    image->Init();
+    const uint32_t split_bit = 1U << local_depth;
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (bucket->IsReadable(i) && (Hash(bucket->KeyAt(i)) & split_bit) != 0) {
+        image->Insert(bucket->KeyAt(i), bucket->ValueAt(i), comparator_);
+        bucket->RemoveAt(i);
+      }
+    }
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      if (dir_page->GetBucketPageId(i) == bucket_page_id) {
+        dir_page->SetLocalDepth(i, local_depth + 1);
+        if ((i & split_bit) != 0) {
+          dir_page->SetBucketPageId(i, image_page_id);
+        }
+      }
+    }
+    dir_dirty = true;
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  const uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+  const page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+  const bool mergeable = dir_page->GetLocalDepth(bucket_idx) > 0;
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->WLatch();
+  HASH_TABLE_BUCKET_TYPE *bucket = BucketOf(page);
+  const bool removed = bucket->Remove(key, value, comparator_);
+  const bool empty = bucket->IsEmpty();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (removed && empty && mergeable) {
+    Merge(transaction, key);
+  }
+  return removed;
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key) {
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  const uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+  bool dir_dirty = false;
+  // The merged bucket is empty too, so it may merge with its own split image in turn.
+  while (true) {
+    const page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    const uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == 0 || dir_page->GetLocalDepth(dir_page->GetSplitImageIndex(bucket_idx)) != local_depth) {
+      break;
+    }
+    // An insert may have refilled the bucket before the table latch was taken.
+    Page *page = FetchBucketPage(bucket_page_id);
+    const bool empty = BucketOf(page)->IsEmpty();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    if (!empty) {
+      break;
+    }
+    const page_id_t image_page_id = dir_page->GetBucketPageId(dir_page->GetSplitImageIndex(bucket_idx));
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      const page_id_t page_id = dir_page->GetBucketPageId(i);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        dir_page->SetBucketPageId(i, image_page_id);
+        dir_page->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+    dir_dirty = true;
+  }
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+}
+
+/*****************************************************************************
+ * GETGLOBALDEPTH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  const uint32_t global_depth = dir_page->GetGlobalDepth();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::VerifyIntegrity() {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  dir_page->VerifyIntegrity();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+}
+
+template class ExtendibleHashTable<int, int, IntComparator>;
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,21 +28,313 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  header_page_id_ = NewTable(std::min(RoundUpToGroups(std::max<size_t>(num_buckets, 1)), MAX_BUCKETS));
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::HomeSlot(uint64_t hash, size_t size) {
+  // The low bits of the hash make the tag, the others pick the group.
+  return (hash >> 7) % (size / BLOCK_GROUP_SIZE) * BLOCK_GROUP_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::RoundUpToGroups(size_t num_buckets) {
+  return (num_buckets + BLOCK_GROUP_SIZE - 1) / BLOCK_GROUP_SIZE * BLOCK_GROUP_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::LatchHomeBlock(const KeyType &key) {
+  HashTableHeaderPage *header = FetchHeaderPage(header_page_id_);
+  const page_id_t block_page_id =
+      header->GetBlockPageId(HomeSlot(hash_fn_.GetHash(key), header->GetSize()) / BLOCK_ARRAY_SIZE);
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table block page");
+  }
+  page->WLatch();
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::UnlatchHomeBlock(Page *page) {
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableHeaderPage *HASH_TABLE_TYPE::FetchHeaderPage(page_id_t header_page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(header_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table header page");
+  }
+  return reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_BLOCK_TYPE *HASH_TABLE_TYPE::FetchBlockPage(page_id_t block_page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch hash table block page");
+  }
+  return reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_TYPE::NewTable(size_t num_buckets) {
+  page_id_t header_page_id;
+  Page *page = buffer_pool_manager_->NewPage(&header_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new hash table header page");
+  }
+  auto header = reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  header->SetPageId(header_page_id);
+  header->SetSize(num_buckets);
+  // New pages are zeroed, so the blocks start out with no slot occupied.
+  for (size_t i = 0; i < (num_buckets - 1) / BLOCK_ARRAY_SIZE + 1; i++) {
+    page_id_t block_page_id;
+    if (buffer_pool_manager_->NewPage(&block_page_id) == nullptr) {
+      buffer_pool_manager_->UnpinPage(header_page_id, true);
+      DeleteTable(header_page_id);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new hash table block page");
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+    header->AddBlockPageId(block_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id, true);
+  return header_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::DeleteTable(page_id_t header_page_id) {
+  HashTableHeaderPage *header = FetchHeaderPage(header_page_id);
+  for (size_t i = 0; i < header->NumBlocks(); i++) {
+    buffer_pool_manager_->DeletePage(header->GetBlockPageId(i));
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  buffer_pool_manager_->DeletePage(header_page_id);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::Probe(page_id_t header_page_id, uint64_t hash, bool is_dirty, Visitor visit) {
+  HashTableHeaderPage *header = FetchHeaderPage(header_page_id);
+  const bool stopped =
+      ProbeFrom(header, HomeSlot(hash, header->GetSize()), HASH_TABLE_BLOCK_TYPE::TagOf(hash), is_dirty, visit);
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  return stopped;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::ProbeFrom(HashTableHeaderPage *header, size_t home, uint8_t tag, bool is_dirty,
+                                Visitor visit) {
+  const size_t size = header->GetSize();
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  HASH_TABLE_BLOCK_TYPE *block = nullptr;
+  bool stopped = false;
+  for (size_t i = 0; i < size && !stopped; i += BLOCK_GROUP_SIZE) {
+    const size_t slot = (home + i) % size;
+    const page_id_t page_id = header->GetBlockPageId(slot / BLOCK_ARRAY_SIZE);
+    if (page_id != block_page_id) {
+      if (block != nullptr) {
+        buffer_pool_manager_->UnpinPage(block_page_id, false);
+      }
+      block_page_id = page_id;
+      block = FetchBlockPage(block_page_id);
+    }
+    const slot_offset_t group = slot % BLOCK_ARRAY_SIZE;
+    // The slots whose tag matches go first, then the empty ones, which only an insert has a use for; a slot found
+    // empty may have been claimed since, so each is visited in turn.
+    const uint32_t empty = block->MatchEmpty(group);
+    for (uint32_t mask : {block->MatchTag(group, tag), empty}) {
+      for (; mask != 0 && !stopped; mask &= mask - 1) {
+        stopped = visit(block, static_cast<slot_offset_t>(group + __builtin_ctz(mask)));
+      }
+    }
+    // The first group with an empty slot ends the probe sequence: inserts go to the first empty slot they find.
+    if (empty != 0) {
+      break;
+    }
+  }
+  if (block != nullptr) {
+    buffer_pool_manager_->UnpinPage(block_page_id, stopped && is_dirty);
+  }
+  return stopped;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::Collector(const KeyType &key, std::vector<ValueType> *result, size_t num_values,
+                                const size_t *num_old_values) {
+  return [this, &key, result, num_values, num_old_values](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0) {
+      const ValueType value = block->ValueAt(offset);
+      // A pair that migrates during the lookup is met in both tables.
+      const auto old_end = result->begin() + *num_old_values;
+      if (std::find(result->begin() + num_values, old_end, value) == old_end) {
+        result->push_back(value);
+      }
+    }
+    return false;
+  };
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename HASH_TABLE_TYPE::InsertResult HASH_TABLE_TYPE::InsertInto(page_id_t header_page_id, const KeyType &key,
+                                                                   const ValueType &value) {
+  InsertResult result = InsertResult::FULL;
+  const uint64_t hash = hash_fn_.GetHash(key);
+  Probe(header_page_id, hash, true, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (block->IsReadable(offset)) {
+      if (comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+        result = InsertResult::DUPLICATE;
+        return true;
+      }
+      return false;
+    }
+    // Tombstones are not reused, so the pair is only claimed past the end of the probe sequence. Another key may
+    // claim the slot first, in which case the probe goes on past it.
+    if (!block->IsOccupied(offset) && block->Insert(offset, key, value, HASH_TABLE_BLOCK_TYPE::TagOf(hash))) {
+      result = InsertResult::INSERTED;
+      return true;
+    }
+    return false;
+  });
+  if (result == InsertResult::INSERTED) {
+    num_occupied_++;
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::FindPair(page_id_t header_page_id, const KeyType &key, const ValueType &value, bool remove) {
+  return Probe(header_page_id, hash_fn_.GetHash(key), remove, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset) {
+    if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+      if (remove) {
+        block->Remove(offset);
+      }
+      return true;
+    }
+    return false;
+  });
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  table_latch_.RLock();
+  const bool migrated = Migrate(MIGRATION_STEP);
+  const size_t num_values = result->size();
+  size_t num_old_values = num_values;
+  auto collect = Collector(key, result, num_values, &num_old_values);
+  const uint64_t hash = hash_fn_.GetHash(key);
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    Probe(old_header_page_id_, hash, false, collect);
+    num_old_values = result->size();
+  }
+  Probe(header_page_id_, hash, false, collect);
+  table_latch_.RUnlock();
+  if (migrated) {
+    FinishResize();
+  }
+  return result->size() > num_values;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) {
+  results->assign(keys.size(), {});
+  table_latch_.RLock();
+  const bool migrated = Migrate(MIGRATION_STEP);
+  std::vector<size_t> num_old_values(keys.size(), 0);
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    // Only the current table is prefetched; the old one is on its way out.
+    for (size_t i = 0; i < keys.size(); i++) {
+      Probe(old_header_page_id_, hash_fn_.GetHash(keys[i]), false,
+            Collector(keys[i], &(*results)[i], 0, &num_old_values[i]));
+      num_old_values[i] = (*results)[i].size();
+    }
+  }
+
+  // The keys go a group at a time: the first pass hashes the keys of the group and prefetches their home slots,
+  // keeping their blocks pinned for the second pass, which probes them.
+  HashTableHeaderPage *header = FetchHeaderPage(header_page_id_);
+  const size_t size = header->GetSize();
+  uint64_t hashes[PROBE_GROUP_SIZE];
+  size_t homes[PROBE_GROUP_SIZE];
+  page_id_t home_page_ids[PROBE_GROUP_SIZE];
+  for (size_t begin = 0; begin < keys.size(); begin += PROBE_GROUP_SIZE) {
+    const size_t end = std::min(begin + PROBE_GROUP_SIZE, keys.size());
+    for (size_t i = begin; i < end; i++) {
+      hashes[i - begin] = hash_fn_.GetHash(keys[i]);
+      homes[i - begin] = HomeSlot(hashes[i - begin], size);
+      home_page_ids[i - begin] = header->GetBlockPageId(homes[i - begin] / BLOCK_ARRAY_SIZE);
+      FetchBlockPage(home_page_ids[i - begin])->PrefetchSlot(homes[i - begin] % BLOCK_ARRAY_SIZE);
+    }
+    for (size_t i = begin; i < end; i++) {
+      ProbeFrom(header, homes[i - begin], HASH_TABLE_BLOCK_TYPE::TagOf(hashes[i - begin]), false,
+                Collector(keys[i], &(*results)[i], 0, &num_old_values[i]));
+      buffer_pool_manager_->UnpinPage(home_page_ids[i - begin], false);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  table_latch_.RUnlock();
+  if (migrated) {
+    FinishResize();
+  }
 }
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  if (!HASH_TABLE_BLOCK_TYPE::Fits(key)) {
+    return false;
+  }
+  // the size of the table found full, which must grow before the pair can go in
+  size_t full_size = 0;
+  while (true) {
+    table_latch_.RLock();
+    const size_t size = GetSizeLocked();
+    const bool grow = size == full_size || NeedsResize();
+    bool migrated = false;
+    InsertResult result = InsertResult::FULL;
+    if (!grow) {
+      migrated = Migrate(MIGRATION_STEP);
+      Page *home_page = LatchHomeBlock(key);
+      result = old_header_page_id_ != INVALID_PAGE_ID && FindPair(old_header_page_id_, key, value, false)
+                   ? InsertResult::DUPLICATE
+                   : InsertInto(header_page_id_, key, value);
+      UnlatchHomeBlock(home_page);
+    }
+    table_latch_.RUnlock();
+    if (migrated) {
+      FinishResize();
+    }
+    if (result != InsertResult::FULL) {
+      return result == InsertResult::INSERTED;
+    }
+    if (!grow) {
+      full_size = size;
+      continue;
+    }
+    table_latch_.WLock();
+    // Another thread may have grown the table first.
+    const bool grown = GetSizeLocked() != size || size < MAX_BUCKETS;
+    if (GetSizeLocked() == size) {
+      ResizeLocked(2 * size);
+    }
+    table_latch_.WUnlock();
+    if (!grown) {
+      return false;
+    }
+  }
 }
 
 /*****************************************************************************
@@ -48,21 +342,174 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  table_latch_.RLock();
+  const bool migrated = Migrate(MIGRATION_STEP);
+  Page *home_page = LatchHomeBlock(key);
+  const bool removed = (old_header_page_id_ != INVALID_PAGE_ID && FindPair(old_header_page_id_, key, value, true)) ||
+                       FindPair(header_page_id_, key, value, true);
+  UnlatchHomeBlock(home_page);
+  table_latch_.RUnlock();
+  if (migrated) {
+    FinishResize();
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  ResizeLocked(2 * std::max(initial_size, GetSizeLocked()));
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::NeedsResize() {
+  const size_t size = GetSizeLocked();
+  return 4 * (num_occupied_ + 1) > 3 * size && size < MAX_BUCKETS;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::ResizeLocked(size_t num_buckets) {
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    Migrate(std::numeric_limits<size_t>::max());
+    if (num_migrated_ == old_size_) {
+      DeleteTable(old_header_page_id_);
+      old_header_page_id_ = INVALID_PAGE_ID;
+    }
+  }
+  num_buckets = std::min(RoundUpToGroups(num_buckets), MAX_BUCKETS);
+  if (num_buckets <= GetSizeLocked()) {
+    // The table cannot grow any further; inserts go on until it is full.
+    return;
+  }
+  const page_id_t header_page_id = NewTable(num_buckets);
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    // The current table filled up before the old one could migrate to it. No operation is in flight, so both are
+    // rehashed into the new table at once.
+    num_occupied_ = 0;
+    for (const page_id_t from_header_page_id : {old_header_page_id_, header_page_id_}) {
+      MoveAll(from_header_page_id, header_page_id);
+      DeleteTable(from_header_page_id);
+    }
+    header_page_id_ = header_page_id;
+    old_header_page_id_ = INVALID_PAGE_ID;
+    return;
+  }
+  old_size_ = GetSizeLocked();
+  old_header_page_id_ = header_page_id_;
+  header_page_id_ = header_page_id;
+  migrate_index_ = 0;
+  num_migrated_ = 0;
+  num_occupied_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Migrate(size_t num_slots) {
+  if (old_header_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  // Each migrating operation claims the next slots for itself.
+  size_t begin = migrate_index_;
+  size_t end;
+  do {
+    if (begin >= old_size_) {
+      return false;
+    }
+    end = begin + std::min(num_slots, old_size_ - begin);
+  } while (!migrate_index_.compare_exchange_weak(begin, end));
+
+  HashTableHeaderPage *old_header = FetchHeaderPage(old_header_page_id_);
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  HASH_TABLE_BLOCK_TYPE *block = nullptr;
+  size_t num_migrated = 0;
+  for (size_t slot = begin; slot < end; slot++) {
+    const page_id_t page_id = old_header->GetBlockPageId(slot / BLOCK_ARRAY_SIZE);
+    if (page_id != block_page_id) {
+      if (block != nullptr) {
+        buffer_pool_manager_->UnpinPage(block_page_id, true);
+      }
+      block_page_id = page_id;
+      block = FetchBlockPage(block_page_id);
+    }
+    const slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    if (block->IsReadable(offset)) {
+      const KeyType key = block->KeyAt(offset);
+      Page *home_page = LatchHomeBlock(key);
+      // A remove may have beaten the latch to the pair.
+      if (!block->IsReadable(offset) ||
+          InsertInto(header_page_id_, key, block->ValueAt(offset)) != InsertResult::FULL) {
+        // The old slot stays occupied as a tombstone, keeping the probe sequences that pass it intact.
+        block->Remove(offset);
+        num_migrated++;
+      }
+      // Otherwise the pair stays behind, and so does the old table, until the next resize rehashes both.
+      UnlatchHomeBlock(home_page);
+    } else {
+      num_migrated++;
+    }
+  }
+  if (block != nullptr) {
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+  }
+  buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+  return num_migrated_.fetch_add(num_migrated) + num_migrated == old_size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::MoveAll(page_id_t from_header_page_id, page_id_t to_header_page_id) {
+  HashTableHeaderPage *from_header = FetchHeaderPage(from_header_page_id);
+  for (size_t i = 0; i < from_header->NumBlocks(); i++) {
+    const page_id_t block_page_id = from_header->GetBlockPageId(i);
+    HASH_TABLE_BLOCK_TYPE *block = FetchBlockPage(block_page_id);
+    for (slot_offset_t offset = 0; offset < BLOCK_ARRAY_SIZE; offset++) {
+      if (block->IsReadable(offset)) {
+        InsertInto(to_header_page_id, block->KeyAt(offset), block->ValueAt(offset));
+      }
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, false);
+  }
+  buffer_pool_manager_->UnpinPage(from_header_page_id, false);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::FinishResize() {
+  table_latch_.WLock();
+  // Another thread may have finished it, or even started the next resize, first.
+  if (old_header_page_id_ != INVALID_PAGE_ID && num_migrated_ == old_size_) {
+    DeleteTable(old_header_page_id_);
+    old_header_page_id_ = INVALID_PAGE_ID;
+  }
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+  table_latch_.RLock();
+  const size_t size = GetSizeLocked();
+  table_latch_.RUnlock();
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::GetSizeLocked() {
+  HashTableHeaderPage *header = FetchHeaderPage(header_page_id_);
+  const size_t size = header->GetSize();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::IsResizing() {
+  table_latch_.RLock();
+  const bool resizing = old_header_page_id_ != INVALID_PAGE_ID;
+  table_latch_.RUnlock();
+  return resizing;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -72,5 +519,6 @@ template class LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
 template class LinearProbeHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+template class LinearProbeHashTable<VarlenKey, RID, VarlenComparator>;
 
 }  // namespace bustub
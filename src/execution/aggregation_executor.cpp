@@ -1,29 +1,265 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// aggregation_executor.cpp
-//
-// Identification: src/execution/aggregation_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/aggregation_executor.h"
-
-namespace bustub {
-
-AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
-                                         std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx) {}
-
-const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
-
-void AggregationExecutor::Init() {}
-
-bool AggregationExecutor::Next(Tuple *tuple, RID *rid) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor.cpp
+//
+// Identification: src/execution/aggregation_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "execution/executors/aggregation_executor.h"
+
+namespace bustub {
+
+AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      flat_(FlatAggregationHashTable::Supports(plan)),
+      aht_iterator_(std::unordered_map<AggregateKey, AggregateValue>::const_iterator()),
+      // Each partition buffers a block of the temporary space while the input is being spilled.
+      num_partitions_(
+          std::clamp<size_t>(exec_ctx->GetMemoryBudget() / TEMP_SPACE_BLOCK_SIZE, 2, AGGREGATION_MAX_PARTITIONS)),
+      simple_group_bytes_(sizeof(std::pair<const AggregateKey, AggregateValue>) + 4 * sizeof(void *) +
+                          (plan->GetGroupBys().size() + plan->GetAggregates().size()) * sizeof(Value)) {}
+
+const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
+
+void AggregationExecutor::Init() {
+  tables_.clear();
+  flat_tables_.clear();
+  pending_.clear();
+  auto *exchange = dynamic_cast<ExchangeExecutor *>(child_.get());
+  ThreadPool *thread_pool = exec_ctx_->GetThreadPool();
+  if (exchange != nullptr && thread_pool != nullptr) {
+    if (flat_) {
+      AggregateFlatInParallel(exchange, thread_pool);
+    } else {
+      AggregateInParallel(exchange, thread_pool);
+    }
+  } else {
+    child_->Init();
+    ResetTable();
+    std::vector<TmpTupleRun> spill;
+    TupleBatch batch;
+    // Without group-bys, the single group fits in memory whatever the input, and takes whole batches at once.
+    const bool by_batch = flat_ && plan_->GetGroupBys().empty();
+    while (child_->NextBatch(&batch)) {
+      if (by_batch) {
+        flat_tables_[0].InsertBatch(batch.GetTuples());
+        continue;
+      }
+      for (const Tuple &tuple : batch.GetTuples()) {
+        Absorb(tuple, 0, &spill);
+      }
+    }
+    QueueSpilled(&spill, 0);
+  }
+  ResetIterator();
+}
+
+void AggregationExecutor::Close() {
+  tables_.clear();
+  flat_tables_.clear();
+  pending_.clear();
+  child_->Close();
+}
+
+void AggregationExecutor::ResetTable() {
+  tables_.clear();
+  flat_tables_.clear();
+  if (flat_) {
+    flat_tables_.emplace_back(plan_, child_->GetOutputSchema());
+  } else {
+    tables_.emplace_back(plan_->GetAggregates(), plan_->GetAggregateTypes());
+  }
+}
+
+void AggregationExecutor::ResetIterator() {
+  table_idx_ = 0;
+  if (flat_) {
+    flat_iterator_ = flat_tables_[0].Begin();
+  } else {
+    aht_iterator_ = tables_[0].Begin();
+  }
+}
+
+size_t AggregationExecutor::MemoryUsage() const {
+  return flat_ ? flat_tables_[0].MemoryUsage()
+               : tables_[0].Size() * simple_group_bytes_ + tables_[0].DistinctMemoryUsage();
+}
+
+void AggregationExecutor::Absorb(const Tuple &tuple, uint32_t depth, std::vector<TmpTupleRun> *spill) {
+  if (!spill->empty()) {
+    // Over budget: only the groups in memory still take tuples.
+    bool present =
+        flat_ ? flat_tables_[0].InsertIfPresent(tuple) : tables_[0].CombineIfPresent(MakeKey(&tuple), MakeVal(&tuple));
+    if (!present) {
+      (*spill)[PartitionOf(tuple, depth)].Append(tuple);
+    }
+    return;
+  }
+  if (flat_) {
+    flat_tables_[0].Insert(tuple);
+  } else {
+    tables_[0].InsertCombine(MakeKey(&tuple), MakeVal(&tuple));
+  }
+  if (depth < MAX_DEPTH && MemoryUsage() > exec_ctx_->GetMemoryBudget()) {
+    for (size_t i = 0; i < num_partitions_; i++) {
+      spill->emplace_back(exec_ctx_->GetTempSpace(), "an aggregation");
+    }
+  }
+}
+
+size_t AggregationExecutor::PartitionOf(const Tuple &tuple, uint32_t depth) const {
+  hash_t hash = 0;
+  for (const AbstractExpression *group_by : plan_->GetGroupBys()) {
+    Value value = group_by->Evaluate(&tuple, child_->GetOutputSchema());
+    if (!value.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&value));
+    }
+  }
+  // Mix the hash with a seed per depth, so that a partition splits up when it is partitioned again.
+  return HashUtil::HashWords(hash, 0, depth) % num_partitions_;
+}
+
+void AggregationExecutor::QueueSpilled(std::vector<TmpTupleRun> *spill, uint32_t depth) {
+  for (TmpTupleRun &run : *spill) {
+    run.Seal();
+    if (!run.IsEmpty()) {
+      pending_.push_back(SpilledPartition{std::move(run), depth + 1});
+    }
+  }
+}
+
+bool AggregationExecutor::AggregateNextPartition() {
+  if (pending_.empty()) {
+    return false;
+  }
+  SpilledPartition partition = std::move(pending_.back());
+  pending_.pop_back();
+  ResetTable();
+  std::vector<TmpTupleRun> spill;
+  std::vector<Tuple> tuples;
+  while (partition.run_.ReadBlock(&tuples)) {
+    for (const Tuple &tuple : tuples) {
+      Absorb(tuple, partition.depth_, &spill);
+    }
+  }
+  QueueSpilled(&spill, partition.depth_);
+  ResetIterator();
+  return true;
+}
+
+void AggregationExecutor::AggregateInParallel(ExchangeExecutor *exchange, ThreadPool *thread_pool) {
+  const size_t num_workers = exchange->GetNumWorkers();
+  const size_t num_partitions = std::max(num_workers, thread_pool->Size());
+
+  // Phase one: every worker pre-aggregates its tuples into its own row of partitions.
+  std::vector<std::vector<SimpleAggregationHashTable>> local(num_workers);
+  for (auto &partitions : local) {
+    for (size_t i = 0; i < num_partitions; i++) {
+      partitions.emplace_back(plan_->GetAggregates(), plan_->GetAggregateTypes());
+    }
+  }
+  exchange->Drain([&](size_t worker, const TupleBatch &batch) {
+    std::vector<SimpleAggregationHashTable> &partitions = local[worker];
+    for (const Tuple &tuple : batch.GetTuples()) {
+      AggregateKey key = MakeKey(&tuple);
+      size_t partition = std::hash<AggregateKey>{}(key) % num_partitions;
+      partitions[partition].InsertCombine(key, MakeVal(&tuple));
+    }
+  });
+
+  // Phase two: every partition is merged across the workers into the table of the first one.
+  for (size_t i = 0; i < num_partitions; i++) {
+    tables_.push_back(std::move(local[0][i]));
+  }
+  thread_pool->RunAll(
+      num_partitions,
+      [&](size_t partition) {
+        for (size_t worker = 1; worker < num_workers; worker++) {
+          tables_[partition].MergeFrom(&local[worker][partition]);
+        }
+      },
+      exec_ctx_->GetWorkloadClass());
+}
+
+void AggregationExecutor::AggregateFlatInParallel(ExchangeExecutor *exchange, ThreadPool *thread_pool) {
+  const size_t num_workers = exchange->GetNumWorkers();
+  const size_t num_partitions = std::max(num_workers, thread_pool->Size());
+
+  // Phase one: every worker pre-aggregates its tuples into its own table, partitioned by the tables themselves.
+  std::vector<FlatAggregationHashTable> local;
+  for (size_t i = 0; i < num_workers; i++) {
+    local.emplace_back(plan_, child_->GetOutputSchema(), num_partitions);
+  }
+  exchange->Drain([&](size_t worker, const TupleBatch &batch) { local[worker].InsertBatch(batch.GetTuples()); });
+
+  // Phase two: every partition is merged across the workers into a table of its own.
+  for (size_t i = 0; i < num_partitions; i++) {
+    flat_tables_.emplace_back(plan_, child_->GetOutputSchema());
+  }
+  thread_pool->RunAll(
+      num_partitions,
+      [&](size_t partition) {
+        for (const FlatAggregationHashTable &partial : local) {
+          flat_tables_[partition].MergePartition(partial, partition);
+        }
+      },
+      exec_ctx_->GetWorkloadClass());
+}
+
+template <typename Table, typename Emit>
+bool AggregationExecutor::EmitGroup(std::vector<Table> *tables, typename Table::Iterator *iter, const Emit &emit) {
+  const AbstractExpression *having = plan_->GetHaving();
+  while (true) {
+    for (; *iter != (*tables)[table_idx_].End(); ++(*iter)) {
+      const AggregateKey &key = iter->Key();
+      const AggregateValue &val = iter->Val();
+      if (having == nullptr || having->EvaluateAggregate(key.group_bys_, val.aggregates_).GetAs<bool>()) {
+        emit(MakeOutput(key, val));
+        ++(*iter);
+        return true;
+      }
+    }
+    if (table_idx_ + 1 < tables->size()) {
+      *iter = (*tables)[++table_idx_].Begin();
+    } else if (!AggregateNextPartition()) {
+      return false;
+    }
+  }
+}
+
+std::vector<Value> AggregationExecutor::MakeOutput(const AggregateKey &key, const AggregateValue &val) {
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    values.emplace_back(column.GetExpr()->EvaluateAggregate(key.group_bys_, val.aggregates_));
+  }
+  return values;
+}
+
+bool AggregationExecutor::Next(Tuple *tuple, RID *rid) {
+  return EmitGroup([&](std::vector<Value> &&values) { *tuple = Tuple(std::move(values), GetOutputSchema()); });
+}
+
+bool AggregationExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  auto emit = [&](std::vector<Value> &&values) { batch->Append(RID(), values, GetOutputSchema()); };
+  while (!batch->IsFull() && EmitGroup(emit)) {
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
@@ -0,0 +1,281 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.cpp
+//
+// Identification: src/execution/compiled_predicate.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/expressions/compiled_predicate.h"
+
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/selection_kernels.h"
+#include "type/typed_kernels.h"
+
+namespace bustub {
+
+namespace {
+
+using Operands = CompiledPredicate::Operands;
+
+template <typename D>
+inline D ConstantOf(const Operands &operands);
+template <>
+inline int64_t ConstantOf<int64_t>(const Operands &operands) {
+  return operands.int_constant_;
+}
+template <>
+inline double ConstantOf<double>(const Operands &operands) {
+  return operands.decimal_constant_;
+}
+template <>
+inline uint64_t ConstantOf<uint64_t>(const Operands &operands) {
+  return operands.timestamp_constant_;
+}
+
+inline void SetConstant(Operands *operands, int64_t constant) { operands->int_constant_ = constant; }
+inline void SetConstant(Operands *operands, double constant) { operands->decimal_constant_ = constant; }
+inline void SetConstant(Operands *operands, uint64_t constant) { operands->timestamp_constant_ = constant; }
+
+/** column <op> constant, compared in domain D. */
+template <typename Op, typename L, typename D>
+bool ColumnConstant(const char *data, const Operands &operands) {
+  L left = LoadNative<L>(data, operands.left_offset_);
+  return left != NativeNull<L>() && Op()(static_cast<D>(left), ConstantOf<D>(operands));
+}
+
+/** column <op> column. */
+template <typename Op, typename L, typename R>
+bool ColumnColumn(const char *data, const Operands &operands) {
+  L left = LoadNative<L>(data, operands.left_offset_);
+  R right = LoadNative<R>(data, operands.right_offset_);
+  return left != NativeNull<L>() && right != NativeNull<R>() && CompareNative<Op>(left, right);
+}
+
+/** Sets selected to the indices of the set bits of a selection bitmap of the tuples. */
+void SelectFromBitmap(const std::vector<uint64_t> &bitmap, size_t num_tuples, std::vector<uint32_t> *selected) {
+  selected->resize(num_tuples);
+  selected->resize(SelectedIndices(bitmap.data(), num_tuples, selected->data()));
+}
+
+/** column <op> constant over tuples, for a constant of domain D that is a value of L, see Narrow. */
+template <typename Op, typename L, typename D>
+void SelectColumnConstant(const std::vector<Tuple> &tuples, const Operands &operands,
+                          std::vector<uint32_t> *selected) {
+  thread_local std::vector<L> column;
+  thread_local std::vector<uint64_t> bitmap;
+  GatherColumn(tuples, operands.left_offset_, &column);
+  bitmap.resize(SelectionWords(tuples.size()));
+  CompareColumnConstant<Op>(column.data(), tuples.size(), static_cast<L>(ConstantOf<D>(operands)), bitmap.data());
+  SelectFromBitmap(bitmap, tuples.size(), selected);
+}
+
+/** column <op> column over tuples, for two columns of native type T. */
+template <typename Op, typename T>
+void SelectColumnColumn(const std::vector<Tuple> &tuples, const Operands &operands, std::vector<uint32_t> *selected) {
+  thread_local std::vector<T> left;
+  thread_local std::vector<T> right;
+  thread_local std::vector<uint64_t> bitmap;
+  GatherColumn(tuples, operands.left_offset_, &left);
+  GatherColumn(tuples, operands.right_offset_, &right);
+  bitmap.resize(SelectionWords(tuples.size()));
+  CompareColumns<Op>(left.data(), right.data(), tuples.size(), bitmap.data());
+  SelectFromBitmap(bitmap, tuples.size(), selected);
+}
+
+/**
+ * @return true if a constant of domain D is a value of native type L other than its NULL, which a column of L is then
+ * compared with as it is with the constant in D
+ */
+template <typename L, typename D>
+bool Narrow(D constant) {
+  if constexpr (!std::is_same_v<L, D>) {
+    // The bounds keep the conversion of a double defined; the largest value of L is left out, rather than rounded.
+    if (constant < static_cast<D>(std::numeric_limits<L>::lowest()) ||
+        constant >= static_cast<D>(std::numeric_limits<L>::max())) {
+      return false;
+    }
+  }
+  const auto narrowed = static_cast<L>(constant);
+  return static_cast<D>(narrowed) == constant && narrowed != NativeNull<L>();
+}
+
+bool AlwaysFalse(const char * /*data*/, const Operands & /*operands*/) { return false; }
+
+bool AlwaysTrue(const char * /*data*/, const Operands & /*operands*/) { return true; }
+
+/** Calls f with the native types of two types that compare with each other: two numeric types, or two TIMESTAMPs. */
+template <typename F>
+bool DispatchComparableTypes(TypeId left, TypeId right, F &&f) {
+  if ((left == TypeId::TIMESTAMP) != (right == TypeId::TIMESTAMP)) {
+    return false;
+  }
+  bool supported = false;
+  DispatchNativeType(left, [&](auto l) { supported = DispatchNativeType(right, [&](auto r) { f(l, r); }); });
+  return supported;
+}
+
+/** Calls f with the function object of a comparison. */
+template <typename F>
+void DispatchComparison(ComparisonType comp_type, F &&f) {
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      f(std::equal_to<>{});
+      break;
+    case ComparisonType::NotEqual:
+      f(std::not_equal_to<>{});
+      break;
+    case ComparisonType::LessThan:
+      f(std::less<>{});
+      break;
+    case ComparisonType::LessThanOrEqual:
+      f(std::less_equal<>{});
+      break;
+    case ComparisonType::GreaterThan:
+      f(std::greater<>{});
+      break;
+    case ComparisonType::GreaterThanOrEqual:
+      f(std::greater_equal<>{});
+      break;
+  }
+}
+
+/** @return the comparison that holds for (right, left) when comp_type holds for (left, right) */
+ComparisonType Flip(ComparisonType comp_type) {
+  switch (comp_type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comp_type;
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<CompiledPredicate> CompiledPredicate::Compile(const AbstractExpression *predicate,
+                                                              const Schema *schema) {
+  Fn fn;
+  SelectFn select_fn;
+  Operands operands;
+  if (!CompileInto(predicate, schema, &fn, &select_fn, &operands)) {
+    return nullptr;
+  }
+  return std::unique_ptr<CompiledPredicate>(new CompiledPredicate(fn, select_fn, operands));
+}
+
+void CompiledPredicate::Recompile(const AbstractExpression *predicate, const Schema *schema) {
+  // The columns and the types of the constants are those compiled for, so the predicate is still supported.
+  const bool supported = CompileInto(predicate, schema, &fn_, &select_fn_, &operands_);
+  BUSTUB_ASSERT(supported, "A predicate recompiles as it compiled.");
+}
+
+bool CompiledPredicate::CompileInto(const AbstractExpression *predicate, const Schema *schema, Fn *compiled_fn,
+                                    SelectFn *compiled_select_fn, Operands *compiled_operands) {
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return false;
+  }
+  const auto *left_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *right_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+  const auto *left_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+  const auto *right_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  ComparisonType comp_type = comparison->GetComparisonType();
+  Operands operands;
+
+  if (left_constant != nullptr && right_constant != nullptr) {
+    // Folds to a constant.
+    Value result = predicate->Evaluate(nullptr, schema);
+    *compiled_fn = !result.IsNull() && result.GetAs<bool>() ? &AlwaysTrue : &AlwaysFalse;
+    *compiled_select_fn = nullptr;
+    *compiled_operands = operands;
+    return true;
+  }
+  if (left_constant != nullptr && right_column != nullptr) {
+    std::swap(left_column, right_column);
+    std::swap(left_constant, right_constant);
+    comp_type = Flip(comp_type);
+  }
+  if (left_column == nullptr || (right_column == nullptr && right_constant == nullptr)) {
+    return false;
+  }
+
+  const Column &left = schema->GetColumn(left_column->GetColIdx());
+  operands.left_offset_ = left.GetOffset();
+  Fn fn = nullptr;
+  SelectFn select_fn = nullptr;
+  bool supported;
+  if (right_column != nullptr) {
+    const Column &right = schema->GetColumn(right_column->GetColIdx());
+    operands.right_offset_ = right.GetOffset();
+    supported = DispatchComparableTypes(left.GetType(), right.GetType(), [&](auto l, auto r) {
+      using L = decltype(l);
+      using R = decltype(r);
+      DispatchComparison(comp_type, [&](auto op) {
+        using Op = decltype(op);
+        fn = &ColumnColumn<Op, L, R>;
+        if constexpr (std::is_same_v<L, R>) {
+          select_fn = &SelectColumnColumn<Op, L>;
+        }
+      });
+    });
+  } else {
+    const Value &constant = right_constant->GetValue();
+    supported = DispatchComparableTypes(left.GetType(), constant.GetTypeId(), [&](auto l, auto c) {
+      using L = decltype(l);
+      using D = NativeDomain<L, decltype(c)>;
+      if (constant.IsNull()) {
+        fn = &AlwaysFalse;
+        return;
+      }
+      const auto value = static_cast<D>(constant.GetAs<decltype(c)>());
+      SetConstant(&operands, value);
+      DispatchComparison(comp_type, [&](auto op) {
+        using Op = decltype(op);
+        fn = &ColumnConstant<Op, L, D>;
+        if (Narrow<L>(value)) {
+          select_fn = &SelectColumnConstant<Op, L, D>;
+        }
+      });
+    });
+  }
+  if (!supported || fn == nullptr) {
+    return false;
+  }
+  *compiled_fn = fn;
+  *compiled_select_fn = select_fn;
+  *compiled_operands = operands;
+  return true;
+}
+
+void CompiledPredicate::Select(const std::vector<Tuple> &tuples, std::vector<uint32_t> *selected) const {
+  if (select_fn_ != nullptr) {
+    select_fn_(tuples, operands_, selected);
+    return;
+  }
+  selected->clear();
+  for (size_t i = 0; i < tuples.size(); i++) {
+    if (Evaluate(&tuples[i])) {
+      selected->push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+}  // namespace bustub
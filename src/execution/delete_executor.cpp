@@ -11,16 +11,58 @@
 //===----------------------------------------------------------------------===//
 #include <memory>
 
+#include "common/exception.h"
 #include "execution/executors/delete_executor.h"
+#include "execution/index_batch.h"
+#include "execution/plans/seq_scan_plan.h"
 
 namespace bustub {
 
 DeleteExecutor::DeleteExecutor(ExecutorContext *exec_ctx, const DeletePlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_executor_(std::move(child_executor)),
+      table_info_(exec_ctx->GetCatalog()->GetTable(plan->TableOid())) {
+  BUSTUB_ASSERT(!table_info_->IsPartitioned(), "The tuples of a partitioned table are deleted from its partitions.");
+}
 
-void DeleteExecutor::Init() {}
+void DeleteExecutor::Init() {
+  done_ = false;
+  // Of every tuple of the table, one exclusive table lock covers the row locks.
+  const bool whole_table = SeqScanPlanNode::IsFullScanOf(plan_->GetChildPlan(), plan_->TableOid());
+  exec_ctx_->LockTable(plan_->TableOid(), whole_table ? LockMode::EXCLUSIVE : LockMode::INTENTION_EXCLUSIVE);
+  child_executor_->Init();
+}
 
-bool DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) { return false; }
+bool DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
+  if (done_) {
+    return false;
+  }
+  done_ = true;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  IndexBatch index_batch(exec_ctx_, table_info_);
+  TupleBatch batch;
+  Tuple old_tuple;
+  while (child_executor_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      RID old_rid = batch.GetRID(i);
+      // The child may project the tuple, the keys and statistics are read from the tuple of the table.
+      if (!table_info_->table_->GetTuple(old_rid, &old_tuple, txn)) {
+        throw Exception("Delete from table " + table_info_->name_ + " failed.");
+      }
+      if (!table_info_->table_->MarkDelete(old_rid, txn)) {
+        throw Exception("Delete from table " + table_info_->name_ + " failed.");
+      }
+      index_batch.Delete(old_tuple, old_rid);
+      MaterializedView::RecordDeltas(txn, table_info_->views_, old_tuple, false);
+      table_info_->stats_.RemoveTuple(old_tuple);
+    }
+    index_batch.Flush();
+  }
+  return false;
+}
+
+void DeleteExecutor::Close() { child_executor_->Close(); }
 
 }  // namespace bustub
@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// exchange_executor.cpp
+//
+// Identification: src/execution/exchange_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/exchange_executor.h"
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "execution/executor_factory.h"
+#include "execution/executors/seq_scan_executor.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+ExchangeExecutor::ExchangeExecutor(ExecutorContext *exec_ctx, const ExchangePlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan), queue_(QUEUE_BATCHES_PER_WORKER * plan->GetNumWorkers()) {
+  for (size_t i = 0; i < plan_->GetNumWorkers(); i++) {
+    children_.push_back(ExecutorFactory::CreateExecutor(exec_ctx, plan_->GetChildPlan()));
+  }
+}
+
+ExchangeExecutor::~ExchangeExecutor() { Stop(); }
+
+void ExchangeExecutor::Init() { Start(nullptr); }
+
+void ExchangeExecutor::Close() {
+  Stop();
+  current_.Clear();
+  current_idx_ = 0;
+  for (auto &child : children_) {
+    child->Close();
+  }
+}
+
+void ExchangeExecutor::Drain(const BatchConsumer &consume) {
+  Start(&consume);
+  size_t attempt = 0;
+  while (running_ != 0) {
+    Backoff(&attempt);
+  }
+  serial_child_ = children_.size() - 1;
+  std::scoped_lock lock(error_latch_);
+  if (error_ != nullptr) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ExchangeExecutor::Start(const BatchConsumer *consume) {
+  Stop();
+  stopped_ = false;
+  error_ = nullptr;
+  current_.Clear();
+  current_idx_ = 0;
+  serial_child_ = 0;
+
+  // The workers share the transaction: the scans lock their tables here, so that the workers find the locks held.
+  std::vector<const AbstractPlanNode *> nodes{plan_->GetChildPlan()};
+  while (!nodes.empty()) {
+    const AbstractPlanNode *node = nodes.back();
+    nodes.pop_back();
+    if (node->GetType() == PlanType::SeqScan) {
+      SeqScanExecutor::LockTable(exec_ctx_, dynamic_cast<const SeqScanPlanNode *>(node)->GetTableOid());
+    }
+    nodes.insert(nodes.end(), node->GetChildren().begin(), node->GetChildren().end());
+  }
+
+  // Split the driving scan, at the end of the chain of first children.
+  const AbstractPlanNode *node = plan_->GetChildPlan();
+  while (!node->GetChildren().empty()) {
+    BUSTUB_ASSERT(node->GetType() != PlanType::Exchange, "Exchanges cannot be nested.");
+    node = node->GetChildAt(0);
+  }
+  if (node->GetType() == PlanType::SeqScan) {
+    const auto *scan_plan = dynamic_cast<const SeqScanPlanNode *>(node);
+    std::vector<TableHeap *> tables;
+    for (TableMetadata *table_info : SeqScanExecutor::ScanTables(exec_ctx_->GetCatalog(), scan_plan)) {
+      tables.push_back(table_info->table_.get());
+    }
+    morsel_sources_.push_back(std::make_unique<MorselSource>(std::move(tables), scan_plan->GetMorselSize()));
+    split_plans_.push_back(node);
+    exec_ctx_->SetMorselSource(node, morsel_sources_.back().get());
+  }
+
+  ThreadPool *thread_pool = exec_ctx_->GetThreadPool();
+  serial_ = thread_pool == nullptr;
+  if (serial_ && consume == nullptr) {
+    children_[0]->Init();
+    return;
+  }
+  running_ = children_.size();
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (serial_) {
+      Work(i, consume);
+    } else {
+      thread_pool->Submit([this, i, consume] { Work(i, consume); }, exec_ctx_->GetWorkloadClass());
+    }
+  }
+}
+
+void ExchangeExecutor::Work(size_t worker, const BatchConsumer *consume) {
+  try {
+    AbstractExecutor *child = children_[worker].get();
+    child->Init();
+    TupleBatch batch;
+    while (!stopped_ && child->NextBatch(&batch)) {
+      if (consume != nullptr) {
+        (*consume)(worker, batch);
+        continue;
+      }
+      size_t attempt = 0;
+      while (!stopped_ && !queue_.TryPush(&batch)) {
+        Backoff(&attempt);
+      }
+    }
+  } catch (...) {
+    std::scoped_lock lock(error_latch_);
+    if (error_ == nullptr) {
+      error_ = std::current_exception();
+    }
+    stopped_ = true;
+  }
+  running_.fetch_sub(1);
+}
+
+bool ExchangeExecutor::NextBatch(TupleBatch *batch) {
+  if (serial_) {
+    while (!children_[serial_child_]->NextBatch(batch)) {
+      if (++serial_child_ == children_.size()) {
+        serial_child_--;
+        return false;
+      }
+      children_[serial_child_]->Init();
+    }
+    return true;
+  }
+  const size_t capacity = batch->Capacity();
+  if (capacity < TUPLE_BATCH_SIZE) {
+    // The batches of the workers do not fit, they are handed out from current_ instead.
+    batch->Clear();
+    Tuple tuple;
+    RID rid;
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->Emplace(rid, tuple);
+    }
+    return !batch->IsEmpty();
+  }
+  size_t attempt = 0;
+  while (true) {
+    // A worker pushes its last batch before it counts itself out.
+    bool last = running_ == 0;
+    if (queue_.TryPop(batch)) {
+      batch->SetCapacity(capacity);
+      return true;
+    }
+    if (last) {
+      std::scoped_lock lock(error_latch_);
+      if (error_ != nullptr) {
+        std::rethrow_exception(error_);
+      }
+      batch->Clear();
+      return false;
+    }
+    Backoff(&attempt);
+  }
+}
+
+bool ExchangeExecutor::Next(Tuple *tuple, RID *rid) {
+  while (current_idx_ == current_.Size()) {
+    current_idx_ = 0;
+    if (!NextBatch(&current_)) {
+      return false;
+    }
+  }
+  *tuple = current_.GetTuple(current_idx_);
+  *rid = current_.GetRID(current_idx_);
+  current_idx_++;
+  return true;
+}
+
+void ExchangeExecutor::Stop() {
+  stopped_ = true;
+  size_t attempt = 0;
+  while (running_ != 0) {
+    Backoff(&attempt);
+  }
+  TupleBatch batch;
+  while (queue_.TryPop(&batch)) {
+  }
+  for (const AbstractPlanNode *node : split_plans_) {
+    exec_ctx_->SetMorselSource(node, nullptr);
+  }
+  split_plans_.clear();
+  morsel_sources_.clear();
+}
+
+void ExchangeExecutor::Backoff(size_t *attempt) {
+  // Spin through short waits, sleep through long ones such as a worker building a hash table.
+  if ((*attempt)++ < 64) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+}  // namespace bustub
@@ -12,24 +12,56 @@
 
 #include "execution/executor_factory.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/aggregation_executor.h"
 #include "execution/executors/delete_executor.h"
+#include "execution/executors/exchange_executor.h"
+#include "execution/executors/hash_join_executor.h"
 #include "execution/executors/index_scan_executor.h"
 #include "execution/executors/insert_executor.h"
 #include "execution/executors/limit_executor.h"
+#include "execution/executors/materialize_executor.h"
+#include "execution/executors/merge_join_executor.h"
+#include "execution/executors/metered_executor.h"
 #include "execution/executors/nested_index_join_executor.h"
 #include "execution/executors/nested_loop_join_executor.h"
+#include "execution/executors/profiled_executor.h"
+#include "execution/executors/scan_aggregate_executor.h"
 #include "execution/executors/seq_scan_executor.h"
+#include "execution/executors/sort_executor.h"
+#include "execution/executors/top_n_executor.h"
 #include "execution/executors/update_executor.h"
+#include "execution/executors/view_scan_executor.h"
 #include "storage/index/generic_key.h"
 
 namespace bustub {
 
 std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx,
                                                                   const AbstractPlanNode *plan) {
+  auto executor = CreatePlanExecutor(exec_ctx, plan);
+  // An exchange is left bare: the aggregation above it looks for it, to aggregate the children in parallel.
+  if (plan->GetType() == PlanType::Exchange) {
+    return executor;
+  }
+  return Instrument(exec_ctx, plan, std::move(executor));
+}
+
+std::unique_ptr<AbstractExecutor> ExecutorFactory::Instrument(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                                              std::unique_ptr<AbstractExecutor> &&executor) {
+  auto metered = std::make_unique<MeteredExecutor>(exec_ctx, plan->GetType(), std::move(executor));
+  QueryProfile *profile = exec_ctx->GetProfile();
+  if (profile == nullptr) {
+    return metered;
+  }
+  return std::make_unique<ProfiledExecutor>(exec_ctx, profile->GetOperatorProfile(plan), std::move(metered));
+}
+
+std::unique_ptr<AbstractExecutor> ExecutorFactory::CreatePlanExecutor(ExecutorContext *exec_ctx,
+                                                                      const AbstractPlanNode *plan) {
   switch (plan->GetType()) {
     // Create a new sequential scan executor.
     case PlanType::SeqScan: {
@@ -62,13 +94,27 @@ std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContex
 
     case PlanType::Limit: {
       auto limit_plan = dynamic_cast<const LimitPlanNode *>(plan);
-      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, limit_plan->GetChildPlan());
+      std::unique_ptr<AbstractExecutor> child_executor;
+      if (limit_plan->GetChildPlan()->GetType() == PlanType::Sort) {
+        // A sort under a limit only needs to keep the tuples up to the end of the limit.
+        auto sort_plan = dynamic_cast<const SortPlanNode *>(limit_plan->GetChildPlan());
+        size_t n = limit_plan->GetLimit() + std::min(limit_plan->GetOffset(), SIZE_MAX - limit_plan->GetLimit());
+        auto top_n = std::make_unique<TopNExecutor>(
+            exec_ctx, sort_plan, n, ExecutorFactory::CreateExecutor(exec_ctx, sort_plan->GetChildPlan()));
+        child_executor = Instrument(exec_ctx, sort_plan, std::move(top_n));
+      } else {
+        child_executor = ExecutorFactory::CreateExecutor(exec_ctx, limit_plan->GetChildPlan());
+      }
       return std::make_unique<LimitExecutor>(exec_ctx, limit_plan, std::move(child_executor));
     }
 
     // Create a new aggregation executor.
     case PlanType::Aggregation: {
       auto agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
+      // The scan under the aggregation is fused into it if the plan has the shape ScanAggregateExecutor supports.
+      if (auto fused = CreateScanAggregateExecutor(exec_ctx, agg_plan); fused != nullptr) {
+        return fused;
+      }
       auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, agg_plan->GetChildPlan());
       return std::make_unique<AggregationExecutor>(exec_ctx, agg_plan, std::move(child_executor));
     }
@@ -87,6 +133,43 @@ std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContex
       return std::make_unique<NestIndexJoinExecutor>(exec_ctx, nested_index_join_plan, std::move(left));
     }
 
+    case PlanType::HashJoin: {
+      auto hash_join_plan = dynamic_cast<const HashJoinPlanNode *>(plan);
+      auto left = ExecutorFactory::CreateExecutor(exec_ctx, hash_join_plan->GetLeftPlan());
+      auto right = ExecutorFactory::CreateExecutor(exec_ctx, hash_join_plan->GetRightPlan());
+      return std::make_unique<HashJoinExecutor>(exec_ctx, hash_join_plan, std::move(left), std::move(right));
+    }
+
+    case PlanType::MergeJoin: {
+      auto merge_join_plan = dynamic_cast<const MergeJoinPlanNode *>(plan);
+      auto left = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetLeftPlan());
+      auto right = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetRightPlan());
+      return std::make_unique<MergeJoinExecutor>(exec_ctx, merge_join_plan, std::move(left), std::move(right));
+    }
+
+    case PlanType::Materialize: {
+      auto materialize_plan = dynamic_cast<const MaterializePlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, materialize_plan->GetChildPlan());
+      return std::make_unique<MaterializeExecutor>(exec_ctx, materialize_plan, std::move(child_executor));
+    }
+
+    // Create a new exchange executor, which creates the instances of its child plan itself
+    case PlanType::Exchange: {
+      return std::make_unique<ExchangeExecutor>(exec_ctx, dynamic_cast<const ExchangePlanNode *>(plan));
+    }
+
+    // Create a new sort executor
+    case PlanType::Sort: {
+      auto sort_plan = dynamic_cast<const SortPlanNode *>(plan);
+      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, sort_plan->GetChildPlan());
+      return std::make_unique<SortExecutor>(exec_ctx, sort_plan, std::move(child_executor));
+    }
+
+    // Create a new view scan executor
+    case PlanType::ViewScan: {
+      return std::make_unique<ViewScanExecutor>(exec_ctx, dynamic_cast<const ViewScanPlanNode *>(plan));
+    }
+
     default: {
       BUSTUB_ASSERT(false, "Unsupported plan type.");
     }
@@ -0,0 +1,359 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// flat_aggregation_hash_table.cpp
+//
+// Identification: src/execution/flat_aggregation_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/flat_aggregation_hash_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "type/aggregation_kernels.h"
+#include "type/limits.h"
+#include "type/typed_kernels.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+bool FlatAggregationHashTable::Supports(const AggregationPlanNode *plan) {
+  for (const AbstractExpression *group_by : plan->GetGroupBys()) {
+    switch (group_by->GetReturnType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+      case TypeId::TIMESTAMP:
+        break;
+      default:
+        // Variable-length keys do not serialize in place, and equal decimals need not have equal bytes.
+        return false;
+    }
+  }
+  for (const AbstractExpression *aggregate : plan->GetAggregates()) {
+    if (aggregate->GetReturnType() != TypeId::INTEGER) {
+      return false;
+    }
+  }
+  // The distinct counters of a group do not fit in a row of fixed width.
+  return std::none_of(plan->GetAggregateTypes().begin(), plan->GetAggregateTypes().end(), IsDistinctAggregate);
+}
+
+FlatAggregationHashTable::FlatAggregationHashTable(const AggregationPlanNode *plan, const Schema *input_schema,
+                                                   size_t num_partitions)
+    : input_schema_(input_schema),
+      group_bys_(plan->GetGroupBys()),
+      aggregates_(plan->GetAggregates()),
+      agg_types_(plan->GetAggregateTypes()),
+      slots_(INITIAL_SLOTS, Slot{0, nullptr}),
+      partitions_(num_partitions) {
+  BUSTUB_ASSERT(num_partitions > 0, "A table needs at least one partition.");
+  for (const AbstractExpression *group_by : group_bys_) {
+    group_by_columns_.push_back(ColumnOffsetOf(group_by));
+    key_offsets_.push_back(key_size_);
+    key_size_ += Type::GetTypeSize(group_by->GetReturnType());
+  }
+  for (const AbstractExpression *aggregate : aggregates_) {
+    aggregate_columns_.push_back(ColumnOffsetOf(aggregate));
+  }
+  nulls_offset_ = STATES_OFFSET + agg_types_.size() * sizeof(int64_t);
+  key_offset_ = nulls_offset_ + agg_types_.size();
+  row_size_ = (key_offset_ + key_size_ + alignof(int64_t) - 1) / alignof(int64_t) * alignof(int64_t);
+  rows_per_chunk_ = std::max<size_t>(1, CHUNK_SIZE / row_size_);
+  scratch_key_.resize(key_size_);
+
+  initial_states_.resize(key_offset_ - STATES_OFFSET, 0);
+  auto *states = reinterpret_cast<int64_t *>(initial_states_.data());
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    switch (agg_types_[i]) {
+      case AggregationType::CountAggregate:
+      case AggregationType::SumAggregate:
+        states[i] = 0;
+        break;
+      case AggregationType::MinAggregate:
+        states[i] = BUSTUB_INT32_MAX;
+        break;
+      case AggregationType::MaxAggregate:
+        states[i] = BUSTUB_INT32_MIN;
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        UNREACHABLE("Distinct counts are not supported by the table.");
+    }
+  }
+}
+
+void FlatAggregationHashTable::AddChecked(int64_t *state, int64_t input) {
+  *state += input;
+  if (*state > BUSTUB_INT32_MAX || *state < BUSTUB_INT32_MIN) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+  }
+}
+
+uint32_t FlatAggregationHashTable::ColumnOffsetOf(const AbstractExpression *expr) const {
+  const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(expr);
+  if (column_expr == nullptr || column_expr->GetTupleIdx() != 0) {
+    return NOT_A_COLUMN;
+  }
+  const Column &column = input_schema_->GetColumn(column_expr->GetColIdx());
+  return column.IsInlined() && column.GetType() == expr->GetReturnType() ? column.GetOffset() : NOT_A_COLUMN;
+}
+
+hash_t FlatAggregationHashTable::SerializeKey(const Tuple &tuple) {
+  char *key = scratch_key_.data();
+  for (size_t i = 0; i < group_bys_.size(); i++) {
+    if (group_by_columns_[i] != NOT_A_COLUMN) {
+      // A fixed-width value serializes to the bytes it is stored as in the tuple.
+      const size_t size = (i + 1 < group_bys_.size() ? key_offsets_[i + 1] : key_size_) - key_offsets_[i];
+      memcpy(key + key_offsets_[i], tuple.GetData() + group_by_columns_[i], size);
+      continue;
+    }
+    group_bys_[i]->Evaluate(&tuple, input_schema_).SerializeTo(key + key_offsets_[i]);
+  }
+  return HashUtil::HashBytes(key, key_size_);
+}
+
+void FlatAggregationHashTable::Insert(const Tuple &tuple) {
+  hash_t hash = SerializeKey(tuple);
+  Fold(Find(hash, scratch_key_.data(), true), tuple);
+}
+
+void FlatAggregationHashTable::InsertBatch(const std::vector<Tuple> &tuples) {
+  if (!group_bys_.empty()) {
+    for (const Tuple &tuple : tuples) {
+      Insert(tuple);
+    }
+    return;
+  }
+  if (tuples.empty()) {
+    return;
+  }
+  char *row = Find(SerializeKey(tuples[0]), scratch_key_.data(), true);
+  auto *states = reinterpret_cast<int64_t *>(row + STATES_OFFSET);
+  char *nulls = row + nulls_offset_;
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    if (agg_types_[i] == AggregationType::CountAggregate) {
+      AddChecked(&states[i], static_cast<int64_t>(tuples.size()));
+      continue;
+    }
+    if (aggregate_columns_[i] != NOT_A_COLUMN) {
+      GatherColumn(tuples, aggregate_columns_[i], &scratch_column_);
+    } else {
+      scratch_column_.clear();
+      for (const Tuple &tuple : tuples) {
+        Value value = aggregates_[i]->Evaluate(&tuple, input_schema_);
+        scratch_column_.push_back(value.IsNull() ? NativeNull<int32_t>() : value.GetAs<int32_t>());
+      }
+    }
+    const ColumnAggregates<int32_t> aggregates = AggregateColumn(scratch_column_.data(), scratch_column_.size());
+    if (aggregates.count_ < tuples.size()) {
+      nulls[i] = 1;
+    }
+    if (aggregates.count_ == 0) {
+      continue;
+    }
+    switch (agg_types_[i]) {
+      case AggregationType::SumAggregate:
+        AddChecked(&states[i], aggregates.sum_);
+        break;
+      case AggregationType::MinAggregate:
+        states[i] = std::min<int64_t>(states[i], aggregates.min_);
+        break;
+      case AggregationType::MaxAggregate:
+        states[i] = std::max<int64_t>(states[i], aggregates.max_);
+        break;
+      case AggregationType::CountAggregate:
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        break;
+    }
+  }
+}
+
+bool FlatAggregationHashTable::InsertIfPresent(const Tuple &tuple) {
+  hash_t hash = SerializeKey(tuple);
+  char *row = Find(hash, scratch_key_.data(), false);
+  if (row == nullptr) {
+    return false;
+  }
+  Fold(row, tuple);
+  return true;
+}
+
+size_t FlatAggregationHashTable::MemoryUsage() const {
+  return slots_.size() * sizeof(Slot) + num_chunks_ * rows_per_chunk_ * row_size_;
+}
+
+void FlatAggregationHashTable::Fold(char *row, const Tuple &tuple) {
+  auto *states = reinterpret_cast<int64_t *>(row + STATES_OFFSET);
+  char *nulls = row + nulls_offset_;
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    if (agg_types_[i] == AggregationType::CountAggregate) {
+      // Count increases by one, whatever the input.
+      AddChecked(&states[i], 1);
+      continue;
+    }
+    int32_t input;
+    if (aggregate_columns_[i] != NOT_A_COLUMN) {
+      input = LoadNative<int32_t>(tuple.GetData(), aggregate_columns_[i]);
+    } else {
+      Value value = aggregates_[i]->Evaluate(&tuple, input_schema_);
+      input = value.IsNull() ? NativeNull<int32_t>() : value.GetAs<int32_t>();
+    }
+    if (input == NativeNull<int32_t>()) {
+      nulls[i] = 1;
+      continue;
+    }
+    auto value = static_cast<int64_t>(input);
+    switch (agg_types_[i]) {
+      case AggregationType::SumAggregate:
+        AddChecked(&states[i], value);
+        break;
+      case AggregationType::MinAggregate:
+        states[i] = std::min(states[i], value);
+        break;
+      case AggregationType::MaxAggregate:
+        states[i] = std::max(states[i], value);
+        break;
+      case AggregationType::CountAggregate:
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        break;
+    }
+  }
+}
+
+void FlatAggregationHashTable::MergePartition(const FlatAggregationHashTable &other, size_t partition) {
+  for (size_t r = 0; r < other.partitions_[partition].num_rows_; r++) {
+    const char *other_row = other.RowAt(partition, r);
+    char *row = Find(*reinterpret_cast<const hash_t *>(other_row), other_row + key_offset_, true);
+    auto *states = reinterpret_cast<int64_t *>(row + STATES_OFFSET);
+    const auto *other_states = reinterpret_cast<const int64_t *>(other_row + STATES_OFFSET);
+    char *nulls = row + nulls_offset_;
+    for (size_t i = 0; i < agg_types_.size(); i++) {
+      nulls[i] |= other_row[nulls_offset_ + i];
+      switch (agg_types_[i]) {
+        case AggregationType::CountAggregate:
+        case AggregationType::SumAggregate:
+          AddChecked(&states[i], other_states[i]);
+          break;
+        case AggregationType::MinAggregate:
+          states[i] = std::min(states[i], other_states[i]);
+          break;
+        case AggregationType::MaxAggregate:
+          states[i] = std::max(states[i], other_states[i]);
+          break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          break;
+      }
+    }
+  }
+}
+
+char *FlatAggregationHashTable::Find(hash_t hash, const char *key, bool insert) {
+  if (insert && (num_groups_ + 1) * 2 > slots_.size()) {
+    Grow();
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    Slot &slot = slots_[i];
+    if (slot.row_ == nullptr) {
+      if (!insert) {
+        return nullptr;
+      }
+      slot = Slot{hash, NewRow(hash, key)};
+      num_groups_++;
+      return slot.row_;
+    }
+    if (slot.hash_ == hash && memcmp(slot.row_ + key_offset_, key, key_size_) == 0) {
+      return slot.row_;
+    }
+  }
+}
+
+char *FlatAggregationHashTable::NewRow(hash_t hash, const char *key) {
+  Partition &partition = partitions_[(hash >> 32) % partitions_.size()];
+  if (partition.num_rows_ == partition.chunks_.size() * rows_per_chunk_) {
+    partition.chunks_.emplace_back(rows_per_chunk_ * row_size_);
+    num_chunks_++;
+  }
+  size_t row_idx = partition.num_rows_++;
+  char *row = partition.chunks_[row_idx / rows_per_chunk_].data() + (row_idx % rows_per_chunk_) * row_size_;
+  memcpy(row, &hash, sizeof(hash));
+  memcpy(row + STATES_OFFSET, initial_states_.data(), initial_states_.size());
+  memcpy(row + key_offset_, key, key_size_);
+  return row;
+}
+
+void FlatAggregationHashTable::Grow() {
+  decltype(slots_) slots(slots_.size() * 2, Slot{0, nullptr});
+  const size_t mask = slots.size() - 1;
+  for (const Slot &slot : slots_) {
+    if (slot.row_ == nullptr) {
+      continue;
+    }
+    size_t i = slot.hash_ & mask;
+    while (slots[i].row_ != nullptr) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+  }
+  slots_ = std::move(slots);
+}
+
+void FlatAggregationHashTable::Clear() {
+  slots_.assign(INITIAL_SLOTS, Slot{0, nullptr});
+  num_groups_ = 0;
+  num_chunks_ = 0;
+  for (Partition &partition : partitions_) {
+    partition.chunks_.clear();
+    partition.num_rows_ = 0;
+  }
+}
+
+FlatAggregationHashTable::Iterator::Iterator(const FlatAggregationHashTable *table, size_t partition, size_t row)
+    : table_(table), partition_(partition), row_(row) {
+  Settle();
+}
+
+FlatAggregationHashTable::Iterator &FlatAggregationHashTable::Iterator::operator++() {
+  row_++;
+  Settle();
+  return *this;
+}
+
+void FlatAggregationHashTable::Iterator::Settle() {
+  while (partition_ < table_->partitions_.size() && row_ == table_->partitions_[partition_].num_rows_) {
+    partition_++;
+    row_ = 0;
+  }
+  if (partition_ == table_->partitions_.size()) {
+    return;
+  }
+  const char *row = table_->RowAt(partition_, row_);
+  const char *key = row + table_->key_offset_;
+  key_.group_bys_.clear();
+  for (size_t i = 0; i < table_->group_bys_.size(); i++) {
+    TypeId type = table_->group_bys_[i]->GetReturnType();
+    key_.group_bys_.push_back(Value::DeserializeFrom(key + table_->key_offsets_[i], type));
+  }
+  const auto *states = reinterpret_cast<const int64_t *>(row + STATES_OFFSET);
+  val_.aggregates_.clear();
+  for (size_t i = 0; i < table_->agg_types_.size(); i++) {
+    val_.aggregates_.push_back(row[table_->nulls_offset_ + i] != 0
+                                   ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                   : ValueFactory::GetIntegerValue(static_cast<int32_t>(states[i])));
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,385 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_join_executor.cpp
+//
+// Identification: src/execution/hash_join_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/hash_join_executor.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
+                                   std::unique_ptr<AbstractExecutor> &&left_executor,
+                                   std::unique_ptr<AbstractExecutor> &&right_executor)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)),
+      // Each partition buffers a block of the temporary space while a side is being spilled.
+      num_partitions_(std::clamp<size_t>(MemoryBudget() / TEMP_SPACE_BLOCK_SIZE, 2, HASH_JOIN_MAX_PARTITIONS)),
+      // A residual predicate may read any column of the left tuples, so they are held whole.
+      key_only_(plan->GetJoinType() != JoinType::Inner && plan->Predicate() == nullptr),
+      build_schema_(left_executor_->GetOutputSchema()),
+      build_keys_(plan->GetLeftKeys()),
+      probe_partition_(exec_ctx->GetTempSpace(), "a hash join") {
+  if (key_only_) {
+    std::vector<Column> columns;
+    build_keys_.clear();
+    for (uint32_t i = 0; i < plan->GetLeftKeys().size(); i++) {
+      const TypeId type = plan->GetLeftKeys()[i]->GetReturnType();
+      std::string name = "key" + std::to_string(i);
+      columns.push_back(type == TypeId::VARCHAR ? Column(name, type, uint32_t{0}) : Column(name, type));
+      key_columns_.push_back(std::make_unique<ColumnValueExpression>(0, i, type));
+      build_keys_.push_back(key_columns_.back().get());
+    }
+    key_schema_ = std::make_unique<Schema>(columns);
+    build_schema_ = key_schema_.get();
+  }
+}
+
+HashJoinExecutor::~HashJoinExecutor() { Reset(); }
+
+size_t HashJoinExecutor::MemoryBudget() const {
+  return exec_ctx_->IsAdmitted() ? std::min(plan_->GetMemoryBudget(), exec_ctx_->GetMemoryBudget())
+                                 : plan_->GetMemoryBudget();
+}
+
+void HashJoinExecutor::Init() {
+  Reset();
+  left_executor_->Init();
+  right_executor_->Init();
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+
+  // Build the hash table on the left side for as long as it fits in the budget.
+  std::vector<TmpTupleRun> left_partitions;
+  std::vector<hash_t> build_hashes;
+  size_t bytes = 0;
+  Tuple tuple;
+  RID rid;
+  while (left_executor_->Next(&tuple, &rid)) {
+    hash_t hash;
+    if (!HashKeys(tuple, left_schema, plan_->GetLeftKeys(), 0, &hash)) {
+      continue;
+    }
+    build_hashes.push_back(hash);
+    Tuple build_tuple = BuildTuple(std::move(tuple));
+    if (spilled_) {
+      left_partitions[hash % num_partitions_].Append(build_tuple);
+      continue;
+    }
+    bytes += build_tuple.GetLength();
+    hash_table_.Insert(hash, std::move(build_tuple));
+    if (bytes > MemoryBudget()) {
+      // Out of memory: move the hash table to the partitions, the hash of each tuple is already known.
+      spilled_ = true;
+      left_partitions = NewPartitions(num_partitions_);
+      for (const auto &entry : hash_table_.GetEntries()) {
+        left_partitions[entry.hash_ % num_partitions_].Append(entry.tuple_);
+      }
+      hash_table_.Clear();
+    }
+  }
+  hash_table_.Build();
+
+  // The filter is sized once the number of build keys is known, and complete before the probe side produces a tuple.
+  bloom_filter_.Reset(build_hashes.size());
+  for (hash_t hash : build_hashes) {
+    bloom_filter_.Insert(hash);
+  }
+  filter_pushed_down_ =
+      plan_->GetJoinType() != JoinType::Anti && right_executor_->PushDownFilter(&bloom_filter_, plan_->GetRightKeys());
+
+  if (spilled_) {
+    for (TmpTupleRun &partition : left_partitions) {
+      partition.Seal();
+    }
+    SpillRight(&left_partitions);
+  }
+}
+
+void HashJoinExecutor::Close() {
+  Reset();
+  left_executor_->Close();
+  right_executor_->Close();
+}
+
+bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const JoinType join_type = plan_->GetJoinType();
+  while (true) {
+    if (join_type == JoinType::Inner) {
+      for (; match_ != JoinHashTable::END; match_ = hash_table_.FindNext(match_)) {
+        const Tuple &left = hash_table_.GetTuple(match_);
+        if (!Matches(left, *probe_tuple_)) {
+          continue;
+        }
+        std::vector<Value> values;
+        values.reserve(GetOutputSchema()->GetColumnCount());
+        for (const Column &column : GetOutputSchema()->GetColumns()) {
+          values.emplace_back(column.GetExpr()->EvaluateJoin(&left, left_schema, probe_tuple_, right_schema));
+        }
+        *tuple = Tuple(std::move(values), GetOutputSchema());
+        match_ = hash_table_.FindNext(match_);
+        return true;
+      }
+    } else if (probe_tuple_ != nullptr) {
+      // A semi or anti join is done with the probe tuple at its first match.
+      while (match_ != JoinHashTable::END && !Matches(hash_table_.GetTuple(match_), *probe_tuple_)) {
+        match_ = hash_table_.FindNext(match_);
+      }
+      const Tuple *probe = probe_tuple_;
+      const bool matched = match_ != JoinHashTable::END;
+      probe_tuple_ = nullptr;
+      match_ = JoinHashTable::END;
+      if (matched == (join_type == JoinType::Semi)) {
+        *tuple = ProbeOutput(*probe);
+        return true;
+      }
+    }
+
+    if (unmatched_next_ < probe_unmatched_.size()) {
+      *tuple = ProbeOutput((*probe_tuples_)[probe_unmatched_[unmatched_next_++]]);
+      return true;
+    }
+    if (probe_next_ == probe_indices_.size()) {
+      if (!NextProbeBatch() && (!spilled_ || !BuildNextPartition())) {
+        return false;
+      }
+      continue;
+    }
+    if (probe_next_ % PROBE_GROUP_SIZE == 0) {
+      hash_table_.Prefetch(&probe_hashes_[probe_next_], std::min(PROBE_GROUP_SIZE, probe_hashes_.size() - probe_next_));
+    }
+    probe_tuple_ = &(*probe_tuples_)[probe_indices_[probe_next_]];
+    match_ = hash_table_.Find(probe_hashes_[probe_next_]);
+    probe_next_++;
+  }
+}
+
+bool HashJoinExecutor::HashKeys(const Tuple &tuple, const Schema *schema,
+                                const std::vector<const AbstractExpression *> &keys, uint32_t depth,
+                                hash_t *hash) {
+  hash_t result = depth;
+  for (const AbstractExpression *key : keys) {
+    Value value = key->Evaluate(&tuple, schema);
+    if (value.IsNull()) {
+      return false;
+    }
+    result = HashUtil::CombineHashes(result, HashUtil::HashValue(&value));
+  }
+  *hash = result;
+  return true;
+}
+
+bool HashJoinExecutor::KeysEqual(const Tuple &left, const Tuple &right) {
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const auto &right_keys = plan_->GetRightKeys();
+  for (size_t i = 0; i < build_keys_.size(); i++) {
+    Value left_value = build_keys_[i]->Evaluate(&left, build_schema_);
+    Value right_value = right_keys[i]->Evaluate(&right, right_schema);
+    if (left_value.CompareEquals(right_value) != CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HashJoinExecutor::Matches(const Tuple &left, const Tuple &right) {
+  if (!KeysEqual(left, right)) {
+    return false;
+  }
+  const AbstractExpression *predicate = plan_->Predicate();
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  return predicate == nullptr || predicate->EvaluateJoin(&left, left_schema, &right, right_schema).GetAs<bool>();
+}
+
+Tuple HashJoinExecutor::BuildTuple(Tuple &&tuple) {
+  if (!key_only_) {
+    return std::move(tuple);
+  }
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  std::vector<Value> keys;
+  keys.reserve(plan_->GetLeftKeys().size());
+  for (const AbstractExpression *key : plan_->GetLeftKeys()) {
+    keys.push_back(key->Evaluate(&tuple, left_schema));
+  }
+  return Tuple(std::move(keys), key_schema_.get());
+}
+
+Tuple HashJoinExecutor::ProbeOutput(const Tuple &probe) {
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    values.emplace_back(column.GetExpr()->Evaluate(&probe, right_schema));
+  }
+  return Tuple(std::move(values), GetOutputSchema());
+}
+
+std::vector<TmpTupleRun> HashJoinExecutor::NewPartitions(size_t num_partitions) {
+  std::vector<TmpTupleRun> partitions;
+  partitions.reserve(num_partitions);
+  for (size_t i = 0; i < num_partitions; i++) {
+    partitions.emplace_back(exec_ctx_->GetTempSpace(), "a hash join");
+  }
+  return partitions;
+}
+
+void HashJoinExecutor::Reset() {
+  pending_.clear();
+  probe_partition_.Drop();
+  probe_buffer_.clear();
+  probe_batch_.Clear();
+  probe_tuples_ = nullptr;
+  probe_indices_.clear();
+  probe_hashes_.clear();
+  probe_next_ = 0;
+  probe_unmatched_.clear();
+  unmatched_next_ = 0;
+  probe_tuple_ = nullptr;
+  hash_table_.Clear();
+  match_ = JoinHashTable::END;
+  depth_ = 0;
+  filter_pushed_down_ = false;
+  spilled_ = false;
+}
+
+void HashJoinExecutor::SpillRight(std::vector<TmpTupleRun> *left_partitions) {
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  // The last partition holds the probe tuples an anti join knows to have no match, paired with no left tuple.
+  std::vector<TmpTupleRun> right_partitions = NewPartitions(num_partitions_ + 1);
+  Tuple tuple;
+  RID rid;
+  while (right_executor_->Next(&tuple, &rid)) {
+    hash_t hash;
+    if (HashKeys(tuple, right_schema, plan_->GetRightKeys(), 0, &hash) &&
+        (filter_pushed_down_ || bloom_filter_.MayContain(hash))) {
+      right_partitions[hash % num_partitions_].Append(tuple);
+    } else if (plan_->GetJoinType() == JoinType::Anti) {
+      right_partitions.back().Append(tuple);
+    }
+  }
+  for (TmpTupleRun &partition : right_partitions) {
+    partition.Seal();
+  }
+  for (size_t i = 0; i < num_partitions_; i++) {
+    pending_.push_back(PartitionPair{std::move((*left_partitions)[i]), std::move(right_partitions[i]), 1});
+  }
+  if (!right_partitions.back().IsEmpty()) {
+    pending_.push_back(PartitionPair{TmpTupleRun(exec_ctx_->GetTempSpace(), "a hash join"),
+                                     std::move(right_partitions.back()), 1});
+  }
+}
+
+void HashJoinExecutor::Repartition(PartitionPair *pair) {
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  std::vector<TmpTupleRun> left_partitions = NewPartitions(num_partitions_);
+  std::vector<TmpTupleRun> right_partitions = NewPartitions(num_partitions_);
+  std::vector<Tuple> tuples;
+  hash_t hash;
+  while (pair->left_.ReadBlock(&tuples)) {
+    for (const Tuple &tuple : tuples) {
+      HashKeys(tuple, build_schema_, build_keys_, pair->depth_, &hash);
+      left_partitions[hash % num_partitions_].Append(tuple);
+    }
+  }
+  while (pair->right_.ReadBlock(&tuples)) {
+    for (const Tuple &tuple : tuples) {
+      HashKeys(tuple, right_schema, plan_->GetRightKeys(), pair->depth_, &hash);
+      right_partitions[hash % num_partitions_].Append(tuple);
+    }
+  }
+  for (size_t i = 0; i < num_partitions_; i++) {
+    left_partitions[i].Seal();
+    right_partitions[i].Seal();
+  }
+  for (size_t i = 0; i < num_partitions_; i++) {
+    pending_.push_back(
+        PartitionPair{std::move(left_partitions[i]), std::move(right_partitions[i]), pair->depth_ + 1});
+  }
+}
+
+bool HashJoinExecutor::BuildNextPartition() {
+  while (!pending_.empty()) {
+    PartitionPair pair = std::move(pending_.back());
+    pending_.pop_back();
+    if (pair.right_.IsEmpty() || (pair.left_.IsEmpty() && plan_->GetJoinType() != JoinType::Anti)) {
+      // One side is empty, so nothing in the pair joins; an anti join still produces a right side without a left.
+      continue;
+    }
+    if (pair.left_.GetBytes() > MemoryBudget() && pair.depth_ < MAX_DEPTH) {
+      Repartition(&pair);
+      continue;
+    }
+
+    hash_table_.Clear();
+    depth_ = pair.depth_;
+    std::vector<Tuple> tuples;
+    hash_t hash;
+    while (pair.left_.ReadBlock(&tuples)) {
+      for (Tuple &tuple : tuples) {
+        HashKeys(tuple, build_schema_, build_keys_, depth_, &hash);
+        hash_table_.Insert(hash, std::move(tuple));
+      }
+    }
+    hash_table_.Build();
+    match_ = JoinHashTable::END;
+
+    probe_partition_ = std::move(pair.right_);
+    probe_indices_.clear();
+    probe_hashes_.clear();
+    probe_next_ = 0;
+    return true;
+  }
+  return false;
+}
+
+bool HashJoinExecutor::NextProbeBatch() {
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  do {
+    if (!spilled_) {
+      if (!right_executor_->NextBatch(&probe_batch_)) {
+        return false;
+      }
+      probe_tuples_ = &probe_batch_.GetTuples();
+    } else {
+      if (!probe_partition_.ReadBlock(&probe_buffer_)) {
+        return false;
+      }
+      probe_tuples_ = &probe_buffer_;
+    }
+    probe_indices_.clear();
+    probe_hashes_.clear();
+    probe_unmatched_.clear();
+    unmatched_next_ = 0;
+    for (uint32_t i = 0; i < probe_tuples_->size(); i++) {
+      hash_t hash;
+      // The probe tuples of spilled partitions went through the filter before they were spilled.
+      if (HashKeys((*probe_tuples_)[i], right_schema, plan_->GetRightKeys(), depth_, &hash) &&
+          (spilled_ || filter_pushed_down_ || bloom_filter_.MayContain(hash))) {
+        probe_indices_.push_back(i);
+        probe_hashes_.push_back(hash);
+      } else if (plan_->GetJoinType() == JoinType::Anti) {
+        probe_unmatched_.push_back(i);
+      }
+    }
+  } while (probe_indices_.empty() && probe_unmatched_.empty());
+  probe_next_ = 0;
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_batch.cpp
+//
+// Identification: src/execution/index_batch.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/index_batch.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+IndexBatch::IndexBatch(ExecutorContext *exec_ctx, TableMetadata *table_info)
+    : exec_ctx_(exec_ctx), table_info_(table_info) {
+  for (IndexInfo *index_info : exec_ctx->GetCatalog()->GetTableIndexes(table_info->name_)) {
+    indexes_.push_back(IndexChanges{index_info, {}, {}, {}, {}, {}});
+  }
+}
+
+IndexBatch::IndexBatch(ExecutorContext *exec_ctx, TableMetadata *table_info,
+                       const std::vector<uint32_t> &updated_columns)
+    : IndexBatch(exec_ctx, table_info) {
+  auto unchanged = [&](const IndexChanges &changes) {
+    const std::vector<uint32_t> &key_attrs = changes.index_info_->index_->GetKeyAttrs();
+    return std::none_of(key_attrs.begin(), key_attrs.end(), [&](uint32_t attr) {
+      return std::find(updated_columns.begin(), updated_columns.end(), attr) != updated_columns.end();
+    });
+  };
+  indexes_.erase(std::remove_if(indexes_.begin(), indexes_.end(), unchanged), indexes_.end());
+}
+
+Tuple IndexBatch::KeyOf(const Tuple &tuple, const IndexInfo *index_info) const {
+  Index *index = index_info->index_.get();
+  return tuple.KeyFromTuple(table_info_->schema_, *index->GetKeySchema(), index->GetKeyAttrs());
+}
+
+void IndexBatch::Insert(const Tuple &tuple, RID rid) {
+  for (IndexChanges &changes : indexes_) {
+    changes.inserted_keys_.push_back(KeyOf(tuple, changes.index_info_));
+    changes.inserted_rids_.push_back(rid);
+    changes.records_.emplace_back(rid, table_info_->oid_, WType::INSERT, tuple, changes.index_info_->index_oid_,
+                                  exec_ctx_->GetCatalog());
+  }
+}
+
+void IndexBatch::Delete(const Tuple &tuple, RID rid) {
+  for (IndexChanges &changes : indexes_) {
+    changes.deleted_keys_.push_back(KeyOf(tuple, changes.index_info_));
+    changes.deleted_rids_.push_back(rid);
+    changes.records_.emplace_back(rid, table_info_->oid_, WType::DELETE, tuple, changes.index_info_->index_oid_,
+                                  exec_ctx_->GetCatalog());
+  }
+}
+
+void IndexBatch::Update(const Tuple &old_tuple, const Tuple &new_tuple, RID rid) {
+  for (IndexChanges &changes : indexes_) {
+    Tuple old_key = KeyOf(old_tuple, changes.index_info_);
+    Tuple new_key = KeyOf(new_tuple, changes.index_info_);
+    if (old_key.GetLength() == new_key.GetLength() &&
+        memcmp(old_key.GetData(), new_key.GetData(), old_key.GetLength()) == 0) {
+      // The entry of the tuple stays as it is.
+      continue;
+    }
+    changes.deleted_keys_.push_back(std::move(old_key));
+    changes.deleted_rids_.push_back(rid);
+    changes.inserted_keys_.push_back(std::move(new_key));
+    changes.inserted_rids_.push_back(rid);
+    changes.records_.emplace_back(rid, table_info_->oid_, WType::UPDATE, new_tuple, changes.index_info_->index_oid_,
+                                  exec_ctx_->GetCatalog());
+    changes.records_.back().old_tuple_ = old_tuple;
+  }
+}
+
+void IndexBatch::LockInsertGaps(const IndexChanges &changes, std::vector<RID> *next_rids) {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  Index *index = changes.index_info_->index_.get();
+  const bool inserted = !next_rids->empty();
+  next_rids->resize(changes.inserted_keys_.size());
+  for (size_t i = 0; i < changes.inserted_keys_.size(); i++) {
+    RID next_rid;
+    if (!index->GetNextKey(changes.inserted_keys_[i], &next_rid, txn)) {
+      return;
+    }
+    // Once the key is in, an entry inserted past it by another transaction meanwhile bounds its gap instead, which a
+    // scan may have locked without seeing the key.
+    if (inserted && next_rid == (*next_rids)[i]) {
+      continue;
+    }
+    exec_ctx_->LockKeyRange(KeyRange{changes.index_info_->index_oid_, next_rid}, LockMode::INSERT_INTENTION);
+    (*next_rids)[i] = next_rid;
+  }
+}
+
+void IndexBatch::Flush() {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  const bool locks_key_ranges = exec_ctx_->LocksKeyRanges(table_info_->oid_, true);
+  std::vector<RID> next_rids;
+  for (IndexChanges &changes : indexes_) {
+    Index *index = changes.index_info_->index_.get();
+    if (!changes.deleted_keys_.empty()) {
+      if (locks_key_ranges) {
+        for (const RID &rid : changes.deleted_rids_) {
+          exec_ctx_->LockKeyRange(KeyRange{changes.index_info_->index_oid_, rid}, LockMode::EXCLUSIVE);
+        }
+      }
+      index->DeleteEntries(changes.deleted_keys_, changes.deleted_rids_, txn);
+    }
+    if (!changes.inserted_keys_.empty()) {
+      next_rids.clear();
+      if (locks_key_ranges) {
+        LockInsertGaps(changes, &next_rids);
+      }
+      index->InsertEntries(changes.inserted_keys_, changes.inserted_rids_, txn);
+      if (locks_key_ranges) {
+        LockInsertGaps(changes, &next_rids);
+      }
+    }
+    for (IndexWriteRecord &record : changes.records_) {
+      txn->GetIndexWriteSet()->push_back(std::move(record));
+    }
+    changes.deleted_keys_.clear();
+    changes.deleted_rids_.clear();
+    changes.inserted_keys_.clear();
+    changes.inserted_rids_.clear();
+    changes.records_.clear();
+  }
+}
+
+}  // namespace bustub
@@ -6,17 +6,332 @@
 //
 // Identification: src/execution/index_scan_executor.cpp
 //
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/generic_key.h"
+#include "storage/table/toast.h"
+#include "storage/table/tuple_ref.h"
+#include "type/type.h"
+#include "type/value_factory.h"
+
 namespace bustub {
+
+class IndexScanExecutor::Cursor {
+ public:
+  virtual ~Cursor() = default;
+
+  /**
+   * Moves to the next entry of the index.
+   * @param[out] rid the record id of the entry
+   * @param[out] key if not nullptr, the values of the columns of its key, INCLUDE columns too
+   * @return false at the end of the index
+   */
+  virtual bool Next(RID *rid, std::vector<Value> *key) = 0;
+
+  /**
+   * @param lo if not nullptr, the key to start at instead of the first key of the index
+   * @param hi if not nullptr, the key to stop past, given lo
+   * @return a cursor at the first key of the index, nullptr if it is not a B+ tree index of generic keys
+   */
+  static std::unique_ptr<Cursor> Begin(Index *index, const Tuple *lo, const Tuple *hi) {
+    std::unique_ptr<Cursor> cursor;
+    if ((cursor = BeginIfKeySize<4>(index, lo, hi)) != nullptr ||
+        (cursor = BeginIfKeySize<8>(index, lo, hi)) != nullptr ||
+        (cursor = BeginIfKeySize<16>(index, lo, hi)) != nullptr ||
+        (cursor = BeginIfKeySize<32>(index, lo, hi)) != nullptr) {
+      return cursor;
+    }
+    return BeginIfKeySize<64>(index, lo, hi);
+  }
+
+ private:
+  template <size_t KeySize>
+  static std::unique_ptr<Cursor> BeginIfKeySize(Index *index, const Tuple *lo, const Tuple *hi);
+};
+
+template <size_t KeySize>
+class IndexScanExecutor::BPlusTreeCursor : public IndexScanExecutor::Cursor {
+ public:
+  using TreeIndex = BPlusTreeIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+
+  BPlusTreeCursor(TreeIndex *index, const Tuple *lo, const Tuple *hi)
+      : key_schema_(index->GetKeySchema()), iter_(Start(index, lo, hi)) {}
+
+  bool Next(RID *rid, std::vector<Value> *key) override {
+    if (iter_.isEnd()) {
+      return false;
+    }
+    const auto &entry = *iter_;
+    *rid = entry.second;
+    if (key != nullptr) {
+      key->clear();
+      for (uint32_t i = 0; i < key_schema_->GetColumnCount(); i++) {
+        key->emplace_back(entry.first.ToValue(key_schema_, i));
+      }
+    }
+    ++iter_;
+    return true;
+  }
+
+ private:
+  static IndexIterator<GenericKey<KeySize>, RID, GenericComparator<KeySize>> Start(TreeIndex *index, const Tuple *lo,
+                                                                                   const Tuple *hi) {
+    if (lo == nullptr) {
+      return index->GetBeginIterator();
+    }
+    GenericKey<KeySize> lo_key;
+    lo_key.SetFromKey(*lo);
+    if (hi == nullptr) {
+      return index->GetBeginIterator(lo_key);
+    }
+    GenericKey<KeySize> hi_key;
+    hi_key.SetFromKey(*hi);
+    return index->GetBeginIterator(lo_key, hi_key);
+  }
+
+  Schema *key_schema_;
+  IndexIterator<GenericKey<KeySize>, RID, GenericComparator<KeySize>> iter_;
+};
+
+template <size_t KeySize>
+std::unique_ptr<IndexScanExecutor::Cursor> IndexScanExecutor::Cursor::BeginIfKeySize(Index *index, const Tuple *lo,
+                                                                                      const Tuple *hi) {
+  auto *tree_index = dynamic_cast<typename BPlusTreeCursor<KeySize>::TreeIndex *>(index);
+  return tree_index == nullptr ? nullptr : std::make_unique<BPlusTreeCursor<KeySize>>(tree_index, lo, hi);
+}
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      index_info_(exec_ctx->GetCatalog()->GetIndex(plan->GetIndexOid())),
+      table_info_(exec_ctx->GetCatalog()->GetTable(index_info_->table_name_)) {
+  std::vector<uint32_t> col_idxs;
+  if (plan->GetPredicate() != nullptr) {
+    ColumnValueExpression::CollectColumns(plan->GetPredicate(), &col_idxs);
+  }
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    ColumnValueExpression::CollectColumns(column.GetExpr(), &col_idxs);
+  }
+  std::copy_if(col_idxs.begin(), col_idxs.end(), std::back_inserter(toast_columns_),
+               [this](uint32_t col_idx) { return !table_info_->schema_.GetColumn(col_idx).IsInlined(); });
+
+  index_only_ = IsCovered(plan, *index_info_->index_, table_info_->schema_);
+  if (index_only_) {
+    for (const Column &column : table_info_->schema_.GetColumns()) {
+      row_.emplace_back(ValueFactory::GetNullValueByType(column.GetType()));
+    }
+  }
+
+  // The scan starts at the least key with the lower bound, and stops past the keys with the upper bound, whatever the
+  // other key columns, which compare equal to the NULLs of the upper key.
+  if (plan->GetLowerBound().has_value() || plan->GetUpperBound().has_value()) {
+    Schema *search_key_schema = index_info_->index_->GetMetadata()->GetSearchKeySchema();
+    std::vector<Value> lower;
+    std::vector<Value> upper;
+    for (uint32_t i = 0; i < search_key_schema->GetColumnCount(); i++) {
+      const TypeId type = search_key_schema->GetColumn(i).GetType();
+      lower.push_back(i == 0 && plan->GetLowerBound().has_value() ? plan->GetLowerBound()->CastAs(type)
+                                                                  : Type::GetMinValue(type));
+      upper.push_back(i == 0 && plan->GetUpperBound().has_value() ? plan->GetUpperBound()->CastAs(type)
+                                                                  : ValueFactory::GetNullValueByType(type));
+    }
+    lower_key_ = Tuple(lower, search_key_schema);
+    upper_key_ = Tuple(upper, search_key_schema);
+  }
+}
+
+IndexScanExecutor::~IndexScanExecutor() = default;
+
+bool IndexScanExecutor::IsCovered(const IndexScanPlanNode *plan, const Index &index, const Schema &table_schema) {
+  std::vector<uint32_t> col_idxs;
+  if (plan->GetPredicate() != nullptr) {
+    ColumnValueExpression::CollectColumns(plan->GetPredicate(), &col_idxs);
+  }
+  for (const Column &column : plan->OutputSchema()->GetColumns()) {
+    ColumnValueExpression::CollectColumns(column.GetExpr(), &col_idxs);
+  }
+  // A varlen column may be stored out of line in the tuple its key was made of, so reading one takes the tuple.
+  const std::vector<uint32_t> &key_attrs = index.GetKeyAttrs();
+  return std::all_of(col_idxs.begin(), col_idxs.end(), [&](uint32_t col_idx) {
+    return table_schema.GetColumn(col_idx).IsInlined() &&
+           std::find(key_attrs.begin(), key_attrs.end(), col_idx) != key_attrs.end();
+  });
+}
+
+void IndexScanExecutor::Init() {
+  // The rows the index points to are locked one at a time, under an intention lock on the table.
+  if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
+    exec_ctx_->LockTable(table_info_->oid_, LockMode::INTENTION_SHARED);
+  }
+  releases_read_locks_ = !index_only_ && exec_ctx_->ReleasesReadLocks();
+  cursor_.reset();
+  if (exec_ctx_->LocksKeyRanges(table_info_->oid_, false)) {
+    LockKeyRanges();
+  }
+  const bool bounded = plan_->GetLowerBound().has_value() || plan_->GetUpperBound().has_value();
+  cursor_ = Cursor::Begin(index_info_->index_.get(), bounded ? &lower_key_ : nullptr,
+                          plan_->GetUpperBound().has_value() ? &upper_key_ : nullptr);
+  if (cursor_ == nullptr) {
+    throw NotImplementedException("Index scan of an index that is not a B+ tree of generic keys.");
+  }
+  fetched_.clear();
+  fetched_idx_ = 0;
+}
+
+void IndexScanExecutor::LockKeyRanges() {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  Index *index = index_info_->index_.get();
+  const bool bounded = plan_->GetLowerBound().has_value() || plan_->GetUpperBound().has_value();
+  const Tuple *upper_key = plan_->GetUpperBound().has_value() ? &upper_key_ : nullptr;
+  std::vector<KeyRange> unlocked;
+  do {
+    unlocked.clear();
+    RID rid;
+    std::unique_ptr<Cursor> cursor = Cursor::Begin(index, bounded ? &lower_key_ : nullptr, upper_key);
+    if (cursor == nullptr) {
+      return;
+    }
+    while (cursor->Next(&rid, nullptr)) {
+      if (!txn->IsKeyRangeLocked(KeyRange{index_info_->index_oid_, rid}, LockMode::SHARED)) {
+        unlocked.push_back(KeyRange{index_info_->index_oid_, rid});
+      }
+    }
+    cursor.reset();
+    // The range past the entries of the scan, up to the first key past the upper bound or over the end of the index.
+    RID past_rid;
+    if (upper_key != nullptr) {
+      index->GetNextKey(*upper_key, &past_rid, txn);
+    }
+    if (!txn->IsKeyRangeLocked(KeyRange{index_info_->index_oid_, past_rid}, LockMode::SHARED)) {
+      unlocked.push_back(KeyRange{index_info_->index_oid_, past_rid});
+    }
+    for (const KeyRange &range : unlocked) {
+      exec_ctx_->LockKeyRange(range, LockMode::SHARED);
+    }
+  } while (!unlocked.empty());
+}
+
+void IndexScanExecutor::Close() {
+  cursor_.reset();
+  fetched_.clear();
+}
+
+bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
+  if (index_only_) {
+    return NextFromIndex(tuple, rid);
+  }
+  if (plan_->FetchesInPageOrder()) {
+    return NextInPageOrder(tuple, rid);
+  }
+  Transaction *txn = exec_ctx_->GetTransaction();
+  RID candidate_rid;
+  TupleRef candidate;
+  while (cursor_->Next(&candidate_rid, nullptr)) {
+    const bool was_locked =
+        releases_read_locks_ && (txn->IsSharedLocked(candidate_rid) || txn->IsExclusiveLocked(candidate_rid));
+    // The tuple is read in place on its page, which is let go of before the next one is fetched.
+    if (!table_info_->table_->GetTupleRef(candidate_rid, &candidate, txn)) {
+      continue;
+    }
+    const bool emitted = Emit(*candidate, tuple);
+    if (releases_read_locks_) {
+      exec_ctx_->ReleaseReadLock(candidate_rid, was_locked);
+    }
+    if (emitted) {
+      *rid = candidate_rid;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IndexScanExecutor::NextInPageOrder(Tuple *tuple, RID *rid) {
+  while (true) {
+    for (; fetched_idx_ < fetched_.size(); fetched_idx_++) {
+      if (Emit(fetched_[fetched_idx_], tuple)) {
+        *rid = fetched_[fetched_idx_++].GetRid();
+        return true;
+      }
+    }
+    std::vector<RID> rids;
+    RID candidate_rid;
+    while (rids.size() < FETCH_BATCH_SIZE && cursor_->Next(&candidate_rid, nullptr)) {
+      rids.push_back(candidate_rid);
+    }
+    if (rids.empty()) {
+      return false;
+    }
+    // Of the same page, the tuples stay in key order.
+    std::stable_sort(rids.begin(), rids.end(),
+                     [](const RID &lhs, const RID &rhs) { return lhs.GetPageId() < rhs.GetPageId(); });
+    fetched_idx_ = 0;
+    Transaction *txn = exec_ctx_->GetTransaction();
+    std::vector<bool> was_locked;
+    if (releases_read_locks_) {
+      for (const RID &fetched_rid : rids) {
+        was_locked.push_back(txn->IsSharedLocked(fetched_rid) || txn->IsExclusiveLocked(fetched_rid));
+      }
+    }
+    if (!table_info_->table_->GetTuples(rids, &fetched_, txn)) {
+      throw Exception("Index scan couldn't fetch a page of the table.");
+    }
+    // The tuples fetched are copies, which need no lock any more.
+    for (size_t i = 0; i < was_locked.size(); i++) {
+      exec_ctx_->ReleaseReadLock(rids[i], was_locked[i]);
+    }
+  }
+}
 
-void IndexScanExecutor::Init() {}
+bool IndexScanExecutor::NextFromIndex(Tuple *tuple, RID *rid) {
+  const std::vector<uint32_t> &key_attrs = index_info_->index_->GetKeyAttrs();
+  RID candidate_rid;
+  std::vector<Value> key;
+  while (cursor_->Next(&candidate_rid, &key)) {
+    // The expressions read the columns of the table, of which the ones they read come from the key.
+    for (size_t i = 0; i < key_attrs.size(); i++) {
+      row_[key_attrs[i]] = std::move(key[i]);
+    }
+    Tuple row(row_, &table_info_->schema_);
+    row.SetRid(candidate_rid);
+    if (Emit(row, tuple)) {
+      *rid = candidate_rid;
+      return true;
+    }
+  }
+  return false;
+}
 
-bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool IndexScanExecutor::Emit(const Tuple &candidate, Tuple *tuple) {
+  const Tuple *read = &candidate;
+  Tuple detoasted;
+  if (!toast_columns_.empty() && Toast::HasToasted(candidate, &table_info_->schema_, toast_columns_)) {
+    detoasted = Toast::Detoast(exec_ctx_->GetBufferPoolManager(), candidate, &table_info_->schema_, toast_columns_);
+    read = &detoasted;
+  }
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate != nullptr) {
+    Value result = predicate->Evaluate(read, &table_info_->schema_);
+    if (result.IsNull() || !result.GetAs<bool>()) {
+      return false;
+    }
+  }
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    values.emplace_back(column.GetExpr()->Evaluate(read, &table_info_->schema_));
+  }
+  *tuple = Tuple(std::move(values), GetOutputSchema());
+  return true;
+}
 
 }  // namespace bustub
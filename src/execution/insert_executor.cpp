@@ -1,26 +1,122 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// insert_executor.cpp
-//
-// Identification: src/execution/insert_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-
-#include "execution/executors/insert_executor.h"
-
-namespace bustub {
-
-InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
-                               std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
-
-void InsertExecutor::Init() {}
-
-bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// insert_executor.cpp
+//
+// Identification: src/execution/insert_executor.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "execution/executors/insert_executor.h"
+#include "execution/index_batch.h"
+
+namespace bustub {
+
+InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
+                               std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_executor_(std::move(child_executor)),
+      table_info_(exec_ctx->GetCatalog()->GetTable(plan->TableOid())),
+      tables_(table_info_->IsPartitioned() ? table_info_->partitions_ : std::vector<TableMetadata *>{table_info_}) {}
+
+size_t InsertExecutor::TableOf(const Tuple &tuple) const {
+  if (!table_info_->IsPartitioned()) {
+    return 0;
+  }
+  const PartitionScheme &scheme = *table_info_->partition_scheme_;
+  return scheme.PartitionOf(tuple.GetValue(&table_info_->schema_, scheme.GetColIdx()));
+}
+
+void InsertExecutor::Init() {
+  done_ = false;
+  exec_ctx_->LockTable(plan_->TableOid(), LockMode::INTENTION_EXCLUSIVE);
+  if (child_executor_ != nullptr) {
+    child_executor_->Init();
+  }
+}
+
+bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
+  if (done_) {
+    return false;
+  }
+  done_ = true;
+  if (plan_->IsRawInsert()) {
+    InsertRawValues();
+  } else {
+    InsertFromChild();
+  }
+  return false;
+}
+
+void InsertExecutor::Close() {
+  if (child_executor_ != nullptr) {
+    child_executor_->Close();
+  }
+}
+
+void InsertExecutor::InsertRawValues() {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  std::vector<std::vector<Tuple>> tuples(tables_.size());
+  for (const std::vector<Value> &values : plan_->RawValues()) {
+    Tuple tuple(values, &table_info_->schema_);
+    tuples[TableOf(tuple)].push_back(std::move(tuple));
+  }
+  for (size_t table_idx = 0; table_idx < tables_.size(); table_idx++) {
+    if (tuples[table_idx].empty()) {
+      continue;
+    }
+    TableMetadata *table_info = tables_[table_idx];
+    std::vector<RID> rids;
+    if (!table_info->table_->BulkInsert(tuples[table_idx], &rids, txn, &table_info->schema_)) {
+      throw Exception("Insert into table " + table_info->name_ + " failed.");
+    }
+    IndexBatch index_batch(exec_ctx_, table_info);
+    for (size_t i = 0; i < tuples[table_idx].size(); i++) {
+      index_batch.Insert(tuples[table_idx][i], rids[i]);
+      MaterializedView::RecordDeltas(txn, table_info_->views_, tuples[table_idx][i], true);
+      table_info->stats_.AddTuple(tuples[table_idx][i]);
+      if (table_info != table_info_) {
+        table_info_->stats_.AddTuple(tuples[table_idx][i]);
+      }
+    }
+    index_batch.Flush();
+  }
+}
+
+void InsertExecutor::InsertFromChild() {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  std::vector<IndexBatch> index_batches;
+  for (TableMetadata *table_info : tables_) {
+    index_batches.emplace_back(exec_ctx_, table_info);
+  }
+  TupleBatch batch;
+  while (child_executor_->NextBatch(&batch)) {
+    for (const Tuple &tuple : batch.GetTuples()) {
+      const size_t table_idx = TableOf(tuple);
+      TableMetadata *table_info = tables_[table_idx];
+      RID rid;
+      if (!table_info->table_->InsertTuple(tuple, &rid, txn, &table_info->schema_)) {
+        throw Exception("Insert into table " + table_info->name_ + " failed.");
+      }
+      index_batches[table_idx].Insert(tuple, rid);
+      MaterializedView::RecordDeltas(txn, table_info_->views_, tuple, true);
+      table_info->stats_.AddTuple(tuple);
+      if (table_info != table_info_) {
+        table_info_->stats_.AddTuple(tuple);
+      }
+    }
+    for (IndexBatch &index_batch : index_batches) {
+      index_batch.Flush();
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.cpp
+//
+// Identification: src/execution/join_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/join_hash_table.h"
+
+#include <utility>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void JoinHashTable::Insert(hash_t hash, Tuple &&tuple) {
+  BUSTUB_ASSERT(entries_.size() < END, "Too many tuples to build a hash table on.");
+  entries_.push_back(Entry{hash, END, std::move(tuple)});
+}
+
+void JoinHashTable::Build() {
+  // At least two buckets, so that the shift stays below 64.
+  shift_ = 63;
+  while (shift_ > 0 && (uint64_t{1} << (64 - shift_)) < entries_.size()) {
+    shift_--;
+  }
+  buckets_.assign(uint64_t{1} << (64 - shift_), END);
+  // Entries are pushed onto the front of their chains, so the later ones are found first.
+  for (uint32_t i = 0; i < entries_.size(); i++) {
+    uint32_t &bucket = buckets_[BucketOf(entries_[i].hash_)];
+    entries_[i].next_ = bucket;
+    bucket = i;
+  }
+}
+
+void JoinHashTable::Clear() {
+  entries_.clear();
+  buckets_.clear();
+  shift_ = 63;
+}
+
+void JoinHashTable::Prefetch(const hash_t *hashes, size_t n) const {
+  if (buckets_.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    __builtin_prefetch(&buckets_[BucketOf(hashes[i])]);
+  }
+  for (size_t i = 0; i < n; i++) {
+    const uint32_t entry = buckets_[BucketOf(hashes[i])];
+    if (entry != END) {
+      __builtin_prefetch(&entries_[entry]);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -12,14 +12,68 @@
 
 #include "execution/executors/limit_executor.h"
 
+#include <algorithm>
+#include <cstdint>
+
 namespace bustub {
 
 LimitExecutor::LimitExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *plan,
                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void LimitExecutor::Init() {
+  child_executor_->Init();
+  skipped_ = 0;
+  produced_ = 0;
+  if (plan_->GetLimit() == 0) {
+    child_executor_->Close();
+  }
+}
+
+void LimitExecutor::Close() { child_executor_->Close(); }
 
-void LimitExecutor::Init() {}
+bool LimitExecutor::Next(Tuple *tuple, RID *rid) {
+  while (produced_ < plan_->GetLimit() && child_executor_->Next(tuple, rid)) {
+    if (skipped_ < plan_->GetOffset()) {
+      skipped_++;
+      continue;
+    }
+    if (++produced_ == plan_->GetLimit()) {
+      child_executor_->Close();
+    }
+    return true;
+  }
+  return false;
+}
 
-bool LimitExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool LimitExecutor::NextBatch(TupleBatch *batch) {
+  const size_t capacity = batch->Capacity();
+  while (produced_ < plan_->GetLimit()) {
+    // Ask the child for no more tuples than the offset and the limit have left, so that it reads no further.
+    size_t to_skip = plan_->GetOffset() - skipped_;
+    size_t to_produce = plan_->GetLimit() - produced_;
+    size_t wanted = to_produce > SIZE_MAX - to_skip ? SIZE_MAX : to_skip + to_produce;
+    batch->Clear();
+    batch->SetCapacity(std::clamp<size_t>(wanted, 1, capacity));
+    bool produced = child_executor_->NextBatch(batch);
+    batch->SetCapacity(capacity);
+    if (!produced) {
+      return false;
+    }
+    size_t begin = std::min(plan_->GetOffset() - skipped_, batch->Size());
+    size_t end = begin + std::min(plan_->GetLimit() - produced_, batch->Size() - begin);
+    skipped_ += begin;
+    produced_ += end - begin;
+    if (produced_ == plan_->GetLimit()) {
+      child_executor_->Close();
+    }
+    if (begin < end) {
+      batch->Slice(begin, end);
+      return true;
+    }
+  }
+  batch->Clear();
+  return false;
+}
 
 }  // namespace bustub
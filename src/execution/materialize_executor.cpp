@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialize_executor.cpp
+//
+// Identification: src/execution/materialize_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/materialize_executor.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "execution/expressions/column_value_expression.h"
+#include "storage/table/toast.h"
+#include "storage/table/tuple_ref.h"
+
+namespace bustub {
+
+namespace {
+
+/** Adds the columns of the table an output expression reads, those of the right side of the join, each once. */
+void CollectTableColumns(const AbstractExpression *expr, std::vector<uint32_t> *col_idxs) {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    if (column->GetTupleIdx() == 1 &&
+        std::find(col_idxs->begin(), col_idxs->end(), column->GetColIdx()) == col_idxs->end()) {
+      col_idxs->push_back(column->GetColIdx());
+    }
+    return;
+  }
+  for (const AbstractExpression *child : expr->GetChildren()) {
+    CollectTableColumns(child, col_idxs);
+  }
+}
+
+}  // namespace
+
+MaterializeExecutor::MaterializeExecutor(ExecutorContext *exec_ctx, const MaterializePlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      table_info_(exec_ctx->GetCatalog()->GetTable(plan->GetTableOid())) {
+  std::vector<uint32_t> col_idxs;
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    CollectTableColumns(column.GetExpr(), &col_idxs);
+  }
+  std::copy_if(col_idxs.begin(), col_idxs.end(), std::back_inserter(toast_columns_),
+               [this](uint32_t col_idx) { return !table_info_->schema_.GetColumn(col_idx).IsInlined(); });
+}
+
+void MaterializeExecutor::Init() {
+  if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
+    exec_ctx_->LockTable(table_info_->oid_, LockMode::INTENTION_SHARED);
+  }
+  releases_read_locks_ = exec_ctx_->ReleasesReadLocks();
+  child_->Init();
+}
+
+bool MaterializeExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *child_schema = child_->GetOutputSchema();
+  const Schema *table_schema = &table_info_->schema_;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  Tuple child_tuple;
+  RID child_rid;
+  TupleRef row;
+  while (child_->Next(&child_tuple, &child_rid)) {
+    const RID row_rid(child_tuple.GetValue(child_schema, plan_->GetRowIdColIdx()).GetAs<int64_t>());
+    const bool was_locked = releases_read_locks_ && (txn->IsSharedLocked(row_rid) || txn->IsExclusiveLocked(row_rid));
+    // The row is read in place on its page, which is let go of once the output tuple is built.
+    if (!table_info_->table_->GetTupleRef(row_rid, &row, txn)) {
+      continue;
+    }
+    const Tuple *read = &*row;
+    Tuple detoasted;
+    if (!toast_columns_.empty() && Toast::HasToasted(*row, table_schema, toast_columns_)) {
+      detoasted = Toast::Detoast(exec_ctx_->GetBufferPoolManager(), *row, table_schema, toast_columns_);
+      read = &detoasted;
+    }
+    std::vector<Value> values;
+    values.reserve(GetOutputSchema()->GetColumnCount());
+    for (const Column &column : GetOutputSchema()->GetColumns()) {
+      values.emplace_back(column.GetExpr()->EvaluateJoin(&child_tuple, child_schema, read, table_schema));
+    }
+    *tuple = Tuple(std::move(values), GetOutputSchema());
+    *rid = row_rid;
+    row.Release();
+    if (releases_read_locks_) {
+      exec_ctx_->ReleaseReadLock(row_rid, was_locked);
+    }
+    return true;
+  }
+  return false;
+}
+
+}  // namespace bustub
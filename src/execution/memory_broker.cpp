@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_broker.cpp
+//
+// Identification: src/execution/memory_broker.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/memory_broker.h"
+
+#include <algorithm>
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+size_t MemoryBroker::Admit(size_t request, size_t minimum) {
+  request = std::min(request, capacity_);
+  minimum = std::min(minimum, request);
+  std::unique_lock<std::mutex> lock(latch_);
+  const uint64_t ticket = next_ticket_++;
+  queue_.push_back(ticket);
+  cv_.wait(lock, [&] { return queue_.front() == ticket && capacity_ - reserved_ >= minimum; });
+  queue_.pop_front();
+  const size_t granted = std::min(request, capacity_ - reserved_);
+  reserved_ += granted;
+  // The next query in the queue may fit in what is left.
+  cv_.notify_all();
+  return granted;
+}
+
+void MemoryBroker::Release(size_t bytes) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(bytes <= reserved_, "Released more memory than was granted.");
+  reserved_ -= bytes;
+  cv_.notify_all();
+}
+
+size_t MemoryBroker::GetReserved() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return reserved_;
+}
+
+size_t MemoryBroker::GetNumWaiting() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return queue_.size();
+}
+
+size_t MemoryBroker::CountSpillingOperators(const AbstractPlanNode *plan) {
+  size_t num_operators = 0;
+  switch (plan->GetType()) {
+    case PlanType::Aggregation:
+    case PlanType::HashJoin:
+    case PlanType::MergeJoin:
+    case PlanType::Sort:
+      num_operators = 1;
+      break;
+    default:
+      break;
+  }
+  for (const AbstractPlanNode *child : plan->GetChildren()) {
+    num_operators += CountSpillingOperators(child);
+  }
+  return num_operators;
+}
+
+}  // namespace bustub
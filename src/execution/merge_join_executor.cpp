@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.cpp
+//
+// Identification: src/execution/merge_join_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/merge_join_executor.h"
+
+#include <utility>
+
+namespace bustub {
+
+MergeJoinExecutor::MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                                     std::unique_ptr<AbstractExecutor> &&left_executor,
+                                     std::unique_ptr<AbstractExecutor> &&right_executor)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)),
+      spill_(exec_ctx->GetTempSpace(), "a merge join"),
+      respill_(exec_ctx->GetTempSpace(), "a merge join") {}
+
+void MergeJoinExecutor::Init() {
+  DropRun();
+  in_run_ = false;
+  left_executor_->Init();
+  right_executor_->Init();
+  AdvanceLeft();
+  AdvanceRight();
+}
+
+void MergeJoinExecutor::Close() {
+  DropRun();
+  in_run_ = false;
+  left_valid_ = false;
+  right_valid_ = false;
+  left_executor_->Close();
+  right_executor_->Close();
+}
+
+bool MergeJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const AbstractExpression *predicate = plan_->Predicate();
+  while (true) {
+    if (in_run_) {
+      const Tuple *right = NextInRun();
+      if (right != nullptr) {
+        if (predicate != nullptr && !predicate->EvaluateJoin(&left_, left_schema, right, right_schema).GetAs<bool>()) {
+          continue;
+        }
+        std::vector<Value> values;
+        values.reserve(GetOutputSchema()->GetColumnCount());
+        for (const Column &column : GetOutputSchema()->GetColumns()) {
+          values.emplace_back(column.GetExpr()->EvaluateJoin(&left_, left_schema, right, right_schema));
+        }
+        *tuple = Tuple(std::move(values), GetOutputSchema());
+        return true;
+      }
+      // The run is done with the current left tuple; the next one joins with it too if it has the same key.
+      if (AdvanceLeft() && CompareKeys(left_keys_, run_keys_) == 0) {
+        RewindRun();
+        continue;
+      }
+      in_run_ = false;
+      DropRun();
+    }
+
+    if (!left_valid_ || !right_valid_) {
+      return false;
+    }
+    const int cmp = CompareKeys(left_keys_, right_keys_);
+    if (cmp < 0) {
+      AdvanceLeft();
+    } else if (cmp > 0) {
+      AdvanceRight();
+    } else {
+      LoadRun();
+      in_run_ = true;
+    }
+  }
+}
+
+int MergeJoinExecutor::CompareKeys(const std::vector<Value> &left, const std::vector<Value> &right) {
+  for (size_t i = 0; i < left.size(); i++) {
+    if (left[i].CompareLessThan(right[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (left[i].CompareGreaterThan(right[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+bool MergeJoinExecutor::Pull(AbstractExecutor *executor, const std::vector<const AbstractExpression *> &key_exprs,
+                             Tuple *tuple, std::vector<Value> *keys) {
+  const Schema *schema = executor->GetOutputSchema();
+  RID rid;
+  while (executor->Next(tuple, &rid)) {
+    keys->clear();
+    bool has_null = false;
+    for (const AbstractExpression *key : key_exprs) {
+      keys->push_back(key->Evaluate(tuple, schema));
+      has_null = has_null || keys->back().IsNull();
+    }
+    if (!has_null) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MergeJoinExecutor::LoadRun() {
+  DropRun();
+  run_keys_ = right_keys_;
+  const size_t budget = exec_ctx_->GetMemoryBudget();
+  size_t bytes = 0;
+  do {
+    if (!spilled_ && (run_.empty() || bytes + right_.GetLength() <= budget)) {
+      bytes += right_.GetLength();
+      run_.push_back(std::move(right_));
+    } else {
+      spill_.Append(right_);
+      spilled_ = true;
+    }
+  } while (AdvanceRight() && CompareKeys(right_keys_, run_keys_) == 0);
+  if (spilled_) {
+    spill_.Seal();
+  }
+}
+
+void MergeJoinExecutor::RewindRun() {
+  run_pos_ = 0;
+  if (spilled_) {
+    // What was read of the spilled tuples was written again as it was read: read that instead.
+    respill_.Seal();
+    spill_ = std::move(respill_);
+    respill_ = TmpTupleRun(exec_ctx_->GetTempSpace(), "a merge join");
+    spill_block_.clear();
+    spill_pos_ = 0;
+  }
+}
+
+const Tuple *MergeJoinExecutor::NextInRun() {
+  if (run_pos_ < run_.size()) {
+    return &run_[run_pos_++];
+  }
+  while (spill_pos_ == spill_block_.size()) {
+    if (!spilled_ || !spill_.ReadBlock(&spill_block_)) {
+      return nullptr;
+    }
+    spill_pos_ = 0;
+    for (const Tuple &tuple : spill_block_) {
+      respill_.Append(tuple);
+    }
+  }
+  return &spill_block_[spill_pos_++];
+}
+
+void MergeJoinExecutor::DropRun() {
+  run_.clear();
+  run_pos_ = 0;
+  spill_.Drop();
+  respill_.Drop();
+  spilled_ = false;
+  spill_block_.clear();
+  spill_pos_ = 0;
+}
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metered_executor.cpp
+//
+// Identification: src/execution/metered_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/metered_executor.h"
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <string>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+/** @return the nanoseconds elapsed since start */
+uint64_t ElapsedNanos(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+MeteredExecutor::MeteredExecutor(ExecutorContext *exec_ctx, PlanType plan_type,
+                                 std::unique_ptr<AbstractExecutor> &&executor)
+    : AbstractExecutor(exec_ctx), executor_(std::move(executor)), metrics_(GetOperatorMetrics(plan_type)) {}
+
+MeteredExecutor::OperatorMetrics *MeteredExecutor::GetOperatorMetrics(PlanType plan_type) {
+  // Never destroyed, nor unregistered: executors may run until the end of the process.
+  static auto *metrics = [] {
+    auto *metrics = new std::array<OperatorMetrics, NUM_PLAN_TYPES>();
+    MetricsRegistry *registry = MetricsRegistry::Global();
+    for (size_t i = 0; i < NUM_PLAN_TYPES; i++) {
+      const std::string prefix = std::string("executor.") + PlanTypeName(static_cast<PlanType>(i));
+      OperatorMetrics *type_metrics = &(*metrics)[i];
+      registry->RegisterCounter(metrics, prefix + ".tuples", &type_metrics->num_tuples_);
+      registry->RegisterCounter(metrics, prefix + ".busy_ns", &type_metrics->busy_ns_);
+      registry->RegisterCounter(metrics, prefix + ".tuples_per_sec", [type_metrics] {
+        const uint64_t busy_ns = type_metrics->busy_ns_.Get();
+        return busy_ns == 0 ? 0 : static_cast<uint64_t>(type_metrics->num_tuples_.Get() * 1e9 / busy_ns);
+      });
+    }
+    return metrics;
+  }();
+  return &(*metrics)[static_cast<size_t>(plan_type)];
+}
+
+void MeteredExecutor::Init() {
+  const auto start = std::chrono::steady_clock::now();
+  executor_->Init();
+  metrics_->busy_ns_.Add(ElapsedNanos(start));
+}
+
+bool MeteredExecutor::Next(Tuple *tuple, RID *rid) {
+  const auto start = std::chrono::steady_clock::now();
+  const bool produced = executor_->Next(tuple, rid);
+  metrics_->busy_ns_.Add(ElapsedNanos(start));
+  if (produced) {
+    metrics_->num_tuples_.Add();
+  }
+  return produced;
+}
+
+bool MeteredExecutor::NextBatch(TupleBatch *batch) {
+  const auto start = std::chrono::steady_clock::now();
+  const bool produced = executor_->NextBatch(batch);
+  metrics_->busy_ns_.Add(ElapsedNanos(start));
+  metrics_->num_tuples_.Add(batch->Size());
+  return produced;
+}
+
+}  // namespace bustub
@@ -12,15 +12,78 @@
 
 #include "execution/executors/nested_loop_join_executor.h"
 
+#include <utility>
+
 namespace bustub {
 
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const NestedLoopJoinPlanNode *plan,
                                                std::unique_ptr<AbstractExecutor> &&left_executor,
                                                std::unique_ptr<AbstractExecutor> &&right_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)) {}
+
+void NestedLoopJoinExecutor::Init() {
+  left_executor_->Init();
+  block_.clear();
+  block_.reserve(plan_->GetBlockSize());
+  has_right_ = false;
+  NextBlock();
+}
+
+void NestedLoopJoinExecutor::Close() {
+  block_.clear();
+  left_executor_->Close();
+  right_executor_->Close();
+}
+
+bool NestedLoopJoinExecutor::NextBlock() {
+  block_.clear();
+  Tuple tuple;
+  RID rid;
+  while (block_.size() < plan_->GetBlockSize() && left_executor_->Next(&tuple, &rid)) {
+    block_.push_back(std::move(tuple));
+  }
+  if (block_.empty()) {
+    return false;
+  }
+  right_executor_->Init();
+  block_idx_ = block_.size();
+  return true;
+}
 
-void NestedLoopJoinExecutor::Init() {}
+bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *left_schema = left_executor_->GetOutputSchema();
+  const Schema *right_schema = right_executor_->GetOutputSchema();
+  const AbstractExpression *predicate = plan_->Predicate();
+  while (!block_.empty()) {
+    for (; has_right_ && block_idx_ < block_.size(); block_idx_++) {
+      const Tuple &left = block_[block_idx_];
+      if (predicate != nullptr &&
+          !predicate->EvaluateJoin(&left, left_schema, &right_tuple_, right_schema).GetAs<bool>()) {
+        continue;
+      }
+      std::vector<Value> values;
+      values.reserve(GetOutputSchema()->GetColumnCount());
+      for (const Column &column : GetOutputSchema()->GetColumns()) {
+        values.emplace_back(column.GetExpr()->EvaluateJoin(&left, left_schema, &right_tuple_, right_schema));
+      }
+      *tuple = Tuple(std::move(values), GetOutputSchema());
+      block_idx_++;
+      return true;
+    }
 
-bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+    // The block is done with the current right tuple: move on to the next one, or to the next block.
+    RID right_rid;
+    has_right_ = right_executor_->Next(&right_tuple_, &right_rid);
+    if (has_right_) {
+      block_idx_ = 0;
+    } else if (!NextBlock()) {
+      return false;
+    }
+  }
+  return false;
+}
 
 }  // namespace bustub
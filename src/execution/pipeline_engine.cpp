@@ -0,0 +1,544 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pipeline_engine.cpp
+//
+// Identification: src/execution/pipeline_engine.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/pipeline_engine.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_factory.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/executors/hash_join_executor.h"
+#include "execution/executors/seq_scan_executor.h"
+#include "execution/join_hash_table.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/exchange_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/morsel_source.h"
+
+namespace bustub {
+
+/** Gathers the output of the plan, each worker into its own tuples. */
+class ResultSink : public PushOperator {
+ public:
+  void Open(size_t num_workers) override { tuples_.assign(num_workers, {}); }
+
+  void Push(size_t worker, const TupleBatch &batch) override {
+    tuples_[worker].insert(tuples_[worker].end(), batch.GetTuples().begin(), batch.GetTuples().end());
+  }
+
+  void Finish() override {}
+
+  /** Appends the tuples gathered, worker by worker, to result_set. */
+  void Take(std::vector<Tuple> *result_set) {
+    for (auto &tuples : tuples_) {
+      std::move(tuples.begin(), tuples.end(), std::back_inserter(*result_set));
+    }
+    tuples_.clear();
+  }
+
+ private:
+  std::vector<std::vector<Tuple>> tuples_;
+};
+
+namespace {
+
+/** Pushes the tuples of a worker to an operator a batch at a time. */
+class Emitter {
+ public:
+  explicit Emitter(PushOperator *next) : next_(next) {}
+
+  void Open(size_t num_workers) {
+    batches_.clear();
+    batches_.resize(num_workers);
+  }
+
+  /** Appends a tuple of a worker, pushing the batch of the worker once it is full. */
+  void Emit(size_t worker, RID rid, const std::vector<Value> &values, const Schema *schema) {
+    TupleBatch &batch = batches_[worker];
+    batch.Append(rid, values, schema);
+    if (batch.IsFull()) {
+      next_->Push(worker, batch);
+      batch.Clear();
+    }
+  }
+
+  /** Pushes the batches that are not empty. */
+  void Flush() {
+    for (size_t worker = 0; worker < batches_.size(); worker++) {
+      if (!batches_[worker].IsEmpty()) {
+        next_->Push(worker, batches_[worker]);
+        batches_[worker].Clear();
+      }
+    }
+  }
+
+ private:
+  PushOperator *next_;
+  std::vector<TupleBatch> batches_;
+};
+
+/** A sequential scan, with an instance per worker sharing a MorselSource. */
+class ScanSource : public PushSource {
+ public:
+  ScanSource(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan, size_t num_workers)
+      : exec_ctx_(exec_ctx), plan_(plan) {
+    for (size_t i = 0; i < num_workers; i++) {
+      scans_.push_back(ExecutorFactory::CreateExecutor(exec_ctx, plan));
+    }
+  }
+
+  ~ScanSource() override { Unregister(); }
+
+  size_t NumWorkers() const override { return scans_.size(); }
+
+  void Open() override {
+    if (scans_.size() == 1) {
+      return;
+    }
+    // The workers share the transaction: the table is locked here, so that the workers find the lock held.
+    SeqScanExecutor::LockTable(exec_ctx_, plan_->GetTableOid());
+    std::vector<TableHeap *> tables;
+    for (TableMetadata *table_info : SeqScanExecutor::ScanTables(exec_ctx_->GetCatalog(), plan_)) {
+      tables.push_back(table_info->table_.get());
+    }
+    morsels_ = std::make_unique<MorselSource>(std::move(tables), plan_->GetMorselSize());
+    exec_ctx_->SetMorselSource(plan_, morsels_.get());
+  }
+
+  void Run(size_t worker, PushOperator *head) override {
+    AbstractExecutor *scan = scans_[worker].get();
+    scan->Init();
+    TupleBatch batch;
+    while (scan->NextBatch(&batch)) {
+      head->Push(worker, batch);
+    }
+  }
+
+  void Close() override {
+    for (auto &scan : scans_) {
+      scan->Close();
+    }
+    Unregister();
+  }
+
+ private:
+  void Unregister() {
+    if (morsels_ != nullptr) {
+      exec_ctx_->SetMorselSource(plan_, nullptr);
+      morsels_.reset();
+    }
+  }
+
+  ExecutorContext *exec_ctx_;
+  const SeqScanPlanNode *plan_;
+  std::vector<std::unique_ptr<AbstractExecutor>> scans_;
+  std::unique_ptr<MorselSource> morsels_;
+};
+
+/** A plan the engine does not compile, run by its Volcano executor on a single worker. */
+class ExecutorSource : public PushSource {
+ public:
+  ExecutorSource(ExecutorContext *exec_ctx, const AbstractPlanNode *plan)
+      : executor_(ExecutorFactory::CreateExecutor(exec_ctx, plan)) {}
+
+  size_t NumWorkers() const override { return 1; }
+
+  void Run(size_t worker, PushOperator *head) override {
+    executor_->Init();
+    TupleBatch batch;
+    while (executor_->NextBatch(&batch)) {
+      head->Push(worker, batch);
+    }
+  }
+
+  void Close() override { executor_->Close(); }
+
+ private:
+  std::unique_ptr<AbstractExecutor> executor_;
+};
+
+/** The build side of a hash join: the left tuples, by the hash of their keys. */
+class HashBuildSink : public PushOperator {
+ public:
+  explicit HashBuildSink(const HashJoinPlanNode *plan) : plan_(plan) {}
+
+  void Open(size_t num_workers) override {
+    partials_.assign(num_workers, {});
+    table_.Clear();
+  }
+
+  void Push(size_t worker, const TupleBatch &batch) override {
+    const Schema *schema = plan_->GetLeftPlan()->OutputSchema();
+    for (const Tuple &tuple : batch.GetTuples()) {
+      hash_t hash;
+      if (HashJoinExecutor::HashKeys(tuple, schema, plan_->GetLeftKeys(), 0, &hash)) {
+        partials_[worker].emplace_back(hash, tuple);
+      }
+    }
+  }
+
+  void Finish() override {
+    for (auto &partial : partials_) {
+      for (auto &[hash, tuple] : partial) {
+        table_.Insert(hash, std::move(tuple));
+      }
+    }
+    partials_.clear();
+    table_.Build();
+  }
+
+  /** @return the hash table, once built */
+  const JoinHashTable &GetTable() const { return table_; }
+
+ private:
+  const HashJoinPlanNode *plan_;
+  /** The tuples of each worker with their hashes, until Finish inserts them into table_. */
+  std::vector<std::vector<std::pair<hash_t, Tuple>>> partials_;
+  JoinHashTable table_;
+};
+
+/** The probe side of a hash join, which streams the right tuples through the hash table of its build side. */
+class HashProbeOperator : public PushOperator {
+ public:
+  HashProbeOperator(const HashJoinPlanNode *plan, const HashBuildSink *build, PushOperator *next)
+      : plan_(plan), build_(build), emitter_(next) {}
+
+  void Open(size_t num_workers) override {
+    emitter_.Open(num_workers);
+    hashes_.assign(num_workers, {});
+    valid_.assign(num_workers, {});
+  }
+
+  void Push(size_t worker, const TupleBatch &batch) override {
+    const JoinHashTable &table = build_->GetTable();
+    const Schema *right_schema = plan_->GetRightPlan()->OutputSchema();
+    const std::vector<Tuple> &tuples = batch.GetTuples();
+    // Hash the whole batch first, so that the buckets of a group of tuples are prefetched together.
+    std::vector<hash_t> &hashes = hashes_[worker];
+    std::vector<bool> &valid = valid_[worker];
+    hashes.assign(tuples.size(), 0);
+    valid.resize(tuples.size());
+    for (size_t i = 0; i < tuples.size(); i++) {
+      valid[i] = HashJoinExecutor::HashKeys(tuples[i], right_schema, plan_->GetRightKeys(), 0, &hashes[i]);
+    }
+    for (size_t group = 0; group < tuples.size(); group += PROBE_GROUP_SIZE) {
+      const size_t end = std::min(tuples.size(), group + PROBE_GROUP_SIZE);
+      table.Prefetch(hashes.data() + group, end - group);
+      for (size_t i = group; i < end; i++) {
+        Probe(worker, table, tuples[i], batch.GetRID(i), valid[i], hashes[i]);
+      }
+    }
+  }
+
+  void Finish() override { emitter_.Flush(); }
+
+ private:
+  /** Number of probe tuples whose buckets are prefetched together, see JoinHashTable::Prefetch. */
+  static constexpr size_t PROBE_GROUP_SIZE = 16;
+
+  /** Emits the output of a probe tuple, if any. */
+  void Probe(size_t worker, const JoinHashTable &table, const Tuple &probe, RID rid, bool valid, hash_t hash) {
+    const JoinType join_type = plan_->GetJoinType();
+    bool matched = false;
+    if (valid) {
+      for (uint32_t entry = table.Find(hash); entry != JoinHashTable::END; entry = table.FindNext(entry)) {
+        const Tuple &build = table.GetTuple(entry);
+        if (!Matches(build, probe)) {
+          continue;
+        }
+        matched = true;
+        if (join_type != JoinType::Inner) {
+          break;
+        }
+        EmitJoined(worker, build, probe);
+      }
+    }
+    if (matched ? join_type == JoinType::Semi : join_type == JoinType::Anti) {
+      const Schema *right_schema = plan_->GetRightPlan()->OutputSchema();
+      std::vector<Value> values;
+      values.reserve(plan_->OutputSchema()->GetColumnCount());
+      for (const Column &column : plan_->OutputSchema()->GetColumns()) {
+        values.emplace_back(column.GetExpr()->Evaluate(&probe, right_schema));
+      }
+      emitter_.Emit(worker, rid, values, plan_->OutputSchema());
+    }
+  }
+
+  /** @return true if a build tuple and a probe tuple join: their keys are equal and they satisfy the predicate */
+  bool Matches(const Tuple &build, const Tuple &probe) const {
+    const Schema *left_schema = plan_->GetLeftPlan()->OutputSchema();
+    const Schema *right_schema = plan_->GetRightPlan()->OutputSchema();
+    const auto &left_keys = plan_->GetLeftKeys();
+    const auto &right_keys = plan_->GetRightKeys();
+    for (size_t i = 0; i < left_keys.size(); i++) {
+      Value left_value = left_keys[i]->Evaluate(&build, left_schema);
+      Value right_value = right_keys[i]->Evaluate(&probe, right_schema);
+      if (left_value.CompareEquals(right_value) != CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    const AbstractExpression *predicate = plan_->Predicate();
+    return predicate == nullptr || predicate->EvaluateJoin(&build, left_schema, &probe, right_schema).GetAs<bool>();
+  }
+
+  void EmitJoined(size_t worker, const Tuple &build, const Tuple &probe) {
+    const Schema *left_schema = plan_->GetLeftPlan()->OutputSchema();
+    const Schema *right_schema = plan_->GetRightPlan()->OutputSchema();
+    std::vector<Value> values;
+    values.reserve(plan_->OutputSchema()->GetColumnCount());
+    for (const Column &column : plan_->OutputSchema()->GetColumns()) {
+      values.emplace_back(column.GetExpr()->EvaluateJoin(&build, left_schema, &probe, right_schema));
+    }
+    emitter_.Emit(worker, RID(), values, plan_->OutputSchema());
+  }
+
+  const HashJoinPlanNode *plan_;
+  const HashBuildSink *build_;
+  Emitter emitter_;
+  /** The hashes of the keys of the batch of each worker, and whether they have no NULL key. */
+  std::vector<std::vector<hash_t>> hashes_;
+  std::vector<std::vector<bool>> valid_;
+};
+
+/** An aggregation: a sink that aggregates into a table per worker, and the single-worker source of its groups. */
+class AggregationBreaker : public PushOperator, public PushSource {
+ public:
+  explicit AggregationBreaker(const AggregationPlanNode *plan) : plan_(plan) {}
+
+  void Open(size_t num_workers) override {
+    tables_.clear();
+    for (size_t i = 0; i < num_workers; i++) {
+      tables_.emplace_back(plan_->GetAggregates(), plan_->GetAggregateTypes());
+    }
+  }
+
+  void Push(size_t worker, const TupleBatch &batch) override {
+    const Schema *schema = plan_->GetChildPlan()->OutputSchema();
+    for (const Tuple &tuple : batch.GetTuples()) {
+      std::vector<Value> keys;
+      for (const auto *expr : plan_->GetGroupBys()) {
+        keys.emplace_back(expr->Evaluate(&tuple, schema));
+      }
+      std::vector<Value> vals;
+      for (const auto *expr : plan_->GetAggregates()) {
+        vals.emplace_back(expr->Evaluate(&tuple, schema));
+      }
+      tables_[worker].InsertCombine({keys}, {vals});
+    }
+  }
+
+  void Finish() override {
+    for (size_t i = 1; i < tables_.size(); i++) {
+      tables_[0].MergeFrom(&tables_[i]);
+    }
+    while (tables_.size() > 1) {
+      tables_.pop_back();
+    }
+  }
+
+  size_t NumWorkers() const override { return 1; }
+
+  void Run(size_t worker, PushOperator *head) override {
+    if (tables_.empty()) {
+      return;
+    }
+    const AbstractExpression *having = plan_->GetHaving();
+    const Schema *schema = plan_->OutputSchema();
+    Emitter emitter(head);
+    emitter.Open(1);
+    for (auto iter = tables_[0].Begin(); iter != tables_[0].End(); ++iter) {
+      const AggregateKey &key = iter.Key();
+      const AggregateValue &val = iter.Val();
+      if (having != nullptr && !having->EvaluateAggregate(key.group_bys_, val.aggregates_).GetAs<bool>()) {
+        continue;
+      }
+      std::vector<Value> values;
+      values.reserve(schema->GetColumnCount());
+      for (const Column &column : schema->GetColumns()) {
+        values.emplace_back(column.GetExpr()->EvaluateAggregate(key.group_bys_, val.aggregates_));
+      }
+      emitter.Emit(worker, RID(), values, schema);
+    }
+    emitter.Flush();
+  }
+
+  void Close() override { tables_.clear(); }
+
+ private:
+  const AggregationPlanNode *plan_;
+  /** The table of each worker, merged into the first by Finish. */
+  std::vector<SimpleAggregationHashTable> tables_;
+};
+
+/** A sort: a sink that gathers the tuples of every worker, and the single-worker source of them in order. */
+class SortBreaker : public PushOperator, public PushSource {
+ public:
+  explicit SortBreaker(const SortPlanNode *plan) : plan_(plan) {}
+
+  void Open(size_t num_workers) override { partials_.assign(num_workers, {}); }
+
+  void Push(size_t worker, const TupleBatch &batch) override {
+    partials_[worker].insert(partials_[worker].end(), batch.GetTuples().begin(), batch.GetTuples().end());
+  }
+
+  void Finish() override {
+    tuples_.clear();
+    for (auto &partial : partials_) {
+      std::move(partial.begin(), partial.end(), std::back_inserter(tuples_));
+    }
+    partials_.clear();
+    SortKey sort_key(plan_->GetOrderBys(), plan_->GetChildPlan()->OutputSchema());
+    std::stable_sort(tuples_.begin(), tuples_.end(),
+                     [&](const Tuple &left, const Tuple &right) { return sort_key.Compare(left, right) < 0; });
+  }
+
+  size_t NumWorkers() const override { return 1; }
+
+  void Run(size_t worker, PushOperator *head) override {
+    TupleBatch batch;
+    for (Tuple &tuple : tuples_) {
+      batch.Emplace(RID(), std::move(tuple));
+      if (batch.IsFull()) {
+        head->Push(worker, batch);
+        batch.Clear();
+      }
+    }
+    if (!batch.IsEmpty()) {
+      head->Push(worker, batch);
+    }
+  }
+
+  void Close() override { tuples_.clear(); }
+
+ private:
+  const SortPlanNode *plan_;
+  /** The tuples of each worker, until Finish sorts them into tuples_. */
+  std::vector<std::vector<Tuple>> partials_;
+  std::vector<Tuple> tuples_;
+};
+
+}  // namespace
+
+PipelineEngine::PipelineEngine(ExecutorContext *exec_ctx, const AbstractPlanNode *plan)
+    : exec_ctx_(exec_ctx),
+      num_workers_(exec_ctx->GetThreadPool() == nullptr ? 1 : exec_ctx->GetThreadPool()->Size()) {
+  auto result_sink = std::make_unique<ResultSink>();
+  result_sink_ = result_sink.get();
+  operators_.push_back(std::move(result_sink));
+  Pipeline pipeline;
+  pipeline.operators_.push_back(result_sink_);
+  Compile(plan, result_sink_, &pipeline);
+  AddPipeline(&pipeline);
+}
+
+PipelineEngine::~PipelineEngine() = default;
+
+void PipelineEngine::Compile(const AbstractPlanNode *plan, PushOperator *consumer, Pipeline *pipeline) {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      sources_.push_back(
+          std::make_unique<ScanSource>(exec_ctx_, dynamic_cast<const SeqScanPlanNode *>(plan), num_workers_));
+      pipeline->source_ = sources_.back().get();
+      return;
+    }
+    case PlanType::Exchange:
+      Compile(dynamic_cast<const ExchangePlanNode *>(plan)->GetChildPlan(), consumer, pipeline);
+      return;
+    case PlanType::HashJoin: {
+      const auto *join_plan = dynamic_cast<const HashJoinPlanNode *>(plan);
+      auto build = std::make_unique<HashBuildSink>(join_plan);
+      auto probe = std::make_unique<HashProbeOperator>(join_plan, build.get(), consumer);
+      Pipeline build_pipeline;
+      build_pipeline.operators_.push_back(build.get());
+      Compile(join_plan->GetLeftPlan(), build.get(), &build_pipeline);
+      AddPipeline(&build_pipeline);
+      pipeline->operators_.push_back(probe.get());
+      Compile(join_plan->GetRightPlan(), probe.get(), pipeline);
+      operators_.push_back(std::move(build));
+      operators_.push_back(std::move(probe));
+      return;
+    }
+    case PlanType::Aggregation: {
+      const auto *agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
+      auto breaker = std::make_unique<AggregationBreaker>(agg_plan);
+      Pipeline child_pipeline;
+      child_pipeline.operators_.push_back(breaker.get());
+      Compile(agg_plan->GetChildPlan(), breaker.get(), &child_pipeline);
+      AddPipeline(&child_pipeline);
+      pipeline->source_ = breaker.get();
+      operators_.push_back(std::move(breaker));
+      return;
+    }
+    case PlanType::Sort: {
+      const auto *sort_plan = dynamic_cast<const SortPlanNode *>(plan);
+      auto breaker = std::make_unique<SortBreaker>(sort_plan);
+      Pipeline child_pipeline;
+      child_pipeline.operators_.push_back(breaker.get());
+      Compile(sort_plan->GetChildPlan(), breaker.get(), &child_pipeline);
+      AddPipeline(&child_pipeline);
+      pipeline->source_ = breaker.get();
+      operators_.push_back(std::move(breaker));
+      return;
+    }
+    default:
+      sources_.push_back(std::make_unique<ExecutorSource>(exec_ctx_, plan));
+      pipeline->source_ = sources_.back().get();
+      return;
+  }
+}
+
+void PipelineEngine::AddPipeline(Pipeline *pipeline) {
+  std::reverse(pipeline->operators_.begin(), pipeline->operators_.end());
+  pipelines_.push_back(std::move(*pipeline));
+}
+
+void PipelineEngine::Execute(std::vector<Tuple> *result_set) {
+  for (const Pipeline &pipeline : pipelines_) {
+    Run(pipeline);
+  }
+  if (result_set != nullptr) {
+    result_sink_->Take(result_set);
+  }
+}
+
+void PipelineEngine::Run(const Pipeline &pipeline) {
+  PushSource *source = pipeline.source_;
+  const size_t num_workers = source->NumWorkers();
+  for (PushOperator *op : pipeline.operators_) {
+    op->Open(num_workers);
+  }
+  PushOperator *head = pipeline.operators_.front();
+  source->Open();
+  try {
+    if (num_workers == 1) {
+      source->Run(0, head);
+    } else {
+      exec_ctx_->GetThreadPool()->RunAll(
+          num_workers, [&](size_t worker) { source->Run(worker, head); }, exec_ctx_->GetWorkloadClass());
+    }
+  } catch (...) {
+    source->Close();
+    throw;
+  }
+  source->Close();
+  for (PushOperator *op : pipeline.operators_) {
+    op->Finish();
+  }
+}
+
+}  // namespace bustub
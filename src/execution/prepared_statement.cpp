@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prepared_statement.cpp
+//
+// Identification: src/execution/prepared_statement.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/prepared_statement.h"
+
+#include <utility>
+
+namespace bustub {
+
+PreparedStatement::PreparedStatement(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                     std::unique_ptr<AbstractExecutor> &&executor,
+                                     std::vector<ConstantValueExpression *> parameters)
+    : exec_ctx_(exec_ctx), parameters_(std::move(parameters)), cursor_(plan, std::move(executor)) {}
+
+void PreparedStatement::Bind(size_t param_idx, const Value &value) {
+  BUSTUB_ASSERT(param_idx < parameters_.size(), "No such parameter.");
+  parameters_[param_idx]->SetValue(value);
+}
+
+ResultCursor *PreparedStatement::Open(Transaction *txn) {
+  // The last execution is closed in its own transaction.
+  cursor_.Close();
+  exec_ctx_->SetTransaction(txn);
+  cursor_.Open();
+  return &cursor_;
+}
+
+void PreparedStatement::Execute(Transaction *txn, std::vector<Tuple> *result_set) {
+  ResultCursor *cursor = Open(txn);
+  while (cursor->NextBatch(&batch_)) {
+    if (result_set != nullptr) {
+      result_set->insert(result_set->end(), batch_.GetTuples().begin(), batch_.GetTuples().end());
+    }
+  }
+}
+
+}  // namespace bustub
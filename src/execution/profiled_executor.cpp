@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// profiled_executor.cpp
+//
+// Identification: src/execution/profiled_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/profiled_executor.h"
+
+#include <ctime>
+#include <utility>
+
+namespace bustub {
+
+ProfiledExecutor::ProfiledExecutor(ExecutorContext *exec_ctx, OperatorProfile *profile,
+                                   std::unique_ptr<AbstractExecutor> &&executor)
+    : AbstractExecutor(exec_ctx), executor_(std::move(executor)), profile_(profile) {
+  profile_->num_instances_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ProfiledExecutor::Start ProfiledExecutor::Now() {
+  timespec cpu;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+  return {std::chrono::steady_clock::now(), static_cast<uint64_t>(cpu.tv_sec) * 1000000000 + cpu.tv_nsec,
+          BufferPoolManager::GetThreadFetchStats()};
+}
+
+void ProfiledExecutor::AddSince(const Start &start, std::atomic<uint64_t> *wall_ns, std::atomic<uint64_t> *cpu_ns) {
+  const Start end = Now();
+  wall_ns->fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end.wall_ - start.wall_).count(),
+                     std::memory_order_relaxed);
+  cpu_ns->fetch_add(end.cpu_ns_ - start.cpu_ns_, std::memory_order_relaxed);
+  profile_->num_fetches_.fetch_add(end.fetches_.num_fetches_ - start.fetches_.num_fetches_,
+                                   std::memory_order_relaxed);
+  profile_->num_hits_.fetch_add(end.fetches_.num_hits_ - start.fetches_.num_hits_, std::memory_order_relaxed);
+}
+
+void ProfiledExecutor::Init() {
+  const Start start = Now();
+  executor_->Init();
+  AddSince(start, &profile_->init_wall_ns_, &profile_->init_cpu_ns_);
+}
+
+bool ProfiledExecutor::Next(Tuple *tuple, RID *rid) {
+  const Start start = Now();
+  const bool produced = executor_->Next(tuple, rid);
+  AddSince(start, &profile_->next_wall_ns_, &profile_->next_cpu_ns_);
+  if (produced) {
+    profile_->num_tuples_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return produced;
+}
+
+bool ProfiledExecutor::NextBatch(TupleBatch *batch) {
+  const Start start = Now();
+  const bool produced = executor_->NextBatch(batch);
+  AddSince(start, &profile_->next_wall_ns_, &profile_->next_cpu_ns_);
+  profile_->num_tuples_.fetch_add(batch->Size(), std::memory_order_relaxed);
+  return produced;
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// query_profile.cpp
+//
+// Identification: src/execution/query_profile.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/query_profile.h"
+
+#include <iomanip>
+
+namespace bustub {
+
+namespace {
+
+/** @return nanoseconds as milliseconds */
+double Millis(uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+/** @return what is left of total once part is taken away, 0 if part is larger */
+uint64_t Remainder(uint64_t total, uint64_t part) { return total > part ? total - part : 0; }
+
+}  // namespace
+
+std::string QueryProfile::ToString(const AbstractPlanNode *plan) {
+  std::ostringstream out;
+  Totals totals;
+  Print(plan, 0, &out, &totals);
+  return out.str();
+}
+
+void QueryProfile::Print(const AbstractPlanNode *plan, size_t depth, std::ostringstream *out,
+                         Totals *parent_totals) {
+  // The children first, whose totals the operator's own time and pages are what is left of.
+  std::ostringstream children_out;
+  Totals children_totals;
+  for (const AbstractPlanNode *child : plan->GetChildren()) {
+    Print(child, depth + 1, &children_out, &children_totals);
+  }
+
+  *out << std::string(2 * depth, ' ') << PlanTypeName(plan->GetType());
+  OperatorProfile *profile = nullptr;
+  {
+    std::scoped_lock latch(latch_);
+    auto iter = operators_.find(plan);
+    if (iter != operators_.end()) {
+      profile = &iter->second;
+    }
+  }
+  Totals totals = children_totals;
+  if (profile == nullptr) {
+    // An exchange, a scan fused into the aggregation above it, or a plan that was never executed.
+    *out << " (not profiled)\n";
+  } else {
+    const uint64_t init_wall_ns = profile->init_wall_ns_.load(std::memory_order_relaxed);
+    totals.wall_ns_ = init_wall_ns + profile->next_wall_ns_.load(std::memory_order_relaxed);
+    totals.cpu_ns_ = profile->init_cpu_ns_.load(std::memory_order_relaxed) +
+                     profile->next_cpu_ns_.load(std::memory_order_relaxed);
+    totals.num_fetches_ = profile->num_fetches_.load(std::memory_order_relaxed);
+    totals.num_hits_ = profile->num_hits_.load(std::memory_order_relaxed);
+    *out << std::fixed << std::setprecision(3) << " (rows=" << profile->num_tuples_.load(std::memory_order_relaxed)
+         << " loops=" << profile->num_instances_.load(std::memory_order_relaxed)
+         << " time=" << Millis(totals.wall_ns_) << "ms"
+         << " self=" << Millis(Remainder(totals.wall_ns_, children_totals.wall_ns_)) << "ms"
+         << " cpu=" << Millis(totals.cpu_ns_) << "ms"
+         << " self_cpu=" << Millis(Remainder(totals.cpu_ns_, children_totals.cpu_ns_)) << "ms"
+         << " init=" << Millis(init_wall_ns) << "ms"
+         << " pages=" << Remainder(totals.num_fetches_, children_totals.num_fetches_)
+         << " hits=" << Remainder(totals.num_hits_, children_totals.num_hits_)
+         << ")\n";
+  }
+  *out << children_out.str();
+
+  parent_totals->wall_ns_ += totals.wall_ns_;
+  parent_totals->cpu_ns_ += totals.cpu_ns_;
+  parent_totals->num_fetches_ += totals.num_fetches_;
+  parent_totals->num_hits_ += totals.num_hits_;
+}
+
+}  // namespace bustub
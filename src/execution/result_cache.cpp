@@ -0,0 +1,345 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.cpp
+//
+// Identification: src/execution/result_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/result_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/expressions/row_id_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/materialize_plan.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "type/type.h"
+
+namespace bustub {
+
+namespace {
+
+/** Writes a plan out as its fingerprint, and collects the tables it reads. */
+class Fingerprinter {
+ public:
+  explicit Fingerprinter(Catalog *catalog, std::string *out) : catalog_(catalog), out_(out) {}
+
+  /** @return false if the plan is not cached */
+  bool AppendPlan(const AbstractPlanNode *plan) {
+    Append(plan->GetType());
+    Append(plan->GetChildren().size());
+    if (!AppendSchema(plan->OutputSchema())) {
+      return false;
+    }
+    switch (plan->GetType()) {
+      case PlanType::SeqScan: {
+        const auto *scan = static_cast<const SeqScanPlanNode *>(plan);
+        Append(scan->GetTableOid());
+        Append(scan->GetSample().method_);
+        Append(scan->GetSample().fraction_);
+        Append(scan->GetSample().seed_);
+        AddTable(catalog_->GetTable(scan->GetTableOid()));
+        if (!AppendExpression(scan->GetPredicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::IndexScan: {
+        const auto *scan = static_cast<const IndexScanPlanNode *>(plan);
+        Append(scan->GetIndexOid());
+        Append(scan->FetchesInPageOrder());
+        AppendBound(scan->GetLowerBound());
+        AppendBound(scan->GetUpperBound());
+        AddTable(catalog_->GetTable(catalog_->GetIndex(scan->GetIndexOid())->table_name_));
+        if (!AppendExpression(scan->GetPredicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::Aggregation: {
+        const auto *aggregation = static_cast<const AggregationPlanNode *>(plan);
+        for (AggregationType agg_type : aggregation->GetAggregateTypes()) {
+          Append(agg_type);
+        }
+        if (!AppendExpression(aggregation->GetHaving()) || !AppendExpressions(aggregation->GetGroupBys()) ||
+            !AppendExpressions(aggregation->GetAggregates())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::Limit: {
+        const auto *limit = static_cast<const LimitPlanNode *>(plan);
+        Append(limit->GetLimit());
+        Append(limit->GetOffset());
+        break;
+      }
+      case PlanType::NestedLoopJoin: {
+        if (!AppendExpression(static_cast<const NestedLoopJoinPlanNode *>(plan)->Predicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::NestedIndexJoin: {
+        const auto *join = static_cast<const NestedIndexJoinPlanNode *>(plan);
+        Append(join->GetInnerTableOid());
+        AppendString(join->GetIndexName());
+        AddTable(catalog_->GetTable(join->GetInnerTableOid()));
+        if (!AppendSchema(join->OuterTableSchema()) || !AppendSchema(join->InnerTableSchema()) ||
+            !AppendExpression(join->Predicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::HashJoin: {
+        const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+        Append(join->GetJoinType());
+        if (!AppendExpressions(join->GetLeftKeys()) || !AppendExpressions(join->GetRightKeys()) ||
+            !AppendExpression(join->Predicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::MergeJoin: {
+        const auto *join = static_cast<const MergeJoinPlanNode *>(plan);
+        if (!AppendExpressions(join->GetLeftKeys()) || !AppendExpressions(join->GetRightKeys()) ||
+            !AppendExpression(join->Predicate())) {
+          return false;
+        }
+        break;
+      }
+      case PlanType::Materialize: {
+        const auto *materialize = static_cast<const MaterializePlanNode *>(plan);
+        Append(materialize->GetTableOid());
+        Append(materialize->GetRowIdColIdx());
+        AddTable(catalog_->GetTable(materialize->GetTableOid()));
+        break;
+      }
+      case PlanType::Sort: {
+        for (const OrderBy &order_by : static_cast<const SortPlanNode *>(plan)->GetOrderBys()) {
+          Append(order_by.second);
+          if (!AppendExpression(order_by.first)) {
+            return false;
+          }
+        }
+        break;
+      }
+      case PlanType::Exchange:
+        // The number of workers changes the order of the tuples at most.
+        break;
+      case PlanType::Insert:
+      case PlanType::Update:
+      case PlanType::Delete:
+      case PlanType::ViewScan:
+        return false;
+    }
+    return std::all_of(plan->GetChildren().begin(), plan->GetChildren().end(),
+                       [this](const AbstractPlanNode *child) { return AppendPlan(child); });
+  }
+
+  /** @return the tables read, each once */
+  std::vector<TableHeap *> TakeTables() {
+    std::sort(tables_.begin(), tables_.end());
+    tables_.erase(std::unique(tables_.begin(), tables_.end()), tables_.end());
+    return std::move(tables_);
+  }
+
+ private:
+  template <typename T>
+  void Append(T field) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &field, sizeof(T));
+    out_->append(bytes, sizeof(T));
+  }
+
+  void AppendString(const std::string &str) {
+    Append(str.size());
+    out_->append(str);
+  }
+
+  void AppendValue(const Value &value) {
+    Append(value.GetTypeId());
+    Append(value.IsNull());
+    if (value.IsNull()) {
+      return;
+    }
+    const size_t size = value.GetTypeId() == TypeId::VARCHAR ? sizeof(uint32_t) + value.GetLength()
+                                                               : Type::GetTypeSize(value.GetTypeId());
+    const size_t offset = out_->size();
+    out_->resize(offset + size);
+    value.SerializeTo(out_->data() + offset);
+  }
+
+  void AppendBound(const std::optional<Value> &bound) {
+    Append(bound.has_value());
+    if (bound.has_value()) {
+      AppendValue(*bound);
+    }
+  }
+
+  bool AppendSchema(const Schema *schema) {
+    Append(schema->GetColumnCount());
+    return std::all_of(schema->GetColumns().begin(), schema->GetColumns().end(), [this](const Column &column) {
+      Append(column.GetType());
+      return AppendExpression(column.GetExpr());
+    });
+  }
+
+  bool AppendExpressions(const std::vector<const AbstractExpression *> &exprs) {
+    Append(exprs.size());
+    return std::all_of(exprs.begin(), exprs.end(), [this](const AbstractExpression *expr) {
+      return AppendExpression(expr);
+    });
+  }
+
+  bool AppendExpression(const AbstractExpression *expr) {
+    if (expr == nullptr) {
+      Append('N');
+      return true;
+    }
+    if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+      Append('C');
+      Append(column->GetTupleIdx());
+      Append(column->GetColIdx());
+    } else if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+      Append('K');
+      AppendValue(constant->GetValue());
+    } else if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr); comparison != nullptr) {
+      Append('P');
+      Append(comparison->GetComparisonType());
+    } else if (const auto *logic = dynamic_cast<const LogicExpression *>(expr); logic != nullptr) {
+      Append('L');
+      Append(logic->GetLogicType());
+    } else if (const auto *aggregate = dynamic_cast<const AggregateValueExpression *>(expr); aggregate != nullptr) {
+      Append('A');
+      Append(aggregate->IsGroupByTerm());
+      Append(aggregate->GetTermIdx());
+    } else if (const auto *row_id = dynamic_cast<const RowIdExpression *>(expr); row_id != nullptr) {
+      Append('R');
+      Append(row_id->GetTupleIdx());
+    } else {
+      return false;
+    }
+    Append(expr->GetReturnType());
+    return AppendExpressions(expr->GetChildren());
+  }
+
+  /** Adds the heap of a table, or those of its partitions. */
+  void AddTable(TableMetadata *table_metadata) {
+    if (table_metadata->IsPartitioned()) {
+      for (TableMetadata *partition : table_metadata->partitions_) {
+        AddTable(partition);
+      }
+      return;
+    }
+    tables_.push_back(table_metadata->table_.get());
+  }
+
+  Catalog *catalog_;
+  std::string *out_;
+  std::vector<TableHeap *> tables_;
+};
+
+}  // namespace
+
+ResultCache::ResultCache(size_t capacity) : capacity_(capacity) {
+  MetricsRegistry *registry = MetricsRegistry::Global();
+  registry->RegisterCounter(this, "result_cache.hits", &num_hits_);
+  registry->RegisterCounter(this, "result_cache.misses", &num_misses_);
+  registry->RegisterCounter(this, "result_cache.invalidations", &num_invalidations_);
+  registry->RegisterCounter(this, "result_cache.bytes", [this] { return GetSize(); });
+}
+
+ResultCache::~ResultCache() { MetricsRegistry::Global()->Unregister(this); }
+
+bool ResultCache::MakeKey(const AbstractPlanNode *plan, Catalog *catalog, Transaction *txn, Key *key) {
+  if (!txn->ReadsVersions() || txn->IsOptimistic()) {
+    return false;
+  }
+  key->fingerprint_.clear();
+  key->tables_.clear();
+  Fingerprinter fingerprinter(catalog, &key->fingerprint_);
+  if (!fingerprinter.AppendPlan(plan)) {
+    return false;
+  }
+  for (TableHeap *table : fingerprinter.TakeTables()) {
+    const timestamp_t last_commit_ts = table->GetLastCommitTs();
+    if (last_commit_ts > txn->GetReadTs()) {
+      return false;
+    }
+    key->tables_.emplace_back(table, last_commit_ts);
+  }
+  return true;
+}
+
+bool ResultCache::Lookup(const Key &key, std::vector<Tuple> *result_set) {
+  std::scoped_lock latch(latch_);
+  auto iter = entries_.find(key.fingerprint_);
+  if (iter == entries_.end()) {
+    num_misses_.Add();
+    return false;
+  }
+  if (iter->second.tables_ != key.tables_) {
+    // A table was written since, or the plan reads the tables of another catalog.
+    Erase(iter);
+    num_invalidations_.Add();
+    num_misses_.Add();
+    return false;
+  }
+  num_hits_.Add();
+  lru_.splice(lru_.begin(), lru_, iter->second.lru_iter_);
+  if (result_set != nullptr) {
+    result_set->insert(result_set->end(), iter->second.result_.begin(), iter->second.result_.end());
+  }
+  return true;
+}
+
+void ResultCache::Insert(Key &&key, const std::vector<Tuple> &result) {
+  size_t size = key.fingerprint_.size() + result.size() * sizeof(Tuple);
+  for (const Tuple &tuple : result) {
+    size += tuple.GetLength();
+  }
+  if (size > capacity_) {
+    return;
+  }
+  std::scoped_lock latch(latch_);
+  if (auto iter = entries_.find(key.fingerprint_); iter != entries_.end()) {
+    Erase(iter);
+  }
+  while (size_ + size > capacity_) {
+    Erase(entries_.find(lru_.back()));
+  }
+  lru_.push_front(key.fingerprint_);
+  entries_.emplace(std::move(key.fingerprint_), Entry{std::move(key.tables_), result, size, lru_.begin()});
+  size_ += size;
+}
+
+size_t ResultCache::GetSize() {
+  std::scoped_lock latch(latch_);
+  return size_;
+}
+
+void ResultCache::Erase(std::unordered_map<std::string, Entry>::iterator iter) {
+  size_ -= iter->second.size_;
+  lru_.erase(iter->second.lru_iter_);
+  entries_.erase(iter);
+}
+
+}  // namespace bustub
@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cursor.cpp
+//
+// Identification: src/execution/result_cursor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/result_cursor.h"
+
+#include <utility>
+
+namespace bustub {
+
+ResultCursor::ResultCursor(const AbstractPlanNode *plan, std::unique_ptr<AbstractExecutor> &&executor)
+    : num_spilling_operators_(MemoryBroker::CountSpillingOperators(plan)), executor_(std::move(executor)) {}
+
+ResultCursor::~ResultCursor() { Close(); }
+
+bool ResultCursor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  // The tuples Next read ahead go first, so that the two can be mixed.
+  while (next_tuple_ < batch_.Size() && !batch->IsFull()) {
+    batch->Emplace(batch_.GetRID(next_tuple_), batch_.GetTuple(next_tuple_));
+    next_tuple_++;
+  }
+  if (!batch->IsEmpty() || done_) {
+    return !batch->IsEmpty();
+  }
+  try {
+    if (executor_->NextBatch(batch)) {
+      return true;
+    }
+  } catch (...) {
+    Finish();
+    throw;
+  }
+  Finish();
+  return false;
+}
+
+bool ResultCursor::Next(Tuple *tuple) {
+  if (next_tuple_ == batch_.Size()) {
+    next_tuple_ = 0;
+    if (done_) {
+      batch_.Clear();
+      return false;
+    }
+    bool produced;
+    try {
+      produced = executor_->NextBatch(&batch_);
+    } catch (...) {
+      Finish();
+      throw;
+    }
+    if (!produced) {
+      Finish();
+      return false;
+    }
+  }
+  *tuple = batch_.GetTuple(next_tuple_++);
+  return true;
+}
+
+void ResultCursor::Open() {
+  Close();
+  ExecutorContext *exec_ctx = executor_->GetExecutorContext();
+  exec_ctx->AdmitQuery(num_spilling_operators_);
+  done_ = false;
+  try {
+    executor_->Init();
+  } catch (...) {
+    Finish();
+    throw;
+  }
+}
+
+void ResultCursor::Close() {
+  if (!done_) {
+    Finish();
+  }
+  batch_.Clear();
+  next_tuple_ = 0;
+}
+
+void ResultCursor::Finish() {
+  done_ = true;
+  ExecutorContext *exec_ctx = executor_->GetExecutorContext();
+  try {
+    executor_->Close();
+  } catch (...) {
+    exec_ctx->ReleaseQuery();
+    throw;
+  }
+  exec_ctx->ReleaseQuery();
+}
+
+}  // namespace bustub
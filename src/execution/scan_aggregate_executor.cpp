@@ -0,0 +1,337 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// scan_aggregate_executor.cpp
+//
+// Identification: src/execution/scan_aggregate_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/scan_aggregate_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "type/limits.h"
+#include "type/typed_kernels.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Finds the column of the table that an expression on the output of a scan reads.
+ * @param[out] col_idx the index of the column in the schema of the table
+ * @return false if the expression is not an inlined column of the table of type type
+ */
+bool ResolveColumn(const AbstractExpression *expr, const SeqScanPlanNode *scan_plan, const Schema &table_schema,
+                   TypeId type, uint32_t *col_idx) {
+  const auto *output_expr = dynamic_cast<const ColumnValueExpression *>(expr);
+  if (output_expr == nullptr || output_expr->GetTupleIdx() != 0 ||
+      output_expr->GetColIdx() >= scan_plan->OutputSchema()->GetColumnCount()) {
+    return false;
+  }
+  const AbstractExpression *scanned = scan_plan->OutputSchema()->GetColumn(output_expr->GetColIdx()).GetExpr();
+  const auto *table_expr = dynamic_cast<const ColumnValueExpression *>(scanned);
+  if (table_expr == nullptr || table_expr->GetTupleIdx() != 0) {
+    return false;
+  }
+  const Column &column = table_schema.GetColumn(table_expr->GetColIdx());
+  if (!column.IsInlined() || column.GetType() != type || expr->GetReturnType() != type) {
+    return false;
+  }
+  *col_idx = table_expr->GetColIdx();
+  return true;
+}
+
+/** Adds to a count or a sum, with the overflow checks of an INTEGER value. */
+inline void AddChecked(int64_t *state, int64_t input) {
+  *state += input;
+  if (*state > BUSTUB_INT32_MAX || *state < BUSTUB_INT32_MIN) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+  }
+}
+
+}  // namespace
+
+template <typename KeyType>
+ScanAggregateExecutor<KeyType>::ScanAggregateExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                                      std::unique_ptr<SeqScanExecutor> &&scan)
+    : AbstractExecutor(exec_ctx), plan_(plan), scan_(std::move(scan)), has_key_(!plan->GetGroupBys().empty()) {
+  const auto *scan_plan = dynamic_cast<const SeqScanPlanNode *>(plan_->GetChildPlan());
+  const Schema &table_schema = exec_ctx->GetCatalog()->GetTable(scan_plan->GetTableOid())->schema_;
+  uint32_t col_idx = 0;
+  if (has_key_) {
+    key_type_ = plan_->GetGroupBys()[0]->GetReturnType();
+    bool resolved = ResolveColumn(plan_->GetGroupBys()[0], scan_plan, table_schema, key_type_, &col_idx);
+    BUSTUB_ASSERT(resolved, "The group-by must be a column of the table.");
+    key_offset_ = table_schema.GetColumn(col_idx).GetOffset();
+  }
+  for (size_t i = 0; i < plan_->GetAggregates().size(); i++) {
+    bool resolved = ResolveColumn(plan_->GetAggregates()[i], scan_plan, table_schema, TypeId::INTEGER, &col_idx);
+    BUSTUB_ASSERT(resolved, "The aggregate inputs must be INTEGER columns of the table.");
+    input_offsets_.push_back(table_schema.GetColumn(col_idx).GetOffset());
+    switch (plan_->GetAggregateTypes()[i]) {
+      case AggregationType::CountAggregate:
+      case AggregationType::SumAggregate:
+        initial_states_.push_back(0);
+        break;
+      case AggregationType::MinAggregate:
+        initial_states_.push_back(BUSTUB_INT32_MAX);
+        break;
+      case AggregationType::MaxAggregate:
+        initial_states_.push_back(BUSTUB_INT32_MIN);
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        UNREACHABLE("Distinct counts are not supported by the executor.");
+    }
+  }
+}
+
+template <typename KeyType>
+void ScanAggregateExecutor<KeyType>::Init() {
+  slots_.assign(INITIAL_SLOTS, NO_GROUP);
+  keys_.clear();
+  states_.clear();
+  nulls_.clear();
+  next_group_ = 0;
+  scan_->Init();
+  scan_->Drain(this);
+}
+
+template <typename KeyType>
+void ScanAggregateExecutor<KeyType>::Close() {
+  slots_.clear();
+  keys_.clear();
+  states_.clear();
+  nulls_.clear();
+  next_group_ = 0;
+  scan_->Close();
+}
+
+template <typename KeyType>
+size_t ScanAggregateExecutor<KeyType>::SlotOf(KeyType key, size_t mask) {
+  // Fibonacci hashing: the high bits of the product depend on all the bits of the key.
+  return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL >> 32) & mask;
+}
+
+template <typename KeyType>
+uint32_t ScanAggregateExecutor<KeyType>::FindGroup(KeyType key) {
+  if ((keys_.size() + 1) * 2 > slots_.size()) {
+    Grow();
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = SlotOf(key, mask);; i = (i + 1) & mask) {
+    if (slots_[i] == NO_GROUP) {
+      slots_[i] = keys_.size();
+      keys_.push_back(key);
+      states_.insert(states_.end(), initial_states_.begin(), initial_states_.end());
+      nulls_.resize(nulls_.size() + initial_states_.size(), 0);
+      return slots_[i];
+    }
+    if (keys_[slots_[i]] == key) {
+      return slots_[i];
+    }
+  }
+}
+
+template <typename KeyType>
+void ScanAggregateExecutor<KeyType>::Grow() {
+  slots_.assign(slots_.size() * 2, NO_GROUP);
+  const size_t mask = slots_.size() - 1;
+  for (uint32_t group = 0; group < keys_.size(); group++) {
+    size_t i = SlotOf(keys_[group], mask);
+    while (slots_[i] != NO_GROUP) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = group;
+  }
+}
+
+template <typename KeyType>
+void ScanAggregateExecutor<KeyType>::Consume(const std::vector<Tuple> &candidates) {
+  groups_.resize(candidates.size());
+  if (has_key_) {
+    for (size_t i = 0; i < candidates.size(); i++) {
+      groups_[i] = FindGroup(LoadNative<KeyType>(candidates[i].GetData(), key_offset_));
+    }
+  } else {
+    std::fill(groups_.begin(), groups_.end(), FindGroup(KeyType{}));
+  }
+  for (uint32_t agg_idx = 0; agg_idx < input_offsets_.size(); agg_idx++) {
+    switch (plan_->GetAggregateTypes()[agg_idx]) {
+      case AggregationType::CountAggregate:
+        Fold<AggregationType::CountAggregate>(agg_idx, candidates);
+        break;
+      case AggregationType::SumAggregate:
+        Fold<AggregationType::SumAggregate>(agg_idx, candidates);
+        break;
+      case AggregationType::MinAggregate:
+        Fold<AggregationType::MinAggregate>(agg_idx, candidates);
+        break;
+      case AggregationType::MaxAggregate:
+        Fold<AggregationType::MaxAggregate>(agg_idx, candidates);
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        break;
+    }
+  }
+}
+
+template <typename KeyType>
+template <AggregationType Type>
+void ScanAggregateExecutor<KeyType>::Fold(uint32_t agg_idx, const std::vector<Tuple> &candidates) {
+  const size_t num_aggs = input_offsets_.size();
+  const uint32_t offset = input_offsets_[agg_idx];
+  int64_t *states = states_.data() + agg_idx;
+  char *nulls = nulls_.data() + agg_idx;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const size_t group = groups_[i] * num_aggs;
+    if constexpr (Type == AggregationType::CountAggregate) {
+      // Count increases by one, whatever the input.
+      AddChecked(&states[group], 1);
+      continue;
+    }
+    const int32_t input = LoadNative<int32_t>(candidates[i].GetData(), offset);
+    if (input == NativeNull<int32_t>()) {
+      nulls[group] = 1;
+      continue;
+    }
+    if constexpr (Type == AggregationType::SumAggregate) {
+      AddChecked(&states[group], input);
+    } else if constexpr (Type == AggregationType::MinAggregate) {
+      states[group] = std::min<int64_t>(states[group], input);
+    } else if constexpr (Type == AggregationType::MaxAggregate) {
+      states[group] = std::max<int64_t>(states[group], input);
+    }
+  }
+}
+
+template <typename KeyType>
+bool ScanAggregateExecutor<KeyType>::NextGroup(std::vector<Value> *values) {
+  const AbstractExpression *having = plan_->GetHaving();
+  const size_t num_aggs = input_offsets_.size();
+  AggregateKey key;
+  AggregateValue val;
+  for (; next_group_ < keys_.size(); next_group_++) {
+    key.group_bys_.clear();
+    if (has_key_) {
+      key.group_bys_.push_back(Value::DeserializeFrom(reinterpret_cast<const char *>(&keys_[next_group_]), key_type_));
+    }
+    val.aggregates_.clear();
+    for (size_t i = 0; i < num_aggs; i++) {
+      const size_t state = next_group_ * num_aggs + i;
+      val.aggregates_.push_back(nulls_[state] != 0
+                                    ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                    : ValueFactory::GetIntegerValue(static_cast<int32_t>(states_[state])));
+    }
+    if (having != nullptr && !having->EvaluateAggregate(key.group_bys_, val.aggregates_).GetAs<bool>()) {
+      continue;
+    }
+    values->clear();
+    for (const Column &column : GetOutputSchema()->GetColumns()) {
+      values->emplace_back(column.GetExpr()->EvaluateAggregate(key.group_bys_, val.aggregates_));
+    }
+    next_group_++;
+    return true;
+  }
+  return false;
+}
+
+template <typename KeyType>
+bool ScanAggregateExecutor<KeyType>::Next(Tuple *tuple, RID *rid) {
+  std::vector<Value> values;
+  if (!NextGroup(&values)) {
+    return false;
+  }
+  *tuple = Tuple(std::move(values), GetOutputSchema());
+  return true;
+}
+
+template <typename KeyType>
+bool ScanAggregateExecutor<KeyType>::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  std::vector<Value> values;
+  while (!batch->IsFull() && NextGroup(&values)) {
+    batch->Append(RID(), values, GetOutputSchema());
+  }
+  return !batch->IsEmpty();
+}
+
+std::unique_ptr<AbstractExecutor> CreateScanAggregateExecutor(ExecutorContext *exec_ctx,
+                                                              const AggregationPlanNode *plan) {
+  if (plan->GetChildPlan()->GetType() != PlanType::SeqScan || plan->GetGroupBys().size() > 1 ||
+      std::any_of(plan->GetAggregateTypes().begin(), plan->GetAggregateTypes().end(), IsDistinctAggregate)) {
+    return nullptr;
+  }
+  const auto *scan_plan = dynamic_cast<const SeqScanPlanNode *>(plan->GetChildPlan());
+  TableMetadata *table_info = exec_ctx->GetCatalog()->GetTable(scan_plan->GetTableOid());
+  uint32_t col_idx;
+  for (const AbstractExpression *aggregate : plan->GetAggregates()) {
+    if (!ResolveColumn(aggregate, scan_plan, table_info->schema_, TypeId::INTEGER, &col_idx)) {
+      return nullptr;
+    }
+  }
+  TypeId key_type = TypeId::TINYINT;
+  uint64_t num_groups = 1;
+  if (!plan->GetGroupBys().empty()) {
+    key_type = plan->GetGroupBys()[0]->GetReturnType();
+    if (!ResolveColumn(plan->GetGroupBys()[0], scan_plan, table_info->schema_, key_type, &col_idx)) {
+      return nullptr;
+    }
+    // The statistics know nothing of a table that was neither analyzed nor inserted into, but a narrow key has few
+    // values anyway.
+    const TableStatistics &stats = table_info->stats_;
+    uint64_t num_distinct = UINT64_MAX;
+    if (stats.IsAnalyzed() || stats.GetRowCount() > 0) {
+      num_distinct = stats.GetDistinctCount(col_idx);
+    }
+    const size_t key_bits = Type::GetTypeSize(key_type) * 8;
+    if (key_bits <= 16) {
+      num_distinct = std::min<uint64_t>(num_distinct, uint64_t{1} << key_bits);
+    }
+    if (num_distinct == UINT64_MAX) {
+      return nullptr;
+    }
+    // A group per distinct value and one for NULL, twice over, as the estimate may fall short.
+    num_groups = 2 * (num_distinct + 1);
+  }
+  const size_t group_bytes = Type::GetTypeSize(key_type) + 2 * sizeof(uint32_t) +
+                             plan->GetAggregates().size() * (sizeof(int64_t) + sizeof(char));
+  if (num_groups * group_bytes > exec_ctx->GetMemoryBudget()) {
+    return nullptr;
+  }
+  auto scan = std::make_unique<SeqScanExecutor>(exec_ctx, scan_plan);
+  switch (key_type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return std::make_unique<ScanAggregateExecutor<int8_t>>(exec_ctx, plan, std::move(scan));
+    case TypeId::SMALLINT:
+      return std::make_unique<ScanAggregateExecutor<int16_t>>(exec_ctx, plan, std::move(scan));
+    case TypeId::INTEGER:
+      return std::make_unique<ScanAggregateExecutor<int32_t>>(exec_ctx, plan, std::move(scan));
+    case TypeId::BIGINT:
+      return std::make_unique<ScanAggregateExecutor<int64_t>>(exec_ctx, plan, std::move(scan));
+    case TypeId::TIMESTAMP:
+      return std::make_unique<ScanAggregateExecutor<uint64_t>>(exec_ctx, plan, std::move(scan));
+    default:
+      return nullptr;
+  }
+}
+
+template class ScanAggregateExecutor<int8_t>;
+template class ScanAggregateExecutor<int16_t>;
+template class ScanAggregateExecutor<int32_t>;
+template class ScanAggregateExecutor<int64_t>;
+template class ScanAggregateExecutor<uint64_t>;
+
+}  // namespace bustub
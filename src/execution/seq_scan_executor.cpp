@@ -1,22 +1,549 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include "execution/executors/seq_scan_executor.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
-
-void SeqScanExecutor::Init() {}
-
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/seq_scan_executor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "execution/executors/hash_join_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "storage/table/toast.h"
+
+namespace bustub {
+
+namespace {
+/** @return the comparison of b with a that is equivalent to the comparison of a with b */
+ComparisonType Commute(ComparisonType comparison_type) {
+  switch (comparison_type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comparison_type;
+  }
+}
+}  // namespace
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      table_info_(exec_ctx->GetCatalog()->GetTable(plan->GetTableOid())),
+      compiled_predicate_(plan->GetPredicate() == nullptr
+                              ? nullptr
+                              : CompiledPredicate::Compile(plan->GetPredicate(), &table_info_->schema_)),
+      ring_(std::clamp<size_t>(exec_ctx->GetBufferPoolManager()->GetPoolSize() / 8, 2, SEQ_SCAN_BUFFER_RING_SIZE)) {
+  std::vector<uint32_t> col_idxs;
+  if (plan->GetPredicate() != nullptr) {
+    ColumnValueExpression::CollectColumns(plan->GetPredicate(), &col_idxs);
+  }
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    ColumnValueExpression::CollectColumns(column.GetExpr(), &col_idxs);
+  }
+  std::copy_if(col_idxs.begin(), col_idxs.end(), std::back_inserter(toast_columns_),
+               [this](uint32_t col_idx) { return !table_info_->schema_.GetColumn(col_idx).IsInlined(); });
+  scan_columns_ = std::move(col_idxs);
+
+  // A comparison of a column with a constant can rule out pages by the zone map, with the column on the left.
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(plan->GetPredicate());
+  if (comparison != nullptr) {
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+    const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+    comparison_type_ = comparison->GetComparisonType();
+    if (column == nullptr) {
+      column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+      constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+      comparison_type_ = Commute(comparison_type_);
+    }
+    if (column != nullptr && constant != nullptr) {
+      comparison_column_ = column;
+      comparison_constant_ = constant;
+    }
+  }
+}
+
+void SeqScanExecutor::LockTable(ExecutorContext *exec_ctx, table_oid_t table_oid) {
+  // A snapshot or an optimistic transaction reads without locks.
+  if (exec_ctx->GetTransaction()->ReadsVersions()) {
+    return;
+  }
+  switch (exec_ctx->GetTransaction()->GetIsolationLevel()) {
+    case IsolationLevel::REPEATABLE_READ:
+      exec_ctx->LockTable(table_oid, LockMode::SHARED);
+      break;
+    case IsolationLevel::READ_COMMITTED:
+      exec_ctx->LockTable(table_oid, LockMode::INTENTION_SHARED);
+      break;
+    case IsolationLevel::READ_UNCOMMITTED:
+      break;
+  }
+}
+
+std::vector<TableMetadata *> SeqScanExecutor::ScanTables(Catalog *catalog, const SeqScanPlanNode *plan) {
+  TableMetadata *table_info = catalog->GetTable(plan->GetTableOid());
+  if (!table_info->IsPartitioned()) {
+    return {table_info};
+  }
+  std::vector<bool> candidates(table_info->partitions_.size(), true);
+  if (plan->GetPredicate() != nullptr) {
+    PrunePartitions(plan->GetPredicate(), *table_info->partition_scheme_, &candidates);
+  }
+  std::vector<TableMetadata *> tables;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (candidates[i]) {
+      tables.push_back(table_info->partitions_[i]);
+    }
+  }
+  return tables;
+}
+
+void SeqScanExecutor::PrunePartitions(const AbstractExpression *predicate, const PartitionScheme &scheme,
+                                      std::vector<bool> *candidates) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(predicate); logic != nullptr) {
+    if (logic->GetLogicType() == LogicType::And) {
+      PrunePartitions(logic->GetChildAt(0), scheme, candidates);
+      PrunePartitions(logic->GetChildAt(1), scheme, candidates);
+      return;
+    }
+    // A tuple satisfies a disjunction in the partitions of either side.
+    std::vector<bool> left(candidates->size(), true);
+    std::vector<bool> right(candidates->size(), true);
+    PrunePartitions(logic->GetChildAt(0), scheme, &left);
+    PrunePartitions(logic->GetChildAt(1), scheme, &right);
+    for (size_t i = 0; i < candidates->size(); i++) {
+      (*candidates)[i] = (*candidates)[i] && (left[i] || right[i]);
+    }
+    return;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return;
+  }
+  ComparisonType comparison_type = comparison->GetComparisonType();
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    comparison_type = Commute(comparison_type);
+  }
+  if (column == nullptr || constant == nullptr || column->GetColIdx() != scheme.GetColIdx()) {
+    return;
+  }
+  const Value &value = constant->GetValue();
+  if (value.IsNull()) {
+    // A NULL satisfies no comparison.
+    candidates->assign(candidates->size(), false);
+    return;
+  }
+  switch (comparison_type) {
+    case ComparisonType::Equal:
+      scheme.Prune(&value, &value, candidates);
+      break;
+    case ComparisonType::LessThan:
+    case ComparisonType::LessThanOrEqual:
+      scheme.Prune(nullptr, &value, candidates);
+      break;
+    case ComparisonType::GreaterThan:
+    case ComparisonType::GreaterThanOrEqual:
+      scheme.Prune(&value, nullptr, candidates);
+      break;
+    case ComparisonType::NotEqual:
+      break;
+  }
+}
+
+void SeqScanExecutor::ScanTable(size_t table_idx) {
+  table_idx_ = table_idx;
+  table_info_ = tables_[table_idx];
+  Transaction *txn = exec_ctx_->GetTransaction();
+  const bool unlocked = txn->ReadsVersions() || txn->IsRowLockCovered(table_info_->oid_, false);
+  row_lock_manager_ = unlocked ? nullptr : exec_ctx_->GetLockManager();
+  releases_read_locks_ = row_lock_manager_ != nullptr && exec_ctx_->ReleasesReadLocks();
+}
+
+void SeqScanExecutor::Init() {
+  // The constants of the predicate may have been rebound since the last run, see PreparedStatement.
+  if (compiled_predicate_ != nullptr) {
+    compiled_predicate_->Recompile(plan_->GetPredicate(), &table_info_->schema_);
+  }
+  if (comparison_constant_ != nullptr) {
+    compared_constant_ = comparison_constant_->GetValue();
+    compared_column_ = compared_constant_.IsNull() ? nullptr : comparison_column_;
+  }
+  LockTable(exec_ctx_, plan_->GetTableOid());
+  tables_ = ScanTables(exec_ctx_->GetCatalog(), plan_);
+  morsels_ = exec_ctx_->GetMorselSource(plan_);
+  next_page_id_ = INVALID_PAGE_ID;
+  sampled_tables_ = 0;
+  if (!tables_.empty()) {
+    ScanTable(0);
+    next_page_id_ = morsels_ == nullptr ? table_info_->table_->GetFirstPageId() : INVALID_PAGE_ID;
+  }
+  pages_.clear();
+  page_idx_ = 0;
+  resume_rid_ = RID();
+  current_.Clear();
+  current_idx_ = 0;
+  consumer_ = nullptr;
+  consumed_.clear();
+}
+
+void SeqScanExecutor::Close() {
+  morsels_ = nullptr;
+  next_page_id_ = INVALID_PAGE_ID;
+  pages_.clear();
+  page_idx_ = 0;
+  resume_rid_ = RID();
+  current_.Clear();
+  current_idx_ = 0;
+}
+
+bool SeqScanExecutor::Matches(const Tuple &candidate) const {
+  if (compiled_predicate_ != nullptr) {
+    return compiled_predicate_->Evaluate(&candidate);
+  }
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate == nullptr) {
+    return true;
+  }
+  Value result = predicate->Evaluate(&candidate, &table_info_->schema_);
+  return !result.IsNull() && result.GetAs<bool>();
+}
+
+bool SeqScanExecutor::PushDownFilter(const BloomFilter *filter, const std::vector<const AbstractExpression *> &keys) {
+  std::vector<const AbstractExpression *> filter_keys;
+  for (const AbstractExpression *key : keys) {
+    // An output column is an expression on the tuples of the table, which the filter is checked on instead.
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(key);
+    if (column == nullptr || column->GetColIdx() >= GetOutputSchema()->GetColumnCount()) {
+      filter_ = nullptr;
+      filter_keys_.clear();
+      return false;
+    }
+    filter_keys.push_back(GetOutputSchema()->GetColumn(column->GetColIdx()).GetExpr());
+  }
+  filter_ = filter;
+  filter_keys_ = std::move(filter_keys);
+  return filter != nullptr;
+}
+
+bool SeqScanExecutor::PassesFilter(const Tuple &candidate) const {
+  hash_t hash;
+  return filter_ == nullptr || (HashJoinExecutor::HashKeys(candidate, &table_info_->schema_, filter_keys_, 0, &hash) &&
+                                filter_->MayContain(hash));
+}
+
+std::vector<Value> SeqScanExecutor::Project(const Tuple &candidate) {
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    values.emplace_back(column.GetExpr()->Evaluate(&candidate, &table_info_->schema_));
+  }
+  return values;
+}
+
+void SeqScanExecutor::Emit(const RID &rid, Tuple *candidate, bool in_page, TupleBatch *batch) {
+  if (plan_->GetSample().SamplesTuples() && !plan_->GetSample().Picks(rid.Get())) {
+    return;
+  }
+  if (consumer_ == nullptr) {
+    batch->Append(rid, Project(*candidate), GetOutputSchema());
+  } else if (in_page || candidate->IsAllocated()) {
+    consumed_.push_back(std::move(*candidate));
+  } else {
+    // The tuple is in the buffer of the candidates, which the next candidate overwrites.
+    consumed_.emplace_back(*candidate);
+  }
+}
+
+void SeqScanExecutor::Drain(CandidateConsumer *consumer) {
+  consumer_ = consumer;
+  consumed_.clear();
+  // Nothing is appended to the batch, which thus never fills up before the end of the table.
+  TupleBatch batch;
+  try {
+    NextBatch(&batch);
+  } catch (...) {
+    consumer_ = nullptr;
+    throw;
+  }
+  consumer_ = nullptr;
+}
+
+bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+  if (current_idx_ == current_.Size()) {
+    current_idx_ = 0;
+    if (!NextBatch(&current_)) {
+      return false;
+    }
+  }
+  *tuple = current_.GetTuple(current_idx_);
+  *rid = current_.GetRID(current_idx_);
+  current_idx_++;
+  return true;
+}
+
+bool SeqScanExecutor::NextBatch(TupleBatch *batch) {
+  const TableSample &sample = plan_->GetSample();
+  batch->Clear();
+  while (!batch->IsFull()) {
+    if (page_idx_ == pages_.size()) {
+      page_idx_ = 0;
+      pages_.clear();
+      if (morsels_ != nullptr) {
+        // Between morsels the scan holds no latch, and lets the more urgent tasks queued on the pool run first.
+        ThreadPool::Yield();
+        size_t table_idx;
+        if (!morsels_->Next(&pages_, &ring_, nullptr, &table_idx)) {
+          break;
+        }
+        if (table_idx != table_idx_) {
+          ScanTable(table_idx);
+        }
+      } else if (sample.SamplesPages()) {
+        // The pages picked of each table come from its page directory, the others are never read.
+        while (pages_.empty() && sampled_tables_ < tables_.size()) {
+          ScanTable(sampled_tables_++);
+          for (page_id_t page_id : table_info_->table_->GetPageIds()) {
+            if (sample.Picks(page_id)) {
+              pages_.push_back(page_id);
+            }
+          }
+        }
+        if (pages_.empty()) {
+          break;
+        }
+      } else {
+        if (next_page_id_ == INVALID_PAGE_ID && table_idx_ + 1 < tables_.size()) {
+          ScanTable(table_idx_ + 1);
+          next_page_id_ = table_info_->table_->GetFirstPageId();
+        }
+        if (next_page_id_ == INVALID_PAGE_ID) {
+          break;
+        }
+        pages_.push_back(next_page_id_);
+      }
+    }
+    if (morsels_ != nullptr && resume_rid_.GetPageId() == INVALID_PAGE_ID && sample.SamplesPages() &&
+        !sample.Picks(pages_[page_idx_])) {
+      page_idx_++;
+      continue;
+    }
+    page_id_t next_page_id;
+    if (resume_rid_.GetPageId() == INVALID_PAGE_ID && CanSkipPage(pages_[page_idx_], &next_page_id)) {
+      if (morsels_ == nullptr) {
+        next_page_id_ = next_page_id;
+      }
+      page_idx_++;
+      continue;
+    }
+    if (ScanPage(pages_[page_idx_], batch)) {
+      page_idx_++;
+    }
+  }
+  return !batch->IsEmpty();
+}
+
+bool SeqScanExecutor::ScanPage(page_id_t page_id, TupleBatch *batch) {
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  Page *page = bpm->FetchPageWithRing(page_id, &ring_);
+  assert(page != nullptr);  // all pages are pinned
+  page->RLatch();
+  bool found = table_info_->table_->VisitPage(page, [this, batch](auto *page) { return ScanTuples(page, batch); });
+  if (consumer_ != nullptr && !consumed_.empty()) {
+    // While the page is latched, the tuples read in place are still there.
+    consumer_->Consume(consumed_);
+    consumed_.clear();
+  }
+  if (!found && morsels_ == nullptr) {
+    next_page_id_ = static_cast<TablePage *>(page)->GetNextPageId();
+  }
+  page->RUnlatch();
+  bpm->UnpinPage(page_id, false);
+  if (found) {
+    return false;
+  }
+  resume_rid_ = RID();
+  return true;
+}
+
+bool SeqScanExecutor::CanSkipPage(page_id_t page_id, page_id_t *next_page_id) {
+  // The zone map summarizes the versions in the pages, a transaction reading the versions may see older ones.
+  ZoneMap::Range range;
+  if (compared_column_ == nullptr || exec_ctx_->GetTransaction()->ReadsVersions() ||
+      !table_info_->table_->GetZoneMap()->GetRange(page_id, compared_column_->GetColIdx(), &range, next_page_id)) {
+    return false;
+  }
+  // A NULL satisfies no comparison, so a page without other values has no match.
+  if (!range.has_values_) {
+    return true;
+  }
+  const Value &constant = compared_constant_;
+  switch (comparison_type_) {
+    case ComparisonType::Equal:
+      return constant.CompareLessThan(range.min_) == CmpBool::CmpTrue ||
+             constant.CompareGreaterThan(range.max_) == CmpBool::CmpTrue;
+    case ComparisonType::NotEqual:
+      return constant.CompareEquals(range.min_) == CmpBool::CmpTrue &&
+             constant.CompareEquals(range.max_) == CmpBool::CmpTrue;
+    case ComparisonType::LessThan:
+      return range.min_.CompareGreaterThanEquals(constant) == CmpBool::CmpTrue;
+    case ComparisonType::LessThanOrEqual:
+      return range.min_.CompareGreaterThan(constant) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThan:
+      return range.max_.CompareLessThanEquals(constant) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThanOrEqual:
+      return range.max_.CompareLessThan(constant) == CmpBool::CmpTrue;
+  }
+  return false;
+}
+
+template <typename PageType>
+bool SeqScanExecutor::ReadVisibleCandidate(PageType *page, const RID &rid, Tuple *candidate) {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  if (txn->ReadsVersions()) {
+    switch (table_info_->table_->ResolveVersion(rid, candidate, txn)) {
+      case VersionStore::Visibility::CURRENT:
+        break;
+      case VersionStore::Visibility::OLDER:
+        candidate->SetRid(rid);
+        return true;
+      case VersionStore::Visibility::NONE:
+        return false;
+    }
+  }
+  return ReadCandidate(page, rid, candidate);
+}
+
+bool SeqScanExecutor::ReadCandidate(TablePage *page, const RID &rid, Tuple *candidate) {
+  // The candidates are read in place, only the projections of the matching ones are copied out of the page.
+  return page->GetTupleView(rid, candidate, exec_ctx_->GetTransaction(), row_lock_manager_);
+}
+
+bool SeqScanExecutor::ReadCandidate(PaxPage *page, const RID &rid, Tuple *candidate) {
+  // Only the minipages of the columns the scan reads are touched.
+  return page->GetTupleColumns(rid, scan_columns_, &candidate_buffer_, candidate, exec_ctx_->GetTransaction(),
+                               row_lock_manager_);
+}
+
+bool SeqScanExecutor::ReadCandidate(CompressedPage *page, const RID &rid, Tuple *candidate) {
+  // Only the segments of the columns the scan reads are decoded.
+  return page->GetTupleColumns(rid, scan_columns_, &candidate_buffer_, candidate, exec_ctx_->GetTransaction(),
+                               row_lock_manager_);
+}
+
+template <typename PageType>
+bool SeqScanExecutor::ScanTuples(PageType *page, TupleBatch *batch) {
+  if constexpr (std::is_same_v<PageType, TablePage>) {
+    if (compiled_predicate_ != nullptr) {
+      return SelectTuples(page, batch);
+    }
+  }
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  Transaction *txn = exec_ctx_->GetTransaction();
+  TableHeap *table = table_info_->table_.get();
+  RID rid;
+  bool found = table->GetNextSnapshotRid(page, resume_rid_.GetPageId() == INVALID_PAGE_ID ? nullptr : &resume_rid_,
+                                         &rid, txn);
+  // An equality on a dictionary encoded column of a compressed page rules tuples out by their code first, which are
+  // those of the versions in the page.
+  bool by_code = false;
+  uint32_t code = 0;
+  if constexpr (std::is_same_v<PageType, CompressedPage>) {
+    by_code = compared_column_ != nullptr && !txn->ReadsVersions() &&
+              (comparison_type_ == ComparisonType::Equal || comparison_type_ == ComparisonType::NotEqual) &&
+              page->FindCode(compared_column_->GetColIdx(), compared_constant_, &code);
+  }
+  bool is_equal = comparison_type_ == ComparisonType::Equal;
+  Tuple candidate;
+  for (; found && !batch->IsFull(); found = table->GetNextSnapshotRid(page, &rid, &rid, txn)) {
+    if constexpr (std::is_same_v<PageType, CompressedPage>) {
+      if (by_code && (page->GetCode(rid.GetSlotNum(), compared_column_->GetColIdx()) == code) != is_equal) {
+        resume_rid_ = rid;
+        continue;
+      }
+    }
+    const bool was_locked = releases_read_locks_ && (txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid));
+    if (ReadVisibleCandidate(page, rid, &candidate)) {
+      if (!toast_columns_.empty() && Toast::HasToasted(candidate, &table_info_->schema_, toast_columns_)) {
+        // Only the values the scan reads are fetched from their overflow pages.
+        Tuple detoasted = Toast::Detoast(bpm, candidate, &table_info_->schema_, toast_columns_);
+        if (Matches(detoasted) && PassesFilter(detoasted)) {
+          Emit(rid, &detoasted, true, batch);
+        }
+      } else if (Matches(candidate) && PassesFilter(candidate)) {
+        Emit(rid, &candidate, std::is_same_v<PageType, TablePage>, batch);
+      }
+    }
+    if (releases_read_locks_) {
+      // The latch of the page keeps the tuple as read until the batch holds its projection.
+      exec_ctx_->ReleaseReadLock(rid, was_locked);
+    }
+    resume_rid_ = rid;
+  }
+  return found;
+}
+
+bool SeqScanExecutor::SelectTuples(TablePage *page, TupleBatch *batch) {
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  Transaction *txn = exec_ctx_->GetTransaction();
+  TableHeap *table = table_info_->table_.get();
+  RID rid;
+  bool found = table->GetNextSnapshotRid(page, resume_rid_.GetPageId() == INVALID_PAGE_ID ? nullptr : &resume_rid_,
+                                         &rid, txn);
+  while (found && !batch->IsFull()) {
+    // Reads no more candidates than the batch has room for, in place, or as older versions the chunk owns.
+    const size_t room = batch->Capacity() - batch->Size();
+    chunk_.clear();
+    chunk_rids_.clear();
+    for (; found && chunk_.size() < room; found = table->GetNextSnapshotRid(page, &rid, &rid, txn)) {
+      const bool was_locked = releases_read_locks_ && (txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid));
+      Tuple candidate;
+      if (ReadVisibleCandidate(page, rid, &candidate)) {
+        chunk_.push_back(std::move(candidate));
+        chunk_rids_.push_back(rid);
+      }
+      if (releases_read_locks_) {
+        // The latch of the page keeps the tuple as read until the batch holds its projection.
+        exec_ctx_->ReleaseReadLock(rid, was_locked);
+      }
+      resume_rid_ = rid;
+    }
+
+    compiled_predicate_->Select(chunk_, &selected_);
+    for (uint32_t idx : selected_) {
+      Tuple &candidate = chunk_[idx];
+      if (!toast_columns_.empty() && Toast::HasToasted(candidate, &table_info_->schema_, toast_columns_)) {
+        Tuple detoasted = Toast::Detoast(bpm, candidate, &table_info_->schema_, toast_columns_);
+        if (PassesFilter(detoasted)) {
+          Emit(chunk_rids_[idx], &detoasted, true, batch);
+        }
+      } else if (PassesFilter(candidate)) {
+        Emit(chunk_rids_[idx], &candidate, true, batch);
+      }
+    }
+  }
+  return found;
+}
+
+}  // namespace bustub
@@ -0,0 +1,184 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.cpp
+//
+// Identification: src/execution/sort_executor.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/sort_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      sort_key_(plan->GetOrderBys(), child_->GetOutputSchema()) {}
+
+void SortExecutor::Init() {
+  child_->Init();
+  tuples_.clear();
+  keys_.clear();
+  order_.clear();
+  buffered_bytes_ = 0;
+  next_ = 0;
+  runs_.clear();
+  merge_.clear();
+  heap_.clear();
+
+  const size_t key_size = sort_key_.GetSize();
+  const size_t budget = exec_ctx_->GetMemoryBudget();
+  TupleBatch batch;
+  while (child_->NextBatch(&batch)) {
+    for (const Tuple &tuple : batch.GetTuples()) {
+      tuples_.push_back(tuple);
+      keys_.resize(keys_.size() + key_size);
+      sort_key_.Encode(tuple, keys_.data() + keys_.size() - key_size);
+      buffered_bytes_ += tuple.GetLength() + key_size;
+      if (buffered_bytes_ > budget) {
+        SpillBuffer();
+      }
+    }
+  }
+  if (runs_.empty()) {
+    SortBuffer();
+    return;
+  }
+  SpillBuffer();
+
+  // Merge passes read a block of each of their runs at a time.
+  const size_t fan_in = std::max<size_t>(2, budget / TEMP_SPACE_BLOCK_SIZE);
+  while (runs_.size() > fan_in) {
+    std::vector<TmpTupleRun> merged;
+    for (size_t begin = 0; begin < runs_.size(); begin += fan_in) {
+      size_t end = std::min(begin + fan_in, runs_.size());
+      if (end - begin == 1) {
+        merged.push_back(std::move(runs_[begin]));
+        continue;
+      }
+      StartMerge(std::vector<TmpTupleRun>(std::make_move_iterator(runs_.begin() + begin),
+                                          std::make_move_iterator(runs_.begin() + end)));
+      TmpTupleRun run(exec_ctx_->GetTempSpace(), "a sort");
+      Tuple tuple;
+      while (NextMerged(&tuple)) {
+        run.Append(tuple);
+      }
+      run.Seal();
+      merged.push_back(std::move(run));
+    }
+    runs_ = std::move(merged);
+  }
+  StartMerge(std::move(runs_));
+  runs_.clear();
+}
+
+void SortExecutor::Close() {
+  tuples_.clear();
+  keys_.clear();
+  order_.clear();
+  runs_.clear();
+  merge_.clear();
+  heap_.clear();
+  child_->Close();
+}
+
+bool SortExecutor::Next(Tuple *tuple, RID *rid) {
+  if (!merge_.empty()) {
+    if (!NextMerged(tuple)) {
+      return false;
+    }
+  } else {
+    if (next_ == order_.size()) {
+      return false;
+    }
+    *tuple = tuples_[order_[next_++]];
+  }
+  *rid = tuple->GetRid();
+  return true;
+}
+
+void SortExecutor::SortBuffer() {
+  order_.resize(tuples_.size());
+  for (size_t i = 0; i < order_.size(); i++) {
+    order_[i] = i;
+  }
+  std::sort(order_.begin(), order_.end(), [this](size_t left, size_t right) {
+    return sort_key_.Compare(KeyOf(left), tuples_[left], KeyOf(right), tuples_[right]) < 0;
+  });
+}
+
+void SortExecutor::SpillBuffer() {
+  if (tuples_.empty()) {
+    return;
+  }
+  SortBuffer();
+  TmpTupleRun run(exec_ctx_->GetTempSpace(), "a sort");
+  for (size_t i : order_) {
+    run.Append(tuples_[i]);
+  }
+  run.Seal();
+  runs_.push_back(std::move(run));
+  tuples_.clear();
+  keys_.clear();
+  order_.clear();
+  buffered_bytes_ = 0;
+}
+
+void SortExecutor::StartMerge(std::vector<TmpTupleRun> &&runs) {
+  merge_.clear();
+  heap_.clear();
+  for (TmpTupleRun &run : runs) {
+    merge_.push_back(RunReader{std::move(run), {}, 0, std::vector<char>(sort_key_.GetSize())});
+  }
+  for (size_t i = 0; i < merge_.size(); i++) {
+    if (merge_[i].run_.ReadBlock(&merge_[i].block_) && !merge_[i].block_.empty()) {
+      sort_key_.Encode(merge_[i].Current(), merge_[i].key_.data());
+      heap_.push_back(i);
+    }
+  }
+  auto greater = [this](size_t left, size_t right) { return MergeGreater(left, right); };
+  std::make_heap(heap_.begin(), heap_.end(), greater);
+}
+
+bool SortExecutor::MergeGreater(size_t left, size_t right) const {
+  return sort_key_.Compare(merge_[left].key_.data(), merge_[left].Current(), merge_[right].key_.data(),
+                           merge_[right].Current()) > 0;
+}
+
+bool SortExecutor::Advance(RunReader *reader) {
+  if (++reader->pos_ == reader->block_.size()) {
+    reader->pos_ = 0;
+    if (!reader->run_.ReadBlock(&reader->block_) || reader->block_.empty()) {
+      return false;
+    }
+  }
+  sort_key_.Encode(reader->Current(), reader->key_.data());
+  return true;
+}
+
+bool SortExecutor::NextMerged(Tuple *tuple) {
+  if (heap_.empty()) {
+    return false;
+  }
+  auto greater = [this](size_t left, size_t right) { return MergeGreater(left, right); };
+  std::pop_heap(heap_.begin(), heap_.end(), greater);
+  RunReader &reader = merge_[heap_.back()];
+  *tuple = reader.Current();
+  if (Advance(&reader)) {
+    std::push_heap(heap_.begin(), heap_.end(), greater);
+  } else {
+    heap_.pop_back();
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.cpp
+//
+// Identification: src/execution/sort_key.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/sort_key.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** Writes the low bytes of an unsigned value big-endian. */
+void EncodeBigEndian(uint64_t value, size_t size, char *out) {
+  for (size_t i = 0; i < size; i++) {
+    out[i] = static_cast<char>(value >> (8 * (size - 1 - i)));
+  }
+}
+
+/** Writes a signed value of a size big-endian, with the sign bit flipped so that negative values sort first. */
+void EncodeSigned(int64_t value, size_t size, char *out) {
+  uint64_t bits = static_cast<uint64_t>(value) ^ (uint64_t{1} << (8 * size - 1));
+  EncodeBigEndian(bits, size, out);
+}
+
+}  // namespace
+
+SortKey::SortKey(const std::vector<OrderBy> &order_bys, const Schema *schema) : order_bys_(order_bys), schema_(schema) {
+  for (const auto &[expr, order_by_type] : order_bys_) {
+    TypeId type = expr->GetReturnType();
+    if (type == TypeId::VARCHAR) {
+      size_ += 1 + SORT_KEY_VARCHAR_PREFIX;
+      num_encoded_++;
+      exact_ = false;
+      break;
+    }
+    if (type == TypeId::INVALID) {
+      exact_ = false;
+      break;
+    }
+    size_ += 1 + Type::GetTypeSize(type);
+    num_encoded_++;
+  }
+}
+
+void SortKey::Encode(const Tuple &tuple, char *key) const {
+  char *out = key;
+  for (size_t i = 0; i < num_encoded_; i++) {
+    const auto &[expr, order_by_type] = order_bys_[i];
+    TypeId type = expr->GetReturnType();
+    size_t size = type == TypeId::VARCHAR ? SORT_KEY_VARCHAR_PREFIX : Type::GetTypeSize(type);
+    Value value = expr->Evaluate(&tuple, schema_);
+    if (!value.IsNull() && value.GetTypeId() != type) {
+      value = value.CastAs(type);
+    }
+    memset(out, 0, 1 + size);
+    if (!value.IsNull()) {
+      out[0] = 1;
+      switch (type) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          EncodeSigned(value.GetAs<int8_t>(), size, out + 1);
+          break;
+        case TypeId::SMALLINT:
+          EncodeSigned(value.GetAs<int16_t>(), size, out + 1);
+          break;
+        case TypeId::INTEGER:
+          EncodeSigned(value.GetAs<int32_t>(), size, out + 1);
+          break;
+        case TypeId::BIGINT:
+          EncodeSigned(value.GetAs<int64_t>(), size, out + 1);
+          break;
+        case TypeId::TIMESTAMP:
+          EncodeBigEndian(value.GetAs<uint64_t>(), size, out + 1);
+          break;
+        case TypeId::DECIMAL: {
+          // Negative doubles sort in the reverse order of their bits.
+          auto number = value.GetAs<double>();
+          uint64_t bits;
+          memcpy(&bits, &number, sizeof(bits));
+          bits = (bits >> 63) != 0 ? ~bits : bits ^ (uint64_t{1} << 63);
+          EncodeBigEndian(bits, size, out + 1);
+          break;
+        }
+        case TypeId::VARCHAR:
+          memcpy(out + 1, value.GetData(), std::min<size_t>(value.GetLength() - 1, size));
+          break;
+        default:
+          break;
+      }
+    }
+    if (order_by_type == OrderByType::DESC) {
+      for (size_t j = 0; j < 1 + size; j++) {
+        out[j] = static_cast<char>(~out[j]);
+      }
+    }
+    out += 1 + size;
+  }
+}
+
+int SortKey::Compare(const Tuple &left, const Tuple &right) const {
+  for (const auto &[expr, order_by_type] : order_bys_) {
+    Value left_value = expr->Evaluate(&left, schema_);
+    Value right_value = expr->Evaluate(&right, schema_);
+    int result;
+    if (left_value.IsNull() || right_value.IsNull()) {
+      result = static_cast<int>(right_value.IsNull()) - static_cast<int>(left_value.IsNull());
+    } else if (left_value.CompareLessThan(right_value) == CmpBool::CmpTrue) {
+      result = -1;
+    } else if (left_value.CompareGreaterThan(right_value) == CmpBool::CmpTrue) {
+      result = 1;
+    } else {
+      result = 0;
+    }
+    if (result != 0) {
+      return order_by_type == OrderByType::DESC ? -result : result;
+    }
+  }
+  return 0;
+}
+
+int SortKey::Compare(const char *left_key, const Tuple &left, const char *right_key, const Tuple &right) const {
+  int result = memcmp(left_key, right_key, size_);
+  if (result != 0 || exact_) {
+    return result;
+  }
+  return Compare(left, right);
+}
+
+}  // namespace bustub
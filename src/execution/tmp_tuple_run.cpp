@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_run.cpp
+//
+// Identification: src/execution/tmp_tuple_run.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/tmp_tuple_run.h"
+
+#include <cstring>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TmpTupleRun::TmpTupleRun(TmpTupleRun &&other) noexcept
+    : temp_space_(other.temp_space_),
+      owner_(std::move(other.owner_)),
+      blocks_(std::move(other.blocks_)),
+      next_block_(other.next_block_),
+      buffer_(std::move(other.buffer_)),
+      used_(other.used_),
+      bytes_(other.bytes_) {
+  other.blocks_.clear();
+  other.next_block_ = 0;
+  other.used_ = 0;
+  other.bytes_ = 0;
+}
+
+TmpTupleRun &TmpTupleRun::operator=(TmpTupleRun &&other) noexcept {
+  if (this != &other) {
+    Drop();
+    temp_space_ = other.temp_space_;
+    owner_ = std::move(other.owner_);
+    blocks_ = std::move(other.blocks_);
+    next_block_ = other.next_block_;
+    buffer_ = std::move(other.buffer_);
+    used_ = other.used_;
+    bytes_ = other.bytes_;
+    other.blocks_.clear();
+    other.next_block_ = 0;
+    other.used_ = 0;
+    other.bytes_ = 0;
+  }
+  return *this;
+}
+
+void TmpTupleRun::Append(const Tuple &tuple) {
+  const size_t needed = sizeof(uint32_t) + tuple.GetLength();
+  if (needed > TEMP_SPACE_BLOCK_SIZE) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Tuple of " + std::to_string(tuple.GetLength()) +
+                                                     " bytes does not fit in a block to spill " + owner_ + " to.");
+  }
+  if (used_ + needed > TEMP_SPACE_BLOCK_SIZE) {
+    Flush();
+  }
+  if (buffer_ == nullptr) {
+    buffer_ = std::make_unique<char[]>(TEMP_SPACE_BLOCK_SIZE);
+  }
+  tuple.SerializeTo(buffer_.get() + used_);
+  used_ += needed;
+  bytes_ += tuple.GetLength();
+}
+
+void TmpTupleRun::Flush() {
+  const uint32_t block = temp_space_->AllocateBlock();
+  try {
+    temp_space_->WriteBlock(block, buffer_.get(), used_);
+  } catch (...) {
+    temp_space_->FreeBlock(block);
+    throw;
+  }
+  blocks_.push_back(Block{block, static_cast<uint32_t>(used_)});
+  used_ = 0;
+}
+
+void TmpTupleRun::Seal() {
+  if (used_ > 0) {
+    Flush();
+  }
+  buffer_.reset();
+}
+
+bool TmpTupleRun::ReadBlock(std::vector<Tuple> *tuples) {
+  tuples->clear();
+  if (next_block_ == blocks_.size()) {
+    buffer_.reset();
+    return false;
+  }
+  if (buffer_ == nullptr) {
+    buffer_ = std::make_unique<char[]>(TEMP_SPACE_BLOCK_SIZE);
+  }
+  const Block &block = blocks_[next_block_];
+  temp_space_->ReadBlock(block.block_, buffer_.get(), block.size_);
+  for (size_t offset = 0; offset < block.size_;) {
+    tuples->emplace_back();
+    tuples->back().DeserializeFrom(buffer_.get() + offset);
+    offset += sizeof(uint32_t) + tuples->back().GetLength();
+  }
+  temp_space_->FreeBlock(block.block_);
+  next_block_++;
+  return true;
+}
+
+void TmpTupleRun::Drop() {
+  for (size_t i = next_block_; i < blocks_.size(); i++) {
+    temp_space_->FreeBlock(blocks_[i].block_);
+  }
+  blocks_.clear();
+  next_block_ = 0;
+  buffer_.reset();
+  used_ = 0;
+  bytes_ = 0;
+}
+
+}  // namespace bustub
@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// top_n_executor.cpp
+//
+// Identification: src/execution/top_n_executor.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/top_n_executor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace bustub {
+
+TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, size_t n,
+                           std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      n_(n),
+      child_(std::move(child)),
+      sort_key_(plan->GetOrderBys(), child_->GetOutputSchema()) {}
+
+bool TopNExecutor::Less(size_t left, size_t right) const {
+  const size_t key_size = sort_key_.GetSize();
+  return sort_key_.Compare(keys_.data() + left * key_size, tuples_[left], keys_.data() + right * key_size,
+                           tuples_[right]) < 0;
+}
+
+void TopNExecutor::Init() {
+  child_->Init();
+  tuples_.clear();
+  keys_.clear();
+  heap_.clear();
+  next_ = 0;
+  if (n_ == 0) {
+    return;
+  }
+
+  const size_t key_size = sort_key_.GetSize();
+  auto less = [this](size_t left, size_t right) { return Less(left, right); };
+  std::vector<char> key(key_size);
+  TupleBatch batch;
+  while (child_->NextBatch(&batch)) {
+    for (const Tuple &tuple : batch.GetTuples()) {
+      if (tuples_.size() < n_) {
+        tuples_.push_back(tuple);
+        keys_.resize(keys_.size() + key_size);
+        sort_key_.Encode(tuple, KeyOf(tuples_.size() - 1));
+        heap_.push_back(tuples_.size() - 1);
+        std::push_heap(heap_.begin(), heap_.end(), less);
+        continue;
+      }
+      // Only a tuple that sorts before the greatest one kept takes its slot.
+      size_t top = heap_.front();
+      sort_key_.Encode(tuple, key.data());
+      if (sort_key_.Compare(key.data(), tuple, KeyOf(top), tuples_[top]) >= 0) {
+        continue;
+      }
+      std::pop_heap(heap_.begin(), heap_.end(), less);
+      tuples_[top] = tuple;
+      memcpy(KeyOf(top), key.data(), key_size);
+      std::push_heap(heap_.begin(), heap_.end(), less);
+    }
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), less);
+}
+
+void TopNExecutor::Close() {
+  tuples_.clear();
+  keys_.clear();
+  heap_.clear();
+  next_ = 0;
+  child_->Close();
+}
+
+bool TopNExecutor::Next(Tuple *tuple, RID *rid) {
+  if (next_ == heap_.size()) {
+    return false;
+  }
+  *tuple = tuples_[heap_[next_++]];
+  *rid = tuple->GetRid();
+  return true;
+}
+
+}  // namespace bustub
@@ -10,16 +10,105 @@
 //
 //===----------------------------------------------------------------------===//
 #include <memory>
+#include <vector>
 
+#include "common/exception.h"
 #include "execution/executors/update_executor.h"
+#include "execution/index_batch.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "storage/table/toast.h"
 
 namespace bustub {
 
 UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      table_info_(exec_ctx->GetCatalog()->GetTable(plan->TableOid())),
+      child_executor_(std::move(child_executor)) {
+  BUSTUB_ASSERT(!table_info_->IsPartitioned(), "The tuples of a partitioned table are updated in its partitions.");
+}
 
-void UpdateExecutor::Init() {}
+void UpdateExecutor::Init() {
+  done_ = false;
+  // Of every tuple of the table, one exclusive table lock covers the row locks.
+  const bool whole_table = SeqScanPlanNode::IsFullScanOf(plan_->GetChildPlan(), plan_->TableOid());
+  exec_ctx_->LockTable(plan_->TableOid(), whole_table ? LockMode::EXCLUSIVE : LockMode::INTENTION_EXCLUSIVE);
+  child_executor_->Init();
+}
+
+bool UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
+  if (done_) {
+    return false;
+  }
+  done_ = true;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  std::vector<uint32_t> updated_columns;
+  for (const auto &[column, info] : *plan_->GetUpdateAttr()) {
+    updated_columns.push_back(column);
+  }
+  // An update of no indexed column is heap-only: the tuple keeps its RID, and every index its entry.
+  IndexBatch index_batch(exec_ctx_, table_info_, updated_columns);
+  std::vector<ColumnIncrement> increments;
+  const bool increments_only = GetIncrements(index_batch, &increments);
+  const std::vector<uint32_t> &uninlined_columns = table_info_->schema_.GetUnlinedColumns();
+  TupleBatch batch;
+  Tuple old_tuple;
+  Tuple new_tuple;
+  while (child_executor_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      RID old_rid = batch.GetRID(i);
+      if (increments_only) {
+        // Read under the increment lock, without a shared lock that would keep the others from adding to the tuple.
+        if (!table_info_->table_->IncrementTuple(increments, old_rid, txn, &old_tuple, &new_tuple)) {
+          throw Exception("Update of table " + table_info_->name_ + " failed.");
+        }
+        table_info_->stats_.RemoveTuple(old_tuple);
+        table_info_->stats_.AddTuple(new_tuple);
+        continue;
+      }
+      // The child may project the tuple, the update is computed on the tuple of the table.
+      if (!table_info_->table_->GetTuple(old_rid, &old_tuple, txn)) {
+        throw Exception("Update of table " + table_info_->name_ + " failed.");
+      }
+      // The values stored out of line are read back, the heap toasts the new tuple again if it is too large.
+      if (!uninlined_columns.empty() && Toast::HasToasted(old_tuple, &table_info_->schema_, uninlined_columns)) {
+        old_tuple = Toast::Detoast(exec_ctx_->GetBufferPoolManager(), old_tuple, &table_info_->schema_);
+      }
+      new_tuple = GenerateUpdatedTuple(old_tuple);
+      if (!table_info_->table_->UpdateTuple(new_tuple, old_rid, txn)) {
+        throw Exception("Update of table " + table_info_->name_ + " failed.");
+      }
+      if (index_batch.HasIndexes()) {
+        index_batch.Update(old_tuple, new_tuple, old_rid);
+      }
+      MaterializedView::RecordDeltas(txn, table_info_->views_, old_tuple, false);
+      MaterializedView::RecordDeltas(txn, table_info_->views_, new_tuple, true);
+      table_info_->stats_.RemoveTuple(old_tuple);
+      table_info_->stats_.AddTuple(new_tuple);
+    }
+    index_batch.Flush();
+  }
+  return false;
+}
+
+bool UpdateExecutor::GetIncrements(const IndexBatch &index_batch, std::vector<ColumnIncrement> *increments) const {
+  // The old and new keys and view tuples of an increment hold the uncommitted increments of the others.
+  if (index_batch.HasIndexes() || !table_info_->views_.empty() ||
+      table_info_->table_->GetFormat() != TableFormat::ROW) {
+    return false;
+  }
+  const Schema &schema = table_info_->schema_;
+  for (const auto &[column, info] : *plan_->GetUpdateAttr()) {
+    const Column &col = schema.GetColumn(column);
+    if (info.type_ != UpdateType::Add || !ColumnIncrement::Supports(col.GetType())) {
+      return false;
+    }
+    increments->push_back(ColumnIncrement{col.GetOffset(), col.GetType(), info.update_val_});
+  }
+  return !increments->empty();
+}
+
+void UpdateExecutor::Close() { child_executor_->Close(); }
 
-bool UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) { return false; }
 }  // namespace bustub
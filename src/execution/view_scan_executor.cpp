@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// view_scan_executor.cpp
+//
+// Identification: src/execution/view_scan_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/view_scan_executor.h"
+
+namespace bustub {
+
+ViewScanExecutor::ViewScanExecutor(ExecutorContext *exec_ctx, const ViewScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      view_(exec_ctx->GetCatalog()->GetMaterializedView(plan->GetViewName())) {}
+
+void ViewScanExecutor::Init() {
+  tuples_ = view_->Read();
+  next_ = 0;
+}
+
+void ViewScanExecutor::Close() {
+  tuples_.clear();
+  next_ = 0;
+}
+
+bool ViewScanExecutor::Next(Tuple *tuple, RID *rid) {
+  if (next_ == tuples_.size()) {
+    return false;
+  }
+  *tuple = tuples_[next_++];
+  *rid = RID();
+  return true;
+}
+
+bool ViewScanExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  while (!batch->IsFull() && next_ < tuples_.size()) {
+    batch->Emplace(RID(), tuples_[next_++]);
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
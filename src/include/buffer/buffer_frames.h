@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_frames.h
+//
+// Identification: src/include/buffer/buffer_frames.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** The size of the huge pages the page data of a buffer pool is backed by, where the kernel has them. */
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+/** No NUMA node: the memory goes to the node of the thread that first touches it. */
+static constexpr int NO_NUMA_NODE = -1;
+
+/**
+ * BufferFrames holds the memory of the frames of a buffer pool, in one anonymous mapping of its own:
+ *
+ *   - the page data of all the frames, page aligned, each frame's PAGE_SIZE bytes after the previous one's;
+ *   - then the Pages, the book-keeping of the frames, packed in an array of cache-line aligned entries.
+ *
+ * A pool of at least HUGE_PAGE_SIZE of page data is backed by huge pages: reserved ones if the kernel has enough,
+ * otherwise the mapping is aligned on HUGE_PAGE_SIZE and left to transparent huge pages. The mapping may also be bound
+ * to a NUMA node, before any of it is touched, so that a shard of a partitioned pool sits on one node.
+ */
+class BufferFrames {
+ public:
+  /**
+   * @param num_frames the frames of the buffer pool
+   * @param numa_node the node to place the memory on, NO_NUMA_NODE for none; ignored on a machine of one node
+   */
+  explicit BufferFrames(size_t num_frames, int numa_node = NO_NUMA_NODE);
+
+  ~BufferFrames();
+
+  DISALLOW_COPY_AND_MOVE(BufferFrames);
+
+  /** @return the frames, over their page data */
+  Page *GetPages() const { return pages_; }
+
+  /**
+   * Returns the memory of a frame's page data to the kernel, which hands zeroed memory back when it is next touched.
+   * Does nothing for reserved huge pages, which cannot be returned a frame at a time.
+   * @param frame_id the frame, out of use
+   */
+  void Discard(frame_id_t frame_id);
+
+  /** @return true if the page data is backed by reserved huge pages */
+  bool IsHugeTlb() const { return huge_tlb_; }
+
+  /** @return the node the memory is placed on, NO_NUMA_NODE if none */
+  int GetNumaNode() const { return numa_node_; }
+
+  /** @return the NUMA nodes of the machine, 1 if it is not a NUMA machine or they cannot be told */
+  static int GetNumNumaNodes();
+
+ private:
+  /** Places [region, region + size) on a node. @return false if the kernel refused */
+  static bool BindToNode(void *region, size_t size, int numa_node);
+
+  size_t num_frames_;
+  char *region_{nullptr};
+  size_t region_size_{0};
+  Page *pages_{nullptr};
+  bool huge_tlb_{false};
+  int numa_node_{NO_NUMA_NODE};
+};
+
+}  // namespace bustub
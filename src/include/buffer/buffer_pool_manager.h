@@ -12,19 +12,66 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_frames.h"
+#include "buffer/buffer_ring.h"
+#include "buffer/checkpoint_pacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/fetch_trace.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "buffer/secondary_cache.h"
+#include "common/metrics.h"
+#include "common/spin_mutex.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/disk_backend.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Maximum number of pages the prefetch thread reads in one batch. */
+static constexpr size_t PREFETCH_BATCH_SIZE = 16;
+/** Default fraction of the pool the background writer keeps clean, counting free frames. */
+static constexpr double BGWRITER_CLEAN_RATIO = 0.25;
+/** Default time between two rounds of the background writer. */
+static constexpr std::chrono::milliseconds BGWRITER_INTERVAL{10};
+/** Default time between two dumps of the resident pages, see StartPageDump. */
+static constexpr std::chrono::milliseconds PAGE_DUMP_INTERVAL{60000};
+/** Number of dumped pages LoadResidentPages sorts by id at a time, hottest first. */
+static constexpr size_t PAGE_LOAD_CHUNK = 256;
+/** Default time Resize waits for the frames it retires to be unpinned. */
+static constexpr std::chrono::milliseconds RESIZE_TIMEOUT{1000};
+/**
+ * The pin count of a frame the buffer pool claimed under its latch, free or being handed to another page. It is far
+ * enough below zero that the fetches pinning the frame meanwhile, which back off, keep it negative.
+ */
+static constexpr int FRAME_CLAIMED = INT32_MIN / 2;
+/** The slots of a page that FetchChildPage swizzles, as many as a B+ tree internal page has. */
+static constexpr size_t MAX_SWIZZLED_SLOTS = 512;
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * A fetch that finds its page resident takes no latch: it looks the page up in the page table, pins the frame with an
+ * atomic increment of its pin count, then checks that the frame still holds the page, which it keeps while pinned. A
+ * frame is only handed to another page once claimed, its pin count swapped from zero to FRAME_CLAIMED under the
+ * latch, so the pin either comes first and keeps the frame, or finds it claimed and backs off to the latched path,
+ * like misses take it.
  */
 class BufferPoolManager {
  public:
@@ -36,13 +83,31 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the frames reserved for Resize to grow the pool to, 0 = pool_size
+   */
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
+
+  /**
+   * Creates a new BufferPoolManager that is one shard of a ParallelBufferPoolManager. On a NUMA machine, the shards
+   * have their frames on each node in turn.
+   * @param pool_size the size of this shard's buffer pool
+   * @param num_instances total number of shards in the parallel buffer pool
+   * @param instance_index index of this shard in the parallel buffer pool
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the frames reserved for Resize to grow this shard to, 0 = pool_size
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                    size_t max_pool_size = 0);
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -91,11 +156,178 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetches the requested page like FetchPage, but on a miss recycles the frames of the given ring instead of
+   * evicting pages from the rest of the pool. Meant for bulk reads such as sequential scans.
+   * @param page_id id of page to be fetched
+   * @param ring the operator's buffer ring, nullptr = behave like FetchPage
+   * @return the requested page
+   */
+  Page *FetchPageWithRing(page_id_t page_id, BufferRing *ring) { return FetchPageImpl(page_id, ring); }
+
+  /**
+   * Fetches the page a slot of a pinned parent page refers to, like FetchPage. The parent keeps a swizzled reference
+   * per slot, the frame the page was in when last fetched through it, so that while the page stays resident the
+   * fetch pins that frame directly, without looking up the page table. A reference is checked against the frame when
+   * followed, so one left stale by an eviction, or by the parent moving its slots, only costs a regular fetch.
+   * @param parent the pinned page holding the slot, e.g. a B+ tree internal page
+   * @param slot the index of the slot; those from MAX_SWIZZLED_SLOTS on are not swizzled
+   * @param page_id id of the page the slot refers to
+   * @return the requested page
+   */
+  Page *FetchChildPage(Page *parent, size_t slot, page_id_t page_id) {
+    return FetchChildPageImpl(parent, slot, page_id);
+  }
+
+  /**
+   * Creates a new page like NewPage, asking the disk manager to place it close after the hint page.
+   * @param[out] page_id id of created page
+   * @param hint a page the new page should follow on disk, e.g. the current last page of a table heap
+   * @param owner the object the page belongs to, identified by its first page; its pages are allocated in extents
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageWithHint(page_id_t *page_id, page_id_t hint, page_id_t owner = INVALID_PAGE_ID) {
+    return NewPageImpl(page_id, hint, owner);
+  }
+
+  /**
+   * Asks for the given pages to be read into the buffer pool in the background, so that a later FetchPage finds them
+   * resident. Prefetched pages are left unpinned. This is only a hint: pages that are already resident, or for which
+   * no frame can be found without waiting, are skipped.
+   * @param page_ids ids of the pages that are about to be fetched
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) { PrefetchPagesImpl(page_ids); }
+
+  /**
+   * @return true if the page is in the buffer pool, read in; only a hint, as the page may be evicted or read in
+   * right after
+   */
+  virtual bool IsPageResident(page_id_t page_id);
+
+  /**
+   * @return the ids of the resident pages, hottest first: the pinned pages, then the others in the reverse of the order
+   * the replacer would evict them
+   */
+  virtual std::vector<page_id_t> GetResidentPages();
+
+  /**
+   * Writes the ids of the resident pages, hottest first, to a file that LoadResidentPages reads back after a restart,
+   * so that the buffer pool does not start cold. The file is replaced at once, never left half written.
+   * @param file_name the dump file, one page id per line
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Prefetches the pages of a dump written by DumpResidentPages, up to the size of the pool. The hottest pages are
+   * queued first, in chunks sorted by page id so that the prefetch thread reads mostly neighbouring pages together.
+   * @param file_name the dump file
+   * @return the number of pages queued for prefetching, 0 if the file could not be read
+   */
+  size_t LoadResidentPages(const std::string &file_name);
+
+  /**
+   * Starts a thread dumping the resident pages to file_name every interval, and once more when stopped, so that the
+   * dump of a clean shutdown is up to date and that of a crash at most interval old. Does nothing if already running.
+   * @param file_name the dump file, see DumpResidentPages
+   * @param interval time between two dumps
+   */
+  void StartPageDump(const std::string &file_name, std::chrono::milliseconds interval = PAGE_DUMP_INTERVAL);
+
+  /**
+   * Stops and joins the page dump thread after its last dump, if it is running.
+   */
+  void StopPageDump();
+
+  /**
+   * Starts the background writer, which periodically writes dirty pages that are about to be evicted so that a
+   * foreground fetch rarely has to write a victim back itself, and the pages the last fuzzy checkpoint left dirty,
+   * paced by a CheckpointPacer. Pages are only written once the log records up to their LSN are persistent. Does
+   * nothing if the writer is already running.
+   * @param clean_ratio fraction of the pool to keep free or clean, looking at the replacer's eviction candidates
+   * @param interval time between two rounds of the writer
+   */
+  virtual void RunBackgroundWriter(double clean_ratio = BGWRITER_CLEAN_RATIO,
+                                   std::chrono::milliseconds interval = BGWRITER_INTERVAL);
+
+  /**
+   * Stops and joins the background writer, if it is running.
+   */
+  virtual void StopBackgroundWriter();
+
+  /**
+   * Writes back all the dirty pages in the buffer pool while the pool stays in use, as a fuzzy checkpoint does: each
+   * page is written under its read latch, so that it reaches the disk whole, and may be dirtied again right after.
+   * Pages whose LSN is not yet persistent are left dirty, like the background writer leaves them. The pages are
+   * written in the order of their ids, optionally paced so that the flush does not take all the disk bandwidth.
+   * @param max_pages_per_second the rate to write at most, 0 = as fast as possible
+   * @return the number of pages written
+   */
+  virtual size_t FlushDirtyPages(size_t max_pages_per_second = 0);
+
+  /**
+   * Takes the dirty page table of a checkpoint: the pages that may differ from their copy on disk, those dirty, pinned
+   * or being written back, with their recovery LSN, see Page::GetRecLSN.
+   * @param[out] dirty_page_table the pages mapped to their recovery LSN
+   * @return the smallest offset in the log file their records since the recovery LSN are at, INT64_MAX if none
+   */
+  virtual int64_t GetDirtyPageTable(std::unordered_map<page_id_t, lsn_t> *dirty_page_table);
+
+  /**
+   * Asks the background writer to write back the dirty pages whose recovery LSN is below lsn, i.e. those in the dirty
+   * page table of a fuzzy checkpoint logged at lsn, so that the redo of the next checkpoint starts later. The pages
+   * are written lazily, the oldest first, at the pace of a CheckpointPacer, and only while the background writer runs.
+   * @param lsn the LSN of the checkpoint record
+   */
+  virtual void SetCheckpointLSN(lsn_t lsn) { checkpoint_lsn_ = lsn; }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() { return pool_size_; }
+  virtual size_t GetPoolSize() { return pool_size_; }
+
+  /** @return the size Resize can grow the buffer pool to */
+  virtual size_t GetMaxPoolSize() { return max_pool_size_; }
+
+  /**
+   * Resizes the buffer pool while it stays in use. Growing hands frames reserved at construction to the free list,
+   * their memory only faulted in once used. Shrinking retires the frames past new_size, which fetches stop picking
+   * for new pages: the free ones at once, the resident ones once unpinned, the dirty ones after being written back.
+   * The memory of the retired frames is returned to the kernel.
+   * @param new_size the number of frames, from 1 to GetMaxPoolSize()
+   * @param timeout how long to wait for the pinned frames to be unpinned
+   * @return false if new_size is out of range, or if frames were still pinned at the timeout, which a later Resize
+   * retires then
+   */
+  virtual bool Resize(size_t new_size, std::chrono::milliseconds timeout = RESIZE_TIMEOUT);
+
+  /** @return the number of times a thread found the latch of the buffer pool held */
+  virtual uint64_t GetNumLatchContended() const { return latch_.GetNumContended(); }
+
+  /** The pages a thread fetched from all the buffer pools, and those of them it found resident. */
+  struct FetchStats {
+    uint64_t num_fetches_{0};
+    uint64_t num_hits_{0};
+  };
+
+  /** @return the pages the calling thread fetched so far, to attribute them to what it runs, e.g. an operator */
+  static FetchStats GetThreadFetchStats() { return thread_fetch_stats_; }
+
+  /**
+   * Hands every page fetched from now on to trace, and whether it was resident, which the caller owns and keeps alive
+   * until the trace is unset and the fetches in flight are done.
+   * @param trace the trace to record the fetches in, nullptr = stop recording
+   */
+  virtual void SetFetchTrace(FetchTrace *trace) { fetch_trace_.store(trace); }
+
+  /**
+   * Puts a secondary cache behind the buffer pool: the clean pages evicted are copied to it, and the misses read from
+   * it the pages it has. Scans reading through a buffer ring leave it alone. The caller owns the cache, and sets it
+   * before the pool is used.
+   * @param cache the secondary cache, nullptr = none
+   */
+  virtual void SetSecondaryCache(SecondaryCache *cache) { secondary_cache_ = cache; }
 
  protected:
   /**
@@ -116,7 +348,25 @@ class BufferPoolManager {
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id);
+
+  /**
+   * Fetch the requested page from the buffer pool, recycling the frames of the given ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring to recycle frames from, nullptr = use the free list and the replacer
+   * @return the requested page
+   * @throws ChecksumException if the page read from disk does not match its checksum
+   */
+  virtual Page *FetchPageImpl(page_id_t page_id, BufferRing *ring);
+
+  /**
+   * Fetch the page a slot of a parent page refers to, following the swizzled reference of the slot if it is valid.
+   * @param parent the pinned page holding the slot
+   * @param slot the index of the slot
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  virtual Page *FetchChildPageImpl(Page *parent, size_t slot, page_id_t page_id);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -124,49 +374,324 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
+
+  /**
+   * Creates a new page in the buffer pool, placed on disk close after the hint page if possible.
+   * @param[out] page_id id of created page
+   * @param hint a page the new page should follow on disk, INVALID_PAGE_ID for none
+   * @param owner the object the page belongs to, INVALID_PAGE_ID for none
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageImpl(page_id_t *page_id, page_id_t hint, page_id_t owner);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl();
+  virtual void FlushAllPagesImpl();
+
+  /**
+   * Queues the given pages for the prefetch thread, starting it on first use.
+   * @param page_ids ids of the pages to prefetch
+   */
+  virtual void PrefetchPagesImpl(const std::vector<page_id_t> &page_ids);
+
+  /** Body of the prefetch thread: reads queued pages until the buffer pool is destroyed. */
+  void RunPrefetcher();
+
+  /**
+   * Reads the pages into frames, unpinned, skipping those that are already resident or for which every frame is
+   * pinned. All the reads are submitted to the disk backend as one batch.
+   * @param page_ids ids of the pages to prefetch
+   * @param backend the prefetch thread's disk backend
+   */
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids, DiskBackend *backend);
+
+  /**
+   * Body of the background writer thread: runs WriteAheadOfEviction, then WriteBackCheckpointPages, every interval
+   * until stopped.
+   * @param clean_ratio fraction of the pool to keep free or clean, of its size at each round
+   * @param interval time between two rounds
+   */
+  void RunBgWriter(double clean_ratio, std::chrono::milliseconds interval);
+
+  /**
+   * Body of the page dump thread, see StartPageDump.
+   */
+  void RunPageDump(const std::string &file_name, std::chrono::milliseconds interval);
+
+  /**
+   * One round of the background writer. Walks the replacer's eviction candidates and writes dirty ones until
+   * clean_target frames are free or clean. Pages whose LSN is not yet persistent are left dirty.
+   * @param clean_target number of frames to keep free or clean
+   * @return the number of pages written
+   */
+  size_t WriteAheadOfEviction(size_t clean_target);
+
+  /**
+   * Writes back the dirty pages whose recovery LSN is below checkpoint_lsn_, see SetCheckpointLSN, as many of them,
+   * the oldest first, as checkpoint_pacer_ asks for given the dirty frames, the log and the writes since the last
+   * round. Pages whose LSN is not yet persistent are left dirty.
+   * @param now the time of the round
+   * @return the number of pages written
+   */
+  size_t WriteBackCheckpointPages(std::chrono::steady_clock::time_point now);
+
+  /**
+   * Writes dirty frames back without latch_, holding them like the background writer does so that they are not
+   * evicted meanwhile, in the order of their page ids. Called with write_back_latch_ held.
+   * @param dirty_frames the frames to write back
+   * @param lock holds latch_ on entry, released on return
+   * @return the number of pages written
+   */
+  size_t WriteBackFrames(const std::vector<frame_id_t> &dirty_frames, std::unique_lock<SpinMutex> *lock);
+
+  /**
+   * Pins a resident page without latch_, as the hits of FetchPageImpl do.
+   * @param page_id id of page to be pinned
+   * @return the pinned page, nullptr if it was not found resident and read in, or its frame was claimed
+   */
+  Page *TryPinResident(page_id_t page_id);
+
+  /**
+   * Pins a frame without latch_ if it holds the given page, read in.
+   * @return the pinned page, nullptr if the frame holds another page, is being read in, or is claimed
+   */
+  Page *TryPinFrame(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Claims an unpinned frame, so that no fetch can pin it until ReserveFrame hands it to a page. Caller must hold
+   * latch_.
+   * @return false if the frame is pinned
+   */
+  bool ClaimFrame(frame_id_t frame_id);
+
+  /** Drops a pin on a frame, putting it back in the replacer with the last one. */
+  void UnpinFrame(frame_id_t frame_id);
 
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
+  /**
+   * Takes a frame from the free list, or evicts one from the replacer, and claims it. Caller must hold latch_.
+   * @param[out] frame_id id of the frame that was found
+   * @return false if every frame is pinned, true otherwise
+   */
+  bool FindFreeFrame(frame_id_t *frame_id);
+
+  /**
+   * Reuses the frame of the page last read into the ring's current slot, if that page is still resident and unpinned,
+   * and claims it. Caller must hold latch_.
+   * @param ring the buffer ring, may be nullptr
+   * @param[out] frame_id id of the frame that was found
+   * @return true if a ring frame can be reused, false otherwise
+   */
+  bool FindRingFrame(BufferRing *ring, frame_id_t *frame_id);
+
+  /**
+   * Hands a claimed frame over to a new page, pinned once, and marks it as busy with I/O. Caller must hold latch_.
+   * If the old page is dirty it is recorded in write_back_table_ until ReleaseFrame is called.
+   * @param frame_id id of the frame to reserve
+   * @param page_id id of the page that will live in the frame
+   * @return true if the old contents of the frame are dirty and must be written back, false otherwise
+   */
+  bool ReserveFrame(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Finishes the I/O started by ReserveFrame and wakes up every thread waiting on the frame. Caller must hold latch_.
+   * @param frame_id id of the frame whose I/O has completed
+   * @param old_page_id id of the page previously held by the frame
+   * @param write_back the value returned by ReserveFrame
+   */
+  void ReleaseFrame(frame_id_t frame_id, page_id_t old_page_id, bool write_back);
+
+  /** Starts the recovery LSN of a frame whose page is read in or written back. Caller must hold latch_. */
+  void ResetRecLSN(Page *frame);
+
+  /**
+   * Abandons the page being read into a frame whose read failed, and drops the reader's pin. Fetchers waiting on the
+   * frame find it holding no page and drop theirs with DropPin. Caller must hold latch_.
+   * @param frame_id id of the frame whose read failed
+   */
+  void DropPage(frame_id_t frame_id);
+
+  /**
+   * Reserves a slot of the secondary cache, if any, for the page a frame is taken from by ReserveFrame, if clean.
+   * Caller must hold latch_.
+   * @param old_page_id the page the frame held
+   * @param write_back whether the page is dirty, see ReserveFrame
+   * @param[out] ticket the slot to write the page to once latch_ is released
+   * @return true if the page is to be written to the secondary cache
+   */
+  bool ReserveCacheSlot(page_id_t old_page_id, bool write_back, SecondaryCache::Ticket *ticket);
+
+  /**
+   * Returns a claimed frame that holds no page to the free list, or retires it if Resize shrank the pool below it.
+   * Caller must hold latch_.
+   */
+  void FreeFrame(frame_id_t frame_id);
+
+  /**
+   * Retires a frame past the pool size, evicting its page if it is unpinned and clean. Caller must hold latch_.
+   * @param frame_id id of the frame, not retired yet
+   * @param[out] dirty_frames where the frame goes if its page must be written back first
+   * @return false if the frame is still in use
+   */
+  bool RetireFrame(frame_id_t frame_id, std::vector<frame_id_t> *dirty_frames);
+
+  /**
+   * Drops a pin on a frame abandoned by DropPage, returning the frame to the free list with the last one.
+   * Caller must hold latch_.
+   * @param frame_id id of the abandoned frame
+   */
+  void DropPin(frame_id_t frame_id);
+
+  /**
+   * Counts a fetch in the stats of the calling thread and hands it to the fetch trace, if one is set. Called without
+   * latch_, once the page is pinned.
+   * @param page_id id of the fetched page
+   * @param hit true if the page was resident
+   */
+  void RecordFetch(page_id_t page_id, bool hit);
+
+  /**
+   * Blocks until the given page is no longer being written back from a reassigned frame.
+   * @param lock the caller's lock on latch_
+   * @param page_id id of the page about to be read
+   */
+  void WaitForWriteBack(std::unique_lock<SpinMutex> *lock, page_id_t page_id);
+
+  /**
+   * Allocates a page id owned by this instance. A standalone instance defers to the disk manager; a shard of a
+   * ParallelBufferPoolManager hands out every num_instances_-th id starting at instance_index_, ignoring the hint and
+   * the owner.
+   * @param hint a page the new page should follow on disk, INVALID_PAGE_ID for none
+   * @param owner the object the page belongs to, INVALID_PAGE_ID for none
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(page_id_t hint, page_id_t owner);
+
+  /** Number of pages in the buffer pool, changed by Resize under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames reserved; those from pool_size_ on are retired, or about to be. */
+  const size_t max_pool_size_;
+  /** Number of shards in the parallel buffer pool this instance belongs to (1 if standalone). */
+  const uint32_t num_instances_ = 1;
+  /** Index of this instance in the parallel buffer pool. */
+  const uint32_t instance_index_ = 0;
+  /** Next page id to hand out when this instance is a shard. */
+  page_id_t next_page_id_ = 0;
+  /** The memory of the frames; a shard of a parallel pool on a NUMA machine has it on node instance_index_ % nodes. */
+  BufferFrames frames_;
   /** Array of buffer pool pages. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages, written under latch_ and read by hits without it. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
+  /** True for the frames that are out of use, past the pool size, free and claimed for good. */
+  std::vector<bool> retired_;
+  /** Serializes Resize. */
+  std::mutex resize_latch_;
+  /** True while the frame is being read in or written back without latch_ held. */
+  std::unique_ptr<std::atomic<bool>[]> io_in_progress_;
+  /** Per-frame condition, waited on with latch_, signalled when the frame's in-flight I/O completes. */
+  std::unique_ptr<std::condition_variable_any[]> io_cv_;
+  /** True while the background writer or a fuzzy checkpoint is writing the frame's page. */
+  std::unique_ptr<std::atomic<bool>[]> bgwriter_holds_;
+  /** True if the frame was out of the replacer, or was taken out of it, while held by the background writer. */
+  std::unique_ptr<std::atomic<bool>[]> bgwriter_displaced_;
+  /** Dirty pages whose frame was handed to another page, mapped to that frame until the write back completes. */
+  std::unordered_map<page_id_t, frame_id_t> write_back_table_;
+  /** The recovery LSN and log offset of the pages in write_back_table_, for GetDirtyPageTable. */
+  std::unordered_map<page_id_t, std::pair<lsn_t, int64_t>> write_back_rec_lsns_;
+  /** The LSN of the last fuzzy checkpoint, the pages dirty since before it are written by the background writer. */
+  std::atomic<lsn_t> checkpoint_lsn_{INVALID_LSN};
+  /** The pace of the writes of the last checkpoint, used by the background writer only, like the fields below. */
+  CheckpointPacer checkpoint_pacer_;
+  /** The checkpoint checkpoint_pacer_ paces. */
+  lsn_t paced_checkpoint_lsn_{INVALID_LSN};
+  /** The count and sum of write_latency_us_ at the last round of the background writer. */
+  uint64_t paced_num_writes_{0};
+  uint64_t paced_write_time_us_{0};
+  /**
+   * Serializes the writers of page_table_, and protects free_list_, retired_, next_page_id_, the claims of frames and
+   * the book-keeping fields of pages_ but their pin counts and dirty flags. Disk reads and writes for cache misses,
+   * hits and unpins run without it.
+   */
+  SpinMutex latch_;
+  /** The time a cache miss waits for its page to be read from the disk, exported as "buffer_pool.read_latency_us". */
+  Histogram read_latency_us_;
+  /** The time a batch of dirty pages takes to be written, exported as "buffer_pool.write_latency_us". */
+  Histogram write_latency_us_;
+  /** The pages the calling thread fetched, see GetThreadFetchStats. */
+  static thread_local FetchStats thread_fetch_stats_;
+  /** Where the fetched page ids are recorded, see SetFetchTrace; nullptr when no trace is taken. */
+  std::atomic<FetchTrace *> fetch_trace_{nullptr};
+  /** The cache of the clean pages evicted, see SetSecondaryCache; nullptr when none. */
+  SecondaryCache *secondary_cache_{nullptr};
+  /** The fetches that found their page resident, and those that read it in, "buffer_pool.hits" and ".misses". */
+  Counter num_hits_;
+  Counter num_misses_;
+  /** The hits that followed a swizzled reference rather than the page table, "buffer_pool.swizzled_hits". */
+  Counter num_swizzled_hits_;
+  /** The misses that read their page from the secondary cache, "buffer_pool.secondary_hits". */
+  Counter num_secondary_hits_;
+  /** The pages displaced from their frames for others, "buffer_pool.evictions". */
+  Counter num_evictions_;
+  /** The dirty pages written back at eviction, by the background writer or checkpoints, "buffer_pool.dirty_writes". */
+  Counter num_dirty_writes_;
+  /** Pages waiting to be prefetched, at most pool_size_ of them. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** Set when the buffer pool is being destroyed and the prefetch thread should exit. */
+  bool prefetch_stop_ = false;
+  /** Protects prefetch_queue_, prefetch_stop_ and the start of prefetch_thread_. */
+  std::mutex prefetch_latch_;
+  /** Signalled when a page is queued for prefetching or prefetch_stop_ is set. */
+  std::condition_variable prefetch_cv_;
+  /** Reads queued pages in the background; only started by the first PrefetchPages call. */
+  std::thread prefetch_thread_;
+  /** Taken by the background writer and the fuzzy checkpoints while they hold frames, one at a time. */
+  std::mutex write_back_latch_;
+  /** Set when the background writer should exit. */
+  bool bgwriter_stop_ = false;
+  /** Protects bgwriter_stop_ and bgwriter_thread_. */
+  std::mutex bgwriter_latch_;
+  /** Signalled to stop the background writer, or to wake it up early after a foreground write back. */
+  std::condition_variable bgwriter_cv_;
+  /** Writes dirty pages ahead of eviction while running. */
+  std::thread bgwriter_thread_;
+  /** Set when the page dump thread should exit. */
+  bool page_dump_stop_ = false;
+  /** Protects page_dump_stop_ and page_dump_thread_. */
+  std::mutex page_dump_latch_;
+  /** Signalled to stop the page dump thread. */
+  std::condition_variable page_dump_cv_;
+  /** Dumps the resident pages periodically while running. */
+  std::thread page_dump_thread_;
 };
 }  // namespace bustub
@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.h
+//
+// Identification: src/include/buffer/buffer_ring.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferRing is a small private set of buffer pool frames that a bulk operation, e.g. a full table scan, recycles
+ * instead of evicting the rest of the working set.
+ *
+ * Every page read in through BufferPoolManager::FetchPageWithRing takes the next slot of the ring. When a slot comes
+ * around again and the page it read last is still resident and unpinned, its frame is reused for the new page.
+ * Otherwise the frame comes from the free list or the replacer as usual, so the ring never holds frames hostage: an
+ * N-slot ring caps the operation's footprint at roughly N frames. Create one per operator and keep it alive for the
+ * duration of the operator.
+ */
+class BufferRing {
+  friend class BufferPoolManager;
+  friend class ParallelBufferPoolManager;
+
+ public:
+  /**
+   * Creates a new BufferRing.
+   * @param size the number of frames the ring recycles
+   */
+  explicit BufferRing(size_t size) : pages_(std::max<size_t>(size, 1), INVALID_PAGE_ID) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferRing);
+
+  ~BufferRing() = default;
+
+  /** @return the number of frames the ring recycles */
+  size_t Size() const { return pages_.size(); }
+
+ private:
+  /** @return the page last read into the current slot, INVALID_PAGE_ID if the slot was never used */
+  page_id_t Current() const { return pages_[next_slot_]; }
+
+  /** Records the page read into the current slot and moves on to the next slot. */
+  void Advance(page_id_t page_id) {
+    pages_[next_slot_] = page_id;
+    next_slot_ = (next_slot_ + 1) % pages_.size();
+  }
+
+  /**
+   * Returns the part of the ring used for one instance of a ParallelBufferPoolManager, so that every instance only
+   * recycles its own frames. The slots are split evenly across instances.
+   * @param index index of the instance
+   * @param num_instances total number of instances
+   * @return the ring partition of the given instance
+   */
+  BufferRing *Partition(size_t index, size_t num_instances) {
+    if (partitions_.empty()) {
+      for (size_t i = 0; i < num_instances; i++) {
+        partitions_.emplace_back(std::make_unique<BufferRing>(pages_.size() / num_instances));
+      }
+    }
+    return partitions_[index].get();
+  }
+
+  /** Pages last read into each slot. */
+  std::vector<page_id_t> pages_;
+  /** The slot the next page is read into. */
+  size_t next_slot_{0};
+  /** Per-instance partitions, created on first use by a ParallelBufferPoolManager. */
+  std::vector<std::unique_ptr<BufferRing>> partitions_;
+};
+
+}  // namespace bustub
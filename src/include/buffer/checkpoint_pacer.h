@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checkpoint_pacer.h
+//
+// Identification: src/include/buffer/checkpoint_pacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/** Default time the pages a checkpoint leaves dirty are written over, with the pool at CHECKPOINT_DIRTY_RATIO. */
+static constexpr std::chrono::milliseconds CHECKPOINT_SPREAD{1000};
+/** Default number of bytes of log written after a checkpoint by which the pages it leaves dirty are written. */
+static constexpr int64_t CHECKPOINT_LOG_SPREAD = 64 << 20;
+/** Default fraction of the pool dirty past which the writes of a checkpoint are sped up. */
+static constexpr double CHECKPOINT_DIRTY_RATIO = 0.5;
+/** Default mean latency of the writes of the buffer pool past which the writes of a checkpoint are slowed down. */
+static constexpr std::chrono::microseconds CHECKPOINT_WRITE_LATENCY{10000};
+
+/**
+ * CheckpointPacer paces the background writer through the pages a fuzzy checkpoint leaves dirty, see
+ * BufferPoolManager::SetCheckpointLSN, so that they are written before the log grows too long for the next checkpoint
+ * to truncate it, without writing them in a burst that slows the foreground reads down.
+ *
+ * The progress of a checkpoint is the fraction of its pages that are to be written by now, the larger of two: the
+ * time since the checkpoint over its spread, and the log written since over the log spread. The spread is shortened
+ * as the pool is dirtier than the dirty ratio, since evictions then write pages back themselves, and lengthened as the
+ * writes are slower than the write latency, since the device is then busy. The log spread is not: however slow the
+ * device, the pages are written by the end of it. Each round the background writer writes the pages of the checkpoint
+ * that are left past its progress.
+ *
+ * A pacer is used by the background writer thread alone.
+ */
+class CheckpointPacer {
+ public:
+  /**
+   * Creates a new CheckpointPacer.
+   * @param spread the time the pages of a checkpoint are written over, with the pool at dirty_ratio
+   * @param log_spread the number of bytes of log written after a checkpoint by which its pages are written
+   * @param dirty_ratio the fraction of the pool dirty past which the spread is shortened in proportion
+   * @param write_latency the mean latency of the writes past which the spread is lengthened in proportion
+   */
+  explicit CheckpointPacer(std::chrono::milliseconds spread = CHECKPOINT_SPREAD,
+                           int64_t log_spread = CHECKPOINT_LOG_SPREAD, double dirty_ratio = CHECKPOINT_DIRTY_RATIO,
+                           std::chrono::microseconds write_latency = CHECKPOINT_WRITE_LATENCY)
+      : spread_(spread), log_spread_(log_spread), dirty_ratio_(dirty_ratio), write_latency_(write_latency) {}
+
+  /**
+   * Starts pacing the writes of a checkpoint.
+   * @param num_pages the number of pages the checkpoint left dirty
+   * @param log_offset the end of the log
+   * @param now the current time
+   */
+  void BeginCheckpoint(size_t num_pages, int64_t log_offset, std::chrono::steady_clock::time_point now);
+
+  /**
+   * Advances the progress of the checkpoint.
+   * @param num_pages the number of pages the checkpoint left dirty that are still dirty
+   * @param dirty_ratio the fraction of the pool dirty
+   * @param log_offset the end of the log
+   * @param write_latency the mean latency of the writes since the last call, 0 if none
+   * @param now the current time
+   * @return the number of pages to write now, the oldest first
+   */
+  size_t PagesToWrite(size_t num_pages, double dirty_ratio, int64_t log_offset,
+                      std::chrono::microseconds write_latency, std::chrono::steady_clock::time_point now);
+
+  /** @return the fraction of the pages of the checkpoint that are to be written by now */
+  double GetProgress() const { return progress_; }
+
+ private:
+  const std::chrono::milliseconds spread_;
+  const int64_t log_spread_;
+  const double dirty_ratio_;
+  const std::chrono::microseconds write_latency_;
+  /** The number of pages the checkpoint left dirty, and the end of the log then. */
+  size_t num_pages_{0};
+  int64_t log_offset_{0};
+  /** The progress by time, summed over the calls since each one may shorten or lengthen the spread. */
+  double time_progress_{0};
+  double progress_{1};
+  std::chrono::steady_clock::time_point last_call_;
+};
+
+}  // namespace bustub
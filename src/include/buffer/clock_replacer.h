@@ -12,8 +12,9 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +24,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The replacer is lock-free. Every frame has an atomic reference bit and an atomic "in replacer" flag, and the clock
+ * hand is an atomic index advanced with compare-and-swap, so Pin and Unpin are a couple of atomic stores and Victim
+ * can sweep concurrently with them. A frame is claimed by whichever Victim or Pin clears its flag first.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,10 +48,29 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> EvictionCandidates(size_t max_frames) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** Advances the clock hand by one frame. @return the frame the hand pointed at before moving */
+  size_t AdvanceHand();
+
+  size_t num_pages_;
+
+  /** Reference bit per frame, set on Unpin and cleared as the hand sweeps past. */
+  std::unique_ptr<std::atomic<uint8_t>[]> ref_;
+
+  /** Whether the frame is currently in the replacer, i.e. can be victimized. */
+  std::unique_ptr<std::atomic<uint8_t>[]> in_replacer_;
+
+  /**
+   * Number of frames in the replacer. Signed, because a Victim or Pin may decrement it before the Unpin that published
+   * the frame has incremented it.
+   */
+  std::atomic<int64_t> size_{0};
+
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_trace.h
+//
+// Identification: src/include/buffer/fetch_trace.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FetchTrace receives the id of every page fetched from a buffer pool it is set on, see
+ * BufferPoolManager::SetFetchTrace, e.g. to replay the accesses of a real workload against other replacers and pool
+ * sizes. Record is called by the fetching threads concurrently, once the page is pinned, without any latch of the
+ * buffer pool.
+ */
+class FetchTrace {
+ public:
+  virtual ~FetchTrace() = default;
+
+  /**
+   * Records a fetch of a page.
+   * @param page_id id of the fetched page
+   * @param hit true if the page was resident, false if it was read in
+   */
+  virtual void Record(page_id_t page_id, bool hit) = 0;
+};
+
+/**
+ * FetchTraceWriter writes the fetched page ids to a file, as native int32s in the order they were recorded.
+ */
+class FetchTraceWriter : public FetchTrace {
+ public:
+  /** Opens, and truncates, the trace file; throws if it cannot be created. */
+  explicit FetchTraceWriter(const std::string &file_name);
+
+  /** Writes the buffered page ids and closes the file. */
+  ~FetchTraceWriter() override;
+
+  DISALLOW_COPY_AND_MOVE(FetchTraceWriter);
+
+  void Record(page_id_t page_id, bool hit) override;
+
+  /**
+   * Reads back a trace file.
+   * @return the page ids of the trace, empty if the file cannot be read
+   */
+  static std::vector<page_id_t> Read(const std::string &file_name);
+
+ private:
+  /** The number of page ids buffered before they are written. */
+  static constexpr size_t BUFFER_SIZE = 4096;
+
+  /** Writes the buffered page ids; the caller holds latch_. */
+  void WriteBuffer();
+
+  std::mutex latch_;
+  FILE *file_;
+  std::vector<page_id_t> buffer_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/** Default number of historical references LRUKReplacer keeps per frame. */
+static constexpr size_t LRUK_REPLACER_K = 2;
+/** Default correlated reference period of LRUKReplacer, in accesses. */
+static constexpr uint64_t LRUK_CORRELATED_REFERENCE_PERIOD = 0;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every Pin is a reference to the frame, stamped with a logical timestamp. The replacer keeps the timestamps of the
+ * last K uncorrelated references of each frame and evicts the unpinned frame whose K-th most recent reference is the
+ * oldest, i.e. the one with the largest backward K-distance. Frames with fewer than K references have an infinite
+ * backward K-distance and are evicted first, least recently referenced first. A single scan over a table therefore
+ * only evicts pages it touched once, and hot index pages referenced K times survive.
+ *
+ * References that arrive within the correlated reference period of the previous reference to the same frame (e.g. a
+ * fetch, unpin and re-fetch by the same operator) only refresh the last reference and do not count as a new one.
+ * A frame is not evicted while it is within that period, unless every unpinned frame is.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of historical references to keep per frame
+   * @param correlated_period references closer than this many accesses apart are treated as one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        uint64_t correlated_period = LRUK_CORRELATED_REFERENCE_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> EvictionCandidates(size_t max_frames) override;
+
+  size_t Size() override;
+
+ private:
+  /** Eviction order key: (has K references, K-th most recent or last reference timestamp, frame id). */
+  using EvictionKey = std::tuple<bool, uint64_t, frame_id_t>;
+
+  /** @return the eviction key for the frame given its current history. Caller must hold latch_. */
+  EvictionKey KeyOf(frame_id_t frame_id) const;
+
+  /** @return the timestamp of the frame's i-th most recent reference, 1-based. Caller must hold latch_. */
+  uint64_t HistoryAt(frame_id_t frame_id, size_t i) const {
+    return history_[frame_id * k_ + (head_[frame_id] + k_ - (i - 1)) % k_];
+  }
+
+  size_t num_pages_;
+  size_t k_;
+  uint64_t correlated_period_;
+  /** Logical clock, advanced on every reference. */
+  uint64_t current_timestamp_{0};
+  /** Ring buffers of the last k_ uncorrelated reference timestamps, k_ slots per frame. */
+  std::vector<uint64_t> history_;
+  /** Slot of the most recent reference in each frame's ring buffer. */
+  std::vector<size_t> head_;
+  /** Number of references recorded per frame, capped at k_. */
+  std::vector<size_t> count_;
+  /** Timestamp of the most recent (possibly correlated) reference per frame. */
+  std::vector<uint64_t> last_;
+  /** Whether the frame is currently evictable. */
+  std::vector<bool> evictable_;
+  /** Evictable frames ordered by decreasing backward K-distance. */
+  std::set<EvictionKey> eviction_order_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,19 +12,20 @@
 
 #pragma once
 
-#include <list>
 #include <mutex>  // NOLINT
-#include <queue>
-#include <set>
 #include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
+#include "common/spin_mutex.h"
 
 namespace bustub {
 
 /**
  * LRUReplacer implements the lru replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Unpinned frames are kept in a doubly linked list threaded through arrays indexed by frame id, ordered from least to
+ * most recently unpinned. Victim, Pin and Unpin are all O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -45,17 +46,37 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> EvictionCandidates(size_t max_frames) override;
+
   size_t Size() override;
 
+  /** @return the number of times a thread found the latch of the replacer held */
+  uint64_t GetNumLatchContended() const { return replacer_mutex.GetNumContended(); }
+
  private:
-  // TODO(student): implement me!
+  /** Links the frame at the most recently used end of the list. Caller must hold replacer_mutex. */
+  void PushBack(frame_id_t frame_id);
+
+  /** Unlinks the frame from the list. Caller must hold replacer_mutex. */
+  void Unlink(frame_id_t frame_id);
+
   size_t max_pages;
 
-  std::list<frame_id_t> victim_queue;
+  /** Index of the list sentinel; prev_[sentinel] is the most and next_[sentinel] the least recently used frame. */
+  frame_id_t sentinel;
+
+  /** Previous frame in the list, indexed by frame id. */
+  std::vector<frame_id_t> prev_;
+
+  /** Next frame in the list, indexed by frame id. */
+  std::vector<frame_id_t> next_;
+
+  /** Whether the frame is currently linked into the list, indexed by frame id. */
+  std::vector<bool> in_replacer_;
 
-  std::set<frame_id_t> frame_in_replacer;
+  size_t size_;
 
-  std::mutex replacer_mutex;
+  SpinMutex replacer_mutex;
 };
 
 }  // namespace bustub
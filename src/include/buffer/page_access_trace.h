@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.h
+//
+// Identification: src/include/buffer/page_access_trace.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/fetch_trace.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The accesses each thread keeps by default in the ring of a PageAccessTracer. */
+static constexpr size_t PAGE_ACCESS_RING_SIZE = 1 << 16;
+
+/** One fetch of a page from a buffer pool. */
+struct PageAccess {
+  /** When the page was fetched, in nanoseconds since the tracer was created. */
+  uint64_t timestamp_ns_;
+  page_id_t page_id_;
+  /** The object the page belongs to, by its first page, see PageTrace::ResolveOwners; INVALID_PAGE_ID for none. */
+  page_id_t owner_;
+  /** true if the page was resident. */
+  bool hit_;
+};
+
+/**
+ * PageAccessTracer keeps the last accesses of every thread that fetches pages from a buffer pool it is set on, see
+ * BufferPoolManager::SetFetchTrace. Each thread writes to a ring of its own, without any latch, so that tracing costs
+ * a clock read and a few stores a fetch; once a ring is full, the oldest accesses of its thread are overwritten.
+ */
+class PageAccessTracer : public FetchTrace {
+ public:
+  /** @param ring_size the accesses each thread keeps */
+  explicit PageAccessTracer(size_t ring_size = PAGE_ACCESS_RING_SIZE);
+
+  DISALLOW_COPY_AND_MOVE(PageAccessTracer);
+
+  void Record(page_id_t page_id, bool hit) override;
+
+  /**
+   * Must be called once the tracer is unset from the buffer pool and the fetches in flight are done.
+   * @return the accesses kept by all the threads, by timestamp, their owners unresolved
+   */
+  std::vector<PageAccess> Collect() const;
+
+  /** @return the accesses overwritten in the rings so far */
+  uint64_t GetNumOverwritten() const;
+
+ private:
+  struct Ring {
+    explicit Ring(size_t size) : accesses_(size) {}
+
+    std::vector<PageAccess> accesses_;
+    /** The accesses recorded so far, the next one going to accesses_[num_recorded_ % size]. */
+    std::atomic<uint64_t> num_recorded_{0};
+  };
+
+  /** @return the ring of the calling thread, created on its first access */
+  Ring *ThreadRing();
+
+  /** Tells this tracer from those whose rings the threads may still have cached, see ThreadRing. */
+  const uint64_t id_;
+  const size_t ring_size_;
+  const std::chrono::steady_clock::time_point start_;
+  mutable std::mutex rings_latch_;
+  std::unordered_map<std::thread::id, std::unique_ptr<Ring>> rings_;
+};
+
+/**
+ * PageTrace is a trace of page accesses with the objects the pages belong to, and the names of those objects, e.g.
+ * tables and indexes. It is written to and read from a text file, for the analysis of the accesses offline:
+ *
+ *   owner <first page id> <name>
+ *   access <timestamp ns> <page id> <owner> <1 if a hit, 0 if a miss>
+ */
+struct PageTrace {
+  /**
+   * Sets the owner of every access from the extents of the disk manager, see DiskManager::GetExtentOwners. A page
+   * that is the first page of an owner belongs to it too.
+   */
+  void ResolveOwners(const std::map<page_id_t, page_id_t> &extent_owners);
+
+  /** @return false if the file cannot be written */
+  bool Write(const std::string &file_name) const;
+
+  /** @return false if the file cannot be read or is malformed */
+  static bool Read(const std::string &file_name, PageTrace *trace);
+
+  std::vector<PageAccess> accesses_;
+  /** The names of the owners, by their first page. */
+  std::map<page_id_t, std::string> owner_names_;
+};
+
+}  // namespace bustub
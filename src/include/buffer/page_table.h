@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the pages resident in a buffer pool to their frames. It is an open-addressing hash table with linear
+ * probing, at least twice as large as the pool, whose slots are atomic words holding a page id and a frame id each.
+ *
+ * Insert and Erase must be serialized by the caller, e.g. under the latch of the buffer pool, and see an exact table.
+ * Find may also run concurrently with them, without any latch. It then never returns a mapping that was not in the
+ * table at some point, but it may return one that was just erased, or miss an entry that an Erase is moving back
+ * over the slot it frees. A caller without the latch has to validate what it finds, and look again with the latch on
+ * a miss if it needs to be sure.
+ */
+class PageTable {
+ public:
+  /** @param num_frames the frames of the buffer pool, the most entries the table holds */
+  explicit PageTable(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Looks a page up; safe without the latch of the writers.
+   * @param[out] frame_id the frame of the page
+   * @return true if the page was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const {
+    for (size_t slot = Home(page_id);; slot = (slot + 1) & mask_) {
+      const uint64_t entry = slots_[slot].load(std::memory_order_acquire);
+      if (entry == EMPTY) {
+        return false;
+      }
+      if (PageOf(entry) == page_id) {
+        *frame_id = FrameOf(entry);
+        return true;
+      }
+    }
+  }
+
+  /** Maps a page to a frame, replacing its previous frame if it had one. */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /** Unmaps a page, if it is mapped. */
+  void Erase(page_id_t page_id);
+
+ private:
+  /** A free slot: INVALID_PAGE_ID in INVALID_PAGE_ID. */
+  static constexpr uint64_t EMPTY = ~static_cast<uint64_t>(0);
+
+  static uint64_t MakeEntry(page_id_t page_id, frame_id_t frame_id) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t PageOf(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static frame_id_t FrameOf(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xffffffff); }
+
+  /** @return the slot a page is looked for first, by Fibonacci hashing */
+  size_t Home(page_id_t page_id) const {
+    return static_cast<size_t>((static_cast<uint32_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  /** @return the slot holding a page, or the free slot ending its probe sequence. Caller must serialize writers. */
+  size_t SlotOf(page_id_t page_id) const;
+
+  size_t mask_;
+  /** 64 minus the log2 of the number of slots. */
+  int shift_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
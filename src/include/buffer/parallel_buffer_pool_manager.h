@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager hashes page ids across several independent BufferPoolManager instances. Every instance
+ * has its own page table, free list, replacer and latch, so operations on pages that live in different instances
+ * never contend with each other.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManager instances
+   * @param pool_size the pool size of each BufferPoolManager instance
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of each BufferPoolManager instance
+   * @param max_pool_size the frames reserved for Resize in each instance, 0 = pool_size
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t max_pool_size = 0);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return size of the buffer pool, i.e. the sum of the pool sizes of all instances */
+  size_t GetPoolSize() override;
+
+  /** @return the size Resize can grow the buffer pool to, the sum over all instances */
+  size_t GetMaxPoolSize() override;
+
+  /**
+   * Resizes the instances, spreading new_size evenly over them, see BufferPoolManager::Resize.
+   * @param new_size the number of frames, from the number of instances to GetMaxPoolSize()
+   * @param timeout how long to wait for the pinned frames of all the instances to be unpinned
+   * @return false if new_size is out of range, or if frames of an instance were still pinned at the timeout
+   */
+  bool Resize(size_t new_size, std::chrono::milliseconds timeout = RESIZE_TIMEOUT) override;
+
+  /** @return the number of times a thread found the latch of an instance held, summed over all instances */
+  uint64_t GetNumLatchContended() const override;
+
+  /**
+   * Starts the background writer of every instance.
+   * @param clean_ratio fraction of each instance to keep free or clean
+   * @param interval time between two rounds of the writers
+   */
+  void RunBackgroundWriter(double clean_ratio = BGWRITER_CLEAN_RATIO,
+                           std::chrono::milliseconds interval = BGWRITER_INTERVAL) override;
+
+  /**
+   * Stops the background writer of every instance.
+   */
+  void StopBackgroundWriter() override;
+
+  /**
+   * Writes back the dirty pages of every instance, one after the other, see BufferPoolManager::FlushDirtyPages.
+   * @param max_pages_per_second the rate to write at most, over all the instances, 0 = as fast as possible
+   * @return the number of pages written
+   */
+  size_t FlushDirtyPages(size_t max_pages_per_second = 0) override;
+
+  /**
+   * Takes the dirty page table of every instance, see BufferPoolManager::GetDirtyPageTable.
+   * @return the smallest log offset of their pages
+   */
+  int64_t GetDirtyPageTable(std::unordered_map<page_id_t, lsn_t> *dirty_page_table) override;
+
+  /**
+   * Hands the LSN of a fuzzy checkpoint to every instance, see BufferPoolManager::SetCheckpointLSN.
+   */
+  void SetCheckpointLSN(lsn_t lsn) override;
+
+  /**
+   * Asks the instance of the page, see BufferPoolManager::IsPageResident.
+   */
+  bool IsPageResident(page_id_t page_id) override;
+
+  /**
+   * Lists the resident pages of every instance, see BufferPoolManager::GetResidentPages.
+   */
+  std::vector<page_id_t> GetResidentPages() override;
+
+  /**
+   * Puts the secondary cache behind every instance, see BufferPoolManager::SetSecondaryCache.
+   */
+  void SetSecondaryCache(SecondaryCache *cache) override;
+
+  /**
+   * Sets the fetch trace of every instance, see BufferPoolManager::SetFetchTrace.
+   */
+  void SetFetchTrace(FetchTrace *trace) override;
+
+  /** @return the number of BufferPoolManager instances */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+ protected:
+  /**
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManager instance responsible for handling the given page id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  using BufferPoolManager::FetchPageImpl;
+
+  /**
+   * Fetch the requested page from the instance responsible for it. Each instance recycles its own part of the ring.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring to recycle frames from, nullptr = use the free list and the replacer
+   * @return the requested page
+   */
+  Page *FetchPageImpl(page_id_t page_id, BufferRing *ring) override;
+
+  /**
+   * Fetch the page a slot of a parent page refers to from the instance responsible for it, which follows the swizzled
+   * reference of the slot if it is to one of its frames.
+   * @param parent the pinned page holding the slot
+   * @param slot the index of the slot
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  Page *FetchChildPageImpl(Page *parent, size_t slot, page_id_t page_id) override;
+
+  /**
+   * Hands every page to the prefetch thread of the instance responsible for it.
+   * @param page_ids ids of the pages to prefetch
+   */
+  void PrefetchPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Unpin the target page from the instance responsible for it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  using BufferPoolManager::NewPageImpl;
+
+  /**
+   * Creates a new page. Instances are tried in round robin order, starting from a different instance on every call,
+   * until one of them is able to allocate the page. The instances allocate their own page ids, so the hint and the
+   * owner are ignored.
+   * @param[out] page_id id of created page
+   * @param hint ignored
+   * @param owner ignored
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id, page_id_t hint, page_id_t owner) override;
+
+  /**
+   * Deletes a page from the instance responsible for it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  /**
+   * Flushes all the pages of all the instances to disk.
+   */
+  void FlushAllPagesImpl() override;
+
+ private:
+  /** The individual buffer pool instances, indexed by page_id % num_instances. */
+  std::vector<std::unique_ptr<BufferPoolManager>> instances_;
+  /** Index of the instance NewPageImpl starts from on its next call. */
+  size_t next_instance_ = 0;
+  /** Protects next_instance_. */
+  std::mutex next_instance_latch_;
+};
+
+}  // namespace bustub
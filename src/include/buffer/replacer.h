@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManager can be constructed with. */
+enum class ReplacerType { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +48,19 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame altogether, e.g. because the page it held was deleted and the frame went back to the free list.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Lists frames that are about to be victimized, without removing them from the replacer.
+   * @param max_frames the maximum number of frames to list
+   * @return up to max_frames frames, in the order Victim would most likely return them
+   */
+  virtual std::vector<frame_id_t> EvictionCandidates(size_t max_frames) { return {}; }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
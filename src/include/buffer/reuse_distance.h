@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// reuse_distance.h
+//
+// Identification: src/include/buffer/reuse_distance.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "buffer/page_access_trace.h"
+
+namespace bustub {
+
+/**
+ * The reuse of the pages of a trace, or of those of one owner in it. The reuse distance of an access is the number of
+ * distinct other pages accessed since the previous access to its page, so an LRU buffer pool of N frames holds the
+ * page iff its distance is below N. The reuse time is the number of accesses since the previous one to the page.
+ */
+struct ReuseProfile {
+  /**
+   * @return the fraction of the accesses an LRU buffer pool of pool_size frames shared by the whole trace would find
+   * resident; the first access to each page always misses
+   */
+  double HitRatio(size_t pool_size) const;
+
+  /**
+   * @return the average number of distinct pages accessed in a window of the trace of window accesses, by the
+   * Denning-Schwartz estimate, the mean over all the accesses of min(reuse time, window) divided by the accesses of
+   * the trace; a first access counts an infinite reuse time
+   * @param num_trace_accesses the accesses of the whole trace, so that the working sets of the owners add up
+   */
+  double WorkingSetSize(uint64_t window, uint64_t num_trace_accesses) const;
+
+  /** @return the accesses whose reuse distance is in [2^(i-1), 2^i), at i; those of distance 0 at 0 */
+  std::vector<uint64_t> DistanceLog2Histogram() const;
+
+  uint64_t num_accesses_{0};
+  /** The first accesses to the pages, i.e. the distinct pages. */
+  uint64_t num_cold_{0};
+  /** The accesses of every finite reuse distance, by distance. */
+  std::vector<uint64_t> distance_counts_;
+  /** The accesses of every finite reuse time, by time. */
+  std::map<uint64_t, uint64_t> time_counts_;
+};
+
+/** The reuse profiles of a trace: of all of it, and of the accesses to the pages of each owner. */
+struct ReuseAnalysis {
+  /** Computes the reuse distances of the accesses, in order, in O(n log n). */
+  explicit ReuseAnalysis(const std::vector<PageAccess> &accesses);
+
+  ReuseProfile total_;
+  /** By owner; INVALID_PAGE_ID for the pages of no owner. */
+  std::map<page_id_t, ReuseProfile> owners_;
+};
+
+}  // namespace bustub
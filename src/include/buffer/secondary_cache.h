@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// secondary_cache.h
+//
+// Identification: src/include/buffer/secondary_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * SecondaryCache keeps copies of clean pages evicted from a buffer pool in a file on a faster device than the
+ * database file, e.g. a local SSD in front of network storage, so that a later miss reads them from there.
+ *
+ * The file is a ring of page slots, filled in turn: a page evicted takes the next slot, and the page that slot held
+ * is forgotten. Only the index, a hash map from page ids to slots, lives in memory. The cache is exclusive: the buffer
+ * pool takes a page out of it whenever the page enters the pool, so a page that is dirtied and written back to the
+ * database file never has a stale copy left here. The contents of the file do not outlive the cache.
+ *
+ * Reserve and Take are called under the latch of the buffer pool, in the same order as the pool hands frames around;
+ * the slow parts, Write and Read, run without it. A slot reused while being read, or a page taken while being
+ * written, is told apart by the version of the slot, bumped with every reuse.
+ */
+class SecondaryCache {
+ public:
+  /** A slot handed out by Reserve or Take, with the version it had then. */
+  struct Ticket {
+    size_t slot_{0};
+    uint64_t version_{0};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /**
+   * Creates the cache file, discarding what it held.
+   * @param file_name the cache file
+   * @param num_pages the pages the cache holds
+   */
+  SecondaryCache(const std::string &file_name, size_t num_pages);
+
+  /** Closes and removes the cache file. */
+  ~SecondaryCache();
+
+  DISALLOW_COPY_AND_MOVE(SecondaryCache);
+
+  /**
+   * Reserves the next slot for a clean page leaving the buffer pool, forgetting the page it held.
+   * @param page_id the page evicted
+   * @return the slot to Write the page to
+   */
+  Ticket Reserve(page_id_t page_id);
+
+  /**
+   * Writes a page to its reserved slot. The copy can be read once written, unless the page was taken meanwhile.
+   * @param ticket the slot, from Reserve
+   * @param page_data the page, PAGE_SIZE bytes
+   */
+  void Write(const Ticket &ticket, const char *page_data);
+
+  /**
+   * Takes a page out of the cache, as it enters the buffer pool.
+   * @param page_id the page
+   * @param[out] ticket the slot to Read the copy from
+   * @return true if a copy was found
+   */
+  bool Take(page_id_t page_id, Ticket *ticket);
+
+  /**
+   * Reads a copy that Take found.
+   * @param ticket the slot, from Take
+   * @param[out] page_data where to read the page, PAGE_SIZE bytes
+   * @return false if the slot was reused meanwhile, or could not be read; the page is then to be read from disk
+   */
+  bool Read(const Ticket &ticket, char *page_data);
+
+  /** @return the pages the cache holds */
+  size_t GetNumPages() const { return num_pages_; }
+
+  /** @return the pages the cache holds a copy of */
+  size_t Size();
+
+ private:
+  const std::string file_name_;
+  const size_t num_pages_;
+  int fd_{-1};
+  /** Protects everything below. */
+  std::mutex latch_;
+  /** The slot of each cached page, with a copy written or being written. */
+  std::unordered_map<page_id_t, size_t> index_;
+  /** The page each slot was last reserved for, INVALID_PAGE_ID once taken. */
+  std::unique_ptr<page_id_t[]> slot_pages_;
+  /** Bumped every time a slot is reserved. */
+  std::unique_ptr<uint64_t[]> slot_versions_;
+  /** True once the copy of the slot's page is written. */
+  std::unique_ptr<bool[]> slot_ready_;
+  /** The next slot to reserve. */
+  size_t next_slot_{0};
+};
+
+}  // namespace bustub
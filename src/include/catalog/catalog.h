@@ -1,15 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "catalog/materialized_view.h"
+#include "catalog/partition_scheme.h"
 #include "catalog/schema.h"
+#include "catalog/table_statistics.h"
+#include "common/memory_tracker.h"
+#include "common/thread_pool.h"
 #include "storage/index/b_plus_tree_index.h"
 #include "storage/index/index.h"
+#include "storage/table/morsel_source.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -21,22 +30,43 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** A map of the catalog, counted in its memory. */
+template <typename Key, typename Value>
+using CatalogMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                      TrackedAllocator<std::pair<const Key, Value>, MemoryTag::CATALOG>>;
+
 /**
  * Metadata about a table.
+ *
+ * A partitioned table has no heap of its own (table_ is nullptr): its tuples are stored in its partitions, each a table
+ * of the catalog of the same schema, see Catalog::CreatePartitionedTable.
  */
-struct TableMetadata {
+struct TableMetadata : public TrackedObject<MemoryTag::CATALOG> {
   TableMetadata(Schema schema, std::string name, std::unique_ptr<TableHeap> &&table, table_oid_t oid)
-      : schema_(std::move(schema)), name_(std::move(name)), table_(std::move(table)), oid_(oid) {}
+      : schema_(std::move(schema)), name_(std::move(name)), table_(std::move(table)), oid_(oid), stats_(&schema_) {}
   Schema schema_;
   std::string name_;
   std::unique_ptr<TableHeap> table_;
   table_oid_t oid_;
+  /** The statistics of the table, see Catalog::Analyze. */
+  TableStatistics stats_;
+  /** How the tuples of a partitioned table are spread over its partitions, nullptr if the table is not partitioned. */
+  std::unique_ptr<PartitionScheme> partition_scheme_;
+  /** The partitions of a partitioned table, in the order of its scheme. */
+  std::vector<TableMetadata *> partitions_;
+  /** The materialized views of the table, which its writes record their changes for, see MaterializedView. */
+  std::vector<MaterializedView *> views_;
+  /** Whether the writes to the table are logged, and what a persistent catalog keeps of it on restart. */
+  TableDurability durability_{TableDurability::LOGGED};
+
+  /** @return true if the tuples of the table are stored in its partitions */
+  bool IsPartitioned() const { return partition_scheme_ != nullptr; }
 };
 
 /**
  * Metadata about a index
  */
-struct IndexInfo {
+struct IndexInfo : public TrackedObject<MemoryTag::CATALOG> {
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
             std::string table_name, size_t key_size)
       : key_schema_(std::move(key_schema)),
@@ -54,40 +84,161 @@ struct IndexInfo {
 };
 
 /**
- * Catalog is a non-persistent catalog that is designed for the executor to use.
+ * Catalog is a catalog that is designed for the executor to use.
  * It handles table creation and table lookup.
+ *
+ * A persistent catalog stores the schemas and the first pages of its tables, and the definitions of its indexes, in a
+ * chain of catalog pages that the header page records under CATALOG_RECORD_NAME, rewritten and flushed whenever a
+ * table or an index is created. Reopened, it opens the table heaps from their first pages and the B+ trees from their
+ * root pages, which the header page records under the names of the indexes, without reading the tables. The indexes of
+ * a persistent catalog must be B+ trees of GenericKeys to RIDs, which it knows how to open again from their key size.
+ * The statistics of the tables are not stored; see Analyze.
+ *
+ * A table or an index can be created in a tablespace of the disk manager, e.g. to put it on a device of its own. The
+ * tablespace is not stored either: the pages of an object are allocated in the tablespace of its first page, reopened
+ * or not.
+ *
+ * The heap of an unlogged or a temporary table is created without the log manager, see TableDurability. A persistent
+ * catalog reopens an unlogged table truncated, and its indexes empty; it does not store temporary tables at all.
  */
 class Catalog {
  public:
+  /** The name of the record of the first catalog page in the header page. */
+  static constexpr const char *CATALOG_RECORD_NAME = "__bustub_catalog";
+
   /**
    * Creates a new catalog object.
    * @param bpm the buffer pool manager backing tables created by this catalog
    * @param lock_manager the lock manager in use by the system
    * @param log_manager the log manager in use by the system
+   * @param persistent true to store the catalog in the database, opening the one stored there if any; the header
+   * page must exist
    */
-  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager)
-      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {}
+  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager, bool persistent = false)
+      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager}, persistent_{persistent} {
+    if (persistent_) {
+      Load();
+    }
+  }
 
   /**
    * Create a new table and return its metadata.
    * @param txn the transaction in which the table is being created
    * @param table_name the name of the new table
    * @param schema the schema of the new table
+   * @param format the layout of the pages of the table, PAX for tables mostly scanned a few columns at a time
+   * @param tablespace the tablespace of the disk manager the pages of the table are allocated in
+   * @param durability whether the writes to the table are logged, e.g. not those of a staging table
+   * @return a pointer to the metadata of the new table
+   */
+  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                             TableFormat format = TableFormat::ROW, tablespace_id_t tablespace = DEFAULT_TABLESPACE,
+                             TableDurability durability = TableDurability::LOGGED) {
+    BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
+    table_oid_t table_oid = next_table_oid_++;
+    std::unique_ptr<TableHeap> table;
+    {
+      // The table's first page is allocated here, and the pages of the table follow it.
+      DiskManager::TablespaceScope tablespace_scope(tablespace);
+      table = std::make_unique<TableHeap>(bpm_, lock_manager_, LogManagerOf(durability), txn,
+                                          format == TableFormat::PAX ? &schema : nullptr);
+    }
+    table->SetTableOid(table_oid);
+    names_[table_name] = table_oid;
+    tables_[table_oid] = std::make_unique<TableMetadata>(schema, table_name, std::move(table), table_oid);
+    tables_[table_oid]->durability_ = durability;
+    tables_[table_oid]->table_->SetSchema(&tables_[table_oid]->schema_);
+    if (persistent_ && durability != TableDurability::TEMPORARY) {
+      Persist();
+    }
+    return tables_[table_oid].get();
+  }
+
+  /**
+   * Create a new partitioned table and return its metadata. Each partition is a table of its own, named after the
+   * table and its number, e.g. orders$0, with its own heap, statistics and local indexes, see CreateLocalIndexes; the
+   * partitioned table only spreads the tuples inserted into it over them, and scans those that may hold the tuples a
+   * scan looks for, see SeqScanExecutor. A persistent catalog does not store partitioned tables.
+   * @param txn the transaction in which the table is being created
+   * @param table_name the name of the new table
+   * @param schema the schema of the new table, and of its partitions
+   * @param scheme how the tuples are spread over the partitions, by a key column of schema
+   * @param format the layout of the pages of the partitions
+   * @param tablespace the tablespace of the disk manager the pages of the partitions are allocated in
    * @return a pointer to the metadata of the new table
    */
-  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
+  TableMetadata *CreatePartitionedTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                                        const PartitionScheme &scheme, TableFormat format = TableFormat::ROW,
+                                        tablespace_id_t tablespace = DEFAULT_TABLESPACE) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
-    return nullptr;
+    BUSTUB_ASSERT(!persistent_, "A persistent catalog does not store partitioned tables.");
+    BUSTUB_ASSERT(scheme.GetColIdx() < schema.GetColumnCount(), "The key of the partitions is a column of the table.");
+    std::vector<TableMetadata *> partitions;
+    for (size_t i = 0; i < scheme.GetNumPartitions(); i++) {
+      partitions.push_back(CreateTable(txn, PartitionName(table_name, i), schema, format, tablespace));
+    }
+    table_oid_t table_oid = next_table_oid_++;
+    names_[table_name] = table_oid;
+    tables_[table_oid] = std::make_unique<TableMetadata>(schema, table_name, nullptr, table_oid);
+    tables_[table_oid]->partition_scheme_ = std::make_unique<PartitionScheme>(scheme);
+    tables_[table_oid]->partitions_ = std::move(partitions);
+    return tables_[table_oid].get();
+  }
+
+  /** @return the name of a partition of a partitioned table */
+  static std::string PartitionName(const std::string &table_name, size_t partition) {
+    return table_name + "$" + std::to_string(partition);
   }
 
-  /** @return table metadata by name */
-  TableMetadata *GetTable(const std::string &table_name) { return nullptr; }
+  /** @return table metadata by name, throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(const std::string &table_name) { return GetTable(names_.at(table_name)); }
 
-  /** @return table metadata by oid */
-  TableMetadata *GetTable(table_oid_t table_oid) { return nullptr; }
+  /** @return table metadata by oid, throws std::out_of_range if there is no such table */
+  TableMetadata *GetTable(table_oid_t table_oid) { return tables_.at(table_oid).get(); }
+
+  /** @return the metadata of all the tables */
+  std::vector<TableMetadata *> GetTables() {
+    std::vector<TableMetadata *> tables;
+    for (const auto &[table_oid, table_metadata] : tables_) {
+      tables.push_back(table_metadata.get());
+    }
+    return tables;
+  }
+
+  /**
+   * Create a new materialized view of an aggregation over a table, aggregate the tuples of the table into it, and
+   * return it. The writes to the table from then on are folded into the view as they commit, so the view is meant to
+   * be created while no transaction is writing to the table. A persistent catalog does not store views.
+   * @param txn the transaction in which the view is being created, which reads the table
+   * @param view_name the name of the new view
+   * @param plan the aggregation, supported by MaterializedView, which must outlive the view
+   * @return a pointer to the new view
+   */
+  MaterializedView *CreateMaterializedView(Transaction *txn, const std::string &view_name,
+                                           const AggregationPlanNode *plan) {
+    BUSTUB_ASSERT(views_.count(view_name) == 0, "View names should be unique!");
+    BUSTUB_ASSERT(!persistent_, "A persistent catalog does not store views.");
+    BUSTUB_ASSERT(MaterializedView::Supports(plan), "The view cannot maintain the aggregation.");
+    TableMetadata *table_metadata = GetTable(MaterializedView::TableOidOf(plan));
+    auto view = std::make_unique<MaterializedView>(view_name, plan, &table_metadata->schema_);
+    std::vector<TableMetadata *> tables =
+        table_metadata->IsPartitioned() ? table_metadata->partitions_ : std::vector<TableMetadata *>{table_metadata};
+    for (TableMetadata *table : tables) {
+      for (auto iter = table->table_->Begin(txn); iter != table->table_->End(); ++iter) {
+        view->Apply(*iter, true);
+      }
+    }
+    table_metadata->views_.push_back(view.get());
+    return (views_[view_name] = std::move(view)).get();
+  }
+
+  /** @return the materialized view by name, throws std::out_of_range if there is no such view */
+  MaterializedView *GetMaterializedView(const std::string &view_name) { return views_.at(view_name).get(); }
 
   /**
    * Create a new index, populate existing data of the table and return its metadata.
+   * The keys of the existing tuples are sorted here, in parallel on the thread pool of the catalog if it has one, and
+   * bulk loaded into the index, see ReadIndexEntries.
    * @param txn the transaction in which the table is being created
    * @param index_name the name of the new index
    * @param table_name the name of the table
@@ -95,37 +246,265 @@ class Catalog {
    * @param key_schema the schema of the key
    * @param key_attrs key attributes
    * @param keysize size of the key
+   * @param unique_keys false for an index that maps each key to all of the tuples with that key
+   * @param include_attrs the INCLUDE columns, stored in the index after the key, see IndexMetadata; keysize must
+   * leave room for them
+   * @param tablespace the tablespace of the disk manager the pages of the index are allocated in
    * @return a pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         size_t keysize) {
-    return nullptr;
+                         size_t keysize, bool unique_keys = true, const std::vector<uint32_t> &include_attrs = {},
+                         tablespace_id_t tablespace = DEFAULT_TABLESPACE) {
+    BUSTUB_ASSERT(index_names_[table_name].count(index_name) == 0, "Index names should be unique per table!");
+    BUSTUB_ASSERT(!GetTable(table_name)->IsPartitioned(), "A partitioned table has local indexes only.");
+    BUSTUB_ASSERT(!persistent_ || (std::is_same_v<KeyType, GenericKey<sizeof(KeyType)>> &&
+                                   std::is_same_v<ValueType, RID> &&
+                                   std::is_same_v<KeyComparator, GenericComparator<sizeof(KeyType)>>),
+                  "A persistent catalog only opens B+ trees of generic keys again.");
+    TableMetadata *table_metadata = GetTable(table_name);
+    auto *metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs, unique_keys, include_attrs);
+    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(metadata, bpm_);
+    index->SetTablespace(tablespace);
+
+    std::vector<std::pair<KeyType, ValueType>> entries =
+        ReadIndexEntries<KeyType, ValueType, KeyComparator>(txn, table_metadata->table_.get(), schema, metadata);
+    index->BulkLoad(entries.cbegin(), entries.cend(), txn);
+
+    index_oid_t index_oid = next_index_oid_++;
+    index_names_[table_name][index_name] = index_oid;
+    indexes_[index_oid] =
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    if (persistent_) {
+      Persist();
+    }
+    return indexes_[index_oid].get();
   }
 
-  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) { return nullptr; }
+  /**
+   * Creates a local index on every partition of a partitioned table, of the same name and key, see CreateIndex; a key
+   * is only unique within its partition, unless the partitions are by the key itself.
+   * @return the metadata of the indexes, in the order of the partitions
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  std::vector<IndexInfo *> CreateLocalIndexes(Transaction *txn, const std::string &index_name,
+                                              const std::string &table_name, const Schema &schema,
+                                              const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                                              size_t keysize, bool unique_keys = true,
+                                              const std::vector<uint32_t> &include_attrs = {},
+                                              tablespace_id_t tablespace = DEFAULT_TABLESPACE) {
+    std::vector<IndexInfo *> indexes;
+    for (TableMetadata *partition : GetTable(table_name)->partitions_) {
+      indexes.push_back(CreateIndex<KeyType, ValueType, KeyComparator>(txn, index_name, partition->name_, schema,
+                                                                       key_schema, key_attrs, keysize, unique_keys,
+                                                                       include_attrs, tablespace));
+    }
+    return indexes;
+  }
 
-  IndexInfo *GetIndex(index_oid_t index_oid) { return nullptr; }
+  /** Sets the worker threads CreateIndex reads and sorts the keys of a table on, nullptr for the calling thread. */
+  void SetThreadPool(ThreadPool *thread_pool) { thread_pool_ = thread_pool; }
 
-  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) { return std::vector<IndexInfo *>(); }
+  /** @return index metadata by index name and table name, throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    return GetIndex(index_names_.at(table_name).at(index_name));
+  }
+
+  /** @return index metadata by oid, throws std::out_of_range if there is no such index */
+  IndexInfo *GetIndex(index_oid_t index_oid) { return indexes_.at(index_oid).get(); }
+
+  /**
+   * Compresses the cold pages of a table, see TableHeap::CompressPages, and points its indexes to the tuples moved.
+   * @param txn the transaction compressing the table, which holds the table alone
+   * @param table_name the name of the table
+   */
+  void CompressTable(Transaction *txn, const std::string &table_name) {
+    TableMetadata *table_metadata = GetTable(table_name);
+    BUSTUB_ASSERT(!table_metadata->IsPartitioned(), "The partitions of a partitioned table are compressed one by one.");
+    std::vector<std::pair<RID, RID>> moves;
+    table_metadata->table_->CompressPages(&table_metadata->schema_, txn, &moves);
+    std::vector<IndexInfo *> indexes = GetTableIndexes(table_name);
+    if (indexes.empty()) {
+      return;
+    }
+    Tuple tuple;
+    for (const auto &[old_rid, new_rid] : moves) {
+      table_metadata->table_->GetTuple(new_rid, &tuple, txn);
+      for (IndexInfo *index_info : indexes) {
+        Index *index = index_info->index_.get();
+        Tuple key = tuple.KeyFromTuple(table_metadata->schema_, *index->GetKeySchema(), index->GetKeyAttrs());
+        index->DeleteEntry(key, old_rid, txn);
+        index->InsertEntry(key, new_rid, txn);
+      }
+    }
+  }
+
+  /**
+   * Computes the statistics of a table from its tuples, like ANALYZE; see TableStatistics. Those of a partitioned
+   * table are computed from the tuples of all its partitions, after the statistics of each partition.
+   * @param txn the transaction reading the table
+   * @param table_name the name of the table
+   * @param sample_fraction the fraction of the pages of the table to read, all of them by default, see TableSample
+   * @return the statistics of the table
+   */
+  const TableStatistics &Analyze(Transaction *txn, const std::string &table_name, double sample_fraction = 1) {
+    TableMetadata *table_metadata = GetTable(table_name);
+    std::vector<TableHeap *> heaps;
+    for (TableMetadata *partition : table_metadata->partitions_) {
+      partition->stats_.Analyze({partition->table_.get()}, bpm_, txn, sample_fraction);
+      heaps.push_back(partition->table_.get());
+    }
+    if (!table_metadata->IsPartitioned()) {
+      heaps.push_back(table_metadata->table_.get());
+    }
+    table_metadata->stats_.Analyze(heaps, bpm_, txn, sample_fraction);
+    return table_metadata->stats_;
+  }
+
+  /** @return the metadata of all the indexes of the table */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    std::vector<IndexInfo *> table_indexes;
+    auto iter = index_names_.find(table_name);
+    if (iter != index_names_.end()) {
+      for (const auto &[index_name, index_oid] : iter->second) {
+        table_indexes.push_back(indexes_.at(index_oid).get());
+      }
+    }
+    return table_indexes;
+  }
 
  private:
-  [[maybe_unused]] BufferPoolManager *bpm_;
-  [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  /** Number of pages per morsel of the parallel scan of a table by CreateIndex. */
+  static constexpr size_t INDEX_BUILD_MORSEL_SIZE = 16;
+  /** Number of frames of the buffer ring of each worker of that scan. */
+  static constexpr size_t INDEX_BUILD_BUFFER_RING_SIZE = 32;
+
+  /**
+   * Reads the index entries of every tuple of a table and sorts them by key; of equal keys, the tuple found first in
+   * the chain comes first, so that a unique index keeps it, as if the tuples were inserted one by one.
+   *
+   * With a thread pool, the workers scan the table a morsel at a time, each sorting the entries it read into a run,
+   * and the runs are merged two at a time, the merges of a round in parallel. A transaction that takes row locks or
+   * records its reads, which are not thread safe, reads the table on the calling thread instead.
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  std::vector<std::pair<KeyType, ValueType>> ReadIndexEntries(Transaction *txn, TableHeap *table, const Schema &schema,
+                                                              IndexMetadata *metadata) {
+    KeyComparator comparator(metadata->GetSearchKeySchema());
+    auto key_less = [&comparator](const auto &a, const auto &b) { return comparator(a.first, b.first) < 0; };
+    auto make_entry = [&](const Tuple &tuple) {
+      KeyType index_key;
+      index_key.SetFromKey(tuple.KeyFromTuple(schema, *metadata->GetKeySchema(), metadata->GetKeyAttrs()));
+      return std::pair<KeyType, ValueType>(index_key, tuple.GetRid());
+    };
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    const bool unlocked = !enable_logging || txn->ReadsVersions() || txn->IsRowLockCovered(table->GetTableOid(), false);
+    if (thread_pool_ == nullptr || thread_pool_->Size() == 1 || txn->IsOptimistic() || !unlocked) {
+      for (auto iter = table->BeginPageBatch(txn); iter != table->End(); ++iter) {
+        entries.push_back(make_entry(*iter));
+      }
+      std::stable_sort(entries.begin(), entries.end(), key_less);
+      return entries;
+    }
+
+    // An entry with the index of the morsel it was read in, which orders the entries of equal keys of different runs.
+    struct MorselEntry {
+      std::pair<KeyType, ValueType> entry_;
+      size_t morsel_;
+    };
+    auto entry_less = [&comparator](const MorselEntry &a, const MorselEntry &b) {
+      const int cmp = comparator(a.entry_.first, b.entry_.first);
+      return cmp < 0 || (cmp == 0 && a.morsel_ < b.morsel_);
+    };
+    MorselSource morsels(table, INDEX_BUILD_MORSEL_SIZE);
+    std::vector<std::vector<MorselEntry>> runs(thread_pool_->Size());
+    thread_pool_->RunAll(runs.size(), [&](size_t worker) {
+      BufferRing ring(INDEX_BUILD_BUFFER_RING_SIZE);
+      std::vector<page_id_t> pages;
+      std::vector<Tuple> tuples;
+      size_t morsel;
+      std::vector<MorselEntry> &run = runs[worker];
+      while (morsels.Next(&pages, &ring, &morsel)) {
+        for (page_id_t page_id : pages) {
+          tuples.clear();
+          table->ReadPageTuples(page_id, txn, &ring, &tuples);
+          for (const Tuple &tuple : tuples) {
+            run.push_back(MorselEntry{make_entry(tuple), morsel});
+          }
+        }
+      }
+      // A worker claims its morsels in chain order, so a stable sort keeps the entries of equal keys in chain order.
+      std::stable_sort(run.begin(), run.end(), entry_less);
+    });
+    while (runs.size() > 1) {
+      std::vector<std::vector<MorselEntry>> merged((runs.size() + 1) / 2);
+      thread_pool_->RunAll(merged.size(), [&](size_t i) {
+        if (2 * i + 1 == runs.size()) {
+          merged[i] = std::move(runs[2 * i]);
+          return;
+        }
+        std::vector<MorselEntry> &left = runs[2 * i];
+        std::vector<MorselEntry> &right = runs[2 * i + 1];
+        merged[i].reserve(left.size() + right.size());
+        std::merge(std::make_move_iterator(left.begin()), std::make_move_iterator(left.end()),
+                   std::make_move_iterator(right.begin()), std::make_move_iterator(right.end()),
+                   std::back_inserter(merged[i]), entry_less);
+        std::vector<MorselEntry>().swap(left);
+        std::vector<MorselEntry>().swap(right);
+      });
+      runs = std::move(merged);
+    }
+    std::vector<MorselEntry> &sorted = runs[0];
+    entries.resize(sorted.size());
+    const size_t chunk = (sorted.size() + thread_pool_->Size() - 1) / thread_pool_->Size();
+    thread_pool_->RunAll(thread_pool_->Size(), [&](size_t worker) {
+      for (size_t i = worker * chunk; i < std::min(sorted.size(), (worker + 1) * chunk); i++) {
+        entries[i] = sorted[i].entry_;
+      }
+    });
+    return entries;
+  }
+
+  /** Opens the tables and the indexes of the catalog stored in the database, if there is one. */
+  void Load();
+
+  /** Stores the catalog in the catalog pages, and flushes them and the header page. */
+  void Persist();
+
+  /**
+   * @return the B+ tree index stored in the database with keys of key_size bytes, or a new empty one in its place if
+   * is_empty, for an index of a truncated table
+   */
+  std::unique_ptr<Index> OpenIndex(IndexMetadata *metadata, size_t key_size, bool is_empty);
+
+  /** @return the log manager of the heap of a table, nullptr if its writes are not logged */
+  LogManager *LogManagerOf(TableDurability durability) {
+    return durability == TableDurability::LOGGED ? log_manager_ : nullptr;
+  }
+
+  BufferPoolManager *bpm_;
+  LockManager *lock_manager_;
+  LogManager *log_manager_;
+  const bool persistent_;
+  /** The chain of catalog pages, in order. */
+  std::vector<page_id_t> catalog_page_ids_;
 
   /** tables_ : table identifiers -> table metadata. Note that tables_ owns all table metadata. */
-  std::unordered_map<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
+  CatalogMap<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
   /** names_ : table names -> table identifiers */
-  std::unordered_map<std::string, table_oid_t> names_;
+  CatalogMap<std::string, table_oid_t> names_;
   /** The next table identifier to be used. */
   std::atomic<table_oid_t> next_table_oid_{0};
   /** indexes_: index identifiers -> index metadata. Note that indexes_ owns all index metadata */
-  std::unordered_map<index_oid_t, std::unique_ptr<IndexInfo>> indexes_;
+  CatalogMap<index_oid_t, std::unique_ptr<IndexInfo>> indexes_;
   /** index_names_: table name -> index names -> index identifiers */
-  std::unordered_map<std::string, std::unordered_map<std::string, index_oid_t>> index_names_;
+  CatalogMap<std::string, CatalogMap<std::string, index_oid_t>> index_names_;
   /** The next index identifier to be used */
   std::atomic<index_oid_t> next_index_oid_{0};
+  /** The worker threads indexes are built on, nullptr to build them on the calling thread. */
+  ThreadPool *thread_pool_{nullptr};
+  /** views_: view names -> materialized views. */
+  CatalogMap<std::string, std::unique_ptr<MaterializedView>> views_;
 };
 }  // namespace bustub
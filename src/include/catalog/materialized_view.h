@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialized_view.h
+//
+// Identification: src/include/catalog/materialized_view.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * MaterializedView holds the groups of an aggregation over a table, the base table of the view, and keeps them up to
+ * date as the table changes, so that reading the view is a scan of its groups rather than an aggregation of the table.
+ *
+ * The writes to the base table record the tuples they insert and delete in their transaction (an update is a delete
+ * and an insert), see RecordDeltas, and the commit of the transaction folds them into the groups of the view, see
+ * CommitDeltas; an abort drops them. A group keeps the number of its tuples, dropped once it is zero, and the state
+ * of every aggregate, which can take tuples out as well as in: the sum of the non-NULL inputs of a SUM, the number of
+ * NULL inputs, and, for MIN, MAX and COUNT DISTINCT, every distinct non-NULL input with its number of tuples. The
+ * results are those of AggregationExecutor, except that groups of NULL keys are one group.
+ *
+ * The view reads the latest committed groups, not those of the snapshot of a transaction.
+ */
+class MaterializedView {
+ public:
+  /**
+   * @return true if a view can maintain the aggregation: its child is a sequential scan of a table without a sample,
+   * and none of its aggregates is an approximate distinct count, which cannot take tuples out
+   */
+  static bool Supports(const AggregationPlanNode *plan);
+
+  /** @return the table the sequential scan under a supported aggregation scans */
+  static table_oid_t TableOidOf(const AggregationPlanNode *plan);
+
+  /**
+   * Creates a view without groups; the plan, and the expressions and schemas it refers to, must outlive the view.
+   * @param name the name of the view
+   * @param plan the aggregation of the view, supported
+   * @param table_schema the schema of the base table
+   */
+  MaterializedView(std::string name, const AggregationPlanNode *plan, const Schema *table_schema);
+
+  /** @return the name of the view */
+  const std::string &GetName() const { return name_; }
+
+  /** @return the aggregation of the view, whose output schema is that of the tuples of the view */
+  const AggregationPlanNode *GetPlan() const { return plan_; }
+
+  /** @return the number of groups of the view */
+  size_t Size();
+
+  /** Folds a tuple of the base table into its group, or out of it. Not thread safe, see CommitDeltas. */
+  void Apply(const Tuple &tuple, bool insert);
+
+  /** @return the tuples of the groups that satisfy the having clause of the aggregation */
+  std::vector<Tuple> Read();
+
+  /** Records a tuple written to a base table in the transaction, for each view of the table. */
+  static void RecordDeltas(Transaction *txn, const std::vector<MaterializedView *> &views, const Tuple &tuple,
+                           bool insert);
+
+  /** Folds the changes recorded by a committed transaction into their views, a view at a time, and drops them. */
+  static void CommitDeltas(std::vector<ViewDelta> *deltas);
+
+ private:
+  /** Orders values, all of one type. */
+  struct ValueLess {
+    bool operator()(const Value &a, const Value &b) const { return a.CompareLessThan(b) == CmpBool::CmpTrue; }
+  };
+
+  /** Compares group keys, NULL values equal to one another. */
+  struct KeyEqual {
+    bool operator()(const AggregateKey &a, const AggregateKey &b) const;
+  };
+
+  /** The state of an aggregate of a group. */
+  struct AggregateState {
+    /** The sum of the non-NULL inputs, of a SUM. */
+    Value sum_;
+    /** The number of NULL inputs. */
+    size_t num_nulls_{0};
+    /** The distinct non-NULL inputs and their numbers of tuples, of a MIN, a MAX or a COUNT DISTINCT. */
+    std::map<Value, size_t, ValueLess> values_;
+  };
+
+  struct Group {
+    size_t num_tuples_{0};
+    std::vector<AggregateState> states_;
+  };
+
+  /** @return the values of the aggregates of a group */
+  std::vector<Value> AggregatesOf(const Group &group) const;
+
+  std::string name_;
+  const AggregationPlanNode *plan_;
+  const Schema *table_schema_;
+  /** The predicate and the output schema of the scan under the aggregation. */
+  const AbstractExpression *predicate_;
+  const Schema *scan_schema_;
+  /** Protects the groups. */
+  std::mutex latch_;
+  std::unordered_map<AggregateKey, Group, std::hash<AggregateKey>, KeyEqual> groups_;
+};
+
+}  // namespace bustub
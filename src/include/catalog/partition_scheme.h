@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// partition_scheme.h
+//
+// Identification: src/include/catalog/partition_scheme.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "type/value.h"
+
+namespace bustub {
+
+/** How the tuples of a partitioned table are spread over its partitions. */
+enum class PartitionType : uint8_t { HASH, RANGE };
+
+/**
+ * PartitionScheme maps the tuples of a partitioned table to its partitions by the value of a key column.
+ *
+ * Under HASH, a tuple goes to the partition of the hash of its key modulo the number of partitions, which spreads the
+ * keys, and so the inserts, evenly over the partitions. Under RANGE, the partitions hold consecutive ranges of keys,
+ * split at ascending bounds: partition 0 holds the keys below the first bound, partition i the keys from bound i - 1
+ * up to bound i, and the last partition the keys from the last bound up. Either way, the tuples with a NULL key go to
+ * partition 0.
+ */
+class PartitionScheme {
+ public:
+  /**
+   * Creates a HASH scheme.
+   * @param col_idx the key column, in the schema of the table
+   * @param key_type the type of the key column
+   * @param num_partitions the number of partitions, at least 1
+   */
+  PartitionScheme(uint32_t col_idx, TypeId key_type, size_t num_partitions);
+
+  /**
+   * Creates a RANGE scheme.
+   * @param col_idx the key column, in the schema of the table
+   * @param bounds the ascending, non NULL keys the partitions are split at, one less than the partitions
+   */
+  PartitionScheme(uint32_t col_idx, std::vector<Value> bounds);
+
+  /** @return how the tuples are spread over the partitions */
+  PartitionType GetType() const { return type_; }
+
+  /** @return the key column */
+  uint32_t GetColIdx() const { return col_idx_; }
+
+  /** @return the number of partitions */
+  size_t GetNumPartitions() const { return num_partitions_; }
+
+  /** @return the keys the partitions of a RANGE scheme are split at */
+  const std::vector<Value> &GetBounds() const { return bounds_; }
+
+  /** @return the partition of the tuples with a key */
+  size_t PartitionOf(const Value &key) const;
+
+  /**
+   * Rules out the partitions that hold no key of a range of keys.
+   * @param low the least key of the range, nullptr if it has none; not NULL
+   * @param high the greatest key of the range, nullptr if it has none; not NULL
+   * @param[in,out] candidates a flag per partition, cleared for the partitions ruled out
+   */
+  void Prune(const Value *low, const Value *high, std::vector<bool> *candidates) const;
+
+ private:
+  /** @return true if key is compared with the keys of the table exactly as is: hashed or compared with the bounds */
+  bool IsComparable(const Value &key) const;
+
+  PartitionType type_;
+  uint32_t col_idx_;
+  /** The type of the key column of a HASH scheme. */
+  TypeId key_type_{TypeId::INVALID};
+  size_t num_partitions_;
+  std::vector<Value> bounds_;
+};
+
+}  // namespace bustub
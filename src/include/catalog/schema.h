@@ -21,6 +21,17 @@
 
 namespace bustub {
 
+/**
+ * Where the value of a column is in a tuple, precomputed by Schema so that Tuple reaches it by pointer arithmetic
+ * alone, without going through the Column.
+ */
+struct ColumnLayout {
+  /** The offset of the value in the tuple, or of the offset of the value if it is not inlined. */
+  uint32_t offset_;
+  TypeId type_;
+  bool is_inlined_;
+};
+
 class Schema {
  public:
   /**
@@ -48,6 +59,9 @@ class Schema {
    */
   const Column &GetColumn(const uint32_t col_idx) const { return columns_[col_idx]; }
 
+  /** @return where the value of a column is in a tuple of the schema */
+  const ColumnLayout &GetColumnLayout(const uint32_t col_idx) const { return layouts_[col_idx]; }
+
   /**
    * @param col_name name of the wanted column
    * @return the column with the given name
@@ -98,6 +112,9 @@ class Schema {
 
   /** Indices of all uninlined columns. */
   std::vector<uint32_t> uninlined_columns_;
+
+  /** The layouts of the columns, one after the other. */
+  std::vector<ColumnLayout> layouts_;
 };
 
 }  // namespace bustub
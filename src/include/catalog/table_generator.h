@@ -1,9 +1,12 @@
 #pragma once
 
+#include <optional>
+#include <random>
 #include <utility>
 #include <vector>
 
 #include "catalog/catalog.h"
+#include "common/util/zipf_distribution.h"
 #include "execution/executor_context.h"
 #include "storage/table/table_heap.h"
 
@@ -25,12 +28,15 @@ class TableGenerator {
    */
   void GenerateTestTables();
 
- private:
   /**
-   * Enumeration to characterize the distribution of values in a given column
+   * Enumeration to characterize the distribution of values in a given column. The Zipfian distributions skew towards
+   * the min of the column, with a theta of 0.5 to 0.99, see ZipfDistribution.
    */
   enum class Dist : uint8_t { Uniform, Zipf_50, Zipf_75, Zipf_95, Zipf_99, Serial };
 
+  /** @return the theta of a Zipfian distribution */
+  static double ZipfTheta(Dist dist);
+
   /**
    * Metadata about the data for a given column. Specifically, the type of the
    * column, the distribution of values, a min and max if appropriate.
@@ -64,6 +70,14 @@ class TableGenerator {
      * Counter to generate serial data
      */
     uint64_t serial_counter_{0};
+    /**
+     * Random generator of the column, so that each batch of rows draws new values
+     */
+    std::default_random_engine generator_{};
+    /**
+     * Zipfian distribution of the column, set up by its first batch
+     */
+    std::optional<ZipfDistribution> zipf_{};
 
     /**
      * Constructor
@@ -97,6 +111,16 @@ class TableGenerator {
         : name_(name), num_rows_(num_rows), col_meta_(std::move(col_meta)) {}
   };
 
+  /**
+   * Creates a table and fills it with generated rows, for tables other than the test tables, such as those of
+   * benchmarks.
+   * @param table_meta the name, size and columns of the table
+   * @param format the layout of the pages of the table
+   * @return the metadata of the new table
+   */
+  TableMetadata *GenerateTable(TableInsertMeta *table_meta, TableFormat format = TableFormat::ROW);
+
+ private:
   void FillTable(TableMetadata *info, TableInsertMeta *table_meta);
 
   std::vector<Value> MakeValues(ColumnInsertMeta *col_meta, uint32_t count);
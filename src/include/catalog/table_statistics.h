@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_statistics.h
+//
+// Identification: src/include/catalog/table_statistics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/util/hyperloglog.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class TableHeap;
+
+/**
+ * TableStatistics holds the statistics of a table that plans are costed with: its row count, and of each column the
+ * fraction of NULLs, an estimate of the number of distinct values and an equi-depth histogram.
+ *
+ * Analyze computes them all from the table, the histograms from a sample of up to SAMPLE_SIZE rows. Of a large table,
+ * it may read only a SYSTEM sample of its pages (see TableSample) and scale the row and NULL counts up by the share of
+ * the pages it read; the distinct values of a column are scaled alike only when nearly every value of the sample is
+ * distinct, since the values of a column with few of them are all in the sample already. In between, the
+ * write executors keep them up to date through AddTuple and RemoveTuple: the row and NULL counts exactly, the distinct
+ * values as far as new ones go, since a HyperLogLog forgets nothing, while the histograms stay as last analyzed.
+ * Changes of aborted transactions are not taken back, the statistics being estimates anyway.
+ *
+ * Thread safe.
+ */
+class TableStatistics {
+ public:
+  /** Number of buckets of the histograms, each holding about as many of the sampled values. */
+  static constexpr size_t HISTOGRAM_BUCKETS = 32;
+  /** Number of rows sampled for the histograms. */
+  static constexpr size_t SAMPLE_SIZE = 30000;
+
+  /** Creates the statistics of an empty table, which has not been analyzed. */
+  explicit TableStatistics(const Schema *schema);
+
+  /**
+   * Computes the statistics from all of the tuples of the table, like ANALYZE.
+   * @param heaps the heaps of the table, of the schema the statistics were created with: its own, or its partitions
+   * @param bpm the buffer pool manager to read values stored out of line from
+   * @param txn the transaction reading the table
+   * @param sample_fraction the fraction of the pages to read, all of them by default
+   */
+  void Analyze(const std::vector<TableHeap *> &heaps, BufferPoolManager *bpm, Transaction *txn,
+               double sample_fraction = 1);
+
+  /** Counts a tuple inserted into the table. */
+  void AddTuple(const Tuple &tuple);
+
+  /** Counts a tuple deleted from the table out. */
+  void RemoveTuple(const Tuple &tuple);
+
+  /** @return true if the table has been analyzed, so that its histograms are known */
+  bool IsAnalyzed() const;
+
+  /** @return the number of rows of the table */
+  uint64_t GetRowCount() const;
+
+  /** @return the fraction of the rows of the table with a NULL in the column */
+  double GetNullFraction(uint32_t column_idx) const;
+
+  /** @return the estimated number of distinct values other than NULL of the column, at most its number of them */
+  uint64_t GetDistinctCount(uint32_t column_idx) const;
+
+  /** @return the upper bounds of the buckets of the histogram of the column, in order; empty if not analyzed */
+  std::vector<Value> GetHistogram(uint32_t column_idx) const;
+
+  /** @return the estimated fraction of the rows of the table whose value of the column equals the value */
+  double EstimateEqualFraction(uint32_t column_idx, const Value &value) const;
+
+  /** @return the estimated fraction of the rows of the table whose value of the column is less than the value */
+  double EstimateLessThanFraction(uint32_t column_idx, const Value &value) const;
+
+ private:
+  struct ColumnStatistics {
+    uint64_t null_count_{0};
+    HyperLogLog distinct_;
+    /** The factor the distinct values counted are scaled up by, for statistics analyzed from a sample of the pages. */
+    double distinct_scale_{1};
+    std::vector<Value> histogram_;
+  };
+
+  /** The share of the distinct values among the values of a sample above which a column is taken as unique. */
+  static constexpr double UNIQUE_SAMPLE_SHARE = 0.9;
+
+  /** @return the hash of a value for the distinct estimates, which tells integers apart better than HashValue */
+  static hash_t HashForDistinct(const Value &value);
+
+  /** @return the value of a column of a tuple, or false if it is stored out of line and was not read back */
+  bool ReadValue(const Tuple &tuple, uint32_t column_idx, Value *value) const;
+
+  /** @return the fraction of the rows with a value of the column other than NULL; needs latch_ */
+  double NonNullFraction(const ColumnStatistics &column) const;
+
+  const Schema *schema_;
+  mutable std::mutex latch_;
+  bool analyzed_{false};
+  uint64_t row_count_{0};
+  std::vector<ColumnStatistics> columns_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena.h
+//
+// Identification: src/include/common/arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The default size of a chunk of an Arena. */
+static constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Arena is a bump allocator for memory that dies all at once, such as the tuples of a batch.
+ *
+ * Allocations are carved out of chunks one after the other and are never freed on their own: Reset frees all of them
+ * at once, and keeps the chunks for the allocations that follow, so that an arena reset between batches stops calling
+ * the global allocator once it has grown to the size of a batch. An arena is not thread-safe.
+ */
+class Arena {
+ public:
+  /**
+   * Creates an empty arena.
+   * @param chunk_size the size of the chunks, larger allocations get a chunk of their own
+   */
+  explicit Arena(size_t chunk_size = ARENA_CHUNK_SIZE) : chunk_size_(chunk_size) {}
+
+  DISALLOW_COPY(Arena);
+  Arena(Arena &&other) noexcept = default;
+  Arena &operator=(Arena &&other) noexcept = default;
+
+  /**
+   * Allocates memory that lives until the next Reset or the destruction of the arena.
+   * @param size the number of bytes to allocate
+   * @param alignment the alignment of the memory, a power of two no larger than alignof(std::max_align_t)
+   * @return the memory
+   */
+  char *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /** Frees every allocation at once. The chunks are kept for the next allocations. */
+  void Reset();
+
+  /** @return the number of bytes allocated since the last Reset */
+  size_t GetBytesAllocated() const { return bytes_allocated_; }
+
+  /** @return the number of bytes of the chunks of the arena */
+  size_t GetBytesReserved() const { return bytes_reserved_; }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data_;
+    size_t size_;
+  };
+
+  size_t chunk_size_;
+  std::vector<Chunk> chunks_;
+  /** The chunk allocations are carved out of, and the offset of the next one in it. */
+  size_t chunk_idx_{0};
+  size_t offset_{0};
+  size_t bytes_allocated_{0};
+  size_t bytes_reserved_{0};
+};
+
+}  // namespace bustub
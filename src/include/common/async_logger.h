@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_logger.h
+//
+// Identification: src/include/common/async_logger.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * AsyncLogger writes the lines of the LOG_* macros to a stream on a background thread, so that logging threads do not
+ * pay for the write and the flush of every line.
+ *
+ * A logging thread formats its line and pushes it into a bounded ring of records, without locks: it claims the next
+ * record with a compare and swap on the enqueue position, copies the line into the string of the record, whose
+ * capacity is reused from line to line, and publishes the record through its sequence number (Vyukov's bounded queue).
+ * The background thread takes all the published records at once, writes them with one fwrite and flushes the stream.
+ * Lines come out in the order their records were claimed. A thread that finds the ring full waits for the background
+ * thread to make room, so no line is lost.
+ *
+ * The background thread sleeps while the ring is empty; a logging thread only takes the mutex to wake it up if it
+ * announced it was going to sleep, and a missed wake-up is bounded by IDLE_TIMEOUT.
+ */
+class AsyncLogger {
+ public:
+  /** The number of records of the ring, a power of two. */
+  static constexpr size_t RING_SIZE = 1024;
+  /** How long the background thread sleeps at most while the ring is empty. */
+  static constexpr std::chrono::milliseconds IDLE_TIMEOUT{10};
+
+  /** Creates a logger writing to stream, and starts its background thread. */
+  explicit AsyncLogger(FILE *stream);
+
+  /** Writes out the lines left and stops the background thread. */
+  ~AsyncLogger();
+
+  DISALLOW_COPY_AND_MOVE(AsyncLogger);
+
+  /**
+   * @return the logger of the LOG_* macros, writing to LOG_OUTPUT_STREAM. It is stopped when the process exits, after
+   * which lines are written directly, see Append.
+   */
+  static AsyncLogger *Instance();
+
+  /** Queues a line, written out later by the background thread, or at once if the logger is stopped. */
+  void Append(const char *line, size_t length);
+
+  /** Waits until the lines appended before the call are written out and the stream is flushed. */
+  void Flush();
+
+  /** Writes out the lines left and stops the background thread; later lines are written directly. Idempotent. */
+  void Stop();
+
+ private:
+  struct Record {
+    /** The enqueue position the record is free for, or that position plus one once its line is published. */
+    std::atomic<uint64_t> sequence_;
+    std::string line_;
+  };
+
+  /** The loop of the background thread. */
+  void Run();
+
+  /** Writes out the published records from dequeue_pos_ on. @return the number of lines written */
+  size_t Drain();
+
+  /** @return true if the next record to be written out is published */
+  bool HasPublished() const;
+
+  /** Wakes up the background thread if it is asleep. */
+  void Wake();
+
+  FILE *stream_;
+  std::unique_ptr<Record[]> ring_;
+  /** The next record to be claimed by a logging thread. */
+  alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+  /** The next record to be written out, advanced under drain_mutex_. */
+  alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+  /** Serializes the drains of the background thread with those of logging threads once it is stopped. */
+  std::mutex drain_mutex_;
+  /** The lines of a drain, written with one fwrite. */
+  std::string batch_;
+
+  /** True while the background thread sleeps or is about to. */
+  std::atomic<bool> sleeping_{false};
+  std::atomic<bool> stopped_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  /** Signalled by the background thread after each drain, for Flush. */
+  std::condition_variable drained_;
+  std::thread thread_;
+};
+
+}  // namespace bustub
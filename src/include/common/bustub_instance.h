@@ -13,17 +13,30 @@
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "catalog/catalog.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
+#include "concurrency/vacuum_manager.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * Creates a new BustubInstance.
+   * @param db_file_name the database file name
+   * @param num_bpm_instances number of buffer pool shards, each holding pool_size frames (1 = no sharding)
+   * @param pool_size number of frames of each buffer pool shard
+   * @param warm_restart whether to dump the resident pages to a .bpd file next to the database, periodically and at
+   * shutdown, and to prefetch those of the last dump at startup
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t num_bpm_instances = 1,
+                          size_t pool_size = BUFFER_POOL_SIZE, bool warm_restart = false) {
     enable_logging = false;
 
     // storage related
@@ -32,7 +45,12 @@ class BustubInstance {
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    if (num_bpm_instances > 1) {
+      buffer_pool_manager_ =
+          new ParallelBufferPoolManager(num_bpm_instances, pool_size, disk_manager_, log_manager_);
+    } else {
+      buffer_pool_manager_ = new BufferPoolManager(pool_size, disk_manager_, log_manager_);
+    }
 
     // txn related
     lock_manager_ = new LockManager();
@@ -40,12 +58,37 @@ class BustubInstance {
 
     // checkpoints
     checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+
+    // catalog: a new database starts with its header page, an existing one reopens the tables stored in it
+    if (disk_manager_->IsNewFile()) {
+      page_id_t header_page_id;
+      auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->NewPage(&header_page_id));
+      BUSTUB_ASSERT(header_page != nullptr && header_page_id == HEADER_PAGE_ID, "The header page comes first.");
+      header_page->Init();
+      buffer_pool_manager_->UnpinPage(header_page_id, true);
+      buffer_pool_manager_->FlushPage(header_page_id);
+    }
+    catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_, true);
+
+    // the older versions kept for the snapshots, vacuumed once its thread is started
+    vacuum_manager_ = new VacuumManager(transaction_manager_, catalog_);
+
+    // warm restart: reload the pages resident at the last dump, which a new database has none of
+    if (warm_restart) {
+      const std::string page_dump_file = db_file_name.substr(0, db_file_name.rfind('.')) + ".bpd";
+      if (!disk_manager_->IsNewFile()) {
+        buffer_pool_manager_->LoadResidentPages(page_dump_file);
+      }
+      buffer_pool_manager_->StartPageDump(page_dump_file);
+    }
   }
 
   ~BustubInstance() {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    delete vacuum_manager_;
+    delete catalog_;
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -60,6 +103,8 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  Catalog *catalog_;
+  VacuumManager *vacuum_manager_;
 };
 
 }  // namespace bustub
@@ -47,6 +47,8 @@ enum class ExceptionType {
   OUT_OF_MEMORY = 9,
   /** Method not implemented. */
   NOT_IMPLEMENTED = 11,
+  /** A page read from disk does not match its checksum. */
+  CHECKSUM = 12,
 };
 
 class Exception : public std::runtime_error {
@@ -85,6 +87,8 @@ class Exception : public std::runtime_error {
         return "Out of Memory";
       case ExceptionType::NOT_IMPLEMENTED:
         return "Not implemented";
+      case ExceptionType::CHECKSUM:
+        return "Checksum mismatch";
       default:
         return "Unknown";
     }
@@ -100,4 +104,10 @@ class NotImplementedException : public Exception {
   explicit NotImplementedException(const std::string &msg) : Exception(ExceptionType::NOT_IMPLEMENTED, msg) {}
 };
 
+class ChecksumException : public Exception {
+ public:
+  ChecksumException() = delete;
+  explicit ChecksumException(const std::string &msg) : Exception(ExceptionType::CHECKSUM, msg) {}
+};
+
 }  // namespace bustub
@@ -26,10 +26,12 @@
 
 /**
  * Debug logging functions for EE. Unlike the performance counters,
- * these are just fprintf() turned on/off by LOG_LEVEL compile option.
+ * these are turned on/off by LOG_LEVEL compile option.
  * The main concern here is not to add any overhead on runtime performance
  * when the logging is turned off. Use LOG_XXX_ENABLED macros defined here to
  * eliminate all instructions in the final binary.
+ * When on, each line is formatted by the logging thread and written out by
+ * the background thread of AsyncLogger, so a line costs no write or flush.
  * @author Hideaki
  */
 
@@ -86,7 +88,12 @@ static constexpr int LOG_LEVEL = LOG_LEVEL_INFO;
 #define __FUNCTION__ ""
 #endif
 
-void OutputLogHeader(const char *file, int line, const char *func, int level);
+/**
+ * Formats a log line, its header then the message, and appends it to AsyncLogger::Instance(). Error lines are flushed
+ * before returning, so that they are out if the process crashes next.
+ */
+void OutputLogLine(const char *file, int line, const char *func, int level, const char *format, ...)
+    __attribute__((format(printf, 5, 6)));
 
 // Two convenient macros for debugging
 // 1. Logging macros.
@@ -98,11 +105,7 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_ERROR
 #define LOG_ERROR_ENABLED
 // #pragma message("LOG_ERROR was enabled.")
-#define LOG_ERROR(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_ERROR); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_ERROR(...) ::bustub::OutputLogLine(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_ERROR, __VA_ARGS__)
 #else
 #define LOG_ERROR(...) ((void)0)
 #endif
@@ -113,11 +116,7 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_WARN
 #define LOG_WARN_ENABLED
 // #pragma message("LOG_WARN was enabled.")
-#define LOG_WARN(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_WARN); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                               \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                        \
-  ::fflush(stdout)
+#define LOG_WARN(...) ::bustub::OutputLogLine(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_WARN, __VA_ARGS__)
 #else
 #define LOG_WARN(...) ((void)0)
 #endif
@@ -128,11 +127,7 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_INFO
 #define LOG_INFO_ENABLED
 // #pragma message("LOG_INFO was enabled.")
-#define LOG_INFO(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_INFO); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                               \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                        \
-  ::fflush(stdout)
+#define LOG_INFO(...) ::bustub::OutputLogLine(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_INFO, __VA_ARGS__)
 #else
 #define LOG_INFO(...) ((void)0)
 #endif
@@ -143,11 +138,7 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_DEBUG
 #define LOG_DEBUG_ENABLED
 // #pragma message("LOG_DEBUG was enabled.")
-#define LOG_DEBUG(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_DEBUG); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_DEBUG(...) ::bustub::OutputLogLine(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_DEBUG, __VA_ARGS__)
 #else
 #define LOG_DEBUG(...) ((void)0)
 #endif
@@ -158,46 +149,11 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_TRACE
 #define LOG_TRACE_ENABLED
 // #pragma message("LOG_TRACE was enabled.")
-#define LOG_TRACE(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_TRACE); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_TRACE(...) ::bustub::OutputLogLine(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_TRACE, __VA_ARGS__)
 #else
 #define LOG_TRACE(...) ((void)0)
 #endif
 
-// Output log message header in this format: [type] [file:line:function] time -
-// ex: [ERROR] [somefile.cpp:123:doSome()] 2008/07/06 10:00:00 -
-inline void OutputLogHeader(const char *file, int line, const char *func, int level) {
-  time_t t = ::time(nullptr);
-  tm *curTime = localtime(&t);  // NOLINT
-  char time_str[32];            // FIXME
-  ::strftime(time_str, 32, LOG_LOG_TIME_FORMAT, curTime);
-  const char *type;
-  switch (level) {
-    case LOG_LEVEL_ERROR:
-      type = "ERROR";
-      break;
-    case LOG_LEVEL_WARN:
-      type = "WARN ";
-      break;
-    case LOG_LEVEL_INFO:
-      type = "INFO ";
-      break;
-    case LOG_LEVEL_DEBUG:
-      type = "DEBUG";
-      break;
-    case LOG_LEVEL_TRACE:
-      type = "TRACE";
-      break;
-    default:
-      type = "UNKWN";
-  }
-  // PAVLO: DO NOT CHANGE THIS
-  ::fprintf(LOG_OUTPUT_STREAM, "%s [%s:%d:%s] %s - ", time_str, file, line, func, type);
-}
-
 }  // namespace bustub
 
 #endif
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_tracker.h
+//
+// Identification: src/include/common/memory_tracker.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "common/metrics.h"
+
+namespace bustub {
+
+/** The subsystems whose memory is accounted for apart, see MemoryTracker. */
+enum class MemoryTag : uint8_t { LOCK_MANAGER, TRANSACTIONS, EXECUTION, TUPLES, CATALOG, LOG_BUFFERS, NUM_TAGS };
+
+/**
+ * MemoryTracker counts the bytes a subsystem holds on the heap, as they are allocated and freed, from many threads
+ * without them contending: the containers of the subsystem allocate through a TrackedAllocator, its objects derive
+ * from TrackedObject, and its fixed buffers are counted where they are allocated.
+ *
+ * There is one tracker per MemoryTag in the process, exported by the metrics registry as "memory.<tag>_bytes", e.g.
+ * "memory.lock_manager_bytes", next to "memory.buffer_pool_bytes" of the buffer pools. A subsystem whose bytes keep
+ * growing while its load does not leaks.
+ */
+class MemoryTracker {
+ public:
+  /** @return the tracker of a subsystem */
+  static MemoryTracker *Of(MemoryTag tag);
+
+  /** @return the name of a subsystem in its metric, e.g. "lock_manager" */
+  static const char *NameOf(MemoryTag tag);
+
+  /** Allocates an object of a subsystem with the global operator new, see TrackedObject. */
+  static void *AllocateObject(MemoryTag tag, size_t size);
+
+  /** Frees an object allocated by AllocateObject. */
+  static void FreeObject(MemoryTag tag, void *data, size_t size);
+
+  void Allocate(size_t bytes) { allocated_.Add(bytes); }
+
+  void Free(size_t bytes) { freed_.Add(bytes); }
+
+  /** @return the bytes allocated and not freed yet; those allocated or freed meanwhile may be missed */
+  uint64_t GetBytes() const {
+    // Read the frees first, so that a block allocated and freed meanwhile is not counted as freed only.
+    const uint64_t freed = freed_.Get();
+    return allocated_.Get() - freed;
+  }
+
+ private:
+  Counter allocated_;
+  Counter freed_;
+};
+
+/** An allocator of the standard containers counting what it allocates in the tracker of a subsystem. */
+template <typename T, MemoryTag Tag>
+class TrackedAllocator {
+ public:
+  using value_type = T;
+
+  TrackedAllocator() = default;
+
+  template <typename U>
+  TrackedAllocator(const TrackedAllocator<U, Tag> &other) {}  // NOLINT
+
+  template <typename U>
+  struct rebind {
+    using other = TrackedAllocator<U, Tag>;
+  };
+
+  T *allocate(size_t n) {
+    T *data = std::allocator<T>().allocate(n);
+    MemoryTracker::Of(Tag)->Allocate(n * sizeof(T));
+    return data;
+  }
+
+  void deallocate(T *data, size_t n) {
+    MemoryTracker::Of(Tag)->Free(n * sizeof(T));
+    std::allocator<T>().deallocate(data, n);
+  }
+
+  template <typename U>
+  bool operator==(const TrackedAllocator<U, Tag> &other) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const TrackedAllocator<U, Tag> &other) const {
+    return false;
+  }
+};
+
+/** A base of the classes whose objects, allocated with new, are counted in the tracker of a subsystem. */
+template <MemoryTag Tag>
+class TrackedObject {
+ public:
+  static void *operator new(size_t size) { return MemoryTracker::AllocateObject(Tag, size); }
+
+  static void operator delete(void *data, size_t size) { MemoryTracker::FreeObject(Tag, data, size); }
+};
+
+}  // namespace bustub
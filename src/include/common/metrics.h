@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.h
+//
+// Identification: src/include/common/metrics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+
+namespace bustub {
+
+/** The number of buckets a Histogram splits each power of two into, from 8 on. */
+static constexpr size_t HISTOGRAM_SUB_BUCKETS = 4;
+
+/** The number of buckets of a Histogram: one per value below 8, then 4 per power of two up to 2^64. */
+static constexpr size_t HISTOGRAM_NUM_BUCKETS = HISTOGRAM_SUB_BUCKETS * 63;
+
+/** The number of shards of a Counter, each on its own cache line. */
+static constexpr size_t COUNTER_NUM_SHARDS = 16;
+
+/** A copy of the counts of a Histogram at some point, which can be merged with others. */
+struct HistogramSnapshot {
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+  std::array<uint64_t, HISTOGRAM_NUM_BUCKETS> buckets_{};
+
+  /** Adds the counts of another snapshot to this one. */
+  void Merge(const HistogramSnapshot &other);
+
+  /** @return the mean of the values, 0 if none was recorded */
+  double Mean() const { return count_ == 0 ? 0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+  /**
+   * @return an upper bound of the values a fraction of the values recorded are at most: the top of the bucket the
+   * percentile falls in, capped by the largest value
+   */
+  uint64_t Percentile(double fraction) const;
+};
+
+/**
+ * Histogram counts the values recorded in log-linear buckets, in the manner of an HDR histogram: each power of two is
+ * split into HISTOGRAM_SUB_BUCKETS buckets of equal width, so a value and the top of its bucket are within 25% of each
+ * other. The values below 8 have one bucket each. Recording takes a few relaxed atomic increments, and no latch.
+ */
+class Histogram {
+ public:
+  /** @return the bucket of a value: the bit below its leading one and the next select the bucket in its power of two */
+  static size_t BucketOf(uint64_t value) {
+    if (value < 2 * HISTOGRAM_SUB_BUCKETS) {
+      return value;
+    }
+    const size_t shift = 64 - __builtin_clzll(value) - 3;
+    return HISTOGRAM_SUB_BUCKETS * (shift + 1) + ((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+  }
+
+  /** @return the largest value of a bucket */
+  static uint64_t BucketTop(size_t bucket) {
+    if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) {
+      return bucket;
+    }
+    const size_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    // Wraps around to UINT64_MAX for the last bucket.
+    return ((HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS + 1) << shift) - 1;
+  }
+
+  void Record(uint64_t value) {
+    buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /** Records the time elapsed since start, in Unit, microseconds by default. */
+  template <typename Unit = std::chrono::microseconds>
+  void RecordSince(std::chrono::steady_clock::time_point start) {
+    Record(std::chrono::duration_cast<Unit>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  /** @return the counts so far; those recorded meanwhile may be counted in part */
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, HISTOGRAM_NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * Counter counts events from many threads without them contending on one cache line: each thread adds to one of
+ * COUNTER_NUM_SHARDS shards, picked round robin once per thread, and reading the counter sums them.
+ */
+class Counter {
+ public:
+  void Add(uint64_t n = 1) { shards_[ShardIndex()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the count so far; additions made meanwhile may be missed */
+  uint64_t Get() const {
+    uint64_t sum = 0;
+    for (const Shard &shard : shards_) {
+      sum += shard.value_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  /** @return the shard of the calling thread */
+  static size_t ShardIndex() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % COUNTER_NUM_SHARDS;
+    return shard;
+  }
+
+  std::array<Shard, COUNTER_NUM_SHARDS> shards_{};
+};
+
+/**
+ * MetricsRegistry exports the metrics of the components of the system under names, e.g. "log.flush_bytes": the
+ * histograms they own, and counters they read on demand. Several components may register a metric under the same
+ * name, e.g. the instances of a parallel buffer pool: its histograms are then merged, and its counters summed.
+ *
+ * A component registers its metrics once it is constructed, and unregisters them all before it is destroyed.
+ */
+class MetricsRegistry {
+ public:
+  /** @return the registry of the process */
+  static MetricsRegistry *Global();
+
+  /** Registers a histogram of an owner, which must stay valid until the owner is unregistered. */
+  void RegisterHistogram(const void *owner, const std::string &name, const Histogram *histogram);
+
+  /** Registers a counter of an owner, read by calling read, until the owner is unregistered. */
+  void RegisterCounter(const void *owner, const std::string &name, std::function<uint64_t()> read);
+
+  /** Registers a counter of an owner, which must stay valid until the owner is unregistered. */
+  void RegisterCounter(const void *owner, const std::string &name, const Counter *counter) {
+    RegisterCounter(owner, name, [counter] { return counter->Get(); });
+  }
+
+  /** Unregisters every metric of an owner. */
+  void Unregister(const void *owner);
+
+  /** @return the histograms registered under a name, merged; empty if there are none */
+  HistogramSnapshot GetHistogram(const std::string &name);
+
+  /** @return the sum of the counters registered under a name, 0 if there are none */
+  uint64_t GetCounter(const std::string &name);
+
+  /**
+   * @return every metric, one line each in the order of the names: "<name> <value>" for a counter, and
+   * "<name> count=<n> mean=<mean> p50=<p50> p99=<p99> max=<max>" for a histogram
+   */
+  std::string Dump();
+
+ private:
+  /** A metric of an owner: a histogram, or else a counter. */
+  struct Metric {
+    const void *owner_;
+    const Histogram *histogram_;
+    std::function<uint64_t()> read_;
+  };
+
+  std::multimap<std::string, Metric> metrics_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,21 +12,36 @@
 
 #pragma once
 
+#include <atomic>
 #include <climits>
 #include <condition_variable>  // NOLINT
 #include <mutex>               // NOLINT
 
 #include "common/macros.h"
+#include "common/spin_mutex.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch with an atomic fast path.
+ *
+ * The readers and the writer share one atomic word, the number of readers holding the latch and a bit set once a
+ * writer entered, so that an uncontended RLock or RUnlock is one atomic instruction on that word and takes no mutex.
+ * A writer that entered keeps the new readers out, then waits for the readers holding the latch to leave. A thread
+ * that has to wait spins for a short while first, then parks on a condition variable; the threads releasing the latch
+ * only take the mutex to wake up the parked ones, if there are any.
+ *
+ * The latch stays a few words large, as every Page has one; a counter per core would make it a few kilobytes.
  */
 class ReaderWriterLatch {
   using mutex_t = std::mutex;
   using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
+  /** The bit of state_ set once a writer entered. */
+  static const uint32_t WRITER_ENTERED = 1U << 31;
+  /** The bits of state_ counting the readers holding the latch. */
+  static const uint32_t MAX_READERS = WRITER_ENTERED - 1;
+  /** How many times a thread looks at the latch again before it parks. */
+  static const int SPIN_LIMIT = 64;
 
  public:
   ReaderWriterLatch() = default;
@@ -38,59 +53,94 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
-    }
+    // Enter, which keeps the new readers out, then wait for the readers holding the latch to leave.
+    Await([this] {
+      uint32_t state = state_.load();
+      while ((state & WRITER_ENTERED) == 0) {
+        if (state_.compare_exchange_weak(state, state | WRITER_ENTERED)) {
+          return true;
+        }
+      }
+      return false;
+    });
+    Await([this] { return (state_.load() & MAX_READERS) == 0; });
   }
 
   /**
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    state_.fetch_and(~WRITER_ENTERED);
+    WakeUp();
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    Await([this] { return TryRLock(); });
+  }
+
+  /**
+   * Acquire a read latch if that does not have to wait.
+   * @return true if the read latch is acquired
+   */
+  bool TryRLock() {
+    uint32_t state = state_.load();
+    while ((state & WRITER_ENTERED) == 0 && (state & MAX_READERS) != MAX_READERS) {
+      if (state_.compare_exchange_weak(state, state + 1)) {
+        return true;
+      }
     }
-    reader_count_++;
+    return false;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    const uint32_t state = state_.fetch_sub(1) - 1;
+    // The last reader lets an entered writer in; a reader leaving a full latch makes room for another.
+    if ((state & WRITER_ENTERED) != 0 ? (state & MAX_READERS) == 0 : (state & MAX_READERS) == MAX_READERS - 1) {
+      WakeUp();
     }
   }
 
  private:
+  /**
+   * Spins, then parks until acquire succeeds; acquire is retried after every change of the latch. It may only fail if
+   * the latch is held, never spuriously, or the thread may park for good.
+   */
+  template <typename Acquire>
+  void Await(Acquire &&acquire) {
+    for (int i = 0; i < SPIN_LIMIT; i++) {
+      if (acquire()) {
+        return;
+      }
+      CpuRelax();
+    }
+    std::unique_lock<mutex_t> latch(mutex_);
+    // Counted in before acquire is retried, so that a release after that retry sees the waiter and wakes it up.
+    num_parked_.fetch_add(1);
+    cond_.wait(latch, acquire);
+    num_parked_.fetch_sub(1);
+  }
+
+  /** Wakes up the parked threads after a change of the latch, if there are any. */
+  void WakeUp() {
+    if (num_parked_.load() > 0) {
+      std::lock_guard<mutex_t> guard(mutex_);
+      cond_.notify_all();
+    }
+  }
+
+  /** WRITER_ENTERED, and the number of readers holding the latch. */
+  std::atomic<uint32_t> state_{0};
+  /** The number of threads parked on cond_. */
+  std::atomic<uint32_t> num_parked_{0};
+  /** Only taken to park, and to wake up the parked threads. */
   mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  cond_t cond_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spin_mutex.h
+//
+// Identification: src/include/common/spin_mutex.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Tells the core a spinning thread is waiting. */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * SpinMutex is a mutex for very short critical sections: a thread finding it locked spins for a short while, as the
+ * owner is likely to unlock it soon, and only then sleeps on a futex until the owner wakes it up.
+ *
+ * Unlocking an uncontended SpinMutex is one atomic exchange, with no system call, as the owner only wakes up a sleeper
+ * if one announced itself. It counts how often it was found locked, for the metrics of the latches it backs.
+ *
+ * It is a Lockable, so it works with std::lock_guard, std::unique_lock and std::scoped_lock, and with
+ * std::condition_variable_any for waiting.
+ */
+class SpinMutex {
+  /** How many times a thread looks at the mutex again before it sleeps. */
+  static const int SPIN_LIMIT = 100;
+  /** The states of the mutex. */
+  static const uint32_t UNLOCKED = 0;
+  static const uint32_t LOCKED = 1;
+  /** Locked, and a thread may be sleeping on it. */
+  static const uint32_t CONTENDED = 2;
+
+ public:
+  SpinMutex() = default;
+  ~SpinMutex() = default;
+
+  DISALLOW_COPY_AND_MOVE(SpinMutex);
+
+  /** Locks the mutex, spinning then sleeping while it is locked. */
+  void lock() {  // NOLINT
+    uint32_t state = UNLOCKED;
+    if (!state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire)) {
+      LockContended();
+    }
+  }
+
+  /** @return true if the mutex was unlocked and is now locked */
+  bool try_lock() {  // NOLINT
+    uint32_t state = UNLOCKED;
+    return state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire);
+  }
+
+  /** Unlocks the mutex, waking up one sleeping thread if there may be one. */
+  void unlock() {  // NOLINT
+    if (state_.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+      Wake();
+    }
+  }
+
+  /** @return the number of times lock found the mutex locked */
+  uint64_t GetNumContended() const { return num_contended_.load(std::memory_order_relaxed); }
+
+  /** @return the number of times a thread went to sleep on the mutex */
+  uint64_t GetNumSleeps() const { return num_sleeps_.load(std::memory_order_relaxed); }
+
+ private:
+  void LockContended() {
+    num_contended_.fetch_add(1, std::memory_order_relaxed);
+    for (int i = 0; i < SPIN_LIMIT; i++) {
+      CpuRelax();
+      uint32_t state = UNLOCKED;
+      if (state_.load(std::memory_order_relaxed) == UNLOCKED &&
+          state_.compare_exchange_weak(state, LOCKED, std::memory_order_acquire)) {
+        return;
+      }
+    }
+    // A thread that took the mutex from here on leaves it CONTENDED, as others may still be sleeping.
+    while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+      num_sleeps_.fetch_add(1, std::memory_order_relaxed);
+      Sleep();
+    }
+  }
+
+  /** Sleeps while the mutex is CONTENDED, or not at all if it changed already. */
+  void Sleep() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, CONTENDED, nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  /** Wakes up one thread sleeping on the mutex. */
+  void Wake() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+  }
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex is the state word itself");
+
+  /** UNLOCKED, LOCKED or CONTENDED. */
+  std::atomic<uint32_t> state_{UNLOCKED};
+  std::atomic<uint64_t> num_contended_{0};
+  std::atomic<uint64_t> num_sleeps_{0};
+};
+
+}  // namespace bustub
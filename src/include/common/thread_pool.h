@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool.h
+//
+// Identification: src/include/common/thread_pool.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The class of work a task belongs to, which the ThreadPool shares its workers between. */
+enum class WorkloadClass : uint8_t {
+  /** Short transactions and point queries, whose latency matters. */
+  INTERACTIVE = 0,
+  /** Long scans and reports, whose throughput matters. */
+  ANALYTICAL = 1,
+};
+
+/** The number of workload classes. */
+static constexpr size_t NUM_WORKLOAD_CLASSES = 2;
+/** The default tickets of the interactive and analytical classes, see ThreadPool::SetTickets. */
+static constexpr uint32_t INTERACTIVE_TICKETS = 8;
+static constexpr uint32_t ANALYTICAL_TICKETS = 1;
+
+/**
+ * ThreadPool runs tasks on a fixed set of worker threads, queued by workload class.
+ *
+ * The tasks of a class run in the order they were submitted, and the classes share the workers by stride scheduling:
+ * each class has tickets and a pass, an idle worker takes the next task of the class with the lowest pass, whose pass
+ * then advances by the inverse of its tickets. While both classes have tasks queued, the interactive class thus starts
+ * INTERACTIVE_TICKETS tasks for every ANALYTICAL_TICKETS analytical ones, and a class that was idle starts from the
+ * pass of the others rather than with the credit of its idle time.
+ *
+ * A task that is already running is not preempted, so that short tasks do not wait behind a long one holding every
+ * worker, long tasks offer preemption points: at a point where it holds no latch, e.g. between the morsels of a
+ * parallel scan, a task calls Yield, which runs the queued tasks of the classes that come before its own, if any,
+ * on its thread before it resumes.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Creates a new thread pool and starts its workers.
+   * @param num_threads the number of worker threads
+   */
+  explicit ThreadPool(size_t num_threads);
+
+  DISALLOW_COPY_AND_MOVE(ThreadPool);
+
+  /** Runs the tasks submitted so far, then stops the workers. */
+  ~ThreadPool();
+
+  /** Queues a task of a workload class to run on the next idle worker. */
+  void Submit(std::function<void()> task, WorkloadClass workload_class = WorkloadClass::INTERACTIVE);
+
+  /**
+   * Runs task(0), ..., task(n - 1) on the workers and waits for all of them. Must not be called from a task of the
+   * pool, whose worker it would hold up.
+   * @throw the first exception thrown by a task, once all of them are done
+   */
+  void RunAll(size_t n, const std::function<void(size_t)> &task,
+              WorkloadClass workload_class = WorkloadClass::INTERACTIVE);
+
+  /**
+   * Sets the share of the workers of a workload class while the other class has tasks queued too.
+   * @param tickets the tickets of the class, at least 1
+   */
+  void SetTickets(WorkloadClass workload_class, uint32_t tickets);
+
+  /**
+   * A preemption point: if the calling thread runs a task of a pool, runs the tasks queued in that pool of the
+   * classes that come before the class of the task, then returns. Does nothing on any other thread.
+   */
+  static void Yield();
+
+  /** @return the number of worker threads */
+  size_t Size() const { return workers_.size(); }
+
+ private:
+  /** The pass a class advances by per task with a single ticket. */
+  static constexpr uint64_t STRIDE = uint64_t{1} << 20;
+
+  /** Runs tasks until the pool is shut down. */
+  void Work();
+
+  /**
+   * Pops the next task, of the queued class with the lowest pass among the classes before limit. Call with latch_
+   * held.
+   * @return false if those classes have no task queued
+   */
+  bool PopTask(size_t limit, std::function<void()> *task, WorkloadClass *workload_class);
+
+  /** Runs a task of a class on the calling thread, as the class of the task it may yield to. */
+  void RunTask(const std::function<void()> &task, WorkloadClass workload_class);
+
+  std::vector<std::thread> workers_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  /** The tasks queued for each class, and the tickets and pass of each. */
+  std::array<std::deque<std::function<void()>>, NUM_WORKLOAD_CLASSES> tasks_;
+  std::array<uint32_t, NUM_WORKLOAD_CLASSES> tickets_{INTERACTIVE_TICKETS, ANALYTICAL_TICKETS};
+  std::array<uint64_t, NUM_WORKLOAD_CLASSES> pass_{};
+  /** The pass of the last task started, where a class with no task queued starts from. */
+  uint64_t global_pass_{0};
+  bool shutdown_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.h
+//
+// Identification: src/include/common/util/bloom_filter.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * BloomFilter is a blocked Bloom filter over the hashes of keys: it tells for sure that a key was never inserted, and
+ * mistakes a key that was not for one that was about once in a hundred lookups.
+ *
+ * The filter is split into blocks the size of a cache line. A key sets one bit in each of the eight words of a single
+ * block, so an insert or a lookup touches one cache line, at the cost of a slightly higher false positive rate than a
+ * classic Bloom filter of the same size. The hashes are remixed first, since the hashes of HashUtil spread small
+ * integers poorly over the high bits that pick the block.
+ *
+ * Not thread safe for writers; concurrent lookups of a filter that is not being written to are.
+ */
+class BloomFilter {
+ public:
+  /** Number of bits of filter per key it is sized for. */
+  static constexpr size_t BITS_PER_KEY = 12;
+
+  /** Creates a filter sized for num_keys keys, see Reset. */
+  explicit BloomFilter(size_t num_keys = 0) { Reset(num_keys); }
+
+  /** Empties the filter and sizes it for num_keys keys; at least one block is kept, so an empty filter rejects all. */
+  void Reset(size_t num_keys) {
+    size_t num_blocks = std::max<size_t>(1, (num_keys * BITS_PER_KEY + BLOCK_BITS - 1) / BLOCK_BITS);
+    blocks_.assign(num_blocks, Block{});
+  }
+
+  /** Inserts the hash of a key. */
+  void Insert(hash_t hash) {
+    uint64_t mixed = Mix(hash);
+    Block &block = blocks_[BlockIndex(mixed)];
+    auto key = static_cast<uint32_t>(mixed);
+    for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+      block.words_[i] |= uint64_t{1} << ((key * SALTS[i]) >> 26);
+    }
+  }
+
+  /** @return false if no key with the hash was inserted, true if one may have been */
+  bool MayContain(hash_t hash) const {
+    uint64_t mixed = Mix(hash);
+    const Block &block = blocks_[BlockIndex(mixed)];
+    auto key = static_cast<uint32_t>(mixed);
+    for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+      if ((block.words_[i] & (uint64_t{1} << ((key * SALTS[i]) >> 26))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** @return the bytes of memory of the filter */
+  size_t GetSize() const { return blocks_.size() * sizeof(Block); }
+
+ private:
+  static constexpr size_t WORDS_PER_BLOCK = 8;
+  static constexpr size_t BLOCK_BITS = WORDS_PER_BLOCK * 64;
+  /** Odd multipliers that pick the bit of each word from the low half of the hash. */
+  static constexpr uint32_t SALTS[WORDS_PER_BLOCK] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                      0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+  struct alignas(64) Block {
+    uint64_t words_[WORDS_PER_BLOCK]{};
+  };
+
+  static uint64_t Mix(hash_t hash) { return HashUtil::MixHash(hash); }
+
+  /** @return the block of a hash, from its high half, without a division */
+  size_t BlockIndex(uint64_t mixed) const { return static_cast<size_t>(((mixed >> 32) * blocks_.size()) >> 32); }
+
+  std::vector<Block> blocks_;
+};
+
+}  // namespace bustub
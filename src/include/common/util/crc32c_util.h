@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.h
+//
+// Identification: src/include/common/util/crc32c_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace bustub {
+
+/**
+ * Crc32cUtil computes CRC-32C (Castagnoli) checksums. The hardware CRC instructions of SSE 4.2 or ARMv8 are used when
+ * the build targets them, which makes checksumming a page cost a few hundred nanoseconds; otherwise a table-driven
+ * software implementation computes the same values.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length number of bytes
+   * @param crc the checksum of the preceding bytes, to checksum a buffer in pieces
+   * @return the CRC-32C of the bytes
+   */
+  static inline uint32_t Crc32c(const char *data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+    for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+#if defined(__SSE4_2__)
+      crc = static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+#else
+      crc = __crc32cd(crc, word);
+#endif
+    }
+    for (; length > 0; data++, length--) {
+#if defined(__SSE4_2__)
+      crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+#else
+      crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+#endif
+    }
+#else
+    for (; length > 0; data++, length--) {
+      crc = Table()[(crc ^ static_cast<uint8_t>(*data)) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+  }
+
+ private:
+  /** The reflected Castagnoli polynomial. */
+  static constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+  static constexpr std::array<uint32_t, 256> MakeTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) != 0 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+      }
+      table[i] = crc;
+    }
+    return table;
+  }
+
+  /** @return the byte-at-a-time lookup table of the software implementation */
+  static const std::array<uint32_t, 256> &Table() {
+    static constexpr std::array<uint32_t, 256> TABLE = MakeTable();
+    return TABLE;
+  }
+};
+
+}  // namespace bustub
@@ -13,7 +13,9 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -28,28 +30,122 @@ class HashUtil {
  private:
   static const hash_t prime_factor = 10000019;
 
+  /** The secrets of wyhash, odd constants with half of their bits set. */
+  static constexpr uint64_t SECRET0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t SECRET1 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t SECRET2 = 0x8ebc6af09c88c6e3ULL;
+  static constexpr uint64_t SECRET3 = 0x589965cc75374cc3ULL;
+
+  /** Replaces a and b with the low and the high half of their 128-bit product. */
+  static inline void MultiplyWide(uint64_t *a, uint64_t *b) {
+    __extension__ using Product = unsigned __int128;
+    const Product product = static_cast<Product>(*a) * *b;
+    *a = static_cast<uint64_t>(product);
+    *b = static_cast<uint64_t>(product >> 64);
+  }
+
+  /** @return the two halves of the 128-bit product of a and b folded together by xor */
+  static inline uint64_t Mum(uint64_t a, uint64_t b) {
+    MultiplyWide(&a, &b);
+    return a ^ b;
+  }
+
+  template <size_t N>
+  static inline uint64_t Read(const char *bytes) {
+    uint64_t word = 0;
+    memcpy(&word, bytes, N);
+    return word;
+  }
+
  public:
-  static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+  /**
+   * @return the hash of a byte string, by wyhash (https://github.com/wangyi-fudan/wyhash): the string is read 16 bytes
+   * at a time, and every pair of words is mixed by a 64x64 to 128-bit multiplication
+   */
+  static inline hash_t HashBytes(const char *bytes, size_t length, uint64_t seed = 0) {
+    seed ^= Mum(seed ^ SECRET0, SECRET1);
+    uint64_t a;
+    uint64_t b;
+    if (length <= 16) {
+      if (length >= 4) {
+        // Two overlapping pairs of 4-byte reads cover every byte of 4 to 16.
+        const size_t quarter = (length >> 3) << 2;
+        a = (Read<4>(bytes) << 32) | Read<4>(bytes + quarter);
+        b = (Read<4>(bytes + length - 4) << 32) | Read<4>(bytes + length - 4 - quarter);
+      } else if (length > 0) {
+        const auto *u = reinterpret_cast<const uint8_t *>(bytes);
+        a = (uint64_t{u[0]} << 16) | (uint64_t{u[length >> 1]} << 8) | u[length - 1];
+        b = 0;
+      } else {
+        a = b = 0;
+      }
+    } else {
+      size_t rest = length;
+      const char *p = bytes;
+      if (rest > 48) {
+        // Three independent lanes keep the multipliers busy on long strings.
+        uint64_t lane1 = seed;
+        uint64_t lane2 = seed;
+        do {
+          seed = Mum(Read<8>(p) ^ SECRET1, Read<8>(p + 8) ^ seed);
+          lane1 = Mum(Read<8>(p + 16) ^ SECRET2, Read<8>(p + 24) ^ lane1);
+          lane2 = Mum(Read<8>(p + 32) ^ SECRET3, Read<8>(p + 40) ^ lane2);
+          p += 48;
+          rest -= 48;
+        } while (rest > 48);
+        seed ^= lane1 ^ lane2;
+      }
+      while (rest > 16) {
+        seed = Mum(Read<8>(p) ^ SECRET1, Read<8>(p + 8) ^ seed);
+        p += 16;
+        rest -= 16;
+      }
+      a = Read<8>(p + rest - 16);
+      b = Read<8>(p + rest - 8);
     }
-    return hash;
+    return HashWords(a, b, seed ^ length);
   }
 
-  static inline hash_t CombineHashes(hash_t l, hash_t r) {
-    hash_t both[2];
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
+  /** @return the hash of a pair of words, seeded; every bit of it depends on every bit of both */
+  static inline hash_t HashWords(uint64_t a, uint64_t b, uint64_t seed = 0) {
+    a ^= SECRET1;
+    b ^= seed ^ SECRET2;
+    MultiplyWide(&a, &b);
+    return Mum(a ^ SECRET0, b ^ SECRET1);
   }
 
+  static inline hash_t CombineHashes(hash_t l, hash_t r) { return HashWords(l, r); }
+
   static inline hash_t SumHashes(hash_t l, hash_t r) { return (l % prime_factor + r % prime_factor) % prime_factor; }
 
+  /**
+   * @return the hash remixed by the finalizer of MurmurHash3, so that all of its bits depend on all of the bits of the
+   * input, for hashes that are not mixed already, such as integers hashed as themselves
+   */
+  static inline hash_t MixHash(hash_t hash) {
+    uint64_t mixed = hash;
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdULL;
+    mixed ^= mixed >> 33;
+    mixed *= 0xc4ceb9fe1a85ec53ULL;
+    mixed ^= mixed >> 33;
+    return mixed;
+  }
+
+  /**
+   * @return the hash of the bytes of a value. Values of 4, 8 or 16 bytes, such as integers and the keys of hash
+   * indexes, are hashed as one or two words without a loop; the width is known at compile time.
+   */
   template <typename T>
   static inline hash_t Hash(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(ptr), sizeof(T));
+    const auto *bytes = reinterpret_cast<const char *>(ptr);
+    if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+      return HashWords(Read<sizeof(T)>(bytes), sizeof(T));
+    } else if constexpr (sizeof(T) == 16) {
+      return HashWords(Read<8>(bytes), Read<8>(bytes + 8), sizeof(T));
+    } else {
+      return HashBytes(bytes, sizeof(T));
+    }
   }
 
   template <typename T>
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hyperloglog.h
+//
+// Identification: src/include/common/util/hyperloglog.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * HyperLogLog estimates the number of distinct hashes added to it in a few kilobytes, whatever their number, within
+ * about 1.6% of the truth.
+ *
+ * The hash picks one of its registers by its top PRECISION bits, and the register keeps the longest run of leading
+ * zeros seen in the rest of the hash. Small counts, which leave registers empty, are estimated by linear counting
+ * instead. The hashes are remixed first, like in BloomFilter. Hashes cannot be removed from the sketch.
+ *
+ * Not thread safe.
+ */
+class HyperLogLog {
+ public:
+  /** Number of bits of the hash picking the register. */
+  static constexpr uint32_t PRECISION = 12;
+  static constexpr size_t NUM_REGISTERS = size_t{1} << PRECISION;
+
+  HyperLogLog() : registers_(NUM_REGISTERS, 0) {}
+
+  /** Adds a hash to the sketch. */
+  void Add(hash_t hash) {
+    uint64_t mixed = HashUtil::MixHash(hash);
+    size_t index = mixed >> (64 - PRECISION);
+    // The rest of the hash, with a bit set past its end so the run of zeros is at most 64 - PRECISION long.
+    uint64_t rest = (mixed << PRECISION) | (uint64_t{1} << (PRECISION - 1));
+    auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+  }
+
+  /** Adds the hashes of another sketch to this one. */
+  void Merge(const HyperLogLog &other) {
+    for (size_t i = 0; i < NUM_REGISTERS; i++) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  /** @return the estimated number of distinct hashes added */
+  uint64_t Estimate() const {
+    double sum = 0;
+    size_t empty = 0;
+    for (uint8_t rank : registers_) {
+      sum += std::ldexp(1.0, -rank);
+      empty += rank == 0 ? 1 : 0;
+    }
+    const auto m = static_cast<double>(NUM_REGISTERS);
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && empty > 0) {
+      estimate = m * std::log(m / static_cast<double>(empty));
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+  }
+
+  /** Empties the sketch. */
+  void Clear() { std::fill(registers_.begin(), registers_.end(), 0); }
+
+ private:
+  std::vector<uint8_t> registers_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zipf_distribution.h
+//
+// Identification: src/include/common/util/zipf_distribution.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ZipfDistribution draws integers of [min, max] with a Zipfian skew: min is the most frequent, and the k-th value is
+ * drawn with a probability proportional to 1 / k^theta. A theta of 0.99 is the skew of YCSB, where a few percent of
+ * the values take most of the draws; 0.5 is mild.
+ *
+ * A draw takes constant time (Gray et al., "Quickly Generating Billion-Record Synthetic Databases"), after the
+ * constructor sums the n terms of the zeta function once. Used like the distributions of <random>.
+ */
+class ZipfDistribution {
+ public:
+  /**
+   * Creates a distribution of [min, max].
+   * @param theta the skew, in [0, 1)
+   */
+  ZipfDistribution(uint64_t min, uint64_t max, double theta)
+      : min_(min), num_values_(max - min + 1), uniform_(0.0, 1.0) {
+    BUSTUB_ASSERT(min <= max && theta >= 0 && theta < 1, "A Zipfian distribution needs a range and a skew in [0, 1).");
+    double zeta_2 = Zeta(2, theta);
+    zeta_n_ = Zeta(num_values_, theta);
+    alpha_ = 1.0 / (1.0 - theta);
+    eta_ = (1.0 - std::pow(2.0 / num_values_, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n_);
+    half_pow_theta_ = 1.0 + std::pow(0.5, theta);
+  }
+
+  /** @return the next value drawn with generator */
+  template <class Generator>
+  uint64_t operator()(Generator &generator) {
+    double u = uniform_(generator);
+    double uz = u * zeta_n_;
+    if (uz < 1.0 || num_values_ == 1) {
+      return min_;
+    }
+    if (uz < half_pow_theta_) {
+      return min_ + 1;
+    }
+    auto rank = static_cast<uint64_t>(static_cast<double>(num_values_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return min_ + std::min(rank, num_values_ - 1);
+  }
+
+ private:
+  /** @return the sum of 1 / i^theta for i in [1, n] */
+  static double Zeta(uint64_t n, double theta) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    return sum;
+  }
+
+  uint64_t min_;
+  uint64_t num_values_;
+  double zeta_n_;
+  double alpha_;
+  double eta_;
+  double half_pow_theta_;
+  std::uniform_real_distribution<double> uniform_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// deterministic_scheduler.h
+//
+// Identification: src/include/concurrency/deterministic_scheduler.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/rid.h"
+#include "common/thread_pool.h"
+#include "concurrency/transaction_manager.h"
+
+namespace bustub {
+
+/** A transaction run by a DeterministicScheduler: the rows it reads and writes, declared up front, and its logic. */
+struct DeterministicTxn {
+  /** The rows the transaction reads. */
+  std::vector<RID> read_set_;
+  /** The rows the transaction writes, which it may read as well. */
+  std::vector<RID> write_set_;
+  /** Runs the transaction on the rows of its sets. @return false to abort it */
+  std::function<bool(Transaction *txn)> logic_;
+};
+
+/**
+ * DeterministicScheduler runs transactions in the order of the batches it sequences them in, so that they never
+ * deadlock: its sequencer thread takes the transactions submitted since the last batch every batch interval, orders
+ * them, and requests the locks of all their declared rows in that order, one transaction after the other. A request
+ * is granted once the requests before it on the row are, and are all shared along with it. A transaction runs on the
+ * thread pool once all its locks are granted, and releases them once committed or aborted; its conflicting
+ * transactions thus run in batch order, and no transaction ever waits for one that comes after it.
+ *
+ * The locks are those of the scheduler, not of the LockManager: the rows of its sets are recorded as locked in the
+ * transaction, which the storage then does not lock again, so that it neither waits in the lock manager nor joins its
+ * waits-for graph. The rows the transactions declare are thus only to be written through the scheduler. The table
+ * locks, and the locks of the rows a transaction did not declare, are taken from the LockManager as usual.
+ */
+class DeterministicScheduler {
+ public:
+  /** The default interval between two batches of the sequencer thread. */
+  static constexpr std::chrono::milliseconds DEFAULT_BATCH_INTERVAL{5};
+
+  /**
+   * Creates a new scheduler, whose sequencer thread is not started.
+   * @param transaction_manager the transaction manager beginning and committing the transactions
+   * @param thread_pool the pool the transactions run on
+   * @param batch_interval the interval between two batches of the sequencer thread
+   */
+  DeterministicScheduler(TransactionManager *transaction_manager, ThreadPool *thread_pool,
+                         std::chrono::milliseconds batch_interval = DEFAULT_BATCH_INTERVAL)
+      : transaction_manager_(transaction_manager), thread_pool_(thread_pool), batch_interval_(batch_interval) {}
+
+  /** Stops the sequencer thread, sequencing what was submitted, and waits for the transactions to finish. */
+  ~DeterministicScheduler();
+
+  /**
+   * Submits a transaction, to be run in the next batch.
+   * @return the future of the outcome of the transaction, true if it committed
+   */
+  std::future<bool> Submit(DeterministicTxn txn);
+
+  /** Starts the thread sequencing a batch every batch interval. */
+  void RunSequencerThread();
+
+  /** Stops the thread, once it sequenced the transactions submitted so far. */
+  void StopSequencerThread();
+
+  /** Sequences the transactions submitted so far as one batch. @return the number of them */
+  size_t SequenceBatch();
+
+  /** Waits until every transaction sequenced so far has finished. */
+  void WaitForIdle();
+
+  /** @return the number of batches sequenced so far, none of them empty */
+  uint64_t GetNumBatches() const { return num_batches_.load(); }
+
+ private:
+  /** A transaction submitted, with the promise of its outcome and the number of its locks not granted yet. */
+  struct Entry {
+    DeterministicTxn txn_;
+    std::promise<bool> outcome_;
+    /** The rows of the sets of the transaction, each once, and whether it writes them. */
+    std::vector<std::pair<RID, bool>> rows_;
+    size_t num_waiting_{0};
+  };
+
+  /** A lock request on a row, in batch order. */
+  struct Request {
+    Entry *entry_;
+    bool exclusive_;
+    bool granted_{false};
+  };
+
+  /** Requests the locks of the rows of a transaction, running it if all are granted. Call with latch_ held. */
+  void RequestLocks(Entry *entry, std::vector<Entry *> *ready);
+
+  /** Grants the requests on a row that can be, in order. Call with latch_ held. */
+  void GrantLocks(std::deque<Request> *queue, std::vector<Entry *> *ready);
+
+  /** Runs a transaction whose locks are all granted on the thread pool. */
+  void Dispatch(Entry *entry);
+
+  /** Runs a transaction, then releases its locks. */
+  void Execute(Entry *entry);
+
+  /** The loop of the sequencer thread. */
+  void RunSequencer();
+
+  TransactionManager *transaction_manager_;
+  ThreadPool *thread_pool_;
+  const std::chrono::milliseconds batch_interval_;
+
+  /** Protects the transactions submitted and not sequenced yet. */
+  std::mutex submit_latch_;
+  std::vector<std::unique_ptr<Entry>> submitted_;
+
+  /** Protects the lock table and the number of transactions sequenced and not finished. */
+  std::mutex latch_;
+  std::condition_variable idle_cv_;
+  std::unordered_map<RID, std::deque<Request>> lock_table_;
+  size_t num_running_{0};
+
+  std::atomic<uint64_t> num_batches_{0};
+  std::atomic<bool> enable_sequencer_{false};
+  std::thread *sequencer_thread_{nullptr};
+};
+
+}  // namespace bustub
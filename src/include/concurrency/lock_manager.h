@@ -13,15 +13,22 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <condition_variable>  // NOLINT
-#include <list>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "common/memory_tracker.h"
+#include "common/metrics.h"
 #include "common/rid.h"
+#include "common/spin_mutex.h"
 #include "concurrency/transaction.h"
 
 namespace bustub {
@@ -29,47 +36,124 @@ namespace bustub {
 class TransactionManager;
 
 /**
- * LockManager handles transactions asking for locks on records.
+ * How LockManager handles deadlocks. DETECTION lets requests wait and breaks the cycles of the waits-for graph in the
+ * background; the prevention modes resolve every conflict at enqueue time, by the age of the transactions, the lower
+ * txn_id_t being the older, so that no cycle ever forms:
+ * - WOUND_WAIT: an older requester aborts (wounds) the younger transactions it conflicts with, a younger one waits;
+ * - WAIT_DIE: an older requester waits, a younger one conflicting with an older transaction aborts (dies).
  */
-class LockManager {
-  enum class LockMode { SHARED, EXCLUSIVE };
+enum class DeadlockMode { DETECTION, WOUND_WAIT, WAIT_DIE };
 
-  class LockRequest {
+/**
+ * LockManager handles transactions asking for locks on records and on tables.
+ *
+ * Locks are hierarchical, table -> row: before locking rows of a table, a transaction locks the table in the
+ * intention mode of the row locks, INTENTION_SHARED for shared row locks and INTENTION_EXCLUSIVE for exclusive ones.
+ * A SHARED, SHARED_INTENTION_EXCLUSIVE or EXCLUSIVE table lock covers the row locks of its mode on every row of the
+ * table, which the transaction then does not take, see Transaction::IsRowLockCovered. The row lock functions do not
+ * check the table lock, the callers take it first.
+ *
+ * The key ranges of the indexes are locked apart from the rows, for scans to see no phantoms, see LockKeyRange.
+ */
+class LockManager {
+  /**
+   * The requests on a resource, linked through the requests themselves: the granted ones first, then the waiting ones
+   * in the order they are granted in. The granted requests are counted by mode, so that a request is checked against
+   * all of them at once.
+   */
+  class LockRequestQueue {
    public:
-    LockRequest(txn_id_t txn_id, LockMode lock_mode) : txn_id_(txn_id), lock_mode_(lock_mode), granted_(false) {}
-
-    txn_id_t txn_id_;
-    LockMode lock_mode_;
-    bool granted_;
+    LockRequest *head_ = nullptr;
+    LockRequest *tail_ = nullptr;
+    /** The first request not granted, nullptr if all are. */
+    LockRequest *first_waiting_ = nullptr;
+    /** The number of granted requests of each LockMode. */
+    std::array<uint32_t, NUM_LOCK_MODES> num_granted_{};
+    bool upgrading_ = false;
   };
 
-  class LockRequestQueue {
+  /** A partition of a lock table, holding the queues of the resources, RIDs or tables, that hash to it. */
+  template <typename Key>
+  class LockTableShard {
    public:
-    std::list<LockRequest> request_queue_;
-    std::condition_variable cv_;  // for notifying blocked transactions on this rid
-    bool upgrading_ = false;
+    SpinMutex latch_;
+    std::unordered_map<Key, LockRequestQueue, std::hash<Key>, std::equal_to<Key>,
+                       TrackedAllocator<std::pair<const Key, LockRequestQueue>, MemoryTag::LOCK_MANAGER>>
+        lock_table_;
+    /**
+     * The highest commit LSN of the transactions that released locks of the shard after appending their commit record,
+     * maybe before it was durable. A transaction granted a lock of the shard depends on it, as the queues are erased.
+     */
+    lsn_t release_lsn_ = INVALID_LSN;
   };
 
  public:
+  /** The default number of shards of the lock table. */
+  static constexpr size_t DEFAULT_NUM_SHARDS = 16;
+  /** The default number of row locks of a transaction on one table past which they are escalated to a table lock. */
+  static constexpr size_t DEFAULT_ESCALATION_THRESHOLD = 1000;
+
   /**
    * Creates a new lock manager configured for the deadlock detection policy.
+   * @param num_shards the number of shards of the lock table, each with its own latch
+   * @param escalation_threshold the number of row locks on one table past which RecordRowLock escalates them
+   */
+  explicit LockManager(size_t num_shards = DEFAULT_NUM_SHARDS,
+                       size_t escalation_threshold = DEFAULT_ESCALATION_THRESHOLD)
+      : LockManager(DeadlockMode::DETECTION, num_shards, escalation_threshold) {}
+
+  /**
+   * Creates a new lock manager configured for a deadlock policy; only DETECTION runs the cycle detection thread.
+   * @param deadlock_mode how deadlocks are handled
+   * @param num_shards the number of shards of the lock table, each with its own latch
+   * @param escalation_threshold the number of row locks on one table past which RecordRowLock escalates them
    */
-  LockManager() {
-    enable_cycle_detection_ = true;
-    cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
-    LOG_INFO("Cycle detection thread launched");
+  explicit LockManager(DeadlockMode deadlock_mode, size_t num_shards = DEFAULT_NUM_SHARDS,
+                       size_t escalation_threshold = DEFAULT_ESCALATION_THRESHOLD)
+      : deadlock_mode_(deadlock_mode),
+        escalation_threshold_(escalation_threshold),
+        shards_(std::max<size_t>(num_shards, 1)),
+        key_range_shards_(std::max<size_t>(num_shards, 1)) {
+    enable_cycle_detection_ = deadlock_mode_ == DeadlockMode::DETECTION;
+    if (enable_cycle_detection_) {
+      cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
+      LOG_INFO("Cycle detection thread launched");
+    }
+    MetricsRegistry *registry = MetricsRegistry::Global();
+    registry->RegisterHistogram(this, "lock_manager.lock_wait_us", &lock_wait_us_);
+    registry->RegisterCounter(this, "lock_manager.waits", &num_waits_);
+    registry->RegisterCounter(this, "lock_manager.deadlock_aborts", &num_deadlock_aborts_);
+    registry->RegisterCounter(this, "lock_manager.latch_contended", [this] { return GetNumLatchContended(); });
   }
 
   ~LockManager() {
-    enable_cycle_detection_ = false;
-    cycle_detection_thread_->join();
-    delete cycle_detection_thread_;
-    LOG_INFO("Cycle detection thread stopped");
+    MetricsRegistry::Global()->Unregister(this);
+    if (cycle_detection_thread_ != nullptr) {
+      enable_cycle_detection_ = false;
+      cycle_detection_thread_->join();
+      delete cycle_detection_thread_;
+      LOG_INFO("Cycle detection thread stopped");
+    }
+  }
+
+  /** @return how this lock manager handles deadlocks */
+  DeadlockMode GetDeadlockMode() const { return deadlock_mode_; }
+
+  /** @return the number of times a thread found the latch of a shard of the lock tables held */
+  uint64_t GetNumLatchContended() const {
+    uint64_t num_contended = table_locks_.latch_.GetNumContended();
+    for (const auto &shard : shards_) {
+      num_contended += shard.latch_.GetNumContended();
+    }
+    for (const auto &shard : key_range_shards_) {
+      num_contended += shard.latch_.GetNumContended();
+    }
+    return num_contended;
   }
 
   /*
    * [LOCK_NOTE]: For all locking functions, we:
-   * 1. return false if the transaction is aborted; and
+   * 1. return false if the transaction is aborted, by the deadlock policy as well; and
    * 2. block on wait, return true when the lock request is granted; and
    * 3. it is undefined behavior to try locking an already locked RID in the same transaction, i.e. the transaction
    *    is responsible for keeping track of its current locks.
@@ -92,9 +176,19 @@ class LockManager {
   bool LockExclusive(Transaction *txn, const RID &rid);
 
   /**
-   * Upgrade a lock from a shared lock to an exclusive lock.
+   * Acquire a lock on RID in increment mode, see LockMode::INCREMENT; upgrades a shared lock to an exclusive one
+   * instead. See [LOCK_NOTE] in header file.
+   * @param txn the transaction requesting the increment lock
+   * @param rid the RID to be locked in increment mode
+   * @return true if the lock is granted, false otherwise
+   */
+  bool LockIncrement(Transaction *txn, const RID &rid);
+
+  /**
+   * Upgrade a lock from a shared or an increment lock to an exclusive lock. LockShared and LockExclusive upgrade an
+   * increment lock too: a transaction reads or overwrites a row only once the others are done adding to it.
    * @param txn the transaction requesting the lock upgrade
-   * @param rid the RID that should already be locked in shared mode by the requesting transaction
+   * @param rid the RID that should already be locked in shared or increment mode by the requesting transaction
    * @return true if the upgrade is successful, false otherwise
    */
   bool LockUpgrade(Transaction *txn, const RID &rid);
@@ -107,6 +201,64 @@ class LockManager {
    */
   bool Unlock(Transaction *txn, const RID &rid);
 
+  /**
+   * Acquire a lock on a table, or upgrade the lock the transaction holds on it to cover lock_mode as well: the new
+   * mode is the weakest one covering both, SHARED_INTENTION_EXCLUSIVE for SHARED and INTENTION_EXCLUSIVE. See
+   * [LOCK_NOTE]; a shared mode under READ_UNCOMMITTED aborts the transaction.
+   * @param txn the transaction requesting the lock
+   * @param lock_mode the mode to lock the table in
+   * @param table_oid the table to be locked
+   * @return true if the lock is granted, false otherwise
+   */
+  bool LockTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid);
+
+  /**
+   * Release the lock held by the transaction on a table. Its row locks in the table should be released first.
+   * @param txn the transaction releasing the lock, it should actually hold the lock
+   * @param table_oid the table that is locked by the transaction
+   * @return true if the unlock is successful, false otherwise
+   */
+  bool UnlockTable(Transaction *txn, table_oid_t table_oid);
+
+  /**
+   * Acquire a lock on a key range of an index, or upgrade the lock the transaction holds on it to EXCLUSIVE if it is of
+   * another mode. Next-key locking: a scan locks SHARED the range of every entry it reads and the range of the first
+   * entry past them, an insert locks INSERT_INTENTION the range of the first entry past its key, and a delete locks
+   * EXCLUSIVE the range of its entry, which the delete merges into the next one. So an insert waits for the scans of
+   * its gap, and the inserts into a gap proceed at once. Key range locks are held until the transaction ends. See
+   * [LOCK_NOTE] in header file.
+   * @param txn the transaction requesting the lock
+   * @param range the key range to be locked
+   * @param lock_mode SHARED, INSERT_INTENTION or EXCLUSIVE
+   * @return true if the lock is granted, false otherwise
+   */
+  bool LockKeyRange(Transaction *txn, const KeyRange &range, LockMode lock_mode);
+
+  /**
+   * Release every key range lock held by the transaction, as it ends.
+   * @param txn the transaction releasing the locks
+   */
+  void UnlockKeyRanges(Transaction *txn);
+
+  /**
+   * Records that the row lock txn holds on rid, if any, is on a tuple of the table. Once txn holds more than
+   * escalation_threshold row locks on the table, they are escalated: txn locks the table EXCLUSIVE if any of them is
+   * exclusive or increment and SHARED otherwise, then releases the row locks the table lock covers, staying in its
+   * growing phase.
+   * Shared row locks are only escalated under REPEATABLE_READ, where they are held until commit anyway.
+   * @param txn the transaction holding the row lock
+   * @param table_oid the table of the tuple
+   * @param rid the locked tuple
+   * @return false if txn was aborted while it waited for the table lock, true otherwise
+   */
+  bool RecordRowLock(Transaction *txn, table_oid_t table_oid, const RID &rid);
+
+  /** @return true if locks of the two modes, held by different transactions, are compatible */
+  static bool AreCompatible(LockMode held, LockMode requested);
+
+  /** @return the weakest mode covering both modes */
+  static LockMode Combine(LockMode a, LockMode b);
+
   /*** Graph API ***/
   /**
    * Adds edge t1->t2
@@ -132,14 +284,120 @@ class LockManager {
   void RunCycleDetection();
 
  private:
-  std::mutex latch_;
+  /** @return the shard of the lock table holding the queue of rid */
+  LockTableShard<RID> &GetShard(const RID &rid) { return shards_[std::hash<RID>()(rid) % shards_.size()]; }
+
+  /** @return the shard of the key range lock table holding the queue of range */
+  LockTableShard<KeyRange> &GetShard(const KeyRange &range) {
+    return key_range_shards_[std::hash<KeyRange>()(range) % key_range_shards_.size()];
+  }
+
+  /**
+   * Enqueues a request of txn on a resource of shard and waits until it is granted. The upgrade request of a queue
+   * replaces the request of txn in it and goes ahead of the requests waiting there. Under a prevention mode, the
+   * conflicts of the request are resolved before it waits, see DeadlockMode.
+   * @return true if the request is granted, false if txn was aborted, before or while it waited
+   */
+  template <typename Key>
+  bool Acquire(Transaction *txn, LockTableShard<Key> *shard, const Key &key, LockMode lock_mode, bool upgrade);
+
+  /**
+   * Removes the request of txn on a resource of shard. @return false if there is none
+   * @param release_lsn the commit LSN of txn if it protected its writes with the lock, else INVALID_LSN
+   */
+  template <typename Key>
+  bool Release(Transaction *txn, lsn_t release_lsn, LockTableShard<Key> *shard, const Key &key);
+
+  /** Links request into queue ahead of pos, at the tail if pos is nullptr; request is not granted. */
+  static void Link(LockRequestQueue *queue, LockRequest *request, LockRequest *pos);
+
+  /** Unlinks request from queue. */
+  static void Unlink(LockRequestQueue *queue, LockRequest *request);
+
+  /** @return the request of txn_id in queue, nullptr if there is none */
+  static LockRequest *FindRequest(const LockRequestQueue &queue, txn_id_t txn_id);
+
+  /** @return true if request, waiting in queue, can be granted: it is the first waiting, compatible with the granted */
+  static bool IsGrantable(const LockRequestQueue &queue, const LockRequest *request);
+
+  /**
+   * Wakes up the waiting requests of queue after a change of it: under DETECTION all of them, which keep their edges
+   * in the waits-for graph up to date, else only the first one, the only one that may be grantable.
+   */
+  void NotifyWaiting(const LockRequestQueue &queue) const;
+
+  /**
+   * Collects the transactions request in queue waits for: those of the requests ahead of it that are waiting
+   * themselves or incompatible with it.
+   * @param[out] blockers their IDs, sorted
+   */
+  static void GetBlockers(const LockRequestQueue &queue, const LockRequest *request, std::vector<txn_id_t> *blockers);
+
+  /** Replaces the edges from txn_id in the waits-for graph by edges to the sorted targets. */
+  void SetWaitsFor(txn_id_t txn_id, const std::vector<txn_id_t> &targets);
+
+  /**
+   * Checks if the graph has a cycle through the transactions whose edges were added since they were last searched.
+   * @param[out] txn_id if there is such a cycle, will contain its newest transaction ID
+   * @return true if such a cycle is found
+   */
+  bool HasTouchedCycle(txn_id_t *txn_id);
+
+  /**
+   * Applies the prevention mode to the new request in queue: to the requests ahead of it, which it waits for,
+   * and to the waiting ones behind an upgrade request, which wait for it.
+   * @param[out] aborted the other transactions aborted, wounded or dying
+   * @return false if the transaction of request itself must abort
+   */
+  bool PreventDeadlock(const LockRequestQueue &queue, const LockRequest *request, std::vector<txn_id_t> *aborted);
+
+  /** Aborts txn_id if it waits for a lock, and wakes it up to see it. */
+  void AbortWaiting(txn_id_t txn_id);
+
+  /** Releases the row lock of txn on rid, and forgets the table of rid, without ending its growing phase. */
+  bool ReleaseRowLock(Transaction *txn, const RID &rid);
+
+  /** Aborts txn for reason and throws. */
+  [[noreturn]] static void AbortImplicitly(Transaction *txn, AbortReason reason);
+
+  /**
+   * Searches the waits-for graph depth first from txn_id for a cycle, visiting the lowest transaction IDs first.
+   * @param path the transactions on the path to txn_id
+   * @param visited the transactions searched from already
+   * @param[out] cycle_txn_id if a cycle is found, will contain its newest transaction ID
+   * @return true if a cycle is found
+   */
+  bool FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::unordered_set<txn_id_t> *visited,
+                 txn_id_t *cycle_txn_id);
+
+  const DeadlockMode deadlock_mode_;
   std::atomic<bool> enable_cycle_detection_;
-  std::thread *cycle_detection_thread_;
+  std::thread *cycle_detection_thread_ = nullptr;
+  /** The number of row locks of a transaction on one table past which they are escalated to a table lock. */
+  const size_t escalation_threshold_;
 
-  /** Lock table for lock requests. */
-  std::unordered_map<RID, LockRequestQueue> lock_table_;
-  /** Waits-for graph representation. */
-  std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for_;
+  /** Lock table for lock requests on rows, partitioned into shards by the hash of the RID. */
+  std::vector<LockTableShard<RID>> shards_;
+  /** Lock table for lock requests on key ranges of indexes, partitioned into shards by the hash of the range. */
+  std::vector<LockTableShard<KeyRange>> key_range_shards_;
+  /** Lock table for lock requests on tables, which are few. */
+  LockTableShard<table_oid_t> table_locks_;
+  /** Guards waits_for_ and touched_, taken after a shard latch, never before. */
+  std::mutex waits_for_latch_;
+  /** Waits-for graph representation, the targets of each transaction kept sorted, maintained by the waiters. */
+  std::map<txn_id_t, std::vector<txn_id_t>> waits_for_;
+  /** The transactions whose edges were added to since cycle detection last searched from them. */
+  std::set<txn_id_t> touched_;
+  /** Guards abort_waiting_, taken after a shard latch, never before. */
+  std::mutex waiting_latch_;
+  /** For each waiting transaction, aborts it if it still waits on its queue, and notifies the queue. */
+  std::unordered_map<txn_id_t, std::function<void()>> abort_waiting_;
+  /** The time a request waits before it is granted or aborted, exported as "lock_manager.lock_wait_us". */
+  Histogram lock_wait_us_;
+  /** The requests that waited, "lock_manager.waits". */
+  Counter num_waits_;
+  /** The transactions aborted to prevent or break a deadlock, "lock_manager.deadlock_aborts". */
+  Counter num_deadlock_aborts_;
 };
 
 }  // namespace bustub
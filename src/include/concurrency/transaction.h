@@ -12,16 +12,23 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "common/logger.h"
+#include "common/memory_tracker.h"
+#include "common/thread_pool.h"
 #include "storage/page/page.h"
+#include "storage/table/column_increment.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -49,15 +56,54 @@ enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
 
 /**
- * Type of write operation.
+ * Type of write operation. An INCREMENT is an update adding to integer columns in place, see ColumnIncrement.
  */
-enum class WType { INSERT = 0, DELETE, UPDATE };
+enum class WType { INSERT = 0, DELETE, UPDATE, INCREMENT };
 
 class TableHeap;
 class Catalog;
+class MaterializedView;
 using table_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The oid of no table. */
+static constexpr table_oid_t INVALID_TABLE_OID = UINT32_MAX;
+
+/** Commit timestamps order the committed writes; a snapshot sees the writes committed up to its timestamp. */
+using timestamp_t = int64_t;
+/** The timestamp of no commit, an uncommitted write or no snapshot. */
+static constexpr timestamp_t INVALID_TS = -1;
+
+/**
+ * How a transaction keeps its reads consistent with the writes of the others.
+ */
+enum class ConcurrencyMode {
+  /** Two-phase locking of the rows and tables read and written. */
+  LOCKING,
+  /** Read-only, reading a snapshot of the transactions committed when it began, without locks. */
+  SNAPSHOT,
+  /**
+   * Optimistic: reads the newest committed versions without locks, and is validated when it commits against the
+   * writes committed since. Its writes lock the rows like in LOCKING.
+   */
+  OPTIMISTIC
+};
+
+/**
+ * ReadRecord tracks a tuple read by an optimistic transaction, and the version it read.
+ */
+class TableReadRecord {
+ public:
+  TableReadRecord(RID rid, TableHeap *table, timestamp_t version_ts)
+      : rid_(rid), table_(table), version_ts_(version_ts) {}
+
+  RID rid_;
+  /** The table heap specifies which table this read record is for. */
+  TableHeap *table_;
+  /** The commit timestamp of the version read, or of the transaction begin if it is older. */
+  timestamp_t version_ts_;
+};
+
 /**
  * WriteRecord tracks information related to a write.
  */
@@ -72,6 +118,8 @@ class TableWriteRecord {
   Tuple tuple_;
   /** The table heap specifies which table this write record is for. */
   TableHeap *table_;
+  /** The increments of an increment, taken out again on abort rather than restoring the old tuple. */
+  std::vector<ColumnIncrement> increments_;
 };
 
 /**
@@ -99,6 +147,80 @@ class IndexWriteRecord {
   Catalog *catalog_;
 };
 
+/** ViewDelta is a tuple written to the base table of a materialized view, folded into the view at commit. */
+struct ViewDelta {
+  MaterializedView *view_;
+  /** The tuple of the base table. */
+  Tuple tuple_;
+  /** True if the tuple was inserted, false if it was deleted. */
+  bool insert_;
+};
+
+/**
+ * Modes of the locks of LockManager. Rows are locked SHARED, EXCLUSIVE or INCREMENT; tables in any mode but INCREMENT
+ * and INSERT_INTENTION, the intention modes announcing the row locks the transaction takes in the table,
+ * INTENTION_EXCLUSIVE those of INCREMENT as well. INCREMENT is compatible with itself only: the transactions holding it
+ * on a row add to its integer columns at once, their increments commuting, and none can read the row until they are
+ * done. Key ranges, see KeyRange, are locked SHARED by the scans reading them, INSERT_INTENTION by the inserts into
+ * them, which is compatible with itself only, and EXCLUSIVE by the deletes out of them.
+ */
+enum class LockMode {
+  INTENTION_SHARED,
+  INTENTION_EXCLUSIVE,
+  SHARED,
+  SHARED_INTENTION_EXCLUSIVE,
+  EXCLUSIVE,
+  INCREMENT,
+  INSERT_INTENTION
+};
+
+/** The number of modes of LockMode. */
+static constexpr size_t NUM_LOCK_MODES = 7;
+
+/**
+ * KeyRange names a range of the keys of an index for next-key locking: the key of an entry of the index, and the gap
+ * between it and the key of the entry before it. The range past the last entry is named by an invalid RID. A scan
+ * locks the ranges of the entries it reads and the range past them, so that no key can be inserted among them; see
+ * LockManager::LockKeyRange.
+ */
+struct KeyRange {
+  index_oid_t index_oid_;
+  /** The record id of the entry, which tells the entries of equal keys apart. */
+  RID rid_;
+
+  bool operator==(const KeyRange &other) const { return index_oid_ == other.index_oid_ && rid_ == other.rid_; }
+};
+
+}  // namespace bustub
+
+namespace std {
+template <>
+struct hash<bustub::KeyRange> {
+  size_t operator()(const bustub::KeyRange &range) const {
+    return hash<bustub::RID>()(range.rid_) * 31 + range.index_oid_;
+  }
+};
+}  // namespace std
+
+namespace bustub {
+
+/**
+ * LockRequest is a request of a transaction for a lock of LockManager. The transaction owns its requests and reuses the
+ * ones of the locks it released, see Transaction::NewLockRequest; the lock manager links them into the queue of the
+ * resource, so that a lock request allocates nothing.
+ */
+class LockRequest {
+ public:
+  txn_id_t txn_id_{INVALID_TXN_ID};
+  LockMode lock_mode_{LockMode::SHARED};
+  bool granted_{false};
+  /** The requests ahead of and behind this one in the queue of the resource. */
+  LockRequest *prev_{nullptr};
+  LockRequest *next_{nullptr};
+  /** Waited on with the latch of the queue, notified when the request may be grantable or its transaction aborted. */
+  std::condition_variable_any cv_;
+};
+
 /**
  * Reason to a transaction abortion
  */
@@ -146,7 +268,7 @@ class TransactionAbortException : public std::exception {
 /**
  * Transaction tracks information related to a transaction.
  */
-class Transaction {
+class Transaction : public TrackedObject<MemoryTag::TRANSACTIONS> {
  public:
   explicit Transaction(txn_id_t txn_id, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ)
       : state_(TransactionState::GROWING),
@@ -155,8 +277,13 @@ class Transaction {
         txn_id_(txn_id),
         prev_lsn_(INVALID_LSN),
         shared_lock_set_{new std::unordered_set<RID>},
-        exclusive_lock_set_{new std::unordered_set<RID>} {
+        exclusive_lock_set_{new std::unordered_set<RID>},
+        increment_lock_set_{new std::unordered_set<RID>},
+        table_lock_map_{new std::unordered_map<table_oid_t, LockMode>},
+        key_range_lock_map_{new std::unordered_map<KeyRange, LockMode>},
+        table_row_lock_map_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>} {
     // Initialize the sets that will be tracked.
+    table_read_set_ = std::make_shared<std::deque<TableReadRecord>>();
     table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
     index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
     page_set_ = std::make_shared<std::deque<bustub::Page *>>();
@@ -173,18 +300,57 @@ class Transaction {
   /** @return the id of this transaction */
   inline txn_id_t GetTransactionId() const { return txn_id_; }
 
+  /** @return true if this transaction began with TransactionManager::BeginReadOnly, which owns it */
+  inline bool IsReadOnly() const { return read_only_; }
+
+  /** Makes this a read-only transaction, owned by the transaction manager. */
+  inline void SetReadOnly() { read_only_ = true; }
+
+  /**
+   * Makes a finished read-only transaction new again under another id, so that TransactionManager::BeginReadOnly
+   * reuses it and its sets, which it left empty, instead of allocating them again.
+   */
+  void Renew(txn_id_t txn_id) {
+    state_ = TransactionState::GROWING;
+    workload_class_ = WorkloadClass::INTERACTIVE;
+    thread_id_ = std::this_thread::get_id();
+    txn_id_ = txn_id;
+    prev_lsn_ = INVALID_LSN;
+    begin_log_offset_ = 0;
+    commit_lsn_ = INVALID_LSN;
+    dependency_lsn_ = INVALID_LSN;
+  }
+
   /** @return the isolation level of this transaction */
   inline IsolationLevel GetIsolationLevel() const { return isolation_level_; }
 
+  /** @return the workload class the tasks of the queries of this transaction are scheduled in */
+  inline WorkloadClass GetWorkloadClass() const { return workload_class_; }
+
+  /** Schedules the tasks of the queries of this transaction in a workload class, e.g. ANALYTICAL for a report. */
+  inline void SetWorkloadClass(WorkloadClass workload_class) { workload_class_ = workload_class; }
+
+  /** @return the list of table read records of this transaction, kept if it is optimistic */
+  inline std::shared_ptr<std::deque<TableReadRecord>> GetReadSet() { return table_read_set_; }
+
   /** @return the list of table write records of this transaction */
   inline std::shared_ptr<std::deque<TableWriteRecord>> GetWriteSet() { return table_write_set_; }
 
   /** @return the list of index write records of this transaction */
   inline std::shared_ptr<std::deque<IndexWriteRecord>> GetIndexWriteSet() { return index_write_set_; }
 
+  /** @return the changes to the base tables of materialized views, in the order they were made */
+  inline std::vector<ViewDelta> *GetViewDeltas() { return &view_deltas_; }
+
   /** @return the page set */
   inline std::shared_ptr<std::deque<Page *>> GetPageSet() { return page_set_; }
 
+  /**
+   * Adds a tuple read record into the table read set of this optimistic transaction.
+   * @param read_record the read record of the tuple
+   */
+  inline void AppendTableReadRecord(const TableReadRecord &read_record) { table_read_set_->push_back(read_record); }
+
   /**
    * Adds a tuple write record into the table write set.
    * @param write_record write record to be added
@@ -228,6 +394,84 @@ class Transaction {
   /** @return true if rid is exclusively locked by this transaction */
   bool IsExclusiveLocked(const RID &rid) { return exclusive_lock_set_->find(rid) != exclusive_lock_set_->end(); }
 
+  /** @return the set of resources under an increment lock */
+  inline std::shared_ptr<std::unordered_set<RID>> GetIncrementLockSet() { return increment_lock_set_; }
+
+  /** @return true if rid is locked for increments by this transaction */
+  bool IsIncrementLocked(const RID &rid) { return increment_lock_set_->find(rid) != increment_lock_set_->end(); }
+
+  /** @return the modes of the table locks held by this transaction */
+  inline std::shared_ptr<std::unordered_map<table_oid_t, LockMode>> GetTableLockMap() { return table_lock_map_; }
+
+  /** @return the modes of the key range locks held by this transaction */
+  inline std::shared_ptr<std::unordered_map<KeyRange, LockMode>> GetKeyRangeLockMap() { return key_range_lock_map_; }
+
+  /** @return true if the key range lock of this transaction on range, if any, covers lock_mode */
+  bool IsKeyRangeLocked(const KeyRange &range, LockMode lock_mode) {
+    auto iter = key_range_lock_map_->find(range);
+    return iter != key_range_lock_map_->end() && (iter->second == lock_mode || iter->second == LockMode::EXCLUSIVE);
+  }
+
+  /** @return the row locks of this transaction, of any mode, recorded for the tables of their tuples */
+  inline std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> GetTableRowLockMap() {
+    return table_row_lock_map_;
+  }
+
+  /**
+   * LockManager: takes a lock request of the transaction in no queue, or makes one if all are in queues.
+   * @param lock_mode the mode of the lock requested
+   * @return the request, not granted and linked to no other
+   */
+  LockRequest *NewLockRequest(LockMode lock_mode) {
+    LockRequest *request;
+    if (free_lock_requests_.empty()) {
+      request = &lock_requests_.emplace_back();
+    } else {
+      request = free_lock_requests_.back();
+      free_lock_requests_.pop_back();
+    }
+    request->txn_id_ = txn_id_;
+    request->lock_mode_ = lock_mode;
+    request->granted_ = false;
+    request->prev_ = nullptr;
+    request->next_ = nullptr;
+    return request;
+  }
+
+  /**
+   * LockManager: gives back a lock request taken out of its queue, for the next request to reuse.
+   * @param request a request of NewLockRequest
+   */
+  void FreeLockRequest(LockRequest *request) { free_lock_requests_.push_back(request);
+  }
+
+  /**
+   * @param table_oid the table
+   * @param[out] lock_mode the mode of the lock of this transaction on the table, if any
+   * @return true if this transaction holds a lock on the table
+   */
+  bool GetTableLockMode(table_oid_t table_oid, LockMode *lock_mode) {
+    auto iter = table_lock_map_->find(table_oid);
+    if (iter == table_lock_map_->end()) {
+      return false;
+    }
+    *lock_mode = iter->second;
+    return true;
+  }
+
+  /**
+   * @return true if the lock of this transaction on the table covers every row of it, so that the row lock, exclusive
+   * (or increment) or shared, need not be taken
+   */
+  bool IsRowLockCovered(table_oid_t table_oid, bool exclusive) {
+    LockMode lock_mode;
+    if (!GetTableLockMode(table_oid, &lock_mode)) {
+      return false;
+    }
+    return lock_mode == LockMode::EXCLUSIVE ||
+           (!exclusive && (lock_mode == LockMode::SHARED || lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE));
+  }
+
   /** @return the current state of the transaction */
   inline TransactionState GetState() { return state_; }
 
@@ -246,22 +490,101 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return the end of the log file when the transaction began: its records are at or after it */
+  inline int64_t GetBeginLogOffset() const { return begin_log_offset_; }
+
+  /**
+   * Set the offset in the log file the records of the transaction are at or after.
+   * @param begin_log_offset the end of the log file when the transaction began
+   */
+  inline void SetBeginLogOffset(int64_t begin_log_offset) { begin_log_offset_ = begin_log_offset; }
+
+  /** @return the LSN of the commit record, INVALID_LSN until the transaction appends one when it commits */
+  inline lsn_t GetCommitLSN() const { return commit_lsn_; }
+
+  /**
+   * Set the LSN of the commit record.
+   * @param commit_lsn the LSN of the commit record in the log buffer
+   */
+  inline void SetCommitLSN(lsn_t commit_lsn) { commit_lsn_ = commit_lsn; }
+
+  /**
+   * @return the highest commit LSN of the transactions this one may have read or overwritten the writes of before they
+   * were durable; it does not report its own commit until the log is persistent up to there
+   */
+  inline lsn_t GetDependencyLSN() const { return dependency_lsn_; }
+
+  /**
+   * Records a dependency on the commit of another transaction.
+   * @param lsn the commit LSN of that transaction
+   */
+  inline void AddDependencyLSN(lsn_t lsn) { dependency_lsn_ = std::max(dependency_lsn_, lsn); }
+
+  /** @return how this transaction keeps its reads consistent, see ConcurrencyMode */
+  inline ConcurrencyMode GetConcurrencyMode() const { return concurrency_mode_; }
+
+  /**
+   * @return true if this is a read-only transaction reading a snapshot: it takes no locks, and sees the versions of the
+   * tuples committed up to its read timestamp, see VersionStore
+   */
+  inline bool IsSnapshot() const { return concurrency_mode_ == ConcurrencyMode::SNAPSHOT; }
+
+  /** @return true if this is an optimistic transaction, which reads without locks and is validated when it commits */
+  inline bool IsOptimistic() const { return concurrency_mode_ == ConcurrencyMode::OPTIMISTIC; }
+
+  /** @return true if this transaction reads the versions of the tuples without locks: a snapshot or optimistic one */
+  inline bool ReadsVersions() const { return concurrency_mode_ != ConcurrencyMode::LOCKING; }
+
+  /**
+   * @return the timestamp of the snapshot this transaction reads, or of the last commit when it began if it is
+   * optimistic; INVALID_TS if it takes locks
+   */
+  inline timestamp_t GetReadTs() const { return read_ts_; }
+
+  /**
+   * Makes this a transaction reading the versions of the tuples.
+   * @param concurrency_mode SNAPSHOT or OPTIMISTIC
+   * @param read_ts the timestamp of its snapshot, or of the last commit if it is optimistic
+   */
+  inline void SetReadTs(ConcurrencyMode concurrency_mode, timestamp_t read_ts) {
+    concurrency_mode_ = concurrency_mode;
+    read_ts_ = read_ts;
+  }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
   /** The isolation level of the transaction. */
   IsolationLevel isolation_level_;
+  /** The workload class of the tasks of the transaction. */
+  WorkloadClass workload_class_{WorkloadClass::INTERACTIVE};
   /** The thread ID, used in single-threaded transactions. */
   std::thread::id thread_id_;
   /** The ID of this transaction. */
   txn_id_t txn_id_;
+  /** True if this transaction is read-only, pooled by the transaction manager. */
+  bool read_only_{false};
 
+  /** The tuples read by an optimistic transaction, validated when it commits. */
+  std::shared_ptr<std::deque<TableReadRecord>> table_read_set_;
   /** The undo set of table tuples. */
   std::shared_ptr<std::deque<TableWriteRecord>> table_write_set_;
   /** The undo set of indexes. */
   std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
+  /** The changes to the base tables of materialized views, folded into the views at commit. */
+  std::vector<ViewDelta> view_deltas_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
+  /** The end of the log file when the transaction began. */
+  int64_t begin_log_offset_{0};
+  /** The LSN of the commit record, appended before the locks are released and waited for after. */
+  lsn_t commit_lsn_{INVALID_LSN};
+  /** The highest LSN the log must be persistent up to before this transaction reports its commit. */
+  lsn_t dependency_lsn_{INVALID_LSN};
+  /** How this transaction keeps its reads consistent. */
+  ConcurrencyMode concurrency_mode_{ConcurrencyMode::LOCKING};
+  /** The timestamp of the snapshot, or of the last commit when an optimistic transaction began; else INVALID_TS. */
+  timestamp_t read_ts_{INVALID_TS};
 
   /** Concurrent index: the pages that were latched during index operation. */
   std::shared_ptr<std::deque<Page *>> page_set_;
@@ -272,6 +595,18 @@ class Transaction {
   std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
   std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+  /** LockManager: the set of increment-locked tuples held by this transaction. */
+  std::shared_ptr<std::unordered_set<RID>> increment_lock_set_;
+  /** LockManager: the modes of the locks on tables held by this transaction. */
+  std::shared_ptr<std::unordered_map<table_oid_t, LockMode>> table_lock_map_;
+  /** LockManager: the modes of the locks on key ranges held by this transaction. */
+  std::shared_ptr<std::unordered_map<KeyRange, LockMode>> key_range_lock_map_;
+  /** LockManager: the locked tuples of each table, as recorded by LockManager::RecordRowLock. */
+  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> table_row_lock_map_;
+  /** LockManager: every lock request the transaction made, at as many as it held locks at once. */
+  std::deque<LockRequest, TrackedAllocator<LockRequest, MemoryTag::LOCK_MANAGER>> lock_requests_;
+  /** LockManager: the requests of lock_requests_ in no queue. */
+  std::vector<LockRequest *> free_lock_requests_;
 };
 
 }  // namespace bustub
@@ -12,11 +12,18 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
+#include "common/rwlatch.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
@@ -38,15 +45,41 @@ class TransactionManager {
    * Begins a new transaction.
    * @param txn an optional transaction object to be initialized, otherwise a new transaction is created.
    * @param isolation_level an optional isolation level of the transaction.
+   * @param concurrency_mode how the transaction keeps its reads consistent: a snapshot reads the transactions
+   * committed so far without locks, whatever its isolation level, see ConcurrencyMode
    * @return an initialized transaction
    */
-  Transaction *Begin(Transaction *txn = nullptr, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ);
+  Transaction *Begin(Transaction *txn = nullptr, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ,
+                     ConcurrencyMode concurrency_mode = ConcurrencyMode::LOCKING);
+
+  /**
+   * Begins a read-only transaction: a snapshot, see ConcurrencyMode::SNAPSHOT, which takes no locks and logs nothing.
+   * It skips the list of running transactions, which only the lock manager and the checkpoints look up, and the
+   * checkpoint barrier; and its object comes from a pool of the manager, whose sets were allocated by a read-only
+   * transaction that finished, so that beginning and committing it costs about the registration of its snapshot. The
+   * manager owns the transaction, which must not be deleted nor used once committed or aborted: it goes back to the
+   * pool then.
+   * @return an initialized read-only transaction
+   */
+  Transaction *BeginReadOnly();
+
+  /**
+   * Makes the ids of the transactions beginning from now on go on from next_txn_id, if larger, e.g. past those of the
+   * log the recovery read.
+   */
+  void SetNextTransactionId(txn_id_t next_txn_id) {
+    txn_id_t current = next_txn_id_.load();
+    while (current < next_txn_id && !next_txn_id_.compare_exchange_weak(current, next_txn_id)) {
+    }
+  }
 
   /**
    * Commits a transaction.
    * @param txn the transaction to commit
+   * @return false if the transaction is optimistic and a tuple it read was written and committed since, it is then
+   * aborted instead
    */
-  void Commit(Transaction *txn);
+  bool Commit(Transaction *txn);
 
   /**
    * Aborts a transaction
@@ -54,31 +87,54 @@ class TransactionManager {
    */
   void Abort(Transaction *txn);
 
-  /**
-   * Global list of running transactions
-   */
-
-  /** The transaction map is a global list of all the running transactions in the system. */
-  static std::unordered_map<txn_id_t, Transaction *> txn_map;
-
   /**
    * Locates and returns the transaction with the given transaction ID.
-   * @param txn_id the id of the transaction to be found, it must exist!
+   * @param txn_id the id of the transaction to be found, it must be running!
    * @return the transaction with the given transaction id
    */
   static Transaction *GetTransaction(txn_id_t txn_id) {
-    assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
-    auto *res = TransactionManager::txn_map[txn_id];
+    TxnMapShard &shard = GetTxnMapShard(txn_id);
+    shard.latch_.RLock();
+    auto iter = shard.txns_.find(txn_id);
+    Transaction *res = iter == shard.txns_.end() ? nullptr : iter->second;
+    shard.latch_.RUnlock();
     assert(res != nullptr);
     return res;
   }
 
-  /** Prevents all transactions from performing operations, used for checkpointing. */
+  /** @return the commit timestamp of the last transaction committed, whose writes a new snapshot sees */
+  timestamp_t GetLastCommitTs() const { return last_commit_ts_.load(); }
+
+  /**
+   * @return the read timestamp of the oldest running snapshot, or the last commit timestamp if none runs: every
+   * snapshot, running or yet to begin, sees the writes committed up to it
+   */
+  timestamp_t GetOldestSnapshotTs();
+
+  /** @return the number of running transactions in the system */
+  static size_t GetNumRunningTransactions();
+
+  /**
+   * Prevents all transactions from performing operations, used for consistent checkpoints: waits for the running
+   * transactions to finish, and blocks those beginning until ResumeTransactions.
+   */
   void BlockAllTransactions();
 
   /** Resumes all transactions, used for checkpointing. */
   void ResumeTransactions();
 
+  /**
+   * Takes the transaction table of a checkpoint: the running transactions that logged a record and did not commit
+   * yet, with the LSN of their last record. Those committing are left out under the commit latch, so that the commit
+   * record of every transaction in the table is appended after it is taken.
+   * @param[out] txn_table the transactions mapped to the LSN of their last record
+   * @return the smallest offset in the log file their records are at or after, INT64_MAX if there are none
+   */
+  int64_t GetTransactionTable(std::unordered_map<txn_id_t, lsn_t> *txn_table);
+
+  /** @return the number of transactions of this manager that are running, or beginning */
+  size_t GetNumActiveTransactions() const { return num_in_barrier_.load(); }
+
  private:
   /**
    * Releases all the locks held by the given transaction.
@@ -92,17 +148,104 @@ class TransactionManager {
     for (auto item : *txn->GetSharedLockSet()) {
       lock_set.emplace(item);
     }
+    for (auto item : *txn->GetIncrementLockSet()) {
+      lock_set.emplace(item);
+    }
     for (auto locked_rid : lock_set) {
       lock_manager_->Unlock(txn, locked_rid);
     }
+    lock_manager_->UnlockKeyRanges(txn);
+    // The table locks go last, after the row locks under them.
+    std::vector<table_oid_t> locked_tables;
+    for (const auto &[table_oid, lock_mode] : *txn->GetTableLockMap()) {
+      locked_tables.push_back(table_oid);
+    }
+    for (table_oid_t table_oid : locked_tables) {
+      lock_manager_->UnlockTable(txn, table_oid);
+    }
+  }
+
+  /** A partition of the global list of running transactions, by transaction ID. */
+  struct TxnMapShard {
+    ReaderWriterLatch latch_;
+    std::unordered_map<txn_id_t, Transaction *, std::hash<txn_id_t>, std::equal_to<txn_id_t>,
+                       TrackedAllocator<std::pair<const txn_id_t, Transaction *>, MemoryTag::TRANSACTIONS>>
+        txns_;
+  };
+
+  /** The number of shards of the global list of running transactions. */
+  static constexpr size_t NUM_TXN_MAP_SHARDS = 16;
+
+  /** @return the shard of the global list of running transactions holding txn_id */
+  static TxnMapShard &GetTxnMapShard(txn_id_t txn_id) {
+    return txn_map_shards[static_cast<size_t>(txn_id) % NUM_TXN_MAP_SHARDS];
   }
 
+  /** @return true if no tuple the optimistic txn read has a newer committed version, under the commit latch */
+  bool Validate(Transaction *txn);
+
+  /** Counts a beginning transaction in, after waiting for a blocking checkpoint to end. */
+  void EnterBarrier();
+
+  /** Counts a finished transaction out, waking up a blocking checkpoint if it was the last one. */
+  void LeaveBarrier();
+
+  /**
+   * Appends the commit record of a transaction that wrote to the log buffer, under the commit latch, so that the commit
+   * LSNs follow the commit timestamps. Without logging the transaction keeps INVALID_LSN.
+   */
+  void AppendCommitRecord(Transaction *txn);
+
+  /** Forgets the read timestamp of a finished snapshot or optimistic transaction. */
+  void EndSnapshot(Transaction *txn);
+
+  /**
+   * Applies the deletes of a committing transaction, grouped by page, so that each page is latched and logged once
+   * for all its deletes, see TableHeap::ApplyDeletes.
+   */
+  void ApplyDeletes(Transaction *txn);
+
+  /** Ends a read-only transaction, and gives it back to the pool. */
+  void EndReadOnly(Transaction *txn, TransactionState state);
+
+  /** Removes the finished transaction from the global list of running transactions. */
+  static void RemoveTransaction(Transaction *txn);
+
+  /**
+   * The global list of all the running transactions in the system, shared by every TransactionManager. Transactions
+   * join it in Begin and leave it when they commit or abort, so it only holds the running ones.
+   */
+  static std::array<TxnMapShard, NUM_TXN_MAP_SHARDS> txn_map_shards;
+
   std::atomic<txn_id_t> next_txn_id_{0};
+  /** Taken while a transaction stamps its writes, so that the commit timestamps are published in order. */
+  std::mutex commit_latch_;
+  /** The commit timestamp of the last transaction that stamped all its writes. */
+  std::atomic<timestamp_t> last_commit_ts_{0};
+  /** The LSN of the commit record of that transaction, stored before its timestamp, or INVALID_LSN without logging. */
+  std::atomic<lsn_t> last_commit_lsn_{INVALID_LSN};
+  /** Taken to begin, end or look up the running snapshots. */
+  std::mutex snapshot_latch_;
+  /** The read timestamps of the running snapshots. */
+  std::multiset<timestamp_t> snapshots_;
+  /** Taken to take a read-only transaction out of the pool or put one back. */
+  std::mutex read_only_latch_;
+  /** Every read-only transaction of the manager, and those of them finished, pooled for BeginReadOnly. */
+  std::vector<std::unique_ptr<Transaction>> read_only_txns_;
+  std::vector<Transaction *> free_read_only_txns_;
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-
-  /** The global transaction latch is used for checkpointing. */
-  ReaderWriterLatch global_txn_latch_;
+  LogManager *log_manager_;
+
+  // The checkpoint barrier: the transactions only touch its two atomics as long as no checkpoint blocks them, and only
+  // wait on barrier_cv_, under barrier_latch_, while one does.
+  /** The number of running transactions, and of those beginning. */
+  std::atomic<size_t> num_in_barrier_{0};
+  /** True while a checkpoint blocks the transactions. */
+  std::atomic<bool> blocking_{false};
+  /** Taken by the checkpoints, and by the transactions waiting for one or waking one up. */
+  std::mutex barrier_latch_;
+  /** Signalled when a checkpoint ends, or the last transaction it waits for finishes. */
+  std::condition_variable barrier_cv_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vacuum_manager.h
+//
+// Identification: src/include/concurrency/vacuum_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catalog/catalog.h"
+#include "concurrency/transaction_manager.h"
+
+namespace bustub {
+
+/**
+ * VacuumManager reclaims the older versions of the tuples of the tables that no snapshot reads anymore, see
+ * VersionStore::Vacuum, so that the version chains stay short however long the tables are written.
+ *
+ * Its thread vacuums a few pages of every table per step and sleeps between steps, not to compete with the
+ * transactions for the latches of the version stores. A step goes by the oldest running snapshot of the transaction
+ * manager, which only moves forward. A step also merges the changes the indexes of the tables left pending, see
+ * Index::MergeChanges, as many keys' worth per index as pages per table, and frees the overflow chains of the
+ * committed deletes and updates the snapshots no longer read, see TableHeap::FreeRetiredChains.
+ */
+class VacuumManager {
+ public:
+  /** The most pages with version chains of a table vacuumed per step. */
+  static constexpr size_t DEFAULT_PAGES_PER_STEP = 64;
+  /** The pause of the thread between two steps. */
+  static constexpr std::chrono::milliseconds DEFAULT_VACUUM_INTERVAL{10};
+
+  /**
+   * Creates a new vacuum manager, whose thread is not started.
+   * @param transaction_manager the transaction manager beginning the snapshots
+   * @param catalog the catalog of the tables to vacuum
+   * @param pages_per_step the most pages of a table vacuumed per step
+   * @param vacuum_interval the pause of the thread between two steps
+   */
+  VacuumManager(TransactionManager *transaction_manager, Catalog *catalog,
+                size_t pages_per_step = DEFAULT_PAGES_PER_STEP,
+                std::chrono::milliseconds vacuum_interval = DEFAULT_VACUUM_INTERVAL)
+      : transaction_manager_(transaction_manager),
+        catalog_(catalog),
+        pages_per_step_(pages_per_step),
+        vacuum_interval_(vacuum_interval) {}
+
+  ~VacuumManager() { StopVacuumThread(); }
+
+  /** Starts the thread vacuuming the tables in the background. */
+  void RunVacuumThread();
+
+  /** Stops the thread, once its current step is done. */
+  void StopVacuumThread();
+
+  /**
+   * Vacuums the next pages_per_step pages with version chains of every table, frees its retired overflow chains, and
+   * merges the pending changes of the next pages_per_step keys of every index.
+   * @return the number of undo records reclaimed
+   */
+  size_t VacuumStep();
+
+ private:
+  /** The loop of the vacuum thread. */
+  void RunVacuum();
+
+  TransactionManager *transaction_manager_;
+  Catalog *catalog_;
+  const size_t pages_per_step_;
+  const std::chrono::milliseconds vacuum_interval_;
+  std::atomic<bool> enable_vacuum_{false};
+  std::thread *vacuum_thread_{nullptr};
+};
+
+}  // namespace bustub
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bounded_queue.h
+//
+// Identification: src/include/container/bounded_queue.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BoundedQueue is a lock-free, bounded, multi-producer multi-consumer FIFO queue.
+ *
+ * Each slot carries a sequence number that tells producers and consumers whose turn it is: a producer claims the
+ * slot of ticket t when its sequence is t, and publishes the item by setting it to t + 1; a consumer claims it when
+ * its sequence is t + 1, and frees it for the producer of ticket t + capacity. Claiming a ticket is a single CAS on
+ * the head or the tail, so neither side ever blocks the other; a full or an empty queue is reported to the caller.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  /**
+   * Creates an empty queue.
+   * @param capacity the maximum number of items in the queue, rounded up to a power of two
+   */
+  explicit BoundedQueue(size_t capacity) {
+    capacity_ = 1;
+    while (capacity_ < capacity) {
+      capacity_ <<= 1;
+    }
+    slots_ = std::make_unique<Slot[]>(capacity_);
+    for (size_t i = 0; i < capacity_; i++) {
+      slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(BoundedQueue);
+
+  /**
+   * Appends an item, moving from it only on success.
+   * @return false if the queue is full
+   */
+  bool TryPush(T *item) {
+    size_t ticket = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[ticket & (capacity_ - 1)];
+      size_t sequence = slot.sequence_.load(std::memory_order_acquire);
+      if (sequence == ticket) {
+        if (tail_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+          slot.item_ = std::move(*item);
+          slot.sequence_.store(ticket + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < ticket) {
+        // The consumer of the previous round has not freed the slot yet.
+        return false;
+      } else {
+        ticket = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Removes the oldest item.
+   * @param[out] item the removed item
+   * @return false if the queue is empty
+   */
+  bool TryPop(T *item) {
+    size_t ticket = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[ticket & (capacity_ - 1)];
+      size_t sequence = slot.sequence_.load(std::memory_order_acquire);
+      if (sequence == ticket + 1) {
+        if (head_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+          *item = std::move(slot.item_);
+          slot.sequence_.store(ticket + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < ticket + 1) {
+        // The producer of this round has not published the item yet.
+        return false;
+      } else {
+        ticket = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /** @return the maximum number of items in the queue */
+  size_t Capacity() const { return capacity_; }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence_;
+    T item_;
+  };
+
+  size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  /** The ticket of the next pop; kept on its own cache line from the ticket of the next push. */
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace bustub
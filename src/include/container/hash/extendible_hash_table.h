@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.h
+//
+// Identification: src/include/container/hash/extendible_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/hash_table.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+#define EXTENDIBLE_HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+/**
+ * Implementation of extendible hash table that is backed by a buffer pool manager. Non-unique keys are supported.
+ * Supports insert and delete. The table grows by splitting the buckets that fill up one at a time, doubling the
+ * directory when the bucket already uses all its bits, and shrinks by merging buckets that empty into their split
+ * image.
+ *
+ * Inserts, removes and lookups latch the table in read mode and their bucket page; only a split or a merge latches
+ * the table in write mode, and only for as long as it takes to rewrite one bucket and the directory.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
+ public:
+  /**
+   * Creates a new ExtendibleHashTable, with a directory of a single bucket
+   *
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param hash_fn the hash function
+   */
+  explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+
+  /**
+   * Inserts a key-value pair into the hash table.
+   * @param transaction the current transaction
+   * @param key the key to create
+   * @param value the value to be associated with the key
+   * @return true if insert succeeded, false if the pair is already in the table or its bucket is full and cannot be
+   * split any further
+   */
+  bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Deletes the associated value for the given key.
+   * @param transaction the current transaction
+   * @param key the key to delete
+   * @param value the value to delete
+   * @return true if remove succeeded, false otherwise
+   */
+  bool Remove(Transaction *transaction, const KeyType &key, const ValueType &value) override;
+
+  /**
+   * Performs a point query on the hash table.
+   * @param transaction the current transaction
+   * @param key the key to look up
+   * @param[out] result the value(s) associated with a given key
+   * @return the value(s) associated with the given key
+   */
+  bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
+
+  /**
+   * @return the global depth of the directory
+   */
+  uint32_t GetGlobalDepth();
+
+  /**
+   * Asserts that the directory is consistent, see HashTableDirectoryPage::VerifyIntegrity.
+   */
+  void VerifyIntegrity();
+
+ private:
+  /** @return the low 32 bits of the hash of the key, the low bits of which index the directory */
+  uint32_t Hash(const KeyType &key);
+
+  inline uint32_t KeyToDirectoryIndex(const KeyType &key, HashTableDirectoryPage *dir_page) {
+    return Hash(key) & dir_page->GetGlobalDepthMask();
+  }
+
+  HashTableDirectoryPage *FetchDirectoryPage();
+
+  /** @return the pinned page of the bucket */
+  Page *FetchBucketPage(page_id_t bucket_page_id);
+
+  inline HASH_TABLE_BUCKET_TYPE *BucketOf(Page *page) {
+    return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  }
+
+  /**
+   * Inserts into a full bucket, splitting it until the bucket of the key has room. Latches the table in write mode.
+   */
+  bool SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value);
+
+  /**
+   * Merges the bucket of the key into its split image if it is empty and both have the same local depth, then
+   * shrinks the directory as far as it can. Latches the table in write mode.
+   */
+  void Merge(Transaction *transaction, const KeyType &key);
+
+  // member variable
+  page_id_t directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+
+  // Readers includes inserts and removes, writers are splits and merges
+  ReaderWriterLatch table_latch_;
+
+  // Hash function
+  HashFunction<KeyType> hash_fn_;
+};
+
+}  // namespace bustub
@@ -14,10 +14,20 @@
 
 #include <cstdint>
 
-#include "murmur3/MurmurHash3.h"
+#include "common/util/hash_util.h"
 
 namespace bustub {
 
+/**
+ * KeyHasher hashes the keys of a type, and is specialized for types whose bytes do not make a key. By default the bytes
+ * of a key are hashed by HashUtil::Hash, which hashes keys of 4, 8 or 16 bytes, such as integers and GenericKey<8> or
+ * GenericKey<16>, as words rather than as byte strings.
+ */
+template <typename KeyType>
+struct KeyHasher {
+  static uint64_t Hash(const KeyType &key) { return HashUtil::Hash(&key); }
+};
+
 template <typename KeyType>
 class HashFunction {
  public:
@@ -25,12 +35,7 @@ class HashFunction {
    * @param key the key to be hashed
    * @return the hashed value
    */
-  virtual uint64_t GetHash(KeyType key) {
-    uint64_t hash[2];
-    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(&key), static_cast<int>(sizeof(KeyType)), 0,
-                                 reinterpret_cast<void *>(&hash));
-    return hash[0];
-  }
+  virtual uint64_t GetHash(KeyType key) { return KeyHasher<KeyType>::Hash(key); }
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -31,7 +32,22 @@ namespace bustub {
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table dynamically grows once full.
+ * table dynamically grows once three quarters full.
+ *
+ * Probing goes a group of BLOCK_GROUP_SIZE slots at a time, see HashTableBlockPage: the hash of a key picks the group
+ * its probe starts at, and its tag, matched against the control bytes of a whole group at once, picks the slots of a
+ * group whose key is compared. The size of a table is thus a multiple of BLOCK_GROUP_SIZE.
+ *
+ * Growing is incremental: a resize only allocates the new, larger table, and the old one is kept alongside it while
+ * each later operation migrates the next MIGRATION_STEP slots of the old table, the way Redis rehashes its
+ * dictionaries. Lookups and removes consult both tables until the migration finishes; inserts only go to the new one.
+ * No single operation thus pays for rehashing the whole table.
+ *
+ * Operations take the table latch in read mode; only starting a resize and dropping the old table take it in write
+ * mode. The pairs of a key, in either table, are only inserted, removed or migrated with the block page its probe
+ * sequence starts at in the current table write latched, which serializes the duplicate checks of the key without
+ * ever holding two block latches. Slots are claimed with the compare and swap of the block page and never reused,
+ * so lookups read them without latches, the old table before the new one so that a migrating pair is not missed.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -52,7 +68,8 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    * @param transaction the current transaction
    * @param key the key to create
    * @param value the value to be associated with the key
-   * @return true if insert succeeded, false otherwise
+   * @return true if insert succeeded, false otherwise: the pair is already there, the table is full and can grow no
+   * more, or the key is too large for any block page
    */
   bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value) override;
 
@@ -75,24 +92,133 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Performs point queries for a batch of keys, as GetValue does for each. The keys go PROBE_GROUP_SIZE at a time:
+   * the keys of a group are all hashed and the slots their probes start at are prefetched first, and only then are
+   * they probed, so that the cache misses of the group overlap instead of stalling each probe in turn.
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results[i] is set to the values associated with keys[i]
+   */
+  void GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Resizes the table to at least twice the initial size provided, and never less than twice its current size. The
+   * migration of a resize in progress is finished first; the migration of this one is left to later operations.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
 
   /**
    * Gets the size of the hash table
-   * @return current size of the hash table
+   * @return current size of the hash table, the new one while a resize is in progress
    */
   size_t GetSize();
 
+  /**
+   * @return true if the pairs of the table before the last resize are still being migrated
+   */
+  bool IsResizing();
+
+  /** The number of slots of the old table each operation migrates while a resize is in progress. */
+  static constexpr size_t MIGRATION_STEP = 32;
+
+  /** The number of keys GetValues prefetches ahead of probing them, each pinning the block its probe starts at. */
+  static constexpr size_t PROBE_GROUP_SIZE = 16;
+
  private:
+  enum class InsertResult { INSERTED, DUPLICATE, FULL };
+
+  /** The largest table a header page can describe. */
+  static constexpr size_t MAX_BUCKETS = HashTableHeaderPage::MAX_BLOCKS * BLOCK_ARRAY_SIZE;
+
+  /** @return the first slot of the group the probe for a key of the hash starts at in a table of the size */
+  static size_t HomeSlot(uint64_t hash, size_t size);
+
+  /** @return the number of buckets rounded up to whole groups, as the sizes of tables are */
+  static size_t RoundUpToGroups(size_t num_buckets);
+
+  /** @return the pinned, write latched block page the probe sequence of the key starts at in the current table */
+  Page *LatchHomeBlock(const KeyType &key);
+
+  void UnlatchHomeBlock(Page *page);
+
+  HashTableHeaderPage *FetchHeaderPage(page_id_t header_page_id);
+
+  HASH_TABLE_BLOCK_TYPE *FetchBlockPage(page_id_t block_page_id);
+
+  /** Allocates a table of the number of buckets, empty, and returns the page id of its header. */
+  page_id_t NewTable(size_t num_buckets);
+
+  /** Deletes the header and blocks of a table. */
+  void DeleteTable(page_id_t header_page_id);
+
+  /**
+   * Visits the slots of the probe sequence of a key of the hash in a table, a group at a time from its home group on,
+   * up to and including the first group with a slot never occupied, or until the visitor returns true. Of each group,
+   * only the slots whose tag matches the hash and the slots never occupied are visited.
+   * @param is_dirty whether the block the visitor stopped at is to be unpinned dirty
+   * @param visit called with the block page and the offset of each slot
+   * @return true if the visitor stopped the probe
+   */
+  template <typename Visitor>
+  bool Probe(page_id_t header_page_id, uint64_t hash, bool is_dirty, Visitor visit);
+
+  /** Probe, from a home slot of a table whose header is pinned, for the tag of the hash. */
+  template <typename Visitor>
+  bool ProbeFrom(HashTableHeaderPage *header, size_t home, uint8_t tag, bool is_dirty, Visitor visit);
+
+  /**
+   * @return a visitor of Probe that collects the values of the key into result, after the first num_values, skipping
+   * those already collected from the old table into result[num_values, *num_old_values)
+   */
+  auto Collector(const KeyType &key, std::vector<ValueType> *result, size_t num_values, const size_t *num_old_values);
+
+  /** Inserts the pair in the first free slot of its probe sequence in a table, unless already there. */
+  InsertResult InsertInto(page_id_t header_page_id, const KeyType &key, const ValueType &value);
+
+  /** @return true if the pair is in a table, in which case it is removed if remove is set */
+  bool FindPair(page_id_t header_page_id, const KeyType &key, const ValueType &value, bool remove);
+
+  /** GetSize, with the table latch held */
+  size_t GetSizeLocked();
+
+  /** @return true if the current table is loaded enough to grow, and can */
+  bool NeedsResize();
+
+  /**
+   * Finishes the resize in progress, if any, and allocates the new table of another to the number of buckets, to
+   * which the current one starts migrating. Needs the table latch in write mode.
+   */
+  void ResizeLocked(size_t num_buckets);
+
+  /**
+   * Moves the pairs of the next slots of the old table to the new one, if a resize is in progress.
+   * @param num_slots the number of slots to claim, which no other operation then migrates
+   * @return true if this call migrated the last of the slots of the old table
+   */
+  bool Migrate(size_t num_slots);
+
+  /** Inserts all the pairs of a table into another. */
+  void MoveAll(page_id_t from_header_page_id, page_id_t to_header_page_id);
+
+  /** Deletes the old table once all its slots have migrated. Takes the table latch in write mode. */
+  void FinishResize();
+
   // member variable
   page_id_t header_page_id_;
+  // the table being migrated from, INVALID_PAGE_ID unless a resize is in progress
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  // the number of slots of the old table, the next one to be claimed for migration, and how many have migrated
+  size_t old_size_{0};
+  std::atomic<size_t> migrate_index_{0};
+  std::atomic<size_t> num_migrated_{0};
+  // the slots of the current table ever occupied, tombstones included, which drive the probe lengths
+  std::atomic<size_t> num_occupied_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
+  // Readers includes inserts and removes, writers only swap and drop tables
   ReaderWriterLatch table_latch_;
 
   // Hash function
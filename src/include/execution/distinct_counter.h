@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_counter.h
+//
+// Identification: src/include/execution/distinct_counter.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+#include "common/util/hash_util.h"
+#include "common/util/hyperloglog.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * DistinctCounter counts the distinct non-NULL values added to it, the state of a COUNT DISTINCT aggregate of a group.
+ *
+ * An exact counter holds every distinct value, bucketed by hash; an approximate one only a HyperLogLog sketch of their
+ * hashes, a fixed few kilobytes however many values it sees. Counters of either kind merge, so that partial counts of
+ * the same group taken by several threads add up to the count of the group.
+ */
+class DistinctCounter {
+ public:
+  /** The estimated bytes of memory of a value held by an exact counter. */
+  static constexpr size_t VALUE_BYTES = sizeof(std::pair<const hash_t, Value>) + 3 * sizeof(void *);
+  /** The bytes of memory of the sketch of an approximate counter. */
+  static constexpr size_t SKETCH_BYTES = HyperLogLog::NUM_REGISTERS;
+
+  /** Creates an empty counter, exact or approximate. */
+  explicit DistinctCounter(bool approximate) {
+    if (approximate) {
+      sketch_.emplace();
+    }
+  }
+
+  /**
+   * Adds a value to the counter; NULL values are not counted.
+   * @return true if an exact counter held a new value for it
+   */
+  bool Add(const Value &value) {
+    if (value.IsNull()) {
+      return false;
+    }
+    hash_t hash = HashUtil::HashValue(&value);
+    if (sketch_.has_value()) {
+      sketch_->Add(hash);
+      return false;
+    }
+    return Insert(hash, value);
+  }
+
+  /**
+   * Adds the values of another counter of the same kind to this one.
+   * @return the number of new values an exact counter held for it
+   */
+  size_t Merge(const DistinctCounter &other) {
+    if (sketch_.has_value()) {
+      sketch_->Merge(*other.sketch_);
+      return 0;
+    }
+    size_t num_new = 0;
+    for (const auto &[hash, value] : other.values_) {
+      num_new += Insert(hash, value) ? 1 : 0;
+    }
+    return num_new;
+  }
+
+  /** @return the number of distinct values added, estimated if the counter is approximate */
+  uint64_t Count() const { return sketch_.has_value() ? sketch_->Estimate() : values_.size(); }
+
+ private:
+  /** Holds a value unless an equal one is held already. @return true if it was not */
+  bool Insert(hash_t hash, const Value &value) {
+    auto [begin, end] = values_.equal_range(hash);
+    for (auto iter = begin; iter != end; ++iter) {
+      if (iter->second.CompareEquals(value) == CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    values_.emplace(hash, value);
+    return true;
+  }
+
+  /** The distinct values of an exact counter, by hash. */
+  std::unordered_multimap<hash_t, Value> values_;
+  /** The sketch of an approximate counter. */
+  std::optional<HyperLogLog> sketch_;
+};
+
+}  // namespace bustub
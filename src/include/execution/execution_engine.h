@@ -12,14 +12,27 @@
 
 #pragma once
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "common/thread_pool.h"
 #include "concurrency/transaction_manager.h"
 #include "execution/executor_context.h"
 #include "execution/executor_factory.h"
+#include "execution/pipeline_engine.h"
 #include "execution/plans/abstract_plan.h"
+#include "execution/prepared_statement.h"
+#include "execution/query_profile.h"
+#include "execution/result_cache.h"
+#include "execution/result_cursor.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 namespace bustub {
 class ExecutionEngine {
@@ -31,32 +44,143 @@ class ExecutionEngine {
 
   bool Execute(const AbstractPlanNode *plan, std::vector<Tuple> *result_set, Transaction *txn,
                ExecutorContext *exec_ctx) {
-    // construct executor
-    auto executor = ExecutorFactory::CreateExecutor(exec_ctx, plan);
+    // a profiled plan runs for its profile
+    ResultCache::Key key;
+    if (result_cache_ != nullptr && exec_ctx->GetProfile() == nullptr &&
+        ResultCache::MakeKey(plan, exec_ctx->GetCatalog(), txn, &key)) {
+      if (result_cache_->Lookup(key, result_set)) {
+        return true;
+      }
+      std::vector<Tuple> result;
+      if (Run(plan, &result, txn, exec_ctx)) {
+        result_cache_->Insert(std::move(key), result);
+      }
+      if (result_set != nullptr) {
+        result_set->insert(result_set->end(), std::make_move_iterator(result.begin()),
+                           std::make_move_iterator(result.end()));
+      }
+      return true;
+    }
+    Run(plan, result_set, txn, exec_ctx);
+    return true;
+  }
+
+  /**
+   * Caches the results of the read-only plans that Execute runs in snapshots, returned again as long as the tables
+   * they read are not written, see ResultCache.
+   * @param capacity the number of bytes of results to hold at most
+   */
+  void EnableResultCache(size_t capacity = RESULT_CACHE_SIZE) {
+    result_cache_ = std::make_unique<ResultCache>(capacity);
+  }
+
+  /** @return the result cache, nullptr if it is not enabled */
+  ResultCache *GetResultCache() { return result_cache_.get(); }
+
+  /**
+   * Starts executing a plan, whose output the client then pulls from the returned cursor a batch at a time, instead
+   * of having Execute gather all of it, see ResultCursor. The executors run only as far as the client reads.
+   * @return the cursor over the output of the plan; exec_ctx and txn must outlive it
+   */
+  std::unique_ptr<ResultCursor> Open(const AbstractPlanNode *plan, Transaction *txn, ExecutorContext *exec_ctx) {
+    // exchanges run their children on the threads of the engine
+    exec_ctx->SetThreadPool(&thread_pool_);
+
+    // admit the query first, as some executors size themselves by the memory budget when created
+    exec_ctx->AdmitQuery(MemoryBroker::CountSpillingOperators(plan));
+    std::unique_ptr<ResultCursor> cursor;
+    try {
+      // construct executor
+      cursor = std::make_unique<ResultCursor>(plan, ExecutorFactory::CreateExecutor(exec_ctx, plan));
+    } catch (...) {
+      exec_ctx->ReleaseQuery();
+      throw;
+    }
+    cursor->Open();
+    return cursor;
+  }
 
+  /**
+   * Prepares a plan to be executed many times, with new values of its parameters each time, see PreparedStatement.
+   * @param parameters the constants of the expressions of the plan that are its parameters, in order
+   * @param exec_ctx the context the plan runs in every time, which must outlive the statement
+   */
+  std::unique_ptr<PreparedStatement> Prepare(const AbstractPlanNode *plan,
+                                             std::vector<ConstantValueExpression *> parameters,
+                                             ExecutorContext *exec_ctx) {
+    exec_ctx->SetThreadPool(&thread_pool_);
+    return std::make_unique<PreparedStatement>(exec_ctx, plan, ExecutorFactory::CreateExecutor(exec_ctx, plan),
+                                               std::move(parameters));
+  }
+
+  /**
+   * Executes a plan as Execute does, push-based rather than through the Init/Next interface of the executors, see
+   * PipelineEngine.
+   * @throws the exception of a pipeline that failed, of any of its tasks, once the query is released; result_set then
+   * holds a part of the output at most
+   */
+  bool ExecutePushed(const AbstractPlanNode *plan, std::vector<Tuple> *result_set, Transaction *txn,
+                     ExecutorContext *exec_ctx) {
+    exec_ctx->SetThreadPool(&thread_pool_);
+    exec_ctx->AdmitQuery(MemoryBroker::CountSpillingOperators(plan));
+    try {
+      PipelineEngine engine(exec_ctx, plan);
+      engine.Execute(result_set);
+    } catch (...) {
+      exec_ctx->ReleaseQuery();
+      throw;
+    }
+    exec_ctx->ReleaseQuery();
+    return true;
+  }
+
+  /**
+   * Executes a plan as Execute does, as EXPLAIN ANALYZE: each of its operators is profiled.
+   * @return the plan tree annotated with the profile of each operator, see QueryProfile::ToString
+   */
+  std::string ExecuteAnalyze(const AbstractPlanNode *plan, std::vector<Tuple> *result_set, Transaction *txn,
+                             ExecutorContext *exec_ctx) {
+    QueryProfile profile;
+    exec_ctx->SetProfile(&profile);
+    try {
+      Execute(plan, result_set, txn, exec_ctx);
+    } catch (...) {
+      exec_ctx->SetProfile(nullptr);
+      throw;
+    }
+    exec_ctx->SetProfile(nullptr);
+    return profile.ToString(plan);
+  }
+
+ private:
+  /** Runs a plan to its end. @return false if it was cut short by an exception */
+  bool Run(const AbstractPlanNode *plan, std::vector<Tuple> *result_set, Transaction *txn,
+           ExecutorContext *exec_ctx) {
     // prepare
-    executor->Init();
+    auto cursor = Open(plan, txn, exec_ctx);
 
     // execute
     try {
-      Tuple tuple;
-      RID rid;
-      while (executor->Next(&tuple, &rid)) {
+      TupleBatch batch;
+      while (cursor->NextBatch(&batch)) {
         if (result_set != nullptr) {
-          result_set->push_back(tuple);
+          result_set->insert(result_set->end(), batch.GetTuples().begin(), batch.GetTuples().end());
         }
       }
     } catch (Exception &e) {
       // TODO(student): handle exceptions
+      return false;
     }
-
     return true;
   }
 
- private:
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] TransactionManager *txn_mgr_;
   [[maybe_unused]] Catalog *catalog_;
+  /** The worker threads of the exchanges of all the plans the engine executes. */
+  ThreadPool thread_pool_{std::max(1U, std::thread::hardware_concurrency())};
+  /** The results of the plans executed, nullptr if they are not cached. */
+  std::unique_ptr<ResultCache> result_cache_;
 };
 
 }  // namespace bustub
@@ -12,15 +12,31 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "catalog/catalog.h"
+#include "common/thread_pool.h"
+#include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
+#include "execution/memory_broker.h"
+#include "storage/disk/temp_space.h"
 #include "storage/page/tmp_tuple_page.h"
+#include "storage/table/morsel_source.h"
 
 namespace bustub {
+
+class AbstractPlanNode;
+class QueryProfile;
+
+/** The default memory budget of the operators that spill to the temporary space past it, in bytes. */
+static constexpr size_t EXECUTOR_MEMORY_BUDGET = 16 << 20;
+
 /**
  * ExecutorContext stores all the context necessary to run an executor.
  */
@@ -45,6 +61,9 @@ class ExecutorContext {
   /** @return the running transaction */
   Transaction *GetTransaction() const { return transaction_; }
 
+  /** Runs the executors of the context in another transaction from now on, see PreparedStatement. */
+  void SetTransaction(Transaction *transaction) { transaction_ = transaction; }
+
   /** @return the catalog */
   Catalog *GetCatalog() { return catalog_; }
 
@@ -57,15 +76,189 @@ class ExecutorContext {
   /** @return the lock manager */
   LockManager *GetLockManager() { return lock_mgr_; }
 
+  /**
+   * Locks a table for the running transaction, if it takes locks at all: like the row locks of the table heap, table
+   * locks are only taken with logging enabled.
+   * @param table_oid the table to lock
+   * @param lock_mode the mode to lock the table in, see LockManager::LockTable
+   * @throws TransactionAbortException if the transaction is aborted instead
+   */
+  void LockTable(table_oid_t table_oid, LockMode lock_mode) {
+    if (!enable_logging || lock_mgr_ == nullptr || transaction_->IsSnapshot()) {
+      return;
+    }
+    // An optimistic transaction does not lock what it reads.
+    if (transaction_->IsOptimistic()) {
+      if (lock_mode == LockMode::INTENTION_SHARED || lock_mode == LockMode::SHARED) {
+        return;
+      }
+      if (lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE) {
+        lock_mode = LockMode::INTENTION_EXCLUSIVE;
+      }
+    }
+    if (!lock_mgr_->LockTable(transaction_, lock_mode, table_oid)) {
+      throw TransactionAbortException(transaction_->GetTransactionId(), AbortReason::DEADLOCK);
+    }
+    // The tuples of a partitioned table are those of its partitions, which are locked alike.
+    if (catalog_ != nullptr) {
+      for (TableMetadata *partition : catalog_->GetTable(table_oid)->partitions_) {
+        LockTable(partition->oid_, lock_mode);
+      }
+    }
+  }
+
+  /**
+   * @return true if the running transaction only holds the shared locks of the rows it scans for as long as it reads
+   * them, see ReleaseReadLock: under READ_COMMITTED, and when it takes row locks at all
+   */
+  bool ReleasesReadLocks() const {
+    return enable_logging && lock_mgr_ != nullptr && !transaction_->ReadsVersions() &&
+           transaction_->GetIsolationLevel() == IsolationLevel::READ_COMMITTED;
+  }
+
+  /**
+   * Releases the shared lock a scan took to read a row, once it is done with the tuple, so that a long scan under
+   * READ_COMMITTED neither piles up row locks nor holds the writers up until it commits, see ReleasesReadLocks.
+   * @param rid the row read
+   * @param was_locked true if the transaction held a lock on rid before the scan read it, which it keeps
+   */
+  void ReleaseReadLock(const RID &rid, bool was_locked) {
+    if (!was_locked && transaction_->IsSharedLocked(rid)) {
+      lock_mgr_->Unlock(transaction_, rid);
+    }
+  }
+
+  /**
+   * @return true if the running transaction locks the key ranges of the indexes of a table, see
+   * LockManager::LockKeyRange: when it takes row locks at all and its table lock does not cover them; to write, and to
+   * scan under REPEATABLE_READ, whose scans must not see phantoms
+   * @param table_oid the table of the indexes
+   * @param write true to insert or delete entries, false to scan them
+   */
+  bool LocksKeyRanges(table_oid_t table_oid, bool write) const {
+    if (!enable_logging || lock_mgr_ == nullptr || transaction_->IsRowLockCovered(table_oid, write)) {
+      return false;
+    }
+    return write ? !transaction_->IsSnapshot()
+                 : !transaction_->ReadsVersions() &&
+                       transaction_->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ;
+  }
+
+  /**
+   * Locks a key range of an index for the running transaction, see LocksKeyRanges.
+   * @throws TransactionAbortException if the transaction is aborted instead
+   */
+  void LockKeyRange(const KeyRange &range, LockMode lock_mode) {
+    if (!lock_mgr_->LockKeyRange(transaction_, range, lock_mode)) {
+      throw TransactionAbortException(transaction_->GetTransactionId(), AbortReason::DEADLOCK);
+    }
+  }
+
   /** @return the transaction manager */
   TransactionManager *GetTransactionManager() { return txn_mgr_; }
 
+  /**
+   * @return the memory budget of every operator that spills to the temporary space past it, in bytes; while the query
+   * is admitted by a memory broker, the share of each of those operators of the memory granted to the query
+   */
+  size_t GetMemoryBudget() const { return admitted_ ? memory_share_ : memory_budget_; }
+
+  /** Sets the memory budget of every operator that spills to the temporary space past it, in bytes. */
+  void SetMemoryBudget(size_t memory_budget) { memory_budget_ = memory_budget; }
+
+  /** Shares the memory of the queries of this context with those of others through a broker, nullptr for none. */
+  void SetMemoryBroker(MemoryBroker *memory_broker) { memory_broker_ = memory_broker; }
+
+  /** @return the broker the queries of this context are granted memory by, nullptr if none */
+  MemoryBroker *GetMemoryBroker() const { return memory_broker_; }
+
+  /**
+   * Admits the query about to run, waiting until the memory broker grants it memory, if there is a broker: the query
+   * asks for the memory budget of each of its operators that spill, which then share the grant equally, see
+   * MemoryBroker. Does nothing if there is no broker or the query is admitted already.
+   * @param num_operators the operators of the query that spill, see MemoryBroker::CountSpillingOperators
+   */
+  void AdmitQuery(size_t num_operators) {
+    if (memory_broker_ == nullptr || admitted_) {
+      return;
+    }
+    num_operators = std::max<size_t>(num_operators, 1);
+    const size_t request = std::min(memory_budget_, SIZE_MAX / num_operators) * num_operators;
+    memory_grant_ = memory_broker_->Admit(request, request / MEMORY_GRANT_MIN_FRACTION);
+    memory_share_ = std::max<size_t>(memory_grant_ / num_operators, 1);
+    admitted_ = true;
+  }
+
+  /** Gives the memory granted to the query that ran back to the broker, if it was admitted. */
+  void ReleaseQuery() {
+    if (admitted_) {
+      memory_broker_->Release(memory_grant_);
+      admitted_ = false;
+    }
+  }
+
+  /** @return true if the running query was admitted by a memory broker, its operators sharing what it was granted */
+  bool IsAdmitted() const { return admitted_; }
+
+  /** @return the temporary space the operators spill to, the context's own unless another was set */
+  TempSpace *GetTempSpace() { return temp_space_; }
+
+  /** Makes the operators spill to a temporary space shared with other contexts, or to the context's own if nullptr. */
+  void SetTempSpace(TempSpace *temp_space) { temp_space_ = temp_space != nullptr ? temp_space : &own_temp_space_; }
+
+  /** @return the workload class the tasks of the query are scheduled in on the thread pool, that of its transaction */
+  WorkloadClass GetWorkloadClass() const {
+    return transaction_ == nullptr ? WorkloadClass::INTERACTIVE : transaction_->GetWorkloadClass();
+  }
+
+  /** @return the worker threads exchanges run their children on, nullptr to run them on the calling thread */
+  ThreadPool *GetThreadPool() { return thread_pool_; }
+
+  /** Sets the worker threads exchanges run their children on. */
+  void SetThreadPool(ThreadPool *thread_pool) { thread_pool_ = thread_pool; }
+
+  /** @return the profile the operators add to under EXPLAIN ANALYZE, nullptr if the query is not profiled */
+  QueryProfile *GetProfile() { return profile_; }
+
+  /** Sets the profile the operators created from now on add to, see ExecutionEngine::ExecuteAnalyze. */
+  void SetProfile(QueryProfile *profile) { profile_ = profile; }
+
+  /** @return the pages the scan of plan is split across the workers of an exchange by, nullptr if it is not split */
+  MorselSource *GetMorselSource(const AbstractPlanNode *plan) {
+    std::scoped_lock lock(morsel_latch_);
+    auto iter = morsel_sources_.find(plan);
+    return iter == morsel_sources_.end() ? nullptr : iter->second;
+  }
+
+  /** Splits the scan of plan across the workers of an exchange by source, or stops splitting it if source = nullptr. */
+  void SetMorselSource(const AbstractPlanNode *plan, MorselSource *source) {
+    std::scoped_lock lock(morsel_latch_);
+    if (source == nullptr) {
+      morsel_sources_.erase(plan);
+    } else {
+      morsel_sources_[plan] = source;
+    }
+  }
+
  private:
   Transaction *transaction_;
   Catalog *catalog_;
   BufferPoolManager *bpm_;
   TransactionManager *txn_mgr_;
   LockManager *lock_mgr_;
+  size_t memory_budget_{EXECUTOR_MEMORY_BUDGET};
+  MemoryBroker *memory_broker_{nullptr};
+  /** Whether the running query is admitted, the memory it was granted, and the share of each spilling operator. */
+  bool admitted_{false};
+  size_t memory_grant_{0};
+  size_t memory_share_{0};
+  /** The temporary space of the context, whose file is only created once an operator spills. */
+  TempSpace own_temp_space_;
+  TempSpace *temp_space_{&own_temp_space_};
+  ThreadPool *thread_pool_{nullptr};
+  QueryProfile *profile_{nullptr};
+  std::mutex morsel_latch_;
+  std::unordered_map<const AbstractPlanNode *, MorselSource *> morsel_sources_;
 };
 
 }  // namespace bustub
@@ -24,11 +24,19 @@ namespace bustub {
 class ExecutorFactory {
  public:
   /**
-   * Creates a new executor given the executor context and plan node.
+   * Creates a new executor given the executor context and plan node, metered, and profiled under EXPLAIN ANALYZE.
    * @param exec_ctx the executor context for the created executor
    * @param plan the plan node that needs to be executed
    * @return an executor for the given plan and context
    */
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan);
+
+ private:
+  /** @return the executor of the type of the plan node, unmetered, with metered children */
+  static std::unique_ptr<AbstractExecutor> CreatePlanExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan);
+
+  /** @return the executor of a plan node in a MeteredExecutor, itself in a ProfiledExecutor if the query is profiled */
+  static std::unique_ptr<AbstractExecutor> Instrument(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                                      std::unique_ptr<AbstractExecutor> &&executor);
 };
 }  // namespace bustub
@@ -12,12 +12,21 @@
 
 #pragma once
 
+#include <vector>
+
+#include "common/util/bloom_filter.h"
 #include "execution/executor_context.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 /**
- * AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
+ * AbstractExecutor implements the Volcano tuple-at-a-time iterator model, along with a batch-at-a-time variant of it.
+ *
+ * Executors that do not override NextBatch produce their batches from Next, so tuple-at-a-time and batch-at-a-time
+ * executors can be stacked in any order. A parent pulls its child either with Next or NextBatch, never both, and
+ * closes it when it stops pulling before the child is exhausted, see Close.
  */
 class AbstractExecutor {
  public:
@@ -44,6 +53,43 @@ class AbstractExecutor {
    */
   virtual bool Next(Tuple *tuple, RID *rid) = 0;
 
+  /**
+   * Produces the next batch of tuples from this executor, up to the capacity of the batch.
+   * @param[out] batch the batch is emptied, then filled with the next tuples produced by this executor
+   * @return true if some tuple was produced, false if there are no more tuples
+   */
+  virtual bool NextBatch(TupleBatch *batch) {
+    batch->Clear();
+    Tuple tuple;
+    RID rid;
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->Emplace(rid, tuple);
+    }
+    return !batch->IsEmpty();
+  }
+
+  /**
+   * Tells this executor that its parent needs no more tuples from it, so that it can let go of what it holds, such as
+   * pinned pages, buffered tuples and the children it still pulls from, instead of waiting to be destroyed. Next and
+   * NextBatch must not be called again until the next Init. Executors with children close them too.
+   */
+  virtual void Close() {}
+
+  /**
+   * Offers this executor a filter its parent applies to the tuples it produces, such as the Bloom filter a hash join
+   * builds on the keys of its build side: a tuple whose keys do not hash into the filter would be discarded by the
+   * parent anyway, so the executor may drop it early. The keys are hashed as HashJoinExecutor::HashKeys does at depth
+   * 0, and a tuple with a NULL key may be dropped too. The filter replaces any filter offered before and must outlive
+   * the executor or the next offer.
+   * @param filter the filter, nullptr to drop the one offered before
+   * @param keys the keys the filter is on, evaluated on the output tuples of this executor
+   * @return true if this executor applies the filter, false if the parent has to
+   */
+  virtual bool PushDownFilter(const BloomFilter * /*filter*/,
+                              const std::vector<const AbstractExpression *> & /*keys*/) {
+    return false;
+  }
+
   /** @return the schema of the tuples that this executor produces */
   virtual const Schema *GetOutputSchema() = 0;
 
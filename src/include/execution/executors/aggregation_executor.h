@@ -12,26 +12,43 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "common/memory_tracker.h"
 #include "common/util/hash_util.h"
 #include "container/hash/hash_function.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/executors/exchange_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/flat_aggregation_hash_table.h"
 #include "execution/plans/aggregation_plan.h"
+#include "execution/tmp_tuple_run.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
 namespace bustub {
+
+/** Upper bound on the number of partitions an aggregation spills its input to. */
+static constexpr size_t AGGREGATION_MAX_PARTITIONS = 64;
+
 /**
  * A simplified hash table that has all the necessary functionality for aggregations.
+ *
+ * The groups of a table with distinct aggregates carry a DistinctCounter per aggregate, whose counts are only written
+ * into the values of the aggregates by Begin.
  */
 class SimpleAggregationHashTable {
  public:
+  /** The map from aggregate keys to aggregate values, counted in the memory of the execution. */
+  using HashTable =
+      std::unordered_map<AggregateKey, AggregateValue, std::hash<AggregateKey>, std::equal_to<AggregateKey>,
+                         TrackedAllocator<std::pair<const AggregateKey, AggregateValue>, MemoryTag::EXECUTION>>;
+
   /**
    * Create a new simplified aggregation hash table.
    * @param agg_exprs the aggregation expressions
@@ -39,7 +56,9 @@ class SimpleAggregationHashTable {
    */
   SimpleAggregationHashTable(const std::vector<const AbstractExpression *> &agg_exprs,
                              const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
+      : agg_exprs_{agg_exprs},
+        agg_types_{agg_types},
+        has_distinct_(std::any_of(agg_types.begin(), agg_types.end(), IsDistinctAggregate)) {}
 
   /** @return the initial aggregrate value for this aggregation executor */
   AggregateValue GenerateInitialAggregateValue() {
@@ -62,9 +81,22 @@ class SimpleAggregationHashTable {
           // Max starts at INT_MIN.
           values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
           break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          // Distinct counts start at zero, and are kept by the counters until Begin.
+          values.emplace_back(ValueFactory::GetIntegerValue(0));
+          break;
+      }
+    }
+    std::vector<DistinctCounter> distinct;
+    if (has_distinct_) {
+      for (const auto &agg_type : agg_types_) {
+        const bool approximate = agg_type == AggregationType::ApproxCountDistinctAggregate;
+        distinct.emplace_back(approximate);
+        distinct_bytes_ += approximate ? DistinctCounter::SKETCH_BYTES : 0;
       }
     }
-    return {values};
+    return {values, distinct};
   }
 
   /** Combines the input into the aggregation result. */
@@ -87,6 +119,35 @@ class SimpleAggregationHashTable {
           // Max is just the max.
           result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
           break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          // Distinct counts add the input to the counter.
+          distinct_bytes_ += result->distinct_[i].Add(input.aggregates_[i]) ? DistinctCounter::VALUE_BYTES : 0;
+          break;
+      }
+    }
+  }
+
+  /** Merges a partial aggregation result of another table for the same aggregations into the aggregation result. */
+  void MergeAggregateValues(AggregateValue *result, const AggregateValue &partial) {
+    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
+      switch (agg_types_[i]) {
+        case AggregationType::CountAggregate:
+        case AggregationType::SumAggregate:
+          // Counts and sums add up.
+          result->aggregates_[i] = result->aggregates_[i].Add(partial.aggregates_[i]);
+          break;
+        case AggregationType::MinAggregate:
+          result->aggregates_[i] = result->aggregates_[i].Min(partial.aggregates_[i]);
+          break;
+        case AggregationType::MaxAggregate:
+          result->aggregates_[i] = result->aggregates_[i].Max(partial.aggregates_[i]);
+          break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          // Distinct counts merge their counters, as the same input may have been counted by both.
+          distinct_bytes_ += result->distinct_[i].Merge(partial.distinct_[i]) * DistinctCounter::VALUE_BYTES;
+          break;
       }
     }
   }
@@ -103,13 +164,53 @@ class SimpleAggregationHashTable {
     CombineAggregateValues(&ht[agg_key], agg_val);
   }
 
+  /**
+   * Merges the partial aggregation results of another table for the same aggregations into the hash table, and
+   * empties the other table. The groups the hash table lacks are moved over rather than copied, counters and all.
+   * @param other the other table
+   */
+  void MergeFrom(SimpleAggregationHashTable *other) {
+    ht.merge(other->ht);
+    for (const auto &[agg_key, partial] : other->ht) {
+      MergeAggregateValues(&ht.find(agg_key)->second, partial);
+    }
+    // The counters moved over are at most the bytes of all the counters of the other table.
+    distinct_bytes_ += other->distinct_bytes_;
+    other->Clear();
+  }
+
+  /**
+   * Combines a value with the current aggregation of its key, if the key is in the hash table.
+   * @return false if the key is not in the hash table
+   */
+  bool CombineIfPresent(const AggregateKey &agg_key, const AggregateValue &agg_val) {
+    auto iter = ht.find(agg_key);
+    if (iter == ht.end()) {
+      return false;
+    }
+    CombineAggregateValues(&iter->second, agg_val);
+    return true;
+  }
+
+  /** @return the number of groups in the hash table */
+  size_t Size() const { return ht.size(); }
+
+  /** @return the estimated bytes of memory held by the distinct counters of the groups */
+  size_t DistinctMemoryUsage() const { return distinct_bytes_; }
+
+  /** Empties the hash table. */
+  void Clear() {
+    ht.clear();
+    distinct_bytes_ = 0;
+  }
+
   /**
    * An iterator through the simplified aggregation hash table.
    */
   class Iterator {
    public:
     /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_(iter) {}
+    explicit Iterator(HashTable::const_iterator iter) : iter_(iter) {}
 
     /** @return the key of the iterator */
     const AggregateKey &Key() { return iter_->first; }
@@ -131,26 +232,61 @@ class SimpleAggregationHashTable {
 
    private:
     /** Aggregates map. */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
+    HashTable::const_iterator iter_;
   };
 
-  /** @return iterator to the start of the hash table */
-  Iterator Begin() { return Iterator{ht.cbegin()}; }
+  /** @return iterator to the start of the hash table, once the distinct counts are written into the values */
+  Iterator Begin() {
+    if (has_distinct_) {
+      for (auto &[agg_key, agg_val] : ht) {
+        for (uint32_t i = 0; i < agg_types_.size(); i++) {
+          if (IsDistinctAggregate(agg_types_[i])) {
+            agg_val.aggregates_[i] = ValueFactory::GetIntegerValue(static_cast<int32_t>(agg_val.distinct_[i].Count()));
+          }
+        }
+      }
+    }
+    return Iterator{ht.cbegin()};
+  }
 
   /** @return iterator to the end of the hash table */
   Iterator End() { return Iterator{ht.cend()}; }
 
  private:
   /** The hash table is just a map from aggregate keys to aggregate values. */
-  std::unordered_map<AggregateKey, AggregateValue> ht{};
+  HashTable ht{};
   /** The aggregate expressions that we have. */
   const std::vector<const AbstractExpression *> &agg_exprs_;
   /** The types of aggregations that we have. */
   const std::vector<AggregationType> &agg_types_;
+  /** True if any aggregation counts distinct inputs, so that the groups carry counters. */
+  bool has_distinct_;
+  /** The estimated bytes of memory held by the distinct counters. */
+  size_t distinct_bytes_{0};
 };
 
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX) on the tuples of a child executor.
+ * The child is drained a batch at a time, and NextBatch hands out the groups a batch at a time.
+ *
+ * When the child is an exchange and there is a thread pool, the aggregation runs in two phases. Every worker of the
+ * exchange first aggregates its own batches into tables of its own, one per partition of the group keys by hash. Then
+ * every partition is merged across the workers by a task of its own, so neither phase shares a table between threads.
+ * The groups come out partition by partition.
+ *
+ * Plans that FlatAggregationHashTable supports aggregate into flat tables, and the others into simple ones. Without
+ * group-bys, a flat table takes whole batches at once, see FlatAggregationHashTable::InsertBatch.
+ *
+ * When it does not run in two phases, the aggregation keeps its table within the memory budget of the executor
+ * context. Once the table is over budget, tuples of the groups in the table are still aggregated in memory, but the
+ * tuples of new groups are partitioned on the hash of their keys to TmpTupleRuns. After the groups in memory are
+ * handed out, every partition is aggregated the same way in turn, partitioned again with a different hash if its own
+ * groups do not fit, up to MAX_DEPTH times.
+ *
+ * Distinct counts only aggregate into simple tables. The values held by exact counters count towards the memory of
+ * the table, so that the many groups of a high-cardinality column spill, but the counters of the groups in memory
+ * keep growing once the table is over budget. Approximate counters take a fixed sketch per group, and merge across
+ * the workers of the two phases.
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -170,8 +306,13 @@ class AggregationExecutor : public AbstractExecutor {
 
   void Init() override;
 
+  /** Drops the groups and the spilled partitions, and closes the child. */
+  void Close() override;
+
   bool Next(Tuple *tuple, RID *rid) override;
 
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return the tuple as an AggregateKey */
   AggregateKey MakeKey(const Tuple *tuple) {
     std::vector<Value> keys;
@@ -195,9 +336,80 @@ class AggregationExecutor : public AbstractExecutor {
   const AggregationPlanNode *plan_;
   /** The child executor whose tuples we are aggregating. */
   std::unique_ptr<AbstractExecutor> child_;
-  /** Simple aggregation hash table. */
-  // Uncomment me! SimpleAggregationHashTable aht_;
+  /** Number of times a partition is partitioned again before it is aggregated in memory regardless. */
+  static constexpr uint32_t MAX_DEPTH = 3;
+
+  /** The input tuples of groups that did not fit in memory, aggregated once the groups in memory are handed out. */
+  struct SpilledPartition {
+    TmpTupleRun run_;
+    /** The number of times the tuples of the partition have been partitioned. */
+    uint32_t depth_;
+  };
+
+  /** True if the plan aggregates into flat_tables_ rather than tables_. */
+  bool flat_;
+  /** The aggregation hash tables, one per partition of the groups; a single one unless aggregating in parallel. */
+  std::vector<SimpleAggregationHashTable> tables_;
+  /** The flat aggregation hash tables, as tables_. */
+  std::vector<FlatAggregationHashTable> flat_tables_;
+  /** The table the iterator iterates through. */
+  size_t table_idx_{0};
   /** Simple aggregation hash table iterator. */
-  // Uncomment me! SimpleAggregationHashTable::Iterator aht_iterator_;
+  SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** Flat aggregation hash table iterator. */
+  FlatAggregationHashTable::Iterator flat_iterator_;
+  /** The number of partitions the input is spilled to. */
+  size_t num_partitions_;
+  /** The estimated bytes of memory of a group of a simple aggregation hash table. */
+  size_t simple_group_bytes_;
+  /** The spilled partitions left to be aggregated. */
+  std::vector<SpilledPartition> pending_;
+
+  /** Replaces the tables with a single empty one. */
+  void ResetTable();
+
+  /** Points the iterator at the first group of the first table. */
+  void ResetIterator();
+
+  /** @return the estimated bytes of memory of the single table being aggregated into */
+  size_t MemoryUsage() const;
+
+  /**
+   * Aggregates a tuple into the single table, or appends it to its partition once spill is not empty.
+   * @param depth the number of times the tuple has been partitioned
+   * @param spill the partitions of the tuples of new groups, created once the table goes over budget
+   */
+  void Absorb(const Tuple &tuple, uint32_t depth, std::vector<TmpTupleRun> *spill);
+
+  /** @return the partition of the spilled tuple, hashed differently at each depth */
+  size_t PartitionOf(const Tuple &tuple, uint32_t depth) const;
+
+  /** Seals the partitions spilled at a depth and queues up the ones that have tuples. */
+  void QueueSpilled(std::vector<TmpTupleRun> *spill, uint32_t depth);
+
+  /** Aggregates the next spilled partition into the single table. @return false if none is left */
+  bool AggregateNextPartition();
+
+  /** Aggregates the output of the workers of the exchange child in two phases, into one table per partition. */
+  void AggregateInParallel(ExchangeExecutor *exchange, ThreadPool *thread_pool);
+
+  /** Aggregates as AggregateInParallel, into flat tables. */
+  void AggregateFlatInParallel(ExchangeExecutor *exchange, ThreadPool *thread_pool);
+
+  /** @return the values of the output columns for a group */
+  std::vector<Value> MakeOutput(const AggregateKey &key, const AggregateValue &val);
+
+  /**
+   * Advances the iterator to the next group that satisfies the having clause, then hands it to emit.
+   * @return false if no group is left
+   */
+  template <typename Table, typename Emit>
+  bool EmitGroup(std::vector<Table> *tables, typename Table::Iterator *iter, const Emit &emit);
+
+  /** Hands the next group that satisfies the having clause to emit. @return false if no group is left */
+  template <typename Emit>
+  bool EmitGroup(const Emit &emit) {
+    return flat_ ? EmitGroup(&flat_tables_, &flat_iterator_, emit) : EmitGroup(&tables_, &aht_iterator_, emit);
+  }
 };
 }  // namespace bustub
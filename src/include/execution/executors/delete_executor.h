@@ -25,6 +25,9 @@ namespace bustub {
 /**
  * Delete executes a delete from a table.
  * Deleted tuple info come from a child executor.
+ *
+ * The tuples are marked deleted a batch of the child at a time, and their entries are then removed from each index of
+ * the table as a batch, see IndexBatch.
  */
 class DeleteExecutor : public AbstractExecutor {
  public:
@@ -46,10 +49,16 @@ class DeleteExecutor : public AbstractExecutor {
   // Delete from indexes if necessary.
   bool Next([[maybe_unused]] Tuple *tuple, RID *rid) override;
 
+  void Close() override;
+
  private:
   /** The delete plan node to be executed. */
   const DeletePlanNode *plan_;
   /** The child executor to obtain rid from. */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The table deleted from. */
+  TableMetadata *table_info_;
+  /** True once the deletes are done. */
+  bool done_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// exchange_executor.h
+//
+// Identification: src/include/execution/executors/exchange_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "container/bounded_queue.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/exchange_plan.h"
+#include "storage/table/morsel_source.h"
+
+namespace bustub {
+
+/**
+ * ExchangeExecutor gathers the output of one instance of its child plan per worker.
+ *
+ * Init splits the driving scan of the child plan (see ExchangePlanNode) into a MorselSource shared by the instances
+ * through the executor context, and submits one task per instance to the thread pool of the context, in the workload
+ * class of the transaction, see ThreadPool. Each task initializes its instance and drains it a batch at a time into
+ * a lock-free BoundedQueue, which Next and NextBatch drain in turn; the order of the tuples is unspecified. If the
+ * context has no thread pool, the instances are run one after the other on the calling thread instead.
+ *
+ * Drain is the alternative to Init for a parent that can consume the batches of every worker on that worker, such as
+ * the first phase of a parallel aggregation.
+ *
+ * The instances run under the transaction of the context and share its catalog and buffer pool. Exchanges must not
+ * be nested, since a worker waiting on an inner exchange could hold up the pool threads its tasks need.
+ */
+class ExchangeExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new exchange executor.
+   * @param exec_ctx the executor context
+   * @param plan the exchange plan to be executed
+   */
+  ExchangeExecutor(ExecutorContext *exec_ctx, const ExchangePlanNode *plan);
+
+  /** Stops the workers. */
+  ~ExchangeExecutor() override;
+
+  /** Handles a batch of a worker; called on the thread of that worker. */
+  using BatchConsumer = std::function<void(size_t worker, const TupleBatch &batch)>;
+
+  void Init() override;
+
+  /** Stops the workers, then closes the instances of the child plan. */
+  void Close() override;
+
+  /**
+   * Runs every instance to completion, handing its batches to consume instead of gathering them, and waits for them.
+   * Next and NextBatch produce no tuple afterwards, until the next Init.
+   * @param consume the consumer of the batches, called concurrently for different workers
+   * @throw the first exception thrown by an instance or by consume
+   */
+  void Drain(const BatchConsumer &consume);
+
+  /** @return the number of instances of the child plan */
+  size_t GetNumWorkers() const { return children_.size(); }
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+ private:
+  /** Number of batches per worker the queue holds. */
+  static constexpr size_t QUEUE_BATCHES_PER_WORKER = 2;
+
+  /** Splits the driving scan and starts the workers, which hand their batches to consume or to the queue if null. */
+  void Start(const BatchConsumer *consume);
+
+  /** Initializes and drains the instance of a worker into consume, or into the queue if null. */
+  void Work(size_t worker, const BatchConsumer *consume);
+
+  /** Stops the workers, waits for them to exit and unregisters the morsel sources. */
+  void Stop();
+
+  /** Waits for a while before polling the queue again. */
+  static void Backoff(size_t *attempt);
+
+  /** The exchange plan node to be executed. */
+  const ExchangePlanNode *plan_;
+  /** The morsel sources of the split scans, registered with the executor context; outlive children_. */
+  std::vector<std::unique_ptr<MorselSource>> morsel_sources_;
+  /** The plan nodes the morsel sources are registered for. */
+  std::vector<const AbstractPlanNode *> split_plans_;
+  /** One instance of the child plan per worker. */
+  std::vector<std::unique_ptr<AbstractExecutor>> children_;
+  /** The batches handed over by the workers. */
+  BoundedQueue<TupleBatch> queue_;
+  /** The number of workers still running. */
+  std::atomic<size_t> running_{0};
+  /** True once the workers should stop early. */
+  std::atomic<bool> stopped_{false};
+  /** The first exception thrown by a worker, rethrown on the calling thread. */
+  std::exception_ptr error_;
+  std::mutex error_latch_;
+  /** True if the context had no thread pool at Init, and the instances run on the calling thread. */
+  bool serial_{false};
+  /** The next instance to drain on the calling thread, when serial_. */
+  size_t serial_child_{0};
+  /** The batch Next hands out tuples from. */
+  TupleBatch current_;
+  /** The next tuple of current_. */
+  size_t current_idx_{0};
+};
+}  // namespace bustub
@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_join_executor.h
+//
+// Identification: src/include/execution/executors/hash_join_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/util/bloom_filter.h"
+#include "common/util/hash_util.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/join_hash_table.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/tmp_tuple_run.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** Upper bound on the number of partitions a hash join spills each side to. */
+static constexpr size_t HASH_JOIN_MAX_PARTITIONS = 64;
+
+/**
+ * HashJoinExecutor equi-joins two children executors. It builds a hash table on the left (build) side and probes it
+ * with every tuple of the right (probe) side.
+ *
+ * While the left side fits in the memory budget of the plan, or in the share of the join of the memory granted to
+ * the query if that is less, see ExecutorContext::AdmitQuery, the join runs in memory. As soon as it does not, the
+ * join turns into a grace hash join: both sides are partitioned on the hash of their keys to runs in the temporary
+ * space, see TmpTupleRun, and the partitions are then joined pairwise. A left partition that still does not fit is
+ * partitioned again with a different hash, up to MAX_DEPTH times, so that one skewed key cannot recurse forever.
+ * Tuples with a NULL key never join and are dropped up front.
+ *
+ * Alongside the hash table, the join builds a Bloom filter on the keys of the whole build side, and offers it to the
+ * probe side, see AbstractExecutor::PushDownFilter, so that a sequential scan drops the probe tuples without a match
+ * before they are ever copied out of their page. If the probe side does not take the filter, the join applies it
+ * itself, ahead of probing the hash table or spilling the probe tuples to disk.
+ *
+ * The probe side is read a batch at a time, and the hashes of the keys of a batch are all computed before it probes
+ * the hash table, PROBE_GROUP_SIZE tuples at a time with their buckets prefetched, see JoinHashTable.
+ *
+ * A semi or anti join produces each probe tuple once, as soon as its first match is found or once it is known to have
+ * none, see JoinType. Without a residual predicate, the build side then only holds the keys of the left tuples. An anti
+ * join produces the probe tuples the Bloom filter rules out, and those with a NULL key, rather than dropping them, so
+ * its filter is never pushed down.
+ */
+class HashJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new hash join executor.
+   * @param exec_ctx the executor context
+   * @param plan the hash join plan to be executed
+   * @param left_executor the child executor that produces the tuples the hash table is built on
+   * @param right_executor the child executor that produces the tuples that probe the hash table
+   */
+  HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
+                   std::unique_ptr<AbstractExecutor> &&left_executor,
+                   std::unique_ptr<AbstractExecutor> &&right_executor);
+
+  /** Frees the temporary blocks that are left if the join was not run to the end. */
+  ~HashJoinExecutor() override;
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
+
+  void Init() override;
+
+  /** Frees the temporary blocks of the join and closes both children. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  /**
+   * Hashes the join keys of a tuple; each depth seeds the hash differently. The Bloom filter of the join is on the
+   * hashes at depth 0.
+   * @return false if a key is NULL, in which case the tuple joins with nothing
+   */
+  static bool HashKeys(const Tuple &tuple, const Schema *schema, const std::vector<const AbstractExpression *> &keys,
+                       uint32_t depth, hash_t *hash);
+
+ private:
+  /** Number of times a partition is partitioned again before it is built in memory regardless. */
+  static constexpr uint32_t MAX_DEPTH = 3;
+
+  /** Number of probe tuples whose buckets are prefetched together, see JoinHashTable::Prefetch. */
+  static constexpr size_t PROBE_GROUP_SIZE = 16;
+
+  /** A left partition and the right partition it joins with. */
+  struct PartitionPair {
+    TmpTupleRun left_;
+    TmpTupleRun right_;
+    /** The number of times the tuples of the pair have been partitioned. */
+    uint32_t depth_;
+  };
+
+  /** @return the bytes of the left side the join holds in memory */
+  size_t MemoryBudget() const;
+
+  /** @return true if the keys of a build tuple and a right tuple are all equal */
+  bool KeysEqual(const Tuple &left, const Tuple &right);
+
+  /** @return true if a build tuple and a right tuple join: their keys are equal and they satisfy the predicate */
+  bool Matches(const Tuple &left, const Tuple &right);
+
+  /** @return the tuple the join holds for a left tuple: the tuple itself, or its keys for a key-only build side */
+  Tuple BuildTuple(Tuple &&tuple);
+
+  /** @return the output tuple of a semi or anti join for a probe tuple */
+  Tuple ProbeOutput(const Tuple &probe);
+
+  /** @return num_partitions empty partitions */
+  std::vector<TmpTupleRun> NewPartitions(size_t num_partitions);
+
+  /** Frees every temporary block the join still holds. */
+  void Reset();
+
+  /** Partitions the right child to match the left partitions and queues up the pairs. */
+  void SpillRight(std::vector<TmpTupleRun> *left_partitions);
+
+  /** Partitions both sides of a pair one level deeper and queues up the sub pairs. */
+  void Repartition(PartitionPair *pair);
+
+  /** Builds the hash table on the next queued pair whose both sides have tuples. @return false if none is left */
+  bool BuildNextPartition();
+
+  /**
+   * Reads the next batch of probe tuples and hashes their keys, keeping those that may have a match.
+   * @return false if the probe side is exhausted
+   */
+  bool NextProbeBatch();
+
+  /** The hash join plan node to be executed. */
+  const HashJoinPlanNode *plan_;
+  /** The build side. */
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  /** The probe side. */
+  std::unique_ptr<AbstractExecutor> right_executor_;
+  /** The number of partitions each side is spilled to. */
+  size_t num_partitions_;
+
+  /** True if the build side holds only the keys of the left tuples, as tuples of key_schema_. */
+  bool key_only_{false};
+  std::unique_ptr<Schema> key_schema_;
+  std::vector<std::unique_ptr<ColumnValueExpression>> key_columns_;
+  /** The schema of the tuples the build side holds, and the join keys evaluated on them. */
+  const Schema *build_schema_;
+  std::vector<const AbstractExpression *> build_keys_;
+
+  /** The left tuples of the current partition (or of the whole left side), by the hash of their keys. */
+  JoinHashTable hash_table_;
+  /** The depth the keys of hash_table_ are hashed at. */
+  uint32_t depth_{0};
+  /** The hashes at depth 0 of the keys of the whole build side. */
+  BloomFilter bloom_filter_;
+  /** True if the probe side applies bloom_filter_ itself. */
+  bool filter_pushed_down_{false};
+  /** True once the join has spilled to the temporary space. */
+  bool spilled_{false};
+  /** The partition pairs left to be joined. */
+  std::vector<PartitionPair> pending_;
+
+  /** The right partition being probed, when spilled. */
+  TmpTupleRun probe_partition_;
+  /** The tuples of the last block read from probe_partition_. */
+  std::vector<Tuple> probe_buffer_;
+  /** The last batch read from the probe side, when not spilled. */
+  TupleBatch probe_batch_;
+  /** The tuples of the current probe batch, those of probe_batch_ or probe_buffer_. */
+  const std::vector<Tuple> *probe_tuples_{nullptr};
+  /** The probe tuples of the batch that may have a match, by their index in probe_tuples_, and their hashes. */
+  std::vector<uint32_t> probe_indices_;
+  std::vector<hash_t> probe_hashes_;
+  /** The next tuple of probe_indices_. */
+  size_t probe_next_{0};
+  /** The probe tuples of the batch known to have no match, by their index in probe_tuples_, for an anti join. */
+  std::vector<uint32_t> probe_unmatched_;
+  /** The next tuple of probe_unmatched_. */
+  size_t unmatched_next_{0};
+
+  /** The current probe tuple. */
+  const Tuple *probe_tuple_{nullptr};
+  /** The next entry of hash_table_ to be checked against probe_tuple_. */
+  uint32_t match_{JoinHashTable::END};
+};
+}  // namespace bustub
@@ -6,14 +6,16 @@
 //
 // Identification: src/include/execution/executors/index_scan_executor.h
 //
-// Copyright (c) 2015-20, Carnegie Mellon University Database Group
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "catalog/catalog.h"
 #include "common/rid.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -23,11 +25,26 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table: it walks a B+ tree index in key order and fetches the tuple
+ * of every record id from the table, keeping the ones that satisfy the predicate of the plan.
+ *
+ * When the index covers the scan, that is every column read by the predicate or the output is a key or INCLUDE
+ * column of the index, the scan is index only: the rows are made from the keys, and no tuple is fetched. Otherwise, a
+ * plan that fetches in page order has the record ids of FETCH_BATCH_SIZE keys at a time sorted by page, and their
+ * tuples read a page at a time, see TableHeap::GetTuples.
+ *
+ * Under READ_COMMITTED, the scan locks the table INTENTION_SHARED and each row it fetches SHARED, only until it is done
+ * with the tuple. Under REPEATABLE_READ, it locks the key range it scans as well, see LockKeyRanges, so that reading it
+ * again finds no phantoms, without a SHARED lock on the whole table.
+ *
+ * The index iterator keeps the leaf page it is on pinned and read latched for as long as the scan is open, so a
+ * parent that stops early should close the scan, see Close.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
+  /** The number of record ids sorted and fetched at a time when fetching in page order. */
+  static constexpr size_t FETCH_BATCH_SIZE = 1024;
+
   /**
    * Creates a new index scan executor.
    * @param exec_ctx the executor context
@@ -35,14 +52,68 @@ class IndexScanExecutor : public AbstractExecutor {
    */
   IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan);
 
+  ~IndexScanExecutor() override;
+
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
   void Init() override;
 
+  /** Drops the index iterator, which unpins and unlatches its leaf page. */
+  void Close() override;
+
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /** @return true if the scan reads its rows from the keys of the index, without fetching the tuples */
+  bool IsIndexOnly() const { return index_only_; }
+
+  /** @return true if the index covers the scan of a plan over a table, so that the scan is index only */
+  static bool IsCovered(const IndexScanPlanNode *plan, const Index &index, const Schema &table_schema);
+
  private:
+  /** The position of the scan in the index, whatever the key size of the index. */
+  class Cursor;
+  /** The position of the scan in a B+ tree index of generic keys of a size. */
+  template <size_t KeySize>
+  class BPlusTreeCursor;
+
+  /**
+   * Locks SHARED the key ranges of the entries the scan reads and the one past them, see LockManager::LockKeyRange,
+   * before it reads any, so that it never waits for a lock with a leaf page latched: a pass over the entries finds the
+   * ranges not locked yet, locked once the pass is done; and passes are made until one finds none. The entries may
+   * have changed before the locks were granted, not after.
+   */
+  void LockKeyRanges();
+
+  /** Next of an index only scan. */
+  bool NextFromIndex(Tuple *tuple, RID *rid);
+
+  /** Next of a scan fetching in page order. */
+  bool NextInPageOrder(Tuple *tuple, RID *rid);
+
+  /** @return true if the tuple satisfies the predicate, and makes the output row of it if so */
+  bool Emit(const Tuple &candidate, Tuple *tuple);
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The index being scanned. */
+  IndexInfo *index_info_;
+  /** The table of the index. */
+  TableMetadata *table_info_;
+  /** The varlen columns of the table read by the predicate or the output columns, fetched when stored out of line. */
+  std::vector<uint32_t> toast_columns_;
+  /** The keys the scan starts at and stops past, when the plan bounds it. */
+  Tuple lower_key_;
+  Tuple upper_key_;
+  /** The current position of the scan, nullptr once it is closed. */
+  std::unique_ptr<Cursor> cursor_;
+  /** True if the index covers the scan. */
+  bool index_only_;
+  /** True if the row locks are only held while each tuple is read, see ExecutorContext::ReleasesReadLocks. */
+  bool releases_read_locks_{false};
+  /** The values of the columns of the table in an index only scan, NULL but for the ones of the index. */
+  std::vector<Value> row_;
+  /** The tuples of the current batch when fetching in page order, and the next one of them. */
+  std::vector<Tuple> fetched_;
+  size_t fetched_idx_{0};
 };
 }  // namespace bustub
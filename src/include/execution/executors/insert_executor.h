@@ -14,7 +14,9 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "catalog/catalog.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/insert_plan.h"
@@ -24,6 +26,15 @@ namespace bustub {
 /**
  * InsertExecutor executes an insert into a table.
  * Inserted values can either be embedded in the plan itself ("raw insert") or come from a child executor.
+ *
+ * A raw insert has all its tuples at hand, so it bulk inserts them into fresh pages of the table, see
+ * TableHeap::BulkInsert, and then inserts their keys into each index of the table as a batch. Tuples from a child are
+ * inserted into the table one by one as they come, a batch of the child at a time, and their keys into each index
+ * once the batch is in the table, see IndexBatch.
+ *
+ * Into a partitioned table, every tuple is inserted into its partition, and its keys into the local indexes of the
+ * partition; under a HASH scheme the partitions spread the inserts over as many heaps, rather than all of them
+ * contending for the last page of one.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -41,11 +52,31 @@ class InsertExecutor : public AbstractExecutor {
   void Init() override;
 
   // Note that Insert does not make use of the tuple pointer being passed in.
-  // We return false if the insert failed for any reason, and return true if all inserts succeeded.
+  // We throw exception if the insert failed for any reason, and return false if all inserts succeeded.
+  // Insert into indexes if necessary.
   bool Next([[maybe_unused]] Tuple *tuple, RID *rid) override;
 
+  void Close() override;
+
  private:
+  /** Inserts the raw values of the plan. */
+  void InsertRawValues();
+
+  /** Inserts the tuples of the child executor. */
+  void InsertFromChild();
+
+  /** @return the index in tables_ of the table a tuple is inserted into */
+  size_t TableOf(const Tuple &tuple) const;
+
   /** The insert plan node to be executed. */
   const InsertPlanNode *plan_;
+  /** The child executor to obtain values from, nullptr for a raw insert. */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The table inserted into. */
+  TableMetadata *table_info_;
+  /** The tables the tuples are stored in: table_info_, or its partitions if it is partitioned. */
+  std::vector<TableMetadata *> tables_;
+  /** True once the inserts are done. */
+  bool done_{false};
 };
 }  // namespace bustub
@@ -21,6 +21,8 @@
 namespace bustub {
 /**
  * LimitExecutor limits the number of output tuples with an optional offset.
+ * NextBatch slices the batches of the child rather than copying their tuples one at a time, and asks for batches no
+ * larger than the tuples the offset and the limit have left. The child is closed as soon as the limit is reached.
  */
 class LimitExecutor : public AbstractExecutor {
  public:
@@ -37,12 +39,21 @@ class LimitExecutor : public AbstractExecutor {
 
   void Init() override;
 
+  /** Closes the child executor. */
+  void Close() override;
+
   bool Next(Tuple *tuple, RID *rid) override;
 
+  bool NextBatch(TupleBatch *batch) override;
+
  private:
   /** The limit plan node to be executed. */
   const LimitPlanNode *plan_;
   /** The child executor to obtain value from. */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The number of child tuples skipped so far, up to the offset. */
+  size_t skipped_{0};
+  /** The number of tuples produced so far, up to the limit. */
+  size_t produced_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialize_executor.h
+//
+// Identification: src/include/execution/executors/materialize_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/materialize_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * MaterializeExecutor completes the tuples of its child with the columns of the rows of a table they carry the record
+ * ids of, see MaterializePlanNode. The scans below it then read and copy only the columns their predicates and their
+ * parents read, and the other columns are fetched at the end, for the rows that are left once the filters and joins
+ * in between have dropped the others (late materialization).
+ *
+ * A row is read in place on its page, locked as an index scan locks it, and of the values stored out of line, see
+ * Toast, only those of the columns the output reads are fetched. A row that is gone by the time it is fetched is
+ * skipped.
+ */
+class MaterializeExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new materialize executor.
+   * @param exec_ctx the executor context
+   * @param plan the materialize plan to be executed
+   * @param child the child executor that produces the tuples carrying the record ids
+   */
+  MaterializeExecutor(ExecutorContext *exec_ctx, const MaterializePlanNode *plan,
+                      std::unique_ptr<AbstractExecutor> &&child);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  /** Closes the child. */
+  void Close() override { child_->Close(); }
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+ private:
+  /** The materialize plan node to be executed. */
+  const MaterializePlanNode *plan_;
+  /** The child executor from which tuples are obtained. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The table the rows are fetched from. */
+  TableMetadata *table_info_;
+  /** The varlen columns of the table the output reads. */
+  std::vector<uint32_t> toast_columns_;
+  /** True if the row locks are only held while each row is read, see ExecutorContext::ReleasesReadLocks. */
+  bool releases_read_locks_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.h
+//
+// Identification: src/include/execution/executors/merge_join_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/tmp_tuple_run.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * MergeJoinExecutor equi-joins two children executors whose tuples both come ordered on their join keys, ascending,
+ * by advancing whichever side has the smaller key, so that each child is read once and nothing is built up front.
+ * Tuples with a NULL key never join and are skipped.
+ *
+ * When the keys meet, the whole run of right tuples with that key is buffered, and every left tuple of the key is
+ * joined with the run; the left side is never buffered. Memory is thus bounded by the longest right run, not by the
+ * inputs. A run that outgrows the memory budget of the executor context spills the rest of its tuples to the temporary
+ * space, see TmpTupleRun, from which they are read back, and written again for the next left tuple, once per left
+ * tuple of the key.
+ */
+class MergeJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new merge join executor.
+   * @param exec_ctx the executor context
+   * @param plan the merge join plan to be executed
+   * @param left_executor the child executor that produces the left tuples, ordered on the left keys
+   * @param right_executor the child executor that produces the right tuples, ordered on the right keys
+   */
+  MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                    std::unique_ptr<AbstractExecutor> &&left_executor,
+                    std::unique_ptr<AbstractExecutor> &&right_executor);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
+
+  void Init() override;
+
+  /** Drops the buffered run and closes both children. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  /** @return a negative number, zero or a positive number as the keys left sort before, with or after right */
+  static int CompareKeys(const std::vector<Value> &left, const std::vector<Value> &right);
+
+ private:
+  /**
+   * Pulls the next tuple of a side whose keys are not NULL, and evaluates its keys.
+   * @return false if the side is exhausted
+   */
+  bool Pull(AbstractExecutor *executor, const std::vector<const AbstractExpression *> &key_exprs, Tuple *tuple,
+            std::vector<Value> *keys);
+
+  /** Moves the current left tuple to the next one. @return false if the left side is exhausted */
+  bool AdvanceLeft() { return left_valid_ = Pull(left_executor_.get(), plan_->GetLeftKeys(), &left_, &left_keys_); }
+
+  /** Moves the current right tuple to the next one. @return false if the right side is exhausted */
+  bool AdvanceRight() {
+    return right_valid_ = Pull(right_executor_.get(), plan_->GetRightKeys(), &right_, &right_keys_);
+  }
+
+  /** Buffers the run of right tuples with the key of the current right tuple, which then is the one after the run. */
+  void LoadRun();
+
+  /** Starts joining the run again, with the next left tuple of its key. */
+  void RewindRun();
+
+  /** @return the next tuple of the run for the current left tuple, nullptr once the run is exhausted */
+  const Tuple *NextInRun();
+
+  /** Drops the tuples of the run. */
+  void DropRun();
+
+  /** The merge join plan node to be executed. */
+  const MergeJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+
+  /** The current left tuple and its keys, if left_valid_. */
+  Tuple left_;
+  std::vector<Value> left_keys_;
+  bool left_valid_{false};
+  /** The right tuple after the run, and its keys, if right_valid_. */
+  Tuple right_;
+  std::vector<Value> right_keys_;
+  bool right_valid_{false};
+
+  /** True while the current left tuple is joined with the run. */
+  bool in_run_{false};
+  /** The keys of the run. */
+  std::vector<Value> run_keys_;
+  /** The tuples of the run held in memory, the first ones, and the next of them to join. */
+  std::vector<Tuple> run_;
+  size_t run_pos_{0};
+  /** The tuples of the run past the memory budget, being read, and being written again for the next left tuple. */
+  TmpTupleRun spill_;
+  TmpTupleRun respill_;
+  bool spilled_{false};
+  /** The tuples of the last block read from spill_, and the next of them to join. */
+  std::vector<Tuple> spill_block_;
+  size_t spill_pos_{0};
+};
+
+}  // namespace bustub
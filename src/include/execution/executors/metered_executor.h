@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metered_executor.h
+//
+// Identification: src/include/execution/executors/metered_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/metrics.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+/**
+ * MeteredExecutor wraps the executor of a plan, passing every call through, and counts the tuples it produces and
+ * the time spent in it, its children included. The counts are kept per type of plan and exported as
+ * "executor.<type>.tuples", "executor.<type>.busy_ns" and "executor.<type>.tuples_per_sec", e.g.
+ * "executor.seq_scan.tuples".
+ */
+class MeteredExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new metered executor.
+   * @param exec_ctx the executor context
+   * @param plan_type the type of the plan the wrapped executor executes, which its counts are kept under
+   * @param executor the wrapped executor
+   */
+  MeteredExecutor(ExecutorContext *exec_ctx, PlanType plan_type, std::unique_ptr<AbstractExecutor> &&executor);
+
+  const Schema *GetOutputSchema() override { return executor_->GetOutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Close() override { executor_->Close(); }
+
+  bool PushDownFilter(const BloomFilter *filter, const std::vector<const AbstractExpression *> &keys) override {
+    return executor_->PushDownFilter(filter, keys);
+  }
+
+ private:
+  /** The counts of the executors of one type of plan. */
+  struct OperatorMetrics {
+    Counter num_tuples_;
+    Counter busy_ns_;
+  };
+
+  /** @return the counts kept for a type of plan, exported on the first call */
+  static OperatorMetrics *GetOperatorMetrics(PlanType plan_type);
+
+  /** The wrapped executor. */
+  std::unique_ptr<AbstractExecutor> executor_;
+  /** The counts of the type of plan of the wrapped executor. */
+  OperatorMetrics *metrics_;
+};
+}  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -24,6 +25,9 @@ namespace bustub {
 /**
  * NestedLoopJoinExecutor joins two tables using nested loop.
  * The child executor can either be a sequential scan
+ *
+ * The join buffers a block of left tuples at a time and scans the right child once per block rather than once per
+ * left tuple, so the right child is re-scanned |left| / block size times.
  */
 class NestedLoopJoinExecutor : public AbstractExecutor {
  public:
@@ -43,10 +47,29 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
 
   void Init() override;
 
+  /** Closes both children. */
+  void Close() override;
+
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
   /** The NestedLoop plan node to be executed. */
   const NestedLoopJoinPlanNode *plan_;
+  /** The outer side. */
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  /** The inner side, re-scanned once per block. */
+  std::unique_ptr<AbstractExecutor> right_executor_;
+
+  /** Refills block_ from the left child and rewinds the right child. @return false if the left child is exhausted */
+  bool NextBlock();
+
+  /** The current block of left tuples. */
+  std::vector<Tuple> block_;
+  /** The next tuple of block_ to join with right_tuple_. */
+  size_t block_idx_{0};
+  /** The current right tuple. */
+  Tuple right_tuple_;
+  /** True while right_tuple_ holds a right tuple. */
+  bool has_right_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// profiled_executor.h
+//
+// Identification: src/include/execution/executors/profiled_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/query_profile.h"
+
+namespace bustub {
+/**
+ * ProfiledExecutor wraps the executor of a plan node under EXPLAIN ANALYZE, passing every call through, and adds to
+ * the profile of the plan node the tuples it produces, the wall and CPU time spent in Init and Next, and the pages
+ * fetched meanwhile by the calling thread, all with its children's.
+ */
+class ProfiledExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new profiled executor.
+   * @param exec_ctx the executor context
+   * @param profile the profile of the plan node of the wrapped executor
+   * @param executor the wrapped executor
+   */
+  ProfiledExecutor(ExecutorContext *exec_ctx, OperatorProfile *profile, std::unique_ptr<AbstractExecutor> &&executor);
+
+  const Schema *GetOutputSchema() override { return executor_->GetOutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Close() override { executor_->Close(); }
+
+  bool PushDownFilter(const BloomFilter *filter, const std::vector<const AbstractExpression *> &keys) override {
+    return executor_->PushDownFilter(filter, keys);
+  }
+
+ private:
+  /** What the calling thread had spent when a call began. */
+  struct Start {
+    std::chrono::steady_clock::time_point wall_;
+    uint64_t cpu_ns_;
+    BufferPoolManager::FetchStats fetches_;
+  };
+
+  /** @return what the calling thread has spent so far */
+  static Start Now();
+
+  /** Adds what the calling thread spent since start to the wall and CPU time, and the pages, of the profile. */
+  void AddSince(const Start &start, std::atomic<uint64_t> *wall_ns, std::atomic<uint64_t> *cpu_ns);
+
+  /** The wrapped executor. */
+  std::unique_ptr<AbstractExecutor> executor_;
+  /** The profile of the plan node of the wrapped executor. */
+  OperatorProfile *profile_;
+};
+}  // namespace bustub
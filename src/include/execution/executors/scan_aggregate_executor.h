@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// scan_aggregate_executor.h
+//
+// Identification: src/include/execution/executors/scan_aggregate_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/executors/seq_scan_executor.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ScanAggregateExecutor fuses an aggregation with the sequential scan under it, for plans of the shape of the most
+ * common dashboard queries: a scan with any predicate, under an aggregation with at most one group-by, a column of the
+ * table of a fixed-width type, and aggregates of INTEGER columns of the table other than distinct counts.
+ *
+ * The scan evaluates its predicate as usual, compiled where it can be, and hands the tuples that satisfy it over a
+ * page at a time without projecting them, see SeqScanExecutor::Drain. The executor is instantiated for the native
+ * type of the group-by column (KeyType), and reads the keys and the aggregate inputs straight from the tuple data:
+ * the groups of the tuples of a page are first looked up in an open-addressing table of native keys, then every
+ * aggregate is folded over the page by a loop instantiated for its aggregation type, see Fold. The loops make no
+ * virtual calls and materialize no Value.
+ *
+ * The results are those of FlatAggregationHashTable: NULL keys make up one group, and an aggregate with a NULL input
+ * is NULL. The groups are all held in memory, so the executor is only used when the statistics of the table estimate
+ * that they fit in the memory budget of the executor context, see CreateScanAggregateExecutor.
+ */
+template <typename KeyType>
+class ScanAggregateExecutor : public AbstractExecutor, public CandidateConsumer {
+ public:
+  /**
+   * Creates a new fused scan and aggregation executor.
+   * @param exec_ctx the executor context
+   * @param plan the aggregation plan node, of the shape the executor supports
+   * @param scan the executor of the sequential scan under the aggregation
+   */
+  ScanAggregateExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                        std::unique_ptr<SeqScanExecutor> &&scan);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  /** Runs the scan to its end, aggregating its tuples. */
+  void Init() override;
+
+  /** Drops the groups and closes the scan. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** Aggregates the tuples of a page of the scan. */
+  void Consume(const std::vector<Tuple> &candidates) override;
+
+ private:
+  /** The index of no group, in an empty slot. */
+  static constexpr uint32_t NO_GROUP = UINT32_MAX;
+  /** The number of slots of an empty table. */
+  static constexpr size_t INITIAL_SLOTS = 64;
+
+  /** @return the group of a key, created with the initial states if new */
+  uint32_t FindGroup(KeyType key);
+
+  /** Doubles the number of slots. */
+  void Grow();
+
+  /** @return the slot a key hashes to, among the slots of a mask */
+  static size_t SlotOf(KeyType key, size_t mask);
+
+  /** Folds the inputs of an aggregate of the tuples of a page into the states of their groups, in groups_. */
+  template <AggregationType Type>
+  void Fold(uint32_t agg_idx, const std::vector<Tuple> &candidates);
+
+  /** Hands the next group that satisfies the having clause to values. @return false if none is left */
+  bool NextGroup(std::vector<Value> *values);
+
+  /** The aggregation plan node to be executed. */
+  const AggregationPlanNode *plan_;
+  /** The scan under the aggregation. */
+  std::unique_ptr<SeqScanExecutor> scan_;
+  /** True if the plan has a group-by, read at key_offset_ of the tuples of the table as a value of key_type_. */
+  bool has_key_;
+  uint32_t key_offset_{0};
+  TypeId key_type_{TypeId::INVALID};
+  /** The offsets of the aggregate inputs in the tuples of the table. */
+  std::vector<uint32_t> input_offsets_;
+  /** The initial aggregation states of a group. */
+  std::vector<int64_t> initial_states_;
+
+  /** The groups of the slots, NO_GROUP if empty. */
+  std::vector<uint32_t> slots_;
+  /** The key of every group. */
+  std::vector<KeyType> keys_;
+  /** The aggregation states of every group, and whether each has had a NULL input, group after group. */
+  std::vector<int64_t> states_;
+  std::vector<char> nulls_;
+  /** The groups of the tuples of the page being aggregated. */
+  std::vector<uint32_t> groups_;
+  /** The next group to produce. */
+  uint32_t next_group_{0};
+};
+
+/**
+ * Creates the fused executor of an aggregation, instantiated for the type of its group-by, see ScanAggregateExecutor.
+ * @return the executor, or nullptr if the plan does not have the shape it supports or its groups may not fit in memory
+ */
+std::unique_ptr<AbstractExecutor> CreateScanAggregateExecutor(ExecutorContext *exec_ctx,
+                                                              const AggregationPlanNode *plan);
+
+}  // namespace bustub
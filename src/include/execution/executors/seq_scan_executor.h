@@ -12,17 +12,72 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_ring.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/compiled_predicate.h"
+#include "execution/expressions/constant_value_expression.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/morsel_source.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+/** Upper bound on the number of frames a sequential scan recycles through its buffer ring. */
+static constexpr size_t SEQ_SCAN_BUFFER_RING_SIZE = 32;
+
+/**
+ * CandidateConsumer takes the tuples of the table that a SeqScanExecutor reads and that satisfy its predicate, in
+ * place of the batches of their projections, see SeqScanExecutor::Drain.
+ */
+class CandidateConsumer {
+ public:
+  virtual ~CandidateConsumer() = default;
+
+  /** Takes the tuples read from one page, of the schema of the table; they are only valid during the call. */
+  virtual void Consume(const std::vector<Tuple> &candidates) = 0;
+};
+
 /**
  * SeqScanExecutor executes a sequential scan over a table.
+ * The scan reads pages through a private buffer ring of at most SEQ_SCAN_BUFFER_RING_SIZE frames (and at most an
+ * eighth of the buffer pool), so scanning a large table does not evict the rest of the working set.
+ * NextBatch filters and projects a whole batch of tuples in a single call, reading the tuples in place on their pinned
+ * page so that only the projections of the matching ones are copied. The predicate is compiled once, when it has a
+ * form CompiledPredicate supports, and interpreted otherwise. A compiled predicate is evaluated on the tuples of a
+ * TablePage a chunk at a time, see CompiledPredicate::Select, comparing whole columns with the selection kernels. Of
+ * the values stored out of line, see Toast, the scan only fetches those of the columns the predicate or the output
+ * columns read, and of a table of PAX pages it only reads the minipages of those columns.
+ *
+ * When the predicate compares a column summarized by the zone map of the table with a constant, the scan skips the
+ * pages whose summary shows that none of their tuples satisfies it, without fetching them. On a CompressedPage, it
+ * decodes only the columns it reads, and an equality on a dictionary encoded column compares the codes of the tuples
+ * with the code of the constant before decoding any of them.
+ *
+ * A filter pushed down by a parent, see PushDownFilter, is checked on the tuples that satisfy the predicate before they
+ * are projected; the keys of the filter are evaluated on the tuples of the table.
+ *
+ * Under an ExchangeExecutor, the executor context hands the scan a MorselSource shared with the scans of the other
+ * workers, and the scan only reads the morsels of pages it claims from it rather than the whole table.
+ *
+ * Of a partitioned table, the scan reads the partitions one after the other, all but those the predicate rules out:
+ * the partitions a comparison of the key column with a constant, or a conjunction or a disjunction of those, shows to
+ * hold no tuple that satisfies it, see ScanTables. Under an exchange, the MorselSource hands out the pages of the same
+ * partitions.
+ *
+ * A scan of a SYSTEM sample of the table (see TableSample) reads only the pages it picks, listed by the page directory
+ * of the table, see TableHeap::GetPageIds, rather than walking the chain of pages; under an exchange, the workers
+ * skip the pages of their morsels it does not pick. A scan of a BERNOULLI sample reads every page, and leaves out the
+ * tuples it does not pick.
+ *
+ * Under REPEATABLE_READ, the scan locks the whole table SHARED instead of locking each row it reads; under
+ * READ_COMMITTED it locks the table INTENTION_SHARED and the rows one at a time, releasing the lock of each row once it
+ * is done with the tuple.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -35,12 +90,162 @@ class SeqScanExecutor : public AbstractExecutor {
 
   void Init() override;
 
+  /** Drops the position of the scan; the scan reads no more pages. */
+  void Close() override;
+
   bool Next(Tuple *tuple, RID *rid) override;
 
+  bool NextBatch(TupleBatch *batch) override;
+
+  /**
+   * Runs the scan to its end, handing the tuples of the table that satisfy the predicate to consumer a page at a
+   * time, read in place where the page allows, instead of projecting them. Follows Init, in place of Next and
+   * NextBatch, for a parent fused with the scan, see ScanAggregateExecutor.
+   */
+  void Drain(CandidateConsumer *consumer);
+
+  /** Takes the filter if every key is an output column of the scan. */
+  bool PushDownFilter(const BloomFilter *filter, const std::vector<const AbstractExpression *> &keys) override;
+
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
+  /** Takes the table lock of a scan of the table for the transaction of exec_ctx, see the class comment. */
+  static void LockTable(ExecutorContext *exec_ctx, table_oid_t table_oid);
+
+  /**
+   * @return the tables a scan reads, with the constants of its predicate as bound now: the table of the plan, or the
+   * partitions of a partitioned table the predicate does not rule out, in order
+   */
+  static std::vector<TableMetadata *> ScanTables(Catalog *catalog, const SeqScanPlanNode *plan);
+
  private:
+  /** Clears the flags of candidates of the partitions of a scheme that hold no tuple that satisfies predicate. */
+  static void PrunePartitions(const AbstractExpression *predicate, const PartitionScheme &scheme,
+                              std::vector<bool> *candidates);
+
+  /** Moves the scan on to the table of tables_ at an index, which takes its own row locks. */
+  void ScanTable(size_t table_idx);
+
+  /** @return true if a tuple of the table satisfies the predicate of the plan */
+  bool Matches(const Tuple &candidate) const;
+
+  /** @return true if there is no pushed down filter, or the keys of a tuple of the table may be in it */
+  bool PassesFilter(const Tuple &candidate) const;
+
+  /** @return the values of the output columns for a tuple of the table */
+  std::vector<Value> Project(const Tuple &candidate);
+
+  /**
+   * Appends the projection of a tuple of the table that satisfies the predicate to batch, or, while draining, the
+   * tuple itself to consumed_, unless the tuple is left out of a BERNOULLI sample.
+   * @param in_page true if the data of the tuple stays in the latched page, rather than in a buffer of the scan
+   */
+  void Emit(const RID &rid, Tuple *candidate, bool in_page, TupleBatch *batch);
+
+  /**
+   * Filters and projects the tuples of a page into batch, from where the previous call left off.
+   * @return true if the page is done, false if the batch filled up first
+   */
+  bool ScanPage(page_id_t page_id, TupleBatch *batch);
+
+  /**
+   * Filters and projects the tuples of a pinned and read latched page into batch, see ScanPage.
+   * @return true if the batch filled up before the end of the page
+   */
+  template <typename PageType>
+  bool ScanTuples(PageType *page, TupleBatch *batch);
+
+  /**
+   * Filters and projects the tuples of a pinned and read latched table page as ScanTuples does, reading chunks of
+   * candidates that the compiled predicate is evaluated on at once.
+   * @return true if the batch filled up before the end of the page
+   */
+  bool SelectTuples(TablePage *page, TupleBatch *batch);
+
+  /**
+   * @param page_id a page yet to be scanned
+   * @param[out] next_page_id the page after it in the chain, if it can be skipped
+   * @return true if the zone map of the table shows that no tuple of the page satisfies the predicate
+   */
+  bool CanSkipPage(page_id_t page_id, page_id_t *next_page_id);
+
+  /** Reads a tuple of a page in place. @return false if the tuple does not exist */
+  bool ReadCandidate(TablePage *page, const RID &rid, Tuple *candidate);
+
+  /** Reads the columns the scan reads of a tuple of a PAX page into candidate_buffer_. */
+  bool ReadCandidate(PaxPage *page, const RID &rid, Tuple *candidate);
+
+  /** Decodes the columns the scan reads of a tuple of a compressed page into candidate_buffer_. */
+  bool ReadCandidate(CompressedPage *page, const RID &rid, Tuple *candidate);
+
+  /**
+   * Reads the version of a tuple of a page that the transaction sees, an older one kept in the version store of the
+   * table for a snapshot or an optimistic transaction, else the one in the page. @return false if it sees none
+   */
+  template <typename PageType>
+  bool ReadVisibleCandidate(PageType *page, const RID &rid, Tuple *candidate);
+
   /** The sequential scan plan node to be executed. */
   const SeqScanPlanNode *plan_;
+  /** The table being scanned: that of the plan, or the partition being scanned of a partitioned table. */
+  TableMetadata *table_info_;
+  /** The tables the scan reads, see ScanTables, and the index of table_info_ among them. */
+  std::vector<TableMetadata *> tables_;
+  size_t table_idx_{0};
+  /** The compiled predicate of the plan, nullptr if it is interpreted. */
+  std::unique_ptr<CompiledPredicate> compiled_predicate_;
+  /** The frames recycled by the scan. */
+  BufferRing ring_;
+  /** The columns of the table read by the predicate or the output columns. */
+  std::vector<uint32_t> scan_columns_;
+  /** The varlen columns of scan_columns_. */
+  std::vector<uint32_t> toast_columns_;
+  /** The memory of the candidates read from PAX pages. */
+  std::vector<char> candidate_buffer_;
+  /** The candidates SelectTuples evaluates the compiled predicate on at once, and their RIDs. */
+  std::vector<Tuple> chunk_;
+  std::vector<RID> chunk_rids_;
+  /** The indices of the candidates of chunk_ that satisfy the compiled predicate. */
+  std::vector<uint32_t> selected_;
+  /** The column and the constant of a predicate of the form (column comparison constant), nullptr for any other. */
+  const ColumnValueExpression *comparison_column_{nullptr};
+  const ConstantValueExpression *comparison_constant_{nullptr};
+  /** The column of such a predicate, as of Init, nullptr if the predicate has no other form or compares with NULL. */
+  const ColumnValueExpression *compared_column_{nullptr};
+  /** The comparison of the predicate, with the column on its left. */
+  ComparisonType comparison_type_{ComparisonType::Equal};
+  /** The value of the constant the predicate compares the column with, as of Init. */
+  Value compared_constant_;
+
+  /** The lock manager the rows read are locked with, nullptr if the table lock covers them or none are needed. */
+  LockManager *row_lock_manager_{nullptr};
+  /** True if the row locks are only held while each tuple is read, see ExecutorContext::ReleasesReadLocks. */
+  bool releases_read_locks_{false};
+
+  /** The filter pushed down by the parent, nullptr if none. */
+  const BloomFilter *filter_{nullptr};
+  /** The keys of filter_, as expressions on the tuples of the table. */
+  std::vector<const AbstractExpression *> filter_keys_;
+
+  /** The source of the pages to be scanned, nullptr to scan the whole table page after page. */
+  MorselSource *morsels_{nullptr};
+  /** The page after the ones scanned so far, when scanning the whole table. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** The number of tables of tables_ whose picked pages were listed, when scanning a SYSTEM sample of them. */
+  size_t sampled_tables_{0};
+  /** The pages of the current morsel, or the current page of the table. */
+  std::vector<page_id_t> pages_;
+  /** The next page of pages_ to be scanned. */
+  size_t page_idx_{0};
+  /** The last tuple scanned on pages_[page_idx_], INVALID_PAGE_ID if the page is yet to be scanned. */
+  RID resume_rid_;
+  /** The consumer of the tuples while draining, nullptr otherwise, and the tuples of the page being scanned for it. */
+  CandidateConsumer *consumer_{nullptr};
+  std::vector<Tuple> consumed_;
+
+  /** The batch Next hands out tuples from. */
+  TupleBatch current_;
+  /** The next tuple of current_. */
+  size_t current_idx_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.h
+//
+// Identification: src/include/execution/executors/sort_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/sort_key.h"
+#include "execution/tmp_tuple_run.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortExecutor executes an external merge sort.
+ *
+ * The tuples of the child are buffered with their normalized keys, see SortKey, and sorted by comparing the keys
+ * in place. Whenever the buffer outgrows the memory budget of the executor context, it is sorted and written to a
+ * run in the temporary space, see TmpTupleRun. If the input spilled, the runs are merged as many at a time as the
+ * budget holds a block of each for, until the last merge is few enough runs to stream the output from.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new sort executor.
+   * @param exec_ctx the executor context
+   * @param plan the sort plan to be executed
+   * @param child the child executor that produces the tuples to sort
+   */
+  SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  /** Drops the buffered tuples and the runs, and closes the child. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+ private:
+  /** A sorted run being merged, read back a block at a time, and the normalized key of its current tuple. */
+  struct RunReader {
+    TmpTupleRun run_;
+    std::vector<Tuple> block_;
+    size_t pos_{0};
+    std::vector<char> key_;
+
+    /** @return the current tuple of the run */
+    const Tuple &Current() const { return block_[pos_]; }
+  };
+
+  /** @return the normalized key of a buffered tuple */
+  const char *KeyOf(size_t i) const { return keys_.data() + i * sort_key_.GetSize(); }
+
+  /** Sorts the buffered tuples into order_. */
+  void SortBuffer();
+
+  /** Writes the buffered tuples to a new sorted run, then empties the buffer. */
+  void SpillBuffer();
+
+  /** Starts merging runs, each of which becomes a reader of merge_. */
+  void StartMerge(std::vector<TmpTupleRun> &&runs);
+
+  /** @return true if the current tuple of a reader of merge_ sorts after the one of another, for the heap */
+  bool MergeGreater(size_t left, size_t right) const;
+
+  /** Moves a reader to its next tuple. @return false if the run is exhausted */
+  bool Advance(RunReader *reader);
+
+  /** Pops the least tuple of the merge. @return false if every run is exhausted */
+  bool NextMerged(Tuple *tuple);
+
+  /** The sort plan node to be executed. */
+  const SortPlanNode *plan_;
+  /** The child executor from which tuples are obtained. */
+  std::unique_ptr<AbstractExecutor> child_;
+  SortKey sort_key_;
+  /** The buffered tuples, their normalized keys back to back, and their indices in sorted order. */
+  std::vector<Tuple> tuples_;
+  std::vector<char> keys_;
+  std::vector<size_t> order_;
+  /** The bytes of the buffered tuples and keys. */
+  size_t buffered_bytes_{0};
+  /** The next index of order_ to produce, when the input did not spill. */
+  size_t next_{0};
+  /** The sorted runs spilled so far. */
+  std::vector<TmpTupleRun> runs_;
+  /** The readers of the runs being merged, and a min-heap of the indices of those with tuples left. */
+  std::vector<RunReader> merge_;
+  std::vector<size_t> heap_;
+};
+
+}  // namespace bustub
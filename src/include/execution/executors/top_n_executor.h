@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// top_n_executor.h
+//
+// Identification: src/include/execution/executors/top_n_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNExecutor produces the first N tuples of a sort, in order, in a single pass over its child.
+ *
+ * It keeps the N least tuples seen so far in a max-heap of their normalized keys, see SortKey, so that a tuple which
+ * does not sort before the greatest of them is rejected on its key, without being copied. The executor factory
+ * creates one in place of a sort under a limit, with N the limit plus the offset.
+ */
+class TopNExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new top-N executor.
+   * @param exec_ctx the executor context
+   * @param plan the sort plan of the tuples
+   * @param n the number of tuples to produce, at most
+   * @param child the child executor that produces the tuples to sort
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, size_t n,
+               std::unique_ptr<AbstractExecutor> &&child);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  /** Drops the kept tuples and closes the child. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+ private:
+  /** @return the normalized key of a kept tuple */
+  char *KeyOf(size_t i) { return keys_.data() + i * sort_key_.GetSize(); }
+
+  /** @return true if the kept tuple at a slot sorts before the one at another */
+  bool Less(size_t left, size_t right) const;
+
+  /** The sort plan of the tuples. */
+  const SortPlanNode *plan_;
+  /** The number of tuples to produce, at most. */
+  size_t n_;
+  /** The child executor from which tuples are obtained. */
+  std::unique_ptr<AbstractExecutor> child_;
+  SortKey sort_key_;
+  /** The kept tuples and their normalized keys back to back, one slot each. */
+  std::vector<Tuple> tuples_;
+  std::vector<char> keys_;
+  /** The slots, as a max-heap while the child is consumed, then in sorted order. */
+  std::vector<size_t> heap_;
+  /** The next index of heap_ to produce. */
+  size_t next_{0};
+};
+
+}  // namespace bustub
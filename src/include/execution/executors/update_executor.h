@@ -18,6 +18,7 @@
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/index_batch.h"
 #include "execution/plans/update_plan.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
@@ -27,6 +28,14 @@ namespace bustub {
 /**
  * UpdateExecutor executes an update in a table.
  * Updated values from a child executor.
+ *
+ * The tuples are updated in place a batch of the child at a time, and the entries of the ones whose keys changed are
+ * then moved in each index of the table as a batch, see IndexBatch. The indexes on none of the updated columns are
+ * not looked at, so an update of no indexed column touches the table pages only.
+ *
+ * An update adding to INTEGER and BIGINT columns only, of no index and of a table without materialized views, adds to
+ * the tuples in place under increment locks, see TableHeap::IncrementTuple: the transactions adding to the same tuple,
+ * a counter say, then do so at once rather than one after the other.
  */
 class UpdateExecutor : public AbstractExecutor {
   friend class UpdatePlanNode;
@@ -46,6 +55,8 @@ class UpdateExecutor : public AbstractExecutor {
 
   bool Next([[maybe_unused]] Tuple *tuple, RID *rid) override;
 
+  void Close() override;
+
   /*
    * Given an old tuple, creates a new updated tuple based on the updateinfo given in the plan
    * @param old_tup the tuple to be updated
@@ -72,15 +83,24 @@ class UpdateExecutor : public AbstractExecutor {
         }
       }
     }
-    return Tuple(values, &schema);
+    return Tuple(std::move(values), &schema);
   }
 
  private:
+  /**
+   * @param index_batch the indexes the update changes
+   * @param[out] increments the increments of the update, if it only adds to the tuples in place
+   * @return true if the update adds to the tuples in place
+   */
+  bool GetIncrements(const IndexBatch &index_batch, std::vector<ColumnIncrement> *increments) const;
+
   /** The update plan node to be executed. */
   const UpdatePlanNode *plan_;
   /** Metadata identifying the table that should be updated. */
-  const TableMetadata *table_info_;
+  TableMetadata *table_info_;
   /** The child executor to obtain value from. */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** True once the updates are done. */
+  bool done_{false};
 };
 }  // namespace bustub
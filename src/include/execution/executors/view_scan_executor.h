@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// view_scan_executor.h
+//
+// Identification: src/include/execution/executors/view_scan_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/materialized_view.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/view_scan_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ViewScanExecutor reads the groups of a materialized view. Init takes the tuples of the groups at once, so the scan
+ * sees the view as of a single commit however long it runs.
+ */
+class ViewScanExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new view scan executor.
+   * @param exec_ctx the executor context
+   * @param plan the view scan plan to be executed
+   */
+  ViewScanExecutor(ExecutorContext *exec_ctx, const ViewScanPlanNode *plan);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  /** Drops the tuples of the groups. */
+  void Close() override;
+
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+ private:
+  /** The view scan plan node to be executed. */
+  const ViewScanPlanNode *plan_;
+  /** The view to read. */
+  MaterializedView *view_;
+  /** The tuples of the groups of the view, and the next one to produce. */
+  std::vector<Tuple> tuples_;
+  size_t next_{0};
+};
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include "catalog/schema.h"
@@ -48,6 +49,19 @@ class ColumnValueExpression : public AbstractExpression {
   uint32_t GetTupleIdx() const { return tuple_idx_; }
   uint32_t GetColIdx() const { return col_idx_; }
 
+  /** Adds the columns an expression reads to col_idxs, each once. */
+  static void CollectColumns(const AbstractExpression *expr, std::vector<uint32_t> *col_idxs) {
+    if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+      if (std::find(col_idxs->begin(), col_idxs->end(), column->col_idx_) == col_idxs->end()) {
+        col_idxs->push_back(column->col_idx_);
+      }
+      return;
+    }
+    for (const AbstractExpression *child : expr->GetChildren()) {
+      CollectColumns(child, col_idxs);
+    }
+  }
+
  private:
   /** Tuple index 0 = left side of join, tuple index 1 = right side of join */
   uint32_t tuple_idx_;
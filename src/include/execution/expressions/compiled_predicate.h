@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.h
+//
+// Identification: src/include/execution/expressions/compiled_predicate.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * CompiledPredicate is a predicate over the tuples of one schema, compiled from a ComparisonExpression of
+ * ColumnValueExpressions and ConstantValueExpressions of numeric types.
+ *
+ * Compiling picks a single function specialized on the comparison and on the types of both operands, which reads the
+ * columns straight from the tuple data at their offset in the schema, instead of walking the expression tree and
+ * materializing a Value at every node. A comparison with a NULL operand does not satisfy the predicate. Select
+ * evaluates the predicate on many tuples at once: when the operands have the same native type, see typed_kernels.h,
+ * it gathers their columns and compares them a vector register at a time with the selection kernels.
+ */
+class CompiledPredicate {
+ public:
+  /**
+   * Compiles a predicate.
+   * @param predicate the predicate to compile
+   * @param schema the schema of the tuples the predicate is evaluated on
+   * @return the compiled predicate, or nullptr if the predicate has a form or a type that is not supported
+   */
+  static std::unique_ptr<CompiledPredicate> Compile(const AbstractExpression *predicate, const Schema *schema);
+
+  /**
+   * Compiles the predicate again, in place, after its constants were rebound, see ConstantValueExpression::SetValue.
+   * @param predicate the predicate it was compiled from
+   * @param schema the schema it was compiled for
+   */
+  void Recompile(const AbstractExpression *predicate, const Schema *schema);
+
+  /** @return true if the tuple satisfies the predicate */
+  bool Evaluate(const Tuple *tuple) const { return fn_(tuple->GetData(), operands_); }
+
+  /**
+   * Evaluates the predicate on tuples at once.
+   * @param tuples the tuples, of the schema the predicate was compiled for
+   * @param[out] selected the indices of the tuples that satisfy the predicate, in increasing order
+   */
+  void Select(const std::vector<Tuple> &tuples, std::vector<uint32_t> *selected) const;
+
+  /** Where the compiled function finds its operands. */
+  struct Operands {
+    /** Offset of the left column in the tuple data. */
+    uint32_t left_offset_{0};
+    /** Offset of the right column in the tuple data, when the right operand is a column. */
+    uint32_t right_offset_{0};
+    /** The right operand, when it is a constant compared as an integer. */
+    int64_t int_constant_{0};
+    /** The right operand, when it is a constant compared as a DECIMAL. */
+    double decimal_constant_{0};
+    /** The right operand, when it is a constant compared as a TIMESTAMP. */
+    uint64_t timestamp_constant_{0};
+  };
+
+  /** The function a predicate compiles to. */
+  using Fn = bool (*)(const char *data, const Operands &operands);
+
+  /** The function a predicate compiles to for Select, when it has one. */
+  using SelectFn = void (*)(const std::vector<Tuple> &tuples, const Operands &operands,
+                            std::vector<uint32_t> *selected);
+
+ private:
+  CompiledPredicate(Fn fn, SelectFn select_fn, const Operands &operands)
+      : fn_(fn), select_fn_(select_fn), operands_(operands) {}
+
+  /** Compiles a predicate into its functions and operands. @return false if it is not supported */
+  static bool CompileInto(const AbstractExpression *predicate, const Schema *schema, Fn *fn, SelectFn *select_fn,
+                          Operands *operands);
+
+  Fn fn_;
+  /** nullptr if Select evaluates fn_ tuple by tuple. */
+  SelectFn select_fn_;
+  Operands operands_;
+};
+
+}  // namespace bustub
@@ -18,7 +18,8 @@
 
 namespace bustub {
 /**
- * ConstantValueExpression represents constants.
+ * ConstantValueExpression represents constants. A constant can also be a parameter of a prepared statement, which
+ * SetValue binds to a new value between runs, see PreparedStatement; executors thus read constants in Init.
  */
 class ConstantValueExpression : public AbstractExpression {
  public:
@@ -36,6 +37,15 @@ class ConstantValueExpression : public AbstractExpression {
     return val_;
   }
 
+  /** @return the constant */
+  const Value &GetValue() const { return val_; }
+
+  /** Binds the constant to a value of its type, which may be NULL. */
+  void SetValue(const Value &val) {
+    BUSTUB_ASSERT(val.GetTypeId() == GetReturnType(), "A constant keeps its type.");
+    val_ = val;
+  }
+
  private:
   Value val_;
 };
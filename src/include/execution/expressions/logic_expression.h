@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// logic_expression.h
+//
+// Identification: src/include/expression/logic_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** LogicType represents the type of logical operation that we want to perform. */
+enum class LogicType { And, Or };
+
+/**
+ * LogicExpression represents two boolean expressions combined, with the three-valued logic of SQL: a NULL operand
+ * makes for a NULL result unless the other operand decides it alone.
+ */
+class LogicExpression : public AbstractExpression {
+ public:
+  /** Creates a new logic expression representing (left logic_type right). */
+  LogicExpression(const AbstractExpression *left, const AbstractExpression *right, LogicType logic_type)
+      : AbstractExpression({left, right}, TypeId::BOOLEAN), logic_type_{logic_type} {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+    Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+    return PerformLogic(lhs, rhs);
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    Value rhs = GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+    return PerformLogic(lhs, rhs);
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    Value lhs = GetChildAt(0)->EvaluateAggregate(group_bys, aggregates);
+    Value rhs = GetChildAt(1)->EvaluateAggregate(group_bys, aggregates);
+    return PerformLogic(lhs, rhs);
+  }
+
+  /** @return the type of logical operation */
+  LogicType GetLogicType() const { return logic_type_; }
+
+ private:
+  Value PerformLogic(const Value &lhs, const Value &rhs) const {
+    // The value that decides the operation alone: false for AND, true for OR.
+    const bool decisive = logic_type_ == LogicType::Or;
+    if ((!lhs.IsNull() && lhs.GetAs<bool>() == decisive) || (!rhs.IsNull() && rhs.GetAs<bool>() == decisive)) {
+      return ValueFactory::GetBooleanValue(decisive);
+    }
+    if (lhs.IsNull() || rhs.IsNull()) {
+      return ValueFactory::GetNullValueByType(TypeId::BOOLEAN);
+    }
+    return ValueFactory::GetBooleanValue(!decisive);
+  }
+
+  LogicType logic_type_;
+};
+}  // namespace bustub
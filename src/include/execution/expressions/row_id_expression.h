@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// row_id_expression.h
+//
+// Identification: src/include/execution/expressions/row_id_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+/**
+ * RowIdExpression is the record id of the tuple of the table a scan reads, as a BIGINT (see RID::Get). A scan that
+ * outputs it along with the few columns its parents read lets the other columns be fetched by a MaterializeExecutor
+ * at the end of the plan, for the rows that are left by then (late materialization).
+ */
+class RowIdExpression : public AbstractExpression {
+ public:
+  /** @param tuple_idx {tuple index 0 = left side of join, tuple index 1 = right side of join} */
+  explicit RowIdExpression(uint32_t tuple_idx = 0) : AbstractExpression({}, TypeId::BIGINT), tuple_idx_{tuple_idx} {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    return ValueFactory::GetBigIntValue(tuple->GetRid().Get());
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    return ValueFactory::GetBigIntValue((tuple_idx_ == 0 ? left_tuple : right_tuple)->GetRid().Get());
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    BUSTUB_ASSERT(false, "Aggregation should only refer to group-by and aggregates.");
+  }
+
+  uint32_t GetTupleIdx() const { return tuple_idx_; }
+
+ private:
+  /** Tuple index 0 = left side of join, tuple index 1 = right side of join */
+  uint32_t tuple_idx_;
+};
+}  // namespace bustub
@@ -0,0 +1,212 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// flat_aggregation_hash_table.h
+//
+// Identification: src/include/execution/flat_aggregation_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/memory_tracker.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * FlatAggregationHashTable is an open-addressing aggregation hash table for group-by keys of fixed-width types.
+ *
+ * Every group is a row of an arena: the hash of the key, the aggregation states inline as 64-bit integers with a null
+ * flag each, then the group-by values serialized back to back. The slots of the table only point to the rows, so
+ * growing the table moves the slots and never the rows. An input tuple is serialized into a scratch key, hashed once
+ * and probed for once, and its aggregates are folded into the states of the row it finds or appends.
+ *
+ * The rows are appended to one of a number of partitions by the high bits of their hash, so that the partitions of
+ * the tables of several threads can be merged independently, see MergePartition.
+ *
+ * The aggregation results are the ones of SimpleAggregationHashTable, except that groups of NULL keys are one group.
+ */
+class FlatAggregationHashTable {
+ public:
+  /**
+   * @return true if the table supports the plan: every group-by is of an integral or timestamp type, every
+   * aggregate input is an integer
+   */
+  static bool Supports(const AggregationPlanNode *plan);
+
+  /**
+   * Creates a new empty table.
+   * @param plan the aggregation plan, supported by the table
+   * @param input_schema the schema of the tuples to aggregate
+   * @param num_partitions the number of partitions of the rows
+   */
+  FlatAggregationHashTable(const AggregationPlanNode *plan, const Schema *input_schema, size_t num_partitions = 1);
+
+  /** Folds a tuple into its group, creating the group if it is new. */
+  void Insert(const Tuple &tuple);
+
+  /**
+   * Folds tuples into their groups, as Insert does one at a time. Without group-bys, all the tuples are of one group,
+   * and each aggregate is computed over the column of its inputs at once by the aggregation kernels, see
+   * aggregation_kernels.h; a sum then checks for overflow once per call rather than once per tuple, as merging does.
+   */
+  void InsertBatch(const std::vector<Tuple> &tuples);
+
+  /**
+   * Folds a tuple into its group if the group exists.
+   * @return false if the tuple belongs to no group of the table
+   */
+  bool InsertIfPresent(const Tuple &tuple);
+
+  /**
+   * Merges the groups of a partition of another table for the same plan into this table.
+   * @param other the table to merge from
+   * @param partition the partition of other to merge
+   */
+  void MergePartition(const FlatAggregationHashTable &other, size_t partition);
+
+  /** Empties the table. */
+  void Clear();
+
+  /** @return the number of groups */
+  size_t Size() const { return num_groups_; }
+
+  /** @return the bytes of memory held by the slots and the rows */
+  size_t MemoryUsage() const;
+
+  /** @return the number of partitions of the rows */
+  size_t GetNumPartitions() const { return partitions_.size(); }
+
+  /**
+   * An iterator through the groups of the table, partition by partition. The key and value of a group are
+   * materialized when the iterator first reaches it.
+   */
+  class Iterator {
+   public:
+    /** Creates an iterator of no table. */
+    Iterator() = default;
+
+    /** Creates an iterator at a row of a partition of the table. */
+    Iterator(const FlatAggregationHashTable *table, size_t partition, size_t row);
+
+    /** @return the key of the iterator */
+    const AggregateKey &Key() const { return key_; }
+
+    /** @return the value of the iterator */
+    const AggregateValue &Val() const { return val_; }
+
+    /** @return the iterator after it is incremented */
+    Iterator &operator++();
+
+    /** @return true if both iterators are identical */
+    bool operator==(const Iterator &other) const { return partition_ == other.partition_ && row_ == other.row_; }
+
+    /** @return true if both iterators are different */
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+   private:
+    /** Skips past the ends of partitions and materializes the group of the row, if any. */
+    void Settle();
+
+    const FlatAggregationHashTable *table_{nullptr};
+    size_t partition_{0};
+    size_t row_{0};
+    AggregateKey key_;
+    AggregateValue val_;
+  };
+
+  /** @return iterator to the first group of the table */
+  Iterator Begin() const { return Iterator{this, 0, 0}; }
+
+  /** @return iterator past the last group of the table */
+  Iterator End() const { return Iterator{this, partitions_.size(), 0}; }
+
+ private:
+  /** The size of an arena chunk of rows. */
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+  /** The number of slots of an empty table. */
+  static constexpr size_t INITIAL_SLOTS = 64;
+  /** The offset of the aggregation states in a row, after the hash. */
+  static constexpr size_t STATES_OFFSET = sizeof(hash_t);
+  /** The offset in the input tuples of a group-by or an aggregate input that is not a column. */
+  static constexpr uint32_t NOT_A_COLUMN = UINT32_MAX;
+
+  struct Slot {
+    hash_t hash_;
+    char *row_;
+  };
+
+  /** The rows of a partition, in arena chunks of rows_per_chunk_ rows, counted in the memory of the execution. */
+  struct Partition {
+    std::vector<std::vector<char, TrackedAllocator<char, MemoryTag::EXECUTION>>> chunks_;
+    size_t num_rows_{0};
+  };
+
+  /** Serializes the key of a tuple into scratch_key_. @return the hash of the key */
+  hash_t SerializeKey(const Tuple &tuple);
+
+  /** @return the row of the group of the key; if the group is new, appended with the initial states if insert */
+  char *Find(hash_t hash, const char *key, bool insert);
+
+  /** Folds the aggregates of a tuple into the states of a row. */
+  void Fold(char *row, const Tuple &tuple);
+
+  /** Appends a row for a new group to the partition of its hash. */
+  char *NewRow(hash_t hash, const char *key);
+
+  /** Doubles the number of slots. */
+  void Grow();
+
+  /** @return the row at an index of a partition */
+  const char *RowAt(size_t partition, size_t row) const {
+    return partitions_[partition].chunks_[row / rows_per_chunk_].data() + (row % rows_per_chunk_) * row_size_;
+  }
+
+  /** Adds to a count or a sum, with the overflow checks of an INTEGER value. */
+  static void AddChecked(int64_t *state, int64_t input);
+
+  /** @return the offset in the input tuples of an expression that reads a column of them, NOT_A_COLUMN otherwise */
+  uint32_t ColumnOffsetOf(const AbstractExpression *expr) const;
+
+  const Schema *input_schema_;
+  const std::vector<const AbstractExpression *> &group_bys_;
+  const std::vector<const AbstractExpression *> &aggregates_;
+  const std::vector<AggregationType> &agg_types_;
+  /**
+   * The offsets in the input tuples of the group-bys and aggregate inputs that are columns, which are read from the
+   * tuple data in their native type without materializing a Value, see ColumnOffsetOf.
+   */
+  std::vector<uint32_t> group_by_columns_;
+  std::vector<uint32_t> aggregate_columns_;
+  /** The offsets of the group-by values in a serialized key. */
+  std::vector<size_t> key_offsets_;
+  size_t key_size_{0};
+  size_t nulls_offset_;
+  size_t key_offset_;
+  size_t row_size_;
+  size_t rows_per_chunk_;
+  /** The initial states and null flags of a new row. */
+  std::vector<char> initial_states_;
+  /** The key of the tuple being inserted. */
+  std::vector<char> scratch_key_;
+  /** The aggregate inputs of the tuples being inserted by InsertBatch. */
+  std::vector<int32_t> scratch_column_;
+  std::vector<Slot, TrackedAllocator<Slot, MemoryTag::EXECUTION>> slots_;
+  size_t num_groups_{0};
+  std::vector<Partition> partitions_;
+  /** The number of chunks of all the partitions. */
+  size_t num_chunks_{0};
+};
+
+}  // namespace bustub
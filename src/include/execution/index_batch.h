@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_batch.h
+//
+// Identification: src/include/execution/index_batch.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "concurrency/transaction.h"
+#include "execution/executor_context.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * IndexBatch buffers the changes a write executor makes to the indexes of a table for a batch of tuples, and applies
+ * them to each index at once with Index::DeleteEntries and Index::InsertEntries, which a BPlusTreeIndex applies in key
+ * order, so that consecutive entries land on the same leaf page rather than each descending the tree somewhere else.
+ *
+ * The changes are recorded in the index write set of the transaction only once they are applied, so that an abort
+ * undoes exactly the changes that reached the indexes. Of every index, the deletes are applied before the inserts, so
+ * an update that moves a unique key from one tuple of the batch to another does not find it taken.
+ *
+ * Where the transaction locks key ranges, see ExecutorContext::LocksKeyRanges, a delete locks the range of its entry
+ * EXCLUSIVE, and an insert the gap of its key INSERT_INTENTION, before the entry goes in and again after, if the entry
+ * bounding the gap changed meanwhile.
+ */
+class IndexBatch {
+ public:
+  /**
+   * @param exec_ctx the context of the write executor
+   * @param table_info the table written to, whose indexes the batch keeps up to date
+   */
+  IndexBatch(ExecutorContext *exec_ctx, TableMetadata *table_info);
+
+  /**
+   * Creates a batch for updates of some columns of a table only. An update writes a tuple in place, at its RID, so the
+   * indexes whose keys have none of the columns keep their entries as they are, and are left out of the batch.
+   * @param exec_ctx the context of the update executor
+   * @param table_info the table updated
+   * @param updated_columns the columns the updates may change
+   */
+  IndexBatch(ExecutorContext *exec_ctx, TableMetadata *table_info, const std::vector<uint32_t> &updated_columns);
+
+  /** Buffers the entries of a tuple inserted into the table. */
+  void Insert(const Tuple &tuple, RID rid);
+
+  /** Buffers the removal of the entries of a tuple deleted from the table. */
+  void Delete(const Tuple &tuple, RID rid);
+
+  /** Buffers the removal of the old and the insert of the new entries of an updated tuple, where its keys changed. */
+  void Update(const Tuple &old_tuple, const Tuple &new_tuple, RID rid);
+
+  /** Applies the buffered changes to the indexes, and empties the batch. */
+  void Flush();
+
+  /** @return true if the table has indexes to keep up to date, which a batch for updates may have left out */
+  bool HasIndexes() const { return !indexes_.empty(); }
+
+ private:
+  /** The buffered changes to one index. */
+  struct IndexChanges {
+    IndexInfo *index_info_;
+    std::vector<Tuple> deleted_keys_;
+    std::vector<RID> deleted_rids_;
+    std::vector<Tuple> inserted_keys_;
+    std::vector<RID> inserted_rids_;
+    /** The write records of the changes, appended to the transaction once they are applied. */
+    std::vector<IndexWriteRecord> records_;
+  };
+
+  /**
+   * Locks INSERT_INTENTION the key ranges bounding the gaps the keys inserted into an index go into, see
+   * Index::GetNextKey.
+   * @param[in,out] next_rids empty before the keys are inserted, then the entries locked for each key, after which
+   * the entries bounding the gaps now are locked as well, if they differ
+   */
+  void LockInsertGaps(const IndexChanges &changes, std::vector<RID> *next_rids);
+
+  /** @return the key of a tuple of the table in an index */
+  Tuple KeyOf(const Tuple &tuple, const IndexInfo *index_info) const;
+
+  ExecutorContext *exec_ctx_;
+  TableMetadata *table_info_;
+  std::vector<IndexChanges> indexes_;
+};
+
+}  // namespace bustub
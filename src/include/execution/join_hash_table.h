@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.h
+//
+// Identification: src/include/execution/join_hash_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/memory_tracker.h"
+#include "common/util/hash_util.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * JoinHashTable holds the tuples of the build side of a hash join, by the hash of their join keys.
+ *
+ * The tuples are appended to an array of entries, each with its hash and the index of the next entry of its chain,
+ * and Build links them into chains off a directory of buckets indexed by the high bits of the hash. The low bits are
+ * left alone, as the tuples of a spilled partition share them.
+ *
+ * Probes go a group of hashes at a time, see Prefetch: the buckets of all the hashes of the group are prefetched, then
+ * the first entries of their chains, before any chain is walked, so that the cache misses of the group overlap
+ * instead of stalling each probe in turn (group prefetching).
+ */
+class JoinHashTable {
+ public:
+  /** The index of no entry, which ends a chain. */
+  static constexpr uint32_t END = UINT32_MAX;
+
+  /** An entry of the table. */
+  struct Entry {
+    hash_t hash_;
+    /** The next entry of the chain of the bucket. */
+    uint32_t next_;
+    Tuple tuple_;
+  };
+
+  /** The entries, counted in the memory of the execution. */
+  using Entries = std::vector<Entry, TrackedAllocator<Entry, MemoryTag::EXECUTION>>;
+
+  /** Appends a tuple to the table, which is probed only after the next Build. */
+  void Insert(hash_t hash, Tuple &&tuple);
+
+  /** Links the entries inserted so far into the chains of a directory of about one bucket per entry. */
+  void Build();
+
+  /** Removes all the entries. */
+  void Clear();
+
+  /** @return the entries, in the order they were inserted */
+  const Entries &GetEntries() const { return entries_; }
+
+  /** Prefetches the buckets of a group of hashes, then the first entries of their chains, ahead of probing them. */
+  void Prefetch(const hash_t *hashes, size_t n) const;
+
+  /** @return the first entry of the hash, END if none */
+  uint32_t Find(hash_t hash) const { return Match(buckets_.empty() ? END : buckets_[BucketOf(hash)], hash); }
+
+  /** @return the entry of the same hash after an entry, END if none */
+  uint32_t FindNext(uint32_t entry) const { return Match(entries_[entry].next_, entries_[entry].hash_); }
+
+  /** @return the tuple of an entry */
+  const Tuple &GetTuple(uint32_t entry) const { return entries_[entry].tuple_; }
+
+ private:
+  size_t BucketOf(hash_t hash) const { return hash >> shift_; }
+
+  /** @return the first entry of the hash from an entry on along its chain, END if none */
+  uint32_t Match(uint32_t entry, hash_t hash) const {
+    while (entry != END && entries_[entry].hash_ != hash) {
+      entry = entries_[entry].next_;
+    }
+    return entry;
+  }
+
+  Entries entries_;
+  /** The first entry of the chain of each bucket, empty until Build. */
+  std::vector<uint32_t, TrackedAllocator<uint32_t, MemoryTag::EXECUTION>> buckets_;
+  /** The shift of a hash down to its bucket, 64 less the log of the number of buckets. */
+  uint32_t shift_{63};
+};
+
+}  // namespace bustub
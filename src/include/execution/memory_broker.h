@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_broker.h
+//
+// Identification: src/include/execution/memory_broker.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+class AbstractPlanNode;
+
+/** The fraction of the memory it asks for below which a query waits to be admitted, see MemoryBroker::Admit. */
+static constexpr size_t MEMORY_GRANT_MIN_FRACTION = 4;
+
+/**
+ * MemoryBroker shares the memory of the process between the queries running at once. The operators that spill past
+ * a memory budget (aggregations, hash join build sides, sorts and merge join runs) otherwise each take the budget of
+ * their executor context, however many queries run, which can run the process out of memory.
+ *
+ * A query asks for the budget of each of its spilling operators when it starts, see ExecutorContext::AdmitQuery, and
+ * is granted as much of it as is free, provided that is at least a MEMORY_GRANT_MIN_FRACTION of it: its operators
+ * then split the grant between them, and spill earlier the less memory it was granted. A query that would be granted
+ * less waits in a queue until queries that finish release enough. The queue is served in order, so that a large query
+ * is not passed over forever by smaller ones.
+ */
+class MemoryBroker {
+ public:
+  /** @param capacity the bytes to share between the queries */
+  explicit MemoryBroker(size_t capacity) : capacity_(capacity) {}
+
+  DISALLOW_COPY_AND_MOVE(MemoryBroker);
+
+  /**
+   * Waits until a query can be granted memory, behind the queries that waited before it.
+   * @param request the bytes the query asks for
+   * @param minimum the fewest bytes the query runs with
+   * @return the bytes granted, between minimum and request, both capped by the capacity
+   */
+  size_t Admit(size_t request, size_t minimum);
+
+  /** Gives back bytes granted by Admit, admitting the queries waiting for them. */
+  void Release(size_t bytes);
+
+  /** @return the bytes to share between the queries */
+  size_t GetCapacity() const { return capacity_; }
+
+  /** @return the bytes granted and not released */
+  size_t GetReserved();
+
+  /** @return the number of queries waiting to be admitted */
+  size_t GetNumWaiting();
+
+  /** @return the number of operators of a plan that spill past the memory budget, which a query asks memory for */
+  static size_t CountSpillingOperators(const AbstractPlanNode *plan);
+
+ private:
+  const size_t capacity_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  size_t reserved_{0};
+  /** The tickets of the waiting queries, in the order they arrived; the first one is admitted next. */
+  std::deque<uint64_t> queue_;
+  uint64_t next_ticket_{0};
+};
+
+}  // namespace bustub
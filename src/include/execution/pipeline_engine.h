@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pipeline_engine.h
+//
+// Identification: src/include/execution/pipeline_engine.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PushOperator is a stage of a pipeline: it takes the batches pushed by the stage before it, and pushes its own
+ * output on to the stage after it, if any, in the same call.
+ */
+class PushOperator {
+ public:
+  virtual ~PushOperator() = default;
+
+  /** Prepares the state of every worker, before the source of the pipeline starts pushing. */
+  virtual void Open(size_t num_workers) = 0;
+
+  /** Takes a batch pushed on a worker; called concurrently for different workers, on the thread of the worker. */
+  virtual void Push(size_t worker, const TupleBatch &batch) = 0;
+
+  /**
+   * Called once all the workers are done, on the calling thread: pushes the output the workers held back, or, for a
+   * sink, completes what they put into it.
+   */
+  virtual void Finish() = 0;
+};
+
+/** PushSource is the start of a pipeline, which pushes the batches of each of its workers into the pipeline. */
+class PushSource {
+ public:
+  virtual ~PushSource() = default;
+
+  /** @return the number of workers the source runs on */
+  virtual size_t NumWorkers() const = 0;
+
+  /** Called on the calling thread before the workers start. */
+  virtual void Open() {}
+
+  /** Pushes every batch of a worker into head; called concurrently for different workers. */
+  virtual void Run(size_t worker, PushOperator *head) = 0;
+
+  /** Called on the calling thread once the workers are done, or have failed. */
+  virtual void Close() {}
+};
+
+class ResultSink;
+
+/** A pipeline: a source and the operators it pushes through, in order, the last of which is the sink. */
+struct Pipeline {
+  PushSource *source_{nullptr};
+  std::vector<PushOperator *> operators_;
+};
+
+/**
+ * PipelineEngine executes a plan push-based, as an alternative to pulling tuples through the Init/Next interface of
+ * the executors, which costs a chain of virtual calls per tuple (or batch) per operator.
+ *
+ * The plan is cut into pipelines at its pipeline breakers: the build side of a hash join, aggregations and sorts.
+ * Each pipeline is a source, which produces batches, the streaming operators they pass through, and a sink, which
+ * takes them all. A sequential scan is a source with one instance per worker of the thread pool of the executor
+ * context, sharing a MorselSource; the probe side of a hash join is a streaming operator; the hash join build side,
+ * aggregations and sorts are sinks whose output is the source of the pipeline of their parent (a single worker). An
+ * exchange is dropped, as the scans run in parallel anyway. Every other plan, and so its whole subtree, is run by its
+ * Volcano executor as the single-worker source of a pipeline.
+ *
+ * The pipelines run one at a time, every pipeline after the pipelines its sink or source depends on. The workers of
+ * a source with more than one worker run as tasks on the thread pool, in the workload class of the transaction, see
+ * ThreadPool; a single-worker source runs on the calling thread, so that a Volcano executor under it can use the pool
+ * itself. The streaming operators keep an output batch per worker, and the sinks a partial result per worker, merged
+ * by Finish, so that no state is shared between workers.
+ *
+ * Unlike the executors, the sinks hold their whole input in memory and never spill: the engine is meant for plans
+ * whose hash join build sides, groups and sorted inputs fit in memory.
+ */
+class PipelineEngine {
+ public:
+  /**
+   * Cuts a plan into pipelines.
+   * @param exec_ctx the executor context the plan runs in
+   * @param plan the plan to execute
+   */
+  PipelineEngine(ExecutorContext *exec_ctx, const AbstractPlanNode *plan);
+
+  ~PipelineEngine();
+
+  /**
+   * Runs the pipelines.
+   * @param[out] result_set the output tuples of the plan, in order if the last pipeline has a single worker; ignored
+   * if nullptr
+   * @throw the first exception thrown by a worker
+   */
+  void Execute(std::vector<Tuple> *result_set);
+
+  /** @return the pipelines, in the order they run */
+  const std::vector<Pipeline> &GetPipelines() const { return pipelines_; }
+
+ private:
+  /**
+   * Compiles a plan into the pipeline that pushes its output into consumer, after the pipelines it depends on.
+   * @param plan the plan
+   * @param consumer the operator the output of the plan is pushed into
+   * @param pipeline the pipeline consumer is part of, whose operators are collected from the sink back
+   */
+  void Compile(const AbstractPlanNode *plan, PushOperator *consumer, Pipeline *pipeline);
+
+  /** Appends a pipeline, compiled from the sink back, to the pipelines to run. */
+  void AddPipeline(Pipeline *pipeline);
+
+  /** Runs a pipeline to completion. */
+  void Run(const Pipeline &pipeline);
+
+  ExecutorContext *exec_ctx_;
+  /** The number of workers of a parallel scan. */
+  size_t num_workers_;
+  /** The pipelines, each after the ones it depends on. */
+  std::vector<Pipeline> pipelines_;
+  /** The operators and sources of the pipelines. */
+  std::vector<std::unique_ptr<PushOperator>> operators_;
+  std::vector<std::unique_ptr<PushSource>> sources_;
+  /** The sink of the last pipeline, which gathers the output of the plan. */
+  ResultSink *result_sink_;
+};
+
+}  // namespace bustub
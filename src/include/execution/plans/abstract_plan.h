@@ -20,7 +20,73 @@
 namespace bustub {
 
 /** PlanType represents the types of plans that we have in our system. */
-enum class PlanType { SeqScan, IndexScan, Insert, Update, Delete, Aggregation, Limit, NestedLoopJoin, NestedIndexJoin };
+enum class PlanType {
+  SeqScan,
+  IndexScan,
+  Insert,
+  Update,
+  Delete,
+  Aggregation,
+  Limit,
+  NestedLoopJoin,
+  NestedIndexJoin,
+  HashJoin,
+  MergeJoin,
+  Materialize,
+  Exchange,
+  Sort,
+  ViewScan
+};
+
+/** @return the name of a type of plan, e.g. "seq_scan" for SeqScan, nullptr if plan_type is none */
+constexpr const char *FindPlanTypeName(PlanType plan_type) {
+  switch (plan_type) {
+    case PlanType::SeqScan:
+      return "seq_scan";
+    case PlanType::IndexScan:
+      return "index_scan";
+    case PlanType::Insert:
+      return "insert";
+    case PlanType::Update:
+      return "update";
+    case PlanType::Delete:
+      return "delete";
+    case PlanType::Aggregation:
+      return "aggregation";
+    case PlanType::Limit:
+      return "limit";
+    case PlanType::NestedLoopJoin:
+      return "nested_loop_join";
+    case PlanType::NestedIndexJoin:
+      return "nested_index_join";
+    case PlanType::HashJoin:
+      return "hash_join";
+    case PlanType::MergeJoin:
+      return "merge_join";
+    case PlanType::Materialize:
+      return "materialize";
+    case PlanType::Exchange:
+      return "exchange";
+    case PlanType::Sort:
+      return "sort";
+    case PlanType::ViewScan:
+      return "view_scan";
+  }
+  return nullptr;
+}
+
+/** The number of types of plans, for the arrays indexed by PlanType; ViewScan is the last one. */
+constexpr size_t NUM_PLAN_TYPES = static_cast<size_t>(PlanType::ViewScan) + 1;
+
+// A type added to PlanType must be named above, or the switch fails to compile; then this fails until it is counted.
+static_assert(FindPlanTypeName(static_cast<PlanType>(NUM_PLAN_TYPES)) == nullptr,
+              "NUM_PLAN_TYPES must count every PlanType");
+
+/** @return the name of a type of plan, e.g. "seq_scan" for SeqScan */
+inline const char *PlanTypeName(PlanType plan_type) {
+  const char *name = FindPlanTypeName(plan_type);
+  return name == nullptr ? "unknown" : name;
+}
 
 /**
  * AbstractPlanNode represents all the possible types of plan nodes in our system.
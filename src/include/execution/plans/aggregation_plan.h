@@ -16,13 +16,29 @@
 #include <vector>
 
 #include "common/util/hash_util.h"
+#include "execution/distinct_counter.h"
 #include "execution/plans/abstract_plan.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
-/** AggregationType enumerates all the possible aggregation functions in our system. */
-enum class AggregationType { CountAggregate, SumAggregate, MinAggregate, MaxAggregate };
+/**
+ * AggregationType enumerates all the possible aggregation functions in our system. CountDistinctAggregate counts the
+ * distinct non-NULL inputs exactly, ApproxCountDistinctAggregate estimates their number, see DistinctCounter.
+ */
+enum class AggregationType {
+  CountAggregate,
+  SumAggregate,
+  MinAggregate,
+  MaxAggregate,
+  CountDistinctAggregate,
+  ApproxCountDistinctAggregate
+};
+
+/** @return true if the aggregation counts distinct inputs, exactly or not */
+inline bool IsDistinctAggregate(AggregationType type) {
+  return type == AggregationType::CountDistinctAggregate || type == AggregationType::ApproxCountDistinctAggregate;
+}
 
 /**
  * AggregationPlanNode represents the various SQL aggregation functions.
@@ -102,6 +118,8 @@ struct AggregateKey {
 
 struct AggregateValue {
   std::vector<Value> aggregates_;
+  /** The counters of the aggregates of a group, if any aggregate counts distinct inputs; unused by the others. */
+  std::vector<DistinctCounter> distinct_{};
 };
 }  // namespace bustub
 
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// exchange_plan.h
+//
+// Identification: src/include/execution/plans/exchange_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * ExchangePlanNode runs its child plan on several workers and gathers their output.
+ *
+ * The sequential scan reached by following the first child of every node from the child plan (the outer side of
+ * joins) is split across the workers; every other scan is run in full by every worker. The child plan must therefore
+ * produce its output tuple by tuple of that scan, as scans and joins do, but not aggregations or limits. An
+ * aggregation directly above an exchange aggregates the output of every worker on that worker instead, see
+ * AggregationExecutor.
+ */
+class ExchangePlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new exchange plan node.
+   * @param output_schema the output format of this exchange node, the one of the child
+   * @param child the plan to run on every worker
+   * @param num_workers the number of workers
+   */
+  ExchangePlanNode(const Schema *output_schema, const AbstractPlanNode *child, size_t num_workers)
+      : AbstractPlanNode(output_schema, {child}), num_workers_(num_workers) {
+    BUSTUB_ASSERT(num_workers_ > 0, "An exchange needs at least one worker.");
+  }
+
+  PlanType GetType() const override { return PlanType::Exchange; }
+
+  /** @return the plan to run on every worker */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Exchange should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the number of workers */
+  size_t GetNumWorkers() const { return num_workers_; }
+
+ private:
+  /** The number of workers. */
+  size_t num_workers_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_join_plan.h
+//
+// Identification: src/include/execution/plans/hash_join_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** Default number of bytes of build side tuples a hash join holds in memory before it spills to disk. */
+static constexpr size_t HASH_JOIN_MEMORY_BUDGET = 1 << 20;
+
+/**
+ * The tuples a hash join produces: the joined pairs of tuples (Inner), or the right tuples that have a match on the
+ * left (Semi, EXISTS) or none (Anti, NOT EXISTS), each once, however many matches it has.
+ */
+enum class JoinType { Inner, Semi, Anti };
+
+/**
+ * HashJoinPlanNode equi-joins the tuples of two children plans on the values of their join keys.
+ *
+ * A semi or anti join filters the right (probe) side by the keys of the left (build) side, which is the set of keys
+ * tested for membership and is not output: the columns of its output schema are evaluated on the right tuples alone.
+ */
+class HashJoinPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new hash join plan node.
+   * @param output_schema the output format of this hash join node
+   * @param children the build side (left) and probe side (right) children plans
+   * @param left_keys the join keys, evaluated on the left tuples
+   * @param right_keys the join keys, evaluated on the right tuples, matched pairwise against left_keys
+   * @param predicate a further predicate on the joined tuples, the tuples are joined if all their keys are equal and
+   * predicate(tuple) = true or predicate = nullptr
+   * @param memory_budget the bytes of left tuples the join holds in memory before it partitions both sides to disk
+   * @param join_type whether the join produces the joined pairs, or the right tuples with or without a match
+   */
+  HashJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
+                   std::vector<const AbstractExpression *> &&left_keys,
+                   std::vector<const AbstractExpression *> &&right_keys, const AbstractExpression *predicate = nullptr,
+                   size_t memory_budget = HASH_JOIN_MEMORY_BUDGET, JoinType join_type = JoinType::Inner)
+      : AbstractPlanNode(output_schema, std::move(children)),
+        left_keys_(std::move(left_keys)),
+        right_keys_(std::move(right_keys)),
+        predicate_(predicate),
+        memory_budget_(memory_budget),
+        join_type_(join_type) {
+    BUSTUB_ASSERT(left_keys_.size() == right_keys_.size(), "Both sides of a hash join need as many join keys.");
+  }
+
+  PlanType GetType() const override { return PlanType::HashJoin; }
+
+  /** @return the join keys of the left side */
+  const std::vector<const AbstractExpression *> &GetLeftKeys() const { return left_keys_; }
+
+  /** @return the join keys of the right side */
+  const std::vector<const AbstractExpression *> &GetRightKeys() const { return right_keys_; }
+
+  /** @return the predicate to be checked on top of the equal keys, possibly nullptr */
+  const AbstractExpression *Predicate() const { return predicate_; }
+
+  /** @return the bytes of left tuples to be held in memory */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** @return whether the join produces the joined pairs, or the right tuples with or without a match */
+  JoinType GetJoinType() const { return join_type_; }
+
+  /** @return the left plan node of the hash join, which the hash table is built on; it should be the smaller table */
+  const AbstractPlanNode *GetLeftPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Hash joins should have exactly two children plans.");
+    return GetChildAt(0);
+  }
+
+  /** @return the right plan node of the hash join, which probes the hash table */
+  const AbstractPlanNode *GetRightPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Hash joins should have exactly two children plans.");
+    return GetChildAt(1);
+  }
+
+ private:
+  /** The join keys of the left side. */
+  std::vector<const AbstractExpression *> left_keys_;
+  /** The join keys of the right side. */
+  std::vector<const AbstractExpression *> right_keys_;
+  /** The residual join predicate. */
+  const AbstractExpression *predicate_;
+  /** The bytes of left tuples held in memory. */
+  size_t memory_budget_;
+  /** The tuples produced. */
+  JoinType join_type_;
+};
+
+}  // namespace bustub
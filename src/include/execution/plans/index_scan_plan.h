@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <optional>
+#include <utility>
+
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
@@ -28,9 +31,20 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) == true or predicate ==
    * nullptr
    * @param table_oid the identifier of table to be scanned
+   * @param fetch_in_page_order true to fetch the tuples of batches of record ids in the order of their pages rather
+   * than of their keys, see FetchesInPageOrder
+   * @param lower_bound if set, the scan starts at the first key whose first column is not less than it
+   * @param upper_bound if set, the scan stops past the last key whose first column is not greater than it
    */
-  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid)
-      : AbstractPlanNode(output, {}), predicate_{predicate}, index_oid_(index_oid) {}
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid,
+                    bool fetch_in_page_order = false, std::optional<Value> lower_bound = std::nullopt,
+                    std::optional<Value> upper_bound = std::nullopt)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        index_oid_(index_oid),
+        fetch_in_page_order_(fetch_in_page_order),
+        lower_bound_(std::move(lower_bound)),
+        upper_bound_(std::move(upper_bound)) {}
 
   PlanType GetType() const override { return PlanType::IndexScan; }
 
@@ -40,11 +54,31 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** @return the identifier of the table that should be scanned */
   index_oid_t GetIndexOid() const { return index_oid_; }
 
+  /**
+   * @return true if the tuples are fetched a batch of record ids at a time, sorted by page, so that each page is read
+   * once per batch and in order, like a bitmap heap scan; the tuples then come out in key order only within a page
+   */
+  bool FetchesInPageOrder() const { return fetch_in_page_order_; }
+
+  /**
+   * @return the least value of the first key column the scan reads, if bounded; the bounds only narrow the scan down
+   * the index, the predicate is still checked on all the tuples in between
+   */
+  const std::optional<Value> &GetLowerBound() const { return lower_bound_; }
+
+  /** @return the greatest value of the first key column the scan reads, if bounded */
+  const std::optional<Value> &GetUpperBound() const { return upper_bound_; }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
+  /** True if the tuples are fetched in the order of their pages. */
+  bool fetch_in_page_order_;
+  /** The bounds of the first key column, both included. */
+  std::optional<Value> lower_bound_;
+  std::optional<Value> upper_bound_;
 };
 
 }  // namespace bustub
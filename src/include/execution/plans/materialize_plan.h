@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// materialize_plan.h
+//
+// Identification: src/include/execution/plans/materialize_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "catalog/catalog.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+/**
+ * MaterializePlanNode fetches the rows of a table whose record ids its child carries in a column, output by a
+ * RowIdExpression in a scan of the table, and completes the tuples of the child with the columns of the rows.
+ *
+ * The columns of the output schema are evaluated as those of a join of the tuples of the child (tuple 0) with the rows
+ * of the table they carry the record ids of (tuple 1).
+ */
+class MaterializePlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new materialize plan node.
+   * @param output_schema the output format of this node, over the tuples of the child and the rows of the table
+   * @param child the plan to obtain tuples from
+   * @param table_oid the table the record ids are of
+   * @param row_id_col_idx the column of the output schema of the child holding the record ids
+   */
+  MaterializePlanNode(const Schema *output_schema, const AbstractPlanNode *child, table_oid_t table_oid,
+                      uint32_t row_id_col_idx)
+      : AbstractPlanNode(output_schema, {child}), table_oid_(table_oid), row_id_col_idx_(row_id_col_idx) {}
+
+  PlanType GetType() const override { return PlanType::Materialize; }
+
+  /** @return the identifier of the table the rows are fetched from */
+  table_oid_t GetTableOid() const { return table_oid_; }
+
+  /** @return the column of the tuples of the child holding the record ids */
+  uint32_t GetRowIdColIdx() const { return row_id_col_idx_; }
+
+  /** @return the plan to obtain tuples from */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Materialize should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+ private:
+  table_oid_t table_oid_;
+  uint32_t row_id_col_idx_;
+};
+}  // namespace bustub
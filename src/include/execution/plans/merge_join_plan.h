@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_plan.h
+//
+// Identification: src/include/execution/plans/merge_join_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * MergeJoinPlanNode equi-joins the tuples of two children plans that are both ordered on their join keys, ascending,
+ * the first key first: index scans of indexes on the keys, or sorts with ASC keys.
+ */
+class MergeJoinPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new merge join plan node.
+   * @param output_schema the output format of this merge join node
+   * @param children the left and right children plans, both ordered on their join keys
+   * @param left_keys the join keys, evaluated on the left tuples, in the order the left tuples are sorted on
+   * @param right_keys the join keys, evaluated on the right tuples, matched pairwise against left_keys
+   * @param predicate a further predicate on the joined tuples, the tuples are joined if all their keys are equal and
+   * predicate(tuple) = true or predicate = nullptr
+   */
+  MergeJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
+                    std::vector<const AbstractExpression *> &&left_keys,
+                    std::vector<const AbstractExpression *> &&right_keys, const AbstractExpression *predicate = nullptr)
+      : AbstractPlanNode(output_schema, std::move(children)),
+        left_keys_(std::move(left_keys)),
+        right_keys_(std::move(right_keys)),
+        predicate_(predicate) {
+    BUSTUB_ASSERT(left_keys_.size() == right_keys_.size(), "Both sides of a merge join need as many join keys.");
+  }
+
+  PlanType GetType() const override { return PlanType::MergeJoin; }
+
+  /** @return the join keys of the left side */
+  const std::vector<const AbstractExpression *> &GetLeftKeys() const { return left_keys_; }
+
+  /** @return the join keys of the right side */
+  const std::vector<const AbstractExpression *> &GetRightKeys() const { return right_keys_; }
+
+  /** @return the predicate to be checked on top of the equal keys, possibly nullptr */
+  const AbstractExpression *Predicate() const { return predicate_; }
+
+  /** @return the left plan node of the merge join */
+  const AbstractPlanNode *GetLeftPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Merge joins should have exactly two children plans.");
+    return GetChildAt(0);
+  }
+
+  /** @return the right plan node of the merge join, whose runs of equal keys are buffered */
+  const AbstractPlanNode *GetRightPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Merge joins should have exactly two children plans.");
+    return GetChildAt(1);
+  }
+
+ private:
+  /** The join keys of the left side. */
+  std::vector<const AbstractExpression *> left_keys_;
+  /** The join keys of the right side. */
+  std::vector<const AbstractExpression *> right_keys_;
+  /** The residual join predicate. */
+  const AbstractExpression *predicate_;
+};
+
+}  // namespace bustub
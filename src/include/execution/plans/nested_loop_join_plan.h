@@ -20,6 +20,10 @@
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
+
+/** Default number of outer tuples a nested loop join buffers per scan of the inner child. */
+static constexpr size_t NESTED_LOOP_JOIN_BLOCK_SIZE = 256;
+
 /**
  * NestedLoopJoinPlanNode joins tuples that come from two sequential scan
  */
@@ -31,16 +35,22 @@ class NestedLoopJoinPlanNode : public AbstractPlanNode {
    * @param children two sequential scan children plans
    * @param predicate the predicate to join with, the tuples are joined if predicate(tuple) = true or predicate =
    * nullptr
+   * @param block_size the number of left tuples joined per scan of the right child, 1 for a tuple-at-a-time join
    */
   NestedLoopJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
-                         const AbstractExpression *predicate)
-      : AbstractPlanNode(output_schema, std::move(children)), predicate_(predicate) {}
+                         const AbstractExpression *predicate, size_t block_size = NESTED_LOOP_JOIN_BLOCK_SIZE)
+      : AbstractPlanNode(output_schema, std::move(children)), predicate_(predicate), block_size_(block_size) {
+    BUSTUB_ASSERT(block_size_ > 0, "Nested loop joins need at least one tuple per block.");
+  }
 
   PlanType GetType() const override { return PlanType::NestedLoopJoin; }
 
   /** @return the predicate to be used in the nested loop join */
   const AbstractExpression *Predicate() const { return predicate_; }
 
+  /** @return the number of left tuples joined per scan of the right child */
+  size_t GetBlockSize() const { return block_size_; }
+
   /** @return the left plan node of the nested loop join, by convention it should be the smaller table*/
   const AbstractPlanNode *GetLeftPlan() const {
     BUSTUB_ASSERT(GetChildren().size() == 2, "Nested loop joins should have exactly two children plans.");
@@ -56,6 +66,8 @@ class NestedLoopJoinPlanNode : public AbstractPlanNode {
  private:
   /** The join predicate. */
   const AbstractExpression *predicate_;
+  /** The number of left tuples per block. */
+  size_t block_size_;
 };
 
 }  // namespace bustub
@@ -15,10 +15,16 @@
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "storage/table/table_sample.h"
 
 namespace bustub {
+
+/** Default number of table pages a sequential scan under an exchange claims at a time. */
+static constexpr size_t SEQ_SCAN_MORSEL_SIZE = 16;
+
 /**
- * SeqScanPlanNode identifies a table that should be scanned with an optional predicate.
+ * SeqScanPlanNode identifies a table that should be scanned with an optional predicate, or only a sample of it, e.g.
+ * for an approximate answer, see TableSample.
  */
 class SeqScanPlanNode : public AbstractPlanNode {
  public:
@@ -27,9 +33,17 @@ class SeqScanPlanNode : public AbstractPlanNode {
    * @param output the output format of this scan plan node
    * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) = true or predicate = nullptr
    * @param table_oid the identifier of table to be scanned
+   * @param morsel_size the number of pages the scan claims at a time when it is split across the workers of an
+   * exchange
+   * @param sample the sample of the table to scan, all of it by default
    */
-  SeqScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid)
-      : AbstractPlanNode(output, {}), predicate_{predicate}, table_oid_(table_oid) {}
+  SeqScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid,
+                  size_t morsel_size = SEQ_SCAN_MORSEL_SIZE, TableSample sample = {})
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        table_oid_(table_oid),
+        morsel_size_(morsel_size),
+        sample_(sample) {}
 
   PlanType GetType() const override { return PlanType::SeqScan; }
 
@@ -39,11 +53,28 @@ class SeqScanPlanNode : public AbstractPlanNode {
   /** @return the identifier of the table that should be scanned */
   table_oid_t GetTableOid() const { return table_oid_; }
 
+  /** @return the number of pages a worker of an exchange claims at a time */
+  size_t GetMorselSize() const { return morsel_size_; }
+
+  /** @return the sample of the table the scan reads */
+  const TableSample &GetSample() const { return sample_; }
+
+  /** @return true if plan is a scan of every tuple of the table, with no predicate */
+  static bool IsFullScanOf(const AbstractPlanNode *plan, table_oid_t table_oid) {
+    const auto *scan = dynamic_cast<const SeqScanPlanNode *>(plan);
+    return scan != nullptr && scan->GetTableOid() == table_oid && scan->GetPredicate() == nullptr &&
+           scan->GetSample().method_ == SampleMethod::NONE;
+  }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
   /** The table whose tuples should be scanned. */
   table_oid_t table_oid_;
+  /** The number of pages per morsel. */
+  size_t morsel_size_;
+  /** The sample of the table to scan. */
+  TableSample sample_;
 };
 
 }  // namespace bustub
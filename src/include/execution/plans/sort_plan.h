@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_plan.h
+//
+// Identification: src/include/execution/plans/sort_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** The direction of a sort key. NULL sorts below every other value. */
+enum class OrderByType { ASC, DESC };
+
+/** A sort key and its direction. */
+using OrderBy = std::pair<const AbstractExpression *, OrderByType>;
+
+/**
+ * SortPlanNode orders the tuples of its child plan by a list of sort keys, the first key first (ORDER BY). The tuples
+ * are produced unchanged, so the output schema is the one of the child. Under a limit, only the tuples up to the end
+ * of the limit are kept, see TopNExecutor.
+ */
+class SortPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new sort plan node.
+   * @param output_schema the output format of this sort node, the one of the child
+   * @param child the plan to obtain tuples from
+   * @param order_bys the sort keys, evaluated against the tuples of the child
+   */
+  SortPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> &&order_bys)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)) {}
+
+  PlanType GetType() const override { return PlanType::Sort; }
+
+  /** @return the sort keys */
+  const std::vector<OrderBy> &GetOrderBys() const { return order_bys_; }
+
+  /** @return the plan to obtain tuples from */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Sort should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+ private:
+  std::vector<OrderBy> order_bys_;
+};
+}  // namespace bustub
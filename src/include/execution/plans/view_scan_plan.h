@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// view_scan_plan.h
+//
+// Identification: src/include/execution/plans/view_scan_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+/**
+ * ViewScanPlanNode reads the groups of a materialized view, in place of the aggregation the view maintains, see
+ * MaterializedView.
+ */
+class ViewScanPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new view scan plan node.
+   * @param output_schema the output format of this node, the output schema of the aggregation of the view
+   * @param view_name the name of the view to read
+   */
+  ViewScanPlanNode(const Schema *output_schema, std::string view_name)
+      : AbstractPlanNode(output_schema, {}), view_name_(std::move(view_name)) {}
+
+  PlanType GetType() const override { return PlanType::ViewScan; }
+
+  /** @return the name of the view to read */
+  const std::string &GetViewName() const { return view_name_; }
+
+ private:
+  std::string view_name_;
+};
+}  // namespace bustub
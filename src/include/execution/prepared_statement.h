@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prepared_statement.h
+//
+// Identification: src/include/execution/prepared_statement.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+#include "concurrency/transaction.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/result_cursor.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PreparedStatement is a plan prepared to be executed many times, such as the few plan shapes of an OLTP workload,
+ * see ExecutionEngine::Prepare. Its executors are created once, with their buffers and hash tables, and every
+ * execution only binds the parameters, switches the executor context to the transaction it runs in, and initializes
+ * the executors again, which keep the memory they grew to.
+ *
+ * The parameters are ConstantValueExpressions of the expressions of the plan, which Bind sets to new values of their
+ * types. Executors read the constants of their plans in Init, so every run sees the values bound before it. Values
+ * the optimizer copied out of the expressions into the plan nodes, such as the bounds of an index scan, are not
+ * parameters: a plan whose such values change is prepared again.
+ *
+ * A statement runs one execution at a time, in the executor context it was prepared in.
+ */
+class PreparedStatement {
+ public:
+  /**
+   * @param exec_ctx the context the statement runs in, which must outlive it
+   * @param plan the plan
+   * @param executor the root executor of the plan
+   * @param parameters the parameters of the plan, in order
+   */
+  PreparedStatement(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                    std::unique_ptr<AbstractExecutor> &&executor, std::vector<ConstantValueExpression *> parameters);
+
+  DISALLOW_COPY_AND_MOVE(PreparedStatement);
+
+  /** @return the number of parameters of the statement */
+  size_t NumParameters() const { return parameters_.size(); }
+
+  /** Binds a parameter to a value of its type, for the executions from the next one on. */
+  void Bind(size_t param_idx, const Value &value);
+
+  /**
+   * Starts an execution, with the parameters as bound, closing the one before if it is still open.
+   * @param txn the transaction the execution runs in
+   * @return the cursor over the result, owned by the statement and valid until the next execution
+   */
+  ResultCursor *Open(Transaction *txn);
+
+  /**
+   * Executes the statement to its end.
+   * @param txn the transaction the execution runs in
+   * @param[out] result_set the output tuples, appended; ignored if nullptr
+   */
+  void Execute(Transaction *txn, std::vector<Tuple> *result_set);
+
+ private:
+  ExecutorContext *exec_ctx_;
+  std::vector<ConstantValueExpression *> parameters_;
+  /** The cursor over the executors of the plan, opened by every execution. */
+  ResultCursor cursor_;
+  /** The batch Execute reads the result with. */
+  TupleBatch batch_;
+};
+
+}  // namespace bustub
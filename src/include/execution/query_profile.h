@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// query_profile.h
+//
+// Identification: src/include/execution/query_profile.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * OperatorProfile accumulates what the executors of one plan node spent, their children included: an exchange runs
+ * several instances of its child plan, on as many threads, which all add to the profile of the plan.
+ */
+struct OperatorProfile {
+  /** The executors created for the plan node. */
+  std::atomic<uint64_t> num_instances_{0};
+  /** The tuples they produced. */
+  std::atomic<uint64_t> num_tuples_{0};
+  /** The wall and CPU time spent in Init, in nanoseconds. */
+  std::atomic<uint64_t> init_wall_ns_{0};
+  std::atomic<uint64_t> init_cpu_ns_{0};
+  /** The wall and CPU time spent in Next and NextBatch, in nanoseconds. */
+  std::atomic<uint64_t> next_wall_ns_{0};
+  std::atomic<uint64_t> next_cpu_ns_{0};
+  /** The pages fetched from the buffer pool, and those of them found resident. */
+  std::atomic<uint64_t> num_fetches_{0};
+  std::atomic<uint64_t> num_hits_{0};
+};
+
+/**
+ * QueryProfile holds the profiles of the operators of a query run under EXPLAIN ANALYZE, see
+ * ExecutionEngine::ExecuteAnalyze, and annotates the plan tree with them.
+ */
+class QueryProfile {
+ public:
+  /** @return the profile of a plan node, created empty on the first call */
+  OperatorProfile *GetOperatorProfile(const AbstractPlanNode *plan) {
+    std::scoped_lock latch(latch_);
+    return &operators_[plan];
+  }
+
+  /**
+   * Prints the plan tree, a node per line indented under its parent, with the profile of each: the tuples produced,
+   * the wall time spent in total and in the operator itself, its children aside, the CPU time, the time spent in
+   * Init, and the pages the operator itself fetched and found resident. The time of a node above an exchange may be
+   * less than that of its children, which run in parallel, and its own time is then 0.
+   * @param plan the root of the plan tree profiled
+   */
+  std::string ToString(const AbstractPlanNode *plan);
+
+ private:
+  /** The wall and CPU time, in nanoseconds, the pages fetched and found resident by an operator and its children. */
+  struct Totals {
+    uint64_t wall_ns_{0};
+    uint64_t cpu_ns_{0};
+    uint64_t num_fetches_{0};
+    uint64_t num_hits_{0};
+  };
+
+  /** Prints a node and its children at a depth, and adds the totals of the node to those of its parent. */
+  void Print(const AbstractPlanNode *plan, size_t depth, std::ostringstream *out, Totals *parent_totals);
+
+  std::mutex latch_;
+  std::unordered_map<const AbstractPlanNode *, OperatorProfile> operators_;
+};
+
+}  // namespace bustub
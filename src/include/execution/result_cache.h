@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.h
+//
+// Identification: src/include/execution/result_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/metrics.h"
+#include "concurrency/transaction.h"
+#include "execution/plans/abstract_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** Default number of bytes of results a ResultCache holds. */
+static constexpr size_t RESULT_CACHE_SIZE = 16 << 20;
+
+/**
+ * ResultCache keeps the results of read-only plans, so that a plan executed again on tables that did not change since,
+ * e.g. the same query of a dashboard refreshed over and over, returns its result without running, see
+ * ExecutionEngine::EnableResultCache.
+ *
+ * A result is keyed by the fingerprint of its plan: the plan tree written out canonically, the types and fields of its
+ * nodes and expressions and the values of its constants, so the parameters of a prepared plan are part of it, but not
+ * the knobs that change how it runs rather than what it returns, such as its morsel or block sizes. Two plans built
+ * apart are one if they are written out alike. A plan that writes, reads a materialized view (up to date only once the
+ * commit is done), or holds an expression the fingerprint does not know, is not cached.
+ *
+ * Each result is stored with the timestamp of the last commit that wrote to each table the plan reads, see
+ * TableHeap::GetLastCommitTs, which is set before the commit is visible. A result is returned as long as the tables
+ * still have those timestamps, and only to a transaction whose snapshot holds those commits: only transactions
+ * reading a snapshot use the cache, as a locking one takes its locks as it reads and an optimistic one records its
+ * reads to be validated. A result is stored only if the snapshot it was computed from holds the commits it is stored
+ * with, so that a commit made visible meanwhile changes the timestamps it is checked against.
+ *
+ * The results are evicted least recently used first past the capacity of the cache; a result larger than it is not
+ * stored. The cache is thread safe.
+ */
+class ResultCache {
+ public:
+  /** The key a result is looked up and stored under. */
+  struct Key {
+    std::string fingerprint_;
+    /** The heaps of the tables the plan reads, and the timestamps of their last commits. */
+    std::vector<std::pair<TableHeap *, timestamp_t>> tables_;
+  };
+
+  /** @param capacity the number of bytes of results to hold at most */
+  explicit ResultCache(size_t capacity = RESULT_CACHE_SIZE);
+
+  ~ResultCache();
+
+  DISALLOW_COPY_AND_MOVE(ResultCache);
+
+  /**
+   * Makes the key of the result of a plan for a transaction.
+   * @param plan the plan
+   * @param catalog the catalog of the tables the plan reads
+   * @param txn the transaction the plan runs in
+   * @param[out] key the key of the result
+   * @return false if the result must be neither looked up nor stored: the plan is not cached, the transaction does
+   * not read a snapshot, or a table was written by a commit its snapshot does not hold
+   */
+  static bool MakeKey(const AbstractPlanNode *plan, Catalog *catalog, Transaction *txn, Key *key);
+
+  /**
+   * Looks a result up.
+   * @param[out] result_set the tuples of the result, appended on a hit; ignored if nullptr
+   * @return true on a hit
+   */
+  bool Lookup(const Key &key, std::vector<Tuple> *result_set);
+
+  /** Stores the result of the plan of a key, replacing the one stored before it. */
+  void Insert(Key &&key, const std::vector<Tuple> &result);
+
+  /** @return the number of bytes of the results held */
+  size_t GetSize();
+
+ private:
+  struct Entry {
+    std::vector<std::pair<TableHeap *, timestamp_t>> tables_;
+    std::vector<Tuple> result_;
+    size_t size_;
+    /** The position of the entry in lru_. */
+    std::list<std::string>::iterator lru_iter_;
+  };
+
+  /** Removes an entry. */
+  void Erase(std::unordered_map<std::string, Entry>::iterator iter);
+
+  const size_t capacity_;
+  std::mutex latch_;
+  /** The results by the fingerprints of their plans. */
+  std::unordered_map<std::string, Entry> entries_;
+  /** The fingerprints of the results, the least recently used last. */
+  std::list<std::string> lru_;
+  size_t size_{0};
+  Counter num_hits_;
+  Counter num_misses_;
+  Counter num_invalidations_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cursor.h
+//
+// Identification: src/include/execution/result_cursor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ResultCursor streams the output of a plan to its client, see ExecutionEngine::Open. The root executor of the plan
+ * is only pulled when the client asks for more, one batch at a time, so the memory a query holds does not grow with
+ * the size of its result, and its first rows reach the client as soon as they are produced. A client that stops
+ * reading early closes the cursor, which closes the executors, letting go of what they hold.
+ *
+ * The executor context and the transaction the plan runs in must outlive the cursor.
+ */
+class ResultCursor {
+ public:
+  /**
+   * Creates a cursor over the output of an executor, which produces no tuples until opened.
+   * @param plan the plan
+   * @param executor the root executor of the plan
+   */
+  ResultCursor(const AbstractPlanNode *plan, std::unique_ptr<AbstractExecutor> &&executor);
+
+  /** Closes the cursor if the client did not. */
+  ~ResultCursor();
+
+  DISALLOW_COPY_AND_MOVE(ResultCursor);
+
+  /** @return the schema of the tuples of the cursor */
+  const Schema *GetOutputSchema() const { return executor_->GetOutputSchema(); }
+
+  /**
+   * Produces the next batch of the result, of at most the capacity of the batch, which the client thus picks. The
+   * tuples of the batch are only valid until it is filled again or cleared, see TupleBatch.
+   * @param[out] batch the batch is emptied, then filled with the next tuples of the result
+   * @return true if some tuple was produced, false if the result is exhausted or the cursor closed
+   */
+  bool NextBatch(TupleBatch *batch);
+
+  /**
+   * Produces the next tuple of the result, copied out of the batch the cursor reads ahead into.
+   * @return true if a tuple was produced, false if the result is exhausted or the cursor closed
+   */
+  bool Next(Tuple *tuple);
+
+  /**
+   * Initializes the executors, closing them first if the cursor is open, so that the result starts over. The query is
+   * admitted by the memory broker of the executor context first, if it has one, see ExecutorContext::AdmitQuery.
+   */
+  void Open();
+
+  /**
+   * Stops the query, closing its executors and releasing the memory granted to it; the cursor produces no more tuples
+   * until opened again.
+   */
+  void Close();
+
+  /** @return true if the result is exhausted or the cursor closed */
+  bool IsDone() const { return done_; }
+
+ private:
+  /** Marks the cursor done, closes the executors and ends the admission of the query. */
+  void Finish();
+
+  /** The number of operators of the plan that spill, which the query asks memory for. */
+  size_t num_spilling_operators_;
+  std::unique_ptr<AbstractExecutor> executor_;
+  /** The batch Next hands tuples out of, and the next tuple of it to hand out. */
+  TupleBatch batch_;
+  size_t next_tuple_{0};
+  bool done_{true};
+};
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.h
+//
+// Identification: src/include/execution/sort_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/plans/sort_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** The number of leading bytes of a VARCHAR sort key that a normalized key holds. */
+static constexpr size_t SORT_KEY_VARCHAR_PREFIX = 8;
+
+/**
+ * SortKey compares tuples by a list of sort keys, and encodes the keys of a tuple to a normalized key: a fixed-size
+ * byte string whose memcmp order is the order of the tuples.
+ *
+ * Every key is a marker byte that puts NULL first, then the value big-endian with the sign bit flipped, all bits
+ * inverted for a DESC key. A VARCHAR key only contributes its first SORT_KEY_VARCHAR_PREFIX bytes and ends the
+ * normalized key, since the keys after it would otherwise be compared on ties of the prefix alone; the normalized key
+ * is then inexact, and equal normalized keys are resolved by comparing the tuples.
+ */
+class SortKey {
+ public:
+  /**
+   * Creates the sort key of a list of sort keys.
+   * @param order_bys the sort keys
+   * @param schema the schema of the tuples the keys are evaluated against
+   */
+  SortKey(const std::vector<OrderBy> &order_bys, const Schema *schema);
+
+  /** @return the size of a normalized key, in bytes */
+  size_t GetSize() const { return size_; }
+
+  /** @return true if equal normalized keys imply equal sort keys */
+  bool IsExact() const { return exact_; }
+
+  /**
+   * Encodes the normalized key of a tuple.
+   * @param tuple the tuple
+   * @param[out] key the GetSize() bytes of the normalized key
+   */
+  void Encode(const Tuple &tuple, char *key) const;
+
+  /** @return a negative number, zero or a positive number as left sorts before, with or after right */
+  int Compare(const Tuple &left, const Tuple &right) const;
+
+  /** @return Compare(left, right), decided on the normalized keys of the tuples unless they are equal and inexact */
+  int Compare(const char *left_key, const Tuple &left, const char *right_key, const Tuple &right) const;
+
+ private:
+  const std::vector<OrderBy> &order_bys_;
+  const Schema *schema_;
+  /** The number of sort keys the normalized key holds. */
+  size_t num_encoded_{0};
+  size_t size_{0};
+  bool exact_{true};
+};
+
+}  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_run.h
+//
+// Identification: src/include/execution/tmp_tuple_run.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/disk/temp_space.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TmpTupleRun is a sequence of tuples an operator spills to blocks of a TempSpace, bypassing the buffer pool.
+ *
+ * Tuples are appended, serialized back to back, to a private buffer of a block, which is written to the temporary
+ * file with one write whenever it is full. Once the run is sealed, its tuples are read back a block at a time, in the
+ * order they were appended, through the same buffer. Blocks are freed as they are read, and the blocks that are left
+ * when the run is destroyed are freed unread. The buffer is only held while the run is written or read.
+ */
+class TmpTupleRun {
+ public:
+  /**
+   * Creates an empty run.
+   * @param temp_space the temporary space the blocks of the run are allocated in
+   * @param owner the name of the operator spilling, for error messages
+   */
+  TmpTupleRun(TempSpace *temp_space, std::string owner) : temp_space_(temp_space), owner_(std::move(owner)) {}
+
+  TmpTupleRun(TmpTupleRun &&other) noexcept;
+  TmpTupleRun &operator=(TmpTupleRun &&other) noexcept;
+  TmpTupleRun(const TmpTupleRun &) = delete;
+  TmpTupleRun &operator=(const TmpTupleRun &) = delete;
+
+  /** Frees the blocks that are left. */
+  ~TmpTupleRun() { Drop(); }
+
+  /**
+   * Appends a tuple, writing out the buffer first when the tuple does not fit in it.
+   * @throw OUT_OF_RANGE if the tuple does not fit in a block
+   * @throw Exception if the block can't be written
+   */
+  void Append(const Tuple &tuple);
+
+  /** Writes out the last block once the run has been written, and drops the buffer. */
+  void Seal();
+
+  /**
+   * Reads the tuples of the next block, in the order they were appended, and frees the block.
+   * @param[out] tuples the tuples of the block
+   * @return false if every block has been read
+   */
+  bool ReadBlock(std::vector<Tuple> *tuples);
+
+  /** Frees the blocks that are left without reading them. */
+  void Drop();
+
+  /** @return the number of bytes of tuple data appended to the run */
+  size_t GetBytes() const { return bytes_; }
+
+  /** @return true if no tuple was appended to the run */
+  bool IsEmpty() const { return blocks_.empty() && used_ == 0; }
+
+ private:
+  /** A block of the run, and the bytes of it in use. */
+  struct Block {
+    uint32_t block_;
+    uint32_t size_;
+  };
+
+  /** Writes the buffer to a new block. */
+  void Flush();
+
+  TempSpace *temp_space_;
+  std::string owner_;
+  /** The blocks of the run, in the order they were written. */
+  std::vector<Block> blocks_;
+  /** The next block to read. */
+  size_t next_block_{0};
+  /** The buffer of a block, and the bytes of it in use while the run is written. */
+  std::unique_ptr<char[]> buffer_;
+  size_t used_{0};
+  size_t bytes_{0};
+};
+
+}  // namespace bustub
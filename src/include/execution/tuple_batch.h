@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.h
+//
+// Identification: src/include/execution/tuple_batch.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/arena.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** Default number of tuples an executor produces per call to NextBatch. */
+static constexpr size_t TUPLE_BATCH_SIZE = 1024;
+
+/**
+ * TupleBatch is a batch of tuples, along with their RIDs, handed from an executor to its parent by NextBatch.
+ * The producer fills the batch up to its capacity; the storage of the batch is reused from one call to the next.
+ *
+ * The tuples appended from values are serialized into an arena of the batch, which Clear resets, so once the batch
+ * has grown to its working size, filling it again does not allocate. A tuple of the batch is thus only valid until
+ * the batch is cleared; copying it out of the batch copies its data.
+ */
+class TupleBatch {
+ public:
+  /** Creates an empty batch of at most capacity tuples. */
+  explicit TupleBatch(size_t capacity = TUPLE_BATCH_SIZE) : capacity_(capacity) {
+    BUSTUB_ASSERT(capacity_ > 0, "A batch holds at least one tuple.");
+    tuples_.reserve(capacity_);
+    rids_.reserve(capacity_);
+  }
+
+  /** Changes the maximum number of tuples in the batch, to no fewer than the tuples it holds. */
+  void SetCapacity(size_t capacity) {
+    BUSTUB_ASSERT(capacity > 0 && capacity >= Size(), "A batch holds at least one tuple, and the ones it has.");
+    capacity_ = capacity;
+  }
+
+  /** Empties the batch. */
+  void Clear() {
+    tuples_.clear();
+    rids_.clear();
+    arena_.Reset();
+  }
+
+  /** Appends a tuple of values, serialized into the arena of the batch. */
+  void Append(RID rid, const std::vector<Value> &values, const Schema *schema) {
+    BUSTUB_ASSERT(!IsFull(), "Cannot append to a full batch.");
+    tuples_.emplace_back(values, schema, &arena_);
+    rids_.push_back(rid);
+  }
+
+  /** Appends a tuple to the batch, constructed in place from args. */
+  template <typename... Args>
+  void Emplace(RID rid, Args &&... args) {
+    BUSTUB_ASSERT(!IsFull(), "Cannot append to a full batch.");
+    tuples_.emplace_back(std::forward<Args>(args)...);
+    rids_.push_back(rid);
+  }
+
+  /** Keeps only the tuples in [begin, end) of the batch. */
+  void Slice(size_t begin, size_t end) {
+    BUSTUB_ASSERT(begin <= end && end <= Size(), "Slice out of the batch.");
+    tuples_.erase(tuples_.begin() + end, tuples_.end());
+    tuples_.erase(tuples_.begin(), tuples_.begin() + begin);
+    rids_.erase(rids_.begin() + end, rids_.end());
+    rids_.erase(rids_.begin(), rids_.begin() + begin);
+  }
+
+  /** @return the idx'th tuple of the batch */
+  const Tuple &GetTuple(size_t idx) const { return tuples_[idx]; }
+
+  /** @return the RID of the idx'th tuple of the batch */
+  RID GetRID(size_t idx) const { return rids_[idx]; }
+
+  /** @return the tuples of the batch */
+  const std::vector<Tuple> &GetTuples() const { return tuples_; }
+
+  /** @return the number of tuples in the batch */
+  size_t Size() const { return tuples_.size(); }
+
+  /** @return the maximum number of tuples in the batch */
+  size_t Capacity() const { return capacity_; }
+
+  bool IsEmpty() const { return tuples_.empty(); }
+
+  bool IsFull() const { return tuples_.size() == capacity_; }
+
+ private:
+  size_t capacity_;
+  std::vector<Tuple> tuples_;
+  std::vector<RID> rids_;
+  /** The data of the tuples appended from values. */
+  Arena arena_;
+};
+
+}  // namespace bustub
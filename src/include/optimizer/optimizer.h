@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimizer.h
+//
+// Identification: src/include/optimizer/optimizer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+/**
+ * Optimizer rewrites a plan into one that computes the same rows for less, as costed by the statistics of the tables,
+ * see TableStatistics and Catalog::Analyze. Bottom up, it
+ * - pushes the conjuncts of a join predicate that read one side only down into that side, into its scan or join;
+ * - plans every join as a nested loop join, or as a hash join on its equality conjuncts, with either side outer or
+ *   built on, whichever is cheapest;
+ * - replaces a sequential scan with a scan of an index, bounded by the conjuncts of the predicate on its first key
+ *   column and fetching in page order, when that is cheaper.
+ *
+ * Plans are costed in pages read, the ones out of order at RANDOM_PAGE_COST, plus CPU_TUPLE_COST per tuple processed;
+ * a tuple built into a hash table costs twice one probed. A join keeps the order of its output columns whichever side
+ * it swaps to, so its parent is left as it is. The plan below an exchange is left as it is, since its workers share
+ * the sequential scans below it. Nested index joins are not planned, they have no executor.
+ *
+ * The nodes, expressions and schemas of the rewritten plan are owned by the optimizer or by the original plan, so both
+ * must outlive it.
+ */
+class Optimizer {
+ public:
+  /** The cost of processing a tuple, relative to reading a page. */
+  static constexpr double CPU_TUPLE_COST = 0.01;
+  /** The cost of reading a page out of the order of the table, relative to reading the next one in order. */
+  static constexpr double RANDOM_PAGE_COST = 4;
+  /** The selectivity of a predicate the statistics tell nothing about. */
+  static constexpr double DEFAULT_SELECTIVITY = 1.0 / 3;
+
+  /** @param catalog the catalog of the tables the plans read */
+  explicit Optimizer(Catalog *catalog) : catalog_(catalog) {}
+
+  /** @return the rewritten plan */
+  const AbstractPlanNode *Optimize(const AbstractPlanNode *plan);
+
+  /** @return the estimated number of rows a plan outputs */
+  double EstimateRows(const AbstractPlanNode *plan) const;
+
+  /** @return the estimated cost of running a plan */
+  double EstimateCost(const AbstractPlanNode *plan) const;
+
+ private:
+  /** The estimated fraction of a page of the leaves of an index that holds entries. */
+  static constexpr double INDEX_FILL_FACTOR = 0.7;
+
+  /** Where a column read by an expression comes from: a column of a table, and how many rows carry it. */
+  struct ColumnSource {
+    const TableStatistics *stats_{nullptr};
+    uint32_t col_idx_{0};
+    double rows_{0};
+  };
+  using ColumnResolver = std::function<bool(const ColumnValueExpression *, ColumnSource *)>;
+
+  const AbstractPlanNode *Rewrite(const AbstractPlanNode *plan);
+
+  /** @return the plan with other children, the plan itself if they are the same */
+  const AbstractPlanNode *WithChildren(const AbstractPlanNode *plan, std::vector<const AbstractPlanNode *> children);
+
+  /** @return the cheapest of the sequential scan and the scans of the indexes of its table */
+  const AbstractPlanNode *ChooseScan(const SeqScanPlanNode *plan);
+
+  /**
+   * @param conjuncts the conjuncts of the join predicate, over the output columns of left (tuple 0) and right (1)
+   * @return the cheapest join of left and right on the conjuncts, once the ones reading one side are pushed there
+   */
+  const AbstractPlanNode *PlanJoin(const Schema *output_schema, const AbstractPlanNode *left,
+                                   const AbstractPlanNode *right, std::vector<const AbstractExpression *> conjuncts,
+                                   size_t block_size, size_t memory_budget);
+
+  /**
+   * @param conjunct a predicate over the output columns of the plan
+   * @return the plan filtering its rows by the conjunct as well, nullptr if the plan cannot take it
+   */
+  const AbstractPlanNode *AddFilter(const AbstractPlanNode *plan, const AbstractExpression *conjunct);
+
+  /** Adds the key equalities and the predicate of a hash join as conjuncts. @return false if a key cannot be read */
+  bool JoinConjuncts(const HashJoinPlanNode *plan, std::vector<const AbstractExpression *> *conjuncts);
+
+  /** Adds the conjuncts of an expression, the operands of its ANDs. */
+  static void SplitConjuncts(const AbstractExpression *expr, std::vector<const AbstractExpression *> *conjuncts);
+
+  /** @return the AND of the conjuncts, which are not nullptr, nullptr if there are none */
+  const AbstractExpression *Conjoin(const std::vector<const AbstractExpression *> &conjuncts);
+
+  /**
+   * @return the expression with each column replaced by map of it, the expression itself if none changes, nullptr if
+   * map returns nullptr for any
+   */
+  const AbstractExpression *MapColumns(
+      const AbstractExpression *expr,
+      const std::function<const AbstractExpression *(const ColumnValueExpression *)> &map);
+
+  /** @return the expression with the left and right tuples of a join swapped, nullptr for nullptr */
+  const AbstractExpression *SwapSides(const AbstractExpression *expr);
+
+  /** @return the output schema of a join with its left and right children swapped */
+  const Schema *SwapSides(const Schema *schema);
+
+  /** @return the sides of a join an expression reads, 1 for left and 2 for right, 0 if none */
+  static int SidesRead(const AbstractExpression *expr);
+
+  /** @return the estimated fraction of the rows satisfying a predicate, of which resolve finds the columns */
+  double Selectivity(const AbstractExpression *predicate, const ColumnResolver &resolve) const;
+
+  /** @return the estimated fraction of the rows whose column compares to the value as asked */
+  static double CompareSelectivity(const ColumnSource &column, ComparisonType comp_type, const Value &value);
+
+  /** @return the estimated fraction of the pairs of rows whose columns are equal */
+  static double EqualSelectivity(const ColumnSource &left, const ColumnSource &right);
+
+  /** @return the estimated number of rows of an equi-join of two plans on their keys, then the predicate */
+  double EstimateEquiJoinRows(const AbstractPlanNode *left_plan, const AbstractPlanNode *right_plan,
+                              const std::vector<const AbstractExpression *> &left_keys,
+                              const std::vector<const AbstractExpression *> &right_keys,
+                              const AbstractExpression *predicate) const;
+
+  /** Finds the column of a table an output column of a plan comes from. @return false if there is none */
+  bool TraceColumn(const AbstractPlanNode *plan, uint32_t col_idx, ColumnSource *source) const;
+
+  /** @return a resolver of the columns of an expression evaluated on the tuples of the table */
+  ColumnResolver TableResolver(const TableMetadata *table) const;
+
+  /** @return a resolver of the columns of an expression evaluated on the joined tuples of two plans */
+  ColumnResolver JoinResolver(const AbstractPlanNode *left, const AbstractPlanNode *right) const;
+
+  /** @return the estimated number of pages of a table */
+  static double TablePages(const TableMetadata *table);
+
+  /** @return the table a scan reads */
+  const TableMetadata *ScanTable(const AbstractPlanNode *plan) const;
+
+  /** Makes a node, expression or schema owned by the optimizer. */
+  template <typename T, typename... Args>
+  const T *Make(Args &&... args) {
+    auto made = std::make_unique<T>(std::forward<Args>(args)...);
+    const T *result = made.get();
+    if constexpr (std::is_base_of_v<AbstractPlanNode, T>) {
+      plans_.push_back(std::move(made));
+    } else if constexpr (std::is_base_of_v<AbstractExpression, T>) {
+      expressions_.push_back(std::move(made));
+    } else {
+      schemas_.push_back(std::move(made));
+    }
+    return result;
+  }
+
+  Catalog *catalog_;
+  /** The estimates of the plans seen so far, which never change, since the plans do not. */
+  mutable std::unordered_map<const AbstractPlanNode *, double> rows_;
+  mutable std::unordered_map<const AbstractPlanNode *, double> costs_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plans_;
+  std::vector<std::unique_ptr<AbstractExpression>> expressions_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+};
+
+}  // namespace bustub
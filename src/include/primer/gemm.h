@@ -0,0 +1,236 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gemm.h
+//
+// Identification: src/include/primer/gemm.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "common/thread_pool.h"
+
+namespace bustub {
+
+/** The rows of the blocks of C a blocked GEMM works through, which share a panel of B. */
+static constexpr int GEMM_BLOCK_M = 64;
+/** The columns of the blocks of C, and of the panels of B they are computed from. */
+static constexpr int GEMM_BLOCK_N = 512;
+/** The depth of the panels of A and B a block of C is computed from at a time, sized for them to stay in the caches. */
+static constexpr int GEMM_BLOCK_K = 256;
+/** The rows of the tiles of C a micro-kernel keeps the sums of in registers. */
+static constexpr int GEMM_MICRO_M = 4;
+/** The multiply-adds below which a GEMM is not worth splitting across threads. */
+static constexpr int64_t GEMM_PARALLEL_MIN_OPS = int64_t{1} << 21;
+
+/**
+ * GemmMicroKernel computes a tile of GEMM_MICRO_M x WIDTH of C += A * B, keeping the sums of the tile in vector
+ * registers across the whole depth. There are kernels for float and int32_t on AVX-512 and AVX2; WIDTH is 0 for the
+ * others, whose tiles are all computed by GemmScalar.
+ */
+template <typename T>
+struct GemmMicroKernel {
+  static constexpr int WIDTH = 0;
+
+  static void Run(int /*k*/, const T * /*a*/, int /*lda*/, const T * /*b*/, int /*ldb*/, T * /*c*/, int /*ldc*/) {}
+};
+
+#if defined(__AVX512F__)
+
+template <>
+struct GemmMicroKernel<float> {
+  static constexpr int WIDTH = 32;
+
+  static void Run(int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc) {
+    __m512 sums[GEMM_MICRO_M][2];
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      sums[i][0] = _mm512_loadu_ps(c + i * ldc);
+      sums[i][1] = _mm512_loadu_ps(c + i * ldc + 16);
+    }
+    for (int p = 0; p < k; p++) {
+      const __m512 b0 = _mm512_loadu_ps(b + p * ldb);
+      const __m512 b1 = _mm512_loadu_ps(b + p * ldb + 16);
+      for (int i = 0; i < GEMM_MICRO_M; i++) {
+        const __m512 ai = _mm512_set1_ps(a[i * lda + p]);
+        sums[i][0] = _mm512_fmadd_ps(ai, b0, sums[i][0]);
+        sums[i][1] = _mm512_fmadd_ps(ai, b1, sums[i][1]);
+      }
+    }
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      _mm512_storeu_ps(c + i * ldc, sums[i][0]);
+      _mm512_storeu_ps(c + i * ldc + 16, sums[i][1]);
+    }
+  }
+};
+
+template <>
+struct GemmMicroKernel<int32_t> {
+  static constexpr int WIDTH = 32;
+
+  static void Run(int k, const int32_t *a, int lda, const int32_t *b, int ldb, int32_t *c, int ldc) {
+    __m512i sums[GEMM_MICRO_M][2];
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      sums[i][0] = _mm512_loadu_si512(c + i * ldc);
+      sums[i][1] = _mm512_loadu_si512(c + i * ldc + 16);
+    }
+    for (int p = 0; p < k; p++) {
+      const __m512i b0 = _mm512_loadu_si512(b + p * ldb);
+      const __m512i b1 = _mm512_loadu_si512(b + p * ldb + 16);
+      for (int i = 0; i < GEMM_MICRO_M; i++) {
+        const __m512i ai = _mm512_set1_epi32(a[i * lda + p]);
+        sums[i][0] = _mm512_add_epi32(sums[i][0], _mm512_mullo_epi32(ai, b0));
+        sums[i][1] = _mm512_add_epi32(sums[i][1], _mm512_mullo_epi32(ai, b1));
+      }
+    }
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      _mm512_storeu_si512(c + i * ldc, sums[i][0]);
+      _mm512_storeu_si512(c + i * ldc + 16, sums[i][1]);
+    }
+  }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+template <>
+struct GemmMicroKernel<float> {
+  static constexpr int WIDTH = 16;
+
+  static void Run(int k, const float *a, int lda, const float *b, int ldb, float *c, int ldc) {
+    __m256 sums[GEMM_MICRO_M][2];
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      sums[i][0] = _mm256_loadu_ps(c + i * ldc);
+      sums[i][1] = _mm256_loadu_ps(c + i * ldc + 8);
+    }
+    for (int p = 0; p < k; p++) {
+      const __m256 b0 = _mm256_loadu_ps(b + p * ldb);
+      const __m256 b1 = _mm256_loadu_ps(b + p * ldb + 8);
+      for (int i = 0; i < GEMM_MICRO_M; i++) {
+        const __m256 ai = _mm256_set1_ps(a[i * lda + p]);
+        sums[i][0] = _mm256_fmadd_ps(ai, b0, sums[i][0]);
+        sums[i][1] = _mm256_fmadd_ps(ai, b1, sums[i][1]);
+      }
+    }
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      _mm256_storeu_ps(c + i * ldc, sums[i][0]);
+      _mm256_storeu_ps(c + i * ldc + 8, sums[i][1]);
+    }
+  }
+};
+
+template <>
+struct GemmMicroKernel<int32_t> {
+  static constexpr int WIDTH = 16;
+
+  static void Run(int k, const int32_t *a, int lda, const int32_t *b, int ldb, int32_t *c, int ldc) {
+    __m256i sums[GEMM_MICRO_M][2];
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      sums[i][0] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + i * ldc));
+      sums[i][1] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + i * ldc + 8));
+    }
+    for (int p = 0; p < k; p++) {
+      const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + p * ldb));
+      const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + p * ldb + 8));
+      for (int i = 0; i < GEMM_MICRO_M; i++) {
+        const __m256i ai = _mm256_set1_epi32(a[i * lda + p]);
+        sums[i][0] = _mm256_add_epi32(sums[i][0], _mm256_mullo_epi32(ai, b0));
+        sums[i][1] = _mm256_add_epi32(sums[i][1], _mm256_mullo_epi32(ai, b1));
+      }
+    }
+    for (int i = 0; i < GEMM_MICRO_M; i++) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(c + i * ldc), sums[i][0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(c + i * ldc + 8), sums[i][1]);
+    }
+  }
+};
+
+#endif
+
+/**
+ * Computes C += A * B on row-major matrices, A of m x k, B of k x n and C of m x n, with lda, ldb and ldc the strides
+ * of their rows. The innermost loop runs along the rows of B and C, at unit stride, for the compiler to vectorize.
+ */
+template <typename T>
+void GemmScalar(int m, int n, int k, const T *a, int lda, const T *b, int ldb, T *c, int ldc) {
+  for (int i = 0; i < m; i++) {
+    for (int p = 0; p < k; p++) {
+      const T aip = a[i * lda + p];
+      for (int j = 0; j < n; j++) {
+        c[i * ldc + j] += aip * b[p * ldb + j];
+      }
+    }
+  }
+}
+
+/** Computes a block of C += A * B as Gemm does, in micro-kernel tiles, the edges that do not fill one by GemmScalar. */
+template <typename T>
+void GemmBlock(int m, int n, int k, const T *a, int lda, const T *b, int ldb, T *c, int ldc) {
+  using Kernel = GemmMicroKernel<T>;
+  int j = 0;
+  if constexpr (Kernel::WIDTH > 0) {
+    for (; j + Kernel::WIDTH <= n; j += Kernel::WIDTH) {
+      int i = 0;
+      for (; i + GEMM_MICRO_M <= m; i += GEMM_MICRO_M) {
+        Kernel::Run(k, a + i * lda, lda, b + j, ldb, c + i * ldc + j, ldc);
+      }
+      GemmScalar(m - i, Kernel::WIDTH, k, a + i * lda, lda, b + j, ldb, c + i * ldc + j, ldc);
+    }
+  }
+  GemmScalar(m, n - j, k, a, lda, b + j, ldb, c + j, ldc);
+}
+
+/**
+ * Computes C += A * B on row-major matrices, A of m x k, B of k x n and C of m x n, block by block so that what a
+ * block is computed from stays in the caches: C is split in columns of GEMM_BLOCK_N, the depth in slices of
+ * GEMM_BLOCK_K, and the panel of B of a column and slice is reused by the blocks of GEMM_BLOCK_M rows of C in turn.
+ */
+template <typename T>
+void Gemm(int m, int n, int k, const T *a, const T *b, T *c) {
+  for (int jc = 0; jc < n; jc += GEMM_BLOCK_N) {
+    const int nc = std::min(GEMM_BLOCK_N, n - jc);
+    for (int pc = 0; pc < k; pc += GEMM_BLOCK_K) {
+      const int kc = std::min(GEMM_BLOCK_K, k - pc);
+      for (int ic = 0; ic < m; ic += GEMM_BLOCK_M) {
+        const int mc = std::min(GEMM_BLOCK_M, m - ic);
+        GemmBlock(mc, nc, kc, a + ic * k + pc, k, b + pc * n + jc, n, c + ic * n + jc, n);
+      }
+    }
+  }
+}
+
+/**
+ * Computes C += A * B as Gemm does, with the blocks of GEMM_BLOCK_M x GEMM_BLOCK_N of C, which are independent of each
+ * other, split across the workers of a thread pool. Each block is computed over the whole depth by one worker.
+ * @param thread_pool the workers, nullptr to compute the product on the calling thread, as for small products
+ */
+template <typename T>
+void GemmParallel(int m, int n, int k, const T *a, const T *b, T *c, ThreadPool *thread_pool) {
+  if (thread_pool == nullptr || thread_pool->Size() < 2 || int64_t{m} * n * k < GEMM_PARALLEL_MIN_OPS) {
+    Gemm(m, n, k, a, b, c);
+    return;
+  }
+  const int num_row_blocks = (m + GEMM_BLOCK_M - 1) / GEMM_BLOCK_M;
+  const int num_column_blocks = (n + GEMM_BLOCK_N - 1) / GEMM_BLOCK_N;
+  thread_pool->RunAll(num_row_blocks * num_column_blocks, [&](size_t block) {
+    const int ic = static_cast<int>(block / num_column_blocks) * GEMM_BLOCK_M;
+    const int jc = static_cast<int>(block % num_column_blocks) * GEMM_BLOCK_N;
+    const int mc = std::min(GEMM_BLOCK_M, m - ic);
+    const int nc = std::min(GEMM_BLOCK_N, n - jc);
+    for (int pc = 0; pc < k; pc += GEMM_BLOCK_K) {
+      const int kc = std::min(GEMM_BLOCK_K, k - pc);
+      GemmBlock(mc, nc, kc, a + ic * k + pc, k, b + pc * n + jc, n, c + ic * n + jc, n);
+    }
+  });
+}
+
+}  // namespace bustub
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <cstring>
 #include <memory>
 #include "common/logger.h"
+#include "primer/gemm.h"
 
 namespace bustub {
 
@@ -87,6 +89,9 @@ class RowMatrix : public Matrix<T> {
   // TODO(P0): Add implementation
   ~RowMatrix() override { delete[] data_; };
 
+  // Return the flattened array of the elements, row after row
+  T *GetData() { return this->linear; }
+
  private:
   // 2D array containing the elements of the matrix in row-major format
   // TODO(P0): Allocate the array of row pointers in the constructor. Use these pointers
@@ -102,55 +107,53 @@ class RowMatrixOperations {
   // Return nullptr if dimensions mismatch for input matrices.
   static std::unique_ptr<RowMatrix<T>> AddMatrices(std::unique_ptr<RowMatrix<T>> mat1,
                                                    std::unique_ptr<RowMatrix<T>> mat2) {
-    auto mat1_ptr = mat1.get();
-    auto mat2_ptr = mat2.get();
-
-    if (mat1_ptr->GetRows() != mat1_ptr->GetRows() || mat1_ptr->GetColumns() != mat2_ptr->GetColumns()) {
+    if (mat1->GetRows() != mat2->GetRows() || mat1->GetColumns() != mat2->GetColumns()) {
       return std::unique_ptr<RowMatrix<T>>(nullptr);
     }
 
-    std::unique_ptr<RowMatrix<int>> new_mat{new RowMatrix<T>(mat1_ptr->GetRows(), mat1_ptr->GetRows())};
-    for (int i = 0; i < mat1_ptr->GetRows(); i++) {
-      for (int j = 0; j < mat2_ptr->GetColumns(); j++) {
-        new_mat->SetElem(i, j, mat1_ptr->GetElem(i, j) + mat2_ptr->GetElem(i, j));
-      }
+    // The sum is added to mat1 in place, over the flattened arrays.
+    const int size = mat1->GetRows() * mat1->GetColumns();
+    T *sum = mat1->GetData();
+    const T *addend = mat2->GetData();
+    for (int i = 0; i < size; i++) {
+      sum[i] += addend[i];
     }
-
-    return new_mat;
+    return mat1;
   }
 
   // Compute matrix multiplication (mat1 * mat2) and return the result.
   // Return nullptr if dimensions mismatch for input matrices.
+  // The tiles of a large product are split across the workers of thread_pool, if not nullptr.
   static std::unique_ptr<RowMatrix<T>> MultiplyMatrices(std::unique_ptr<RowMatrix<T>> mat1,
-                                                        std::unique_ptr<RowMatrix<T>> mat2) {
-    // TODO(P0): Add code
-
-    auto mat1_ptr = mat1.get();
-    auto mat2_ptr = mat2.get();
-
-    if (mat1_ptr->GetColumns() != mat2_ptr->GetRows()) {
+                                                        std::unique_ptr<RowMatrix<T>> mat2,
+                                                        ThreadPool *thread_pool = nullptr) {
+    if (mat1->GetColumns() != mat2->GetRows()) {
       return std::unique_ptr<RowMatrix<T>>(nullptr);
     }
 
-    auto new_mat = new RowMatrix<T>(mat1_ptr->GetRows(), mat2_ptr->GetColumns());
-    for (int i = 0; i < mat1_ptr->GetRows(); i++) {
-      for (int j = 0; j < mat2_ptr->GetColumns(); j++) {
-        for (int p = 0; p < mat1_ptr->GetColumns(); p++) {
-          new_mat->SetElem(i, j, new_mat->GetElem(i, j) + mat1_ptr->GetElem(i, p) * mat2_ptr->GetElem(p, j));
-        }
-      }
-    }
-
-    return std::unique_ptr<RowMatrix<T>>{new_mat};
+    // The product accumulates into a zeroed matrix, see Gemm.
+    auto product = std::make_unique<RowMatrix<T>>(mat1->GetRows(), mat2->GetColumns());
+    GemmParallel(mat1->GetRows(), mat2->GetColumns(), mat1->GetColumns(), mat1->GetData(), mat2->GetData(),
+                 product->GetData(), thread_pool);
+    return product;
   }
 
   // Simplified GEMM (general matrix multiply) operation
   // Compute (matA * matB + matC). Return nullptr if dimensions mismatch for input matrices
+  // The tiles of a large product are split across the workers of thread_pool, if not nullptr.
   static std::unique_ptr<RowMatrix<T>> GemmMatrices(std::unique_ptr<RowMatrix<T>> matA,
                                                     std::unique_ptr<RowMatrix<T>> matB,
-                                                    std::unique_ptr<RowMatrix<T>> matC) {
-    // TODO(P0): Add code
-    return AddMatrices(MultiplyMatrices(matA, matB), matC);
+                                                    std::unique_ptr<RowMatrix<T>> matC,
+                                                    ThreadPool *thread_pool = nullptr) {
+    if (matA->GetColumns() != matB->GetRows() || matC->GetRows() != matA->GetRows() ||
+        matC->GetColumns() != matB->GetColumns()) {
+      return std::unique_ptr<RowMatrix<T>>(nullptr);
+    }
+
+    // The product is added to matC in place as it is computed, with no matrix in between.
+    GemmParallel(matA->GetRows(), matB->GetColumns(), matA->GetColumns(), matA->GetData(), matB->GetData(),
+                 matC->GetData(), thread_pool);
+    return matC;
   }
 };
 }  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// backup_manager.h
+//
+// Identification: src/include/recovery/backup_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+
+namespace bustub {
+
+/** Number of frames of the buffer ring a backup reads its pages through. */
+static constexpr size_t BACKUP_RING_SIZE = 16;
+
+/**
+ * BackupManager takes online backups of the db file, full or incremental, while the transactions keep running, and
+ * restores them.
+ *
+ * A backup starts with a fuzzy checkpoint, then copies pages through a buffer ring, each under its read latch, and
+ * last the log from the start the checkpoint kept, i.e. from the oldest record its redo or undo reads, to the end of
+ * the records persistent once the pages are copied. A full backup copies every page. An incremental one copies the
+ * pages changed since its base, the backup of the LSN it is given: those DiskManager::TakeChangedPages returns, if
+ * they were taken at that backup by this manager, and those dirty in the buffer pool; otherwise, e.g. after a restart,
+ * every page whose LSN is past the base, which misses the pages that are not logged, such as those of the indexes.
+ * The pages changed while they are copied are brought up to date by the log.
+ *
+ * A backup file holds a header, the pages, each after its page id, then the log:
+ *---------------------------------------------------------------------------------------------------------
+ * | magic | base_lsn | backup_lsn | num_pages | checkpoint_offset | log_offset | log_size | (page_id page)* | log |
+ *---------------------------------------------------------------------------------------------------------
+ * Restore writes the pages in place, replaces the log with the one of the backup, and redoes it from its checkpoint,
+ * without undoing the transactions it leaves running: those are rolled back by the recovery once the last backup is
+ * restored, a full one first, then each incremental one on the one of its base.
+ */
+class BackupManager {
+ public:
+  BackupManager(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+                CheckpointManager *checkpoint_manager)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        checkpoint_manager_(checkpoint_manager) {}
+
+  /**
+   * Takes a backup, with logging enabled, see the class comment.
+   * @param file_name the backup file, overwritten
+   * @param base_lsn the LSN of the backup this one is incremental to, INVALID_LSN for a full backup
+   * @param max_pages_per_second the most pages copied per second, 0 not to throttle the backup
+   * @return the LSN of the backup, the base of the next incremental one
+   * @throws Exception if the file can't be written, or a checkpoint truncated the log of the backup meanwhile
+   */
+  lsn_t Backup(const std::string &file_name, lsn_t base_lsn = INVALID_LSN, size_t max_pages_per_second = 0);
+
+  /** @return the number of pages the last backup copied */
+  size_t GetNumPagesCopied() const { return num_pages_copied_; }
+
+  /**
+   * Restores a backup onto a database not in use, to be reopened and recovered once the last backup is restored.
+   * @param file_name the backup file
+   * @param disk_manager the disk manager of the database
+   * @param buffer_pool_manager a buffer pool of the database holding none of its pages yet, the log is redone in and
+   * flushed on return
+   * @return the LSN of the backup
+   * @throws Exception if the file can't be read or is not a backup
+   */
+  static lsn_t Restore(const std::string &file_name, DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager);
+
+ private:
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  CheckpointManager *checkpoint_manager_;
+  /** The LSN of the last backup, at whose start the changed pages of the disk manager were taken. */
+  lsn_t changed_pages_lsn_{INVALID_LSN};
+  size_t num_pages_copied_{0};
+};
+
+}  // namespace bustub
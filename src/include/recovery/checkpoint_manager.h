@@ -19,7 +19,8 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily, or fuzzy ones
+ * while they keep running.
  */
 class CheckpointManager {
  public:
@@ -31,13 +32,34 @@ class CheckpointManager {
 
   ~CheckpointManager() = default;
 
+  /**
+   * Blocks the transactions, writes back every page and logs a checkpoint, see LogCheckpoint. The transactions stay
+   * blocked until EndCheckpoint.
+   */
   void BeginCheckpoint();
   void EndCheckpoint();
 
+  /**
+   * Takes a fuzzy checkpoint: logs the transaction table and the dirty page table while the transactions keep running,
+   * and writes no page. The pages dirty since before the checkpoint are left to the background writer, which writes
+   * them lazily, see BufferPoolManager::SetCheckpointLSN; recovery redoes and undoes from the log what the pages on
+   * disk miss or hold uncommitted, from the checkpoint record on, see LogCheckpoint.
+   */
+  void FuzzyCheckpoint();
+
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /**
+   * Logs a checkpoint record, with the transaction table and the dirty page table, and once it is persistent points
+   * the master record at the end of the log before it, where the analysis of the recovery starts. The tables are
+   * taken while the transactions run: the records appended meanwhile are past that offset, and the analysis reads
+   * them too.
+   * @return the LSN of the checkpoint record, INVALID_LSN if logging is disabled
+   */
+  lsn_t LogCheckpoint();
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
 };
 
 }  // namespace bustub
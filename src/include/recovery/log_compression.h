@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_compression.h
+//
+// Identification: src/include/recovery/log_compression.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/** The shortest match LogCompressor encodes. */
+static constexpr size_t LOG_MIN_MATCH = 4;
+
+/**
+ * LogCompressor compresses the large payloads of the log records, in a byte oriented LZ77 format after LZ4's block
+ * format, which is fast to compress and to decompress at the cost of the ratio.
+ *
+ * The compressed data is a series of sequences, each of a token byte, literals, then a match:
+ *  -------------------------------------------------------------------------------
+ *  | token (1) | [literal length](n) | literals | offset (2) | [match length](n) |
+ *  -------------------------------------------------------------------------------
+ * The high four bits of the token are the number of literals, and the low four ones the length of the match less
+ * LOG_MIN_MATCH; a nibble of 15 is followed by bytes added to it, up to one below 255. The match copies its length from
+ * offset bytes back in the output, possibly overlapping it. The last sequence only has literals.
+ */
+class LogCompressor {
+ public:
+  /**
+   * Compresses size bytes of src into dst.
+   * @return the size of the compressed data, or 0 if it does not fit in capacity bytes
+   */
+  static size_t Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+  /**
+   * Decompresses size bytes of compressed data of src into dst.
+   * @return the size of the decompressed data, or 0 if it is malformed or does not fit in capacity bytes
+   */
+  static size_t Decompress(const char *src, size_t size, char *dst, size_t capacity);
+};
+
+}  // namespace bustub
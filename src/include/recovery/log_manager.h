@@ -13,62 +13,328 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <future>              // NOLINT
-#include <mutex>               // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
 
+#include "common/memory_tracker.h"
+#include "common/metrics.h"
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 /**
- * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
- * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ * Where LogManager appends the log records:
+ * - SHARED: into one buffer shared by every thread, see the class comment;
+ * - PER_THREAD: into a private buffer of each thread, only latched against the flushes. The LSNs still come from one
+ *   atomic counter, and a flush merges the buffers in the order of the LSNs as it writes them.
+ */
+enum class LogBufferMode { SHARED, PER_THREAD };
+
+/** Number of shared log buffers: one is appended to while the flush thread has the writes of the others in flight. */
+static constexpr size_t LOG_NUM_BUFFERS = 4;
+/** How often the flush thread polls its writes in flight, while it watches for the next commits. */
+static constexpr std::chrono::microseconds LOG_POLL_INTERVAL{100};
+/** The size above which the body of a log record is compressed, when the log manager compresses them. */
+static constexpr size_t LOG_COMPRESSION_THRESHOLD = 256;
+
+/**
+ * LogManager maintains a separate thread that is awakened whenever the log buffer is full, a committing transaction
+ * waits for its log records, or a timeout happens. When the thread is awakened, the log buffer's content is written
+ * into the disk log file.
+ *
+ * Commits are grouped: the records are appended to one of the LOG_NUM_BUFFERS buffers while the flush thread writes
+ * the others, so every transaction that commits during a write has its commit record written, and is woken up, by a
+ * next one. The flush thread submits the writes asynchronously, through a log backend of the disk manager whose writes
+ * complete once on disk, and keeps several in flight; the persistent LSN advances over the writes completed in order.
+ * Without a flush thread, the waiting transactions and the appenders finding the buffer full write the log themselves.
+ *
+ * Appending takes no latch: an appender reserves the room of its record and its LSN at once with a compare-and-swap
+ * of reservation_, then copies the record in parallel with the others, and counts the bytes it copied in num_copied_.
+ * A flush stops the reservations in the buffer by switching them to the next one, and writes it once the bytes
+ * copied reach the end of the reserved ones.
+ *
+ * The log written is streamed to the subscribers, e.g. the senders to read replicas: each is handed the bytes of every
+ * write once they are on disk, whole records in the order of their LSNs, before the persistent LSN covers them.
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * Creates a new log manager.
+   * @param disk_manager the disk manager the log is written with
+   * @param buffer_mode whether the threads append to one shared buffer or to buffers of their own
+   * @param compress_payloads true to compress the bodies of the records larger than LOG_COMPRESSION_THRESHOLD
+   */
+  explicit LogManager(DiskManager *disk_manager, LogBufferMode buffer_mode = LogBufferMode::SHARED,
+                      bool compress_payloads = false)
+      : buffer_mode_(buffer_mode),
+        compress_payloads_(compress_payloads),
+        persistent_lsn_(INVALID_LSN),
+        disk_manager_(disk_manager) {
+    for (auto &buffer : buffers_) {
+      buffer = new char[LOG_BUFFER_SIZE];
+      MemoryTracker::Of(MemoryTag::LOG_BUFFERS)->Allocate(LOG_BUFFER_SIZE);
+    }
+    MetricsRegistry *registry = MetricsRegistry::Global();
+    registry->RegisterHistogram(this, "log.append_latency_ns", &metrics_.append_latency_ns_);
+    registry->RegisterHistogram(this, "log.flush_bytes", &metrics_.flush_bytes_);
+    registry->RegisterHistogram(this, "log.flush_records", &metrics_.flush_records_);
+    registry->RegisterHistogram(this, "log.write_latency_us", &metrics_.write_latency_us_);
+    registry->RegisterHistogram(this, "log.commit_latency_us", &metrics_.commit_latency_us_);
+    registry->RegisterCounter(this, "log.commit_waits", [this] { return GetNumCommitWaits(); });
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    MetricsRegistry::Global()->Unregister(this);
+    for (auto &buffer : buffers_) {
+      delete[] buffer;
+      MemoryTracker::Of(MemoryTag::LOG_BUFFERS)->Free(LOG_BUFFER_SIZE);
+      buffer = nullptr;
+    }
   }
 
+  /** Starts the flush thread and sets enable_logging. */
   void RunFlushThread();
+  /** Writes the log buffer, then stops and joins the flush thread, and clears enable_logging. */
   void StopFlushThread();
 
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  inline lsn_t GetNextLSN() { return NextLSNOf(reservation_); }
+
+  /**
+   * Makes the LSNs go on from those of the log written before, e.g. once the recovery has read it, as if the records
+   * up to lsn were persistent. Must be called before any record is appended.
+   * @param lsn the next LSN
+   */
+  void SetNextLSN(lsn_t lsn);
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
-  inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  inline void SetPersistentLSN(lsn_t lsn) {
+    {
+      std::scoped_lock latch(latch_);
+      persistent_lsn_ = lsn;
+    }
+    persistent_cv_.notify_all();
+  }
+
+  /**
+   * Blocks until the log records up to and including lsn are on disk. The LSN is registered for the next write of the
+   * flush thread, which wakes up every transaction waiting for an LSN it wrote at once.
+   * @param lsn the LSN to wait for
+   */
+  void WaitUntilPersistent(lsn_t lsn);
+  inline char *GetLogBuffer() { return buffers_[EpochOf(reservation_)]; }
+
+  /** @return the disk manager the log is written with */
+  inline DiskManager *GetDiskManager() { return disk_manager_; }
+
+  /** @return the number of commits that waited for a write of the log */
+  uint64_t GetNumCommitWaits() const { return num_commit_waits_; }
+
+  /** The histograms of a log manager. */
+  struct LogMetrics {
+    /** The time AppendLogRecord takes, in nanoseconds. */
+    Histogram append_latency_ns_;
+    /** The bytes of each write of the log. */
+    Histogram flush_bytes_;
+    /** The records of each write of the log, i.e. the size of the groups of commits. */
+    Histogram flush_records_;
+    /** The time each write of the log takes until it is on disk, its sync included, in microseconds. */
+    Histogram write_latency_us_;
+    /** The time from the append of a commit record until it is on disk, in microseconds, see RecordCommitLatency. */
+    Histogram commit_latency_us_;
+  };
+
+  /** @return the histograms of the log manager */
+  LogMetrics *GetMetrics() { return &metrics_; }
+
+  /**
+   * Records the time a commit waited for its record since appending it, once on disk, e.g. by the transaction manager.
+   * @param appended when the commit record was appended
+   */
+  void RecordCommitLatency(std::chrono::steady_clock::time_point appended) {
+    metrics_.commit_latency_us_.RecordSince(appended);
+  }
+
+  /**
+   * A subscriber of the log stream, called with the bytes of each write of the log once they are on disk. It runs on
+   * the writing thread, maybe under the latch of the log manager, and must not call back into it: it should copy the
+   * bytes and return.
+   */
+  using LogSubscriber = std::function<void(const char *data, size_t size)>;
+
+  /** Streams the log written from now on to a subscriber. @return the id to unsubscribe it with */
+  size_t Subscribe(LogSubscriber subscriber);
+
+  /** Stops streaming the log to a subscriber, which is no longer called once this returns. */
+  void Unsubscribe(size_t subscriber_id);
 
  private:
-  // TODO(students): you may add your own member variables
+  /**
+   * Switches the reservations to the next buffer, and writes the records appended to this one so far, with latch_
+   * released during the write. Caller must hold latch_, and no other write may be in progress.
+   */
+  void Flush(std::unique_lock<std::mutex> *latch);
+
+  /**
+   * Switches the reservations to the next buffer, and submits the write of the records appended to this one so far
+   * through backend, without waiting for it. Caller must hold latch_, and the next buffer must not be in flight.
+   */
+  void FlushAsync(std::unique_lock<std::mutex> *latch, DiskBackend *backend);
+
+  /**
+   * Switches the reservations to the next buffer, and records the bytes and records of the buffer switched from.
+   * @return the reservation word of the buffer switched from
+   */
+  uint64_t SwitchBuffer();
+
+  /** Waits until the appenders of the buffer of a reservation word switched from have copied their records. */
+  void WaitForCopies(uint64_t reservation);
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** The private log buffer of a thread, in PER_THREAD mode. */
+  struct ThreadLogBuffer {
+    ThreadLogBuffer() { MemoryTracker::Of(MemoryTag::LOG_BUFFERS)->Allocate(2 * LOG_BUFFER_SIZE); }
+    ~ThreadLogBuffer() { MemoryTracker::Of(MemoryTag::LOG_BUFFERS)->Free(2 * LOG_BUFFER_SIZE); }
+
+    /** Held by the thread while it appends, and by a flush while it takes the records out. */
+    std::mutex latch_;
+    /** The records appended since the last flush, in the order of their LSNs. */
+    std::unique_ptr<char[]> data_{new char[LOG_BUFFER_SIZE]};
+    size_t size_{0};
+    /** The records taken out by the current flush, swapped with data_. */
+    std::unique_ptr<char[]> taken_{new char[LOG_BUFFER_SIZE]};
+    size_t taken_size_{0};
+    /** The LSN of the last record the thread appended. */
+    lsn_t last_lsn_{INVALID_LSN};
+  };
+
+  /** Appends a log record to the buffer of the calling thread. @return its LSN */
+  lsn_t AppendToThreadBuffer(LogRecord *log_record);
+
+  /** @return the buffer of the calling thread, registered on its first append */
+  ThreadLogBuffer *GetThreadLogBuffer();
+
+  /**
+   * Takes the records of every thread buffer whose LSN is below the next LSN, and writes them merged in the order of
+   * their LSNs; see Flush. Caller must hold latch_, and no other write may be in progress.
+   */
+  void FlushThreadBuffers(std::unique_lock<std::mutex> *latch);
+
+  /** @return true if some appended log records are not on disk yet */
+  bool HasUnwritten() const { return NextLSNOf(reservation_) - 1 > persistent_lsn_; }
+
+  /** Writes size bytes of merged records from buffers_[merge_buffer_], and switches to the other buffer. */
+  void WriteMerged(size_t size);
+
+  /** @return the size of the serialized log record at data */
+  static size_t SizeAt(const char *data) {
+    int32_t size;
+    memcpy(&size, data, sizeof(int32_t));
+    return static_cast<size_t>(size);
+  }
+  /** @return the LSN of the serialized log record at data */
+  static lsn_t LSNAt(const char *data) {
+    lsn_t lsn;
+    memcpy(&lsn, data + sizeof(int32_t), sizeof(lsn_t));
+    return lsn;
+  }
+
+  /** Hands the bytes of a write of the log, on disk, to the subscribers. */
+  void Publish(const char *data, size_t size);
+
+  /** Waits, holding latch_, until the log records up to and including lsn are on disk, see WaitUntilPersistent. */
+  void AwaitPersistent(std::unique_lock<std::mutex> *latch, lsn_t lsn);
+
+  /**
+   * Compresses the body of a log record into its compressed_ bytes, and sets its size to theirs, if the body is larger
+   * than LOG_COMPRESSION_THRESHOLD and compresses.
+   */
+  void CompressLogRecord(LogRecord *log_record);
+
+  /** Serializes a log record, whose LSN is set, into data, which has room for GetSize() bytes. */
+  void SerializeLogRecord(LogRecord *log_record, char *data);
+
+  /** @return the buffer the records of a reservation word are appended to */
+  static size_t EpochOf(uint64_t reservation) { return reservation >> 62; }
+  /** @return the end of the records reserved in the buffer of a reservation word */
+  static size_t OffsetOf(uint64_t reservation) { return (reservation >> 32) & 0x3fffffff; }
+  /** @return the next log sequence number of a reservation word */
+  static lsn_t NextLSNOf(uint64_t reservation) { return static_cast<lsn_t>(reservation & 0xffffffff); }
+
+  const LogBufferMode buffer_mode_;
+  const bool compress_payloads_;
+
+  /**
+   * The reservation word: from the high bits, 2 bits of the buffer appended to, then 30 bits of the end of the records
+   * reserved in it, then 32 bits of the next log sequence number.
+   */
+  std::atomic<uint64_t> reservation_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
+  /** The buffers appended to and written by turns. */
+  char *buffers_[LOG_NUM_BUFFERS];
+  /** The number of bytes copied into each buffer since it was last written. */
+  std::atomic<size_t> num_copied_[LOG_NUM_BUFFERS]{};
+  /** In PER_THREAD mode, the buffer of buffers_ the merged records are written from next. */
+  size_t merge_buffer_{0};
+
+  /** The thread buffers, in PER_THREAD mode, registered by thread. */
+  std::unordered_map<std::thread::id, std::unique_ptr<ThreadLogBuffer>> thread_buffers_;
+  std::mutex thread_buffers_latch_;
+  /** Tells apart the log managers, for the buffer of the calling thread cached by GetThreadLogBuffer. */
+  const uint64_t instance_id_{next_instance_id++};
+  static std::atomic<uint64_t> next_instance_id;
+  /** The largest LSN a transaction waits for, to be written by the next flush. */
+  lsn_t flush_lsn_{INVALID_LSN};
+  /** The LSN of the last record handed to the disk manager. */
+  lsn_t submitted_lsn_{INVALID_LSN};
+  /** True while a flush takes and writes records, synchronously. */
+  bool flushing_{false};
+  /** True while the flush thread runs. */
+  bool running_{false};
+  /** A write submitted by FlushAsync: the buffer it is written from, the last LSN and the number of bytes in it. */
+  struct LogWrite {
+    size_t epoch_;
+    lsn_t last_lsn_;
+    size_t size_;
+    std::chrono::steady_clock::time_point submitted_;
+    bool done_;
+  };
+  /** The writes in flight, in the order of their LSNs. */
+  std::deque<LogWrite> writes_;
 
+  /** Guards the fields from flush_lsn_ on, the switches of the buffers and persistent_lsn_ transitions. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Notified, under latch_, whenever the persistent LSN advances or a write ends. */
+  std::condition_variable persistent_cv_;
+  /** Notified whenever the buffers are switched, to the appenders waiting for room. */
+  std::condition_variable append_cv_;
+
+  std::atomic<uint64_t> num_commit_waits_{0};
+  LogMetrics metrics_;
+
+  /** The subscribers of the log stream by id, and the id of the next one, guarded by subscribers_latch_. */
+  std::map<size_t, LogSubscriber> subscribers_;
+  size_t next_subscriber_id_{0};
+  /** Held while the subscribers are called, so that a subscriber is not called once unsubscribed. */
+  std::mutex subscribers_latch_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
@@ -14,8 +14,12 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/table/column_increment.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -32,15 +36,34 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** The whole image of a table page filled by a bulk insert. */
+  PAGEIMAGE,
+  /** An update logging only the byte ranges of the tuple that changed. */
+  DELTAUPDATE,
+  /** A compensation log record: the undo of a record by the recovery, which is never undone itself. */
+  CLR,
+  /** A fuzzy checkpoint, with the transaction table and the dirty page table the analysis starts from. */
+  CHECKPOINT,
+  /** An increment of integer columns of a tuple in place, undone by taking the increments out, see ColumnIncrement. */
+  INCREMENT,
+  /** The deletes a commit applied to tuples of one page at once, each undone as an APPLYDELETE. */
+  APPLYDELETES,
+  /** The whole image of an overflow page holding a chunk of a value stored out of line, see Toast; never undone. */
+  OVERFLOWPAGE,
 };
 
+/** Set in the LogType of a serialized record whose body is compressed, see LogRecord. */
+static constexpr int32_t LOG_COMPRESSED_FLAG = 0x100;
+
 /**
  * For every write operation on the table page, you should write ahead a corresponding log record.
  *
- * For EACH log record, HEADER is like (5 fields in common, 20 bytes in total).
- *---------------------------------------------
- * | size | LSN | transID | prevLSN | LogType |
- *---------------------------------------------
+ * For EACH log record, HEADER is like (6 fields in common, 24 bytes in total).
+ *--------------------------------------------------------
+ * | size | LSN | transID | prevLSN | LogType | checksum |
+ *--------------------------------------------------------
+ * the checksum being the CRC-32C of the serialized record but the checksum itself, which tells a torn record at the
+ * end of the log from a whole one, see SetChecksum.
  * For insert type log record
  *---------------------------------------------------------------
  * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
@@ -57,6 +80,39 @@ enum class LogRecordType {
  *--------------------------
  * | HEADER | prev_page_id |
  *--------------------------
+ * For page image type log record (including overflowpage)
+ *------------------------------------------
+ * | HEADER | page_id | page_data(PAGE_SIZE) |
+ *------------------------------------------
+ * For delta update type log record, with num_ranges ranges of the old tuple replaced in the new one
+ *--------------------------------------------------------------------------
+ * | HEADER | tuple_rid | old_tuple_size | new_tuple_size | num_ranges | ... |
+ *--------------------------------------------------------------------------
+ * each range being, from an offset in the old tuple
+ *--------------------------------------------------------------------
+ * | offset | old_length | new_length | old_bytes | new_bytes |
+ *--------------------------------------------------------------------
+ * For increment type log record, with num_increments increments of the columns at offsets in the tuple
+ *-------------------------------------------------------------------------
+ * | HEADER | tuple_rid | num_increments | (offset | type_id | amount)* |
+ *-------------------------------------------------------------------------
+ * For apply deletes type log record, with num_tuples tuples of the page page_id
+ *---------------------------------------------------------------------------------------
+ * | HEADER | page_id | num_tuples | (tuple_rid | tuple_size | tuple_data(char[] array))* |
+ *---------------------------------------------------------------------------------------
+ * For compensation type log record, with the undone record serialized whole and uncompressed
+ *-------------------------------------------------------
+ * | HEADER | undo_next_lsn | undone_record(char[] array) |
+ *-------------------------------------------------------
+ * For checkpoint type log record, the offsets being 8 bytes
+ *-----------------------------------------------------------------------------------------------------------
+ * | HEADER | redo_offset | undo_offset | num_txns | (txn_id | last_lsn)* | num_pages | (page_id | rec_lsn)* |
+ *-----------------------------------------------------------------------------------------------------------
+ * A record whose body, everything after the HEADER, is compressed by LogCompressor has LOG_COMPRESSED_FLAG set in its
+ * LogType, see LogManager:
+ *------------------------------------------------------
+ * | HEADER | body_size | compressed_body(char[] array) |
+ *------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -85,17 +141,46 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
   }
 
-  // constructor for UPDATE type
+  // constructor for UPDATE/DELTAUPDATE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
             const Tuple &old_tuple, const Tuple &new_tuple)
+      : txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type), update_rid_(update_rid) {
+    if (log_record_type == LogRecordType::DELTAUPDATE) {
+      // Only the ranges that changed, the tuples are not kept
+      EncodeDelta(old_tuple, new_tuple);
+      size_ = HEADER_SIZE + sizeof(RID) + delta_.size();
+      return;
+    }
+    assert(log_record_type == LogRecordType::UPDATE);
+    old_tuple_ = old_tuple;
+    new_tuple_ = new_tuple;
+    // calculate log record size
+    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+  }
+
+  // constructor for INCREMENT type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
+            const std::vector<ColumnIncrement> &increments)
       : txn_id_(txn_id),
         prev_lsn_(prev_lsn),
         log_record_type_(log_record_type),
         update_rid_(update_rid),
-        old_tuple_(old_tuple),
-        new_tuple_(new_tuple) {
-    // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+        increments_(increments) {
+    size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + increments.size() * INCREMENT_SIZE;
+  }
+
+  // constructor for APPLYDELETES type, the tuples being of the page
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t page_id,
+            std::vector<std::pair<RID, Tuple>> delete_tuples)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        page_id_(page_id),
+        delete_tuples_(std::move(delete_tuples)) {
+    size_ = HEADER_SIZE + sizeof(page_id_t) + sizeof(int32_t);
+    for (const auto &[rid, tuple] : delete_tuples_) {
+      size_ += sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+    }
   }
 
   // constructor for NEWPAGE type
@@ -110,12 +195,49 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for PAGEIMAGE/OVERFLOWPAGE type, the image must outlive the record
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t page_id, const char *page_image)
+      : size_(HEADER_SIZE + sizeof(page_id_t) + PAGE_SIZE),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        page_id_(page_id),
+        page_image_(page_image) {}
+
+  // constructor for CLR type, undoing the serialized record undone
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, lsn_t undo_next_lsn, const char *undone,
+            int32_t undone_size)
+      : size_(HEADER_SIZE + sizeof(lsn_t) + undone_size),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        undo_next_lsn_(undo_next_lsn),
+        undone_(undone, undone + undone_size) {}
+
+  // constructor for CHECKPOINT type
+  LogRecord(LogRecordType log_record_type, int64_t redo_offset, int64_t undo_offset,
+            const std::unordered_map<txn_id_t, lsn_t> &txn_table,
+            const std::unordered_map<page_id_t, lsn_t> &dirty_page_table)
+      : log_record_type_(log_record_type),
+        redo_offset_(redo_offset),
+        undo_offset_(undo_offset),
+        txn_table_(txn_table.begin(), txn_table.end()),
+        dirty_page_table_(dirty_page_table.begin(), dirty_page_table.end()) {
+    size_ = HEADER_SIZE + 2 * sizeof(int64_t) + 2 * sizeof(int32_t) +
+            (txn_table_.size() + dirty_page_table_.size()) * (sizeof(int32_t) + sizeof(lsn_t));
+  }
+
   ~LogRecord() = default;
 
   inline Tuple &GetDeleteTuple() { return delete_tuple_; }
 
   inline RID &GetDeleteRID() { return delete_rid_; }
 
+  /** @return the tuples an APPLYDELETES record deleted, of the page GetDeletePageId */
+  inline const std::vector<std::pair<RID, Tuple>> &GetDeleteTuples() { return delete_tuples_; }
+
+  inline page_id_t GetDeletePageId() { return page_id_; }
+
   inline Tuple &GetInsertTuple() { return insert_tuple_; }
 
   inline RID &GetInsertRID() { return insert_rid_; }
@@ -126,8 +248,59 @@ class LogRecord {
 
   inline RID &GetUpdateRID() { return update_rid_; }
 
+  /** @return the ranges of a DELTAUPDATE record, from old_tuple_size on */
+  inline const std::vector<char> &GetDelta() { return delta_; }
+
+  /**
+   * Rebuilds a tuple of a DELTAUPDATE record from the other one, replacing the ranges that changed.
+   * @param tuple the old tuple, or the new one if undo
+   * @param[out] result the new tuple, or the old one if undo
+   * @param undo true to rebuild the old tuple from the new one
+   * @return false if tuple is not of the size the record logged
+   */
+  bool ApplyDelta(const Tuple &tuple, Tuple *result, bool undo) const;
+
+  /** Sets the checksum in the header of a serialized record, that of all its bytes but the checksum. */
+  static void SetChecksum(char *data);
+
+  /** @return true if a serialized record, of the size in its header, matches the checksum in its header */
+  static bool VerifyChecksum(const char *data);
+
+  /**
+   * @return true if the size bytes at data start with a whole record of a log buffer at most, which matches its
+   * checksum, rather than with a torn record or the zeroes past the end of the log
+   */
+  static bool IsWholeRecord(const char *data, size_t size);
+
+  /** @return the increments of an INCREMENT record, of the tuple at GetUpdateRID */
+  inline const std::vector<ColumnIncrement> &GetIncrements() { return increments_; }
+
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline page_id_t GetNewPageId() { return page_id_; }
+
+  inline page_id_t GetPageImageId() { return page_id_; }
+
+  inline const char *GetPageImage() { return page_image_; }
+
+  /** @return the LSN of the next record of the transaction to undo after the one a CLR undid */
+  inline lsn_t GetUndoNextLSN() { return undo_next_lsn_; }
+
+  /** @return the record a CLR undid, serialized */
+  inline const std::vector<char> &GetUndoneRecord() { return undone_; }
+
+  /** @return the offset in the log file the redo starts at after a checkpoint, that of its oldest recovery LSN */
+  inline int64_t GetRedoOffset() { return redo_offset_; }
+
+  /** @return the offset in the log file the first records of the transactions active at a checkpoint are at or after */
+  inline int64_t GetUndoOffset() { return undo_offset_; }
+
+  /** @return the transactions active at a checkpoint, with the LSN of their last record */
+  inline const std::vector<std::pair<txn_id_t, lsn_t>> &GetTxnTable() { return txn_table_; }
+
+  /** @return the pages that were dirty at a checkpoint, with their recovery LSN */
+  inline const std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPageTable() { return dirty_page_table_; }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -159,6 +332,8 @@ class LogRecord {
   txn_id_t txn_id_{INVALID_TXN_ID};
   lsn_t prev_lsn_{INVALID_LSN};
   LogRecordType log_record_type_{LogRecordType::INVALID};
+  // set as the record is serialized, see SetChecksum
+  uint32_t checksum_{0};
 
   // case1: for delete operation, delete_tuple_ for UNDO operation
   RID delete_rid_;
@@ -176,7 +351,43 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
-  static const int HEADER_SIZE = 20;
+
+  // case5: for page image operation, with page_id_
+  const char *page_image_{nullptr};
+
+  // case6: for delta update operation, with update_rid_, serialized from old_tuple_size on
+  std::vector<char> delta_;
+
+  // case7: for compensation operation
+  lsn_t undo_next_lsn_{INVALID_LSN};
+  std::vector<char> undone_;
+
+  // case8: for checkpoint
+  int64_t redo_offset_{0};
+  int64_t undo_offset_{0};
+  std::vector<std::pair<txn_id_t, lsn_t>> txn_table_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table_;
+
+  // case9: for increment operation, with update_rid_
+  std::vector<ColumnIncrement> increments_;
+
+  // case10: for apply deletes operation, with page_id_
+  std::vector<std::pair<RID, Tuple>> delete_tuples_;
+
+  // the body_size and compressed body of the record, empty if the body is not compressed
+  std::vector<char> compressed_;
+
+  /** Fills delta_ with the ranges of old_tuple that changed in new_tuple. */
+  void EncodeDelta(const Tuple &old_tuple, const Tuple &new_tuple);
+
+  /** @return the CRC-32C of a serialized record, skipping the checksum in its header */
+  static uint32_t ComputeChecksum(const char *data);
+
+  static const int HEADER_SIZE = 24;
+  /** The offset of the checksum in the header, its last field. */
+  static const int CHECKSUM_OFFSET = 20;
+  /** The size of a serialized increment: its offset, type and amount. */
+  static const int INCREMENT_SIZE = 2 * sizeof(int32_t) + sizeof(int64_t);
 };  // namespace bustub
 
 }  // namespace bustub
@@ -13,45 +13,224 @@
 #pragma once
 
 #include <algorithm>
-#include <mutex>  // NOLINT
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/thread_pool.h"
 #include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
+class TablePage;
+
 /**
- * Read log file from disk, redo and undo.
+ * Read log file from disk, redo and undo, after ARIES.
+ *
+ * Analysis rebuilds the transaction table and the dirty page table from the last checkpoint the master record points
+ * at, or from the start of the log without one, reading the log up to its end.
+ *
+ * Redo then reads the log from the oldest record it may have to apply on: that of the oldest recovery LSN of the dirty
+ * pages, or of the first record of the transactions to undo. It hands the records of each page to the worker its page
+ * id hashes to, in batches of a log buffer of records: a worker applies the records of its pages in the order of their
+ * LSNs, skipping those older than the recovery LSN of the page or than its LSN, while the next batches are read. A
+ * record of two pages, NEWPAGE, goes to both workers, and each applies its own part.
+ *
+ * Undo rolls the transactions left active back, from their last record on down the prevLSN chains, in the reverse
+ * order of the LSNs across all of them. Every record undone is first logged as a CLR, which holds the record it undoes
+ * and the next record to undo, and is redone if the recovery starts over: a recovery that crashes goes on from the
+ * last CLR on, never undoing a record twice. A transaction rolled back ends with an ABORT record.
+ *
+ * UndoInBackground makes the database available right after Redo instead: each transaction to undo becomes a running
+ * transaction of the transaction manager again, holding the exclusive locks of the tuples it wrote, and a thread rolls
+ * them back, aborting each one, and so releasing its locks, once it is undone. The transactions reading or writing
+ * those tuples wait for their rollback on the locks; those reading a snapshot, or under a table lock only, take no
+ * lock and see the changes not undone yet.
+ *
+ * Redo and Undo work on TablePages: the records do not tell the format of their page. They run with enable_logging
+ * off, and so call the pages without transactions.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  /**
+   * Creates a new log recovery.
+   * @param disk_manager the disk manager the log is read with
+   * @param buffer_pool_manager the buffer pool the pages are redone in
+   * @param log_manager the log manager the CLRs are appended with, nullptr to undo without logging them
+   * @param num_redo_workers the number of threads Redo applies the records with
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager = nullptr,
+              size_t num_redo_workers = std::max(1U, std::thread::hardware_concurrency()))
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        num_redo_workers_(num_redo_workers),
+        offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogRecovery() {
+    WaitForUndo();
     delete[] log_buffer_;
     log_buffer_ = nullptr;
   }
 
+  /** Rebuilds the transaction table and the dirty page table, see the class comment. */
+  void Analysis();
+  /** Redoes the records since the oldest recovery LSN, after Analysis, which it runs first if it has not run. */
   void Redo();
+  /**
+   * Rolls back the transactions left active, after Redo. The LSNs of the log manager go on from those of the log, and
+   * the CLRs are persistent on return.
+   */
   void Undo();
-  bool DeserializeLogRecord(const char *data, LogRecord *log_record);
+
+  /**
+   * Rolls back the transactions left active in the background, after Redo, see the class comment. They hold the locks
+   * of their tuples on return, and the LSNs of the log manager and the transaction ids of txn_manager go on from those
+   * of the log. Must be called before any transaction begins or logs, with the logging of txn_manager enabled.
+   * @param txn_manager the transaction manager the transactions run in and are aborted with
+   * @param lock_manager the lock manager of txn_manager
+   */
+  void UndoInBackground(TransactionManager *txn_manager, LockManager *lock_manager);
+
+  /**
+   * Redoes whole serialized records, e.g. those a primary streams to a read replica, on every page older than them
+   * whatever the dirty page table, with the workers of Redo; the pages are write latched while a record is applied.
+   * @return the LSN of the last record, INVALID_LSN if there is none
+   */
+  lsn_t RedoRecords(const char *data, size_t size);
+
+  /** Waits until the rollback of UndoInBackground, if any, is done. */
+  void WaitForUndo() {
+    if (undo_thread_.joinable()) {
+      undo_thread_.join();
+    }
+  }
+
+  /**
+   * Deserializes a log record, decompressing its body if need be. The page image of a PAGEIMAGE or OVERFLOWPAGE record
+   * points into data, or into a buffer of the calling thread reused by its next call if the record is compressed.
+   * @param data the serialized record
+   * @param size the number of bytes available at data
+   * @return false if they do not hold a whole record
+   */
+  bool DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record);
+
+  /**
+   * @return the transactions without a COMMIT or ABORT record in the log after Analysis, with their last LSN; Undo
+   * rolls them back; not to be read while it runs in the background
+   */
+  const std::unordered_map<txn_id_t, lsn_t> &GetActiveTransactions() const { return active_txn_; }
+
+  /** @return the pages that may be older than the log after Analysis, with their recovery LSN */
+  const std::unordered_map<page_id_t, lsn_t> &GetDirtyPageTable() const { return dirty_page_table_; }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /**
+   * Reads the log from offset on, and calls visit on each whole record with its offset, then read_done, if any, once
+   * the records of a log buffer are visited. The log is mapped and its records visited in place, or else read a log
+   * buffer at a time. The scan ends at the first record that is torn, i.e. does not match its checksum.
+   */
+  void ScanLog(int offset, const std::function<void(const char *, int)> &visit,
+               const std::function<void()> &read_done = nullptr);
+
+  /** Notes a serialized record in the transaction table and the dirty page table. */
+  void AnalyzeLogRecord(const char *data);
+
+  /** Appends a serialized record, decompressed, to the batches of the workers of its pages that Redo applies it to. */
+  void DispatchLogRecord(const char *data, std::vector<std::vector<char>> *batches);
+
+  /** Applies the records of a batch to the pages of a worker, those whose id hashes to partition. */
+  void RedoBatch(const std::vector<char> &batch, size_t partition, size_t num_partitions);
+
+  /** Applies a record to its pages of a worker, those older than the record. */
+  void RedoLogRecord(LogRecord *log_record, size_t partition, size_t num_partitions);
+
+  /** Undoes the records of active_txn_, the latest first, and ends each transaction once all its records are undone. */
+  void UndoActiveTransactions();
+
+  /**
+   * Finds the tuples the records of a transaction to undo wrote, from its record of an LSN down its prevLSN chain.
+   * @param[out] rids the tuples
+   * @return the smallest offset in the log file of those records
+   */
+  int64_t GetWrittenTuples(lsn_t lsn, std::vector<RID> *rids);
+
+  /**
+   * Logs a CLR for a record of a transaction, then undoes the record on its page, under its write latch.
+   * @param log_record the record to undo
+   * @param serialized the record, serialized uncompressed
+   */
+  void UndoLogRecord(LogRecord *log_record, const std::vector<char> &serialized);
+
+  /** Reverts the change of a record, one of a table page, on that page. */
+  static void UndoChange(LogRecord *log_record, TablePage *page);
+
+  /** Reads the record of an LSN from the log, serialized uncompressed. @return false if it is not in the log */
+  bool ReadLogRecord(lsn_t lsn, std::vector<char> *serialized);
+
+  /**
+   * @return the body of a serialized record, decompressed into decompressed_ if need be, or nullptr if it does not
+   * decompress; body_size is set to its size
+   */
+  const char *GetBody(const char *data, size_t *body_size);
+
+  /** Appends a serialized record of a header and an uncompressed body to out. */
+  static void AppendLogRecord(const char *header, LogRecordType type, const char *body, size_t body_size,
+                              std::vector<char> *out);
+
+  /**
+   * Finds the pages a record of a type and an uncompressed body modifies, the second one for NEWPAGE only.
+   * @return false if the record modifies no page
+   */
+  static bool GetPageIds(LogRecordType type, const char *body, page_id_t page_ids[2]);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  const size_t num_redo_workers_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
+  /** The transactions with a COMMIT or ABORT record, which may still log the deletes they apply after it. */
+  std::unordered_set<txn_id_t> ended_txn_;
+  /** The pages that may be older than the log, with the LSN of the first record they may miss. */
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table_;
   /** Mapping the log sequence number to log file offset for undos. */
   std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** True once Analysis has run. */
+  bool analyzed_{false};
+  /** The offset in the log file Redo starts at. */
+  int redo_offset_{0};
+  /** The LSN after the last one of the log. */
+  lsn_t next_lsn_{0};
+  /** The transaction id after the largest one of the log. */
+  txn_id_t next_txn_id_{0};
+
+  /** The transaction manager of UndoInBackground, and the transactions it rolls back in it, by id. */
+  TransactionManager *txn_manager_{nullptr};
+  std::unordered_map<txn_id_t, std::unique_ptr<Transaction>> loser_txns_;
+  /** The thread of UndoInBackground. */
+  std::thread undo_thread_;
+  /** The workers of RedoRecords, kept across its calls. */
+  std::unique_ptr<ThreadPool> redo_pool_;
+  /** True once RedoRecords applies the records to every page, not only to those of the dirty page table. */
+  bool redo_all_pages_{false};
 
-  int offset_ __attribute__((__unused__));
+  /** The offset in the log file of log_buffer_. */
+  int offset_;
   char *log_buffer_;
+  /** The body of the last compressed record GetBody read. */
+  std::vector<char> decompressed_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_replica.h
+//
+// Identification: src/include/recovery/log_replica.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "recovery/log_recovery.h"
+
+namespace bustub {
+
+/**
+ * LogReplica keeps the pages of a read replica, a buffer pool of their own, up to date with the log of a primary, fed
+ * by Receive, e.g. from a subscriber of the primary's LogManager. A thread applies the records received so far with
+ * the parallel redo of LogRecovery, and then advances the applied LSN.
+ *
+ * The read-only queries on the replica run between BeginRead and EndRead, which keep the records from being applied
+ * meanwhile: they see the pages as of the applied LSN BeginRead returns, the changes of the transactions running on
+ * the primary then included. Only the table pages are replicated, not the catalog: the tables are opened on the
+ * replica by their first page id.
+ */
+class LogReplica {
+ public:
+  /**
+   * Creates a replica and starts applying the records it receives.
+   * @param disk_manager the disk manager of the replica's database file
+   * @param buffer_pool_manager the buffer pool of the replica the records are applied in
+   * @param num_redo_workers the number of threads the records are applied with
+   */
+  LogReplica(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager,
+             size_t num_redo_workers = std::max(1U, std::thread::hardware_concurrency()));
+
+  /** Stops applying, once the records received are applied. */
+  ~LogReplica();
+
+  /**
+   * Queues bytes of the primary's log to apply, in the order it wrote them; a record may span two calls.
+   * @param data the bytes, copied before returning
+   * @param size the number of bytes
+   */
+  void Receive(const char *data, size_t size);
+
+  /** @return the LSN of the last record applied, INVALID_LSN if none was */
+  lsn_t GetAppliedLSN() {
+    std::scoped_lock latch(latch_);
+    return applied_lsn_;
+  }
+
+  /** Blocks until the records up to and including lsn are applied. */
+  void WaitUntilApplied(lsn_t lsn);
+
+  /**
+   * Starts a read-only query: no record is applied until EndRead.
+   * @return the LSN of the last record the pages read reflect
+   */
+  lsn_t BeginRead() {
+    apply_latch_.RLock();
+    return GetAppliedLSN();
+  }
+
+  /** Ends a read-only query started with BeginRead. */
+  void EndRead() { apply_latch_.RUnlock(); }
+
+ private:
+  /** Applies the records received, until the replica is destroyed. */
+  void RunApply();
+
+  LogRecovery log_recovery_;
+  /** The bytes received and not applied yet; guarded by latch_. */
+  std::vector<char> received_;
+  lsn_t applied_lsn_{INVALID_LSN};
+  bool running_{true};
+  std::mutex latch_;
+  /** Notified when bytes are received, or the replica stops. */
+  std::condition_variable received_cv_;
+  /** Notified when the applied LSN advances. */
+  std::condition_variable applied_cv_;
+  /** Write latched while records are applied, read latched by the queries. */
+  ReaderWriterLatch apply_latch_;
+  std::thread apply_thread_;
+};
+
+}  // namespace bustub
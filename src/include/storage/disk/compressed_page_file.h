@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_file.h
+//
+// Identification: src/include/storage/disk/compressed_page_file.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The unit the slots of a CompressedPageFile are sized and placed in. */
+static constexpr size_t COMPRESSED_SLOT_UNIT = 512;
+/** Number of slots freed by rewrites that a CompressedPageFile lets pile up before it syncs to reuse them. */
+static constexpr size_t COMPRESSED_FREE_BATCH = 256;
+
+/**
+ * CompressedPageFile stores the pages of a database compressed, see DiskManager's enable_compression, so that the
+ * file takes less room on disk and a read transfers fewer bytes.
+ *
+ * Each page is compressed with LogCompressor on its way to disk, and stored in a slot of as many COMPRESSED_SLOT_UNITs
+ * as it takes, up to a whole page for one that does not compress. The slots are variable-size and located through the
+ * page map, a sidecar file of one entry per page, the unit the slot starts at and the size of the data, cached in
+ * memory. A page rewritten goes to a free slot of its new size, or to the end of the file, never over its old slot,
+ * whose page stays readable until the map entry of the new one is written. The old slot is freed once both files are
+ * synced, so that a crash before leaves no map entry pointing at a slot reused since; reopened, the gaps between the
+ * slots of the map are the free slots.
+ *
+ * Behind the buffer pool, the file can keep the compressed images of the pages last read and written in memory, a tier
+ * of compressed frames of SetCacheSize bytes: a miss of the buffer pool on a page evicted not long ago is then
+ * decompressed from there instead of read from disk. It holds several pages in the room of a frame, so more of the
+ * working set stays in memory; the pages that do not compress are left out of it.
+ *
+ * Thread safe; the reads only wait for the updates of the map in memory, and for Sync to free slots.
+ */
+class CompressedPageFile {
+ public:
+  /**
+   * Opens the files, emptying them if the database is new.
+   * @param data_file the file of the slots
+   * @param map_file the page map
+   * @param is_new true if the database is new
+   * @throws Exception if a file can't be opened or read
+   */
+  CompressedPageFile(const std::string &data_file, const std::string &map_file, bool is_new);
+
+  /** Closes the files, after a Sync. */
+  ~CompressedPageFile();
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageFile);
+
+  /** Compresses a page, PAGE_SIZE bytes, into a slot of its size. */
+  void Write(page_id_t page_id, const char *page_data);
+
+  /**
+   * Reads a page back, decompressed.
+   * @param[out] page_data PAGE_SIZE bytes, zeroed if the page was never written
+   * @return false if the page was never written, or its slot could not be read or decompressed
+   */
+  bool Read(page_id_t page_id, char *page_data);
+
+  /** Syncs both files, then frees the slots of the pages rewritten before. */
+  void Sync();
+
+  /** @return the number of pages in the page map, one past the last page written */
+  page_id_t GetNumPages();
+
+  /** @return the number of bytes of the slots in use */
+  size_t GetStoredBytes();
+
+  /**
+   * Sizes the tier of compressed frames, evicting the least recently used ones past the new size.
+   * @param cache_bytes the bytes of compressed pages kept in memory, 0 for none
+   */
+  void SetCacheSize(size_t cache_bytes);
+
+  /** @return the number of reads served by the compressed frames */
+  size_t GetNumCacheHits();
+
+ private:
+  /** The place of a page, as stored in the page map; a size of 0 for none, of PAGE_SIZE for a page stored as is. */
+  struct MapEntry {
+    uint32_t unit_;
+    uint32_t size_;
+  };
+
+  /** @return the number of units of a slot of size bytes */
+  static uint32_t UnitsOf(uint32_t size) {
+    return static_cast<uint32_t>((size + COMPRESSED_SLOT_UNIT - 1) / COMPRESSED_SLOT_UNIT);
+  }
+
+  /** @return the first unit of a free slot of num_units units. Caller must hold latch_. */
+  uint32_t AllocateSlot(uint32_t num_units);
+
+  /** Syncs both files, then frees the pending slots. Caller must hold latch_. */
+  void SyncLocked();
+
+  /**
+   * Keeps the compressed image of a page as its most recently used frame, or forgets the page's frame if size is
+   * PAGE_SIZE. Caller must hold slots_latch_, so that a read does not cache an image older than a write's.
+   */
+  void CachePut(page_id_t page_id, const char *data, uint32_t size);
+
+  /** Evicts the least recently used frames until they fit cache_bytes_. Caller must hold cache_latch_. */
+  void TrimCache();
+
+  /** A compressed frame, with its place in cache_lru_. */
+  struct CachedPage {
+    std::string data_;
+    std::list<page_id_t>::iterator lru_;
+  };
+
+  int data_fd_{-1};
+  int map_fd_{-1};
+  /** Protects everything below; taken before slots_latch_. */
+  std::mutex latch_;
+  /** Held shared by the reads of the map and the slots, exclusive while the map changes or slots are freed. */
+  std::shared_mutex slots_latch_;
+  std::vector<MapEntry> map_;
+  /** The first units of the free slots of i + 1 units. */
+  std::vector<std::vector<uint32_t>> free_slots_;
+  /** The slots of the pages rewritten since the last sync, as (first unit, units). */
+  std::vector<std::pair<uint32_t, uint32_t>> pending_slots_;
+  /** One past the last unit of the file. */
+  uint32_t end_unit_{0};
+  size_t stored_units_{0};
+  /** Protects the compressed frames below; taken after slots_latch_. */
+  std::mutex cache_latch_;
+  std::unordered_map<page_id_t, CachedPage> cache_;
+  /** The pages of the compressed frames, most recently used first. */
+  std::list<page_id_t> cache_lru_;
+  size_t cache_bytes_{0};
+  size_t cached_bytes_{0};
+  size_t num_cache_hits_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_backend.h
+//
+// Identification: src/include/storage/disk/disk_backend.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The implementations a DiskBackend can be created with. */
+enum class DiskBackendType { POSIX, IO_URING };
+
+/**
+ * DiskRequest is a single read or write handed to a DiskBackend.
+ */
+struct DiskRequest {
+  enum class Type { READ, WRITE };
+
+  /** Whether to read into or write out of data_. */
+  Type type_;
+  /** Byte offset in the file. */
+  int64_t offset_;
+  /** Number of bytes to transfer. */
+  uint32_t size_;
+  /** The caller's buffer, which must stay valid until the callback has run. */
+  char *data_;
+  /**
+   * Invoked exactly once when the request completes, with true on success. Reads past the end of the file succeed and
+   * zero the rest of the buffer, like DiskManager::ReadPage does.
+   */
+  std::function<void(bool)> callback_;
+
+  /** @return a request that reads the given page into page_data */
+  static DiskRequest ReadPage(page_id_t page_id, char *page_data, std::function<void(bool)> callback) {
+    return {Type::READ, static_cast<int64_t>(page_id) * PAGE_SIZE, PAGE_SIZE, page_data, std::move(callback)};
+  }
+
+  /** @return a request that writes page_data to the given page */
+  static DiskRequest WritePage(page_id_t page_id, const char *page_data, std::function<void(bool)> callback) {
+    return {Type::WRITE, static_cast<int64_t>(page_id) * PAGE_SIZE, PAGE_SIZE, const_cast<char *>(page_data),
+            std::move(callback)};
+  }
+};
+
+/**
+ * DiskBackend performs batches of reads and writes on one file and reports their completion through callbacks.
+ * A backend is not thread-safe: every thread that issues I/O should own its own, the way the buffer pool's prefetch
+ * thread does. Callbacks run on the thread that calls Submit or Wait.
+ *
+ * When the file is opened for direct I/O, offsets and sizes must be multiples of PAGE_SIZE. Buffers that are not
+ * PAGE_SIZE aligned are transparently copied through an aligned bounce buffer.
+ */
+class DiskBackend {
+ public:
+  virtual ~DiskBackend() = default;
+
+  /**
+   * Issues the requests, as few system calls as the backend allows. Completed requests may have their callbacks
+   * invoked before Submit returns.
+   * @param requests the requests to issue; they are moved from
+   */
+  virtual void Submit(std::vector<DiskRequest> *requests) = 0;
+
+  /**
+   * Blocks until every submitted request has completed and its callback has run.
+   */
+  virtual void Wait() = 0;
+
+  /**
+   * Blocks until at least one submitted request has completed, unless none is in flight, and runs the callbacks of
+   * the completed ones.
+   */
+  virtual void WaitAny() = 0;
+
+  /** Runs the callbacks of the submitted requests that have completed, without blocking. */
+  virtual void Poll() = 0;
+
+  /**
+   * Creates a backend over the given file.
+   * @param type the implementation to use; IO_URING falls back to POSIX where io_uring is unavailable
+   * @param file_name the file to open, which must exist
+   * @param direct_io true to bypass the operating system's page cache (O_DIRECT)
+   * @param sync_writes true to complete the writes only once their data is on the device (O_DSYNC)
+   * @return the backend, or nullptr if the file could not be opened
+   */
+  static std::unique_ptr<DiskBackend> Create(DiskBackendType type, const std::string &file_name,
+                                             bool direct_io = false, bool sync_writes = false);
+
+ protected:
+  /**
+   * @param request the request about to be issued
+   * @param direct_io whether the file was opened with O_DIRECT
+   * @return a PAGE_SIZE aligned copy of the request's buffer, to be passed to Complete; nullptr if none is needed
+   */
+  static char *BounceBuffer(const DiskRequest &request, bool direct_io);
+
+  /**
+   * Finishes a request: zero-fills a short read, copies a bounced read back, releases the bounce buffer and invokes
+   * the callback.
+   * @param request the completed request
+   * @param bounce_buffer the value returned by BounceBuffer
+   * @param result number of bytes transferred, or a negative errno
+   */
+  static void Complete(DiskRequest *request, char *bounce_buffer, int64_t result);
+};
+
+/**
+ * PosixDiskBackend runs every request synchronously with pread/pwrite, running its callback before Submit returns.
+ */
+class PosixDiskBackend : public DiskBackend {
+ public:
+  /**
+   * @param fd the file to operate on, owned by the backend from now on
+   * @param direct_io whether fd was opened with O_DIRECT
+   */
+  PosixDiskBackend(int fd, bool direct_io);
+
+  ~PosixDiskBackend() override;
+
+  void Submit(std::vector<DiskRequest> *requests) override;
+
+  void Wait() override {}
+
+  void WaitAny() override {}
+
+  void Poll() override {}
+
+ private:
+  int fd_;
+  bool direct_io_;
+};
+
+/**
+ * SegmentedDiskBackend performs the requests on a series of files of segment_size bytes each as if they were one
+ * file, the way the log is kept in segments, through a backend on each file. A request that crosses the end of a file
+ * is split, and its callback runs once every part has completed. The backends of the files before the one of the
+ * latest request are closed once they have nothing in flight, so that the files can be renamed or removed.
+ */
+class SegmentedDiskBackend : public DiskBackend {
+ public:
+  /**
+   * @param type the implementation of the backends on the files
+   * @param segment_name maps the number of a segment, its offset divided by segment_size, to the name of its file
+   * @param segment_size the size of every file but the last
+   * @param sync_writes true to complete the writes only once their data is on the device (O_DSYNC)
+   */
+  SegmentedDiskBackend(DiskBackendType type, std::function<std::string(int64_t)> segment_name, int64_t segment_size,
+                       bool sync_writes)
+      : type_(type), segment_name_(std::move(segment_name)), segment_size_(segment_size), sync_writes_(sync_writes) {}
+
+  void Submit(std::vector<DiskRequest> *requests) override;
+
+  void Wait() override;
+
+  void WaitAny() override;
+
+  void Poll() override;
+
+ private:
+  /** The backend on the file of a segment, and the number of its requests in flight. */
+  struct Segment {
+    std::unique_ptr<DiskBackend> backend_;
+    size_t num_in_flight_{0};
+  };
+
+  const DiskBackendType type_;
+  const std::function<std::string(int64_t)> segment_name_;
+  const int64_t segment_size_;
+  const bool sync_writes_;
+  /** The segments requests were submitted to, by number. */
+  std::map<int64_t, Segment> segments_;
+  /** The number of parts of requests completed so far, for WaitAny. */
+  size_t num_completed_{0};
+};
+
+/**
+ * StripedDiskBackend performs page requests on several files, the way a DiskManager spreads the extents of its
+ * tablespaces, through a backend on each file. Every request goes to the file and offset that locate maps its offset
+ * to, so a request must not cross the boundary of a stripe, e.g. an extent; page requests never do.
+ */
+class StripedDiskBackend : public DiskBackend {
+ public:
+  /**
+   * @param type the implementation of the backends on the files
+   * @param direct_io true to open the files with O_DIRECT
+   * @param file_name maps the number of a file to its name
+   * @param locate maps the offset of a request to the number of its file, and returns its offset in that file
+   */
+  StripedDiskBackend(DiskBackendType type, bool direct_io, std::function<std::string(size_t)> file_name,
+                     std::function<int64_t(int64_t, size_t *)> locate)
+      : type_(type), direct_io_(direct_io), file_name_(std::move(file_name)), locate_(std::move(locate)) {}
+
+  void Submit(std::vector<DiskRequest> *requests) override;
+
+  void Wait() override;
+
+  void WaitAny() override;
+
+  void Poll() override;
+
+ private:
+  /** The backend on a file, and the number of its requests in flight. */
+  struct File {
+    std::unique_ptr<DiskBackend> backend_;
+    size_t num_in_flight_{0};
+  };
+
+  const DiskBackendType type_;
+  const bool direct_io_;
+  const std::function<std::string(size_t)> file_name_;
+  const std::function<int64_t(int64_t, size_t *)> locate_;
+  /** The files requests were submitted to, by number, opened on first use. */
+  std::map<size_t, File> files_;
+  /** The number of requests completed so far, for WaitAny. */
+  size_t num_completed_{0};
+};
+
+}  // namespace bustub
@@ -14,26 +14,131 @@
 
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/compressed_page_file.h"
+#include "storage/disk/disk_backend.h"
 
 namespace bustub {
 
+/** Number of pages in an extent, i.e. one word of the free space map. */
+static constexpr size_t EXTENT_SIZE = 64;
+
+/** Default size of a segment file of the log. */
+static constexpr int64_t LOG_SEGMENT_SIZE = 16 << 20;
+/** Number of segment files of the log kept past its end to be written next, recycled from the truncated ones. */
+static constexpr size_t LOG_NUM_SPARE_SEGMENTS = 2;
+/** Number of pages the double-write file holds, i.e. the largest batch WritePages writes in place at once. */
+static constexpr size_t DOUBLE_WRITE_BATCH_SIZE = 64;
+/** Largest number of adjacent pages WritePages writes in place with one system call. */
+static constexpr size_t MAX_COALESCED_WRITE = 64;
+/** Number of pages the blocks of the db file are allocated by ahead of its growth, see DiskManager::AllocatePage. */
+static constexpr size_t PREALLOCATE_SIZE = 16 * EXTENT_SIZE;
+
+/** Identifies a tablespace of a DiskManager, see DiskManager::CreateTablespace. */
+using tablespace_id_t = uint32_t;
+/** The tablespace of the db file itself, which holds every page not allocated in another one. */
+static constexpr tablespace_id_t DEFAULT_TABLESPACE = 0;
+
+/** How the pages of a mapped database file are going to be read, see DiskManager::MapFile. */
+enum class MapAdvice {
+  /** In any order, left to the kernel's default read ahead. */
+  NORMAL,
+  /** Mostly in order, as by scans; the kernel reads further ahead and drops the pages read sooner. */
+  SEQUENTIAL,
+  /** All of them soon; the kernel starts reading the whole file in. */
+  WILLNEED
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional pread/pwrite on a plain file descriptor, so there is no shared file
+ * position and any number of threads (e.g. the instances of a parallel buffer pool) can do page I/O concurrently.
+ *
+ * With checksums enabled, the CRC-32C of every page written is recorded, and a page read back that does not match
+ * raises a ChecksumException, e.g. after a torn write. Page layouts use all of the page (the header page starts its
+ * records at offset 0 and hash table block pages have no header at all), so the checksums are kept in a sidecar file
+ * next to the log, 4 bytes per page, and cached in memory so that verifying a read costs no extra I/O.
+ *
+ * The log is kept in segment files of log_segment_size bytes, <name>.log then <name>.log.1, <name>.log.2 and so on,
+ * addressed by one offset running across them. The blocks of a segment are allocated when it is created, and the
+ * next one is prepared once the writes are halfway through the current one, so that the synced appends update no
+ * file metadata. TruncateLog recycles the segments before a checkpoint's start of recovery: their files are renamed
+ * to the segments after the last one and emptied, to be written again.
+ *
+ * With the double-write buffer enabled, no write in place is left torn by a crash. The pages are written in batches of
+ * up to DOUBLE_WRITE_BATCH_SIZE: first together to a sidecar file, <name>.dwb, after a header of their ids and a
+ * checksum, with one sync, then in place, and the db file is synced before the next batch reuses the sidecar. Opening
+ * the db file writes the pages of a whole batch found in the sidecar in place again, which completes the batch a
+ * crash interrupted; a batch torn in the sidecar itself fails its checksum and is ignored, its pages were not touched
+ * yet. Every page write pays two syncs, which WritePages shares across its batch.
+ *
+ * Pages can also live in tablespaces, each a set of data files, e.g. one per device, created by CreateTablespace.
+ * A tablespace owns whole extents, striped across its files: its n-th extent is stored in file n % num_files, as
+ * extent n / num_files of that file, so that a large table in a tablespace of several devices reads from all of them.
+ * A page id still names one page across all the files, and the free space map, the checksums and the double-write
+ * buffer know nothing of tablespaces. A new object starts in the tablespace of the TablespaceScope its first page is
+ * allocated in, and the extents of an owner are allocated in the tablespace of its first page. The tablespaces are
+ * listed in <name>.tbs and the tablespace of every extent is kept in <name>.tsm; the pages of the default tablespace
+ * stay at their own offset in the db file.
+ *
+ * With compression enabled, the pages are not stored in the db file but compressed in <name>.cpf, in slots located
+ * through the page map <name>.cpm, see CompressedPageFile, so that the database takes less room on disk and a page read
+ * transfers fewer bytes, for the CPU time of compressing and decompressing it. Every page read and written goes through
+ * ReadPage and WritePage then: there are no tablespaces, MapFile does not map anything, and CreateDiskBackend hands out
+ * no backend. The checksums and the double-write buffer cover the pages as they are before compression.
  */
 class DiskManager {
  public:
+  /**
+   * Makes the pages the calling thread allocates without an owner, such as the first pages of the objects it creates,
+   * come from the extents of a tablespace for as long as the scope lives. An owner's pages follow its first page.
+   */
+  class TablespaceScope {
+   public:
+    /** @param tablespace the tablespace, ignored by the disk managers that do not have it */
+    explicit TablespaceScope(tablespace_id_t tablespace) : saved_(current_tablespace_) {
+      current_tablespace_ = tablespace;
+    }
+
+    ~TablespaceScope() { current_tablespace_ = saved_; }
+
+    DISALLOW_COPY_AND_MOVE(TablespaceScope);
+
+   private:
+    const tablespace_id_t saved_;
+  };
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param backend_type the implementation of the backends handed out by CreateDiskBackend
+   * @param direct_io true to open those backends with O_DIRECT
+   * @param enable_checksums true to checksum every page written and verify it when the page is read back
+   * @param log_segment_size the size of the segment files of the log
+   * @param enable_double_write true to write the pages through the double-write buffer, see the class comment
+   * @param enable_compression true to store the pages compressed, see the class comment; a database is always opened
+   * the way it was created
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskBackendType backend_type = DiskBackendType::IO_URING,
+                       bool direct_io = false, bool enable_checksums = false,
+                       int64_t log_segment_size = LOG_SEGMENT_SIZE, bool enable_double_write = false,
+                       bool enable_compression = false);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -47,13 +152,92 @@ class DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Writes pages to the database file, in batches through the double-write buffer if it is enabled. The pages are
+   * written in the order of their ids, runs of adjacent ones with one vectored write.
+   * @param pages the ids of the pages with their raw data, the last one counting for a page given twice
+   */
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws ChecksumException if checksums are enabled and the page does not match its checksum
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Maps the database file read-only, so that ReadPage copies pages out of the mapping rather than making a system
+   * call. Meant for read-only deployments: writes still go through the file, and are seen through the mapping, but
+   * the pages past the end of the file when it was mapped are read with system calls as before. Call it before the
+   * disk manager is used; ShutDown unmaps the file.
+   * @param advice how the pages are going to be read, passed on to the kernel
+   * @return false if the file is empty, there are tablespaces, the pages are compressed, or the file could not be
+   * mapped
+   */
+  bool MapFile(MapAdvice advice = MapAdvice::SEQUENTIAL);
+
+  /**
+   * Creates a tablespace over data files, whose extents are striped across them, see the class comment. Once created,
+   * the tablespace is opened with the db file; creating it again returns it.
+   * @param name the name of the tablespace, without tabs or newlines
+   * @param files the data files of the tablespace, e.g. one on each device; new ones are emptied
+   * @return the tablespace, to be used in a TablespaceScope
+   * @throws Exception if a tablespace of that name has other files, a file can't be opened, or the pages are
+   * compressed
+   */
+  tablespace_id_t CreateTablespace(const std::string &name, const std::vector<std::string> &files);
+
+  /**
+   * @param page_id id of the page
+   * @return the tablespace the extent of the page belongs to, DEFAULT_TABLESPACE unless it was allocated to another
+   */
+  tablespace_id_t GetPageTablespace(page_id_t page_id);
+
+  /**
+   * @param page_id id of the page
+   * @param[out] offset the offset of the page in its file
+   * @return the name of the file the page is stored in
+   */
+  std::string GetPageFile(page_id_t page_id, int64_t *offset);
+
+  /**
+   * @param page_id id of the page
+   * @return the page in the mapping of MapFile, to be read in place and not kept past ShutDown; nullptr if the file
+   * is not mapped or the page is past the mapping
+   */
+  const char *GetMappedPage(page_id_t page_id) const {
+    const auto offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+    return page_id >= 0 && offset + PAGE_SIZE <= mapping_size_ ? mapping_ + offset : nullptr;
+  }
+
+  /**
+   * Verifies a page that was read without ReadPage, e.g. through a DiskBackend. Counts failures like ReadPage does.
+   * @param page_id id of the page
+   * @param page_data the page as read from disk
+   * @return true if checksums are disabled, or no checksum was recorded for the page, or the page matches it
+   */
+  bool VerifyPageChecksum(page_id_t page_id, const char *page_data);
+
+  /**
+   * Creates a backend for batched, asynchronous page I/O on the database file. Every I/O thread should create its own.
+   * @return the backend, or nullptr if the pages are compressed, to be read with ReadPage
+   */
+  std::unique_ptr<DiskBackend> CreateDiskBackend() {
+    if (compressed_ != nullptr) {
+      return nullptr;
+    }
+    // Tablespaces may be created after the backend, which has to route their pages too.
+    return std::make_unique<StripedDiskBackend>(
+        backend_type_, direct_io_, [this](size_t file) { return GetFileName(file); },
+        [this](int64_t offset, size_t *file) {
+          const PageLocation location = Locate(static_cast<page_id_t>(offset / PAGE_SIZE));
+          *file = location.file_;
+          return static_cast<int64_t>(location.offset_ + offset % PAGE_SIZE);
+        });
+  }
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -61,27 +245,142 @@ class DiskManager {
    */
   void WriteLog(char *log_data, int size);
 
+  /**
+   * Appends log data to the log file through a backend created by CreateLogBackend, without waiting for the write.
+   * The writes may complete in any order; each is on disk once its callback runs.
+   * @param backend the log backend of the calling thread
+   * @param log_data raw log data, which must stay valid until the callback has run
+   * @param size size of the log data
+   * @param callback invoked with true once the data is on disk
+   */
+  void WriteLogAsync(DiskBackend *backend, const char *log_data, int size, std::function<void(bool)> callback);
+
+  /**
+   * Creates a backend for asynchronous writes of the log, see WriteLogAsync, whose writes complete once on disk.
+   * @return the backend, over the segment files of the log
+   */
+  std::unique_ptr<DiskBackend> CreateLogBackend() {
+    return std::make_unique<SegmentedDiskBackend>(
+        backend_type_, [this](int64_t segment) { return LogSegmentName(segment); }, log_segment_size_, true);
+  }
+
   /**
    * Read a log entry from the log file.
    * @param[out] log_data output buffer
    * @param size size of the log entry
-   * @param offset offset of the log entry in the file
-   * @return true if the read was successful, false otherwise
+   * @param offset offset of the log entry in the log
+   * @return true if the read was successful, false past the end of the log or before its truncation point
    */
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Maps the log read-only from offset to its end, its segments one after the other in memory, so that recovery
+   * parses its records in place, whichever segments they span, rather than copying them out a buffer at a time. The
+   * kernel is advised to read the mapping ahead, in order. One mapping is kept at a time; ShutDown unmaps it.
+   * @param offset the offset in the log to map from
+   * @param[out] size the number of bytes mapped from offset on, up to the end of the log appended so far
+   * @return the log data at offset, valid until UnmapLog; nullptr if there is none, or if it can't be mapped, e.g. as
+   * the size of a segment is not a multiple of the system page size
+   */
+  const char *MapLog(int64_t offset, size_t *size);
+
+  /** Unmaps the log mapped by MapLog, if any. */
+  void UnmapLog();
+
+  /**
+   * Recycles the segments of the log wholly before offset, which recovery no longer reads, e.g. those before the
+   * start of the redo and of the undo of the last checkpoint: up to LOG_NUM_SPARE_SEGMENTS of them are renamed past
+   * the last segment, to be written next, the others removed. The segment being written is kept. The new start of
+   * the log is in the master record before any segment goes.
+   * @param offset the offset in the log recovery reads from at the earliest
+   */
+  void TruncateLog(int64_t offset);
+
+  /** @return the offset of the first segment of the log still kept, see TruncateLog */
+  int64_t GetLogStart() const { return log_start_; }
+
+  /** @return the end of the log appended so far: the records written from now on land at or after it */
+  int64_t GetLogSize() const { return log_offset_; }
+
+  /**
+   * Replaces the log with the bytes of another one from offset on, e.g. those of a backup: the log then starts at the
+   * segment of offset, holds the bytes at their offsets, and ends after them, and the master record points at the
+   * checkpoint the recovery starts from. Call it before the log is written.
+   * @param data the bytes of the log
+   * @param size the number of bytes
+   * @param offset the offset in the log of the first byte
+   * @param checkpoint_offset the offset in the log of the checkpoint to recover from
+   */
+  void RestoreLog(const char *data, size_t size, int64_t offset, int64_t checkpoint_offset);
+
+  /**
+   * Returns the pages written to disk since the last call, or since the db file was opened, and records the pages
+   * written from now on anew; an incremental backup copies them, see BackupManager.
+   * @return the pages, in id order
+   */
+  std::vector<page_id_t> TakeChangedPages();
+
+  /** @return the number of pages of the db file, those allocated past its end included */
+  page_id_t GetNumPages() const { return next_page_id_; }
+
+  /**
+   * Records the offset in the log file the recovery starts its analysis at, that of the last checkpoint, in the master
+   * record kept next to the log. Only returns once it is on disk.
+   * @param checkpoint_offset the offset of the checkpoint
+   */
+  void WriteMasterRecord(int64_t checkpoint_offset);
+
+  /** @return the offset of the last checkpoint from the master record, 0 if none was taken */
+  int64_t ReadMasterRecord();
+
+  /**
+   * Allocate a page on disk. Deallocated pages are reused before the file is grown, preferring the free page closest
+   * after the hint so that pages allocated one after the other by the same structure stay physically sequential.
+   *
+   * Pages allocated on behalf of an owner instead come from the owner's current extent, a run of EXTENT_SIZE
+   * contiguous pages reserved for it alone, so that objects growing at the same time do not interleave in the file.
+   * When the extent is used up, a wholly free extent is reused or the file grows by a new one.
+   *
+   * The blocks of the pages the file grows by are allocated ahead, PREALLOCATE_SIZE pages at a time, so that writing a
+   * new page does not allocate them one by one. They are allocated past the end of the file without growing it, which
+   * the writes of the pages do, so that the size of the file still tells the pages it holds when reopened.
+   * @param hint a page the new page should follow, e.g. the last page of a table heap; INVALID_PAGE_ID for none
+   * @param owner the object the page belongs to, identified by its first page; INVALID_PAGE_ID for none
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(page_id_t hint = INVALID_PAGE_ID, page_id_t owner = INVALID_PAGE_ID);
+
+  /**
+   * @param owner the object, identified by its first page
+   * @return the first pages of the extents allocated to the owner since startup, in allocation order
+   */
+  std::vector<page_id_t> GetExtents(page_id_t owner);
+
+  /**
+   * @return the owner of every extent allocated since startup, by the first page of the extent, to tell which object
+   * a page belongs to: the one whose extent starts at most EXTENT_SIZE - 1 pages before it
+   */
+  std::map<page_id_t, page_id_t> GetExtentOwners();
+
+  /**
+   * Returns the pages of the owner's current extent that were never allocated to the free space map, and forgets
+   * about the owner's extents. Must be called when the object is dropped; ShutDown does it for every owner.
+   * @param owner the object, identified by its first page
+   */
+  void ReleaseExtents(page_id_t owner);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, making it available for reuse by AllocatePage.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return the number of deallocated pages waiting to be reused */
+  size_t GetNumFreePages();
+
+  /** @return true if the db file was empty when opened, so that it holds no database yet */
+  bool IsNewFile() const { return is_new_file_; }
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +390,32 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of system calls that wrote pages in place, each one a run of adjacent pages */
+  int GetNumWriteCalls() const { return num_write_calls_; }
+
+  /** @return the number of pages read back that did not match their checksum */
+  int GetNumChecksumFailures() const { return num_checksum_failures_; }
+
+  /** @return the number of bytes the pages take on disk compressed, 0 if they are not compressed */
+  size_t GetCompressedBytes() { return compressed_ != nullptr ? compressed_->GetStoredBytes() : 0; }
+
+  /**
+   * Keeps the last pages read and written compressed in memory as well, behind the buffer pool, see
+   * CompressedPageFile. Does nothing if the pages are not compressed.
+   * @param cache_bytes the bytes of compressed pages to keep, 0 for none
+   */
+  void SetCompressedCacheSize(size_t cache_bytes) {
+    if (compressed_ != nullptr) {
+      compressed_->SetCacheSize(cache_bytes);
+    }
+  }
+
+  /** @return the number of page reads served from the compressed pages kept in memory */
+  size_t GetNumCompressedCacheHits() { return compressed_ != nullptr ? compressed_->GetNumCacheHits() : 0; }
+
+  /** @return the number of pages that differed from their double-write copy when the db file was opened */
+  size_t GetNumRepairedPages() const { return num_repaired_pages_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -102,16 +427,172 @@ class DiskManager {
 
  private:
   int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /**
+   * Opens a sidecar file of the db file, discarding its contents if the db file is new.
+   * @return the file descriptor
+   */
+  int OpenSidecar(const std::string &file_name, bool db_is_new);
+  /** Writes a page in place in the db file, and records its checksum. */
+  void WritePageInPlace(page_id_t page_id, const char *page_data);
+  /** Writes pages sorted by id in place in the db file, a run of adjacent pages at a time, with their checksums. */
+  void WritePagesInPlace(const std::pair<page_id_t, const char *> *pages, size_t num_pages);
+  /** Writes num_pages adjacent pages from first_page_id on in place in the db file with one vectored write. */
+  void WriteRunInPlace(page_id_t first_page_id, const std::pair<page_id_t, const char *> *pages, size_t num_pages);
+  /** Records the checksum of a page written in place, if checksums are enabled. */
+  void RecordChecksum(page_id_t page_id, const char *page_data);
+  /** Records a page written in place as changed, see TakeChangedPages. */
+  void RecordChangedPage(page_id_t page_id);
+  /**
+   * Writes the pages of the batch in the double-write file, if it holds a whole one, in place again, and records the
+   * checksums of those already in place.
+   */
+  void RepairTornPages();
+  /** Where a page is stored: the number of its file, 0 for the db file and i + 1 for data_files_[i], and more. */
+  struct PageLocation {
+    size_t file_;
+    int fd_;
+    off_t offset_;
+  };
+  /** @return where the page is stored */
+  PageLocation Locate(page_id_t page_id);
+  /** @return the name of a file numbered like in PageLocation */
+  std::string GetFileName(size_t file);
+  /** Opens the tablespaces listed in the tablespace file and reads the tablespace of every extent. */
+  void OpenTablespaces(const std::string &base_name, bool db_is_new);
+  /** Opens a data file of a tablespace, emptying it if the tablespace is new. Caller must hold tablespace_latch_. */
+  size_t OpenDataFile(const std::string &file_name, bool is_new);
+  /** Allocates an extent to a tablespace, the next stripe of it. Caller must hold free_pages_latch_. */
+  void AssignExtent(size_t extent, tablespace_id_t tablespace);
+  /** Syncs the db file, every data file and the checksums of their pages. */
+  void SyncDataFiles();
+  /** @return the tablespace of an extent. Caller must hold free_pages_latch_ or tablespace_latch_. */
+  tablespace_id_t GetExtentTablespace(size_t extent) const {
+    return extent < extent_locations_.size() ? extent_locations_[extent].tablespace_ : DEFAULT_TABLESPACE;
+  }
+  /**
+   * @return the first free page at or after page_id in an extent of the tablespace, or INVALID_PAGE_ID. Caller must
+   * hold free_pages_latch_.
+   */
+  page_id_t FindFreePage(page_id_t page_id, tablespace_id_t tablespace = DEFAULT_TABLESPACE);
+  /** Marks the page free or used, in memory and in the free space map file. Caller must hold free_pages_latch_. */
+  void SetPageFree(page_id_t page_id, bool free);
+  /** @return the first page of a newly reserved extent of the tablespace. Caller must hold free_pages_latch_. */
+  page_id_t ReserveExtent(tablespace_id_t tablespace = DEFAULT_TABLESPACE);
+  /** Allocates the blocks of the db file up to end_page_id, if not yet. Caller must hold free_pages_latch_. */
+  void PreallocatePages(page_id_t end_page_id);
+  /** @return the offset in the log of size bytes appended, whose segments are prepared */
+  int64_t ReserveLog(int size);
+  /** @return the name of the file of a segment of the log */
+  std::string LogSegmentName(int64_t segment) const {
+    return segment == 0 ? log_name_ : log_name_ + "." + std::to_string(segment);
+  }
+  /**
+   * Opens the file of a segment of the log, creating it with its blocks allocated if it does not exist, unless it is
+   * open already. Caller must hold log_latch_.
+   */
+  void PrepareLogSegment(int64_t segment);
+  /** @return the file descriptor of a segment of the log, -1 if it is not open */
+  int GetLogSegmentFd(int64_t segment);
+  /** Opens the segments of the log from the master record's start of the log on, and finds its end. */
+  void OpenLog();
+  /** Pages of an object's extents; see AllocatePage. */
+  struct ExtentList {
+    /** First page of every extent of the object. */
+    std::vector<page_id_t> extents_;
+    /** Next page to hand out from the current extent. */
+    page_id_t next_page_id_;
+    /** One past the last page of the current extent. */
+    page_id_t end_page_id_;
+    /** The tablespace of the extents, that of the owner's first page. */
+    tablespace_id_t tablespace_;
+  };
+  /** A tablespace, see CreateTablespace. */
+  struct Tablespace {
+    std::string name_;
+    /** The data files, as indexes into data_files_. */
+    std::vector<size_t> files_;
+    /** The number of extents ever allocated to the tablespace, the next one's place in the stripes. */
+    int32_t num_extents_{0};
+  };
+  /** The place of an extent, as stored in the tablespace map. */
+  struct ExtentLocation {
+    tablespace_id_t tablespace_;
+    /** The extent's number within its tablespace, which tells its file and its offset there. */
+    int32_t stripe_;
+  };
+  /** The thread's tablespace for the pages allocated without an owner, see TablespaceScope. */
+  static thread_local tablespace_id_t current_tablespace_;
+  // the size of a segment of the log
+  const int64_t log_segment_size_;
+  // file descriptors of the segments of the log, from the first one kept to the spares past its end;
+  // guarded by log_latch_
+  std::map<int64_t, int> log_segment_fds_;
+  // offset of the first segment kept, see TruncateLog
+  std::atomic<int64_t> log_start_;
+  // end of the log data appended so far
+  std::atomic<int64_t> log_offset_;
+  std::mutex log_latch_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  DiskBackendType backend_type_;
+  bool direct_io_;
+  // file descriptor of the db file, -1 after ShutDown
+  int db_fd_;
+  // the file the pages are stored in compressed instead of the db file, nullptr if compression is disabled
+  std::unique_ptr<CompressedPageFile> compressed_;
+  // the read-only mapping of the db file made by MapFile, nullptr if none
+  const char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  // the mapping of the log made by MapLog, from the start of a segment, nullptr if none
+  const char *log_mapping_{nullptr};
+  size_t log_mapping_size_{0};
+  // file descriptor of the checksum file, -1 if checksums are disabled
+  int checksum_fd_;
+  // CRC-32C of every page, 0 if none was recorded; guarded by checksum_latch_
+  std::vector<uint32_t> checksums_;
+  std::mutex checksum_latch_;
+  // one bit per page, set once the page is written in place, see TakeChangedPages; guarded by changed_pages_latch_
+  std::vector<uint64_t> changed_pages_;
+  std::mutex changed_pages_latch_;
+  std::atomic<int> num_checksum_failures_;
+  // file descriptor of the double-write file, -1 if the double-write buffer is disabled
+  int double_write_fd_;
+  // held from the write of a batch to the double-write file until its pages are synced in place
+  std::mutex double_write_latch_;
+  size_t num_repaired_pages_{0};
+  // file descriptor of the free space map, a bitmap with one bit per page that is set while the page is free
+  int free_pages_fd_;
+  // in-memory copy of the free space map; guarded by free_pages_latch_
+  std::vector<uint64_t> free_pages_;
+  size_t num_free_pages_;
+  // extents of every object that allocated pages as an owner; guarded by free_pages_latch_
+  std::unordered_map<page_id_t, ExtentList> extents_;
+  std::mutex free_pages_latch_;
+  // the tablespaces, DEFAULT_TABLESPACE first, and the data files they are striped across; guarded by tablespace_latch_
+  std::vector<Tablespace> tablespaces_;
+  std::vector<std::pair<std::string, int>> data_files_;
+  // the place of every extent, those past its end and those of the default tablespace in the db file; changed under
+  // both free_pages_latch_ and tablespace_latch_
+  std::vector<ExtentLocation> extent_locations_;
+  std::shared_mutex tablespace_latch_;
+  // the number of tablespaces, the default one included; with it alone, every page is in the db file
+  std::atomic<size_t> num_tablespaces_{1};
+  // file descriptors of the tablespace file, a line with the name and the data files of every tablespace, and of the
+  // tablespace map, the ExtentLocation of every extent
+  int tablespace_list_fd_{-1};
+  int tablespace_map_fd_{-1};
+  // file descriptor of the master record, the offset in the log of the last checkpoint
+  int master_fd_;
+  // the first page past the end of the db file when opened, then past every page allocated
   std::atomic<page_id_t> next_page_id_;
-  int num_flushes_;
-  int num_writes_;
-  bool flush_log_;
+  // the first page of the db file whose blocks were not allocated ahead, see PreallocatePages; guarded by
+  // free_pages_latch_
+  page_id_t preallocated_page_id_{0};
+  bool is_new_file_{true};
+  std::atomic<int> num_flushes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_write_calls_{0};
+  std::atomic<bool> flush_log_;
   std::future<void> *flush_log_f_;
 };
 
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_disk_backend.h
+//
+// Identification: src/include/storage/disk/io_uring_disk_backend.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BUSTUB_HAVE_IO_URING 1
+#endif
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+
+#include <memory>
+#include <vector>
+
+#include "storage/disk/disk_backend.h"
+
+namespace bustub {
+
+/** Default number of requests an IoUringDiskBackend keeps in flight. */
+static constexpr uint32_t IO_URING_QUEUE_DEPTH = 64;
+
+/**
+ * IoUringDiskBackend issues requests through a Linux io_uring, driven directly with the io_uring_setup and
+ * io_uring_enter system calls. A whole batch of reads and writes is submitted with a single io_uring_enter, and
+ * completions are reaped from the completion queue without further system calls when they are already there.
+ * Requests within a batch may complete in any order.
+ */
+class IoUringDiskBackend : public DiskBackend {
+ public:
+  /**
+   * Sets up an io_uring over the given file.
+   * @param fd the file to operate on, owned by the backend from now on (closed even on failure)
+   * @param direct_io whether fd was opened with O_DIRECT
+   * @param queue_depth the maximum number of requests in flight
+   * @return the backend, or nullptr if the kernel does not support io_uring
+   */
+  static std::unique_ptr<IoUringDiskBackend> Create(int fd, bool direct_io,
+                                                    uint32_t queue_depth = IO_URING_QUEUE_DEPTH);
+
+  ~IoUringDiskBackend() override;
+
+  void Submit(std::vector<DiskRequest> *requests) override;
+
+  void Wait() override;
+
+  void WaitAny() override;
+
+  void Poll() override { Reap(); }
+
+ private:
+  /** A submitted request, indexed by the user data of its submission queue entry. */
+  struct InFlight {
+    DiskRequest request_;
+    char *bounce_buffer_;
+  };
+
+  IoUringDiskBackend(int fd, bool direct_io) : fd_(fd), direct_io_(direct_io) {}
+
+  /** Maps the rings of ring_fd_. @return false on failure */
+  bool MapRings(const io_uring_params &params);
+
+  /** Hands every queued submission to the kernel and, if min_complete > 0, waits for that many completions. */
+  void Enter(uint32_t min_complete);
+
+  /** Runs the callbacks of every completion that is already in the completion queue. */
+  void Reap();
+
+  int fd_;
+  bool direct_io_;
+  int ring_fd_{-1};
+
+  /** Submission queue ring, shared with the kernel. */
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  /** Submission queue entries written but not yet handed to the kernel. */
+  uint32_t to_submit_{0};
+
+  /** Completion queue ring, shared with the kernel; may be the same mapping as sq_ring_. */
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+
+  /** Slots for requests in flight, at most one per submission queue entry. */
+  std::vector<InFlight> in_flight_;
+  std::vector<uint32_t> free_slots_;
+};
+
+}  // namespace bustub
+
+#endif  // BUSTUB_HAVE_IO_URING
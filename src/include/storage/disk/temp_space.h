@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// temp_space.h
+//
+// Identification: src/include/storage/disk/temp_space.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Number of pages in a block of a TempSpace, the unit its file is written and read in. */
+static constexpr size_t TEMP_SPACE_BLOCK_PAGES = 8;
+/** Size of a block of a TempSpace, in bytes. */
+static constexpr size_t TEMP_SPACE_BLOCK_SIZE = TEMP_SPACE_BLOCK_PAGES * PAGE_SIZE;
+
+/**
+ * TempSpace holds the data the operators spill past their memory budget, see TmpTupleRun, in a file of its own.
+ *
+ * Spilled data is written once and read back once, by the operator that wrote it, and never outlives the process, so
+ * it does not go through the buffer pool or the db file: it would take frames from the pages of the tables, and
+ * be written back, logged and checkpointed for nothing. The file is allocated in blocks of TEMP_SPACE_BLOCK_SIZE,
+ * each written with one pwrite and read back with one pread into the private buffer of the run that owns it. A
+ * block is freed as soon as it is read, to be reused by the next one allocated.
+ *
+ * The file is created in a directory on first use and unlinked right away, so that it goes away with the process,
+ * however it ends; it is emptied whenever no block is allocated. Blocks are allocated and freed under a latch, and
+ * any number of threads can read and write their own blocks at once.
+ */
+class TempSpace {
+ public:
+  /** @param directory the directory the file is created in; $TMPDIR, or /tmp, if empty */
+  explicit TempSpace(std::string directory = "") : directory_(std::move(directory)) {}
+
+  DISALLOW_COPY_AND_MOVE(TempSpace);
+
+  /** Closes the file, and with it frees its space. */
+  ~TempSpace();
+
+  /**
+   * @return a free block, reusing those freed before growing the file
+   * @throw Exception if the file can't be created
+   */
+  uint32_t AllocateBlock();
+
+  /** Frees a block, read or not. */
+  void FreeBlock(uint32_t block);
+
+  /**
+   * Writes the first size bytes of a block.
+   * @throw Exception on an I/O error, e.g. when the device is full
+   */
+  void WriteBlock(uint32_t block, const char *data, size_t size);
+
+  /**
+   * Reads back the first size bytes of a block, as written by WriteBlock.
+   * @throw Exception on an I/O error
+   */
+  void ReadBlock(uint32_t block, char *data, size_t size);
+
+  /** @return the number of blocks allocated and not freed */
+  size_t GetNumAllocated();
+
+  /** @return the number of blocks the file holds, allocated or free */
+  size_t GetNumBlocks();
+
+ private:
+  const std::string directory_;
+  std::mutex latch_;
+  /** The file, -1 until the first block is allocated. */
+  int fd_{-1};
+  uint32_t num_blocks_{0};
+  /** The freed blocks, the most recently freed last. */
+  std::vector<uint32_t> free_blocks_;
+};
+
+}  // namespace bustub
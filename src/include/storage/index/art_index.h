@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.h
+//
+// Identification: src/include/storage/index/art_index.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "storage/index/index.h"
+#include "storage/index/ordered_key.h"
+
+namespace bustub {
+
+/**
+ * ARTIndex is an in-memory index, an adaptive radix tree over the keys encoded to byte strings whose memcmp order is
+ * the order of the keys, see EncodeOrderedKey, so that no key is a prefix of another. A point lookup then costs one
+ * node per byte of the key at most, fewer with path compression, and no page fetch. Nothing of the index is stored:
+ * it is to be rebuilt from the table at startup, its durability coming from the log.
+ *
+ * Inner nodes hold 4, 16, 48 or 256 children, grown and shrunk as children come and go, and the part of the keys all
+ * of their children share (their prefix). Leaves hold a whole key and its record ids.
+ *
+ * Readers and writers use optimistic lock coupling: every inner node has a version, which readers validate after
+ * reading the node, starting over if it changed, and which writers lock and bump to modify the node. A writer locks
+ * the node it modifies and, to replace that node with another, its parent. Prefixes and leaves are never modified in
+ * place: a node or leaf is replaced by a modified copy, and the one replaced is marked obsolete. Replaced nodes are
+ * freed once no operation that may still be reading them is running (epoch-based reclamation).
+ */
+class ARTIndex : public Index {
+ public:
+  explicit ARTIndex(IndexMetadata *metadata);
+
+  ~ARTIndex() override;
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  /**
+   * Collects the record ids of the keys from lo to hi, in key order. A key inserted or deleted during the scan may or
+   * may not be seen, the others are seen once.
+   * @param lo the first key, nullptr to start from the first key of the index
+   * @param hi the last key, nullptr to go to the last key of the index
+   * @param[out] result the record ids, appended
+   */
+  void ScanRange(const Tuple *lo, const Tuple *hi, std::vector<RID> *result);
+
+  /** @return the key encoded to a byte string whose memcmp order is the order of the keys, see EncodeOrderedKey */
+  std::string EncodeKey(const Tuple &key) const;
+
+ private:
+  struct Node;
+  struct Leaf;
+  template <size_t N>
+  struct SortedNode;
+  struct Node48;
+  struct Node256;
+
+  /** An inner node with its children in key byte order, for copying and scanning it. */
+  struct Children {
+    size_t size_{0};
+    uint8_t bytes_[256];
+    Node *nodes_[256];
+  };
+
+  /**
+   * @param[out] inserted false if the key is there and unique, or already has the record id
+   * @return false to start over
+   */
+  bool TryInsert(const std::string &key, RID rid, bool *inserted);
+
+  /** @return false to start over */
+  bool TryRemove(const std::string &key, RID rid);
+
+  /** @return false to start over */
+  bool TryLookup(const std::string &key, std::vector<RID> *result);
+
+  /**
+   * Collects the record ids of the keys in range below the node, see ScanRange.
+   * @param path the bytes of the keys above the node
+   * @param lo the first key; lo_tight if the path is a prefix of it, else the keys below are all after it
+   * @param hi the last key, nullptr for none; hi_tight if the path is a prefix of it, else the keys below are all
+   * before it
+   * @param[out] last the last key collected, which the keys collected after a start over must be after
+   * @return false to start over
+   */
+  bool ScanNode(Node *node, std::string *path, const std::string &lo, bool lo_tight, const std::string *hi,
+                bool hi_tight, std::vector<RID> *result, std::string *last);
+
+  /** Reads the version of the node. @return false if the node is locked or obsolete */
+  static bool ReadLock(Node *node, uint64_t *version);
+  /** @return true if the node did not change since its version was read */
+  static bool Validate(Node *node, uint64_t version);
+  /** Locks the node if it did not change since its version was read. */
+  static bool UpgradeToWriteLock(Node *node, uint64_t version);
+  static void WriteUnlock(Node *node);
+  /** Unlocks the node and marks it obsolete, for the readers that still find it to start over. */
+  static void WriteUnlockObsolete(Node *node);
+
+  /** @return a new inner node of 4, 16, 48 or 256 children, with the prefix */
+  static Node *NewInner(size_t capacity, std::string prefix);
+  static Leaf *NewLeaf(const std::string &key, std::vector<RID> rids);
+  /** @return the child of the byte, nullptr for none */
+  static Node *FindChild(Node *node, uint8_t byte);
+  static void AddChild(Node *node, uint8_t byte, Node *child);
+  static void ReplaceChild(Node *node, uint8_t byte, Node *child);
+  static void RemoveChild(Node *node, uint8_t byte);
+  static void GetChildren(Node *node, Children *children);
+  /** @return a copy of the inner node with another prefix and room for capacity children */
+  static Node *CopyInner(Node *node, size_t capacity, std::string prefix);
+  /** Frees the node, and the nodes below it if recursive. */
+  static void FreeNode(Node *node, bool recursive);
+
+  /** @return the epoch the operation runs in, to be left with ExitEpoch */
+  size_t EnterEpoch();
+  void ExitEpoch(size_t epoch);
+  /** Frees the node once no operation that may be reading it is running. */
+  void Retire(Node *node);
+
+  /** The root, a node of 256 children with no prefix, never replaced. */
+  Node *root_;
+  /** The epoch of the operations starting now, see Retire. */
+  std::atomic<size_t> epoch_{0};
+  /** The number of operations running in each of the last three epochs, by epoch modulo 3. */
+  std::atomic<size_t> num_active_[3] = {};
+  /** Protects retired_ and the advance of epoch_. */
+  std::mutex retire_latch_;
+  /** The nodes replaced in each of the last three epochs, by epoch modulo 3. */
+  std::vector<Node *> retired_[3];
+};
+
+}  // namespace bustub
@@ -10,28 +10,77 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
 #include <queue>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
+#include "common/metrics.h"
+#include "common/rwlatch.h"
+#include "common/spin_mutex.h"
 #include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/** Default fraction of each page BulkLoad fills, leaving room for inserts before pages split. */
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;
+/** Most sparse leaf pages remembered for Compact; those past it wait for another remove. */
+static constexpr size_t MAX_SPARSE_LEAVES = 1024;
+/** Default time between two rounds of the compactor, see BPlusTree::StartCompactor. */
+static constexpr std::chrono::milliseconds COMPACTOR_INTERVAL{100};
+/** Default number of sparse leaf pages the compactor rebalances in one round. */
+static constexpr size_t COMPACTOR_BATCH_SIZE = 64;
+/** The lookups of a key that make the adaptive hash index point at its leaf page, see SetAdaptiveHashIndex. */
+static constexpr uint32_t ADAPTIVE_HASH_THRESHOLD = 4;
+/** The lookups GetValuesInterleaved keeps in flight at once. */
+static constexpr size_t INTERLEAVED_LOOKUPS = 16;
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, or else each key is stored once with a posting list of its values (see BPlusTreePostingPage)
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Readers use optimistic latch coupling: they traverse the tree without latching the pages and validate the version
+ * of every page they read (see BPlusTreePage) before trusting what they read from it, starting over if a writer
+ * got in the way. Writers crab down the tree: they write latch each page on the way and let go of all the pages above
+ * as soon as a page is safe, i.e. cannot split or merge, and thus will not change anything above it. They bump the
+ * versions of the pages they modify. The root latch guards root_page_id_ against the writers that could change it.
+ *
+ * By default a remove merges or rebalances a leaf page as soon as it falls below its min size, which under churn of
+ * deletes and reinserts makes pages merge and split again and again, each time write latching their parent. With a
+ * merge watermark, removes only merge the leaf pages that fall below it, e.g. the empty ones, and remember the leaf
+ * pages left below their min size; Compact rebalances those later, in batches, from a background thread if wanted.
+ *
+ * With a write buffer, inserts and removes are not applied to the leaf pages right away but kept as messages at the
+ * root, which lookups apply to what they find in the tree. Once the buffer is full, the messages are flushed down in
+ * key order, so that the messages to a leaf page all find it in memory: random inserts read a leaf page per batch of
+ * messages instead of one each, like the buffers of a B-epsilon tree.
+ *
+ * With an adaptive hash index, like that of InnoDB, the keys looked up again and again get an entry in an in-memory
+ * hash table pointing at their leaf page and slot, and a lookup that finds its key there reads the leaf page right
+ * away rather than searching the tree. An entry is only good as long as its leaf page stays resident and unchanged:
+ * it records the version of the page, which every insert, remove, split and merge bumps, and a lookup that finds the
+ * page evicted or at another version searches the tree and makes the entry anew.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -39,24 +88,140 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  using BulkLoadIterator = typename std::vector<std::pair<KeyType, ValueType>>::const_iterator;
+
+  /**
+   * Creates a B+ tree. A leaf page splits when it reaches leaf_max_size pairs, an internal page when it exceeds
+   * internal_max_size children, which is therefore capped so that the extra child still fits on the page.
+   * A tree without unique keys maps each key to all of the values inserted with it.
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE - 1,
+                     bool unique_keys = true);
+
+  ~BPlusTree();
+
+  /**
+   * Opens the tree of this name stored in the database, from the root page the header page records for it.
+   * @return false if the header page has no record of the tree, which is then empty
+   */
+  bool Open();
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
-  // Insert a key-value pair into this B+ tree.
+  // Returns the first root page of the tree, which owns the extents its pages are allocated in; INVALID_PAGE_ID until
+  // the tree allocates a page.
+  page_id_t GetExtentOwner() const { return extent_owner_; }
+
+  // Makes the tree allocate its first page, and so all of its extents, in a tablespace rather than in that of the
+  // caller's DiskManager::TablespaceScope. Must be called before the tree allocates a page.
+  void SetTablespace(tablespace_id_t tablespace) { tablespace_ = tablespace; }
+
+  // Insert a key-value pair into this B+ tree. Without unique keys, a key gets one more value.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and its value from this B+ tree, all of its values without unique keys.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove a key-value pair from this B+ tree, if the key has that value.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  /**
+   * Makes removes merge a leaf page only once it holds fewer pairs than the watermark, see the class comment.
+   * @param watermark 1 to merge only the leaf pages that become empty; 0, the default, to merge them at their min size
+   */
+  void SetMergeWatermark(int watermark) { merge_watermark_ = watermark; }
+
+  /**
+   * Merges or rebalances the leaf pages removes left below their min size, the way a remove does without a merge
+   * watermark, one leaf page at a time under the root latch.
+   * @param max_leaves the most sparse leaf pages to look at
+   * @return the number of leaf pages merged or rebalanced
+   */
+  size_t Compact(size_t max_leaves = MAX_SPARSE_LEAVES);
+
+  /**
+   * Starts the compactor, a thread that runs Compact every interval and whenever a batch of sparse leaf pages is
+   * waiting. Stopped by StopCompactor or by the destructor.
+   * @param interval the time between two rounds
+   * @param batch_size the most leaf pages a round looks at
+   */
+  void StartCompactor(std::chrono::milliseconds interval = COMPACTOR_INTERVAL,
+                      size_t batch_size = COMPACTOR_BATCH_SIZE);
+
+  /** Stops and joins the compactor, if it is running. */
+  void StopCompactor();
+
+  /**
+   * Buffers inserts and removes at the root, see the class comment. An insert into a tree with unique keys then
+   * returns false only if the buffer holds the key; the insert of a key already in the leaf pages is dropped when
+   * flushed. Iterators and bulk loads flush the buffer first. Not to be called concurrently with other operations.
+   * @param capacity the messages to flush down at once; 0, the default, to apply inserts and removes right away
+   */
+  void SetWriteBuffer(size_t capacity);
+
+  /** Applies the buffered inserts and removes to the leaf pages, in key order. Also done by the destructor. */
+  void FlushWriteBuffer();
+
+  /**
+   * Makes lookups of the keys looked up ADAPTIVE_HASH_THRESHOLD times go straight to their leaf page, see the class
+   * comment. Keys share the entries of the hash table by their hash, the one looked up most keeping it. Not to be
+   * called concurrently with other operations.
+   * @param num_entries the entries of the hash table; 0, the default, for no adaptive hash index
+   */
+  void SetAdaptiveHashIndex(size_t num_entries);
+
+  // return the value associated with a given key, all of them without unique keys
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
+  /**
+   * Looks up many keys in one pass: the search goes down the tree for the first key only, and from there on walks the
+   * leaf pages forward, going down from the root again only for a key beyond the next leaf page.
+   * @param keys the keys, sorted
+   * @param[out] results the values of each key, at the index of the key
+   * @return the number of keys found
+   */
+  size_t GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                   Transaction *transaction = nullptr);
+
+  /**
+   * Looks up many keys scattered over the tree, each with a search of its own, INTERLEAVED_LOOKUPS searches at a time.
+   * A search is a state machine that stops after every page it moves to, having prefetched the page into the cache,
+   * and the searches in flight take their steps in turns, so that each one's cache misses are taken while the others
+   * run. Pages that are not resident are read in by the step that fetches them. Better than GetValues for keys too far
+   * apart to share leaf pages.
+   * @param keys the keys, in any order
+   * @param[out] results the values of each key, at the index of the key
+   * @return the number of keys found
+   */
+  size_t GetValuesInterleaved(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                              Transaction *transaction = nullptr);
+
+  /**
+   * Builds the tree from key & value pairs sorted by key, without the splits and the random page accesses of inserting
+   * them one by one: the leaf pages are filled left to right, and each internal level is built on top of the one
+   * below. Of equal keys, only the first pair is kept unless the keys are not unique. A tree that is not empty gets the
+   * pairs inserted instead.
+   * @param begin the first pair
+   * @param end past the last pair
+   * @param fill_factor the fraction of each page to fill, between its min size and its capacity
+   * @param transaction the transaction to insert the pairs with if the tree is not empty
+   */
+  void BulkLoad(BulkLoadIterator begin, BulkLoadIterator end, double fill_factor = BULK_LOAD_FILL_FACTOR,
+                Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
+  /** @return an iterator over the pairs from the first key not before lo up to hi, included or not */
+  INDEXITERATOR_TYPE Begin(const KeyType &lo, const KeyType &hi, bool hi_inclusive = true);
+  /** @return an iterator over the pairs backward from the last one */
+  INDEXITERATOR_TYPE RBegin();
+  /** @return an iterator over the pairs backward from the last key not after the key */
+  INDEXITERATOR_TYPE RBegin(const KeyType &key);
+  /** @return an iterator over the pairs backward from the last key not after hi down to lo, included or not */
+  INDEXITERATOR_TYPE RBegin(const KeyType &hi, const KeyType &lo, bool lo_inclusive = true);
   INDEXITERATOR_TYPE end();
 
   void Print(BufferPoolManager *bpm) {
@@ -77,9 +242,235 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
   // expose for test purpose
+  // returns the leaf page pinned and read latched, nullptr if the tree is empty
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
+  /**
+   * Goes down the tree to the leaf page of the key as long as the pages are resident, without reading any in.
+   * @return true if the leaf page, and the pages above it, were found in the buffer pool, or the tree is empty; only a
+   * hint, as the pages may be evicted right after
+   */
+  bool IsLeafPageResident(const KeyType &key);
+
  private:
+  /** Kind of modification a writer crabs down the tree for; COMPACT merges or rebalances the leaf page it finds. */
+  enum class WriteOperation { INSERT, REMOVE, COMPACT };
+
+  /** Which leaf page a search goes to: the one the key belongs in, or the first or the last one. */
+  enum class LeafSearch { KEY, LEFT_MOST, RIGHT_MOST };
+
+  /** @return the leaf page pinned and read latched, nullptr if the tree is empty */
+  Page *FindLeafPage(const KeyType &key, LeafSearch search);
+
+  /**
+   * Finds the leaf page without latching any page.
+   * @param[out] version the version of the leaf page, to be validated after reading it
+   * @return the leaf page pinned, nullptr if the tree is empty
+   */
+  Page *FindLeafPageOptimistic(const KeyType &key, LeafSearch search, uint32_t *version);
+
+  /** @return a backward iterator from the last pair of the leaf page the search finds that is not after hi */
+  INDEXITERATOR_TYPE ReverseIterator(const KeyType &hi, LeafSearch search, std::optional<KeyType> lo,
+                                     bool lo_inclusive);
+
+  /**
+   * Points the leaf page back to its new previous page. The caller holds the pages on its left write latched; the
+   * page is latched after them, in the order iterators latch leaf pages in.
+   */
+  void UpdatePrevPageId(page_id_t page_id, page_id_t prev_page_id);
+
+  /**
+   * Finds the leaf page for an insert or a remove with latch crabbing. The caller holds the root latch, recorded as
+   * nullptr in the page set of the transaction. The pages still latched are kept in the page set, from the root down,
+   * until ReleaseWritePages.
+   * @return the leaf page, pinned and write latched
+   */
+  Page *FindLeafPageForWrite(const KeyType &key, WriteOperation operation, Transaction *transaction);
+
+  /** @return true if the operation cannot make the page split or merge */
+  bool IsSafe(BPlusTreePage *node, WriteOperation operation) const;
+
+  /**
+   * Ends the modifications of the pages in the page set of the transaction, unlatches and unpins them, and then
+   * deletes the pages in its deleted page set. Releases the root latch if the page set holds it.
+   */
+  void ReleaseWritePages(Transaction *transaction);
+
+  /** Deletes the pages whose delete was deferred, see deferred_pages_; those still pinned stay deferred. */
+  void DeleteDeferredPages();
+
+  /** Looks the key up in the read latched leaf page. @return true if it is found, with its values added */
+  bool LookupLatched(LeafPage *leaf, const KeyType &key, std::vector<ValueType> *result);
+
+  /** Unlatches and unpins the read latched page. */
+  void ReleaseReadPage(Page *page);
+
+  /** @return the page, pinned; throws if the buffer pool has no free frame */
+  Page *FetchTreePage(page_id_t page_id);
+
+  /** @return the child of a pinned internal page, pinned, through its swizzled reference; throws like FetchTreePage */
+  Page *FetchChildTreePage(Page *parent, int child_index, page_id_t child_page_id);
+
+  /**
+   * @return a new page of the tree, pinned, in the extents of the tree and, if it is the first page, in the tablespace
+   * of the tree; nullptr if the buffer pool is full
+   */
+  Page *AllocatePage(page_id_t *page_id, page_id_t hint);
+
+  /** @return a new page of the tree, pinned, write latched and added to the page set of the transaction */
+  Page *NewTreePage(page_id_t *page_id, page_id_t hint, Transaction *transaction);
+
+  /** One level of a tree being bulk loaded: so many entries go into so many pages, the last one of which is open. */
+  struct BulkLoadLevel {
+    int64_t num_entries_;
+    int64_t num_pages_;
+    int64_t num_opened_pages_;
+    // entries the open page is still to take
+    int64_t remaining_entries_;
+    Page *page_;
+  };
+
+  /** @return the number of pages to spread the entries over, so that each is filled to about fill but min_size */
+  static int64_t BulkLoadNumPages(int64_t num_entries, int fill, int min_size);
+
+  /**
+   * Opens the next page of the level, the previous one being full.
+   * @param key the key under which its parent refers to it, which separates it from the previous page
+   */
+  void BulkLoadOpenPage(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key);
+
+  /** Appends the child to the open page of the internal level. @return the id of the page the child went into */
+  page_id_t BulkLoadAddChild(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key,
+                             page_id_t child_page_id);
+
+  /** @return a new posting page, pinned; only the leaf page its key is on guards it */
+  BPlusTreePostingPage *NewPostingPage(page_id_t hint, page_id_t next_page_id);
+
+  /** Adds the value to the key at the index of the write latched leaf page, starting a posting list if need be. */
+  void AddToPostingList(LeafPage *leaf, int index, const ValueType &value);
+
+  /**
+   * Removes the value from the posting list of the key at the index of the write latched leaf page; the last value
+   * left moves back to the leaf page. @return false if the key does not have the value
+   */
+  bool RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value, Transaction *transaction);
+
+  /** Removes the key with its value, or with any value if there is none, and all of its posting pages. */
+  void RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction);
+
+  /** Inserts the pair into the leaf pages, past the write buffer. */
+  bool InsertEntry(const KeyType &key, const ValueType &value, Transaction *transaction);
+
+  /** Looks the key up in the leaf pages, past the write buffer. */
+  bool LookupEntry(const KeyType &key, std::vector<ValueType> *result);
+
+  /**
+   * Looks the key up in the leaf page an optimistic search ended at, and unpins the page.
+   * @param version the version of the page the search read
+   * @param generation the generation of the adaptive hash index when the search started
+   * @param[out] found whether the key is found, with its values added to result
+   * @return false if the page changed since, and the search must start over
+   */
+  bool LookupLeafOptimistic(const KeyType &key, Page *page, uint32_t version, uint64_t generation,
+                            std::vector<ValueType> *result, bool *found);
+
+  /**
+   * A search of GetValuesInterleaved: the key it looks up, and the page it is at, pinned, if it has started. Until the
+   * version of a page just fetched is read, the search keeps its parent pinned too, to validate it again.
+   */
+  struct InterleavedLookup {
+    size_t key_index_;
+    Page *page_;
+    uint32_t version_;
+    Page *parent_;
+    uint32_t parent_version_;
+    uint64_t generation_;
+  };
+
+  /** Looks keys up in the leaf pages, past the write buffer, see GetValuesInterleaved. */
+  size_t LookupEntriesInterleaved(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Takes the next step of a search of GetValuesInterleaved: starts it at the root, or reads the page it is at, which
+   * the step before fetched and prefetched, and then fetches and prefetches the next page down, or looks its key up if
+   * the page is a leaf page. A search that finds a page changed starts over at its next step.
+   * @return true if the search is done, having looked up its key in the leaf page
+   */
+  bool StepLookup(const KeyType &key, InterleavedLookup *lookup, std::vector<ValueType> *result, bool *found);
+
+  /** An entry of the adaptive hash index: a key, how often it was looked up, and where it was found. */
+  struct AdaptiveHashEntry {
+    SpinMutex latch_;
+    KeyType key_;
+    // the lookups of the key, less those of the other keys of the entry since
+    uint32_t hits_{0};
+    // the leaf page and slot the key was found at, INVALID_PAGE_ID until looked up ADAPTIVE_HASH_THRESHOLD times
+    page_id_t page_id_{INVALID_PAGE_ID};
+    int slot_{0};
+    // the version of the leaf page then, and adaptive_hash_generation_
+    uint32_t version_{0};
+    uint64_t generation_{0};
+  };
+
+  /** @return the entry of the adaptive hash index the key belongs in */
+  AdaptiveHashEntry &GetAdaptiveHashEntry(const KeyType &key) const {
+    return adaptive_hash_[KeyHasher<KeyType>::Hash(key) % adaptive_hash_size_];
+  }
+
+  /**
+   * Looks the key up in the leaf page its entry of the adaptive hash index points at.
+   * @return false if the entry is not the key's, or the leaf page is no longer resident or changed since
+   */
+  bool LookupAdaptiveHash(const KeyType &key, std::vector<ValueType> *result);
+
+  /** Counts a lookup of a key found in the leaf page at a version, making its entry once looked up often enough. */
+  void RecordAdaptiveHash(const KeyType &key, page_id_t page_id, int slot, uint32_t version, uint64_t generation);
+
+  /** Looks sorted keys up in the leaf pages, past the write buffer, see GetValues. */
+  size_t LookupEntries(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results);
+
+  /** What a message in the write buffer does to its key. */
+  enum class MessageType { INSERT, REMOVE, REMOVE_VALUE };
+
+  /** An insert or remove in the write buffer; REMOVE removes the key with all of its values. */
+  struct Message {
+    MessageType type_;
+    ValueType value_;
+  };
+
+  /** Orders the write buffer by key with the comparator of the tree. */
+  struct KeyLess {
+    const KeyComparator *comparator_;
+    bool operator()(const KeyType &a, const KeyType &b) const { return (*comparator_)(a, b) < 0; }
+  };
+
+  /** Adds a message to the write buffer, flushing it if full. Needs write_buffer_latch_ write latched. */
+  void BufferMessage(const KeyType &key, MessageType type, const ValueType &value);
+
+  /** Applies the buffered messages of the key, oldest first, to its values as found in the leaf pages. */
+  void ApplyMessages(const KeyType &key, std::vector<ValueType> *values) const;
+
+  /** Applies the write buffer to the leaf pages and empties it. Needs write_buffer_latch_ write latched. */
+  void FlushWriteBufferLatched();
+
+  /** @return the size below which a remove merges or rebalances the leaf page, see SetMergeWatermark */
+  int GetMergeSize(const LeafPage *leaf) const {
+    const int watermark = merge_watermark_;
+    return watermark == 0 ? leaf->GetMinSize() : std::min(watermark, leaf->GetMinSize());
+  }
+
+  /**
+   * Merges or rebalances the leaf page the key belongs in if it is below its min size.
+   * @return true if the leaf page was merged or rebalanced
+   */
+  bool CompactLeaf(const KeyType &key);
+
+  /** Body of the compactor thread, see StartCompactor. */
+  void RunCompactor(std::chrono::milliseconds interval, size_t batch_size);
+
+  /** @return the first posting page of the pairs, whose keys are equal */
+  page_id_t BulkLoadPostingList(BulkLoadIterator begin, BulkLoadIterator end, page_id_t hint);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
@@ -88,17 +479,18 @@ class BPlusTree {
                         Transaction *transaction = nullptr);
 
   template <typename N>
-  N *Split(N *node);
+  N *Split(N *node, Transaction *transaction);
 
+  /** @param compacting true to merge a leaf page below its min size whatever the merge watermark */
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr, bool compacting = false);
 
   template <typename N>
   bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
                 int index, Transaction *transaction = nullptr);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  bool Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -111,11 +503,50 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // read by optimistic readers without any latch
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool unique_keys_;
+  // owner of the extents the pages of the tree are allocated in, the first root page
+  page_id_t extent_owner_;
+  // the tablespace set by SetTablespace, if any
+  std::optional<tablespace_id_t> tablespace_;
+  // held by the writers that may change root_page_id_
+  ReaderWriterLatch root_latch_;
+  // the pages split and merged, "b_plus_tree.splits" and ".merges"
+  Counter num_splits_;
+  Counter num_merges_;
+  // the optimistic searches started over from the root because a page changed under them, "b_plus_tree.restarts"
+  Counter num_restarts_;
+  // see SetMergeWatermark, 0 for none
+  std::atomic<int> merge_watermark_{0};
+  // a key of each leaf page a remove left below its min size, for Compact; guarded by compactor_latch_
+  std::vector<KeyType> sparse_leaves_;
+  std::mutex compactor_latch_;
+  std::condition_variable compactor_cv_;
+  bool compactor_stop_{false};
+  std::thread compactor_thread_;
+  // see SetWriteBuffer, 0 for none
+  std::atomic<size_t> write_buffer_capacity_{0};
+  // held by lookups while they apply the buffered messages, and write latched by inserts and removes
+  ReaderWriterLatch write_buffer_latch_;
+  // the buffered messages by key, each key's oldest first
+  std::multimap<KeyType, Message, KeyLess> write_buffer_;
+  // see SetAdaptiveHashIndex, 0 for none
+  size_t adaptive_hash_size_{0};
+  std::unique_ptr<AdaptiveHashEntry[]> adaptive_hash_;
+  // bumped before pages of the tree are deleted, which could be reused at the same version by another tree
+  std::atomic<uint64_t> adaptive_hash_generation_{0};
+  // the pages removed from the tree that an optimistic reader still had pinned when deleted, deleted again on the next
+  // release of write pages; guarded by deferred_latch_
+  std::vector<page_id_t> deferred_pages_;
+  std::mutex deferred_latch_;
+  std::atomic<bool> has_deferred_pages_{false};
+  // the lookups that went straight to their leaf page, "b_plus_tree.adaptive_hash_hits"
+  Counter num_adaptive_hash_hits_;
 };
 
 }  // namespace bustub
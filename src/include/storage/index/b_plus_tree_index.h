@@ -11,10 +11,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
+#include "common/util/bloom_filter.h"
 #include "storage/index/b_plus_tree.h"
 #include "storage/index/index.h"
 
@@ -29,14 +33,101 @@ class BPlusTreeIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /** Sorts the entries by key and inserts them in order, or bulk loads them into an empty tree, see BulkLoad. */
+  void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /** Sorts the entries by key and deletes them in order, so that consecutive deletes find their leaf page in memory. */
+  void DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  bool GetNextKey(const Tuple &key, RID *rid, Transaction *transaction) override;
+
+  page_id_t GetExtentOwner() const override { return container_.GetExtentOwner(); }
+
+  /**
+   * Keeps a change buffer from now on, for an index without unique keys: an insert or delete whose leaf page is not in
+   * the buffer pool is recorded in a tree of pending inserts or one of pending deletes, which stay in memory, instead
+   * of waiting for the leaf page to be read in. An insert cancels the pending delete of the same entry, and the other
+   * way around. ScanKey and ScanKeys apply the pending changes of their keys; ScanKey merges them into the index as
+   * well, once it has read the leaf page in anyway. MergeChanges merges the others in the background, see
+   * VacuumManager, and iterators merge all of them first. The two trees are stored in the buffer pool of the index,
+   * named after it with "#ins" and "#del", and are reopened by calling this again after Open.
+   * @throw Exception if the index has unique keys, whose inserts must read the leaf page to find duplicates
+   */
+  void EnableChangeBuffer();
+
+  /** @return true if the index keeps a change buffer */
+  bool HasChangeBuffer() const { return has_change_buffer_; }
+
+  /** @return the number of inserts and deletes pending in the change buffer */
+  size_t GetNumPendingChanges() const { return num_changes_; }
+
+  /** Merges the pending changes of the first keys of the change buffer, in key order. */
+  size_t MergeChanges(size_t max_keys) override;
+
+  /** Allocates the pages of the index in a tablespace, see BPlusTree::SetTablespace. */
+  void SetTablespace(tablespace_id_t tablespace) { container_.SetTablespace(tablespace); }
+
+  /** Merges leaf pages lazily, rebalanced by a compactor thread, see BPlusTree::SetMergeWatermark. */
+  void SetMergeWatermark(int watermark) {
+    container_.SetMergeWatermark(watermark);
+    if (watermark == 0) {
+      container_.StopCompactor();
+    } else {
+      container_.StartCompactor();
+    }
+  }
+
+  /** Buffers inserts and deletes at the root of the tree, flushed down in batches, see BPlusTree::SetWriteBuffer. */
+  void SetWriteBuffer(size_t capacity) { container_.SetWriteBuffer(capacity); }
+
+  /** Makes point lookups of hot keys skip the search down the tree, see BPlusTree::SetAdaptiveHashIndex. */
+  void SetAdaptiveHashIndex(size_t num_entries) { container_.SetAdaptiveHashIndex(num_entries); }
+
+  /**
+   * Looks up a batch of keys at the cost of about one search and a walk over the leaf pages they are on, see
+   * BPlusTree::GetValues. The keys need not be sorted.
+   * @param[out] results the record ids of each key, at the index of the key
+   */
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results, Transaction *transaction);
+
+  /**
+   * Looks up a batch of keys with a search of the tree each, the searches interleaved to overlap their cache misses,
+   * see BPlusTree::GetValuesInterleaved. Better than ScanKeys for keys too sparse to share leaf pages.
+   * @param[out] results the record ids of each key, at the index of the key
+   */
+  void ProbeKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results, Transaction *transaction);
+
+  /** Builds the index from key & value pairs sorted by key, see BPlusTree::BulkLoad. */
+  void BulkLoad(typename BPlusTree<KeyType, ValueType, KeyComparator>::BulkLoadIterator begin,
+                typename BPlusTree<KeyType, ValueType, KeyComparator>::BulkLoadIterator end, Transaction *transaction);
+
+  /**
+   * Keeps a Bloom filter over the keys of the index from now on, so that ScanKey and ScanKeys answer most lookups of
+   * keys the index does not hold without descending the tree. The filter is built from the entries of the tree, and
+   * rebuilt twice as large whenever the inserted keys outgrow it. Deleted keys stay in the filter until the next
+   * rebuild, where they only cost false positives. Keys are told apart by their bytes, or by the values of their key
+   * columns if the index has INCLUDE columns. Must not run concurrently with
+   * inserts into the index.
+   */
+  void EnableBloomFilter();
+
+  /** @return true if the index keeps a Bloom filter over its keys */
+  bool HasBloomFilter() const { return has_bloom_filter_; }
+
+  /** Opens the tree of the index stored in the database, see BPlusTree::Open. @return false if there is none */
+  bool Open() { return container_.Open(); }
+
   INDEXITERATOR_TYPE GetBeginIterator();
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
 
+  /** @return an iterator over the entries from the first key not before lo up to the last key not after hi */
+  INDEXITERATOR_TYPE GetBeginIterator(const KeyType &lo, const KeyType &hi);
+
   INDEXITERATOR_TYPE GetEndIterator();
 
  protected:
@@ -44,6 +135,60 @@ class BPlusTreeIndex : public Index {
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
+
+ private:
+  using ChangeTree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+  /** Inserts the entry into the tree, or records it in the change buffer. @return false if it was a duplicate */
+  bool InsertOrBuffer(const KeyType &key, RID rid, Transaction *transaction);
+
+  /** Deletes the entry from the tree, or records its delete in the change buffer. */
+  void DeleteOrBuffer(const KeyType &key, RID rid, Transaction *transaction);
+
+  /** @return true if the change tree holds the entry */
+  bool HasChange(ChangeTree *changes, const KeyType &key, RID rid);
+
+  /**
+   * Applies the pending changes of the key to its record ids as found in the tree. Needs change_latch_ latched.
+   * @return true if the key has pending changes
+   */
+  bool ApplyChanges(const KeyType &key, std::vector<RID> *result);
+
+  /** Merges the pending changes of the key into the tree. Needs change_latch_ write latched. @return their number */
+  size_t MergeKeyChanges(const KeyType &key);
+
+  /** Builds bloom_filter_ from the entries of the tree, with room for as many again. Needs filter_latch_ latched. */
+  void RebuildBloomFilter();
+
+  /** Adds keys to the Bloom filter, if the index keeps one. */
+  void AddToBloomFilter(const KeyType *keys, size_t count);
+
+  /** @return false if the index keeps a Bloom filter and the key is not in it */
+  bool MayContain(const KeyType &key);
+
+  /** @return the hash of a key in the Bloom filter, which leaves out its INCLUDE columns */
+  hash_t HashKey(const KeyType &key) const;
+
+  /** Protects bloom_filter_ and its counts, which writers update after the tree. */
+  ReaderWriterLatch filter_latch_;
+  std::atomic<bool> has_bloom_filter_{false};
+  std::unique_ptr<BloomFilter> bloom_filter_;
+  /** The number of keys bloom_filter_ was sized for. */
+  size_t filter_capacity_{0};
+  /** The number of keys added to bloom_filter_ since it was built, counting the ones built from. */
+  size_t filter_keys_{0};
+
+  BufferPoolManager *buffer_pool_manager_;
+  /**
+   * Read latched by the inserts, deletes and lookups that go through the change buffer, write latched by merges. The
+   * inserts and deletes of one entry are serialized by the locks of the tuple, those of different ones commute.
+   */
+  ReaderWriterLatch change_latch_;
+  std::atomic<bool> has_change_buffer_{false};
+  /** The pending inserts and deletes; an entry is never in both. */
+  std::unique_ptr<ChangeTree> change_inserts_;
+  std::unique_ptr<ChangeTree> change_deletes_;
+  std::atomic<size_t> num_changes_{0};
 };
 
 }  // namespace bustub
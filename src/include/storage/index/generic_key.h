@@ -12,9 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <memory>
 
+#include "storage/index/ordered_key.h"
 #include "storage/table/tuple.h"
+#include "type/limits.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -72,11 +76,33 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * The comparator is specialized for the key schema when it is created: keys made of integer columns only are
+ * compared on their raw integers, not on Values deserialized from them, which is what binary searches in B+ tree
+ * pages spend most of their time on. Other keys are normalized, see KeyNormalizer, and compared with one memcmp;
+ * only a key with a NULL, or one that does not fit the key size, is compared on its Values. A NULL compares equal to
+ * anything on every path.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    if (num_integer_columns_ > 0) {
+      return CompareIntegers(lhs, rhs);
+    }
+    if (normalizer_ != nullptr) {
+      char lhs_normalized[MAX_NORMALIZED_SIZE];
+      char rhs_normalized[MAX_NORMALIZED_SIZE];
+      bool lhs_null;
+      bool rhs_null;
+      const size_t lhs_size = normalizer_->Encode(lhs.data_, KeySize, lhs_normalized, &lhs_null);
+      const size_t rhs_size = normalizer_->Encode(rhs.data_, KeySize, rhs_normalized, &rhs_null);
+      if (lhs_size > 0 && rhs_size > 0 && !lhs_null && !rhs_null) {
+        // No normalized key is a prefix of another.
+        const int result = memcmp(lhs_normalized, rhs_normalized, std::min(lhs_size, rhs_size));
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+      }
+    }
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -94,13 +120,119 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * Finds a separator for suffix truncation: a key that sorts after lhs and not after rhs, given lhs < rhs, and has
+   * as many trailing zero bytes as possible, which B+ tree internal pages do not store.
+   * @return rhs with as many of its last bytes zeroed as will keep it after lhs and not after itself
+   */
+  inline GenericKey<KeySize> ShortestSeparator(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    // The offset of a variable length column must not be zeroed, or it would point elsewhere.
+    for (uint32_t i = 0; i < key_schema_->GetColumnCount(); i++) {
+      if (!key_schema_->GetColumn(i).IsInlined()) {
+        return rhs;
+      }
+    }
+    GenericKey<KeySize> separator;
+    memset(separator.data_, 0, KeySize);
+    size_t length = 0;
+    while ((*this)(lhs, separator) >= 0 || (*this)(separator, rhs) > 0) {
+      // Only a nonzero byte of rhs makes for a different candidate.
+      while (length < KeySize && rhs.data_[length] == 0) {
+        length++;
+      }
+      if (length == KeySize) {
+        return rhs;
+      }
+      separator.data_[length] = rhs.data_[length];
+      length++;
+    }
+    return separator;
+  }
+
+  /** @return true if the keys are compared on their raw integers, which is cheap enough for branchless searches */
+  inline bool ComparesIntegers() const { return num_integer_columns_ > 0; }
+
+  GenericComparator(const GenericComparator &other) = default;
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {
+    const uint32_t column_count = key_schema_->GetColumnCount();
+    if (column_count > KeySize) {
+      return;
+    }
+    auto normalizer = std::make_shared<const KeyNormalizer>(key_schema_);
+    if (normalizer->IsSupported() && normalizer->GetMaxEncodedSize(KeySize) <= MAX_NORMALIZED_SIZE) {
+      normalizer_ = std::move(normalizer);
+    }
+    for (uint32_t i = 0; i < column_count; i++) {
+      const Column &column = key_schema_->GetColumn(i);
+      const TypeId type = column.GetType();
+      if ((type != TypeId::TINYINT && type != TypeId::SMALLINT && type != TypeId::INTEGER &&
+           type != TypeId::BIGINT) ||
+          column.GetOffset() + column.GetFixedLength() > KeySize) {
+        // Some column needs another path.
+        num_integer_columns_ = 0;
+        return;
+      }
+      integer_columns_[i] = {static_cast<uint16_t>(column.GetOffset()), static_cast<uint8_t>(column.GetFixedLength())};
+      num_integer_columns_++;
+    }
+  }
 
  private:
+  /** The largest normalized key compared, for the keys of the largest key size and as many columns as bytes. */
+  static constexpr size_t MAX_NORMALIZED_SIZE = 5 * KeySize;
+
+  /** Where an integer column is in the key, and how wide it is. */
+  struct IntegerColumn {
+    uint16_t offset_;
+    uint8_t size_;
+  };
+
+  template <typename T>
+  static inline int CompareInteger(const char *lhs, const char *rhs, T null_value) {
+    T lhs_value;
+    T rhs_value;
+    memcpy(&lhs_value, lhs, sizeof(T));
+    memcpy(&rhs_value, rhs, sizeof(T));
+    if (lhs_value == null_value || rhs_value == null_value) {
+      return 0;
+    }
+    return lhs_value < rhs_value ? -1 : (lhs_value > rhs_value ? 1 : 0);
+  }
+
+  inline int CompareIntegers(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    for (uint32_t i = 0; i < num_integer_columns_; i++) {
+      const char *lhs_data = lhs.data_ + integer_columns_[i].offset_;
+      const char *rhs_data = rhs.data_ + integer_columns_[i].offset_;
+      int result;
+      switch (integer_columns_[i].size_) {
+        case sizeof(int8_t):
+          result = CompareInteger<int8_t>(lhs_data, rhs_data, BUSTUB_INT8_NULL);
+          break;
+        case sizeof(int16_t):
+          result = CompareInteger<int16_t>(lhs_data, rhs_data, BUSTUB_INT16_NULL);
+          break;
+        case sizeof(int32_t):
+          result = CompareInteger<int32_t>(lhs_data, rhs_data, BUSTUB_INT32_NULL);
+          break;
+        default:
+          result = CompareInteger<int64_t>(lhs_data, rhs_data, BUSTUB_INT64_NULL);
+          break;
+      }
+      if (result != 0) {
+        return result;
+      }
+    }
+    return 0;
+  }
+
   Schema *key_schema_;
+  // the normalizer of the keys compared with memcmp, shared by the copies of the comparator; nullptr if none
+  std::shared_ptr<const KeyNormalizer> normalizer_;
+  // the columns of the key if they are all integers, compared without Values, or else none
+  uint32_t num_integer_columns_{0};
+  IntegerColumn integer_columns_[KeySize];
 };
 
 }  // namespace bustub
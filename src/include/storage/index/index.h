@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/macros.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -36,30 +37,52 @@ class IndexMetadata {
  public:
   IndexMetadata() = delete;
 
+  /**
+   * @param include_attrs the INCLUDE columns of the index: stored in its entries after the key columns, so that a scan
+   * reading only them needs not fetch the tuples, but neither compared nor searched on. A key without unique keys is
+   * stored once for all of its tuples, so only an index with unique keys may have INCLUDE columns.
+   */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                const std::vector<uint32_t> &key_attrs, bool unique_keys = true,
+                const std::vector<uint32_t> &include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(ConcatAttrs(key_attrs, include_attrs)),
+        index_column_count_(static_cast<uint32_t>(key_attrs.size())),
+        unique_keys_(unique_keys) {
+    BUSTUB_ASSERT(unique_keys || include_attrs.empty(), "Only an index with unique keys may have INCLUDE columns.");
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    search_key_schema_ = Schema::CopySchema(tuple_schema, key_attrs);
   }
 
-  ~IndexMetadata() { delete key_schema_; }
+  ~IndexMetadata() {
+    delete key_schema_;
+    delete search_key_schema_;
+  }
 
   inline const std::string &GetName() const { return name_; }
 
   inline const std::string &GetTableName() { return table_name_; }
 
-  // Returns a schema object pointer that represents the indexed key
+  // Returns a schema object pointer that represents the indexed key, its INCLUDE columns last
   inline Schema *GetKeySchema() const { return key_schema_; }
 
-  // Return the number of columns inside index key (not in tuple key)
-  // Note that this must be defined inside the cpp source file
-  // because it uses the member of catalog::Schema which is not known here
-  uint32_t GetIndexColumnCount() const { return static_cast<uint32_t>(key_attrs_.size()); }
+  /** @return the schema of the key columns alone, which keys are compared on */
+  inline Schema *GetSearchKeySchema() const { return search_key_schema_; }
+
+  // Return the number of columns inside index key (not in tuple key), without its INCLUDE columns
+  uint32_t GetIndexColumnCount() const { return index_column_count_; }
+
+  /** @return the number of INCLUDE columns of the index */
+  uint32_t GetIncludeColumnCount() const { return static_cast<uint32_t>(key_attrs_.size()) - index_column_count_; }
 
   //  Returns the mapping relation between indexed columns  and base table
-  //  columns
+  //  columns, the INCLUDE columns last
   inline const std::vector<uint32_t> &GetKeyAttrs() const { return key_attrs_; }
 
+  /** @return true if no two tuples may have the same key, false if the index maps a key to all of its tuples */
+  inline bool HasUniqueKeys() const { return unique_keys_; }
+
   // Get a string representation for debugging
   std::string ToString() const {
     std::stringstream os;
@@ -74,12 +97,24 @@ class IndexMetadata {
   }
 
  private:
+  static std::vector<uint32_t> ConcatAttrs(std::vector<uint32_t> key_attrs,
+                                           const std::vector<uint32_t> &include_attrs) {
+    key_attrs.insert(key_attrs.end(), include_attrs.begin(), include_attrs.end());
+    return key_attrs;
+  }
+
   std::string name_;
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<uint32_t> key_attrs_;
+  // the number of key columns, which come before the INCLUDE columns
+  const uint32_t index_column_count_;
+  // false if a key maps to all of the tuples with that key
+  const bool unique_keys_;
   // schema of the indexed key
   Schema *key_schema_;
+  // schema of the key columns alone
+  Schema *search_key_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -132,11 +167,43 @@ class Index {
   // designed for secondary indexes.
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  // insert a batch of entries, the key at an index going with the rid at the same index; one by one by default
+  virtual void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      InsertEntry(keys[i], rids[i], transaction);
+    }
+  }
+
   // delete the index entry linked to given tuple
   virtual void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  // delete a batch of entries, the key at an index going with the rid at the same index; one by one by default
+  virtual void DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      DeleteEntry(keys[i], rids[i], transaction);
+    }
+  }
+
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Finds the entry whose key range an insert of a key locks for next-key locking, see KeyRange: the first entry of
+   * the index whose key is greater than the key.
+   * @param[out] rid the record id of the entry, an invalid RID if there is none
+   * @return false if the index does not keep its keys in order, and has no key ranges
+   */
+  virtual bool GetNextKey(const Tuple &key, RID *rid, Transaction *transaction) { return false; }
+
+  /** @return the page that owns the extents the pages of the index are allocated in, INVALID_PAGE_ID for none */
+  virtual page_id_t GetExtentOwner() const { return INVALID_PAGE_ID; }
+
+  /**
+   * Merges changes the index left pending into it, for the indexes that defer some, in the background.
+   * @param max_keys the most keys to merge the changes of
+   * @return the number of changes merged
+   */
+  virtual size_t MergeChanges(size_t max_keys) { return 0; }
+
  private:
   //===--------------------------------------------------------------------===//
   //  Data members
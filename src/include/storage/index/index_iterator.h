@@ -13,31 +13,103 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * Iterates over the key & value pairs of the leaf pages, from left to right or from right to left, optionally up to a
+ * bound key. The iterator keeps the leaf page it is positioned on pinned and read latched, and crabs to the next leaf
+ * page before letting go of the current one.
+ *
+ * Writers latch sibling leaf pages from left to right, so a backward iterator only tries to latch the previous page.
+ * If a writer holds it, the iterator lets go of its page, which the writer may be waiting for, and finds the page
+ * preceding its last key from the root again. Either way it positions itself by key, since the pages may have changed
+ * while they were not latched.
+ *
+ * A key with a posting list yields a pair for each of its values, which are read as the iterator gets to the key.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** Which way an iterator goes and where it stops. By default, it goes from left to right up to the last pair. */
+  struct Range {
+    // compares the keys to the bound, needed with a bound or backward
+    const KeyComparator *comparator_{nullptr};
+    // the key past which the iterator ends, if any
+    std::optional<KeyType> bound_;
+    // true if the iterator ends after a pair with the bound key, false if before it
+    bool bound_inclusive_{true};
+    bool reverse_{false};
+    // finds the leaf page a key belongs in, pinned and read latched, nullptr if the tree is empty; needed backward
+    std::function<Page *(const KeyType &key)> find_leaf_page_;
+  };
+
+  /** Creates an end iterator. */
   IndexIterator();
+  /**
+   * Creates an iterator positioned on a pair of a leaf page. Past the end of the page, it moves on to the next one.
+   * Backward, it is positioned on the pair right before the index, on the previous pages if the index is 0.
+   * @param buffer_pool_manager the buffer pool of the tree
+   * @param page the leaf page, pinned and read latched; the iterator takes both over
+   * @param index the index of the pair in the leaf page
+   * @param range the direction and the bound of the iteration
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, Range range = {});
   ~IndexIterator();
 
+  DISALLOW_COPY(IndexIterator);
+  IndexIterator(IndexIterator &&other) noexcept;
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+
   bool isEnd();
 
   const MappingType &operator*();
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const {
+    return page_ == itr.page_ && (page_ == nullptr || (index_ == itr.index_ && posting_index_ == itr.posting_index_));
+  }
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** Moves on to the next leaf pages until the index is within the current one. */
+  void SkipExhaustedPages();
+  /**
+   * Moves back to the last pair before the key, which is on the current leaf page or before it.
+   * The current page is pinned and latched, and cannot be one merged away, so its previous page is live.
+   */
+  void MoveBefore(const KeyType &key);
+  /** Ends the iteration if the current pair is past the bound. */
+  void CheckBound();
+  /** Reads the values of the current key if it has a posting list. */
+  void LoadPostingList();
+  /** @return true if the key is past the bound, in the direction of the iteration */
+  bool IsPastBound(const KeyType &key, bool inclusive) const;
+  /** Unlatches and unpins the current leaf page. */
+  void Release();
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  Page *page_{nullptr};
+  LeafPage *leaf_{nullptr};
+  int index_{0};
+  Range range_;
+  // the values of the current key if it has a posting list, the one at the posting index being the current pair
+  std::vector<ValueType> posting_list_;
+  int posting_index_{-1};
+  MappingType posting_item_;
 };
 
 }  // namespace bustub
@@ -20,6 +20,6 @@ namespace bustub {
  */
 class IntComparator {
  public:
-  inline int operator()(const int lhs, const int rhs) { return lhs - rhs; }
+  inline int operator()(const int lhs, const int rhs) const { return lhs - rhs; }
 };
 }  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_index.h
+//
+// Identification: src/include/storage/index/lsm_index.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/thread_pool.h"
+#include "storage/index/index.h"
+#include "storage/index/ordered_key.h"
+
+namespace bustub {
+
+/**
+ * LSMIndex is a log-structured merge tree, an index for the tables that are mostly appended to and read by key: a
+ * write goes to a table in memory, and reaches the pages of the buffer pool in sorted runs written a page at a time,
+ * each entry written again once per level it goes down, rather than into a leaf of a tree in place.
+ *
+ * An entry is a key encoded as by EncodeOrderedKey, a record id, and whether it deletes them (a tombstone), ordered by
+ * key and record id. The memtable is a skip list of entries; writers take the write latch of the index and link a new
+ * node bottom up once it is complete, readers take no latch. Once the memtable holds memtable_size entries it is
+ * frozen, a new one takes its place, and it is flushed to a sorted run of level 0.
+ *
+ * A sorted run is immutable: a chain of pages of entries in order, with the first key of each page (its block index)
+ * and a Bloom filter of its keys in memory, so that a lookup reads the pages of its key only, in the runs that may
+ * hold it. Level 0 holds the runs flushed, which overlap one another, newest first; every level below holds a single
+ * run, LEVEL_SIZE_RATIO times as large as the one above it may be. Once level 0 has LEVEL0_RUNS runs they are merged
+ * into level 1, and a level grown past its size into the one below. A merge keeps the newest entry of each key and
+ * record id, and drops the tombstones once no level is below them.
+ *
+ * The memtables and the runs in use form a version, which a lookup holds a reference to while it reads them, so that
+ * a flush or a merge installs a new version without waiting for the lookups; the pages of a run are deleted once no
+ * version refers to it. The flushes and merges run one at a time, on the thread pool, or on the writer thread that
+ * froze the memtable without one.
+ *
+ * Nothing of the index is reopened: like ARTIndex, it is to be rebuilt from the table at startup, its durability
+ * coming from the log.
+ */
+class LSMIndex : public Index {
+ public:
+  /** The default number of entries of a memtable. */
+  static constexpr size_t DEFAULT_MEMTABLE_SIZE = 4096;
+  /** The number of runs of level 0 that are merged into level 1. */
+  static constexpr size_t LEVEL0_RUNS = 4;
+  /** How many times as large as a level the level below it may be. */
+  static constexpr size_t LEVEL_SIZE_RATIO = 10;
+
+  /**
+   * Creates an empty index.
+   * @param metadata the metadata of the index
+   * @param bpm the buffer pool the pages of the runs are allocated in
+   * @param thread_pool the thread pool the flushes and merges run on, nullptr to run them on the writer thread
+   * @param memtable_size the number of entries a memtable is frozen at
+   */
+  LSMIndex(IndexMetadata *metadata, BufferPoolManager *bpm, ThreadPool *thread_pool = nullptr,
+           size_t memtable_size = DEFAULT_MEMTABLE_SIZE);
+
+  /** Waits for the flush or merge running, and deletes the pages of the runs. */
+  ~LSMIndex() override;
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  /** Waits until the frozen memtables are flushed and no merge is due. */
+  void WaitForCompaction();
+
+  /** @return the number of runs of each level, level 0 first, down to the last level that has one */
+  std::vector<size_t> GetNumRuns();
+
+ private:
+  struct Entry {
+    std::string key_;
+    RID rid_;
+    bool deleted_;
+  };
+
+  struct MemTable;
+  struct Run;
+  struct Version;
+
+  /** Adds an entry to the memtable, freezing it once full. */
+  void Write(const Tuple &key, RID rid, bool deleted);
+
+  /** @return the current version */
+  std::shared_ptr<const Version> GetVersion();
+
+  /** Collects the record ids of the key, by the newest entry of each, from the memtables down to the last level. */
+  static void Lookup(const Version &version, const std::string &key, std::vector<RID> *result);
+
+  /** Flushes the frozen memtables and merges the levels, until nothing is left to. */
+  void Compact();
+
+  /** Flushes the oldest frozen memtable to a run of level 0. @return false if there is none */
+  bool FlushMemTable();
+
+  /** Merges level 0 into level 1 or a level past its size into the next, if any is due. @return false if none is */
+  bool MergeLevel();
+
+  /** @return the run of the entries of runs, newest first, keeping the newest of each; nullptr if none is kept */
+  std::shared_ptr<Run> MergeRuns(const std::vector<std::shared_ptr<Run>> &runs, bool drop_tombstones);
+
+  /** @return the number of entries the run of a level from 1 on may hold */
+  size_t LevelCapacity(size_t level) const;
+
+  BufferPoolManager *bpm_;
+  ThreadPool *thread_pool_;
+  const size_t memtable_size_;
+  /** Serializes the writers of the memtable. */
+  std::mutex write_latch_;
+  /** Protects version_ and compacting_. */
+  std::mutex version_latch_;
+  std::condition_variable idle_cv_;
+  std::shared_ptr<const Version> version_;
+  /** Whether a compaction is scheduled or running. */
+  bool compacting_{false};
+};
+
+}  // namespace bustub
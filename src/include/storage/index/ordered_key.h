@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ordered_key.h
+//
+// Identification: src/include/storage/index/ordered_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * KeyNormalizer encodes keys laid out like tuples of a key schema, as in a Tuple or a GenericKey, to byte strings
+ * whose memcmp order is the order of the keys, reading the values in place instead of through Values: every column is
+ * a marker byte that puts NULL first, then the value big-endian with the sign bit flipped, a VARCHAR with its zero
+ * bytes escaped and a terminator, so that no key is a prefix of another. A DECIMAL -0 is encoded as 0, which it equals.
+ */
+class KeyNormalizer {
+ public:
+  /** Creates the normalizer of the keys of a schema. */
+  explicit KeyNormalizer(const Schema *schema);
+
+  /** @return true if every column of the schema is of a type the normalizer encodes */
+  bool IsSupported() const { return supported_; }
+
+  /** @return the most bytes the encoding of a key of size bytes takes */
+  size_t GetMaxEncodedSize(size_t size) const { return 2 * size + 3 * columns_.size(); }
+
+  /**
+   * Encodes a key.
+   * @param data the key, laid out like a tuple of the schema
+   * @param size the bytes of data that may be read
+   * @param[out] out GetMaxEncodedSize(size) bytes for the encoded key
+   * @param[out] has_null if not nullptr, set to whether the key has a NULL column
+   * @return the size of the encoded key, 0 if a value of the key is past size bytes or stored out of line
+   */
+  size_t Encode(const char *data, size_t size, char *out, bool *has_null = nullptr) const;
+
+ private:
+  std::vector<ColumnLayout> columns_;
+  bool supported_{true};
+};
+
+/**
+ * Encodes a key to a byte string whose memcmp order is the order of the keys, for the indexes that compare keys as
+ * bytes; see KeyNormalizer.
+ * @param key the key
+ * @param schema the schema of the key columns
+ * @return the encoded key
+ * @throws Exception if a value of the key is stored out of line
+ */
+std::string EncodeOrderedKey(const Tuple &key, const Schema *schema);
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_key.h
+//
+// Identification: src/include/storage/index/varlen_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "container/hash/hash_function.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * VarlenKey is a key of any length for hash indexes, which only ever compare keys for equality: a view of the bytes
+ * of a key tuple, as long as the tuple is. Where GenericKey<64> pads a short VARCHAR key to 64 bytes, and stores and
+ * hashes all of them, a VarlenKey is stored in the heap of a hash table block page at its own length, and hashed over
+ * it. The bytes viewed must outlive the key: the tuple it was set from, or the pinned block page it was read from.
+ */
+class VarlenKey {
+ public:
+  VarlenKey() = default;
+
+  VarlenKey(const char *data, uint32_t size) : data_(data), size_(size) {}
+
+  inline void SetFromKey(const Tuple &tuple) {
+    data_ = tuple.GetData();
+    size_ = tuple.GetLength();
+  }
+
+  inline const char *GetData() const { return data_; }
+
+  inline uint32_t GetSize() const { return size_; }
+
+  /** The size of the keys a hash table block page makes room for in its heap, per slot. */
+  static constexpr size_t EXPECTED_SIZE = 24;
+
+ private:
+  const char *data_{nullptr};
+  uint32_t size_{0};
+};
+
+/**
+ * Function object that compares VarlenKeys on their bytes, then their sizes. Equal keys have equal bytes, since a
+ * tuple is serialized the same way for the same values, and the order is of no use to a hash table.
+ */
+class VarlenComparator {
+ public:
+  VarlenComparator() = default;
+
+  /** The key schema is not needed, but hash indexes build their comparator from it. */
+  explicit VarlenComparator(Schema * /* key_schema */) {}
+
+  inline int operator()(const VarlenKey &lhs, const VarlenKey &rhs) const {
+    const int cmp = memcmp(lhs.GetData(), rhs.GetData(), std::min(lhs.GetSize(), rhs.GetSize()));
+    if (cmp != 0) {
+      return cmp;
+    }
+    return static_cast<int>(lhs.GetSize() > rhs.GetSize()) - static_cast<int>(lhs.GetSize() < rhs.GetSize());
+  }
+};
+
+/** A VarlenKey is hashed over its bytes, not over the view itself. */
+template <>
+struct KeyHasher<VarlenKey> {
+  static uint64_t Hash(const VarlenKey &key) { return HashUtil::HashBytes(key.GetData(), key.GetSize()); }
+};
+
+}  // namespace bustub
@@ -11,14 +11,16 @@
 #pragma once
 
 #include <queue>
+#include <type_traits>
 
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE 32
+// the most slots that fit, which is when all the keys are empty
+#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(page_id_t) + 2 * sizeof(uint16_t)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,9 +29,24 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * The keys are of variable length: a key is stored without its trailing zero bytes, and
+ * KeyAt pads it with zeros again. Splitting a leaf page pushes up the shortest separator
+ * the comparator can find instead of the first key of the new page (suffix truncation),
+ * so wide keys take only a few bytes here. Each slot holds a child pointer and the
+ * offset and length of its key; the keys are stored from the end of the page backwards.
+ *
+ * Header format (size in byte, 32 bytes in total):
+ *  ---------------------------------------------------------------
+ * | BPlusTreePage header (28) | KeyBytes (2) | KeyHeapOffset (2) |
+ *  ---------------------------------------------------------------
+ *
+ *  --------------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | SLOT(n) | free space | KEY(n) | ... | KEY(0) |
+ *  --------------------------------------------------------------------------------
+ *
+ * Besides the max size, which bounds the number of children, a page overflows once it
+ * lacks the room to take one more entry with a full length key. It underflows only when
+ * it has fewer than min size children and fills less than half of the page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -43,10 +60,14 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  /** @return the index of the child whose subtree covers key, the one Lookup returns */
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
+  // append a child whose parent page id is already set, for bulk loading
+  void Append(const KeyType &key, const ValueType &value);
 
   // Split and Merge utility methods
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
@@ -56,10 +77,55 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                          BufferPoolManager *buffer_pool_manager);
 
+  /** @return true if the page has to be split */
+  bool IsOverflowing() const;
+  /** @return true if inserting one more entry may make the page overflow */
+  bool IsFull() const;
+  /** @return true if the page has to be merged or take entries from a sibling */
+  bool IsUnderflowing() const;
+  /** @return true if removing one entry may make the page underflow */
+  bool IsAtMinimum() const;
+  /** @return true if the entries of both pages and the separator between them fit on one page */
+  bool CanMergeWith(const BPlusTreeInternalPage *sibling) const;
+  /** @return true if the key at index can be replaced with key without making the page overflow */
+  bool CanReplaceKeyAt(int index, const KeyType &key) const;
+
+  /** @return the number of bytes the key takes up on the page */
+  static uint16_t StoredKeySize(const KeyType &key);
+  /** @return the number of entries with keys of key_size bytes that fit on the page without overflowing it */
+  static int Capacity(size_t key_size);
+
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
+  struct Slot {
+    ValueType value_;
+    uint16_t key_offset_;
+    uint16_t key_size_;
+  };
+  static constexpr size_t MAX_ENTRY_SIZE = sizeof(Slot) + sizeof(KeyType);
+  static_assert(std::is_trivially_copyable_v<KeyType>, "internal page keys are stored as raw bytes");
+  static_assert(PAGE_SIZE <= UINT16_MAX, "offsets into the page are 16 bits");
+  static_assert(sizeof(Slot) == sizeof(page_id_t) + 2 * sizeof(uint16_t), "slots must match INTERNAL_PAGE_SIZE");
+
+  /** @return true if size entries whose keys take key_bytes bytes fit on the page without overflowing it */
+  bool Fits(int size, size_t key_bytes) const;
+  /** Inserts the entry at index, shifting the entries from index on to the right. */
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  /** Stores the key in the key heap, which must have room for it next to num_slots slots. */
+  void StoreKey(Slot *slot, const KeyType &key, int num_slots);
+  /** Moves the keys to the end of the page, reclaiming the space of removed and replaced keys. */
+  void CompactKeys();
+  char *GetPageData() { return reinterpret_cast<char *>(this); }
+  const char *GetPageData() const { return reinterpret_cast<const char *>(this); }
+
+  void CopyNFrom(const BPlusTreeInternalPage *source, int start, int size, BufferPoolManager *buffer_pool_manager);
+  void CopyLastFrom(const KeyType &key, const ValueType &value, BufferPoolManager *buffer_pool_manager);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value, BufferPoolManager *buffer_pool_manager);
+  void Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager);
+
+  // number of bytes all the keys take up
+  uint16_t key_bytes_;
+  // the keys are stored from this offset to the end of the page, among the space of removed keys
+  uint16_t key_heap_offset_;
+  Slot slots_[0];
 };
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <cstdlib>
@@ -25,7 +26,7 @@ namespace bustub {
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
 
 // define page type enum
-enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
+enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE, POSTING_PAGE };
 
 /**
  * Both internal and leaf page are inherited from this page.
@@ -33,12 +34,16 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | Version (4) |
  * ----------------------------------------------------------------------------
+ *
+ * The version lets readers traverse the tree without latching the pages (optimistic latch coupling). A writer makes
+ * it odd before it modifies the page and even again once the whole operation is done; a reader notes the version,
+ * reads the page and afterwards checks that the version is unchanged, or else starts over.
  */
 class BPlusTreePage {
  public:
@@ -62,6 +67,20 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  /** @return the version of the page, to be checked with ValidateVersion after reading the page */
+  uint32_t GetVersion() const;
+  /** @return true if the version is not odd, i.e. no writer was modifying the page */
+  static bool IsStable(uint32_t version) { return (version & 1) == 0; }
+  /** @return true if the page did not change since its version was read */
+  bool ValidateVersion(uint32_t version) const;
+
+  /** Marks the page as being modified. The caller must hold the write latch of the page. */
+  void BeginWrite();
+  /** Marks the end of the modification started with BeginWrite. */
+  void EndWrite();
+  /** @return true between BeginWrite and EndWrite */
+  bool IsBeingWritten() const;
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_ __attribute__((__unused__));
@@ -70,6 +89,7 @@ class BPlusTreePage {
   int max_size_ __attribute__((__unused__));
   page_id_t parent_page_id_ __attribute__((__unused__));
   page_id_t page_id_ __attribute__((__unused__));
+  std::atomic<uint32_t> version_;
 };
 
 }  // namespace bustub
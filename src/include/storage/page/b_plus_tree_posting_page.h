@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 32
+#define POSTING_PAGE_SIZE ((PAGE_SIZE - POSTING_PAGE_HEADER_SIZE) / sizeof(RID))
+
+/**
+ * Store the record ids of a key with duplicates in a B+ tree with non-unique keys. A key with a single record id keeps
+ * it in its leaf entry; once it has more, they move to a chain of posting pages and the leaf entry refers to the first
+ * one instead, see ListRID. The key is thus stored once however many record ids it has.
+ *
+ * The posting pages of a key belong to its leaf page: they are only modified with the leaf page write latched, and
+ * read either with it read latched or optimistically, validating the version of the leaf page.
+ *
+ * Posting page format:
+ *  --------------------------------------------
+ * | HEADER | RID(1) | RID(2) | ... | RID(n) |
+ *  --------------------------------------------
+ *
+ *  Header format (size in byte, 32 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ *  --------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | Version (4) | NextPageId (4)
+ *  --------------------------------------------------------------
+ */
+class BPlusTreePostingPage : public BPlusTreePage {
+ public:
+  void Init(page_id_t page_id, page_id_t next_page_id = INVALID_PAGE_ID);
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  bool IsFull() const { return GetSize() >= GetMaxSize(); }
+
+  RID ValueAt(int index) const;
+  /** @return the index of the record id, -1 if it is not on the page */
+  int ValueIndex(const RID &value) const;
+  /** Appends the record id; the page must not be full. */
+  void Append(const RID &value);
+  /** Removes the record id at the index, moving the last one in its place. */
+  void RemoveAt(int index);
+  /** Removes the last record id. @return the record id */
+  RID RemoveLast();
+  void SetValueAt(int index, const RID &value);
+
+  /** @return the value of a leaf entry that refers to the posting list starting at the page */
+  static RID ListRID(page_id_t page_id) { return RID(page_id, POSTING_LIST_SLOT); }
+  /** @return true if the value of a leaf entry refers to a posting list, false if it is the record id itself */
+  static bool IsListRID(const RID &value) { return value.GetSlotNum() == POSTING_LIST_SLOT; }
+
+  /**
+   * Reads the record ids of a posting list.
+   * @param page_id the first page of the list
+   * @param[out] values the record ids, appended
+   * @param validate called after each page is read, before its next page id is followed; reading stops if it returns
+   * false, so that an optimistic reader never follows a page id it could not trust
+   * @return false if validate did
+   */
+  template <typename Validate>
+  static bool ReadList(BufferPoolManager *buffer_pool_manager, page_id_t page_id, std::vector<RID> *values,
+                       Validate &&validate) {
+    while (page_id != INVALID_PAGE_ID) {
+      Page *page = buffer_pool_manager->FetchPage(page_id);
+      if (page == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch posting page");
+      }
+      auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+      // An optimistic reader may see the size torn, it finds out when validating.
+      const int size = std::clamp(posting->GetSize(), 0, static_cast<int>(POSTING_PAGE_SIZE));
+      for (int i = 0; i < size; i++) {
+        values->push_back(posting->ValueAt(i));
+      }
+      page_id = posting->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
+      if (!validate()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // no record id of a tuple has this slot number
+  static constexpr uint32_t POSTING_LIST_SLOT = std::numeric_limits<uint32_t>::max();
+
+  page_id_t next_page_id_;
+  RID array_[0];
+};
+
+}  // namespace bustub
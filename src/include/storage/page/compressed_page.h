@@ -0,0 +1,315 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page.h
+//
+// Identification: src/include/storage/page/compressed_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class CompressedPageBuilder;
+
+/**
+ * Compressed page format:
+ *  -------------------------------------------------------------------------------------------------
+ *  | HEADER | SEGMENTS | DELETE BITS | SEGMENT DATA_1 | ... | SEGMENT DATA_n | ... FREE SPACE ... |
+ *  -------------------------------------------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| Magic (4) | TupleCount (4) |
+ *  ----------------------------------------------------------------------------------------------
+ *  ---------------------------------------
+ *  | ColumnCount (4) | InlineLength (4) |
+ *  ---------------------------------------
+ *  followed by a Segment for every column, and by two bitmaps of TupleCount bits, of the tuples marked deleted and of
+ *  the tuples deleted.
+ *
+ * A CompressedPage holds the tuples of cold table pages, packed column by column with a lightweight encoding picked
+ * per column: integers are bit-packed as offsets from the smallest value of the page (frame of reference) or, when
+ * they come in runs, run-length encoded; varlen values are dictionary encoded with bit-packed codes when the page has
+ * few distinct ones. Reads decode only the columns they read, see GetTupleColumns, and a predicate comparing a
+ * dictionary encoded column with a constant can compare codes, see FindCode.
+ *
+ * The page is built once, by CompressedPageBuilder, and never takes new tuples; its tuples can still be deleted. It
+ * shares the first 16 bytes of its header with TablePage, and Magic is where TablePage keeps its free space pointer,
+ * which never gets as large, so a page of a heap tells whether it is compressed, see IsCompressed.
+ */
+class CompressedPage : public Page {
+  friend class CompressedPageBuilder;
+
+ public:
+  /** @return true if the data of a table heap page is that of a CompressedPage */
+  static bool IsCompressed(const char *data) {
+    return *reinterpret_cast<const uint32_t *>(data + OFFSET_MAGIC) == COMPRESSED_PAGE_MAGIC;
+  }
+
+  /** @return the page ID of this table page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the page ID of the previous table page */
+  page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+
+  /** @return the page ID of the next table page */
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Set the page id of the previous page in the table. */
+  void SetPrevPageId(page_id_t prev_page_id) {
+    memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
+  }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /** A compressed page takes no new tuples. @return false */
+  bool InsertTuple(const Tuple & /*tuple*/, RID * /*rid*/, Transaction * /*txn*/, LockManager * /*lock_manager*/,
+                   LogManager * /*log_manager*/) {
+    return false;
+  }
+
+  /** A compressed page takes no new tuples. @return false */
+  bool AppendTuple(const Tuple & /*tuple*/, RID * /*rid*/) { return false; }
+
+  /** Log the whole page as one page image record, see TablePage::LogPageImage. */
+  void LogPageImage(Transaction *txn, LogManager *log_manager);
+
+  /** Mark a tuple as deleted, see TablePage::MarkDelete. */
+  bool MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /** A compressed tuple is not updated in place. @return false, for the update to delete and insert instead */
+  bool UpdateTuple(const Tuple & /*new_tuple*/, Tuple * /*old_tuple*/, const RID & /*rid*/, Transaction * /*txn*/,
+                   LockManager * /*lock_manager*/, LogManager * /*log_manager*/) {
+    return false;
+  }
+
+  /** To be called on commit. Actually perform the delete. */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /** To be called on commit. Actually perform deletes of the page, see TablePage::ApplyDeletes. */
+  void ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager);
+
+  /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
+  void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /** Read a tuple, decoded from all the segments, see TablePage::GetTuple. */
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * Reads some columns of a tuple, decoding only their segments, see PaxPage::GetTupleColumns.
+   * @param rid rid of the tuple to read
+   * @param column_ids the columns to read
+   * @param[out] buffer the memory of the tuple, reused from read to read
+   * @param[out] tuple the tuple that was read, a view of buffer
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTupleColumns(const RID &rid, const std::vector<uint32_t> &column_ids, std::vector<char> *buffer,
+                       Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * @param[out] first_rid the RID of the first tuple in this page
+   * @return true if the first tuple exists, false otherwise
+   */
+  bool GetFirstTupleRid(RID *first_rid);
+
+  /**
+   * @param cur_rid the RID of the current tuple
+   * @param[out] next_rid the RID of the tuple following the current tuple
+   * @return true if the next tuple exists, false otherwise
+   */
+  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
+
+  /** @return 0, a compressed page has no room for new tuples */
+  uint32_t GetFreeSpaceRemaining() { return 0; }
+
+  /**
+   * Looks a value up in the dictionary of a column, for a predicate to compare the codes of the tuples with its code.
+   * @param column_idx a column of the page
+   * @param value the value to look up
+   * @param[out] code the code of the value, the size of the dictionary if the page has no such value
+   * @return false if the column is not dictionary encoded, or the dictionary holds values stored out of line, which
+   * cannot be compared by code
+   */
+  bool FindCode(uint32_t column_idx, const Value &value, uint32_t *code);
+
+  /** @return the code of the value of a dictionary encoded column of the tuple of a slot */
+  uint32_t GetCode(uint32_t slot_num, uint32_t column_idx) {
+    const Segment &segment = *GetSegment(column_idx);
+    return ReadCode(segment, slot_num);
+  }
+
+  /** @return a copy of the tuple of a slot, deleted or not, e.g. for the log record of its delete */
+  Tuple CopyOutTuple(const RID &rid);
+
+ private:
+  /** How the values of a column are stored. */
+  enum class Encoding : uint8_t {
+    /** The inline values one after the other, or the varlen values with their offsets. */
+    PLAIN,
+    /** Integers as offsets from base_, of bit_width_ bits each. */
+    BITPACK,
+    /** Integers in count_ runs: the end (exclusive) of every run as a uint16_t, then the bit-packed run values. */
+    RLE,
+    /** Varlen values as codes of bit_width_ bits into a dictionary of count_ values. */
+    DICTIONARY
+  };
+
+  /** Where and how the values of a column are stored. */
+  struct Segment {
+    /** The frame of reference of the BITPACK and RLE integers. */
+    int64_t base_;
+    /** The offset of the data of the segment in the page. */
+    uint32_t offset_;
+    /** The number of runs of RLE, or of values of the dictionary. */
+    uint32_t count_;
+    /** The offset of the inline part of the column in a tuple. */
+    uint32_t tuple_offset_;
+    /** The width of the inline part of the column. */
+    uint16_t width_;
+    uint8_t type_id_;
+    Encoding encoding_;
+    uint8_t bit_width_;
+    uint8_t padding_[7];
+  };
+
+  static_assert(sizeof(page_id_t) == 4);
+  static_assert(sizeof(Segment) == 32);
+
+  static constexpr uint32_t COMPRESSED_PAGE_MAGIC = 0xC0DEC0DE;
+  static constexpr size_t SIZE_COMPRESSED_PAGE_HEADER = 32;
+  static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_MAGIC = 16;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 20;
+  static constexpr size_t OFFSET_COLUMN_COUNT = 24;
+  static constexpr size_t OFFSET_INLINE_LENGTH = 28;
+
+  uint32_t GetHeaderField(size_t offset) { return *reinterpret_cast<uint32_t *>(GetData() + offset); }
+  void SetHeaderField(size_t offset, uint32_t value) { memcpy(GetData() + offset, &value, sizeof(uint32_t)); }
+
+  uint32_t GetTupleCount() { return GetHeaderField(OFFSET_TUPLE_COUNT); }
+  uint32_t GetColumnCount() { return GetHeaderField(OFFSET_COLUMN_COUNT); }
+  /** @return the length of the inline part of a tuple */
+  uint32_t GetInlineLength() { return GetHeaderField(OFFSET_INLINE_LENGTH); }
+
+  Segment *GetSegment(uint32_t column_idx) {
+    return reinterpret_cast<Segment *>(GetData() + SIZE_COMPRESSED_PAGE_HEADER) + column_idx;
+  }
+  /** @return the bitmap of the tuples marked deleted, followed by the bitmap of the deleted ones */
+  uint8_t *GetDeleteBits() {
+    return reinterpret_cast<uint8_t *>(GetData() + SIZE_COMPRESSED_PAGE_HEADER + sizeof(Segment) * GetColumnCount());
+  }
+  bool IsMarkedDeleted(uint32_t slot_num) { return ((GetDeleteBits()[slot_num / 8] >> (slot_num % 8)) & 1) != 0; }
+  bool IsDeleted(uint32_t slot_num) {
+    uint32_t bit = GetTupleCount() + slot_num;
+    return IsMarkedDeleted(slot_num) || ((GetDeleteBits()[bit / 8] >> (bit % 8)) & 1) != 0;
+  }
+  void SetDeleteBit(uint32_t bit, bool set) {
+    uint8_t mask = static_cast<uint8_t>(1U << (bit % 8));
+    GetDeleteBits()[bit / 8] = set ? GetDeleteBits()[bit / 8] | mask : GetDeleteBits()[bit / 8] & ~mask;
+  }
+
+  /** @return the code of the tuple of a slot in a DICTIONARY segment */
+  uint32_t ReadCode(const Segment &segment, uint32_t slot_num);
+  /** Writes the inline value of the tuple of a slot of a segment of a fixed-width column to dest. */
+  void ReadFixed(const Segment &segment, uint32_t slot_num, char *dest);
+  /** @return the stored form of the value of the tuple of a slot of a segment of a varlen column, of size bytes */
+  const char *ReadVarlen(const Segment &segment, uint32_t slot_num, uint32_t *size);
+  /** @return the size of the tuple of a slot with only some of its varlen columns, or all of them if all is set */
+  uint32_t GetTupleSize(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all);
+  /** Writes the columns of the tuple of a slot to dest in the layout of a tuple, see PaxPage::ReadTuple. */
+  void ReadTuple(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all, char *dest, uint32_t size);
+  /** @return false if the tuple does not exist, after the checks and the locking of TablePage::GetTupleView */
+  bool CheckRead(const RID &rid, Transaction *txn, LockManager *lock_manager);
+};
+
+/**
+ * CompressedPageBuilder collects tuples for a CompressedPage, as long as they fit in one page, and writes the page.
+ *
+ * For every column it keeps what picking the smallest encoding needs, so that telling whether one more tuple fits
+ * takes a constant time per column.
+ */
+class CompressedPageBuilder {
+ public:
+  /** Creates a builder for the tuples of a schema. */
+  explicit CompressedPageBuilder(const Schema *schema);
+
+  /** @return false if the tuple does not fit in the page with the tuples added so far; it is then not added */
+  bool Add(const Tuple &tuple);
+
+  /** @return true if a tuple of a schema fits in a compressed page of its own */
+  static bool Fits(const Schema *schema, const Tuple &tuple) { return CompressedPageBuilder(schema).Add(tuple); }
+
+  /** @return the number of tuples added since the last Build */
+  uint32_t GetTupleCount() const { return tuple_count_; }
+
+  /**
+   * Writes the tuples added so far to a page, in the order they were added, and starts over with none.
+   * @param page the page to write, which need not be initialized
+   * @param page_id the id of the page
+   * @param prev_page_id the previous page of the heap
+   * @param next_page_id the next page of the heap
+   */
+  void Build(CompressedPage *page, page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id);
+
+ private:
+  using Encoding = CompressedPage::Encoding;
+
+  /** What sizing the encodings of a column needs, kept up to date tuple after tuple. */
+  struct Summary {
+    int64_t min_{0};
+    int64_t max_{0};
+    /** The number of runs of equal integers. */
+    uint32_t runs_{0};
+    /** The bytes of the stored forms of the varlen values of the dictionary. */
+    uint32_t dictionary_bytes_{0};
+    /** The bytes of the stored forms of the varlen values of all the tuples. */
+    uint32_t value_bytes_{0};
+  };
+
+  /** The values of a column. */
+  struct ColumnValues {
+    Summary summary_;
+    /** The values of an integer column. */
+    std::vector<int64_t> integers_;
+    /** The codes of the values of a varlen column into dictionary_. */
+    std::vector<uint32_t> codes_;
+    std::vector<std::string> dictionary_;
+    std::unordered_map<std::string, uint32_t> code_of_;
+    /** The inline values of any other column, one after the other. */
+    std::string fixed_;
+  };
+
+  /** @return the bytes of the data of a column, encoded in its smallest encoding, which is returned in encoding */
+  uint32_t SegmentSize(uint32_t column_idx, const Summary &summary, uint32_t dictionary_size, uint32_t tuple_count,
+                       Encoding *encoding, uint32_t *bit_width) const;
+
+  const Schema *schema_;
+  std::vector<ColumnValues> columns_;
+  uint32_t tuple_count_{0};
+};
+
+}  // namespace bustub
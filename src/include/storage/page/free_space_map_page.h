@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * A page of the free-space map of a table heap, see FreeSpaceMap.
+ *
+ * Each entry records a heap page and the category of its free space: the free bytes in units of
+ * FREE_SPACE_CATEGORY_SIZE, rounded down, so that a page of category c has at least c units free. The entries are
+ * appended in the order of the pages in the heap, and the pages of the map are chained.
+ *
+ * Format (size in byte):
+ * ------------------------------------------------------------------------------------
+ * | NextPageId (4) | Count (4) | HeapPageIds (4 * ENTRIES) | Categories (ENTRIES) | Free
+ * ------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  /** The bytes of free space of one unit of category. */
+  static constexpr uint32_t FREE_SPACE_CATEGORY_SIZE = PAGE_SIZE / 256;
+  /** The number of entries of a page. */
+  static constexpr uint32_t ENTRIES = (PAGE_SIZE - 2 * sizeof(uint32_t)) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+  /** @return the category of a page with free_bytes of free space */
+  static uint8_t CategoryOf(uint32_t free_bytes) {
+    uint32_t category = free_bytes / FREE_SPACE_CATEGORY_SIZE;
+    return static_cast<uint8_t>(category > UINT8_MAX ? UINT8_MAX : category);
+  }
+
+  /** @return the smallest category of which every page has at least free_bytes of free space */
+  static uint8_t CategoryFor(uint32_t free_bytes) {
+    uint32_t category = (free_bytes + FREE_SPACE_CATEGORY_SIZE - 1) / FREE_SPACE_CATEGORY_SIZE;
+    return static_cast<uint8_t>(category > UINT8_MAX ? UINT8_MAX : category);
+  }
+
+  /** Initializes the page with no entries and no next page. */
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  /** @return the next page of the map */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  /** Sets the next page of the map. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the number of entries */
+  uint32_t GetCount() const { return count_; }
+
+  /** @return true if the page has no room for another entry */
+  bool IsFull() const { return count_ == ENTRIES; }
+
+  /** @return the heap page of an entry, INVALID_PAGE_ID if the page was removed from the heap */
+  page_id_t HeapPageIdAt(uint32_t idx) const { return heap_page_ids_[idx]; }
+
+  /** Sets the heap page of an entry. */
+  void SetHeapPageIdAt(uint32_t idx, page_id_t heap_page_id) { heap_page_ids_[idx] = heap_page_id; }
+
+  /** @return the category of an entry */
+  uint8_t CategoryAt(uint32_t idx) const { return categories_[idx]; }
+
+  /** Sets the category of an entry. */
+  void SetCategoryAt(uint32_t idx, uint8_t category) { categories_[idx] = category; }
+
+  /**
+   * Appends an entry, the page must not be full.
+   * @return the index of the entry
+   */
+  uint32_t Append(page_id_t heap_page_id, uint8_t category);
+
+  /** @return the index of the first entry of at least a category, count if there is none */
+  uint32_t Find(uint8_t category) const;
+
+  /** @return the largest category of the entries, 0 if there are none */
+  uint8_t MaxCategory() const;
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t count_;
+  page_id_t heap_page_ids_[ENTRIES];
+  uint8_t categories_[ENTRIES];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE, "A free-space map page must fit in a page.");
+
+}  // namespace bustub
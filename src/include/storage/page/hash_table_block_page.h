@@ -13,25 +13,61 @@
 #pragma once
 
 #include <atomic>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "common/config.h"
 #include "storage/index/int_comparator.h"
+#include "storage/index/varlen_key.h"
 #include "storage/page/hash_table_page_defs.h"
 
 namespace bustub {
+
+/** The slot of a VarlenKey in a block page: where the bytes of the key are in the heap of the page, and its value. */
+template <typename ValueType>
+struct VarlenSlot {
+  uint16_t offset_;
+  uint16_t size_;
+  ValueType value_;
+};
+
+/** @return the bytes of a block page a slot takes up, control byte aside, see BLOCK_ARRAY_SIZE */
+template <typename KeyType, typename ValueType>
+constexpr size_t HashTableSlotSize() {
+  if constexpr (std::is_same_v<KeyType, VarlenKey>) {
+    return sizeof(VarlenSlot<ValueType>) + VarlenKey::EXPECTED_SIZE;
+  } else {
+    return sizeof(std::pair<KeyType, ValueType>);
+  }
+}
+
 /**
  * Store indexed key and and value together within block page. Supports
  * non-unique keys.
  *
  * Block page format (keys are stored in order):
- *  ----------------------------------------------------------------
- * | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
- *  ----------------------------------------------------------------
+ *  ------------------------------------------------------------------------------------
+ * | CONTROL(1) ... CONTROL(n) | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
+ *  ------------------------------------------------------------------------------------
  *
  *  Here '+' means concatenation.
  *
+ * The control byte of a slot tells whether it was ever occupied and whether it is readable, and a readable slot also
+ * keeps 7 bits of the hash of its key (its tag), in the manner of the SwissTable of Abseil. The slots are probed a
+ * group of BLOCK_GROUP_SIZE at a time: one SSE2 comparison of the control bytes of the group finds the slots whose tag
+ * matches the key, and only their keys are compared, and another finds the empty slots, which end a probe sequence.
+ *
+ * The keys of a block page of VarlenKeys are stored out of line, in a heap after the slots, which are VarlenSlots:
+ *  --------------------------------------------------------------------------------------------------
+ * | CONTROL(1) ... CONTROL(n) | SLOT(1) | ... | SLOT(n) | KEY(1) KEY(2) ... free space | HEAP SIZE(4) |
+ *  --------------------------------------------------------------------------------------------------
+ * The keys are appended to the heap, and their bytes are never reclaimed: a page whose heap is full takes no more
+ * keys, and the table grows as if the page were full.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBlockPage {
@@ -64,11 +100,21 @@ class HashTableBlockPage {
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
    * @param value value to insert
+   * @param tag the tag of the hash of the key, see TagOf
    * @return If the value is inserted successfully, it returns true. If the
    * index is marked as occupied before the key and value can be inserted,
    * Insert returns false.
    */
-  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value);
+  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value, uint8_t tag = 0);
+
+  /** @return false if the key is too large for any block page, only ever a VarlenKey larger than the whole heap */
+  static bool Fits(const KeyType &key) {
+    if constexpr (IS_VARLEN) {
+      return key.GetSize() <= HEAP_END - HEAP_BEGIN;
+    } else {
+      return true;
+    }
+  }
 
   /**
    * Removes a key and value at index.
@@ -93,12 +139,68 @@ class HashTableBlockPage {
    */
   bool IsReadable(slot_offset_t bucket_ind) const;
 
+  /**
+   * Hints the CPU to load the flags and the pair of an index into the cache ahead of a probe that reads them.
+   *
+   * @param bucket_ind index to be probed
+   */
+  void PrefetchSlot(slot_offset_t bucket_ind) const {
+    __builtin_prefetch(&control_[bucket_ind]);
+    __builtin_prefetch(&array_[bucket_ind]);
+  }
+
+  /** @return the tag of a hash, kept in the control byte of the slot of its key */
+  static uint8_t TagOf(uint64_t hash) { return static_cast<uint8_t>(hash & 0x7f); }
+
+  /**
+   * @param group_ind the first index of a group, a multiple of BLOCK_GROUP_SIZE
+   * @return a mask of the readable indexes of the group whose key has the tag, bit i for index group_ind + i
+   */
+  uint32_t MatchTag(slot_offset_t group_ind, uint8_t tag) const { return MatchControl(group_ind, READABLE | tag); }
+
+  /**
+   * @param group_ind the first index of a group, a multiple of BLOCK_GROUP_SIZE
+   * @return a mask of the indexes of the group never occupied, bit i for index group_ind + i
+   */
+  uint32_t MatchEmpty(slot_offset_t group_ind) const { return MatchControl(group_ind, EMPTY); }
+
  private:
-  std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
+  // The control bytes. A new page is zeroed, so EMPTY must be 0.
+  static constexpr uint8_t EMPTY = 0;
+  static constexpr uint8_t TOMBSTONE = 1;
+  // claimed by an insert that has yet to write the pair
+  static constexpr uint8_t CLAIMED = 2;
+  // set in the control byte of a readable index, along with the tag of its key
+  static constexpr uint8_t READABLE = 0x80;
+
+  static constexpr bool IS_VARLEN = std::is_same_v<KeyType, VarlenKey>;
+  using SlotType = std::conditional_t<IS_VARLEN, VarlenSlot<ValueType>, MappingType>;
+  // the offsets of the heap of VarlenKeys in the page, whose size is kept in its last bytes
+  static constexpr size_t HEAP_BEGIN = BLOCK_ARRAY_SIZE * (1 + sizeof(SlotType));
+  static constexpr size_t HEAP_END = PAGE_SIZE - sizeof(uint32_t);
+
+  /** @return the number of bytes of the heap of a page of VarlenKeys taken */
+  std::atomic<uint32_t> *HeapSize() {
+    return reinterpret_cast<std::atomic<uint32_t> *>(reinterpret_cast<char *>(this) + HEAP_END);
+  }
+
+  /** @return a mask of the indexes of the group whose control byte is the one given */
+  uint32_t MatchControl(slot_offset_t group_ind, uint8_t control) const {
+#if defined(__SSE2__)
+    const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&control_[group_ind]));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(control)))));
+#else
+    uint32_t mask = 0;
+    for (slot_offset_t i = 0; i < BLOCK_GROUP_SIZE; i++) {
+      mask |= static_cast<uint32_t>(control_[group_ind + i].load(std::memory_order_relaxed) == control) << i;
+    }
+    return mask;
+#endif
+  }
 
-  // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  std::atomic_char readable_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
-  MappingType array_[0];
+  std::atomic<uint8_t> control_[BLOCK_ARRAY_SIZE];
+  SlotType array_[0];
 };
 
 }  // namespace bustub
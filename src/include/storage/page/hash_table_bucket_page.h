@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_bucket_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Store indexed key and value together within a bucket page of an extendible hash table. Supports non-unique keys,
+ * but not duplicate (key, value) pairs.
+ *
+ * Unlike block pages, buckets are latched with their page and never probed past, so a removed pair simply frees its
+ * slot and there are no tombstones.
+ *
+ * Bucket page format (keys are stored in no particular order):
+ *  --------------------------------------------------------------------------
+ * | READABLE BITMAP | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
+ *  --------------------------------------------------------------------------
+ *
+ *  Here '+' means concatenation.
+ *
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableBucketPage() = delete;
+
+  /** Empties the bucket. */
+  void Init();
+
+  /**
+   * Scans the bucket and collects the values of the key.
+   *
+   * @param key key to look up
+   * @param comparator comparator for keys
+   * @param[out] result the values are appended to it
+   * @return true if the key has any value in the bucket
+   */
+  bool GetValue(const KeyType &key, const KeyComparator &comparator, std::vector<ValueType> *result) const;
+
+  /**
+   * Inserts a key and value into a free slot of the bucket.
+   *
+   * @return false if the bucket is full or already has the pair, true otherwise
+   */
+  bool Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+
+  /**
+   * Removes a key and value from the bucket.
+   *
+   * @return true if the pair was in the bucket
+   */
+  bool Remove(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+
+  /**
+   * Gets the key at an index in the bucket.
+   *
+   * @param bucket_idx the index in the bucket to get the key at
+   * @return key at index bucket_idx of the bucket
+   */
+  KeyType KeyAt(uint32_t bucket_idx) const;
+
+  /**
+   * Gets the value at an index in the bucket.
+   *
+   * @param bucket_idx the index in the bucket to get the value at
+   * @return value at index bucket_idx of the bucket
+   */
+  ValueType ValueAt(uint32_t bucket_idx) const;
+
+  /**
+   * Frees the slot at an index in the bucket.
+   *
+   * @param bucket_idx index to remove the pair at
+   */
+  void RemoveAt(uint32_t bucket_idx);
+
+  /**
+   * Returns whether or not an index holds a key/value pair
+   *
+   * @param bucket_idx index to look at
+   * @return true if the index is readable, false otherwise
+   */
+  bool IsReadable(uint32_t bucket_idx) const;
+
+  /**
+   * @return the number of key/value pairs in the bucket
+   */
+  uint32_t NumReadable() const;
+
+  /**
+   * @return true if no slot of the bucket is free
+   */
+  bool IsFull() const;
+
+  /**
+   * @return true if the bucket holds no pair
+   */
+  bool IsEmpty() const;
+
+ private:
+  void SetReadable(uint32_t bucket_idx, bool readable);
+
+  // 1 if the slot holds a key/value pair, 0 if it is free.
+  char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  MappingType array_[0];
+};
+
+}  // namespace bustub
@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Directory Page for extendible hash table.
+ *
+ * The directory entry at index i holds the bucket for the keys whose hash ends in the global depth bits of i. A bucket
+ * of local depth d is shared by the 2^(global depth - d) entries that end in the same d bits; those bits are the
+ * local depth mask of the entries.
+ *
+ * Directory format (size in byte):
+ * --------------------------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
+ * --------------------------------------------------------------------------------------------
+ */
+class HashTableDirectoryPage {
+ public:
+  /**
+   * Initializes the directory with global depth 0, its single entry holding the bucket page.
+   *
+   * @param page_id the page id of this page
+   * @param bucket_page_id the page id of the first bucket
+   */
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * Sets the page ID of this page
+   *
+   * @param page_id the page id for the page id field to be set to
+   */
+  void SetPageId(page_id_t page_id);
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number for the lsn field to be set to
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @return the global depth of the directory
+   */
+  uint32_t GetGlobalDepth() const;
+
+  /**
+   * @return a mask of the global depth low bits of a hash, which make its directory index
+   */
+  uint32_t GetGlobalDepthMask() const;
+
+  /**
+   * @return the number of entries in the directory, 2^global depth
+   */
+  uint32_t Size() const;
+
+  /**
+   * Doubles the directory, each new entry holding the bucket of the entry it is the image of.
+   * The global depth must be less than DIRECTORY_MAX_DEPTH.
+   */
+  void IncrGlobalDepth();
+
+  /**
+   * Halves the directory; CanShrink must be true.
+   */
+  void DecrGlobalDepth();
+
+  /**
+   * @return true if no bucket has a local depth equal to the global depth, so the directory can be halved
+   */
+  bool CanShrink() const;
+
+  /**
+   * @param bucket_idx the index in the directory
+   * @return the page id of the bucket of the entry
+   */
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+
+  /**
+   * Sets the page id of the bucket of an entry
+   *
+   * @param bucket_idx the index in the directory
+   * @param bucket_page_id the page id of the bucket
+   */
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /**
+   * @param bucket_idx the index in the directory
+   * @return the local depth of the bucket of the entry
+   */
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+
+  /**
+   * Sets the local depth of the bucket of an entry
+   *
+   * @param bucket_idx the index in the directory
+   * @param local_depth the local depth
+   */
+  void SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth);
+
+  /**
+   * @param bucket_idx the index in the directory
+   * @return a mask of the local depth low bits of a hash, which all keys of the bucket of the entry share
+   */
+  uint32_t GetLocalDepthMask(uint32_t bucket_idx) const;
+
+  /**
+   * @param bucket_idx the index in the directory, whose bucket must have a local depth greater than 0
+   * @return the index of the entry of the bucket the bucket of this entry split from, or would merge with: it differs
+   * in the highest bit of the local depth
+   */
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+  /**
+   * Asserts that the directory is consistent: each bucket is held by all and only the entries that end in the same
+   * local depth bits, with the same local depth, which is not greater than the global depth.
+   */
+  void VerifyIntegrity() const;
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+};
+
+}  // namespace bustub
@@ -14,11 +14,25 @@
 
 #define MappingType std::pair<KeyType, ValueType>
 
-/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in   * a block page. It is an approximate
- * calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType). For each key/value
- * pair, we need two additional bits for occupied_ and readable_. 4 * PAGE_SIZE / (4 * sizeof (MappingType) + 1) =
- * PAGE_SIZE/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required to maintain the occupied
- * and readable flags for a key value pair.*/
-#define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+/** The slots of a block page are probed BLOCK_GROUP_SIZE at a time, their control bytes matched in one instruction. */
+#define BLOCK_GROUP_SIZE 16
+
+/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a block page. For each key/value pair,
+ * we need an additional control byte, so a page holds PAGE_SIZE / (sizeof (MappingType) + 1) of them, rounded down to
+ * whole groups of BLOCK_GROUP_SIZE so that no group straddles two block pages. The slot of a VarlenKey takes the room
+ * of its expected bytes in the heap besides, see HashTableSlotSize. */
+#define BLOCK_ARRAY_SIZE \
+  (PAGE_SIZE / (HashTableSlotSize<KeyType, ValueType>() + 1) / BLOCK_GROUP_SIZE * BLOCK_GROUP_SIZE)
 
 #define HASH_TABLE_BLOCK_TYPE HashTableBlockPage<KeyType, ValueType, KeyComparator>
+
+/** BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hash table bucket page.
+ * Buckets are not probed, so they need no tombstones and keep a single readable_ bit per key/value pair: 8 * PAGE_SIZE
+ * / (8 * sizeof (MappingType) + 1) = PAGE_SIZE / (sizeof (MappingType) + 0.125). */
+#define BUCKET_ARRAY_SIZE (8 * PAGE_SIZE / (8 * sizeof(MappingType) + 1))
+
+#define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+/** The directory of an extendible hash table fits a single page, so is at most 2^DIRECTORY_MAX_DEPTH entries long. */
+#define DIRECTORY_MAX_DEPTH 9
+#define DIRECTORY_ARRAY_SIZE (1 << DIRECTORY_MAX_DEPTH)
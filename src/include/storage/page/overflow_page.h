@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * OverflowPage format:
+ *
+ * Sizes are in bytes.
+ * | PageId (4) | LSN (4) | NextPageId (4) | Size (4) | Data (Size) | (free space) |
+ *
+ * An overflow page holds a chunk of a varlen value stored out of line, see Toast. The chunks of a value are chained
+ * from its first chunk on, and are written once, before the tuple pointing to them is inserted. Each is logged whole in
+ * an OVERFLOWPAGE record, whose redo checks the page id and LSN of the page header like that of any table page.
+ */
+class OverflowPage : public Page {
+ public:
+  /** The most bytes of data a page holds. */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - SIZE_PAGE_HEADER - 2 * sizeof(uint32_t);
+
+  /** Initializes the page with a chunk of data of at most CAPACITY bytes, followed by the chunk of next_page_id. */
+  void Init(page_id_t page_id, const char *data, uint32_t size, page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_PAGE_START, &page_id, sizeof(page_id_t));
+    SetLSN(INVALID_LSN);
+    SetNextPageId(next_page_id);
+    memcpy(GetData() + OFFSET_SIZE, &size, sizeof(uint32_t));
+    memcpy(GetData() + OFFSET_DATA, data, size);
+  }
+
+  /** @return the next page of the chain, INVALID_PAGE_ID for the last one */
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Sets the next page of the chain. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /** @return the number of bytes of data of the page */
+  uint32_t GetSize() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_SIZE); }
+
+  /** @return the data of the page */
+  const char *GetChunk() { return GetData() + OFFSET_DATA; }
+
+ private:
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = SIZE_PAGE_HEADER;
+  static constexpr size_t OFFSET_SIZE = SIZE_PAGE_HEADER + 4;
+  static constexpr size_t OFFSET_DATA = SIZE_PAGE_HEADER + 8;
+};
+
+}  // namespace bustub
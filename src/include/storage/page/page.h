@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,17 +27,21 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data of a frame of a buffer pool lives apart from its Page, in the region of page data of the pool, see
+ * BufferFrames, so that the book-keeping of the frames stays packed, one cache line or so each.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferFrames;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor, for a page outside any buffer pool. Allocates the page data and zeros it out. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Destructor. Frees the swizzled references of the page, if it has any. */
+  ~Page() { delete[] swips_.load(); }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
@@ -42,8 +49,8 @@ class Page {
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
 
-  /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  /** @return the pin count of this page, 0 for a frame claimed by its buffer pool */
+  inline int GetPinCount() { return std::max(pin_count_.load(), 0); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
@@ -57,6 +64,9 @@ class Page {
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if it is free of writers. @return true if the latch is acquired */
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
@@ -66,6 +76,15 @@ class Page {
   /** Sets the page LSN. */
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
 
+  /**
+   * @return the recovery LSN: the records that modified the page since it was last read or written back have an LSN
+   * at least this one, and are in the log at or after GetRecLogOffset()
+   */
+  inline lsn_t GetRecLSN() { return rec_lsn_; }
+
+  /** @return the offset in the log file the records since the recovery LSN are at or after */
+  inline int64_t GetRecLogOffset() { return rec_log_offset_; }
+
  protected:
   static_assert(sizeof(page_id_t) == 4);
   static_assert(sizeof(lsn_t) == 4);
@@ -78,16 +97,33 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** Creates a frame of a buffer pool, whose zeroed page data the pool holds. */
+  explicit Page(char *data) : data_(data) {}
+
+  /** The page data of a page outside any buffer pool. */
+  std::unique_ptr<char[]> owned_data_;
+  /** The actual data that is stored within a page, PAGE_SIZE bytes. */
+  char *data_;
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /**
+   * The pin count of this page. A frame its buffer pool has claimed, being free or handed to another page, has it
+   * negative, so that a fetch pinning it without the latch of the pool can tell, see BufferPoolManager::FRAME_CLAIMED.
+   */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /** The next LSN of the log when the page was last read or written back. */
+  lsn_t rec_lsn_ = 0;
+  /** The end of the log file when the page was last read or written back. */
+  int64_t rec_log_offset_ = 0;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /**
+   * The frames of the pages the page refers to, one per slot, as they were when last fetched through it, see
+   * BufferPoolManager::FetchChildPage; allocated on first use and kept by the frame for the pages it holds next.
+   */
+  std::atomic<std::atomic<Page *> *> swips_{nullptr};
 };
 
 }  // namespace bustub
@@ -0,0 +1,252 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.h
+//
+// Identification: src/include/storage/page/pax_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/page/page.h"
+#include "storage/page/table_page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PAX (partition attributes across) page format:
+ *  -----------------------------------------------------------------------------------------------------
+ *  | HEADER | COLUMNS | SLOTS | MINIPAGE_1 | ... | MINIPAGE_n | ... FREE SPACE ... | ... VARLEN DATA ... |
+ *  -----------------------------------------------------------------------------------------------------
+ *                                                                                ^
+ *                                                                                varlen pointer
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| TupleCount (4) | UsedSlots (4) |
+ *  ----------------------------------------------------------------------------------------------
+ *  --------------------------------------------------------------------------
+ *  | Capacity (4) | ColumnCount (4) | VarlenPointer (4) | FragmentedSpace (4) |
+ *  --------------------------------------------------------------------------
+ *  followed by a ColumnDescriptor for every column, and by the size of the tuple of each of the Capacity slots.
+ *
+ * A PaxPage holds the same tuples a TablePage does, but column by column: minipage i holds the inline part of column
+ * i for every slot, at its fixed width, and the varlen values of all the columns are stored in the varlen data at the
+ * end of the page, their minipage holding their offset. A scan reading a few columns only touches their minipages,
+ * see GetTupleColumns.
+ *
+ * The page describes its own layout, so none of its methods needs the schema past Init, and it shares the first 16
+ * bytes of its header with TablePage, so a chain of pages reads the same whatever the format of its pages. Slots are
+ * reused, and the space of the varlen values of deleted or updated tuples is reclaimed by compacting the varlen data
+ * when an insert or an update needs it, like TablePage does.
+ */
+class PaxPage : public Page {
+ public:
+  /**
+   * Initialize the PaxPage header and the layout of its minipages for the tuples of a schema.
+   * @param page_id the page ID of this page
+   * @param page_size the size of this page
+   * @param prev_page_id the previous table page ID
+   * @param log_manager the log manager in use
+   * @param txn the transaction that this page is created in
+   * @param schema the schema of the tuples of the page
+   */
+  void Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+            const Schema *schema);
+
+  /** @return the most bytes of a tuple of the schema that fits in an empty page */
+  static uint32_t GetMaxTupleSize(const Schema *schema);
+
+  /** @return the page ID of this table page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the page ID of the previous table page */
+  page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+
+  /** @return the page ID of the next table page */
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Set the page id of the previous page in the table. */
+  void SetPrevPageId(page_id_t prev_page_id) {
+    memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
+  }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /** Insert a tuple into the page, see TablePage::InsertTuple. */
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /** Append a tuple to a page that is not visible to other transactions yet, see TablePage::AppendTuple. */
+  bool AppendTuple(const Tuple &tuple, RID *rid);
+
+  /** Log the whole page as one page image record, see TablePage::LogPageImage. */
+  void LogPageImage(Transaction *txn, LogManager *log_manager);
+
+  /** Mark a tuple as deleted, see TablePage::MarkDelete. */
+  bool MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /** Update a tuple, see TablePage::UpdateTuple. */
+  bool UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                   LockManager *lock_manager, LogManager *log_manager);
+
+  /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /** To be called on commit. Actually perform deletes of the page, see TablePage::ApplyDeletes. */
+  void ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager);
+
+  /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
+  void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /** Read a tuple, reassembled from the minipages, see TablePage::GetTuple. */
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * Reads some columns of a tuple, from their minipages only. The tuple has the layout of a whole tuple of the schema,
+   * but the other columns read as zero, or NULL for varlen columns.
+   * @param rid rid of the tuple to read
+   * @param column_ids the columns to read
+   * @param[out] buffer the memory of the tuple, reused from read to read
+   * @param[out] tuple the tuple that was read, a view of buffer
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTupleColumns(const RID &rid, const std::vector<uint32_t> &column_ids, std::vector<char> *buffer,
+                       Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * @param[out] first_rid the RID of the first tuple in this page
+   * @return true if the first tuple exists, false otherwise
+   */
+  bool GetFirstTupleRid(RID *first_rid);
+
+  /**
+   * @param cur_rid the RID of the current tuple
+   * @param[out] next_rid the RID of the tuple following the current tuple
+   * @return true if the next tuple exists, false otherwise
+   */
+  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
+
+  /**
+   * @return the bytes of free space of the page, in the terms of TablePage::GetSpaceNeeded: a tuple of n bytes fits
+   * iff TablePage::GetSpaceNeeded(n) bytes are free; 0 when no slot is free
+   */
+  uint32_t GetFreeSpaceRemaining() {
+    return GetUsedSlots() == GetCapacity() ? 0 : TablePage::GetSpaceNeeded(GetInlineLength() + GetVarlenSpace());
+  }
+
+  /** Moves the varlen values to the end of the page, leaving no hole among them. Every tuple keeps its slot. */
+  void Compact();
+
+  /** @return a copy of the tuple of a slot, deleted or not, e.g. for the log record of its delete */
+  Tuple CopyOutTuple(const RID &rid);
+
+ private:
+  /** Where a column is on the page and in its tuples. */
+  struct ColumnDescriptor {
+    /** The offset of the minipage of the column in the page. */
+    uint32_t minipage_offset_;
+    /** The offset of the inline part of the column in a tuple. */
+    uint32_t tuple_offset_;
+    /** The width of the inline part of the column. */
+    uint16_t width_;
+    /** 1 if the column is varlen, whose minipage holds the offsets of its values in the page. */
+    uint16_t is_varlen_;
+  };
+
+  static_assert(sizeof(page_id_t) == 4);
+  static_assert(sizeof(ColumnDescriptor) == 12);
+
+  /**
+   * Lays the minipages of a page out for the tuples of a schema.
+   * @param[out] capacity the number of slots of the page
+   * @param[out] columns the descriptors of the columns, if not nullptr
+   * @return the end of the last minipage
+   */
+  static uint32_t Layout(const Schema *schema, uint32_t page_size, uint32_t *capacity,
+                         std::vector<ColumnDescriptor> *columns);
+
+  static constexpr size_t SIZE_PAX_PAGE_HEADER = 40;
+  static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 16;
+  static constexpr size_t OFFSET_USED_SLOTS = 20;
+  static constexpr size_t OFFSET_CAPACITY = 24;
+  static constexpr size_t OFFSET_COLUMN_COUNT = 28;
+  static constexpr size_t OFFSET_VARLEN_POINTER = 32;
+  static constexpr size_t OFFSET_FRAGMENTED_SPACE = 36;
+  /** The bytes a varlen value is expected to take when sizing the minipages, with its length. */
+  static constexpr uint32_t EXPECTED_VARLEN_SIZE = 36;
+
+  uint32_t GetHeaderField(size_t offset) { return *reinterpret_cast<uint32_t *>(GetData() + offset); }
+  void SetHeaderField(size_t offset, uint32_t value) { memcpy(GetData() + offset, &value, sizeof(uint32_t)); }
+
+  /** @return one past the last slot that was ever used, up to the empty slots at the end */
+  uint32_t GetTupleCount() { return GetHeaderField(OFFSET_TUPLE_COUNT); }
+  /** @return the number of slots holding a tuple */
+  uint32_t GetUsedSlots() { return GetHeaderField(OFFSET_USED_SLOTS); }
+  /** @return the number of slots of the page */
+  uint32_t GetCapacity() { return GetHeaderField(OFFSET_CAPACITY); }
+  uint32_t GetColumnCount() { return GetHeaderField(OFFSET_COLUMN_COUNT); }
+  /** @return the start of the varlen data */
+  uint32_t GetVarlenPointer() { return GetHeaderField(OFFSET_VARLEN_POINTER); }
+  /** @return the bytes of the holes among the varlen data */
+  uint32_t GetFragmentedSpace() { return GetHeaderField(OFFSET_FRAGMENTED_SPACE); }
+
+  ColumnDescriptor *GetColumnDescriptor(uint32_t column_idx) {
+    return reinterpret_cast<ColumnDescriptor *>(GetData() + SIZE_PAX_PAGE_HEADER) + column_idx;
+  }
+  /** @return the size of the tuple in a slot, with the deleted flag of TablePage; 0 if the slot is empty */
+  uint32_t GetTupleSize(uint32_t slot_num) { return GetSlots()[slot_num]; }
+  void SetTupleSize(uint32_t slot_num, uint32_t size) { memcpy(GetSlots() + slot_num, &size, sizeof(uint32_t)); }
+  uint32_t *GetSlots() {
+    return reinterpret_cast<uint32_t *>(GetData() + SIZE_PAX_PAGE_HEADER + sizeof(ColumnDescriptor) * GetColumnCount());
+  }
+  /** @return the inline part of a column of the tuple of a slot */
+  char *GetColumnData(const ColumnDescriptor &column, uint32_t slot_num) {
+    return GetData() + column.minipage_offset_ + column.width_ * slot_num;
+  }
+  /** @return the page offset of a varlen value of the tuple of a slot */
+  uint32_t GetVarlenOffset(const ColumnDescriptor &column, uint32_t slot_num) {
+    return *reinterpret_cast<uint32_t *>(GetColumnData(column, slot_num));
+  }
+  /** @return the length of the inline part of a tuple */
+  uint32_t GetInlineLength();
+  /** @return the end of the last minipage */
+  uint32_t GetMinipagesEnd();
+  /** @return the bytes of free space for varlen values, between the minipages and the varlen data or in holes */
+  uint32_t GetVarlenSpace() { return GetVarlenPointer() - GetMinipagesEnd() + GetFragmentedSpace(); }
+
+  /** @return the bytes of the varlen values of the tuple of a slot */
+  uint32_t GetVarlenSize(uint32_t slot_num);
+  /** @return true if the tuple fits in the page once freed_varlen_size more bytes of varlen values are freed */
+  bool Fits(const Tuple &tuple, uint32_t freed_varlen_size) {
+    return tuple.GetLength() - GetInlineLength() <= GetVarlenSpace() + freed_varlen_size;
+  }
+  /** Stores a tuple in a slot, which must fit. */
+  void WriteTuple(const Tuple &tuple, uint32_t slot_num);
+  /** Frees the varlen values of the tuple of a slot; they stay readable until the varlen data is compacted. */
+  void FreeVarlenValues(uint32_t slot_num);
+  /** Writes the columns of the tuple of a slot to dest in the layout of a tuple, or all the columns if all is set. */
+  void ReadTuple(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all, char *dest, uint32_t size);
+  /** @return the slot of a tuple to read, after the checks and the locking of TablePage::GetTupleView */
+  bool CheckRead(const RID &rid, Transaction *txn, LockManager *lock_manager);
+};
+
+}  // namespace bustub
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <cstring>
+#include <vector>
 
 #include "common/rid.h"
 #include "concurrency/lock_manager.h"
@@ -36,10 +37,17 @@ namespace bustub {
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------
+ *  | TupleCount (4) | FragmentedSpace (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  ---------------------------------------------------------------------------------------
  *
+ *  Deleting or moving a tuple leaves a hole among the inserted tuples rather than shifting the others, and
+ *  FragmentedSpace counts the bytes of the holes. An insert or an update that needs more room than the free space has
+ *  compacts the page first, see Compact, which keeps every tuple in its slot so that RIDs stay stable. Empty slots
+ *  are reused by inserts, and the ones at the end of the slot array are dropped.
+ *
+ *  The changes made without a transaction, those of the recovery, are neither locked nor logged, even while logging
+ *  is enabled. Without a log manager, those of the pages of an unlogged table, they are locked but not logged.
  */
 class TablePage : public Page {
  public:
@@ -77,17 +85,42 @@ class TablePage : public Page {
    * @param tuple tuple to insert
    * @param[out] rid rid of the inserted tuple
    * @param txn transaction performing the insert
-   * @param lock_manager the lock manager
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
    * @param log_manager the log manager
    * @return true if the insert is successful (i.e. there is enough space)
    */
   bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
 
+  /**
+   * Appends a tuple to a page that is not visible to other transactions yet, e.g. a fresh page of a bulk insert.
+   * Unlike InsertTuple, no free slot is reused, and the tuple is neither locked nor logged; see LogPageImage.
+   * @param tuple tuple to append
+   * @param[out] rid rid of the appended tuple
+   * @return true if the append succeeds, i.e. the tuple fits in the free space
+   */
+  bool AppendTuple(const Tuple &tuple, RID *rid);
+
+  /**
+   * Puts a tuple back in the slot it was deleted from, undoing an ApplyDelete of a transaction the recovery rolls
+   * back. The tuple is neither locked nor logged.
+   * @param tuple the tuple that was deleted
+   * @param rid rid of the tuple
+   * @return true if the slot is free and the tuple fits in the free space
+   */
+  bool RestoreTuple(const Tuple &tuple, const RID &rid);
+
+  /**
+   * Logs the whole page as one page image record, standing in for the records of the tuples appended to it.
+   * @param txn transaction that filled the page
+   * @param log_manager the log manager
+   */
+  void LogPageImage(Transaction *txn, LogManager *log_manager);
+
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
    * @param rid rid of the tuple to mark as deleted
    * @param txn transaction performing the delete
-   * @param lock_manager the lock manager
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
    * @param log_manager the log manager
    * @return true if marking the tuple as deleted is successful (i.e the tuple exists)
    */
@@ -99,16 +132,40 @@ class TablePage : public Page {
    * @param[out] old_tuple old value of the tuple
    * @param rid rid of the tuple
    * @param txn transaction performing the update
-   * @param lock_manager the lock manager
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
    * @param log_manager the log manager
    * @return true if updating the tuple succeeded
    */
   bool UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
                    LockManager *lock_manager, LogManager *log_manager);
 
+  /**
+   * Add to integer columns of a tuple in place, under an increment lock, see ColumnIncrement.
+   * @param increments the increments
+   * @param undo true to take the increments out, rolling them back, which is not checked against the column ranges
+   * @param rid rid of the tuple
+   * @param[out] old_tuple the tuple before, with the increments of the transactions adding to it at once
+   * @param[out] new_tuple the tuple after
+   * @param txn transaction performing the increment
+   * @param lock_manager the lock manager, nullptr if a lock of txn covers the row lock
+   * @param log_manager the log manager
+   * @return true if incrementing the tuple succeeded, false if it does not exist or a value would overflow its type
+   */
+  bool IncrementTuple(const std::vector<ColumnIncrement> &increments, bool undo, const RID &rid, Tuple *old_tuple,
+                      Tuple *new_tuple, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
   /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
   void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
 
+  /**
+   * To be called on commit. Actually perform the deletes of tuples of the page, logged in one APPLYDELETES record
+   * rather than a record each.
+   * @param rids rids of the tuples, of this page
+   * @param txn transaction performing the deletes
+   * @param log_manager the log manager
+   */
+  void ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager);
+
   /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
   void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
 
@@ -117,11 +174,22 @@ class TablePage : public Page {
    * @param rid rid of the tuple to read
    * @param[out] tuple the tuple that was read
    * @param txn transaction performing the read
-   * @param lock_manager the lock manager
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
    * @return true if the read is successful (i.e. the tuple exists)
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Reads a tuple from a table without copying it: the tuple is pointed at the data of the page, and is only valid for
+   * as long as the page stays pinned and read latched.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read, which does not own its data
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager, nullptr if a table lock of txn covers the row lock
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTupleView(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
   /** @return the rid of the first tuple in this page */
 
   /**
@@ -137,17 +205,33 @@ class TablePage : public Page {
    */
   bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
 
+  /** @return the bytes of free space of the page, between the slot array and the tuples or in holes among them */
+  uint32_t GetFreeSpaceRemaining() { return GetContiguousFreeSpace() + GetFragmentedSpace(); }
+
+  /**
+   * Moves the tuples to the end of the page, leaving no hole among them, so that all the free space of the page is
+   * between the slot array and the tuples. Every tuple keeps its slot.
+   */
+  void Compact();
+
+  /** @return the bytes of free space a new tuple of tuple_size bytes takes, with its slot */
+  static uint32_t GetSpaceNeeded(uint32_t tuple_size) { return tuple_size + SIZE_TUPLE; }
+
+  /** @return a copy of the tuple of a slot, deleted or not, e.g. for the log record of its delete */
+  Tuple CopyOutTuple(const RID &rid);
+
  private:
   static_assert(sizeof(page_id_t) == 4);
 
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 28;
   static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;  // Naming things is hard.
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_FRAGMENTED_SPACE = 24;
+  static constexpr size_t OFFSET_TUPLE_OFFSET = 28;  // Naming things is hard.
+  static constexpr size_t OFFSET_TUPLE_SIZE = 32;
 
   /** @return pointer to the end of the current free space, see header comment */
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
@@ -166,10 +250,23 @@ class TablePage : public Page {
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
+  /** @return the bytes of the holes among the tuples */
+  uint32_t GetFragmentedSpace() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FRAGMENTED_SPACE); }
+
+  /** Set the bytes of the holes among the tuples. */
+  void SetFragmentedSpace(uint32_t fragmented_space) {
+    memcpy(GetData() + OFFSET_FRAGMENTED_SPACE, &fragmented_space, sizeof(uint32_t));
+  }
+
+  /** @return the bytes of free space between the slot array and the tuples */
+  uint32_t GetContiguousFreeSpace() {
     return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
   }
 
+  /** Drops the empty slots at the end of the slot array. */
+  void TrimEmptySlots();
+
+
   /** @return tuple offset at slot slot_num */
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
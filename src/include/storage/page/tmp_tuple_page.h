@@ -1,15 +1,13 @@
 #pragma once
 
+#include <cstring>
+
 #include "storage/page/page.h"
 #include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
-// To pass the test cases for this class, you must follow the existing TmpTuplePage format and implement the
-// existing functions exactly as they are! It may be helpful to look at TablePage.
-// Remember that this task is optional, you get full credit if you finish the next task.
-
 /**
  * TmpTuplePage format:
  *
@@ -17,17 +15,62 @@ namespace bustub {
  * | PageId (4) | LSN (4) | FreeSpace (4) | (free space) | TupleSize2 | TupleData2 | TupleSize1 | TupleData1 |
  *
  * We choose this format because DeserializeExpression expects to read Size followed by Data.
+ *
+ * Tuples grow from the end of the page towards the header, so the tuples of a page are read back from the free space
+ * pointer to the end of the page, most recently inserted first.
  */
 class TmpTuplePage : public Page {
  public:
-  void Init(page_id_t page_id, uint32_t page_size) {}
+  /** Initializes an empty page of page_size bytes. */
+  void Init(page_id_t page_id, uint32_t page_size) {
+    memcpy(GetData() + OFFSET_PAGE_ID, &page_id, sizeof(page_id_t));
+    SetFreeSpacePointer(page_size);
+  }
+
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PAGE_ID); }
+
+  /**
+   * Appends a tuple to the page.
+   * @param tuple the tuple to append
+   * @param[out] out the handle to read the tuple back with
+   * @return false if the page has no room left for the tuple
+   */
+  bool Insert(const Tuple &tuple, TmpTuple *out) {
+    uint32_t needed = sizeof(uint32_t) + tuple.GetLength();
+    uint32_t free_space_pointer = GetFreeSpacePointer();
+    if (free_space_pointer < SIZE_HEADER + needed) {
+      return false;
+    }
+    free_space_pointer -= needed;
+    tuple.SerializeTo(GetData() + free_space_pointer);
+    SetFreeSpacePointer(free_space_pointer);
+    *out = TmpTuple(GetTablePageId(), free_space_pointer);
+    return true;
+  }
 
-  page_id_t GetTablePageId() { return INVALID_PAGE_ID; }
+  /** @return the offset of the most recently inserted tuple, equal to PAGE_SIZE when the page holds none */
+  uint32_t GetFirstOffset() { return GetFreeSpacePointer(); }
 
-  bool Insert(const Tuple &tuple, TmpTuple *out) { return false; }
+  /** @return the offset of the tuple inserted just before the one at offset, equal to PAGE_SIZE past the first one */
+  uint32_t GetNextOffset(uint32_t offset) {
+    return offset + sizeof(uint32_t) + *reinterpret_cast<uint32_t *>(GetData() + offset);
+  }
+
+  /** Reads back the tuple at an offset handed out by Insert. */
+  void Get(uint32_t offset, Tuple *tuple) { tuple->DeserializeFrom(GetData() + offset); }
 
  private:
   static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t OFFSET_PAGE_ID = 0;
+  static constexpr size_t OFFSET_FREE_SPACE = 8;
+  static constexpr size_t SIZE_HEADER = 12;
+
+  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+
+  void SetFreeSpacePointer(uint32_t free_space_pointer) {
+    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
+  }
 };
 
 }  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_increment.h
+//
+// Identification: src/include/storage/table/column_increment.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "type/limits.h"
+#include "type/type_id.h"
+
+namespace bustub {
+
+/**
+ * ColumnIncrement is an amount added to an INTEGER or BIGINT column of a tuple in place, the write of an
+ * UpdateType::Add update. Increments of a value commute, so that the transactions adding to a tuple may do so at once,
+ * each taking its own increments out again if it aborts; see LockMode::INCREMENT.
+ */
+struct ColumnIncrement {
+  /** The offset of the column in the data of the tuple. */
+  uint32_t offset_;
+  /** INTEGER or BIGINT. */
+  TypeId type_;
+  int64_t amount_;
+
+  /** @return true if the values of a column of the type can be incremented in place */
+  static bool Supports(TypeId type) { return type == TypeId::INTEGER || type == TypeId::BIGINT; }
+
+  /**
+   * @param data the data of a tuple
+   * @param[out] value the value of the column in it
+   * @return false if the value is NULL, which an increment leaves NULL
+   */
+  bool Read(const char *data, int64_t *value) const {
+    if (type_ == TypeId::INTEGER) {
+      int32_t int_value;
+      memcpy(&int_value, data + offset_, sizeof(int32_t));
+      *value = int_value;
+      return int_value != BUSTUB_INT32_NULL;
+    }
+    memcpy(value, data + offset_, sizeof(int64_t));
+    return *value != BUSTUB_INT64_NULL;
+  }
+
+  /** @return the value incremented by sign times the amount, computed without overflowing */
+  int64_t Add(int64_t value, int64_t sign) const {
+    return static_cast<int64_t>(static_cast<uint64_t>(value) + static_cast<uint64_t>(sign * amount_));
+  }
+
+  /** @return true if adding the amount to value keeps it in the range of the type */
+  bool Fits(int64_t value) const {
+    if (type_ == TypeId::INTEGER) {
+      return value + amount_ >= BUSTUB_INT32_MIN && value + amount_ <= BUSTUB_INT32_MAX;
+    }
+    return amount_ >= 0 ? value <= BUSTUB_INT64_MAX - amount_ : value >= BUSTUB_INT64_MIN - amount_;
+  }
+};
+
+/** @return true if the increments keep the values of the tuple data in the ranges of their types */
+inline bool IncrementsFit(const std::vector<ColumnIncrement> &increments, const char *data) {
+  int64_t value;
+  for (const ColumnIncrement &increment : increments) {
+    if (increment.Read(data, &value) && !increment.Fits(value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Adds increments to the values of tuple data, or takes them out if undo, leaving the NULL values as they are. The
+ * ranges of the types are not checked, see IncrementsFit: an undo takes out what was checked when it was added.
+ */
+inline void ApplyIncrements(const std::vector<ColumnIncrement> &increments, bool undo, char *data) {
+  int64_t value;
+  for (const ColumnIncrement &increment : increments) {
+    if (!increment.Read(data, &value)) {
+      continue;
+    }
+    value = increment.Add(value, undo ? -1 : 1);
+    if (increment.type_ == TypeId::INTEGER) {
+      const auto int_value = static_cast<int32_t>(value);
+      memcpy(data + increment.offset_, &int_value, sizeof(int32_t));
+    } else {
+      memcpy(data + increment.offset_, &value, sizeof(int64_t));
+    }
+  }
+}
+
+}  // namespace bustub
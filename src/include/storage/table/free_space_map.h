@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records how much free space every page of a table heap has, in the chain of FreeSpaceMapPages, so that
+ * an insert can go straight to a page with room for its tuple.
+ *
+ * The map is a hint: it is not logged, and the heap only corrects the entry of a page when an insert finds the page
+ * fuller than recorded or a delete frees space in it. A page it hands out must still be checked for room.
+ *
+ * Besides the pages, the map keeps the largest category of every page of the map and where the entry of every heap
+ * page is in memory, so that a lookup reads only a page of the map that has a match. Thread safe.
+ *
+ * Since every page of the heap has an entry, in the order the pages were added, the map doubles as the directory of
+ * the pages of the heap, see GetHeapPageIds, which lists them without walking the chain.
+ */
+class FreeSpaceMap {
+ public:
+  /** Creates a map that is not open yet. */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  /**
+   * Creates the first page of an empty map.
+   * @return false if no page could be created
+   */
+  bool Create();
+
+  /**
+   * Opens the map stored from a page on, reading all its pages.
+   * @param first_page_id the first page of the map
+   */
+  void Open(page_id_t first_page_id);
+
+  /** @return true once the map is created or opened */
+  bool IsOpen();
+
+  /** @return the first page of the map */
+  page_id_t GetFirstPageId();
+
+  /** @return the heap page recorded last, INVALID_PAGE_ID if there is none */
+  page_id_t GetLastHeapPageId();
+
+  /**
+   * @param free_bytes the free space needed
+   * @return the first recorded heap page with at least free_bytes of free space, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t free_bytes);
+
+  /**
+   * Records the free space of a heap page, appending an entry for it if it has none.
+   * @return false if the entry was new and no page could be created for it
+   */
+  bool Update(page_id_t heap_page_id, uint32_t free_bytes);
+
+  /** Forgets a page deleted from the heap: its entry stays, with no page and no free space. */
+  void Remove(page_id_t heap_page_id);
+
+  /** @return the pages of the heap, in the order they were recorded */
+  std::vector<page_id_t> GetHeapPageIds();
+
+ private:
+  /** A page of the map in memory. */
+  struct MapPage {
+    page_id_t page_id_;
+    uint8_t max_category_;
+  };
+
+  /** @return the pinned page of the map, nullptr if it could not be fetched */
+  FreeSpaceMapPage *FetchMapPage(page_id_t page_id) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    return page == nullptr ? nullptr : reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  }
+
+  /** Appends an entry to the last page of the map, chaining a new page to it when it is full. */
+  bool Append(page_id_t heap_page_id, uint8_t category);
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::mutex latch_;
+  std::vector<MapPage> pages_;
+  /** The entry of every heap page, numbered across the pages of the map. */
+  std::unordered_map<page_id_t, size_t> entries_;
+  page_id_t last_heap_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
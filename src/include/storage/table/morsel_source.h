@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel_source.h
+//
+// Identification: src/include/storage/table/morsel_source.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_ring.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * MorselSource hands out the pages of a TableHeap to the workers of a parallel scan, a morsel of consecutive pages at
+ * a time. Workers claim morsels until the page chain is exhausted, so faster workers simply scan more of the table.
+ *
+ * Since the heap is a linked list of pages, claiming a morsel walks its pages to find where the next morsel starts;
+ * the walk reads the pages in for the worker, which then scans them out of the buffer pool. The pages the zone map of
+ * the heap knows the next page of are not read, as the worker may well skip them by the zone map too.
+ *
+ * A source over several heaps, e.g. the partitions of a table, hands out the pages of one heap after the other, a
+ * morsel never spanning two heaps.
+ */
+class MorselSource {
+ public:
+  /**
+   * Creates a new MorselSource over all the pages of a table.
+   * @param table_heap the table to be scanned
+   * @param morsel_size the number of pages per morsel
+   */
+  MorselSource(TableHeap *table_heap, size_t morsel_size);
+
+  /**
+   * Creates a new MorselSource over all the pages of several tables, in order.
+   * @param table_heaps the tables to be scanned
+   * @param morsel_size the number of pages per morsel
+   */
+  MorselSource(std::vector<TableHeap *> table_heaps, size_t morsel_size);
+
+  /**
+   * Claims the next morsel. Thread safe.
+   * @param[out] pages the pages of the morsel, in chain order
+   * @param ring the buffer ring of the worker to walk the pages through
+   * @param[out] index the number of morsels claimed before this one, if not nullptr, to order the morsels by
+   * @param[out] heap_idx the index of the table the pages are of, if not nullptr
+   * @return false if every page has been claimed already
+   */
+  bool Next(std::vector<page_id_t> *pages, BufferRing *ring, size_t *index = nullptr, size_t *heap_idx = nullptr);
+
+ private:
+  std::vector<TableHeap *> table_heaps_;
+  size_t morsel_size_;
+  std::mutex latch_;
+  /** The table the next morsel is of. */
+  size_t heap_idx_{0};
+  /** The first page of the next morsel, INVALID_PAGE_ID once the chain of the table is exhausted. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** The number of morsels claimed. */
+  size_t num_claimed_{0};
+};
+
+}  // namespace bustub
@@ -12,20 +12,77 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/page/compressed_page.h"
+#include "storage/page/pax_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
+#include "storage/table/toast.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+#include "storage/table/version_store.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
+/** Number of insert partitions of a table heap, each with a page of its own to insert into. */
+static constexpr size_t TABLE_HEAP_INSERT_PARTITIONS = 16;
+
+/** The layout of the pages of a table heap. */
+enum class TableFormat { ROW, PAX };
+
+/**
+ * What survives of a table across a restart. The writes to an UNLOGGED table are not logged, so that it is emptied on
+ * restart, as it may be left anywhere between the states it went through; a TEMPORARY table is not logged either, nor
+ * stored by the catalog, so that it is gone on restart. Both are meant for data that can be loaded again, e.g. the
+ * staging tables of a load, which they fill without writing the log.
+ */
+enum class TableDurability { LOGGED, UNLOGGED, TEMPORARY };
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * Inserts find a page with room through the free-space map of the heap, trying the page of the last insert first, and
+ * append a page to the end of the chain when no page has room. The threads are spread over TABLE_HEAP_INSERT_PARTITIONS
+ * insert partitions, each with a last insert page of its own, so that concurrent inserters fill pages side by side
+ * instead of queueing on the latch of one page: the free-space map never hands a partition the page another one is
+ * filling, it appends a page instead. Only linking a new page to the chain is serialized; the page is taken from the
+ * buffer pool and filled outside of append_latch_.
+ *
+ * The pages are TablePages, storing whole rows, or PaxPages, storing the tuples column by column so that a scan of a
+ * few columns reads only theirs, see TableFormat. Either can be compressed into CompressedPages once cold, see
+ * CompressPages. The heap works the same with all of them, through VisitPage.
+ *
+ * A heap without a log manager does not log its writes, see TableDurability; it still locks its tuples and versions
+ * them as any other, and its transactions roll them back from their write sets.
+ *
+ * The tuples too large for a page have their largest values stored out of line, found with the schema of the heap, see
+ * Toast and SetSchema. The chains of overflow pages of a rolled back write are freed with the rollback, those of the
+ * tuples a commit deleted or replaced once the commit is durable and no snapshot reads them, see FreeRetiredChains.
+ *
+ * Once CreateZoneMap is called, the heap keeps the zone map of some of its columns up to date with its inserts and
+ * updates, for scans to skip pages with.
+ *
+ * With concurrency control on, under enable_logging, every write also leaves the version it replaces in the version
+ * store of the heap, from which the read-only transactions reading a snapshot see the tuples as they were, without
+ * locks; see VersionStore. Snapshot transactions cannot write.
  */
 class TableHeap {
   friend class TableIterator;
+  friend class MorselSource;
 
  public:
   ~TableHeap() = default;
@@ -34,30 +91,50 @@ class TableHeap {
    * Create a table heap without a transaction. (open table)
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
-   * @param log_manager the log manager
+   * @param log_manager the log manager, nullptr not to log the writes to the heap
    * @param first_page_id the id of the first page
+   * @param free_space_map_page_id the id of the first page of the free-space map, INVALID_PAGE_ID = rebuild the map
+   * from the pages of the heap on the first insert
+   * @param pax_schema the schema of the tuples of a heap of PaxPages, nullptr for a heap of TablePages
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            page_id_t first_page_id);
+            page_id_t first_page_id, page_id_t free_space_map_page_id = INVALID_PAGE_ID,
+            const Schema *pax_schema = nullptr);
 
   /**
    * Create a table heap with a transaction. (create table)
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
-   * @param log_manager the log manager
+   * @param log_manager the log manager, nullptr not to log the writes to the heap
    * @param txn the creating transaction
+   * @param pax_schema the schema of the tuples to store in PaxPages, nullptr to store them in TablePages
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, const Schema *pax_schema = nullptr);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large (>= page_size), its largest varlen values are stored out
+   * of line, see Toast; if it is still too large, or there is no schema to find its varlen values with, return false.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param schema the schema of the tuple, nullptr for that of the heap, see SetSchema
+   * @return true iff the insert is successful
+   */
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, const Schema *schema = nullptr);
+
+  /**
+   * Insert tuples into fresh pages appended to the end of the table, logging each page once as a whole instead of
+   * each tuple. Tuples too large for a page are toasted as in InsertTuple; if any of them cannot be, insert none and
+   * return false.
+   * @param tuples the tuples to insert
+   * @param[out] rids the rids of the inserted tuples are appended to rids, in the order of the tuples
+   * @param txn the transaction performing the insert
+   * @param schema the schema of the tuples, nullptr for that of the heap, see SetSchema
    * @return true iff the insert is successful
    */
-  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn);
+  bool BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn,
+                  const Schema *schema = nullptr);
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -68,7 +145,8 @@ class TableHeap {
   bool MarkDelete(const RID &rid, Transaction *txn);  // for delete
 
   /**
-   * if the new tuple is too large to fit in the old page, return false (will delete and insert)
+   * if the new tuple is too large to fit in the old page, return false (will delete and insert). A new tuple too large
+   * for any page is toasted first as in InsertTuple, with the schema of the heap.
    * @param tuple new tuple
    * @param rid rid of the old tuple
    * @param txn transaction performing the update
@@ -77,12 +155,50 @@ class TableHeap {
   bool UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn);
 
   /**
-   * Called on Commit/Abort to actually delete a tuple or rollback an insert.
+   * Add to integer columns of a tuple in place, under an increment lock, which the other transactions adding to the
+   * tuple hold at the same time, see LockMode::INCREMENT. An abort takes the increments out again rather than restoring
+   * the old tuple, see RollbackIncrement. Only the tuples of uncompressed TablePages are incremented.
+   * @param increments the increments
+   * @param rid rid of the tuple
+   * @param txn transaction performing the increment
+   * @param[out] old_tuple the tuple before, with the uncommitted increments of the others
+   * @param[out] new_tuple the tuple after
+   * @return true if the increment is successful
+   */
+  bool IncrementTuple(const std::vector<ColumnIncrement> &increments, const RID &rid, Transaction *txn,
+                      Tuple *old_tuple, Tuple *new_tuple);
+
+  /**
+   * Called on Commit/Abort to actually delete a tuple or rollback an insert. The values of a rolled back insert stored
+   * out of line are freed with it, those of a delete retired, see FreeRetiredChains.
    * @param rid rid of the tuple to delete
    * @param txn transaction performing the delete.
    */
   void ApplyDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Called on Commit to actually delete tuples of one page, under one latch of the page and in one log record.
+   * @param rids rids of the tuples to delete, all of one page
+   * @param txn transaction performing the deletes
+   */
+  void ApplyDeletes(const std::vector<RID> &rids, Transaction *txn);
+
+  /**
+   * Called on Commit, before the deletes are applied, for each update of txn: retires the values of the tuple the update
+   * replaced stored out of line, but those the tuple still points to, see FreeRetiredChains.
+   * @param rid rid of the updated tuple
+   * @param old_tuple the tuple the update replaced, as stored
+   * @param txn the committing transaction
+   */
+  void RetireReplaced(const RID &rid, const Tuple &old_tuple, Transaction *txn);
+
+  /**
+   * Frees the chains of overflow pages of the tuples committed transactions deleted or replaced, of the commits the log
+   * holds and every snapshot sees. Called after a commit, and by the vacuum for those a snapshot kept.
+   * @param oldest_ts the read timestamp of the oldest running snapshot, or the last commit timestamp if none runs
+   */
+  void FreeRetiredChains(timestamp_t oldest_ts);
+
   /**
    * Called on abort to rollback a delete.
    * @param rid rid of the deleted tuple.
@@ -90,6 +206,14 @@ class TableHeap {
    */
   void RollbackDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Called on abort to take the increments of the transaction out of a tuple.
+   * @param rid rid of the incremented tuple
+   * @param increments the increments of the transaction
+   * @param txn transaction performing the rollback
+   */
+  void RollbackIncrement(const RID &rid, const std::vector<ColumnIncrement> &increments, Transaction *txn);
+
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
@@ -99,8 +223,53 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * Read tuples from the table a page at a time: every page is fetched and latched once for all of its tuples read,
+   * and the pages are read ahead in the order of the rids, so that rids sorted by page make for sequential reads.
+   * @param rids rids of the tuples to read, best sorted by page
+   * @param[out] tuples the tuples that exist, in the order of rids, each with its rid
+   * @param txn transaction performing the read
+   * @return false if a page could not be fetched, in which case the transaction is aborted
+   */
+  bool GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn);
+
+  /**
+   * Read a tuple from the table without copying it, see TupleRef.
+   * @param rid rid of the tuple to read
+   * @param[out] ref the ref to the tuple, which holds its page pinned and read latched if the read was successful
+   * @param txn transaction performing the read
+   * @return true if the read was successful (i.e. the tuple exists)
+   */
+  bool GetTupleRef(const RID &rid, TupleRef *ref, Transaction *txn);
+
+  /**
+   * Reads the tuples of a page of the table that txn sees, as a scan does, e.g. for the workers of a parallel scan
+   * that claim the pages themselves.
+   * @param page_id the page
+   * @param txn the transaction performing the read
+   * @param ring the buffer ring the page is read through, nullptr = read through the whole buffer pool
+   * @param[out] tuples the tuples of the page, in slot order
+   * @return the page after it in the chain, INVALID_PAGE_ID if it is the last one
+   */
+  page_id_t ReadPageTuples(page_id_t page_id, Transaction *txn, BufferRing *ring, std::vector<Tuple> *tuples);
+
+  /**
+   * @param txn the transaction performing the scan
+   * @param ring the buffer ring the scan reads pages through, nullptr = read through the whole buffer pool
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferRing *ring = nullptr);
+
+  /**
+   * See TableIterator for the page-batch mode, which suits scans that read every tuple of the pages they enter.
+   * @param txn the transaction performing the scan
+   * @param read_ahead the number of pages of the chain to read ahead of the iterator, 0 to not read ahead
+   * @param ring the buffer ring the scan reads pages through, nullptr = read through the whole buffer pool; scans
+   * through a ring do not read ahead
+   * @return the begin iterator of this table, in page-batch mode
+   */
+  TableIterator BeginPageBatch(Transaction *txn, size_t read_ahead = TABLE_ITERATOR_READ_AHEAD,
+                               BufferRing *ring = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -108,11 +277,345 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the id of the first page of the free-space map of this table, INVALID_PAGE_ID if it is not built yet */
+  page_id_t GetFreeSpaceMapPageId() { return free_space_map_.GetFirstPageId(); }
+
+  /**
+   * @return the pages of this table, from the free-space map rather than by walking the chain, in the order they were
+   * added; a scan of a sample of the pages reads only those it picks, see TableSample
+   */
+  std::vector<page_id_t> GetPageIds();
+
+  /**
+   * Summarizes columns of this table in its zone map, reading all its pages, see ZoneMap. Replaces the columns
+   * summarized so far, if any.
+   * @param schema the schema of the tuples of the table
+   * @param column_ids the columns to summarize, all of which must be inlined
+   * @param txn the transaction reading the pages
+   */
+  void CreateZoneMap(const Schema *schema, const std::vector<uint32_t> &column_ids, Transaction *txn);
+
+  /**
+   * Compresses the cold pages of this table, every page but the first and the last one, into CompressedPages that
+   * replace them in the chain, packing the tuples of consecutive pages together. The tuples move: the caller must
+   * point the indexes of the table to their new rids. The caller also holds the table alone, with no uncommitted
+   * change to it, as for any reorganization of a table.
+   * @param schema the schema of the tuples of the table
+   * @param txn the transaction compressing the table
+   * @param[out] moves the old and the new rid of every tuple moved
+   */
+  void CompressPages(const Schema *schema, Transaction *txn, std::vector<std::pair<RID, RID>> *moves);
+
+  /**
+   * Empties this table, deleting every page but the first one, which is emptied, without logging it: the reset of an
+   * unlogged table on restart, before any transaction uses it.
+   */
+  void Truncate();
+
+  /** @return the zone map of this table, which is not enabled until CreateZoneMap is called */
+  ZoneMap *GetZoneMap() { return &zone_map_; }
+
+  /** @return the oid of the table of this heap, INVALID_TABLE_OID if it is not a table of the catalog */
+  table_oid_t GetTableOid() const { return table_oid_; }
+
+  /** Sets the oid of the table of this heap, whose table locks then cover the row locks of its tuples. */
+  void SetTableOid(table_oid_t table_oid) { table_oid_ = table_oid; }
+
+  /** @return the older versions of the tuples of this table, kept for the snapshots */
+  VersionStore *GetVersionStore() { return &versions_; }
+
+  /** Stamps the writes of the committing txn to rid with its commit timestamp, see VersionStore. */
+  void CommitVersion(const RID &rid, Transaction *txn, timestamp_t commit_ts) {
+    versions_.Commit(rid, txn->GetTransactionId(), commit_ts);
+  }
+
+  /**
+   * @return the timestamp of the last commit that wrote to this table, INVALID_TS if none did: a counter of the
+   * modifications of the table, which the results of the plans reading it are checked against, see ResultCache
+   */
+  timestamp_t GetLastCommitTs() const { return last_commit_ts_.load(); }
+
+  /** Records a commit that wrote to this table, before it is visible to the snapshots. */
+  void SetLastCommitTs(timestamp_t commit_ts) { last_commit_ts_.store(commit_ts); }
+
+  /**
+   * Steps through the tuples of a latched page like its GetFirstTupleRid and GetNextTupleRid, but for a transaction
+   * reading a snapshot, through the tuples the page no longer holds that have older versions as well.
+   * @param page the page
+   * @param cur_rid the current tuple, nullptr to find the first one
+   * @param[out] next_rid the next tuple
+   * @param txn the transaction reading the page
+   * @return false if there is none
+   */
+  template <typename PageType>
+  bool GetNextSnapshotRid(PageType *page, const RID *cur_rid, RID *next_rid, Transaction *txn) {
+    // next_rid may be cur_rid.
+    const uint32_t slot_num = cur_rid == nullptr ? 0 : cur_rid->GetSlotNum() + 1;
+    bool found = cur_rid == nullptr ? page->GetFirstTupleRid(next_rid) : page->GetNextTupleRid(RID(*cur_rid), next_rid);
+    if (!txn->ReadsVersions()) {
+      return found;
+    }
+    RID versioned;
+    if (versions_.GetNextVersionedRid(page->GetTablePageId(), slot_num, &versioned) &&
+        (!found || versioned.GetSlotNum() < next_rid->GetSlotNum())) {
+      *next_rid = versioned;
+      found = true;
+    }
+    return found;
+  }
+
+  /**
+   * Finds the version of a tuple that txn, reading the versions without locks, sees, and adds it to the read set of txn
+   * if it is optimistic.
+   * @param rid the tuple
+   * @param[out] tuple the version txn sees, if it is an older one
+   * @param txn the snapshot or optimistic transaction
+   * @return which version of the tuple txn sees
+   */
+  VersionStore::Visibility ResolveVersion(const RID &rid, Tuple *tuple, Transaction *txn) {
+    if (!txn->IsOptimistic()) {
+      return versions_.Resolve(rid, txn->GetReadTs(), tuple);
+    }
+    timestamp_t version_ts;
+    VersionStore::Visibility visibility = versions_.ResolveLatest(rid, txn->GetTransactionId(), tuple, &version_ts);
+    txn->AppendTableReadRecord(TableReadRecord(rid, this, std::max(version_ts, txn->GetReadTs())));
+    return visibility;
+  }
+
+  /**
+   * Reads the version of a tuple of a latched page that txn, reading the versions, sees, without locking it.
+   * @return false if it sees none
+   */
+  template <typename PageType>
+  bool GetSnapshotTuple(PageType *page, const RID &rid, Tuple *tuple, Transaction *txn) {
+    switch (ResolveVersion(rid, tuple, txn)) {
+      case VersionStore::Visibility::CURRENT: {
+        // The vacuum drops the chain of a tuple once every snapshot sees it deleted, the page then reads it as gone.
+        const TransactionState state = txn->GetState();
+        if (!page->GetTuple(rid, tuple, txn, nullptr)) {
+          txn->SetState(state);
+          return false;
+        }
+        return true;
+      }
+      case VersionStore::Visibility::OLDER:
+        tuple->rid_ = rid;
+        return true;
+      case VersionStore::Visibility::NONE:
+        break;
+    }
+    return false;
+  }
+
+  /** @return the layout of the pages of this table */
+  TableFormat GetFormat() const { return pax_schema_ == nullptr ? TableFormat::ROW : TableFormat::PAX; }
+
+  /**
+   * Calls fn with a page of this table, as a CompressedPage if it is one, else as a TablePage or a PaxPage depending
+   * on the format of the table. All have the same methods for the heap to call.
+   */
+  template <typename Fn>
+  decltype(auto) VisitPage(Page *page, Fn &&fn) const {
+    if (CompressedPage::IsCompressed(page->GetData())) {
+      return fn(static_cast<CompressedPage *>(page));
+    }
+    if (pax_schema_ != nullptr) {
+      return fn(static_cast<PaxPage *>(page));
+    }
+    return fn(static_cast<TablePage *>(page));
+  }
+
+  /**
+   * Sets the schema of the tuples of this heap, which outlives it: the heap toasts the tuples too large for a page with
+   * it, and finds the values stored out of line of the tuples it deletes.
+   */
+  void SetSchema(const Schema *schema) { schema_ = schema; }
+
  private:
+  /** The most bytes of a tuple that fits in a TablePage. */
+  static constexpr uint32_t MAX_TUPLE_SIZE = PAGE_SIZE - 32;
+
+  /**
+   * Inserts a tuple that fits in a page, and adds it to the write set of txn.
+   * @return false if the tuple is not inserted
+   */
+  bool InsertStoredTuple(const Tuple &tuple, RID *rid, Transaction *txn);
+
+  /**
+   * Toasts the tuples too large for a page, see Toast::ToastTuple.
+   * @param[out] toasted the toasted tuples, at the index of each source tuple that needed toasting
+   * @return false if a tuple cannot be toasted, when none stays toasted
+   */
+  bool ToastTuples(const std::vector<Tuple> &tuples, const Schema *schema, std::vector<Tuple> *toasted,
+                   Transaction *txn);
+
+  /** Frees the chains of overflow pages of the tuples of toasted from the index from on, which no tuple points to. */
+  void FreeToasted(const std::vector<Tuple> &toasted, size_t from, const Schema *schema);
+
+  /** A chain of overflow pages of a tuple a committed transaction deleted or replaced, see FreeRetiredChains. */
+  struct RetiredChain {
+    timestamp_t commit_ts_;
+    lsn_t commit_lsn_;
+    page_id_t first_page_id_;
+  };
+
+  /** @return the chains of overflow pages of the tuple at rid of a latched page, deleted or not */
+  template <typename PageType>
+  std::vector<page_id_t> GetChains(PageType *page, const RID &rid) const {
+    if (schema_ == nullptr || schema_->GetUnlinedColumns().empty()) {
+      return {};
+    }
+    return Toast::GetChains(page->CopyOutTuple(rid), schema_);
+  }
+
+  /** @return the chains of overflow pages of a tuple of the heap, none if it has no data or the heap no schema */
+  std::vector<page_id_t> GetChains(const Tuple &tuple) const {
+    if (schema_ == nullptr || tuple.GetData() == nullptr) {
+      return {};
+    }
+    return Toast::GetChains(tuple, schema_);
+  }
+
+  /** Keeps the chains of the tuples committing txn deleted or replaced until FreeRetiredChains. */
+  void RetireChains(const std::vector<page_id_t> &chains, Transaction *txn);
+
+  /** Frees chains of overflow pages no tuple points to anymore. */
+  void FreeChains(const std::vector<page_id_t> &chains) {
+    for (page_id_t first_page_id : chains) {
+      Toast::FreeChain(buffer_pool_manager_, first_page_id);
+    }
+  }
+
+  /** Opens or rebuilds the free-space map if it is not open yet. */
+  void OpenFreeSpaceMap();
+
+  /**
+   * Appends a page to the end of the chain and inserts the tuple into it.
+   * @return the new page, INVALID_PAGE_ID if no page could be created
+   */
+  page_id_t AppendPage(const Tuple &tuple, RID *rid, Transaction *txn);
+
+  /** @return the last insert page of the insert partition of the calling thread */
+  std::atomic<page_id_t> &InsertPageId() {
+    static thread_local const size_t partition =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) % TABLE_HEAP_INSERT_PARTITIONS;
+    return insert_page_ids_[partition];
+  }
+
+  /**
+   * @return a page the free-space map says has room for space_needed bytes, INVALID_PAGE_ID if there is none or it is
+   * the last insert page of a partition, which is left to that partition
+   */
+  page_id_t FindInsertPage(uint32_t space_needed);
+
+  /** Forgets the last insert page of every partition, once pages are removed from the heap. */
+  void ResetInsertPages() {
+    for (auto &page_id : insert_page_ids_) {
+      page_id.store(INVALID_PAGE_ID);
+    }
+  }
+
+  /** @return the last page of the chain, cached in last_page_id_; INVALID_PAGE_ID if it could not be fetched */
+  page_id_t FindLastPageId();
+
+  /** Points a page of the chain to the page after it, and that page back to it. */
+  void LinkPages(page_id_t page_id, page_id_t next_page_id);
+
+  /**
+   * @return the lock manager to take the row locks of txn with, nullptr if its table lock covers them or it reads the
+   * versions without locks
+   */
+  LockManager *RowLockManager(Transaction *txn, bool exclusive) {
+    if (!exclusive && txn->ReadsVersions()) {
+      return nullptr;
+    }
+    return txn->IsRowLockCovered(table_oid_, exclusive) ? nullptr : lock_manager_;
+  }
+
+  /** @return true if the writes of txn leave undo records: with concurrency control on, and not for a rollback */
+  static bool KeepsVersions(Transaction *txn) {
+    return enable_logging && txn->GetState() != TransactionState::ABORTED;
+  }
+
+  /** @return false after aborting txn if it reads a snapshot, which must not write */
+  static bool CanWrite(Transaction *txn) {
+    if (txn->IsSnapshot()) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Records the row lock txn holds on rid, if any, with the lock manager, which escalates the row locks of txn on the
+   * table to a table lock once there are too many. @return false if txn was aborted while it waited for that lock
+   */
+  bool RecordRowLock(Transaction *txn, const RID &rid) {
+    return !enable_logging || lock_manager_ == nullptr || table_oid_ == INVALID_TABLE_OID ||
+           lock_manager_->RecordRowLock(txn, table_oid_, rid);
+  }
+
+  /**
+   * Takes the row lock of txn on rid before the latch of its page, so that txn never waits for the lock under the latch,
+   * which the holder may need to roll back: e.g. a transaction of the recovery undoing in the background. The page
+   * then finds the lock held. @return false if txn was aborted while it waited
+   */
+  bool LockRow(Transaction *txn, const RID &rid, bool exclusive) {
+    LockManager *lock_manager = RowLockManager(txn, exclusive);
+    if (!enable_logging || lock_manager == nullptr || txn->IsExclusiveLocked(rid)) {
+      return true;
+    }
+    if (txn->IsSharedLocked(rid)) {
+      return !exclusive || lock_manager->LockUpgrade(txn, rid);
+    }
+    if (exclusive) {
+      return lock_manager->LockExclusive(txn, rid);
+    }
+    // The page aborts a transaction reading uncommitted on a shared lock, leave it to the page.
+    return txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED || lock_manager->LockShared(txn, rid);
+  }
+
+  /** Initializes a new page of the heap. */
+  void InitPage(Page *page, page_id_t page_id, page_id_t prev_page_id, Transaction *txn);
+
+  /** @return a new page for the heap, pinned and write latched, to be linked; nullptr if none could be created */
+  Page *NewHeapPage(page_id_t *page_id);
+
+  /**
+   * Initializes a page of NewHeapPage and links it to the end of the chain, where it stays latched for the caller to
+   * fill, unlatch and unpin. Caller must hold append_latch_.
+   * @return false if the last page could not be fetched
+   */
+  bool LinkNewPage(Page *new_page, Transaction *txn);
+
+  /** Unlatches and unpins a page of NewHeapPage filled, and records its free space. */
+  void ReleaseNewPage(Page *new_page);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  table_oid_t table_oid_{INVALID_TABLE_OID};
+  /** The schema of the tuples of a heap of PaxPages, nullptr for a heap of TablePages. */
+  std::unique_ptr<const Schema> pax_schema_;
+  /** The most bytes of a tuple that fits in a page, larger ones are toasted. */
+  uint32_t max_tuple_size_;
+  /** The schema of the tuples, nullptr if unknown, see SetSchema. */
+  const Schema *schema_{nullptr};
+  page_id_t free_space_map_page_id_{INVALID_PAGE_ID};
+  FreeSpaceMap free_space_map_;
+  ZoneMap zone_map_;
+  VersionStore versions_;
+  /** The page of the last insert of each insert partition, the first one tried by its next; set by the constructors. */
+  std::array<std::atomic<page_id_t>, TABLE_HEAP_INSERT_PARTITIONS> insert_page_ids_{};
+  std::atomic<timestamp_t> last_commit_ts_{INVALID_TS};
+  /** Serializes the links of pages to the chain, and protects last_page_id_. */
+  std::mutex append_latch_;
+  /** The last page of the chain as of the last append; read without append_latch_ only as a placement hint. */
+  std::atomic<page_id_t> last_page_id_{INVALID_PAGE_ID};
+  /** Protects retired_chains_. */
+  std::mutex retired_latch_;
+  std::vector<RetiredChain> retired_chains_;
 };
 
 }  // namespace bustub
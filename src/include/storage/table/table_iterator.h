@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <deque>
+#include <vector>
 
+#include "buffer/buffer_ring.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -22,17 +25,39 @@ namespace bustub {
 
 class TableHeap;
 
+/** Default number of pages of the chain a page-batch TableIterator asks the buffer pool to read ahead of it. */
+static constexpr size_t TABLE_ITERATOR_READ_AHEAD = 8;
+
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ *
+ * By default the iterator fetches the page of the current tuple again on every increment, and copies the next tuple
+ * out of it through TableHeap::GetTuple. In page-batch mode, see TableHeap::BeginPageBatch, it pins every page once
+ * and copies all of its tuples at once, then hands them out without touching the page again; on entering a page, it
+ * asks the buffer pool to read up to read_ahead pages of the chain after it in the background. The chain is followed
+ * through the links of the zone map of the table as far as it knows them, and else one page at a time. The tuples of
+ * a page are read as of when the iterator entered it.
  */
 class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring = nullptr);
+
+  /** Creates a page-batch iterator positioned on the first tuple of the chain from page_id on. */
+  TableIterator(TableHeap *table_heap, page_id_t page_id, Transaction *txn, BufferRing *ring, size_t read_ahead);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        ring_(other.ring_),
+        batched_(other.batched_),
+        read_ahead_(other.read_ahead_),
+        page_tuples_(other.page_tuples_),
+        page_idx_(other.page_idx_),
+        next_page_id_(other.next_page_id_),
+        prefetched_(other.prefetched_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +77,44 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    ring_ = other.ring_;
+    batched_ = other.batched_;
+    read_ahead_ = other.read_ahead_;
+    page_tuples_ = other.page_tuples_;
+    page_idx_ = other.page_idx_;
+    next_page_id_ = other.next_page_id_;
+    prefetched_ = other.prefetched_;
     return *this;
   }
 
  private:
+  /**
+   * Copies the tuples of the first page with any from page_id on into page_tuples_, and moves the first one to tuple_.
+   * Moves to the end if there is none.
+   */
+  void ReadPages(page_id_t page_id);
+
+  /** Asks for the pages after a page that was just read to be read ahead, next_page_id being the one after it. */
+  void ReadAhead(page_id_t page_id, page_id_t next_page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer ring that pages are read through, owned by whoever started the scan. */
+  BufferRing *ring_;
+
+  /** True in page-batch mode. */
+  bool batched_{false};
+  /** The number of pages to read ahead, in page-batch mode. */
+  size_t read_ahead_{0};
+  /** The tuples of the current page, in page-batch mode; the ones before page_idx_ have been moved out. */
+  std::vector<Tuple> page_tuples_;
+  /** The index of the current tuple in page_tuples_. */
+  size_t page_idx_{0};
+  /** The page after the current one. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** The pages asked to be read ahead and not entered yet, in chain order. */
+  std::deque<page_id_t> prefetched_;
 };
 
 }  // namespace bustub
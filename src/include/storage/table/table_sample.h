@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_sample.h
+//
+// Identification: src/include/storage/table/table_sample.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/** How a sampled scan picks the tuples of its sample, as TABLESAMPLE does. */
+enum class SampleMethod : uint8_t {
+  /** Every tuple. */
+  NONE,
+  /** Every tuple of a random subset of the pages; the pages left out are not read at all. */
+  SYSTEM,
+  /** A random subset of the tuples, of all the pages. */
+  BERNOULLI,
+};
+
+/**
+ * TableSample describes the sample a scan reads of a table: each page (SYSTEM) or each tuple (BERNOULLI) is part of
+ * it with a probability of the sample fraction. Whether it is is decided by the hash of its page id or RID with the
+ * seed rather than drawn, so that the same seed picks the same sample again (REPEATABLE), and the workers of a parallel
+ * scan agree on it without sharing any state.
+ */
+struct TableSample {
+  SampleMethod method_{SampleMethod::NONE};
+  /** The probability of each page or tuple to be part of the sample, in (0, 1]. */
+  double fraction_{1};
+  uint64_t seed_{0};
+
+  /** @return true if a page, or the RID of a tuple (RID::Get), is part of the sample */
+  bool Picks(int64_t key) const {
+    const hash_t hash = HashUtil::HashWords(static_cast<uint64_t>(key), 0, seed_);
+    // The top 53 bits of the hash, as a fraction in [0, 1).
+    return static_cast<double>(hash >> 11) * 0x1.0p-53 < fraction_;
+  }
+
+  /** @return true if the scan leaves pages out */
+  bool SamplesPages() const { return method_ == SampleMethod::SYSTEM && fraction_ < 1; }
+
+  /** @return true if the scan leaves tuples of the pages it reads out */
+  bool SamplesTuples() const { return method_ == SampleMethod::BERNOULLI && fraction_ < 1; }
+};
+
+}  // namespace bustub
@@ -4,8 +4,10 @@
 
 namespace bustub {
 
-// Document this class! What does it represent?
-
+/**
+ * TmpTuple is the handle of a tuple spilled to a TmpTuplePage, e.g. by a hash join that ran out of memory: the page
+ * that holds the tuple and the offset of the tuple within it.
+ */
 class TmpTuple {
  public:
   TmpTuple(page_id_t page_id, size_t offset) : page_id_(page_id), offset_(offset) {}
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// toast.h
+//
+// Identification: src/include/storage/table/toast.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "recovery/log_manager.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Toast stores the varlen values of tuples too large for a page out of line, in chains of OverflowPages, and reads
+ * them back.
+ *
+ * A value stored out of line keeps its place in the tuple, with a toast pointer in place of its data:
+ * --------------------------------------------------------------------------
+ * | TOAST_POINTER_FLAG | POINTER_SIZE (4) | FirstPageId (4) | Length (4) |
+ * --------------------------------------------------------------------------
+ * where Length is the length of the value as stored inline. The other columns of the tuple read as usual, so a reader
+ * only ever fetches the overflow pages of the columns it detoasts.
+ *
+ * Every overflow page is logged whole as it is written, in an OVERFLOWPAGE record of the inserting transaction. A chain
+ * belongs to the one tuple pointing to it, and is freed once that tuple is gone for good, see FreeChain.
+ */
+class Toast {
+ public:
+  /** The bytes of a toast pointer after its length. */
+  static constexpr uint32_t POINTER_SIZE = sizeof(page_id_t) + sizeof(uint32_t);
+
+  /**
+   * Stores the largest varlen values of a tuple out of line until the tuple fits, largest first.
+   * @param bpm the buffer pool manager to create the overflow pages in
+   * @param tuple the tuple to toast
+   * @param schema the schema of the tuple
+   * @param max_size the size the toasted tuple must fit in
+   * @param[out] toasted the toasted tuple, which owns its data
+   * @param txn the transaction writing the tuple, which logs the overflow pages
+   * @param log_manager the log manager, nullptr not to log the overflow pages
+   * @return false if the tuple does not fit even with all its varlen values out of line, or no page could be created;
+   * the pages written until then are freed
+   */
+  static bool ToastTuple(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema, uint32_t max_size,
+                         Tuple *toasted, Transaction *txn, LogManager *log_manager);
+
+  /** @return true if any of the columns of the tuple is stored out of line */
+  static bool HasToasted(const Tuple &tuple, const Schema *schema, const std::vector<uint32_t> &column_ids);
+
+  /**
+   * Reads values stored out of line back into a tuple.
+   * @param bpm the buffer pool manager to read the overflow pages from
+   * @param tuple a tuple with toast pointers
+   * @param schema the schema of the tuple
+   * @param column_ids the columns to read back; the other columns keep their toast pointers
+   * @return a copy of the tuple with the columns inline, which owns its data and has the rid of the tuple
+   */
+  static Tuple Detoast(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema,
+                       const std::vector<uint32_t> &column_ids);
+
+  /** Reads all the values stored out of line back into a tuple, see Detoast above. */
+  static Tuple Detoast(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema);
+
+  /** @return the total size of a varlen value as stored in a tuple, with its length, inline or a toast pointer */
+  static uint32_t StoredSize(const char *stored);
+
+  /** @return the first pages of the chains of the values of a tuple stored out of line */
+  static std::vector<page_id_t> GetChains(const Tuple &tuple, const Schema *schema);
+
+  /**
+   * Frees the overflow pages of a chain, which no tuple points to anymore, nor will once a crash is recovered from.
+   * @param bpm the buffer pool manager of the overflow pages
+   * @param page_id the first page of the chain, INVALID_PAGE_ID for none
+   */
+  static void FreeChain(BufferPoolManager *bpm, page_id_t page_id);
+
+ private:
+  /**
+   * Writes a new chain of overflow pages holding the data, logged by txn as in ToastTuple.
+   * @return its first page, INVALID_PAGE_ID on failure, when the pages written until then are freed
+   */
+  static page_id_t WriteChain(BufferPoolManager *bpm, const char *data, uint32_t size, Transaction *txn,
+                              LogManager *log_manager);
+
+  /** Reads the size bytes of data of a chain of overflow pages. */
+  static void ReadChain(BufferPoolManager *bpm, page_id_t page_id, char *data, uint32_t size);
+
+  /**
+   * Copies a tuple, rewriting the varlen values of the columns marked in rewrite with write.
+   * @param size the size of the copy
+   * @param write writes the new stored form of a value to its destination and returns its size
+   */
+  template <typename Write>
+  static Tuple Rewrite(const Tuple &tuple, const Schema *schema, const std::vector<bool> &rewrite, uint32_t size,
+                       Write write);
+};
+
+}  // namespace bustub
@@ -12,15 +12,21 @@
 
 #pragma once
 
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/arena.h"
+#include "common/memory_tracker.h"
 #include "common/rid.h"
 #include "type/value.h"
 
 namespace bustub {
 
+/** Set in the length of a varlen value of a tuple that is stored out of line, see Toast. */
+static constexpr uint32_t TOAST_POINTER_FLAG = 1U << 31;
+
 /**
  * Tuple format:
  * ---------------------------------------------------------------------
@@ -30,10 +36,18 @@ namespace bustub {
 class Tuple {
   friend class TablePage;
 
+  friend class PaxPage;
+
+  friend class CompressedPage;
+
   friend class TableHeap;
 
   friend class TableIterator;
 
+  friend class TupleRef;
+
+  friend class Toast;
+
  public:
   // Default constructor (to create a dummy tuple)
   Tuple() = default;
@@ -44,16 +58,23 @@ class Tuple {
   // constructor for creating a new tuple based on input value
   Tuple(std::vector<Value> values, const Schema *schema);
 
-  // copy constructor, deep copy
+  // constructor for creating a new tuple based on input value, in memory of an arena which the tuple does not own
+  Tuple(const std::vector<Value> &values, const Schema *schema, Arena *arena);
+
+  // copy constructor, deep copy: the copy owns its data
   Tuple(const Tuple &other);
 
-  // assign operator, deep copy
+  // assign operator, deep copy: the copy owns its data
   Tuple &operator=(const Tuple &other);
 
+  // move constructor, steals the data of the other tuple and leaves it empty; a view or an arena tuple stays one
+  Tuple(Tuple &&other) noexcept;
+
+  // move assign operator, steals the data of the other tuple and leaves it empty
+  Tuple &operator=(Tuple &&other) noexcept;
+
   ~Tuple() {
-    if (allocated_) {
-      delete[] data_;
-    }
+    FreeData();
     allocated_ = false;
     data_ = nullptr;
   }
@@ -66,6 +87,9 @@ class Tuple {
   // return RID of current tuple
   inline RID GetRid() const { return rid_; }
 
+  // set the RID of the tuple, for a tuple of a table read other than from its page, e.g. an older version of it
+  inline void SetRid(RID rid) { rid_ = rid; }
+
   // Get the address of this tuple in the table's backing store
   inline char *GetData() const { return data_; }
 
@@ -73,24 +97,54 @@ class Tuple {
   inline uint32_t GetLength() const { return size_; }
 
   // Get the value of a specified column (const)
-  // checks the schema to see how to return the Value.
+  // checks the schema to see how to return the Value; throws if the value is stored out of line, see Toast::Detoast
   Value GetValue(const Schema *schema, uint32_t column_idx) const;
 
+  // Is the column value stored out of line, in overflow pages?
+  bool IsToasted(const Schema *schema, uint32_t column_idx) const;
+
   // Generates a key tuple given schemas and attributes
-  Tuple KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs);
+  Tuple KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const;
 
-  // Is the column value null ?
-  inline bool IsNull(const Schema *schema, uint32_t column_idx) const {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
-  }
+  // Is the column value null ? Read from the bytes of the value, without deserializing it
+  bool IsNull(const Schema *schema, uint32_t column_idx) const;
   inline bool IsAllocated() { return allocated_; }
 
   std::string ToString(const Schema *schema) const;
 
  private:
+  // Allocate the data of a tuple of size bytes, counted in the memory of the tuples
+  static char *AllocateData(uint32_t size) {
+    MemoryTracker::Of(MemoryTag::TUPLES)->Allocate(size);
+    return new char[size];
+  }
+
+  // Free the data of the tuple if it owns it, of size_ bytes
+  void FreeData() {
+    if (allocated_) {
+      MemoryTracker::Of(MemoryTag::TUPLES)->Free(size_);
+      delete[] data_;
+    }
+  }
+
+  // Get the size of the tuple of the values
+  static uint32_t SerializedSize(const std::vector<Value> &values, const Schema *schema);
+
+  // Serialize the values into the size_ bytes of data_
+  void Serialize(const std::vector<Value> &values, const Schema *schema);
+
   // Get the starting storage address of specific column
-  const char *GetDataPtr(const Schema *schema, uint32_t column_idx) const;
+  inline const char *GetDataPtr(const Schema *schema, uint32_t column_idx) const {
+    const ColumnLayout &layout = schema->GetColumnLayout(column_idx);
+    // For inline type, data is stored where it is.
+    if (layout.is_inlined_) {
+      return data_ + layout.offset_;
+    }
+    // We read the relative offset from the tuple data, where the real data for the VARCHAR type begins.
+    int32_t offset;
+    memcpy(&offset, data_ + layout.offset_, sizeof(int32_t));
+    return data_ + offset;
+  }
 
   bool allocated_{false};  // is allocated?
   RID rid_{};              // if pointing to the table heap, the rid is valid
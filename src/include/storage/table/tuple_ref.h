@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_ref.h
+//
+// Identification: src/include/storage/table/tuple_ref.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleRef is a read-only view of a tuple on a table page, see TableHeap::GetTupleRef. The tuple is not copied: the
+ * ref keeps its page pinned and read latched for as long as it refers to it, and lets go of both when it is released,
+ * reset or destroyed. Keep a ref short-lived, and copy the tuple out of it with Copy when it has to outlive the ref.
+ * A tuple of a PaxPage is reassembled rather than read in place, and the ref owns it, but holds its page all the same.
+ */
+class TupleRef {
+  friend class TableHeap;
+
+ public:
+  /** Creates a ref to no tuple. */
+  TupleRef() = default;
+
+  TupleRef(TupleRef &&other) noexcept;
+  TupleRef &operator=(TupleRef &&other) noexcept;
+  TupleRef(const TupleRef &) = delete;
+  TupleRef &operator=(const TupleRef &) = delete;
+
+  /** Unlatches and unpins the page of the tuple. */
+  ~TupleRef() { Release(); }
+
+  /** @return the tuple, valid for as long as the ref refers to it */
+  const Tuple &operator*() const { return tuple_; }
+
+  /** @return the tuple, valid for as long as the ref refers to it */
+  const Tuple *operator->() const { return &tuple_; }
+
+  /** @return a copy of the tuple that owns its data */
+  Tuple Copy() const { return tuple_; }
+
+  /** @return true if the ref refers to a tuple */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** Unlatches and unpins the page of the tuple; the ref refers to no tuple afterwards. */
+  void Release();
+
+ private:
+  /** Takes the view of the tuple of another ref over, after this ref was released. */
+  void TakeView(TupleRef *other);
+
+  BufferPoolManager *bpm_{nullptr};
+  /** The page of the tuple, pinned and read latched, nullptr if the ref refers to no tuple. */
+  Page *page_{nullptr};
+  Tuple tuple_;
+};
+
+}  // namespace bustub
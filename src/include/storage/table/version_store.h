@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.h
+//
+// Identification: src/include/storage/table/version_store.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "common/rid.h"
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * VersionStore keeps the older versions of the tuples of a table heap, for the transactions reading a snapshot.
+ *
+ * The heap holds the newest version of every tuple, committed or not. Every write to a tuple leaves an undo record in
+ * the version chain of its RID, newest first: the version the write replaced, none for an insert, stamped with the
+ * commit timestamp of the write once it commits. A snapshot sees the newest version committed up to its timestamp,
+ * which is the one replaced by the oldest write it does not see, or the one in the heap if it sees them all.
+ *
+ * Increments are the exception, see LockMode::INCREMENT: the transactions adding to a tuple at once commit in any
+ * order, so their undo records, at the front of the chain, are not ordered by commit timestamp. A reader takes the
+ * increments it does not see out of the version it reads instead, the heap version being the newest of them applied
+ * to the version it replaced.
+ *
+ * The undo records of a tuple are added while its page is write latched, so a reader holding the page latch sees the
+ * heap and the chain agree. They live in memory only, and are dropped when the write aborts, or by the vacuum once
+ * every snapshot sees the write. Thread safe.
+ */
+class VersionStore {
+ public:
+  /** Which version of a tuple a snapshot sees. */
+  enum class Visibility {
+    /** The version in the heap. */
+    CURRENT,
+    /** An older version kept in the version chain. */
+    OLDER,
+    /** None: the tuple was inserted after the snapshot, or deleted before it. */
+    NONE
+  };
+
+  /**
+   * Records a write to a tuple, before it is visible in the heap.
+   * @param rid the tuple
+   * @param txn_id the writing transaction
+   * @param wtype the kind of write
+   * @param before the version the write replaces, nullptr for an insert
+   */
+  void Record(const RID &rid, txn_id_t txn_id, WType wtype, const Tuple *before);
+
+  /**
+   * Records an increment of a tuple, to be taken out of the versions of the readers that do not see it.
+   * @param rid the tuple
+   * @param txn_id the incrementing transaction
+   * @param before the version the increment replaces, with the uncommitted increments of the others
+   * @param increments the increments
+   */
+  void RecordIncrement(const RID &rid, txn_id_t txn_id, const Tuple &before,
+                       const std::vector<ColumnIncrement> &increments);
+
+  /** Stamps the writes of a committing transaction to a tuple with its commit timestamp. */
+  void Commit(const RID &rid, txn_id_t txn_id, timestamp_t commit_ts);
+
+  /** Drops the newest write of the aborting transaction txn_id to a tuple, rolled back in the heap. */
+  void Discard(const RID &rid, txn_id_t txn_id);
+
+  /**
+   * @param rid the tuple
+   * @param read_ts the timestamp of the snapshot
+   * @param[out] tuple the version the snapshot sees, if it is an older one
+   * @return which version of the tuple the snapshot sees
+   */
+  Visibility Resolve(const RID &rid, timestamp_t read_ts, Tuple *tuple);
+
+  /**
+   * @param rid the tuple
+   * @param txn_id the optimistic transaction reading the tuple
+   * @param[out] tuple the version the transaction sees, if it is an older one
+   * @param[out] version_ts the commit timestamp of the newest committed write kept, INVALID_TS if none
+   * @return which version of the tuple the transaction sees: its own write, or else the newest committed one
+   */
+  Visibility ResolveLatest(const RID &rid, txn_id_t txn_id, Tuple *tuple, timestamp_t *version_ts);
+
+  /** @return the commit timestamp of the newest committed write to a tuple kept, INVALID_TS if none */
+  timestamp_t GetLatestCommitTs(const RID &rid);
+
+  /**
+   * Finds the tuples of a page with a version chain, which a snapshot may see even if the page no longer holds them.
+   * @param page_id the page
+   * @param slot_num the first slot to look at
+   * @param[out] next_rid the first tuple of the page at slot_num or after it with a version chain
+   * @return false if there is none
+   */
+  bool GetNextVersionedRid(page_id_t page_id, uint32_t slot_num, RID *next_rid);
+
+  /**
+   * Reclaims the undo records no snapshot reads anymore, of the next few pages with version chains. The pages are
+   * taken in order from where the last call stopped, wrapping around, so repeated calls sweep the whole table.
+   * @param oldest_ts the read timestamp of the oldest running snapshot, or the last commit timestamp if none runs
+   * @param max_pages the most pages to vacuum
+   * @return the number of undo records reclaimed
+   */
+  size_t Vacuum(timestamp_t oldest_ts, size_t max_pages);
+
+  /** @return the number of undo records kept */
+  size_t GetNumVersions();
+
+ private:
+  /** An undo record: a write to a tuple and the version it replaced. */
+  struct UndoRecord {
+    txn_id_t txn_id_;
+    /** INVALID_TS until the write commits. */
+    timestamp_t commit_ts_;
+    WType wtype_;
+    /** The version replaced, empty for an insert. */
+    Tuple before_;
+    /** The increments of an INCREMENT. */
+    std::vector<ColumnIncrement> increments_;
+  };
+
+  /**
+   * @param chain a version chain
+   * @param sees whether a reader sees a write of the chain
+   * @param[out] tuple the version the reader sees, if it is an older one
+   * @return which version of the tuple the reader sees
+   */
+  template <typename Sees>
+  static Visibility VisibilityOf(const std::deque<UndoRecord> &chain, Sees &&sees, Tuple *tuple);
+
+  /** @return the commit timestamp of the newest committed write of a chain, INVALID_TS if none */
+  static timestamp_t LatestCommitTs(const std::deque<UndoRecord> &chain);
+
+  /** @return the version chain of a tuple, nullptr if it has none */
+  const std::deque<UndoRecord> *FindChain(const RID &rid) const;
+
+  /**
+   * Drops the undo records of a chain no snapshot reading at oldest_ts or later reads.
+   * @return the number of undo records dropped
+   */
+  static size_t Prune(std::deque<UndoRecord> *chain, timestamp_t oldest_ts);
+
+  ReaderWriterLatch latch_;
+  /** The version chains of the tuples of each page, by slot, newest write first. */
+  std::map<page_id_t, std::map<uint32_t, std::deque<UndoRecord>>> chains_;
+  size_t num_versions_{0};
+  /** The page the next vacuum starts from. */
+  page_id_t vacuum_page_id_{0};
+  /** The oldest snapshot timestamp the last vacuum was given, by which every write prunes the chain it grows. */
+  timestamp_t horizon_{INVALID_TS};
+};
+
+}  // namespace bustub
@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ZoneMap records the smallest and the largest value of some columns of a table heap for every page of the heap, so
+ * that a scan can skip the pages of which no tuple can satisfy its predicate without reading them.
+ *
+ * The summary of a page only ever widens: inserts and updates add their values to it, and deletes leave it as is. A
+ * page with tuples whose values the map never saw has no summary, and must be read. Alongside the summaries, the map
+ * keeps the page after every page in the chain, so a scan skipping a page does not read it to find the next one.
+ *
+ * The map lives in memory only, like the caches of the free-space map, and is rebuilt by reading the heap. Thread safe.
+ */
+class ZoneMap {
+ public:
+  /** The values of a column on a page. */
+  struct Range {
+    /** False if the page holds no value of the column other than NULL, and min_ and max_ are meaningless. */
+    bool has_values_{false};
+    Value min_;
+    Value max_;
+  };
+
+  /**
+   * Starts summarizing columns, dropping all the summaries so far.
+   * @param schema the schema of the tuples of the heap
+   * @param column_ids the columns to summarize, all of which must be inlined
+   */
+  void Enable(const Schema &schema, const std::vector<uint32_t> &column_ids);
+
+  /** @return true if the map summarizes any column */
+  bool IsEnabled();
+
+  /** Records a new, empty page at the end of the chain; its summary is complete from the start. */
+  void AddPage(page_id_t page_id);
+
+  /** Marks the summary of a page read from the heap as complete, and records the page after it. */
+  void CompletePage(page_id_t page_id, page_id_t next_page_id);
+
+  /** Records the page after a page, when a page is linked to the end of the chain. */
+  void Link(page_id_t page_id, page_id_t next_page_id);
+
+  /** Adds the values of a tuple stored on a page to the summary of the page. */
+  void Add(page_id_t page_id, const Tuple &tuple);
+
+  /**
+   * @param page_id a page of the heap
+   * @param column_idx a column of the heap
+   * @param[out] range the values of the column on the page
+   * @param[out] next_page_id the page after the page in the chain
+   * @return false if the column is not summarized, or the page has no complete summary
+   */
+  bool GetRange(page_id_t page_id, uint32_t column_idx, Range *range, page_id_t *next_page_id);
+
+  /** @return false if the page has no complete summary, else the page after it in the chain in next_page_id */
+  bool GetNextPageId(page_id_t page_id, page_id_t *next_page_id);
+
+ private:
+  /** The summary of a page. */
+  struct PageSummary {
+    /** False while the page is being read to rebuild its summary, when the ranges may miss some of its values. */
+    bool complete_{false};
+    page_id_t next_page_id_{INVALID_PAGE_ID};
+    /** The values of the columns on the page, in the order of column_ids_. */
+    std::vector<Range> ranges_;
+  };
+
+  /** @return the summary of a page, created empty if it has none */
+  PageSummary *GetSummary(page_id_t page_id);
+
+  std::mutex latch_;
+  std::unique_ptr<const Schema> schema_;
+  std::vector<uint32_t> column_ids_;
+  /** The index in column_ids_ of every column of the schema, -1 for the ones that are not summarized. */
+  std::vector<int> column_slots_;
+  std::unordered_map<page_id_t, PageSummary> summaries_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,279 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_kernels.h
+//
+// Identification: src/include/type/aggregation_kernels.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "type/typed_kernels.h"
+
+namespace bustub {
+
+/*
+ * Aggregation kernels compute the COUNT, SUM, MIN and MAX of the values of a column of native values, see
+ * typed_kernels.h, skipping its NULLs. With AVX-512 or AVX2, INTEGER, BIGINT and DECIMAL columns are aggregated a
+ * vector register at a time, in lanes that are reduced once at the end. The NULLs are masked out of the lanes by
+ * comparing them with the NULL of the type; as it is also the lowest value of the type, the MAX lanes of AVX2 take them
+ * in unmasked, they never win over a value.
+ */
+
+/** The aggregates of the non-NULL values of a column; with no such value, the sum, min and max are NULL. */
+template <typename T>
+struct ColumnAggregates {
+  /** The sum, in the domain of T with itself: int64_t for the integers. */
+  NativeDomain<T, T> sum_{0};
+  T min_{NativeNull<T>()};
+  T max_{NativeNull<T>()};
+  /** The values that are not NULL. */
+  size_t count_{0};
+
+  /** Adds the aggregates of count other non-NULL values. */
+  void Add(NativeDomain<T, T> sum, T min, T max, size_t count) {
+    if (count == 0) {
+      return;
+    }
+    sum_ += sum;
+    min_ = count_ == 0 ? min : std::min(min_, min);
+    max_ = count_ == 0 ? max : std::max(max_, max);
+    count_ += count;
+  }
+};
+
+/**
+ * AggregationSimd aggregates the values of a column WIDTH at a time: Run adds the aggregates of the values of a prefix
+ * of the column to aggregates and returns the length of the prefix, a multiple of WIDTH. WIDTH is 0 for the types it
+ * has no vector instructions for, whose values are all aggregated one at a time.
+ */
+template <typename T>
+struct AggregationSimd {
+  static constexpr size_t WIDTH = 0;
+
+  static size_t Run(const T * /*column*/, size_t /*n*/, ColumnAggregates<T> * /*aggregates*/) { return 0; }
+};
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+
+/**
+ * Adds the aggregates in the lanes of vector registers to aggregates: the sums, as lanes of S, and the mins and maxes
+ * of the WIDTH lanes of T.
+ */
+template <typename S, typename T, size_t WIDTH, typename SumVec, typename Vec>
+inline void AddLanes(SumVec sums, Vec mins, Vec maxes, size_t count, ColumnAggregates<T> *aggregates) {
+  std::array<S, sizeof(SumVec) / sizeof(S)> sum_lanes;
+  std::array<T, WIDTH> min_lanes;
+  std::array<T, WIDTH> max_lanes;
+  memcpy(sum_lanes.data(), &sums, sizeof(sums));
+  memcpy(min_lanes.data(), &mins, sizeof(mins));
+  memcpy(max_lanes.data(), &maxes, sizeof(maxes));
+  S sum = 0;
+  for (S lane : sum_lanes) {
+    sum += lane;
+  }
+  aggregates->Add(sum, *std::min_element(min_lanes.begin(), min_lanes.end()),
+                  *std::max_element(max_lanes.begin(), max_lanes.end()), count);
+}
+
+#endif
+
+#if defined(__AVX512F__)
+
+template <>
+struct AggregationSimd<int32_t> {
+  static constexpr size_t WIDTH = 16;
+
+  static size_t Run(const int32_t *column, size_t n, ColumnAggregates<int32_t> *aggregates) {
+    const __m512i null = _mm512_set1_epi32(BUSTUB_INT32_NULL);
+    // The sums of the lower and upper halves of the lanes, widened to 64 bits.
+    __m512i sums_low = _mm512_setzero_si512();
+    __m512i sums_high = _mm512_setzero_si512();
+    __m512i mins = _mm512_set1_epi32(INT32_MAX);
+    __m512i maxes = _mm512_set1_epi32(INT32_MIN);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m512i values = _mm512_loadu_si512(column + i);
+      const __mmask16 valid = _mm512_cmpneq_epi32_mask(values, null);
+      const __m512i summed = _mm512_maskz_mov_epi32(valid, values);
+      // The zero-masking forms, as the others leave lanes undefined that GCC 12 warns about.
+      const __m256i low = _mm512_maskz_extracti64x4_epi64(0xF, summed, 0);
+      const __m256i high = _mm512_maskz_extracti64x4_epi64(0xF, summed, 1);
+      sums_low = _mm512_add_epi64(sums_low, _mm512_maskz_cvtepi32_epi64(0xFF, low));
+      sums_high = _mm512_add_epi64(sums_high, _mm512_maskz_cvtepi32_epi64(0xFF, high));
+      mins = _mm512_mask_min_epi32(mins, valid, mins, values);
+      maxes = _mm512_mask_max_epi32(maxes, valid, maxes, values);
+      count += __builtin_popcount(valid);
+    }
+    AddLanes<int64_t, int32_t, WIDTH>(_mm512_add_epi64(sums_low, sums_high), mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+template <>
+struct AggregationSimd<int64_t> {
+  static constexpr size_t WIDTH = 8;
+
+  static size_t Run(const int64_t *column, size_t n, ColumnAggregates<int64_t> *aggregates) {
+    const __m512i null = _mm512_set1_epi64(BUSTUB_INT64_NULL);
+    __m512i sums = _mm512_setzero_si512();
+    __m512i mins = _mm512_set1_epi64(INT64_MAX);
+    __m512i maxes = _mm512_set1_epi64(INT64_MIN);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m512i values = _mm512_loadu_si512(column + i);
+      const __mmask8 valid = _mm512_cmpneq_epi64_mask(values, null);
+      sums = _mm512_mask_add_epi64(sums, valid, sums, values);
+      mins = _mm512_mask_min_epi64(mins, valid, mins, values);
+      maxes = _mm512_mask_max_epi64(maxes, valid, maxes, values);
+      count += __builtin_popcount(valid);
+    }
+    AddLanes<int64_t, int64_t, WIDTH>(sums, mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+template <>
+struct AggregationSimd<double> {
+  static constexpr size_t WIDTH = 8;
+
+  static size_t Run(const double *column, size_t n, ColumnAggregates<double> *aggregates) {
+    const __m512d null = _mm512_set1_pd(BUSTUB_DECIMAL_NULL);
+    __m512d sums = _mm512_setzero_pd();
+    __m512d mins = _mm512_set1_pd(DBL_MAX);
+    __m512d maxes = _mm512_set1_pd(BUSTUB_DECIMAL_NULL);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m512d values = _mm512_loadu_pd(column + i);
+      const __mmask8 valid = _mm512_cmp_pd_mask(values, null, _CMP_NEQ_OQ);
+      sums = _mm512_mask_add_pd(sums, valid, sums, values);
+      mins = _mm512_mask_min_pd(mins, valid, mins, values);
+      maxes = _mm512_mask_max_pd(maxes, valid, maxes, values);
+      count += __builtin_popcount(valid);
+    }
+    AddLanes<double, double, WIDTH>(sums, mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+#elif defined(__AVX2__)
+
+template <>
+struct AggregationSimd<int32_t> {
+  static constexpr size_t WIDTH = 8;
+
+  static size_t Run(const int32_t *column, size_t n, ColumnAggregates<int32_t> *aggregates) {
+    const __m256i null = _mm256_set1_epi32(BUSTUB_INT32_NULL);
+    const __m256i min_identity = _mm256_set1_epi32(INT32_MAX);
+    // The sums of the lower and upper halves of the lanes, widened to 64 bits.
+    __m256i sums_low = _mm256_setzero_si256();
+    __m256i sums_high = _mm256_setzero_si256();
+    __m256i mins = min_identity;
+    __m256i maxes = _mm256_set1_epi32(INT32_MIN);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+      const __m256i nulls = _mm256_cmpeq_epi32(values, null);
+      const __m256i summed = _mm256_andnot_si256(nulls, values);
+      sums_low = _mm256_add_epi64(sums_low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(summed)));
+      sums_high = _mm256_add_epi64(sums_high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(summed, 1)));
+      mins = _mm256_min_epi32(mins, _mm256_blendv_epi8(values, min_identity, nulls));
+      maxes = _mm256_max_epi32(maxes, values);
+      count += WIDTH - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(nulls)));
+    }
+    AddLanes<int64_t, int32_t, WIDTH>(_mm256_add_epi64(sums_low, sums_high), mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+/** AVX2 has no 64-bit minimum and maximum, they are blends by a greater than comparison. */
+template <>
+struct AggregationSimd<int64_t> {
+  static constexpr size_t WIDTH = 4;
+
+  static size_t Run(const int64_t *column, size_t n, ColumnAggregates<int64_t> *aggregates) {
+    const __m256i null = _mm256_set1_epi64x(BUSTUB_INT64_NULL);
+    const __m256i min_identity = _mm256_set1_epi64x(INT64_MAX);
+    __m256i sums = _mm256_setzero_si256();
+    __m256i mins = min_identity;
+    __m256i maxes = _mm256_set1_epi64x(INT64_MIN);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+      const __m256i nulls = _mm256_cmpeq_epi64(values, null);
+      sums = _mm256_add_epi64(sums, _mm256_andnot_si256(nulls, values));
+      const __m256i candidates = _mm256_blendv_epi8(values, min_identity, nulls);
+      mins = _mm256_blendv_epi8(mins, candidates, _mm256_cmpgt_epi64(mins, candidates));
+      maxes = _mm256_blendv_epi8(maxes, values, _mm256_cmpgt_epi64(values, maxes));
+      count += WIDTH - __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(nulls)));
+    }
+    AddLanes<int64_t, int64_t, WIDTH>(sums, mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+template <>
+struct AggregationSimd<double> {
+  static constexpr size_t WIDTH = 4;
+
+  static size_t Run(const double *column, size_t n, ColumnAggregates<double> *aggregates) {
+    const __m256d null = _mm256_set1_pd(BUSTUB_DECIMAL_NULL);
+    const __m256d min_identity = _mm256_set1_pd(DBL_MAX);
+    __m256d sums = _mm256_setzero_pd();
+    __m256d mins = min_identity;
+    __m256d maxes = null;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+      const __m256d values = _mm256_loadu_pd(column + i);
+      const __m256d nulls = _mm256_cmp_pd(values, null, _CMP_EQ_OQ);
+      sums = _mm256_add_pd(sums, _mm256_andnot_pd(nulls, values));
+      mins = _mm256_min_pd(mins, _mm256_blendv_pd(values, min_identity, nulls));
+      maxes = _mm256_max_pd(maxes, values);
+      count += WIDTH - __builtin_popcount(_mm256_movemask_pd(nulls));
+    }
+    AddLanes<double, double, WIDTH>(sums, mins, maxes, count, aggregates);
+    return i;
+  }
+};
+
+#endif
+
+/**
+ * @return the sum, min, max and count of the non-NULL values of a column, as the Add, Min and Max of Value; the sum of
+ * a DECIMAL column may round differently, as its values are added up in another order
+ */
+template <typename T>
+ColumnAggregates<T> AggregateColumn(const T *column, size_t n) {
+  ColumnAggregates<T> aggregates;
+  size_t i = AggregationSimd<T>::Run(column, n, &aggregates);
+  for (; i < n; i++) {
+    const T value = column[i];
+    if (value != NativeNull<T>()) {
+      aggregates.Add(value, value, value, 1);
+    }
+  }
+  return aggregates;
+}
+
+}  // namespace bustub
@@ -0,0 +1,276 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// selection_kernels.h
+//
+// Identification: src/include/type/selection_kernels.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "type/typed_kernels.h"
+
+namespace bustub {
+
+/*
+ * Selection kernels compare a column of native values, see typed_kernels.h, with a constant or with another column of
+ * the same native type, and set the bits of a selection bitmap where the comparison holds: bit i % 64 of word i / 64
+ * for the value i. A comparison with a NULL never holds. The comparison is one of the function objects std::equal_to<>
+ * to std::greater_equal<>, as CompiledPredicate dispatches on. With AVX-512 or AVX2, INTEGER, BIGINT, DECIMAL and
+ * TIMESTAMP columns are compared a vector register at a time, 4 to 16 values per instruction.
+ */
+
+/** @return the words of the selection bitmap of n values */
+inline size_t SelectionWords(size_t n) { return (n + 63) / 64; }
+
+/** @return true if a comparison holds for two values of a column, neither of them NULL */
+template <typename Op, typename T>
+inline bool SelectsNative(T left, T right) {
+  return left != NativeNull<T>() && right != NativeNull<T>() && Op()(left, right);
+}
+
+/**
+ * SelectionSimd compares the values of a column WIDTH at a time, and returns a bit per value. WIDTH is 0 for the types
+ * it has no vector comparisons for, whose values are all compared by SelectsNative.
+ */
+template <typename T>
+struct SelectionSimd {
+  static constexpr size_t WIDTH = 0;
+};
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+
+/**
+ * The predicate of the vector comparisons of doubles for a comparison, which are all false on NaNs. It is a variable
+ * rather than a function, as the immediate operand of an intrinsic is not folded from a call without optimizations.
+ */
+template <typename Op>
+constexpr int FLOAT_PREDICATE = std::is_same_v<Op, std::equal_to<>>       ? _CMP_EQ_OQ
+                                : std::is_same_v<Op, std::not_equal_to<>> ? _CMP_NEQ_OQ
+                                : std::is_same_v<Op, std::less<>>         ? _CMP_LT_OQ
+                                : std::is_same_v<Op, std::less_equal<>>   ? _CMP_LE_OQ
+                                : std::is_same_v<Op, std::greater<>>      ? _CMP_GT_OQ
+                                                                          : _CMP_GE_OQ;
+
+#endif
+
+#if defined(__AVX512F__)
+
+/** The predicate of the AVX-512 vector comparisons of integers for a comparison, see FLOAT_PREDICATE. */
+template <typename Op>
+constexpr int INT_PREDICATE = std::is_same_v<Op, std::equal_to<>>       ? _MM_CMPINT_EQ
+                              : std::is_same_v<Op, std::not_equal_to<>> ? _MM_CMPINT_NE
+                              : std::is_same_v<Op, std::less<>>         ? _MM_CMPINT_LT
+                              : std::is_same_v<Op, std::less_equal<>>   ? _MM_CMPINT_LE
+                              : std::is_same_v<Op, std::greater<>>      ? _MM_CMPINT_NLE
+                                                                        : _MM_CMPINT_NLT;
+
+template <>
+struct SelectionSimd<int32_t> {
+  static constexpr size_t WIDTH = 16;
+  using Vec = __m512i;
+  static Vec Load(const int32_t *values) { return _mm512_loadu_si512(values); }
+  static Vec Broadcast(int32_t value) { return _mm512_set1_epi32(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return _mm512_cmp_epi32_mask(left, right, INT_PREDICATE<Op>);
+  }
+};
+
+template <>
+struct SelectionSimd<int64_t> {
+  static constexpr size_t WIDTH = 8;
+  using Vec = __m512i;
+  static Vec Load(const int64_t *values) { return _mm512_loadu_si512(values); }
+  static Vec Broadcast(int64_t value) { return _mm512_set1_epi64(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return _mm512_cmp_epi64_mask(left, right, INT_PREDICATE<Op>);
+  }
+};
+
+template <>
+struct SelectionSimd<uint64_t> {
+  static constexpr size_t WIDTH = 8;
+  using Vec = __m512i;
+  static Vec Load(const uint64_t *values) { return _mm512_loadu_si512(values); }
+  static Vec Broadcast(uint64_t value) { return _mm512_set1_epi64(static_cast<int64_t>(value)); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return _mm512_cmp_epu64_mask(left, right, INT_PREDICATE<Op>);
+  }
+};
+
+template <>
+struct SelectionSimd<double> {
+  static constexpr size_t WIDTH = 8;
+  using Vec = __m512d;
+  static Vec Load(const double *values) { return _mm512_loadu_pd(values); }
+  static Vec Broadcast(double value) { return _mm512_set1_pd(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return _mm512_cmp_pd_mask(left, right, FLOAT_PREDICATE<Op>);
+  }
+};
+
+#elif defined(__AVX2__)
+
+/**
+ * Compares integer lanes with the only comparisons AVX2 has for them, equality and greater than, of which the other
+ * comparisons are the negations, with the operands swapped or not.
+ */
+template <typename Op, size_t WIDTH, typename Vec, typename Eq, typename Gt, typename Mask>
+inline uint64_t CompareIntLanes(Vec left, Vec right, Eq eq, Gt gt, Mask mask) {
+  constexpr uint64_t lanes = (uint64_t{1} << WIDTH) - 1;
+  if constexpr (std::is_same_v<Op, std::equal_to<>>) {
+    return mask(eq(left, right));
+  } else if constexpr (std::is_same_v<Op, std::not_equal_to<>>) {
+    return mask(eq(left, right)) ^ lanes;
+  } else if constexpr (std::is_same_v<Op, std::less<>>) {
+    return mask(gt(right, left));
+  } else if constexpr (std::is_same_v<Op, std::less_equal<>>) {
+    return mask(gt(left, right)) ^ lanes;
+  } else if constexpr (std::is_same_v<Op, std::greater<>>) {
+    return mask(gt(left, right));
+  } else {
+    return mask(gt(right, left)) ^ lanes;
+  }
+}
+
+template <>
+struct SelectionSimd<int32_t> {
+  static constexpr size_t WIDTH = 8;
+  using Vec = __m256i;
+  static Vec Load(const int32_t *values) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values)); }
+  static Vec Broadcast(int32_t value) { return _mm256_set1_epi32(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return CompareIntLanes<Op, WIDTH>(
+        left, right, [](Vec l, Vec r) { return _mm256_cmpeq_epi32(l, r); },
+        [](Vec l, Vec r) { return _mm256_cmpgt_epi32(l, r); },
+        [](Vec m) { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m))); });
+  }
+};
+
+template <>
+struct SelectionSimd<int64_t> {
+  static constexpr size_t WIDTH = 4;
+  using Vec = __m256i;
+  static Vec Load(const int64_t *values) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values)); }
+  static Vec Broadcast(int64_t value) { return _mm256_set1_epi64x(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return CompareIntLanes<Op, WIDTH>(
+        left, right, [](Vec l, Vec r) { return _mm256_cmpeq_epi64(l, r); },
+        [](Vec l, Vec r) { return _mm256_cmpgt_epi64(l, r); },
+        [](Vec m) { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(m))); });
+  }
+};
+
+/** Unsigned values are loaded with their sign bit flipped, which orders them as signed ones. */
+template <>
+struct SelectionSimd<uint64_t> {
+  static constexpr size_t WIDTH = 4;
+  using Vec = __m256i;
+  static Vec Load(const uint64_t *values) {
+    return _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values)), SignBit());
+  }
+  static Vec Broadcast(uint64_t value) { return _mm256_xor_si256(_mm256_set1_epi64x(value), SignBit()); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return SelectionSimd<int64_t>::Compare<Op>(left, right);
+  }
+
+ private:
+  static Vec SignBit() { return _mm256_set1_epi64x(INT64_MIN); }
+};
+
+template <>
+struct SelectionSimd<double> {
+  static constexpr size_t WIDTH = 4;
+  using Vec = __m256d;
+  static Vec Load(const double *values) { return _mm256_loadu_pd(values); }
+  static Vec Broadcast(double value) { return _mm256_set1_pd(value); }
+  template <typename Op>
+  static uint64_t Compare(Vec left, Vec right) {
+    return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(left, right, FLOAT_PREDICATE<Op>)));
+  }
+};
+
+#endif
+
+/** Sets the bits of bitmap, of SelectionWords(n) words, where column[i] <op> constant, and clears the others. */
+template <typename Op, typename T>
+void CompareColumnConstant(const T *column, size_t n, T constant, uint64_t *bitmap) {
+  std::fill(bitmap, bitmap + SelectionWords(n), 0);
+  if (constant == NativeNull<T>()) {
+    return;
+  }
+  size_t i = 0;
+  using Simd = SelectionSimd<T>;
+  if constexpr (Simd::WIDTH > 0) {
+    const auto right = Simd::Broadcast(constant);
+    const auto null = Simd::Broadcast(NativeNull<T>());
+    for (; i + Simd::WIDTH <= n; i += Simd::WIDTH) {
+      const auto left = Simd::Load(column + i);
+      const uint64_t bits =
+          Simd::template Compare<Op>(left, right) & Simd::template Compare<std::not_equal_to<>>(left, null);
+      bitmap[i / 64] |= bits << (i % 64);
+    }
+  }
+  for (; i < n; i++) {
+    bitmap[i / 64] |= static_cast<uint64_t>(SelectsNative<Op>(column[i], constant)) << (i % 64);
+  }
+}
+
+/** Sets the bits of bitmap, of SelectionWords(n) words, where left[i] <op> right[i], and clears the others. */
+template <typename Op, typename T>
+void CompareColumns(const T *left, const T *right, size_t n, uint64_t *bitmap) {
+  std::fill(bitmap, bitmap + SelectionWords(n), 0);
+  size_t i = 0;
+  using Simd = SelectionSimd<T>;
+  if constexpr (Simd::WIDTH > 0) {
+    const auto null = Simd::Broadcast(NativeNull<T>());
+    for (; i + Simd::WIDTH <= n; i += Simd::WIDTH) {
+      const auto l = Simd::Load(left + i);
+      const auto r = Simd::Load(right + i);
+      const uint64_t bits = Simd::template Compare<Op>(l, r) & Simd::template Compare<std::not_equal_to<>>(l, null) &
+                            Simd::template Compare<std::not_equal_to<>>(r, null);
+      bitmap[i / 64] |= bits << (i % 64);
+    }
+  }
+  for (; i < n; i++) {
+    bitmap[i / 64] |= static_cast<uint64_t>(SelectsNative<Op>(left[i], right[i])) << (i % 64);
+  }
+}
+
+/**
+ * Converts the selection bitmap of n values into a selection vector.
+ * @param[out] indices the indices of the set bits in increasing order, room for n of them
+ * @return the number of indices
+ */
+inline size_t SelectedIndices(const uint64_t *bitmap, size_t n, uint32_t *indices) {
+  size_t count = 0;
+  for (size_t word = 0; word < SelectionWords(n); word++) {
+    for (uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+      indices[count++] = static_cast<uint32_t>(word * 64 + __builtin_ctzll(bits));
+    }
+  }
+  return count;
+}
+
+}  // namespace bustub
@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// typed_kernels.h
+//
+// Identification: src/include/type/typed_kernels.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "storage/table/tuple.h"
+#include "type/limits.h"
+#include "type/type_id.h"
+
+namespace bustub {
+
+/*
+ * Typed kernels compute on the native values of fixed-width columns, int8_t to int64_t for TINYINT to BIGINT, double
+ * for DECIMAL and uint64_t for TIMESTAMP, with the semantics of the Value methods they stand for, but with the types
+ * resolved at compile time: a caller dispatches on the TypeIds once, see DispatchNativeType, and then runs a kernel
+ * specialized on them over a whole column, instead of going through Type::GetInstance and the switch on the type of
+ * the other operand for every value. BOOLEAN is left out, as it shares int8_t with TINYINT but hashes differently.
+ */
+
+/** @return the native value a column of native type T stores for NULL */
+template <typename T>
+constexpr T NativeNull();
+template <>
+constexpr int8_t NativeNull<int8_t>() {
+  return BUSTUB_INT8_NULL;
+}
+template <>
+constexpr int16_t NativeNull<int16_t>() {
+  return BUSTUB_INT16_NULL;
+}
+template <>
+constexpr int32_t NativeNull<int32_t>() {
+  return BUSTUB_INT32_NULL;
+}
+template <>
+constexpr int64_t NativeNull<int64_t>() {
+  return BUSTUB_INT64_NULL;
+}
+template <>
+constexpr double NativeNull<double>() {
+  return BUSTUB_DECIMAL_NULL;
+}
+template <>
+constexpr uint64_t NativeNull<uint64_t>() {
+  return BUSTUB_TIMESTAMP_NULL;
+}
+
+/**
+ * The type two native values are compared and combined in, as the Value methods do: double if either is a DECIMAL,
+ * uint64_t for two TIMESTAMPs, and int64_t for integers of any width.
+ */
+template <typename L, typename R>
+using NativeDomain = std::conditional_t<std::is_floating_point_v<L> || std::is_floating_point_v<R>, double,
+                                        std::conditional_t<std::is_unsigned_v<L>, uint64_t, int64_t>>;
+
+/** @return the native value of type T stored at an offset of the data of a tuple */
+template <typename T>
+inline T LoadNative(const char *data, uint32_t offset) {
+  T value;
+  memcpy(&value, data + offset, sizeof(T));
+  return value;
+}
+
+/**
+ * Calls f with a value of the native type a column of type type_id is stored as.
+ * @return false if the type has no native kernels, f is then not called
+ */
+template <typename F>
+bool DispatchNativeType(TypeId type_id, F &&f) {
+  switch (type_id) {
+    case TypeId::TINYINT:
+      f(int8_t{});
+      return true;
+    case TypeId::SMALLINT:
+      f(int16_t{});
+      return true;
+    case TypeId::INTEGER:
+      f(int32_t{});
+      return true;
+    case TypeId::BIGINT:
+      f(int64_t{});
+      return true;
+    case TypeId::DECIMAL:
+      f(double{});
+      return true;
+    case TypeId::TIMESTAMP:
+      f(uint64_t{});
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** @return true if a comparison op holds for two non-NULL values, as the Compare* methods of Value */
+template <typename Op, typename L, typename R>
+inline bool CompareNative(L left, R right) {
+  using D = NativeDomain<L, R>;
+  return Op()(static_cast<D>(left), static_cast<D>(right));
+}
+
+/** @return the hash of a non-NULL value, equal to HashUtil::HashValue of the Value */
+template <typename T>
+inline hash_t HashNative(T value) {
+  // Integers of all widths hash as BIGINTs, so that equal integers of different types hash alike.
+  std::conditional_t<std::is_integral_v<T> && std::is_signed_v<T>, int64_t, T> raw = value;
+  return HashUtil::Hash(&raw);
+}
+
+/** Reads a column at an offset of the data of tuples into a vector of native values, NULLs included. */
+template <typename T>
+void GatherColumn(const std::vector<Tuple> &tuples, uint32_t offset, std::vector<T> *column) {
+  column->resize(tuples.size());
+  for (size_t i = 0; i < tuples.size(); i++) {
+    (*column)[i] = LoadNative<T>(tuples[i].GetData(), offset);
+  }
+}
+
+/**
+ * Combines the hashes of the values of a column into hashes, as HashUtil::CombineHashes does with
+ * HashUtil::HashValue, and flags the NULLs in nulls; the hashes of NULLs are left as they are.
+ */
+template <typename T>
+void HashColumn(const T *column, size_t n, hash_t *hashes, uint8_t *nulls) {
+  for (size_t i = 0; i < n; i++) {
+    if (column[i] == NativeNull<T>()) {
+      nulls[i] = 1;
+      continue;
+    }
+    hashes[i] = HashUtil::CombineHashes(hashes[i], HashNative(column[i]));
+  }
+}
+
+}  // namespace bustub
@@ -61,6 +61,8 @@ class Value {
 
   Value() : Value(TypeId::INVALID) {}
   Value(const Value &other);
+  // Steals the varlen data of the other value, which no longer manages it, or copies it if inlined
+  Value(Value &&other) noexcept;
   Value &operator=(Value other);
   ~Value();
   // NOLINTNEXTLINE
@@ -138,6 +140,17 @@ class Value {
   inline Value Copy() const { return Type::GetInstance(type_id_)->Copy(*this); }
 
  protected:
+  // Managed varlen data of up to this many bytes, terminator included, is inlined in the value instead of being
+  // allocated on the heap, so that copying short strings does not allocate either
+  static constexpr uint32_t VARLEN_INLINE_SIZE = 16;
+
+  // Whether the varlen data is inlined in value_
+  inline bool IsInlined() const { return manage_data_ && size_.len_ <= VARLEN_INLINE_SIZE; }
+  // Access the varlen data, wherever it is kept
+  inline const char *GetVarlen() const { return IsInlined() ? value_.inline_ : value_.const_varlen_; }
+  // Set up len bytes of managed varlen data, inlined or allocated depending on len, and return them for writing
+  char *AllocateVarlen(uint32_t len);
+
   // The actual value item
   union Val {
     int8_t boolean_;
@@ -149,6 +162,7 @@ class Value {
     uint64_t timestamp_;
     char *varlen_;
     const char *const_varlen_;
+    char inline_[VARLEN_INLINE_SIZE];
   } value_;
 
   union {
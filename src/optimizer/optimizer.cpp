@@ -0,0 +1,805 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimizer.cpp
+//
+// Identification: src/optimizer/optimizer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "optimizer/optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "execution/executors/index_scan_executor.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/delete_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/materialize_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/update_plan.h"
+#include "execution/plans/view_scan_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the comparison with its operands swapped, a < b for b > a */
+ComparisonType Flip(ComparisonType comp_type) {
+  switch (comp_type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comp_type;
+  }
+}
+
+double Clamp(double fraction) { return std::min(1.0, std::max(0.0, fraction)); }
+
+}  // namespace
+
+const AbstractPlanNode *Optimizer::Optimize(const AbstractPlanNode *plan) {
+  // The plans of an earlier call may be gone, and others made where they were.
+  rows_.clear();
+  costs_.clear();
+  return Rewrite(plan);
+}
+
+const AbstractPlanNode *Optimizer::Rewrite(const AbstractPlanNode *plan) {
+  if (plan->GetType() == PlanType::Exchange) {
+    return plan;
+  }
+  std::vector<const AbstractPlanNode *> children;
+  for (const AbstractPlanNode *child : plan->GetChildren()) {
+    children.push_back(Rewrite(child));
+  }
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      return ChooseScan(static_cast<const SeqScanPlanNode *>(plan));
+    case PlanType::NestedLoopJoin: {
+      const auto *join = static_cast<const NestedLoopJoinPlanNode *>(plan);
+      std::vector<const AbstractExpression *> conjuncts;
+      SplitConjuncts(join->Predicate(), &conjuncts);
+      return PlanJoin(join->OutputSchema(), children[0], children[1], std::move(conjuncts), join->GetBlockSize(),
+                      HASH_JOIN_MEMORY_BUDGET);
+    }
+    case PlanType::HashJoin: {
+      const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+      std::vector<const AbstractExpression *> conjuncts;
+      // A semi or anti join is not a join of its predicate, which PlanJoin would turn it into.
+      if (join->GetJoinType() != JoinType::Inner || !JoinConjuncts(join, &conjuncts)) {
+        return WithChildren(plan, std::move(children));
+      }
+      return PlanJoin(join->OutputSchema(), children[0], children[1], std::move(conjuncts),
+                      NESTED_LOOP_JOIN_BLOCK_SIZE, join->GetMemoryBudget());
+    }
+    default:
+      return WithChildren(plan, std::move(children));
+  }
+}
+
+const AbstractPlanNode *Optimizer::WithChildren(const AbstractPlanNode *plan,
+                                                std::vector<const AbstractPlanNode *> children) {
+  if (children == plan->GetChildren()) {
+    return plan;
+  }
+  const Schema *output = plan->OutputSchema();
+  switch (plan->GetType()) {
+    case PlanType::NestedLoopJoin: {
+      const auto *join = static_cast<const NestedLoopJoinPlanNode *>(plan);
+      return Make<NestedLoopJoinPlanNode>(output, std::move(children), join->Predicate(), join->GetBlockSize());
+    }
+    case PlanType::HashJoin: {
+      const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+      std::vector<const AbstractExpression *> left_keys = join->GetLeftKeys();
+      std::vector<const AbstractExpression *> right_keys = join->GetRightKeys();
+      return Make<HashJoinPlanNode>(output, std::move(children), std::move(left_keys), std::move(right_keys),
+                                    join->Predicate(), join->GetMemoryBudget(), join->GetJoinType());
+    }
+    case PlanType::MergeJoin: {
+      const auto *join = static_cast<const MergeJoinPlanNode *>(plan);
+      std::vector<const AbstractExpression *> left_keys = join->GetLeftKeys();
+      std::vector<const AbstractExpression *> right_keys = join->GetRightKeys();
+      return Make<MergeJoinPlanNode>(output, std::move(children), std::move(left_keys), std::move(right_keys),
+                                     join->Predicate());
+    }
+    case PlanType::Sort: {
+      std::vector<OrderBy> order_bys = static_cast<const SortPlanNode *>(plan)->GetOrderBys();
+      return Make<SortPlanNode>(output, children[0], std::move(order_bys));
+    }
+    case PlanType::Aggregation: {
+      const auto *aggregation = static_cast<const AggregationPlanNode *>(plan);
+      std::vector<const AbstractExpression *> group_bys = aggregation->GetGroupBys();
+      std::vector<const AbstractExpression *> aggregates = aggregation->GetAggregates();
+      std::vector<AggregationType> agg_types = aggregation->GetAggregateTypes();
+      return Make<AggregationPlanNode>(output, children[0], aggregation->GetHaving(), std::move(group_bys),
+                                       std::move(aggregates), std::move(agg_types));
+    }
+    case PlanType::Limit: {
+      const auto *limit = static_cast<const LimitPlanNode *>(plan);
+      return Make<LimitPlanNode>(output, children[0], limit->GetLimit(), limit->GetOffset());
+    }
+    case PlanType::Materialize: {
+      const auto *materialize = static_cast<const MaterializePlanNode *>(plan);
+      return Make<MaterializePlanNode>(output, children[0], materialize->GetTableOid(),
+                                       materialize->GetRowIdColIdx());
+    }
+    case PlanType::Insert:
+      return Make<InsertPlanNode>(children[0], static_cast<const InsertPlanNode *>(plan)->TableOid());
+    case PlanType::Delete:
+      return Make<DeletePlanNode>(children[0], static_cast<const DeletePlanNode *>(plan)->TableOid());
+    case PlanType::Update: {
+      const auto *update = static_cast<const UpdatePlanNode *>(plan);
+      return Make<UpdatePlanNode>(children[0], update->TableOid(), *update->GetUpdateAttr());
+    }
+    default:
+      throw NotImplementedException("Optimizer cannot rewrite the children of this plan");
+  }
+}
+
+const AbstractPlanNode *Optimizer::ChooseScan(const SeqScanPlanNode *plan) {
+  // A sample is of the pages or the tuples of the table, which an index scan does not read alike.
+  if (plan->GetSample().method_ != SampleMethod::NONE) {
+    return plan;
+  }
+  const TableMetadata *table = ScanTable(plan);
+  std::vector<const AbstractExpression *> conjuncts;
+  SplitConjuncts(plan->GetPredicate(), &conjuncts);
+
+  const AbstractPlanNode *best = plan;
+  double best_cost = EstimateCost(plan);
+  for (IndexInfo *index_info : catalog_->GetTableIndexes(table->name_)) {
+    // The bounds on the first key column, from its comparisons with constants of its type.
+    const uint32_t key_col = index_info->index_->GetKeyAttrs()[0];
+    const TypeId key_type = table->schema_.GetColumn(key_col).GetType();
+    std::optional<Value> lower;
+    std::optional<Value> upper;
+    for (const AbstractExpression *conjunct : conjuncts) {
+      const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct);
+      if (comparison == nullptr) {
+        continue;
+      }
+      ComparisonType comp_type = comparison->GetComparisonType();
+      const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+      const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+      if (column == nullptr) {
+        column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+        constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+        comp_type = Flip(comp_type);
+      }
+      if (column == nullptr || constant == nullptr || column->GetColIdx() != key_col ||
+          constant->GetValue().IsNull() || constant->GetValue().GetTypeId() != key_type) {
+        continue;
+      }
+      const Value &value = constant->GetValue();
+      if ((comp_type == ComparisonType::Equal || comp_type == ComparisonType::GreaterThan ||
+           comp_type == ComparisonType::GreaterThanOrEqual) &&
+          (!lower.has_value() || value.CompareGreaterThan(*lower) == CmpBool::CmpTrue)) {
+        lower = value;
+      }
+      if ((comp_type == ComparisonType::Equal || comp_type == ComparisonType::LessThan ||
+           comp_type == ComparisonType::LessThanOrEqual) &&
+          (!upper.has_value() || value.CompareLessThan(*upper) == CmpBool::CmpTrue)) {
+        upper = value;
+      }
+    }
+
+    // An index the predicate does not bound is still worth scanning whole if it holds every column read.
+    IndexScanPlanNode probe(plan->OutputSchema(), plan->GetPredicate(), index_info->index_oid_);
+    const bool covered = IndexScanExecutor::IsCovered(&probe, *index_info->index_, table->schema_);
+    if (!lower.has_value() && !upper.has_value() && !covered) {
+      continue;
+    }
+    // The bounds are inclusive, so the predicate stays whole to filter out the bounds of strict comparisons.
+    const auto *candidate = Make<IndexScanPlanNode>(plan->OutputSchema(), plan->GetPredicate(), index_info->index_oid_,
+                                                    !covered, lower, upper);
+    double cost = EstimateCost(candidate);
+    if (cost < best_cost) {
+      best = candidate;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+const AbstractPlanNode *Optimizer::PlanJoin(const Schema *output_schema, const AbstractPlanNode *left,
+                                            const AbstractPlanNode *right,
+                                            std::vector<const AbstractExpression *> conjuncts, size_t block_size,
+                                            size_t memory_budget) {
+  // The conjuncts reading one side only filter that side before the join, where it takes them.
+  std::vector<const AbstractExpression *> remaining;
+  for (const AbstractExpression *conjunct : conjuncts) {
+    const int sides = SidesRead(conjunct);
+    if (sides == 1 || sides == 2) {
+      const AbstractPlanNode *&side = sides == 1 ? left : right;
+      if (const AbstractPlanNode *filtered = AddFilter(side, conjunct); filtered != nullptr) {
+        side = filtered;
+        continue;
+      }
+    }
+    remaining.push_back(conjunct);
+  }
+
+  // The equalities of an expression of each side make the keys of a hash join, the rest its predicate.
+  std::vector<const AbstractExpression *> left_keys;
+  std::vector<const AbstractExpression *> right_keys;
+  std::vector<const AbstractExpression *> residual;
+  for (const AbstractExpression *conjunct : remaining) {
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct);
+    if (comparison != nullptr && comparison->GetComparisonType() == ComparisonType::Equal) {
+      const int lhs_sides = SidesRead(comparison->GetChildAt(0));
+      const int rhs_sides = SidesRead(comparison->GetChildAt(1));
+      if ((lhs_sides == 1 && rhs_sides == 2) || (lhs_sides == 2 && rhs_sides == 1)) {
+        left_keys.push_back(comparison->GetChildAt(lhs_sides == 1 ? 0 : 1));
+        right_keys.push_back(comparison->GetChildAt(lhs_sides == 1 ? 1 : 0));
+        continue;
+      }
+    }
+    residual.push_back(conjunct);
+  }
+
+  const AbstractExpression *predicate = Conjoin(remaining);
+  const AbstractExpression *residual_predicate = Conjoin(residual);
+  std::vector<const AbstractPlanNode *> candidates;
+  candidates.push_back(Make<NestedLoopJoinPlanNode>(output_schema, std::vector<const AbstractPlanNode *>{left, right},
+                                                    predicate, block_size));
+  if (!left_keys.empty()) {
+    std::vector<const AbstractExpression *> build_keys = left_keys;
+    std::vector<const AbstractExpression *> probe_keys = right_keys;
+    candidates.push_back(Make<HashJoinPlanNode>(output_schema, std::vector<const AbstractPlanNode *>{left, right},
+                                                std::move(build_keys), std::move(probe_keys), residual_predicate,
+                                                memory_budget));
+  }
+  // With the sides swapped, the columns of the output and of the predicates read the other tuple.
+  const Schema *swapped_schema = SwapSides(output_schema);
+  const AbstractExpression *swapped_predicate = predicate == nullptr ? nullptr : SwapSides(predicate);
+  if (swapped_schema != nullptr && (predicate == nullptr || swapped_predicate != nullptr)) {
+    candidates.push_back(Make<NestedLoopJoinPlanNode>(
+        swapped_schema, std::vector<const AbstractPlanNode *>{right, left}, swapped_predicate, block_size));
+  }
+  const AbstractExpression *swapped_residual = residual_predicate == nullptr ? nullptr : SwapSides(residual_predicate);
+  if (swapped_schema != nullptr && !left_keys.empty() &&
+      (residual_predicate == nullptr || swapped_residual != nullptr)) {
+    candidates.push_back(Make<HashJoinPlanNode>(swapped_schema, std::vector<const AbstractPlanNode *>{right, left},
+                                                std::move(right_keys), std::move(left_keys), swapped_residual,
+                                                memory_budget));
+  }
+
+  const AbstractPlanNode *best = nullptr;
+  double best_cost = 0;
+  for (const AbstractPlanNode *candidate : candidates) {
+    double cost = EstimateCost(candidate);
+    if (best == nullptr || cost < best_cost) {
+      best = candidate;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+const AbstractPlanNode *Optimizer::AddFilter(const AbstractPlanNode *plan, const AbstractExpression *conjunct) {
+  // The conjunct reads the output columns of the plan, which are expressions on what the plan reads.
+  const Schema *output = plan->OutputSchema();
+  auto to_input = [output](const ColumnValueExpression *column) -> const AbstractExpression * {
+    return column->GetColIdx() < output->GetColumnCount() ? output->GetColumn(column->GetColIdx()).GetExpr() : nullptr;
+  };
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      const auto *scan = static_cast<const SeqScanPlanNode *>(plan);
+      const AbstractExpression *mapped = MapColumns(conjunct, to_input);
+      if (mapped == nullptr) {
+        return nullptr;
+      }
+      const auto *filtered = Make<SeqScanPlanNode>(output, Conjoin({scan->GetPredicate(), mapped}),
+                                                   scan->GetTableOid(), scan->GetMorselSize(), scan->GetSample());
+      return ChooseScan(filtered);
+    }
+    case PlanType::IndexScan: {
+      const auto *scan = static_cast<const IndexScanPlanNode *>(plan);
+      const AbstractExpression *mapped = MapColumns(conjunct, to_input);
+      if (mapped == nullptr) {
+        return nullptr;
+      }
+      return Make<IndexScanPlanNode>(output, Conjoin({scan->GetPredicate(), mapped}), scan->GetIndexOid(),
+                                     scan->FetchesInPageOrder(), scan->GetLowerBound(), scan->GetUpperBound());
+    }
+    case PlanType::NestedLoopJoin:
+    case PlanType::HashJoin: {
+      std::vector<const AbstractExpression *> conjuncts;
+      size_t block_size = NESTED_LOOP_JOIN_BLOCK_SIZE;
+      size_t memory_budget = HASH_JOIN_MEMORY_BUDGET;
+      if (plan->GetType() == PlanType::NestedLoopJoin) {
+        const auto *join = static_cast<const NestedLoopJoinPlanNode *>(plan);
+        SplitConjuncts(join->Predicate(), &conjuncts);
+        block_size = join->GetBlockSize();
+      } else {
+        const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+        if (join->GetJoinType() != JoinType::Inner || !JoinConjuncts(join, &conjuncts)) {
+          return nullptr;
+        }
+        memory_budget = join->GetMemoryBudget();
+      }
+      const AbstractExpression *mapped = MapColumns(conjunct, to_input);
+      if (mapped == nullptr) {
+        return nullptr;
+      }
+      conjuncts.push_back(mapped);
+      return PlanJoin(output, plan->GetChildAt(0), plan->GetChildAt(1), std::move(conjuncts), block_size,
+                      memory_budget);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+bool Optimizer::JoinConjuncts(const HashJoinPlanNode *plan, std::vector<const AbstractExpression *> *conjuncts) {
+  // A key is evaluated on the tuple of its side alone, whichever tuple its columns name.
+  auto on_side = [this](uint32_t tuple_idx) {
+    return [this, tuple_idx](const ColumnValueExpression *column) -> const AbstractExpression * {
+      if (column->GetTupleIdx() == tuple_idx) {
+        return column;
+      }
+      return Make<ColumnValueExpression>(tuple_idx, column->GetColIdx(), column->GetReturnType());
+    };
+  };
+  std::vector<const AbstractExpression *> equalities;
+  for (size_t i = 0; i < plan->GetLeftKeys().size(); i++) {
+    const AbstractExpression *left_key = MapColumns(plan->GetLeftKeys()[i], on_side(0));
+    const AbstractExpression *right_key = MapColumns(plan->GetRightKeys()[i], on_side(1));
+    if (left_key == nullptr || right_key == nullptr) {
+      return false;
+    }
+    equalities.push_back(Make<ComparisonExpression>(left_key, right_key, ComparisonType::Equal));
+  }
+  conjuncts->insert(conjuncts->end(), equalities.begin(), equalities.end());
+  SplitConjuncts(plan->Predicate(), conjuncts);
+  return true;
+}
+
+void Optimizer::SplitConjuncts(const AbstractExpression *expr, std::vector<const AbstractExpression *> *conjuncts) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr);
+      logic != nullptr && logic->GetLogicType() == LogicType::And) {
+    SplitConjuncts(logic->GetChildAt(0), conjuncts);
+    SplitConjuncts(logic->GetChildAt(1), conjuncts);
+    return;
+  }
+  conjuncts->push_back(expr);
+}
+
+const AbstractExpression *Optimizer::Conjoin(const std::vector<const AbstractExpression *> &conjuncts) {
+  const AbstractExpression *result = nullptr;
+  for (const AbstractExpression *conjunct : conjuncts) {
+    if (conjunct == nullptr) {
+      continue;
+    }
+    result = result == nullptr ? conjunct : Make<LogicExpression>(result, conjunct, LogicType::And);
+  }
+  return result;
+}
+
+const AbstractExpression *Optimizer::MapColumns(
+    const AbstractExpression *expr,
+    const std::function<const AbstractExpression *(const ColumnValueExpression *)> &map) {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    return map(column);
+  }
+  if (dynamic_cast<const ConstantValueExpression *>(expr) != nullptr) {
+    return expr;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr);
+  const auto *logic = dynamic_cast<const LogicExpression *>(expr);
+  if (comparison == nullptr && logic == nullptr) {
+    // An expression of which the optimizer does not know how to make another.
+    return nullptr;
+  }
+  const AbstractExpression *lhs = MapColumns(expr->GetChildAt(0), map);
+  const AbstractExpression *rhs = MapColumns(expr->GetChildAt(1), map);
+  if (lhs == nullptr || rhs == nullptr) {
+    return nullptr;
+  }
+  if (lhs == expr->GetChildAt(0) && rhs == expr->GetChildAt(1)) {
+    return expr;
+  }
+  if (comparison != nullptr) {
+    return Make<ComparisonExpression>(lhs, rhs, comparison->GetComparisonType());
+  }
+  return Make<LogicExpression>(lhs, rhs, logic->GetLogicType());
+}
+
+const AbstractExpression *Optimizer::SwapSides(const AbstractExpression *expr) {
+  if (expr == nullptr) {
+    return nullptr;
+  }
+  return MapColumns(expr, [this](const ColumnValueExpression *column) -> const AbstractExpression * {
+    return Make<ColumnValueExpression>(1 - column->GetTupleIdx(), column->GetColIdx(), column->GetReturnType());
+  });
+}
+
+const Schema *Optimizer::SwapSides(const Schema *schema) {
+  std::vector<Column> columns;
+  for (const Column &column : schema->GetColumns()) {
+    const AbstractExpression *swapped = SwapSides(column.GetExpr());
+    if (swapped == nullptr) {
+      return nullptr;
+    }
+    if (column.IsInlined()) {
+      columns.emplace_back(column.GetName(), column.GetType(), swapped);
+    } else {
+      columns.emplace_back(column.GetName(), column.GetType(), column.GetVariableLength(), swapped);
+    }
+  }
+  return Make<Schema>(columns);
+}
+
+int Optimizer::SidesRead(const AbstractExpression *expr) {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    return column->GetTupleIdx() == 0 ? 1 : 2;
+  }
+  int sides = 0;
+  for (const AbstractExpression *child : expr->GetChildren()) {
+    sides |= SidesRead(child);
+  }
+  return sides;
+}
+
+double Optimizer::Selectivity(const AbstractExpression *predicate, const ColumnResolver &resolve) const {
+  if (predicate == nullptr) {
+    return 1;
+  }
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(predicate); logic != nullptr) {
+    double lhs = Selectivity(logic->GetChildAt(0), resolve);
+    double rhs = Selectivity(logic->GetChildAt(1), resolve);
+    return logic->GetLogicType() == LogicType::And ? lhs * rhs : lhs + rhs - lhs * rhs;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return DEFAULT_SELECTIVITY;
+  }
+  const auto *lhs_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *rhs_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+  const auto *lhs_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+  const auto *rhs_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  ColumnSource lhs;
+  ColumnSource rhs;
+  if (lhs_column != nullptr && rhs_constant != nullptr && resolve(lhs_column, &lhs)) {
+    return CompareSelectivity(lhs, comparison->GetComparisonType(), rhs_constant->GetValue());
+  }
+  if (lhs_constant != nullptr && rhs_column != nullptr && resolve(rhs_column, &rhs)) {
+    return CompareSelectivity(rhs, Flip(comparison->GetComparisonType()), lhs_constant->GetValue());
+  }
+  if (lhs_column != nullptr && rhs_column != nullptr && resolve(lhs_column, &lhs) && resolve(rhs_column, &rhs)) {
+    if (comparison->GetComparisonType() == ComparisonType::Equal) {
+      return EqualSelectivity(lhs, rhs);
+    }
+    if (comparison->GetComparisonType() == ComparisonType::NotEqual) {
+      return 1 - EqualSelectivity(lhs, rhs);
+    }
+  }
+  return DEFAULT_SELECTIVITY;
+}
+
+double Optimizer::CompareSelectivity(const ColumnSource &column, ComparisonType comp_type, const Value &value) {
+  if (value.IsNull()) {
+    // A comparison with NULL is never true.
+    return 0;
+  }
+  const TableStatistics &stats = *column.stats_;
+  const double non_null = 1 - stats.GetNullFraction(column.col_idx_);
+  const double equal = stats.EstimateEqualFraction(column.col_idx_, value);
+  const double less = stats.EstimateLessThanFraction(column.col_idx_, value);
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      return Clamp(equal);
+    case ComparisonType::NotEqual:
+      return Clamp(non_null - equal);
+    case ComparisonType::LessThan:
+      return Clamp(less);
+    case ComparisonType::LessThanOrEqual:
+      return Clamp(less + equal);
+    case ComparisonType::GreaterThan:
+      return Clamp(non_null - less - equal);
+    case ComparisonType::GreaterThanOrEqual:
+      return Clamp(non_null - less);
+  }
+  return DEFAULT_SELECTIVITY;
+}
+
+double Optimizer::EqualSelectivity(const ColumnSource &left, const ColumnSource &right) {
+  // Each value of the side with fewer of them finds its match among the values of the other, as far as they go.
+  auto distinct = [](const ColumnSource &column) {
+    double count = static_cast<double>(column.stats_->GetDistinctCount(column.col_idx_));
+    return std::max(1.0, std::min(count, column.rows_));
+  };
+  return 1 / std::max(distinct(left), distinct(right));
+}
+
+bool Optimizer::TraceColumn(const AbstractPlanNode *plan, uint32_t col_idx, ColumnSource *source) const {
+  if (plan->OutputSchema() == nullptr || col_idx >= plan->OutputSchema()->GetColumnCount()) {
+    return false;
+  }
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(plan->OutputSchema()->GetColumn(col_idx).GetExpr());
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+    case PlanType::IndexScan:
+      if (column == nullptr) {
+        return false;
+      }
+      *source = ColumnSource{&ScanTable(plan)->stats_, column->GetColIdx(), 0};
+      break;
+    case PlanType::NestedLoopJoin:
+    case PlanType::HashJoin:
+    case PlanType::MergeJoin:
+      if (column == nullptr || !TraceColumn(plan->GetChildAt(column->GetTupleIdx()), column->GetColIdx(), source)) {
+        return false;
+      }
+      break;
+    case PlanType::Limit:
+    case PlanType::Sort:
+    case PlanType::Exchange:
+      // The rows of the child, as they are.
+      if (!TraceColumn(plan->GetChildAt(0), col_idx, source)) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+  // The rows that reach the plan have at most as many values as there are of them.
+  const double rows = EstimateRows(plan);
+  source->rows_ = plan->GetType() == PlanType::SeqScan || plan->GetType() == PlanType::IndexScan
+                      ? rows
+                      : std::min(source->rows_, rows);
+  return true;
+}
+
+Optimizer::ColumnResolver Optimizer::TableResolver(const TableMetadata *table) const {
+  const double rows = static_cast<double>(table->stats_.GetRowCount());
+  return [table, rows](const ColumnValueExpression *column, ColumnSource *source) {
+    if (column->GetColIdx() >= table->schema_.GetColumnCount()) {
+      return false;
+    }
+    *source = ColumnSource{&table->stats_, column->GetColIdx(), rows};
+    return true;
+  };
+}
+
+Optimizer::ColumnResolver Optimizer::JoinResolver(const AbstractPlanNode *left, const AbstractPlanNode *right) const {
+  return [this, left, right](const ColumnValueExpression *column, ColumnSource *source) {
+    return TraceColumn(column->GetTupleIdx() == 0 ? left : right, column->GetColIdx(), source);
+  };
+}
+
+double Optimizer::TablePages(const TableMetadata *table) {
+  // A tuple takes its slot of the page directory besides its data.
+  const double bytes =
+      static_cast<double>(table->stats_.GetRowCount()) * (table->schema_.GetLength() + 2 * sizeof(uint32_t));
+  return std::max(1.0, bytes / PAGE_SIZE);
+}
+
+const TableMetadata *Optimizer::ScanTable(const AbstractPlanNode *plan) const {
+  if (plan->GetType() == PlanType::SeqScan) {
+    return catalog_->GetTable(static_cast<const SeqScanPlanNode *>(plan)->GetTableOid());
+  }
+  const IndexInfo *index_info = catalog_->GetIndex(static_cast<const IndexScanPlanNode *>(plan)->GetIndexOid());
+  return catalog_->GetTable(index_info->table_name_);
+}
+
+double Optimizer::EstimateRows(const AbstractPlanNode *plan) const {
+  if (auto cached = rows_.find(plan); cached != rows_.end()) {
+    return cached->second;
+  }
+  double rows = 0;
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+    case PlanType::IndexScan: {
+      const TableMetadata *table = ScanTable(plan);
+      const AbstractExpression *predicate = plan->GetType() == PlanType::SeqScan
+                                                ? static_cast<const SeqScanPlanNode *>(plan)->GetPredicate()
+                                                : static_cast<const IndexScanPlanNode *>(plan)->GetPredicate();
+      rows = static_cast<double>(table->stats_.GetRowCount()) * Selectivity(predicate, TableResolver(table));
+      if (plan->GetType() == PlanType::SeqScan &&
+          static_cast<const SeqScanPlanNode *>(plan)->GetSample().method_ != SampleMethod::NONE) {
+        rows *= static_cast<const SeqScanPlanNode *>(plan)->GetSample().fraction_;
+      }
+      break;
+    }
+    case PlanType::NestedLoopJoin: {
+      const auto *join = static_cast<const NestedLoopJoinPlanNode *>(plan);
+      rows = EstimateRows(join->GetLeftPlan()) * EstimateRows(join->GetRightPlan()) *
+             Selectivity(join->Predicate(), JoinResolver(join->GetLeftPlan(), join->GetRightPlan()));
+      break;
+    }
+    case PlanType::HashJoin: {
+      const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+      rows = EstimateEquiJoinRows(join->GetLeftPlan(), join->GetRightPlan(), join->GetLeftKeys(), join->GetRightKeys(),
+                                  join->Predicate());
+      if (join->GetJoinType() != JoinType::Inner) {
+        // A right row is produced once however many rows it joins with: as many as join, at most every one.
+        const double right_rows = EstimateRows(join->GetRightPlan());
+        const double semi_rows = std::min(rows, right_rows);
+        rows = join->GetJoinType() == JoinType::Semi ? semi_rows : right_rows - semi_rows;
+      }
+      break;
+    }
+    case PlanType::MergeJoin: {
+      const auto *join = static_cast<const MergeJoinPlanNode *>(plan);
+      rows = EstimateEquiJoinRows(join->GetLeftPlan(), join->GetRightPlan(), join->GetLeftKeys(), join->GetRightKeys(),
+                                  join->Predicate());
+      break;
+    }
+    case PlanType::ViewScan: {
+      const auto *view_scan = static_cast<const ViewScanPlanNode *>(plan);
+      rows = static_cast<double>(catalog_->GetMaterializedView(view_scan->GetViewName())->Size());
+      break;
+    }
+    case PlanType::Aggregation: {
+      const auto *aggregation = static_cast<const AggregationPlanNode *>(plan);
+      rows = aggregation->GetGroupBys().empty() ? 1 : EstimateRows(aggregation->GetChildPlan());
+      if (aggregation->GetHaving() != nullptr) {
+        rows *= DEFAULT_SELECTIVITY;
+      }
+      break;
+    }
+    case PlanType::Limit: {
+      const auto *limit = static_cast<const LimitPlanNode *>(plan);
+      const double offset = static_cast<double>(limit->GetOffset());
+      rows = std::min(static_cast<double>(limit->GetLimit()),
+                      std::max(0.0, EstimateRows(limit->GetChildPlan()) - offset));
+      break;
+    }
+    case PlanType::Insert: {
+      const auto *insert = static_cast<const InsertPlanNode *>(plan);
+      rows = insert->IsRawInsert() ? static_cast<double>(insert->RawValues().size())
+                                   : EstimateRows(insert->GetChildPlan());
+      break;
+    }
+    default:
+      rows = plan->GetChildren().empty() ? 0 : EstimateRows(plan->GetChildAt(0));
+      break;
+  }
+  rows_[plan] = rows;
+  return rows;
+}
+
+double Optimizer::EstimateEquiJoinRows(const AbstractPlanNode *left_plan, const AbstractPlanNode *right_plan,
+                                       const std::vector<const AbstractExpression *> &left_keys,
+                                       const std::vector<const AbstractExpression *> &right_keys,
+                                       const AbstractExpression *predicate) const {
+  const double left_rows = EstimateRows(left_plan);
+  const double right_rows = EstimateRows(right_plan);
+  double selectivity = Selectivity(predicate, JoinResolver(left_plan, right_plan));
+  for (size_t i = 0; i < left_keys.size(); i++) {
+    const auto *left_key = dynamic_cast<const ColumnValueExpression *>(left_keys[i]);
+    const auto *right_key = dynamic_cast<const ColumnValueExpression *>(right_keys[i]);
+    ColumnSource left;
+    ColumnSource right;
+    if (left_key != nullptr && right_key != nullptr && TraceColumn(left_plan, left_key->GetColIdx(), &left) &&
+        TraceColumn(right_plan, right_key->GetColIdx(), &right)) {
+      selectivity *= EqualSelectivity(left, right);
+    } else {
+      selectivity /= std::max(1.0, std::max(left_rows, right_rows));
+    }
+  }
+  return left_rows * right_rows * selectivity;
+}
+
+double Optimizer::EstimateCost(const AbstractPlanNode *plan) const {
+  if (auto cached = costs_.find(plan); cached != costs_.end()) {
+    return cached->second;
+  }
+  double cost = 0;
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      const TableMetadata *table = ScanTable(plan);
+      // A sample of the pages reads only those, a sample of the tuples still reads them all.
+      const TableSample &sample = static_cast<const SeqScanPlanNode *>(plan)->GetSample();
+      const double read = sample.SamplesPages() ? sample.fraction_ : 1;
+      cost = read * (TablePages(table) + CPU_TUPLE_COST * static_cast<double>(table->stats_.GetRowCount()));
+      break;
+    }
+    case PlanType::IndexScan: {
+      const auto *scan = static_cast<const IndexScanPlanNode *>(plan);
+      const IndexInfo *index_info = catalog_->GetIndex(scan->GetIndexOid());
+      const TableMetadata *table = ScanTable(plan);
+      const TableStatistics &stats = table->stats_;
+      const auto rows = static_cast<double>(stats.GetRowCount());
+
+      // The entries of the range of the first key column the scan reads.
+      const uint32_t key_col = index_info->index_->GetKeyAttrs()[0];
+      double range = 1;
+      if (scan->GetLowerBound().has_value() || scan->GetUpperBound().has_value()) {
+        const double below = scan->GetLowerBound().has_value()
+                                 ? stats.EstimateLessThanFraction(key_col, *scan->GetLowerBound())
+                                 : 0;
+        const double up_to = scan->GetUpperBound().has_value()
+                                 ? stats.EstimateLessThanFraction(key_col, *scan->GetUpperBound()) +
+                                       stats.EstimateEqualFraction(key_col, *scan->GetUpperBound())
+                                 : 1 - stats.GetNullFraction(key_col);
+        range = Clamp(up_to - below);
+      }
+      const double matches = rows * range;
+
+      // A descent from the root, the leaves of the range in order, and the pages of the tuples, if it reads them.
+      const double entry_size = static_cast<double>(index_info->key_size_ + sizeof(RID));
+      const double leaf_capacity = PAGE_SIZE * INDEX_FILL_FACTOR / entry_size;
+      const double height = 1 + std::ceil(std::log(std::max(1.0, rows / leaf_capacity)) / std::log(leaf_capacity));
+      const double leaves = std::max(1.0, matches / leaf_capacity);
+      double fetches = matches;
+      if (IndexScanExecutor::IsCovered(scan, *index_info->index_, table->schema_)) {
+        fetches = 0;
+      } else if (scan->FetchesInPageOrder()) {
+        // Each page holding a match is read once, as many of them as the matches spread over.
+        const double pages = TablePages(table);
+        fetches = pages * (1 - std::pow(1 - 1 / pages, matches));
+      }
+      cost = RANDOM_PAGE_COST * (height + fetches) + leaves + CPU_TUPLE_COST * matches;
+      break;
+    }
+    case PlanType::NestedLoopJoin: {
+      // The right side is scanned again for every block of the left.
+      const auto *join = static_cast<const NestedLoopJoinPlanNode *>(plan);
+      const double left_rows = EstimateRows(join->GetLeftPlan());
+      const double right_rows = EstimateRows(join->GetRightPlan());
+      const double blocks = std::max(1.0, std::ceil(left_rows / static_cast<double>(join->GetBlockSize())));
+      cost = EstimateCost(join->GetLeftPlan()) + blocks * EstimateCost(join->GetRightPlan()) +
+             CPU_TUPLE_COST * left_rows * right_rows;
+      break;
+    }
+    case PlanType::HashJoin: {
+      const auto *join = static_cast<const HashJoinPlanNode *>(plan);
+      const double left_rows = EstimateRows(join->GetLeftPlan());
+      const double right_rows = EstimateRows(join->GetRightPlan());
+      cost = EstimateCost(join->GetLeftPlan()) + EstimateCost(join->GetRightPlan()) +
+             CPU_TUPLE_COST * (2 * left_rows + right_rows);
+      // Past the budget, both sides are written out in partitions and read back.
+      const double left_bytes = left_rows * join->GetLeftPlan()->OutputSchema()->GetLength();
+      if (left_bytes > static_cast<double>(join->GetMemoryBudget())) {
+        const double right_bytes = right_rows * join->GetRightPlan()->OutputSchema()->GetLength();
+        cost += 2 * (left_bytes + right_bytes) / PAGE_SIZE;
+      }
+      break;
+    }
+    case PlanType::MergeJoin: {
+      // Each side is read once, in order.
+      const auto *join = static_cast<const MergeJoinPlanNode *>(plan);
+      cost = EstimateCost(join->GetLeftPlan()) + EstimateCost(join->GetRightPlan()) +
+             CPU_TUPLE_COST * (EstimateRows(join->GetLeftPlan()) + EstimateRows(join->GetRightPlan()));
+      break;
+    }
+    case PlanType::Sort: {
+      const double rows = EstimateRows(plan);
+      cost = EstimateCost(plan->GetChildAt(0)) + CPU_TUPLE_COST * rows * std::log2(std::max(2.0, rows));
+      break;
+    }
+    default:
+      for (const AbstractPlanNode *child : plan->GetChildren()) {
+        cost += EstimateCost(child) + CPU_TUPLE_COST * EstimateRows(child);
+      }
+      break;
+  }
+  // Every plan processes the rows it outputs.
+  cost += CPU_TUPLE_COST * EstimateRows(plan);
+  costs_[plan] = cost;
+  return cost;
+}
+
+}  // namespace bustub
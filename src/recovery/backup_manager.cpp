@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// backup_manager.cpp
+//
+// Identification: src/recovery/backup_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/backup_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_ring.h"
+#include "common/exception.h"
+#include "recovery/log_recovery.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr uint32_t BACKUP_MAGIC = 0x42544231;
+
+/** The header of a backup file, see BackupManager. */
+struct BackupHeader {
+  uint32_t magic_;
+  lsn_t base_lsn_;
+  lsn_t backup_lsn_;
+  uint32_t num_pages_;
+  int64_t checkpoint_offset_;
+  int64_t log_offset_;
+  int64_t log_size_;
+};
+
+}  // namespace
+
+lsn_t BackupManager::Backup(const std::string &file_name, lsn_t base_lsn, size_t max_pages_per_second) {
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw Exception("can't open backup file " + file_name);
+  }
+  std::vector<page_id_t> page_ids = disk_manager_->TakeChangedPages();
+  const bool incremental = base_lsn != INVALID_LSN && base_lsn == changed_pages_lsn_;
+  if (incremental) {
+    // The pages changed since the base are those written since, and those still dirty.
+    std::unordered_map<page_id_t, lsn_t> dirty_page_table;
+    buffer_pool_manager_->GetDirtyPageTable(&dirty_page_table);
+    for (const auto &[page_id, rec_lsn] : dirty_page_table) {
+      page_ids.push_back(page_id);
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+    page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  } else {
+    page_ids.resize(disk_manager_->GetNumPages());
+    std::iota(page_ids.begin(), page_ids.end(), 0);
+  }
+  // The log from the start the checkpoint keeps on brings the pages copied up to date.
+  checkpoint_manager_->FuzzyCheckpoint();
+  BackupHeader header{BACKUP_MAGIC, base_lsn, INVALID_LSN, 0, disk_manager_->ReadMasterRecord(),
+                      disk_manager_->GetLogStart(), 0};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  BufferRing ring(BACKUP_RING_SIZE);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (max_pages_per_second != 0) {
+      std::this_thread::sleep_until(start + std::chrono::microseconds(i * 1000000 / max_pages_per_second));
+    }
+    const page_id_t page_id = page_ids[i];
+    Page *page = buffer_pool_manager_->FetchPageWithRing(page_id, &ring);
+    if (page == nullptr) {
+      throw Exception("no frame to read the pages of the backup in");
+    }
+    page->RLatch();
+    if (incremental || base_lsn == INVALID_LSN || page->GetLSN() > base_lsn) {
+      out.write(reinterpret_cast<const char *>(&page_id), sizeof(page_id_t));
+      out.write(page->GetData(), PAGE_SIZE);
+      header.num_pages_++;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+
+  // Every record of the pages copied is persistent, and so below the end of the log.
+  const lsn_t backup_lsn = log_manager_->GetNextLSN() - 1;
+  log_manager_->WaitUntilPersistent(backup_lsn);
+  std::vector<char> log(disk_manager_->GetLogSize() - header.log_offset_);
+  if (!disk_manager_->ReadLog(log.data(), static_cast<int>(log.size()), static_cast<int>(header.log_offset_))) {
+    throw Exception("the log of the backup was truncated");
+  }
+  // The records after them may be written still: the log is cut at the first one that is not whole.
+  auto log_size = static_cast<size_t>(header.checkpoint_offset_ - header.log_offset_);
+  while (LogRecord::IsWholeRecord(log.data() + log_size, log.size() - log_size)) {
+    int32_t record_size;
+    memcpy(&record_size, log.data() + log_size, sizeof(int32_t));
+    log_size += record_size;
+  }
+  out.write(log.data(), static_cast<std::streamsize>(log_size));
+
+  header.backup_lsn_ = backup_lsn;
+  header.log_size_ = static_cast<int64_t>(log_size);
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.flush();
+  if (!out) {
+    throw Exception("I/O error while writing backup file " + file_name);
+  }
+  changed_pages_lsn_ = backup_lsn;
+  num_pages_copied_ = header.num_pages_;
+  return backup_lsn;
+}
+
+lsn_t BackupManager::Restore(const std::string &file_name, DiskManager *disk_manager,
+                             BufferPoolManager *buffer_pool_manager) {
+  std::ifstream in(file_name, std::ios::binary);
+  BackupHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic_ != BACKUP_MAGIC) {
+    throw Exception(file_name + " is not a backup file");
+  }
+  std::vector<char> page(PAGE_SIZE);
+  for (uint32_t i = 0; i < header.num_pages_; i++) {
+    page_id_t page_id;
+    if (!in.read(reinterpret_cast<char *>(&page_id), sizeof(page_id_t)) || !in.read(page.data(), PAGE_SIZE)) {
+      throw Exception("backup file " + file_name + " is truncated");
+    }
+    disk_manager->WritePage(page_id, page.data());
+  }
+  std::vector<char> log(header.log_size_);
+  if (!in.read(log.data(), static_cast<std::streamsize>(log.size()))) {
+    throw Exception("backup file " + file_name + " is truncated");
+  }
+  disk_manager->RestoreLog(log.data(), log.size(), header.log_offset_, header.checkpoint_offset_);
+  LogRecovery log_recovery(disk_manager, buffer_pool_manager);
+  log_recovery.Redo();
+  buffer_pool_manager->FlushAllPages();
+  return header.backup_lsn_;
+}
+
+}  // namespace bustub
@@ -12,16 +12,50 @@
 
 #include "recovery/checkpoint_manager.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace bustub {
 
 void CheckpointManager::BeginCheckpoint() {
   // Block all the transactions and ensure that both the WAL and all dirty buffer pool pages are persisted to disk,
   // creating a consistent checkpoint. Do NOT allow transactions to resume at the end of this method, resume them
   // in CheckpointManager::EndCheckpoint() instead. This is for grading purposes.
+  transaction_manager_->BlockAllTransactions();
+  buffer_pool_manager_->FlushAllPages();
+  LogCheckpoint();
 }
 
 void CheckpointManager::EndCheckpoint() {
   // Allow transactions to resume, completing the checkpoint.
+  transaction_manager_->ResumeTransactions();
+}
+
+void CheckpointManager::FuzzyCheckpoint() {
+  const lsn_t lsn = LogCheckpoint();
+  if (lsn != INVALID_LSN) {
+    buffer_pool_manager_->SetCheckpointLSN(lsn);
+  }
+}
+
+lsn_t CheckpointManager::LogCheckpoint() {
+  if (!enable_logging || log_manager_ == nullptr || log_manager_->GetDiskManager() == nullptr) {
+    return INVALID_LSN;
+  }
+  DiskManager *disk_manager = log_manager_->GetDiskManager();
+  const int64_t checkpoint_offset = disk_manager->GetLogSize();
+  std::unordered_map<txn_id_t, lsn_t> txn_table;
+  const int64_t undo_offset = std::min(checkpoint_offset, transaction_manager_->GetTransactionTable(&txn_table));
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table;
+  const int64_t redo_offset =
+      std::min(checkpoint_offset, buffer_pool_manager_->GetDirtyPageTable(&dirty_page_table));
+  LogRecord log_record(LogRecordType::CHECKPOINT, redo_offset, undo_offset, txn_table, dirty_page_table);
+  const lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+  log_manager_->WaitUntilPersistent(lsn);
+  disk_manager->WriteMasterRecord(checkpoint_offset);
+  // The recovery from this checkpoint on reads nothing before its redo and its undo.
+  disk_manager->TruncateLog(std::min(redo_offset, undo_offset));
+  return lsn;
 }
 
 }  // namespace bustub
@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_compression.cpp
+//
+// Identification: src/recovery/log_compression.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** The matches are looked up in a table of the last positions of 1 << HASH_BITS hashes of four bytes. */
+constexpr size_t HASH_BITS = 12;
+/** The farthest back a match can be, for its offset to fit in two bytes. */
+constexpr size_t MAX_OFFSET = 65535;
+
+uint32_t Read32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(uint32_t));
+  return value;
+}
+
+size_t Hash(uint32_t value) { return (value * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the bytes added to a nibble of 15. @return false if they do not fit before end */
+bool WriteLength(size_t length, char **out, const char *end) {
+  for (; length >= 255; length -= 255) {
+    if (*out == end) {
+      return false;
+    }
+    *(*out)++ = static_cast<char>(255);
+  }
+  if (*out == end) {
+    return false;
+  }
+  *(*out)++ = static_cast<char>(length);
+  return true;
+}
+
+/** Adds the bytes following a nibble of 15 to length. @return false if the input ends first */
+bool ReadLength(size_t *length, const unsigned char **in, const unsigned char *end) {
+  unsigned char byte;
+  do {
+    if (*in == end) {
+      return false;
+    }
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Writes a sequence, the last one if match_length is 0. @return false if it does not fit before end */
+bool WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length, char **out,
+                   const char *end) {
+  const size_t match_code = match_length == 0 ? 0 : match_length - LOG_MIN_MATCH;
+  if (*out == end) {
+    return false;
+  }
+  *(*out)++ = static_cast<char>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (literal_length >= 15 && !WriteLength(literal_length - 15, out, end)) {
+    return false;
+  }
+  if (static_cast<size_t>(end - *out) < literal_length) {
+    return false;
+  }
+  memcpy(*out, literals, literal_length);
+  *out += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (end - *out < static_cast<ptrdiff_t>(sizeof(uint16_t))) {
+    return false;
+  }
+  const auto encoded_offset = static_cast<uint16_t>(offset);
+  memcpy(*out, &encoded_offset, sizeof(uint16_t));
+  *out += sizeof(uint16_t);
+  return match_code < 15 || WriteLength(match_code - 15, out, end);
+}
+
+}  // namespace
+
+size_t LogCompressor::Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  // One past the last position of each hash, 0 if none yet.
+  uint32_t positions[1 << HASH_BITS] = {0};
+  char *out = dst;
+  const char *out_end = dst + capacity;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + LOG_MIN_MATCH <= size) {
+    const uint32_t value = Read32(src + pos);
+    const size_t hash = Hash(value);
+    const size_t candidate = positions[hash];
+    positions[hash] = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != value) {
+      pos++;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t length = LOG_MIN_MATCH;
+    while (pos + length < size && src[match + length] == src[pos + length]) {
+      length++;
+    }
+    if (!WriteSequence(src + anchor, pos - anchor, pos - match, length, &out, out_end)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!WriteSequence(src + anchor, size - anchor, 0, 0, &out, out_end)) {
+    return 0;
+  }
+  return out - dst;
+}
+
+size_t LogCompressor::Decompress(const char *src, size_t size, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *in_end = in + size;
+  char *out = dst;
+  const char *out_end = dst + capacity;
+  while (in < in_end) {
+    const unsigned token = *in++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(&literal_length, &in, in_end)) {
+      return 0;
+    }
+    if (static_cast<size_t>(in_end - in) < literal_length || static_cast<size_t>(out_end - out) < literal_length) {
+      return 0;
+    }
+    memcpy(out, in, literal_length);
+    out += literal_length;
+    in += literal_length;
+    if (in == in_end) {
+      break;
+    }
+    if (in_end - in < static_cast<ptrdiff_t>(sizeof(uint16_t))) {
+      return 0;
+    }
+    uint16_t offset;
+    memcpy(&offset, in, sizeof(uint16_t));
+    in += sizeof(uint16_t);
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(&match_length, &in, in_end)) {
+      return 0;
+    }
+    match_length += LOG_MIN_MATCH;
+    if (offset == 0 || offset > out - dst || static_cast<size_t>(out_end - out) < match_length) {
+      return 0;
+    }
+    // Byte by byte, for a match overlapping the bytes it copies.
+    const char *match = out - offset;
+    for (size_t i = 0; i < match_length; i++) {
+      out[i] = match[i];
+    }
+    out += match_length;
+  }
+  return out - dst;
+}
+
+}  // namespace bustub
@@ -12,7 +12,19 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "common/logger.h"
+#include "recovery/log_compression.h"
+
 namespace bustub {
+
+std::atomic<uint64_t> LogManager::next_instance_id{1};
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
@@ -22,33 +34,522 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::unique_lock<std::mutex> latch(latch_);
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  enable_logging = true;
+  flush_thread_ = new std::thread([this] {
+    std::unique_ptr<DiskBackend> backend;
+    if (buffer_mode_ == LogBufferMode::SHARED && disk_manager_ != nullptr) {
+      backend = disk_manager_->CreateLogBackend();
+    }
+    std::unique_lock<std::mutex> latch(latch_);
+    auto wants_flush = [this] { return !running_ || flush_lsn_ > submitted_lsn_; };
+    if (backend == nullptr) {
+      while (running_ || HasUnwritten()) {
+        // Waits for a commit to wait for its records, or the buffer to fill up, or the timeout. The committers
+        // arriving during a write append behind it, and the next write takes all of them.
+        cv_.wait_for(latch, log_timeout, wants_flush);
+        if (HasUnwritten()) {
+          Flush(&latch);
+        }
+      }
+      return;
+    }
+    while (running_ || HasUnwritten() || !writes_.empty()) {
+      const bool has_free_buffer = writes_.size() + 1 < LOG_NUM_BUFFERS;
+      bool timed_out = false;
+      if (writes_.empty()) {
+        timed_out = !cv_.wait_for(latch, log_timeout, wants_flush);
+      } else if (running_ && has_free_buffer) {
+        // Watches for the next commits while the writes are in flight, polling them now and then.
+        cv_.wait_for(latch, LOG_POLL_INTERVAL, wants_flush);
+      }
+      if (OffsetOf(reservation_) > 0 && has_free_buffer && (timed_out || wants_flush())) {
+        FlushAsync(&latch, backend.get());
+      }
+      if (!writes_.empty()) {
+        // The completions run on this thread, and retire the writes in order.
+        const bool poll = running_ && writes_.size() + 1 < LOG_NUM_BUFFERS;
+        latch.unlock();
+        if (poll) {
+          backend->Poll();
+        } else {
+          backend->WaitAny();
+        }
+        latch.lock();
+      }
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  {
+    std::scoped_lock latch(latch_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cv_.notify_one();
+  flush_thread_->join();
+  delete flush_thread_;
+  flush_thread_ = nullptr;
+  enable_logging = false;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  const auto start = std::chrono::steady_clock::now();
+  if (compress_payloads_) {
+    CompressLogRecord(log_record);
+  }
+  if (buffer_mode_ == LogBufferMode::PER_THREAD) {
+    const lsn_t lsn = AppendToThreadBuffer(log_record);
+    metrics_.append_latency_ns_.RecordSince<std::chrono::nanoseconds>(start);
+    return lsn;
+  }
+  const auto size = static_cast<size_t>(log_record->GetSize());
+  uint64_t reservation = reservation_.load();
+  while (true) {
+    if (OffsetOf(reservation) + size <= static_cast<size_t>(LOG_BUFFER_SIZE)) {
+      // The room of the record and its LSN at once, so that the records are in the buffer in the order of their LSNs.
+      if (reservation_.compare_exchange_weak(reservation, reservation + (static_cast<uint64_t>(size) << 32) + 1)) {
+        break;
+      }
+      continue;
+    }
+    // The buffer is full: the flush thread switches to the next one once that is free.
+    std::unique_lock<std::mutex> latch(latch_);
+    if (reservation_.load() == reservation) {
+      if (running_) {
+        flush_lsn_ = std::max(flush_lsn_, NextLSNOf(reservation) - 1);
+        cv_.notify_one();
+        append_cv_.wait(latch, [&] { return EpochOf(reservation_) != EpochOf(reservation); });
+      } else if (!flushing_) {
+        Flush(&latch);
+      } else {
+        persistent_cv_.wait(latch);
+      }
+    }
+    reservation = reservation_.load();
+  }
+  const size_t epoch = EpochOf(reservation);
+  log_record->lsn_ = NextLSNOf(reservation);
+  SerializeLogRecord(log_record, buffers_[epoch] + OffsetOf(reservation));
+  num_copied_[epoch].fetch_add(size, std::memory_order_release);
+  metrics_.append_latency_ns_.RecordSince<std::chrono::nanoseconds>(start);
+  return log_record->lsn_;
+}
+
+void LogManager::WaitUntilPersistent(lsn_t lsn) {
+  std::unique_lock<std::mutex> latch(latch_);
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  num_commit_waits_++;
+  AwaitPersistent(&latch, lsn);
+}
+
+void LogManager::AwaitPersistent(std::unique_lock<std::mutex> *latch, lsn_t lsn) {
+  while (persistent_lsn_ < lsn) {
+    if (running_) {
+      // Registers the LSN with the next write, which wakes up every committer it covers.
+      if (flush_lsn_ < lsn) {
+        flush_lsn_ = lsn;
+        cv_.notify_one();
+      }
+      persistent_cv_.wait(*latch);
+    } else if (!flushing_ && lsn < GetNextLSN()) {
+      Flush(latch);
+    } else {
+      // Another write is in progress, or the LSN was not appended here and is set by SetPersistentLSN.
+      persistent_cv_.wait(*latch);
+    }
+  }
+}
+
+void LogManager::Flush(std::unique_lock<std::mutex> *latch) {
+  if (buffer_mode_ == LogBufferMode::PER_THREAD) {
+    FlushThreadBuffers(latch);
+    return;
+  }
+  flushing_ = true;
+  const uint64_t reservation = SwitchBuffer();
+  const size_t epoch = EpochOf(reservation);
+  const size_t size = OffsetOf(reservation);
+  const lsn_t lsn = NextLSNOf(reservation) - 1;
+
+  latch->unlock();
+  WaitForCopies(reservation);
+  if (disk_manager_ != nullptr) {
+    const auto start = std::chrono::steady_clock::now();
+    disk_manager_->WriteLog(buffers_[epoch], static_cast<int>(size));
+    metrics_.write_latency_us_.RecordSince(start);
+  }
+  Publish(buffers_[epoch], size);
+  num_copied_[epoch].store(0);
+  latch->lock();
+
+  flushing_ = false;
+  persistent_lsn_ = std::max(persistent_lsn_.load(), lsn);
+  persistent_cv_.notify_all();
+}
+
+void LogManager::FlushAsync(std::unique_lock<std::mutex> *latch, DiskBackend *backend) {
+  const uint64_t reservation = SwitchBuffer();
+  const size_t epoch = EpochOf(reservation);
+  writes_.push_back(
+      {epoch, NextLSNOf(reservation) - 1, OffsetOf(reservation), std::chrono::steady_clock::now(), false});
+
+  latch->unlock();
+  WaitForCopies(reservation);
+  auto on_written = [this, epoch](bool ok) {
+    if (!ok) {
+      LOG_DEBUG("I/O error while writing log");
+    }
+    std::scoped_lock latch(latch_);
+    for (auto &write : writes_) {
+      if (write.epoch_ == epoch && !write.done_) {
+        metrics_.write_latency_us_.RecordSince(write.submitted_);
+        write.done_ = true;
+      }
+    }
+    // The writes may complete in any order; the records are persistent up to the first one still in flight.
+    while (!writes_.empty() && writes_.front().done_) {
+      Publish(buffers_[writes_.front().epoch_], writes_.front().size_);
+      persistent_lsn_ = std::max(persistent_lsn_.load(), writes_.front().last_lsn_);
+      num_copied_[writes_.front().epoch_].store(0);
+      writes_.pop_front();
+    }
+    persistent_cv_.notify_all();
+  };
+  disk_manager_->WriteLogAsync(backend, buffers_[epoch], static_cast<int>(OffsetOf(reservation)), on_written);
+  latch->lock();
+}
+
+uint64_t LogManager::SwitchBuffer() {
+  // The next reservations go to the next buffer, from its start; the LSNs go on.
+  uint64_t reservation = reservation_.load();
+  uint64_t switched;
+  do {
+    switched = (static_cast<uint64_t>((EpochOf(reservation) + 1) % LOG_NUM_BUFFERS) << 62) |
+               static_cast<uint32_t>(reservation);
+  } while (!reservation_.compare_exchange_weak(reservation, switched));
+  if (OffsetOf(reservation) > 0) {
+    metrics_.flush_bytes_.Record(OffsetOf(reservation));
+    metrics_.flush_records_.Record(NextLSNOf(reservation) - 1 - submitted_lsn_);
+  }
+  submitted_lsn_ = NextLSNOf(reservation) - 1;
+  append_cv_.notify_all();
+  return reservation;
+}
+
+void LogManager::WaitForCopies(uint64_t reservation) {
+  // The appenders that reserved room in the buffer before the switch copy their records in a few instructions.
+  while (num_copied_[EpochOf(reservation)].load(std::memory_order_acquire) < OffsetOf(reservation)) {
+    std::this_thread::yield();
+  }
+}
+
+lsn_t LogManager::AppendToThreadBuffer(LogRecord *log_record) {
+  const auto size = static_cast<size_t>(log_record->GetSize());
+  ThreadLogBuffer *buffer = GetThreadLogBuffer();
+  while (true) {
+    {
+      // Only a flush taking the records out competes for the latch.
+      std::scoped_lock buffer_latch(buffer->latch_);
+      if (buffer->size_ + size <= static_cast<size_t>(LOG_BUFFER_SIZE)) {
+        // The LSN is taken under the latch, so that a flush finds every record below the next LSN it reads.
+        log_record->lsn_ = NextLSNOf(reservation_.fetch_add(1));
+        SerializeLogRecord(log_record, buffer->data_.get() + buffer->size_);
+        buffer->size_ += size;
+        buffer->last_lsn_ = log_record->lsn_;
+        return log_record->lsn_;
+      }
+    }
+    // The buffer is full: the next flush takes all of its records out, then writes them while the thread goes on.
+    std::unique_lock<std::mutex> latch(latch_);
+    auto has_room = [&] {
+      std::scoped_lock buffer_latch(buffer->latch_);
+      return buffer->size_ + size <= static_cast<size_t>(LOG_BUFFER_SIZE);
+    };
+    if (running_) {
+      flush_lsn_ = std::max(flush_lsn_, buffer->last_lsn_);
+      cv_.notify_one();
+      append_cv_.wait(latch, has_room);
+    } else if (!flushing_) {
+      Flush(&latch);
+    } else {
+      persistent_cv_.wait(latch);
+    }
+  }
+}
+
+LogManager::ThreadLogBuffer *LogManager::GetThreadLogBuffer() {
+  thread_local uint64_t cached_instance_id = 0;
+  thread_local ThreadLogBuffer *cached_buffer = nullptr;
+  if (cached_instance_id != instance_id_) {
+    std::scoped_lock latch(thread_buffers_latch_);
+    auto &buffer = thread_buffers_[std::this_thread::get_id()];
+    if (buffer == nullptr) {
+      buffer = std::make_unique<ThreadLogBuffer>();
+    }
+    cached_instance_id = instance_id_;
+    cached_buffer = buffer.get();
+  }
+  return cached_buffer;
+}
+
+void LogManager::FlushThreadBuffers(std::unique_lock<std::mutex> *latch) {
+  flushing_ = true;
+  const lsn_t next_lsn = GetNextLSN();
+  const lsn_t num_records = next_lsn - 1 - submitted_lsn_;
+  submitted_lsn_ = next_lsn - 1;
+  latch->unlock();
+
+  // Takes the records below next_lsn out of every buffer, leaving those appended since in it.
+  std::vector<ThreadLogBuffer *> buffers;
+  size_t num_bytes = 0;
+  {
+    std::scoped_lock buffers_latch(thread_buffers_latch_);
+    for (auto &[thread_id, buffer] : thread_buffers_) {
+      std::scoped_lock buffer_latch(buffer->latch_);
+      size_t taken_size = 0;
+      while (taken_size < buffer->size_ && LSNAt(buffer->data_.get() + taken_size) < next_lsn) {
+        taken_size += SizeAt(buffer->data_.get() + taken_size);
+      }
+      if (taken_size == 0) {
+        continue;
+      }
+      std::swap(buffer->data_, buffer->taken_);
+      buffer->taken_size_ = taken_size;
+      buffer->size_ -= taken_size;
+      memcpy(buffer->data_.get(), buffer->taken_.get() + taken_size, buffer->size_);
+      buffers.push_back(buffer.get());
+      num_bytes += taken_size;
+    }
+  }
+  if (num_bytes > 0) {
+    metrics_.flush_bytes_.Record(num_bytes);
+    metrics_.flush_records_.Record(num_records);
+  }
+  // Under latch_, so that no appender misses the room made between checking for it and waiting for it.
+  latch->lock();
+  append_cv_.notify_all();
+  latch->unlock();
+
+  if (buffers.size() == 1 && disk_manager_ != nullptr) {
+    // A single buffer needs no merge, and its two arrays are written by turns.
+    const auto start = std::chrono::steady_clock::now();
+    disk_manager_->WriteLog(buffers[0]->taken_.get(), static_cast<int>(buffers[0]->taken_size_));
+    metrics_.write_latency_us_.RecordSince(start);
+    Publish(buffers[0]->taken_.get(), buffers[0]->taken_size_);
+    buffers.clear();
+  }
+  // Merges them in the order of their LSNs, through buffers_ by turns.
+  using Head = std::pair<lsn_t, size_t>;
+  std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+  std::vector<size_t> positions(buffers.size(), 0);
+  for (size_t i = 0; i < buffers.size(); i++) {
+    heads.emplace(LSNAt(buffers[i]->taken_.get()), i);
+  }
+  size_t merged_size = 0;
+  while (!heads.empty()) {
+    const size_t i = heads.top().second;
+    heads.pop();
+    const char *record = buffers[i]->taken_.get() + positions[i];
+    const size_t size = SizeAt(record);
+    if (merged_size + size > static_cast<size_t>(LOG_BUFFER_SIZE)) {
+      WriteMerged(merged_size);
+      merged_size = 0;
+    }
+    memcpy(buffers_[merge_buffer_] + merged_size, record, size);
+    merged_size += size;
+    positions[i] += size;
+    if (positions[i] < buffers[i]->taken_size_) {
+      heads.emplace(LSNAt(buffers[i]->taken_.get() + positions[i]), i);
+    }
+  }
+  if (merged_size > 0) {
+    WriteMerged(merged_size);
+  }
+  latch->lock();
+
+  flushing_ = false;
+  persistent_lsn_ = std::max(persistent_lsn_.load(), next_lsn - 1);
+  persistent_cv_.notify_all();
+}
+
+void LogManager::WriteMerged(size_t size) {
+  if (disk_manager_ != nullptr) {
+    const auto start = std::chrono::steady_clock::now();
+    disk_manager_->WriteLog(buffers_[merge_buffer_], static_cast<int>(size));
+    metrics_.write_latency_us_.RecordSince(start);
+  }
+  Publish(buffers_[merge_buffer_], size);
+  merge_buffer_ ^= 1;
+}
+
+size_t LogManager::Subscribe(LogSubscriber subscriber) {
+  std::scoped_lock subscribers_latch(subscribers_latch_);
+  subscribers_.emplace(next_subscriber_id_, std::move(subscriber));
+  return next_subscriber_id_++;
+}
+
+void LogManager::Unsubscribe(size_t subscriber_id) {
+  std::scoped_lock subscribers_latch(subscribers_latch_);
+  subscribers_.erase(subscriber_id);
+}
+
+void LogManager::Publish(const char *data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  std::scoped_lock subscribers_latch(subscribers_latch_);
+  for (auto &[subscriber_id, subscriber] : subscribers_) {
+    subscriber(data, size);
+  }
+}
+
+void LogManager::SetNextLSN(lsn_t lsn) {
+  std::scoped_lock latch(latch_);
+  const uint64_t reservation = reservation_;
+  assert(OffsetOf(reservation) == 0 && writes_.empty());
+  reservation_ = (reservation & ~uint64_t{0xffffffff}) | static_cast<uint32_t>(lsn);
+  persistent_lsn_ = lsn - 1;
+  submitted_lsn_ = lsn - 1;
+}
+
+void LogManager::CompressLogRecord(LogRecord *log_record) {
+  const size_t body_size = log_record->GetSize() - LogRecord::HEADER_SIZE;
+  if (body_size <= LOG_COMPRESSION_THRESHOLD) {
+    return;
+  }
+  thread_local std::vector<char> serialized;
+  serialized.resize(log_record->GetSize());
+  SerializeLogRecord(log_record, serialized.data());
+  // Kept only if smaller, with its size in front of it.
+  auto &compressed = log_record->compressed_;
+  compressed.resize(body_size);
+  const size_t compressed_size =
+      LogCompressor::Compress(serialized.data() + LogRecord::HEADER_SIZE, body_size,
+                              compressed.data() + sizeof(int32_t), body_size - sizeof(int32_t));
+  if (compressed_size == 0) {
+    compressed.clear();
+    return;
+  }
+  const auto uncompressed_size = static_cast<int32_t>(body_size);
+  memcpy(compressed.data(), &uncompressed_size, sizeof(int32_t));
+  compressed.resize(sizeof(int32_t) + compressed_size);
+  log_record->size_ = LogRecord::HEADER_SIZE + compressed.size();
+}
+
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *data) {
+  // HEADER: | size | LSN | transID | prevLSN | LogType | checksum |, the first fields of the record
+  memcpy(data, log_record, LogRecord::HEADER_SIZE);
+  size_t pos = LogRecord::HEADER_SIZE;
+  if (!log_record->compressed_.empty()) {
+    const int32_t log_type = static_cast<int32_t>(log_record->log_record_type_) | LOG_COMPRESSED_FLAG;
+    memcpy(data + 16, &log_type, sizeof(int32_t));
+    memcpy(data + pos, log_record->compressed_.data(), log_record->compressed_.size());
+    LogRecord::SetChecksum(data);
+    return;
+  }
+  auto write_rid_and_tuple = [&](const RID &rid, const Tuple &tuple) {
+    memcpy(data + pos, &rid, sizeof(RID));
+    pos += sizeof(RID);
+    tuple.SerializeTo(data + pos);
+    pos += sizeof(int32_t) + tuple.GetLength();
+  };
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      write_rid_and_tuple(log_record->insert_rid_, log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      write_rid_and_tuple(log_record->delete_rid_, log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE:
+      write_rid_and_tuple(log_record->update_rid_, log_record->old_tuple_);
+      log_record->new_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(data + pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      memcpy(data + pos + sizeof(page_id_t), &log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::OVERFLOWPAGE:
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      memcpy(data + pos + sizeof(page_id_t), log_record->page_image_, PAGE_SIZE);
+      break;
+    case LogRecordType::DELTAUPDATE:
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      memcpy(data + pos + sizeof(RID), log_record->delta_.data(), log_record->delta_.size());
+      break;
+    case LogRecordType::INCREMENT: {
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      const auto num_increments = static_cast<int32_t>(log_record->increments_.size());
+      memcpy(data + pos, &num_increments, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const ColumnIncrement &increment : log_record->increments_) {
+        const auto type_id = static_cast<int32_t>(increment.type_);
+        memcpy(data + pos, &increment.offset_, sizeof(uint32_t));
+        memcpy(data + pos + sizeof(uint32_t), &type_id, sizeof(int32_t));
+        memcpy(data + pos + 2 * sizeof(int32_t), &increment.amount_, sizeof(int64_t));
+        pos += LogRecord::INCREMENT_SIZE;
+      }
+      break;
+    }
+    case LogRecordType::APPLYDELETES: {
+      const auto num_tuples = static_cast<int32_t>(log_record->delete_tuples_.size());
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      memcpy(data + pos + sizeof(page_id_t), &num_tuples, sizeof(int32_t));
+      pos += sizeof(page_id_t) + sizeof(int32_t);
+      for (const auto &[rid, tuple] : log_record->delete_tuples_) {
+        write_rid_and_tuple(rid, tuple);
+      }
+      break;
+    }
+    case LogRecordType::CLR:
+      memcpy(data + pos, &log_record->undo_next_lsn_, sizeof(lsn_t));
+      memcpy(data + pos + sizeof(lsn_t), log_record->undone_.data(), log_record->undone_.size());
+      break;
+    case LogRecordType::CHECKPOINT: {
+      auto write = [&](const auto &value) {
+        memcpy(data + pos, &value, sizeof(value));
+        pos += sizeof(value);
+      };
+      write(log_record->redo_offset_);
+      write(log_record->undo_offset_);
+      write(static_cast<int32_t>(log_record->txn_table_.size()));
+      for (const auto &[txn_id, last_lsn] : log_record->txn_table_) {
+        write(txn_id);
+        write(last_lsn);
+      }
+      write(static_cast<int32_t>(log_record->dirty_page_table_.size()));
+      for (const auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+        write(page_id);
+        write(rec_lsn);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  LogRecord::SetChecksum(data);
+}
 
 }  // namespace bustub
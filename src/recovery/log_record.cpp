@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_record.cpp
+//
+// Identification: src/recovery/log_record.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_record.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "common/util/crc32c_util.h"
+
+namespace bustub {
+
+namespace {
+
+/** The bytes a range of a delta takes besides its data: offset, old_length and new_length. */
+constexpr uint32_t RANGE_HEADER_SIZE = 3 * sizeof(uint32_t);
+
+void Append32(std::vector<char> *out, uint32_t value) {
+  const size_t pos = out->size();
+  out->resize(pos + sizeof(uint32_t));
+  memcpy(out->data() + pos, &value, sizeof(uint32_t));
+}
+
+uint32_t Read32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(uint32_t));
+  return value;
+}
+
+}  // namespace
+
+void LogRecord::EncodeDelta(const Tuple &old_tuple, const Tuple &new_tuple) {
+  const char *old_data = old_tuple.GetData();
+  const char *new_data = new_tuple.GetData();
+  const uint32_t old_size = old_tuple.GetLength();
+  const uint32_t new_size = new_tuple.GetLength();
+  const uint32_t min_size = std::min(old_size, new_size);
+  uint32_t prefix = 0;
+  while (prefix < min_size && old_data[prefix] == new_data[prefix]) {
+    prefix++;
+  }
+  uint32_t suffix = 0;
+  while (suffix < min_size - prefix && old_data[old_size - 1 - suffix] == new_data[new_size - 1 - suffix]) {
+    suffix++;
+  }
+
+  // Each range as offset, old_length and new_length.
+  std::vector<std::array<uint32_t, 3>> ranges;
+  if (old_size != new_size) {
+    // The bytes after a value that changed size are shifted, one range replaces everything between the common ends.
+    ranges.push_back({prefix, old_size - suffix - prefix, new_size - suffix - prefix});
+  } else {
+    // The runs of bytes that changed, merged across the gaps shorter than the header of a range.
+    const uint32_t changed_end = old_size - suffix;
+    uint32_t pos = prefix;
+    while (pos < changed_end) {
+      uint32_t end;
+      uint32_t next = pos;
+      do {
+        end = next;
+        while (end < changed_end && old_data[end] != new_data[end]) {
+          end++;
+        }
+        next = end;
+        while (next < changed_end && old_data[next] == new_data[next]) {
+          next++;
+        }
+      } while (next < changed_end && next - end < RANGE_HEADER_SIZE);
+      ranges.push_back({pos, end - pos, end - pos});
+      pos = next;
+    }
+  }
+
+  Append32(&delta_, old_size);
+  Append32(&delta_, new_size);
+  Append32(&delta_, static_cast<uint32_t>(ranges.size()));
+  for (const auto &[offset, old_length, new_length] : ranges) {
+    Append32(&delta_, offset);
+    Append32(&delta_, old_length);
+    Append32(&delta_, new_length);
+    delta_.insert(delta_.end(), old_data + offset, old_data + offset + old_length);
+    // A range is at the same offset in both tuples: either they are of the same size, or it is the only range.
+    delta_.insert(delta_.end(), new_data + offset, new_data + offset + new_length);
+  }
+}
+
+bool LogRecord::ApplyDelta(const Tuple &tuple, Tuple *result, bool undo) const {
+  assert(log_record_type_ == LogRecordType::DELTAUPDATE);
+  const char *delta = delta_.data();
+  const uint32_t old_size = Read32(delta);
+  const uint32_t new_size = Read32(delta + sizeof(uint32_t));
+  const uint32_t num_ranges = Read32(delta + 2 * sizeof(uint32_t));
+  const uint32_t from_size = undo ? new_size : old_size;
+  const uint32_t to_size = undo ? old_size : new_size;
+  if (tuple.GetLength() != from_size) {
+    return false;
+  }
+
+  // Built in the serialized form of a tuple, | tuple_size | tuple_data |.
+  std::vector<char> storage(sizeof(int32_t) + to_size);
+  memcpy(storage.data(), &to_size, sizeof(int32_t));
+  char *out = storage.data() + sizeof(int32_t);
+  const char *from = tuple.GetData();
+  size_t pos = 3 * sizeof(uint32_t);
+  uint32_t cursor = 0;
+  // The offset in the new tuple less the one in the old tuple, past the ranges so far.
+  int64_t shift = 0;
+  for (uint32_t i = 0; i < num_ranges; i++) {
+    const uint32_t offset = Read32(delta + pos);
+    const uint32_t old_length = Read32(delta + pos + sizeof(uint32_t));
+    const uint32_t new_length = Read32(delta + pos + 2 * sizeof(uint32_t));
+    const char *old_bytes = delta + pos + RANGE_HEADER_SIZE;
+    const char *new_bytes = old_bytes + old_length;
+    pos += RANGE_HEADER_SIZE + old_length + new_length;
+
+    const auto from_offset = static_cast<uint32_t>(undo ? offset + shift : offset);
+    const uint32_t to_length = undo ? old_length : new_length;
+    memcpy(out, from + cursor, from_offset - cursor);
+    out += from_offset - cursor;
+    memcpy(out, undo ? old_bytes : new_bytes, to_length);
+    out += to_length;
+    cursor = from_offset + (undo ? new_length : old_length);
+    shift += static_cast<int64_t>(new_length) - old_length;
+  }
+  memcpy(out, from + cursor, from_size - cursor);
+  result->DeserializeFrom(storage.data());
+  return true;
+}
+
+uint32_t LogRecord::ComputeChecksum(const char *data) {
+  int32_t size;
+  memcpy(&size, data, sizeof(int32_t));
+  const uint32_t crc = Crc32cUtil::Crc32c(data, CHECKSUM_OFFSET);
+  return Crc32cUtil::Crc32c(data + HEADER_SIZE, size - HEADER_SIZE, crc);
+}
+
+void LogRecord::SetChecksum(char *data) {
+  const uint32_t checksum = ComputeChecksum(data);
+  memcpy(data + CHECKSUM_OFFSET, &checksum, sizeof(uint32_t));
+}
+
+bool LogRecord::VerifyChecksum(const char *data) {
+  uint32_t checksum;
+  memcpy(&checksum, data + CHECKSUM_OFFSET, sizeof(uint32_t));
+  return checksum == ComputeChecksum(data);
+}
+
+bool LogRecord::IsWholeRecord(const char *data, size_t size) {
+  if (size < static_cast<size_t>(HEADER_SIZE)) {
+    return false;
+  }
+  int32_t record_size;
+  memcpy(&record_size, data, sizeof(int32_t));
+  return record_size >= HEADER_SIZE && record_size <= LOG_BUFFER_SIZE && static_cast<size_t>(record_size) <= size &&
+         VerifyChecksum(data);
+}
+
+}  // namespace bustub
@@ -12,6 +12,15 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <queue>
+#include <utility>
+
+#include "common/logger.h"
+#include "common/thread_pool.h"
+#include "recovery/log_compression.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,21 +29,816 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record) {
+  if (size < static_cast<size_t>(LogRecord::HEADER_SIZE)) {
+    return false;
+  }
+  int32_t record_size;
+  int32_t log_type;
+  memcpy(&record_size, data, sizeof(int32_t));
+  memcpy(&log_record->lsn_, data + 4, sizeof(lsn_t));
+  memcpy(&log_record->txn_id_, data + 8, sizeof(txn_id_t));
+  memcpy(&log_record->prev_lsn_, data + 12, sizeof(lsn_t));
+  memcpy(&log_type, data + 16, sizeof(int32_t));
+  if (record_size < LogRecord::HEADER_SIZE || static_cast<size_t>(record_size) > size) {
+    return false;
+  }
+  log_record->size_ = record_size;
+  const char *body = data + LogRecord::HEADER_SIZE;
+  size_t body_size = record_size - LogRecord::HEADER_SIZE;
+  if ((log_type & LOG_COMPRESSED_FLAG) != 0) {
+    thread_local std::vector<char> decompressed;
+    int32_t uncompressed_size;
+    if (body_size < sizeof(int32_t)) {
+      return false;
+    }
+    memcpy(&uncompressed_size, body, sizeof(int32_t));
+    decompressed.resize(uncompressed_size);
+    if (LogCompressor::Decompress(body + sizeof(int32_t), body_size - sizeof(int32_t), decompressed.data(),
+                                  uncompressed_size) != static_cast<size_t>(uncompressed_size)) {
+      return false;
+    }
+    body = decompressed.data();
+    body_size = uncompressed_size;
+    log_type &= ~LOG_COMPRESSED_FLAG;
+  }
+  log_record->log_record_type_ = static_cast<LogRecordType>(log_type);
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, body, sizeof(RID));
+      log_record->insert_tuple_.DeserializeFrom(body + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, body, sizeof(RID));
+      log_record->delete_tuple_.DeserializeFrom(body + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, body, sizeof(RID));
+      log_record->old_tuple_.DeserializeFrom(body + sizeof(RID));
+      log_record->new_tuple_.DeserializeFrom(body + sizeof(RID) + sizeof(int32_t) + log_record->old_tuple_.GetLength());
+      break;
+    case LogRecordType::DELTAUPDATE:
+      memcpy(&log_record->update_rid_, body, sizeof(RID));
+      log_record->delta_.assign(body + sizeof(RID), body + body_size);
+      break;
+    case LogRecordType::INCREMENT: {
+      int32_t num_increments;
+      memcpy(&log_record->update_rid_, body, sizeof(RID));
+      memcpy(&num_increments, body + sizeof(RID), sizeof(int32_t));
+      const char *pos = body + sizeof(RID) + sizeof(int32_t);
+      log_record->increments_.resize(num_increments);
+      for (ColumnIncrement &increment : log_record->increments_) {
+        int32_t type_id;
+        memcpy(&increment.offset_, pos, sizeof(uint32_t));
+        memcpy(&type_id, pos + sizeof(uint32_t), sizeof(int32_t));
+        memcpy(&increment.amount_, pos + 2 * sizeof(int32_t), sizeof(int64_t));
+        increment.type_ = static_cast<TypeId>(type_id);
+        pos += LogRecord::INCREMENT_SIZE;
+      }
+      break;
+    }
+    case LogRecordType::APPLYDELETES: {
+      int32_t num_tuples;
+      memcpy(&log_record->page_id_, body, sizeof(page_id_t));
+      memcpy(&num_tuples, body + sizeof(page_id_t), sizeof(int32_t));
+      const char *pos = body + sizeof(page_id_t) + sizeof(int32_t);
+      log_record->delete_tuples_.resize(num_tuples);
+      for (auto &[rid, tuple] : log_record->delete_tuples_) {
+        memcpy(&rid, pos, sizeof(RID));
+        tuple.DeserializeFrom(pos + sizeof(RID));
+        pos += sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+      }
+      break;
+    }
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, body, sizeof(page_id_t));
+      memcpy(&log_record->page_id_, body + sizeof(page_id_t), sizeof(page_id_t));
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::OVERFLOWPAGE:
+      memcpy(&log_record->page_id_, body, sizeof(page_id_t));
+      log_record->page_image_ = body + sizeof(page_id_t);
+      break;
+    case LogRecordType::CLR:
+      memcpy(&log_record->undo_next_lsn_, body, sizeof(lsn_t));
+      log_record->undone_.assign(body + sizeof(lsn_t), body + body_size);
+      break;
+    case LogRecordType::CHECKPOINT: {
+      size_t pos = 0;
+      auto read = [&](auto *value) {
+        memcpy(value, body + pos, sizeof(*value));
+        pos += sizeof(*value);
+      };
+      int32_t num_entries;
+      read(&log_record->redo_offset_);
+      read(&log_record->undo_offset_);
+      read(&num_entries);
+      log_record->txn_table_.resize(num_entries);
+      for (auto &[txn_id, last_lsn] : log_record->txn_table_) {
+        read(&txn_id);
+        read(&last_lsn);
+      }
+      read(&num_entries);
+      log_record->dirty_page_table_.resize(num_entries);
+      for (auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+        read(&page_id);
+        read(&rec_lsn);
+      }
+      break;
+    }
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+void LogRecovery::ScanLog(int offset, const std::function<void(const char *, int)> &visit,
+                          const std::function<void()> &read_done) {
+  size_t log_size;
+  const char *log = disk_manager_->MapLog(offset, &log_size);
+  if (log != nullptr) {
+    // Parsed in place; read_done runs every LOG_BUFFER_SIZE bytes of records, as after a read.
+    size_t pos = 0;
+    size_t read_start = 0;
+    int32_t size;
+    for (; LogRecord::IsWholeRecord(log + pos, log_size - pos); pos += size) {
+      memcpy(&size, log + pos, sizeof(int32_t));
+      visit(log + pos, offset + static_cast<int>(pos));
+      if (pos + size - read_start >= static_cast<size_t>(LOG_BUFFER_SIZE) && read_done) {
+        read_done();
+        read_start = pos + size;
+      }
+    }
+    if (pos > read_start && read_done) {
+      read_done();
+    }
+    disk_manager_->UnmapLog();
+    return;
+  }
+  offset_ = offset;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    int pos = 0;
+    bool end_of_log = false;
+    while (pos + LogRecord::HEADER_SIZE <= LOG_BUFFER_SIZE) {
+      int32_t size;
+      memcpy(&size, log_buffer_ + pos, sizeof(int32_t));
+      if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE) {
+        // The zeroes read past the end of the file, or a torn record.
+        end_of_log = true;
+        break;
+      }
+      if (pos + size > LOG_BUFFER_SIZE) {
+        // The record goes on past the buffer, the next read starts with it.
+        break;
+      }
+      if (!LogRecord::VerifyChecksum(log_buffer_ + pos)) {
+        end_of_log = true;
+        break;
+      }
+      visit(log_buffer_ + pos, offset_ + pos);
+      pos += size;
+    }
+    if (read_done) {
+      read_done();
+    }
+    if (end_of_log) {
+      break;
+    }
+    offset_ += pos;
+  }
+}
+
+/*
+ * analysis phase: read the log from the last checkpoint to the end, and rebuild the active_txn_ table, with the
+ * transactions to undo, and the dirty_page_table_, with the pages to redo, from the tables of the checkpoint record
+ */
+void LogRecovery::Analysis() {
+  active_txn_.clear();
+  ended_txn_.clear();
+  dirty_page_table_.clear();
+  lsn_mapping_.clear();
+  next_lsn_ = 0;
+  next_txn_id_ = 0;
+  const auto checkpoint_offset = static_cast<int>(disk_manager_->ReadMasterRecord());
+  redo_offset_ = checkpoint_offset;
+  ScanLog(checkpoint_offset, [&](const char *data, int offset) {
+    lsn_t lsn;
+    memcpy(&lsn, data + 4, sizeof(lsn_t));
+    lsn_mapping_[lsn] = offset;
+    AnalyzeLogRecord(data);
+  });
+  analyzed_ = true;
+}
+
+void LogRecovery::AnalyzeLogRecord(const char *data) {
+  int32_t size;
+  lsn_t lsn;
+  txn_id_t txn_id;
+  lsn_t prev_lsn;
+  int32_t log_type;
+  memcpy(&size, data, sizeof(int32_t));
+  memcpy(&lsn, data + 4, sizeof(lsn_t));
+  memcpy(&txn_id, data + 8, sizeof(txn_id_t));
+  memcpy(&prev_lsn, data + 12, sizeof(lsn_t));
+  memcpy(&log_type, data + 16, sizeof(int32_t));
+  next_lsn_ = std::max(next_lsn_, lsn + 1);
+  next_txn_id_ = std::max(next_txn_id_, txn_id + 1);
+  const auto type = static_cast<LogRecordType>(log_type & ~LOG_COMPRESSED_FLAG);
+
+  if (type == LogRecordType::CHECKPOINT) {
+    LogRecord log_record;
+    if (!DeserializeLogRecord(data, size, &log_record)) {
+      LOG_DEBUG("malformed checkpoint record %d", lsn);
+      return;
+    }
+    // The records read since the start of the checkpoint are newer than its tables.
+    for (const auto &[checkpoint_txn_id, last_lsn] : log_record.GetTxnTable()) {
+      if (ended_txn_.count(checkpoint_txn_id) == 0) {
+        active_txn_.emplace(checkpoint_txn_id, last_lsn);
+      }
+      next_txn_id_ = std::max(next_txn_id_, checkpoint_txn_id + 1);
+    }
+    for (const auto &[page_id, rec_lsn] : log_record.GetDirtyPageTable()) {
+      auto [iter, inserted] = dirty_page_table_.emplace(page_id, rec_lsn);
+      if (!inserted) {
+        iter->second = std::min(iter->second, rec_lsn);
+      }
+    }
+    redo_offset_ = std::min({redo_offset_, static_cast<int>(log_record.GetRedoOffset()),
+                             static_cast<int>(log_record.GetUndoOffset())});
+    return;
+  }
+
+  if (prev_lsn == INVALID_LSN) {
+    // The first record of a transaction, which may reuse the id of one that ended before a restart.
+    ended_txn_.erase(txn_id);
+  }
+  if (type == LogRecordType::COMMIT || type == LogRecordType::ABORT) {
+    active_txn_.erase(txn_id);
+    ended_txn_.insert(txn_id);
+  } else if (ended_txn_.count(txn_id) == 0) {
+    active_txn_[txn_id] = lsn;
+  }
+
+  size_t body_size;
+  const char *body = GetBody(data, &body_size);
+  page_id_t page_ids[2];
+  if (body != nullptr && GetPageIds(type, body, page_ids)) {
+    for (auto page_id : page_ids) {
+      if (page_id != INVALID_PAGE_ID) {
+        dirty_page_table_.emplace(page_id, lsn);
+      }
+    }
+  }
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
- *read log file from the beginning to end (you must prefetch log records into
- *log buffer to reduce unnecessary I/O operations), remember to compare page's
- *LSN with log_record's sequence number, and also build active_txn_ table &
- *lsn_mapping_ table
+ *read log file from the oldest record a page of dirty_page_table_ may miss to the end (you must prefetch log records
+ *into log buffer to reduce unnecessary I/O operations), remember to compare page's LSN with log_record's sequence
+ *number, and also build lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  if (!analyzed_) {
+    Analysis();
+  }
+  ThreadPool pool(num_redo_workers_);
+  const size_t num_partitions = pool.Size();
+  // The scan fills batches while the workers apply those of the previous read, in applied.
+  std::vector<std::vector<char>> batches(num_partitions);
+  std::vector<std::vector<char>> applied(num_partitions);
+  std::future<void> applying;
+  ScanLog(
+      redo_offset_,
+      [&](const char *data, int offset) {
+        lsn_t lsn;
+        memcpy(&lsn, data + 4, sizeof(lsn_t));
+        lsn_mapping_[lsn] = offset;
+        DispatchLogRecord(data, &batches);
+      },
+      [&] {
+        if (applying.valid()) {
+          applying.get();
+        }
+        std::swap(batches, applied);
+        for (auto &batch : batches) {
+          batch.clear();
+        }
+        applying = std::async(std::launch::async, [&] {
+          pool.RunAll(num_partitions,
+                      [&](size_t partition) { RedoBatch(applied[partition], partition, num_partitions); });
+        });
+      });
+  if (applying.valid()) {
+    applying.get();
+  }
+}
+
+lsn_t LogRecovery::RedoRecords(const char *data, size_t size) {
+  if (redo_pool_ == nullptr) {
+    redo_pool_ = std::make_unique<ThreadPool>(num_redo_workers_);
+  }
+  redo_all_pages_ = true;
+  const size_t num_partitions = redo_pool_->Size();
+  std::vector<std::vector<char>> batches(num_partitions);
+  lsn_t last_lsn = INVALID_LSN;
+  int32_t record_size;
+  for (size_t pos = 0; pos + LogRecord::HEADER_SIZE <= size; pos += record_size) {
+    memcpy(&record_size, data + pos, sizeof(int32_t));
+    if (record_size < LogRecord::HEADER_SIZE || pos + record_size > size || !LogRecord::VerifyChecksum(data + pos)) {
+      break;
+    }
+    memcpy(&last_lsn, data + pos + 4, sizeof(lsn_t));
+    DispatchLogRecord(data + pos, &batches);
+  }
+  redo_pool_->RunAll(num_partitions,
+                     [&](size_t partition) { RedoBatch(batches[partition], partition, num_partitions); });
+  return last_lsn;
+}
+
+void LogRecovery::DispatchLogRecord(const char *data, std::vector<std::vector<char>> *batches) {
+  lsn_t lsn;
+  int32_t log_type;
+  memcpy(&lsn, data + 4, sizeof(lsn_t));
+  memcpy(&log_type, data + 16, sizeof(int32_t));
+  const auto type = static_cast<LogRecordType>(log_type & ~LOG_COMPRESSED_FLAG);
+
+  // A compressed record is handed to the workers decompressed, so that they do not keep its scratch buffer.
+  size_t body_size;
+  const char *body = GetBody(data, &body_size);
+  if (body == nullptr) {
+    LOG_DEBUG("log record %d does not decompress", lsn);
+    return;
+  }
+  page_id_t page_ids[2];
+  if (!GetPageIds(type, body, page_ids)) {
+    return;
+  }
+  const size_t num_partitions = batches->size();
+  size_t dispatched = num_partitions;
+  for (auto page_id : page_ids) {
+    if (page_id == INVALID_PAGE_ID || page_id % num_partitions == dispatched) {
+      continue;
+    }
+    auto iter = dirty_page_table_.find(page_id);
+    if (!redo_all_pages_ && (iter == dirty_page_table_.end() || lsn < iter->second)) {
+      continue;
+    }
+    dispatched = page_id % num_partitions;
+    AppendLogRecord(data, type, body, body_size, &(*batches)[dispatched]);
+  }
+}
+
+void LogRecovery::RedoBatch(const std::vector<char> &batch, size_t partition, size_t num_partitions) {
+  LogRecord log_record;
+  for (size_t pos = 0; pos < batch.size(); pos += log_record.GetSize()) {
+    if (!DeserializeLogRecord(batch.data() + pos, batch.size() - pos, &log_record)) {
+      LOG_DEBUG("malformed log record at %zu of a redo batch", pos);
+      return;
+    }
+    RedoLogRecord(&log_record, partition, num_partitions);
+  }
+}
+
+void LogRecovery::RedoLogRecord(LogRecord *log_record, size_t partition, size_t num_partitions) {
+  const lsn_t lsn = log_record->GetLSN();
+  auto redo_page = [&](page_id_t page_id, auto &&redo) {
+    if (page_id == INVALID_PAGE_ID || page_id % num_partitions != partition) {
+      return;
+    }
+    auto iter = dirty_page_table_.find(page_id);
+    if (!redo_all_pages_ && (iter == dirty_page_table_.end() || lsn < iter->second)) {
+      return;
+    }
+    Page *page;
+    // Every frame may be pinned by the other workers for a moment.
+    while ((page = buffer_pool_manager_->FetchPage(page_id)) == nullptr) {
+      std::this_thread::yield();
+    }
+    auto *table_page = reinterpret_cast<TablePage *>(page);
+    // Read on a replica while its records are applied.
+    table_page->WLatch();
+    // A page never written is older than any record, even the first one, whose LSN 0 it shares.
+    const bool is_older = table_page->GetTablePageId() != page_id || table_page->GetLSN() < lsn;
+    if (is_older) {
+      redo(table_page);
+      table_page->SetLSN(lsn);
+    }
+    table_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, is_older);
+  };
+
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::INSERT:
+      redo_page(log_record->GetInsertRID().GetPageId(), [&](TablePage *page) {
+        RID rid;
+        page->InsertTuple(log_record->GetInsertTuple(), &rid, nullptr, nullptr, nullptr);
+      });
+      break;
+    case LogRecordType::MARKDELETE:
+      redo_page(log_record->GetDeleteRID().GetPageId(),
+                [&](TablePage *page) { page->MarkDelete(log_record->GetDeleteRID(), nullptr, nullptr, nullptr); });
+      break;
+    case LogRecordType::APPLYDELETE:
+      redo_page(log_record->GetDeleteRID().GetPageId(),
+                [&](TablePage *page) { page->ApplyDelete(log_record->GetDeleteRID(), nullptr, nullptr); });
+      break;
+    case LogRecordType::APPLYDELETES:
+      redo_page(log_record->GetDeletePageId(), [&](TablePage *page) {
+        for (const auto &[rid, tuple] : log_record->GetDeleteTuples()) {
+          page->ApplyDelete(rid, nullptr, nullptr);
+        }
+      });
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      redo_page(log_record->GetDeleteRID().GetPageId(),
+                [&](TablePage *page) { page->RollbackDelete(log_record->GetDeleteRID(), nullptr, nullptr); });
+      break;
+    case LogRecordType::UPDATE:
+      redo_page(log_record->GetUpdateRID().GetPageId(), [&](TablePage *page) {
+        Tuple old_tuple;
+        page->UpdateTuple(log_record->GetUpdateTuple(), &old_tuple, log_record->GetUpdateRID(), nullptr, nullptr,
+                          nullptr);
+      });
+      break;
+    case LogRecordType::DELTAUPDATE:
+      redo_page(log_record->GetUpdateRID().GetPageId(), [&](TablePage *page) {
+        Tuple old_tuple;
+        Tuple new_tuple;
+        if (page->GetTuple(log_record->GetUpdateRID(), &old_tuple, nullptr, nullptr) &&
+            log_record->ApplyDelta(old_tuple, &new_tuple, false)) {
+          page->UpdateTuple(new_tuple, &old_tuple, log_record->GetUpdateRID(), nullptr, nullptr, nullptr);
+        }
+      });
+      break;
+    case LogRecordType::INCREMENT:
+      redo_page(log_record->GetUpdateRID().GetPageId(), [&](TablePage *page) {
+        Tuple old_tuple;
+        Tuple new_tuple;
+        page->IncrementTuple(log_record->GetIncrements(), false, log_record->GetUpdateRID(), &old_tuple, &new_tuple,
+                             nullptr, nullptr, nullptr);
+      });
+      break;
+    case LogRecordType::NEWPAGE:
+      redo_page(log_record->GetNewPageId(), [&](TablePage *page) {
+        page->Init(log_record->GetNewPageId(), PAGE_SIZE, log_record->GetNewPageRecord(), nullptr, nullptr);
+      });
+      // The heap links the previous page to the new one.
+      redo_page(log_record->GetNewPageRecord(),
+                [&](TablePage *page) { page->SetNextPageId(log_record->GetNewPageId()); });
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::OVERFLOWPAGE:
+      redo_page(log_record->GetPageImageId(),
+                [&](TablePage *page) { memcpy(page->GetData(), log_record->GetPageImage(), PAGE_SIZE); });
+      break;
+    case LogRecordType::CLR: {
+      // The undo the CLR logged, done again.
+      const std::vector<char> &serialized = log_record->GetUndoneRecord();
+      LogRecord undone;
+      page_id_t page_ids[2];
+      if (DeserializeLogRecord(serialized.data(), serialized.size(), &undone) &&
+          GetPageIds(undone.GetLogRecordType(), serialized.data() + LogRecord::HEADER_SIZE, page_ids)) {
+        redo_page(page_ids[0], [&](TablePage *page) { UndoChange(&undone, page); });
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
- *iterate through active txn map and undo each operation
+ *undo the records of the active txns, the latest first, following their prevLSNs, and log a CLR for each
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  if (!analyzed_) {
+    Analysis();
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+  UndoActiveTransactions();
+}
+
+void LogRecovery::UndoInBackground(TransactionManager *txn_manager, LockManager *lock_manager) {
+  if (!analyzed_) {
+    Analysis();
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+  txn_manager->SetNextTransactionId(next_txn_id_);
+  txn_manager_ = txn_manager;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    auto txn = std::make_unique<Transaction>(txn_id);
+    std::vector<RID> rids;
+    const int64_t begin_log_offset = GetWrittenTuples(lsn, &rids);
+    txn_manager->Begin(txn.get());
+    // Its next records, the CLRs and the ABORT, follow those of the log, which a checkpoint must not truncate.
+    txn->SetPrevLSN(lsn);
+    txn->SetBeginLogOffset(begin_log_offset);
+    for (const RID &rid : rids) {
+      lock_manager->LockExclusive(txn.get(), rid);
+    }
+    loser_txns_.emplace(txn_id, std::move(txn));
+  }
+  undo_thread_ = std::thread([this] { UndoActiveTransactions(); });
+}
+
+void LogRecovery::UndoActiveTransactions() {
+  // The next record to undo of every transaction, the latest first.
+  std::priority_queue<std::pair<lsn_t, txn_id_t>> to_undo;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    to_undo.emplace(lsn, txn_id);
+  }
+  std::vector<char> serialized;
+  LogRecord log_record;
+  while (!to_undo.empty()) {
+    const auto [lsn, txn_id] = to_undo.top();
+    to_undo.pop();
+    lsn_t undo_next_lsn = INVALID_LSN;
+    if (!ReadLogRecord(lsn, &serialized) ||
+        !DeserializeLogRecord(serialized.data(), serialized.size(), &log_record)) {
+      LOG_DEBUG("log record %d of transaction %d is not in the log", lsn, txn_id);
+    } else if (log_record.GetLogRecordType() == LogRecordType::CLR) {
+      // A recovery before this one undid the records up to there.
+      undo_next_lsn = log_record.GetUndoNextLSN();
+    } else {
+      UndoLogRecord(&log_record, serialized);
+      undo_next_lsn = log_record.GetPrevLSN();
+    }
+    if (undo_next_lsn != INVALID_LSN) {
+      to_undo.emplace(undo_next_lsn, txn_id);
+      continue;
+    }
+    auto loser = loser_txns_.find(txn_id);
+    if (loser != loser_txns_.end()) {
+      // Logs the ABORT record, then releases the locks of the transaction.
+      txn_manager_->Abort(loser->second.get());
+    } else if (log_manager_ != nullptr) {
+      LogRecord abort_record(txn_id, active_txn_[txn_id], LogRecordType::ABORT);
+      log_manager_->AppendLogRecord(&abort_record);
+    }
+    active_txn_.erase(txn_id);
+  }
+  if (log_manager_ != nullptr && log_manager_->GetNextLSN() > next_lsn_) {
+    log_manager_->WaitUntilPersistent(log_manager_->GetNextLSN() - 1);
+  }
+}
+
+void LogRecovery::UndoLogRecord(LogRecord *log_record, const std::vector<char> &serialized) {
+  page_id_t page_ids[2];
+  if (log_record->GetLogRecordType() == LogRecordType::NEWPAGE ||
+      log_record->GetLogRecordType() == LogRecordType::OVERFLOWPAGE ||
+      !GetPageIds(log_record->GetLogRecordType(), serialized.data() + LogRecord::HEADER_SIZE, page_ids)) {
+    // Nothing to undo: a new page stays in its table heap, empty, and an overflow page is only reached from the tuple
+    // the undo of its insert removes.
+    return;
+  }
+  const txn_id_t txn_id = log_record->GetTxnId();
+  lsn_t lsn = INVALID_LSN;
+  if (log_manager_ != nullptr) {
+    LogRecord clr(txn_id, active_txn_[txn_id], LogRecordType::CLR, log_record->GetPrevLSN(), serialized.data(),
+                  static_cast<int32_t>(serialized.size()));
+    lsn = log_manager_->AppendLogRecord(&clr);
+    active_txn_[txn_id] = lsn;
+    auto loser = loser_txns_.find(txn_id);
+    if (loser != loser_txns_.end()) {
+      loser->second->SetPrevLSN(lsn);
+    }
+  }
+  Page *page = buffer_pool_manager_->FetchPage(page_ids[0]);
+  if (page == nullptr) {
+    LOG_DEBUG("no frame to undo log record %d in", log_record->GetLSN());
+    return;
+  }
+  auto *table_page = reinterpret_cast<TablePage *>(page);
+  // The transactions running while the undo does, after UndoInBackground, may be on the page.
+  table_page->WLatch();
+  UndoChange(log_record, table_page);
+  if (lsn != INVALID_LSN) {
+    table_page->SetLSN(lsn);
+  }
+  table_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_ids[0], true);
+}
+
+void LogRecovery::UndoChange(LogRecord *log_record, TablePage *page) {
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record->GetInsertRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record->GetDeleteRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->RestoreTuple(log_record->GetDeleteTuple(), log_record->GetDeleteRID());
+      break;
+    case LogRecordType::APPLYDELETES: {
+      const std::vector<std::pair<RID, Tuple>> &delete_tuples = log_record->GetDeleteTuples();
+      for (auto iter = delete_tuples.rbegin(); iter != delete_tuples.rend(); ++iter) {
+        page->RestoreTuple(iter->second, iter->first);
+      }
+      break;
+    }
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record->GetDeleteRID(), nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->GetOriginalTuple(), &new_tuple, log_record->GetUpdateRID(), nullptr, nullptr,
+                        nullptr);
+      break;
+    }
+    case LogRecordType::DELTAUPDATE: {
+      Tuple new_tuple;
+      Tuple old_tuple;
+      if (page->GetTuple(log_record->GetUpdateRID(), &new_tuple, nullptr, nullptr) &&
+          log_record->ApplyDelta(new_tuple, &old_tuple, true)) {
+        page->UpdateTuple(old_tuple, &new_tuple, log_record->GetUpdateRID(), nullptr, nullptr, nullptr);
+      }
+      break;
+    }
+    case LogRecordType::INCREMENT: {
+      // Taken out of the tuple as it is, with the increments of the other transactions that were added since.
+      Tuple old_tuple;
+      Tuple new_tuple;
+      page->IncrementTuple(log_record->GetIncrements(), true, log_record->GetUpdateRID(), &old_tuple, &new_tuple,
+                           nullptr, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::PAGEIMAGE: {
+      // The tuples the bulk insert appended, those of the image.
+      auto image = std::make_unique<Page>();
+      memcpy(image->GetData(), log_record->GetPageImage(), PAGE_SIZE);
+      auto *image_page = reinterpret_cast<TablePage *>(image.get());
+      RID rid;
+      Tuple tuple;
+      for (bool found = image_page->GetFirstTupleRid(&rid); found; found = image_page->GetNextTupleRid(rid, &rid)) {
+        if (page->GetTuple(rid, &tuple, nullptr, nullptr)) {
+          page->ApplyDelete(rid, nullptr, nullptr);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+int64_t LogRecovery::GetWrittenTuples(lsn_t lsn, std::vector<RID> *rids) {
+  int64_t begin_log_offset = INT64_MAX;
+  std::vector<char> serialized;
+  LogRecord log_record;
+  while (lsn != INVALID_LSN) {
+    auto iter = lsn_mapping_.find(lsn);
+    if (iter == lsn_mapping_.end() || !ReadLogRecord(lsn, &serialized) ||
+        !DeserializeLogRecord(serialized.data(), serialized.size(), &log_record)) {
+      break;
+    }
+    begin_log_offset = std::min<int64_t>(begin_log_offset, iter->second);
+    switch (log_record.GetLogRecordType()) {
+      case LogRecordType::CLR:
+        // The records up to there are undone already.
+        lsn = log_record.GetUndoNextLSN();
+        continue;
+      case LogRecordType::INSERT:
+        rids->push_back(log_record.GetInsertRID());
+        break;
+      case LogRecordType::MARKDELETE:
+      case LogRecordType::APPLYDELETE:
+      case LogRecordType::ROLLBACKDELETE:
+        rids->push_back(log_record.GetDeleteRID());
+        break;
+      case LogRecordType::APPLYDELETES:
+        for (const auto &[rid, tuple] : log_record.GetDeleteTuples()) {
+          rids->push_back(rid);
+        }
+        break;
+      case LogRecordType::UPDATE:
+      case LogRecordType::DELTAUPDATE:
+      case LogRecordType::INCREMENT:
+        rids->push_back(log_record.GetUpdateRID());
+        break;
+      case LogRecordType::PAGEIMAGE: {
+        auto image = std::make_unique<Page>();
+        memcpy(image->GetData(), log_record.GetPageImage(), PAGE_SIZE);
+        auto *image_page = reinterpret_cast<TablePage *>(image.get());
+        RID rid;
+        for (bool found = image_page->GetFirstTupleRid(&rid); found; found = image_page->GetNextTupleRid(rid, &rid)) {
+          rids->push_back(rid);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    lsn = log_record.GetPrevLSN();
+  }
+  return begin_log_offset;
+}
+
+bool LogRecovery::ReadLogRecord(lsn_t lsn, std::vector<char> *serialized) {
+  auto iter = lsn_mapping_.find(lsn);
+  if (iter == lsn_mapping_.end()) {
+    return false;
+  }
+  int32_t size;
+  if (!disk_manager_->ReadLog(reinterpret_cast<char *>(&size), sizeof(int32_t), iter->second) ||
+      size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  std::vector<char> data(size);
+  if (!disk_manager_->ReadLog(data.data(), size, iter->second)) {
+    return false;
+  }
+  int32_t log_type;
+  memcpy(&log_type, data.data() + 16, sizeof(int32_t));
+  size_t body_size;
+  const char *body = GetBody(data.data(), &body_size);
+  if (body == nullptr) {
+    return false;
+  }
+  serialized->clear();
+  AppendLogRecord(data.data(), static_cast<LogRecordType>(log_type & ~LOG_COMPRESSED_FLAG), body, body_size,
+                  serialized);
+  return true;
+}
+
+const char *LogRecovery::GetBody(const char *data, size_t *body_size) {
+  int32_t size;
+  int32_t log_type;
+  memcpy(&size, data, sizeof(int32_t));
+  memcpy(&log_type, data + 16, sizeof(int32_t));
+  const char *body = data + LogRecord::HEADER_SIZE;
+  *body_size = size - LogRecord::HEADER_SIZE;
+  if ((log_type & LOG_COMPRESSED_FLAG) == 0) {
+    return body;
+  }
+  int32_t uncompressed_size;
+  memcpy(&uncompressed_size, body, sizeof(int32_t));
+  decompressed_.resize(uncompressed_size);
+  if (LogCompressor::Decompress(body + sizeof(int32_t), *body_size - sizeof(int32_t), decompressed_.data(),
+                                uncompressed_size) != static_cast<size_t>(uncompressed_size)) {
+    return nullptr;
+  }
+  *body_size = uncompressed_size;
+  return decompressed_.data();
+}
+
+void LogRecovery::AppendLogRecord(const char *header, LogRecordType type, const char *body, size_t body_size,
+                                  std::vector<char> *out) {
+  const size_t pos = out->size();
+  out->resize(pos + LogRecord::HEADER_SIZE + body_size);
+  memcpy(out->data() + pos, header, LogRecord::HEADER_SIZE);
+  const auto size = static_cast<int32_t>(LogRecord::HEADER_SIZE + body_size);
+  const auto log_type = static_cast<int32_t>(type);
+  memcpy(out->data() + pos, &size, sizeof(int32_t));
+  memcpy(out->data() + pos + 16, &log_type, sizeof(int32_t));
+  memcpy(out->data() + pos + LogRecord::HEADER_SIZE, body, body_size);
+  LogRecord::SetChecksum(out->data() + pos);
+}
+
+bool LogRecovery::GetPageIds(LogRecordType type, const char *body, page_id_t page_ids[2]) {
+  page_ids[0] = INVALID_PAGE_ID;
+  page_ids[1] = INVALID_PAGE_ID;
+  switch (type) {
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATE:
+    case LogRecordType::DELTAUPDATE:
+    case LogRecordType::INCREMENT:
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::OVERFLOWPAGE:
+    case LogRecordType::APPLYDELETES:
+      // The RID, or the page id, comes first.
+      memcpy(&page_ids[0], body, sizeof(page_id_t));
+      return true;
+    case LogRecordType::NEWPAGE:
+      memcpy(&page_ids[0], body + sizeof(page_id_t), sizeof(page_id_t));
+      memcpy(&page_ids[1], body, sizeof(page_id_t));
+      return true;
+    case LogRecordType::CLR: {
+      // The page of the record undone, serialized uncompressed after undo_next_lsn.
+      const char *undone = body + sizeof(lsn_t);
+      int32_t undone_type;
+      memcpy(&undone_type, undone + 16, sizeof(int32_t));
+      return GetPageIds(static_cast<LogRecordType>(undone_type), undone + LogRecord::HEADER_SIZE, page_ids);
+    }
+    default:
+      return false;
+  }
+}
 
 }  // namespace bustub
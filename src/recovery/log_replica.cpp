@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_replica.cpp
+//
+// Identification: src/recovery/log_replica.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_replica.h"
+
+#include <cstring>
+
+namespace bustub {
+
+LogReplica::LogReplica(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, size_t num_redo_workers)
+    : log_recovery_(disk_manager, buffer_pool_manager, nullptr, num_redo_workers) {
+  apply_thread_ = std::thread([this] { RunApply(); });
+}
+
+LogReplica::~LogReplica() {
+  {
+    std::scoped_lock latch(latch_);
+    running_ = false;
+  }
+  received_cv_.notify_one();
+  apply_thread_.join();
+}
+
+void LogReplica::Receive(const char *data, size_t size) {
+  {
+    std::scoped_lock latch(latch_);
+    received_.insert(received_.end(), data, data + size);
+  }
+  received_cv_.notify_one();
+}
+
+void LogReplica::WaitUntilApplied(lsn_t lsn) {
+  std::unique_lock latch(latch_);
+  applied_cv_.wait(latch, [&] { return applied_lsn_ != INVALID_LSN && applied_lsn_ >= lsn; });
+}
+
+void LogReplica::RunApply() {
+  std::vector<char> applying;
+  std::unique_lock latch(latch_);
+  while (true) {
+    received_cv_.wait(latch, [&] { return !running_ || !received_.empty(); });
+    if (received_.empty()) {
+      return;
+    }
+    // The whole records received so far; a record received in part waits for the rest.
+    size_t size = 0;
+    int32_t record_size;
+    while (size + sizeof(int32_t) <= received_.size()) {
+      memcpy(&record_size, received_.data() + size, sizeof(int32_t));
+      if (record_size <= 0 || size + record_size > received_.size()) {
+        break;
+      }
+      size += record_size;
+    }
+    if (size == 0) {
+      if (!running_) {
+        return;
+      }
+      received_cv_.wait(latch);
+      continue;
+    }
+    applying.assign(received_.begin(), received_.begin() + size);
+    received_.erase(received_.begin(), received_.begin() + size);
+    latch.unlock();
+
+    apply_latch_.WLock();
+    const lsn_t last_lsn = log_recovery_.RedoRecords(applying.data(), applying.size());
+    latch.lock();
+    if (last_lsn != INVALID_LSN) {
+      applied_lsn_ = last_lsn;
+    }
+    latch.unlock();
+    apply_latch_.WUnlock();
+    applied_cv_.notify_all();
+    latch.lock();
+  }
+}
+
+}  // namespace bustub
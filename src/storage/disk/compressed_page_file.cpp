@@ -0,0 +1,270 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_file.cpp
+//
+// Identification: src/storage/disk/compressed_page_file.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_page_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "recovery/log_compression.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return true once all of size bytes are written at offset */
+bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(fd, data + written, size - written, offset + static_cast<off_t>(written));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+/** @return true once all of size bytes are read from offset */
+bool ReadFully(int fd, char *data, size_t size, off_t offset) {
+  size_t read_bytes = 0;
+  while (read_bytes < size) {
+    ssize_t n = pread(fd, data + read_bytes, size - read_bytes, offset + static_cast<off_t>(read_bytes));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    read_bytes += n;
+  }
+  return true;
+}
+
+}  // namespace
+
+CompressedPageFile::CompressedPageFile(const std::string &data_file, const std::string &map_file, bool is_new)
+    : free_slots_(UnitsOf(PAGE_SIZE)) {
+  const int flags = O_RDWR | O_CREAT | (is_new ? O_TRUNC : 0);
+  data_fd_ = open(data_file.c_str(), flags, 0644);
+  map_fd_ = open(map_file.c_str(), flags, 0644);
+  struct stat stat_buf;
+  if (data_fd_ < 0 || map_fd_ < 0 || fstat(map_fd_, &stat_buf) != 0) {
+    throw Exception("can't open compressed page files " + data_file + " and " + map_file);
+  }
+  map_.resize(stat_buf.st_size / sizeof(MapEntry));
+  if (!map_.empty() &&
+      !ReadFully(map_fd_, reinterpret_cast<char *>(map_.data()), map_.size() * sizeof(MapEntry), 0)) {
+    throw Exception("can't read page map " + map_file);
+  }
+  // The gaps between the slots of the map are free, split into slots of a page at most.
+  std::vector<std::pair<uint32_t, uint32_t>> slots;
+  for (const MapEntry &entry : map_) {
+    if (entry.size_ != 0) {
+      slots.emplace_back(entry.unit_, UnitsOf(entry.size_));
+    }
+  }
+  std::sort(slots.begin(), slots.end());
+  for (const auto &[unit, num_units] : slots) {
+    for (uint32_t gap = end_unit_; gap < unit;) {
+      const uint32_t gap_units = std::min<uint32_t>(unit - gap, free_slots_.size());
+      free_slots_[gap_units - 1].push_back(gap);
+      gap += gap_units;
+    }
+    end_unit_ = std::max(end_unit_, unit + num_units);
+    stored_units_ += num_units;
+  }
+}
+
+CompressedPageFile::~CompressedPageFile() {
+  {
+    std::scoped_lock lock(latch_);
+    SyncLocked();
+  }
+  close(data_fd_);
+  close(map_fd_);
+}
+
+void CompressedPageFile::Write(page_id_t page_id, const char *page_data) {
+  // A page that does not save a unit compressed is stored as is.
+  char compressed[PAGE_SIZE];
+  const size_t max_size = PAGE_SIZE - COMPRESSED_SLOT_UNIT;
+  auto size = static_cast<uint32_t>(LogCompressor::Compress(page_data, PAGE_SIZE, compressed, max_size));
+  const char *data = compressed;
+  if (size == 0) {
+    size = PAGE_SIZE;
+    data = page_data;
+  }
+  const uint32_t num_units = UnitsOf(size);
+
+  std::unique_lock lock(latch_);
+  const uint32_t unit = AllocateSlot(num_units);
+  lock.unlock();
+  const bool written = WriteFully(data_fd_, data, size, static_cast<off_t>(unit) * COMPRESSED_SLOT_UNIT);
+  lock.lock();
+  if (!written) {
+    LOG_DEBUG("I/O error while writing a compressed page");
+    free_slots_[num_units - 1].push_back(unit);
+    return;
+  }
+  const MapEntry new_entry{unit, size};
+  MapEntry old_entry{0, 0};
+  {
+    std::unique_lock slots_lock(slots_latch_);
+    if (map_.size() <= static_cast<size_t>(page_id)) {
+      map_.resize(page_id + 1, MapEntry{0, 0});
+    }
+    old_entry = map_[page_id];
+    map_[page_id] = new_entry;
+    CachePut(page_id, data, size);
+  }
+  if (!WriteFully(map_fd_, reinterpret_cast<const char *>(&new_entry), sizeof(MapEntry),
+                  static_cast<off_t>(page_id * sizeof(MapEntry)))) {
+    LOG_DEBUG("I/O error while writing the page map");
+  }
+  stored_units_ += num_units;
+  if (old_entry.size_ != 0) {
+    pending_slots_.emplace_back(old_entry.unit_, UnitsOf(old_entry.size_));
+    stored_units_ -= UnitsOf(old_entry.size_);
+    if (pending_slots_.size() >= COMPRESSED_FREE_BATCH) {
+      SyncLocked();
+    }
+  }
+}
+
+bool CompressedPageFile::Read(page_id_t page_id, char *page_data) {
+  std::shared_lock slots_lock(slots_latch_);
+  MapEntry entry{0, 0};
+  if (page_id >= 0 && static_cast<size_t>(page_id) < map_.size()) {
+    entry = map_[page_id];
+  }
+  if (entry.size_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return false;
+  }
+  {
+    std::scoped_lock cache_lock(cache_latch_);
+    if (auto it = cache_.find(page_id); it != cache_.end()) {
+      cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second.lru_);
+      num_cache_hits_++;
+      const std::string &data = it->second.data_;
+      return LogCompressor::Decompress(data.data(), data.size(), page_data, PAGE_SIZE) == PAGE_SIZE;
+    }
+  }
+  const auto offset = static_cast<off_t>(entry.unit_) * COMPRESSED_SLOT_UNIT;
+  if (entry.size_ == PAGE_SIZE) {
+    return ReadFully(data_fd_, page_data, PAGE_SIZE, offset);
+  }
+  char compressed[PAGE_SIZE];
+  if (!ReadFully(data_fd_, compressed, entry.size_, offset) ||
+      LogCompressor::Decompress(compressed, entry.size_, page_data, PAGE_SIZE) != PAGE_SIZE) {
+    LOG_DEBUG("page %d could not be read compressed", page_id);
+    return false;
+  }
+  CachePut(page_id, compressed, entry.size_);
+  return true;
+}
+
+void CompressedPageFile::Sync() {
+  std::scoped_lock lock(latch_);
+  SyncLocked();
+}
+
+void CompressedPageFile::SyncLocked() {
+  fdatasync(data_fd_);
+  fdatasync(map_fd_);
+  if (pending_slots_.empty()) {
+    return;
+  }
+  // No read of an old slot is left running once they are handed out again.
+  std::unique_lock slots_lock(slots_latch_);
+  for (const auto &[unit, num_units] : pending_slots_) {
+    free_slots_[num_units - 1].push_back(unit);
+  }
+  pending_slots_.clear();
+}
+
+uint32_t CompressedPageFile::AllocateSlot(uint32_t num_units) {
+  // A slot of the size, else the end of a larger one, whose rest is freed.
+  for (uint32_t units = num_units; units <= free_slots_.size(); units++) {
+    std::vector<uint32_t> &slots = free_slots_[units - 1];
+    if (!slots.empty()) {
+      const uint32_t unit = slots.back();
+      slots.pop_back();
+      if (units > num_units) {
+        free_slots_[units - num_units - 1].push_back(unit + num_units);
+      }
+      return unit;
+    }
+  }
+  const uint32_t unit = end_unit_;
+  end_unit_ += num_units;
+  return unit;
+}
+
+void CompressedPageFile::CachePut(page_id_t page_id, const char *data, uint32_t size) {
+  std::scoped_lock cache_lock(cache_latch_);
+  if (auto it = cache_.find(page_id); it != cache_.end()) {
+    cached_bytes_ -= it->second.data_.size();
+    cache_lru_.erase(it->second.lru_);
+    cache_.erase(it);
+  }
+  if (size == PAGE_SIZE || size > cache_bytes_) {
+    return;
+  }
+  cache_lru_.push_front(page_id);
+  cache_.emplace(page_id, CachedPage{std::string(data, size), cache_lru_.begin()});
+  cached_bytes_ += size;
+  TrimCache();
+}
+
+void CompressedPageFile::TrimCache() {
+  while (cached_bytes_ > cache_bytes_) {
+    auto it = cache_.find(cache_lru_.back());
+    cached_bytes_ -= it->second.data_.size();
+    cache_.erase(it);
+    cache_lru_.pop_back();
+  }
+}
+
+void CompressedPageFile::SetCacheSize(size_t cache_bytes) {
+  std::scoped_lock cache_lock(cache_latch_);
+  cache_bytes_ = cache_bytes;
+  TrimCache();
+}
+
+size_t CompressedPageFile::GetNumCacheHits() {
+  std::scoped_lock cache_lock(cache_latch_);
+  return num_cache_hits_;
+}
+
+page_id_t CompressedPageFile::GetNumPages() {
+  std::scoped_lock lock(latch_);
+  return static_cast<page_id_t>(map_.size());
+}
+
+size_t CompressedPageFile::GetStoredBytes() {
+  std::scoped_lock lock(latch_);
+  return stored_units_ * COMPRESSED_SLOT_UNIT;
+}
+
+}  // namespace bustub
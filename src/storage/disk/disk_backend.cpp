@@ -0,0 +1,272 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_backend.cpp
+//
+// Identification: src/storage/disk/disk_backend.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_backend.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/logger.h"
+#include "common/macros.h"
+#include "storage/disk/io_uring_disk_backend.h"
+
+namespace bustub {
+
+std::unique_ptr<DiskBackend> DiskBackend::Create(DiskBackendType type, const std::string &file_name, bool direct_io,
+                                                 bool sync_writes) {
+  int flags = O_RDWR;
+  if (sync_writes) {
+    flags |= O_DSYNC;
+  }
+#ifdef O_DIRECT
+  if (direct_io) {
+    flags |= O_DIRECT;
+  }
+#else
+  direct_io = false;
+#endif
+  int fd = open(file_name.c_str(), flags);
+  if (fd < 0) {
+    LOG_DEBUG("can't open %s: %s", file_name.c_str(), strerror(errno));
+    return nullptr;
+  }
+#ifdef BUSTUB_HAVE_IO_URING
+  if (type == DiskBackendType::IO_URING) {
+    auto backend = IoUringDiskBackend::Create(fd, direct_io);
+    if (backend != nullptr) {
+      return backend;
+    }
+    LOG_DEBUG("io_uring is unavailable, falling back to pread/pwrite");
+    fd = open(file_name.c_str(), flags);
+    if (fd < 0) {
+      return nullptr;
+    }
+  }
+#endif
+  return std::make_unique<PosixDiskBackend>(fd, direct_io);
+}
+
+char *DiskBackend::BounceBuffer(const DiskRequest &request, bool direct_io) {
+  if (!direct_io || reinterpret_cast<uintptr_t>(request.data_) % PAGE_SIZE == 0) {
+    return nullptr;
+  }
+  BUSTUB_ASSERT(request.offset_ % PAGE_SIZE == 0 && request.size_ % PAGE_SIZE == 0,
+                "direct I/O must be page aligned");
+  auto *bounce_buffer = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, request.size_));
+  if (request.type_ == DiskRequest::Type::WRITE) {
+    memcpy(bounce_buffer, request.data_, request.size_);
+  }
+  return bounce_buffer;
+}
+
+void DiskBackend::Complete(DiskRequest *request, char *bounce_buffer, int64_t result) {
+  char *buffer = bounce_buffer != nullptr ? bounce_buffer : request->data_;
+  bool success = result >= 0;
+  if (request->type_ == DiskRequest::Type::READ && success) {
+    // The file may end before the page does.
+    if (result < static_cast<int64_t>(request->size_)) {
+      memset(buffer + result, 0, request->size_ - result);
+    }
+    if (bounce_buffer != nullptr) {
+      memcpy(request->data_, bounce_buffer, request->size_);
+    }
+  } else if (request->type_ == DiskRequest::Type::WRITE) {
+    success = result == static_cast<int64_t>(request->size_);
+  }
+  if (!success) {
+    LOG_DEBUG("I/O error at offset %ld: %s", static_cast<long>(request->offset_),  // NOLINT
+              result < 0 ? strerror(static_cast<int>(-result)) : "short write");
+  }
+  free(bounce_buffer);
+  if (request->callback_) {
+    request->callback_(success);
+  }
+}
+
+PosixDiskBackend::PosixDiskBackend(int fd, bool direct_io) : fd_(fd), direct_io_(direct_io) {}
+
+PosixDiskBackend::~PosixDiskBackend() { close(fd_); }
+
+void PosixDiskBackend::Submit(std::vector<DiskRequest> *requests) {
+  for (auto &request : *requests) {
+    char *bounce_buffer = BounceBuffer(request, direct_io_);
+    char *buffer = bounce_buffer != nullptr ? bounce_buffer : request.data_;
+    int64_t result = 0;
+    // pread and pwrite may transfer less than asked for; keep going until the request is done or the file ends.
+    while (result < static_cast<int64_t>(request.size_)) {
+      ssize_t n = request.type_ == DiskRequest::Type::READ
+                      ? pread(fd_, buffer + result, request.size_ - result, request.offset_ + result)
+                      : pwrite(fd_, buffer + result, request.size_ - result, request.offset_ + result);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        result = -errno;
+        break;
+      }
+      if (n == 0) {
+        break;
+      }
+      result += n;
+    }
+    Complete(&request, bounce_buffer, result);
+  }
+  requests->clear();
+}
+
+void SegmentedDiskBackend::Submit(std::vector<DiskRequest> *requests) {
+  int64_t first_segment = INT64_MAX;
+  for (auto &request : *requests) {
+    // The callback of the request runs once its last part completes, with false if any part failed.
+    struct Parts {
+      size_t num_left_;
+      bool ok_;
+      std::function<void(bool)> callback_;
+    };
+    const int64_t end = request.offset_ + request.size_;
+    const int64_t num_parts = (end - 1) / segment_size_ - request.offset_ / segment_size_ + 1;
+    auto parts = std::make_shared<Parts>(Parts{static_cast<size_t>(num_parts), true, std::move(request.callback_)});
+    for (int64_t offset = request.offset_; offset < end;) {
+      const int64_t number = offset / segment_size_;
+      const int64_t part_end = std::min(end, (number + 1) * segment_size_);
+      first_segment = std::min(first_segment, number);
+      Segment *segment = &segments_[number];
+      auto on_done = [this, segment, parts](bool ok) {
+        segment->num_in_flight_--;
+        num_completed_++;
+        parts->ok_ = parts->ok_ && ok;
+        if (--parts->num_left_ == 0) {
+          parts->callback_(parts->ok_);
+        }
+      };
+      if (segment->backend_ == nullptr) {
+        segment->backend_ = DiskBackend::Create(type_, segment_name_(number), false, sync_writes_);
+      }
+      segment->num_in_flight_++;
+      if (segment->backend_ == nullptr) {
+        LOG_DEBUG("can't open segment %ld", number);
+        on_done(false);
+      } else {
+        std::vector<DiskRequest> part;
+        part.push_back({request.type_, offset - number * segment_size_, static_cast<uint32_t>(part_end - offset),
+                        request.data_ + (offset - request.offset_), on_done});
+        segment->backend_->Submit(&part);
+      }
+      offset = part_end;
+    }
+  }
+  requests->clear();
+  for (auto iter = segments_.begin(); iter != segments_.end() && iter->first < first_segment;) {
+    iter = iter->second.num_in_flight_ == 0 ? segments_.erase(iter) : std::next(iter);
+  }
+}
+
+void SegmentedDiskBackend::Wait() {
+  for (auto &[number, segment] : segments_) {
+    if (segment.backend_ != nullptr) {
+      segment.backend_->Wait();
+    }
+  }
+}
+
+void SegmentedDiskBackend::WaitAny() {
+  const size_t num_completed = num_completed_;
+  Poll();
+  if (num_completed_ != num_completed) {
+    return;
+  }
+  // The oldest writes complete first, or nearly so.
+  for (auto &[number, segment] : segments_) {
+    if (segment.num_in_flight_ > 0) {
+      segment.backend_->WaitAny();
+      return;
+    }
+  }
+}
+
+void SegmentedDiskBackend::Poll() {
+  for (auto &[number, segment] : segments_) {
+    if (segment.backend_ != nullptr) {
+      segment.backend_->Poll();
+    }
+  }
+}
+
+void StripedDiskBackend::Submit(std::vector<DiskRequest> *requests) {
+  // Grouped by file, so that each backend gets the whole of its share at once.
+  std::map<size_t, std::vector<DiskRequest>> by_file;
+  for (auto &request : *requests) {
+    size_t number;
+    const int64_t offset = locate_(request.offset_, &number);
+    File *file = &files_[number];
+    file->num_in_flight_++;
+    auto on_done = [this, file, callback = std::move(request.callback_)](bool ok) {
+      file->num_in_flight_--;
+      num_completed_++;
+      if (callback) {
+        callback(ok);
+      }
+    };
+    by_file[number].push_back({request.type_, offset, request.size_, request.data_, std::move(on_done)});
+  }
+  requests->clear();
+  for (auto &[number, file_requests] : by_file) {
+    File *file = &files_[number];
+    if (file->backend_ == nullptr) {
+      file->backend_ = DiskBackend::Create(type_, file_name_(number), direct_io_);
+    }
+    if (file->backend_ == nullptr) {
+      LOG_DEBUG("can't open data file %zu", number);
+      for (auto &request : file_requests) {
+        request.callback_(false);
+      }
+      continue;
+    }
+    file->backend_->Submit(&file_requests);
+  }
+}
+
+void StripedDiskBackend::Wait() {
+  for (auto &[number, file] : files_) {
+    if (file.backend_ != nullptr) {
+      file.backend_->Wait();
+    }
+  }
+}
+
+void StripedDiskBackend::WaitAny() {
+  const size_t num_completed = num_completed_;
+  Poll();
+  if (num_completed_ != num_completed) {
+    return;
+  }
+  for (auto &[number, file] : files_) {
+    if (file.num_in_flight_ > 0) {
+      file.backend_->WaitAny();
+      return;
+    }
+  }
+}
+
+void StripedDiskBackend::Poll() {
+  for (auto &[number, file] : files_) {
+    if (file.backend_ != nullptr) {
+      file.backend_->Poll();
+    }
+  }
+}
+
+}  // namespace bustub
@@ -10,27 +10,58 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c_util.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+thread_local tablespace_id_t DiskManager::current_tablespace_ = DEFAULT_TABLESPACE;
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, DiskBackendType backend_type, bool direct_io,
+                         bool enable_checksums, int64_t log_segment_size, bool enable_double_write,
+                         bool enable_compression)
+    : log_segment_size_(log_segment_size),
+      log_start_(0),
+      log_offset_(0),
+      file_name_(db_file),
+      backend_type_(backend_type),
+      direct_io_(direct_io),
+      db_fd_(-1),
+      checksum_fd_(-1),
+      num_checksum_failures_(0),
+      double_write_fd_(-1),
+      free_pages_fd_(-1),
+      num_free_pages_(0),
+      master_fd_(-1),
+      next_page_id_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -38,88 +69,614 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
-
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+
+  // The sidecar files describe the pages of the db file; left over from an older db file, they would be wrong.
+  const int db_file_size = GetFileSize(file_name_);
+  const std::string compressed_map_name = file_name_.substr(0, n) + ".cpm";
+  const bool db_is_new = db_file_size == 0 && (!enable_compression || GetFileSize(compressed_map_name) <= 0);
+  is_new_file_ = db_is_new;
+  // The pages of a reopened file are taken, whether the free space map knows of them or not.
+  next_page_id_ = static_cast<page_id_t>(std::max(db_file_size, 0) / PAGE_SIZE);
+  if (enable_compression) {
+    compressed_ = std::make_unique<CompressedPageFile>(file_name_.substr(0, n) + ".cpf", compressed_map_name, db_is_new);
+    next_page_id_ = std::max(next_page_id_.load(), compressed_->GetNumPages());
+  }
+  preallocated_page_id_ = next_page_id_;
+  const std::string free_pages_name = file_name_.substr(0, n) + ".fsm";
+  free_pages_fd_ = OpenSidecar(free_pages_name, db_is_new);
+  free_pages_.resize(GetFileSize(free_pages_name) / sizeof(uint64_t));
+  if (!free_pages_.empty() && pread(free_pages_fd_, free_pages_.data(), free_pages_.size() * sizeof(uint64_t), 0) < 0) {
+    throw Exception("can't read free space map");
+  }
+  for (auto word : free_pages_) {
+    num_free_pages_ += __builtin_popcountll(word);
+  }
+  OpenTablespaces(file_name_.substr(0, n), db_is_new);
+
+  master_fd_ = OpenSidecar(file_name_.substr(0, n) + ".mst", db_is_new);
+  OpenLog();
+
+  if (enable_checksums) {
+    const std::string checksum_name = file_name_.substr(0, n) + ".crc";
+    checksum_fd_ = OpenSidecar(checksum_name, db_is_new);
+    checksums_.resize(GetFileSize(checksum_name) / sizeof(uint32_t));
+    if (!checksums_.empty() &&
+        pread(checksum_fd_, checksums_.data(), checksums_.size() * sizeof(uint32_t), 0) < 0) {
+      throw Exception("can't read checksum file");
     }
   }
+  if (enable_double_write) {
+    double_write_fd_ = OpenSidecar(file_name_.substr(0, n) + ".dwb", db_is_new);
+    RepairTornPages();
+  }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() { ShutDown(); }
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  if (free_pages_fd_ >= 0) {
+    // Give the never used tails of the open extents back, or they would be lost for good.
+    std::vector<page_id_t> owners;
+    {
+      std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+      for (const auto &[owner, extent_list] : extents_) {
+        owners.push_back(owner);
+      }
+    }
+    for (auto owner : owners) {
+      ReleaseExtents(owner);
+    }
+  }
+  if (mapping_ != nullptr) {
+    munmap(const_cast<char *>(mapping_), mapping_size_);  // NOLINT
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+  }
+  UnmapLog();
+  compressed_.reset();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  {
+    std::unique_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+    for (auto &[data_file_name, fd] : data_files_) {
+      if (fd >= 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+  }
+  if (tablespace_list_fd_ >= 0) {
+    close(tablespace_list_fd_);
+    tablespace_list_fd_ = -1;
+  }
+  if (tablespace_map_fd_ >= 0) {
+    close(tablespace_map_fd_);
+    tablespace_map_fd_ = -1;
+  }
+  if (checksum_fd_ >= 0) {
+    close(checksum_fd_);
+    checksum_fd_ = -1;
+  }
+  if (double_write_fd_ >= 0) {
+    close(double_write_fd_);
+    double_write_fd_ = -1;
+  }
+  if (free_pages_fd_ >= 0) {
+    close(free_pages_fd_);
+    free_pages_fd_ = -1;
+  }
+  if (master_fd_ >= 0) {
+    close(master_fd_);
+    master_fd_ = -1;
+  }
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  for (const auto &[segment, fd] : log_segment_fds_) {
+    close(fd);
+  }
+  log_segment_fds_.clear();
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (double_write_fd_ >= 0) {
+    WritePages({{page_id, page_data}});
+  } else {
+    WritePageInPlace(page_id, page_data);
+  }
+}
+
+/**
+ * Write pages into disk file, through the double-write file if any: | num_pages | checksum | page_ids | pages |, the
+ * header in the first page of the file and the pages after it
+ */
+void DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  // In page id order, so that the writes are mostly sequential and adjacent pages are written together. The sort is
+  // stable, so that the last copy of a page given twice is written last.
+  std::vector<std::pair<page_id_t, const char *>> sorted(pages);
+  std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  if (double_write_fd_ < 0) {
+    WritePagesInPlace(sorted.data(), sorted.size());
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  std::vector<char> area;
+  for (size_t begin = 0; begin < sorted.size(); begin += DOUBLE_WRITE_BATCH_SIZE) {
+    const size_t end = std::min(sorted.size(), begin + DOUBLE_WRITE_BATCH_SIZE);
+    const auto num_pages = static_cast<uint32_t>(end - begin);
+    area.assign((1 + num_pages) * PAGE_SIZE, 0);
+    memcpy(area.data(), &num_pages, sizeof(uint32_t));
+    for (size_t i = begin; i < end; i++) {
+      memcpy(area.data() + 2 * sizeof(uint32_t) + (i - begin) * sizeof(page_id_t), &sorted[i].first,
+             sizeof(page_id_t));
+      memcpy(area.data() + (1 + i - begin) * PAGE_SIZE, sorted[i].second, PAGE_SIZE);
+    }
+    const uint32_t checksum =
+        Crc32cUtil::Crc32c(area.data() + 2 * sizeof(uint32_t), area.size() - 2 * sizeof(uint32_t));
+    memcpy(area.data() + sizeof(uint32_t), &checksum, sizeof(uint32_t));
+
+    std::lock_guard<std::mutex> double_write_guard(double_write_latch_);
+    if (pwrite(double_write_fd_, area.data(), area.size(), 0) != static_cast<ssize_t>(area.size())) {
+      LOG_DEBUG("I/O error while writing the double-write buffer");
+    }
+    fdatasync(double_write_fd_);
+    WritePagesInPlace(sorted.data() + begin, end - begin);
+    SyncDataFiles();
+  }
+}
+
+void DiskManager::WritePageInPlace(page_id_t page_id, const char *page_data) {
+  if (compressed_ != nullptr) {
+    compressed_->Write(page_id, page_data);
+    num_writes_.fetch_add(1, std::memory_order_relaxed);
+    num_write_calls_.fetch_add(1, std::memory_order_relaxed);
+    RecordChecksum(page_id, page_data);
+    RecordChangedPage(page_id);
+    return;
+  }
+  const PageLocation location = Locate(page_id);
+  num_writes_.fetch_add(1, std::memory_order_relaxed);
+  // pwrite may write less than asked for, keep going until the whole page is out
+  ssize_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t n = pwrite(location.fd_, page_data + written, PAGE_SIZE - written, location.offset_ + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += n;
+  }
+  num_write_calls_.fetch_add(1, std::memory_order_relaxed);
+  RecordChecksum(page_id, page_data);
+  RecordChangedPage(page_id);
+}
+
+void DiskManager::WritePagesInPlace(const std::pair<page_id_t, const char *> *pages, size_t num_pages) {
+  // Compressed, adjacent pages are not adjacent in the file.
+  if (compressed_ != nullptr) {
+    for (size_t i = 0; i < num_pages; i++) {
+      WritePageInPlace(pages[i].first, pages[i].second);
+    }
+    return;
+  }
+  // Adjacent pages of different extents may be in different files once there are tablespaces.
+  const page_id_t run_boundary = num_tablespaces_ > 1 ? static_cast<page_id_t>(EXTENT_SIZE) : 0;
+  size_t begin = 0;
+  while (begin < num_pages) {
+    size_t end = begin + 1;
+    while (end < num_pages && end - begin < MAX_COALESCED_WRITE && pages[end].first == pages[end - 1].first + 1 &&
+           (run_boundary == 0 || pages[end].first % run_boundary != 0)) {
+      end++;
+    }
+    if (end - begin == 1) {
+      WritePageInPlace(pages[begin].first, pages[begin].second);
+    } else {
+      WriteRunInPlace(pages[begin].first, pages + begin, end - begin);
+    }
+    begin = end;
+  }
+}
+
+void DiskManager::WriteRunInPlace(page_id_t first_page_id, const std::pair<page_id_t, const char *> *pages,
+                                  size_t num_pages) {
+  std::vector<iovec> iov(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    iov[i].iov_base = const_cast<char *>(pages[i].second);  // NOLINT
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  const PageLocation location = Locate(first_page_id);
+  off_t offset = location.offset_;
+  num_writes_.fetch_add(static_cast<int>(num_pages), std::memory_order_relaxed);
+  num_write_calls_.fetch_add(1, std::memory_order_relaxed);
+  // pwritev may write less than asked for too, keep going from where it stopped
+  size_t first = 0;
+  while (first < num_pages) {
+    ssize_t n = pwritev(location.fd_, iov.data() + first, static_cast<int>(num_pages - first), offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    offset += n;
+    for (auto left = static_cast<size_t>(n); left > 0;) {
+      const size_t step = std::min(left, iov[first].iov_len);
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + step;
+      iov[first].iov_len -= step;
+      left -= step;
+      if (iov[first].iov_len == 0) {
+        first++;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    RecordChecksum(pages[i].first, pages[i].second);
+    RecordChangedPage(pages[i].first);
+  }
+}
+
+void DiskManager::RecordChangedPage(page_id_t page_id) {
+  const size_t word = page_id / 64;
+  std::lock_guard<std::mutex> changed_pages_guard(changed_pages_latch_);
+  if (word >= changed_pages_.size()) {
+    changed_pages_.resize(word + 1);
+  }
+  changed_pages_[word] |= uint64_t{1} << (page_id % 64);
+}
+
+std::vector<page_id_t> DiskManager::TakeChangedPages() {
+  std::vector<uint64_t> changed_pages;
+  {
+    std::lock_guard<std::mutex> changed_pages_guard(changed_pages_latch_);
+    changed_pages.swap(changed_pages_);
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t word = 0; word < changed_pages.size(); word++) {
+    for (uint64_t bits = changed_pages[word]; bits != 0; bits &= bits - 1) {
+      page_ids.push_back(static_cast<page_id_t>(word * 64 + __builtin_ctzll(bits)));
+    }
+  }
+  return page_ids;
+}
+
+void DiskManager::RecordChecksum(page_id_t page_id, const char *page_data) {
+  if (checksum_fd_ >= 0) {
+    // 0 means no checksum was ever recorded, so a page whose checksum happens to be 0 is recorded as 1 instead.
+    const uint32_t checksum = std::max<uint32_t>(Crc32cUtil::Crc32c(page_data, PAGE_SIZE), 1);
+    std::lock_guard<std::mutex> checksum_guard(checksum_latch_);
+    if (checksums_.size() <= static_cast<size_t>(page_id)) {
+      checksums_.resize(page_id + 1, 0);
+    }
+    checksums_[page_id] = checksum;
+    if (pwrite(checksum_fd_, &checksum, sizeof(checksum), static_cast<off_t>(page_id) * sizeof(checksum)) !=
+        sizeof(checksum)) {
+      LOG_DEBUG("I/O error while writing checksum");
+    }
+  }
+}
+
+void DiskManager::RepairTornPages() {
+  uint32_t header[2];
+  if (pread(double_write_fd_, header, sizeof(header), 0) != sizeof(header) || header[0] == 0 ||
+      header[0] > DOUBLE_WRITE_BATCH_SIZE) {
+    return;
+  }
+  const uint32_t num_pages = header[0];
+  std::vector<char> area((1 + num_pages) * PAGE_SIZE);
+  if (pread(double_write_fd_, area.data(), area.size(), 0) != static_cast<ssize_t>(area.size()) ||
+      Crc32cUtil::Crc32c(area.data() + 2 * sizeof(uint32_t), area.size() - 2 * sizeof(uint32_t)) != header[1]) {
+    // Torn in the double-write file, before any of its pages was written in place.
+    return;
+  }
+  std::vector<char> on_disk(PAGE_SIZE);
+  for (uint32_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    memcpy(&page_id, area.data() + 2 * sizeof(uint32_t) + i * sizeof(page_id_t), sizeof(page_id_t));
+    const char *copy = area.data() + (1 + i) * PAGE_SIZE;
+    bool read = false;
+    if (compressed_ != nullptr) {
+      read = compressed_->Read(page_id, on_disk.data());
+    } else {
+      const PageLocation location = Locate(page_id);
+      read = pread(location.fd_, on_disk.data(), PAGE_SIZE, location.offset_) == PAGE_SIZE;
+    }
+    if (!read || memcmp(on_disk.data(), copy, PAGE_SIZE) != 0) {
+      LOG_DEBUG("page %d repaired from the double-write buffer", page_id);
+      WritePageInPlace(page_id, copy);
+      next_page_id_ = std::max(next_page_id_.load(), page_id + 1);
+      num_repaired_pages_++;
+    } else {
+      // The page made it to disk, its checksum may not have.
+      RecordChecksum(page_id, copy);
+    }
+  }
+  SyncDataFiles();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+  if (const char *mapped = GetMappedPage(page_id); mapped != nullptr) {
+    // A page fault at worst, which the read ahead asked for by MapFile mostly spares.
+    memcpy(page_data, mapped, PAGE_SIZE);
+    if (!VerifyPageChecksum(page_id, page_data)) {
+      throw ChecksumException("page " + std::to_string(page_id) + " does not match its checksum");
+    }
+    return;
+  }
+  if (compressed_ != nullptr) {
+    // A page never written reads as zeros, like one past the end of the db file.
+    if (!compressed_->Read(page_id, page_data)) {
+      LOG_DEBUG("compressed page %d not read", page_id);
+    }
+    if (!VerifyPageChecksum(page_id, page_data)) {
+      throw ChecksumException("page " + std::to_string(page_id) + " does not match its checksum");
+    }
+    return;
+  }
+  const PageLocation location = Locate(page_id);
+  ssize_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t n = pread(location.fd_, page_data + read_count, PAGE_SIZE - read_count, location.offset_ + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    // end of file
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
+  }
+  // check if read beyond file length, or if file ends before reading PAGE_SIZE
+  if (read_count == 0) {
+    LOG_DEBUG("I/O error reading past end of file");
+  } else if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+  }
+  if (read_count < PAGE_SIZE) {
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+
+  if (!VerifyPageChecksum(page_id, page_data)) {
+    throw ChecksumException("page " + std::to_string(page_id) + " does not match its checksum");
+  }
+}
+
+bool DiskManager::MapFile(MapAdvice advice) {
+  struct stat stat_buf;
+  // The pages of the other tablespaces are not in the db file, nor are compressed pages.
+  if (num_tablespaces_ > 1 || compressed_ != nullptr) {
+    return false;
+  }
+  if (mapping_ != nullptr || db_fd_ < 0 || fstat(db_fd_, &stat_buf) != 0 || stat_buf.st_size < PAGE_SIZE) {
+    return false;
+  }
+  const auto size = static_cast<size_t>(stat_buf.st_size) / PAGE_SIZE * PAGE_SIZE;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, db_fd_, 0);
+  if (mapped == MAP_FAILED) {
+    LOG_DEBUG("can't map the db file");
+    return false;
+  }
+  if (advice == MapAdvice::SEQUENTIAL) {
+    madvise(mapped, size, MADV_SEQUENTIAL);
+  } else if (advice == MapAdvice::WILLNEED) {
+    madvise(mapped, size, MADV_WILLNEED);
+  }
+  mapping_ = static_cast<const char *>(mapped);
+  mapping_size_ = size;
+  return true;
+}
+
+tablespace_id_t DiskManager::CreateTablespace(const std::string &name, const std::vector<std::string> &files) {
+  BUSTUB_ASSERT(!files.empty(), "a tablespace has at least one data file");
+  BUSTUB_ASSERT(name.find_first_of("\t\n") == std::string::npos, "tablespace names have no tabs or newlines");
+  if (compressed_ != nullptr) {
+    throw Exception("tablespace " + name + " can't be created, the pages are compressed");
+  }
+  std::unique_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  for (tablespace_id_t tablespace = 1; tablespace < tablespaces_.size(); tablespace++) {
+    if (tablespaces_[tablespace].name_ != name) {
+      continue;
+    }
+    std::vector<std::string> file_names;
+    for (size_t file : tablespaces_[tablespace].files_) {
+      file_names.push_back(data_files_[file].first);
+    }
+    if (file_names != files) {
+      throw Exception("tablespace " + name + " has other data files");
+    }
+    return tablespace;
+  }
+  // A file holds the pages of one tablespace only.
+  std::vector<std::string> in_use{file_name_};
+  for (const auto &[data_file_name, fd] : data_files_) {
+    in_use.push_back(data_file_name);
+  }
+  for (const auto &file : files) {
+    if (std::find(in_use.begin(), in_use.end(), file) != in_use.end() ||
+        file.find_first_of("\t\n") != std::string::npos) {
+      throw Exception("data file " + file + " can't be used by tablespace " + name);
+    }
+    in_use.push_back(file);
+  }
+
+  Tablespace tablespace;
+  tablespace.name_ = name;
+  std::string line = name;
+  for (const auto &file : files) {
+    tablespace.files_.push_back(OpenDataFile(file, true));
+    line += '\t' + file;
+  }
+  line += '\n';
+  // Listed once its data files exist, so that a listed tablespace can always be opened again.
+  struct stat stat_buf;
+  if (fstat(tablespace_list_fd_, &stat_buf) != 0 ||
+      pwrite(tablespace_list_fd_, line.data(), line.size(), stat_buf.st_size) != static_cast<ssize_t>(line.size())) {
+    throw Exception("can't write tablespace file");
+  }
+  fdatasync(tablespace_list_fd_);
+  tablespaces_.push_back(std::move(tablespace));
+  num_tablespaces_ = tablespaces_.size();
+  return static_cast<tablespace_id_t>(tablespaces_.size() - 1);
+}
+
+tablespace_id_t DiskManager::GetPageTablespace(page_id_t page_id) {
+  std::shared_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  return page_id < 0 ? DEFAULT_TABLESPACE : GetExtentTablespace(page_id / EXTENT_SIZE);
+}
+
+std::string DiskManager::GetPageFile(page_id_t page_id, int64_t *offset) {
+  const PageLocation location = Locate(page_id);
+  *offset = location.offset_;
+  return GetFileName(location.file_);
+}
+
+DiskManager::PageLocation DiskManager::Locate(page_id_t page_id) {
+  const off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  if (num_tablespaces_ == 1 || page_id < 0) {
+    return {0, db_fd_, offset};
+  }
+  std::shared_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  const size_t extent = page_id / EXTENT_SIZE;
+  const tablespace_id_t tablespace_id = GetExtentTablespace(extent);
+  if (tablespace_id == DEFAULT_TABLESPACE) {
+    return {0, db_fd_, offset};
+  }
+  const Tablespace &tablespace = tablespaces_[tablespace_id];
+  const auto num_files = static_cast<int32_t>(tablespace.files_.size());
+  const int32_t stripe = extent_locations_[extent].stripe_;
+  const size_t file = tablespace.files_[stripe % num_files];
+  const auto extent_offset = static_cast<off_t>(stripe / num_files) * static_cast<off_t>(EXTENT_SIZE * PAGE_SIZE);
+  return {file + 1, data_files_[file].second, extent_offset + static_cast<off_t>(page_id % EXTENT_SIZE) * PAGE_SIZE};
+}
+
+std::string DiskManager::GetFileName(size_t file) {
+  if (file == 0) {
+    return file_name_;
+  }
+  std::shared_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  return data_files_[file - 1].first;
+}
+
+void DiskManager::OpenTablespaces(const std::string &base_name, bool db_is_new) {
+  std::unique_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  tablespaces_.push_back({"default", {}, 0});
+  const std::string list_name = base_name + ".tbs";
+  tablespace_list_fd_ = OpenSidecar(list_name, db_is_new);
+  std::string list(std::max(GetFileSize(list_name), 0), '\0');
+  if (!list.empty() && pread(tablespace_list_fd_, list.data(), list.size(), 0) != static_cast<ssize_t>(list.size())) {
+    throw Exception("can't read tablespace file");
+  }
+  // A line per tablespace: its name, then its data files, separated by tabs.
+  std::istringstream lines(list);
+  for (std::string line; std::getline(lines, line);) {
+    std::istringstream fields(line);
+    Tablespace tablespace;
+    std::getline(fields, tablespace.name_, '\t');
+    for (std::string file; std::getline(fields, file, '\t');) {
+      tablespace.files_.push_back(OpenDataFile(file, false));
+    }
+    tablespaces_.push_back(std::move(tablespace));
+  }
+
+  const std::string map_name = base_name + ".tsm";
+  tablespace_map_fd_ = OpenSidecar(map_name, db_is_new);
+  extent_locations_.resize(std::max(GetFileSize(map_name), 0) / sizeof(ExtentLocation));
+  if (!extent_locations_.empty() && pread(tablespace_map_fd_, extent_locations_.data(),
+                                          extent_locations_.size() * sizeof(ExtentLocation), 0) < 0) {
+    throw Exception("can't read tablespace map");
+  }
+  for (const auto &location : extent_locations_) {
+    if (location.tablespace_ >= tablespaces_.size()) {
+      throw Exception("tablespace map names an unknown tablespace");
+    }
+    int32_t &num_extents = tablespaces_[location.tablespace_].num_extents_;
+    num_extents = std::max(num_extents, location.stripe_ + 1);
+  }
+  // The extents of the other tablespaces are taken, even past the end of the db file.
+  next_page_id_ =
+      std::max(next_page_id_.load(), static_cast<page_id_t>(extent_locations_.size() * EXTENT_SIZE));
+  num_tablespaces_ = tablespaces_.size();
+}
+
+size_t DiskManager::OpenDataFile(const std::string &file_name, bool is_new) {
+  const int fd = open(file_name.c_str(), O_RDWR | O_CREAT | (is_new ? O_TRUNC : 0), 0644);
+  if (fd < 0) {
+    throw Exception("can't open data file " + file_name);
+  }
+  data_files_.emplace_back(file_name, fd);
+  return data_files_.size() - 1;
+}
+
+void DiskManager::AssignExtent(size_t extent, tablespace_id_t tablespace) {
+  std::unique_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+  if (extent_locations_.size() <= extent) {
+    extent_locations_.resize(extent + 1, {DEFAULT_TABLESPACE, 0});
+  }
+  extent_locations_[extent] = {tablespace, tablespaces_[tablespace].num_extents_++};
+  // Synced at once: pages written to the extent are lost if a crash forgets where they went.
+  if (pwrite(tablespace_map_fd_, &extent_locations_[extent], sizeof(ExtentLocation),
+             static_cast<off_t>(extent * sizeof(ExtentLocation))) != sizeof(ExtentLocation)) {
+    LOG_DEBUG("I/O error while writing tablespace map");
+  }
+  fdatasync(tablespace_map_fd_);
+}
+
+void DiskManager::SyncDataFiles() {
+  fdatasync(db_fd_);
+  // With the pages, lest a durable page be read back against a stale checksum after a crash.
+  if (checksum_fd_ >= 0) {
+    fdatasync(checksum_fd_);
+  }
+  if (compressed_ != nullptr) {
+    compressed_->Sync();
+  }
+  if (num_tablespaces_ > 1) {
+    std::shared_lock<std::shared_mutex> tablespace_lock(tablespace_latch_);
+    for (const auto &[data_file_name, fd] : data_files_) {
+      fdatasync(fd);
+    }
+  }
+}
+
+bool DiskManager::VerifyPageChecksum(page_id_t page_id, const char *page_data) {
+  if (checksum_fd_ < 0) {
+    return true;
+  }
+  uint32_t expected;
+  {
+    std::lock_guard<std::mutex> checksum_guard(checksum_latch_);
+    if (checksums_.size() <= static_cast<size_t>(page_id) || checksums_[page_id] == 0) {
+      return true;
     }
+    expected = checksums_[page_id];
   }
+  if (std::max<uint32_t>(Crc32cUtil::Crc32c(page_data, PAGE_SIZE), 1) == expected) {
+    return true;
+  }
+  num_checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+  LOG_DEBUG("page %d does not match its checksum", page_id);
+  return false;
 }
 
 /**
@@ -142,18 +699,248 @@ void DiskManager::WriteLog(char *log_data, int size) {
     assert(flush_log_f_->wait_for(std::chrono::seconds(10)) == std::future_status::ready);
   }
 
-  num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
+  num_flushes_.fetch_add(1, std::memory_order_relaxed);
+  // sequence write, split at the ends of the segments
+  const int64_t offset = ReserveLog(size);
+  std::vector<int> fds;
+  for (int written = 0; written < size;) {
+    const int64_t segment = (offset + written) / log_segment_size_;
+    const int64_t segment_offset = offset + written - segment * log_segment_size_;
+    const int fd = GetLogSegmentFd(segment);
+    const auto length = static_cast<int>(std::min<int64_t>(size - written, log_segment_size_ - segment_offset));
+    const ssize_t n = pwrite(fd, log_data + written, length, segment_offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    if (fds.empty() || fds.back() != fd) {
+      fds.push_back(fd);
+    }
+    written += n;
+  }
+  // needs to sync to keep disk file in sync; the blocks are allocated, so the data is enough
+  for (auto fd : fds) {
+#ifdef __linux__
+    fdatasync(fd);
+#else
+    fsync(fd);
+#endif
+  }
+  flush_log_ = false;
+}
+
+void DiskManager::WriteLogAsync(DiskBackend *backend, const char *log_data, int size,
+                                std::function<void(bool)> callback) {
+  num_flushes_.fetch_add(1, std::memory_order_relaxed);
+  std::vector<DiskRequest> requests;
+  requests.push_back({DiskRequest::Type::WRITE, ReserveLog(size), static_cast<uint32_t>(size),
+                      const_cast<char *>(log_data), std::move(callback)});
+  backend->Submit(&requests);
+}
+
+int64_t DiskManager::ReserveLog(int size) {
+  const int64_t offset = log_offset_.fetch_add(size);
+  const int64_t end = offset + size;
+  // The segment after the current one is prepared halfway through it, long before the writes reach it.
+  const int64_t last_segment = (end + log_segment_size_ / 2) / log_segment_size_;
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  for (int64_t segment = offset / log_segment_size_; segment <= last_segment; segment++) {
+    PrepareLogSegment(segment);
+  }
+  return offset;
+}
 
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
+void DiskManager::PrepareLogSegment(int64_t segment) {
+  if (log_segment_fds_.count(segment) != 0) {
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
-  flush_log_ = false;
+  const std::string segment_name = LogSegmentName(segment);
+  const int fd = open(segment_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw Exception("can't open " + segment_name);
+  }
+#ifdef FALLOC_FL_KEEP_SIZE
+  // Allocated at once, without growing the file, so that a synced write does not wait for the blocks to be allocated
+  // too. The end of the log is found from the size of its last segment, which the writes grow.
+  fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, log_segment_size_);
+#endif
+  log_segment_fds_[segment] = fd;
+}
+
+int DiskManager::GetLogSegmentFd(int64_t segment) {
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  auto iter = log_segment_fds_.find(segment);
+  return iter == log_segment_fds_.end() ? -1 : iter->second;
+}
+
+void DiskManager::OpenLog() {
+  int64_t log_start;
+  if (pread(master_fd_, &log_start, sizeof(int64_t), sizeof(int64_t)) != sizeof(int64_t)) {
+    log_start = 0;
+  }
+  log_start_ = log_start;
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  // Every segment is full but the last one; the files after it are spares, whatever they hold.
+  int64_t segment = log_start / log_segment_size_;
+  while (true) {
+    PrepareLogSegment(segment);
+    struct stat stat_buf;
+    fstat(log_segment_fds_[segment], &stat_buf);
+    if (stat_buf.st_size < log_segment_size_) {
+      log_offset_ = segment * log_segment_size_ + stat_buf.st_size;
+      break;
+    }
+    segment++;
+  }
+  for (segment++; GetFileSize(LogSegmentName(segment)) >= 0; segment++) {
+    PrepareLogSegment(segment);
+    if (ftruncate(log_segment_fds_[segment], 0) != 0) {
+      LOG_DEBUG("I/O error while emptying a spare log segment");
+    }
+  }
+}
+
+void DiskManager::TruncateLog(int64_t offset) {
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  // The segment being written stays, even once every record in it is dead.
+  const int64_t first_segment = std::min(offset, log_offset_.load()) / log_segment_size_;
+  if (first_segment * log_segment_size_ <= log_start_) {
+    return;
+  }
+  const int64_t log_start = first_segment * log_segment_size_;
+  if (pwrite(master_fd_, &log_start, sizeof(int64_t), sizeof(int64_t)) != sizeof(int64_t)) {
+    LOG_DEBUG("I/O error while writing master record");
+    return;
+  }
+#ifdef __linux__
+  fdatasync(master_fd_);
+#else
+  fsync(master_fd_);
+#endif
+  log_start_ = log_start;
+
+  const int64_t current_segment = log_offset_ / log_segment_size_;
+  for (auto iter = log_segment_fds_.begin(); iter != log_segment_fds_.end() && iter->first < first_segment;) {
+    const std::string segment_name = LogSegmentName(iter->first);
+    close(iter->second);
+    iter = log_segment_fds_.erase(iter);
+    const int64_t last_segment = log_segment_fds_.rbegin()->first;
+    if (last_segment - current_segment >= static_cast<int64_t>(LOG_NUM_SPARE_SEGMENTS)) {
+      unlink(segment_name.c_str());
+      continue;
+    }
+    // Emptied, then allocated again by PrepareLogSegment: the metadata is updated here rather than by the appends.
+    const std::string spare_name = LogSegmentName(last_segment + 1);
+    if (rename(segment_name.c_str(), spare_name.c_str()) != 0 || truncate(spare_name.c_str(), 0) != 0) {
+      LOG_DEBUG("can't recycle log segment %s", segment_name.c_str());
+      continue;
+    }
+    PrepareLogSegment(last_segment + 1);
+  }
+}
+
+const char *DiskManager::MapLog(int64_t offset, size_t *size) {
+  UnmapLog();
+  const int64_t log_end = log_offset_;
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
+  if (offset < log_start_ || offset >= log_end || log_segment_size_ % page_size != 0) {
+    return nullptr;
+  }
+  const int64_t first_segment = offset / log_segment_size_;
+  const int64_t mapping_start = first_segment * log_segment_size_;
+  const auto mapping_size = static_cast<size_t>(log_end - mapping_start);
+  // The addresses of the whole log are reserved first, then each segment is mapped over its part of them.
+  void *reserved = mmap(nullptr, mapping_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    return nullptr;
+  }
+  char *mapping = static_cast<char *>(reserved);
+  for (int64_t segment = first_segment; segment * log_segment_size_ < log_end; segment++) {
+    const int fd = GetLogSegmentFd(segment);
+    const int64_t segment_offset = segment * log_segment_size_ - mapping_start;
+    const auto length = static_cast<size_t>(std::min(log_segment_size_, log_end - segment * log_segment_size_));
+    if (fd < 0 || mmap(mapping + segment_offset, length, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+      LOG_DEBUG("can't map the log");
+      munmap(mapping, mapping_size);
+      return nullptr;
+    }
+  }
+  madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+  const int64_t read_start = (offset - mapping_start) / page_size * page_size;
+  madvise(mapping + read_start, mapping_size - read_start, MADV_WILLNEED);
+  log_mapping_ = mapping;
+  log_mapping_size_ = mapping_size;
+  *size = static_cast<size_t>(log_end - offset);
+  return mapping + (offset - mapping_start);
+}
+
+void DiskManager::UnmapLog() {
+  if (log_mapping_ != nullptr) {
+    munmap(const_cast<char *>(log_mapping_), log_mapping_size_);  // NOLINT
+    log_mapping_ = nullptr;
+    log_mapping_size_ = 0;
+  }
+}
+
+void DiskManager::RestoreLog(const char *data, size_t size, int64_t offset, int64_t checkpoint_offset) {
+  std::lock_guard<std::mutex> log_guard(log_latch_);
+  for (const auto &[segment, fd] : log_segment_fds_) {
+    close(fd);
+    unlink(LogSegmentName(segment).c_str());
+  }
+  log_segment_fds_.clear();
+  const int64_t log_start = offset / log_segment_size_ * log_segment_size_;
+  const int64_t master_record[2] = {checkpoint_offset, log_start};
+  if (pwrite(master_fd_, master_record, sizeof(master_record), 0) != sizeof(master_record)) {
+    LOG_DEBUG("I/O error while writing master record");
+  }
+#ifdef __linux__
+  fdatasync(master_fd_);
+#else
+  fsync(master_fd_);
+#endif
+  log_start_ = log_start;
+  // The bytes before offset in its segment are a hole, never read.
+  for (size_t written = 0; written < size;) {
+    const int64_t segment = (offset + static_cast<int64_t>(written)) / log_segment_size_;
+    const int64_t segment_offset = offset + static_cast<int64_t>(written) - segment * log_segment_size_;
+    const auto length = static_cast<size_t>(std::min<int64_t>(size - written, log_segment_size_ - segment_offset));
+    PrepareLogSegment(segment);
+    if (pwrite(log_segment_fds_[segment], data + written, length, segment_offset) != static_cast<ssize_t>(length)) {
+      LOG_DEBUG("I/O error while restoring log");
+      break;
+    }
+    written += length;
+  }
+  log_offset_ = offset + static_cast<int64_t>(size);
+  PrepareLogSegment(log_offset_ / log_segment_size_);
+  for (const auto &[segment, fd] : log_segment_fds_) {
+    fsync(fd);
+  }
+}
+
+void DiskManager::WriteMasterRecord(int64_t checkpoint_offset) {
+  if (pwrite(master_fd_, &checkpoint_offset, sizeof(int64_t), 0) != sizeof(int64_t)) {
+    LOG_DEBUG("I/O error while writing master record");
+    return;
+  }
+#ifdef __linux__
+  fdatasync(master_fd_);
+#else
+  fsync(master_fd_);
+#endif
+}
+
+int64_t DiskManager::ReadMasterRecord() {
+  int64_t checkpoint_offset;
+  if (pread(master_fd_, &checkpoint_offset, sizeof(int64_t), 0) != sizeof(int64_t)) {
+    return 0;
+  }
+  return checkpoint_offset;
 }
 
 /**
@@ -162,40 +949,219 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * @return: false means already reach the end
  */
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
-    // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+  if (offset < log_start_) {
+    LOG_DEBUG("log read before its truncation point");
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
+  int read_count = 0;
+  while (read_count < size) {
+    const int64_t segment = (offset + read_count) / log_segment_size_;
+    const int64_t segment_offset = offset + read_count - segment * log_segment_size_;
+    const int fd = GetLogSegmentFd(segment);
+    if (fd < 0) {
+      break;
+    }
+    const auto length = static_cast<size_t>(std::min<int64_t>(size - read_count, log_segment_size_ - segment_offset));
+    const ssize_t n = pread(fd, log_data + read_count, length, segment_offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading log");
+      return false;
+    }
+    read_count += n;
+    // The end of the log, in its last segment.
+    if (static_cast<size_t>(n) < length) {
+      break;
+    }
+  }
+  if (read_count == 0) {
+    // LOG_DEBUG("end of log file");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
-  if (read_count < size) {
-    log_io_.clear();
-    memset(log_data + read_count, 0, size - read_count);
-  }
-
+  memset(log_data + read_count, 0, size - read_count);
   return true;
 }
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Reuse a deallocated page if there is one, otherwise grow the file
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(page_id_t hint, page_id_t owner) {
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  if (owner != INVALID_PAGE_ID) {
+    auto [iter, is_new] = extents_.try_emplace(owner);
+    ExtentList &extent_list = iter->second;
+    if (is_new) {
+      // The owner's first page was allocated in its tablespace, which the rest of its pages follow.
+      extent_list.tablespace_ = owner < 0 ? DEFAULT_TABLESPACE : GetExtentTablespace(owner / EXTENT_SIZE);
+    }
+    if (extent_list.extents_.empty() || extent_list.next_page_id_ == extent_list.end_page_id_) {
+      extent_list.next_page_id_ = ReserveExtent(extent_list.tablespace_);
+      extent_list.end_page_id_ = extent_list.next_page_id_ + static_cast<page_id_t>(EXTENT_SIZE);
+      extent_list.extents_.push_back(extent_list.next_page_id_);
+    }
+    return extent_list.next_page_id_++;
+  }
+  const tablespace_id_t tablespace = current_tablespace_ < num_tablespaces_ ? current_tablespace_ : DEFAULT_TABLESPACE;
+  if (num_free_pages_ > 0) {
+    // Prefer the page right after the hint, then anything after it, then anything at all.
+    page_id_t page_id = hint == INVALID_PAGE_ID ? INVALID_PAGE_ID : FindFreePage(hint + 1, tablespace);
+    if (page_id == INVALID_PAGE_ID) {
+      page_id = FindFreePage(0, tablespace);
+    }
+    if (page_id != INVALID_PAGE_ID) {
+      SetPageFree(page_id, false);
+      return page_id;
+    }
+  }
+  if (tablespace != DEFAULT_TABLESPACE) {
+    // The other tablespaces grow by whole extents; the rest of this one is free for their next pages.
+    const page_id_t page_id = ReserveExtent(tablespace);
+    for (page_id_t free_page_id = page_id + 1; free_page_id < page_id + static_cast<page_id_t>(EXTENT_SIZE);
+         free_page_id++) {
+      SetPageFree(free_page_id, true);
+    }
+    return page_id;
+  }
+  const page_id_t page_id = next_page_id_++;
+  // Pages past the end of the file may be free in a free space map that outlived them, see ReleaseExtents.
+  SetPageFree(page_id, false);
+  PreallocatePages(next_page_id_);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page is marked in the free space map and handed out again by AllocatePage
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  SetPageFree(page_id, true);
+}
+
+std::vector<page_id_t> DiskManager::GetExtents(page_id_t owner) {
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  auto iter = extents_.find(owner);
+  return iter == extents_.end() ? std::vector<page_id_t>{} : iter->second.extents_;
+}
+
+std::map<page_id_t, page_id_t> DiskManager::GetExtentOwners() {
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  std::map<page_id_t, page_id_t> extent_owners;
+  for (const auto &[owner, extent_list] : extents_) {
+    for (page_id_t extent : extent_list.extents_) {
+      extent_owners.emplace(extent, owner);
+    }
+  }
+  return extent_owners;
+}
+
+void DiskManager::ReleaseExtents(page_id_t owner) {
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  auto iter = extents_.find(owner);
+  if (iter == extents_.end()) {
+    return;
+  }
+  for (page_id_t page_id = iter->second.next_page_id_; page_id < iter->second.end_page_id_; page_id++) {
+    SetPageFree(page_id, true);
+  }
+  extents_.erase(iter);
+}
+
+page_id_t DiskManager::ReserveExtent(tablespace_id_t tablespace) {
+  static_assert(sizeof(free_pages_[0]) * 8 == EXTENT_SIZE, "an extent is one word of the free space map");
+  // An extent whose pages have all been freed can be taken over as a whole.
+  if (num_free_pages_ >= EXTENT_SIZE) {
+    for (size_t word = 0; word < free_pages_.size(); word++) {
+      if (free_pages_[word] == ~uint64_t{0} && GetExtentTablespace(word) == tablespace) {
+        free_pages_[word] = 0;
+        num_free_pages_ -= EXTENT_SIZE;
+        if (pwrite(free_pages_fd_, &free_pages_[word], sizeof(uint64_t), static_cast<off_t>(word * sizeof(uint64_t))) !=
+            sizeof(uint64_t)) {
+          LOG_DEBUG("I/O error while writing free space map");
+        }
+        return static_cast<page_id_t>(word * EXTENT_SIZE);
+      }
+    }
+  }
+  // Otherwise grow the file by an aligned extent. The pages skipped to align it are free for anyone to use.
+  const page_id_t first_page_id = next_page_id_;
+  const auto extent_page_id = static_cast<page_id_t>((first_page_id + EXTENT_SIZE - 1) / EXTENT_SIZE * EXTENT_SIZE);
+  for (page_id_t page_id = first_page_id; page_id < extent_page_id; page_id++) {
+    SetPageFree(page_id, true);
+  }
+  next_page_id_ = extent_page_id + static_cast<page_id_t>(EXTENT_SIZE);
+  if (tablespace != DEFAULT_TABLESPACE) {
+    AssignExtent(extent_page_id / EXTENT_SIZE, tablespace);
+  } else {
+    PreallocatePages(next_page_id_);
+  }
+  return extent_page_id;
+}
+
+void DiskManager::PreallocatePages(page_id_t end_page_id) {
+  if (end_page_id <= preallocated_page_id_ || db_fd_ < 0 || compressed_ != nullptr) {
+    return;
+  }
+  const auto chunk = static_cast<page_id_t>(PREALLOCATE_SIZE);
+  const page_id_t preallocated_page_id = (end_page_id + chunk - 1) / chunk * chunk;
+#ifdef FALLOC_FL_KEEP_SIZE
+  // Not retried on failure, e.g. where the file system cannot: the writes then allocate the blocks as they go.
+  fallocate(db_fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(preallocated_page_id_) * PAGE_SIZE,
+            static_cast<off_t>(preallocated_page_id - preallocated_page_id_) * PAGE_SIZE);
+#endif
+  preallocated_page_id_ = preallocated_page_id;
+}
+
+size_t DiskManager::GetNumFreePages() {
+  std::lock_guard<std::mutex> free_pages_guard(free_pages_latch_);
+  return num_free_pages_;
+}
+
+page_id_t DiskManager::FindFreePage(page_id_t page_id, tablespace_id_t tablespace) {
+  // A word of the free space map is an extent, all of it in one tablespace.
+  const bool has_tablespaces = num_tablespaces_ > 1;
+  for (size_t word = page_id / 64; word < free_pages_.size(); word++) {
+    if (has_tablespaces && GetExtentTablespace(word) != tablespace) {
+      continue;
+    }
+    uint64_t bits = free_pages_[word];
+    // Ignore the pages before page_id in its own word.
+    if (word == static_cast<size_t>(page_id / 64)) {
+      bits &= ~uint64_t{0} << (page_id % 64);
+    }
+    if (bits != 0) {
+      return static_cast<page_id_t>(word * 64 + __builtin_ctzll(bits));
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void DiskManager::SetPageFree(page_id_t page_id, bool free) {
+  const size_t word = page_id / 64;
+  const uint64_t bit = uint64_t{1} << (page_id % 64);
+  if (word >= free_pages_.size()) {
+    if (!free) {
+      return;
+    }
+    free_pages_.resize(word + 1, 0);
+  }
+  if (((free_pages_[word] & bit) != 0) == free) {
+    return;
+  }
+  free_pages_[word] ^= bit;
+  num_free_pages_ = free ? num_free_pages_ + 1 : num_free_pages_ - 1;
+  if (pwrite(free_pages_fd_, &free_pages_[word], sizeof(uint64_t), static_cast<off_t>(word * sizeof(uint64_t))) !=
+      sizeof(uint64_t)) {
+    LOG_DEBUG("I/O error while writing free space map");
+  }
+}
 
 /**
  * Returns number of flushes made so far
@@ -212,6 +1178,17 @@ int DiskManager::GetNumWrites() const { return num_writes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Private helper function to open a sidecar file, truncating it if it belongs to an older db file
+ */
+int DiskManager::OpenSidecar(const std::string &file_name, bool db_is_new) {
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT | (db_is_new ? O_TRUNC : 0), 0644);
+  if (fd < 0) {
+    throw Exception("can't open " + file_name);
+  }
+  return fd;
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_disk_backend.cpp
+//
+// Identification: src/storage/disk/io_uring_disk_backend.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring_disk_backend.h"
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+std::unique_ptr<IoUringDiskBackend> IoUringDiskBackend::Create(int fd, bool direct_io, uint32_t queue_depth) {
+  std::unique_ptr<IoUringDiskBackend> backend(new IoUringDiskBackend(fd, direct_io));
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  backend->ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (backend->ring_fd_ < 0) {
+    LOG_DEBUG("io_uring_setup failed: %s", strerror(errno));
+    return nullptr;
+  }
+  if (!backend->MapRings(params)) {
+    LOG_DEBUG("mapping the io_uring failed: %s", strerror(errno));
+    return nullptr;
+  }
+  backend->in_flight_.resize(params.sq_entries);
+  for (uint32_t slot = params.sq_entries; slot > 0; slot--) {
+    backend->free_slots_.push_back(slot - 1);
+  }
+  return backend;
+}
+
+bool IoUringDiskBackend::MapRings(const io_uring_params &params) {
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  return true;
+}
+
+IoUringDiskBackend::~IoUringDiskBackend() {
+  if (sqes_ != nullptr) {
+    Wait();
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+  close(fd_);
+}
+
+void IoUringDiskBackend::Submit(std::vector<DiskRequest> *requests) {
+  for (auto &request : *requests) {
+    // Every submission queue entry is in use; make room by waiting for the oldest batch.
+    while (free_slots_.empty()) {
+      Enter(1);
+      Reap();
+    }
+    const uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    char *bounce_buffer = BounceBuffer(request, direct_io_);
+    in_flight_[slot] = {std::move(request), bounce_buffer};
+    const InFlight &in_flight = in_flight_[slot];
+
+    // We are the only producer, so the tail can be read plainly; the kernel only needs to see it after the entry.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = in_flight.request_.type_ == DiskRequest::Type::READ ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(bounce_buffer != nullptr ? bounce_buffer : in_flight.request_.data_);
+    sqe->len = in_flight.request_.size_;
+    sqe->off = static_cast<uint64_t>(in_flight.request_.offset_);
+    sqe->user_data = slot;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+  }
+  requests->clear();
+  // One system call for the whole batch.
+  Enter(0);
+  Reap();
+}
+
+void IoUringDiskBackend::Wait() {
+  while (free_slots_.size() < in_flight_.size()) {
+    Enter(1);
+    Reap();
+  }
+}
+
+void IoUringDiskBackend::WaitAny() {
+  if (free_slots_.size() < in_flight_.size()) {
+    Enter(1);
+    Reap();
+  }
+}
+
+void IoUringDiskBackend::Enter(uint32_t min_complete) {
+  if (to_submit_ == 0 && min_complete == 0) {
+    return;
+  }
+  const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  while (true) {
+    const int submitted =
+        static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit_, min_complete, flags, nullptr, 0));
+    if (submitted >= 0) {
+      to_submit_ -= std::min(to_submit_, static_cast<uint32_t>(submitted));
+      return;
+    }
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      throw Exception(std::string("io_uring_enter failed: ") + strerror(errno));
+    }
+  }
+}
+
+void IoUringDiskBackend::Reap() {
+  // The head is reloaded on every iteration, because a callback may submit more requests and reap in turn.
+  for (unsigned head = *cq_head_; head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE); head = *cq_head_) {
+    const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+    const auto slot = static_cast<uint32_t>(cqe.user_data);
+    const int64_t result = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    // Release the slot before the callback, so that it can be reused right away.
+    InFlight in_flight = std::move(in_flight_[slot]);
+    free_slots_.push_back(slot);
+    Complete(&in_flight.request_, in_flight.bounce_buffer_, result);
+  }
+}
+
+}  // namespace bustub
+
+#endif  // BUSTUB_HAVE_IO_URING
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// temp_space.cpp
+//
+// Identification: src/storage/disk/temp_space.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/temp_space.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+TempSpace::~TempSpace() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+uint32_t TempSpace::AllocateBlock() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (fd_ < 0) {
+    std::string directory = directory_;
+    if (directory.empty()) {
+      const char *tmpdir = std::getenv("TMPDIR");
+      directory = tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp";
+    }
+    std::string name = directory + "/bustub_temp_XXXXXX";
+    fd_ = mkstemp(name.data());
+    if (fd_ < 0) {
+      throw Exception("can't create temporary file in " + directory);
+    }
+    unlink(name.c_str());
+  }
+  if (!free_blocks_.empty()) {
+    const uint32_t block = free_blocks_.back();
+    free_blocks_.pop_back();
+    return block;
+  }
+  return num_blocks_++;
+}
+
+void TempSpace::FreeBlock(uint32_t block) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(block < num_blocks_, "Freed a block that was never allocated.");
+  free_blocks_.push_back(block);
+  if (free_blocks_.size() == num_blocks_) {
+    // Nothing is spilled anymore: give the space of the file back.
+    free_blocks_.clear();
+    num_blocks_ = 0;
+    if (ftruncate(fd_, 0) != 0) {
+      LOG_DEBUG("can't empty temporary file");
+    }
+  }
+}
+
+void TempSpace::WriteBlock(uint32_t block, const char *data, size_t size) {
+  BUSTUB_ASSERT(size <= TEMP_SPACE_BLOCK_SIZE, "Wrote past the end of a block.");
+  const auto offset = static_cast<off_t>(block) * TEMP_SPACE_BLOCK_SIZE;
+  // pwrite may write less than asked for, keep going until the whole block is out
+  for (size_t written = 0; written < size;) {
+    ssize_t n = pwrite(fd_, data + written, size - written, offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      throw Exception("can't write temporary file");
+    }
+    written += n;
+  }
+}
+
+void TempSpace::ReadBlock(uint32_t block, char *data, size_t size) {
+  BUSTUB_ASSERT(size <= TEMP_SPACE_BLOCK_SIZE, "Read past the end of a block.");
+  const auto offset = static_cast<off_t>(block) * TEMP_SPACE_BLOCK_SIZE;
+  for (size_t read = 0; read < size;) {
+    ssize_t n = pread(fd_, data + read, size - read, offset + read);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      throw Exception("can't read temporary file");
+    }
+    read += n;
+  }
+}
+
+size_t TempSpace::GetNumAllocated() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_blocks_ - free_blocks_.size();
+}
+
+size_t TempSpace::GetNumBlocks() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_blocks_;
+}
+
+}  // namespace bustub
@@ -0,0 +1,782 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.cpp
+//
+// Identification: src/storage/index/art_index.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/art_index.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/*
+ * The version of a node counts its modifications in steps of 4: bit 1 is set
+ * while a writer holds the node, bit 0 once the node is obsolete.
+ */
+struct ARTIndex::Node {
+  Node(uint16_t capacity, std::string prefix) : capacity_(capacity), prefix_(std::move(prefix)) {}
+
+  std::atomic<uint64_t> version_{0};
+  // 4, 16, 48 or 256 for an inner node, 0 for a leaf
+  const uint16_t capacity_;
+  uint16_t num_children_{0};
+  const std::string prefix_;
+};
+
+struct ARTIndex::Leaf : ARTIndex::Node {
+  Leaf(std::string key, std::vector<RID> rids) : Node(0, ""), key_(std::move(key)), rids_(std::move(rids)) {}
+
+  const std::string key_;
+  const std::vector<RID> rids_;
+};
+
+/** A node of 4 or 16 children, whose bytes are kept sorted. */
+template <size_t N>
+struct ARTIndex::SortedNode : ARTIndex::Node {
+  explicit SortedNode(std::string prefix) : Node(N, std::move(prefix)) {}
+
+  /** @return the number of children, clamped for the readers that see it torn */
+  size_t Size() const { return std::min<size_t>(num_children_, N); }
+
+  uint8_t bytes_[N];
+  Node *children_[N];
+};
+
+/** A node of 48 children, found through the index of each byte. */
+struct ARTIndex::Node48 : ARTIndex::Node {
+  explicit Node48(std::string prefix) : Node(48, std::move(prefix)) {
+    std::fill(std::begin(indexes_), std::end(indexes_), 0);
+    std::fill(std::begin(children_), std::end(children_), nullptr);
+  }
+
+  // one past the slot of the child of each byte, 0 for none
+  uint8_t indexes_[256];
+  Node *children_[48];
+};
+
+/** A node of 256 children, one for each byte. */
+struct ARTIndex::Node256 : ARTIndex::Node {
+  explicit Node256(std::string prefix) : Node(256, std::move(prefix)) {
+    std::fill(std::begin(children_), std::end(children_), nullptr);
+  }
+
+  Node *children_[256];
+};
+
+namespace {
+
+/** @return the capacity of the next larger kind of node */
+size_t GrownCapacity(size_t capacity) { return capacity == 4 ? 16 : capacity == 16 ? 48 : 256; }
+
+/** @return the capacity of the next smaller kind of node, 0 for none */
+size_t ShrunkCapacity(size_t capacity) { return capacity == 256 ? 48 : capacity == 48 ? 16 : capacity == 16 ? 4 : 0; }
+
+}  // namespace
+
+ARTIndex::ARTIndex(IndexMetadata *metadata) : Index(metadata), root_(NewInner(256, "")) {}
+
+ARTIndex::~ARTIndex() {
+  FreeNode(root_, true);
+  for (auto &retired : retired_) {
+    for (Node *node : retired) {
+      FreeNode(node, false);
+    }
+  }
+}
+
+void ARTIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  const std::string encoded = EncodeKey(key);
+  const size_t epoch = EnterEpoch();
+  bool inserted;
+  while (!TryInsert(encoded, rid, &inserted)) {
+    std::this_thread::yield();
+  }
+  ExitEpoch(epoch);
+}
+
+void ARTIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  const std::string encoded = EncodeKey(key);
+  const size_t epoch = EnterEpoch();
+  while (!TryRemove(encoded, rid)) {
+    std::this_thread::yield();
+  }
+  ExitEpoch(epoch);
+}
+
+void ARTIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  const std::string encoded = EncodeKey(key);
+  const size_t epoch = EnterEpoch();
+  while (!TryLookup(encoded, result)) {
+    std::this_thread::yield();
+  }
+  ExitEpoch(epoch);
+}
+
+void ARTIndex::ScanRange(const Tuple *lo, const Tuple *hi, std::vector<RID> *result) {
+  const std::string lo_key = lo == nullptr ? "" : EncodeKey(*lo);
+  const std::string hi_key = hi == nullptr ? "" : EncodeKey(*hi);
+  std::string last;
+  const size_t epoch = EnterEpoch();
+  while (true) {
+    // Started over, the scan goes on past the last key collected.
+    const std::string &from = last.empty() ? lo_key : last;
+    std::string path;
+    if (ScanNode(root_, &path, from, !from.empty(), hi == nullptr ? nullptr : &hi_key, hi != nullptr, result,
+                 &last)) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  ExitEpoch(epoch);
+}
+
+std::string ARTIndex::EncodeKey(const Tuple &key) const {
+  return EncodeOrderedKey(key, GetMetadata()->GetSearchKeySchema());
+}
+
+/*****************************************************************************
+ * OPERATIONS
+ *****************************************************************************/
+/*
+ * Go down from the root, locking a node only to modify it. A key off the
+ * prefix of a node splits the prefix; a key next to the leaf of another gets
+ * a new node for the bytes they share; a full node grows into a copy.
+ */
+bool ARTIndex::TryInsert(const std::string &key, RID rid, bool *inserted) {
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    const std::string &prefix = node->prefix_;
+    size_t matched = 0;
+    while (matched < prefix.size() && depth + matched < key.size() && prefix[matched] == key[depth + matched]) {
+      matched++;
+    }
+    if (matched < prefix.size()) {
+      BUSTUB_ASSERT(depth + matched < key.size(), "no key is a prefix of another");
+      // A new node takes the bytes the key shares with the prefix, the node goes below it with the rest.
+      if (!UpgradeToWriteLock(parent, parent_version)) {
+        return false;
+      }
+      if (!UpgradeToWriteLock(node, version)) {
+        WriteUnlock(parent);
+        return false;
+      }
+      Node *branch = NewInner(4, prefix.substr(0, matched));
+      AddChild(branch, prefix[matched], CopyInner(node, node->capacity_, prefix.substr(matched + 1)));
+      AddChild(branch, key[depth + matched], NewLeaf(key, {rid}));
+      ReplaceChild(parent, parent_byte, branch);
+      WriteUnlockObsolete(node);
+      WriteUnlock(parent);
+      Retire(node);
+      *inserted = true;
+      return true;
+    }
+    depth += prefix.size();
+    const auto byte = static_cast<uint8_t>(key[depth]);
+    Node *child = FindChild(node, byte);
+    if (!Validate(node, version)) {
+      return false;
+    }
+
+    if (child == nullptr) {
+      if (node->num_children_ < node->capacity_) {
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        AddChild(node, byte, NewLeaf(key, {rid}));
+        WriteUnlock(node);
+      } else {
+        // The root never fills up, the node has a parent.
+        if (!UpgradeToWriteLock(parent, parent_version)) {
+          return false;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          WriteUnlock(parent);
+          return false;
+        }
+        Node *grown = CopyInner(node, GrownCapacity(node->capacity_), prefix);
+        AddChild(grown, byte, NewLeaf(key, {rid}));
+        ReplaceChild(parent, parent_byte, grown);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        Retire(node);
+      }
+      *inserted = true;
+      return true;
+    }
+
+    if (child->capacity_ == 0) {
+      auto leaf = static_cast<Leaf *>(child);
+      if (leaf->key_ == key) {
+        if (GetMetadata()->HasUniqueKeys() ||
+            std::find(leaf->rids_.begin(), leaf->rids_.end(), rid) != leaf->rids_.end()) {
+          *inserted = false;
+          return true;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        std::vector<RID> rids = leaf->rids_;
+        rids.push_back(rid);
+        ReplaceChild(node, byte, NewLeaf(key, std::move(rids)));
+        WriteUnlock(node);
+        Retire(leaf);
+        *inserted = true;
+        return true;
+      }
+      // A new node takes the bytes both keys share past the byte, with both leaves below it.
+      if (!UpgradeToWriteLock(node, version)) {
+        return false;
+      }
+      size_t shared = depth + 1;
+      while (shared < key.size() && shared < leaf->key_.size() && leaf->key_[shared] == key[shared]) {
+        shared++;
+      }
+      BUSTUB_ASSERT(shared < key.size() && shared < leaf->key_.size(), "no key is a prefix of another");
+      Node *branch = NewInner(4, key.substr(depth + 1, shared - depth - 1));
+      AddChild(branch, leaf->key_[shared], leaf);
+      AddChild(branch, key[shared], NewLeaf(key, {rid}));
+      ReplaceChild(node, byte, branch);
+      WriteUnlock(node);
+      *inserted = true;
+      return true;
+    }
+
+    depth++;
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = child;
+    if (!ReadLock(node, &version) || !Validate(parent, parent_version)) {
+      return false;
+    }
+  }
+}
+
+/*
+ * Go down as an insert does. A node left with one child is replaced by the
+ * child, its prefix extended with the node's; a node left with few children
+ * shrinks into a copy of a smaller kind.
+ */
+bool ARTIndex::TryRemove(const std::string &key, RID rid) {
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    const std::string &prefix = node->prefix_;
+    if (key.compare(depth, prefix.size(), prefix) != 0) {
+      return Validate(node, version);
+    }
+    depth += prefix.size();
+    const auto byte = static_cast<uint8_t>(key[depth]);
+    Node *child = FindChild(node, byte);
+    if (!Validate(node, version)) {
+      return false;
+    }
+    if (child == nullptr) {
+      return true;
+    }
+
+    if (child->capacity_ == 0) {
+      auto leaf = static_cast<Leaf *>(child);
+      if (leaf->key_ != key || std::find(leaf->rids_.begin(), leaf->rids_.end(), rid) == leaf->rids_.end()) {
+        return true;
+      }
+      if (leaf->rids_.size() > 1) {
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        std::vector<RID> rids = leaf->rids_;
+        rids.erase(std::find(rids.begin(), rids.end(), rid));
+        ReplaceChild(node, byte, NewLeaf(key, std::move(rids)));
+        WriteUnlock(node);
+        Retire(leaf);
+        return true;
+      }
+      const size_t num_left = node->num_children_ - 1;
+      const size_t shrunk_capacity = ShrunkCapacity(node->capacity_);
+      if (node == root_ || (num_left > 1 && num_left != shrunk_capacity / 2)) {
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        RemoveChild(node, byte);
+        WriteUnlock(node);
+        Retire(leaf);
+        return true;
+      }
+      if (!UpgradeToWriteLock(parent, parent_version)) {
+        return false;
+      }
+      if (!UpgradeToWriteLock(node, version)) {
+        WriteUnlock(parent);
+        return false;
+      }
+      if (num_left == 1) {
+        // The other child takes the place of the node; a leaf has its whole key, an inner node needs a longer prefix.
+        Children children;
+        GetChildren(node, &children);
+        const size_t other = children.bytes_[0] == byte ? 1 : 0;
+        Node *other_child = children.nodes_[other];
+        if (other_child->capacity_ == 0) {
+          ReplaceChild(parent, parent_byte, other_child);
+        } else {
+          uint64_t other_version;
+          if (!ReadLock(other_child, &other_version) || !UpgradeToWriteLock(other_child, other_version)) {
+            WriteUnlock(node);
+            WriteUnlock(parent);
+            return false;
+          }
+          std::string merged_prefix = prefix;
+          merged_prefix.push_back(static_cast<char>(children.bytes_[other]));
+          merged_prefix += other_child->prefix_;
+          ReplaceChild(parent, parent_byte, CopyInner(other_child, other_child->capacity_, std::move(merged_prefix)));
+          WriteUnlockObsolete(other_child);
+          Retire(other_child);
+        }
+      } else {
+        Node *shrunk = CopyInner(node, shrunk_capacity, prefix);
+        RemoveChild(shrunk, byte);
+        ReplaceChild(parent, parent_byte, shrunk);
+      }
+      WriteUnlockObsolete(node);
+      WriteUnlock(parent);
+      Retire(node);
+      Retire(leaf);
+      return true;
+    }
+
+    depth++;
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = child;
+    if (!ReadLock(node, &version) || !Validate(parent, parent_version)) {
+      return false;
+    }
+  }
+}
+
+bool ARTIndex::TryLookup(const std::string &key, std::vector<RID> *result) {
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    const std::string &prefix = node->prefix_;
+    if (key.compare(depth, prefix.size(), prefix) != 0) {
+      return Validate(node, version);
+    }
+    depth += prefix.size();
+    Node *child = FindChild(node, static_cast<uint8_t>(key[depth]));
+    if (!Validate(node, version)) {
+      return false;
+    }
+    if (child == nullptr) {
+      return true;
+    }
+    if (child->capacity_ == 0) {
+      // Leaves are never modified, the one found was the child when the node was validated.
+      auto leaf = static_cast<Leaf *>(child);
+      if (leaf->key_ == key) {
+        result->insert(result->end(), leaf->rids_.begin(), leaf->rids_.end());
+      }
+      return true;
+    }
+    depth++;
+    uint64_t child_version;
+    if (!ReadLock(child, &child_version) || !Validate(node, version)) {
+      return false;
+    }
+    node = child;
+    version = child_version;
+  }
+}
+
+/*
+ * Visit the children in byte order. The bytes of the prefix and of each child
+ * are checked against the bounds as long as the path is a prefix of them;
+ * once it is not, the keys below are all in range on that side.
+ */
+bool ARTIndex::ScanNode(Node *node, std::string *path, const std::string &lo, bool lo_tight, const std::string *hi,
+                        bool hi_tight, std::vector<RID> *result, std::string *last) {
+  if (node->capacity_ == 0) {
+    auto leaf = static_cast<Leaf *>(node);
+    if (leaf->key_ >= lo && (last->empty() || leaf->key_ > *last) && (hi == nullptr || leaf->key_ <= *hi)) {
+      result->insert(result->end(), leaf->rids_.begin(), leaf->rids_.end());
+      *last = leaf->key_;
+    }
+    return true;
+  }
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  // Where the bytes of the path differ from a bound decides the side of all the keys below.
+  auto compare = [](const std::string &bound, size_t depth, uint8_t byte) {
+    return depth >= bound.size() ? 1 : static_cast<int>(byte) - static_cast<uint8_t>(bound[depth]);
+  };
+  const std::string &prefix = node->prefix_;
+  for (size_t i = 0; i < prefix.size() && (lo_tight || hi_tight); i++) {
+    const auto byte = static_cast<uint8_t>(prefix[i]);
+    if (lo_tight) {
+      const int cmp = compare(lo, path->size() + i, byte);
+      if (cmp < 0) {
+        return true;
+      }
+      lo_tight = cmp == 0;
+    }
+    if (hi_tight) {
+      const int cmp = compare(*hi, path->size() + i, byte);
+      if (cmp > 0) {
+        return true;
+      }
+      hi_tight = cmp == 0;
+    }
+  }
+  Children children;
+  GetChildren(node, &children);
+  if (!Validate(node, version)) {
+    return false;
+  }
+  const size_t depth = path->size();
+  path->append(prefix);
+  bool done = true;
+  for (size_t i = 0; i < children.size_ && done; i++) {
+    const uint8_t byte = children.bytes_[i];
+    bool child_lo_tight = lo_tight;
+    bool child_hi_tight = hi_tight;
+    if (lo_tight) {
+      const int cmp = compare(lo, path->size(), byte);
+      if (cmp < 0) {
+        continue;
+      }
+      child_lo_tight = cmp == 0;
+    }
+    if (hi_tight) {
+      const int cmp = compare(*hi, path->size(), byte);
+      if (cmp > 0) {
+        break;
+      }
+      child_hi_tight = cmp == 0;
+    }
+    path->push_back(static_cast<char>(byte));
+    done = ScanNode(children.nodes_[i], path, lo, child_lo_tight, hi, child_hi_tight, result, last);
+    path->pop_back();
+  }
+  path->resize(depth);
+  return done;
+}
+
+/*****************************************************************************
+ * NODES
+ *****************************************************************************/
+bool ARTIndex::ReadLock(Node *node, uint64_t *version) {
+  *version = node->version_.load();
+  return (*version & 3) == 0;
+}
+
+bool ARTIndex::Validate(Node *node, uint64_t version) { return node->version_.load() == version; }
+
+bool ARTIndex::UpgradeToWriteLock(Node *node, uint64_t version) {
+  return node->version_.compare_exchange_strong(version, version + 2);
+}
+
+void ARTIndex::WriteUnlock(Node *node) { node->version_.fetch_add(2); }
+
+void ARTIndex::WriteUnlockObsolete(Node *node) { node->version_.fetch_add(3); }
+
+ARTIndex::Node *ARTIndex::NewInner(size_t capacity, std::string prefix) {
+  switch (capacity) {
+    case 4:
+      return new SortedNode<4>(std::move(prefix));
+    case 16:
+      return new SortedNode<16>(std::move(prefix));
+    case 48:
+      return new Node48(std::move(prefix));
+    default:
+      return new Node256(std::move(prefix));
+  }
+}
+
+ARTIndex::Leaf *ARTIndex::NewLeaf(const std::string &key, std::vector<RID> rids) {
+  return new Leaf(key, std::move(rids));
+}
+
+namespace {
+
+template <typename SortedNodeType>
+int FindSlot(const SortedNodeType *node, uint8_t byte) {
+  for (size_t i = 0; i < node->Size(); i++) {
+    if (node->bytes_[i] == byte) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+template <typename SortedNodeType, typename NodeType>
+void AddSorted(SortedNodeType *node, uint8_t byte, NodeType *child) {
+  size_t slot = node->num_children_;
+  while (slot > 0 && node->bytes_[slot - 1] > byte) {
+    node->bytes_[slot] = node->bytes_[slot - 1];
+    node->children_[slot] = node->children_[slot - 1];
+    slot--;
+  }
+  node->bytes_[slot] = byte;
+  node->children_[slot] = child;
+}
+
+template <typename SortedNodeType>
+void RemoveSorted(SortedNodeType *node, uint8_t byte) {
+  const int slot = FindSlot(node, byte);
+  for (size_t i = slot; i + 1 < node->num_children_; i++) {
+    node->bytes_[i] = node->bytes_[i + 1];
+    node->children_[i] = node->children_[i + 1];
+  }
+}
+
+}  // namespace
+
+ARTIndex::Node *ARTIndex::FindChild(Node *node, uint8_t byte) {
+  switch (node->capacity_) {
+    case 4: {
+      auto sorted = static_cast<SortedNode<4> *>(node);
+      const int slot = FindSlot(sorted, byte);
+      return slot < 0 ? nullptr : sorted->children_[slot];
+    }
+    case 16: {
+      auto sorted = static_cast<SortedNode<16> *>(node);
+      const int slot = FindSlot(sorted, byte);
+      return slot < 0 ? nullptr : sorted->children_[slot];
+    }
+    case 48: {
+      auto node48 = static_cast<Node48 *>(node);
+      const uint8_t index = node48->indexes_[byte];
+      return index == 0 ? nullptr : node48->children_[index - 1];
+    }
+    default:
+      return static_cast<Node256 *>(node)->children_[byte];
+  }
+}
+
+void ARTIndex::AddChild(Node *node, uint8_t byte, Node *child) {
+  switch (node->capacity_) {
+    case 4:
+      AddSorted(static_cast<SortedNode<4> *>(node), byte, child);
+      break;
+    case 16:
+      AddSorted(static_cast<SortedNode<16> *>(node), byte, child);
+      break;
+    case 48: {
+      auto node48 = static_cast<Node48 *>(node);
+      uint8_t slot = 0;
+      while (node48->children_[slot] != nullptr) {
+        slot++;
+      }
+      node48->children_[slot] = child;
+      node48->indexes_[byte] = slot + 1;
+      break;
+    }
+    default:
+      static_cast<Node256 *>(node)->children_[byte] = child;
+      break;
+  }
+  node->num_children_++;
+}
+
+void ARTIndex::ReplaceChild(Node *node, uint8_t byte, Node *child) {
+  switch (node->capacity_) {
+    case 4: {
+      auto sorted = static_cast<SortedNode<4> *>(node);
+      sorted->children_[FindSlot(sorted, byte)] = child;
+      break;
+    }
+    case 16: {
+      auto sorted = static_cast<SortedNode<16> *>(node);
+      sorted->children_[FindSlot(sorted, byte)] = child;
+      break;
+    }
+    case 48: {
+      auto node48 = static_cast<Node48 *>(node);
+      node48->children_[node48->indexes_[byte] - 1] = child;
+      break;
+    }
+    default:
+      static_cast<Node256 *>(node)->children_[byte] = child;
+      break;
+  }
+}
+
+void ARTIndex::RemoveChild(Node *node, uint8_t byte) {
+  switch (node->capacity_) {
+    case 4:
+      RemoveSorted(static_cast<SortedNode<4> *>(node), byte);
+      break;
+    case 16:
+      RemoveSorted(static_cast<SortedNode<16> *>(node), byte);
+      break;
+    case 48: {
+      auto node48 = static_cast<Node48 *>(node);
+      node48->children_[node48->indexes_[byte] - 1] = nullptr;
+      node48->indexes_[byte] = 0;
+      break;
+    }
+    default:
+      static_cast<Node256 *>(node)->children_[byte] = nullptr;
+      break;
+  }
+  node->num_children_--;
+}
+
+void ARTIndex::GetChildren(Node *node, Children *children) {
+  children->size_ = 0;
+  auto add = [children](size_t byte, Node *child) {
+    children->bytes_[children->size_] = static_cast<uint8_t>(byte);
+    children->nodes_[children->size_] = child;
+    children->size_++;
+  };
+  switch (node->capacity_) {
+    case 4: {
+      auto sorted = static_cast<SortedNode<4> *>(node);
+      for (size_t i = 0; i < sorted->Size(); i++) {
+        add(sorted->bytes_[i], sorted->children_[i]);
+      }
+      break;
+    }
+    case 16: {
+      auto sorted = static_cast<SortedNode<16> *>(node);
+      for (size_t i = 0; i < sorted->Size(); i++) {
+        add(sorted->bytes_[i], sorted->children_[i]);
+      }
+      break;
+    }
+    case 48: {
+      auto node48 = static_cast<Node48 *>(node);
+      for (size_t byte = 0; byte < 256; byte++) {
+        // A torn index is caught by the version check of the reader.
+        if (const uint8_t index = node48->indexes_[byte]; index != 0 && index <= 48) {
+          add(byte, node48->children_[index - 1]);
+        }
+      }
+      break;
+    }
+    default: {
+      auto node256 = static_cast<Node256 *>(node);
+      for (size_t byte = 0; byte < 256; byte++) {
+        if (node256->children_[byte] != nullptr) {
+          add(byte, node256->children_[byte]);
+        }
+      }
+      break;
+    }
+  }
+}
+
+ARTIndex::Node *ARTIndex::CopyInner(Node *node, size_t capacity, std::string prefix) {
+  Children children;
+  GetChildren(node, &children);
+  Node *copy = NewInner(capacity, std::move(prefix));
+  for (size_t i = 0; i < children.size_; i++) {
+    AddChild(copy, children.bytes_[i], children.nodes_[i]);
+  }
+  return copy;
+}
+
+void ARTIndex::FreeNode(Node *node, bool recursive) {
+  if (recursive && node->capacity_ != 0) {
+    Children children;
+    GetChildren(node, &children);
+    for (size_t i = 0; i < children.size_; i++) {
+      FreeNode(children.nodes_[i], true);
+    }
+  }
+  switch (node->capacity_) {
+    case 0:
+      delete static_cast<Leaf *>(node);
+      break;
+    case 4:
+      delete static_cast<SortedNode<4> *>(node);
+      break;
+    case 16:
+      delete static_cast<SortedNode<16> *>(node);
+      break;
+    case 48:
+      delete static_cast<Node48 *>(node);
+      break;
+    default:
+      delete static_cast<Node256 *>(node);
+      break;
+  }
+}
+
+/*****************************************************************************
+ * EPOCHS
+ *****************************************************************************/
+/*
+ * An operation counts itself in the epoch it finds, and checks that the epoch
+ * did not move on meanwhile, or else tries again: the epoch only moves on once
+ * no operation runs in the epoch before, so operations only ever run in the
+ * current epoch and the one before.
+ */
+size_t ARTIndex::EnterEpoch() {
+  while (true) {
+    const size_t epoch = epoch_;
+    num_active_[epoch % 3]++;
+    if (epoch_ == epoch) {
+      return epoch;
+    }
+    num_active_[epoch % 3]--;
+  }
+}
+
+void ARTIndex::ExitEpoch(size_t epoch) { num_active_[epoch % 3]--; }
+
+/*
+ * A node retired in an epoch was unlinked before the next one began, so only
+ * the operations of that epoch and before may still read it. Moving from
+ * epoch e to e + 1 needs all the operations of e - 1 to be done, which the
+ * move from e - 1 to e needed of e - 2: the nodes of e - 2 are freed then.
+ */
+void ARTIndex::Retire(Node *node) {
+  std::vector<Node *> freed;
+  {
+    std::scoped_lock lock(retire_latch_);
+    const size_t epoch = epoch_;
+    retired_[epoch % 3].push_back(node);
+    if (num_active_[(epoch + 2) % 3] == 0) {
+      freed.swap(retired_[(epoch + 1) % 3]);
+      epoch_ = epoch + 1;
+    }
+  }
+  for (Node *retired : freed) {
+    FreeNode(retired, false);
+  }
+}
+
+}  // namespace bustub
@@ -9,7 +9,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -19,19 +24,47 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool unique_keys)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(std::min(internal_max_size, static_cast<int>(INTERNAL_PAGE_SIZE) - 1)),
+      unique_keys_(unique_keys),
+      extent_owner_(INVALID_PAGE_ID),
+      write_buffer_(KeyLess{&comparator_}) {
+  MetricsRegistry *registry = MetricsRegistry::Global();
+  registry->RegisterCounter(this, "b_plus_tree.splits", &num_splits_);
+  registry->RegisterCounter(this, "b_plus_tree.merges", &num_merges_);
+  registry->RegisterCounter(this, "b_plus_tree.restarts", &num_restarts_);
+  registry->RegisterCounter(this, "b_plus_tree.adaptive_hash_hits", &num_adaptive_hash_hits_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() {
+  StopCompactor();
+  FlushWriteBuffer();
+  MetricsRegistry::Global()->Unregister(this);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Open() {
+  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_page_id = INVALID_PAGE_ID;
+  const bool found = header_page->GetRootId(index_name_, &root_page_id);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+  root_latch_.WLock();
+  root_page_id_ = found ? root_page_id : INVALID_PAGE_ID;
+  root_latch_.WUnlock();
+  return found;
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -42,9 +75,527 @@ bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    return LookupEntry(key, result);
+  }
+  std::vector<ValueType> values;
+  write_buffer_latch_.RLock();
+  LookupEntry(key, &values);
+  ApplyMessages(key, &values);
+  write_buffer_latch_.RUnlock();
+  result->insert(result->end(), values.begin(), values.end());
+  return !values.empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupEntry(const KeyType &key, std::vector<ValueType> *result) {
+  if (adaptive_hash_size_ > 0 && LookupAdaptiveHash(key, result)) {
+    return true;
+  }
+  while (true) {
+    // Read before the search, so that a page deleted during it does not get an entry.
+    const uint64_t generation = adaptive_hash_generation_;
+    uint32_t version;
+    Page *page = FindLeafPageOptimistic(key, LeafSearch::KEY, &version);
+    if (page == nullptr) {
+      return false;
+    }
+    bool found;
+    if (LookupLeafOptimistic(key, page, version, generation, result, &found)) {
+      return found;
+    }
+    std::this_thread::yield();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupLeafOptimistic(const KeyType &key, Page *page, uint32_t version, uint64_t generation,
+                                          std::vector<ValueType> *result, bool *found) {
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType value;
+  *found = leaf->Lookup(key, &value, comparator_);
+  bool valid = leaf->ValidateVersion(version);
+  std::vector<ValueType> values;
+  if (valid && *found && !unique_keys_ && BPlusTreePostingPage::IsListRID(value)) {
+    valid = BPlusTreePostingPage::ReadList(buffer_pool_manager_, value.GetPageId(), &values,
+                                           [leaf, version] { return leaf->ValidateVersion(version); });
+  } else if (*found) {
+    values.push_back(value);
+  }
+  if (valid && *found && adaptive_hash_size_ > 0) {
+    RecordAdaptiveHash(key, page->GetPageId(), leaf->KeyIndex(key, comparator_), version, generation);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if (valid) {
+    result->insert(result->end(), values.begin(), values.end());
+  }
+  return valid;
+}
+
+/*
+ * Look up sorted keys. The leaf pages are read latched and crabbed from left
+ * to right like index iterators do. A key past the next leaf page is searched
+ * from the root instead, which skips the pages in between.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                                 Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    return LookupEntries(keys, results);
+  }
+  write_buffer_latch_.RLock();
+  LookupEntries(keys, results);
+  size_t num_found = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    ApplyMessages(keys[i], &(*results)[i]);
+    num_found += (*results)[i].empty() ? 0 : 1;
+  }
+  write_buffer_latch_.RUnlock();
+  return num_found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::LookupEntries(const std::vector<KeyType> &keys,
+                                     std::vector<std::vector<ValueType>> *results) {
+  results->resize(keys.size());
+  size_t num_found = 0;
+  Page *page = nullptr;
+  for (size_t i = 0; i < keys.size(); i++) {
+    const KeyType &key = keys[i];
+    // Whether the key is past the last one of the leaf page, which is not the last page.
+    auto is_past = [this, &key](Page *leaf_page) {
+      auto leaf = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+      return leaf->GetNextPageId() != INVALID_PAGE_ID &&
+             (leaf->GetSize() == 0 || comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) > 0);
+    };
+    if (page == nullptr) {
+      page = FindLeafPage(key);
+    } else if (is_past(page)) {
+      Page *next_page = FetchTreePage(reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId());
+      next_page->RLatch();
+      ReleaseReadPage(page);
+      page = next_page;
+      if (is_past(page)) {
+        ReleaseReadPage(page);
+        page = FindLeafPage(key);
+      }
+    }
+    if (page == nullptr) {
+      // The tree is empty.
+      return num_found;
+    }
+    if (LookupLatched(reinterpret_cast<LeafPage *>(page->GetData()), key, &(*results)[i])) {
+      num_found++;
+    }
+  }
+  if (page != nullptr) {
+    ReleaseReadPage(page);
+  }
+  return num_found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::GetValuesInterleaved(const std::vector<KeyType> &keys,
+                                            std::vector<std::vector<ValueType>> *results, Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    return LookupEntriesInterleaved(keys, results);
+  }
+  write_buffer_latch_.RLock();
+  LookupEntriesInterleaved(keys, results);
+  size_t num_found = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    ApplyMessages(keys[i], &(*results)[i]);
+    num_found += (*results)[i].empty() ? 0 : 1;
+  }
+  write_buffer_latch_.RUnlock();
+  return num_found;
+}
+
+/*
+ * The searches in flight are kept in a small array and stepped round-robin;
+ * a search that is done hands its slot to the next key, and the last search
+ * moves into the slot of a done one once the keys run out. The searches are
+ * optimistic like FindLeafPageOptimistic, each holding only a pin on the page
+ * it is at between its steps, so that they never wait on each other's latches.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::LookupEntriesInterleaved(const std::vector<KeyType> &keys,
+                                                std::vector<std::vector<ValueType>> *results) {
+  results->assign(keys.size(), {});
+  size_t num_found = 0;
+  size_t next_key = 0;
+  // Hands the next key to a search, past the keys the adaptive hash index finds. @return false if none is left
+  auto start = [&](InterleavedLookup *lookup) {
+    while (next_key < keys.size()) {
+      const size_t i = next_key++;
+      if (adaptive_hash_size_ > 0 && LookupAdaptiveHash(keys[i], &(*results)[i])) {
+        num_found++;
+        continue;
+      }
+      *lookup = {i, nullptr, 0, nullptr, 0, 0};
+      return true;
+    }
+    return false;
+  };
+  InterleavedLookup lookups[INTERLEAVED_LOOKUPS];
+  size_t num_lookups = 0;
+  while (num_lookups < INTERLEAVED_LOOKUPS && start(&lookups[num_lookups])) {
+    num_lookups++;
+  }
+  try {
+    while (num_lookups > 0) {
+      for (size_t i = 0; i < num_lookups;) {
+        InterleavedLookup *lookup = &lookups[i];
+        bool found;
+        if (!StepLookup(keys[lookup->key_index_], lookup, &(*results)[lookup->key_index_], &found)) {
+          i++;
+          continue;
+        }
+        num_found += found ? 1 : 0;
+        if (start(lookup)) {
+          i++;
+        } else {
+          *lookup = lookups[--num_lookups];
+        }
+      }
+    }
+  } catch (const Exception &e) {
+    for (size_t i = 0; i < num_lookups; i++) {
+      for (Page *page : {lookups[i].page_, lookups[i].parent_}) {
+        if (page != nullptr) {
+          buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        }
+      }
+    }
+    throw;
+  }
+  return num_found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::StepLookup(const KeyType &key, InterleavedLookup *lookup, std::vector<ValueType> *result,
+                                bool *found) {
+  auto restart = [this, lookup] {
+    if (lookup->parent_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(lookup->parent_->GetPageId(), false);
+      lookup->parent_ = nullptr;
+    }
+    buffer_pool_manager_->UnpinPage(lookup->page_->GetPageId(), false);
+    lookup->page_ = nullptr;
+    num_restarts_.Add();
+  };
+  if (lookup->page_ == nullptr) {
+    // Read before the search, so that a page deleted during it does not get an entry.
+    lookup->generation_ = adaptive_hash_generation_;
+    const page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      *found = false;
+      return true;
+    }
+    lookup->page_ = FetchTreePage(root_page_id);
+    lookup->version_ = reinterpret_cast<BPlusTreePage *>(lookup->page_->GetData())->GetVersion();
+    // A page that is no longer the root covers only part of the keys.
+    if (!BPlusTreePage::IsStable(lookup->version_) || root_page_id_ != root_page_id) {
+      restart();
+    }
+    return false;
+  }
+
+  auto node = reinterpret_cast<BPlusTreePage *>(lookup->page_->GetData());
+  if (lookup->parent_ != nullptr) {
+    // The page was fetched and prefetched by the last step; the parent is validated again after its version is read,
+    // as by FindLeafPageOptimistic.
+    lookup->version_ = node->GetVersion();
+    const bool valid = BPlusTreePage::IsStable(lookup->version_) &&
+                       reinterpret_cast<BPlusTreePage *>(lookup->parent_->GetData())->ValidateVersion(
+                           lookup->parent_version_);
+    buffer_pool_manager_->UnpinPage(lookup->parent_->GetPageId(), false);
+    lookup->parent_ = nullptr;
+    if (!valid) {
+      restart();
+      return false;
+    }
+  }
+  if (node->IsLeafPage()) {
+    Page *page = lookup->page_;
+    lookup->page_ = nullptr;
+    if (LookupLeafOptimistic(key, page, lookup->version_, lookup->generation_, result, found)) {
+      return true;
+    }
+    num_restarts_.Add();
+    return false;
+  }
+  auto internal = reinterpret_cast<InternalPage *>(node);
+  const int child_index = internal->LookupIndex(key, comparator_);
+  const page_id_t child_page_id = internal->ValueAt(child_index);
+  if (!node->ValidateVersion(lookup->version_)) {
+    restart();
+    return false;
+  }
+  Page *child_page = FetchChildTreePage(lookup->page_, child_index, child_page_id);
+  // The header and the middle of the page, where the binary search of its keys starts, are read by the next step.
+  __builtin_prefetch(child_page->GetData());
+  __builtin_prefetch(child_page->GetData() + PAGE_SIZE / 2);
+  lookup->parent_ = lookup->page_;
+  lookup->parent_version_ = lookup->version_;
+  lookup->page_ = child_page;
   return false;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupLatched(LeafPage *leaf, const KeyType &key, std::vector<ValueType> *result) {
+  ValueType value;
+  if (!leaf->Lookup(key, &value, comparator_)) {
+    return false;
+  }
+  if (!unique_keys_ && BPlusTreePostingPage::IsListRID(value)) {
+    BPlusTreePostingPage::ReadList(buffer_pool_manager_, value.GetPageId(), result, [] { return true; });
+  } else {
+    result->push_back(value);
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * ADAPTIVE HASH INDEX
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetAdaptiveHashIndex(size_t num_entries) {
+  adaptive_hash_size_ = num_entries;
+  adaptive_hash_ = num_entries == 0 ? nullptr : std::make_unique<AdaptiveHashEntry[]>(num_entries);
+}
+
+/*
+ * The entry is copied out under its latch, and the leaf page read like an
+ * optimistic search reads it: at the version the entry recorded, validated
+ * again once read. The page is pinned before the generation is checked, so
+ * that it cannot be deleted and reused in between.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::LookupAdaptiveHash(const KeyType &key, std::vector<ValueType> *result) {
+  AdaptiveHashEntry &entry = GetAdaptiveHashEntry(key);
+  page_id_t page_id;
+  int slot;
+  uint32_t version;
+  uint64_t generation;
+  {
+    std::scoped_lock lock(entry.latch_);
+    if (entry.page_id_ == INVALID_PAGE_ID || comparator_(entry.key_, key) != 0) {
+      return false;
+    }
+    page_id = entry.page_id_;
+    slot = entry.slot_;
+    version = entry.version_;
+    generation = entry.generation_;
+  }
+  // An evicted page would take a read from disk, which the search through the tree might as well pay for.
+  if (!buffer_pool_manager_->IsPageResident(page_id)) {
+    return false;
+  }
+  Page *page = FetchTreePage(page_id);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  bool valid = leaf->ValidateVersion(version) && adaptive_hash_generation_ == generation;
+  ValueType value;
+  if (valid) {
+    value = leaf->GetItem(slot).second;
+    valid = leaf->ValidateVersion(version);
+  }
+  std::vector<ValueType> values;
+  if (valid && !unique_keys_ && BPlusTreePostingPage::IsListRID(value)) {
+    valid = BPlusTreePostingPage::ReadList(buffer_pool_manager_, value.GetPageId(), &values,
+                                           [leaf, version] { return leaf->ValidateVersion(version); });
+  } else if (valid) {
+    values.push_back(value);
+  }
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  if (!valid) {
+    return false;
+  }
+  result->insert(result->end(), values.begin(), values.end());
+  num_adaptive_hash_hits_.Add();
+  return true;
+}
+
+/*
+ * Keys whose hashes collide share an entry. A lookup of another key than that
+ * of the entry takes one hit away from it, and takes the entry over once it
+ * has none left, so that the key looked up most keeps the entry.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RecordAdaptiveHash(const KeyType &key, page_id_t page_id, int slot, uint32_t version,
+                                        uint64_t generation) {
+  AdaptiveHashEntry &entry = GetAdaptiveHashEntry(key);
+  std::scoped_lock lock(entry.latch_);
+  if (entry.hits_ == 0 || comparator_(entry.key_, key) != 0) {
+    if (entry.hits_ > 0 && --entry.hits_ > 0) {
+      return;
+    }
+    entry.key_ = key;
+    entry.page_id_ = INVALID_PAGE_ID;
+  }
+  entry.hits_ = std::min(entry.hits_ + 1, 2 * ADAPTIVE_HASH_THRESHOLD);
+  if (entry.hits_ >= ADAPTIVE_HASH_THRESHOLD) {
+    entry.page_id_ = page_id;
+    entry.slot_ = slot;
+    entry.version_ = version;
+    entry.generation_ = generation;
+  }
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build the tree from sorted key & value pairs. The number of pages of every
+ * level is known up front, so the levels are all built in the same pass: each
+ * level has one open page, and opening a page adds it to the open page of the
+ * level above, opening that one first if it is full. Only the open pages are
+ * pinned, and the pages of each level are allocated left to right.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoad(BulkLoadIterator begin, BulkLoadIterator end, double fill_factor,
+                              Transaction *transaction) {
+  FlushWriteBuffer();
+  root_latch_.WLock();
+  if (!IsEmpty()) {
+    root_latch_.WUnlock();
+    for (auto iter = begin; iter != end; ++iter) {
+      Insert(iter->first, iter->second, transaction);
+    }
+    return;
+  }
+  int64_t num_entries = 0;
+  // The separators in the internal pages are no longer than the keys they separate.
+  size_t max_key_size = 0;
+  for (auto iter = begin; iter != end; ++iter) {
+    if (iter == begin || comparator_(std::prev(iter)->first, iter->first) != 0) {
+      num_entries++;
+      max_key_size = std::max<size_t>(max_key_size, InternalPage::StoredKeySize(iter->first));
+    }
+  }
+  if (num_entries == 0) {
+    root_latch_.WUnlock();
+    return;
+  }
+
+  // A leaf page holds at most max size - 1 pairs, an internal page max size children, as far as their keys fit.
+  const int leaf_min_size = std::max(1, leaf_max_size_ / 2);
+  const int leaf_fill = std::clamp(static_cast<int>(fill_factor * (leaf_max_size_ - 1)), leaf_min_size,
+                                   std::max(leaf_min_size, leaf_max_size_ - 1));
+  const int internal_capacity = std::min(internal_max_size_, InternalPage::Capacity(max_key_size));
+  const int internal_min_size = std::max(2, std::min((internal_max_size_ + 1) / 2, internal_capacity / 2));
+  const int internal_fill =
+      std::clamp(static_cast<int>(fill_factor * internal_capacity), internal_min_size, internal_capacity);
+  std::vector<BulkLoadLevel> levels;
+  levels.push_back({num_entries, BulkLoadNumPages(num_entries, leaf_fill, leaf_min_size), 0, 0, nullptr});
+  while (levels.back().num_pages_ > 1) {
+    const int64_t num_children = levels.back().num_pages_;
+    levels.push_back(
+        {num_children, BulkLoadNumPages(num_children, internal_fill, internal_min_size), 0, 0, nullptr});
+  }
+
+  for (auto iter = begin; iter != end; ++iter) {
+    if (iter != begin && comparator_(std::prev(iter)->first, iter->first) == 0) {
+      continue;
+    }
+    if (levels[0].remaining_entries_ == 0) {
+      // The first key in a page is never looked at, the others separate the leaf from the previous one.
+      BulkLoadOpenPage(&levels, 0,
+                       iter == begin ? KeyType{} : comparator_.ShortestSeparator(std::prev(iter)->first, iter->first));
+    }
+    ValueType value = iter->second;
+    if (!unique_keys_ && std::next(iter) != end && comparator_(std::next(iter)->first, iter->first) == 0) {
+      auto run_end = std::next(iter);
+      while (run_end != end && comparator_(run_end->first, iter->first) == 0) {
+        ++run_end;
+      }
+      value = BPlusTreePostingPage::ListRID(BulkLoadPostingList(iter, run_end, levels[0].page_->GetPageId()));
+    }
+    reinterpret_cast<LeafPage *>(levels[0].page_->GetData())->Insert(iter->first, value, comparator_);
+    levels[0].remaining_entries_--;
+  }
+  for (auto &level : levels) {
+    buffer_pool_manager_->UnpinPage(level.page_->GetPageId(), true);
+  }
+  // Readers cannot reach any of the pages before the root is published.
+  root_page_id_ = levels.back().page_->GetPageId();
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int64_t BPLUSTREE_TYPE::BulkLoadNumPages(int64_t num_entries, int fill, int min_size) {
+  // Spread evenly over at most num_entries / min_size pages, no page gets fewer than min size entries.
+  return std::max<int64_t>(1, std::min((num_entries + fill - 1) / fill, num_entries / min_size));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadOpenPage(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key) {
+  BulkLoadLevel &current = (*levels)[level];
+  page_id_t page_id;
+  Page *page = AllocatePage(&page_id, current.page_ == nullptr ? INVALID_PAGE_ID : current.page_->GetPageId());
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new b+ tree page");
+  }
+  if (extent_owner_ == INVALID_PAGE_ID) {
+    extent_owner_ = page_id;
+  }
+  const page_id_t parent_page_id =
+      level + 1 < levels->size() ? BulkLoadAddChild(levels, level + 1, key, page_id) : INVALID_PAGE_ID;
+  if (level == 0) {
+    if (current.page_ != nullptr) {
+      reinterpret_cast<LeafPage *>(current.page_->GetData())->SetNextPageId(page_id);
+    }
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    leaf->Init(page_id, parent_page_id, leaf_max_size_);
+    leaf->SetPrevPageId(current.page_ == nullptr ? INVALID_PAGE_ID : current.page_->GetPageId());
+  } else {
+    reinterpret_cast<InternalPage *>(page->GetData())->Init(page_id, parent_page_id, internal_max_size_);
+  }
+  if (current.page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(current.page_->GetPageId(), true);
+  }
+  current.page_ = page;
+  const int64_t page_index = current.num_opened_pages_++;
+  current.remaining_entries_ =
+      current.num_entries_ / current.num_pages_ + (page_index < current.num_entries_ % current.num_pages_ ? 1 : 0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::BulkLoadAddChild(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key,
+                                           page_id_t child_page_id) {
+  if ((*levels)[level].remaining_entries_ == 0) {
+    BulkLoadOpenPage(levels, level, key);
+  }
+  BulkLoadLevel &current = (*levels)[level];
+  reinterpret_cast<InternalPage *>(current.page_->GetData())->Append(key, child_page_id);
+  current.remaining_entries_--;
+  return current.page_->GetPageId();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::BulkLoadPostingList(BulkLoadIterator begin, BulkLoadIterator end, page_id_t hint) {
+  BPlusTreePostingPage *first = NewPostingPage(hint, INVALID_PAGE_ID);
+  BPlusTreePostingPage *posting = first;
+  for (auto iter = begin; iter != end; ++iter) {
+    if (posting->IsFull()) {
+      BPlusTreePostingPage *next = NewPostingPage(posting->GetPageId(), INVALID_PAGE_ID);
+      posting->SetNextPageId(next->GetPageId());
+      if (posting != first) {
+        buffer_pool_manager_->UnpinPage(posting->GetPageId(), true);
+      }
+      posting = next;
+    }
+    posting->Append(iter->second);
+  }
+  if (posting != first) {
+    buffer_pool_manager_->UnpinPage(posting->GetPageId(), true);
+  }
+  const page_id_t first_page_id = first->GetPageId();
+  buffer_pool_manager_->UnpinPage(first_page_id, true);
+  return first_page_id;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -52,11 +603,46 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: with unique keys, if user try to insert duplicate keys return
+ * false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) { return false; }
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    return InsertEntry(key, value, transaction);
+  }
+  write_buffer_latch_.WLock();
+  if (unique_keys_) {
+    // The key may be in the leaves as well as in the buffer, and the buffered messages may have removed it since.
+    std::vector<ValueType> values;
+    LookupEntry(key, &values);
+    ApplyMessages(key, &values);
+    if (!values.empty()) {
+      write_buffer_latch_.WUnlock();
+      return false;
+    }
+  }
+  BufferMessage(key, MessageType::INSERT, value);
+  write_buffer_latch_.WUnlock();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertEntry(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  std::unique_ptr<Transaction> local_transaction;
+  if (transaction == nullptr) {
+    local_transaction = std::make_unique<Transaction>(INVALID_TXN_ID);
+    transaction = local_transaction.get();
+  }
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (IsEmpty()) {
+    StartNewTree(key, value);
+    ReleaseWritePages(transaction);
+    return true;
+  }
+  return InsertIntoLeaf(key, value, transaction);
+}
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -64,19 +650,148 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = AllocatePage(&page_id, INVALID_PAGE_ID);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new root page");
+  }
+  if (extent_owner_ == INVALID_PAGE_ID) {
+    extent_owner_ = page_id;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  leaf->Insert(key, value, comparator_);
+  // Readers cannot reach the page before it is published as the root.
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: with unique keys, if user try to insert duplicate keys return
+ * false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  return false;
+  auto leaf =
+      reinterpret_cast<LeafPage *>(FindLeafPageForWrite(key, WriteOperation::INSERT, transaction)->GetData());
+  const int index = leaf->KeyIndex(key, comparator_);
+  if (index < leaf->GetSize() && comparator_(leaf->KeyAt(index), key) == 0) {
+    if (unique_keys_) {
+      ReleaseWritePages(transaction);
+      return false;
+    }
+    // The leaf page gets a new version, the posting list it guards is about to change.
+    leaf->BeginWrite();
+    AddToPostingList(leaf, index, value);
+    ReleaseWritePages(transaction);
+    return true;
+  }
+  leaf->BeginWrite();
+  if (leaf->Insert(key, value, comparator_) >= leaf->GetMaxSize()) {
+    LeafPage *new_leaf = Split(leaf, transaction);
+    new_leaf->SetNextPageId(leaf->GetNextPageId());
+    new_leaf->SetPrevPageId(leaf->GetPageId());
+    leaf->SetNextPageId(new_leaf->GetPageId());
+    if (new_leaf->GetNextPageId() != INVALID_PAGE_ID) {
+      UpdatePrevPageId(new_leaf->GetNextPageId(), new_leaf->GetPageId());
+    }
+    // Any key between the two leaves separates them; the shortest one takes the least room in the parent.
+    InsertIntoParent(leaf, comparator_.ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)),
+                     new_leaf, transaction);
+  }
+  ReleaseWritePages(transaction);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreePostingPage *BPLUSTREE_TYPE::NewPostingPage(page_id_t hint, page_id_t next_page_id) {
+  page_id_t page_id;
+  Page *page = AllocatePage(&page_id, hint);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new posting page");
+  }
+  auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  posting->Init(page_id, next_page_id);
+  return posting;
+}
+
+/*
+ * New values go into the first posting page, and once it is full, into a new
+ * first page; thus all of the pages but the first are full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AddToPostingList(LeafPage *leaf, int index, const ValueType &value) {
+  const ValueType current = leaf->GetItem(index).second;
+  if (!BPlusTreePostingPage::IsListRID(current)) {
+    BPlusTreePostingPage *posting = NewPostingPage(leaf->GetPageId(), INVALID_PAGE_ID);
+    posting->Append(current);
+    posting->Append(value);
+    leaf->SetValueAt(index, BPlusTreePostingPage::ListRID(posting->GetPageId()));
+    buffer_pool_manager_->UnpinPage(posting->GetPageId(), true);
+    return;
+  }
+  Page *page = FetchTreePage(current.GetPageId());
+  auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  if (posting->IsFull()) {
+    BPlusTreePostingPage *first = NewPostingPage(page->GetPageId(), page->GetPageId());
+    first->Append(value);
+    leaf->SetValueAt(index, BPlusTreePostingPage::ListRID(first->GetPageId()));
+    buffer_pool_manager_->UnpinPage(first->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return;
+  }
+  posting->Append(value);
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+}
+
+/*
+ * The value is replaced with the last one of the first page, so that the other
+ * pages stay full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value,
+                                           Transaction *transaction) {
+  const page_id_t first_page_id = leaf->GetItem(index).second.GetPageId();
+  Page *first_page = FetchTreePage(first_page_id);
+  auto first = reinterpret_cast<BPlusTreePostingPage *>(first_page->GetData());
+  int value_index = first->ValueIndex(value);
+  if (value_index >= 0) {
+    leaf->BeginWrite();
+    first->RemoveAt(value_index);
+  } else {
+    page_id_t page_id = first->GetNextPageId();
+    while (page_id != INVALID_PAGE_ID && value_index < 0) {
+      Page *page = FetchTreePage(page_id);
+      auto posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+      value_index = posting->ValueIndex(value);
+      if (value_index >= 0) {
+        leaf->BeginWrite();
+        posting->SetValueAt(value_index, first->RemoveLast());
+      }
+      page_id = posting->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), value_index >= 0);
+    }
+    if (value_index < 0) {
+      buffer_pool_manager_->UnpinPage(first_page_id, false);
+      return false;
+    }
+  }
+  if (first->GetSize() == 0) {
+    // The next page, full, becomes the first one.
+    leaf->SetValueAt(index, BPlusTreePostingPage::ListRID(first->GetNextPageId()));
+    transaction->AddIntoDeletedPageSet(first_page_id);
+  } else if (first->GetSize() == 1 && first->GetNextPageId() == INVALID_PAGE_ID) {
+    leaf->SetValueAt(index, first->ValueAt(0));
+    transaction->AddIntoDeletedPageSet(first_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(first_page_id, true);
+  return true;
 }
 
 /*
@@ -88,8 +803,18 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-N *BPLUSTREE_TYPE::Split(N *node) {
-  return nullptr;
+N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction) {
+  num_splits_.Add();
+  page_id_t page_id;
+  auto new_node = reinterpret_cast<N *>(NewTreePage(&page_id, node->GetPageId(), transaction)->GetData());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    new_node->Init(page_id, node->GetParentPageId(), leaf_max_size_);
+    node->MoveHalfTo(new_node);
+  } else {
+    new_node->Init(page_id, node->GetParentPageId(), internal_max_size_);
+    node->MoveHalfTo(new_node, buffer_pool_manager_);
+  }
+  return new_node;
 }
 
 /*
@@ -103,7 +828,30 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_page_id;
+    Page *root_page = NewTreePage(&root_page_id, old_node->GetPageId(), transaction);
+    auto root = reinterpret_cast<InternalPage *>(root_page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    return;
+  }
+  // The parent is write latched in the page set already; this only takes another pin.
+  Page *parent_page = FetchTreePage(old_node->GetParentPageId());
+  auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  parent->BeginWrite();
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->IsOverflowing()) {
+    InternalPage *new_parent = Split(parent, transaction);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,7 +864,242 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    RemoveEntry(key, nullptr, transaction);
+    return;
+  }
+  write_buffer_latch_.WLock();
+  BufferMessage(key, MessageType::REMOVE, ValueType{});
+  write_buffer_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (write_buffer_capacity_ == 0) {
+    RemoveEntry(key, &value, transaction);
+    return;
+  }
+  write_buffer_latch_.WLock();
+  BufferMessage(key, MessageType::REMOVE_VALUE, value);
+  write_buffer_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  std::unique_ptr<Transaction> local_transaction;
+  if (transaction == nullptr) {
+    local_transaction = std::make_unique<Transaction>(INVALID_TXN_ID);
+    transaction = local_transaction.get();
+  }
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (IsEmpty()) {
+    ReleaseWritePages(transaction);
+    return;
+  }
+  auto leaf =
+      reinterpret_cast<LeafPage *>(FindLeafPageForWrite(key, WriteOperation::REMOVE, transaction)->GetData());
+  const int index = leaf->KeyIndex(key, comparator_);
+  if (index >= leaf->GetSize() || comparator_(leaf->KeyAt(index), key) != 0) {
+    ReleaseWritePages(transaction);
+    return;
+  }
+  const ValueType current = leaf->GetItem(index).second;
+  const bool has_list = !unique_keys_ && BPlusTreePostingPage::IsListRID(current);
+  if (has_list && value != nullptr) {
+    // The key stays as long as it has a value left.
+    RemoveFromPostingList(leaf, index, *value, transaction);
+    ReleaseWritePages(transaction);
+    return;
+  }
+  if (value == nullptr || current == *value) {
+    for (page_id_t page_id = has_list ? current.GetPageId() : INVALID_PAGE_ID; page_id != INVALID_PAGE_ID;) {
+      Page *page = FetchTreePage(page_id);
+      transaction->AddIntoDeletedPageSet(page_id);
+      page_id = reinterpret_cast<BPlusTreePostingPage *>(page->GetData())->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    leaf->BeginWrite();
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    CoalesceOrRedistribute(leaf, transaction);
+    // Left below its min size by the merge watermark, for Compact to deal with; the leaf is not merged if it is empty.
+    if (merge_watermark_ != 0 && !leaf->IsRootPage() && leaf->GetSize() > 0 && leaf->GetSize() < leaf->GetMinSize()) {
+      std::lock_guard<std::mutex> compactor_guard(compactor_latch_);
+      if (sparse_leaves_.size() < MAX_SPARSE_LEAVES) {
+        sparse_leaves_.push_back(key);
+        if (sparse_leaves_.size() == COMPACTOR_BATCH_SIZE) {
+          compactor_cv_.notify_one();
+        }
+      }
+    }
+  }
+  ReleaseWritePages(transaction);
+}
+
+/*****************************************************************************
+ * WRITE BUFFER
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetWriteBuffer(size_t capacity) {
+  write_buffer_latch_.WLock();
+  write_buffer_capacity_ = capacity;
+  if (write_buffer_.size() >= capacity) {
+    FlushWriteBufferLatched();
+  }
+  write_buffer_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushWriteBuffer() {
+  if (write_buffer_capacity_ == 0) {
+    return;
+  }
+  write_buffer_latch_.WLock();
+  FlushWriteBufferLatched();
+  write_buffer_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BufferMessage(const KeyType &key, MessageType type, const ValueType &value) {
+  // A multimap inserts after the equal keys, which keeps the messages of a key in order.
+  write_buffer_.emplace(key, Message{type, value});
+  if (write_buffer_.size() >= write_buffer_capacity_) {
+    FlushWriteBufferLatched();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ApplyMessages(const KeyType &key, std::vector<ValueType> *values) const {
+  auto [first, last] = write_buffer_.equal_range(key);
+  for (auto iter = first; iter != last; ++iter) {
+    const Message &message = iter->second;
+    switch (message.type_) {
+      case MessageType::INSERT:
+        // As InsertEntry does, an insert into a tree with unique keys is dropped if the key is there.
+        if (!unique_keys_ || values->empty()) {
+          values->push_back(message.value_);
+        }
+        break;
+      case MessageType::REMOVE:
+        values->clear();
+        break;
+      case MessageType::REMOVE_VALUE:
+        if (auto pos = std::find(values->begin(), values->end(), message.value_); pos != values->end()) {
+          values->erase(pos);
+        }
+        break;
+    }
+  }
+}
+
+/*
+ * Apply the messages in key order: consecutive messages mostly go to the
+ * same leaf page, which the first of them brings into the buffer pool.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FlushWriteBufferLatched() {
+  for (const auto &[key, message] : write_buffer_) {
+    switch (message.type_) {
+      case MessageType::INSERT:
+        InsertEntry(key, message.value_, nullptr);
+        break;
+      case MessageType::REMOVE:
+        RemoveEntry(key, nullptr, nullptr);
+        break;
+      case MessageType::REMOVE_VALUE:
+        RemoveEntry(key, &message.value_, nullptr);
+        break;
+    }
+  }
+  write_buffer_.clear();
+}
+
+/*
+ * Rebalance the leaf pages removes left sparse, in key order so that the
+ * pages around them are found in memory. A key stands for whichever leaf page
+ * holds it by now, which may have been filled again or merged meanwhile.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::Compact(size_t max_leaves) {
+  std::vector<KeyType> keys;
+  {
+    std::lock_guard<std::mutex> compactor_guard(compactor_latch_);
+    const size_t num_keys = std::min(max_leaves, sparse_leaves_.size());
+    keys.assign(sparse_leaves_.end() - num_keys, sparse_leaves_.end());
+    sparse_leaves_.resize(sparse_leaves_.size() - num_keys);
+  }
+  std::sort(keys.begin(), keys.end(), [this](const KeyType &a, const KeyType &b) { return comparator_(a, b) < 0; });
+  size_t num_compacted = 0;
+  for (const KeyType &key : keys) {
+    // Rebalancing moves one pair at a time, merging ends it; give up on a leaf page that cannot change.
+    bool compacted = false;
+    while (CompactLeaf(key)) {
+      compacted = true;
+    }
+    num_compacted += compacted ? 1 : 0;
+  }
+  return num_compacted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::CompactLeaf(const KeyType &key) {
+  Transaction transaction(INVALID_TXN_ID);
+  root_latch_.WLock();
+  transaction.AddIntoPageSet(nullptr);
+  if (IsEmpty()) {
+    ReleaseWritePages(&transaction);
+    return false;
+  }
+  auto leaf =
+      reinterpret_cast<LeafPage *>(FindLeafPageForWrite(key, WriteOperation::COMPACT, &transaction)->GetData());
+  bool compacted = false;
+  if (!leaf->IsRootPage() && leaf->GetSize() < leaf->GetMinSize()) {
+    const int size = leaf->GetSize();
+    leaf->BeginWrite();
+    CoalesceOrRedistribute(leaf, &transaction, true);
+    compacted = leaf->GetSize() != size || !transaction.GetDeletedPageSet()->empty();
+  }
+  ReleaseWritePages(&transaction);
+  return compacted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartCompactor(std::chrono::milliseconds interval, size_t batch_size) {
+  std::lock_guard<std::mutex> compactor_guard(compactor_latch_);
+  if (compactor_thread_.joinable()) {
+    return;
+  }
+  compactor_stop_ = false;
+  compactor_thread_ = std::thread(&BPLUSTREE_TYPE::RunCompactor, this, interval, batch_size);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StopCompactor() {
+  {
+    std::lock_guard<std::mutex> compactor_guard(compactor_latch_);
+    compactor_stop_ = true;
+  }
+  compactor_cv_.notify_all();
+  if (compactor_thread_.joinable()) {
+    compactor_thread_.join();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RunCompactor(std::chrono::milliseconds interval, size_t batch_size) {
+  std::unique_lock<std::mutex> compactor_lock(compactor_latch_);
+  while (!compactor_stop_) {
+    compactor_cv_.wait_for(compactor_lock, interval,
+                           [&] { return compactor_stop_ || sparse_leaves_.size() >= batch_size; });
+    if (compactor_stop_ || sparse_leaves_.empty()) {
+      continue;
+    }
+    compactor_lock.unlock();
+    Compact(batch_size);
+    compactor_lock.lock();
+  }
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
@@ -127,8 +1110,51 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, bool compacting) {
+  if (node->IsRootPage()) {
+    if (AdjustRoot(node)) {
+      transaction->AddIntoDeletedPageSet(node->GetPageId());
+      return true;
+    }
+    return false;
+  }
+  bool underflowing;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    underflowing = node->GetSize() < (compacting ? node->GetMinSize() : GetMergeSize(node));
+  } else {
+    underflowing = node->IsUnderflowing();
+  }
+  if (!underflowing) {
+    return false;
+  }
+  Page *parent_page = FetchTreePage(node->GetParentPageId());
+  auto parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  const int index = parent->ValueIndex(node->GetPageId());
+  // Writers only get to the sibling through the parent, which is latched, so the sibling latch is free or about to be.
+  Page *neighbor_page = FetchTreePage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  neighbor_page->WLatch();
+  transaction->AddIntoPageSet(neighbor_page);
+  auto neighbor = reinterpret_cast<N *>(neighbor_page->GetData());
+  neighbor->BeginWrite();
+  parent->BeginWrite();
+  bool fits;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    // A leaf splits as soon as it is full.
+    fits = neighbor->GetSize() + node->GetSize() < node->GetMaxSize();
+  } else {
+    fits = node->CanMergeWith(neighbor);
+  }
+  bool deleted = false;
+  if (fits) {
+    const bool node_is_left = index == 0;
+    Coalesce(&neighbor, &node, &parent, index, transaction);
+    deleted = !node_is_left;
+  } else {
+    // If the new separator does not fit in the parent, the node is left underflowing, which costs space but no more.
+    Redistribute(neighbor, node, parent, index);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+  return deleted;
 }
 
 /*
@@ -148,7 +1174,24 @@ template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) {
-  return false;
+  // Always move the right page into the left one, so that leaf pages are only ever deleted by merging them into their
+  // left sibling.
+  if (index == 0) {
+    std::swap(*neighbor_node, *node);
+    index = 1;
+  }
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    (*node)->MoveAllTo(*neighbor_node);
+    if ((*neighbor_node)->GetNextPageId() != INVALID_PAGE_ID) {
+      UpdatePrevPageId((*neighbor_node)->GetNextPageId(), (*neighbor_node)->GetPageId());
+    }
+  } else {
+    (*node)->MoveAllTo(*neighbor_node, (*parent)->KeyAt(index), buffer_pool_manager_);
+  }
+  transaction->AddIntoDeletedPageSet((*node)->GetPageId());
+  (*parent)->Remove(index);
+  num_merges_.Add();
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -159,10 +1202,46 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of both
+ * @return  false means nothing moved, because the new separator would make
+ * the parent, or the moved pair would make "node", overflow
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+bool BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index) {
+  // The pair that moves is the last one on the left and the separator goes right before the first one on the right.
+  const int key_index = index == 0 ? 1 : index;
+  const int moved_index = index == 0 ? 0 : neighbor_node->GetSize() - 1;
+  KeyType separator;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    const int left_index = index == 0 ? 0 : moved_index - 1;
+    separator = comparator_.ShortestSeparator(neighbor_node->KeyAt(left_index), neighbor_node->KeyAt(left_index + 1));
+  } else {
+    // The separators of internal pages rotate through the parent.
+    separator = neighbor_node->KeyAt(index == 0 ? 1 : moved_index);
+    if (node->IsFull()) {
+      return false;
+    }
+  }
+  if (!parent->CanReplaceKeyAt(key_index, separator)) {
+    return false;
+  }
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+  } else {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveLastToFrontOf(node);
+    } else {
+      neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+    }
+  }
+  parent->SetKeyAt(key_index, separator);
+  return true;
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,7 +1253,26 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
+  if (old_root_node->GetSize() > 1) {
+    return false;
+  }
+  const page_id_t child_page_id = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+  Page *child_page = FetchTreePage(child_page_id);
+  reinterpret_cast<BPlusTreePage *>(child_page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(child_page_id, true);
+  root_page_id_ = child_page_id;
+  UpdateRootPageId();
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -185,7 +1283,11 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
+  FlushWriteBuffer();
+  Page *page = FindLeafPage(KeyType{}, true);
+  return page == nullptr ? INDEXITERATOR_TYPE() : INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -193,7 +1295,82 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() { return INDEXITERATOR_TYPE(); }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  const int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index);
+}
+
+/*
+ * Input parameters are the low and the high key, find the leaf page that
+ * contains the low key, then construct an index iterator that ends past the
+ * high key
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &lo, const KeyType &hi, bool hi_inclusive) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPage(lo);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  typename INDEXITERATOR_TYPE::Range range;
+  range.comparator_ = &comparator_;
+  range.bound_ = hi;
+  range.bound_inclusive_ = hi_inclusive;
+  const int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(lo, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index, std::move(range));
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * a backward index iterator
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin() {
+  return ReverseIterator(KeyType{}, LeafSearch::RIGHT_MOST, std::nullopt, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &key) {
+  return ReverseIterator(key, LeafSearch::KEY, std::nullopt, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::RBegin(const KeyType &hi, const KeyType &lo, bool lo_inclusive) {
+  return ReverseIterator(hi, LeafSearch::KEY, lo, lo_inclusive);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::ReverseIterator(const KeyType &hi, LeafSearch search, std::optional<KeyType> lo,
+                                                   bool lo_inclusive) {
+  FlushWriteBuffer();
+  Page *page = FindLeafPage(hi, search);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->GetSize();
+  if (search == LeafSearch::KEY) {
+    // Right past the last key not after hi.
+    index = leaf->KeyIndex(hi, comparator_);
+    if (index < leaf->GetSize() && comparator_(leaf->KeyAt(index), hi) == 0) {
+      index++;
+    }
+  }
+  typename INDEXITERATOR_TYPE::Range range;
+  range.comparator_ = &comparator_;
+  range.bound_ = std::move(lo);
+  range.bound_inclusive_ = lo_inclusive;
+  range.reverse_ = true;
+  range.find_leaf_page_ = [this](const KeyType &key) { return FindLeafPage(key); };
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index, std::move(range));
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -209,10 +1386,268 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() { return INDEXITERATOR_TYPE(); }
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * The leaf page is found optimistically and then read latched; if it changed
+ * in between, the search starts over.
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  return FindLeafPage(key, leftMost ? LeafSearch::LEFT_MOST : LeafSearch::KEY);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, LeafSearch search) {
+  while (true) {
+    uint32_t version;
+    Page *page = FindLeafPageOptimistic(key, search, &version);
+    if (page == nullptr) {
+      return nullptr;
+    }
+    page->RLatch();
+    if (reinterpret_cast<BPlusTreePage *>(page->GetData())->ValidateVersion(version)) {
+      return page;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    num_restarts_.Add();
+    std::this_thread::yield();
+  }
+}
+
+/*
+ * Optimistic latch coupling: every page is read without a latch and trusted
+ * only once its version is validated. The child page id is validated before the
+ * child is fetched, and the parent is validated again after the child version is
+ * read, so the child cannot have been split, merged or deleted in between.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, LeafSearch search, uint32_t *version) {
+  while (true) {
+    const page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+    Page *page = FetchTreePage(root_page_id);
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    uint32_t node_version = node->GetVersion();
+    // A page that is no longer the root covers only part of the keys.
+    bool valid = BPlusTreePage::IsStable(node_version) && root_page_id_ == root_page_id;
+    while (valid && !node->IsLeafPage()) {
+      auto internal = reinterpret_cast<InternalPage *>(node);
+      int child_index;
+      if (search == LeafSearch::LEFT_MOST) {
+        child_index = 0;
+      } else if (search == LeafSearch::RIGHT_MOST) {
+        // The size may be torn by a writer; the version check below catches that.
+        child_index = std::clamp(internal->GetSize(), 1, static_cast<int>(INTERNAL_PAGE_SIZE)) - 1;
+      } else {
+        child_index = internal->LookupIndex(key, comparator_);
+      }
+      const page_id_t child_page_id = internal->ValueAt(child_index);
+      if (!node->ValidateVersion(node_version)) {
+        valid = false;
+        break;
+      }
+      Page *child_page = buffer_pool_manager_->FetchChildPage(page, child_index, child_page_id);
+      if (child_page == nullptr) {
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch b+ tree page");
+      }
+      auto child = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+      const uint32_t child_version = child->GetVersion();
+      valid = BPlusTreePage::IsStable(child_version) && node->ValidateVersion(node_version);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = child_page;
+      node = child;
+      node_version = child_version;
+    }
+    if (valid) {
+      *version = node_version;
+      return page;
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    num_restarts_.Add();
+    std::this_thread::yield();
+  }
+}
+
+/*
+ * Like FindLeafPageOptimistic, but a page that is not resident ends the
+ * search, and so does a page that changed: it is only a hint.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsLeafPageResident(const KeyType &key) {
+  const page_id_t root_page_id = root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  if (!buffer_pool_manager_->IsPageResident(root_page_id)) {
+    return false;
+  }
+  Page *page = FetchTreePage(root_page_id);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  uint32_t node_version = node->GetVersion();
+  bool resident = BPlusTreePage::IsStable(node_version);
+  while (resident && !node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    const int child_index = internal->LookupIndex(key, comparator_);
+    const page_id_t child_page_id = internal->ValueAt(child_index);
+    if (!node->ValidateVersion(node_version) || !buffer_pool_manager_->IsPageResident(child_page_id)) {
+      resident = false;
+      break;
+    }
+    Page *child_page = FetchChildTreePage(page, child_index, child_page_id);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child_page;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    node_version = node->GetVersion();
+    resident = BPlusTreePage::IsStable(node_version);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return resident;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageForWrite(const KeyType &key, WriteOperation operation, Transaction *transaction) {
+  Page *page = FetchTreePage(root_page_id_);
+  while (true) {
+    page->WLatch();
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, operation)) {
+      // Nothing above this page is going to change.
+      ReleaseWritePages(transaction);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    const int child_index = internal->LookupIndex(key, comparator_);
+    page = FetchChildTreePage(page, child_index, internal->ValueAt(child_index));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, WriteOperation operation) const {
+  if (operation == WriteOperation::INSERT) {
+    // A leaf splits when it becomes full, an internal page when it overflows.
+    return node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize()
+                              : !reinterpret_cast<InternalPage *>(node)->IsFull();
+  }
+  if (operation == WriteOperation::COMPACT && node->IsLeafPage()) {
+    // Compaction is there to merge it.
+    return false;
+  }
+  if (node->IsRootPage()) {
+    // The root leaf must not become empty, the root internal page must keep two children.
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  }
+  return node->IsLeafPage() ? node->GetSize() > GetMergeSize(reinterpret_cast<LeafPage *>(node))
+                            : !reinterpret_cast<InternalPage *>(node)->IsAtMinimum();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseWritePages(Transaction *transaction) {
+  for (Page *page : *transaction->GetPageSet()) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    const bool modified = node->IsBeingWritten();
+    if (modified) {
+      node->EndWrite();
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), modified);
+  }
+  transaction->GetPageSet()->clear();
+  if (!transaction->GetDeletedPageSet()->empty()) {
+    adaptive_hash_generation_++;
+  }
+  if (has_deferred_pages_) {
+    DeleteDeferredPages();
+  }
+  for (page_id_t page_id : *transaction->GetDeletedPageSet()) {
+    // Fails while an optimistic reader still has the page pinned; the reader will find its version changed, and the
+    // page is deleted once it is unpinned.
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      std::lock_guard<std::mutex> deferred_guard(deferred_latch_);
+      deferred_pages_.push_back(page_id);
+      has_deferred_pages_ = true;
+    }
+  }
+  transaction->GetDeletedPageSet()->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeleteDeferredPages() {
+  // Fetched first: the page may have been evicted once unpinned, and only a resident page is deallocated.
+  auto delete_page = [this](page_id_t page_id) {
+    if (buffer_pool_manager_->FetchPage(page_id) == nullptr) {
+      return false;
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return buffer_pool_manager_->DeletePage(page_id);
+  };
+  std::lock_guard<std::mutex> deferred_guard(deferred_latch_);
+  deferred_pages_.erase(std::remove_if(deferred_pages_.begin(), deferred_pages_.end(), delete_page),
+                        deferred_pages_.end());
+  has_deferred_pages_ = !deferred_pages_.empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UpdatePrevPageId(page_id_t page_id, page_id_t prev_page_id) {
+  Page *page = FetchTreePage(page_id);
+  // Searches do not read the pointer, so the version of the page stays.
+  page->WLatch();
+  reinterpret_cast<LeafPage *>(page->GetData())->SetPrevPageId(prev_page_id);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseReadPage(Page *page) {
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch b+ tree page");
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchChildTreePage(Page *parent, int child_index, page_id_t child_page_id) {
+  Page *page = buffer_pool_manager_->FetchChildPage(parent, child_index, child_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch b+ tree page");
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::AllocatePage(page_id_t *page_id, page_id_t hint) {
+  std::optional<DiskManager::TablespaceScope> tablespace_scope;
+  if (tablespace_.has_value()) {
+    tablespace_scope.emplace(*tablespace_);
+  }
+  return buffer_pool_manager_->NewPageWithHint(page_id, hint, extent_owner_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::NewTreePage(page_id_t *page_id, page_id_t hint, Transaction *transaction) {
+  Page *page = AllocatePage(page_id, hint);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new b+ tree page");
+  }
+  page->WLatch();
+  transaction->AddIntoPageSet(page);
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->BeginWrite();
+  return page;
 }
 
 /*
@@ -221,15 +1656,12 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
  * Call this method everytime root page id is changed.
  * @parameter: insert_record      defualt value is false. When set to true,
  * insert a record <index_name, root_page_id> into header page instead of
- * updating it.
+ * updating it, unless the tree has had a record since it was last empty.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
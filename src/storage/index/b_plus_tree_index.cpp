@@ -9,6 +9,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "common/exception.h"
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -18,8 +23,10 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager)
     : Index(metadata),
-      comparator_(metadata->GetKeySchema()),
-      container_(metadata->GetName(), buffer_pool_manager, comparator_) {}
+      comparator_(metadata->GetSearchKeySchema()),
+      container_(metadata->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE - 1,
+                 metadata->HasUniqueKeys()),
+      buffer_pool_manager_(buffer_pool_manager) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -27,7 +34,39 @@ void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *t
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_.Insert(index_key, rid, transaction);
+  if (has_change_buffer_ ? InsertOrBuffer(index_key, rid, transaction)
+                         : container_.Insert(index_key, rid, transaction)) {
+    AddToBloomFilter(&index_key, 1);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids,
+                                         Transaction *transaction) {
+  std::vector<std::pair<KeyType, ValueType>> entries(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    entries[i].first.SetFromKey(keys[i]);
+    entries[i].second = rids[i];
+  }
+  // Stable, so that of equal keys the first entry is the one indexed, as if inserted one by one.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; });
+  if (has_change_buffer_) {
+    // One by one, to cancel pending deletes and to buffer the entries whose leaf page is not in memory.
+    for (const auto &entry : entries) {
+      InsertOrBuffer(entry.first, entry.second, transaction);
+    }
+  } else {
+    container_.BulkLoad(entries.cbegin(), entries.cend(), BULK_LOAD_FILL_FACTOR, transaction);
+  }
+  if (has_bloom_filter_) {
+    std::vector<KeyType> index_keys;
+    index_keys.reserve(entries.size());
+    for (const auto &entry : entries) {
+      index_keys.push_back(entry.first);
+    }
+    AddToBloomFilter(index_keys.data(), index_keys.size());
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -36,7 +75,30 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *t
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_.Remove(index_key, transaction);
+  if (has_change_buffer_) {
+    DeleteOrBuffer(index_key, rid, transaction);
+  } else {
+    container_.Remove(index_key, rid, transaction);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids,
+                                         Transaction *transaction) {
+  std::vector<std::pair<KeyType, ValueType>> entries(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    entries[i].first.SetFromKey(keys[i]);
+    entries[i].second = rids[i];
+  }
+  std::sort(entries.begin(), entries.end(),
+            [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; });
+  for (const auto &entry : entries) {
+    if (has_change_buffer_) {
+      DeleteOrBuffer(entry.first, entry.second, transaction);
+    } else {
+      container_.Remove(entry.first, entry.second, transaction);
+    }
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -45,14 +107,346 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_.GetValue(index_key, result, transaction);
+  if (!MayContain(index_key)) {
+    return;
+  }
+  if (!has_change_buffer_) {
+    container_.GetValue(index_key, result, transaction);
+    return;
+  }
+  change_latch_.RLock();
+  std::vector<RID> rids;
+  container_.GetValue(index_key, &rids, transaction);
+  const bool pending = ApplyChanges(index_key, &rids);
+  change_latch_.RUnlock();
+  result->insert(result->end(), rids.begin(), rids.end());
+  if (pending) {
+    // The leaf page was just read in: merge the changes while it is in memory.
+    change_latch_.WLock();
+    MergeKeyChanges(index_key);
+    change_latch_.WUnlock();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::GetNextKey(const Tuple &key, RID *rid, Transaction *transaction) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+  // The iterator starts at the first key not before the key, past which the entries of the key itself are skipped.
+  auto iter = GetBeginIterator(index_key);
+  while (!iter.isEnd() && comparator_((*iter).first, index_key) == 0) {
+    ++iter;
+  }
+  *rid = iter.isEnd() ? RID() : (*iter).second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                    Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  std::vector<size_t> order;
+  order.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i]);
+    // The keys the Bloom filter rules out are not looked up, their results stay empty.
+    if (MayContain(index_keys[i])) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(),
+            [&](size_t lhs, size_t rhs) { return comparator_(index_keys[lhs], index_keys[rhs]) < 0; });
+  std::vector<KeyType> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (size_t i : order) {
+    sorted_keys.push_back(index_keys[i]);
+  }
+  std::vector<std::vector<RID>> sorted_results;
+  if (has_change_buffer_) {
+    change_latch_.RLock();
+    container_.GetValues(sorted_keys, &sorted_results, transaction);
+    for (size_t i = 0; i < sorted_keys.size(); i++) {
+      ApplyChanges(sorted_keys[i], &sorted_results[i]);
+    }
+    change_latch_.RUnlock();
+  } else {
+    container_.GetValues(sorted_keys, &sorted_results, transaction);
+  }
+  results->assign(keys.size(), {});
+  for (size_t i = 0; i < order.size(); i++) {
+    (*results)[order[i]] = std::move(sorted_results[i]);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ProbeKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                     Transaction *transaction) {
+  std::vector<KeyType> index_keys;
+  std::vector<size_t> positions;
+  index_keys.reserve(keys.size());
+  positions.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    KeyType index_key;
+    index_key.SetFromKey(keys[i]);
+    // The keys the Bloom filter rules out are not looked up, their results stay empty.
+    if (MayContain(index_key)) {
+      index_keys.push_back(index_key);
+      positions.push_back(i);
+    }
+  }
+  std::vector<std::vector<RID>> probed;
+  if (has_change_buffer_) {
+    change_latch_.RLock();
+    container_.GetValuesInterleaved(index_keys, &probed, transaction);
+    for (size_t i = 0; i < index_keys.size(); i++) {
+      ApplyChanges(index_keys[i], &probed[i]);
+    }
+    change_latch_.RUnlock();
+  } else {
+    container_.GetValuesInterleaved(index_keys, &probed, transaction);
+  }
+  results->assign(keys.size(), {});
+  for (size_t i = 0; i < positions.size(); i++) {
+    (*results)[positions[i]] = std::move(probed[i]);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(typename BPlusTree<KeyType, ValueType, KeyComparator>::BulkLoadIterator begin,
+                                    typename BPlusTree<KeyType, ValueType, KeyComparator>::BulkLoadIterator end,
+                                    Transaction *transaction) {
+  container_.BulkLoad(begin, end, BULK_LOAD_FILL_FACTOR, transaction);
+  if (has_bloom_filter_) {
+    filter_latch_.WLock();
+    RebuildBloomFilter();
+    filter_latch_.WUnlock();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::EnableBloomFilter() {
+  filter_latch_.WLock();
+  if (!has_bloom_filter_) {
+    RebuildBloomFilter();
+    has_bloom_filter_ = true;
+  }
+  filter_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::EnableChangeBuffer() {
+  if (GetMetadata()->HasUniqueKeys()) {
+    throw Exception("a change buffer needs an index without unique keys");
+  }
+  change_latch_.WLock();
+  if (!has_change_buffer_) {
+    change_inserts_ = std::make_unique<ChangeTree>(GetName() + "#ins", buffer_pool_manager_, comparator_,
+                                                   LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE - 1, false);
+    change_deletes_ = std::make_unique<ChangeTree>(GetName() + "#del", buffer_pool_manager_, comparator_,
+                                                   LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE - 1, false);
+    // Pick up the changes left pending by the last run, if any.
+    size_t num_changes = 0;
+    for (ChangeTree *changes : {change_inserts_.get(), change_deletes_.get()}) {
+      if (changes->Open()) {
+        for (auto iter = changes->begin(); !iter.isEnd(); ++iter) {
+          num_changes++;
+        }
+      }
+    }
+    num_changes_ = num_changes;
+    has_change_buffer_ = true;
+  }
+  change_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::InsertOrBuffer(const KeyType &key, RID rid, Transaction *transaction) {
+  bool inserted = true;
+  change_latch_.RLock();
+  if (num_changes_ > 0 && HasChange(change_deletes_.get(), key, rid)) {
+    // The entry is still in the tree.
+    change_deletes_->Remove(key, rid);
+    num_changes_--;
+  } else if (container_.IsLeafPageResident(key)) {
+    inserted = container_.Insert(key, rid, transaction);
+  } else {
+    change_inserts_->Insert(key, rid);
+    num_changes_++;
+  }
+  change_latch_.RUnlock();
+  return inserted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::DeleteOrBuffer(const KeyType &key, RID rid, Transaction *transaction) {
+  change_latch_.RLock();
+  if (num_changes_ > 0 && HasChange(change_inserts_.get(), key, rid)) {
+    // The entry never made it into the tree.
+    change_inserts_->Remove(key, rid);
+    num_changes_--;
+  } else if (container_.IsLeafPageResident(key)) {
+    container_.Remove(key, rid, transaction);
+  } else {
+    change_deletes_->Insert(key, rid);
+    num_changes_++;
+  }
+  change_latch_.RUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::HasChange(ChangeTree *changes, const KeyType &key, RID rid) {
+  std::vector<RID> rids;
+  changes->GetValue(key, &rids);
+  return std::find(rids.begin(), rids.end(), rid) != rids.end();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::ApplyChanges(const KeyType &key, std::vector<RID> *result) {
+  if (num_changes_ == 0) {
+    return false;
+  }
+  std::vector<RID> inserted;
+  change_inserts_->GetValue(key, &inserted);
+  std::vector<RID> deleted;
+  change_deletes_->GetValue(key, &deleted);
+  result->insert(result->end(), inserted.begin(), inserted.end());
+  for (const RID &rid : deleted) {
+    if (auto pos = std::find(result->begin(), result->end(), rid); pos != result->end()) {
+      result->erase(pos);
+    }
+  }
+  return !inserted.empty() || !deleted.empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_INDEX_TYPE::MergeKeyChanges(const KeyType &key) {
+  std::vector<RID> inserted;
+  change_inserts_->GetValue(key, &inserted);
+  for (const RID &rid : inserted) {
+    container_.Insert(key, rid);
+  }
+  std::vector<RID> deleted;
+  change_deletes_->GetValue(key, &deleted);
+  for (const RID &rid : deleted) {
+    container_.Remove(key, rid);
+  }
+  if (!inserted.empty()) {
+    change_inserts_->Remove(key);
+  }
+  if (!deleted.empty()) {
+    change_deletes_->Remove(key);
+  }
+  num_changes_ -= inserted.size() + deleted.size();
+  return inserted.size() + deleted.size();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_INDEX_TYPE::MergeChanges(size_t max_keys) {
+  if (!has_change_buffer_ || num_changes_ == 0) {
+    return 0;
+  }
+  change_latch_.WLock();
+  // The first keys of both trees, merged in key order so that the changes to a leaf page are merged together.
+  std::vector<KeyType> keys;
+  for (ChangeTree *changes : {change_inserts_.get(), change_deletes_.get()}) {
+    size_t num_keys = 0;
+    for (auto iter = changes->begin(); !iter.isEnd() && num_keys < max_keys; ++iter, ++num_keys) {
+      keys.push_back((*iter).first);
+    }
+  }
+  auto less = [this](const KeyType &a, const KeyType &b) { return comparator_(a, b) < 0; };
+  std::sort(keys.begin(), keys.end(), less);
+  keys.erase(std::unique(keys.begin(), keys.end(),
+                         [this](const KeyType &a, const KeyType &b) { return comparator_(a, b) == 0; }),
+             keys.end());
+  size_t num_merged = 0;
+  for (size_t i = 0; i < keys.size() && i < max_keys; i++) {
+    num_merged += MergeKeyChanges(keys[i]);
+  }
+  change_latch_.WUnlock();
+  return num_merged;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.begin(); }
+void BPLUSTREE_INDEX_TYPE::RebuildBloomFilter() {
+  // Writers add their keys after inserting them into the tree: a key the walk misses is added once the latch is free.
+  std::vector<hash_t> hashes;
+  for (auto iter = container_.begin(); !iter.isEnd(); ++iter) {
+    hashes.push_back(HashKey((*iter).first));
+  }
+  if (has_change_buffer_) {
+    for (auto iter = change_inserts_->begin(); !iter.isEnd(); ++iter) {
+      hashes.push_back(HashKey((*iter).first));
+    }
+  }
+  filter_capacity_ = std::max<size_t>(2 * hashes.size(), 64);
+  filter_keys_ = hashes.size();
+  bloom_filter_ = std::make_unique<BloomFilter>(filter_capacity_);
+  for (hash_t hash : hashes) {
+    bloom_filter_->Insert(hash);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) { return container_.Begin(key); }
+void BPLUSTREE_INDEX_TYPE::AddToBloomFilter(const KeyType *keys, size_t count) {
+  if (!has_bloom_filter_) {
+    return;
+  }
+  filter_latch_.WLock();
+  for (size_t i = 0; i < count; i++) {
+    bloom_filter_->Insert(HashKey(keys[i]));
+  }
+  filter_keys_ += count;
+  if (filter_keys_ > filter_capacity_) {
+    RebuildBloomFilter();
+  }
+  filter_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::MayContain(const KeyType &key) {
+  if (!has_bloom_filter_) {
+    return true;
+  }
+  hash_t hash = HashKey(key);
+  filter_latch_.RLock();
+  bool may_contain = bloom_filter_->MayContain(hash);
+  filter_latch_.RUnlock();
+  return may_contain;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+hash_t BPLUSTREE_INDEX_TYPE::HashKey(const KeyType &key) const {
+  if (GetMetadata()->GetIncludeColumnCount() == 0) {
+    return HashUtil::Hash(&key);
+  }
+  // A key looked up by its key columns alone has zeros for its INCLUDE columns.
+  Schema *search_key_schema = GetMetadata()->GetSearchKeySchema();
+  hash_t hash = 0;
+  for (uint32_t i = 0; i < search_key_schema->GetColumnCount(); i++) {
+    Value value = key.ToValue(search_key_schema, i);
+    hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&value));
+  }
+  return hash;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() {
+  MergeChanges(std::numeric_limits<size_t>::max());
+  return container_.begin();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) {
+  MergeChanges(std::numeric_limits<size_t>::max());
+  return container_.Begin(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &lo, const KeyType &hi) {
+  MergeChanges(std::numeric_limits<size_t>::max());
+  return container_.Begin(lo, hi);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetEndIterator() { return container_.end(); }
@@ -2,29 +2,195 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <thread>  // NOLINT
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, Range range)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_(page),
+      leaf_(reinterpret_cast<LeafPage *>(page->GetData())),
+      index_(index),
+      range_(std::move(range)) {
+  if (!range_.reverse_) {
+    SkipExhaustedPages();
+  } else if (--index_ < 0) {
+    if (leaf_->GetSize() == 0) {
+      Release();
+    } else {
+      MoveBefore(leaf_->KeyAt(0));
+    }
+  }
+  CheckBound();
+  LoadPostingList();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(other.page_),
+      leaf_(other.leaf_),
+      index_(other.index_),
+      range_(std::move(other.range_)),
+      posting_list_(std::move(other.posting_list_)),
+      posting_index_(other.posting_index_),
+      posting_item_(other.posting_item_) {
+  other.page_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    Release();
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    leaf_ = other.leaf_;
+    index_ = other.index_;
+    range_ = std::move(other.range_);
+    posting_list_ = std::move(other.posting_list_);
+    posting_index_ = other.posting_index_;
+    posting_item_ = other.posting_item_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::isEnd() { return page_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  return posting_index_ >= 0 ? posting_item_ : leaf_->GetItem(index_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  if (posting_index_ >= 0) {
+    posting_index_ += range_.reverse_ ? -1 : 1;
+    if (posting_index_ >= 0 && posting_index_ < static_cast<int>(posting_list_.size())) {
+      posting_item_.second = posting_list_[posting_index_];
+      return *this;
+    }
+  }
+  if (!range_.reverse_) {
+    index_++;
+    SkipExhaustedPages();
+  } else if (--index_ < 0) {
+    MoveBefore(leaf_->KeyAt(0));
+  }
+  CheckBound();
+  LoadPostingList();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedPages() {
+  while (page_ != nullptr && index_ >= leaf_->GetSize()) {
+    if (leaf_->GetSize() > 0 && IsPastBound(leaf_->KeyAt(leaf_->GetSize() - 1), false)) {
+      // The keys on the next page are all past the bound, no need to fetch it.
+      Release();
+      return;
+    }
+    const page_id_t next_page_id = leaf_->GetNextPageId();
+    Page *next_page = next_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPage(next_page_id);
+    if (next_page != nullptr) {
+      // Latch the next page before letting go of this one, so that it cannot be merged away in between.
+      next_page->RLatch();
+    } else if (next_page_id != INVALID_PAGE_ID) {
+      Release();
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch next leaf page");
+    }
+    Release();
+    page_ = next_page;
+    leaf_ = next_page == nullptr ? nullptr : reinterpret_cast<LeafPage *>(next_page->GetData());
+    index_ = 0;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveBefore(const KeyType &key) {
+  while (page_ != nullptr) {
+    index_ = leaf_->KeyIndex(key, *range_.comparator_) - 1;
+    if (index_ >= 0) {
+      return;
+    }
+    const page_id_t prev_page_id = leaf_->GetPrevPageId();
+    if (prev_page_id == INVALID_PAGE_ID || (leaf_->GetSize() > 0 && IsPastBound(leaf_->KeyAt(0), false))) {
+      Release();
+      return;
+    }
+    Page *prev_page = buffer_pool_manager_->FetchPage(prev_page_id);
+    if (prev_page == nullptr) {
+      Release();
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch previous leaf page");
+    }
+    if (prev_page->TryRLatch()) {
+      Release();
+      page_ = prev_page;
+      leaf_ = reinterpret_cast<LeafPage *>(prev_page->GetData());
+      continue;
+    }
+    // A writer holds the previous page and may be waiting for this one; waiting for it in turn would deadlock.
+    buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    Release();
+    std::this_thread::yield();
+    page_ = range_.find_leaf_page_(key);
+    leaf_ = page_ == nullptr ? nullptr : reinterpret_cast<LeafPage *>(page_->GetData());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::CheckBound() {
+  if (page_ != nullptr && IsPastBound(leaf_->KeyAt(index_), range_.bound_inclusive_)) {
+    Release();
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::isEnd() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::LoadPostingList() {
+  posting_list_.clear();
+  posting_index_ = -1;
+  if (page_ == nullptr || !BPlusTreePostingPage::IsListRID(leaf_->GetItem(index_).second)) {
+    return;
+  }
+  // The leaf page is latched, the posting list cannot change.
+  BPlusTreePostingPage::ReadList(buffer_pool_manager_, leaf_->GetItem(index_).second.GetPageId(), &posting_list_,
+                                 [] { return true; });
+  posting_index_ = range_.reverse_ ? static_cast<int>(posting_list_.size()) - 1 : 0;
+  posting_item_ = {leaf_->KeyAt(index_), posting_list_[posting_index_]};
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+bool INDEXITERATOR_TYPE::IsPastBound(const KeyType &key, bool inclusive) const {
+  if (!range_.bound_.has_value()) {
+    return false;
+  }
+  const int result = (*range_.comparator_)(key, *range_.bound_);
+  if (result == 0) {
+    return !inclusive;
+  }
+  return range_.reverse_ ? result < 0 : result > 0;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Release() {
+  if (page_ != nullptr) {
+    page_->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -44,5 +44,6 @@ template class LinearProbeHashTableIndex<GenericKey<8>, RID, GenericComparator<8
 template class LinearProbeHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTableIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTableIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class LinearProbeHashTableIndex<VarlenKey, RID, VarlenComparator>;
 
 }  // namespace bustub
@@ -0,0 +1,543 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_index.cpp
+//
+// Identification: src/storage/index/lsm_index.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/lsm_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "common/macros.h"
+#include "common/util/bloom_filter.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+namespace {
+
+/*
+ * A page of a run holds its number of entries, then the entries:
+ * | key size (2) | key | rid (8) | deleted (1) |
+ */
+constexpr size_t OFFSET_NUM_ENTRIES = 0;
+constexpr size_t OFFSET_ENTRIES = 4;
+constexpr size_t ENTRY_OVERHEAD = sizeof(uint16_t) + sizeof(int64_t) + sizeof(uint8_t);
+/** The longest key an entry can have, alone on its page. */
+constexpr size_t MAX_KEY_SIZE = PAGE_SIZE - OFFSET_ENTRIES - ENTRY_OVERHEAD;
+
+/** @return the order of two entries, by key and then by record id */
+int Compare(const std::string &a_key, RID a_rid, const std::string &b_key, RID b_rid) {
+  const int cmp = a_key.compare(b_key);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return a_rid.Get() < b_rid.Get() ? -1 : (a_rid.Get() > b_rid.Get() ? 1 : 0);
+}
+
+hash_t HashKey(const std::string &key) { return HashUtil::HashBytes(key.data(), key.size()); }
+
+/**
+ * Records the entry of a record id of the key, newest first: the first one seen of a record id decides whether the
+ * record id is in the result.
+ */
+void Visit(RID rid, bool deleted, std::vector<RID> *seen, std::vector<RID> *result) {
+  if (std::find(seen->begin(), seen->end(), rid) != seen->end()) {
+    return;
+  }
+  seen->push_back(rid);
+  if (!deleted) {
+    result->push_back(rid);
+  }
+}
+
+}  // namespace
+
+/*****************************************************************************
+ * MEMTABLE
+ *****************************************************************************/
+/*
+ * A skip list of a single writer at a time and any number of readers. A node
+ * is complete before it is linked, bottom up, with release stores that the
+ * acquire loads of the readers pair with; a node is never unlinked.
+ */
+struct LSMIndex::MemTable {
+  static constexpr size_t MAX_HEIGHT = 12;
+
+  struct Node {
+    Node(std::string key, RID rid, bool deleted, size_t height)
+        : key_(std::move(key)), rid_(rid), deleted_(deleted), height_(height) {
+      for (auto &next : next_) {
+        next.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    const std::string key_;
+    const RID rid_;
+    std::atomic<bool> deleted_;
+    const size_t height_;
+    std::atomic<Node *> next_[MAX_HEIGHT];
+  };
+
+  MemTable() : head_("", RID(), false, MAX_HEIGHT) {}
+
+  ~MemTable() {
+    Node *node = head_.next_[0].load(std::memory_order_relaxed);
+    while (node != nullptr) {
+      Node *next = node->next_[0].load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(MemTable);
+
+  /**
+   * @param[out] prev the last node before the entry at each height, if not nullptr
+   * @return the first node at or after the entry, nullptr if none is
+   */
+  Node *FindGreaterOrEqual(const std::string &key, RID rid, Node **prev) {
+    Node *node = &head_;
+    for (size_t height = MAX_HEIGHT; height-- > 0;) {
+      Node *next = node->next_[height].load(std::memory_order_acquire);
+      while (next != nullptr && Compare(next->key_, next->rid_, key, rid) < 0) {
+        node = next;
+        next = node->next_[height].load(std::memory_order_acquire);
+      }
+      if (prev != nullptr) {
+        prev[height] = node;
+      }
+      if (height == 0) {
+        return next;
+      }
+    }
+    return nullptr;
+  }
+
+  /** Adds the entry, or sets whether it deletes if it is there. Writers only, one at a time. */
+  void Put(const std::string &key, RID rid, bool deleted) {
+    Node *prev[MAX_HEIGHT];
+    Node *node = FindGreaterOrEqual(key, rid, prev);
+    if (node != nullptr && Compare(node->key_, node->rid_, key, rid) == 0) {
+      node->deleted_.store(deleted, std::memory_order_release);
+      return;
+    }
+    // Each height is a quarter as likely as the one below it.
+    size_t height = 1;
+    while (height < MAX_HEIGHT && (NextRandom() & 3) == 0) {
+      height++;
+    }
+    node = new Node(key, rid, deleted, height);
+    for (size_t i = 0; i < height; i++) {
+      node->next_[i].store(prev[i]->next_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      prev[i]->next_[i].store(node, std::memory_order_release);
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Visits the entries of the key, see Visit. */
+  void Lookup(const std::string &key, std::vector<RID> *seen, std::vector<RID> *result) {
+    Node *node = FindGreaterOrEqual(key, RID(std::numeric_limits<int64_t>::min()), nullptr);
+    for (; node != nullptr && node->key_ == key; node = node->next_[0].load(std::memory_order_acquire)) {
+      Visit(node->rid_, node->deleted_.load(std::memory_order_acquire), seen, result);
+    }
+  }
+
+  /** @return the first node in order, nullptr if the memtable is empty */
+  Node *First() { return head_.next_[0].load(std::memory_order_acquire); }
+
+  uint64_t NextRandom() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    return random_state_;
+  }
+
+  Node head_;
+  std::atomic<size_t> size_{0};
+  uint64_t random_state_{0x9e3779b97f4a7c15ULL};
+};
+
+/*****************************************************************************
+ * RUN
+ *****************************************************************************/
+struct LSMIndex::Run {
+  Run(BufferPoolManager *bpm, size_t max_entries) : bpm_(bpm), filter_(max_entries) {}
+
+  ~Run() {
+    for (page_id_t page_id : page_ids_) {
+      bpm_->DeletePage(page_id);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(Run);
+
+  /** Appends an entry, after those added so far, starting a page when the current one is full. */
+  void Add(const std::string &key, RID rid, bool deleted) {
+    const size_t entry_size = ENTRY_OVERHEAD + key.size();
+    if (page_ == nullptr || offset_ + entry_size > PAGE_SIZE) {
+      FinishPage();
+      page_id_t page_id;
+      page_ = bpm_->NewPage(&page_id);
+      BUSTUB_ASSERT(page_ != nullptr, "Couldn't create a page for the run.");
+      page_ids_.push_back(page_id);
+      first_keys_.push_back(key);
+      offset_ = OFFSET_ENTRIES;
+      page_entries_ = 0;
+    }
+    char *data = page_->GetData();
+    const auto key_size = static_cast<uint16_t>(key.size());
+    const int64_t rid_value = rid.Get();
+    const auto deleted_byte = static_cast<uint8_t>(deleted);
+    memcpy(data + offset_, &key_size, sizeof(key_size));
+    memcpy(data + offset_ + sizeof(key_size), key.data(), key.size());
+    memcpy(data + offset_ + sizeof(key_size) + key.size(), &rid_value, sizeof(rid_value));
+    memcpy(data + offset_ + sizeof(key_size) + key.size() + sizeof(rid_value), &deleted_byte, sizeof(deleted_byte));
+    offset_ += entry_size;
+    page_entries_++;
+    num_entries_++;
+    filter_.Insert(HashKey(key));
+  }
+
+  /** Writes the count of the current page, and unpins it. */
+  void FinishPage() {
+    if (page_ != nullptr) {
+      memcpy(page_->GetData() + OFFSET_NUM_ENTRIES, &page_entries_, sizeof(page_entries_));
+      bpm_->UnpinPage(page_ids_.back(), true);
+      page_ = nullptr;
+    }
+  }
+
+  /** Reads the entries of a page of the run. */
+  void ReadPage(size_t i, std::vector<Entry> *entries) const {
+    Page *page = bpm_->FetchPage(page_ids_[i]);
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the run.");
+    entries->clear();
+    page->RLatch();
+    const char *data = page->GetData();
+    uint32_t num_entries;
+    memcpy(&num_entries, data + OFFSET_NUM_ENTRIES, sizeof(num_entries));
+    size_t offset = OFFSET_ENTRIES;
+    for (uint32_t j = 0; j < num_entries; j++) {
+      uint16_t key_size;
+      int64_t rid_value;
+      uint8_t deleted_byte;
+      memcpy(&key_size, data + offset, sizeof(key_size));
+      std::string key(data + offset + sizeof(key_size), key_size);
+      memcpy(&rid_value, data + offset + sizeof(key_size) + key_size, sizeof(rid_value));
+      memcpy(&deleted_byte, data + offset + sizeof(key_size) + key_size + sizeof(rid_value), sizeof(deleted_byte));
+      entries->push_back(Entry{std::move(key), RID(rid_value), deleted_byte != 0});
+      offset += ENTRY_OVERHEAD + key_size;
+    }
+    page->RUnlatch();
+    bpm_->UnpinPage(page_ids_[i], false);
+  }
+
+  /** Visits the entries of the key, see Visit, reading the pages that may hold them only. */
+  void Lookup(const std::string &key, std::vector<RID> *seen, std::vector<RID> *result) const {
+    if (!filter_.MayContain(HashKey(key))) {
+      return;
+    }
+    // The entries of the key start in the last page that starts before the key, or in the first that starts with it.
+    size_t i = std::lower_bound(first_keys_.begin(), first_keys_.end(), key) - first_keys_.begin();
+    i = i > 0 ? i - 1 : 0;
+    std::vector<Entry> entries;
+    for (; i < page_ids_.size() && first_keys_[i] <= key; i++) {
+      ReadPage(i, &entries);
+      for (const Entry &entry : entries) {
+        if (entry.key_ == key) {
+          Visit(entry.rid_, entry.deleted_, seen, result);
+        } else if (entry.key_ > key) {
+          return;
+        }
+      }
+    }
+  }
+
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  /** The block index: the key of the first entry of each page. */
+  std::vector<std::string> first_keys_;
+  BloomFilter filter_;
+  size_t num_entries_{0};
+  /** The page being written while the run is built, and its end and number of entries. */
+  Page *page_{nullptr};
+  size_t offset_{0};
+  uint32_t page_entries_{0};
+};
+
+/*****************************************************************************
+ * VERSION
+ *****************************************************************************/
+struct LSMIndex::Version {
+  /** The memtable written to. */
+  std::shared_ptr<MemTable> active_;
+  /** The memtables frozen and not flushed yet, newest first. */
+  std::vector<std::shared_ptr<MemTable>> frozen_;
+  /** The runs of level 0, newest first. */
+  std::vector<std::shared_ptr<Run>> level0_;
+  /** The run of each level from 1 on, nullptr for an empty level. */
+  std::vector<std::shared_ptr<Run>> levels_;
+};
+
+/*****************************************************************************
+ * INDEX
+ *****************************************************************************/
+LSMIndex::LSMIndex(IndexMetadata *metadata, BufferPoolManager *bpm, ThreadPool *thread_pool, size_t memtable_size)
+    : Index(metadata), bpm_(bpm), thread_pool_(thread_pool), memtable_size_(memtable_size) {
+  auto version = std::make_shared<Version>();
+  version->active_ = std::make_shared<MemTable>();
+  version_ = std::move(version);
+}
+
+LSMIndex::~LSMIndex() { WaitForCompaction(); }
+
+void LSMIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) { Write(key, rid, false); }
+
+void LSMIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) { Write(key, rid, true); }
+
+void LSMIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  Lookup(*GetVersion(), EncodeOrderedKey(key, GetMetadata()->GetSearchKeySchema()), result);
+}
+
+void LSMIndex::WaitForCompaction() {
+  std::unique_lock lock(version_latch_);
+  idle_cv_.wait(lock, [this] { return !compacting_; });
+}
+
+std::vector<size_t> LSMIndex::GetNumRuns() {
+  std::shared_ptr<const Version> version = GetVersion();
+  std::vector<size_t> num_runs{version->level0_.size()};
+  for (const std::shared_ptr<Run> &run : version->levels_) {
+    num_runs.push_back(run == nullptr ? 0 : 1);
+  }
+  while (num_runs.size() > 1 && num_runs.back() == 0) {
+    num_runs.pop_back();
+  }
+  return num_runs;
+}
+
+void LSMIndex::Write(const Tuple &key, RID rid, bool deleted) {
+  const std::string encoded = EncodeOrderedKey(key, GetMetadata()->GetSearchKeySchema());
+  BUSTUB_ASSERT(encoded.size() <= MAX_KEY_SIZE, "The key is too large for a page of a run.");
+  bool compact_here = false;
+  {
+    std::scoped_lock write_latch(write_latch_);
+    std::shared_ptr<const Version> version = GetVersion();
+    if (!deleted && GetMetadata()->HasUniqueKeys()) {
+      // As in the other indexes, a unique key already there is not inserted again.
+      std::vector<RID> rids;
+      Lookup(*version, encoded, &rids);
+      if (!rids.empty()) {
+        return;
+      }
+    }
+    version->active_->Put(encoded, rid, deleted);
+    if (version->active_->size_.load(std::memory_order_relaxed) < memtable_size_) {
+      return;
+    }
+    auto next = std::make_shared<Version>(*version);
+    next->frozen_.insert(next->frozen_.begin(), next->active_);
+    next->active_ = std::make_shared<MemTable>();
+    std::scoped_lock version_latch(version_latch_);
+    version_ = std::move(next);
+    if (!compacting_) {
+      compacting_ = true;
+      if (thread_pool_ == nullptr) {
+        compact_here = true;
+      } else {
+        thread_pool_->Submit([this] { Compact(); }, WorkloadClass::ANALYTICAL);
+      }
+    }
+  }
+  if (compact_here) {
+    Compact();
+  }
+}
+
+std::shared_ptr<const LSMIndex::Version> LSMIndex::GetVersion() {
+  std::scoped_lock version_latch(version_latch_);
+  return version_;
+}
+
+void LSMIndex::Lookup(const Version &version, const std::string &key, std::vector<RID> *result) {
+  std::vector<RID> seen;
+  version.active_->Lookup(key, &seen, result);
+  for (const std::shared_ptr<MemTable> &memtable : version.frozen_) {
+    memtable->Lookup(key, &seen, result);
+  }
+  for (const std::shared_ptr<Run> &run : version.level0_) {
+    run->Lookup(key, &seen, result);
+  }
+  for (const std::shared_ptr<Run> &run : version.levels_) {
+    if (run != nullptr) {
+      run->Lookup(key, &seen, result);
+    }
+  }
+}
+
+void LSMIndex::Compact() {
+  while (true) {
+    if (FlushMemTable() || MergeLevel()) {
+      continue;
+    }
+    // Only the writers change the version meanwhile, and only by freezing a memtable.
+    std::scoped_lock version_latch(version_latch_);
+    if (version_->frozen_.empty()) {
+      compacting_ = false;
+      idle_cv_.notify_all();
+      return;
+    }
+  }
+}
+
+bool LSMIndex::FlushMemTable() {
+  std::shared_ptr<const Version> version = GetVersion();
+  if (version->frozen_.empty()) {
+    return false;
+  }
+  const std::shared_ptr<MemTable> &memtable = version->frozen_.back();
+  auto run = std::make_shared<Run>(bpm_, memtable->size_.load());
+  for (MemTable::Node *node = memtable->First(); node != nullptr;
+       node = node->next_[0].load(std::memory_order_acquire)) {
+    run->Add(node->key_, node->rid_, node->deleted_.load(std::memory_order_acquire));
+  }
+  run->FinishPage();
+
+  std::scoped_lock version_latch(version_latch_);
+  auto next = std::make_shared<Version>(*version_);
+  BUSTUB_ASSERT(next->frozen_.back() == memtable, "Only the flush takes memtables out.");
+  next->frozen_.pop_back();
+  // Older memtables are all flushed already, so the run is the newest of level 0.
+  next->level0_.insert(next->level0_.begin(), std::move(run));
+  version_ = std::move(next);
+  return true;
+}
+
+bool LSMIndex::MergeLevel() {
+  std::shared_ptr<const Version> version = GetVersion();
+  std::vector<std::shared_ptr<Run>> inputs;
+  const bool from_level0 = version->level0_.size() >= LEVEL0_RUNS;
+  // The level merged into, from 1 on.
+  size_t target = 0;
+  if (from_level0) {
+    inputs = version->level0_;
+    target = 1;
+  } else {
+    for (size_t level = 1; level <= version->levels_.size() && target == 0; level++) {
+      const std::shared_ptr<Run> &run = version->levels_[level - 1];
+      if (run != nullptr && run->num_entries_ > LevelCapacity(level)) {
+        inputs.push_back(run);
+        target = level + 1;
+      }
+    }
+    if (target == 0) {
+      return false;
+    }
+  }
+  if (target <= version->levels_.size() && version->levels_[target - 1] != nullptr) {
+    inputs.push_back(version->levels_[target - 1]);
+  }
+  const bool is_last = std::all_of(version->levels_.begin() + std::min(target, version->levels_.size()),
+                                   version->levels_.end(), [](const auto &run) { return run == nullptr; });
+  std::shared_ptr<Run> merged = MergeRuns(inputs, is_last);
+
+  std::scoped_lock version_latch(version_latch_);
+  auto next = std::make_shared<Version>(*version_);
+  if (from_level0) {
+    // The runs flushed meanwhile are newer than those merged, which are the oldest of level 0.
+    next->level0_.resize(next->level0_.size() - version->level0_.size());
+  } else {
+    next->levels_[target - 2] = nullptr;
+  }
+  if (next->levels_.size() < target) {
+    next->levels_.resize(target);
+  }
+  next->levels_[target - 1] = std::move(merged);
+  version_ = std::move(next);
+  return true;
+}
+
+std::shared_ptr<LSMIndex::Run> LSMIndex::MergeRuns(const std::vector<std::shared_ptr<Run>> &runs,
+                                                   bool drop_tombstones) {
+  size_t max_entries = 0;
+  for (const std::shared_ptr<Run> &run : runs) {
+    max_entries += run->num_entries_;
+  }
+  auto merged = std::make_shared<Run>(bpm_, max_entries);
+
+  // A cursor over each run, reading it a page at a time.
+  struct Cursor {
+    const Run *run_{nullptr};
+    size_t page_{0};
+    std::vector<Entry> entries_;
+    size_t pos_{0};
+
+    bool Valid() const { return pos_ < entries_.size(); }
+    const Entry &Get() const { return entries_[pos_]; }
+    void Next() {
+      if (++pos_ < entries_.size()) {
+        return;
+      }
+      pos_ = 0;
+      entries_.clear();
+      while (entries_.empty() && ++page_ < run_->page_ids_.size()) {
+        run_->ReadPage(page_, &entries_);
+      }
+    }
+  };
+  std::vector<Cursor> cursors;
+  cursors.reserve(runs.size());
+  for (const std::shared_ptr<Run> &run : runs) {
+    Cursor &cursor = cursors.emplace_back();
+    cursor.run_ = run.get();
+    if (!run->page_ids_.empty()) {
+      run->ReadPage(0, &cursor.entries_);
+    }
+  }
+
+  while (true) {
+    // The smallest entry; of those equal, the one of the newest run.
+    Cursor *min = nullptr;
+    for (Cursor &cursor : cursors) {
+      if (cursor.Valid() && (min == nullptr || Compare(cursor.Get().key_, cursor.Get().rid_, min->Get().key_,
+                                                       min->Get().rid_) < 0)) {
+        min = &cursor;
+      }
+    }
+    if (min == nullptr) {
+      break;
+    }
+    const Entry entry = min->Get();
+    for (Cursor &cursor : cursors) {
+      if (cursor.Valid() && Compare(cursor.Get().key_, cursor.Get().rid_, entry.key_, entry.rid_) == 0) {
+        cursor.Next();
+      }
+    }
+    if (!entry.deleted_ || !drop_tombstones) {
+      merged->Add(entry.key_, entry.rid_, entry.deleted_);
+    }
+  }
+  merged->FinishPage();
+  return merged->num_entries_ == 0 ? nullptr : merged;
+}
+
+size_t LSMIndex::LevelCapacity(size_t level) const {
+  size_t capacity = LEVEL0_RUNS * memtable_size_;
+  for (size_t i = 0; i < level; i++) {
+    capacity *= LEVEL_SIZE_RATIO;
+  }
+  return capacity;
+}
+
+}  // namespace bustub
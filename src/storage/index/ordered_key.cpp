@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ordered_key.cpp
+//
+// Identification: src/storage/index/ordered_key.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/ordered_key.h"
+
+#include <cstring>
+
+#include "common/exception.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+/** Writes the low bytes of an unsigned value big-endian. @return the bytes written */
+size_t PutBigEndian(uint64_t value, size_t size, char *out) {
+  for (size_t i = 0; i < size; i++) {
+    out[i] = static_cast<char>(value >> (8 * (size - 1 - i)));
+  }
+  return size;
+}
+
+/** Writes a signed value of a size big-endian, with the sign bit flipped so that negative values sort first. */
+size_t PutSigned(int64_t value, size_t size, char *out) {
+  return PutBigEndian(static_cast<uint64_t>(value) ^ (uint64_t{1} << (8 * size - 1)), size, out);
+}
+
+/** @return the value of type T stored at data */
+template <typename T>
+T Load(const char *data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+/** @return the bytes a value of a fixed-size type takes in a tuple, 0 for a type that is not encoded */
+size_t FixedSize(TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return 1;
+    case TypeId::SMALLINT:
+      return 2;
+    case TypeId::INTEGER:
+      return 4;
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+KeyNormalizer::KeyNormalizer(const Schema *schema) {
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const ColumnLayout &layout = schema->GetColumnLayout(i);
+    supported_ = supported_ && (layout.type_ == TypeId::VARCHAR ? !layout.is_inlined_ : FixedSize(layout.type_) > 0);
+    columns_.push_back(layout);
+  }
+}
+
+size_t KeyNormalizer::Encode(const char *data, size_t size, char *out, bool *has_null) const {
+  size_t pos = 0;
+  if (has_null != nullptr) {
+    *has_null = false;
+  }
+  auto put_null = [&]() {
+    out[pos++] = 0;
+    if (has_null != nullptr) {
+      *has_null = true;
+    }
+  };
+  for (const ColumnLayout &column : columns_) {
+    if (column.type_ == TypeId::VARCHAR) {
+      // A zero byte is followed by 0xff and the string by two zero bytes, which sort before any longer string.
+      if (column.offset_ + sizeof(int32_t) > size) {
+        return 0;
+      }
+      const auto offset = Load<int32_t>(data + column.offset_);
+      if (offset < 0 || offset + sizeof(uint32_t) > size) {
+        return 0;
+      }
+      const auto length = Load<uint32_t>(data + offset);
+      if (length == BUSTUB_VALUE_NULL) {
+        put_null();
+        continue;
+      }
+      if ((length & TOAST_POINTER_FLAG) != 0 || offset + sizeof(uint32_t) + length > size) {
+        return 0;
+      }
+      const char *chars = data + offset + sizeof(uint32_t);
+      out[pos++] = 1;
+      for (uint32_t j = 0; j + 1 < length; j++) {
+        out[pos++] = chars[j];
+        if (chars[j] == 0) {
+          out[pos++] = static_cast<char>(0xff);
+        }
+      }
+      out[pos++] = 0;
+      out[pos++] = 0;
+      continue;
+    }
+    const size_t fixed_size = FixedSize(column.type_);
+    if (fixed_size == 0 || column.offset_ + fixed_size > size) {
+      return 0;
+    }
+    const char *value = data + column.offset_;
+    out[pos++] = 1;
+    switch (column.type_) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        if (Load<int8_t>(value) == BUSTUB_INT8_NULL) {
+          break;
+        }
+        pos += PutSigned(Load<int8_t>(value), 1, out + pos);
+        continue;
+      case TypeId::SMALLINT:
+        if (Load<int16_t>(value) == BUSTUB_INT16_NULL) {
+          break;
+        }
+        pos += PutSigned(Load<int16_t>(value), 2, out + pos);
+        continue;
+      case TypeId::INTEGER:
+        if (Load<int32_t>(value) == BUSTUB_INT32_NULL) {
+          break;
+        }
+        pos += PutSigned(Load<int32_t>(value), 4, out + pos);
+        continue;
+      case TypeId::BIGINT:
+        if (Load<int64_t>(value) == BUSTUB_INT64_NULL) {
+          break;
+        }
+        pos += PutSigned(Load<int64_t>(value), 8, out + pos);
+        continue;
+      case TypeId::TIMESTAMP:
+        if (Load<uint64_t>(value) == BUSTUB_TIMESTAMP_NULL) {
+          break;
+        }
+        pos += PutBigEndian(Load<uint64_t>(value), 8, out + pos);
+        continue;
+      default: {
+        auto number = Load<double>(value);
+        if (number == BUSTUB_DECIMAL_NULL) {
+          break;
+        }
+        // Negative doubles sort in the reverse order of their bits; -0 equals 0.
+        if (number == 0) {
+          number = 0;
+        }
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits ^ (uint64_t{1} << 63);
+        pos += PutBigEndian(bits, 8, out + pos);
+        continue;
+      }
+    }
+    // The value is NULL, in place of its marker.
+    pos--;
+    put_null();
+  }
+  return pos;
+}
+
+std::string EncodeOrderedKey(const Tuple &key, const Schema *schema) {
+  KeyNormalizer normalizer(schema);
+  std::string encoded(normalizer.GetMaxEncodedSize(key.GetLength()), 0);
+  const size_t size = normalizer.Encode(key.GetData(), key.GetLength(), encoded.data());
+  if (size == 0 && schema->GetColumnCount() > 0) {
+    throw Exception(ExceptionType::MISMATCH_TYPE, "The key is stored out of line, detoast it first.");
+  }
+  encoded.resize(size);
+  return encoded;
+}
+
+}  // namespace bustub
@@ -9,6 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -31,6 +34,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
   SetMaxSize(max_size);
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
+  key_bytes_ = 0;
+  key_heap_offset_ = PAGE_SIZE;
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
@@ -38,13 +43,20 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  return array[index].first;
+  const Slot &slot = slots_[index];
+  KeyType key{};
+  // An optimistic reader may see the slot while it is being changed, but still must not read past the page.
+  const size_t size = std::min<size_t>(slot.key_size_, sizeof(KeyType));
+  const size_t offset = std::min<size_t>(slot.key_offset_, PAGE_SIZE - size);
+  memcpy(&key, GetPageData() + offset, size);
+  return key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
-  array[index].first = key;
+  key_bytes_ -= slots_[index].key_size_;
+  slots_[index].key_size_ = 0;
+  StoreKey(&slots_[index], key, GetSize());
 }
 
 /*
@@ -53,11 +65,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
-  for(int i = 0; i < GetMaxSize(); i++){
-    if(array[i].second == value){
+  for (int i = 0; i < GetSize(); i++) {
+    if (slots_[i].value_ == value) {
       return i;
     }
-  };
+  }
   return -1;
 }
 
@@ -66,7 +78,65 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return array[index].second; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return slots_[index].value_; }
+
+/*
+ * Helper methods to decide whether the page has to be split, merged or
+ * redistributed. Besides the max size, the space of the page bounds the
+ * number of entries, and the page always keeps room for one more entry
+ * with a full length key, so that an insert never has to compact a full page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Fits(int size, size_t key_bytes) const {
+  return size <= GetMaxSize() &&
+         INTERNAL_PAGE_HEADER_SIZE + size * sizeof(Slot) + key_bytes + MAX_ENTRY_SIZE <= PAGE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsOverflowing() const { return !Fits(GetSize(), key_bytes_); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsFull() const { return !Fits(GetSize() + 1, key_bytes_ + sizeof(KeyType)); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderflowing() const {
+  const size_t used_bytes = GetSize() * sizeof(Slot) + key_bytes_;
+  return GetSize() < GetMinSize() && 2 * used_bytes < PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsAtMinimum() const {
+  // Removing an entry frees up to a slot and a full length key.
+  const size_t used_bytes = GetSize() * sizeof(Slot) + key_bytes_;
+  return GetSize() - 1 < GetMinSize() &&
+         2 * (used_bytes - std::min(used_bytes, MAX_ENTRY_SIZE)) < PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMergeWith(const BPlusTreeInternalPage *sibling) const {
+  // The separator from the parent replaces the first key of the right page.
+  return Fits(GetSize() + sibling->GetSize(), key_bytes_ + sibling->key_bytes_ + sizeof(KeyType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanReplaceKeyAt(int index, const KeyType &key) const {
+  return Fits(GetSize(), key_bytes_ - slots_[index].key_size_ + StoredKeySize(key));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint16_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::StoredKeySize(const KeyType &key) {
+  const auto *bytes = reinterpret_cast<const char *>(&key);
+  uint16_t size = sizeof(KeyType);
+  while (size > 0 && bytes[size - 1] == 0) {
+    size--;
+  }
+  return size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::Capacity(size_t key_size) {
+  return (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - MAX_ENTRY_SIZE) / (sizeof(Slot) + key_size);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -75,39 +145,40 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return arra
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
  * Start the search from the second key(the first key should always be invalid)
+ * NOTE: optimistic readers call this while a writer may be changing the page, so
+ * the size is clamped to the capacity and the result must be validated
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
-  int pageNum = GetSize() - 1;
-
-  int up = pageNum - 1;
-  int down = 1;
-  int index = (up + down) / 2;
-
-  while(down <= up){
-    switch (comparator(key, array[index].first)) {
-      case 0:
-        return array[index].second;
-        break;
-      case -1:
-        if(index == 1){
-          return array[0].second;
-        }
-        up = index;
-        index = (up + down) / 2;
-        break;
-      case 1:
-        if(index == pageNum - 1
-            || comparator(key, array[index + 1].first) < 0) {
-          return array[index].second;
-        }
-        down = index;
-        index = (up + down) / 2;
-        break;
+  return slots_[LookupIndex(key, comparator)].value_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(const KeyType &key, const KeyComparator &comparator) const {
+  const int size = std::clamp(GetSize(), 1, std::min(GetMaxSize() + 1, static_cast<int>(INTERNAL_PAGE_SIZE)));
+  if (comparator.ComparesIntegers()) {
+    // Branchless search for the last key that is <= key, the invalid first key counting as smaller than any key.
+    int base = 0;
+    int length = size;
+    while (length > 1) {
+      const int half = length / 2;
+      base = comparator(KeyAt(base + half), key) <= 0 ? base + half : base;
+      length -= half;
     }
+    return base;
   }
-
-  return INVALID_PAGE_ID;
+  // Binary search for the last key that is <= key.
+  int low = 1;
+  int high = size - 1;
+  while (low <= high) {
+    const int mid = low + (high - low) / 2;
+    if (comparator(KeyAt(mid), key) <= 0) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  return low - 1;
 }
 
 /*****************************************************************************
@@ -122,9 +193,8 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCo
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                                                      const ValueType &new_value) {
-  array[0].second = old_value;
-  array[1].first = new_key;
-  array[1].second = new_value;
+  InsertAt(0, KeyType{}, old_value);
+  InsertAt(1, new_key, new_value);
 }
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
@@ -134,18 +204,54 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                     const ValueType &new_value) {
-  for(int i = 0; i < GetSize(); i++){
-    if(array[i].second == old_value){
-      for(int idx = GetSize(); idx > i; idx--){
-        array[idx] = array[idx - 1];
-      }
-      array[i + 1] = MappingType(new_key, new_value);
-      SetSize(GetSize()+1);
-      break;
-    }
+  InsertAt(ValueIndex(old_value) + 1, new_key, new_value);
+  return GetSize();
+}
+
+/*
+ * Append key & value pair after the last one. The first key, as always, is ignored.
+ * NOTE: only call this method within BulkLoad()(b_plus_tree.cpp), which creates
+ * the child pages with this page as their parent already
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  InsertAt(GetSize(), key, value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  Slot slot{value, 0, 0};
+  StoreKey(&slot, key, GetSize() + 1);
+  std::move_backward(slots_ + index, slots_ + GetSize(), slots_ + GetSize() + 1);
+  slots_[index] = slot;
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::StoreKey(Slot *slot, const KeyType &key, int num_slots) {
+  const uint16_t size = StoredKeySize(key);
+  if (key_heap_offset_ < INTERNAL_PAGE_HEADER_SIZE + num_slots * sizeof(Slot) + size) {
+    CompactKeys();
   }
+  assert(key_heap_offset_ >= INTERNAL_PAGE_HEADER_SIZE + num_slots * sizeof(Slot) + size);
+  key_heap_offset_ -= size;
+  memcpy(GetPageData() + key_heap_offset_, &key, size);
+  slot->key_offset_ = key_heap_offset_;
+  slot->key_size_ = size;
+  key_bytes_ += size;
+}
 
-  return GetSize();
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CompactKeys() {
+  char buffer[PAGE_SIZE];
+  uint16_t offset = PAGE_SIZE;
+  for (int i = 0; i < GetSize(); i++) {
+    offset -= slots_[i].key_size_;
+    memcpy(buffer + offset, GetPageData() + slots_[i].key_offset_, slots_[i].key_size_);
+    slots_[i].key_offset_ = offset;
+  }
+  memcpy(GetPageData() + offset, buffer + offset, PAGE_SIZE - offset);
+  key_heap_offset_ = offset;
 }
 
 /*****************************************************************************
@@ -153,30 +259,38 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * The keys differ in length, so it is the bytes that are split in half, as long
+ * as either page is left with at least min size entries or half of them.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
                                                 BufferPoolManager *buffer_pool_manager) {
-  int pairNum = GetSize();
-  for(int i = pairNum / 2; i < pairNum; i++){
-    recipient->array[i - pairNum / 2] = array[i];
-    recipient->SetSize(recipient->GetSize() + 1);
-
-    SetSize(GetSize() - 1);
+  const int size = GetSize();
+  const int min_entries = std::max(1, std::min(GetMinSize(), size / 2));
+  const size_t total_bytes = size * sizeof(Slot) + key_bytes_;
+  int start = 0;
+  size_t left_bytes = 0;
+  while (start < size - min_entries && (start < min_entries || 2 * left_bytes < total_bytes)) {
+    left_bytes += sizeof(Slot) + slots_[start].key_size_;
+    start++;
   }
-
+  recipient->CopyNFrom(this, start, size - start, buffer_pool_manager);
+  for (int i = start; i < size; i++) {
+    key_bytes_ -= slots_[i].key_size_;
+  }
+  SetSize(start);
 }
 
-/* Copy entries into me, starting from {items} and copy {size} entries.
+/* Copy entries into me, starting from {start} of {source} and copy {size} entries.
  * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  for (int i = 0 ; i < size; i++, items++){
-    array[i] = items[i];
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(const BPlusTreeInternalPage *source, int start, int size,
+                                               BufferPoolManager *buffer_pool_manager) {
+  for (int i = start; i < start + size; i++) {
+    CopyLastFrom(source->KeyAt(i), source->ValueAt(i), buffer_pool_manager);
   }
-
 }
 
 /*****************************************************************************
@@ -189,10 +303,9 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
-  for (int i = index; i < GetSize(); ++i) {
-    array[i] = array[i + 1];
-  }
-  SetSize(GetSize() - 1);
+  key_bytes_ -= slots_[index].key_size_;
+  std::move(slots_ + index + 1, slots_ + GetSize(), slots_ + index);
+  IncreaseSize(-1);
 }
 
 /*
@@ -200,7 +313,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return INVALID_PAGE_ID; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
+  const ValueType value = ValueAt(0);
+  Remove(0);
+  return value;
+}
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
@@ -213,7 +330,12 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return IN
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {}
+                                               BufferPoolManager *buffer_pool_manager) {
+  recipient->CopyLastFrom(middle_key, ValueAt(0), buffer_pool_manager);
+  recipient->CopyNFrom(this, 1, GetSize() - 1, buffer_pool_manager);
+  SetSize(0);
+  key_bytes_ = 0;
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -228,14 +350,21 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {}
+                                                      BufferPoolManager *buffer_pool_manager) {
+  recipient->CopyLastFrom(middle_key, ValueAt(0), buffer_pool_manager);
+  Remove(0);
+}
 
 /* Append an entry at the end.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const KeyType &key, const ValueType &value,
+                                                  BufferPoolManager *buffer_pool_manager) {
+  InsertAt(GetSize(), key, value);
+  Adopt(value, buffer_pool_manager);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient" page.
@@ -246,14 +375,36 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {}
+                                                       BufferPoolManager *buffer_pool_manager) {
+  recipient->SetKeyAt(0, middle_key);
+  recipient->CopyFirstFrom(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1), buffer_pool_manager);
+  Remove(GetSize() - 1);
+}
 
 /* Append an entry at the beginning.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const KeyType &key, const ValueType &value,
+                                                   BufferPoolManager *buffer_pool_manager) {
+  InsertAt(0, key, value);
+  Adopt(value, buffer_pool_manager);
+}
+
+/*
+ * Make this page the parent of the child page. Readers never follow parent page
+ * ids, so the child's version is left alone.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager) {
+  Page *page = buffer_pool_manager->FetchPage(child_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch child page to adopt");
+  }
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
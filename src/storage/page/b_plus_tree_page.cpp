@@ -45,9 +45,10 @@ void BPlusTreePage::SetMaxSize(int size) {
 
 /*
  * Helper method to get min page size
- * Generally, min page size == max page size / 2
+ * Generally, min page size == max page size / 2. An internal page splits once it holds more than max size children,
+ * so that each half still has at least (max size + 1) / 2 of them.
  */
-int BPlusTreePage::GetMinSize() const { return max_size_ / 2; }
+int BPlusTreePage::GetMinSize() const { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
 
 /*
  * Helper methods to get/set parent page id
@@ -70,4 +71,26 @@ void BPlusTreePage::SetPageId(page_id_t page_id) {
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
+/*
+ * Helper methods for optimistic readers and the writers they race with. The page contents are read without
+ * synchronization in between, so the fences order them against the version, as in a seqlock.
+ */
+uint32_t BPlusTreePage::GetVersion() const { return version_.load(std::memory_order_acquire); }
+bool BPlusTreePage::ValidateVersion(uint32_t version) const {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return version_.load(std::memory_order_relaxed) == version;
+}
+
+void BPlusTreePage::BeginWrite() {
+  const uint32_t version = version_.load(std::memory_order_relaxed);
+  if (IsStable(version)) {
+    version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+}
+void BPlusTreePage::EndWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+bool BPlusTreePage::IsBeingWritten() const { return !IsStable(version_.load(std::memory_order_relaxed)); }
+
 }  // namespace bustub
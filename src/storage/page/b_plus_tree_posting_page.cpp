@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+/*
+ * Init method after creating a new posting page
+ * Including set page type, set current size to zero, set page id, set next
+ * page id and set max size
+ */
+void BPlusTreePostingPage::Init(page_id_t page_id, page_id_t next_page_id) {
+  SetPageId(page_id);
+  SetParentPageId(INVALID_PAGE_ID);
+  SetMaxSize(POSTING_PAGE_SIZE);
+  SetPageType(IndexPageType::POSTING_PAGE);
+  SetSize(0);
+  SetNextPageId(next_page_id);
+}
+
+page_id_t BPlusTreePostingPage::GetNextPageId() const { return next_page_id_; }
+
+void BPlusTreePostingPage::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+RID BPlusTreePostingPage::ValueAt(int index) const { return array_[index]; }
+
+void BPlusTreePostingPage::SetValueAt(int index, const RID &value) { array_[index] = value; }
+
+int BPlusTreePostingPage::ValueIndex(const RID &value) const {
+  for (int i = 0; i < GetSize(); i++) {
+    if (array_[i] == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void BPlusTreePostingPage::Append(const RID &value) {
+  array_[GetSize()] = value;
+  IncreaseSize(1);
+}
+
+void BPlusTreePostingPage::RemoveAt(int index) { array_[index] = RemoveLast(); }
+
+RID BPlusTreePostingPage::RemoveLast() {
+  IncreaseSize(-1);
+  return array_[GetSize()];
+}
+
+}  // namespace bustub
@@ -0,0 +1,630 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page.cpp
+//
+// Identification: src/storage/page/compressed_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/compressed_page.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "storage/table/toast.h"
+
+namespace bustub {
+
+namespace {
+
+/** The widest integer offsets that are bit-packed, so that reading one never takes more than 8 bytes. */
+constexpr uint32_t MAX_BIT_WIDTH = 56;
+/** The most tuples of a page, so that the ends of the runs of RLE fit a uint16_t. */
+constexpr uint32_t MAX_TUPLE_COUNT = UINT16_MAX;
+
+/** @return the bits needed to store every integer from 0 to range */
+uint32_t BitWidth(uint64_t range) {
+  uint32_t width = 0;
+  while (width < 64 && (range >> width) != 0) {
+    width++;
+  }
+  return width;
+}
+
+uint32_t BitsToBytes(uint64_t bits) { return static_cast<uint32_t>((bits + 7) / 8); }
+
+/** @return the integer of width bits at bit bit_pos of data */
+uint64_t ReadBits(const char *data, uint64_t bit_pos, uint32_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  uint64_t word = 0;
+  memcpy(&word, data + bit_pos / 8, BitsToBytes(bit_pos % 8 + width));
+  return (word >> (bit_pos % 8)) & ((uint64_t{1} << width) - 1);
+}
+
+/** Stores an integer of width bits at bit bit_pos of data, whose bits there must be zero. */
+void WriteBits(char *data, uint64_t bit_pos, uint32_t width, uint64_t value) {
+  if (width == 0) {
+    return;
+  }
+  uint32_t size = BitsToBytes(bit_pos % 8 + width);
+  uint64_t word = 0;
+  memcpy(&word, data + bit_pos / 8, size);
+  word |= value << (bit_pos % 8);
+  memcpy(data + bit_pos / 8, &word, size);
+}
+
+uint16_t LoadUint16(const char *data, uint32_t index) {
+  uint16_t value;
+  memcpy(&value, data + sizeof(uint16_t) * index, sizeof(uint16_t));
+  return value;
+}
+
+void StoreUint16(char *data, uint32_t index, uint32_t value) {
+  auto narrow = static_cast<uint16_t>(value);
+  memcpy(data + sizeof(uint16_t) * index, &narrow, sizeof(uint16_t));
+}
+
+/** @return true if the values of a column are integers, which are bit-packed or run-length encoded */
+bool IsInteger(TypeId type_id) {
+  switch (type_id) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+    case TypeId::TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** @return the integer of width bytes stored at data, sign extended */
+int64_t LoadInteger(const char *data, uint32_t width) {
+  switch (width) {
+    case 1:
+      return *reinterpret_cast<const int8_t *>(data);
+    case 2:
+      return *reinterpret_cast<const int16_t *>(data);
+    case 4:
+      return *reinterpret_cast<const int32_t *>(data);
+    default:
+      return *reinterpret_cast<const int64_t *>(data);
+  }
+}
+
+/** Stores the low width bytes of an integer at dest. */
+void StoreInteger(char *dest, uint32_t width, int64_t value) { memcpy(dest, &value, width); }
+
+}  // namespace
+
+uint32_t CompressedPage::ReadCode(const Segment &segment, uint32_t slot_num) {
+  const char *data = GetData() + segment.offset_;
+  uint32_t codes_offset = sizeof(uint16_t) * (segment.count_ + 1) + LoadUint16(data, segment.count_);
+  return static_cast<uint32_t>(ReadBits(data + codes_offset, uint64_t{slot_num} * segment.bit_width_,
+                                        segment.bit_width_));
+}
+
+void CompressedPage::ReadFixed(const Segment &segment, uint32_t slot_num, char *dest) {
+  const char *data = GetData() + segment.offset_;
+  switch (segment.encoding_) {
+    case Encoding::BITPACK: {
+      uint64_t offset = ReadBits(data, uint64_t{slot_num} * segment.bit_width_, segment.bit_width_);
+      StoreInteger(dest, segment.width_, static_cast<int64_t>(static_cast<uint64_t>(segment.base_) + offset));
+      return;
+    }
+    case Encoding::RLE: {
+      // Find the first run ending after the slot.
+      uint32_t lo = 0;
+      uint32_t hi = segment.count_;
+      while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (LoadUint16(data, mid) <= slot_num) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      const char *values = data + sizeof(uint16_t) * segment.count_;
+      uint64_t offset = ReadBits(values, uint64_t{lo} * segment.bit_width_, segment.bit_width_);
+      StoreInteger(dest, segment.width_, static_cast<int64_t>(static_cast<uint64_t>(segment.base_) + offset));
+      return;
+    }
+    default:
+      memcpy(dest, data + segment.width_ * slot_num, segment.width_);
+  }
+}
+
+const char *CompressedPage::ReadVarlen(const Segment &segment, uint32_t slot_num, uint32_t *size) {
+  const char *data = GetData() + segment.offset_;
+  uint32_t index = segment.encoding_ == Encoding::DICTIONARY ? ReadCode(segment, slot_num) : slot_num;
+  uint32_t begin = LoadUint16(data, index);
+  *size = LoadUint16(data, index + 1) - begin;
+  uint32_t count = segment.encoding_ == Encoding::DICTIONARY ? segment.count_ : GetTupleCount();
+  return data + sizeof(uint16_t) * (count + 1) + begin;
+}
+
+uint32_t CompressedPage::GetTupleSize(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all) {
+  uint32_t tuple_size = GetInlineLength() + (all ? 0 : sizeof(uint32_t));
+  auto add_column = [&](uint32_t column_idx) {
+    const Segment &segment = *GetSegment(column_idx);
+    if (segment.type_id_ == static_cast<uint8_t>(TypeId::VARCHAR)) {
+      uint32_t size;
+      ReadVarlen(segment, slot_num, &size);
+      tuple_size += size;
+    }
+  };
+  if (all) {
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      add_column(i);
+    }
+  } else {
+    std::for_each(column_ids.begin(), column_ids.end(), add_column);
+  }
+  return tuple_size;
+}
+
+void CompressedPage::ReadTuple(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all, char *dest,
+                               uint32_t size) {
+  uint32_t offset = GetInlineLength();
+  auto read_column = [&](uint32_t column_idx) {
+    const Segment &segment = *GetSegment(column_idx);
+    if (segment.type_id_ != static_cast<uint8_t>(TypeId::VARCHAR)) {
+      ReadFixed(segment, slot_num, dest + segment.tuple_offset_);
+      return;
+    }
+    uint32_t stored_size;
+    const char *stored = ReadVarlen(segment, slot_num, &stored_size);
+    memcpy(dest + offset, stored, stored_size);
+    memcpy(dest + segment.tuple_offset_, &offset, sizeof(uint32_t));
+    offset += stored_size;
+  };
+  if (all) {
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      read_column(i);
+    }
+    BUSTUB_ASSERT(offset == size, "The values must fill the tuple exactly.");
+    return;
+  }
+  // The columns not read are zero, and the varlen ones point to a NULL value at the end of the tuple.
+  memset(dest, 0, offset);
+  uint32_t null_offset = size - sizeof(uint32_t);
+  uint32_t null_length = BUSTUB_VALUE_NULL;
+  memcpy(dest + null_offset, &null_length, sizeof(uint32_t));
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    const Segment &segment = *GetSegment(i);
+    if (segment.type_id_ == static_cast<uint8_t>(TypeId::VARCHAR)) {
+      memcpy(dest + segment.tuple_offset_, &null_offset, sizeof(uint32_t));
+    }
+  }
+  std::for_each(column_ids.begin(), column_ids.end(), read_column);
+  BUSTUB_ASSERT(offset == null_offset, "The values must fill the tuple exactly.");
+}
+
+void CompressedPage::LogPageImage(Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && log_manager != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::PAGEIMAGE, GetTablePageId(),
+                         GetData());
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+}
+
+bool CompressedPage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager,
+                                LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is already deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(slot_num)) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  if (enable_logging) {
+    // Acquire an exclusive lock, upgrading from a shared lock if necessary.
+    if (lock_manager == nullptr) {
+      // A table lock of the transaction covers the tuple.
+    } else if (txn->IsSharedLocked(rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid)) {
+        return false;
+      }
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+      return false;
+    }
+    if (log_manager != nullptr) {
+      Tuple dummy_tuple;
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+
+  // Mark the tuple as deleted.
+  SetDeleteBit(slot_num, true);
+  return true;
+}
+
+void CompressedPage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+    // We need to copy out the deleted tuple for undo purposes.
+    Tuple delete_tuple = CopyOutTuple(rid);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  // The values of the tuple stay in the segments, only the tuple is gone.
+  SetDeleteBit(slot_num, false);
+  SetDeleteBit(GetTupleCount() + slot_num, true);
+}
+
+void CompressedPage::ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    std::vector<std::pair<RID, Tuple>> delete_tuples;
+    delete_tuples.reserve(rids.size());
+    for (const RID &rid : rids) {
+      BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+      delete_tuples.emplace_back(rid, CopyOutTuple(rid));
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETES, GetTablePageId(),
+                         std::move(delete_tuples));
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  // Logged already, all at once.
+  for (const RID &rid : rids) {
+    ApplyDelete(rid, nullptr, nullptr);
+  }
+}
+
+Tuple CompressedPage::CopyOutTuple(const RID &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  Tuple tuple;
+  tuple.size_ = GetTupleSize(slot_num, {}, true);
+  tuple.data_ = Tuple::AllocateData(tuple.size_);
+  ReadTuple(slot_num, {}, true, tuple.data_, tuple.size_);
+  tuple.rid_ = rid;
+  tuple.allocated_ = true;
+  return tuple;
+}
+
+void CompressedPage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  // Log the rollback.
+  if (enable_logging && log_manager != nullptr) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
+  // Unset the deleted flag.
+  SetDeleteBit(slot_num, false);
+}
+
+bool CompressedPage::CheckRead(const RID &rid, Transaction *txn, LockManager *lock_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(slot_num)) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  // Otherwise we have a valid tuple, try to acquire at least a shared lock.
+  if (enable_logging) {
+    if (lock_manager != nullptr && !txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) &&
+        !lock_manager->LockShared(txn, rid)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompressedPage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  if (!CheckRead(rid, txn, lock_manager)) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(rid.GetSlotNum(), {}, true);
+  tuple->FreeData();
+  tuple->size_ = tuple_size;
+  tuple->data_ = Tuple::AllocateData(tuple_size);
+  ReadTuple(rid.GetSlotNum(), {}, true, tuple->data_, tuple_size);
+  tuple->rid_ = rid;
+  tuple->allocated_ = true;
+  return true;
+}
+
+bool CompressedPage::GetTupleColumns(const RID &rid, const std::vector<uint32_t> &column_ids,
+                                     std::vector<char> *buffer, Tuple *tuple, Transaction *txn,
+                                     LockManager *lock_manager) {
+  if (!CheckRead(rid, txn, lock_manager)) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(rid.GetSlotNum(), column_ids, false);
+  if (buffer->size() < tuple_size) {
+    buffer->resize(tuple_size);
+  }
+  ReadTuple(rid.GetSlotNum(), column_ids, false, buffer->data(), tuple_size);
+  tuple->FreeData();
+  tuple->size_ = tuple_size;
+  tuple->data_ = buffer->data();
+  tuple->rid_ = rid;
+  tuple->allocated_ = false;
+  return true;
+}
+
+bool CompressedPage::GetFirstTupleRid(RID *first_rid) {
+  // Find and return the first valid tuple.
+  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
+    if (!IsDeleted(i)) {
+      first_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool CompressedPage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  // Find and return the first valid tuple after our current slot number.
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
+    if (!IsDeleted(i)) {
+      next_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  // Otherwise return false as there are no more tuples.
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool CompressedPage::FindCode(uint32_t column_idx, const Value &value, uint32_t *code) {
+  const Segment &segment = *GetSegment(column_idx);
+  if (segment.encoding_ != Encoding::DICTIONARY) {
+    return false;
+  }
+  const char *data = GetData() + segment.offset_;
+  const char *entries = data + sizeof(uint16_t) * (segment.count_ + 1);
+  *code = segment.count_;
+  for (uint32_t i = 0; i < segment.count_; i++) {
+    const char *stored = entries + LoadUint16(data, i);
+    uint32_t length = *reinterpret_cast<const uint32_t *>(stored);
+    if (length != BUSTUB_VALUE_NULL && (length & TOAST_POINTER_FLAG) != 0) {
+      return false;
+    }
+    if (*code == segment.count_ &&
+        Value::DeserializeFrom(stored, static_cast<TypeId>(segment.type_id_)).CompareEquals(value) ==
+            CmpBool::CmpTrue) {
+      *code = i;
+    }
+  }
+  return true;
+}
+
+CompressedPageBuilder::CompressedPageBuilder(const Schema *schema)
+    : schema_(schema), columns_(schema->GetColumnCount()) {}
+
+uint32_t CompressedPageBuilder::SegmentSize(uint32_t column_idx, const Summary &summary, uint32_t dictionary_size,
+                                            uint32_t tuple_count, Encoding *encoding, uint32_t *bit_width) const {
+  const Column &column = schema_->GetColumn(column_idx);
+  *encoding = Encoding::PLAIN;
+  *bit_width = 0;
+  if (!column.IsInlined()) {
+    uint32_t plain = sizeof(uint16_t) * (tuple_count + 1) + summary.value_bytes_;
+    uint32_t code_width = dictionary_size == 0 ? 0 : BitWidth(dictionary_size - 1);
+    uint32_t dictionary = sizeof(uint16_t) * (dictionary_size + 1) + summary.dictionary_bytes_ +
+                          BitsToBytes(uint64_t{tuple_count} * code_width);
+    if (dictionary < plain) {
+      *encoding = Encoding::DICTIONARY;
+      *bit_width = code_width;
+      return dictionary;
+    }
+    return plain;
+  }
+  uint32_t plain = column.GetFixedLength() * tuple_count;
+  if (!IsInteger(column.GetType()) || tuple_count == 0) {
+    return plain;
+  }
+  uint32_t width = BitWidth(static_cast<uint64_t>(summary.max_) - static_cast<uint64_t>(summary.min_));
+  if (width > MAX_BIT_WIDTH) {
+    return plain;
+  }
+  uint32_t bitpack = BitsToBytes(uint64_t{tuple_count} * width);
+  uint32_t rle = sizeof(uint16_t) * summary.runs_ + BitsToBytes(uint64_t{summary.runs_} * width);
+  uint32_t best = plain;
+  if (bitpack < best) {
+    *encoding = Encoding::BITPACK;
+    *bit_width = width;
+    best = bitpack;
+  }
+  if (rle < best) {
+    *encoding = Encoding::RLE;
+    *bit_width = width;
+    best = rle;
+  }
+  return best;
+}
+
+bool CompressedPageBuilder::Add(const Tuple &tuple) {
+  if (tuple_count_ == MAX_TUPLE_COUNT) {
+    return false;
+  }
+  // Size the page with the tuple, without adding it yet.
+  uint32_t tuple_count = tuple_count_ + 1;
+  std::vector<Summary> summaries(columns_.size());
+  uint64_t size = CompressedPage::SIZE_COMPRESSED_PAGE_HEADER +
+                  sizeof(CompressedPage::Segment) * columns_.size() + 2 * BitsToBytes(tuple_count);
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    const Column &column = schema_->GetColumn(i);
+    const char *stored = tuple.GetData() + column.GetOffset();
+    ColumnValues &values = columns_[i];
+    Summary &summary = summaries[i];
+    summary = values.summary_;
+    uint32_t dictionary_size = values.dictionary_.size();
+    if (!column.IsInlined()) {
+      stored = tuple.GetData() + *reinterpret_cast<const uint32_t *>(stored);
+      uint32_t stored_size = Toast::StoredSize(stored);
+      summary.value_bytes_ += stored_size;
+      if (values.code_of_.count(std::string(stored, stored_size)) == 0) {
+        summary.dictionary_bytes_ += stored_size;
+        dictionary_size++;
+      }
+    } else if (IsInteger(column.GetType())) {
+      int64_t value = LoadInteger(stored, column.GetFixedLength());
+      bool is_first = values.integers_.empty();
+      summary.min_ = is_first ? value : std::min(summary.min_, value);
+      summary.max_ = is_first ? value : std::max(summary.max_, value);
+      summary.runs_ += is_first || value != values.integers_.back() ? 1 : 0;
+    }
+    Encoding encoding;
+    uint32_t bit_width;
+    size += SegmentSize(i, summary, dictionary_size, tuple_count, &encoding, &bit_width);
+  }
+  if (size > PAGE_SIZE) {
+    return false;
+  }
+
+  // It fits, add it.
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    const Column &column = schema_->GetColumn(i);
+    const char *stored = tuple.GetData() + column.GetOffset();
+    ColumnValues &values = columns_[i];
+    values.summary_ = summaries[i];
+    if (!column.IsInlined()) {
+      stored = tuple.GetData() + *reinterpret_cast<const uint32_t *>(stored);
+      std::string value(stored, Toast::StoredSize(stored));
+      auto [code, is_new] = values.code_of_.emplace(value, values.dictionary_.size());
+      if (is_new) {
+        values.dictionary_.push_back(std::move(value));
+      }
+      values.codes_.push_back(code->second);
+    } else if (IsInteger(column.GetType())) {
+      values.integers_.push_back(LoadInteger(stored, column.GetFixedLength()));
+    } else {
+      values.fixed_.append(stored, column.GetFixedLength());
+    }
+  }
+  tuple_count_ = tuple_count;
+  return true;
+}
+
+void CompressedPageBuilder::Build(CompressedPage *page, page_id_t page_id, page_id_t prev_page_id,
+                                  page_id_t next_page_id) {
+  using Segment = CompressedPage::Segment;
+  char *data = page->GetData();
+  memset(data, 0, PAGE_SIZE);
+  memcpy(data, &page_id, sizeof(page_id_t));
+  page->SetPrevPageId(prev_page_id);
+  page->SetNextPageId(next_page_id);
+  page->SetHeaderField(CompressedPage::OFFSET_MAGIC, CompressedPage::COMPRESSED_PAGE_MAGIC);
+  page->SetHeaderField(CompressedPage::OFFSET_TUPLE_COUNT, tuple_count_);
+  page->SetHeaderField(CompressedPage::OFFSET_COLUMN_COUNT, columns_.size());
+  page->SetHeaderField(CompressedPage::OFFSET_INLINE_LENGTH, schema_->GetLength());
+
+  uint32_t offset =
+      CompressedPage::SIZE_COMPRESSED_PAGE_HEADER + sizeof(Segment) * columns_.size() + 2 * BitsToBytes(tuple_count_);
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    const Column &column = schema_->GetColumn(i);
+    ColumnValues &values = columns_[i];
+    Segment &segment = *page->GetSegment(i);
+    Encoding encoding;
+    uint32_t bit_width;
+    uint32_t size = SegmentSize(i, values.summary_, values.dictionary_.size(), tuple_count_, &encoding, &bit_width);
+    segment.base_ = values.summary_.min_;
+    segment.offset_ = offset;
+    segment.tuple_offset_ = column.GetOffset();
+    segment.width_ = column.GetFixedLength();
+    segment.type_id_ = static_cast<uint8_t>(column.GetType());
+    segment.encoding_ = encoding;
+    segment.bit_width_ = bit_width;
+    char *dest = data + offset;
+    // The integers are stored as their offset from the smallest one, which wraps around like their difference does.
+    auto offset_of = [&segment](int64_t value) {
+      return static_cast<uint64_t>(value) - static_cast<uint64_t>(segment.base_);
+    };
+    switch (encoding) {
+      case Encoding::BITPACK:
+        for (uint32_t slot = 0; slot < tuple_count_; slot++) {
+          WriteBits(dest, uint64_t{slot} * bit_width, bit_width, offset_of(values.integers_[slot]));
+        }
+        break;
+      case Encoding::RLE: {
+        segment.count_ = values.summary_.runs_;
+        char *run_values = dest + sizeof(uint16_t) * segment.count_;
+        uint32_t run = 0;
+        for (uint32_t slot = 0; slot < tuple_count_; slot++) {
+          if (slot + 1 == tuple_count_ || values.integers_[slot + 1] != values.integers_[slot]) {
+            StoreUint16(dest, run, slot + 1);
+            WriteBits(run_values, uint64_t{run} * bit_width, bit_width,
+                      offset_of(values.integers_[slot]));
+            run++;
+          }
+        }
+        BUSTUB_ASSERT(run == segment.count_, "The runs must all be written.");
+        break;
+      }
+      case Encoding::DICTIONARY: {
+        segment.count_ = values.dictionary_.size();
+        char *entries = dest + sizeof(uint16_t) * (segment.count_ + 1);
+        uint32_t entry_offset = 0;
+        for (uint32_t code = 0; code < segment.count_; code++) {
+          StoreUint16(dest, code, entry_offset);
+          memcpy(entries + entry_offset, values.dictionary_[code].data(), values.dictionary_[code].size());
+          entry_offset += values.dictionary_[code].size();
+        }
+        StoreUint16(dest, segment.count_, entry_offset);
+        char *codes = entries + entry_offset;
+        for (uint32_t slot = 0; slot < tuple_count_; slot++) {
+          WriteBits(codes, uint64_t{slot} * bit_width, bit_width, values.codes_[slot]);
+        }
+        break;
+      }
+      case Encoding::PLAIN:
+        if (!column.IsInlined()) {
+          char *bytes = dest + sizeof(uint16_t) * (tuple_count_ + 1);
+          uint32_t value_offset = 0;
+          for (uint32_t slot = 0; slot < tuple_count_; slot++) {
+            const std::string &value = values.dictionary_[values.codes_[slot]];
+            StoreUint16(dest, slot, value_offset);
+            memcpy(bytes + value_offset, value.data(), value.size());
+            value_offset += value.size();
+          }
+          StoreUint16(dest, tuple_count_, value_offset);
+        } else if (IsInteger(column.GetType())) {
+          for (uint32_t slot = 0; slot < tuple_count_; slot++) {
+            StoreInteger(dest + segment.width_ * slot, segment.width_, values.integers_[slot]);
+          }
+        } else {
+          memcpy(dest, values.fixed_.data(), values.fixed_.size());
+        }
+        break;
+    }
+    offset += size;
+    values = ColumnValues();
+  }
+  BUSTUB_ASSERT(offset <= PAGE_SIZE, "The segments must fit in the page.");
+  tuple_count_ = 0;
+}
+
+}  // namespace bustub
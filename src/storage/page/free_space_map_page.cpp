@@ -0,0 +1,40 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.cpp
+//
+// Identification: src/storage/page/free_space_map_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/free_space_map_page.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+uint32_t FreeSpaceMapPage::Append(page_id_t heap_page_id, uint8_t category) {
+  BUSTUB_ASSERT(!IsFull(), "Cannot append to a full free-space map page.");
+  heap_page_ids_[count_] = heap_page_id;
+  categories_[count_] = category;
+  return count_++;
+}
+
+uint32_t FreeSpaceMapPage::Find(uint8_t category) const {
+  uint32_t idx = 0;
+  while (idx < count_ && categories_[idx] < category) {
+    idx++;
+  }
+  return idx;
+}
+
+uint8_t FreeSpaceMapPage::MaxCategory() const {
+  return count_ == 0 ? 0 : *std::max_element(categories_, categories_ + count_);
+}
+
+}  // namespace bustub
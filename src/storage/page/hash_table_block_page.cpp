@@ -11,36 +11,72 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_block_page.h"
+
+#include <cstring>
+
 #include "storage/index/generic_key.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 KeyType HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const {
-  return {};
+  if constexpr (IS_VARLEN) {
+    return VarlenKey(reinterpret_cast<const char *>(this) + array_[bucket_ind].offset_, array_[bucket_ind].size_);
+  } else {
+    return array_[bucket_ind].first;
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 ValueType HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const {
-  return {};
+  if constexpr (IS_VARLEN) {
+    return array_[bucket_ind].value_;
+  } else {
+    return array_[bucket_ind].second;
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) {
-  return false;
+bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value, uint8_t tag) {
+  if constexpr (IS_VARLEN) {
+    // A full heap makes the page as good as full, and the probe goes on past its empty slots.
+    if (HEAP_BEGIN + HeapSize()->load() + key.GetSize() > HEAP_END) {
+      return false;
+    }
+  }
+  uint8_t control = EMPTY;
+  if (!control_[bucket_ind].compare_exchange_strong(control, CLAIMED)) {
+    return false;
+  }
+  if constexpr (IS_VARLEN) {
+    const size_t offset = HEAP_BEGIN + HeapSize()->fetch_add(key.GetSize());
+    if (offset + key.GetSize() > HEAP_END) {
+      // Another insert took the last of the heap first. The slot is lost, as if its pair had been removed.
+      control_[bucket_ind].store(TOMBSTONE);
+      return false;
+    }
+    memcpy(reinterpret_cast<char *>(this) + offset, key.GetData(), key.GetSize());
+    array_[bucket_ind] = {static_cast<uint16_t>(offset), static_cast<uint16_t>(key.GetSize()), value};
+  } else {
+    array_[bucket_ind] = MappingType(key, value);
+  }
+  control_[bucket_ind].store(READABLE | TagOf(tag));
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {}
+void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  control_[bucket_ind].store(TOMBSTONE);
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const {
-  return false;
+  return control_[bucket_ind].load() != EMPTY;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
-  return false;
+  return (control_[bucket_ind].load() & READABLE) != 0;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -50,5 +86,6 @@ template class HashTableBlockPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class HashTableBlockPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class HashTableBlockPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class HashTableBlockPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBlockPage<VarlenKey, RID, VarlenComparator>;
 
 }  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.cpp
+//
+// Identification: src/storage/page/hash_table_bucket_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_bucket_page.h"
+
+#include <cstring>
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::Init() {
+  memset(readable_, 0, sizeof(readable_));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::GetValue(const KeyType &key, const KeyComparator &comparator,
+                                      std::vector<ValueType> *result) const {
+  bool found = false;
+  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+    if (IsReadable(i) && comparator(array_[i].first, key) == 0) {
+      result->push_back(array_[i].second);
+      found = true;
+    }
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
+  uint32_t free_idx = BUCKET_ARRAY_SIZE;
+  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+    if (!IsReadable(i)) {
+      if (free_idx == BUCKET_ARRAY_SIZE) {
+        free_idx = i;
+      }
+    } else if (comparator(array_[i].first, key) == 0 && array_[i].second == value) {
+      return false;
+    }
+  }
+  if (free_idx == BUCKET_ARRAY_SIZE) {
+    return false;
+  }
+  array_[free_idx] = MappingType(key, value);
+  SetReadable(free_idx, true);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::Remove(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
+  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+    if (IsReadable(i) && comparator(array_[i].first, key) == 0 && array_[i].second == value) {
+      RemoveAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+KeyType HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const {
+  return array_[bucket_idx].first;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+ValueType HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const {
+  return array_[bucket_idx].second;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  SetReadable(bucket_idx, false);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const {
+  return (readable_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx, bool readable) {
+  if (readable) {
+    readable_[bucket_idx / 8] |= static_cast<char>(1 << (bucket_idx % 8));
+  } else {
+    readable_[bucket_idx / 8] &= static_cast<char>(~(1 << (bucket_idx % 8)));
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() const {
+  uint32_t count = 0;
+  for (size_t i = 0; i < sizeof(readable_); i++) {
+    count += __builtin_popcount(static_cast<unsigned char>(readable_[i]));
+  }
+  return count;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::IsFull() const {
+  return NumReadable() == BUCKET_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::IsEmpty() const {
+  for (size_t i = 0; i < sizeof(readable_); i++) {
+    if (readable_[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// DO NOT REMOVE ANYTHING BELOW THIS LINE
+template class HashTableBucketPage<int, int, IntComparator>;
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.cpp
+//
+// Identification: src/storage/page/hash_table_directory_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_directory_page.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void HashTableDirectoryPage::Init(page_id_t page_id, page_id_t bucket_page_id) {
+  page_id_ = page_id;
+  global_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+void HashTableDirectoryPage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+lsn_t HashTableDirectoryPage::GetLSN() const { return lsn_; }
+
+void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepth() const { return global_depth_; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepthMask() const { return (1U << global_depth_) - 1; }
+
+uint32_t HashTableDirectoryPage::Size() const { return 1U << global_depth_; }
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  BUSTUB_ASSERT(global_depth_ < DIRECTORY_MAX_DEPTH, "directory cannot grow past a page");
+  const uint32_t size = Size();
+  memcpy(local_depths_ + size, local_depths_, size * sizeof(local_depths_[0]));
+  memcpy(bucket_page_ids_ + size, bucket_page_ids_, size * sizeof(bucket_page_ids_[0]));
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  BUSTUB_ASSERT(CanShrink(), "a bucket needs all the bits of the global depth");
+  global_depth_--;
+}
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < Size(); i++) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const { return bucket_page_ids_[bucket_idx]; }
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const { return local_depths_[bucket_idx]; }
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
+  local_depths_[bucket_idx] = local_depth;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) const {
+  return (1U << local_depths_[bucket_idx]) - 1;
+}
+
+uint32_t HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const {
+  return bucket_idx ^ (1U << (local_depths_[bucket_idx] - 1));
+}
+
+void HashTableDirectoryPage::VerifyIntegrity() const {
+  // the lowest entry of each bucket, which all its other entries must agree with
+  std::unordered_map<page_id_t, uint32_t> first_entries;
+  for (uint32_t i = 0; i < Size(); i++) {
+    BUSTUB_ASSERT(local_depths_[i] <= global_depth_, "local depth exceeds global depth");
+    [[maybe_unused]] auto first = first_entries.emplace(bucket_page_ids_[i], i).first->second;
+    BUSTUB_ASSERT(local_depths_[i] == local_depths_[first], "entries of a bucket disagree on its local depth");
+    BUSTUB_ASSERT((i & GetLocalDepthMask(i)) == (first & GetLocalDepthMask(i)), "bucket held by a foreign entry");
+  }
+  for ([[maybe_unused]] const auto &[page_id, first] : first_entries) {
+    // A bucket of local depth d is held by 2^(global depth - d) entries.
+    [[maybe_unused]] uint32_t count = 0;
+    for (uint32_t i = 0; i < Size(); i++) {
+      count += bucket_page_ids_[i] == page_id ? 1 : 0;
+    }
+    BUSTUB_ASSERT(count == 1U << (global_depth_ - local_depths_[first]), "bucket missing from some of its entries");
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,510 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.cpp
+//
+// Identification: src/storage/page/pax_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_page.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "storage/table/toast.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return true if the tuple is deleted or empty, see TablePage */
+bool IsDeleted(uint32_t tuple_size) { return (tuple_size & DELETE_MASK) != 0 || tuple_size == 0; }
+
+}  // namespace
+
+uint32_t PaxPage::Layout(const Schema *schema, uint32_t page_size, uint32_t *capacity,
+                         std::vector<ColumnDescriptor> *columns) {
+  // Size the minipages for as many tuples as fit, with varlen values of the expected size.
+  uint32_t tuple_size = sizeof(uint32_t) + schema->GetLength() +
+                        EXPECTED_VARLEN_SIZE * static_cast<uint32_t>(schema->GetUnlinedColumns().size());
+  uint32_t layout_start = SIZE_PAX_PAGE_HEADER + sizeof(ColumnDescriptor) * schema->GetColumnCount();
+  // Leave room for aligning every minipage.
+  uint32_t alignment_slack = alignof(uint64_t) * (schema->GetColumnCount() + 1);
+  *capacity = std::max<uint32_t>(1, (page_size - layout_start - alignment_slack) / tuple_size);
+  uint32_t offset = layout_start + sizeof(uint32_t) * *capacity;
+  for (const Column &column : schema->GetColumns()) {
+    offset = (offset + alignof(uint64_t) - 1) & ~static_cast<uint32_t>(alignof(uint64_t) - 1);
+    if (columns != nullptr) {
+      columns->push_back(ColumnDescriptor{offset, column.GetOffset(), static_cast<uint16_t>(column.GetFixedLength()),
+                                          static_cast<uint16_t>(column.IsInlined() ? 0 : 1)});
+    }
+    offset += column.GetFixedLength() * *capacity;
+  }
+  return offset;
+}
+
+uint32_t PaxPage::GetMaxTupleSize(const Schema *schema) {
+  uint32_t capacity;
+  return schema->GetLength() + PAGE_SIZE - Layout(schema, PAGE_SIZE, &capacity, nullptr);
+}
+
+void PaxPage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager,
+                   Transaction *txn, const Schema *schema) {
+  // Set the page ID.
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  // Log that we are creating a new page.
+  if (enable_logging && log_manager != nullptr) {
+    LogRecord log_record =
+        LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id, page_id);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  // Set the previous and next page IDs.
+  SetPrevPageId(prev_page_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  // Lay the minipages out.
+  uint32_t capacity;
+  std::vector<ColumnDescriptor> columns;
+  Layout(schema, page_size, &capacity, &columns);
+  SetHeaderField(OFFSET_TUPLE_COUNT, 0);
+  SetHeaderField(OFFSET_USED_SLOTS, 0);
+  SetHeaderField(OFFSET_CAPACITY, capacity);
+  SetHeaderField(OFFSET_COLUMN_COUNT, schema->GetColumnCount());
+  SetHeaderField(OFFSET_VARLEN_POINTER, page_size);
+  SetHeaderField(OFFSET_FRAGMENTED_SPACE, 0);
+  memcpy(GetColumnDescriptor(0), columns.data(), sizeof(ColumnDescriptor) * columns.size());
+  memset(GetSlots(), 0, sizeof(uint32_t) * capacity);
+}
+
+uint32_t PaxPage::GetInlineLength() {
+  if (GetColumnCount() == 0) {
+    return 0;
+  }
+  const ColumnDescriptor &last = *GetColumnDescriptor(GetColumnCount() - 1);
+  return last.tuple_offset_ + last.width_;
+}
+
+uint32_t PaxPage::GetMinipagesEnd() {
+  if (GetColumnCount() == 0) {
+    return reinterpret_cast<char *>(GetSlots() + GetCapacity()) - GetData();
+  }
+  const ColumnDescriptor &last = *GetColumnDescriptor(GetColumnCount() - 1);
+  return last.minipage_offset_ + last.width_ * GetCapacity();
+}
+
+uint32_t PaxPage::GetVarlenSize(uint32_t slot_num) {
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    const ColumnDescriptor &column = *GetColumnDescriptor(i);
+    if (column.is_varlen_ != 0) {
+      size += Toast::StoredSize(GetData() + GetVarlenOffset(column, slot_num));
+    }
+  }
+  return size;
+}
+
+void PaxPage::WriteTuple(const Tuple &tuple, uint32_t slot_num) {
+  // If the space is there but not in one piece, fill in the holes first.
+  if (GetVarlenPointer() - GetMinipagesEnd() < tuple.size_ - GetInlineLength()) {
+    Compact();
+  }
+  uint32_t size = GetInlineLength();
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    const ColumnDescriptor &column = *GetColumnDescriptor(i);
+    if (column.is_varlen_ == 0) {
+      memcpy(GetColumnData(column, slot_num), tuple.data_ + column.tuple_offset_, column.width_);
+      continue;
+    }
+    const char *stored = tuple.data_ + *reinterpret_cast<const uint32_t *>(tuple.data_ + column.tuple_offset_);
+    uint32_t stored_size = Toast::StoredSize(stored);
+    uint32_t varlen_pointer = GetVarlenPointer() - stored_size;
+    memcpy(GetData() + varlen_pointer, stored, stored_size);
+    SetHeaderField(OFFSET_VARLEN_POINTER, varlen_pointer);
+    memcpy(GetColumnData(column, slot_num), &varlen_pointer, sizeof(uint32_t));
+    size += stored_size;
+  }
+  SetTupleSize(slot_num, size);
+}
+
+void PaxPage::FreeVarlenValues(uint32_t slot_num) {
+  SetHeaderField(OFFSET_FRAGMENTED_SPACE, GetFragmentedSpace() + GetVarlenSize(slot_num));
+}
+
+void PaxPage::ReadTuple(uint32_t slot_num, const std::vector<uint32_t> &column_ids, bool all, char *dest,
+                        uint32_t size) {
+  uint32_t offset = GetInlineLength();
+  auto read_column = [&](uint32_t column_idx) {
+    const ColumnDescriptor &column = *GetColumnDescriptor(column_idx);
+    if (column.is_varlen_ == 0) {
+      memcpy(dest + column.tuple_offset_, GetColumnData(column, slot_num), column.width_);
+      return;
+    }
+    const char *stored = GetData() + GetVarlenOffset(column, slot_num);
+    uint32_t stored_size = Toast::StoredSize(stored);
+    memcpy(dest + offset, stored, stored_size);
+    memcpy(dest + column.tuple_offset_, &offset, sizeof(uint32_t));
+    offset += stored_size;
+  };
+  if (all) {
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      read_column(i);
+    }
+    BUSTUB_ASSERT(offset == size, "The values must fill the tuple exactly.");
+    return;
+  }
+  // The columns not read are zero, and the varlen ones point to a NULL value at the end of the tuple.
+  memset(dest, 0, offset);
+  uint32_t null_offset = size - sizeof(uint32_t);
+  uint32_t null_length = BUSTUB_VALUE_NULL;
+  memcpy(dest + null_offset, &null_length, sizeof(uint32_t));
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    const ColumnDescriptor &column = *GetColumnDescriptor(i);
+    if (column.is_varlen_ != 0) {
+      memcpy(dest + column.tuple_offset_, &null_offset, sizeof(uint32_t));
+    }
+  }
+  for (uint32_t column_idx : column_ids) {
+    read_column(column_idx);
+  }
+  BUSTUB_ASSERT(offset == null_offset, "The values must fill the tuple exactly.");
+}
+
+void PaxPage::Compact() {
+  // Move the values from the end of the page on, so that none is overwritten before it is moved.
+  std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> values;  // offset, slot, column
+  for (uint32_t slot_num = 0; slot_num < GetTupleCount(); slot_num++) {
+    if (GetTupleSize(slot_num) == 0) {
+      continue;
+    }
+    for (uint32_t i = 0; i < GetColumnCount(); i++) {
+      const ColumnDescriptor &column = *GetColumnDescriptor(i);
+      if (column.is_varlen_ != 0) {
+        values.emplace_back(GetVarlenOffset(column, slot_num), slot_num, i);
+      }
+    }
+  }
+  std::sort(values.begin(), values.end(), std::greater<>());
+  uint32_t varlen_pointer = PAGE_SIZE;
+  for (const auto &[offset, slot_num, column_idx] : values) {
+    uint32_t stored_size = Toast::StoredSize(GetData() + offset);
+    varlen_pointer -= stored_size;
+    memmove(GetData() + varlen_pointer, GetData() + offset, stored_size);
+    memcpy(GetColumnData(*GetColumnDescriptor(column_idx), slot_num), &varlen_pointer, sizeof(uint32_t));
+  }
+  SetHeaderField(OFFSET_VARLEN_POINTER, varlen_pointer);
+  SetHeaderField(OFFSET_FRAGMENTED_SPACE, 0);
+}
+
+bool PaxPage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
+                          LogManager *log_manager) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  // If there is no free slot or not enough space, then return false.
+  if (GetUsedSlots() == GetCapacity() || !Fits(tuple, 0)) {
+    return false;
+  }
+
+  // Find a free slot, reusing an empty one before the end.
+  uint32_t i;
+  for (i = 0; i < GetTupleCount(); i++) {
+    if (GetTupleSize(i) == 0) {
+      break;
+    }
+  }
+  WriteTuple(tuple, i);
+  rid->Set(GetTablePageId(), i);
+  if (i == GetTupleCount()) {
+    SetHeaderField(OFFSET_TUPLE_COUNT, i + 1);
+  }
+  SetHeaderField(OFFSET_USED_SLOTS, GetUsedSlots() + 1);
+
+  // Write the log record.
+  if (enable_logging) {
+    BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
+    // Acquire an exclusive lock on the new tuple.
+    bool locked = lock_manager == nullptr || lock_manager->LockExclusive(txn, *rid);
+    BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
+    if (log_manager != nullptr) {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+  return true;
+}
+
+bool PaxPage::AppendTuple(const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t i = GetTupleCount();
+  if (i == GetCapacity() || !Fits(tuple, 0)) {
+    return false;
+  }
+  WriteTuple(tuple, i);
+  SetHeaderField(OFFSET_TUPLE_COUNT, i + 1);
+  SetHeaderField(OFFSET_USED_SLOTS, GetUsedSlots() + 1);
+  rid->Set(GetTablePageId(), i);
+  return true;
+}
+
+void PaxPage::LogPageImage(Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && log_manager != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::PAGEIMAGE, GetTablePageId(),
+                         GetData());
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+}
+
+bool PaxPage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is already deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  if (enable_logging) {
+    // Acquire an exclusive lock, upgrading from a shared lock if necessary.
+    if (lock_manager == nullptr) {
+      // A table lock of the transaction covers the tuple.
+    } else if (txn->IsSharedLocked(rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid)) {
+        return false;
+      }
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+      return false;
+    }
+    if (log_manager != nullptr) {
+      Tuple dummy_tuple;
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+
+  // Mark the tuple as deleted.
+  SetTupleSize(slot_num, GetTupleSize(slot_num) | DELETE_MASK);
+  return true;
+}
+
+bool PaxPage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                          LockManager *lock_manager, LogManager *log_manager) {
+  BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  // If there is not enough space to update, we need to update via delete followed by an insert (not enough space).
+  if (!Fits(new_tuple, GetVarlenSize(slot_num))) {
+    return false;
+  }
+
+  // Copy out the old value.
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  old_tuple->FreeData();
+  old_tuple->size_ = tuple_size;
+  old_tuple->data_ = Tuple::AllocateData(tuple_size);
+  ReadTuple(slot_num, {}, true, old_tuple->data_, tuple_size);
+  old_tuple->rid_ = rid;
+  old_tuple->allocated_ = true;
+
+  if (enable_logging) {
+    // Acquire an exclusive lock, upgrading from shared if necessary.
+    if (lock_manager == nullptr) {
+      // A table lock of the transaction covers the tuple.
+    } else if (txn->IsSharedLocked(rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid)) {
+        return false;
+      }
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+      return false;
+    }
+    if (log_manager != nullptr) {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::DELTAUPDATE, rid, *old_tuple,
+                           new_tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+
+  // Perform the update: the old varlen values become holes, and the slot is empty while the page may be compacted.
+  FreeVarlenValues(slot_num);
+  SetTupleSize(slot_num, 0);
+  WriteTuple(new_tuple, slot_num);
+  return true;
+}
+
+void PaxPage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+  // Either commit a delete, or roll back an insert.
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+    // We need to copy out the deleted tuple for undo purposes.
+    Tuple delete_tuple = CopyOutTuple(rid);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  FreeVarlenValues(slot_num);
+  SetTupleSize(slot_num, 0);
+  SetHeaderField(OFFSET_USED_SLOTS, GetUsedSlots() - 1);
+  // Drop the empty slots at the end.
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  SetHeaderField(OFFSET_TUPLE_COUNT, tuple_count);
+}
+
+void PaxPage::ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    std::vector<std::pair<RID, Tuple>> delete_tuples;
+    delete_tuples.reserve(rids.size());
+    for (const RID &rid : rids) {
+      BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+      delete_tuples.emplace_back(rid, CopyOutTuple(rid));
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETES, GetTablePageId(),
+                         std::move(delete_tuples));
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  // Logged already, all at once.
+  for (const RID &rid : rids) {
+    ApplyDelete(rid, nullptr, nullptr);
+  }
+}
+
+Tuple PaxPage::CopyOutTuple(const RID &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  Tuple tuple;
+  tuple.size_ = GetTupleSize(slot_num) & ~static_cast<uint32_t>(DELETE_MASK);
+  tuple.data_ = Tuple::AllocateData(tuple.size_);
+  ReadTuple(slot_num, {}, true, tuple.data_, tuple.size_);
+  tuple.rid_ = rid;
+  tuple.allocated_ = true;
+  return tuple;
+}
+
+void PaxPage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  // Log the rollback.
+  if (enable_logging && log_manager != nullptr) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
+  // Unset the deleted flag.
+  SetTupleSize(slot_num, GetTupleSize(slot_num) & ~static_cast<uint32_t>(DELETE_MASK));
+}
+
+bool PaxPage::CheckRead(const RID &rid, Transaction *txn, LockManager *lock_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  // Otherwise we have a valid tuple, try to acquire at least a shared lock.
+  if (enable_logging) {
+    if (lock_manager != nullptr && !txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) &&
+        !lock_manager->LockShared(txn, rid)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PaxPage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  if (!CheckRead(rid, txn, lock_manager)) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(rid.GetSlotNum());
+  tuple->FreeData();
+  tuple->size_ = tuple_size;
+  tuple->data_ = Tuple::AllocateData(tuple_size);
+  ReadTuple(rid.GetSlotNum(), {}, true, tuple->data_, tuple_size);
+  tuple->rid_ = rid;
+  tuple->allocated_ = true;
+  return true;
+}
+
+bool PaxPage::GetTupleColumns(const RID &rid, const std::vector<uint32_t> &column_ids, std::vector<char> *buffer,
+                              Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  if (!CheckRead(rid, txn, lock_manager)) {
+    return false;
+  }
+  uint32_t tuple_size = GetInlineLength() + sizeof(uint32_t);
+  for (uint32_t column_idx : column_ids) {
+    const ColumnDescriptor &column = *GetColumnDescriptor(column_idx);
+    if (column.is_varlen_ != 0) {
+      tuple_size += Toast::StoredSize(GetData() + GetVarlenOffset(column, rid.GetSlotNum()));
+    }
+  }
+  if (buffer->size() < tuple_size) {
+    buffer->resize(tuple_size);
+  }
+  ReadTuple(rid.GetSlotNum(), column_ids, false, buffer->data(), tuple_size);
+  tuple->FreeData();
+  tuple->size_ = tuple_size;
+  tuple->data_ = buffer->data();
+  tuple->rid_ = rid;
+  tuple->allocated_ = false;
+  return true;
+}
+
+bool PaxPage::GetFirstTupleRid(RID *first_rid) {
+  // Find and return the first valid tuple.
+  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
+    if (!IsDeleted(GetTupleSize(i))) {
+      first_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool PaxPage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  // Find and return the first valid tuple after our current slot number.
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
+    if (!IsDeleted(GetTupleSize(i))) {
+      next_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  // Otherwise return false as there are no more tuples.
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+}  // namespace bustub
@@ -12,7 +12,10 @@
 
 #include "storage/page/table_page.h"
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
+#include <vector>
 
 namespace bustub {
 
@@ -21,7 +24,7 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
   // Set the page ID.
   memcpy(GetData(), &page_id, sizeof(page_id));
   // Log that we are creating a new page.
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
     LogRecord log_record =
         LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id, page_id);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
@@ -33,16 +36,12 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(page_size);
   SetTupleCount(0);
+  SetFragmentedSpace(0);
 }
 
 bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
                             LogManager *log_manager) {
   BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
-  // If there is not enough space, then return false.
-  if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
-    return false;
-  }
-
   // Try to find a free slot to reuse.
   uint32_t i;
   for (i = 0; i < GetTupleCount(); i++) {
@@ -53,10 +52,16 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
     }
   }
 
-  // If there was no free slot left, and we cannot claim it from the free space, then we give up.
-  if (i == GetTupleCount() && GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
+  // If there was no free slot left, the new slot takes room in the slot array too.
+  uint32_t space_needed = i == GetTupleCount() ? tuple.size_ + SIZE_TUPLE : tuple.size_;
+  // If there is not enough space, then return false.
+  if (GetFreeSpaceRemaining() < space_needed) {
     return false;
   }
+  // If the space is there but not in one piece, fill in the holes first.
+  if (GetContiguousFreeSpace() < space_needed) {
+    Compact();
+  }
 
   // Otherwise we claim available free space..
   SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
@@ -72,24 +77,80 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   }
 
   // Write the log record.
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr) {
     BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
     // Acquire an exclusive lock on the new tuple.
-    bool locked = lock_manager->LockExclusive(txn, *rid);
+    bool locked = lock_manager == nullptr || lock_manager->LockExclusive(txn, *rid);
     BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
-    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
+    if (log_manager != nullptr) {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+  return true;
+}
+
+bool TablePage::AppendTuple(const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  if (GetContiguousFreeSpace() < tuple.size_ + SIZE_TUPLE) {
+    return false;
+  }
+  uint32_t i = GetTupleCount();
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffsetAtSlot(i, GetFreeSpacePointer());
+  SetTupleSize(i, tuple.size_);
+  SetTupleCount(i + 1);
+  rid->Set(GetTablePageId(), i);
+  return true;
+}
+
+bool TablePage::RestoreTuple(const Tuple &tuple, const RID &rid) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  const uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num < GetTupleCount() && GetTupleSize(slot_num) != 0) {
+    return false;
+  }
+  // The empty slots up to it may have been trimmed since.
+  const uint32_t num_new_slots = slot_num < GetTupleCount() ? 0 : slot_num + 1 - GetTupleCount();
+  const uint32_t space_needed = tuple.size_ + num_new_slots * SIZE_TUPLE;
+  if (GetFreeSpaceRemaining() < space_needed) {
+    return false;
+  }
+  if (GetContiguousFreeSpace() < space_needed) {
+    Compact();
+  }
+  for (uint32_t i = GetTupleCount(); i < slot_num; i++) {
+    SetTupleOffsetAtSlot(i, 0);
+    SetTupleSize(i, 0);
+  }
+  if (num_new_slots > 0) {
+    SetTupleCount(slot_num + 1);
+  }
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size_);
+  return true;
+}
+
+void TablePage::LogPageImage(Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::PAGEIMAGE, GetTablePageId(),
+                         GetData());
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
     SetLSN(lsn);
     txn->SetPrevLSN(lsn);
   }
-  return true;
 }
 
 bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
   if (slot_num >= GetTupleCount()) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
@@ -98,26 +159,30 @@ bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_m
   uint32_t tuple_size = GetTupleSize(slot_num);
   // If the tuple is already deleted, abort the transaction.
   if (IsDeleted(tuple_size)) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
   }
 
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr) {
     // Acquire an exclusive lock, upgrading from a shared lock if necessary.
-    if (txn->IsSharedLocked(rid)) {
+    if (lock_manager == nullptr) {
+      // A table lock of the transaction covers the tuple.
+    } else if (txn->IsSharedLocked(rid)) {
       if (!lock_manager->LockUpgrade(txn, rid)) {
         return false;
       }
     } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
       return false;
     }
-    Tuple dummy_tuple;
-    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
-    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
-    SetLSN(lsn);
-    txn->SetPrevLSN(lsn);
+    if (log_manager != nullptr) {
+      Tuple dummy_tuple;
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
   }
 
   // Mark the tuple as deleted.
@@ -133,7 +198,7 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
   if (slot_num >= GetTupleCount()) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
@@ -141,7 +206,7 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   uint32_t tuple_size = GetTupleSize(slot_num);
   // If the tuple is deleted, abort the transaction.
   if (IsDeleted(tuple_size)) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
@@ -153,47 +218,105 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
 
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  old_tuple->FreeData();
   old_tuple->size_ = tuple_size;
-  if (old_tuple->allocated_) {
-    delete[] old_tuple->data_;
-  }
-  old_tuple->data_ = new char[old_tuple->size_];
+  old_tuple->data_ = Tuple::AllocateData(old_tuple->size_);
   memcpy(old_tuple->data_, GetData() + tuple_offset, old_tuple->size_);
   old_tuple->rid_ = rid;
   old_tuple->allocated_ = true;
 
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr) {
     // Acquire an exclusive lock, upgrading from shared if necessary.
-    if (txn->IsSharedLocked(rid)) {
+    if (lock_manager == nullptr) {
+      // A table lock of the transaction covers the tuple.
+    } else if (txn->IsSharedLocked(rid)) {
       if (!lock_manager->LockUpgrade(txn, rid)) {
         return false;
       }
     } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
       return false;
     }
-    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
-    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
-    SetLSN(lsn);
-    txn->SetPrevLSN(lsn);
+    if (log_manager != nullptr) {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::DELTAUPDATE, rid, *old_tuple,
+                           new_tuple);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
   }
 
   // Perform the update.
-  uint32_t free_space_pointer = GetFreeSpacePointer();
-  BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
-
-  memmove(GetData() + free_space_pointer + tuple_size - new_tuple.size_, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size - new_tuple.size_);
-  memcpy(GetData() + tuple_offset + tuple_size - new_tuple.size_, new_tuple.data_, new_tuple.size_);
+  BUSTUB_ASSERT(tuple_offset >= GetFreeSpacePointer(), "Offset should appear after current free space position.");
+  if (new_tuple.size_ <= tuple_size) {
+    // A tuple that does not grow is updated in place, the rest of its old space becomes a hole.
+    memcpy(GetData() + tuple_offset, new_tuple.data_, new_tuple.size_);
+    SetFragmentedSpace(GetFragmentedSpace() + tuple_size - new_tuple.size_);
+  } else {
+    // A tuple that grows moves to the free space, leaving its old space as a hole to compact if need be.
+    SetTupleSize(slot_num, 0);
+    SetFragmentedSpace(GetFragmentedSpace() + tuple_size);
+    if (GetContiguousFreeSpace() < new_tuple.size_) {
+      Compact();
+    }
+    SetFreeSpacePointer(GetFreeSpacePointer() - new_tuple.size_);
+    memcpy(GetData() + GetFreeSpacePointer(), new_tuple.data_, new_tuple.size_);
+    SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  }
   SetTupleSize(slot_num, new_tuple.size_);
+  return true;
+}
 
-  // Update all tuple offsets.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) > 0 && tuple_offset_i < tuple_offset + tuple_size) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size - new_tuple.size_);
+bool TablePage::IncrementTuple(const std::vector<ColumnIncrement> &increments, bool undo, const RID &rid,
+                               Tuple *old_tuple, Tuple *new_tuple, Transaction *txn, LockManager *lock_manager,
+                               LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    if (enable_logging && txn != nullptr) {
+      txn->SetState(TransactionState::ABORTED);
     }
+    return false;
   }
+  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  // Only the increments are checked at run time, the recovery repeats what was done.
+  if (!undo && txn != nullptr && !IncrementsFit(increments, GetData() + tuple_offset)) {
+    return false;
+  }
+
+  // Copy out the old value, and increment it.
+  old_tuple->FreeData();
+  old_tuple->size_ = tuple_size;
+  old_tuple->data_ = Tuple::AllocateData(old_tuple->size_);
+  memcpy(old_tuple->data_, GetData() + tuple_offset, old_tuple->size_);
+  old_tuple->rid_ = rid;
+  old_tuple->allocated_ = true;
+  *new_tuple = *old_tuple;
+  ApplyIncrements(increments, undo, new_tuple->data_);
+
+  if (enable_logging && txn != nullptr) {
+    // Acquire an increment lock, or an exclusive one if the tuple was read.
+    if (lock_manager != nullptr && !txn->IsExclusiveLocked(rid) && !txn->IsIncrementLocked(rid) &&
+        !lock_manager->LockIncrement(txn, rid)) {
+      return false;
+    }
+    if (log_manager != nullptr) {
+      // The record holds the increments as they are applied, an undo logging them taken out.
+      std::vector<ColumnIncrement> applied = increments;
+      if (undo) {
+        for (ColumnIncrement &increment : applied) {
+          increment.amount_ = -increment.amount_;
+        }
+      }
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INCREMENT, rid, applied);
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+  }
+
+  // Perform the increment, in place: the size of the tuple does not change.
+  memcpy(GetData() + tuple_offset, new_tuple->data_, tuple_size);
   return true;
 }
 
@@ -209,17 +332,11 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
   }
   // Otherwise we are rolling back an insert.
 
-  // We need to copy out the deleted tuple for undo purposes.
-  Tuple delete_tuple;
-  delete_tuple.size_ = tuple_size;
-  delete_tuple.data_ = new char[delete_tuple.size_];
-  memcpy(delete_tuple.data_, GetData() + tuple_offset, delete_tuple.size_);
-  delete_tuple.rid_ = rid;
-  delete_tuple.allocated_ = true;
-
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
     BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
 
+    // We need to copy out the deleted tuple for undo purposes.
+    Tuple delete_tuple = CopyOutTuple(rid);
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
     SetLSN(lsn);
@@ -229,24 +346,82 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
   uint32_t free_space_pointer = GetFreeSpacePointer();
   BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
 
-  memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
-          tuple_offset - free_space_pointer);
-  SetFreeSpacePointer(free_space_pointer + tuple_size);
+  // Rather than shifting the tuples below it, the tuple leaves a hole, unless it borders the free space.
+  if (tuple_offset == free_space_pointer) {
+    SetFreeSpacePointer(free_space_pointer + tuple_size);
+  } else {
+    SetFragmentedSpace(GetFragmentedSpace() + tuple_size);
+  }
   SetTupleSize(slot_num, 0);
   SetTupleOffsetAtSlot(slot_num, 0);
+  TrimEmptySlots();
+}
 
-  // Update all tuple offsets.
+void TablePage::ApplyDeletes(const std::vector<RID> &rids, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
+    std::vector<std::pair<RID, Tuple>> delete_tuples;
+    delete_tuples.reserve(rids.size());
+    for (const RID &rid : rids) {
+      BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+      delete_tuples.emplace_back(rid, CopyOutTuple(rid));
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETES, GetTablePageId(),
+                         std::move(delete_tuples));
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  // Logged already, all at once.
+  for (const RID &rid : rids) {
+    ApplyDelete(rid, nullptr, nullptr);
+  }
+}
+
+Tuple TablePage::CopyOutTuple(const RID &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  Tuple tuple;
+  tuple.size_ = UnsetDeletedFlag(GetTupleSize(slot_num));
+  tuple.data_ = Tuple::AllocateData(tuple.size_);
+  memcpy(tuple.data_, GetData() + GetTupleOffsetAtSlot(slot_num), tuple.size_);
+  tuple.rid_ = rid;
+  tuple.allocated_ = true;
+  return tuple;
+}
+
+void TablePage::Compact() {
+  // Move the tuples from the end of the page on, so that none is overwritten before it is moved.
+  std::vector<uint32_t> slots;
+  slots.reserve(GetTupleCount());
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    uint32_t tuple_offset_i = GetTupleOffsetAtSlot(i);
-    if (GetTupleSize(i) != 0 && tuple_offset_i < tuple_offset) {
-      SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
+    if (GetTupleSize(i) != 0) {
+      slots.push_back(i);
     }
   }
+  std::sort(slots.begin(), slots.end(),
+            [this](uint32_t a, uint32_t b) { return GetTupleOffsetAtSlot(a) > GetTupleOffsetAtSlot(b); });
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (uint32_t slot_num : slots) {
+    // Tuples marked as deleted keep their space until the delete is applied.
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot_num));
+    free_space_pointer -= tuple_size;
+    memmove(GetData() + free_space_pointer, GetData() + GetTupleOffsetAtSlot(slot_num), tuple_size);
+    SetTupleOffsetAtSlot(slot_num, free_space_pointer);
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  SetFragmentedSpace(0);
+}
+
+void TablePage::TrimEmptySlots() {
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  SetTupleCount(tuple_count);
 }
 
 void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
   // Log the rollback.
-  if (enable_logging) {
+  if (enable_logging && txn != nullptr && log_manager != nullptr) {
     BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
     Tuple dummy_tuple;
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
@@ -266,11 +441,26 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log
 }
 
 bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  Tuple view;
+  if (!GetTupleView(rid, &view, txn, lock_manager)) {
+    return false;
+  }
+  // Copy the tuple data into our result.
+  tuple->FreeData();
+  tuple->size_ = view.size_;
+  tuple->data_ = Tuple::AllocateData(tuple->size_);
+  memcpy(tuple->data_, view.data_, tuple->size_);
+  tuple->rid_ = rid;
+  tuple->allocated_ = true;
+  return true;
+}
+
+bool TablePage::GetTupleView(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
   // Get the current slot number.
   uint32_t slot_num = rid.GetSlotNum();
   // If somehow we have more slots than tuples, abort the transaction.
   if (slot_num >= GetTupleCount()) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
@@ -279,29 +469,27 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   uint32_t tuple_size = GetTupleSize(slot_num);
   // If the tuple is deleted, abort the transaction.
   if (IsDeleted(tuple_size)) {
-    if (enable_logging) {
+    if (enable_logging && txn != nullptr) {
       txn->SetState(TransactionState::ABORTED);
     }
     return false;
   }
 
   // Otherwise we have a valid tuple, try to acquire at least a shared lock.
-  if (enable_logging) {
-    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid)) {
+  if (enable_logging && txn != nullptr) {
+    if (lock_manager != nullptr && !txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) &&
+        !lock_manager->LockShared(txn, rid)) {
       return false;
     }
   }
 
-  // At this point, we have at least a shared lock on the RID. Copy the tuple data into our result.
+  // At this point, we have at least a shared lock on the RID. Point our result at the tuple data.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  tuple->FreeData();
   tuple->size_ = tuple_size;
-  if (tuple->allocated_) {
-    delete[] tuple->data_;
-  }
-  tuple->data_ = new char[tuple->size_];
-  memcpy(tuple->data_, GetData() + tuple_offset, tuple->size_);
+  tuple->data_ = GetData() + tuple_offset;
   tuple->rid_ = rid;
-  tuple->allocated_ = true;
+  tuple->allocated_ = false;
   return true;
 }
 
@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+bool FreeSpaceMap::Create() {
+  std::scoped_lock lock(latch_);
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->Init();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  pages_.push_back(MapPage{page_id, 0});
+  return true;
+}
+
+void FreeSpaceMap::Open(page_id_t first_page_id) {
+  std::scoped_lock lock(latch_);
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    FreeSpaceMapPage *map_page = FetchMapPage(page_id);
+    BUSTUB_ASSERT(map_page != nullptr, "Couldn't fetch a page of the free-space map.");
+    for (uint32_t i = 0; i < map_page->GetCount(); i++) {
+      if (map_page->HeapPageIdAt(i) == INVALID_PAGE_ID) {
+        continue;
+      }
+      entries_[map_page->HeapPageIdAt(i)] = pages_.size() * FreeSpaceMapPage::ENTRIES + i;
+      last_heap_page_id_ = map_page->HeapPageIdAt(i);
+    }
+    pages_.push_back(MapPage{page_id, map_page->MaxCategory()});
+    page_id_t next_page_id = map_page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+bool FreeSpaceMap::IsOpen() {
+  std::scoped_lock lock(latch_);
+  return !pages_.empty();
+}
+
+page_id_t FreeSpaceMap::GetFirstPageId() {
+  std::scoped_lock lock(latch_);
+  return pages_.empty() ? INVALID_PAGE_ID : pages_.front().page_id_;
+}
+
+page_id_t FreeSpaceMap::GetLastHeapPageId() {
+  std::scoped_lock lock(latch_);
+  return last_heap_page_id_;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t free_bytes) {
+  uint8_t category = FreeSpaceMapPage::CategoryFor(free_bytes);
+  std::scoped_lock lock(latch_);
+  for (MapPage &page : pages_) {
+    if (page.max_category_ < category) {
+      continue;
+    }
+    FreeSpaceMapPage *map_page = FetchMapPage(page.page_id_);
+    if (map_page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    uint32_t idx = map_page->Find(category);
+    page_id_t heap_page_id = idx == map_page->GetCount() ? INVALID_PAGE_ID : map_page->HeapPageIdAt(idx);
+    // The largest category only overestimates, refresh it since the page is at hand.
+    page.max_category_ = map_page->MaxCategory();
+    buffer_pool_manager_->UnpinPage(page.page_id_, false);
+    if (heap_page_id != INVALID_PAGE_ID) {
+      return heap_page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+bool FreeSpaceMap::Update(page_id_t heap_page_id, uint32_t free_bytes) {
+  uint8_t category = FreeSpaceMapPage::CategoryOf(free_bytes);
+  std::scoped_lock lock(latch_);
+  auto entry = entries_.find(heap_page_id);
+  if (entry == entries_.end()) {
+    return Append(heap_page_id, category);
+  }
+  MapPage &page = pages_[entry->second / FreeSpaceMapPage::ENTRIES];
+  FreeSpaceMapPage *map_page = FetchMapPage(page.page_id_);
+  if (map_page == nullptr) {
+    return false;
+  }
+  uint32_t idx = entry->second % FreeSpaceMapPage::ENTRIES;
+  bool is_dirty = map_page->CategoryAt(idx) != category;
+  map_page->SetCategoryAt(idx, category);
+  page.max_category_ = std::max(page.max_category_, category);
+  buffer_pool_manager_->UnpinPage(page.page_id_, is_dirty);
+  return true;
+}
+
+void FreeSpaceMap::Remove(page_id_t heap_page_id) {
+  std::scoped_lock lock(latch_);
+  auto entry = entries_.find(heap_page_id);
+  if (entry == entries_.end()) {
+    return;
+  }
+  const MapPage &page = pages_[entry->second / FreeSpaceMapPage::ENTRIES];
+  FreeSpaceMapPage *map_page = FetchMapPage(page.page_id_);
+  if (map_page == nullptr) {
+    return;
+  }
+  // Of category 0, the entry is never handed out to an insert, which always needs some space.
+  uint32_t idx = entry->second % FreeSpaceMapPage::ENTRIES;
+  map_page->SetHeapPageIdAt(idx, INVALID_PAGE_ID);
+  map_page->SetCategoryAt(idx, 0);
+  buffer_pool_manager_->UnpinPage(page.page_id_, true);
+  entries_.erase(entry);
+}
+
+std::vector<page_id_t> FreeSpaceMap::GetHeapPageIds() {
+  std::scoped_lock lock(latch_);
+  std::vector<std::pair<size_t, page_id_t>> entries;
+  entries.reserve(entries_.size());
+  for (const auto &[heap_page_id, entry] : entries_) {
+    entries.emplace_back(entry, heap_page_id);
+  }
+  std::sort(entries.begin(), entries.end());
+  std::vector<page_id_t> heap_page_ids;
+  heap_page_ids.reserve(entries.size());
+  for (const auto &entry : entries) {
+    heap_page_ids.push_back(entry.second);
+  }
+  return heap_page_ids;
+}
+
+bool FreeSpaceMap::Append(page_id_t heap_page_id, uint8_t category) {
+  BUSTUB_ASSERT(!pages_.empty(), "The free-space map is not open.");
+  FreeSpaceMapPage *map_page = FetchMapPage(pages_.back().page_id_);
+  if (map_page == nullptr) {
+    return false;
+  }
+  if (map_page->IsFull()) {
+    page_id_t page_id;
+    Page *page = buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      buffer_pool_manager_->UnpinPage(pages_.back().page_id_, false);
+      return false;
+    }
+    map_page->SetNextPageId(page_id);
+    buffer_pool_manager_->UnpinPage(pages_.back().page_id_, true);
+    map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    map_page->Init();
+    pages_.push_back(MapPage{page_id, 0});
+  }
+  uint32_t idx = map_page->Append(heap_page_id, category);
+  entries_[heap_page_id] = (pages_.size() - 1) * FreeSpaceMapPage::ENTRIES + idx;
+  last_heap_page_id_ = heap_page_id;
+  pages_.back().max_category_ = std::max(pages_.back().max_category_, category);
+  buffer_pool_manager_->UnpinPage(pages_.back().page_id_, true);
+  return true;
+}
+
+}  // namespace bustub
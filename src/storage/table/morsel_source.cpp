@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel_source.cpp
+//
+// Identification: src/storage/table/morsel_source.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/morsel_source.h"
+
+#include <cassert>
+#include <utility>
+
+namespace bustub {
+
+MorselSource::MorselSource(TableHeap *table_heap, size_t morsel_size)
+    : MorselSource(std::vector<TableHeap *>{table_heap}, morsel_size) {}
+
+MorselSource::MorselSource(std::vector<TableHeap *> table_heaps, size_t morsel_size)
+    : table_heaps_(std::move(table_heaps)), morsel_size_(morsel_size) {
+  if (!table_heaps_.empty()) {
+    next_page_id_ = table_heaps_[0]->GetFirstPageId();
+  }
+}
+
+bool MorselSource::Next(std::vector<page_id_t> *pages, BufferRing *ring, size_t *index, size_t *heap_idx) {
+  pages->clear();
+  std::scoped_lock lock(latch_);
+  while (next_page_id_ == INVALID_PAGE_ID && heap_idx_ + 1 < table_heaps_.size()) {
+    next_page_id_ = table_heaps_[++heap_idx_]->GetFirstPageId();
+  }
+  if (next_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  TableHeap *table_heap = table_heaps_[heap_idx_];
+  while (pages->size() < morsel_size_ && next_page_id_ != INVALID_PAGE_ID) {
+    page_id_t next_page_id;
+    if (table_heap->GetZoneMap()->GetNextPageId(next_page_id_, &next_page_id)) {
+      pages->push_back(next_page_id_);
+      next_page_id_ = next_page_id;
+      continue;
+    }
+    auto page = static_cast<TablePage *>(table_heap->buffer_pool_manager_->FetchPageWithRing(next_page_id_, ring));
+    assert(page != nullptr);  // all pages are pinned
+    page->RLatch();
+    pages->push_back(next_page_id_);
+    next_page_id_ = page->GetNextPageId();
+    page->RUnlatch();
+    table_heap->buffer_pool_manager_->UnpinPage(pages->back(), false);
+  }
+  if (index != nullptr) {
+    *index = num_claimed_;
+  }
+  if (heap_idx != nullptr) {
+    *heap_idx = heap_idx_;
+  }
+  num_claimed_++;
+  return true;
+}
+
+}  // namespace bustub
@@ -10,87 +10,386 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
+#include "storage/table/toast.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return the chains that are not among the kept ones */
+std::vector<page_id_t> Subtract(std::vector<page_id_t> chains, const std::vector<page_id_t> &kept) {
+  chains.erase(std::remove_if(chains.begin(), chains.end(),
+                              [&kept](page_id_t page_id) {
+                                return std::find(kept.begin(), kept.end(), page_id) != kept.end();
+                              }),
+               chains.end());
+  return chains;
+}
+
+}  // namespace
+
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     page_id_t first_page_id)
+                     page_id_t first_page_id, page_id_t free_space_map_page_id, const Schema *pax_schema)
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id),
+      pax_schema_(pax_schema == nullptr ? nullptr : std::make_unique<const Schema>(*pax_schema)),
+      max_tuple_size_(pax_schema == nullptr ? MAX_TUPLE_SIZE : PaxPage::GetMaxTupleSize(pax_schema)),
+      free_space_map_page_id_(free_space_map_page_id),
+      free_space_map_(buffer_pool_manager) {
+  ResetInsertPages();
+}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
+                     Transaction *txn, const Schema *pax_schema)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      pax_schema_(pax_schema == nullptr ? nullptr : std::make_unique<const Schema>(*pax_schema)),
+      max_tuple_size_(pax_schema == nullptr ? MAX_TUPLE_SIZE : PaxPage::GetMaxTupleSize(pax_schema)),
+      free_space_map_(buffer_pool_manager) {
+  ResetInsertPages();
   // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+  Page *first_page = buffer_pool_manager_->NewPage(&first_page_id_);
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
-  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  InitPage(first_page, first_page_id_, INVALID_LSN, txn);
+  uint32_t free_space = VisitPage(first_page, [](auto *page) { return page->GetFreeSpaceRemaining(); });
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  // And the free-space map, which starts out with the first page.
+  [[maybe_unused]] bool is_created = free_space_map_.Create();
+  BUSTUB_ASSERT(is_created, "Couldn't create a page for the free-space map.");
+  free_space_map_.Update(first_page_id_, free_space);
+  last_page_id_ = first_page_id_;
 }
 
-bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+void TableHeap::OpenFreeSpaceMap() {
+  // Every insert comes by, which must not queue on append_latch_ once the map is open.
+  if (free_space_map_.IsOpen()) {
+    return;
+  }
+  std::scoped_lock lock(append_latch_);
+  if (free_space_map_.IsOpen()) {
+    return;
+  }
+  if (free_space_map_page_id_ != INVALID_PAGE_ID) {
+    free_space_map_.Open(free_space_map_page_id_);
+    last_page_id_ = free_space_map_.GetLastHeapPageId();
+    if (last_page_id_ == INVALID_PAGE_ID) {
+      last_page_id_ = first_page_id_;
+    }
+    return;
+  }
+  // Without a map to open, walk the chain once and record the free space of every page.
+  [[maybe_unused]] bool is_created = free_space_map_.Create();
+  BUSTUB_ASSERT(is_created, "Couldn't create a page for the free-space map.");
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    uint32_t free_space = VisitPage(page, [](auto *page) { return page->GetFreeSpaceRemaining(); });
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    free_space_map_.Update(page_id, free_space);
+    last_page_id_ = page_id;
+    page_id = next_page_id;
+  }
+}
+
+bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, const Schema *schema) {
+  if (!CanWrite(txn)) {
+    return false;
+  }
+  if (tuple.size_ <= max_tuple_size_) {
+    return InsertStoredTuple(tuple, rid, txn) && RecordRowLock(txn, *rid);
+  }
+  // Larger than one page size.
+  schema = schema == nullptr ? schema_ : schema;
+  Tuple toasted;
+  if (schema == nullptr ||
+      !Toast::ToastTuple(buffer_pool_manager_, tuple, schema, max_tuple_size_, &toasted, txn, log_manager_)) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  if (!InsertStoredTuple(toasted, rid, txn)) {
+    // No tuple points to the chains.
+    FreeChains(Toast::GetChains(toasted, schema));
+    return false;
+  }
+  return RecordRowLock(txn, *rid);
+}
+
+bool TableHeap::InsertStoredTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
+  OpenFreeSpaceMap();
+
+  // Insert into the page of the last insert of the partition if it still has room, then into the pages the free-space
+  // map says have room. The map may overestimate the free space of a page, so correct it for every page that turns
+  // out to be full.
+  uint32_t space_needed = TablePage::GetSpaceNeeded(tuple.size_);
+  std::atomic<page_id_t> &insert_page_id = InsertPageId();
+  page_id_t page_id = insert_page_id.load();
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = FindInsertPage(space_needed);
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    Page *cur_page = buffer_pool_manager_->FetchPage(page_id);
+    if (cur_page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    cur_page->WLatch();
+    uint32_t free_space;
+    bool is_inserted = VisitPage(cur_page, [&](auto *page) {
+      bool is_inserted = page->InsertTuple(tuple, rid, txn, RowLockManager(txn, true), log_manager_);
+      if (is_inserted) {
+        zone_map_.Add(page_id, tuple);
+        if (KeepsVersions(txn)) {
+          versions_.Record(*rid, txn->GetTransactionId(), WType::INSERT, nullptr);
+        }
+      }
+      free_space = page->GetFreeSpaceRemaining();
+      return is_inserted;
+    });
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, is_inserted);
+    if (is_inserted) {
+      insert_page_id.store(page_id);
+      break;
+    }
+    free_space_map_.Update(page_id, free_space);
+    page_id = FindInsertPage(space_needed);
+  }
+
+  // Otherwise we have run out of pages with room. We need to create a new page.
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = AppendPage(tuple, rid, txn);
+    if (page_id == INVALID_PAGE_ID) {
+      // Then life sucks and we abort the transaction.
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    insert_page_id.store(page_id);
+  }
+  // Update the transaction's write set.
+  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+  return true;
+}
+
+page_id_t TableHeap::FindInsertPage(uint32_t space_needed) {
+  page_id_t page_id = free_space_map_.FindPage(space_needed);
+  for (const auto &insert_page_id : insert_page_ids_) {
+    if (page_id == insert_page_id.load()) {
+      return INVALID_PAGE_ID;
+    }
+  }
+  return page_id;
+}
+
+page_id_t TableHeap::AppendPage(const Tuple &tuple, RID *rid, Transaction *txn) {
+  page_id_t new_page_id;
+  Page *new_page = NewHeapPage(&new_page_id);
+  if (new_page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  {
+    std::scoped_lock lock(append_latch_);
+    if (!LinkNewPage(new_page, txn)) {
+      new_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(new_page_id, false);
+      buffer_pool_manager_->DeletePage(new_page_id);
+      return INVALID_PAGE_ID;
+    }
+  }
+  // A fresh page always has room for a tuple smaller than a page. Other inserters link pages meanwhile.
+  LockManager *lock_manager = RowLockManager(txn, true);
+  [[maybe_unused]] bool is_inserted = VisitPage(
+      new_page, [&](auto *page) { return page->InsertTuple(tuple, rid, txn, lock_manager, log_manager_); });
+  BUSTUB_ASSERT(is_inserted, "A tuple smaller than a page must fit in an empty page.");
+  zone_map_.Add(new_page_id, tuple);
+  if (KeepsVersions(txn)) {
+    versions_.Record(*rid, txn->GetTransactionId(), WType::INSERT, nullptr);
+  }
+  ReleaseNewPage(new_page);
+  return new_page_id;
+}
+
+bool TableHeap::ToastTuples(const std::vector<Tuple> &tuples, const Schema *schema, std::vector<Tuple> *toasted,
+                            Transaction *txn) {
+  for (size_t i = 0; i < tuples.size(); i++) {
+    if (tuples[i].size_ > max_tuple_size_) {  // larger than one page size
+      if (toasted->empty()) {
+        toasted->resize(tuples.size());
+      }
+      if (schema == nullptr || !Toast::ToastTuple(buffer_pool_manager_, tuples[i], schema, max_tuple_size_,
+                                                  &(*toasted)[i], txn, log_manager_)) {
+        FreeToasted(*toasted, 0, schema);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void TableHeap::FreeToasted(const std::vector<Tuple> &toasted, size_t from, const Schema *schema) {
+  for (size_t i = from; i < toasted.size(); i++) {
+    if (toasted[i].GetData() != nullptr) {
+      FreeChains(Toast::GetChains(toasted[i], schema));
+    }
+  }
+}
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+bool TableHeap::BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn,
+                           const Schema *schema) {
+  if (!CanWrite(txn)) {
+    return false;
+  }
+  schema = schema == nullptr ? schema_ : schema;
+  std::vector<Tuple> toasted;
+  if (!ToastTuples(tuples, schema, &toasted, txn)) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // A tuple is either the one given or its toasted copy.
+  auto tuple_at = [&tuples, &toasted](size_t i) -> const Tuple & {
+    return toasted.empty() || toasted[i].GetData() == nullptr ? tuples[i] : toasted[i];
+  };
+  OpenFreeSpaceMap();
 
-  cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
-    } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
+  // Fill fresh pages one after the other. No other transaction reads a page before it is unlatched, full, so its
+  // tuples need neither latching one by one nor a log record each; other inserters link pages in between.
+  size_t next = 0;
+  while (next < tuples.size()) {
+    page_id_t page_id;
+    Page *page = NewHeapPage(&page_id);
+    if (page == nullptr) {
+      // The tuples appended are rolled back with the transaction, the others point to nothing.
+      FreeToasted(toasted, next, schema);
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    {
+      std::scoped_lock lock(append_latch_);
+      if (!LinkNewPage(page, txn)) {
+        page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        buffer_pool_manager_->DeletePage(page_id);
+        FreeToasted(toasted, next, schema);
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
-    }
-  }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-  // Update the transaction's write set.
-  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+    }
+    auto append = [&](const Tuple &tuple, RID *rid) {
+      return VisitPage(page, [&](auto *page) { return page->AppendTuple(tuple, rid); });
+    };
+    RID rid;
+    for (; next < tuples.size() && append(tuple_at(next), &rid); next++) {
+      if (enable_logging) {
+        // Like InsertTuple, hold an exclusive lock on the new tuple.
+        LockManager *lock_manager = RowLockManager(txn, true);
+        [[maybe_unused]] bool locked = lock_manager == nullptr || lock_manager->LockExclusive(txn, rid);
+        BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
+        versions_.Record(rid, txn->GetTransactionId(), WType::INSERT, nullptr);
+      }
+      zone_map_.Add(page_id, tuple_at(next));
+      rids->push_back(rid);
+      // Update the transaction's write set.
+      txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{}, this);
+    }
+    VisitPage(page, [&](auto *page) { page->LogPageImage(txn, log_manager_); });
+    ReleaseNewPage(page);
+  }
+  // Escalating the row locks may wait for the table lock, which is taken after the pages are released.
+  return std::all_of(rids->begin(), rids->end(), [&](const RID &rid) { return RecordRowLock(txn, rid); });
+}
+
+page_id_t TableHeap::FindLastPageId() {
+  // The cached last page is only stale if the map was opened behind the chain; catch up with the real end.
+  for (page_id_t page_id = last_page_id_;;) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    page->RLatch();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (next_page_id == INVALID_PAGE_ID) {
+      last_page_id_ = page_id;
+      return page_id;
+    }
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::InitPage(Page *page, page_id_t page_id, page_id_t prev_page_id, Transaction *txn) {
+  if (pax_schema_ != nullptr) {
+    static_cast<PaxPage *>(page)->Init(page_id, PAGE_SIZE, prev_page_id, log_manager_, txn, pax_schema_.get());
+  } else {
+    static_cast<TablePage *>(page)->Init(page_id, PAGE_SIZE, prev_page_id, log_manager_, txn);
+  }
+}
+
+Page *TableHeap::NewHeapPage(page_id_t *page_id) {
+  // Keep the heap physically sequential in extents of its own, so that scans read the file front to back.
+  Page *new_page = buffer_pool_manager_->NewPageWithHint(page_id, last_page_id_.load(), first_page_id_);
+  if (new_page != nullptr) {
+    new_page->WLatch();
+  }
+  return new_page;
+}
+
+bool TableHeap::LinkNewPage(Page *new_page, Transaction *txn) {
+  // The cached last page is only stale if the map was opened behind the chain; catch up with the real end.
+  TablePage *last_page;
+  for (;;) {
+    last_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+    if (last_page == nullptr) {
+      return false;
+    }
+    last_page->WLatch();
+    const page_id_t next_page_id = last_page->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    last_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id_, false);
+    last_page_id_ = next_page_id;
+  }
+  // The new page is logged under the latch, so that the links of the chain are redone in the order they were made.
+  const page_id_t new_page_id = new_page->GetPageId();
+  InitPage(new_page, new_page_id, last_page_id_, txn);
+  zone_map_.AddPage(new_page_id);
+  last_page->SetNextPageId(new_page_id);
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  zone_map_.Link(last_page_id_, new_page_id);
+  last_page_id_ = new_page_id;
   return true;
 }
 
+void TableHeap::ReleaseNewPage(Page *new_page) {
+  const page_id_t new_page_id = new_page->GetPageId();
+  uint32_t free_space = VisitPage(new_page, [](auto *page) { return page->GetFreeSpaceRemaining(); });
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  free_space_map_.Update(new_page_id, free_space);
+}
+
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
+  if (!CanWrite(txn) || !LockRow(txn, rid, true)) {
+    return false;
+  }
   // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
@@ -101,33 +400,107 @@ bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  VisitPage(page, [&](auto *page) {
+    // No other transaction changes the page before the delete takes the lock on the tuple under the same latch.
+    Tuple before;
+    const bool keeps_version = KeepsVersions(txn) && page->GetTuple(rid, &before, txn, nullptr);
+    if (page->MarkDelete(rid, txn, RowLockManager(txn, true), log_manager_) && keeps_version) {
+      versions_.Record(rid, txn->GetTransactionId(), WType::DELETE, &before);
+    }
+  });
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
-  return true;
+  return RecordRowLock(txn, rid);
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) {
+  if (!CanWrite(txn) || !LockRow(txn, rid, true)) {
+    return false;
+  }
+  // A tuple larger than one page size is toasted as on insert.
+  Tuple toasted;
+  if (tuple.size_ > max_tuple_size_ &&
+      (schema_ == nullptr || !Toast::ToastTuple(buffer_pool_manager_, tuple, schema_, max_tuple_size_, &toasted,
+                                                txn, log_manager_))) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  const Tuple &stored = toasted.GetData() == nullptr ? tuple : toasted;
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
+    FreeChains(GetChains(toasted));
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
   page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  bool is_updated = VisitPage(
+      page, [&](auto *page) {
+        return page->UpdateTuple(stored, &old_tuple, rid, txn, RowLockManager(txn, true), log_manager_);
+      });
+  if (is_updated) {
+    zone_map_.Add(rid.GetPageId(), stored);
+    if (KeepsVersions(txn)) {
+      versions_.Record(rid, txn->GetTransactionId(), WType::UPDATE, &old_tuple);
+    } else if (txn->GetState() == TransactionState::ABORTED) {
+      // Rolled back, the update no longer hides the version it replaced.
+      versions_.Discard(rid, txn->GetTransactionId());
+    }
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  if (!is_updated) {
+    // No tuple points to the chains of the new tuple.
+    FreeChains(GetChains(toasted));
+  } else if (txn->GetState() == TransactionState::ABORTED) {
+    // Rolled back, nothing points to the chains of the update but those the restored tuple still does.
+    FreeChains(Subtract(GetChains(old_tuple), GetChains(stored)));
+  }
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   }
-  return is_updated;
+  return is_updated && RecordRowLock(txn, rid);
+}
+
+bool TableHeap::IncrementTuple(const std::vector<ColumnIncrement> &increments, const RID &rid, Transaction *txn,
+                               Tuple *old_tuple, Tuple *new_tuple) {
+  if (!CanWrite(txn) || GetFormat() != TableFormat::ROW) {
+    return false;
+  }
+  // As in LockRow, the row lock is taken before the page latch.
+  LockManager *lock_manager = RowLockManager(txn, true);
+  if (enable_logging && lock_manager != nullptr && !lock_manager->LockIncrement(txn, rid)) {
+    return false;
+  }
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  if (page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  page->WLatch();
+  // A compressed tuple is not written in place.
+  const bool is_incremented =
+      !CompressedPage::IsCompressed(page->GetData()) &&
+      page->IncrementTuple(increments, false, rid, old_tuple, new_tuple, txn, lock_manager, log_manager_);
+  if (is_incremented) {
+    zone_map_.Add(rid.GetPageId(), *new_tuple);
+    if (KeepsVersions(txn)) {
+      versions_.RecordIncrement(rid, txn->GetTransactionId(), *old_tuple, increments);
+    }
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_incremented);
+  if (is_incremented) {
+    txn->GetWriteSet()->emplace_back(rid, WType::INCREMENT, Tuple{}, this);
+    txn->GetWriteSet()->back().increments_ = increments;
+  }
+  return is_incremented && RecordRowLock(txn, rid);
 }
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
@@ -136,10 +509,102 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
   page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  std::vector<page_id_t> chains;
+  uint32_t free_space = VisitPage(page, [&](auto *page) {
+    chains = GetChains(page, rid);
+    page->ApplyDelete(rid, txn, log_manager_);
+    return page->GetFreeSpaceRemaining();
+  });
+  // Deleting the tuple of an aborted insert rolls the insert back, of a committed delete keeps its version.
+  if (txn->GetState() == TransactionState::ABORTED) {
+    versions_.Discard(rid, txn->GetTransactionId());
+  }
   lock_manager_->Unlock(txn, rid);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  if (txn->GetState() == TransactionState::ABORTED) {
+    FreeChains(chains);
+  } else {
+    RetireChains(chains, txn);
+  }
+  // Let the inserts find the space the delete freed.
+  if (free_space_map_.IsOpen()) {
+    free_space_map_.Update(rid.GetPageId(), free_space);
+  }
+}
+
+void TableHeap::ApplyDeletes(const std::vector<RID> &rids, Transaction *txn) {
+  const page_id_t page_id = rids.front().GetPageId();
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  page->WLatch();
+  std::vector<page_id_t> chains;
+  uint32_t free_space = VisitPage(page, [&](auto *page) {
+    for (const RID &rid : rids) {
+      std::vector<page_id_t> tuple_chains = GetChains(page, rid);
+      chains.insert(chains.end(), tuple_chains.begin(), tuple_chains.end());
+    }
+    page->ApplyDeletes(rids, txn, log_manager_);
+    return page->GetFreeSpaceRemaining();
+  });
+  for (const RID &rid : rids) {
+    lock_manager_->Unlock(txn, rid);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  RetireChains(chains, txn);
+  if (free_space_map_.IsOpen()) {
+    free_space_map_.Update(page_id, free_space);
+  }
+}
+
+void TableHeap::RetireReplaced(const RID &rid, const Tuple &old_tuple, Transaction *txn) {
+  std::vector<page_id_t> chains = GetChains(old_tuple);
+  if (chains.empty()) {
+    return;
+  }
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  page->RLatch();
+  std::vector<page_id_t> kept = VisitPage(page, [&](auto *page) { return GetChains(page, rid); });
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+  RetireChains(Subtract(chains, kept), txn);
+}
+
+void TableHeap::RetireChains(const std::vector<page_id_t> &chains, Transaction *txn) {
+  if (chains.empty()) {
+    return;
+  }
+  // Stamped with the last commit to the table, this one or a later one, which is as safe.
+  const timestamp_t commit_ts = last_commit_ts_.load();
+  std::scoped_lock lock(retired_latch_);
+  for (page_id_t first_page_id : chains) {
+    // The updates of a transaction that keep a chain of the tuple they replace may each retire it.
+    if (std::none_of(retired_chains_.begin(), retired_chains_.end(),
+                     [&](const RetiredChain &chain) { return chain.first_page_id_ == first_page_id; })) {
+      retired_chains_.push_back({commit_ts, txn->GetCommitLSN(), first_page_id});
+    }
+  }
+}
+
+void TableHeap::FreeRetiredChains(timestamp_t oldest_ts) {
+  // Until the commit is durable, a crash may undo the delete back to a tuple pointing to the chain.
+  const lsn_t persistent_lsn = log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetPersistentLSN();
+  auto is_kept = [&](const RetiredChain &chain) {
+    return chain.commit_ts_ > oldest_ts ||
+           (log_manager_ != nullptr && chain.commit_lsn_ != INVALID_LSN && chain.commit_lsn_ > persistent_lsn);
+  };
+  std::vector<page_id_t> chains;
+  {
+    std::scoped_lock lock(retired_latch_);
+    auto freed = std::stable_partition(retired_chains_.begin(), retired_chains_.end(), is_kept);
+    for (auto iter = freed; iter != retired_chains_.end(); ++iter) {
+      chains.push_back(iter->first_page_id_);
+    }
+    retired_chains_.erase(freed, retired_chains_.end());
+  }
+  FreeChains(chains);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
@@ -148,12 +613,39 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Rollback the delete.
   page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
+  VisitPage(page, [&](auto *page) {
+    page->RollbackDelete(rid, txn, log_manager_);
+    versions_.Discard(rid, txn->GetTransactionId());
+    // The tuple may have been deleted before the zone map read the page, and be missing from its summary.
+    Tuple restored;
+    if (zone_map_.IsEnabled() && page->GetTuple(rid, &restored, txn, RowLockManager(txn, false))) {
+      zone_map_.Add(rid.GetPageId(), restored);
+    }
+  });
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+}
+
+void TableHeap::RollbackIncrement(const RID &rid, const std::vector<ColumnIncrement> &increments, Transaction *txn) {
+  // Find the page which contains the tuple.
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  // Take the increments out of the tuple as it is now, leaving those of the others.
+  Tuple old_tuple;
+  Tuple new_tuple;
+  page->WLatch();
+  if (page->IncrementTuple(increments, true, rid, &old_tuple, &new_tuple, txn, nullptr, log_manager_)) {
+    zone_map_.Add(rid.GetPageId(), new_tuple);
+  }
+  versions_.Discard(rid, txn->GetTransactionId());
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
 bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
+  if (!LockRow(txn, rid, false)) {
+    return false;
+  }
   // Find the page which contains the tuple.
   auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
@@ -163,30 +655,319 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
   }
   // Read the tuple from the page.
   page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
+  LockManager *lock_manager = RowLockManager(txn, false);
+  bool res = VisitPage(page, [&](auto *page) {
+    return txn->ReadsVersions() ? GetSnapshotTuple(page, rid, tuple, txn)
+                                : page->GetTuple(rid, tuple, txn, lock_manager);
+  });
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return res && RecordRowLock(txn, rid);
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
+bool TableHeap::GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn) {
+  tuples->clear();
+  std::vector<page_id_t> page_ids;
+  for (const RID &rid : rids) {
+    if (page_ids.empty() || page_ids.back() != rid.GetPageId()) {
+      page_ids.push_back(rid.GetPageId());
+    }
+  }
+  if (page_ids.size() > 1) {
+    buffer_pool_manager_->PrefetchPages(page_ids);
+  }
+  for (const RID &rid : rids) {
+    if (!LockRow(txn, rid, false)) {
+      return false;
+    }
+  }
+  LockManager *lock_manager = RowLockManager(txn, false);
+  Tuple tuple;
+  for (size_t begin = 0; begin < rids.size();) {
+    const page_id_t page_id = rids[begin].GetPageId();
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    page->RLatch();
+    size_t end = begin;
+    VisitPage(page, [&](auto *page) {
+      for (; end < rids.size() && rids[end].GetPageId() == page_id; end++) {
+        if (txn->ReadsVersions() ? GetSnapshotTuple(page, rids[end], &tuple, txn)
+                                 : page->GetTuple(rids[end], &tuple, txn, lock_manager)) {
+          tuples->push_back(tuple);
+        }
+      }
+    });
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    for (; begin < end; begin++) {
+      if (!RecordRowLock(txn, rids[begin])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+page_id_t TableHeap::ReadPageTuples(page_id_t page_id, Transaction *txn, BufferRing *ring,
+                                    std::vector<Tuple> *tuples) {
+  Page *page = buffer_pool_manager_->FetchPageWithRing(page_id, ring);
+  assert(page != nullptr);  // all pages are pinned
+  page->RLatch();
+  VisitPage(page, [&](auto *page) {
+    RID rid;
+    for (bool found = GetNextSnapshotRid(page, nullptr, &rid, txn); found;
+         found = GetNextSnapshotRid(page, &rid, &rid, txn)) {
+      Tuple tuple;
+      if (txn->ReadsVersions() ? GetSnapshotTuple(page, rid, &tuple, txn)
+                               : page->GetTuple(rid, &tuple, txn, RowLockManager(txn, false))) {
+        tuples->push_back(std::move(tuple));
+      }
+    }
+  });
+  const page_id_t next_page_id = static_cast<TablePage *>(page)->GetNextPageId();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return next_page_id;
+}
+
+bool TableHeap::GetTupleRef(const RID &rid, TupleRef *ref, Transaction *txn) {
+  ref->Release();
+  if (!LockRow(txn, rid, false)) {
+    return false;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(rid.GetPageId());
+  if (page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  page->RLatch();
+  // A tuple of a PaxPage or a CompressedPage is reassembled from its columns, the ref then owns it.
+  LockManager *lock_manager = RowLockManager(txn, false);
+  bool res;
+  if (txn->ReadsVersions()) {
+    res = VisitPage(page, [&](auto *page) { return GetSnapshotTuple(page, rid, &ref->tuple_, txn); });
+  } else {
+    res = pax_schema_ != nullptr || CompressedPage::IsCompressed(page->GetData())
+              ? VisitPage(page, [&](auto *page) { return page->GetTuple(rid, &ref->tuple_, txn, lock_manager); })
+              : static_cast<TablePage *>(page)->GetTupleView(rid, &ref->tuple_, txn, lock_manager);
+  }
+  if (!res) {
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    return false;
+  }
+  ref->bpm_ = buffer_pool_manager_;
+  ref->page_ = page;
+  return true;
+}
+
+void TableHeap::CreateZoneMap(const Schema *schema, const std::vector<uint32_t> &column_ids, Transaction *txn) {
+  // No page is appended while the map is built. The inserts into the pages already in the chain add their tuples to
+  // the summaries, which only count once the page has been read whole.
+  std::scoped_lock lock(append_latch_);
+  zone_map_.Enable(*schema, column_ids);
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    page_id_t next_page_id = VisitPage(page, [&](auto *page) {
+      RID rid;
+      Tuple tuple;
+      for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(RID(rid), &rid)) {
+        if (page->GetTuple(rid, &tuple, txn, RowLockManager(txn, false))) {
+          zone_map_.Add(page_id, tuple);
+        }
+      }
+      return page->GetNextPageId();
+    });
+    zone_map_.CompletePage(page_id, next_page_id);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::LinkPages(page_id_t page_id, page_id_t next_page_id) {
+  // All the formats keep the links to the neighbours of a page at the same place.
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+  page->WLatch();
+  page->SetNextPageId(next_page_id);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  if (next_page_id != INVALID_PAGE_ID) {
+    auto next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    BUSTUB_ASSERT(next_page != nullptr, "Couldn't fetch a page of the table heap.");
+    next_page->WLatch();
+    next_page->SetPrevPageId(page_id);
+    next_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(next_page_id, true);
+  }
+  zone_map_.Link(page_id, next_page_id);
+}
+
+void TableHeap::CompressPages(const Schema *schema, Transaction *txn, std::vector<std::pair<RID, RID>> *moves) {
+  OpenFreeSpaceMap();
+  std::scoped_lock lock(append_latch_);
+  [[maybe_unused]] page_id_t last_page_id = FindLastPageId();
+  BUSTUB_ASSERT(last_page_id != INVALID_PAGE_ID, "Couldn't fetch a page of the table heap.");
+  CompressedPageBuilder builder(schema);
+  // The rids of the tuples added to the builder since the last page it built.
+  std::vector<RID> pending;
+  // The last page of the new chain so far.
+  page_id_t tail_page_id = first_page_id_;
+  // Writes the tuples of the builder to a new page after the tail.
+  auto build_page = [&]() {
+    page_id_t page_id;
+    auto page = static_cast<CompressedPage *>(buffer_pool_manager_->NewPage(&page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't create a page for the table heap.");
+    page->WLatch();
+    builder.Build(page, page_id, tail_page_id, INVALID_PAGE_ID);
+    page->LogPageImage(txn, log_manager_);
+    zone_map_.AddPage(page_id);
+    RID rid;
+    Tuple tuple;
+    for (size_t i = 0; i < pending.size(); i++) {
+      rid.Set(page_id, i);
+      if (zone_map_.IsEnabled() && page->GetTuple(rid, &tuple, txn, RowLockManager(txn, false))) {
+        zone_map_.Add(page_id, tuple);
+      }
+      moves->emplace_back(pending[i], rid);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    free_space_map_.Update(page_id, 0);
+    pending.clear();
+    LinkPages(tail_page_id, page_id);
+    tail_page_id = page_id;
+  };
+
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't fetch a page of the table heap.");
+  first_page->RLatch();
+  page_id_t page_id = first_page->GetNextPageId();
+  first_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, false);
+  while (page_id != INVALID_PAGE_ID && page_id != last_page_id_) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    // Read the tuples of the page, unless it is compressed already or holds a tuple too large to be.
+    std::vector<Tuple> tuples;
+    std::vector<RID> rids;
+    page->RLatch();
+    page_id_t next_page_id = static_cast<TablePage *>(page)->GetNextPageId();
+    bool is_compressible = !CompressedPage::IsCompressed(page->GetData());
+    VisitPage(page, [&](auto *page) {
+      RID rid;
+      for (bool found = page->GetFirstTupleRid(&rid); found && is_compressible;
+           found = page->GetNextTupleRid(RID(rid), &rid)) {
+        Tuple tuple;
+        if (page->GetTuple(rid, &tuple, txn, RowLockManager(txn, false))) {
+          is_compressible = tuple.GetLength() <= PAGE_SIZE / 2 || CompressedPageBuilder::Fits(schema, tuple);
+          tuples.push_back(std::move(tuple));
+          rids.push_back(rid);
+        }
+      }
+    });
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+
+    if (!is_compressible) {
+      // The page stays as it is, after the pages compressed so far.
+      if (builder.GetTupleCount() > 0) {
+        build_page();
+      }
+      LinkPages(tail_page_id, page_id);
+      tail_page_id = page_id;
+      page_id = next_page_id;
+      continue;
+    }
+    for (size_t i = 0; i < tuples.size(); i++) {
+      if (!builder.Add(tuples[i])) {
+        build_page();
+        [[maybe_unused]] bool is_added = builder.Add(tuples[i]);
+        BUSTUB_ASSERT(is_added, "A tuple that fits alone must fit in an empty compressed page.");
+      }
+      pending.push_back(rids[i]);
+    }
+    // The page is gone once its tuples are; no insert or sampled scan may find it anymore.
+    free_space_map_.Remove(page_id);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+  if (builder.GetTupleCount() > 0) {
+    build_page();
+  }
+  LinkPages(tail_page_id, page_id);
+  ResetInsertPages();
+}
+
+void TableHeap::Truncate() {
+  OpenFreeSpaceMap();
+  std::scoped_lock lock(append_latch_);
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't fetch a page of the table heap.");
+  first_page->WLatch();
+  page_id_t page_id = first_page->GetNextPageId();
+  InitPage(first_page, first_page_id_, INVALID_PAGE_ID, nullptr);
+  const uint32_t free_space = VisitPage(first_page, [](auto *page) { return page->GetFreeSpaceRemaining(); });
+  first_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  free_space_map_.Update(first_page_id_, free_space);
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    const page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    free_space_map_.Remove(page_id);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+  last_page_id_ = first_page_id_;
+  ResetInsertPages();
+}
+
+std::vector<page_id_t> TableHeap::GetPageIds() {
+  OpenFreeSpaceMap();
+  return free_space_map_.GetHeapPageIds();
+}
+
+TableIterator TableHeap::Begin(Transaction *txn, BufferRing *ring) {
+  // A snapshot or an optimistic transaction may see tuples the pages no longer hold, which only the batched iterator
+  // steps through.
+  if (txn->ReadsVersions()) {
+    return TableIterator(this, first_page_id_, txn, ring, 0);
+  }
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageWithRing(page_id, ring));
     page->RLatch();
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-    auto found_tuple = page->GetFirstTupleRid(&rid);
+    auto found_tuple = VisitPage(page, [&](auto *page) { return page->GetFirstTupleRid(&rid); });
+    auto next_page_id = page->GetNextPageId();
     page->RUnlatch();
     buffer_pool_manager_->UnpinPage(page_id, false);
     if (found_tuple) {
+      if (ring == nullptr && next_page_id != INVALID_PAGE_ID) {
+        buffer_pool_manager_->PrefetchPages({next_page_id});
+      }
       break;
     }
-    page_id = page->GetNextPageId();
+    page_id = next_page_id;
   }
-  return TableIterator(this, rid, txn);
+  return TableIterator(this, rid, txn, ring);
+}
+
+TableIterator TableHeap::BeginPageBatch(Transaction *txn, size_t read_ahead, BufferRing *ring) {
+  return TableIterator(this, first_page_id_, txn, ring, read_ahead);
 }
 
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
@@ -11,18 +11,80 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
+#include <vector>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), ring_(ring) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
 }
 
+TableIterator::TableIterator(TableHeap *table_heap, page_id_t page_id, Transaction *txn, BufferRing *ring,
+                             size_t read_ahead)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(RID(INVALID_PAGE_ID, 0))),
+      txn_(txn),
+      ring_(ring),
+      batched_(true),
+      read_ahead_(read_ahead) {
+  ReadPages(page_id);
+}
+
+void TableIterator::ReadPages(page_id_t page_id) {
+  page_tuples_.clear();
+  page_idx_ = 0;
+  while (page_id != INVALID_PAGE_ID && page_tuples_.empty()) {
+    next_page_id_ = table_heap_->ReadPageTuples(page_id, txn_, ring_, &page_tuples_);
+    ReadAhead(page_id, next_page_id_);
+    page_id = next_page_id_;
+  }
+  if (page_tuples_.empty()) {
+    tuple_->rid_ = RID(INVALID_PAGE_ID, 0);
+    return;
+  }
+  *tuple_ = std::move(page_tuples_[0]);
+}
+
+void TableIterator::ReadAhead(page_id_t page_id, page_id_t next_page_id) {
+  // Scans through a buffer ring do not read ahead, since prefetched pages would be placed outside the ring and defeat
+  // its scan resistance.
+  if (ring_ != nullptr || read_ahead_ == 0) {
+    return;
+  }
+  if (!prefetched_.empty() && prefetched_.front() == page_id) {
+    prefetched_.pop_front();
+  }
+  if (!prefetched_.empty() && prefetched_.front() != next_page_id) {
+    // The chain changed under the iterator, start over from the page it links to now.
+    prefetched_.clear();
+  }
+  std::vector<page_id_t> page_ids;
+  page_id_t last_page_id = next_page_id;
+  if (prefetched_.empty() && next_page_id != INVALID_PAGE_ID) {
+    prefetched_.push_back(next_page_id);
+    page_ids.push_back(next_page_id);
+  } else if (!prefetched_.empty()) {
+    last_page_id = prefetched_.back();
+  }
+  ZoneMap *zone_map = table_heap_->GetZoneMap();
+  page_id_t after_page_id;
+  while (last_page_id != INVALID_PAGE_ID && prefetched_.size() < read_ahead_ &&
+         zone_map->GetNextPageId(last_page_id, &after_page_id) && after_page_id != INVALID_PAGE_ID) {
+    prefetched_.push_back(after_page_id);
+    page_ids.push_back(after_page_id);
+    last_page_id = after_page_id;
+  }
+  if (!page_ids.empty()) {
+    table_heap_->buffer_pool_manager_->PrefetchPages(page_ids);
+  }
+}
+
 const Tuple &TableIterator::operator*() {
   assert(*this != table_heap_->End());
   return *tuple_;
@@ -34,21 +96,36 @@ Tuple *TableIterator::operator->() {
 }
 
 TableIterator &TableIterator::operator++() {
+  if (batched_) {
+    if (++page_idx_ < page_tuples_.size()) {
+      *tuple_ = std::move(page_tuples_[page_idx_]);
+    } else {
+      ReadPages(next_page_id_);
+    }
+    return *this;
+  }
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPageWithRing(tuple_->rid_.GetPageId(), ring_));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
+  if (!table_heap_->VisitPage(cur_page, [&](auto *page) {
+        return page->GetNextTupleRid(tuple_->rid_, &next_tuple_rid);
+      })) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page =
+          static_cast<TablePage *>(buffer_pool_manager->FetchPageWithRing(cur_page->GetNextPageId(), ring_));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+      // Read the page after this one while we walk its tuples. Scans through a buffer ring skip this, since
+      // prefetched pages would be placed outside the ring and defeat its scan resistance.
+      if (ring_ == nullptr && cur_page->GetNextPageId() != INVALID_PAGE_ID) {
+        buffer_pool_manager->PrefetchPages({cur_page->GetNextPageId()});
+      }
+      if (table_heap_->VisitPage(cur_page, [&](auto *page) { return page->GetFirstTupleRid(&next_tuple_rid); })) {
         break;
       }
     }
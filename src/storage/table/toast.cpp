@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// toast.cpp
+//
+// Identification: src/storage/table/toast.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/toast.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+#include "storage/page/overflow_page.h"
+
+namespace bustub {
+
+uint32_t Toast::StoredSize(const char *stored) {
+  uint32_t len = *reinterpret_cast<const uint32_t *>(stored);
+  if (len == BUSTUB_VALUE_NULL) {
+    return sizeof(uint32_t);
+  }
+  return sizeof(uint32_t) + ((len & TOAST_POINTER_FLAG) != 0 ? POINTER_SIZE : len);
+}
+
+template <typename Write>
+Tuple Toast::Rewrite(const Tuple &tuple, const Schema *schema, const std::vector<bool> &rewrite, uint32_t size,
+                     Write write) {
+  Tuple copy;
+  copy.allocated_ = true;
+  copy.rid_ = tuple.rid_;
+  copy.size_ = size;
+  copy.data_ = Tuple::AllocateData(size);
+  memcpy(copy.data_, tuple.data_, schema->GetLength());
+  uint32_t offset = schema->GetLength();
+  for (uint32_t column_idx : schema->GetUnlinedColumns()) {
+    const char *stored = tuple.GetDataPtr(schema, column_idx);
+    *reinterpret_cast<uint32_t *>(copy.data_ + schema->GetColumn(column_idx).GetOffset()) = offset;
+    if (rewrite[column_idx]) {
+      offset += write(column_idx, stored, copy.data_ + offset);
+    } else {
+      uint32_t stored_size = StoredSize(stored);
+      memcpy(copy.data_ + offset, stored, stored_size);
+      offset += stored_size;
+    }
+  }
+  BUSTUB_ASSERT(offset == size, "The rewritten values must fill the tuple exactly.");
+  return copy;
+}
+
+bool Toast::ToastTuple(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema, uint32_t max_size,
+                       Tuple *toasted, Transaction *txn, LogManager *log_manager) {
+  // Pick the largest values stored inline until the tuple fits, of those a pointer is smaller than.
+  std::vector<uint32_t> candidates;
+  for (uint32_t column_idx : schema->GetUnlinedColumns()) {
+    if (!tuple.IsToasted(schema, column_idx) &&
+        StoredSize(tuple.GetDataPtr(schema, column_idx)) > sizeof(uint32_t) + POINTER_SIZE) {
+      candidates.push_back(column_idx);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [&tuple, schema](uint32_t a, uint32_t b) {
+    return StoredSize(tuple.GetDataPtr(schema, a)) > StoredSize(tuple.GetDataPtr(schema, b));
+  });
+  std::vector<bool> rewrite(schema->GetColumnCount(), false);
+  uint32_t size = tuple.GetLength();
+  for (auto column = candidates.begin(); column != candidates.end() && size > max_size; ++column) {
+    rewrite[*column] = true;
+    size -= StoredSize(tuple.GetDataPtr(schema, *column)) - sizeof(uint32_t) - POINTER_SIZE;
+  }
+  if (size > max_size) {
+    return false;
+  }
+
+  // Write the chains first, so that the tuple only ever points to complete ones.
+  std::vector<page_id_t> first_page_ids(schema->GetColumnCount(), INVALID_PAGE_ID);
+  for (uint32_t column_idx = 0; column_idx < schema->GetColumnCount(); column_idx++) {
+    if (rewrite[column_idx]) {
+      const char *stored = tuple.GetDataPtr(schema, column_idx);
+      first_page_ids[column_idx] = WriteChain(bpm, stored + sizeof(uint32_t),
+                                              *reinterpret_cast<const uint32_t *>(stored), txn, log_manager);
+      if (first_page_ids[column_idx] == INVALID_PAGE_ID) {
+        // No tuple is written to point to the chains of the columns before.
+        for (page_id_t first_page_id : first_page_ids) {
+          FreeChain(bpm, first_page_id);
+        }
+        return false;
+      }
+    }
+  }
+  auto write_pointer = [&first_page_ids](uint32_t column_idx, const char *stored, char *dest) {
+    uint32_t header = TOAST_POINTER_FLAG | POINTER_SIZE;
+    memcpy(dest, &header, sizeof(uint32_t));
+    memcpy(dest + sizeof(uint32_t), &first_page_ids[column_idx], sizeof(page_id_t));
+    memcpy(dest + sizeof(uint32_t) + sizeof(page_id_t), stored, sizeof(uint32_t));
+    return static_cast<uint32_t>(sizeof(uint32_t) + POINTER_SIZE);
+  };
+  *toasted = Rewrite(tuple, schema, rewrite, size, write_pointer);
+  return true;
+}
+
+bool Toast::HasToasted(const Tuple &tuple, const Schema *schema, const std::vector<uint32_t> &column_ids) {
+  return std::any_of(column_ids.begin(), column_ids.end(),
+                     [&tuple, schema](uint32_t column_idx) { return tuple.IsToasted(schema, column_idx); });
+}
+
+Tuple Toast::Detoast(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema,
+                     const std::vector<uint32_t> &column_ids) {
+  std::vector<bool> rewrite(schema->GetColumnCount(), false);
+  uint32_t size = tuple.GetLength();
+  for (uint32_t column_idx : column_ids) {
+    if (!rewrite[column_idx] && tuple.IsToasted(schema, column_idx)) {
+      rewrite[column_idx] = true;
+      const char *pointer = tuple.GetDataPtr(schema, column_idx) + sizeof(uint32_t);
+      size += *reinterpret_cast<const uint32_t *>(pointer + sizeof(page_id_t)) - POINTER_SIZE;
+    }
+  }
+  return Rewrite(tuple, schema, rewrite, size, [bpm](uint32_t column_idx, const char *stored, char *dest) {
+    const char *pointer = stored + sizeof(uint32_t);
+    page_id_t first_page_id = *reinterpret_cast<const page_id_t *>(pointer);
+    uint32_t len = *reinterpret_cast<const uint32_t *>(pointer + sizeof(page_id_t));
+    memcpy(dest, &len, sizeof(uint32_t));
+    ReadChain(bpm, first_page_id, dest + sizeof(uint32_t), len);
+    return static_cast<uint32_t>(sizeof(uint32_t) + len);
+  });
+}
+
+Tuple Toast::Detoast(BufferPoolManager *bpm, const Tuple &tuple, const Schema *schema) {
+  return Detoast(bpm, tuple, schema, schema->GetUnlinedColumns());
+}
+
+std::vector<page_id_t> Toast::GetChains(const Tuple &tuple, const Schema *schema) {
+  std::vector<page_id_t> first_page_ids;
+  for (uint32_t column_idx : schema->GetUnlinedColumns()) {
+    if (tuple.IsToasted(schema, column_idx)) {
+      const char *pointer = tuple.GetDataPtr(schema, column_idx) + sizeof(uint32_t);
+      first_page_ids.push_back(*reinterpret_cast<const page_id_t *>(pointer));
+    }
+  }
+  return first_page_ids;
+}
+
+void Toast::FreeChain(BufferPoolManager *bpm, page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<OverflowPage *>(bpm->FetchPage(page_id));
+    if (page == nullptr) {
+      // No frame to read the next page id in, the rest of the chain stays allocated.
+      return;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+page_id_t Toast::WriteChain(BufferPoolManager *bpm, const char *data, uint32_t size, Transaction *txn,
+                            LogManager *log_manager) {
+  // Write the chunks back to front, so that each page is written once, knowing its next page.
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  uint32_t num_chunks = std::max<uint32_t>(1, (size + OverflowPage::CAPACITY - 1) / OverflowPage::CAPACITY);
+  for (uint32_t chunk = num_chunks; chunk-- > 0;) {
+    page_id_t page_id;
+    auto page = static_cast<OverflowPage *>(bpm->NewPage(&page_id));
+    if (page == nullptr) {
+      FreeChain(bpm, next_page_id);
+      return INVALID_PAGE_ID;
+    }
+    uint32_t offset = chunk * OverflowPage::CAPACITY;
+    page->Init(page_id, data + offset, std::min(OverflowPage::CAPACITY, size - offset), next_page_id);
+    // Logged whole, so that the redo brings the page back for the tuple that will point to it.
+    if (enable_logging && txn != nullptr && log_manager != nullptr) {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::OVERFLOWPAGE, page_id,
+                           page->GetData());
+      lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      page->SetLSN(lsn);
+      txn->SetPrevLSN(lsn);
+    }
+    bpm->UnpinPage(page_id, true);
+    next_page_id = page_id;
+  }
+  return next_page_id;
+}
+
+void Toast::ReadChain(BufferPoolManager *bpm, page_id_t page_id, char *data, uint32_t size) {
+  uint32_t offset = 0;
+  while (offset < size) {
+    BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "An overflow chain ended before its value.");
+    auto page = static_cast<OverflowPage *>(bpm->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch an overflow page.");
+    page->RLatch();
+    memcpy(data + offset, page->GetChunk(), page->GetSize());
+    offset += page->GetSize();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
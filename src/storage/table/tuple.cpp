@@ -12,30 +12,51 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "common/exception.h"
 #include "storage/table/tuple.h"
+#include "type/limits.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return the bytes a varlen value takes past the inlined columns: its length, then its data, none if NULL */
+uint32_t SerializedVarlenSize(const Value &value) {
+  uint32_t len = value.GetLength();
+  return sizeof(uint32_t) + (len == BUSTUB_VALUE_NULL ? 0 : len);
+}
+
+}  // namespace
+
 // TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true) {
-  assert(values.size() == schema->GetColumnCount());
+  size_ = SerializedSize(values, schema);
+  data_ = AllocateData(size_);
+  Serialize(values, schema);
+}
+
+Tuple::Tuple(const std::vector<Value> &values, const Schema *schema, Arena *arena) : allocated_(false) {
+  size_ = SerializedSize(values, schema);
+  data_ = arena->Allocate(size_, alignof(uint32_t));
+  Serialize(values, schema);
+}
 
-  // 1. Calculate the size of the tuple.
+uint32_t Tuple::SerializedSize(const std::vector<Value> &values, const Schema *schema) {
+  assert(values.size() == schema->GetColumnCount());
   uint32_t tuple_size = schema->GetLength();
   for (auto &i : schema->GetUnlinedColumns()) {
-    tuple_size += (values[i].GetLength() + sizeof(uint32_t));
+    tuple_size += SerializedVarlenSize(values[i]);
   }
+  return tuple_size;
+}
 
-  // 2. Allocate memory.
-  size_ = tuple_size;
-  data_ = new char[size_];
+void Tuple::Serialize(const std::vector<Value> &values, const Schema *schema) {
   std::memset(data_, 0, size_);
-
-  // 3. Serialize each attribute based on the input value.
   uint32_t column_count = schema->GetColumnCount();
   uint32_t offset = schema->GetLength();
 
@@ -46,57 +67,81 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
       *reinterpret_cast<uint32_t *>(data_ + col.GetOffset()) = offset;
       // Serialize varchar value, in place (size+data).
       values[i].SerializeTo(data_ + offset);
-      offset += (values[i].GetLength() + sizeof(uint32_t));
+      offset += SerializedVarlenSize(values[i]);
     } else {
       values[i].SerializeTo(data_ + col.GetOffset());
     }
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
+// A copy owns its data, even of a tuple which does not, so that it outlives the page or the arena of the original.
+Tuple::Tuple(const Tuple &other) : allocated_(other.data_ != nullptr), rid_(other.rid_), size_(other.size_) {
   if (allocated_) {
-    delete[] data_;
-  }
-  if (allocated_) {
-    // Deep copy.
-    data_ = new char[size_];
+    data_ = AllocateData(size_);
     memcpy(data_, other.data_, size_);
-  } else {
-    // Shallow copy.
-    data_ = other.data_;
   }
 }
 
 Tuple &Tuple::operator=(const Tuple &other) {
-  if (allocated_) {
-    delete[] data_;
+  if (this == &other) {
+    return *this;
   }
-  allocated_ = other.allocated_;
+  FreeData();
+  allocated_ = other.data_ != nullptr;
   rid_ = other.rid_;
   size_ = other.size_;
-
+  data_ = nullptr;
   if (allocated_) {
-    // Deep copy.
-    data_ = new char[size_];
+    data_ = AllocateData(size_);
     memcpy(data_, other.data_, size_);
-  } else {
-    // Shallow copy.
-    data_ = other.data_;
   }
+  return *this;
+}
+
+Tuple::Tuple(Tuple &&other) noexcept
+    : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_), data_(other.data_) {
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+}
 
+Tuple &Tuple::operator=(Tuple &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  FreeData();
+  allocated_ = other.allocated_;
+  rid_ = other.rid_;
+  size_ = other.size_;
+  data_ = other.data_;
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
   return *this;
 }
 
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
-  const TypeId column_type = schema->GetColumn(column_idx).GetType();
+  const TypeId column_type = schema->GetColumnLayout(column_idx).type_;
   const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (IsToasted(schema, column_idx)) {
+    throw Exception(ExceptionType::MISMATCH_TYPE, "The value is stored out of line, detoast the tuple first.");
+  }
   // the third parameter "is_inlined" is unused
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
-Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) {
+bool Tuple::IsToasted(const Schema *schema, const uint32_t column_idx) const {
+  if (schema->GetColumnLayout(column_idx).is_inlined_) {
+    return false;
+  }
+  uint32_t len = *reinterpret_cast<const uint32_t *>(GetDataPtr(schema, column_idx));
+  return len != BUSTUB_VALUE_NULL && (len & TOAST_POINTER_FLAG) != 0;
+}
+
+Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema,
+                          const std::vector<uint32_t> &key_attrs) const {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
   for (auto idx : key_attrs) {
@@ -105,19 +150,36 @@ Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const
   return Tuple(values, &key_schema);
 }
 
-const char *Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const {
+bool Tuple::IsNull(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_ + col.GetOffset());
+  const char *data_ptr = GetDataPtr(schema, column_idx);
+  // NULL is a value of its own of every type, see type/limits.h; a toasted value is not NULL.
+  auto is = [data_ptr](auto null_value) {
+    decltype(null_value) value;
+    memcpy(&value, data_ptr, sizeof(value));
+    return value == null_value;
+  };
+  switch (schema->GetColumnLayout(column_idx).type_) {
+    case TypeId::BOOLEAN:
+      return is(BUSTUB_BOOLEAN_NULL);
+    case TypeId::TINYINT:
+      return is(BUSTUB_INT8_NULL);
+    case TypeId::SMALLINT:
+      return is(BUSTUB_INT16_NULL);
+    case TypeId::INTEGER:
+      return is(BUSTUB_INT32_NULL);
+    case TypeId::BIGINT:
+      return is(BUSTUB_INT64_NULL);
+    case TypeId::DECIMAL:
+      return is(BUSTUB_DECIMAL_NULL);
+    case TypeId::TIMESTAMP:
+      return is(BUSTUB_TIMESTAMP_NULL);
+    case TypeId::VARCHAR:
+      return is(BUSTUB_VALUE_NULL);
+    default:
+      return false;
   }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<int32_t *>(data_ + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_ + offset);
 }
 
 std::string Tuple::ToString(const Schema *schema) const {
@@ -153,11 +215,9 @@ void Tuple::SerializeTo(char *storage) const {
 void Tuple::DeserializeFrom(const char *storage) {
   uint32_t size = *reinterpret_cast<const uint32_t *>(storage);
   // Construct a tuple.
+  this->FreeData();
   this->size_ = size;
-  if (this->allocated_) {
-    delete[] this->data_;
-  }
-  this->data_ = new char[this->size_];
+  this->data_ = AllocateData(this->size_);
   memcpy(this->data_, storage + sizeof(int32_t), this->size_);
   this->allocated_ = true;
 }
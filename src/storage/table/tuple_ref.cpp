@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_ref.cpp
+//
+// Identification: src/storage/table/tuple_ref.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/tuple_ref.h"
+
+#include <utility>
+
+namespace bustub {
+
+TupleRef::TupleRef(TupleRef &&other) noexcept : bpm_(other.bpm_), page_(other.page_) {
+  TakeView(&other);
+}
+
+TupleRef &TupleRef::operator=(TupleRef &&other) noexcept {
+  if (this != &other) {
+    Release();
+    bpm_ = other.bpm_;
+    page_ = other.page_;
+    TakeView(&other);
+  }
+  return *this;
+}
+
+void TupleRef::TakeView(TupleRef *other) {
+  // The tuple is a view of the page or owns its data, copying it would copy its data.
+  tuple_ = std::move(other->tuple_);
+  other->page_ = nullptr;
+}
+
+void TupleRef::Release() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->RUnlatch();
+  bpm_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  tuple_ = Tuple();
+}
+
+}  // namespace bustub
@@ -0,0 +1,238 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.cpp
+//
+// Identification: src/storage/table/version_store.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/version_store.h"
+
+namespace bustub {
+
+void VersionStore::Record(const RID &rid, txn_id_t txn_id, WType wtype, const Tuple *before) {
+  latch_.WLock();
+  std::deque<UndoRecord> &chain = chains_[rid.GetPageId()][rid.GetSlotNum()];
+  chain.push_front(UndoRecord{txn_id, INVALID_TS, wtype, before == nullptr ? Tuple() : *before, {}});
+  // A tuple written over and over between two vacuums keeps a short chain all the same.
+  num_versions_ = num_versions_ + 1 - Prune(&chain, horizon_);
+  latch_.WUnlock();
+}
+
+void VersionStore::RecordIncrement(const RID &rid, txn_id_t txn_id, const Tuple &before,
+                                   const std::vector<ColumnIncrement> &increments) {
+  latch_.WLock();
+  std::deque<UndoRecord> &chain = chains_[rid.GetPageId()][rid.GetSlotNum()];
+  chain.push_front(UndoRecord{txn_id, INVALID_TS, WType::INCREMENT, before, increments});
+  num_versions_ = num_versions_ + 1 - Prune(&chain, horizon_);
+  latch_.WUnlock();
+}
+
+void VersionStore::Commit(const RID &rid, txn_id_t txn_id, timestamp_t commit_ts) {
+  latch_.WLock();
+  auto page = chains_.find(rid.GetPageId());
+  if (page != chains_.end()) {
+    auto chain = page->second.find(rid.GetSlotNum());
+    if (chain != page->second.end()) {
+      // A later insert may have reused the slot of a committed delete already, the writes are then further down.
+      for (UndoRecord &record : chain->second) {
+        if (record.txn_id_ == txn_id && record.commit_ts_ == INVALID_TS) {
+          record.commit_ts_ = commit_ts;
+        }
+      }
+    }
+  }
+  latch_.WUnlock();
+}
+
+void VersionStore::Discard(const RID &rid, txn_id_t txn_id) {
+  latch_.WLock();
+  auto page = chains_.find(rid.GetPageId());
+  if (page != chains_.end()) {
+    auto chain = page->second.find(rid.GetSlotNum());
+    if (chain != page->second.end()) {
+      // At the front, or behind the increments of others if it is an increment itself.
+      auto newest = std::find_if(chain->second.begin(), chain->second.end(), [txn_id](const UndoRecord &record) {
+        return record.txn_id_ == txn_id && record.commit_ts_ == INVALID_TS;
+      });
+      if (newest != chain->second.end()) {
+        chain->second.erase(newest);
+        num_versions_--;
+      }
+      if (chain->second.empty()) {
+        page->second.erase(chain);
+        if (page->second.empty()) {
+          chains_.erase(page);
+        }
+      }
+    }
+  }
+  latch_.WUnlock();
+}
+
+VersionStore::Visibility VersionStore::Resolve(const RID &rid, timestamp_t read_ts, Tuple *tuple) {
+  latch_.RLock();
+  Visibility visibility = Visibility::CURRENT;
+  if (const std::deque<UndoRecord> *chain = FindChain(rid); chain != nullptr) {
+    auto sees = [read_ts](const UndoRecord &record) {
+      return record.commit_ts_ != INVALID_TS && record.commit_ts_ <= read_ts;
+    };
+    visibility = VisibilityOf(*chain, sees, tuple);
+  }
+  latch_.RUnlock();
+  return visibility;
+}
+
+VersionStore::Visibility VersionStore::ResolveLatest(const RID &rid, txn_id_t txn_id, Tuple *tuple,
+                                                     timestamp_t *version_ts) {
+  latch_.RLock();
+  Visibility visibility = Visibility::CURRENT;
+  *version_ts = INVALID_TS;
+  if (const std::deque<UndoRecord> *chain = FindChain(rid); chain != nullptr) {
+    // The uncommitted writes of others are not seen, those of txn_id are.
+    auto sees = [txn_id](const UndoRecord &record) {
+      return record.commit_ts_ != INVALID_TS || record.txn_id_ == txn_id;
+    };
+    *version_ts = LatestCommitTs(*chain);
+    visibility = VisibilityOf(*chain, sees, tuple);
+  }
+  latch_.RUnlock();
+  return visibility;
+}
+
+timestamp_t VersionStore::GetLatestCommitTs(const RID &rid) {
+  latch_.RLock();
+  timestamp_t commit_ts = INVALID_TS;
+  if (const std::deque<UndoRecord> *chain = FindChain(rid); chain != nullptr) {
+    commit_ts = LatestCommitTs(*chain);
+  }
+  latch_.RUnlock();
+  return commit_ts;
+}
+
+template <typename Sees>
+VersionStore::Visibility VersionStore::VisibilityOf(const std::deque<UndoRecord> &chain, Sees &&sees, Tuple *tuple) {
+  // The commit timestamps only grow towards the front, but for the increments, so the writes the reader does not see
+  // come first: up to the newest write it sees other than an increment. The increments it skips are those it sees.
+  const UndoRecord *oldest_unseen = nullptr;
+  std::vector<const UndoRecord *> unseen_increments;
+  for (const UndoRecord &record : chain) {
+    if (sees(record)) {
+      if (record.wtype_ != WType::INCREMENT) {
+        break;
+      }
+    } else if (record.wtype_ == WType::INCREMENT) {
+      unseen_increments.push_back(&record);
+    } else {
+      // The increments newer than a write the reader does not see are not seen either, and not in its version.
+      oldest_unseen = &record;
+      unseen_increments.clear();
+    }
+  }
+  if (oldest_unseen == nullptr && unseen_increments.empty()) {
+    return chain.front().wtype_ == WType::DELETE ? Visibility::NONE : Visibility::CURRENT;
+  }
+  if (oldest_unseen != nullptr && oldest_unseen->wtype_ == WType::INSERT) {
+    return Visibility::NONE;
+  }
+  if (oldest_unseen != nullptr) {
+    *tuple = oldest_unseen->before_;
+  } else {
+    // The newest write is an increment: the heap holds it applied to the version it replaced.
+    *tuple = chain.front().before_;
+    ApplyIncrements(chain.front().increments_, false, tuple->GetData());
+  }
+  for (const UndoRecord *increment : unseen_increments) {
+    ApplyIncrements(increment->increments_, true, tuple->GetData());
+  }
+  return Visibility::OLDER;
+}
+
+timestamp_t VersionStore::LatestCommitTs(const std::deque<UndoRecord> &chain) {
+  timestamp_t commit_ts = INVALID_TS;
+  for (const UndoRecord &record : chain) {
+    commit_ts = std::max(commit_ts, record.commit_ts_);
+    // Past the increments, the commit timestamps only get older.
+    if (record.commit_ts_ != INVALID_TS && record.wtype_ != WType::INCREMENT) {
+      break;
+    }
+  }
+  return commit_ts;
+}
+
+const std::deque<VersionStore::UndoRecord> *VersionStore::FindChain(const RID &rid) const {
+  auto page = chains_.find(rid.GetPageId());
+  if (page == chains_.end()) {
+    return nullptr;
+  }
+  auto chain = page->second.find(rid.GetSlotNum());
+  return chain == page->second.end() ? nullptr : &chain->second;
+}
+
+bool VersionStore::GetNextVersionedRid(page_id_t page_id, uint32_t slot_num, RID *next_rid) {
+  latch_.RLock();
+  bool found = false;
+  auto page = chains_.find(page_id);
+  if (page != chains_.end()) {
+    auto chain = page->second.lower_bound(slot_num);
+    if (chain != page->second.end()) {
+      next_rid->Set(page_id, chain->first);
+      found = true;
+    }
+  }
+  latch_.RUnlock();
+  return found;
+}
+
+size_t VersionStore::Vacuum(timestamp_t oldest_ts, size_t max_pages) {
+  size_t num_reclaimed = 0;
+  for (size_t i = 0; i < max_pages; i++) {
+    // One page at a time, not to hold off the writers for long.
+    latch_.WLock();
+    horizon_ = std::max(horizon_, oldest_ts);
+    auto page = chains_.lower_bound(vacuum_page_id_);
+    if (page == chains_.end()) {
+      vacuum_page_id_ = 0;
+      latch_.WUnlock();
+      break;
+    }
+    vacuum_page_id_ = page->first + 1;
+    for (auto chain = page->second.begin(); chain != page->second.end();) {
+      const size_t num_pruned = Prune(&chain->second, horizon_);
+      num_versions_ -= num_pruned;
+      num_reclaimed += num_pruned;
+      chain = chain->second.empty() ? page->second.erase(chain) : std::next(chain);
+    }
+    if (page->second.empty()) {
+      chains_.erase(page);
+    }
+    latch_.WUnlock();
+  }
+  return num_reclaimed;
+}
+
+size_t VersionStore::Prune(std::deque<UndoRecord> *chain, timestamp_t oldest_ts) {
+  // Every snapshot sees the writes committed up to oldest_ts, so the oldest writes of the chain that all are never
+  // read: a walk down the chain stops at the newest of them, or skips it if it is an increment. Nor is that write: a
+  // snapshot seeing it and all the newer ones reads the heap, where a deleted tuple is gone as well, and one missing a
+  // newer write reads what the oldest such replaced, or takes the increments it misses out of the heap version.
+  auto seen = std::find_if(chain->rbegin(), chain->rend(), [oldest_ts](const UndoRecord &record) {
+                return record.commit_ts_ == INVALID_TS || record.commit_ts_ > oldest_ts;
+              }).base();
+  const auto num_pruned = static_cast<size_t>(std::distance(seen, chain->end()));
+  chain->erase(seen, chain->end());
+  return num_pruned;
+}
+
+size_t VersionStore::GetNumVersions() {
+  latch_.RLock();
+  size_t num_versions = num_versions_;
+  latch_.RUnlock();
+  return num_versions;
+}
+
+}  // namespace bustub
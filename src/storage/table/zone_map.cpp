@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include <utility>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void ZoneMap::Enable(const Schema &schema, const std::vector<uint32_t> &column_ids) {
+  std::scoped_lock lock(latch_);
+  schema_ = std::make_unique<const Schema>(schema);
+  column_ids_ = column_ids;
+  column_slots_.assign(schema.GetColumnCount(), -1);
+  for (size_t i = 0; i < column_ids.size(); i++) {
+    BUSTUB_ASSERT(schema.GetColumn(column_ids[i]).IsInlined(), "Only inlined columns can be summarized.");
+    column_slots_[column_ids[i]] = static_cast<int>(i);
+  }
+  summaries_.clear();
+}
+
+bool ZoneMap::IsEnabled() {
+  std::scoped_lock lock(latch_);
+  return !column_ids_.empty();
+}
+
+ZoneMap::PageSummary *ZoneMap::GetSummary(page_id_t page_id) {
+  PageSummary &summary = summaries_[page_id];
+  summary.ranges_.resize(column_ids_.size());
+  return &summary;
+}
+
+void ZoneMap::AddPage(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  if (!column_ids_.empty()) {
+    GetSummary(page_id)->complete_ = true;
+  }
+}
+
+void ZoneMap::CompletePage(page_id_t page_id, page_id_t next_page_id) {
+  std::scoped_lock lock(latch_);
+  if (!column_ids_.empty()) {
+    PageSummary *summary = GetSummary(page_id);
+    summary->complete_ = true;
+    summary->next_page_id_ = next_page_id;
+  }
+}
+
+void ZoneMap::Link(page_id_t page_id, page_id_t next_page_id) {
+  std::scoped_lock lock(latch_);
+  auto summary = summaries_.find(page_id);
+  if (summary != summaries_.end()) {
+    summary->second.next_page_id_ = next_page_id;
+  }
+}
+
+void ZoneMap::Add(page_id_t page_id, const Tuple &tuple) {
+  std::scoped_lock lock(latch_);
+  if (column_ids_.empty()) {
+    return;
+  }
+  PageSummary *summary = GetSummary(page_id);
+  for (size_t i = 0; i < column_ids_.size(); i++) {
+    Value value = tuple.GetValue(schema_.get(), column_ids_[i]);
+    if (value.IsNull()) {
+      continue;
+    }
+    Range &range = summary->ranges_[i];
+    if (!range.has_values_) {
+      range.has_values_ = true;
+      range.min_ = value.Copy();
+      range.max_ = std::move(value);
+    } else if (value.CompareLessThan(range.min_) == CmpBool::CmpTrue) {
+      range.min_ = std::move(value);
+    } else if (value.CompareGreaterThan(range.max_) == CmpBool::CmpTrue) {
+      range.max_ = std::move(value);
+    }
+  }
+}
+
+bool ZoneMap::GetRange(page_id_t page_id, uint32_t column_idx, Range *range, page_id_t *next_page_id) {
+  std::scoped_lock lock(latch_);
+  if (column_idx >= column_slots_.size() || column_slots_[column_idx] < 0) {
+    return false;
+  }
+  auto summary = summaries_.find(page_id);
+  if (summary == summaries_.end() || !summary->second.complete_) {
+    return false;
+  }
+  *range = summary->second.ranges_[column_slots_[column_idx]];
+  *next_page_id = summary->second.next_page_id_;
+  return true;
+}
+
+bool ZoneMap::GetNextPageId(page_id_t page_id, page_id_t *next_page_id) {
+  std::scoped_lock lock(latch_);
+  auto summary = summaries_.find(page_id);
+  if (summary == summaries_.end() || !summary->second.complete_) {
+    return false;
+  }
+  *next_page_id = summary->second.next_page_id_;
+  return true;
+}
+
+}  // namespace bustub
@@ -28,7 +28,7 @@ Value::Value(const Value &other) {
       if (size_.len_ == BUSTUB_VALUE_NULL) {
         value_.varlen_ = nullptr;
       } else {
-        if (manage_data_) {
+        if (manage_data_ && !IsInlined()) {
           value_.varlen_ = new char[size_.len_];
           memcpy(value_.varlen_, other.value_.varlen_, size_.len_);
         } else {
@@ -41,6 +41,24 @@ Value::Value(const Value &other) {
   }
 }
 
+Value::Value(Value &&other) noexcept
+    : value_(other.value_), size_(other.size_), manage_data_(other.manage_data_), type_id_(other.type_id_) {
+  if (!other.IsInlined()) {
+    other.manage_data_ = false;
+  }
+}
+
+char *Value::AllocateVarlen(uint32_t len) {
+  manage_data_ = true;
+  size_.len_ = len;
+  if (IsInlined()) {
+    return value_.inline_;
+  }
+  value_.varlen_ = new char[len];
+  assert(value_.varlen_ != nullptr);
+  return value_.varlen_;
+}
+
 Value &Value::operator=(Value other) {
   Swap(*this, other);
   return *this;
@@ -218,13 +236,9 @@ Value::Value(TypeId type, const char *data, uint32_t len, bool manage_data) : Va
         value_.varlen_ = nullptr;
         size_.len_ = BUSTUB_VALUE_NULL;
       } else {
-        manage_data_ = manage_data;
-        if (manage_data_) {
+        if (manage_data) {
           assert(len < BUSTUB_VARCHAR_MAX_LEN);
-          value_.varlen_ = new char[len];
-          assert(value_.varlen_ != nullptr);
-          size_.len_ = len;
-          memcpy(value_.varlen_, data, len);
+          memcpy(AllocateVarlen(len), data, len);
         } else {
           // FUCK YOU GCC I do what I want.
           value_.const_varlen_ = data;
@@ -240,13 +254,9 @@ Value::Value(TypeId type, const char *data, uint32_t len, bool manage_data) : Va
 Value::Value(TypeId type, const std::string &data) : Value(type) {
   switch (type) {
     case TypeId::VARCHAR: {
-      manage_data_ = true;
       // TODO(TAs): How to represent a null string here?
       uint32_t len = static_cast<uint32_t>(data.length()) + 1;
-      value_.varlen_ = new char[len];
-      assert(value_.varlen_ != nullptr);
-      size_.len_ = len;
-      memcpy(value_.varlen_, data.c_str(), len);
+      memcpy(AllocateVarlen(len), data.c_str(), len);
       break;
     }
     default:
@@ -258,7 +268,7 @@ Value::Value(TypeId type, const std::string &data) : Value(type) {
 Value::~Value() {
   switch (type_id_) {
     case TypeId::VARCHAR:
-      if (manage_data_) {
+      if (manage_data_ && !IsInlined()) {
         delete[] value_.varlen_;
       }
       break;
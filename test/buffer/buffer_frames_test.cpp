@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_frames_test.cpp
+//
+// Identification: test/buffer/buffer_frames_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_frames.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+bool IsAligned(const void *address, size_t alignment) { return reinterpret_cast<uintptr_t>(address) % alignment == 0; }
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(BufferFramesTest, LayoutTest) {
+  const size_t num_frames = 10;
+  BufferFrames frames(num_frames);
+  Page *pages = frames.GetPages();
+  EXPECT_FALSE(frames.IsHugeTlb());
+  EXPECT_EQ(NO_NUMA_NODE, frames.GetNumaNode());
+
+  // The page data is page aligned and contiguous, apart from the cache-line aligned book-keeping.
+  ASSERT_TRUE(IsAligned(pages[0].GetData(), getpagesize()));
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_TRUE(IsAligned(&pages[i], 64));
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+    EXPECT_EQ(INVALID_PAGE_ID, pages[i].GetPageId());
+    EXPECT_EQ(0, pages[i].GetPinCount());
+    for (size_t offset = 0; offset < PAGE_SIZE; offset++) {
+      ASSERT_EQ(0, pages[i].GetData()[offset]);
+    }
+    EXPECT_TRUE(pages[i].GetData() + PAGE_SIZE <= reinterpret_cast<char *>(pages) ||
+                pages[i].GetData() >= reinterpret_cast<char *>(pages + num_frames));
+  }
+  pages[num_frames - 1].GetData()[PAGE_SIZE - 1] = 'x';
+  pages[3].WLatch();
+  pages[3].WUnlatch();
+}
+
+// NOLINTNEXTLINE
+TEST(BufferFramesTest, HugePageTest) {
+  // A pool of two huge pages of data, aligned for the kernel to back it with huge pages.
+  const size_t num_frames = 2 * HUGE_PAGE_SIZE / PAGE_SIZE;
+  BufferFrames frames(num_frames, 0);
+  Page *pages = frames.GetPages();
+  EXPECT_TRUE(IsAligned(pages[0].GetData(), HUGE_PAGE_SIZE));
+  EXPECT_EQ(pages[0].GetData() + (num_frames - 1) * PAGE_SIZE, pages[num_frames - 1].GetData());
+  EXPECT_EQ(BufferFrames::GetNumNumaNodes() > 1 ? 0 : NO_NUMA_NODE, frames.GetNumaNode());
+  pages[num_frames - 1].GetData()[PAGE_SIZE - 1] = 'x';
+
+  BufferFrames empty(0);
+  EXPECT_EQ(nullptr, empty.GetPages());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferFramesTest, StandalonePageTest) {
+  // A page outside any buffer pool has page data of its own.
+  Page page;
+  ASSERT_NE(nullptr, page.GetData());
+  EXPECT_EQ(0, page.GetData()[PAGE_SIZE - 1]);
+  EXPECT_TRUE(IsAligned(&page, 64));
+}
+
+}  // namespace bustub
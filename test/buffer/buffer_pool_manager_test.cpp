@@ -11,11 +11,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "gtest/gtest.h"
+#include "common/exception.h"
 #include "common/logger.h"
+#include "common/metrics.h"
+#include "recovery/log_manager.h"
 
 namespace bustub {
 
@@ -142,4 +150,649 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Check that pages written back and read in without the latch held never lose updates
+TEST(BufferPoolManagerTest, ConcurrentEvictionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_threads = 8;
+  const int num_rounds = 100;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids(num_threads);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "0");
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &page_ids, tid] {
+      // Each thread owns one page, while the pool is smaller than the number of threads.
+      for (int round = 0; round < num_rounds; round++) {
+        Page *page = nullptr;
+        while ((page = bpm->FetchPage(page_ids[tid])) == nullptr) {
+          std::this_thread::yield();
+        }
+        EXPECT_EQ(std::to_string(round), page->GetData());
+        snprintf(page->GetData(), PAGE_SIZE, "%d", round + 1);
+        EXPECT_EQ(true, bpm->UnpinPage(page_ids[tid], true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(num_rounds), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Check that hits pinning pages without the latch never get a frame that is being handed to another page
+TEST(BufferPoolManagerTest, ConcurrentHitTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 12;
+  const int num_threads = 8;
+  const int num_fetches = 2000;
+
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, replacer_type);
+
+    std::vector<page_id_t> page_ids(num_pages);
+    for (auto &page_id : page_ids) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+
+    // Scenario: a few hot pages are hit over and over, while fetches of the others evict pages from under them.
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([bpm, &page_ids, tid] {
+        std::mt19937 random(tid);
+        for (int i = 0; i < num_fetches; i++) {
+          page_id_t page_id = page_ids[random() % 4 == 0 ? random() % num_pages : random() % 3];
+          Page *page = nullptr;
+          while ((page = bpm->FetchPage(page_id)) == nullptr) {
+            std::this_thread::yield();
+          }
+          EXPECT_EQ(page_id, page->GetPageId());
+          EXPECT_EQ(std::to_string(page_id), page->GetData());
+          EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Scenario: every pin was dropped, so the whole pool can be taken by new pages.
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+    }
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    }
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+// Check that a swizzled reference is followed while its page stays in its frame, and only then
+TEST(BufferPoolManagerTest, SwizzleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_children = 6;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  MetricsRegistry *registry = MetricsRegistry::Global();
+
+  page_id_t parent_id;
+  Page *parent = bpm->NewPage(&parent_id);
+  ASSERT_NE(nullptr, parent);
+  std::vector<page_id_t> child_ids(num_children);
+  for (auto &child_id : child_ids) {
+    auto *child = bpm->NewPage(&child_id);
+    ASSERT_NE(nullptr, child);
+    snprintf(child->GetData(), PAGE_SIZE, "%d", child_id);
+    EXPECT_EQ(true, bpm->UnpinPage(child_id, true));
+  }
+
+  // Scenario: the first fetch through a slot swizzles it, the next ones follow it while the page stays resident.
+  Page *child = bpm->FetchChildPage(parent, 0, child_ids[5]);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(true, bpm->UnpinPage(child_ids[5], false));
+  EXPECT_EQ(0, registry->GetCounter("buffer_pool.swizzled_hits"));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(child, bpm->FetchChildPage(parent, 0, child_ids[5]));
+    EXPECT_EQ(true, bpm->UnpinPage(child_ids[5], false));
+  }
+  EXPECT_EQ(3, registry->GetCounter("buffer_pool.swizzled_hits"));
+
+  // Scenario: a slot now referring to another page, e.g. after the parent moved its slots, is fetched regularly.
+  child = bpm->FetchChildPage(parent, 0, child_ids[4]);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(std::to_string(child_ids[4]), child->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(child_ids[4], false));
+  EXPECT_EQ(3, registry->GetCounter("buffer_pool.swizzled_hits"));
+
+  // Scenario: once its page is evicted, the frame a slot refers to holds another page; the slot is fetched regularly.
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(child_ids[i]));
+    EXPECT_EQ(true, bpm->UnpinPage(child_ids[i], false));
+  }
+  child = bpm->FetchChildPage(parent, 0, child_ids[4]);
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(child_ids[4], child->GetPageId());
+  EXPECT_EQ(std::to_string(child_ids[4]), child->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(child_ids[4], false));
+  EXPECT_EQ(3, registry->GetCounter("buffer_pool.swizzled_hits"));
+
+  EXPECT_EQ(true, bpm->UnpinPage(parent_id, false));
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Check that a scan through a buffer ring recycles the ring's frames instead of evicting other pages
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_scan_pages = 30;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> scan_page_ids(num_scan_pages);
+  for (auto &page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the working set is everything but the ring's frames, and every page of it is dirty.
+  std::vector<page_id_t> hot_page_ids(buffer_pool_size - 2);
+  for (auto &page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  bpm->FlushAllPages();
+  for (auto page_id : hot_page_ids) {
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "hot");
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: scan every page through a two-frame ring, like a table iterator that holds on to one page at a time.
+  // Evicting any hot page would write it back.
+  const int num_disk_writes = disk_manager->GetNumWrites();
+  BufferRing ring(2);
+  for (auto page_id : scan_page_ids) {
+    auto *page = bpm->FetchPageWithRing(page_id, &ring);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_disk_writes, disk_manager->GetNumWrites());
+  for (auto page_id : hot_page_ids) {
+    EXPECT_EQ(0, strcmp(bpm->FetchPage(page_id)->GetData(), "hot"));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: prefetch the pages that were evicted while fetching them, so some fetches race with the reads.
+  std::vector<page_id_t> evicted(page_ids.begin(), page_ids.begin() + buffer_pool_size / 2);
+  bpm->PrefetchPages(evicted);
+  for (auto page_id : evicted) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: prefetching a whole pool's worth of pages leaves the frames unpinned, so the pool can still be filled
+  // with other pages. In a pool this small the prefetcher reads one page at a time.
+  bpm->PrefetchPages(std::vector<page_id_t>(page_ids.begin(), page_ids.begin() + buffer_pool_size));
+  std::vector<page_id_t> other_page_ids(page_ids.end() - (buffer_pool_size - 1), page_ids.end());
+  for (auto page_id : other_page_ids) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  for (auto page_id : other_page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.bpd";
+  const size_t buffer_pool_size = 10;
+  const size_t num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  // The last pool's worth of pages is resident; keep one pinned, and make another the most recently used.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[12]));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[15]));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[15], false));
+
+  // Scenario: the dump thread dumps once more when stopped. The pinned page comes first, then the hottest.
+  bpm->StartPageDump(dump_name, std::chrono::hours(1));
+  bpm->StopPageDump();
+  std::ifstream dump(dump_name);
+  std::vector<page_id_t> dumped;
+  for (page_id_t page_id; dump >> page_id;) {
+    dumped.push_back(page_id);
+  }
+  ASSERT_EQ(buffer_pool_size, dumped.size());
+  EXPECT_EQ(page_ids[12], dumped[0]);
+  EXPECT_EQ(page_ids[15], dumped[1]);
+  std::sort(dumped.begin(), dumped.end());
+  EXPECT_EQ(std::vector<page_id_t>(page_ids.begin() + buffer_pool_size, page_ids.end()), dumped);
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[12], false));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: a restarted pool prefetches the dumped pages, and ends up with the same pages resident.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size, bpm->LoadResidentPages(dump_name));
+  for (int i = 0; i < 1000 && bpm->GetResidentPages().size() < buffer_pool_size; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::vector<page_id_t> resident = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ(dumped, resident);
+  for (auto page_id : resident) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->LoadResidentPages("missing.bpd"));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(dump_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t max_pool_size = 20;
+  const size_t num_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU, max_pool_size);
+  EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(max_pool_size + 1));
+
+  // Scenario: a full pool of pinned pages takes more pages once grown.
+  std::vector<page_id_t> page_ids(num_pages);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+  }
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  for (size_t i = buffer_pool_size; i < max_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: shrinking waits for the pinned frames it retires, and gives up at the timeout.
+  EXPECT_FALSE(bpm->Resize(buffer_pool_size / 2, std::chrono::milliseconds(10)));
+  for (size_t i = 0; i < max_pool_size; i++) {
+    snprintf(bpm->FetchPage(page_ids[i])->GetData(), PAGE_SIZE, "%d", page_ids[i]);
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  // Scenario: once unpinned, the dirty pages are written back and evicted, and the pool holds no more than its size.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size / 2));
+  EXPECT_EQ(buffer_pool_size / 2, bpm->GetPoolSize());
+  EXPECT_GE(buffer_pool_size / 2, bpm->GetResidentPages().size());
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), page->GetData());
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[buffer_pool_size]));
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+  for (size_t i = max_pool_size; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+    snprintf(bpm->FetchPage(page_ids[i])->GetData(), PAGE_SIZE, "%d", page_ids[i]);
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+
+  // Scenario: fetches running while the pool grows and shrinks always find their pages' contents.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 random(t);
+      while (!stop) {
+        const page_id_t page_id = page_ids[random() % num_pages];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(std::to_string(page_id), page->GetData());
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, random() % 2 == 0));
+      }
+    });
+  }
+  for (int round = 0; round < 50; round++) {
+    EXPECT_TRUE(bpm->Resize(round % 2 == 0 ? max_pool_size : buffer_pool_size / 2));
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, log_manager);
+
+  // Scenario: fill the pool with dirty pages. With logging enabled, only the ones whose log is persistent may be
+  // written by the background writer.
+  enable_logging = true;
+  log_manager->SetPersistentLSN(4);
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + sizeof(page_id_t) + sizeof(lsn_t), PAGE_SIZE - 8, "%d", page_ids[i]);
+    page->SetLSN(static_cast<lsn_t>(i));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+
+  const int num_disk_writes = disk_manager->GetNumWrites();
+  bpm->RunBackgroundWriter(1.0, std::chrono::milliseconds(1));
+  for (int i = 0; i < 1000 && disk_manager->GetNumWrites() < num_disk_writes + 5; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(num_disk_writes + 5, disk_manager->GetNumWrites());
+
+  // Scenario: once the log catches up, the rest is written as well, and evicting the whole pool writes nothing.
+  log_manager->SetPersistentLSN(static_cast<lsn_t>(buffer_pool_size));
+  for (int i = 0; i < 1000 && disk_manager->GetNumWrites() < num_disk_writes + 10; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(num_disk_writes + 10, disk_manager->GetNumWrites());
+  enable_logging = false;
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(num_disk_writes + 10, disk_manager->GetNumWrites());
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_EQ(std::to_string(page_id), page->GetData() + sizeof(page_id_t) + sizeof(lsn_t));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete log_manager;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, FlushDirtyPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the dirty pages are written back whether pinned or not, and are clean after.
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_ids[i]);
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  const int num_disk_writes = disk_manager->GetNumWrites();
+  EXPECT_EQ(buffer_pool_size, bpm->FlushDirtyPages());
+  EXPECT_EQ(num_disk_writes + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  EXPECT_EQ(0, bpm->FlushDirtyPages());
+
+  // Scenario: the pinned page goes back to the replacer once its owner unpins it, every frame can then be reused,
+  // and the clean pages are evicted without writes.
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  std::vector<page_id_t> new_page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&new_page_ids[i]));
+  }
+  EXPECT_EQ(num_disk_writes + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  for (auto page_id : new_page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, PacedFlushTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2 * DOUBLE_WRITE_BATCH_SIZE + 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the adjacent pages go out a double-write batch per call, and the batches are paced to the rate.
+  const int num_write_calls = disk_manager->GetNumWriteCalls();
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(buffer_pool_size, bpm->FlushDirtyPages(1000));
+  EXPECT_LE(std::chrono::milliseconds(2 * DOUBLE_WRITE_BATCH_SIZE), std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(num_write_calls + 3, disk_manager->GetNumWriteCalls());
+  EXPECT_EQ(0, bpm->FlushDirtyPages(1000));
+
+  // Scenario: flushing the whole pool writes its pages in order too.
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_write_calls + 6, disk_manager->GetNumWriteCalls());
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, CheckpointWriteBackTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, log_manager);
+
+  // Scenario: half of the pages are dirtied before a checkpoint logged at LSN 1, half after it. A background writer
+  // keeping nothing clean ahead of eviction writes back the older half only.
+  enable_logging = true;
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    if (i == buffer_pool_size / 2) {
+      LogRecord log_record(0, INVALID_LSN, LogRecordType::BEGIN);
+      EXPECT_EQ(0, log_manager->AppendLogRecord(&log_record));
+    }
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  log_manager->SetPersistentLSN(0);
+
+  const int num_disk_writes = disk_manager->GetNumWrites();
+  bpm->RunBackgroundWriter(0.0, std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(num_disk_writes, disk_manager->GetNumWrites());
+  bpm->SetCheckpointLSN(1);
+  for (int i = 0; i < 1000 && disk_manager->GetNumWrites() < num_disk_writes + 5; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(num_disk_writes + 5, disk_manager->GetNumWrites());
+  enable_logging = false;
+
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table;
+  bpm->GetDirtyPageTable(&dirty_page_table);
+  EXPECT_EQ(buffer_pool_size / 2, dirty_page_table.size());
+  for (size_t i = buffer_pool_size / 2; i < buffer_pool_size; i++) {
+    EXPECT_EQ(1, dirty_page_table.count(page_ids[i]));
+  }
+
+  delete bpm;
+  delete log_manager;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, ChecksumTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name, DiskBackendType::POSIX, false, true);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids(buffer_pool_size * 2);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: corrupt a page that is no longer resident. Fetching it fails loudly instead of returning garbage.
+  char garbage[PAGE_SIZE];
+  memset(garbage, 'x', sizeof(garbage));
+  {
+    std::fstream db_io(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    db_io.seekp(static_cast<int64_t>(page_ids[0]) * PAGE_SIZE);
+    db_io.write(garbage, PAGE_SIZE);
+  }
+  EXPECT_THROW(bpm->FetchPage(page_ids[0]), ChecksumException);
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: the frame the read failed in is not lost; the whole pool can still be pinned.
+  for (size_t i = 1; i <= buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), page->GetData());
+  }
+  for (size_t i = 1; i <= buffer_pool_size; i++) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.crc");
+  delete disk_manager;
+}
+
 }  // namespace bustub
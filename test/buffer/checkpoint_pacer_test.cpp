@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checkpoint_pacer_test.cpp
+//
+// Identification: test/buffer/checkpoint_pacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/checkpoint_pacer.h"
+
+#include <chrono>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+// NOLINTNEXTLINE
+TEST(CheckpointPacerTest, PaceTest) {
+  CheckpointPacer pacer(milliseconds(1000), 1 << 20, 0.5, microseconds(1000));
+  auto now = std::chrono::steady_clock::now();
+
+  // Scenario: with the pool at the dirty ratio and the device fast, the pages are spread over the time given.
+  pacer.BeginCheckpoint(100, 0, now);
+  EXPECT_EQ(0, pacer.PagesToWrite(100, 0.5, 0, microseconds(0), now));
+  now += milliseconds(250);
+  EXPECT_EQ(25, pacer.PagesToWrite(100, 0.5, 0, microseconds(500), now));
+  EXPECT_DOUBLE_EQ(0.25, pacer.GetProgress());
+  // Pages the evictions wrote meanwhile count.
+  now += milliseconds(250);
+  EXPECT_EQ(15, pacer.PagesToWrite(65, 0.5, 0, microseconds(0), now));
+
+  // Scenario: a pool twice as dirty halves the spread, writes twice as slow as the latency given double it.
+  now += milliseconds(125);
+  EXPECT_EQ(25, pacer.PagesToWrite(50, 1.0, 0, microseconds(0), now));
+  now += milliseconds(250);
+  EXPECT_EQ(13, pacer.PagesToWrite(25, 0.5, 0, microseconds(2000), now));
+  EXPECT_DOUBLE_EQ(0.875, pacer.GetProgress());
+
+  // Scenario: however slow the device, the checkpoint is done by the end of its log spread.
+  now += milliseconds(1);
+  EXPECT_EQ(0, pacer.PagesToWrite(12, 0.5, 1 << 19, microseconds(100000), now));
+  now += milliseconds(1);
+  EXPECT_EQ(12, pacer.PagesToWrite(12, 0.5, 1 << 20, microseconds(100000), now));
+  EXPECT_DOUBLE_EQ(1.0, pacer.GetProgress());
+
+  // Scenario: a new checkpoint starts over from its own log offset, the log written overtaking the time.
+  pacer.BeginCheckpoint(8, 1 << 20, now);
+  now += milliseconds(125);
+  EXPECT_EQ(4, pacer.PagesToWrite(8, 0.5, (1 << 20) + (1 << 19), microseconds(0), now));
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -19,7 +20,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +60,50 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 4;
+  const int frames_per_thread = 64;
+  const int num_rounds = 200;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: every thread owns a disjoint set of frames, which it unpins and pins again while other threads race
+  // victims against it. Every frame is handed out by Victim at most once per unpin.
+  std::vector<std::atomic<int>> victimized(num_threads * frames_per_thread);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < num_rounds; round++) {
+        for (int i = 0; i < frames_per_thread; i++) {
+          clock_replacer.Unpin(tid * frames_per_thread + i);
+        }
+        frame_id_t frame_id;
+        for (int i = 0; i < frames_per_thread / 2; i++) {
+          if (clock_replacer.Victim(&frame_id)) {
+            victimized[frame_id]++;
+          }
+        }
+        for (int i = 0; i < frames_per_thread; i++) {
+          clock_replacer.Pin(tid * frames_per_thread + i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+  for (auto &count : victimized) {
+    EXPECT_LE(count.load(), num_rounds);
+  }
+
+  // Scenario: after the dust settles, the replacer behaves like a fresh clock again.
+  clock_replacer.Unpin(3);
+  clock_replacer.Unpin(5);
+  EXPECT_EQ(2, clock_replacer.Size());
+  frame_id_t value;
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
 }  // namespace bustub
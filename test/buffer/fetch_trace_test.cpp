@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_trace_test.cpp
+//
+// Identification: test/buffer/fetch_trace_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/fetch_trace.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FetchTraceTest, RecordAndReplayTest) {
+  const std::string trace_name = "test.trace";
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(2, 5, disk_manager);
+
+  std::vector<page_id_t> page_ids(4);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Only the fetches made while the trace is set are recorded, in order, from every instance.
+  std::vector<page_id_t> fetched{page_ids[3], page_ids[0], page_ids[1], page_ids[0], page_ids[2]};
+  {
+    FetchTraceWriter trace(trace_name);
+    bpm->SetFetchTrace(&trace);
+    for (page_id_t page_id : fetched) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    bpm->SetFetchTrace(nullptr);
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  }
+  EXPECT_EQ(fetched, FetchTraceWriter::Read(trace_name));
+  EXPECT_TRUE(FetchTraceWriter::Read("missing.trace").empty());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(trace_name.c_str());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: reference frames 1-6 once, and frame 1 a second time.
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.Pin(frame_id);
+  }
+  lru_k_replacer.Pin(1);
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single reference have an infinite backward 2-distance and go first, oldest first.
+  // Frame 1 has two references, so it survives all of them.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: pin 5 again, so that both 1 and 5 have two references; 6 still goes first.
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+
+  // Scenario: 1's second most recent reference is older than 5's, so 1 has the larger backward 2-distance.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: pinned and removed frames are never victims.
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Remove(3);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 2);
+
+  // Scenario: two back-to-back references to frame 0 are correlated and only count once.
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.Unpin(0);
+  // Frame 1 is referenced twice, far enough apart to count as two references.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  // Without the correlated period frame 0 would have two references and outlive frames 2 and 3.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  // Frames 2 and 3 are still within their correlated period, but they are evicted when nothing else is left.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU_K);
+
+  // Scenario: page 0 is hot, referenced twice.
+  page_id_t hot_page_id;
+  auto *page = bpm->NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "hot");
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, false));
+
+  // Scenario: a scan touches many pages exactly once. It must recycle its own frames instead of evicting page 0.
+  const int num_disk_writes = disk_manager->GetNumWrites();
+  for (int i = 0; i < 20; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_disk_writes, disk_manager->GetNumWrites());
+  page = bpm->FetchPage(hot_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -10,15 +10,72 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <list>
+#include <random>
 #include <thread>  // NOLINT
+#include <unordered_set>
 #include <vector>
 
 #include "buffer/lru_replacer.h"
+#include "common/logger.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
+/** The previous list-based LRU policy, kept as the baseline for the benchmark below. Pin is O(pool size). */
+class ListLRUReplacer : public Replacer {
+ public:
+  bool Victim(frame_id_t *frame_id) override {
+    if (victim_queue_.empty()) {
+      return false;
+    }
+    *frame_id = victim_queue_.front();
+    victim_queue_.pop_front();
+    frames_.erase(*frame_id);
+    return true;
+  }
+
+  void Pin(frame_id_t frame_id) override {
+    if (frames_.erase(frame_id) > 0) {
+      victim_queue_.remove(frame_id);
+    }
+  }
+
+  void Unpin(frame_id_t frame_id) override {
+    if (frames_.insert(frame_id).second) {
+      victim_queue_.push_back(frame_id);
+    }
+  }
+
+  size_t Size() override { return victim_queue_.size(); }
+
+ private:
+  std::list<frame_id_t> victim_queue_;
+  std::unordered_set<frame_id_t> frames_;
+};
+
+/** Runs a buffer-pool-like pin/unpin/victim mix against the replacer and returns the elapsed milliseconds. */
+static double RunReplacerWorkload(Replacer *replacer, size_t num_frames, size_t num_ops) {
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, static_cast<frame_id_t>(num_frames) - 1);
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer->Unpin(static_cast<frame_id_t>(i));
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_ops; i++) {
+    frame_id_t frame_id = frame_dist(rng);
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+    if (i % 8 == 0 && replacer->Victim(&frame_id)) {
+      replacer->Unpin(frame_id);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
 TEST(LRUReplacerTest, SampleTest) {
   LRUReplacer lru_replacer(7);
 
@@ -59,4 +116,17 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// NOLINTNEXTLINE
+TEST(LRUReplacerTest, DISABLED_PerformanceTest) {
+  const size_t num_ops = 10000;
+  for (size_t num_frames : {1000, 10000, 50000}) {
+    ListLRUReplacer list_replacer;
+    LRUReplacer lru_replacer(num_frames);
+    double list_ms = RunReplacerWorkload(&list_replacer, num_frames, num_ops);
+    double lru_ms = RunReplacerWorkload(&lru_replacer, num_frames, num_ops);
+    LOG_INFO("frames=%zu ops=%zu list=%.2fms intrusive=%.2fms", num_frames, num_ops, list_ms, lru_ms);
+    EXPECT_EQ(list_replacer.Size(), lru_replacer.Size());
+  }
+}
+
 }  // namespace bustub
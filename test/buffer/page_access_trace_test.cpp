@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace_test.cpp
+//
+// Identification: test/buffer/page_access_trace_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_access_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/reuse_distance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageAccessTraceTest, TracerTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(2, disk_manager);
+  std::vector<page_id_t> page_ids(3);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Pages 1 and 2 are resident, page 0 was evicted; fetching 0 then evicts 1.
+  PageAccessTracer tracer;
+  bpm->SetFetchTrace(&tracer);
+  for (page_id_t page_id : {page_ids[2], page_ids[0], page_ids[1], page_ids[1]}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  bpm->SetFetchTrace(nullptr);
+
+  std::vector<PageAccess> accesses = tracer.Collect();
+  ASSERT_EQ(4, accesses.size());
+  std::vector<std::pair<page_id_t, bool>> expected{
+      {page_ids[2], true}, {page_ids[0], false}, {page_ids[1], false}, {page_ids[1], true}};
+  for (size_t i = 0; i < accesses.size(); i++) {
+    EXPECT_EQ(expected[i].first, accesses[i].page_id_);
+    EXPECT_EQ(expected[i].second, accesses[i].hit_);
+    EXPECT_EQ(INVALID_PAGE_ID, accesses[i].owner_);
+  }
+  EXPECT_EQ(0, tracer.GetNumOverwritten());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageAccessTraceTest, RingTest) {
+  // Each thread keeps its last two accesses.
+  PageAccessTracer tracer(2);
+  std::vector<std::thread> threads;
+  for (page_id_t first : {0, 100}) {
+    threads.emplace_back([&tracer, first] {
+      for (page_id_t page_id = first; page_id < first + 5; page_id++) {
+        tracer.Record(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<PageAccess> accesses = tracer.Collect();
+  ASSERT_EQ(4, accesses.size());
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < accesses.size(); i++) {
+    page_ids.push_back(accesses[i].page_id_);
+    if (i > 0) {
+      EXPECT_LE(accesses[i - 1].timestamp_ns_, accesses[i].timestamp_ns_);
+    }
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ((std::vector<page_id_t>{3, 4, 103, 104}), page_ids);
+  EXPECT_EQ(6, tracer.GetNumOverwritten());
+}
+
+// NOLINTNEXTLINE
+TEST(PageAccessTraceTest, ReuseAnalysisTest) {
+  // A B C A B C, then D twice: the pages of the loop are reused at distance 2, D at distance 0.
+  PageTrace trace;
+  uint64_t timestamp = 0;
+  for (page_id_t page_id : {10, 11, 12, 10, 11, 12, 200, 200}) {
+    trace.accesses_.push_back({timestamp++, page_id, INVALID_PAGE_ID, false});
+  }
+  // Pages 10 to 12 are in an extent of owner 10, page 200 in none.
+  trace.ResolveOwners({{10, 10}});
+  trace.owner_names_[10] = "loop table";
+  EXPECT_EQ(10, trace.accesses_[2].owner_);
+  EXPECT_EQ(INVALID_PAGE_ID, trace.accesses_[6].owner_);
+
+  ASSERT_TRUE(trace.Write("test.trace"));
+  PageTrace read;
+  ASSERT_TRUE(PageTrace::Read("test.trace", &read));
+  remove("test.trace");
+  EXPECT_EQ("loop table", read.owner_names_[10]);
+  ASSERT_EQ(trace.accesses_.size(), read.accesses_.size());
+
+  ReuseAnalysis analysis(read.accesses_);
+  const ReuseProfile &total = analysis.total_;
+  EXPECT_EQ(8, total.num_accesses_);
+  EXPECT_EQ(4, total.num_cold_);
+  EXPECT_DOUBLE_EQ(1.0 / 8, total.HitRatio(1));
+  EXPECT_DOUBLE_EQ(1.0 / 8, total.HitRatio(2));
+  EXPECT_DOUBLE_EQ(4.0 / 8, total.HitRatio(3));
+  EXPECT_EQ((std::vector<uint64_t>{1, 0, 3}), total.DistanceLog2Histogram());
+
+  const ReuseProfile &loop = analysis.owners_.at(10);
+  EXPECT_EQ(6, loop.num_accesses_);
+  EXPECT_DOUBLE_EQ(0, loop.HitRatio(2));
+  EXPECT_DOUBLE_EQ(3.0 / 6, loop.HitRatio(3));
+  // A window of one access touches one page; the working sets of the owners add up to that of the trace.
+  EXPECT_DOUBLE_EQ(1, total.WorkingSetSize(1, total.num_accesses_));
+  EXPECT_DOUBLE_EQ(total.WorkingSetSize(3, 8),
+                   loop.WorkingSetSize(3, 8) + analysis.owners_.at(INVALID_PAGE_ID).WorkingSetSize(3, 8));
+}
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <atomic>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  const size_t num_frames = 64;
+  PageTable table(num_frames);
+  frame_id_t frame_id;
+  EXPECT_FALSE(table.Find(0, &frame_id));
+
+  for (size_t i = 0; i < num_frames; i++) {
+    table.Insert(static_cast<page_id_t>(i * 7), static_cast<frame_id_t>(i));
+  }
+  for (size_t i = 0; i < num_frames; i++) {
+    ASSERT_TRUE(table.Find(static_cast<page_id_t>(i * 7), &frame_id));
+    EXPECT_EQ(static_cast<frame_id_t>(i), frame_id);
+    EXPECT_FALSE(table.Find(static_cast<page_id_t>(i * 7 + 1), &frame_id));
+  }
+
+  // Scenario: a page moved to another frame is found there.
+  table.Insert(7, 100);
+  ASSERT_TRUE(table.Find(7, &frame_id));
+  EXPECT_EQ(100, frame_id);
+
+  // Scenario: erasing every other page keeps the rest reachable, whatever their probe sequences.
+  for (size_t i = 0; i < num_frames; i += 2) {
+    table.Erase(static_cast<page_id_t>(i * 7));
+  }
+  table.Erase(1);
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(i % 2 == 1, table.Find(static_cast<page_id_t>(i * 7), &frame_id));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ChurnTest) {
+  // Scenario: a full table churned by a writer, as a pool evicting pages does, never loses a page it holds.
+  const size_t num_frames = 32;
+  PageTable table(num_frames);
+  std::vector<page_id_t> resident(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    resident[i] = static_cast<page_id_t>(i);
+    table.Insert(resident[i], static_cast<frame_id_t>(i));
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> num_wrong{0};
+  std::thread reader([&] {
+    std::mt19937 random(1);
+    frame_id_t frame_id;
+    while (!stop) {
+      // A page other than those of a frame is never found there; a page found maps to the frame it was given.
+      auto page_id = static_cast<page_id_t>(random() % 10000);
+      if (table.Find(page_id, &frame_id) && frame_id != static_cast<frame_id_t>(page_id % num_frames)) {
+        num_wrong++;
+      }
+    }
+  });
+  std::mt19937 random(2);
+  frame_id_t frame_id;
+  size_t num_lost = 0;
+  for (int round = 0; round < 100000; round++) {
+    const size_t frame = random() % num_frames;
+    table.Erase(resident[frame]);
+    resident[frame] = static_cast<page_id_t>((random() % (10000 / num_frames)) * num_frames + frame);
+    table.Insert(resident[frame], static_cast<frame_id_t>(frame));
+    for (size_t i = 0; i < num_frames; i++) {
+      if (!table.Find(resident[i], &frame_id) || frame_id != static_cast<frame_id_t>(i)) {
+        num_lost++;
+      }
+    }
+  }
+  stop = true;
+  reader.join();
+  EXPECT_EQ(0, num_lost);
+  EXPECT_EQ(0, num_wrong);
+}
+
+}  // namespace bustub
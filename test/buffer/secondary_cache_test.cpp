@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// secondary_cache_test.cpp
+//
+// Identification: test/buffer/secondary_cache_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/secondary_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/metrics.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(SecondaryCacheTest, SampleTest) {
+  const size_t num_pages = 4;
+  SecondaryCache cache("test.ssd", num_pages);
+  std::vector<std::vector<char>> data(num_pages + 2, std::vector<char>(PAGE_SIZE));
+  for (size_t i = 0; i < data.size(); i++) {
+    snprintf(data[i].data(), PAGE_SIZE, "Page %zu.", i);
+  }
+  char buf[PAGE_SIZE];
+  SecondaryCache::Ticket ticket;
+  EXPECT_FALSE(cache.Take(0, &ticket));
+
+  // Scenario: a page written can be taken and read back once, then it is gone.
+  cache.Write(cache.Reserve(0), data[0].data());
+  EXPECT_EQ(1, cache.Size());
+  ASSERT_TRUE(cache.Take(0, &ticket));
+  ASSERT_TRUE(cache.Read(ticket, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data[0].data(), PAGE_SIZE));
+  EXPECT_FALSE(cache.Take(0, &ticket));
+
+  // Scenario: a page taken before its copy is written is not found, and the late write does not bring it back.
+  auto reserved = cache.Reserve(1);
+  EXPECT_FALSE(cache.Take(1, &ticket));
+  cache.Write(reserved, data[1].data());
+  EXPECT_FALSE(cache.Take(1, &ticket));
+
+  // Scenario: the slots are reused in turn, forgetting the oldest pages.
+  for (size_t i = 0; i < data.size(); i++) {
+    cache.Write(cache.Reserve(static_cast<page_id_t>(10 + i)), data[i].data());
+  }
+  EXPECT_EQ(num_pages, cache.Size());
+  EXPECT_FALSE(cache.Take(10, &ticket));
+  EXPECT_FALSE(cache.Take(11, &ticket));
+  for (size_t i = 2; i < data.size(); i++) {
+    ASSERT_TRUE(cache.Take(static_cast<page_id_t>(10 + i), &ticket));
+    ASSERT_TRUE(cache.Read(ticket, buf));
+    EXPECT_EQ(0, std::memcmp(buf, data[i].data(), PAGE_SIZE));
+  }
+
+  // Scenario: a copy whose slot is reused before it is read is reported stale.
+  cache.Write(cache.Reserve(20), data[0].data());
+  ASSERT_TRUE(cache.Take(20, &ticket));
+  for (size_t i = 0; i < num_pages; i++) {
+    cache.Write(cache.Reserve(static_cast<page_id_t>(30 + i)), data[1].data());
+  }
+  EXPECT_FALSE(cache.Read(ticket, buf));
+}
+
+// NOLINTNEXTLINE
+TEST(SecondaryCacheTest, BufferPoolTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_pages = 15;
+  MetricsRegistry *registry = MetricsRegistry::Global();
+
+  auto *disk_manager = new DiskManager(db_name);
+  SecondaryCache cache("test.ssd", num_pages);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  bpm->SetSecondaryCache(&cache);
+
+  // Scenario: dirty pages evicted go to the database file only.
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(0, cache.Size());
+  bpm->FlushAllPages();
+
+  // Scenario: clean pages evicted go to the cache, and the misses on them read them from there.
+  for (int round = 0; round < 2; round++) {
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(std::to_string(page_id), page->GetData());
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+  EXPECT_EQ(num_pages - buffer_pool_size, cache.Size());
+  // The pages resident after the flush are evicted in the first round and hit in it; every page hits in the second.
+  EXPECT_EQ(buffer_pool_size + num_pages, registry->GetCounter("buffer_pool.secondary_hits"));
+
+  // Scenario: a page modified after being read from the cache is not read back stale once evicted again.
+  const page_id_t modified = page_ids[0];
+  auto *page = bpm->FetchPage(modified);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "modified");
+  EXPECT_EQ(true, bpm->UnpinPage(modified, true));
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->FetchPage(modified);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("modified", page->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(modified, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -10,12 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstdio>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "common/bustub_instance.h"
+#include "common/thread_pool.h"
 #include "gtest/gtest.h"
 #include "type/value_factory.h"
 
@@ -48,4 +52,523 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(CatalogTest, CreateIndexTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  // The b+ tree keeps its root page id in the header page.
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  Schema schema(columns);
+  auto *table_metadata = catalog->CreateTable(&txn, "potato", schema);
+
+  // Insert the keys out of order, so that the catalog has to sort them for the bulk load.
+  const int64_t num_tuples = 1000;
+  std::vector<RID> rids(num_tuples);
+  for (int64_t i = 0; i < num_tuples; i++) {
+    const int64_t key = (i * 7919) % num_tuples;
+    Tuple tuple({ValueFactory::GetBigIntValue(key), ValueFactory::GetIntegerValue(static_cast<int32_t>(i))}, &schema);
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rids[key], &txn));
+  }
+
+  std::vector<Column> key_columns;
+  key_columns.emplace_back("A", TypeId::BIGINT);
+  Schema key_schema(key_columns);
+  auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_a", "potato", schema,
+                                                                                    key_schema, {0}, 8);
+  EXPECT_EQ(index_info, catalog->GetIndex("potato_a", "potato"));
+  EXPECT_EQ(index_info, catalog->GetIndex(index_info->index_oid_));
+  EXPECT_EQ(std::vector<IndexInfo *>{index_info}, catalog->GetTableIndexes("potato"));
+  EXPECT_THROW(catalog->GetIndex("potato_b", "potato"), std::out_of_range);
+
+  // Scenario: every tuple that was in the table already can be found through the index.
+  for (int64_t key = 0; key < num_tuples; key++) {
+    Tuple key_tuple({ValueFactory::GetBigIntValue(key)}, &key_schema);
+    std::vector<RID> result;
+    index_info->index_->ScanKey(key_tuple, &result, &txn);
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ(rids[key], result[0]);
+  }
+
+  // Scenario: an index without unique keys finds all of the tuples with a key, and forgets them one by one.
+  std::vector<RID> duplicate_rids(num_tuples);
+  for (int64_t key = 0; key < num_tuples; key++) {
+    Tuple tuple({ValueFactory::GetBigIntValue(key), ValueFactory::GetIntegerValue(0)}, &schema);
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &duplicate_rids[key], &txn));
+  }
+  auto *duplicate_index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      &txn, "potato_a_all", "potato", schema, key_schema, {0}, 8, false);
+  for (int64_t key = 0; key < num_tuples; key++) {
+    Tuple key_tuple({ValueFactory::GetBigIntValue(key)}, &key_schema);
+    std::vector<RID> result;
+    duplicate_index_info->index_->ScanKey(key_tuple, &result, &txn);
+    ASSERT_EQ(2, result.size());
+    EXPECT_TRUE((result[0] == rids[key] && result[1] == duplicate_rids[key]) ||
+                (result[1] == rids[key] && result[0] == duplicate_rids[key]));
+    duplicate_index_info->index_->DeleteEntry(key_tuple, rids[key], &txn);
+    result.clear();
+    duplicate_index_info->index_->ScanKey(key_tuple, &result, &txn);
+    EXPECT_EQ(std::vector<RID>{duplicate_rids[key]}, result);
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, ParallelCreateIndexTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(64, disk_manager);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  ThreadPool thread_pool(4);
+  Transaction txn(0);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  Schema schema(columns);
+  auto *table_metadata = catalog->CreateTable(&txn, "potato", schema);
+
+  // Every key is inserted three times, out of order, over enough pages for every worker to claim several morsels.
+  const int64_t num_keys = 3000;
+  std::vector<std::vector<RID>> rids(num_keys);
+  for (int64_t copy = 0; copy < 3; copy++) {
+    for (int64_t i = 0; i < num_keys; i++) {
+      const int64_t key = (i * 7919) % num_keys;
+      Tuple tuple({ValueFactory::GetBigIntValue(key), ValueFactory::GetIntegerValue(static_cast<int32_t>(i))},
+                  &schema);
+      RID rid;
+      ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rid, &txn));
+      rids[key].push_back(rid);
+    }
+  }
+
+  std::vector<Column> key_columns;
+  key_columns.emplace_back("A", TypeId::BIGINT);
+  Schema key_schema(key_columns);
+  auto *serial_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_serial", "potato",
+                                                                                     schema, key_schema, {0}, 8);
+  catalog->SetThreadPool(&thread_pool);
+  auto *unique_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_unique", "potato",
+                                                                                     schema, key_schema, {0}, 8);
+  auto *all_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_all", "potato", schema,
+                                                                                  key_schema, {0}, 8, false);
+
+  for (int64_t key = 0; key < num_keys; key++) {
+    Tuple key_tuple({ValueFactory::GetBigIntValue(key)}, &key_schema);
+    // Scenario: built in parallel, a unique index keeps the tuple of a key found first, as the serial build does.
+    std::vector<RID> serial_result;
+    serial_info->index_->ScanKey(key_tuple, &serial_result, &txn);
+    std::vector<RID> unique_result;
+    unique_info->index_->ScanKey(key_tuple, &unique_result, &txn);
+    ASSERT_EQ(std::vector<RID>{rids[key][0]}, serial_result);
+    ASSERT_EQ(serial_result, unique_result);
+
+    // Scenario: built in parallel, an index without unique keys finds every tuple of a key.
+    std::vector<RID> all_result;
+    all_info->index_->ScanKey(key_tuple, &all_result, &txn);
+    std::sort(all_result.begin(), all_result.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+    std::vector<RID> expected = rids[key];
+    std::sort(expected.begin(), expected.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+    ASSERT_EQ(expected, all_result);
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, PartitionSchemeTest) {
+  // Scenario: a HASH scheme spreads the keys over all the partitions, equal keys of integer types alike.
+  PartitionScheme hash(1, TypeId::INTEGER, 8);
+  std::vector<size_t> counts(8);
+  for (int32_t key = 0; key < 8000; key++) {
+    const size_t partition = hash.PartitionOf(ValueFactory::GetIntegerValue(key));
+    ASSERT_LT(partition, 8);
+    ASSERT_EQ(partition, hash.PartitionOf(ValueFactory::GetBigIntValue(key)));
+    counts[partition]++;
+  }
+  for (size_t count : counts) {
+    EXPECT_GT(count, 500);
+  }
+  EXPECT_EQ(hash.PartitionOf(ValueFactory::GetNullValueByType(TypeId::INTEGER)), 0);
+
+  // Scenario: only a single key of a comparable type narrows a HASH scheme down, to the partition of the key.
+  Value key = ValueFactory::GetBigIntValue(42);
+  std::vector<bool> candidates(8, true);
+  hash.Prune(&key, &key, &candidates);
+  EXPECT_EQ(std::count(candidates.begin(), candidates.end(), true), 1);
+  EXPECT_TRUE(candidates[hash.PartitionOf(key)]);
+  candidates.assign(8, true);
+  hash.Prune(&key, nullptr, &candidates);
+  EXPECT_EQ(std::count(candidates.begin(), candidates.end(), true), 8);
+  Value decimal = ValueFactory::GetDecimalValue(42);
+  hash.Prune(&decimal, &decimal, &candidates);
+  EXPECT_EQ(std::count(candidates.begin(), candidates.end(), true), 8);
+
+  // Scenario: a RANGE scheme splits the keys at its bounds, and rules out the partitions outside of a range.
+  PartitionScheme range(0, {ValueFactory::GetIntegerValue(10), ValueFactory::GetIntegerValue(20)});
+  EXPECT_EQ(range.GetNumPartitions(), 3);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetIntegerValue(-5)), 0);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetIntegerValue(9)), 0);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetIntegerValue(10)), 1);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetIntegerValue(19)), 1);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetIntegerValue(20)), 2);
+  EXPECT_EQ(range.PartitionOf(ValueFactory::GetNullValueByType(TypeId::INTEGER)), 0);
+  Value low = ValueFactory::GetIntegerValue(12);
+  Value high = ValueFactory::GetIntegerValue(25);
+  candidates.assign(3, true);
+  range.Prune(&low, &high, &candidates);
+  EXPECT_EQ(candidates, (std::vector<bool>{false, true, true}));
+  candidates.assign(3, true);
+  range.Prune(nullptr, &low, &candidates);
+  EXPECT_EQ(candidates, (std::vector<bool>{true, true, false}));
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, AnalyzeTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  columns.emplace_back("C", TypeId::VARCHAR, 16);
+  Schema schema(columns);
+  auto *table_metadata = catalog->CreateTable(&txn, "potato", schema);
+  EXPECT_FALSE(table_metadata->stats_.IsAnalyzed());
+  EXPECT_EQ(table_metadata->stats_.GetRowCount(), 0);
+
+  // A takes 10000 values twice over, B is NULL in a quarter of the rows, and C takes 100 values.
+  const int64_t num_tuples = 20000;
+  for (int64_t i = 0; i < num_tuples; i++) {
+    Value b = i % 4 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                         : ValueFactory::GetIntegerValue(static_cast<int32_t>(i));
+    Tuple tuple({ValueFactory::GetBigIntValue((i * 7919) % 10000), b,
+                 ValueFactory::GetVarcharValue("potato" + std::to_string(i % 100))},
+                &schema);
+    RID rid;
+    ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rid, &txn));
+  }
+
+  // Scenario: the statistics are computed from the table.
+  const TableStatistics &stats = catalog->Analyze(&txn, "potato");
+  EXPECT_EQ(&stats, &table_metadata->stats_);
+  EXPECT_TRUE(stats.IsAnalyzed());
+  EXPECT_EQ(stats.GetRowCount(), num_tuples);
+  EXPECT_DOUBLE_EQ(stats.GetNullFraction(0), 0);
+  EXPECT_DOUBLE_EQ(stats.GetNullFraction(1), 0.25);
+  EXPECT_NEAR(stats.GetDistinctCount(0), 10000, 500);
+  EXPECT_NEAR(stats.GetDistinctCount(1), 15000, 750);
+  EXPECT_NEAR(stats.GetDistinctCount(2), 100, 5);
+
+  std::vector<Value> histogram = stats.GetHistogram(0);
+  ASSERT_EQ(histogram.size(), TableStatistics::HISTOGRAM_BUCKETS);
+  for (size_t i = 1; i < histogram.size(); i++) {
+    EXPECT_EQ(histogram[i - 1].CompareLessThanEquals(histogram[i]), CmpBool::CmpTrue);
+  }
+  EXPECT_EQ(histogram.back().GetAs<int64_t>(), 9999);
+  EXPECT_NEAR(stats.EstimateLessThanFraction(0, ValueFactory::GetBigIntValue(5000)), 0.5, 0.05);
+  EXPECT_NEAR(stats.EstimateLessThanFraction(0, ValueFactory::GetBigIntValue(20000)), 1, 1e-9);
+  EXPECT_NEAR(stats.EstimateLessThanFraction(1, ValueFactory::GetIntegerValue(10000)), 0.375, 0.05);
+  EXPECT_NEAR(stats.EstimateEqualFraction(0, ValueFactory::GetBigIntValue(7)), 1.0 / 10000, 1e-5);
+  EXPECT_DOUBLE_EQ(stats.EstimateEqualFraction(1, ValueFactory::GetNullValueByType(TypeId::INTEGER)), 0);
+
+  // Scenario: the counts follow the tuples added and removed, the histograms stay as analyzed.
+  Tuple tuple({ValueFactory::GetBigIntValue(10000), ValueFactory::GetNullValueByType(TypeId::INTEGER),
+               ValueFactory::GetVarcharValue("carrot")},
+              &schema);
+  for (int i = 0; i < 4; i++) {
+    table_metadata->stats_.AddTuple(tuple);
+  }
+  EXPECT_EQ(stats.GetRowCount(), num_tuples + 4);
+  EXPECT_DOUBLE_EQ(stats.GetNullFraction(1), (num_tuples / 4 + 4) / static_cast<double>(num_tuples + 4));
+  EXPECT_NEAR(stats.GetDistinctCount(2), 101, 5);
+  for (int i = 0; i < 4; i++) {
+    table_metadata->stats_.RemoveTuple(tuple);
+  }
+  EXPECT_EQ(stats.GetRowCount(), num_tuples);
+  EXPECT_DOUBLE_EQ(stats.GetNullFraction(1), 0.25);
+  EXPECT_EQ(stats.GetHistogram(0).size(), TableStatistics::HISTOGRAM_BUCKETS);
+
+  // Scenario: analyzed from a quarter of the pages, the counts are scaled up, the distinct values of a unique column
+  // too, but not those of a column whose values all show up in the sample.
+  catalog->Analyze(&txn, "potato", 0.25);
+  EXPECT_NEAR(stats.GetRowCount(), num_tuples, num_tuples * 0.15);
+  EXPECT_NEAR(stats.GetNullFraction(1), 0.25, 0.02);
+  EXPECT_NEAR(stats.GetDistinctCount(1), 15000, 15000 * 0.2);
+  EXPECT_NEAR(stats.GetDistinctCount(2), 100, 5);
+  EXPECT_EQ(stats.GetHistogram(0).size(), TableStatistics::HISTOGRAM_BUCKETS);
+
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, PersistentCatalogTest) {
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::VARCHAR, 16);
+  Schema schema(columns);
+  std::vector<Column> key_columns;
+  key_columns.emplace_back("A", TypeId::BIGINT);
+  Schema key_schema(key_columns);
+  const int64_t num_tuples = 1000;
+  std::vector<RID> rids(num_tuples);
+  table_oid_t table_oid;
+  index_oid_t index_oid;
+
+  // The database of a table, of an index over it, and of a table in PAX pages, flushed before it shuts down.
+  {
+    auto *instance = new BustubInstance("catalog_test.db");
+    Transaction *txn = instance->transaction_manager_->Begin();
+    auto *table_metadata = instance->catalog_->CreateTable(txn, "potato", schema);
+    for (int64_t i = 0; i < num_tuples; i++) {
+      Tuple tuple({ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue("potato" + std::to_string(i))},
+                  &schema);
+      ASSERT_TRUE(table_metadata->table_->InsertTuple(tuple, &rids[i], txn));
+    }
+    auto *index_info = instance->catalog_->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+        txn, "potato_a", "potato", schema, key_schema, {0}, 8);
+    instance->catalog_->CreateTable(txn, "carrot", key_schema, TableFormat::PAX);
+    table_oid = table_metadata->oid_;
+    index_oid = index_info->index_oid_;
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+    instance->buffer_pool_manager_->FlushAllPages();
+    delete instance;
+  }
+
+  // Scenario: the reopened catalog has the tables and the index as they were, without rebuilding anything.
+  {
+    auto *instance = new BustubInstance("catalog_test.db");
+    Transaction *txn = instance->transaction_manager_->Begin();
+    TableMetadata *table_metadata = instance->catalog_->GetTable("potato");
+    EXPECT_EQ(table_metadata->oid_, table_oid);
+    EXPECT_EQ(table_metadata->schema_.ToString(), schema.ToString());
+    EXPECT_EQ(instance->catalog_->GetTable("carrot")->table_->GetFormat(), TableFormat::PAX);
+    int64_t count = 0;
+    for (auto iter = table_metadata->table_->Begin(txn); iter != table_metadata->table_->End(); ++iter) {
+      const int64_t key = iter->GetValue(&schema, 0).GetAs<int64_t>();
+      EXPECT_EQ(iter->GetValue(&schema, 1).ToString(), "potato" + std::to_string(key));
+      count++;
+    }
+    EXPECT_EQ(count, num_tuples);
+    IndexInfo *index_info = instance->catalog_->GetIndex("potato_a", "potato");
+    EXPECT_EQ(index_info->index_oid_, index_oid);
+    EXPECT_EQ(index_info->key_size_, 8);
+    for (int64_t key = 0; key < num_tuples; key++) {
+      std::vector<RID> result;
+      index_info->index_->ScanKey(Tuple({ValueFactory::GetBigIntValue(key)}, &key_schema), &result, txn);
+      ASSERT_EQ(result, std::vector<RID>{rids[key]});
+    }
+
+    // Scenario: what is created next takes new oids and new pages, and is stored as well.
+    auto *onion = instance->catalog_->CreateTable(txn, "onion", schema);
+    EXPECT_NE(onion->oid_, table_oid);
+    RID rid;
+    ASSERT_TRUE(onion->table_->InsertTuple(
+        Tuple({ValueFactory::GetBigIntValue(-1), ValueFactory::GetVarcharValue("onion")}, &schema), &rid, txn));
+    EXPECT_NE(rid.GetPageId(), HEADER_PAGE_ID);
+    std::vector<RID> result;
+    index_info->index_->ScanKey(Tuple({ValueFactory::GetBigIntValue(7)}, &key_schema), &result, txn);
+    EXPECT_EQ(result, std::vector<RID>{rids[7]});
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+    instance->buffer_pool_manager_->FlushAllPages();
+    delete instance;
+  }
+  {
+    auto *instance = new BustubInstance("catalog_test.db");
+    EXPECT_EQ(instance->catalog_->GetTable("onion")->name_, "onion");
+    EXPECT_EQ(instance->catalog_->GetTable("potato")->oid_, table_oid);
+    delete instance;
+  }
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+  remove("catalog_test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, UnloggedTableTest) {
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+  remove("catalog_test.fsm");
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  Schema schema(columns);
+  const int64_t num_tuples = 100;
+  auto tuple_of = [&schema](int64_t i) { return Tuple({ValueFactory::GetBigIntValue(i)}, &schema); };
+  auto count_tuples = [](TableMetadata *table_metadata, Transaction *txn) {
+    int64_t count = 0;
+    for (auto iter = table_metadata->table_->Begin(txn); iter != table_metadata->table_->End(); ++iter) {
+      count++;
+    }
+    return count;
+  };
+
+  {
+    auto *instance = new BustubInstance("catalog_test.db");
+    instance->log_manager_->RunFlushThread();
+    Transaction *txn = instance->transaction_manager_->Begin();
+    auto *logged = instance->catalog_->CreateTable(txn, "logged", schema);
+    auto *staging = instance->catalog_->CreateTable(txn, "staging", schema, TableFormat::ROW, DEFAULT_TABLESPACE,
+                                                    TableDurability::UNLOGGED);
+    auto *scratch = instance->catalog_->CreateTable(txn, "scratch", schema, TableFormat::PAX, DEFAULT_TABLESPACE,
+                                                    TableDurability::TEMPORARY);
+    auto *index_info = instance->catalog_->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+        txn, "staging_a", "staging", schema, schema, {0}, 8);
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+    // The table locks cover the row locks of the writes.
+    auto begin = [&]() {
+      Transaction *txn = instance->transaction_manager_->Begin();
+      for (TableMetadata *table_metadata : {logged, staging, scratch}) {
+        EXPECT_TRUE(instance->lock_manager_->LockTable(txn, LockMode::EXCLUSIVE, table_metadata->oid_));
+      }
+      return txn;
+    };
+
+    // Scenario: the writes to the unlogged and the temporary table append nothing to the log.
+    txn = begin();
+    const lsn_t next_lsn = instance->log_manager_->GetNextLSN();
+    RID rid;
+    RID scratch_rid;
+    for (int64_t i = 0; i <= num_tuples; i++) {
+      ASSERT_TRUE(staging->table_->InsertTuple(tuple_of(i), &rid, txn));
+      index_info->index_->InsertEntry(tuple_of(i), rid, txn);
+      ASSERT_TRUE(scratch->table_->InsertTuple(tuple_of(i), &scratch_rid, txn));
+    }
+    ASSERT_TRUE(staging->table_->MarkDelete(rid, txn));
+    ASSERT_TRUE(scratch->table_->MarkDelete(scratch_rid, txn));
+    EXPECT_EQ(txn->GetPrevLSN(), INVALID_LSN);
+    EXPECT_EQ(instance->log_manager_->GetNextLSN(), next_lsn);
+    ASSERT_TRUE(logged->table_->InsertTuple(tuple_of(0), &rid, txn));
+    EXPECT_NE(txn->GetPrevLSN(), INVALID_LSN);
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+
+    // Scenario: they are read, and rolled back, as any other table.
+    txn = begin();
+    EXPECT_EQ(count_tuples(staging, txn), num_tuples);
+    EXPECT_EQ(count_tuples(scratch, txn), num_tuples);
+    ASSERT_TRUE(staging->table_->InsertTuple(tuple_of(num_tuples), &rid, txn));
+    instance->transaction_manager_->Abort(txn);
+    delete txn;
+    txn = begin();
+    EXPECT_EQ(count_tuples(staging, txn), num_tuples);
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+    instance->buffer_pool_manager_->FlushAllPages();
+    delete instance;
+  }
+
+  // Scenario: on restart, the unlogged table and its index are empty, and the temporary table is gone.
+  {
+    auto *instance = new BustubInstance("catalog_test.db");
+    Transaction *txn = instance->transaction_manager_->Begin();
+    EXPECT_THROW(instance->catalog_->GetTable("scratch"), std::out_of_range);
+    EXPECT_EQ(count_tuples(instance->catalog_->GetTable("logged"), txn), 1);
+    TableMetadata *staging = instance->catalog_->GetTable("staging");
+    EXPECT_EQ(staging->durability_, TableDurability::UNLOGGED);
+    EXPECT_EQ(count_tuples(staging, txn), 0);
+    IndexInfo *index_info = instance->catalog_->GetIndex("staging_a", "staging");
+    std::vector<RID> result;
+    index_info->index_->ScanKey(tuple_of(7), &result, txn);
+    EXPECT_TRUE(result.empty());
+
+    // Scenario: the truncated table is loaded again.
+    RID rid;
+    for (int64_t i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(staging->table_->InsertTuple(tuple_of(i), &rid, txn));
+      index_info->index_->InsertEntry(tuple_of(i), rid, txn);
+    }
+    EXPECT_EQ(count_tuples(staging, txn), num_tuples);
+    index_info->index_->ScanKey(tuple_of(7), &result, txn);
+    EXPECT_EQ(result.size(), 1);
+    instance->transaction_manager_->Commit(txn);
+    delete txn;
+    delete instance;
+  }
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+  remove("catalog_test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, TablespaceTest) {
+  remove("catalog_test.db");
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new Catalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  const tablespace_id_t tablespace = disk_manager->CreateTablespace("fast", {"catalog_test_ts0.dat"});
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::VARCHAR, 64);
+  Schema schema(columns);
+  std::vector<Column> key_columns;
+  key_columns.emplace_back("A", TypeId::BIGINT);
+  Schema key_schema(key_columns);
+  auto *potato = catalog->CreateTable(&txn, "potato", schema, TableFormat::ROW, tablespace);
+  auto *carrot = catalog->CreateTable(&txn, "carrot", schema);
+  for (int64_t i = 0; i < 4000; i++) {
+    Tuple tuple({ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue(std::string(60, 'x'))}, &schema);
+    RID rid;
+    ASSERT_TRUE(potato->table_->InsertTuple(tuple, &rid, &txn));
+    ASSERT_TRUE(carrot->table_->InsertTuple(tuple, &rid, &txn));
+  }
+
+  // Scenario: every page of a table is in the tablespace it was created in.
+  std::unordered_set<page_id_t> potato_pages;
+  for (auto iter = potato->table_->Begin(&txn); iter != potato->table_->End(); ++iter) {
+    potato_pages.insert(iter->GetRid().GetPageId());
+  }
+  EXPECT_GT(potato_pages.size(), EXTENT_SIZE);
+  for (auto page_id : potato_pages) {
+    EXPECT_EQ(disk_manager->GetPageTablespace(page_id), tablespace);
+  }
+  for (auto iter = carrot->table_->Begin(&txn); iter != carrot->table_->End(); ++iter) {
+    EXPECT_EQ(disk_manager->GetPageTablespace(iter->GetRid().GetPageId()), DEFAULT_TABLESPACE);
+  }
+
+  // Scenario: so is an index, from its bulk load on.
+  auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      &txn, "carrot_a", "carrot", schema, key_schema, {0}, 8, true, {}, tablespace);
+  EXPECT_EQ(disk_manager->GetPageTablespace(index_info->index_->GetExtentOwner()), tablespace);
+  std::vector<RID> result;
+  index_info->index_->ScanKey(Tuple({ValueFactory::GetBigIntValue(7)}, &key_schema), &result, &txn);
+  EXPECT_EQ(result.size(), 1);
+
+  delete catalog;
+  delete bpm;
+  delete disk_manager;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  remove("catalog_test.tbs");
+  remove("catalog_test.tsm");
+  remove("catalog_test_ts0.dat");
+}
+
 }  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena_test.cpp
+//
+// Identification: test/common/arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ArenaTest, SampleTest) {
+  Arena arena(1024);
+
+  // Scenario: allocations are aligned, do not overlap, and spill over to new chunks.
+  std::vector<char *> allocations;
+  for (size_t i = 0; i < 100; i++) {
+    size_t size = 1 + i % 37;
+    char *data = arena.Allocate(size, 8);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % 8, 0);
+    memset(data, static_cast<int>(i), size);
+    allocations.push_back(data);
+  }
+  for (size_t i = 0; i < allocations.size(); i++) {
+    for (size_t j = 0; j < 1 + i % 37; j++) {
+      ASSERT_EQ(allocations[i][j], static_cast<char>(i));
+    }
+  }
+  const size_t reserved = arena.GetBytesReserved();
+  EXPECT_GT(reserved, 1024);
+
+  // Scenario: after a reset, the same allocations reuse the chunks.
+  arena.Reset();
+  EXPECT_EQ(arena.GetBytesAllocated(), 0);
+  for (size_t i = 0; i < 100; i++) {
+    arena.Allocate(1 + i % 37, 8);
+  }
+  EXPECT_EQ(arena.GetBytesReserved(), reserved);
+
+  // Scenario: an allocation larger than a chunk gets a chunk of its own.
+  char *large = arena.Allocate(10000);
+  memset(large, 1, 10000);
+  EXPECT_EQ(arena.GetBytesReserved(), reserved + 10000);
+}
+
+}  // namespace bustub
@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_logger_test.cpp
+//
+// Identification: test/common/async_logger_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/async_logger.h"
+#include "common/logger.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the lines written to a stream so far */
+std::vector<std::string> ReadLines(FILE *stream) {
+  std::vector<std::string> lines;
+  rewind(stream);
+  char line[128];
+  while (fgets(line, sizeof(line), stream) != nullptr) {
+    lines.emplace_back(line);
+  }
+  fseek(stream, 0, SEEK_END);
+  return lines;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(AsyncLoggerTest, SampleTest) {
+  FILE *stream = tmpfile();
+  ASSERT_NE(nullptr, stream);
+  {
+    AsyncLogger logger(stream);
+
+    // Scenario: a flushed line is written out.
+    logger.Append("first\n", 6);
+    logger.Flush();
+    EXPECT_EQ(std::vector<std::string>{"first\n"}, ReadLines(stream));
+
+    // Scenario: threads log many more lines than the ring holds; every line comes out once, and the lines of each
+    // thread in order.
+    const int num_threads = 4;
+    const int num_lines = 10 * AsyncLogger::RING_SIZE;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+      threads.emplace_back([&logger, thread] {
+        for (int i = 0; i < num_lines; i++) {
+          std::string line = std::to_string(thread) + " " + std::to_string(i) + "\n";
+          logger.Append(line.data(), line.size());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    logger.Flush();
+    std::vector<std::string> lines = ReadLines(stream);
+    ASSERT_EQ(1 + num_threads * num_lines, lines.size());
+    std::vector<int> next(num_threads, 0);
+    for (size_t i = 1; i < lines.size(); i++) {
+      int thread;
+      int line;
+      ASSERT_EQ(2, sscanf(lines[i].c_str(), "%d %d", &thread, &line));  // NOLINT
+      ASSERT_EQ(next[thread]++, line);
+    }
+
+    // Scenario: lines appended after the logger stops are written out at once.
+    logger.Stop();
+    logger.Stop();
+    logger.Append("last\n", 5);
+    EXPECT_EQ("last\n", ReadLines(stream).back());
+  }
+  fclose(stream);
+
+  // Scenario: the LOG_* macros format a header then the message.
+  LOG_INFO("%s %d", "answer", 42);
+  AsyncLogger::Instance()->Flush();
+}
+
+// NOLINTNEXTLINE
+TEST(AsyncLoggerTest, DISABLED_PerformanceTest) {
+  const int num_threads = 4;
+  const int num_lines = 250000;
+  const std::string line = "2020-01-01 00:00:00 [executor.cpp:123:Next] INFO  - a line of about eighty characters\n";
+  auto run = [&](auto &&append) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < num_lines; i++) {
+          append();
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  FILE *stream = tmpfile();
+  ASSERT_NE(nullptr, stream);
+  auto sync_ms = run([&] {
+    fwrite(line.data(), 1, line.size(), stream);
+    fflush(stream);
+  });
+  int64_t async_ms;
+  {
+    AsyncLogger logger(stream);
+    async_ms = run([&] { logger.Append(line.data(), line.size()); });
+    logger.Flush();
+  }
+  fclose(stream);
+  LOG_INFO("fwrite and fflush: %ld ms, async logger: %ld ms", sync_ms, async_ms);
+}
+
+}  // namespace bustub
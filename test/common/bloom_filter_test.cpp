@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter_test.cpp
+//
+// Identification: test/common/bloom_filter_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/util/bloom_filter.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BloomFilterTest, SampleTest) {
+  // Scenario: an empty filter rejects everything.
+  BloomFilter empty;
+  for (hash_t hash = 0; hash < 1000; hash++) {
+    ASSERT_FALSE(empty.MayContain(hash));
+  }
+
+  // Scenario: the inserted hashes are all found, and few of the others are mistaken for them, even sequential ones.
+  const size_t num_keys = 10000;
+  BloomFilter filter(num_keys);
+  EXPECT_GE(filter.GetSize() * 8, num_keys * BloomFilter::BITS_PER_KEY);
+  for (hash_t hash = 0; hash < num_keys; hash++) {
+    filter.Insert(hash);
+  }
+  for (hash_t hash = 0; hash < num_keys; hash++) {
+    ASSERT_TRUE(filter.MayContain(hash)) << hash;
+  }
+  size_t false_positives = 0;
+  const size_t num_lookups = 100000;
+  for (hash_t hash = num_keys; hash < num_keys + num_lookups; hash++) {
+    false_positives += filter.MayContain(hash) ? 1 : 0;
+  }
+  EXPECT_LT(false_positives, num_lookups / 50);
+
+  filter.Reset(0);
+  EXPECT_FALSE(filter.MayContain(0));
+}
+
+// NOLINTNEXTLINE
+TEST(BloomFilterTest, BPlusTreeIndexTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  auto *metadata = new IndexMetadata("index", "table", &schema, {0});
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(metadata, bpm);
+  auto key_of = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, &schema); };
+
+  // The even keys up to 2000, half before the filter is built.
+  for (int64_t key = 0; key < 1000; key += 2) {
+    index.InsertEntry(key_of(key), RID(0, key), nullptr);
+  }
+  EXPECT_FALSE(index.HasBloomFilter());
+  index.EnableBloomFilter();
+  EXPECT_TRUE(index.HasBloomFilter());
+  for (int64_t key = 1000; key < 2000; key += 2) {
+    index.InsertEntry(key_of(key), RID(0, key), nullptr);
+  }
+
+  // Scenario: the keys the index holds are found past the filter, through its rebuilds, and the others are not.
+  std::vector<Tuple> keys;
+  for (int64_t key = -10; key < 2010; key++) {
+    std::vector<RID> rids;
+    index.ScanKey(key_of(key), &rids, nullptr);
+    bool held = key >= 0 && key < 2000 && key % 2 == 0;
+    ASSERT_EQ(rids.size(), held ? 1 : 0) << key;
+    keys.push_back(key_of(key));
+  }
+  std::vector<std::vector<RID>> results;
+  index.ScanKeys(keys, &results, nullptr);
+  ASSERT_EQ(results.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    int64_t key = static_cast<int64_t>(i) - 10;
+    EXPECT_EQ(results[i].size(), key >= 0 && key < 2000 && key % 2 == 0 ? 1 : 0) << key;
+  }
+
+  // Scenario: a deleted key is not found, though it stays in the filter.
+  index.DeleteEntry(key_of(10), RID(0, 10), nullptr);
+  std::vector<RID> rids;
+  index.ScanKey(key_of(10), &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/logger.h"
+#include "common/util/hash_util.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+#include "murmur3/MurmurHash3.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the largest number of hashes that fall into one of num_buckets buckets by their low bits */
+size_t FullestBucket(const std::vector<hash_t> &hashes, size_t num_buckets) {
+  std::vector<size_t> buckets(num_buckets);
+  size_t fullest = 0;
+  for (hash_t hash : hashes) {
+    fullest = std::max(fullest, ++buckets[hash % num_buckets]);
+  }
+  return fullest;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, SampleTest) {
+  // Scenario: byte strings of every length up to past the three-lane loop hash apart, also when one bit flips.
+  std::string bytes(200, 'x');
+  std::unordered_set<hash_t> hashes;
+  for (size_t length = 0; length <= bytes.size(); length++) {
+    ASSERT_TRUE(hashes.insert(HashUtil::HashBytes(bytes.data(), length)).second);
+    if (length > 0) {
+      std::string flipped = bytes.substr(0, length);
+      flipped[length / 2] ^= 1;
+      ASSERT_TRUE(hashes.insert(HashUtil::HashBytes(flipped.data(), length)).second);
+    }
+  }
+  EXPECT_NE(HashUtil::HashBytes(bytes.data(), 16), HashUtil::HashBytes(bytes.data(), 16, 1));
+
+  // Scenario: sequential integers of 4, 8 and 16 bytes hash apart, and spread evenly over buckets by their low bits,
+  // which is how the hash tables pick a bucket.
+  const size_t num_keys = 1 << 16;
+  std::vector<hash_t> ints;
+  std::vector<hash_t> bigints;
+  std::vector<hash_t> keys;
+  for (size_t i = 0; i < num_keys; i++) {
+    auto i32 = static_cast<int32_t>(i);
+    auto i64 = static_cast<int64_t>(i << 20);
+    GenericKey<16> key;
+    memset(key.data_, 0, sizeof(key.data_));
+    memcpy(key.data_ + 8, &i32, sizeof(i32));
+    ints.push_back(HashUtil::Hash(&i32));
+    bigints.push_back(HashUtil::Hash(&i64));
+    keys.push_back(HashFunction<GenericKey<16>>().GetHash(key));
+  }
+  for (const auto *column : {&ints, &bigints, &keys}) {
+    EXPECT_EQ(num_keys, std::unordered_set<hash_t>(column->begin(), column->end()).size());
+    EXPECT_LT(FullestBucket(*column, 1024), 2 * num_keys / 1024);
+    EXPECT_LT(FullestBucket(*column, 1000), 2 * num_keys / 1000);
+  }
+
+  // Scenario: combining hashes depends on their order.
+  EXPECT_NE(HashUtil::CombineHashes(1, 2), HashUtil::CombineHashes(2, 1));
+  EXPECT_NE(HashUtil::CombineHashes(0, 0), HashUtil::CombineHashes(0, 1));
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, DISABLED_PerformanceTest) {
+  const uint64_t num_keys = 100000000;
+  uint64_t murmur_sum = 0;
+  uint64_t hash_sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t key = 0; key < num_keys; key++) {
+    uint64_t hash[2];
+    murmur3::MurmurHash3_x64_128(&key, sizeof(key), 0, hash);
+    murmur_sum += hash[0];
+  }
+  auto middle = std::chrono::steady_clock::now();
+  HashFunction<uint64_t> hash_fn;
+  for (uint64_t key = 0; key < num_keys; key++) {
+    hash_sum += hash_fn.GetHash(key);
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_NE(murmur_sum, hash_sum);
+  LOG_INFO("murmur3: %ld ms, hash function: %ld ms",
+           std::chrono::duration_cast<std::chrono::milliseconds>(middle - start).count(),
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - middle).count());
+}
+
+}  // namespace bustub
@@ -0,0 +1,237 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics_test.cpp
+//
+// Identification: test/common/metrics_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/memory_tracker.h"
+#include "common/metrics.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, HistogramTest) {
+  // Scenario: the values below 8 have buckets of their own, and the others are within a quarter of the buckets' tops.
+  for (uint64_t value = 0; value < 8; value++) {
+    EXPECT_EQ(value, Histogram::BucketTop(Histogram::BucketOf(value)));
+  }
+  for (uint64_t value : {8UL, 9UL, 50UL, 1000UL, 123456789UL, UINT64_MAX}) {
+    const uint64_t top = Histogram::BucketTop(Histogram::BucketOf(value));
+    EXPECT_LE(value, top);
+    EXPECT_LE(top - value, value / 4);
+  }
+  EXPECT_EQ(HISTOGRAM_NUM_BUCKETS - 1, Histogram::BucketOf(UINT64_MAX));
+  EXPECT_EQ(Histogram::BucketOf(99), Histogram::BucketOf(96));
+  EXPECT_NE(Histogram::BucketOf(96), Histogram::BucketOf(95));
+
+  // Scenario: the percentiles are the tops of the buckets they fall in, and no value is lost across threads.
+  Histogram histogram;
+  EXPECT_EQ(0, histogram.Snapshot().Percentile(0.5));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&histogram] {
+      for (uint64_t value = 1; value <= 100; value++) {
+        histogram.Record(value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_EQ(400, snapshot.count_);
+  EXPECT_EQ(4 * 5050, snapshot.sum_);
+  EXPECT_EQ(100, snapshot.max_);
+  EXPECT_DOUBLE_EQ(50.5, snapshot.Mean());
+  // 50 falls in the bucket [48, 55].
+  EXPECT_EQ(55, snapshot.Percentile(0.5));
+  // The top of the last bucket is capped by the largest value.
+  EXPECT_EQ(100, snapshot.Percentile(0.99));
+  EXPECT_EQ(1, snapshot.Percentile(0));
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, CounterTest) {
+  // Scenario: the additions of threads spread over the shards are all counted.
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 32; t++) {
+    threads.emplace_back([&counter] {
+      for (int i = 0; i < 1000; i++) {
+        counter.Add();
+      }
+      counter.Add(10);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(32 * 1010, counter.Get());
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, RegistryTest) {
+  // Scenario: the metrics of several owners under a name are merged, until their owners unregister.
+  MetricsRegistry *registry = MetricsRegistry::Global();
+  Histogram first;
+  Histogram second;
+  int owner1 = 0;
+  int owner2 = 0;
+  registry->RegisterHistogram(&owner1, "test.latency_us", &first);
+  registry->RegisterCounter(&owner1, "test.count", [] { return 3; });
+  registry->RegisterHistogram(&owner2, "test.latency_us", &second);
+  Counter count;
+  count.Add(4);
+  registry->RegisterCounter(&owner2, "test.count", &count);
+  first.Record(10);
+  second.Record(1000);
+
+  HistogramSnapshot merged = registry->GetHistogram("test.latency_us");
+  EXPECT_EQ(2, merged.count_);
+  EXPECT_EQ(1000, merged.max_);
+  EXPECT_EQ(7, registry->GetCounter("test.count"));
+  const std::string dump = registry->Dump();
+  EXPECT_NE(std::string::npos, dump.find("test.count 7\n"));
+  EXPECT_NE(std::string::npos, dump.find("test.latency_us count=2 "));
+
+  registry->Unregister(&owner2);
+  EXPECT_EQ(1, registry->GetHistogram("test.latency_us").count_);
+  EXPECT_EQ(3, registry->GetCounter("test.count"));
+  registry->Unregister(&owner1);
+  EXPECT_EQ(0, registry->GetHistogram("test.latency_us").count_);
+  EXPECT_EQ(0, registry->GetCounter("test.count"));
+  EXPECT_EQ(std::string::npos, registry->Dump().find("test."));
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, LogManagerTest) {
+  // Scenario: the appends, the flushes of the log and the commits waiting for them are recorded in the registry.
+  remove("test.db");
+  remove("test.log");
+  {
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    log_manager.RunFlushThread();
+    for (int i = 0; i < 5; i++) {
+      LogRecord log_record(i, INVALID_LSN, LogRecordType::COMMIT);
+      const lsn_t lsn = log_manager.AppendLogRecord(&log_record);
+      const auto commit_appended = std::chrono::steady_clock::now();
+      log_manager.WaitUntilPersistent(lsn);
+      log_manager.RecordCommitLatency(commit_appended);
+    }
+    log_manager.StopFlushThread();
+
+    MetricsRegistry *registry = MetricsRegistry::Global();
+    EXPECT_EQ(5, registry->GetHistogram("log.commit_latency_us").count_);
+    EXPECT_EQ(5, registry->GetHistogram("log.flush_records").sum_);
+    EXPECT_LT(0, registry->GetHistogram("log.flush_bytes").sum_);
+    EXPECT_LT(0, registry->GetHistogram("log.write_latency_us").count_);
+    EXPECT_EQ(5, registry->GetHistogram("log.append_latency_ns").count_);
+    disk_manager.ShutDown();
+  }
+  // The log manager unregistered its metrics when it was destroyed.
+  EXPECT_EQ(0, MetricsRegistry::Global()->GetHistogram("log.commit_latency_us").count_);
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, BufferPoolManagerTest) {
+  // Scenario: the fetches of a buffer pool are counted as hits or misses, and the pages it evicts as evictions.
+  remove("test.db");
+  {
+    DiskManager disk_manager("test.db");
+    BufferPoolManager bpm(2, &disk_manager);
+    MetricsRegistry *registry = MetricsRegistry::Global();
+    page_id_t page_ids[3];
+    for (auto &page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // The third page took the frame of the first one, which was dirty.
+    EXPECT_EQ(1, registry->GetCounter("buffer_pool.evictions"));
+    EXPECT_EQ(1, registry->GetCounter("buffer_pool.dirty_writes"));
+
+    ASSERT_NE(nullptr, bpm.FetchPage(page_ids[2]));
+    ASSERT_TRUE(bpm.UnpinPage(page_ids[2], false));
+    ASSERT_NE(nullptr, bpm.FetchPage(page_ids[0]));
+    ASSERT_TRUE(bpm.UnpinPage(page_ids[0], false));
+    EXPECT_EQ(1, registry->GetCounter("buffer_pool.hits"));
+    EXPECT_EQ(1, registry->GetCounter("buffer_pool.misses"));
+    EXPECT_EQ(1, registry->GetHistogram("buffer_pool.read_latency_us").count_);
+    EXPECT_EQ(2, registry->GetCounter("buffer_pool.evictions"));
+    EXPECT_EQ(2, registry->GetCounter("buffer_pool.dirty_writes"));
+    disk_manager.ShutDown();
+  }
+  EXPECT_EQ(0, MetricsRegistry::Global()->GetCounter("buffer_pool.hits"));
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, MemoryTest) {
+  // Scenario: the memory of each subsystem is counted as it is allocated, and no longer once freed.
+  remove("test.db");
+  remove("test.log");
+  MetricsRegistry *registry = MetricsRegistry::Global();
+  auto bytes_of = [&](MemoryTag tag) {
+    return registry->GetCounter(std::string("memory.") + MemoryTracker::NameOf(tag) + "_bytes");
+  };
+  {
+    Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+    const uint64_t tuple_bytes = bytes_of(MemoryTag::TUPLES);
+    {
+      Tuple tuple({ValueFactory::GetIntegerValue(1)}, &schema);
+      Tuple copy(tuple);
+      EXPECT_EQ(tuple_bytes + 2 * sizeof(int32_t), bytes_of(MemoryTag::TUPLES));
+    }
+    EXPECT_EQ(tuple_bytes, bytes_of(MemoryTag::TUPLES));
+
+    DiskManager disk_manager("test.db");
+    const uint64_t log_bytes = bytes_of(MemoryTag::LOG_BUFFERS);
+    auto *log_manager = new LogManager(&disk_manager);
+    EXPECT_LE(log_bytes + 2 * LOG_BUFFER_SIZE, bytes_of(MemoryTag::LOG_BUFFERS));
+    delete log_manager;
+    EXPECT_EQ(log_bytes, bytes_of(MemoryTag::LOG_BUFFERS));
+
+    // The running transactions are counted, and the lock requests they made: a leaked transaction would stay.
+    LockManager lock_manager;
+    TransactionManager txn_manager(&lock_manager);
+    const uint64_t txn_bytes = bytes_of(MemoryTag::TRANSACTIONS);
+    const uint64_t lock_bytes = bytes_of(MemoryTag::LOCK_MANAGER);
+    Transaction *txn = txn_manager.Begin();
+    ASSERT_TRUE(lock_manager.LockShared(txn, RID(0, 0)));
+    const uint64_t running_txn_bytes = bytes_of(MemoryTag::TRANSACTIONS);
+    EXPECT_LE(txn_bytes + sizeof(Transaction), running_txn_bytes);
+    EXPECT_LT(lock_bytes, bytes_of(MemoryTag::LOCK_MANAGER));
+    txn_manager.Commit(txn);
+    delete txn;
+    EXPECT_GE(running_txn_bytes - sizeof(Transaction), bytes_of(MemoryTag::TRANSACTIONS));
+
+    BufferPoolManager bpm(2, &disk_manager);
+    EXPECT_EQ(2 * PAGE_SIZE, registry->GetCounter("memory.buffer_pool_bytes"));
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/logger.h"
 #include "common/rwlatch.h"
 #include "gtest/gtest.h"
 
@@ -57,4 +60,86 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ContentionTest) {
+  // Scenario: the readers never see a write half done, and no write is lost, with threads parking on the latch.
+  const int num_threads = 16;
+  const int num_rounds = 2000;
+  ReaderWriterLatch latch;
+  int first = 0;
+  int second = 0;
+  std::atomic<bool> torn{false};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int i = 0; i < num_rounds; i++) {
+        if ((i + tid) % 4 == 0) {
+          latch.WLock();
+          first++;
+          std::this_thread::yield();
+          second++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          if (first != second) {
+            torn = true;
+          }
+          latch.RUnlock();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(torn);
+  EXPECT_EQ(first, num_threads * num_rounds / 4);
+  EXPECT_EQ(second, first);
+
+  // Scenario: TryRLock fails while a writer holds the latch, or waits for the readers to leave.
+  latch.WLock();
+  EXPECT_FALSE(latch.TryRLock());
+  latch.WUnlock();
+  ASSERT_TRUE(latch.TryRLock());
+  std::atomic<bool> written{false};
+  std::thread writer([&] {
+    latch.WLock();
+    written = true;
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(written);
+  EXPECT_FALSE(latch.TryRLock());
+  latch.RUnlock();
+  writer.join();
+  EXPECT_TRUE(written);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, DISABLED_PerformanceTest) {
+  // The read-mostly latching of pages: short read sections, and one write in every 64 sections.
+  const int num_ops = 1 << 20;
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    Counter counter{};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&counter, num_threads] {
+        for (int i = 0; i < num_ops / num_threads; i++) {
+          if (i % 64 == 0) {
+            counter.Add(1);
+          } else {
+            counter.Read();
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("threads=%d ops=%d %.1fms (%.0f ops/ms)", num_threads, num_ops, ms, num_ops / ms);
+  }
+}
 }  // namespace bustub
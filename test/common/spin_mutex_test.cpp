@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spin_mutex_test.cpp
+//
+// Identification: test/common/spin_mutex_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+#include "common/spin_mutex.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(SpinMutexTest, ContentionTest) {
+  // Scenario: no increment is lost, with threads spinning and sleeping on the mutex.
+  const int num_threads = 16;
+  const int num_rounds = 5000;
+  SpinMutex mutex;
+  int count = 0;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_rounds; i++) {
+        std::lock_guard<SpinMutex> guard(mutex);
+        count++;
+        if (i % 100 == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(count, num_threads * num_rounds);
+
+  // Scenario: try_lock fails while the mutex is held, and the holder's unlock wakes up a sleeping thread.
+  mutex.lock();
+  EXPECT_FALSE(mutex.try_lock());
+  const uint64_t num_contended = mutex.GetNumContended();
+  std::atomic<bool> locked{false};
+  std::thread waiter([&] {
+    std::lock_guard<SpinMutex> guard(mutex);
+    locked = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(locked);
+  EXPECT_EQ(mutex.GetNumContended(), num_contended + 1);
+  mutex.unlock();
+  waiter.join();
+  EXPECT_TRUE(locked);
+  ASSERT_TRUE(mutex.try_lock());
+  mutex.unlock();
+
+  // Scenario: a condition variable waits on the mutex, as the buffer pool and the lock manager do.
+  std::condition_variable_any cv;
+  bool ready = false;
+  std::thread notifier([&] {
+    std::lock_guard<SpinMutex> guard(mutex);
+    ready = true;
+    cv.notify_all();
+  });
+  {
+    std::unique_lock<SpinMutex> lock(mutex);
+    cv.wait(lock, [&] { return ready; });
+  }
+  notifier.join();
+}
+
+template <typename Mutex>
+static void RunShortSections(const char *name) {
+  // The sections of the buffer pool latch: a few loads and stores under the latch.
+  const int num_ops = 1 << 20;
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    Mutex mutex;
+    int64_t count = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, num_threads] {
+        for (int i = 0; i < num_ops / num_threads; i++) {
+          std::lock_guard<Mutex> guard(mutex);
+          count++;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("%s threads=%d ops=%d %.1fms (%.0f ops/ms)", name, num_threads, num_ops, ms, num_ops / ms);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(SpinMutexTest, DISABLED_PerformanceTest) {
+  RunShortSections<std::mutex>("std::mutex");
+  RunShortSections<SpinMutex>("SpinMutex");
+}
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool_test.cpp
+//
+// Identification: test/common/thread_pool_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ThreadPoolTest, StrideTest) {
+  ThreadPool thread_pool(1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::mutex latch;
+  std::vector<WorkloadClass> order;
+
+  // The worker is held up while both classes queue tasks, the analytical ones first.
+  thread_pool.Submit([opened] { opened.wait(); });
+  const size_t num_tasks = 20;
+  for (WorkloadClass workload_class : {WorkloadClass::ANALYTICAL, WorkloadClass::INTERACTIVE}) {
+    for (size_t i = 0; i < num_tasks; i++) {
+      thread_pool.Submit(
+          [&, workload_class] {
+            std::scoped_lock lock(latch);
+            order.push_back(workload_class);
+          },
+          workload_class);
+    }
+  }
+  gate.set_value();
+  thread_pool.RunAll(1, [](size_t) {}, WorkloadClass::ANALYTICAL);
+
+  // Scenario: while both classes have tasks queued, the interactive class starts 8 tasks for every analytical one.
+  std::scoped_lock lock(latch);
+  ASSERT_EQ(order.size(), 2 * num_tasks);
+  size_t num_analytical = 0;
+  for (size_t i = 0; i < 18; i++) {
+    num_analytical += order[i] == WorkloadClass::ANALYTICAL;
+  }
+  EXPECT_EQ(num_analytical, 2);
+  EXPECT_EQ(order[0], WorkloadClass::ANALYTICAL);
+  EXPECT_EQ(order[9], WorkloadClass::ANALYTICAL);
+}
+
+// NOLINTNEXTLINE
+TEST(ThreadPoolTest, YieldTest) {
+  // Scenario: outside of a task of a pool, a preemption point does nothing.
+  ThreadPool::Yield();
+
+  // Scenario: a long analytical task holds the only worker, and runs an interactive task at a preemption point.
+  ThreadPool thread_pool(1);
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  std::atomic<bool> ran_inline{false};
+  std::thread::id analytical_thread;
+  std::promise<void> done;
+  thread_pool.Submit(
+      [&] {
+        analytical_thread = std::this_thread::get_id();
+        started = true;
+        for (size_t i = 0; i < 10000 && !ran_inline; i++) {
+          ThreadPool::Yield();
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        finished = true;
+        done.set_value();
+      },
+      WorkloadClass::ANALYTICAL);
+  while (!started) {
+    std::this_thread::yield();
+  }
+  thread_pool.Submit([&] { ran_inline = !finished && std::this_thread::get_id() == analytical_thread; });
+  done.get_future().wait();
+  EXPECT_TRUE(ran_inline);
+
+  // Scenario: an interactive task does not run analytical tasks at its preemption points.
+  std::atomic<bool> analytical_ran{false};
+  std::atomic<bool> ran_before{true};
+  thread_pool.RunAll(1, [&](size_t) {
+    thread_pool.Submit([&] { analytical_ran = true; }, WorkloadClass::ANALYTICAL);
+    ThreadPool::Yield();
+    ran_before = analytical_ran.load();
+  });
+  EXPECT_FALSE(ran_before);
+}
+
+}  // namespace bustub
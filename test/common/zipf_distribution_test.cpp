@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zipf_distribution_test.cpp
+//
+// Identification: test/common/zipf_distribution_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <vector>
+
+#include "common/util/zipf_distribution.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ZipfDistributionTest, SampleTest) {
+  const uint64_t min = 10;
+  const uint64_t num_values = 1000;
+  const size_t num_draws = 200000;
+  std::mt19937_64 random(42);
+
+  // Scenario: the draws stay in [min, max], and the smaller a value the more often it is drawn; the stronger the
+  // skew, the larger the share of the hottest 1% of the values.
+  double previous_share = 0;
+  for (double theta : {0.5, 0.75, 0.99}) {
+    ZipfDistribution zipf(min, min + num_values - 1, theta);
+    std::vector<size_t> counts(num_values);
+    for (size_t i = 0; i < num_draws; i++) {
+      uint64_t value = zipf(random);
+      ASSERT_GE(value, min);
+      ASSERT_LT(value, min + num_values);
+      counts[value - min]++;
+    }
+    EXPECT_GT(counts[0], counts[1]);
+    EXPECT_GT(counts[1], counts[10]);
+    EXPECT_GT(counts[10], counts[num_values - 1]);
+    size_t hottest = 0;
+    for (size_t rank = 0; rank < num_values / 100; rank++) {
+      hottest += counts[rank];
+    }
+    double share = static_cast<double>(hottest) / num_draws;
+    EXPECT_GT(share, previous_share) << theta;
+    previous_share = share;
+  }
+  EXPECT_GT(previous_share, 0.3);
+
+  // Scenario: a single value is always drawn.
+  ZipfDistribution single(7, 7, 0.99);
+  EXPECT_EQ(7, single(random));
+}
+
+}  // namespace bustub
@@ -2,10 +2,16 @@
  * lock_manager_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <random>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "common/logger.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
@@ -77,7 +83,7 @@ void BasicTest1() {
     delete txns[i];
   }
 }
-TEST(LockManagerTest, DISABLED_BasicTest) { BasicTest1(); }
+TEST(LockManagerTest, BasicTest) { BasicTest1(); }
 
 void TwoPLTest() {
   LockManager lock_mgr{};
@@ -123,7 +129,7 @@ void TwoPLTest() {
 
   delete txn;
 }
-TEST(LockManagerTest, DISABLED_TwoPLTest) { TwoPLTest(); }
+TEST(LockManagerTest, TwoPLTest) { TwoPLTest(); }
 
 void UpgradeTest() {
   LockManager lock_mgr{};
@@ -150,9 +156,9 @@ void UpgradeTest() {
   txn_mgr.Commit(&txn);
   CheckCommitted(&txn);
 }
-TEST(LockManagerTest, DISABLED_UpgradeLockTest) { UpgradeTest(); }
+TEST(LockManagerTest, UpgradeLockTest) { UpgradeTest(); }
 
-TEST(LockManagerTest, DISABLED_GraphEdgeTest) {
+TEST(LockManagerTest, GraphEdgeTest) {
   LockManager lock_mgr{};
   TransactionManager txn_mgr{&lock_mgr};
   const int num_nodes = 100;
@@ -194,7 +200,7 @@ TEST(LockManagerTest, DISABLED_GraphEdgeTest) {
   }
 }
 
-TEST(LockManagerTest, DISABLED_BasicCycleTest) {
+TEST(LockManagerTest, BasicCycleTest) {
   LockManager lock_mgr{}; /* Use Deadlock detection */
   TransactionManager txn_mgr{&lock_mgr};
 
@@ -211,7 +217,7 @@ TEST(LockManagerTest, DISABLED_BasicCycleTest) {
   EXPECT_EQ(false, lock_mgr.HasCycle(&txn));
 }
 
-TEST(LockManagerTest, DISABLED_BasicDeadlockDetectionTest) {
+TEST(LockManagerTest, BasicDeadlockDetectionTest) {
   LockManager lock_mgr{};
   cycle_detection_interval = std::chrono::milliseconds(500);
   TransactionManager txn_mgr{&lock_mgr};
@@ -267,4 +273,427 @@ TEST(LockManagerTest, DISABLED_BasicDeadlockDetectionTest) {
   delete txn0;
   delete txn1;
 }
+// Exclusive locks on the RIDs of different shards, taken in the same order by every transaction, exclude each other.
+TEST(LockManagerTest, ShardedLockTableTest) {
+  LockManager lock_mgr{4};
+  TransactionManager txn_mgr{&lock_mgr};
+  const int num_threads = 8;
+  const int num_rids = 32;
+  const int num_rounds = 50;
+  std::vector<int> counters(num_rids, 0);
+
+  auto task = [&] {
+    for (int round = 0; round < num_rounds; round++) {
+      Transaction *txn = txn_mgr.Begin();
+      for (int i = 0; i < num_rids; i++) {
+        RID rid{i, static_cast<uint32_t>(i)};
+        EXPECT_TRUE(lock_mgr.LockExclusive(txn, rid));
+        // Not atomic: only the exclusive lock keeps the increments apart.
+        counters[i] = counters[i] + 1;
+      }
+      CheckTxnLockSize(txn, 0, num_rids);
+      txn_mgr.Commit(txn);
+      CheckTxnLockSize(txn, 0, 0);
+      delete txn;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_rids; i++) {
+    EXPECT_EQ(counters[i], num_threads * num_rounds);
+  }
+}
+// Finished transactions leave the global list of running transactions.
+TEST(LockManagerTest, TransactionRegistryTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  const size_t num_running = TransactionManager::GetNumRunningTransactions();
+  const int num_threads = 8;
+  const int num_txns = 100;
+
+  auto task = [&](int thread_id) {
+    for (int i = 0; i < num_txns; i++) {
+      Transaction *txn = txn_mgr.Begin();
+      EXPECT_EQ(TransactionManager::GetTransaction(txn->GetTransactionId()), txn);
+      if (i % 2 == 0) {
+        txn_mgr.Commit(txn);
+      } else {
+        txn_mgr.Abort(txn);
+      }
+      delete txn;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(TransactionManager::GetNumRunningTransactions(), num_running);
+}
+// Intention locks on a table are compatible with each other, and an exclusive table lock waits for all of them.
+TEST(LockManagerTest, TableLockTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  const table_oid_t table_oid = 0;
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockMode::INTENTION_SHARED, table_oid));
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockMode::INTENTION_EXCLUSIVE, table_oid));
+  EXPECT_FALSE(txn0->IsRowLockCovered(table_oid, false));
+  // Taking a shared lock over the intention lock combines both.
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockMode::SHARED, table_oid));
+  LockMode lock_mode;
+  ASSERT_TRUE(txn1->GetTableLockMode(table_oid, &lock_mode));
+  EXPECT_EQ(lock_mode, LockMode::SHARED_INTENTION_EXCLUSIVE);
+  EXPECT_TRUE(txn1->IsRowLockCovered(table_oid, false));
+  EXPECT_FALSE(txn1->IsRowLockCovered(table_oid, true));
+  CheckGrowing(txn1);
+
+  // The exclusive lock of txn2 waits for both.
+  std::atomic<bool> granted{false};
+  std::thread t2([&] {
+    EXPECT_TRUE(lock_mgr.LockTable(txn2, LockMode::EXCLUSIVE, table_oid));
+    granted = true;
+    txn_mgr.Commit(txn2);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(txn0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(txn1);
+  EXPECT_TRUE(txn1->GetTableLockMap()->empty());
+  t2.join();
+  EXPECT_TRUE(granted);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+}
+
+TEST(LockManagerTest, LockEscalationTest) {
+  LockManager lock_mgr{LockManager::DEFAULT_NUM_SHARDS, 2};
+  TransactionManager txn_mgr{&lock_mgr};
+  const table_oid_t table_oid = 0;
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+
+  // Past two shared row locks, txn0 takes a shared table lock instead.
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockMode::INTENTION_SHARED, table_oid));
+  for (int i = 0; i < 3; i++) {
+    RID rid{0, static_cast<uint32_t>(i)};
+    EXPECT_TRUE(lock_mgr.LockShared(txn0, rid));
+    EXPECT_TRUE(lock_mgr.RecordRowLock(txn0, table_oid, rid));
+  }
+  LockMode lock_mode;
+  ASSERT_TRUE(txn0->GetTableLockMode(table_oid, &lock_mode));
+  EXPECT_EQ(lock_mode, LockMode::SHARED);
+  EXPECT_TRUE(txn0->GetSharedLockSet()->empty());
+  EXPECT_TRUE(txn0->GetTableRowLockMap()->at(table_oid).empty());
+  CheckGrowing(txn0);
+
+  // The released row locks are free for others, the table lock still keeps writers out.
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockMode::INTENTION_SHARED, table_oid));
+  EXPECT_TRUE(lock_mgr.LockShared(txn1, RID{0, 0}));
+  txn_mgr.Commit(txn1);
+
+  // An exclusive row lock among them escalates to an exclusive table lock.
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockMode::INTENTION_EXCLUSIVE, table_oid));
+  for (int i = 3; i < 6; i++) {
+    RID rid{0, static_cast<uint32_t>(i)};
+    EXPECT_TRUE(lock_mgr.LockExclusive(txn0, rid));
+    EXPECT_TRUE(lock_mgr.RecordRowLock(txn0, table_oid, rid));
+  }
+  ASSERT_TRUE(txn0->GetTableLockMode(table_oid, &lock_mode));
+  EXPECT_EQ(lock_mode, LockMode::EXCLUSIVE);
+  EXPECT_TRUE(txn0->GetExclusiveLockSet()->empty());
+  CheckGrowing(txn0);
+  txn_mgr.Commit(txn0);
+
+  delete txn0;
+  delete txn1;
+}
+
+TEST(LockManagerTest, IncrementLockTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid{0, 0};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+
+  // Increment locks are compatible with one another.
+  EXPECT_TRUE(lock_mgr.LockIncrement(txn0, rid));
+  EXPECT_TRUE(lock_mgr.LockIncrement(txn1, rid));
+  EXPECT_TRUE(txn0->IsIncrementLocked(rid));
+  EXPECT_TRUE(txn1->IsIncrementLocked(rid));
+  EXPECT_FALSE(txn0->IsExclusiveLocked(rid));
+
+  // A reader waits for every transaction adding to the row.
+  std::atomic<bool> granted{false};
+  std::thread t2([&] {
+    EXPECT_TRUE(lock_mgr.LockShared(txn2, rid));
+    granted = true;
+    txn_mgr.Commit(txn2);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(txn0);
+  EXPECT_FALSE(txn0->IsIncrementLocked(rid));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(txn1);
+  t2.join();
+  EXPECT_TRUE(granted);
+
+  // Reading a row it adds to, a transaction upgrades to an exclusive lock; and a row read is incremented exclusively.
+  auto *txn3 = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockIncrement(txn3, rid));
+  EXPECT_TRUE(lock_mgr.LockShared(txn3, rid));
+  EXPECT_FALSE(txn3->IsIncrementLocked(rid));
+  EXPECT_TRUE(txn3->IsExclusiveLocked(rid));
+  RID other_rid{0, 1};
+  EXPECT_TRUE(lock_mgr.LockShared(txn3, other_rid));
+  EXPECT_TRUE(lock_mgr.LockIncrement(txn3, other_rid));
+  EXPECT_TRUE(txn3->IsExclusiveLocked(other_rid));
+  txn_mgr.Commit(txn3);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+  delete txn3;
+}
+
+TEST(LockManagerTest, KeyRangeLockTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  const KeyRange range{0, RID{0, 0}};
+  const KeyRange other_range{0, RID{0, 1}};
+  auto *reader0 = txn_mgr.Begin();
+  auto *reader1 = txn_mgr.Begin();
+  auto *inserter0 = txn_mgr.Begin();
+  auto *inserter1 = txn_mgr.Begin();
+
+  // Scans share a range, and so do the inserts into one.
+  EXPECT_TRUE(lock_mgr.LockKeyRange(reader0, range, LockMode::SHARED));
+  EXPECT_TRUE(lock_mgr.LockKeyRange(reader1, range, LockMode::SHARED));
+  EXPECT_TRUE(lock_mgr.LockKeyRange(inserter0, other_range, LockMode::INSERT_INTENTION));
+  EXPECT_TRUE(lock_mgr.LockKeyRange(inserter1, other_range, LockMode::INSERT_INTENTION));
+  EXPECT_TRUE(inserter0->IsKeyRangeLocked(other_range, LockMode::INSERT_INTENTION));
+  EXPECT_FALSE(inserter0->IsKeyRangeLocked(other_range, LockMode::SHARED));
+
+  // An insert into a scanned range waits for every scan of it.
+  std::atomic<bool> granted{false};
+  std::thread t([&] {
+    EXPECT_TRUE(lock_mgr.LockKeyRange(inserter0, range, LockMode::INSERT_INTENTION));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(reader0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(reader1);
+  t.join();
+  EXPECT_TRUE(granted);
+  EXPECT_TRUE(reader0->GetKeyRangeLockMap()->empty());
+
+  // A transaction scanning a range it inserts into holds it exclusively, once the other inserts are done.
+  granted = false;
+  std::thread t1([&] {
+    EXPECT_TRUE(lock_mgr.LockKeyRange(inserter0, other_range, LockMode::SHARED));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(inserter1);
+  t1.join();
+  EXPECT_TRUE(granted);
+  EXPECT_TRUE(inserter0->IsKeyRangeLocked(other_range, LockMode::SHARED));
+  EXPECT_TRUE(inserter0->IsKeyRangeLocked(other_range, LockMode::INSERT_INTENTION));
+  txn_mgr.Commit(inserter0);
+
+  delete reader0;
+  delete reader1;
+  delete inserter0;
+  delete inserter1;
+}
+
+TEST(LockManagerTest, WoundWaitTest) {
+  LockManager lock_mgr{DeadlockMode::WOUND_WAIT};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid{0, 0};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+
+  // The younger txn2 waits for the older txn1.
+  EXPECT_TRUE(lock_mgr.LockExclusive(txn1, rid));
+  std::thread t2([&] { EXPECT_FALSE(lock_mgr.LockExclusive(txn2, rid)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CheckGrowing(txn2);
+
+  // The oldest txn0 wounds both: txn2 stops waiting, txn0 waits until txn1 is rolled back.
+  std::atomic<bool> granted{false};
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockShared(txn0, rid));
+    granted = true;
+  });
+  t2.join();
+  CheckAborted(txn2);
+  CheckAborted(txn1);
+  EXPECT_FALSE(granted);
+  txn_mgr.Abort(txn1);
+  t0.join();
+  EXPECT_TRUE(granted);
+  txn_mgr.Abort(txn2);
+  txn_mgr.Commit(txn0);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+}
+
+TEST(LockManagerTest, WaitDieTest) {
+  LockManager lock_mgr{DeadlockMode::WAIT_DIE};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid0{0, 0};
+  RID rid1{0, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+
+  // The older txn0 waits for the younger txn1.
+  EXPECT_TRUE(lock_mgr.LockExclusive(txn0, rid0));
+  EXPECT_TRUE(lock_mgr.LockExclusive(txn1, rid1));
+  std::atomic<bool> granted{false};
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockShared(txn0, rid1));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+
+  // The younger txn1 dies rather than wait for the older txn0, whose wait then ends.
+  EXPECT_FALSE(lock_mgr.LockShared(txn1, rid0));
+  CheckAborted(txn1);
+  txn_mgr.Abort(txn1);
+  t0.join();
+  EXPECT_TRUE(granted);
+  txn_mgr.Commit(txn0);
+
+  delete txn0;
+  delete txn1;
+}
+
+TEST(LockManagerTest, WaitsForEdgeTrackingTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid{0, 0};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+
+  // The waiters add their edges as they block, to every request ahead of them they wait for.
+  EXPECT_TRUE(lock_mgr.LockShared(txn0, rid));
+  std::thread t1([&] { EXPECT_TRUE(lock_mgr.LockExclusive(txn1, rid)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::thread t2([&] { EXPECT_TRUE(lock_mgr.LockShared(txn2, rid)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  auto edges = lock_mgr.GetEdgeList();
+  std::sort(edges.begin(), edges.end());
+  const std::vector<std::pair<txn_id_t, txn_id_t>> expected{{txn1->GetTransactionId(), txn0->GetTransactionId()},
+                                                            {txn2->GetTransactionId(), txn1->GetTransactionId()}};
+  EXPECT_EQ(edges, expected);
+
+  // And drop them once granted.
+  txn_mgr.Commit(txn0);
+  t1.join();
+  txn_mgr.Commit(txn1);
+  t2.join();
+  EXPECT_TRUE(lock_mgr.GetEdgeList().empty());
+  txn_mgr.Commit(txn2);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+}
+// Shared locks on a hot row are granted together, and exclusive locks on it still exclude them and each other.
+TEST(LockManagerTest, HotRowLockTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid{0, 0};
+  const int num_threads = 8;
+  const int num_rounds = 200;
+  int first = 0;
+  int second = 0;
+  std::atomic<bool> torn{false};
+
+  auto task = [&](int thread_id) {
+    for (int round = 0; round < num_rounds; round++) {
+      Transaction *txn = txn_mgr.Begin();
+      if ((round + thread_id) % 8 == 0) {
+        EXPECT_TRUE(lock_mgr.LockExclusive(txn, rid));
+        first++;
+        std::this_thread::yield();
+        second++;
+      } else {
+        EXPECT_TRUE(lock_mgr.LockShared(txn, rid));
+        if (first != second) {
+          torn = true;
+        }
+      }
+      txn_mgr.Commit(txn);
+      delete txn;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(torn);
+  EXPECT_EQ(first, num_threads * num_rounds / 8);
+  EXPECT_EQ(second, first);
+}
+// NOLINTNEXTLINE
+TEST(LockManagerTest, DISABLED_HotRowPerformanceTest) {
+  // Short transactions that all read the same row.
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  RID rid{0, 0};
+  const int num_txns = 1 << 16;
+  for (int num_threads : {1, 2, 4, 8, 16}) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, num_threads] {
+        for (int i = 0; i < num_txns / num_threads; i++) {
+          Transaction *txn = txn_mgr.Begin();
+          lock_mgr.LockShared(txn, rid);
+          txn_mgr.Commit(txn);
+          delete txn;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("threads=%d txns=%d %.1fms (%.0f txns/ms)", num_threads, num_txns, ms, num_txns / ms);
+  }
+}
 }  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bounded_queue_test.cpp
+//
+// Identification: test/container/bounded_queue_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "container/bounded_queue.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BoundedQueueTest, SampleTest) {
+  BoundedQueue<int> queue(3);
+  EXPECT_EQ(4, queue.Capacity());
+
+  // Scenario: items come out in order, and a full or an empty queue is reported.
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(queue.TryPush(&i));
+  }
+  int item = 4;
+  EXPECT_FALSE(queue.TryPush(&item));
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.TryPop(&item));
+    EXPECT_EQ(i, item);
+  }
+  EXPECT_FALSE(queue.TryPop(&item));
+}
+
+// NOLINTNEXTLINE
+TEST(BoundedQueueTest, ConcurrentTest) {
+  BoundedQueue<int> queue(8);
+
+  // Scenario: every item pushed by the producers is popped exactly once by the consumers.
+  const int num_threads = 4;
+  const int items_per_thread = 10000;
+  std::vector<std::atomic<int>> popped(num_threads * items_per_thread);
+  std::atomic<int> num_popped{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&queue, t] {
+      for (int i = t; i < num_threads * items_per_thread; i += num_threads) {
+        int item = i;
+        while (!queue.TryPush(&item)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&queue, &popped, &num_popped] {
+      int item;
+      while (num_popped < num_threads * items_per_thread) {
+        if (queue.TryPop(&item)) {
+          popped[item]++;
+          num_popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_threads * items_per_thread; i++) {
+    ASSERT_EQ(1, popped[i]) << i;
+  }
+}
+
+}  // namespace bustub
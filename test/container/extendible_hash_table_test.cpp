@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_test.cpp
+//
+// Identification: test/container/extendible_hash_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/extendible_hash_table_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // insert a few values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // insert one more value for each key
+  for (int i = 0; i < 5; i++) {
+    if (i == 0) {
+      // duplicate values for the same key are not allowed
+      EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
+    } else {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    }
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i == 0 ? 1 : 2, res.size());
+  }
+
+  // look for a key that does not exist
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+  EXPECT_EQ(0, res.size());
+
+  // delete all values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_EQ(i != 0, ht.Remove(nullptr, i, 2 * i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(0, res.size());
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Scenario: the table grows a bucket at a time, far past what the buffer pool holds.
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, num_keys + i)) << i;
+    }
+  }
+  ht.VerifyIntegrity();
+  EXPECT_LT(0, ht.GetGlobalDepth());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(i % 2 == 0 ? 2 : 1, res.size()) << i;
+  }
+
+  // Scenario: the emptied buckets merge and the directory shrinks back.
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << i;
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, num_keys + i)) << i;
+    }
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Scenario: inserts, lookups and removes race with the splits and merges of one another.
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int i = t; i < num_threads * keys_per_thread; i += num_threads) {
+        ASSERT_TRUE(ht.Insert(nullptr, i, i));
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+        if (i % 3 == 0) {
+          ASSERT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i % 3 == 0 ? 0 : 1, res.size()) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, IndexTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema schema({Column("a", TypeId::BIGINT)});
+  auto *metadata = new IndexMetadata("index", "table", &schema, {0}, false);
+  ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>> index(metadata, bpm,
+                                                                           HashFunction<GenericKey<8>>());
+
+  // Scenario: the index takes the place of a linear probe hash table index.
+  for (int64_t i = 0; i < 1000; i++) {
+    Tuple key({ValueFactory::GetBigIntValue(i % 100)}, &schema);
+    index.InsertEntry(key, RID(static_cast<page_id_t>(i), 0), nullptr);
+  }
+  for (int64_t i = 0; i < 100; i++) {
+    Tuple key({ValueFactory::GetBigIntValue(i)}, &schema);
+    std::vector<RID> rids;
+    index.ScanKey(key, &rids, nullptr);
+    EXPECT_EQ(10, rids.size());
+    index.DeleteEntry(key, RID(static_cast<page_id_t>(i), 0), nullptr);
+    rids.clear();
+    index.ScanKey(key, &rids, nullptr);
+    EXPECT_EQ(9, rids.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
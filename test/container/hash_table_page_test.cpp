@@ -23,7 +23,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_HeaderPageSampleTest) {
+TEST(HashTablePageTest, HeaderPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -61,7 +61,7 @@ TEST(HashTablePageTest, DISABLED_HeaderPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BlockPageSampleTest) {
+TEST(HashTablePageTest, BlockPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -111,4 +111,37 @@ TEST(HashTablePageTest, DISABLED_BlockPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BlockPageGroupTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  using BlockPage = HashTableBlockPage<int, int, IntComparator>;
+  auto block_page = reinterpret_cast<BlockPage *>(bpm->NewPage(&block_page_id, nullptr)->GetData());
+
+  // Scenario: a group of a new page is all empty, and matches no tag.
+  EXPECT_EQ(0xffff, block_page->MatchEmpty(BLOCK_GROUP_SIZE));
+  EXPECT_EQ(0, block_page->MatchTag(BLOCK_GROUP_SIZE, 0));
+
+  // Scenario: the slots of a group match the tag of their key until removed, and are no longer empty even then.
+  const slot_offset_t group = BLOCK_GROUP_SIZE;
+  for (unsigned i = 0; i < 6; i++) {
+    EXPECT_TRUE(block_page->Insert(group + i, i, i, BlockPage::TagOf(i % 3)));
+  }
+  EXPECT_FALSE(block_page->Insert(group + 1, 7, 7, BlockPage::TagOf(7)));
+  block_page->Remove(group + 3);
+  EXPECT_EQ(0b000001, block_page->MatchTag(group, BlockPage::TagOf(0)));
+  EXPECT_EQ(0b010010, block_page->MatchTag(group, BlockPage::TagOf(1)));
+  EXPECT_EQ(0, block_page->MatchTag(group, BlockPage::TagOf(3)));
+  EXPECT_EQ(0xffc0, block_page->MatchEmpty(group));
+  EXPECT_EQ(0xffff, block_page->MatchEmpty(0));
+  EXPECT_EQ(BlockPage::TagOf(0x80), BlockPage::TagOf(0));
+
+  bpm->UnpinPage(block_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -21,7 +24,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(50, disk_manager);
 
@@ -104,4 +107,207 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+
+  // Scenario: the table grows far past its initial size, every pair staying visible while the old tables migrate.
+  const int num_keys = 20000;
+  bool resized = false;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+    resized = resized || ht.IsResizing();
+    if (i % 7 == 0) {
+      std::vector<int> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, i / 2, &res)) << i;
+      ASSERT_EQ(1, res.size());
+    }
+  }
+  EXPECT_TRUE(resized);
+  EXPECT_LE(static_cast<size_t>(num_keys), ht.GetSize());
+
+  // Scenario: a batch of lookups finds what the lookups one at a time would, with and without a resize in progress.
+  std::vector<int> keys;
+  for (int i = -100; i < num_keys + 100; i += 3) {
+    keys.push_back(i);
+  }
+  for (bool resize : {false, true}) {
+    if (resize) {
+      ht.Resize(ht.GetSize());
+      EXPECT_TRUE(ht.IsResizing());
+    }
+    std::vector<std::vector<int>> results;
+    ht.GetValues(nullptr, keys, &results);
+    ASSERT_EQ(keys.size(), results.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      ASSERT_EQ(keys[i] >= 0 && keys[i] < num_keys ? std::vector<int>{keys[i]} : std::vector<int>{}, results[i])
+          << keys[i];
+    }
+  }
+
+  // Scenario: a resize migrates with the operations that follow it, lookups and removes finding pairs in either table.
+  const size_t size = ht.GetSize();
+  ht.Resize(size);
+  EXPECT_TRUE(ht.IsResizing());
+  EXPECT_EQ(2 * size, ht.GetSize());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    ASSERT_EQ(1, res.size());
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i)) << i;
+    }
+  }
+  EXPECT_FALSE(ht.IsResizing());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 != 0, ht.GetValue(nullptr, i, &res)) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+
+  // Scenario: threads insert the same pairs while the table resizes under them; each pair goes in exactly once.
+  const int num_threads = 4;
+  const int num_keys = 10000;
+  std::atomic<int> num_inserted{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, &num_inserted, t] {
+      for (int i = 0; i < num_keys; i++) {
+        const int key = (i + t * num_keys / num_threads) % num_keys;
+        num_inserted += ht.Insert(nullptr, key, key) ? 1 : 0;
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, key, &res)) << key;
+        ASSERT_EQ(1, res.size()) << key;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_keys, num_inserted);
+
+  // Scenario: threads remove and look up disjoint keys while the pairs migrate.
+  ht.Resize(ht.GetSize());
+  threads.clear();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&ht, t] {
+      for (int key = t; key < num_keys; key += num_threads) {
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, key, &res)) << key;
+        ASSERT_EQ(1, res.size()) << key;
+        if (key % 2 == 0) {
+          ASSERT_TRUE(ht.Remove(nullptr, key, key)) << key;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int key = 0; key < num_keys; key++) {
+    std::vector<int> res;
+    EXPECT_EQ(key % 2 != 0, ht.GetValue(nullptr, key, &res)) << key;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, VarlenKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(200, disk_manager);
+  LinearProbeHashTable<VarlenKey, RID, VarlenComparator> ht("blah", bpm, VarlenComparator(), 100,
+                                                            HashFunction<VarlenKey>());
+  const int num_keys = 3000;
+  std::vector<std::string> keys;
+  for (int i = 0; i < num_keys; i++) {
+    keys.push_back(std::string(i % 97, 'x') + std::to_string(i));
+  }
+
+  // Scenario: keys of all sizes go to the heaps of the block pages, which fill up and grow the table along the way.
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, VarlenKey(keys[i].data(), keys[i].size()), RID(0, i)));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, VarlenKey(keys[5].data(), keys[5].size()), RID(0, 5)));
+  EXPECT_TRUE(ht.Insert(nullptr, VarlenKey(keys[5].data(), keys[5].size()), RID(1, 5)));
+  for (int i = 0; i < num_keys; i++) {
+    // The key looked up is a copy, found by its bytes.
+    const std::string key = keys[i];
+    std::vector<RID> res;
+    ht.GetValue(nullptr, VarlenKey(key.data(), key.size()), &res);
+    ASSERT_EQ(i == 5 ? 2 : 1, res.size()) << key;
+    EXPECT_EQ(RID(0, i), res[0]);
+  }
+
+  // Scenario: a key that is a prefix of another is a key of its own.
+  std::vector<RID> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, VarlenKey(keys[100].data(), keys[100].size() - 1), &res));
+
+  // Scenario: removed keys are gone, and a key too large for a block page is turned down.
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, VarlenKey(keys[i].data(), keys[i].size()), RID(0, i)));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, VarlenKey(keys[i].data(), keys[i].size()), &res)) << i;
+  }
+  const std::string large_key(PAGE_SIZE, 'x');
+  EXPECT_FALSE(ht.Insert(nullptr, VarlenKey(large_key.data(), large_key.size()), RID(0, 0)));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_ConcurrentPerformanceTest) {
+  const int num_keys = 400000;
+  for (int num_threads : {1, 2, 4, 8}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManager(2000, disk_manager);
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2 * num_keys, HashFunction<int>());
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&ht, t, num_threads] {
+        std::vector<int> res;
+        for (int key = t; key < num_keys; key += num_threads) {
+          ht.Insert(nullptr, key, key);
+          res.clear();
+          ht.GetValue(nullptr, key, &res);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("threads=%d keys=%d %.1fms (%.0f ops/ms)", num_threads, num_keys, ms, 2 * num_keys / ms);
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
 }  // namespace bustub
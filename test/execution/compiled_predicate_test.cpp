@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate_test.cpp
+//
+// Identification: test/execution/compiled_predicate_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/logger.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/compiled_predicate.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+const std::vector<ComparisonType> comparison_types{ComparisonType::Equal,       ComparisonType::NotEqual,
+                                                   ComparisonType::LessThan,    ComparisonType::LessThanOrEqual,
+                                                   ComparisonType::GreaterThan, ComparisonType::GreaterThanOrEqual};
+
+/** @return the interpreted predicate, where a NULL comparison does not hold */
+bool Interpret(const AbstractExpression *predicate, const Tuple &tuple, const Schema *schema) {
+  Value result = predicate->Evaluate(&tuple, schema);
+  return !result.IsNull() && result.GetAs<bool>();
+}
+
+/** @return the indices of the tuples the interpreted predicate holds for */
+std::vector<uint32_t> InterpretAll(const AbstractExpression *predicate, const std::vector<Tuple> &tuples,
+                                   const Schema *schema) {
+  std::vector<uint32_t> selected;
+  for (uint32_t i = 0; i < tuples.size(); i++) {
+    if (Interpret(predicate, tuples[i], schema)) {
+      selected.push_back(i);
+    }
+  }
+  return selected;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(CompiledPredicateTest, MatchesInterpreterTest) {
+  Schema schema({Column("a", TypeId::TINYINT), Column("b", TypeId::SMALLINT), Column("c", TypeId::INTEGER),
+                 Column("d", TypeId::BIGINT), Column("e", TypeId::DECIMAL)});
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<int> dist(-4, 4);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 200; i++) {
+    std::vector<Value> values;
+    for (uint32_t col = 0; col < schema.GetColumnCount(); col++) {
+      int v = dist(rng);
+      TypeId type = schema.GetColumn(col).GetType();
+      // One in nine values is NULL.
+      values.push_back(v == 4 ? ValueFactory::GetNullValueByType(type)
+                              : type == TypeId::DECIMAL ? ValueFactory::GetDecimalValue(v / 2.0)
+                                                        : ValueFactory::GetIntegerValue(v).CastAs(type));
+    }
+    tuples.emplace_back(values, &schema);
+  }
+
+  std::vector<std::unique_ptr<AbstractExpression>> operands;
+  for (uint32_t col = 0; col < schema.GetColumnCount(); col++) {
+    operands.emplace_back(new ColumnValueExpression(0, col, schema.GetColumn(col).GetType()));
+  }
+  operands.emplace_back(new ConstantValueExpression(ValueFactory::GetIntegerValue(1)));
+  operands.emplace_back(new ConstantValueExpression(ValueFactory::GetBigIntValue(-2)));
+  operands.emplace_back(new ConstantValueExpression(ValueFactory::GetDecimalValue(0.5)));
+  operands.emplace_back(new ConstantValueExpression(ValueFactory::GetNullValueByType(TypeId::INTEGER)));
+  // The NULL of an INTEGER column, as a BIGINT, is a value an INTEGER column is compared with.
+  operands.emplace_back(new ConstantValueExpression(ValueFactory::GetBigIntValue(BUSTUB_INT32_NULL)));
+
+  // Scenario: every comparison of every pair of operands compiles, and agrees with the interpreter on every tuple,
+  // one at a time and all at once.
+  std::vector<uint32_t> selected;
+  for (const auto &left : operands) {
+    for (const auto &right : operands) {
+      for (ComparisonType comp_type : comparison_types) {
+        ComparisonExpression predicate(left.get(), right.get(), comp_type);
+        auto compiled = CompiledPredicate::Compile(&predicate, &schema);
+        ASSERT_NE(compiled, nullptr);
+        for (const auto &tuple : tuples) {
+          ASSERT_EQ(compiled->Evaluate(&tuple), Interpret(&predicate, tuple, &schema));
+        }
+        compiled->Select(tuples, &selected);
+        ASSERT_EQ(InterpretAll(&predicate, tuples, &schema), selected);
+      }
+    }
+  }
+
+  // Scenario: VARCHAR columns and anything but a comparison are left to the interpreter.
+  Schema varchar_schema({Column("s", TypeId::VARCHAR, 16)});
+  ColumnValueExpression s(0, 0, TypeId::VARCHAR);
+  ConstantValueExpression hello(ValueFactory::GetVarcharValue("hello"));
+  ComparisonExpression varchar_predicate(&s, &hello, ComparisonType::Equal);
+  EXPECT_EQ(CompiledPredicate::Compile(&varchar_predicate, &varchar_schema), nullptr);
+  EXPECT_EQ(CompiledPredicate::Compile(operands[0].get(), &schema), nullptr);
+}
+
+// NOLINTNEXTLINE
+TEST(CompiledPredicateTest, DISABLED_PerformanceTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT)});
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 1000; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetBigIntValue(-i)},
+                        &schema);
+  }
+  ColumnValueExpression a(0, 0, TypeId::INTEGER);
+  ConstantValueExpression five_hundred(ValueFactory::GetIntegerValue(500));
+  ComparisonExpression predicate(&a, &five_hundred, ComparisonType::LessThan);
+  auto compiled = CompiledPredicate::Compile(&predicate, &schema);
+  ASSERT_NE(compiled, nullptr);
+
+  const int rounds = 10000;
+  size_t interpreted_matches = 0;
+  size_t compiled_matches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (const auto &tuple : tuples) {
+      interpreted_matches += static_cast<size_t>(Interpret(&predicate, tuple, &schema));
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (const auto &tuple : tuples) {
+      compiled_matches += static_cast<size_t>(compiled->Evaluate(&tuple));
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  size_t selected_matches = 0;
+  std::vector<uint32_t> selected;
+  for (int round = 0; round < rounds; round++) {
+    compiled->Select(tuples, &selected);
+    selected_matches += selected.size();
+  }
+  auto selected_end = std::chrono::steady_clock::now();
+  EXPECT_EQ(interpreted_matches, compiled_matches);
+  EXPECT_EQ(interpreted_matches, selected_matches);
+  LOG_INFO("interpreted: %ld ms, compiled: %ld ms, selected: %ld ms",
+           std::chrono::duration_cast<std::chrono::milliseconds>(middle - start).count(),
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - middle).count(),
+           std::chrono::duration_cast<std::chrono::milliseconds>(selected_end - end).count());
+}
+
+}  // namespace bustub
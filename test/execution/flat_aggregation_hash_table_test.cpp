@@ -0,0 +1,197 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// flat_aggregation_hash_table_test.cpp
+//
+// Identification: test/execution/flat_aggregation_hash_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/logger.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/flat_aggregation_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+using Groups = std::map<std::vector<std::string>, std::vector<std::string>>;
+
+/** @return the groups of a table, as strings */
+template <typename Table>
+Groups GroupsOf(Table *table) {
+  Groups groups;
+  for (auto iter = table->Begin(); iter != table->End(); ++iter) {
+    std::vector<std::string> key;
+    for (const Value &value : iter.Key().group_bys_) {
+      key.push_back(value.ToString());
+    }
+    std::vector<std::string> &aggregates = groups[key];
+    EXPECT_TRUE(aggregates.empty());
+    for (const Value &value : iter.Val().aggregates_) {
+      aggregates.push_back(value.IsNull() ? "NULL" : value.ToString());
+    }
+  }
+  return groups;
+}
+
+/** SELECT a, b, count(c), sum(c), min(c), max(c) FROM t GROUP BY a, b */
+class FlatAggregationHashTableTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 rng(15445);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    for (int i = 0; i < 20000; i++) {
+      int c = dist(rng);
+      // One in a hundred inputs is NULL, which turns the sums, mins and maxes of its group NULL.
+      tuples_.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i % 1500),
+                                              ValueFactory::GetBigIntValue(i % 3),
+                                              c % 100 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                                           : ValueFactory::GetIntegerValue(c)},
+                           &schema_);
+    }
+  }
+
+  Schema schema_{{Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::INTEGER)}};
+  ColumnValueExpression a_{0, 0, TypeId::INTEGER};
+  ColumnValueExpression b_{0, 1, TypeId::BIGINT};
+  ColumnValueExpression c_{0, 2, TypeId::INTEGER};
+  AggregationPlanNode plan_{nullptr,
+                            nullptr,
+                            nullptr,
+                            {&a_, &b_},
+                            {&c_, &c_, &c_, &c_},
+                            {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                             AggregationType::MinAggregate, AggregationType::MaxAggregate}};
+  std::vector<Tuple> tuples_;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST_F(FlatAggregationHashTableTest, MatchesSimpleTableTest) {
+  ASSERT_TRUE(FlatAggregationHashTable::Supports(&plan_));
+  SimpleAggregationHashTable simple(plan_.GetAggregates(), plan_.GetAggregateTypes());
+  FlatAggregationHashTable flat(&plan_, &schema_);
+  for (const auto &tuple : tuples_) {
+    std::vector<Value> key{a_.Evaluate(&tuple, &schema_), b_.Evaluate(&tuple, &schema_)};
+    std::vector<Value> val(4, c_.Evaluate(&tuple, &schema_));
+    simple.InsertCombine({key}, {val});
+    flat.Insert(tuple);
+  }
+
+  // Scenario: the table grows far past its initial slots and arena chunk, and agrees with the simple table.
+  EXPECT_EQ(1500, flat.Size());
+  Groups expected = GroupsOf(&simple);
+  ASSERT_EQ(GroupsOf(&flat), expected);
+
+  // Scenario: merging the partitions of partial tables gives the same groups as a single table.
+  const size_t num_partitions = 4;
+  std::vector<FlatAggregationHashTable> partials;
+  for (int i = 0; i < 3; i++) {
+    partials.emplace_back(&plan_, &schema_, num_partitions);
+  }
+  for (size_t i = 0; i < tuples_.size(); i++) {
+    partials[i % partials.size()].Insert(tuples_[i]);
+  }
+  Groups merged;
+  for (size_t partition = 0; partition < num_partitions; partition++) {
+    FlatAggregationHashTable table(&plan_, &schema_);
+    for (const auto &partial : partials) {
+      table.MergePartition(partial, partition);
+    }
+    Groups groups = GroupsOf(&table);
+    EXPECT_LT(0, groups.size());
+    merged.insert(groups.begin(), groups.end());
+  }
+  ASSERT_EQ(merged, expected);
+
+  // Scenario: without group-bys, inserting batches gives the same single group as inserting the tuples one at a time,
+  // of which batches with and without NULL inputs.
+  AggregationPlanNode total_plan{nullptr,
+                                 nullptr,
+                                 nullptr,
+                                 {},
+                                 {&c_, &c_, &c_, &c_},
+                                 {AggregationType::CountAggregate, AggregationType::SumAggregate,
+                                  AggregationType::MinAggregate, AggregationType::MaxAggregate}};
+  FlatAggregationHashTable one_at_a_time(&total_plan, &schema_);
+  FlatAggregationHashTable batched(&total_plan, &schema_);
+  for (size_t begin = 0; begin < tuples_.size(); begin += 1000) {
+    std::vector<Tuple> batch(tuples_.begin() + begin, tuples_.begin() + std::min(begin + 1000, tuples_.size()));
+    for (const auto &tuple : batch) {
+      one_at_a_time.Insert(tuple);
+    }
+    batched.InsertBatch(batch);
+    ASSERT_EQ(GroupsOf(&batched), GroupsOf(&one_at_a_time));
+  }
+  FlatAggregationHashTable non_null(&total_plan, &schema_);
+  std::vector<Tuple> non_null_batch;
+  for (const auto &tuple : tuples_) {
+    if (!c_.Evaluate(&tuple, &schema_).IsNull()) {
+      non_null_batch.push_back(tuple);
+      non_null.Insert(tuple);
+    }
+  }
+  batched.Clear();
+  batched.InsertBatch(non_null_batch);
+  ASSERT_EQ(GroupsOf(&batched), GroupsOf(&non_null));
+  EXPECT_EQ(GroupsOf(&batched).begin()->second[0], std::to_string(non_null_batch.size()));
+
+  // Scenario: a cleared table starts over.
+  flat.Clear();
+  EXPECT_EQ(0, flat.Size());
+  EXPECT_EQ(flat.Begin(), flat.End());
+
+  // Scenario: variable-length keys and non-integer aggregates are left to the simple table.
+  ColumnValueExpression s(0, 0, TypeId::VARCHAR);
+  AggregationPlanNode varchar_plan{nullptr, nullptr, nullptr, {&s}, {&c_}, {AggregationType::CountAggregate}};
+  EXPECT_FALSE(FlatAggregationHashTable::Supports(&varchar_plan));
+  AggregationPlanNode bigint_plan{nullptr, nullptr, nullptr, {&a_}, {&b_}, {AggregationType::SumAggregate}};
+  EXPECT_FALSE(FlatAggregationHashTable::Supports(&bigint_plan));
+}
+
+// NOLINTNEXTLINE
+TEST_F(FlatAggregationHashTableTest, DISABLED_PerformanceTest) {
+  const int rounds = 50;
+  auto start = std::chrono::steady_clock::now();
+  size_t simple_groups = 0;
+  for (int round = 0; round < rounds; round++) {
+    SimpleAggregationHashTable simple(plan_.GetAggregates(), plan_.GetAggregateTypes());
+    for (const auto &tuple : tuples_) {
+      std::vector<Value> key{a_.Evaluate(&tuple, &schema_), b_.Evaluate(&tuple, &schema_)};
+      std::vector<Value> val(4, c_.Evaluate(&tuple, &schema_));
+      simple.InsertCombine({key}, {val});
+    }
+    simple_groups = GroupsOf(&simple).size();
+  }
+  auto middle = std::chrono::steady_clock::now();
+  size_t flat_groups = 0;
+  for (int round = 0; round < rounds; round++) {
+    FlatAggregationHashTable flat(&plan_, &schema_);
+    for (const auto &tuple : tuples_) {
+      flat.Insert(tuple);
+    }
+    flat_groups = flat.Size();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(simple_groups, flat_groups);
+  LOG_INFO("simple: %ld ms, flat: %ld ms",
+           std::chrono::duration_cast<std::chrono::milliseconds>(middle - start).count(),
+           std::chrono::duration_cast<std::chrono::milliseconds>(end - middle).count());
+}
+
+}  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table_test.cpp
+//
+// Identification: test/execution/join_hash_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <vector>
+
+#include "execution/join_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the values of the tuples of the entries of a hash, in increasing order */
+std::vector<int32_t> Lookup(const JoinHashTable &table, hash_t hash, const Schema *schema) {
+  std::vector<int32_t> values;
+  for (uint32_t entry = table.Find(hash); entry != JoinHashTable::END; entry = table.FindNext(entry)) {
+    values.push_back(table.GetTuple(entry).GetValue(schema, 0).GetAs<int32_t>());
+  }
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, SampleTest) {
+  Schema schema({Column("a", TypeId::INTEGER)});
+  JoinHashTable table;
+
+  // Scenario: an empty table finds nothing, built or not.
+  EXPECT_EQ(JoinHashTable::END, table.Find(0));
+  table.Build();
+  EXPECT_EQ(JoinHashTable::END, table.Find(0));
+
+  // Scenario: the entries of duplicate hashes chain together. Hashes that share their low bits, as those of a spilled
+  // partition do, still spread over the buckets, and a hash that only differs in its low bits finds nothing.
+  const int num_hashes = 1000;
+  std::vector<hash_t> hashes;
+  size_t num_entries = 0;
+  for (int i = 0; i < num_hashes; i++) {
+    hashes.push_back(HashUtil::HashWords(i, 0) << 6 | 5);
+    for (int copy = 0; copy < i % 3 + 1; copy++) {
+      num_entries++;
+      table.Insert(hashes.back(), Tuple({ValueFactory::GetIntegerValue(i * 10 + copy)}, &schema));
+    }
+  }
+  table.Build();
+  table.Prefetch(hashes.data(), hashes.size());
+  for (int i = 0; i < num_hashes; i++) {
+    std::vector<int32_t> expected;
+    for (int copy = 0; copy < i % 3 + 1; copy++) {
+      expected.push_back(i * 10 + copy);
+    }
+    ASSERT_EQ(expected, Lookup(table, hashes[i], &schema)) << i;
+    EXPECT_TRUE(Lookup(table, hashes[i] ^ 1, &schema).empty());
+  }
+  EXPECT_EQ(num_entries, table.GetEntries().size());
+
+  // Scenario: a cleared table starts over.
+  table.Clear();
+  table.Build();
+  EXPECT_TRUE(table.GetEntries().empty());
+  EXPECT_EQ(JoinHashTable::END, table.Find(hashes[0]));
+}
+
+}  // namespace bustub
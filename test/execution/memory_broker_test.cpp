@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_broker_test.cpp
+//
+// Identification: test/execution/memory_broker_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "execution/memory_broker.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** Waits until a number of queries wait to be admitted by a broker. */
+void WaitForWaiting(MemoryBroker *broker, size_t num_waiting) {
+  while (broker->GetNumWaiting() != num_waiting) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(MemoryBrokerTest, GrantTest) {
+  MemoryBroker broker(1000);
+
+  // A request is granted in full while it fits, and capped by the capacity.
+  EXPECT_EQ(broker.Admit(400, 100), 400);
+  EXPECT_EQ(broker.Admit(5000, 100), 600);
+  EXPECT_EQ(broker.GetReserved(), 1000);
+  broker.Release(1000);
+
+  // A request that does not fit is granted what is free, if that is at least its minimum.
+  EXPECT_EQ(broker.Admit(700, 100), 700);
+  EXPECT_EQ(broker.Admit(700, 200), 300);
+  EXPECT_EQ(broker.GetReserved(), 1000);
+  broker.Release(300);
+  broker.Release(700);
+  EXPECT_EQ(broker.GetReserved(), 0);
+  EXPECT_EQ(broker.GetNumWaiting(), 0);
+}
+
+// NOLINTNEXTLINE
+TEST(MemoryBrokerTest, QueueTest) {
+  MemoryBroker broker(1000);
+  ASSERT_EQ(broker.Admit(900, 900), 900);
+
+  // A query that needs more than is free waits; a smaller query behind it waits too, though it would fit.
+  std::vector<int> order;
+  std::mutex order_latch;
+  auto admit = [&](int query, size_t request) {
+    size_t granted = broker.Admit(request, request);
+    std::lock_guard<std::mutex> guard(order_latch);
+    order.push_back(query);
+    EXPECT_EQ(granted, request);
+  };
+  std::thread large(admit, 0, 500);
+  WaitForWaiting(&broker, 1);
+  std::thread small(admit, 1, 50);
+  WaitForWaiting(&broker, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  {
+    std::lock_guard<std::mutex> guard(order_latch);
+    EXPECT_TRUE(order.empty());
+  }
+
+  // Releasing the memory admits both, in the order they arrived.
+  broker.Release(900);
+  large.join();
+  small.join();
+  EXPECT_EQ(order, (std::vector<int>{0, 1}));
+  EXPECT_EQ(broker.GetReserved(), 550);
+  EXPECT_EQ(broker.GetNumWaiting(), 0);
+  broker.Release(550);
+}
+
+// NOLINTNEXTLINE
+TEST(MemoryBrokerTest, ConcurrentTest) {
+  // Many queries at once never hold more than the capacity, and all of them are admitted eventually.
+  const size_t capacity = 1000;
+  MemoryBroker broker(capacity);
+  std::atomic<size_t> held{0};
+  std::atomic<bool> exceeded{false};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 8; i++) {
+    threads.emplace_back([&, i] {
+      for (size_t j = 0; j < 200; j++) {
+        size_t request = 100 + (i * 37 + j * 11) % 500;
+        size_t granted = broker.Admit(request, request / MEMORY_GRANT_MIN_FRACTION);
+        if (granted < request / MEMORY_GRANT_MIN_FRACTION || granted > request) {
+          exceeded = true;
+        }
+        if (held.fetch_add(granted) + granted > capacity) {
+          exceeded = true;
+        }
+        std::this_thread::yield();
+        held.fetch_sub(granted);
+        broker.Release(granted);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(exceeded);
+  EXPECT_EQ(broker.GetReserved(), 0);
+}
+
+// NOLINTNEXTLINE
+TEST(MemoryBrokerTest, CountSpillingOperatorsTest) {
+  Schema schema(std::vector<Column>{});
+  SeqScanPlanNode left{&schema, nullptr, 0};
+  SeqScanPlanNode right{&schema, nullptr, 1};
+  EXPECT_EQ(MemoryBroker::CountSpillingOperators(&left), 0);
+
+  HashJoinPlanNode join{&schema, {&left, &right}, {}, {}};
+  AggregationPlanNode agg{&schema, &join, nullptr, {}, {}, {}};
+  SortPlanNode sort{&schema, &agg, {}};
+  EXPECT_EQ(MemoryBroker::CountSpillingOperators(&join), 1);
+  EXPECT_EQ(MemoryBroker::CountSpillingOperators(&sort), 3);
+}
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key_test.cpp
+//
+// Identification: test/execution/sort_key_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/sort_key.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+int Sign(int result) { return (result > 0) - (result < 0); }
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(SortKeyTest, NormalizedKeyOrderTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::DECIMAL), Column("c", TypeId::VARCHAR, 16),
+                 Column("d", TypeId::BIGINT)});
+  ColumnValueExpression a(0, 0, TypeId::INTEGER);
+  ColumnValueExpression b(0, 1, TypeId::DECIMAL);
+  ColumnValueExpression c(0, 2, TypeId::VARCHAR);
+  ColumnValueExpression d(0, 3, TypeId::BIGINT);
+
+  // Few distinct values of each column, NULLs among the fixed-width ones, so that the later keys decide the order
+  // often. Strings share long prefixes so that the normalized key cannot tell them apart.
+  std::mt19937 rng(15445);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 300; i++) {
+    int32_t int_value = static_cast<int32_t>(rng() % 5) - 2;
+    double decimal_value = (static_cast<int>(rng() % 5) - 2) * 0.75;
+    std::string string_value = "prefix__" + std::string(rng() % 3, 'z');
+    std::vector<Value> values{
+        rng() % 7 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(int_value),
+        rng() % 7 == 0 ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                       : ValueFactory::GetDecimalValue(decimal_value),
+        ValueFactory::GetVarcharValue(string_value),
+        ValueFactory::GetBigIntValue(static_cast<int64_t>(rng() % 3) - 1)};
+    tuples.emplace_back(values, &schema);
+  }
+
+  // Scenario: the memcmp order of the normalized keys agrees with comparing the values, for a key that is exact and
+  // for one that ends in a VARCHAR prefix, ascending and descending.
+  std::vector<std::vector<OrderBy>> keys{
+      {{&a, OrderByType::ASC}, {&b, OrderByType::DESC}, {&d, OrderByType::ASC}},
+      {{&b, OrderByType::ASC}, {&c, OrderByType::DESC}, {&a, OrderByType::ASC}},
+      {{&c, OrderByType::ASC}, {&d, OrderByType::DESC}},
+  };
+  for (size_t k = 0; k < keys.size(); k++) {
+    SortKey sort_key(keys[k], &schema);
+    EXPECT_EQ(sort_key.IsExact(), k == 0);
+    std::vector<std::vector<char>> encoded;
+    for (const Tuple &tuple : tuples) {
+      encoded.emplace_back(sort_key.GetSize());
+      sort_key.Encode(tuple, encoded.back().data());
+    }
+    for (size_t i = 0; i < tuples.size(); i++) {
+      for (size_t j = 0; j < tuples.size(); j++) {
+        int expected = Sign(sort_key.Compare(tuples[i], tuples[j]));
+        ASSERT_EQ(Sign(sort_key.Compare(encoded[i].data(), tuples[i], encoded[j].data(), tuples[j])), expected)
+            << k << " " << i << " " << j;
+      }
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// matrix_benchmark_test.cpp
+//
+// Identification: test/primer/matrix_benchmark_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+#include "gtest/gtest.h"
+#include "primer/p0_starter.h"
+
+namespace bustub {
+
+// The benchmarks of the matrix operations, in GFLOP/s, across sizes and thread counts. They are disabled, and run
+// with: ./matrix_benchmark_test --gtest_also_run_disabled_tests
+
+/** The floating point operations each size is timed over at least, so that small sizes are repeated. */
+static constexpr double BENCHMARK_MIN_FLOPS = 1 << 30;
+
+/**
+ * Times an operation on n x n matrices, created and filled outside of the time measured, and logs its GFLOP/s.
+ * @param operation takes the matrices, of which it uses as many as it needs
+ * @param flops the floating point operations of one run of the operation
+ */
+template <typename Operation>
+void RunBenchmark(const char *name, int n, size_t num_threads, double flops, Operation operation) {
+  std::vector<float> elements(n * n);
+  for (size_t i = 0; i < elements.size(); i++) {
+    elements[i] = static_cast<float>(i % 17) / 16;
+  }
+  const int num_runs = std::max(1, static_cast<int>(BENCHMARK_MIN_FLOPS / flops));
+  std::chrono::duration<double> elapsed{0};
+  for (int run = 0; run < num_runs; run++) {
+    std::unique_ptr<RowMatrix<float>> mats[3];
+    for (auto &mat : mats) {
+      mat = std::make_unique<RowMatrix<float>>(n, n);
+      mat->MatImport(elements.data());
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto result = operation(std::move(mats[0]), std::move(mats[1]), std::move(mats[2]));
+    elapsed += std::chrono::steady_clock::now() - start;
+    ASSERT_NE(nullptr, result);
+  }
+  LOG_INFO("%s n=%d threads=%zu runs=%d %.3fms/run (%.2f GFLOP/s)", name, n, num_threads, num_runs,
+           elapsed.count() * 1e3 / num_runs, flops * num_runs / elapsed.count() / 1e9);
+}
+
+// NOLINTNEXTLINE
+TEST(MatrixBenchmarkTest, DISABLED_AddMatricesTest) {
+  using Operations = RowMatrixOperations<float>;
+  for (int n : {64, 256, 1024, 2048}) {
+    RunBenchmark("AddMatrices", n, 1, static_cast<double>(n) * n, [](auto mat1, auto mat2, auto /*mat3*/) {
+      return Operations::AddMatrices(std::move(mat1), std::move(mat2));
+    });
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(MatrixBenchmarkTest, DISABLED_MultiplyMatricesTest) {
+  using Operations = RowMatrixOperations<float>;
+  for (size_t num_threads = 1; num_threads <= std::max(1U, std::thread::hardware_concurrency()); num_threads *= 2) {
+    ThreadPool thread_pool(num_threads);
+    for (int n : {64, 256, 512, 1024}) {
+      RunBenchmark("MultiplyMatrices", n, num_threads, 2.0 * n * n * n, [&](auto mat1, auto mat2, auto /*mat3*/) {
+        return Operations::MultiplyMatrices(std::move(mat1), std::move(mat2), &thread_pool);
+      });
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(MatrixBenchmarkTest, DISABLED_GemmMatricesTest) {
+  using Operations = RowMatrixOperations<float>;
+  for (size_t num_threads = 1; num_threads <= std::max(1U, std::thread::hardware_concurrency()); num_threads *= 2) {
+    ThreadPool thread_pool(num_threads);
+    for (int n : {64, 256, 512, 1024}) {
+      RunBenchmark("GemmMatrices", n, num_threads, 2.0 * n * n * n + n * n, [&](auto mat1, auto mat2, auto mat3) {
+        return Operations::GemmMatrices(std::move(mat1), std::move(mat2), std::move(mat3), &thread_pool);
+      });
+    }
+  }
+}
+
+}  // namespace bustub
@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "primer/p0_starter.h"
@@ -80,4 +82,110 @@ TEST(StarterTest, MultiplyMatricesTest) {
     }
   }
 }
+
+TEST(StarterTest, GemmMatricesTest) {
+  int arr1[6] = {1, 2, 3, 4, 5, 6};
+  std::unique_ptr<RowMatrix<int>> mat1_ptr{new RowMatrix<int>(2, 3)};
+  mat1_ptr->MatImport(&arr1[0]);
+  int arr2[6] = {-2, 1, -2, 2, 2, 3};
+  std::unique_ptr<RowMatrix<int>> mat2_ptr{new RowMatrix<int>(3, 2)};
+  mat2_ptr->MatImport(&arr2[0]);
+  int arr3[4] = {1, -1, 2, 0};
+  std::unique_ptr<RowMatrix<int>> mat3_ptr{new RowMatrix<int>(2, 2)};
+  mat3_ptr->MatImport(&arr3[0]);
+
+  int arr4[4] = {1, 13, -4, 32};
+  std::unique_ptr<RowMatrix<int>> gemm_ptr =
+      RowMatrixOperations<int>::GemmMatrices(std::move(mat1_ptr), std::move(mat2_ptr), std::move(mat3_ptr));
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      EXPECT_EQ(arr4[i * 2 + j], gemm_ptr->GetElem(i, j));
+    }
+  }
+
+  // Scenario: the sum of mismatched matrices is nullptr.
+  EXPECT_EQ(nullptr, RowMatrixOperations<int>::GemmMatrices(std::make_unique<RowMatrix<int>>(2, 3),
+                                                            std::make_unique<RowMatrix<int>>(3, 2),
+                                                            std::make_unique<RowMatrix<int>>(3, 2)));
+}
+
+template <typename T>
+void CheckBlockedMultiply(int m, int n, int k) {
+  auto mat1_ptr = std::make_unique<RowMatrix<T>>(m, k);
+  auto mat2_ptr = std::make_unique<RowMatrix<T>>(k, n);
+  for (int i = 0; i < m; i++) {
+    for (int p = 0; p < k; p++) {
+      mat1_ptr->SetElem(i, p, static_cast<T>((i * 7 + p * 3) % 11 - 5));
+    }
+  }
+  for (int p = 0; p < k; p++) {
+    for (int j = 0; j < n; j++) {
+      mat2_ptr->SetElem(p, j, static_cast<T>((p * 5 + j) % 13 - 6));
+    }
+  }
+  std::vector<T> expected(m * n);
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      for (int p = 0; p < k; p++) {
+        expected[i * n + j] += mat1_ptr->GetElem(i, p) * mat2_ptr->GetElem(p, j);
+      }
+    }
+  }
+
+  auto product_ptr = RowMatrixOperations<T>::MultiplyMatrices(std::move(mat1_ptr), std::move(mat2_ptr));
+  ASSERT_EQ(m, product_ptr->GetRows());
+  ASSERT_EQ(n, product_ptr->GetColumns());
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      // The products of small integers are exact in float too.
+      ASSERT_EQ(expected[i * n + j], product_ptr->GetElem(i, j));
+    }
+  }
+}
+
+TEST(StarterTest, BlockedMultiplyTest) {
+  // Scenario: sizes across the blocks and the micro-kernel tiles, with edges that fill neither.
+  CheckBlockedMultiply<int>(70, 530, 300);
+  CheckBlockedMultiply<int>(1, 33, 1);
+  CheckBlockedMultiply<int>(4, 32, 257);
+  CheckBlockedMultiply<float>(67, 45, 260);
+  CheckBlockedMultiply<double>(9, 17, 5);
+}
+
+TEST(StarterTest, ParallelGemmTest) {
+  // Scenario: the blocks of a large product split across threads add up to the product computed on one thread.
+  const int m = 200;
+  const int n = 600;
+  const int k = 100;
+  std::vector<int> arr1(m * k);
+  std::vector<int> arr2(k * n);
+  std::vector<int> arr3(m * n);
+  for (size_t i = 0; i < arr1.size(); i++) {
+    arr1[i] = static_cast<int>(i % 7) - 3;
+  }
+  for (size_t i = 0; i < arr2.size(); i++) {
+    arr2[i] = static_cast<int>(i % 5) - 2;
+  }
+  for (size_t i = 0; i < arr3.size(); i++) {
+    arr3[i] = static_cast<int>(i % 3);
+  }
+  auto gemm = [&](ThreadPool *thread_pool) {
+    auto mat1_ptr = std::make_unique<RowMatrix<int>>(m, k);
+    auto mat2_ptr = std::make_unique<RowMatrix<int>>(k, n);
+    auto mat3_ptr = std::make_unique<RowMatrix<int>>(m, n);
+    mat1_ptr->MatImport(arr1.data());
+    mat2_ptr->MatImport(arr2.data());
+    mat3_ptr->MatImport(arr3.data());
+    return RowMatrixOperations<int>::GemmMatrices(std::move(mat1_ptr), std::move(mat2_ptr), std::move(mat3_ptr),
+                                                  thread_pool);
+  };
+  ThreadPool thread_pool(4);
+  auto serial_ptr = gemm(nullptr);
+  auto parallel_ptr = gemm(&thread_pool);
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      ASSERT_EQ(serial_ptr->GetElem(i, j), parallel_ptr->GetElem(i, j));
+    }
+  }
+}
 }  // namespace bustub
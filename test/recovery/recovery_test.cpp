@@ -10,7 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <fstream>
+#include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "common/bustub_instance.h"
@@ -19,10 +27,15 @@
 #include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "recovery/backup_manager.h"
+#include "recovery/log_compression.h"
 #include "recovery/log_recovery.h"
+#include "recovery/log_replica.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
+#include "storage/table/toast.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -43,7 +56,7 @@ class RecoveryTest : public ::testing::Test {
 };
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_RedoTest) {
+TEST_F(RecoveryTest, RedoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -132,7 +145,540 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_UndoTest) {
+TEST_F(RecoveryTest, ParallelRedoTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 32};
+  Schema schema{std::vector<Column>{col1, col2}};
+  auto make_tuple = [&](int32_t a, int i) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(std::string(24, 'a' + i % 26))},
+                 &schema);
+  };
+
+  // Scenario: inserts, updates and deletes on more pages than the buffer pool holds, committed, then a crash.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 600;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i, i), &rids[i], txn));
+  }
+  for (int i = 0; i < num_tuples; i += 3) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple(i * 10, i), rids[i], txn));
+  }
+  for (int i = 0; i < num_tuples; i += 5) {
+    ASSERT_TRUE(test_table->MarkDelete(rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("test.db");
+  auto check_tuples = [&] {
+    txn = bustub_instance->transaction_manager_->Begin();
+    test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                               bustub_instance->log_manager_, first_page_id);
+    for (int i = 0; i < num_tuples; i++) {
+      Tuple tuple;
+      ASSERT_EQ(test_table->GetTuple(rids[i], &tuple, txn), i % 5 != 0);
+      if (i % 5 != 0) {
+        EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i % 3 == 0 ? i * 10 : i);
+      }
+    }
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    delete test_table;
+  };
+  auto *log_recovery =
+      new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_, nullptr, 4);
+  log_recovery->Redo();
+  EXPECT_TRUE(log_recovery->GetActiveTransactions().empty());
+  delete log_recovery;
+  check_tuples();
+
+  // Scenario: redone again, every record is older than its page and skipped.
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_, nullptr, 3);
+  log_recovery->Redo();
+  delete log_recovery;
+  check_tuples();
+
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, BatchedDeleteTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 300};
+  Schema schema{std::vector<Column>{col1, col2}};
+  auto make_tuple = [&](int32_t a) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(std::string(200, 'a'))}, &schema);
+  };
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 40;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i), &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  std::vector<page_id_t> page_ids;
+  for (const RID &rid : rids) {
+    if (std::find(page_ids.begin(), page_ids.end(), rid.GetPageId()) == page_ids.end()) {
+      page_ids.push_back(rid.GetPageId());
+    }
+  }
+  ASSERT_GT(page_ids.size(), 1);
+
+  // Scenario: the deletes of a commit, in any order, are applied and logged once per page, after the commit record.
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = num_tuples - 1; i >= 0; i -= 2) {
+    ASSERT_TRUE(test_table->MarkDelete(rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  EXPECT_EQ(txn->GetPrevLSN(), txn->GetCommitLSN() + static_cast<lsn_t>(page_ids.size()));
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  // Scenario: after a crash, the redo deletes the tuples again.
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_EQ(test_table->GetTuple(rids[i], &tuple, txn), i % 2 == 0);
+    if (i % 2 == 0) {
+      EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    }
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ToastRedoTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 3 * PAGE_SIZE}}};
+  std::string payload(2 * PAGE_SIZE, ' ');
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = static_cast<char>('a' + i % 26);
+  }
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(
+      Tuple({ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(payload)}, &schema), &rid, txn, &schema));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  // Scenario: after a crash, the redo writes the overflow pages back along with the tuple pointing to them.
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple stored;
+  ASSERT_TRUE(test_table->GetTuple(rid, &stored, txn));
+  ASSERT_TRUE(stored.IsToasted(&schema, 1));
+  Tuple detoasted = Toast::Detoast(bustub_instance->buffer_pool_manager_, stored, &schema);
+  EXPECT_EQ(detoasted.GetValue(&schema, 0).GetAs<int32_t>(), 1);
+  EXPECT_EQ(detoasted.GetValue(&schema, 1).ToString(), payload);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, CheckpointRecoveryTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 32};
+  Schema schema{std::vector<Column>{col1, col2}};
+  auto make_tuple = [&](int32_t a) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(std::string(24, 'a' + a % 26))},
+                 &schema);
+  };
+
+  // Scenario: a committed table, a loser updating, deleting and inserting across a fuzzy checkpoint, and a winner
+  // committed after it, then a crash.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 100;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i), &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  Transaction *loser = bustub_instance->transaction_manager_->Begin();
+  const txn_id_t loser_id = loser->GetTransactionId();
+  RID loser_rid;
+  ASSERT_TRUE(test_table->UpdateTuple(make_tuple(1000), rids[0], loser));
+  ASSERT_TRUE(test_table->MarkDelete(rids[1], loser));
+  ASSERT_TRUE(test_table->InsertTuple(make_tuple(1001), &loser_rid, loser));
+  bustub_instance->checkpoint_manager_->FuzzyCheckpoint();
+
+  Transaction *winner = bustub_instance->transaction_manager_->Begin();
+  RID winner_rid;
+  ASSERT_TRUE(test_table->InsertTuple(make_tuple(2000), &winner_rid, winner));
+  ASSERT_TRUE(test_table->UpdateTuple(make_tuple(2001), rids[10], winner));
+  bustub_instance->transaction_manager_->Commit(winner);
+  delete winner;
+
+  ASSERT_TRUE(test_table->UpdateTuple(make_tuple(1002), rids[2], loser));
+  ASSERT_TRUE(test_table->MarkDelete(rids[3], loser));
+  bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete loser;
+  delete test_table;
+  delete bustub_instance;
+
+  auto check_tuples = [&] {
+    txn = bustub_instance->transaction_manager_->Begin();
+    test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                               bustub_instance->log_manager_, first_page_id);
+    Tuple tuple;
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+      EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i == 10 ? 2001 : i);
+    }
+    EXPECT_FALSE(test_table->GetTuple(loser_rid, &tuple, txn) && tuple.GetValue(&schema, 0).GetAs<int32_t>() == 1001);
+    ASSERT_TRUE(test_table->GetTuple(winner_rid, &tuple, txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 2000);
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    delete test_table;
+  };
+
+  // Scenario: the analysis from the checkpoint finds the loser only, redo and undo leave the committed tuples.
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_, 4);
+  log_recovery->Analysis();
+  ASSERT_EQ(log_recovery->GetActiveTransactions().size(), 1);
+  EXPECT_EQ(log_recovery->GetActiveTransactions().count(loser_id), 1);
+  EXPECT_FALSE(log_recovery->GetDirtyPageTable().empty());
+  log_recovery->Redo();
+  log_recovery->Undo();
+  EXPECT_TRUE(log_recovery->GetActiveTransactions().empty());
+  delete log_recovery;
+  check_tuples();
+
+  // Scenario: a crash right after the undo, whose CLRs are redone and end the loser.
+  delete bustub_instance;
+  bustub_instance = new BustubInstance("test.db");
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                 bustub_instance->log_manager_, 4);
+  log_recovery->Analysis();
+  EXPECT_TRUE(log_recovery->GetActiveTransactions().empty());
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  check_tuples();
+
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, InstantRestartTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Column col1{"a", TypeId::INTEGER};
+  Schema schema{std::vector<Column>{col1}};
+  auto make_tuple = [&](int32_t a) { return Tuple({ValueFactory::GetIntegerValue(a)}, &schema); };
+
+  // Scenario: two committed tables, a loser updating, deleting and inserting in the first one, then a crash.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  auto *other_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                    bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const page_id_t other_page_id = other_table->GetFirstPageId();
+  const int num_tuples = 10;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i), &rids[i], txn));
+  }
+  RID other_rid;
+  ASSERT_TRUE(other_table->InsertTuple(make_tuple(100), &other_rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  Transaction *loser = bustub_instance->transaction_manager_->Begin();
+  const txn_id_t loser_id = loser->GetTransactionId();
+  RID loser_rid;
+  ASSERT_TRUE(test_table->UpdateTuple(make_tuple(1000), rids[0], loser));
+  ASSERT_TRUE(test_table->MarkDelete(rids[1], loser));
+  ASSERT_TRUE(test_table->InsertTuple(make_tuple(1001), &loser_rid, loser));
+  bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete loser;
+  delete test_table;
+  delete other_table;
+  delete bustub_instance;
+
+  // Scenario: after redo, the loser runs again behind its locks while its undo is held back on the latch of its page.
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_, 2);
+  log_recovery->Redo();
+  bustub_instance->log_manager_->RunFlushThread();
+  Page *page = bustub_instance->buffer_pool_manager_->FetchPage(first_page_id);
+  ASSERT_NE(page, nullptr);
+  page->WLatch();
+  log_recovery->UndoInBackground(bustub_instance->transaction_manager_, bustub_instance->lock_manager_);
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  other_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                              bustub_instance->log_manager_, other_page_id);
+
+  // The other table is served at once, and the new transactions do not reuse the id of the loser.
+  txn = bustub_instance->transaction_manager_->Begin();
+  EXPECT_GT(txn->GetTransactionId(), loser_id);
+  Tuple tuple;
+  ASSERT_TRUE(other_table->GetTuple(other_rid, &tuple, txn));
+  EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 100);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // A reader of a tuple of the loser waits for its rollback.
+  std::atomic<bool> read{false};
+  Tuple read_tuple;
+  std::thread reader([&] {
+    Transaction *reader_txn = bustub_instance->transaction_manager_->Begin();
+    EXPECT_TRUE(test_table->GetTuple(rids[0], &read_tuple, reader_txn));
+    read = true;
+    bustub_instance->transaction_manager_->Commit(reader_txn);
+    delete reader_txn;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(read);
+  page->WUnlatch();
+  bustub_instance->buffer_pool_manager_->UnpinPage(first_page_id, false);
+  reader.join();
+  EXPECT_EQ(read_tuple.GetValue(&schema, 0).GetAs<int32_t>(), 0);
+
+  log_recovery->WaitForUndo();
+  EXPECT_TRUE(log_recovery->GetActiveTransactions().empty());
+  EXPECT_EQ(TransactionManager::GetNumRunningTransactions(), 0);
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+  }
+  EXPECT_FALSE(test_table->GetTuple(loser_rid, &tuple, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete log_recovery;
+  delete test_table;
+  delete other_table;
+  delete bustub_instance;
+
+  // Scenario: the loser ended with an ABORT record.
+  bustub_instance = new BustubInstance("test.db");
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Analysis();
+  EXPECT_TRUE(log_recovery->GetActiveTransactions().empty());
+  delete log_recovery;
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ReplicaTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  auto *replica_disk_manager = new DiskManager("replica.db");
+  auto *replica_bpm = new BufferPoolManager(50, replica_disk_manager);
+  auto *replica = new LogReplica(replica_disk_manager, replica_bpm, 2);
+  LogManager *log_manager = bustub_instance->log_manager_;
+  const size_t subscriber_id =
+      log_manager->Subscribe([&](const char *data, size_t size) { replica->Receive(data, size); });
+  log_manager->RunFlushThread();
+  Column col1{"a", TypeId::INTEGER};
+  Schema schema{std::vector<Column>{col1}};
+  auto make_tuple = [&](int32_t a) { return Tuple({ValueFactory::GetIntegerValue(a)}, &schema); };
+
+  // Scenario: the tables committed on the primary show on the replica once their records are applied.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   log_manager, txn);
+  const int num_tuples = 500;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i), &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  replica->WaitUntilApplied(log_manager->GetPersistentLSN());
+
+  Transaction replica_txn(0);
+  auto *replica_table = new TableHeap(replica_bpm, nullptr, nullptr, test_table->GetFirstPageId());
+  auto check_tuples = [&](int32_t offset) {
+    Tuple tuple;
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(replica_table->GetTuple(rids[i], &tuple, &replica_txn));
+      EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i + offset);
+    }
+  };
+  lsn_t read_lsn = replica->BeginRead();
+  EXPECT_EQ(read_lsn, log_manager->GetPersistentLSN());
+  check_tuples(0);
+
+  // Scenario: the updates committed during a read are applied after it, which sees none of them.
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple(i + 1000), rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(replica->GetAppliedLSN(), read_lsn);
+  check_tuples(0);
+  replica->EndRead();
+  replica->WaitUntilApplied(log_manager->GetPersistentLSN());
+  read_lsn = replica->BeginRead();
+  EXPECT_EQ(read_lsn, log_manager->GetPersistentLSN());
+  check_tuples(1000);
+  replica->EndRead();
+
+  log_manager->Unsubscribe(subscriber_id);
+  delete replica_table;
+  delete test_table;
+  delete bustub_instance;
+  delete replica;
+  delete replica_bpm;
+  delete replica_disk_manager;
+  for (const char *file_name : {"replica.db", "replica.log", "replica.fsm", "replica.mst"}) {
+    remove(file_name);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, BackupTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  auto *backup_manager =
+      new BackupManager(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                        bustub_instance->log_manager_, bustub_instance->checkpoint_manager_);
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 256};
+  Schema schema{std::vector<Column>{col1, col2}};
+  auto make_tuple = [&](int32_t a) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(std::string(200, 'a' + a % 26))},
+                 &schema);
+  };
+
+  // Scenario: a full backup of a committed table copies every page.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 1000;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple(i), &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  const lsn_t full_lsn = backup_manager->Backup("backup.full");
+  const size_t full_pages = backup_manager->GetNumPagesCopied();
+  EXPECT_EQ(full_pages, bustub_instance->disk_manager_->GetNumPages());
+
+  // Scenario: a throttled incremental backup, taken while a loser is running, copies the pages changed since only.
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple(i + 1000), rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  Transaction *loser = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->UpdateTuple(make_tuple(2000), rids[num_tuples - 1], loser));
+  const auto start = std::chrono::steady_clock::now();
+  const lsn_t incremental_lsn = backup_manager->Backup("backup.incr", full_lsn, 100);
+  const size_t incremental_pages = backup_manager->GetNumPagesCopied();
+  EXPECT_GT(incremental_lsn, full_lsn);
+  EXPECT_GT(incremental_pages, 0);
+  EXPECT_LT(incremental_pages, full_pages);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10 * (incremental_pages - 1)));
+  bustub_instance->transaction_manager_->Abort(loser);
+  delete loser;
+  delete test_table;
+  delete backup_manager;
+  delete bustub_instance;
+
+  // Scenario: the full backup restored, then the incremental one on it, are recovered without the loser.
+  for (const auto &[file_name, lsn] : {std::make_pair("backup.full", full_lsn), {"backup.incr", incremental_lsn}}) {
+    auto *disk_manager = new DiskManager("restore.db");
+    auto *bpm = new BufferPoolManager(50, disk_manager);
+    EXPECT_EQ(lsn, BackupManager::Restore(file_name, disk_manager, bpm));
+    delete bpm;
+    delete disk_manager;
+  }
+  bustub_instance = new BustubInstance("restore.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Analysis();
+  EXPECT_EQ(log_recovery->GetActiveTransactions().size(), 1);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple tuple;
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i < 10 ? i + 1000 : i);
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  // Scenario: a file that is not a backup is not restored.
+  auto *disk_manager = new DiskManager("restore.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  EXPECT_THROW(BackupManager::Restore("restore.db", disk_manager, bpm), Exception);
+  delete bpm;
+  delete disk_manager;
+  for (const char *file_name :
+       {"backup.full", "backup.incr", "restore.db", "restore.log", "restore.fsm", "restore.mst"}) {
+    remove(file_name);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, UndoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -313,4 +859,356 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, GroupCommitTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  const int num_threads = 8;
+  const int num_commits = 50;
+
+  // Scenario: the committers arriving during a write are written, and woken up, together by the next one.
+  log_manager->RunFlushThread();
+  EXPECT_TRUE(enable_logging);
+  auto task = [&](int thread_id) {
+    for (int i = 0; i < num_commits; i++) {
+      LogRecord log_record(thread_id, INVALID_LSN, LogRecordType::COMMIT);
+      const lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      log_manager->WaitUntilPersistent(lsn);
+      EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  const int num_records = num_threads * num_commits;
+  EXPECT_EQ(log_manager->GetPersistentLSN(), num_records - 1);
+  EXPECT_LE(disk_manager->GetNumFlushes(), static_cast<int>(log_manager->GetNumCommitWaits()));
+  LOG_INFO("%d commits in %d writes of the log", num_records, disk_manager->GetNumFlushes());
+
+  // Scenario: without the flush thread, a committer writes the log itself.
+  LogRecord log_record(num_threads, INVALID_LSN, LogRecordType::COMMIT);
+  const lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+  EXPECT_LT(log_manager->GetPersistentLSN(), lsn);
+  log_manager->WaitUntilPersistent(lsn);
+  EXPECT_EQ(log_manager->GetPersistentLSN(), lsn);
+
+  // The records, all of the size of a header, are in the log file in the order of their LSNs.
+  const int32_t header_size = log_record.GetSize();
+  std::vector<char> log_data((num_records + 1) * header_size);
+  ASSERT_TRUE(disk_manager->ReadLog(log_data.data(), static_cast<int>(log_data.size()), 0));
+  for (int i = 0; i <= num_records; i++) {
+    int32_t size;
+    lsn_t record_lsn;
+    memcpy(&size, log_data.data() + i * header_size, sizeof(int32_t));
+    memcpy(&record_lsn, log_data.data() + i * header_size + sizeof(int32_t), sizeof(lsn_t));
+    EXPECT_EQ(size, header_size);
+    EXPECT_EQ(record_lsn, i);
+  }
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, AsyncLogWriteTest) {
+  // Falls back to POSIX, and so to synchronous writes, where io_uring is unavailable.
+  auto *disk_manager = new DiskManager("test.db", DiskBackendType::IO_URING);
+  auto *log_manager = new LogManager(disk_manager);
+  const int num_threads = 8;
+  const int num_commits = 200;
+
+  // Scenario: the committers keep several writes in flight, which retire in the order of their LSNs.
+  log_manager->RunFlushThread();
+  auto task = [&](int thread_id) {
+    for (int i = 0; i < num_commits; i++) {
+      LogRecord log_record(thread_id, INVALID_LSN, LogRecordType::COMMIT);
+      const lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+      if (i % 4 == 3) {
+        log_manager->WaitUntilPersistent(lsn);
+        EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  const int num_records = num_threads * num_commits;
+  EXPECT_EQ(log_manager->GetPersistentLSN(), num_records - 1);
+
+  LogRecord log_record(num_threads, INVALID_LSN, LogRecordType::COMMIT);
+  const int32_t header_size = log_record.GetSize();
+  std::vector<char> log_data(num_records * header_size);
+  ASSERT_TRUE(disk_manager->ReadLog(log_data.data(), static_cast<int>(log_data.size()), 0));
+  for (int i = 0; i < num_records; i++) {
+    lsn_t record_lsn;
+    memcpy(&record_lsn, log_data.data() + i * header_size + sizeof(int32_t), sizeof(lsn_t));
+    EXPECT_EQ(record_lsn, i);
+  }
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, DeltaUpdateRecordTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 64};
+  Column col3{"c", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col1, col2, col3}};
+  auto make_tuple = [&](int32_t a, const std::string &b, int64_t c) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(b), ValueFactory::GetBigIntValue(c)},
+                 &schema);
+  };
+  const std::string text(48, 'x');
+  auto check_delta = [&](const Tuple &old_tuple, const Tuple &new_tuple) {
+    LogRecord delta_record(0, INVALID_LSN, LogRecordType::DELTAUPDATE, RID{0, 0}, old_tuple, new_tuple);
+    LogRecord full_record(0, INVALID_LSN, LogRecordType::UPDATE, RID{0, 0}, old_tuple, new_tuple);
+    EXPECT_LT(delta_record.GetSize(), full_record.GetSize());
+    Tuple redone;
+    ASSERT_TRUE(delta_record.ApplyDelta(old_tuple, &redone, false));
+    ASSERT_EQ(redone.GetLength(), new_tuple.GetLength());
+    EXPECT_EQ(memcmp(redone.GetData(), new_tuple.GetData(), new_tuple.GetLength()), 0);
+    Tuple undone;
+    ASSERT_TRUE(delta_record.ApplyDelta(new_tuple, &undone, true));
+    ASSERT_EQ(undone.GetLength(), old_tuple.GetLength());
+    EXPECT_EQ(memcmp(undone.GetData(), old_tuple.GetData(), old_tuple.GetLength()), 0);
+    EXPECT_FALSE(delta_record.ApplyDelta(make_tuple(1, "", 1), &undone, false));
+  };
+
+  // Scenario: an integer column incremented, as UpdateType::Add does.
+  const Tuple tuple = make_tuple(41, text, 7);
+  check_delta(tuple, make_tuple(42, text, 7));
+  // Scenario: two columns apart changed, logged as two ranges.
+  check_delta(tuple, make_tuple(42, text, 8));
+  // Scenario: a varchar that shrinks or grows shifts the bytes after it.
+  check_delta(tuple, make_tuple(41, text.substr(0, 40), 7));
+  check_delta(tuple, make_tuple(41, text + "yz", 7));
+  // Scenario: nothing changed.
+  check_delta(tuple, tuple);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, CompressedLogRecordTest) {
+  // Scenario: the compressor restores what it compressed, and gives up on the data it cannot shrink.
+  std::vector<char> data(PAGE_SIZE);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i % 64 < 32 ? 0 : i % 7);
+  }
+  std::vector<char> compressed(PAGE_SIZE);
+  const size_t compressed_size = LogCompressor::Compress(data.data(), data.size(), compressed.data(), PAGE_SIZE);
+  ASSERT_GT(compressed_size, 0);
+  EXPECT_LT(compressed_size, PAGE_SIZE / 4);
+  std::vector<char> decompressed(PAGE_SIZE);
+  ASSERT_EQ(LogCompressor::Decompress(compressed.data(), compressed_size, decompressed.data(), PAGE_SIZE), PAGE_SIZE);
+  EXPECT_EQ(decompressed, data);
+  EXPECT_EQ(LogCompressor::Decompress(compressed.data(), compressed_size, decompressed.data(), PAGE_SIZE - 1), 0);
+  std::mt19937 generator(15445);
+  std::vector<char> noise(PAGE_SIZE);
+  for (auto &byte : noise) {
+    byte = static_cast<char>(generator());
+  }
+  EXPECT_EQ(LogCompressor::Compress(noise.data(), noise.size(), compressed.data(), PAGE_SIZE), 0);
+
+  // Scenario: the log manager compresses the large bodies as it appends them, and leaves the small ones.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager, LogBufferMode::SHARED, true);
+  LogRecord image_record(0, INVALID_LSN, LogRecordType::PAGEIMAGE, 3, data.data());
+  const int32_t image_size = image_record.GetSize();
+  log_manager->AppendLogRecord(&image_record);
+  EXPECT_LT(image_record.GetSize(), image_size / 4);
+  LogRecord commit_record(0, image_record.GetLSN(), LogRecordType::COMMIT);
+  const lsn_t lsn = log_manager->AppendLogRecord(&commit_record);
+  log_manager->WaitUntilPersistent(lsn);
+
+  std::vector<char> log_data(image_record.GetSize() + commit_record.GetSize());
+  ASSERT_TRUE(disk_manager->ReadLog(log_data.data(), static_cast<int>(log_data.size()), 0));
+  const int32_t header_size = commit_record.GetSize();
+  int32_t log_type;
+  // The type follows the size, the LSN, the transaction id and the prevLSN.
+  memcpy(&log_type, log_data.data() + 4 * sizeof(int32_t), sizeof(int32_t));
+  EXPECT_EQ(log_type, static_cast<int32_t>(LogRecordType::PAGEIMAGE) | LOG_COMPRESSED_FLAG);
+  int32_t body_size;
+  memcpy(&body_size, log_data.data() + header_size, sizeof(int32_t));
+  ASSERT_EQ(body_size, image_size - header_size);
+  std::vector<char> body(body_size);
+  ASSERT_EQ(LogCompressor::Decompress(log_data.data() + header_size + sizeof(int32_t),
+                                      image_record.GetSize() - header_size - sizeof(int32_t), body.data(), body_size),
+            static_cast<size_t>(body_size));
+  page_id_t page_id;
+  memcpy(&page_id, body.data(), sizeof(page_id_t));
+  EXPECT_EQ(page_id, 3);
+  EXPECT_EQ(memcmp(body.data() + sizeof(page_id_t), data.data(), PAGE_SIZE), 0);
+  memcpy(&log_type, log_data.data() + image_record.GetSize() + 4 * sizeof(int32_t), sizeof(int32_t));
+  EXPECT_EQ(log_type, static_cast<int32_t>(LogRecordType::COMMIT));
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, PerThreadBufferTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager, LogBufferMode::PER_THREAD);
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const int num_threads = 8;
+  const int num_txns = 50;
+
+  // Scenario: transactions of a few records each, appended to the buffers of their threads, and committed together.
+  log_manager->RunFlushThread();
+  auto task = [&](int thread_id) {
+    for (int i = 0; i < num_txns; i++) {
+      const Tuple tuple = ConstructTuple(&schema);
+      const txn_id_t txn_id = thread_id * num_txns + i;
+      LogRecord insert_record(txn_id, INVALID_LSN, LogRecordType::INSERT, RID{i, 0}, tuple);
+      log_manager->AppendLogRecord(&insert_record);
+      LogRecord update_record(txn_id, insert_record.GetLSN(), LogRecordType::UPDATE, RID{i, 0}, tuple, tuple);
+      log_manager->AppendLogRecord(&update_record);
+      LogRecord commit_record(txn_id, update_record.GetLSN(), LogRecordType::COMMIT);
+      const lsn_t lsn = log_manager->AppendLogRecord(&commit_record);
+      log_manager->WaitUntilPersistent(lsn);
+      EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  const int num_records = 3 * num_threads * num_txns;
+  EXPECT_EQ(log_manager->GetPersistentLSN(), num_records - 1);
+
+  // The flushes merged the buffers: the log file holds every record once, in the order of the LSNs.
+  std::vector<char> log_data(num_records * PAGE_SIZE);
+  ASSERT_TRUE(disk_manager->ReadLog(log_data.data(), static_cast<int>(log_data.size()), 0));
+  size_t pos = 0;
+  for (int i = 0; i < num_records; i++) {
+    int32_t size;
+    lsn_t record_lsn;
+    memcpy(&size, log_data.data() + pos, sizeof(int32_t));
+    memcpy(&record_lsn, log_data.data() + pos + sizeof(int32_t), sizeof(lsn_t));
+    ASSERT_EQ(record_lsn, i);
+    pos += size;
+  }
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, MappedLogScanTest) {
+  const int64_t segment_size = 4096;
+  const int num_txns = 200;
+  auto *disk_manager = new DiskManager("test.db", DiskBackendType::POSIX, false, false, segment_size);
+  auto *bpm = new BufferPoolManager(16, disk_manager);
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Scenario: records of a header only, some of them spanning two segments, are scanned in place across segments.
+  lsn_t lsn = INVALID_LSN;
+  for (txn_id_t txn_id = 0; txn_id <= num_txns; txn_id++) {
+    LogRecord begin_record(txn_id, INVALID_LSN, LogRecordType::BEGIN);
+    lsn = log_manager->AppendLogRecord(&begin_record);
+    if (txn_id < num_txns) {
+      LogRecord commit_record(txn_id, begin_record.GetLSN(), LogRecordType::COMMIT);
+      lsn = log_manager->AppendLogRecord(&commit_record);
+    }
+  }
+  log_manager->WaitUntilPersistent(lsn);
+  const int32_t record_size = LogRecord(0, INVALID_LSN, LogRecordType::COMMIT).GetSize();
+  ASSERT_GT(disk_manager->GetLogSize(), 2 * segment_size);
+  size_t mapped_size;
+  ASSERT_NE(nullptr, disk_manager->MapLog(record_size, &mapped_size));
+  EXPECT_EQ(disk_manager->GetLogSize() - record_size, mapped_size);
+  disk_manager->UnmapLog();
+  {
+    LogRecovery log_recovery(disk_manager, bpm);
+    log_recovery.Analysis();
+    EXPECT_EQ((std::unordered_map<txn_id_t, lsn_t>{{num_txns, 2 * num_txns}}), log_recovery.GetActiveTransactions());
+  }
+
+  // Scenario: a record that does not match its checksum ends the log, as a torn write at its end would.
+  const txn_id_t torn_txn_id = 150;
+  const int64_t torn_offset = (2 * torn_txn_id + 1) * record_size + 8;
+  {
+    std::fstream segment("test.log." + std::to_string(torn_offset / segment_size),
+                         std::ios::binary | std::ios::in | std::ios::out);
+    segment.seekp(torn_offset % segment_size);
+    segment.put('\x7f');
+  }
+  {
+    LogRecovery log_recovery(disk_manager, bpm);
+    log_recovery.Analysis();
+    EXPECT_EQ((std::unordered_map<txn_id_t, lsn_t>{{torn_txn_id, 2 * torn_txn_id}}),
+              log_recovery.GetActiveTransactions());
+  }
+
+  delete log_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  for (int64_t segment = 1; segment * segment_size < 2 * num_txns * record_size; segment++) {
+    remove(("test.log." + std::to_string(segment)).c_str());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, DISABLED_AppendPerformanceTest) {
+  // Writers appending update records of small tuples, with the flush thread writing the log behind them.
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const Tuple tuple = ConstructTuple(&schema);
+  const int num_records = 1 << 20;
+  for (auto [buffer_mode, num_threads] : std::vector<std::pair<LogBufferMode, int>>{
+           {LogBufferMode::SHARED, 1},
+           {LogBufferMode::SHARED, 4},
+           {LogBufferMode::SHARED, 16},
+           {LogBufferMode::PER_THREAD, 1},
+           {LogBufferMode::PER_THREAD, 4},
+           {LogBufferMode::PER_THREAD, 16}}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *log_manager = new LogManager(disk_manager, buffer_mode);
+    log_manager->RunFlushThread();
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t, num_threads = num_threads] {
+        for (int i = 0; i < num_records / num_threads; i++) {
+          LogRecord log_record(t, INVALID_LSN, LogRecordType::UPDATE, RID{i, 0}, tuple, tuple);
+          log_manager->AppendLogRecord(&log_record);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    log_manager->StopFlushThread();
+    LOG_INFO("%s threads=%d records=%d %.1fms (%.0f records/ms)",
+             buffer_mode == LogBufferMode::SHARED ? "shared" : "per-thread", num_threads, num_records, ms,
+             num_records / ms);
+    delete log_manager;
+    disk_manager->ShutDown();
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
 }  // namespace bustub
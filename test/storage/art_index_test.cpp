@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index_test.cpp
+//
+// Identification: test/storage/art_index_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/art_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ARTIndexTest, BigIntTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  auto key_of = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, &schema); };
+  ARTIndex index(new IndexMetadata("index", "table", &schema, {0}, false));
+
+  // Scenario: keys of either sign, inserted in random order, are found and scanned in key order.
+  std::vector<int64_t> keys;
+  for (int64_t key = -5000; key < 5000; key++) {
+    keys.push_back(key * 977);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  for (int64_t key : keys) {
+    index.InsertEntry(key_of(key), RID(0, static_cast<uint32_t>(key + 5000 * 977)), nullptr);
+  }
+  std::sort(keys.begin(), keys.end());
+  for (int64_t key : keys) {
+    std::vector<RID> rids;
+    index.ScanKey(key_of(key), &rids, nullptr);
+    ASSERT_EQ(std::vector<RID>{RID(0, static_cast<uint32_t>(key + 5000 * 977))}, rids) << key;
+  }
+  std::vector<RID> rids;
+  index.ScanKey(key_of(1), &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+  index.ScanRange(nullptr, nullptr, &rids);
+  ASSERT_EQ(keys.size(), rids.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_EQ(static_cast<uint32_t>(keys[i] + 5000 * 977), rids[i].GetSlotNum());
+  }
+
+  // Scenario: a range scan starts and ends at its bounds, whether they are keys of the index or not.
+  Tuple lo = key_of(-977 * 3 - 1);
+  Tuple hi = key_of(977 * 2);
+  rids.clear();
+  index.ScanRange(&lo, &hi, &rids);
+  EXPECT_EQ(6, rids.size());
+  rids.clear();
+  index.ScanRange(&hi, nullptr, &rids);
+  EXPECT_EQ(4998, rids.size());
+  rids.clear();
+  index.ScanRange(nullptr, &lo, &rids);
+  EXPECT_EQ(4997, rids.size());
+
+  // Scenario: a key of a non-unique index holds several record ids, each removed on its own.
+  index.InsertEntry(key_of(0), RID(1, 0), nullptr);
+  index.InsertEntry(key_of(0), RID(1, 0), nullptr);
+  rids.clear();
+  index.ScanKey(key_of(0), &rids, nullptr);
+  EXPECT_EQ(2, rids.size());
+  index.DeleteEntry(key_of(0), RID(1, 0), nullptr);
+  rids.clear();
+  index.ScanKey(key_of(0), &rids, nullptr);
+  EXPECT_EQ(std::vector<RID>{RID(0, 5000 * 977)}, rids);
+
+  // Scenario: deleting every other key shrinks the nodes, and the keys left are all still found.
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    index.DeleteEntry(key_of(keys[i]), RID(0, static_cast<uint32_t>(keys[i] + 5000 * 977)), nullptr);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    index.ScanKey(key_of(keys[i]), &rids, nullptr);
+    ASSERT_EQ(i % 2 == 0 ? 0 : 1, rids.size()) << keys[i];
+  }
+  for (size_t i = 1; i < keys.size(); i += 2) {
+    index.DeleteEntry(key_of(keys[i]), RID(0, static_cast<uint32_t>(keys[i] + 5000 * 977)), nullptr);
+  }
+  rids.clear();
+  index.ScanRange(nullptr, nullptr, &rids);
+  EXPECT_TRUE(rids.empty());
+
+  // Scenario: an index with unique keys keeps the first record id of a key.
+  ARTIndex unique_index(new IndexMetadata("unique", "table", &schema, {0}));
+  unique_index.InsertEntry(key_of(7), RID(0, 1), nullptr);
+  unique_index.InsertEntry(key_of(7), RID(0, 2), nullptr);
+  rids.clear();
+  unique_index.ScanKey(key_of(7), &rids, nullptr);
+  EXPECT_EQ(std::vector<RID>{RID(0, 1)}, rids);
+}
+
+// NOLINTNEXTLINE
+TEST(ARTIndexTest, CompositeKeyTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::VARCHAR, 16}, Column{"b", TypeId::INTEGER}}};
+  auto key_of = [&](const std::string &a, int32_t b) {
+    return Tuple({ValueFactory::GetVarcharValue(a), ValueFactory::GetIntegerValue(b)}, &schema);
+  };
+  ARTIndex index(new IndexMetadata("index", "table", &schema, {0, 1}));
+
+  // Scenario: strings that are prefixes of others, or hold zero bytes, sort before them, then on the next column.
+  std::vector<std::string> strings{"", "a", "ab", "abc", "b", "ba", std::string("a\0b", 3), "zzzz"};
+  uint32_t slot = 0;
+  for (const auto &a : strings) {
+    for (int32_t b : {-2, 1, 0}) {
+      index.InsertEntry(key_of(a, b), RID(0, slot++), nullptr);
+    }
+  }
+  std::vector<std::string> sorted = strings;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<RID> rids;
+  index.ScanRange(nullptr, nullptr, &rids);
+  ASSERT_EQ(strings.size() * 3, rids.size());
+  size_t i = 0;
+  for (const auto &a : sorted) {
+    for (int32_t b : {-2, 0, 1}) {
+      std::vector<RID> found;
+      index.ScanKey(key_of(a, b), &found, nullptr);
+      ASSERT_EQ(1, found.size());
+      EXPECT_EQ(found[0], rids[i++]);
+    }
+  }
+  EXPECT_LT(index.EncodeKey(key_of("a", 5)), index.EncodeKey(key_of("ab", -5)));
+}
+
+// NOLINTNEXTLINE
+TEST(ARTIndexTest, ConcurrentTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  auto key_of = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, &schema); };
+  ARTIndex index(new IndexMetadata("index", "table", &schema, {0}));
+  const int64_t num_keys = 20000;
+  const int num_threads = 4;
+
+  // Scenario: threads insert and delete keys of their own while others look them up and scan them.
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    index.InsertEntry(key_of(key), RID(0, key), nullptr);
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int64_t key = t; key < num_keys; key += num_threads) {
+        if (key % 2 == 0) {
+          index.DeleteEntry(key_of(key), RID(0, key), nullptr);
+        } else {
+          index.InsertEntry(key_of(key), RID(0, key), nullptr);
+        }
+        std::vector<RID> rids;
+        index.ScanKey(key_of(key ^ 1), &rids, nullptr);
+        ASSERT_LE(rids.size(), 1);
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    for (int i = 0; i < 20; i++) {
+      std::vector<RID> rids;
+      index.ScanRange(nullptr, nullptr, &rids);
+      ASSERT_TRUE(std::is_sorted(rids.begin(), rids.end(),
+                                 [](const RID &a, const RID &b) { return a.GetSlotNum() < b.GetSlotNum(); }));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::vector<RID> rids;
+    index.ScanKey(key_of(key), &rids, nullptr);
+    ASSERT_EQ(key % 2 == 0 ? 0 : 1, rids.size()) << key;
+  }
+  std::vector<RID> rids;
+  index.ScanRange(nullptr, nullptr, &rids);
+  EXPECT_EQ(num_keys / 2, rids.size());
+}
+
+}  // namespace bustub
@@ -2,9 +2,12 @@
  * b_plus_tree_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <random>
 #include <thread>                   // NOLINT
 #include "b_plus_tree_test_util.h"  // NOLINT
 
@@ -92,7 +95,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -145,7 +148,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -197,7 +200,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -240,7 +243,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -284,7 +287,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -330,4 +333,178 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, OptimisticReadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with tiny pages, so that the writers split and merge pages all the time
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // The multiples of three stay in the tree; the other keys come and go.
+  const int64_t scale_factor = 300;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> volatile_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    (key % 3 == 0 ? stable_keys : volatile_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> misses{0};
+  auto reader = [&](uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    while (!done) {
+      for (auto key : stable_keys) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        if (!tree.GetValue(index_key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != key) {
+          misses++;
+        }
+      }
+    }
+  };
+  std::vector<std::thread> readers;
+  for (uint64_t thread_itr = 0; thread_itr < 4; thread_itr++) {
+    readers.emplace_back(reader, thread_itr);
+  }
+  for (int round = 0; round < 5; round++) {
+    LaunchParallelTest(2, InsertHelperSplit, &tree, volatile_keys, 2);
+    LaunchParallelTest(2, DeleteHelperSplit, &tree, volatile_keys, 2);
+  }
+  done = true;
+  for (auto &thread : readers) {
+    thread.join();
+  }
+  EXPECT_EQ(0, misses);
+
+  int64_t current_key = 3;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 3;
+  }
+  EXPECT_EQ(current_key, scale_factor + 3);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ReverseScanTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with tiny pages, so that the writers split and merge the leaves the scans go through
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // The multiples of three stay in the tree; the other keys come and go.
+  const int64_t scale_factor = 300;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> volatile_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    (key % 3 == 0 ? stable_keys : volatile_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> misses{0};
+  auto scanner = [&](uint64_t thread_itr) {
+    while (!done) {
+      // Scenario: every scan goes down through all of the stable keys, in order, whatever the writers do.
+      int64_t previous_key = scale_factor + 1;
+      int64_t expected_key = scale_factor;
+      for (auto iterator = tree.RBegin(); iterator != tree.end(); ++iterator) {
+        const int64_t key = (*iterator).second.GetSlotNum();
+        if (key >= previous_key || (key % 3 == 0 && key != expected_key)) {
+          misses++;
+        }
+        if (key % 3 == 0) {
+          expected_key = key - 3;
+        }
+        previous_key = key;
+      }
+      if (expected_key != 0) {
+        misses++;
+      }
+    }
+  };
+  std::vector<std::thread> scanners;
+  for (uint64_t thread_itr = 0; thread_itr < 2; thread_itr++) {
+    scanners.emplace_back(scanner, thread_itr);
+  }
+  for (int round = 0; round < 5; round++) {
+    LaunchParallelTest(2, InsertHelperSplit, &tree, volatile_keys, 2);
+    LaunchParallelTest(2, DeleteHelperSplit, &tree, volatile_keys, 2);
+  }
+  done = true;
+  for (auto &thread : scanners) {
+    thread.join();
+  }
+  EXPECT_EQ(0, misses);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeConcurrentTest, DISABLED_InsertThroughputTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  const int64_t scale_factor = 200000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  for (int num_threads : {1, 2, 4, 8}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(4096, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, InsertHelperSplit, &tree, keys, num_threads);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    LOG_INFO("threads=%d inserts=%ld inserts/sec=%.0f", num_threads, scale_factor, scale_factor / seconds);
+
+    std::vector<RID> rids;
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(scale_factor);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete key_schema;
+}
+
 }  // namespace bustub
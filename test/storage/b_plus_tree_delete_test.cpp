@@ -3,7 +3,10 @@
  */
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <random>
+#include <vector>
 
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
@@ -12,7 +15,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
+TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   std::string createStmt = "a bigint";
   Schema *key_schema = ParseCreateStatement(createStmt);
@@ -92,7 +95,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
+TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -170,4 +173,235 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, RangeIteratorTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // small pages, so that the ranges span many leaves that split and merge
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 100; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  // Remove the multiples of 5 and of 7, merging leaves in between the ones that remain.
+  std::vector<int64_t> expected;
+  for (int64_t key = 1; key <= 100; key++) {
+    index_key.SetFromInteger(key);
+    if (key % 5 == 0 || key % 7 == 0) {
+      tree.Remove(index_key, transaction);
+    } else {
+      expected.push_back(key);
+    }
+  }
+
+  auto collect = [](auto iterator, auto end) {
+    std::vector<int64_t> result;
+    for (; iterator != end; ++iterator) {
+      result.push_back((*iterator).second.GetSlotNum());
+    }
+    return result;
+  };
+  auto expect_range = [&expected](int64_t lo, int64_t hi, bool lo_inclusive, bool hi_inclusive) {
+    std::vector<int64_t> result;
+    for (auto key : expected) {
+      if ((key > lo || (lo_inclusive && key == lo)) && (key < hi || (hi_inclusive && key == hi))) {
+        result.push_back(key);
+      }
+    }
+    return result;
+  };
+
+  // Scenario: the whole tree backward.
+  std::vector<int64_t> reversed(expected.rbegin(), expected.rend());
+  EXPECT_EQ(reversed, collect(tree.RBegin(), tree.end()));
+  GenericKey<8> lo_key;
+  GenericKey<8> hi_key;
+  for (int64_t lo = 0; lo <= 101; lo += 3) {
+    for (int64_t hi = lo - 1; hi <= 101; hi += 4) {
+      lo_key.SetFromInteger(lo);
+      hi_key.SetFromInteger(hi);
+      // Scenario: a bounded range forward, with the high key in it or not.
+      EXPECT_EQ(expect_range(lo, hi, true, true), collect(tree.Begin(lo_key, hi_key), tree.end())) << lo << " " << hi;
+      EXPECT_EQ(expect_range(lo, hi, true, false), collect(tree.Begin(lo_key, hi_key, false), tree.end()))
+          << lo << " " << hi;
+      // Scenario: a bounded range backward, with the low key in it or not.
+      auto range = expect_range(lo, hi, true, true);
+      std::reverse(range.begin(), range.end());
+      EXPECT_EQ(range, collect(tree.RBegin(hi_key, lo_key), tree.end())) << lo << " " << hi;
+      range = expect_range(lo, hi, false, true);
+      std::reverse(range.begin(), range.end());
+      EXPECT_EQ(range, collect(tree.RBegin(hi_key, lo_key, false), tree.end())) << lo << " " << hi;
+    }
+    // Scenario: backward from a key to the first one.
+    auto range = expect_range(0, lo, true, true);
+    std::reverse(range.begin(), range.end());
+    EXPECT_EQ(range, collect(tree.RBegin(lo_key), tree.end())) << lo;
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, LazyMergeTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  tree.SetMergeWatermark(1);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  for (int64_t key = 1; key <= 200; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  auto check = [&](const std::vector<int64_t> &expected) {
+    std::vector<int64_t> result;
+    for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+      result.push_back((*iterator).second.GetSlotNum());
+    }
+    EXPECT_EQ(expected, result);
+    std::vector<RID> rids;
+    for (auto key : expected) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, &rids)) << key;
+    }
+  };
+
+  // Scenario: removes leave the leaves sparse, and merge only the ones they empty.
+  std::vector<int64_t> expected;
+  for (int64_t key = 1; key <= 200; key++) {
+    index_key.SetFromInteger(key);
+    if (key % 3 != 0 || key > 150) {
+      tree.Remove(index_key, transaction);
+    } else {
+      expected.push_back(key);
+    }
+  }
+  check(expected);
+
+  // Scenario: compaction rebalances the sparse leaves, once.
+  EXPECT_GT(tree.Compact(), 0);
+  EXPECT_EQ(0, tree.Compact());
+  check(expected);
+
+  // Scenario: the compactor thread does it in the background, racing with removes and inserts.
+  tree.StartCompactor(std::chrono::milliseconds(1), 8);
+  std::vector<int64_t> remaining;
+  for (auto key : expected) {
+    index_key.SetFromInteger(key);
+    if (key % 2 == 0) {
+      tree.Remove(index_key, transaction);
+    } else {
+      remaining.push_back(key);
+    }
+  }
+  for (int64_t key = 1000; key < 1100; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+    remaining.push_back(key);
+  }
+  tree.StopCompactor();
+  check(remaining);
+  tree.Compact();
+  check(remaining);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, DeferredDeleteTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(100, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  for (int64_t key = 1; key <= 40; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // Scenario: the leaf pages the removes empty are not deleted while pinned, as by an optimistic reader.
+  std::vector<page_id_t> pinned;
+  for (int64_t key = 1; key <= 36; key++) {
+    index_key.SetFromInteger(key);
+    Page *leaf = tree.FindLeafPage(index_key);
+    leaf->RUnlatch();
+    if (std::find(pinned.begin(), pinned.end(), leaf->GetPageId()) == pinned.end()) {
+      pinned.push_back(leaf->GetPageId());
+    } else {
+      bpm->UnpinPage(leaf->GetPageId(), false);
+    }
+  }
+  for (int64_t key = 1; key <= 36; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  const size_t num_free_pages = disk_manager->GetNumFreePages();
+
+  // Scenario: once unpinned, they are deleted by the next write.
+  for (page_id_t leaf_page_id : pinned) {
+    bpm->UnpinPage(leaf_page_id, false);
+  }
+  rid.Set(0, 1);
+  index_key.SetFromInteger(1);
+  tree.Insert(index_key, rid, transaction);
+  EXPECT_GT(disk_manager->GetNumFreePages(), num_free_pages);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
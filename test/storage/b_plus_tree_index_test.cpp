@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_index_test.cpp
+//
+// Identification: test/storage/b_plus_tree_index_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeIndexTest, ChangeBufferTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(16, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  auto key_of = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, &schema); };
+  const int64_t num_keys = 20000;
+
+  {
+    // Scenario: an index with unique keys cannot defer its inserts.
+    BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> unique_index(
+        new IndexMetadata("unique", "table", &schema, {0}), bpm);
+    EXPECT_THROW(unique_index.EnableChangeBuffer(), Exception);
+  }
+
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      new IndexMetadata("index", "table", &schema, {0}, false), bpm);
+  for (int64_t key = 0; key < num_keys; key++) {
+    index.InsertEntry(key_of(key), RID(0, key), nullptr);
+  }
+  index.EnableChangeBuffer();
+  EXPECT_TRUE(index.HasChangeBuffer());
+  EXPECT_EQ(0, index.GetNumPendingChanges());
+
+  // Scenario: the inserts and deletes of leaf pages evicted long ago are left pending, and lookups see them.
+  for (int64_t key = 0; key < num_keys; key += 7) {
+    index.InsertEntry(key_of(key), RID(1, key), nullptr);
+  }
+  for (int64_t key = 0; key < num_keys; key += 5) {
+    index.DeleteEntry(key_of(key), RID(0, key), nullptr);
+  }
+  EXPECT_GT(index.GetNumPendingChanges(), 0);
+  auto expected_of = [](int64_t key) {
+    std::vector<RID> expected;
+    if (key % 5 != 0) {
+      expected.emplace_back(0, key);
+    }
+    if (key % 7 == 0) {
+      expected.emplace_back(1, key);
+    }
+    return expected;
+  };
+  std::vector<Tuple> keys;
+  for (int64_t key = 0; key < num_keys; key++) {
+    keys.push_back(key_of(key));
+  }
+  std::vector<std::vector<RID>> results;
+  index.ScanKeys(keys, &results, nullptr);
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::sort(results[key].begin(), results[key].end(),
+              [](const RID &a, const RID &b) { return a.GetPageId() < b.GetPageId(); });
+    ASSERT_EQ(expected_of(key), results[key]) << key;
+  }
+  // Scenario: interleaved lookups see them as well.
+  index.ProbeKeys(keys, &results, nullptr);
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::sort(results[key].begin(), results[key].end(),
+              [](const RID &a, const RID &b) { return a.GetPageId() < b.GetPageId(); });
+    ASSERT_EQ(expected_of(key), results[key]) << key;
+  }
+
+  // Scenario: an insert and a delete of the same entry cancel out in the buffer.
+  index.InsertEntry(key_of(1), RID(2, 1), nullptr);
+  index.DeleteEntry(key_of(1), RID(2, 1), nullptr);
+  std::vector<RID> rids;
+  index.ScanKey(key_of(1), &rids, nullptr);
+  EXPECT_EQ(expected_of(1), rids);
+
+  // Scenario: a lookup merges the pending changes of its key, once it has read the leaf page in.
+  const size_t num_pending = index.GetNumPendingChanges();
+  rids.clear();
+  index.ScanKey(key_of(num_keys / 2 + 5), &rids, nullptr);
+  EXPECT_EQ(expected_of(num_keys / 2 + 5), rids);
+  EXPECT_LT(index.GetNumPendingChanges(), num_pending);
+
+  // Scenario: merging in the background, a batch at a time, empties the buffer.
+  while (index.MergeChanges(64) > 0) {
+  }
+  EXPECT_EQ(0, index.GetNumPendingChanges());
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index.ScanKey(key_of(key), &rids, nullptr);
+    std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) { return a.GetPageId() < b.GetPageId(); });
+    ASSERT_EQ(expected_of(key), rids) << key;
+  }
+  size_t num_entries = 0;
+  for (auto iter = index.GetBeginIterator(); !iter.isEnd(); ++iter) {
+    num_entries++;
+  }
+  EXPECT_EQ(num_keys - num_keys / 5 + num_keys / 7 + 1, num_entries);
+
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
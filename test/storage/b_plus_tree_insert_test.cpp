@@ -3,16 +3,24 @@
  */
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
 
 #include "b_plus_tree_test_util.h"  // NOLINT
 #include "buffer/buffer_pool_manager.h"
+#include "common/logger.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -71,7 +79,7 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
@@ -139,4 +147,604 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // tiny pages, so that the tree gets several internal levels
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // sorted pairs with the even keys from 2 to 1000, each of them twice
+  const int64_t scale_factor = 1000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int64_t key = 2; key <= scale_factor; key += 2) {
+    for (int32_t copy = 0; copy < 2; copy++) {
+      GenericKey<8> index_key;
+      index_key.SetFromInteger(key);
+      entries.emplace_back(index_key, RID(copy, static_cast<uint32_t>(key)));
+    }
+  }
+  tree.BulkLoad(entries.cbegin(), entries.cend(), 0.5, transaction);
+
+  // Scenario: only the first of equal keys is loaded, and all of the keys are found.
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_EQ(key % 2 == 0, tree.GetValue(index_key, &rids));
+    if (key % 2 == 0) {
+      EXPECT_EQ(rids[0], RID(0, static_cast<uint32_t>(key)));
+    }
+  }
+
+  // Scenario: the loaded tree splits and merges like any other.
+  for (int64_t key = 1; key <= scale_factor; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)), transaction));
+  }
+  for (int64_t key = 1; key <= scale_factor; key += 3) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  int64_t current_key = 1;
+  int64_t size = 0;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    if (current_key % 3 == 1) {
+      current_key++;
+    }
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key++;
+    size++;
+  }
+  EXPECT_EQ(size, scale_factor - (scale_factor + 2) / 3);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, NonUniqueKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // tiny pages, so that the leaves split and merge with their posting lists
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 4, 4, false);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // key k has 60 * k values, up to three posting pages' worth
+  const int64_t num_keys = 20;
+  std::map<int64_t, std::set<int64_t>> expected;
+  GenericKey<8> index_key;
+  for (int64_t i = 0; i < 60 * num_keys; i++) {
+    for (int64_t key = num_keys - 1; key > 0 && i < 60 * key; key--) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(static_cast<int32_t>(key), static_cast<uint32_t>(i)), transaction));
+      expected[key].insert(i);
+    }
+  }
+  auto check = [&]() {
+    // Scenario: a lookup finds all of the values of a key.
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < num_keys; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      ASSERT_EQ(expected.count(key) == 1, tree.GetValue(index_key, &rids)) << key;
+      std::set<int64_t> values;
+      for (const auto &rid : rids) {
+        EXPECT_EQ(key, rid.GetPageId());
+        values.insert(rid.GetSlotNum());
+      }
+      EXPECT_EQ(rids.size(), values.size());
+      EXPECT_EQ(expected.count(key) == 1 ? expected[key] : std::set<int64_t>{}, values) << key;
+    }
+    // Scenario: a batched lookup finds them too.
+    std::vector<GenericKey<8>> batch(num_keys);
+    for (int64_t key = 0; key < num_keys; key++) {
+      batch[key].SetFromInteger(key);
+    }
+    std::vector<std::vector<RID>> results;
+    EXPECT_EQ(expected.size(), tree.GetValues(batch, &results, transaction));
+    for (int64_t key = 0; key < num_keys; key++) {
+      std::set<int64_t> values;
+      for (const auto &rid : results[key]) {
+        values.insert(rid.GetSlotNum());
+      }
+      EXPECT_EQ(expected.count(key) == 1 ? expected[key] : std::set<int64_t>{}, values) << key;
+    }
+    // Scenario: interleaved lookups in reverse order find them too.
+    std::reverse(batch.begin(), batch.end());
+    EXPECT_EQ(expected.size(), tree.GetValuesInterleaved(batch, &results, transaction));
+    for (int64_t key = 0; key < num_keys; key++) {
+      std::set<int64_t> values;
+      for (const auto &rid : results[num_keys - 1 - key]) {
+        values.insert(rid.GetSlotNum());
+      }
+      EXPECT_EQ(expected.count(key) == 1 ? expected[key] : std::set<int64_t>{}, values) << key;
+    }
+    // Scenario: the iterators yield a pair for each value, forward and backward.
+    std::map<int64_t, std::set<int64_t>> forward;
+    int64_t previous_key = -1;
+    for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+      const int64_t key = (*iterator).first.ToString();
+      EXPECT_LE(previous_key, key);
+      EXPECT_EQ(key, (*iterator).second.GetPageId());
+      forward[key].insert((*iterator).second.GetSlotNum());
+      previous_key = key;
+    }
+    EXPECT_EQ(expected, forward);
+    size_t backward = 0;
+    for (auto iterator = tree.RBegin(); iterator != tree.end(); ++iterator) {
+      const int64_t key = (*iterator).first.ToString();
+      EXPECT_GE(previous_key, key);
+      EXPECT_EQ(1, expected[key].count((*iterator).second.GetSlotNum()));
+      previous_key = key;
+      backward++;
+    }
+    size_t num_values = 0;
+    for (const auto &entry : expected) {
+      num_values += entry.second.size();
+    }
+    EXPECT_EQ(num_values, backward);
+  };
+  check();
+
+  // Scenario: values are removed one at a time, down to a single one and to none, or all of them together.
+  for (int64_t key = 1; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    for (int64_t i = 0; i < 60 * key; i++) {
+      if (i % 3 == 0 || key % 4 == 0 || (key % 4 == 1 && i != 1)) {
+        tree.Remove(index_key, RID(static_cast<int32_t>(key), static_cast<uint32_t>(i)), transaction);
+        expected[key].erase(i);
+      }
+    }
+    // a value the key does not have
+    tree.Remove(index_key, RID(static_cast<int32_t>(key + 1), 1), transaction);
+    if (expected[key].empty()) {
+      expected.erase(key);
+    }
+  }
+  index_key.SetFromInteger(num_keys - 1);
+  tree.Remove(index_key, transaction);
+  expected.erase(num_keys - 1);
+  check();
+
+  // Scenario: bulk loading keeps the values of equal keys too.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> loaded("bar_idx", bpm, comparator, 4, 4, false);
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    for (int64_t i = 0; i <= 60 * key; i++) {
+      entries.emplace_back(index_key, RID(static_cast<int32_t>(key), static_cast<uint32_t>(i)));
+    }
+  }
+  loaded.BulkLoad(entries.cbegin(), entries.cend(), 1.0, transaction);
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(loaded.GetValue(index_key, &rids));
+    EXPECT_EQ(60 * key + 1, rids.size());
+  }
+  size_t num_pairs = 0;
+  for (auto iterator = loaded.begin(); iterator != loaded.end(); ++iterator) {
+    num_pairs++;
+  }
+  EXPECT_EQ(entries.size(), num_pairs);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BatchLookupTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // small pages, so that batches span many leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<GenericKey<8>> batch;
+  std::vector<std::vector<RID>> results;
+  EXPECT_EQ(0, tree.GetValues(batch, &results, transaction));
+
+  // the multiples of 3 up to 3000
+  const int64_t scale_factor = 1000;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    index_key.SetFromInteger(3 * key);
+    tree.Insert(index_key, RID(0, static_cast<uint32_t>(3 * key)), transaction);
+  }
+  // Scenario: batches with keys close together, far apart, repeated, missing and past either end are all looked up.
+  for (int64_t stride : {1, 2, 5, 40, 700}) {
+    batch.clear();
+    results.clear();
+    for (int64_t key = -3; key <= 3 * scale_factor + 10; key += stride) {
+      index_key.SetFromInteger(key);
+      batch.push_back(index_key);
+      if (key % 7 == 0) {
+        batch.push_back(index_key);
+      }
+    }
+    size_t num_found = 0;
+    for (const auto &key : batch) {
+      num_found += key.ToString() % 3 == 0 && key.ToString() > 0 && key.ToString() <= 3 * scale_factor ? 1 : 0;
+    }
+    EXPECT_EQ(num_found, tree.GetValues(batch, &results, transaction)) << stride;
+    ASSERT_EQ(batch.size(), results.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+      std::vector<RID> rids;
+      tree.GetValue(batch[i], &rids);
+      EXPECT_EQ(rids, results[i]) << stride << " " << batch[i].ToString();
+    }
+  }
+
+  // Scenario: interleaved lookups of shuffled keys, through a pool too small for the tree, find the same values.
+  batch.clear();
+  for (int64_t key = -3; key <= 3 * scale_factor + 10; key++) {
+    index_key.SetFromInteger(key);
+    batch.push_back(index_key);
+  }
+  std::shuffle(batch.begin(), batch.end(), std::mt19937(42));
+  size_t num_found = 0;
+  for (const auto &key : batch) {
+    num_found += key.ToString() % 3 == 0 && key.ToString() > 0 && key.ToString() <= 3 * scale_factor ? 1 : 0;
+  }
+  EXPECT_EQ(num_found, tree.GetValuesInterleaved(batch, &results, transaction));
+  ASSERT_EQ(batch.size(), results.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    std::vector<RID> rids;
+    tree.GetValue(batch[i], &rids);
+    EXPECT_EQ(rids, results[i]) << batch[i].ToString();
+  }
+  batch.clear();
+  EXPECT_EQ(0, tree.GetValuesInterleaved(batch, &results, transaction));
+  EXPECT_TRUE(results.empty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, DISABLED_BatchLookupPerformanceTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(1000, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  const int64_t scale_factor = 1000000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries(scale_factor);
+  for (int64_t key = 0; key < scale_factor; key++) {
+    entries[key].first.SetFromInteger(key);
+    entries[key].second = RID(0, static_cast<uint32_t>(key));
+  }
+  tree.BulkLoad(entries.cbegin(), entries.cend());
+  // sorted probes, as from the outer side of a join on a correlated key, a few of them per leaf page
+  std::vector<GenericKey<8>> batch;
+  for (int64_t key = 0; key < scale_factor; key += 50) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    batch.push_back(index_key);
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<RID> rids;
+  for (const auto &key : batch) {
+    tree.GetValue(key, &rids);
+  }
+  const double single_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  std::vector<std::vector<RID>> results;
+  tree.GetValues(batch, &results);
+  const double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  LOG_INFO("keys=%zu GetValue=%.2fms GetValues=%.2fms (%zu and %zu found)", batch.size(), single_ms, batch_ms,
+           rids.size(), results.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, SuffixTruncationTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema);
+
+  // Scenario: the separator keeps only as many columns as it takes to tell the keys apart.
+  Schema *pair_schema = ParseCreateStatement("a bigint,b bigint");
+  GenericComparator<64> pair_comparator(pair_schema);
+  GenericKey<64> left_key;
+  GenericKey<64> right_key;
+  const int64_t left_columns[2] = {1, 0x7fff};
+  const int64_t right_columns[2] = {2, 0x7fff};
+  left_key.SetFromInteger(0);
+  memcpy(left_key.data_, left_columns, sizeof(left_columns));
+  right_key.SetFromInteger(0);
+  memcpy(right_key.data_, right_columns, sizeof(right_columns));
+  GenericKey<64> separator = pair_comparator.ShortestSeparator(left_key, right_key);
+  EXPECT_EQ(pair_comparator(left_key, separator), -1);
+  EXPECT_EQ(pair_comparator(separator, right_key), -1);
+  EXPECT_EQ((BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>::StoredKeySize(separator)), 1);
+  delete pair_schema;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree with the default page sizes
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+
+  const int64_t scale_factor = 10000;
+  GenericKey<64> index_key;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)), transaction));
+  }
+
+  // Scenario: the root takes all of the hundreds of leaves, which full length 64 byte keys would not fit.
+  page_id_t root_page_id;
+  ASSERT_TRUE(static_cast<HeaderPage *>(header_page)->GetRootId("foo_pk", &root_page_id));
+  auto root = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(root_page_id)->GetData());
+  ASSERT_FALSE(root->IsLeafPage());
+  EXPECT_GT(root->GetSize(), (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(GenericKey<64>) + sizeof(page_id_t)));
+  auto internal_root =
+      reinterpret_cast<BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>> *>(root);
+  auto child = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(internal_root->ValueAt(0))->GetData());
+  EXPECT_TRUE(child->IsLeafPage());
+  bpm->UnpinPage(child->GetPageId(), false);
+  bpm->UnpinPage(root_page_id, false);
+
+  // Scenario: merging and redistributing with truncated separators keeps every key reachable.
+  for (int64_t key = 1; key <= scale_factor; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_EQ(key % 2 == 0, tree.GetValue(index_key, &rids));
+  }
+  int64_t current_key = 2;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 2;
+  }
+  EXPECT_EQ(current_key, scale_factor + 2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, WriteBufferTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+
+  {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+    tree.SetWriteBuffer(64);
+    std::vector<int64_t> keys;
+    for (int64_t key = 1; key <= 1000; key++) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+    std::set<int64_t> expected;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+      expected.insert(key);
+      // Scenario: a lookup finds the keys still in the buffer as well as those flushed down.
+      if (key % 97 == 0) {
+        for (int64_t probe = key - 5; probe <= key; probe++) {
+          rids.clear();
+          index_key.SetFromInteger(probe);
+          EXPECT_EQ(expected.count(probe) == 1, tree.GetValue(index_key, &rids)) << probe;
+        }
+      }
+    }
+
+    // Scenario: a duplicate is turned down whether its key is still in the buffer or already flushed to the leaves.
+    index_key.SetFromInteger(keys.back());
+    EXPECT_FALSE(tree.Insert(index_key, RID(1, 0)));
+    tree.FlushWriteBuffer();
+    index_key.SetFromInteger(keys.front());
+    EXPECT_FALSE(tree.Insert(index_key, RID(1, 0)));
+    tree.FlushWriteBuffer();
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(std::vector<RID>{RID(0, keys.front())}, rids);
+
+    // Scenario: removes are buffered too, and a key removed and inserted again has its new value.
+    for (int64_t key = 1; key <= 1000; key += 3) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+      expected.erase(key);
+    }
+    index_key.SetFromInteger(1);
+    EXPECT_TRUE(tree.Insert(index_key, RID(2, 1)));
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(std::vector<RID>{RID(2, 1)}, rids);
+    expected.insert(1);
+    std::vector<GenericKey<8>> batch(1000);
+    for (int64_t key = 1; key <= 1000; key++) {
+      batch[key - 1].SetFromInteger(key);
+    }
+    std::vector<std::vector<RID>> results;
+    EXPECT_EQ(expected.size(), tree.GetValues(batch, &results));
+
+    // Scenario: an iterator sees the buffered messages, flushed first.
+    std::vector<int64_t> scanned;
+    for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+      scanned.push_back((*iterator).first.ToString());
+    }
+    EXPECT_EQ(std::vector<int64_t>(expected.begin(), expected.end()), scanned);
+  }
+
+  {
+    // Scenario: without unique keys, the values of a key are added and removed one by one.
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_idx", bpm, comparator, 8, 8, false);
+    tree.SetWriteBuffer(16);
+    for (int64_t key = 0; key < 100; key++) {
+      for (int64_t value = 0; value < 3; value++) {
+        index_key.SetFromInteger(key % 10);
+        tree.Insert(index_key, RID(value, key));
+      }
+    }
+    for (int64_t key = 0; key < 100; key += 2) {
+      index_key.SetFromInteger(key % 10);
+      tree.Remove(index_key, RID(1, key));
+    }
+    for (int64_t key = 0; key < 10; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, &rids));
+      EXPECT_EQ(key % 2 == 0 ? 20 : 30, rids.size()) << key;
+    }
+    // Scenario: turning the buffer off flushes it.
+    tree.SetWriteBuffer(0);
+    for (int64_t key = 0; key < 10; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, &rids));
+      EXPECT_EQ(key % 2 == 0 ? 20 : 30, rids.size()) << key;
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, AdaptiveHashIndexTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  MetricsRegistry *registry = MetricsRegistry::Global();
+
+  {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 16, 16);
+    tree.SetAdaptiveHashIndex(256);
+    for (int64_t key = 0; key < 2000; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+    auto lookup = [&](int64_t key) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      return tree.GetValue(index_key, &rids);
+    };
+
+    // Scenario: keys looked up again and again go straight to their leaf page once they have an entry.
+    const uint64_t hits = registry->GetCounter("b_plus_tree.adaptive_hash_hits");
+    for (int round = 0; round < 10; round++) {
+      for (int64_t key = 100; key < 120; key += 2) {
+        ASSERT_TRUE(lookup(key)) << key;
+        ASSERT_EQ(std::vector<RID>{RID(0, key)}, rids);
+      }
+    }
+    EXPECT_GE(registry->GetCounter("b_plus_tree.adaptive_hash_hits") - hits, 10 * (10 - ADAPTIVE_HASH_THRESHOLD));
+    EXPECT_FALSE(lookup(101));
+
+    // Scenario: inserts, removes and splits of the leaf pages of the entries make lookups search the tree again.
+    for (int64_t key = 101; key < 120; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(1, key));
+    }
+    index_key.SetFromInteger(110);
+    tree.Remove(index_key);
+    for (int64_t key = 100; key < 120; key++) {
+      ASSERT_EQ(key != 110, lookup(key)) << key;
+      if (key != 110) {
+        ASSERT_EQ(std::vector<RID>{RID(key % 2, key)}, rids);
+      }
+    }
+
+    // Scenario: merges delete leaf pages, and the entries of keys that moved to another page are not trusted.
+    for (int round = 0; round < 5; round++) {
+      for (int64_t key = 1000; key < 1100; key += 2) {
+        ASSERT_TRUE(lookup(key));
+      }
+    }
+    for (int64_t key = 0; key < 2000; key += 2) {
+      if (key < 1000 || key >= 1100) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key);
+      }
+    }
+    for (int64_t key = 1000; key < 1100; key++) {
+      ASSERT_EQ(key % 2 == 0, lookup(key)) << key;
+      if (key % 2 == 0) {
+        ASSERT_EQ(std::vector<RID>{RID(0, key)}, rids);
+      }
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
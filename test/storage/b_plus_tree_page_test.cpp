@@ -0,0 +1,115 @@
+/**
+ * b_plus_tree_page_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "common/logger.h"
+#include "gtest/gtest.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+
+namespace bustub {
+
+namespace {
+
+using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+const int PAGE_ENTRIES = 250;
+
+/** Fills the pages with the keys 0, 4, 8, ..., which sort the same as bigints and as doubles. */
+void FillPages(LeafPage *leaf, InternalPage *internal, const GenericComparator<8> &comparator, bool as_double) {
+  leaf->Init(1, INVALID_PAGE_ID, PAGE_ENTRIES + 1);
+  internal->Init(2, INVALID_PAGE_ID, PAGE_ENTRIES);
+  for (int i = 0; i < PAGE_ENTRIES; i++) {
+    GenericKey<8> key;
+    if (as_double) {
+      const double value = 4 * i;
+      key.SetFromInteger(0);
+      memcpy(key.data_, &value, sizeof(value));
+    } else {
+      key.SetFromInteger(4 * i);
+    }
+    leaf->Insert(key, RID(i), comparator);
+    internal->Append(key, i);
+  }
+}
+
+GenericKey<8> ProbeKey(int64_t value, bool as_double) {
+  GenericKey<8> key;
+  key.SetFromInteger(value);
+  if (as_double) {
+    const auto double_value = static_cast<double>(value);
+    memcpy(key.data_, &double_value, sizeof(double_value));
+  }
+  return key;
+}
+
+}  // namespace
+
+TEST(BPlusTreePageTest, SearchTest) {
+  std::vector<char> leaf_data(PAGE_SIZE);
+  std::vector<char> internal_data(PAGE_SIZE);
+  auto leaf = reinterpret_cast<LeafPage *>(leaf_data.data());
+  auto internal = reinterpret_cast<InternalPage *>(internal_data.data());
+  // Scenario: the branchless search of integer keys and the binary search of other keys find the same entries.
+  for (const char *statement : {"a bigint", "a double"}) {
+    Schema *key_schema = ParseCreateStatement(statement);
+    GenericComparator<8> comparator(key_schema);
+    const bool as_double = !comparator.ComparesIntegers();
+    FillPages(leaf, internal, comparator, as_double);
+    for (int64_t value = -1; value <= 4 * PAGE_ENTRIES; value++) {
+      const GenericKey<8> key = ProbeKey(value, as_double);
+      const int index = std::clamp(static_cast<int>((value + 3) / 4), 0, PAGE_ENTRIES);
+      EXPECT_EQ(index, leaf->KeyIndex(key, comparator)) << statement << " " << value;
+      const int child = std::clamp(static_cast<int>(value / 4), 0, PAGE_ENTRIES - 1);
+      EXPECT_EQ(child, internal->Lookup(key, comparator)) << statement << " " << value;
+    }
+    delete key_schema;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreePageTest, DISABLED_SearchPerformanceTest) {
+  std::vector<char> leaf_data(PAGE_SIZE);
+  std::vector<char> internal_data(PAGE_SIZE);
+  auto leaf = reinterpret_cast<LeafPage *>(leaf_data.data());
+  auto internal = reinterpret_cast<InternalPage *>(internal_data.data());
+  const int num_probes = 1000000;
+  for (const char *statement : {"a bigint", "a double"}) {
+    Schema *key_schema = ParseCreateStatement(statement);
+    GenericComparator<8> comparator(key_schema);
+    const bool as_double = !comparator.ComparesIntegers();
+    FillPages(leaf, internal, comparator, as_double);
+    std::mt19937 generator(15445);
+    std::uniform_int_distribution<int64_t> distribution(0, 4 * PAGE_ENTRIES);
+    std::vector<GenericKey<8>> probes;
+    for (int i = 0; i < num_probes; i++) {
+      probes.push_back(ProbeKey(distribution(generator), as_double));
+    }
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &probe : probes) {
+      checksum += leaf->KeyIndex(probe, comparator);
+    }
+    const double leaf_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / num_probes;
+    start = std::chrono::steady_clock::now();
+    for (const auto &probe : probes) {
+      checksum += internal->Lookup(probe, comparator);
+    }
+    const double internal_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / num_probes;
+    LOG_INFO("%s entries=%d leaf=%.1fns/search internal=%.1fns/search (%s, checksum %ld)", statement, PAGE_ENTRIES,
+             leaf_ns, internal_ns, as_double ? "binary" : "branchless", checksum);
+    delete key_schema;
+  }
+}
+
+}  // namespace bustub
@@ -10,7 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,12 +32,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.fsm");
   };
 };
 
@@ -72,7 +84,612 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LogSegmentTest) {
+  const int64_t segment_size = 4096;
+  std::vector<char> data(12000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i % 251);
+  }
+  std::vector<char> buf(4000);
+  auto file_exists = [](const std::string &file_name) { return std::ifstream(file_name).good(); };
+
+  // Scenario: the writes, synced and asynchronous, and the reads run across the ends of the segments.
+  auto *dm = new DiskManager("test.db", DiskBackendType::POSIX, false, false, segment_size);
+  char page[PAGE_SIZE] = {0};
+  // A db file left empty is new when reopened, and its master record with it.
+  dm->WritePage(0, page);
+  for (int i = 0; i < 3; i++) {
+    dm->WriteLog(data.data() + i * 3000, 3000);
+  }
+  auto backend = dm->CreateLogBackend();
+  bool written = false;
+  dm->WriteLogAsync(backend.get(), data.data() + 9000, 3000, [&](bool ok) { written = ok; });
+  backend->Wait();
+  EXPECT_TRUE(written);
+  EXPECT_EQ(12000, dm->GetLogSize());
+  ASSERT_TRUE(dm->ReadLog(buf.data(), 4000, 2000));
+  EXPECT_EQ(0, std::memcmp(buf.data(), data.data() + 2000, 4000));
+  ASSERT_TRUE(dm->ReadLog(buf.data(), 4000, 10000));
+  EXPECT_EQ(0, std::memcmp(buf.data(), data.data() + 10000, 2000));
+  EXPECT_EQ(0, buf[2000]);
+  EXPECT_FALSE(dm->ReadLog(buf.data(), 4000, 12000));
+  EXPECT_TRUE(file_exists("test.log.3"));
+
+  // Scenario: the segments before the truncation point are gone, the first one recycled as a spare past the end,
+  // the next one removed since there are spares enough.
+  dm->TruncateLog(8500);
+  EXPECT_EQ(8192, dm->GetLogStart());
+  EXPECT_FALSE(dm->ReadLog(buf.data(), 4000, 0));
+  EXPECT_FALSE(file_exists("test.log"));
+  EXPECT_FALSE(file_exists("test.log.1"));
+  EXPECT_TRUE(file_exists("test.log.4"));
+  backend.reset();
+  delete dm;
+
+  // Scenario: reopened, the log starts and ends where it did.
+  dm = new DiskManager("test.db", DiskBackendType::POSIX, false, false, segment_size);
+  EXPECT_EQ(8192, dm->GetLogStart());
+  EXPECT_EQ(12000, dm->GetLogSize());
+  ASSERT_TRUE(dm->ReadLog(buf.data(), 3808, 8192));
+  EXPECT_EQ(0, std::memcmp(buf.data(), data.data() + 8192, 3808));
+  delete dm;
+  for (int segment = 1; segment <= 4; segment++) {
+    remove(("test.log." + std::to_string(segment)).c_str());
+  }
+  remove("test.mst");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 50;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: every thread writes and reads back its own pages, interleaved with all the others.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, 'a' + tid, sizeof(data));
+        snprintf(data, sizeof(data), "page %d", page_id);
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  {
+    auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true);
+    dm.ReadPage(3, buf);  // nothing recorded, nothing to verify
+    dm.WritePage(0, data);
+    dm.WritePage(1, data);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+
+  // Scenario: tear page 1 behind the disk manager's back, as a crash in the middle of a write would.
+  {
+    std::fstream db_io(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    db_io.seekp(PAGE_SIZE + PAGE_SIZE / 2);
+    db_io.write("torn", 4);
+  }
+
+  // Scenario: the checksums survive a restart, and only the torn page fails verification.
+  auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_THROW(dm.ReadPage(1, buf), ChecksumException);
+  EXPECT_EQ(1, dm.GetNumChecksumFailures());
+  EXPECT_FALSE(dm.VerifyPageChecksum(1, buf));
+  EXPECT_EQ(2, dm.GetNumChecksumFailures());
+
+  // Scenario: rewriting the page records a new checksum.
+  dm.WritePage(1, data);
+  dm.ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CoalescedWriteTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(8, std::vector<char>(PAGE_SIZE));
+  for (size_t i = 0; i < data.size(); i++) {
+    std::snprintf(data[i].data(), PAGE_SIZE, "Page %zu.", i);
+  }
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true);
+
+  // Scenario: pages given out of order are written in order, adjacent ones with one call: 3-5, 7, then 9-10.
+  dm.WritePages({{9, data[0].data()},
+                 {4, data[1].data()},
+                 {7, data[2].data()},
+                 {3, data[3].data()},
+                 {10, data[4].data()},
+                 {5, data[5].data()}});
+  EXPECT_EQ(6, dm.GetNumWrites());
+  EXPECT_EQ(3, dm.GetNumWriteCalls());
+  const std::vector<std::pair<page_id_t, size_t>> expected{{9, 0}, {4, 1}, {7, 2}, {3, 3}, {10, 4}, {5, 5}};
+  for (const auto &[page_id, i] : expected) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data[i].data(), PAGE_SIZE), 0);
+  }
+
+  // Scenario: of a page given twice, the last copy wins, and a run longer than MAX_COALESCED_WRITE is split.
+  dm.WritePages({{4, data[6].data()}, {4, data[7].data()}});
+  dm.ReadPage(4, buf);
+  EXPECT_EQ(std::memcmp(buf, data[7].data(), PAGE_SIZE), 0);
+  std::vector<std::pair<page_id_t, const char *>> run;
+  for (size_t i = 0; i < MAX_COALESCED_WRITE + 1; i++) {
+    run.emplace_back(static_cast<page_id_t>(20 + i), data[i % data.size()].data());
+  }
+  const int num_calls = dm.GetNumWriteCalls();
+  dm.WritePages(run);
+  EXPECT_EQ(num_calls + 2, dm.GetNumWriteCalls());
+  for (const auto &[page_id, page_data] : run) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, page_data, PAGE_SIZE), 0);
+  }
+  EXPECT_EQ(0, dm.GetNumChecksumFailures());
+
+  dm.ShutDown();
+  remove("test.mst");
+}
+
+TEST_F(DiskManagerTest, DoubleWriteTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(3, std::vector<char>(PAGE_SIZE));
+  for (size_t i = 0; i < data.size(); i++) {
+    std::snprintf(data[i].data(), PAGE_SIZE, "Page %zu.", i);
+  }
+  std::string db_file("test.db");
+  auto tear = [](const std::string &file_name, int64_t offset) {
+    std::fstream io(file_name, std::ios::binary | std::ios::in | std::ios::out);
+    io.seekp(offset);
+    io.write("torn", 4);
+  };
+
+  {
+    auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true, LOG_SEGMENT_SIZE, true);
+    EXPECT_EQ(0, dm.GetNumRepairedPages());
+    dm.WritePages({{0, data[0].data()}, {1, data[1].data()}, {2, data[2].data()}});
+    dm.ShutDown();
+  }
+
+  // Scenario: a crash tears page 1 while the batch is written in place; the copy of the batch repairs it. Page 0 made
+  // it to disk but not its checksum, which the copy records again.
+  tear(db_file, PAGE_SIZE + PAGE_SIZE / 2);
+  tear("test.crc", 0);
+  {
+    auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true, LOG_SEGMENT_SIZE, true);
+    EXPECT_EQ(1, dm.GetNumRepairedPages());
+    for (page_id_t page_id = 0; page_id < 3; page_id++) {
+      dm.ReadPage(page_id, buf);
+      EXPECT_EQ(std::memcmp(buf, data[page_id].data(), PAGE_SIZE), 0);
+    }
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.WritePage(2, data[0].data());
+    dm.ShutDown();
+  }
+
+  // Scenario: the copy of the last batch is torn itself, and ignored, while page 0 of an older batch is torn behind
+  // the disk manager's back.
+  tear(db_file, PAGE_SIZE / 2);
+  tear("test.dwb", PAGE_SIZE + PAGE_SIZE / 2);
+  auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true, LOG_SEGMENT_SIZE, true);
+  EXPECT_EQ(0, dm.GetNumRepairedPages());
+  EXPECT_THROW(dm.ReadPage(0, buf), ChecksumException);
+  dm.ReadPage(2, buf);
+  EXPECT_EQ(std::memcmp(buf, data[0].data(), PAGE_SIZE), 0);
+  dm.ShutDown();
+  remove("test.dwb");
+  remove("test.mst");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageReuseTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t i = 0; i < 100; i++) {
+      EXPECT_EQ(i, dm.AllocatePage());
+      dm.WritePage(i, data);
+    }
+
+    // Scenario: freed pages are reused before the file grows, in page order unless there is a hint.
+    dm.DeallocatePage(70);
+    dm.DeallocatePage(3);
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(7);
+    EXPECT_EQ(4, dm.GetNumFreePages());
+    EXPECT_EQ(3, dm.AllocatePage());
+    EXPECT_EQ(7, dm.AllocatePage(6));
+    EXPECT_EQ(70, dm.AllocatePage(8));
+    EXPECT_EQ(1, dm.GetNumFreePages());
+    dm.ShutDown();
+  }
+
+  // Scenario: the free space map survives a restart.
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(1, dm.GetNumFreePages());
+    EXPECT_EQ(5, dm.AllocatePage(90));
+    EXPECT_EQ(0, dm.GetNumFreePages());
+    dm.DeallocatePage(42);
+    dm.ShutDown();
+  }
+
+  // Scenario: a free space map left over from an older db file is discarded.
+  remove("test.db");
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(0, dm.GetNumFreePages());
+  EXPECT_EQ(0, dm.AllocatePage());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ExtentAllocationTest) {
+  const std::string db_file = "test.db";
+  page_id_t table_a;
+  page_id_t table_b;
+  {
+    auto dm = DiskManager(db_file);
+    table_a = dm.AllocatePage();
+    table_b = dm.AllocatePage();
+    EXPECT_EQ(0, table_a);
+    EXPECT_EQ(1, table_b);
+
+    // Scenario: two objects growing at the same time get pages from separate, aligned extents.
+    for (page_id_t i = 0; i < static_cast<page_id_t>(EXTENT_SIZE); i++) {
+      EXPECT_EQ(EXTENT_SIZE + i, dm.AllocatePage(INVALID_PAGE_ID, table_a));
+      EXPECT_EQ(2 * EXTENT_SIZE + i, dm.AllocatePage(INVALID_PAGE_ID, table_b));
+    }
+    // The pages skipped to align the first extent are still there for everyone else.
+    EXPECT_EQ(EXTENT_SIZE - 2, dm.GetNumFreePages());
+    EXPECT_EQ(2, dm.AllocatePage());
+
+    // Scenario: a full extent is followed by a new one.
+    EXPECT_EQ(3 * EXTENT_SIZE, dm.AllocatePage(INVALID_PAGE_ID, table_a));
+    EXPECT_EQ((std::vector<page_id_t>{EXTENT_SIZE, 3 * EXTENT_SIZE}), dm.GetExtents(table_a));
+    EXPECT_EQ(std::vector<page_id_t>{2 * EXTENT_SIZE}, dm.GetExtents(table_b));
+
+    // Scenario: dropping an object whose extents were freed lets the next one take over a whole extent.
+    for (page_id_t i = 0; i < static_cast<page_id_t>(EXTENT_SIZE); i++) {
+      dm.DeallocatePage(2 * EXTENT_SIZE + i);
+    }
+    dm.ReleaseExtents(table_b);
+    EXPECT_TRUE(dm.GetExtents(table_b).empty());
+    EXPECT_EQ(2 * EXTENT_SIZE, dm.AllocatePage(INVALID_PAGE_ID, table_b));
+
+    EXPECT_EQ(EXTENT_SIZE - 3, dm.GetNumFreePages());
+    char data[PAGE_SIZE] = {0};
+    dm.WritePage(table_a, data);
+    dm.ShutDown();
+  }
+
+  // Scenario: shutting down gave the unused tails of both extents back.
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(EXTENT_SIZE - 3 + 2 * (EXTENT_SIZE - 1), dm.GetNumFreePages());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PreallocationTest) {
+  const std::string db_file = "test.db";
+  char data[PAGE_SIZE] = {0};
+  {
+    auto dm = DiskManager(db_file);
+    for (int i = 0; i < 3; i++) {
+      dm.WritePage(dm.AllocatePage(), data);
+    }
+
+    // Scenario: the blocks of the pages the file grows by are allocated ahead, past its end, which stays put.
+    struct stat file_stat;
+    ASSERT_EQ(0, stat(db_file.c_str(), &file_stat));
+    EXPECT_EQ(3 * PAGE_SIZE, file_stat.st_size);
+    EXPECT_GE(file_stat.st_blocks * 512, static_cast<off_t>(PREALLOCATE_SIZE * PAGE_SIZE));
+    dm.ShutDown();
+  }
+
+  // Scenario: reopened, the file holds the pages written, not those preallocated, and grows on from them.
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(3, dm.AllocatePage());
+  const page_id_t extent_page_id = dm.AllocatePage(INVALID_PAGE_ID, 0);
+  EXPECT_EQ(EXTENT_SIZE, extent_page_id);
+  dm.WritePage(extent_page_id, data);
+  struct stat file_stat;
+  ASSERT_EQ(0, stat(db_file.c_str(), &file_stat));
+  EXPECT_EQ((EXTENT_SIZE + 1) * PAGE_SIZE, file_stat.st_size);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DiskBackendTest) {
+  const int num_pages = 100;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  for (auto type : {DiskBackendType::POSIX, DiskBackendType::IO_URING}) {
+    for (bool direct_io : {false, true}) {
+      auto backend = DiskBackend::Create(type, db_file, direct_io);
+      ASSERT_NE(nullptr, backend);
+
+      // Scenario: write a batch of pages from deliberately misaligned buffers, larger than the io_uring is deep.
+      std::vector<char> data(num_pages * PAGE_SIZE + 1);
+      std::vector<DiskRequest> requests;
+      int num_written = 0;
+      for (int i = 0; i < num_pages; i++) {
+        char *page = data.data() + 1 + i * PAGE_SIZE;
+        snprintf(page, PAGE_SIZE, "page %d", i);
+        requests.emplace_back(DiskRequest::WritePage(i, page, [&](bool success) { num_written += success ? 1 : 0; }));
+      }
+      backend->Submit(&requests);
+      backend->Wait();
+      EXPECT_EQ(num_pages, num_written);
+
+      // Scenario: read them back in reverse order, plus one page past the end of the file.
+      std::vector<char> buf((num_pages + 1) * PAGE_SIZE + 1, 'x');
+      int num_read = 0;
+      for (int i = num_pages; i >= 0; i--) {
+        requests.emplace_back(DiskRequest::ReadPage(i, buf.data() + 1 + i * PAGE_SIZE,
+                                                    [&](bool success) { num_read += success ? 1 : 0; }));
+      }
+      backend->Submit(&requests);
+      backend->Wait();
+      EXPECT_EQ(num_pages + 1, num_read);
+      EXPECT_EQ(0, std::memcmp(data.data() + 1, buf.data() + 1, num_pages * PAGE_SIZE));
+      EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buf.data() + 1 + num_pages * PAGE_SIZE, PAGE_SIZE));
+
+      // Scenario: the disk manager sees what the backend wrote.
+      char page[PAGE_SIZE];
+      dm.ReadPage(num_pages / 2, page);
+      EXPECT_EQ(std::to_string(num_pages / 2), std::string(page).substr(5));
+    }
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MapFileTest) {
+  const int num_pages = 10;
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: an empty file is not mapped, and reads go on as before.
+  EXPECT_FALSE(dm.MapFile());
+  EXPECT_EQ(nullptr, dm.GetMappedPage(0));
+
+  for (int i = 0; i < num_pages; i++) {
+    std::memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    dm.WritePage(i, data);
+  }
+
+  // Scenario: once mapped, pages are read out of the mapping, also in place.
+  for (auto advice : {MapAdvice::SEQUENTIAL, MapAdvice::WILLNEED, MapAdvice::NORMAL}) {
+    auto mapped = DiskManager(db_file);
+    ASSERT_TRUE(mapped.MapFile(advice));
+    EXPECT_FALSE(mapped.MapFile(advice));
+    for (int i = 0; i < num_pages; i++) {
+      mapped.ReadPage(i, buf);
+      EXPECT_EQ("page " + std::to_string(i), std::string(buf));
+      ASSERT_NE(nullptr, mapped.GetMappedPage(i));
+      EXPECT_EQ(0, std::memcmp(buf, mapped.GetMappedPage(i), PAGE_SIZE));
+    }
+    EXPECT_EQ(nullptr, mapped.GetMappedPage(num_pages));
+    EXPECT_EQ(nullptr, mapped.GetMappedPage(INVALID_PAGE_ID));
+    mapped.ShutDown();
+    EXPECT_EQ(nullptr, mapped.GetMappedPage(0));
+  }
+
+  // Scenario: pages written after mapping are seen, in and past the mapping.
+  ASSERT_TRUE(dm.MapFile(MapAdvice::SEQUENTIAL));
+  std::memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "rewritten");
+  dm.WritePage(3, data);
+  dm.WritePage(num_pages, data);
+  dm.ReadPage(3, buf);
+  EXPECT_EQ("rewritten", std::string(buf));
+  EXPECT_EQ("rewritten", std::string(dm.GetMappedPage(3)));
+  EXPECT_EQ(nullptr, dm.GetMappedPage(num_pages));
+  dm.ReadPage(num_pages, buf);
+  EXPECT_EQ("rewritten", std::string(buf));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, TablespaceTest) {
+  const int num_pages = 200;
+  const std::vector<std::string> files{"test_ts0.dat", "test_ts1.dat"};
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  std::string db_file("test.db");
+  std::vector<page_id_t> page_ids;
+  page_id_t default_page_id;
+
+  {
+    auto dm = DiskManager(db_file);
+    const tablespace_id_t tablespace = dm.CreateTablespace("fast", files);
+    EXPECT_NE(DEFAULT_TABLESPACE, tablespace);
+    EXPECT_EQ(tablespace, dm.CreateTablespace("fast", files));
+    EXPECT_THROW(dm.CreateTablespace("fast", {"test_ts0.dat"}), Exception);
+    EXPECT_THROW(dm.CreateTablespace("slow", {"test_ts1.dat"}), Exception);
+    EXPECT_THROW(dm.CreateTablespace("slow", {db_file}), Exception);
+    EXPECT_FALSE(dm.MapFile());
+
+    // Scenario: an object created in the tablespace has its first page there, and all of its extents after it.
+    page_id_t owner;
+    {
+      DiskManager::TablespaceScope tablespace_scope(tablespace);
+      owner = dm.AllocatePage();
+    }
+    page_ids.push_back(owner);
+    for (int i = 1; i < num_pages; i++) {
+      page_ids.push_back(dm.AllocatePage(page_ids.back(), owner));
+    }
+    default_page_id = dm.AllocatePage();
+    EXPECT_EQ(DEFAULT_TABLESPACE, dm.GetPageTablespace(default_page_id));
+
+    // Scenario: the extents are striped across the files of the tablespace.
+    std::vector<int> pages_per_file(files.size(), 0);
+    for (auto page_id : page_ids) {
+      EXPECT_EQ(tablespace, dm.GetPageTablespace(page_id));
+      int64_t offset;
+      const std::string file = dm.GetPageFile(page_id, &offset);
+      const auto iter = std::find(files.begin(), files.end(), file);
+      ASSERT_NE(files.end(), iter);
+      pages_per_file[iter - files.begin()]++;
+      std::memset(data, 0, PAGE_SIZE);
+      snprintf(data, PAGE_SIZE, "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_GE(pages_per_file[0], static_cast<int>(EXTENT_SIZE));
+    EXPECT_GE(pages_per_file[1], static_cast<int>(EXTENT_SIZE));
+    dm.WritePages({{page_ids[0], data}, {default_page_id, data}});
+    dm.ReadPage(default_page_id, buf);
+    EXPECT_EQ(std::string(data), std::string(buf));
+    std::memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", page_ids[0]);
+    dm.WritePage(page_ids[0], data);
+
+    // Scenario: the backends find the pages in their files too.
+    auto backend = dm.CreateDiskBackend();
+    std::vector<DiskRequest> requests;
+    std::vector<std::vector<char>> pages(page_ids.size(), std::vector<char>(PAGE_SIZE));
+    int num_read = 0;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      requests.emplace_back(
+          DiskRequest::ReadPage(page_ids[i], pages[i].data(), [&](bool success) { num_read += success ? 1 : 0; }));
+    }
+    backend->Submit(&requests);
+    backend->Wait();
+    EXPECT_EQ(num_pages, num_read);
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i].data()));
+    }
+    dm.ShutDown();
+  }
+
+  // Scenario: reopened, the tablespace and the place of every page are found again.
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(dm.CreateTablespace("fast", files), dm.GetPageTablespace(page_ids[0]));
+  for (auto page_id : page_ids) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  const page_id_t page_id = dm.AllocatePage(page_ids.back(), page_ids[0]);
+  EXPECT_EQ(dm.GetPageTablespace(page_ids[0]), dm.GetPageTablespace(page_id));
+  EXPECT_EQ(page_ids.end(), std::find(page_ids.begin(), page_ids.end(), page_id));
+  const page_id_t new_default_page_id = dm.AllocatePage();
+  EXPECT_EQ(DEFAULT_TABLESPACE, dm.GetPageTablespace(new_default_page_id));
+  EXPECT_NE(default_page_id, new_default_page_id);
+  dm.ShutDown();
+
+  for (const auto &file : files) {
+    remove(file.c_str());
+  }
+  remove("test.tbs");
+  remove("test.tsm");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  // Pages of repeated text compress well, a page of noise does not.
+  auto fill = [](char *page, page_id_t page_id) {
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+      page[i] = static_cast<char>('a' + (i / 64 + page_id) % 26);
+    }
+  };
+  std::vector<char> noise(PAGE_SIZE);
+  uint32_t seed = 15445;
+  for (auto &c : noise) {
+    seed = seed * 1103515245 + 12345;
+    c = static_cast<char>(seed >> 16);
+  }
+
+  {
+    auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true, LOG_SEGMENT_SIZE, false, true);
+    EXPECT_FALSE(dm.MapFile());
+    EXPECT_EQ(nullptr, dm.CreateDiskBackend());
+    dm.ReadPage(5, buf);  // never written, reads as zeros
+    EXPECT_EQ(0, buf[0]);
+    char page[PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < 16; page_id++) {
+      fill(page, page_id);
+      dm.WritePage(page_id, page);
+    }
+    dm.WritePage(16, noise.data());
+    EXPECT_LT(dm.GetCompressedBytes(), 8 * PAGE_SIZE);
+
+    // Rewritten, a page moves to another slot and reads back its new contents.
+    fill(page, 100);
+    dm.WritePage(3, page);
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, std::memcmp(buf, page, PAGE_SIZE));
+
+    // Scenario: with compressed frames in memory, the pages read again are not read from disk.
+    dm.SetCompressedCacheSize(4 * PAGE_SIZE);
+    for (int round = 0; round < 2; round++) {
+      for (page_id_t page_id = 0; page_id < 4; page_id++) {
+        dm.ReadPage(page_id, buf);
+      }
+    }
+    EXPECT_GE(dm.GetNumCompressedCacheHits(), 4);
+    dm.ShutDown();
+  }
+
+  // Scenario: reopened, every page is found again through the page map.
+  auto dm = DiskManager(db_file, DiskBackendType::POSIX, false, true, LOG_SEGMENT_SIZE, false, true);
+  char page[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 16; page_id++) {
+    fill(page, page_id == 3 ? 100 : page_id);
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(0, std::memcmp(buf, page, PAGE_SIZE));
+  }
+  dm.ReadPage(16, buf);
+  EXPECT_EQ(0, std::memcmp(buf, noise.data(), PAGE_SIZE));
+  EXPECT_EQ(0, dm.GetNumChecksumFailures());
+  EXPECT_NE(16, dm.AllocatePage());
+  dm.ShutDown();
+
+  remove("test.cpf");
+  remove("test.cpm");
+}
+
 }  // namespace bustub
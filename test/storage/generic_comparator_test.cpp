@@ -0,0 +1,132 @@
+/**
+ * generic_comparator_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "common/logger.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Compares the keys column by column on their Values, the way the generic path does. */
+template <size_t KeySize>
+int CompareValues(Schema *key_schema, const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) {
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    Value lhs_value = lhs.ToValue(key_schema, i);
+    Value rhs_value = rhs.ToValue(key_schema, i);
+    if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/** @return keys with few distinct values per column, some of them negative and some of fixed size NULL */
+template <size_t KeySize>
+std::vector<GenericKey<KeySize>> RandomKeys(Schema *key_schema, size_t num_keys, std::mt19937 *generator) {
+  std::uniform_int_distribution<int> distribution(-3, 3);
+  std::vector<GenericKey<KeySize>> keys(num_keys);
+  for (auto &key : keys) {
+    std::vector<Value> values;
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      const TypeId type = key_schema->GetColumn(i).GetType();
+      const int value = distribution(*generator);
+      if (value == -3 && type != TypeId::VARCHAR) {
+        values.push_back(ValueFactory::GetNullValueByType(type));
+      } else if (type == TypeId::TINYINT) {
+        values.push_back(ValueFactory::GetTinyIntValue(static_cast<int8_t>(value)));
+      } else if (type == TypeId::SMALLINT) {
+        values.push_back(ValueFactory::GetSmallIntValue(static_cast<int16_t>(value)));
+      } else if (type == TypeId::INTEGER) {
+        values.push_back(ValueFactory::GetIntegerValue(value));
+      } else if (type == TypeId::BIGINT) {
+        values.push_back(ValueFactory::GetBigIntValue(value));
+      } else if (type == TypeId::VARCHAR) {
+        // Strings that are prefixes of one another, and one with a zero byte; a tuple can't hold a NULL VARCHAR.
+        values.push_back(ValueFactory::GetVarcharValue(
+            value == 3 ? std::string("a\0b", 3) : std::string(value + 3, static_cast<char>('a' + (value & 1)))));
+      } else {
+        values.push_back(ValueFactory::GetDecimalValue(value));
+      }
+    }
+    key.SetFromKey(Tuple(values, key_schema));
+  }
+  return keys;
+}
+
+}  // namespace
+
+TEST(GenericComparatorTest, IntegerColumnsTest) {
+  std::mt19937 generator(15445);
+  for (const char *statement : {"a bigint", "a tinyint,b smallint,c integer,d bigint", "a integer,b double"}) {
+    Schema *key_schema = ParseCreateStatement(statement);
+    GenericComparator<16> comparator(key_schema);
+    auto keys = RandomKeys<16>(key_schema, 200, &generator);
+    // Scenario: whichever path the schema picks, it orders the keys like their Values do.
+    for (const auto &lhs : keys) {
+      for (const auto &rhs : keys) {
+        ASSERT_EQ(CompareValues(key_schema, lhs, rhs), comparator(lhs, rhs)) << statement;
+      }
+    }
+    delete key_schema;
+  }
+}
+
+TEST(GenericComparatorTest, NormalizedKeysTest) {
+  std::mt19937 generator(15445);
+  for (const char *statement : {"a varchar(8)", "a integer,b varchar(8)", "a varchar(4),b double,c smallint"}) {
+    Schema *key_schema = ParseCreateStatement(statement);
+    GenericComparator<32> comparator(key_schema);
+    auto keys = RandomKeys<32>(key_schema, 200, &generator);
+    // Scenario: keys compared on their normalized bytes, or on their Values if they have a NULL, are ordered like
+    // their Values are.
+    for (const auto &lhs : keys) {
+      for (const auto &rhs : keys) {
+        ASSERT_EQ(CompareValues(key_schema, lhs, rhs), comparator(lhs, rhs)) << statement;
+      }
+    }
+    delete key_schema;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(GenericComparatorTest, DISABLED_PerformanceTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint,b integer");
+  GenericComparator<16> comparator(key_schema);
+  std::mt19937 generator(15445);
+  std::uniform_int_distribution<int64_t> distribution(0, 1000000);
+  std::vector<GenericKey<16>> keys(200000);
+  for (auto &key : keys) {
+    key.SetFromKey(Tuple({ValueFactory::GetBigIntValue(distribution(generator)),
+                          ValueFactory::GetIntegerValue(static_cast<int32_t>(distribution(generator)))},
+                         key_schema));
+  }
+  auto sort_ms = [&keys](auto less) {
+    auto sorted = keys;
+    const auto start = std::chrono::steady_clock::now();
+    std::sort(sorted.begin(), sorted.end(), less);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+  const double value_ms = sort_ms([key_schema](const GenericKey<16> &lhs, const GenericKey<16> &rhs) {
+    return CompareValues(key_schema, lhs, rhs) < 0;
+  });
+  const double integer_ms =
+      sort_ms([&comparator](const GenericKey<16> &lhs, const GenericKey<16> &rhs) { return comparator(lhs, rhs) < 0; });
+  LOG_INFO("keys=%zu values=%.2fms integers=%.2fms", keys.size(), value_ms, integer_ms);
+  delete key_schema;
+}
+
+}  // namespace bustub
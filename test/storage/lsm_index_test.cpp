@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_index_test.cpp
+//
+// Identification: test/storage/lsm_index_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/thread_pool.h"
+#include "gtest/gtest.h"
+#include "storage/index/lsm_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LSMIndexTest, FlushAndMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  auto key_of = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, &schema); };
+  const int64_t num_keys = 20000;
+
+  {
+    LSMIndex index(new IndexMetadata("index", "table", &schema, {0}, false), bpm, nullptr, 256);
+    std::vector<int64_t> keys;
+    for (int64_t key = 0; key < num_keys; key++) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    for (int64_t key : keys) {
+      index.InsertEntry(key_of(key), RID(0, key), nullptr);
+    }
+
+    // Scenario: the memtables were flushed and merged down, leaving fewer runs in level 0 than merge it.
+    std::vector<size_t> num_runs = index.GetNumRuns();
+    ASSERT_GE(num_runs.size(), 3);
+    EXPECT_LT(num_runs[0], LSMIndex::LEVEL0_RUNS);
+    for (int64_t key = 0; key < num_keys; key++) {
+      std::vector<RID> rids;
+      index.ScanKey(key_of(key), &rids, nullptr);
+      ASSERT_EQ(std::vector<RID>{RID(0, key)}, rids) << key;
+    }
+    std::vector<RID> rids;
+    index.ScanKey(key_of(-1), &rids, nullptr);
+    EXPECT_TRUE(rids.empty());
+
+    // Scenario: a delete hides the entries of all the older runs, and a key holds several record ids.
+    for (int64_t key = 0; key < num_keys; key += 3) {
+      index.DeleteEntry(key_of(key), RID(0, key), nullptr);
+    }
+    for (int64_t key = 0; key < num_keys; key += 5) {
+      index.InsertEntry(key_of(key), RID(1, key), nullptr);
+    }
+    for (int64_t key = 0; key < num_keys; key++) {
+      std::vector<RID> expected;
+      if (key % 3 != 0) {
+        expected.emplace_back(0, key);
+      }
+      if (key % 5 == 0) {
+        expected.emplace_back(1, key);
+      }
+      rids.clear();
+      index.ScanKey(key_of(key), &rids, nullptr);
+      std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+      ASSERT_EQ(expected, rids) << key;
+    }
+  }
+
+  {
+    // Scenario: a unique key is inserted once, and can be inserted again once deleted.
+    LSMIndex index(new IndexMetadata("unique", "table", &schema, {0}), bpm, nullptr, 16);
+    for (int64_t key = 0; key < 100; key++) {
+      index.InsertEntry(key_of(key), RID(0, key), nullptr);
+    }
+    index.InsertEntry(key_of(7), RID(1, 7), nullptr);
+    std::vector<RID> rids;
+    index.ScanKey(key_of(7), &rids, nullptr);
+    EXPECT_EQ(std::vector<RID>{RID(0, 7)}, rids);
+    index.DeleteEntry(key_of(7), RID(0, 7), nullptr);
+    index.InsertEntry(key_of(7), RID(1, 7), nullptr);
+    rids.clear();
+    index.ScanKey(key_of(7), &rids, nullptr);
+    EXPECT_EQ(std::vector<RID>{RID(1, 7)}, rids);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(LSMIndexTest, BackgroundCompactionTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(64, disk_manager);
+  ThreadPool thread_pool(2);
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 32}}};
+  Schema key_schema{std::vector<Column>{Column{"b", TypeId::VARCHAR, 32}}};
+  auto key_of = [&](int64_t key) {
+    return Tuple({ValueFactory::GetVarcharValue("event-" + std::to_string(key))}, &key_schema);
+  };
+  const int64_t num_threads = 4;
+  const int64_t keys_per_thread = 5000;
+
+  {
+    LSMIndex index(new IndexMetadata("index", "table", &key_schema, {0}, false), bpm, &thread_pool, 128);
+
+    // Scenario: writers and readers run along with the flushes and merges, and see every key written before.
+    std::vector<std::thread> threads;
+    for (int64_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        for (int64_t i = 0; i < keys_per_thread; i++) {
+          const int64_t key = i * num_threads + t;
+          index.InsertEntry(key_of(key), RID(0, key), nullptr);
+          if (i % 16 == 0) {
+            std::vector<RID> rids;
+            index.ScanKey(key_of(key - 8 * num_threads < 0 ? key : key - 8 * num_threads), &rids, nullptr);
+            ASSERT_EQ(1, rids.size());
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    index.WaitForCompaction();
+    EXPECT_LT(index.GetNumRuns()[0], LSMIndex::LEVEL0_RUNS);
+    for (int64_t key = 0; key < num_threads * keys_per_thread; key++) {
+      std::vector<RID> rids;
+      index.ScanKey(key_of(key), &rids, nullptr);
+      ASSERT_EQ(std::vector<RID>{RID(0, key)}, rids) << key;
+    }
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
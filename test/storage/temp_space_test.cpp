@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// temp_space_test.cpp
+//
+// Identification: test/storage/temp_space_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/temp_space.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the number of files of a directory */
+size_t CountFiles(const std::string &directory) {
+  size_t num_files = 0;
+  DIR *dir = opendir(directory.c_str());
+  while (dirent *entry = readdir(dir)) {
+    num_files += std::string(entry->d_name) != "." && std::string(entry->d_name) != "..";
+  }
+  closedir(dir);
+  return num_files;
+}
+
+}  // namespace
+
+class TempSpaceTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override { mkdir(directory_.c_str(), 0755); }
+
+  // This function is called after every test.
+  void TearDown() override { rmdir(directory_.c_str()); }
+
+  const std::string directory_ = "temp_space_test";
+};
+
+// NOLINTNEXTLINE
+TEST_F(TempSpaceTest, BlockTest) {
+  TempSpace temp_space(directory_);
+  EXPECT_EQ(temp_space.GetNumBlocks(), 0);
+
+  // Blocks grow the file, then the freed ones are reused, the most recently freed first.
+  EXPECT_EQ(temp_space.AllocateBlock(), 0);
+  EXPECT_EQ(temp_space.AllocateBlock(), 1);
+  EXPECT_EQ(temp_space.AllocateBlock(), 2);
+  temp_space.FreeBlock(0);
+  temp_space.FreeBlock(2);
+  EXPECT_EQ(temp_space.GetNumAllocated(), 1);
+  EXPECT_EQ(temp_space.AllocateBlock(), 2);
+  EXPECT_EQ(temp_space.AllocateBlock(), 0);
+  EXPECT_EQ(temp_space.AllocateBlock(), 3);
+  EXPECT_EQ(temp_space.GetNumBlocks(), 4);
+
+  // Once every block is freed, the file starts over.
+  for (uint32_t block = 0; block < 4; block++) {
+    temp_space.FreeBlock(block);
+  }
+  EXPECT_EQ(temp_space.GetNumAllocated(), 0);
+  EXPECT_EQ(temp_space.GetNumBlocks(), 0);
+  EXPECT_EQ(temp_space.AllocateBlock(), 0);
+  temp_space.FreeBlock(0);
+
+  // The file was unlinked as soon as it was created.
+  EXPECT_EQ(CountFiles(directory_), 0);
+}
+
+// NOLINTNEXTLINE
+TEST_F(TempSpaceTest, ReadWriteTest) {
+  TempSpace temp_space(directory_);
+  std::vector<uint32_t> blocks;
+  std::vector<std::string> contents;
+  for (size_t i = 0; i < 16; i++) {
+    blocks.push_back(temp_space.AllocateBlock());
+    // Blocks are written in part, from a few bytes to the whole block.
+    contents.emplace_back(std::max<size_t>(1, i * TEMP_SPACE_BLOCK_SIZE / 15), static_cast<char>('a' + i));
+    temp_space.WriteBlock(blocks.back(), contents.back().data(), contents.back().size());
+  }
+
+  // Threads read back their own blocks at once.
+  std::vector<std::thread> threads;
+  std::vector<int> matches(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    threads.emplace_back([&, i] {
+      std::string data(contents[i].size(), '\0');
+      temp_space.ReadBlock(blocks[i], data.data(), data.size());
+      matches[i] = data == contents[i];
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < blocks.size(); i++) {
+    EXPECT_TRUE(matches[i]) << i;
+    temp_space.FreeBlock(blocks[i]);
+  }
+  EXPECT_EQ(temp_space.GetNumBlocks(), 0);
+}
+
+}  // namespace bustub
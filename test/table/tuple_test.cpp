@@ -11,16 +11,26 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "concurrency/transaction_manager.h"
+#include "concurrency/vacuum_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/table_heap.h"
+#include "storage/table/toast.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +81,1047 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TupleRefTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  // Few enough frames that a ref which kept its page pinned would soon run the pool out.
+  auto *buffer_pool_manager = new BufferPoolManager(4, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  std::vector<RID> rid_v;
+  for (int i = 0; i < 2000; ++i) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    rid_v.push_back(rid);
+  }
+  ASSERT_NE(rid_v.front().GetPageId(), rid_v.back().GetPageId());
+
+  // Scenario: refs read the tuples in place, one page pinned at a time, and copies outlive them.
+  TupleRef ref;
+  std::vector<Tuple> copies;
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_TRUE(table->GetTupleRef(rid_v[i], &ref, transaction)) << i;
+    ASSERT_EQ(ref->GetRid(), rid_v[i]);
+    ASSERT_EQ(ref->GetValue(&schema, 0).GetAs<int32_t>(), i);
+    if (i % 100 == 0) {
+      copies.push_back(ref.Copy());
+    }
+  }
+  TupleRef moved(std::move(ref));
+  EXPECT_FALSE(ref.IsValid());  // NOLINT
+  EXPECT_TRUE(moved.IsValid());
+  moved.Release();
+  EXPECT_FALSE(moved.IsValid());
+  for (size_t i = 0; i < copies.size(); ++i) {
+    EXPECT_EQ(copies[i].GetValue(&schema, 1).ToString(), "tuple " + std::to_string(i * 100));
+  }
+
+  // Scenario: a deleted tuple has no ref.
+  ASSERT_TRUE(table->MarkDelete(rid_v[0], transaction));
+  table->ApplyDelete(rid_v[0], transaction);
+  EXPECT_FALSE(table->GetTupleRef(rid_v[0], &ref, transaction));
+  EXPECT_FALSE(ref.IsValid());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, FreeSpaceMapTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                 &schema);
+  };
+
+  // Scenario: inserts fill the pages in chain order.
+  std::vector<RID> rid_v;
+  for (int i = 0; i < 2000; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, transaction));
+    rid_v.push_back(rid);
+  }
+  const page_id_t first_page_id = table->GetFirstPageId();
+  const page_id_t last_page_id = rid_v.back().GetPageId();
+  ASSERT_EQ(rid_v.front().GetPageId(), first_page_id);
+  ASSERT_NE(last_page_id, first_page_id);
+  std::vector<page_id_t> page_ids;
+  for (const RID &rid : rid_v) {
+    if (page_ids.empty() || page_ids.back() != rid.GetPageId()) {
+      page_ids.push_back(rid.GetPageId());
+    }
+  }
+  std::vector<page_id_t> chain;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    if (chain.empty() || chain.back() != iter->GetRid().GetPageId()) {
+      chain.push_back(iter->GetRid().GetPageId());
+    }
+  }
+  EXPECT_EQ(chain, page_ids);
+
+  // Scenario: the space deletes free on the first page is found again through the map.
+  size_t num_deleted = 0;
+  for (const RID &rid : rid_v) {
+    if (rid.GetPageId() == first_page_id) {
+      ASSERT_TRUE(table->MarkDelete(rid, transaction));
+      table->ApplyDelete(rid, transaction);
+      num_deleted++;
+    }
+  }
+  const page_id_t free_space_map_page_id = table->GetFreeSpaceMapPageId();
+  ASSERT_NE(free_space_map_page_id, INVALID_PAGE_ID);
+  delete table;
+  for (page_id_t map_page_id : {free_space_map_page_id, INVALID_PAGE_ID}) {
+    // Both when the map is opened and when it is rebuilt from the heap.
+    table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id, map_page_id);
+    for (size_t i = 0; i < num_deleted / 2; ++i) {
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(make_tuple(static_cast<int>(i)), &rid, transaction));
+      EXPECT_EQ(rid.GetPageId(), first_page_id) << i;
+    }
+    delete table;
+  }
+
+  // Scenario: once every page is full again, inserts append to the end of the chain.
+  table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id, free_space_map_page_id);
+  RID rid;
+  for (size_t i = 0; i < 200; ++i) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(static_cast<int>(i)), &rid, transaction));
+  }
+  EXPECT_NE(rid.GetPageId(), first_page_id);
+  EXPECT_NE(rid.GetPageId(), last_page_id);
+  size_t count = 0;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(count, rid_v.size() - num_deleted + num_deleted / 2 * 2 + 200);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ConcurrentInsertTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(64, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                 &schema);
+  };
+
+  // Scenario: threads inserting side by side, each into the pages of its partition and appending its own, lose no
+  // tuple and leave every page linked into the chain.
+  const int num_threads = 4;
+  const int num_tuples = 1000;
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      Transaction txn(t + 1);
+      for (int i = 0; i < num_tuples; i++) {
+        RID rid;
+        ASSERT_TRUE(table->InsertTuple(make_tuple(t * num_tuples + i), &rid, &txn));
+        rids[t].push_back(rid);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<RID> all_rids;
+  for (const auto &thread_rids : rids) {
+    all_rids.insert(all_rids.end(), thread_rids.begin(), thread_rids.end());
+  }
+  std::vector<bool> seen(num_threads * num_tuples, false);
+  size_t count = 0;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    const int value = iter->GetValue(&schema, 0).GetAs<int32_t>();
+    ASSERT_FALSE(seen[value]);
+    seen[value] = true;
+    EXPECT_EQ(iter->GetRid(), rids[value / num_tuples][value % num_tuples]);
+    count++;
+  }
+  EXPECT_EQ(count, all_rids.size());
+  std::vector<page_id_t> page_ids = table->GetPageIds();
+  for (const RID &rid : all_rids) {
+    EXPECT_NE(std::find(page_ids.begin(), page_ids.end(), rid.GetPageId()), page_ids.end());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, PageBatchIteratorTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto scan = [&](TableIterator iter) {
+    std::vector<std::pair<RID, int32_t>> tuples;
+    for (; iter != table->End(); ++iter) {
+      tuples.emplace_back(iter->GetRid(), iter->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    return tuples;
+  };
+
+  // Scenario: an empty table has no tuple in either mode.
+  EXPECT_TRUE(table->BeginPageBatch(transaction) == table->End());
+
+  // Scenario: the iterator yields the same tuples in the same order as the default one, past empty pages, with and
+  // without reading ahead, and through the links of the zone map.
+  std::vector<RID> rid_v;
+  for (int i = 0; i < 3000; ++i) {
+    RID rid;
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                &schema);
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    rid_v.push_back(rid);
+  }
+  for (const RID &rid : rid_v) {
+    // Empty the second page and thin out the others.
+    if (rid.GetPageId() == rid_v[1000].GetPageId() || rid.GetSlotNum() % 3 == 0) {
+      ASSERT_TRUE(table->MarkDelete(rid, transaction));
+      table->ApplyDelete(rid, transaction);
+    }
+  }
+  auto expected = scan(table->Begin(transaction));
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(scan(table->BeginPageBatch(transaction)), expected);
+  EXPECT_EQ(scan(table->BeginPageBatch(transaction, 0)), expected);
+  table->CreateZoneMap(&schema, {0}, transaction);
+  EXPECT_EQ(scan(table->BeginPageBatch(transaction, 4)), expected);
+
+  // Scenario: copies of an iterator go on from where it was.
+  auto iter = table->BeginPageBatch(transaction);
+  for (int i = 0; i < 500; i++) {
+    ++iter;
+  }
+  auto copy = iter++;
+  EXPECT_EQ(copy->GetRid(), expected[500].first);
+  EXPECT_EQ(iter->GetRid(), expected[501].first);
+  ++copy;
+  EXPECT_TRUE(copy == iter);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TablePageCompactionTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, PAGE_SIZE}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto make_tuple = [&schema](int i, size_t len) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(len, 'a' + i % 26))},
+                 &schema);
+  };
+  auto check_tuple = [&](const RID &rid, int i, size_t len) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(len, 'a' + i % 26));
+  };
+
+  // Fill the first page with tuples of 100 bytes of data.
+  std::vector<RID> rid_v;
+  const page_id_t first_page_id = table->GetFirstPageId();
+  for (int i = 0;; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, 100), &rid, transaction));
+    if (rid.GetPageId() != first_page_id) {
+      break;
+    }
+    rid_v.push_back(rid);
+  }
+  ASSERT_GT(rid_v.size(), 8);
+
+  // Scenario: deleting every other tuple leaves holes, and the others keep their RIDs.
+  for (size_t i = 0; i < rid_v.size(); i += 2) {
+    ASSERT_TRUE(table->MarkDelete(rid_v[i], transaction));
+    table->ApplyDelete(rid_v[i], transaction);
+  }
+  for (size_t i = 1; i < rid_v.size(); i += 2) {
+    check_tuple(rid_v[i], i, 100);
+  }
+
+  // Scenario: a tuple larger than any hole still goes to the first page, which is compacted for it, in a reused slot.
+  RID large_rid;
+  auto *first_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(first_page_id));
+  first_page->WLatch();
+  EXPECT_TRUE(first_page->InsertTuple(make_tuple(1000, 300), &large_rid, transaction, lock_manager, log_manager));
+  first_page->WUnlatch();
+  buffer_pool_manager->UnpinPage(first_page_id, true);
+  EXPECT_EQ(large_rid.GetPageId(), first_page_id);
+  EXPECT_EQ(large_rid.GetSlotNum(), 0);
+  check_tuple(large_rid, 1000, 300);
+  for (size_t i = 1; i < rid_v.size(); i += 2) {
+    check_tuple(rid_v[i], i, 100);
+  }
+
+  // Scenario: a tuple grows in place of the holes, and shrinks back.
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(1, 600), rid_v[1], transaction));
+  check_tuple(rid_v[1], 1, 600);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(1, 10), rid_v[1], transaction));
+  check_tuple(rid_v[1], 1, 10);
+  for (size_t i = 3; i < rid_v.size(); i += 2) {
+    check_tuple(rid_v[i], i, 100);
+  }
+  check_tuple(large_rid, 1000, 300);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, BulkInsertTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                 &schema);
+  };
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(-1), &rid, transaction));
+
+  // Scenario: a bulk insert fills fresh pages after the last one, in the order of the tuples.
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 1000; ++i) {
+    tuples.push_back(make_tuple(i));
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(table->BulkInsert(tuples, &rids, transaction));
+  ASSERT_EQ(rids.size(), tuples.size());
+  EXPECT_NE(rids.front().GetPageId(), rid.GetPageId());
+  EXPECT_EQ(rids.front().GetSlotNum(), 0);
+  EXPECT_NE(rids.front().GetPageId(), rids.back().GetPageId());
+  EXPECT_EQ(transaction->GetWriteSet()->size(), tuples.size() + 1);
+  int expected = -1;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    ASSERT_EQ(iter->GetValue(&schema, 0).GetAs<int32_t>(), expected);
+    if (expected >= 0) {
+      ASSERT_EQ(iter->GetRid(), rids[expected]);
+    }
+    expected++;
+  }
+  EXPECT_EQ(expected, 1000);
+
+  // Scenario: a row insert still finds room on the first page, and a too large tuple fails the whole batch.
+  ASSERT_TRUE(table->InsertTuple(make_tuple(-2), &rid, transaction));
+  EXPECT_EQ(rid.GetPageId(), table->GetFirstPageId());
+  Schema wide{std::vector<Column>{Column{"a", TypeId::VARCHAR, PAGE_SIZE}}};
+  std::vector<Tuple> too_large{Tuple({ValueFactory::GetVarcharValue(std::string(PAGE_SIZE, 'x'))}, &wide)};
+  rids.clear();
+  EXPECT_FALSE(table->BulkInsert(too_large, &rids, transaction));
+  EXPECT_TRUE(rids.empty());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ToastTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 3 * PAGE_SIZE},
+                                    Column{"c", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  std::string payload(10000, ' ');
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = static_cast<char>('a' + i % 26);
+  }
+  Tuple large({ValueFactory::GetIntegerValue(7), ValueFactory::GetVarcharValue(payload),
+               ValueFactory::GetVarcharValue("small")},
+              &schema);
+
+  // Scenario: a tuple larger than a page needs a schema to be stored.
+  RID rid;
+  EXPECT_FALSE(table->InsertTuple(large, &rid, transaction));
+  ASSERT_TRUE(table->InsertTuple(large, &rid, transaction, &schema));
+
+  // Scenario: the stored tuple keeps its small values inline and points to the large one.
+  Tuple stored;
+  ASSERT_TRUE(table->GetTuple(rid, &stored, transaction));
+  EXPECT_LT(stored.GetLength(), PAGE_SIZE);
+  EXPECT_FALSE(stored.IsToasted(&schema, 0));
+  EXPECT_TRUE(stored.IsToasted(&schema, 1));
+  EXPECT_FALSE(stored.IsToasted(&schema, 2));
+  EXPECT_EQ(stored.GetValue(&schema, 0).GetAs<int32_t>(), 7);
+  EXPECT_EQ(stored.GetValue(&schema, 2).ToString(), "small");
+  EXPECT_THROW(stored.GetValue(&schema, 1), Exception);
+  EXPECT_TRUE(Toast::HasToasted(stored, &schema, {1, 2}));
+  EXPECT_FALSE(Toast::HasToasted(stored, &schema, {2}));
+
+  // Scenario: detoasting reads the value back from its overflow pages.
+  Tuple detoasted = Toast::Detoast(buffer_pool_manager, stored, &schema);
+  EXPECT_EQ(detoasted.GetRid(), rid);
+  EXPECT_FALSE(detoasted.IsToasted(&schema, 1));
+  EXPECT_EQ(detoasted.GetValue(&schema, 0).GetAs<int32_t>(), 7);
+  EXPECT_EQ(detoasted.GetValue(&schema, 1).ToString(), payload);
+  EXPECT_EQ(detoasted.GetValue(&schema, 2).ToString(), "small");
+
+  // Scenario: a bulk insert toasts the tuples that need it, and stores the others as they are.
+  Tuple small({ValueFactory::GetIntegerValue(8), ValueFactory::GetVarcharValue("short"),
+               ValueFactory::GetVarcharValue("small")},
+              &schema);
+  std::vector<RID> rids;
+  ASSERT_TRUE(table->BulkInsert({small, large}, &rids, transaction, &schema));
+  ASSERT_EQ(rids.size(), 2);
+  ASSERT_TRUE(table->GetTuple(rids[0], &stored, transaction));
+  EXPECT_FALSE(stored.IsToasted(&schema, 1));
+  EXPECT_EQ(stored.GetValue(&schema, 1).ToString(), "short");
+  ASSERT_TRUE(table->GetTuple(rids[1], &stored, transaction));
+  EXPECT_TRUE(stored.IsToasted(&schema, 1));
+  EXPECT_EQ(Toast::Detoast(buffer_pool_manager, stored, &schema, {1}).GetValue(&schema, 1).ToString(), payload);
+
+  // Scenario: rolling an insert back frees the overflow pages of its tuple.
+  const size_t num_chain_pages = (payload.size() + OverflowPage::CAPACITY - 1) / OverflowPage::CAPACITY;
+  table->SetSchema(&schema);
+  Transaction aborted(1);
+  ASSERT_TRUE(table->InsertTuple(large, &rid, &aborted));
+  size_t num_free_pages = disk_manager->GetNumFreePages();
+  aborted.SetState(TransactionState::ABORTED);
+  table->ApplyDelete(rid, &aborted);
+  EXPECT_EQ(disk_manager->GetNumFreePages(), num_free_pages + num_chain_pages);
+
+  // Scenario: an update toasts a tuple larger than a page with the schema of the heap.
+  Transaction updater(2);
+  ASSERT_TRUE(table->UpdateTuple(large, rids[0], &updater));
+  ASSERT_TRUE(table->GetTuple(rids[0], &stored, &updater));
+  EXPECT_TRUE(stored.IsToasted(&schema, 1));
+  EXPECT_EQ(Toast::Detoast(buffer_pool_manager, stored, &schema).GetValue(&schema, 1).ToString(), payload);
+
+  // Scenario: the chains an update replaces are only freed once retired and read by no snapshot.
+  Tuple replaced = stored;
+  num_free_pages = disk_manager->GetNumFreePages();
+  ASSERT_TRUE(table->UpdateTuple(small, rids[0], &updater));
+  EXPECT_EQ(disk_manager->GetNumFreePages(), num_free_pages);
+  table->RetireReplaced(rids[0], replaced, &updater);
+  table->FreeRetiredChains(table->GetLastCommitTs() - 1);
+  EXPECT_EQ(disk_manager->GetNumFreePages(), num_free_pages);
+  table->FreeRetiredChains(table->GetLastCommitTs());
+  EXPECT_EQ(disk_manager->GetNumFreePages(), num_free_pages + num_chain_pages);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, PaxTableHeapTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 64},
+                                    Column{"c", TypeId::BIGINT}, Column{"d", TypeId::VARCHAR, 3 * PAGE_SIZE}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(32, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, &schema);
+  EXPECT_EQ(table->GetFormat(), TableFormat::PAX);
+  auto make_tuple = [&schema](int i, const std::string &d) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("tuple " + std::to_string(i)),
+                  ValueFactory::GetBigIntValue(i * 1000000000LL), ValueFactory::GetVarcharValue(d)},
+                 &schema);
+  };
+  auto check_tuple = [&schema](const Tuple &tuple, int i, const std::string &d) {
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), "tuple " + std::to_string(i));
+    ASSERT_EQ(tuple.GetValue(&schema, 2).GetAs<int64_t>(), i * 1000000000LL);
+    ASSERT_EQ(tuple.GetValue(&schema, 3).ToString(), d);
+  };
+
+  // Scenario: the tuples read back whole, across pages, in insert order.
+  std::vector<RID> rids;
+  for (int i = 0; i < 500; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, "d"), &rid, transaction, &schema));
+    rids.push_back(rid);
+  }
+  EXPECT_NE(rids.front().GetPageId(), rids.back().GetPageId());
+  int expected = 0;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    ASSERT_EQ(iter->GetRid(), rids[expected]);
+    check_tuple(*iter, expected, "d");
+    expected++;
+  }
+  EXPECT_EQ(expected, 500);
+
+  // Scenario: a read of some columns only fills those.
+  auto *page = static_cast<PaxPage *>(buffer_pool_manager->FetchPage(rids[7].GetPageId()));
+  page->RLatch();
+  std::vector<char> buffer;
+  Tuple partial;
+  ASSERT_TRUE(page->GetTupleColumns(rids[7], {2, 1}, &buffer, &partial, transaction, lock_manager));
+  page->RUnlatch();
+  buffer_pool_manager->UnpinPage(rids[7].GetPageId(), false);
+  EXPECT_EQ(partial.GetValue(&schema, 1).ToString(), "tuple 7");
+  EXPECT_EQ(partial.GetValue(&schema, 2).GetAs<int64_t>(), 7000000000LL);
+  EXPECT_TRUE(partial.GetValue(&schema, 3).IsNull());
+
+  // Scenario: deletes free their slots for later inserts, and updates may grow a tuple.
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+    table->ApplyDelete(rids[i], transaction);
+  }
+  Tuple tuple;
+  EXPECT_FALSE(table->GetTuple(rids[0], &tuple, transaction));
+  std::string grown(200, 'g');
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10, grown), rids[10], transaction));
+  ASSERT_TRUE(table->GetTuple(rids[10], &tuple, transaction));
+  check_tuple(tuple, 10, grown);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(11, ""), rids[11], transaction));
+  TupleRef ref;
+  ASSERT_TRUE(table->GetTupleRef(rids[11], &ref, transaction));
+  check_tuple(*ref, 11, "");
+  ref.Release();
+  auto *first_page = static_cast<PaxPage *>(buffer_pool_manager->FetchPage(rids[0].GetPageId()));
+  first_page->WLatch();
+  RID rid;
+  EXPECT_TRUE(first_page->InsertTuple(make_tuple(1000, "d"), &rid, transaction, lock_manager, log_manager));
+  first_page->WUnlatch();
+  buffer_pool_manager->UnpinPage(rids[0].GetPageId(), true);
+  EXPECT_EQ(rid, rids[0]);
+  for (int i = 12; i < 500; ++i) {
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, transaction));
+    check_tuple(tuple, i, "d");
+  }
+
+  // Scenario: bulk inserts fill fresh pages, and values too large for a page are still toasted.
+  std::string large(2 * PAGE_SIZE, 'l');
+  std::vector<Tuple> tuples{make_tuple(2000, large), make_tuple(2001, "d")};
+  std::vector<RID> bulk_rids;
+  ASSERT_TRUE(table->BulkInsert(tuples, &bulk_rids, transaction, &schema));
+  ASSERT_TRUE(table->GetTuple(bulk_rids[0], &tuple, transaction));
+  EXPECT_TRUE(tuple.IsToasted(&schema, 3));
+  check_tuple(Toast::Detoast(buffer_pool_manager, tuple, &schema), 2000, large);
+  ASSERT_TRUE(table->GetTuple(bulk_rids[1], &tuple, transaction));
+  check_tuple(tuple, 2001, "d");
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, CompressedPageTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 16},
+                                    Column{"c", TypeId::BIGINT}, Column{"d", TypeId::DECIMAL},
+                                    Column{"e", TypeId::VARCHAR, 32}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  const std::vector<std::string> colors{"red", "green", "blue"};
+  auto make_tuple = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(colors[i % 3]),
+                  ValueFactory::GetBigIntValue(i / 100), ValueFactory::GetDecimalValue(i * 0.5),
+                  ValueFactory::GetVarcharValue("value " + std::to_string(i))},
+                 &schema);
+  };
+  auto check_tuple = [&](const Tuple &tuple, int i) {
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), colors[i % 3]);
+    ASSERT_EQ(tuple.GetValue(&schema, 2).GetAs<int64_t>(), i / 100);
+    ASSERT_EQ(tuple.GetValue(&schema, 3).GetAs<double>(), i * 0.5);
+    ASSERT_EQ(tuple.GetValue(&schema, 4).ToString(), "value " + std::to_string(i));
+  };
+  auto count_pages = [&]() {
+    size_t pages = 0;
+    for (page_id_t page_id = table->GetFirstPageId(); page_id != INVALID_PAGE_ID; pages++) {
+      auto page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+      page_id_t next_page_id = page->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    return pages;
+  };
+  const int num_tuples = 3000;
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, transaction, &schema));
+  }
+  size_t pages_before = count_pages();
+
+  // Scenario: the cold pages compress into fewer pages, and all the tuples read back the same.
+  std::vector<std::pair<RID, RID>> moves;
+  table->CompressPages(&schema, transaction, &moves);
+  size_t pages_after = count_pages();
+  EXPECT_LT(pages_after * 2, pages_before);
+  EXPECT_GT(moves.size(), num_tuples / 2);
+  std::vector<bool> seen(num_tuples, false);
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    int i = iter->GetValue(&schema, 0).GetAs<int32_t>();
+    ASSERT_FALSE(seen[i]);
+    seen[i] = true;
+    check_tuple(*iter, i);
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true), num_tuples);
+  Tuple tuple;
+  for (const auto &[old_rid, new_rid] : moves) {
+    ASSERT_NE(old_rid.GetPageId(), new_rid.GetPageId());
+    ASSERT_TRUE(table->GetTuple(new_rid, &tuple, transaction));
+  }
+
+  // Scenario: the low-cardinality varchar is dictionary encoded, and compares by code; the other one is not.
+  RID rid = moves.front().second;
+  ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+  std::string color = tuple.GetValue(&schema, 1).ToString();
+  auto page = static_cast<CompressedPage *>(buffer_pool_manager->FetchPage(rid.GetPageId()));
+  ASSERT_TRUE(CompressedPage::IsCompressed(page->GetData()));
+  uint32_t code;
+  ASSERT_TRUE(page->FindCode(1, ValueFactory::GetVarcharValue(color), &code));
+  EXPECT_EQ(page->GetCode(rid.GetSlotNum(), 1), code);
+  uint32_t missing_code;
+  ASSERT_TRUE(page->FindCode(1, ValueFactory::GetVarcharValue("purple"), &missing_code));
+  EXPECT_EQ(missing_code, colors.size());
+  EXPECT_FALSE(page->FindCode(4, ValueFactory::GetVarcharValue("value 0"), &code));
+  std::vector<char> buffer;
+  Tuple columns;
+  ASSERT_TRUE(page->GetTupleColumns(rid, {1}, &buffer, &columns, transaction, lock_manager));
+  EXPECT_EQ(columns.GetValue(&schema, 1).ToString(), color);
+  EXPECT_TRUE(columns.GetValue(&schema, 4).IsNull());
+  buffer_pool_manager->UnpinPage(rid.GetPageId(), false);
+
+  // Scenario: compressed tuples are deleted and restored, but not updated in place, and inserts go elsewhere.
+  ASSERT_TRUE(table->MarkDelete(rid, transaction));
+  table->RollbackDelete(rid, transaction);
+  ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+  ASSERT_TRUE(table->MarkDelete(rid, transaction));
+  table->ApplyDelete(rid, transaction);
+  EXPECT_FALSE(table->GetTuple(rid, &tuple, transaction));
+  RID other_rid = moves.back().second;
+  EXPECT_FALSE(table->UpdateTuple(make_tuple(num_tuples), other_rid, transaction));
+  RID new_rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(num_tuples), &new_rid, transaction, &schema));
+  ASSERT_TRUE(table->GetTuple(new_rid, &tuple, transaction));
+  check_tuple(tuple, num_tuples);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+TEST(TupleTest, MoveTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32}}};
+
+  // Scenario: a moved tuple hands over its data without copying it and is left empty.
+  Tuple tuple({ValueFactory::GetIntegerValue(7), ValueFactory::GetVarcharValue("moved")}, &schema);
+  const char *data = tuple.GetData();
+  Tuple moved(std::move(tuple));
+  EXPECT_EQ(moved.GetData(), data);
+  EXPECT_TRUE(moved.IsAllocated());
+  EXPECT_EQ(tuple.GetData(), nullptr);  // NOLINT
+  EXPECT_EQ(tuple.GetLength(), 0);      // NOLINT
+  Tuple assigned;
+  assigned = std::move(moved);
+  EXPECT_EQ(assigned.GetData(), data);
+  EXPECT_EQ(assigned.GetValue(&schema, 1).ToString(), "moved");
+  Tuple copy(assigned);
+  EXPECT_NE(copy.GetData(), data);
+  EXPECT_EQ(copy.GetValue(&schema, 0).GetAs<int32_t>(), 7);
+
+  // Scenario: a moved varchar value keeps its buffer, and the moved-from value no longer frees it.
+  Value value = ValueFactory::GetVarcharValue("a varchar long enough to be worth moving");
+  const char *varlen = value.GetData();
+  Value moved_value(std::move(value));
+  EXPECT_EQ(moved_value.GetData(), varlen);
+  Value assigned_value;
+  assigned_value = std::move(moved_value);
+  EXPECT_EQ(assigned_value.GetData(), varlen);
+  EXPECT_EQ(assigned_value.ToString(), "a varchar long enough to be worth moving");
+
+  // Scenario: the values move into a tuple, and tuples move in and out of containers.
+  std::vector<Value> values{ValueFactory::GetIntegerValue(8), std::move(assigned_value)};
+  std::vector<Tuple> tuples;
+  tuples.emplace_back(std::move(values), &schema);
+  tuples.push_back(std::move(assigned));
+  tuples.reserve(64);
+  EXPECT_EQ(tuples[0].GetValue(&schema, 1).ToString(), "a varchar long enough to be worth moving");
+  EXPECT_EQ(tuples[1].GetData(), data);
+}
+
+TEST(TupleTest, NullCheckTest) {
+  const std::vector<TypeId> types{TypeId::BOOLEAN, TypeId::TINYINT, TypeId::SMALLINT,
+                                  TypeId::INTEGER, TypeId::BIGINT,  TypeId::DECIMAL, TypeId::VARCHAR};
+  std::vector<Column> columns;
+  for (size_t i = 0; i < types.size(); i++) {
+    if (types[i] == TypeId::VARCHAR) {
+      columns.emplace_back("c" + std::to_string(i), types[i], 16);
+    } else {
+      columns.emplace_back("c" + std::to_string(i), types[i]);
+    }
+  }
+  Schema schema{columns};
+  ASSERT_EQ(schema.GetColumnLayout(2).offset_, schema.GetColumn(2).GetOffset());
+  EXPECT_FALSE(schema.GetColumnLayout(6).is_inlined_);
+
+  // Scenario: the NULL check reads the bytes of every type as deserializing them would.
+  std::vector<Value> non_null{ValueFactory::GetBooleanValue(true), ValueFactory::GetTinyIntValue(1),
+                              ValueFactory::GetSmallIntValue(2),   ValueFactory::GetIntegerValue(3),
+                              ValueFactory::GetBigIntValue(4),     ValueFactory::GetDecimalValue(5.5),
+                              ValueFactory::GetVarcharValue("six")};
+  for (size_t null_column = 0; null_column <= types.size(); null_column++) {
+    std::vector<Value> values = non_null;
+    if (null_column < types.size()) {
+      values[null_column] = ValueFactory::GetNullValueByType(types[null_column]);
+    }
+    const Tuple tuple(values, &schema);
+    for (uint32_t i = 0; i < types.size(); i++) {
+      EXPECT_EQ(tuple.IsNull(&schema, i), i == null_column);
+      EXPECT_EQ(tuple.IsNull(&schema, i), tuple.GetValue(&schema, i).IsNull());
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_MovePerformanceTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 64}}};
+  const size_t num_tuples = 1000000;
+  std::vector<Tuple> tuples;
+  for (size_t i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                                           ValueFactory::GetVarcharValue("tuple " + std::to_string(i))},
+                        &schema);
+  }
+  auto fill_ms = [&tuples](auto fill) {
+    auto source = tuples;
+    std::vector<Tuple> sink;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto &tuple : source) {
+      fill(&sink, &tuple);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+  const double copy_ms = fill_ms([](std::vector<Tuple> *sink, Tuple *tuple) { sink->push_back(*tuple); });
+  const double move_ms = fill_ms([](std::vector<Tuple> *sink, Tuple *tuple) { sink->push_back(std::move(*tuple)); });
+  LOG_INFO("tuples=%zu copy=%.2fms move=%.2fms", num_tuples, copy_ms, move_ms);
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, SnapshotReadTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  TransactionManager txn_mgr{lock_manager, log_manager};
+  // The heap keeps versions with concurrency control on.
+  enable_logging = true;
+
+  auto make_tuple = [&schema](int32_t a) { return Tuple({ValueFactory::GetIntegerValue(a)}, &schema); };
+  auto scan = [&](TableHeap *table, Transaction *txn) {
+    std::vector<int32_t> values;
+    for (auto iter = table->Begin(txn); iter != table->End(); ++iter) {
+      values.push_back(iter->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    return values;
+  };
+  auto *txn0 = txn_mgr.Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0);
+  std::vector<RID> rids(3);
+  for (int32_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr.Commit(txn0);
+
+  // Scenario: a snapshot does not see the writes of a transaction running or committed after it began, and takes
+  // no locks where those writes hold theirs.
+  auto *snapshot = txn_mgr.Begin(nullptr, IsolationLevel::REPEATABLE_READ, ConcurrencyMode::SNAPSHOT);
+  auto *writer = txn_mgr.Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10), rids[0], writer));
+  ASSERT_TRUE(table->MarkDelete(rids[1], writer));
+  RID inserted;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(3), &inserted, writer));
+  EXPECT_EQ(scan(table, snapshot), (std::vector<int32_t>{0, 1, 2}));
+  Tuple tuple;
+  ASSERT_TRUE(table->GetTuple(rids[0], &tuple, snapshot));
+  EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 0);
+  EXPECT_FALSE(table->GetTuple(inserted, &tuple, snapshot));
+  EXPECT_EQ(snapshot->GetState(), TransactionState::GROWING);
+  EXPECT_TRUE(snapshot->GetSharedLockSet()->empty());
+  txn_mgr.Commit(writer);
+  EXPECT_EQ(scan(table, snapshot), (std::vector<int32_t>{0, 1, 2}));
+
+  // Scenario: a later snapshot sees the committed writes.
+  auto *later = txn_mgr.Begin(nullptr, IsolationLevel::REPEATABLE_READ, ConcurrencyMode::SNAPSHOT);
+  EXPECT_EQ(scan(table, later), (std::vector<int32_t>{10, 2, 3}));
+
+  // Scenario: a rolled back write leaves no version behind.
+  const size_t num_versions = table->GetVersionStore()->GetNumVersions();
+  auto *aborted = txn_mgr.Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(20), rids[2], aborted));
+  EXPECT_EQ(table->GetVersionStore()->GetNumVersions(), num_versions + 1);
+  txn_mgr.Abort(aborted);
+  EXPECT_EQ(table->GetVersionStore()->GetNumVersions(), num_versions);
+  EXPECT_EQ(scan(table, later), (std::vector<int32_t>{10, 2, 3}));
+
+  // Scenario: a snapshot cannot write.
+  EXPECT_FALSE(table->InsertTuple(make_tuple(4), &inserted, later));
+  EXPECT_EQ(later->GetState(), TransactionState::ABORTED);
+  txn_mgr.Commit(snapshot);
+  txn_mgr.Abort(later);
+
+  enable_logging = false;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete txn0;
+  delete snapshot;
+  delete writer;
+  delete later;
+  delete aborted;
+}
+
+TEST(TupleTest, VacuumTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  TransactionManager txn_mgr{lock_manager, log_manager};
+  auto *catalog = new Catalog(buffer_pool_manager, lock_manager, log_manager);
+  VacuumManager vacuum_manager{&txn_mgr, catalog};
+  enable_logging = true;
+
+  auto make_tuple = [&schema](int32_t a) { return Tuple({ValueFactory::GetIntegerValue(a)}, &schema); };
+  auto read = [&schema](TableHeap *table, const RID &rid, Transaction *txn) {
+    Tuple tuple;
+    return table->GetTuple(rid, &tuple, txn) ? tuple.GetValue(&schema, 0).GetAs<int32_t>() : -1;
+  };
+  auto *txn0 = txn_mgr.Begin();
+  TableHeap *table = catalog->CreateTable(txn0, "t", schema)->table_.get();
+  VersionStore *versions = table->GetVersionStore();
+  std::vector<RID> rids(2);
+  for (int32_t i = 0; i < 2; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr.Commit(txn0);
+  EXPECT_EQ(txn_mgr.GetOldestSnapshotTs(), txn_mgr.GetLastCommitTs());
+
+  // Scenario: a running snapshot keeps the versions it reads, the older ones are reclaimed.
+  auto *snapshot = txn_mgr.Begin(nullptr, IsolationLevel::REPEATABLE_READ, ConcurrencyMode::SNAPSHOT);
+  auto *writer = txn_mgr.Begin();
+  for (int32_t i = 1; i <= 3; i++) {
+    ASSERT_TRUE(table->UpdateTuple(make_tuple(10 * i), rids[0], writer));
+  }
+  txn_mgr.Commit(writer);
+  EXPECT_EQ(txn_mgr.GetOldestSnapshotTs(), snapshot->GetReadTs());
+  EXPECT_EQ(versions->GetNumVersions(), 5);
+  EXPECT_EQ(vacuum_manager.VacuumStep(), 2);
+  EXPECT_EQ(versions->GetNumVersions(), 3);
+  EXPECT_EQ(read(table, rids[0], snapshot), 0);
+  EXPECT_EQ(read(table, rids[1], snapshot), 1);
+
+  // Scenario: once no snapshot needs them, all the versions go, a deleted tuple stays gone.
+  txn_mgr.Commit(snapshot);
+  auto *deleter = txn_mgr.Begin();
+  ASSERT_TRUE(table->MarkDelete(rids[1], deleter));
+  txn_mgr.Commit(deleter);
+  EXPECT_EQ(vacuum_manager.VacuumStep(), 4);
+  EXPECT_EQ(versions->GetNumVersions(), 0);
+  auto *later = txn_mgr.Begin(nullptr, IsolationLevel::REPEATABLE_READ, ConcurrencyMode::SNAPSHOT);
+  EXPECT_EQ(read(table, rids[0], later), 30);
+  EXPECT_EQ(read(table, rids[1], later), -1);
+  EXPECT_EQ(later->GetState(), TransactionState::GROWING);
+  txn_mgr.Commit(later);
+
+  // Scenario: the background thread vacuums the writes as they commit.
+  vacuum_manager.RunVacuumThread();
+  auto *updater = txn_mgr.Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(40), rids[0], updater));
+  txn_mgr.Commit(updater);
+  for (int i = 0; i < 100 && versions->GetNumVersions() != 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(versions->GetNumVersions(), 0);
+  vacuum_manager.StopVacuumThread();
+
+  enable_logging = false;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete catalog;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete txn0;
+  delete snapshot;
+  delete writer;
+  delete deleter;
+  delete later;
+  delete updater;
+}
+
+TEST(TupleTest, OptimisticTransactionTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  TransactionManager txn_mgr{lock_manager, log_manager};
+  enable_logging = true;
+
+  auto make_tuple = [&schema](int32_t a) { return Tuple({ValueFactory::GetIntegerValue(a)}, &schema); };
+  auto read = [&schema](TableHeap *table, const RID &rid, Transaction *txn) {
+    Tuple tuple;
+    return table->GetTuple(rid, &tuple, txn) ? tuple.GetValue(&schema, 0).GetAs<int32_t>() : -1;
+  };
+  auto *txn0 = txn_mgr.Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0);
+  std::vector<RID> rids(2);
+  for (int32_t i = 0; i < 2; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr.Commit(txn0);
+  std::vector<Transaction *> txns{txn0};
+  auto begin = [&](ConcurrencyMode concurrency_mode) {
+    txns.push_back(txn_mgr.Begin(nullptr, IsolationLevel::REPEATABLE_READ, concurrency_mode));
+    return txns.back();
+  };
+
+  // Scenario: a read-modify-write reads without locks, locks the row it writes, and validates.
+  auto *occ = begin(ConcurrencyMode::OPTIMISTIC);
+  EXPECT_EQ(read(table, rids[0], occ), 0);
+  EXPECT_TRUE(occ->GetSharedLockSet()->empty());
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10), rids[0], occ));
+  EXPECT_TRUE(occ->IsExclusiveLocked(rids[0]));
+  EXPECT_EQ(read(table, rids[0], occ), 10);
+  EXPECT_TRUE(txn_mgr.Commit(occ));
+  auto *snapshot = begin(ConcurrencyMode::SNAPSHOT);
+  EXPECT_EQ(read(table, rids[0], snapshot), 10);
+  txn_mgr.Commit(snapshot);
+
+  // Scenario: a write committed to a tuple read since fails the validation.
+  occ = begin(ConcurrencyMode::OPTIMISTIC);
+  EXPECT_EQ(read(table, rids[1], occ), 1);
+  auto *writer = begin(ConcurrencyMode::LOCKING);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(11), rids[1], writer));
+  EXPECT_TRUE(txn_mgr.Commit(writer));
+  EXPECT_FALSE(txn_mgr.Commit(occ));
+  EXPECT_EQ(occ->GetState(), TransactionState::ABORTED);
+
+  // Scenario: an uncommitted write is neither read nor waited for, and validates once rolled back.
+  occ = begin(ConcurrencyMode::OPTIMISTIC);
+  writer = begin(ConcurrencyMode::LOCKING);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(20), rids[0], writer));
+  EXPECT_EQ(read(table, rids[0], occ), 10);
+  EXPECT_EQ(occ->GetState(), TransactionState::GROWING);
+  txn_mgr.Abort(writer);
+  EXPECT_TRUE(txn_mgr.Commit(occ));
+  EXPECT_EQ(txn_mgr.GetOldestSnapshotTs(), txn_mgr.GetLastCommitTs());
+
+  enable_logging = false;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  for (Transaction *txn : txns) {
+    delete txn;
+  }
+}
+
 }  // namespace bustub
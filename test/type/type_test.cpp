@@ -10,12 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "common/exception.h"
+#include "common/util/hash_util.h"
 #include "gtest/gtest.h"
+#include "type/aggregation_kernels.h"
+#include "type/selection_kernels.h"
+#include "type/typed_kernels.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -95,4 +101,185 @@ TEST(TypeTests, TemplateTest) {
   BPlusTreePage<Value, Value> node;
   node.GetInfo(val1, val2);
 }
+
+// NOLINTNEXTLINE
+TEST(TypeTests, TypedKernelsTest) {
+  // Scenario: the native comparisons of every pair of numeric types agree with the Value ones.
+  const std::vector<Value> values = {
+      Value(TypeId::TINYINT, static_cast<int8_t>(-3)),  Value(TypeId::SMALLINT, static_cast<int16_t>(7)),
+      Value(TypeId::INTEGER, static_cast<int32_t>(7)),  Value(TypeId::BIGINT, static_cast<int64_t>(1) << 40),
+      Value(TypeId::DECIMAL, 6.5),                       Value(TypeId::DECIMAL, -3.0),
+  };
+  for (const Value &left : values) {
+    for (const Value &right : values) {
+      DispatchNativeType(left.GetTypeId(), [&](auto l) {
+        DispatchNativeType(right.GetTypeId(), [&](auto r) {
+          const auto left_native = left.GetAs<decltype(l)>();
+          const auto right_native = right.GetAs<decltype(r)>();
+          EXPECT_EQ(left.CompareLessThan(right) == CmpBool::CmpTrue,
+                    CompareNative<std::less<>>(left_native, right_native));
+          EXPECT_EQ(left.CompareEquals(right) == CmpBool::CmpTrue,
+                    CompareNative<std::equal_to<>>(left_native, right_native));
+          EXPECT_EQ(left.CompareGreaterThanEquals(right) == CmpBool::CmpTrue,
+                    CompareNative<std::greater_equal<>>(left_native, right_native));
+        });
+      });
+    }
+  }
+
+  // Scenario: the native hashes are those of the Values, and a column hashes as its Values one by one, NULLs aside.
+  for (const Value &value : values) {
+    DispatchNativeType(value.GetTypeId(),
+                       [&](auto v) { EXPECT_EQ(HashUtil::HashValue(&value), HashNative(value.GetAs<decltype(v)>())); });
+  }
+  Value timestamp(TypeId::TIMESTAMP, static_cast<uint64_t>(123456789));
+  EXPECT_EQ(HashUtil::HashValue(&timestamp), HashNative(timestamp.GetAs<uint64_t>()));
+  const std::vector<int32_t> column = {4, BUSTUB_INT32_NULL, -9, 4, 12};
+  std::vector<hash_t> hashes(column.size(), 42);
+  std::vector<uint8_t> nulls(column.size(), 0);
+  HashColumn(column.data(), column.size(), hashes.data(), nulls.data());
+  for (size_t i = 0; i < column.size(); i++) {
+    Value value(TypeId::INTEGER, column[i]);
+    EXPECT_EQ(value.IsNull(), nulls[i] == 1);
+    if (!value.IsNull()) {
+      EXPECT_EQ(HashUtil::CombineHashes(42, HashUtil::HashValue(&value)), hashes[i]);
+    }
+  }
+
+  // Scenario: the aggregates of a column are those of its Values, and those of a column of NULLs are NULL.
+  ColumnAggregates<int32_t> aggregates = AggregateColumn(column.data(), column.size());
+  EXPECT_EQ(11, aggregates.sum_);
+  EXPECT_EQ(-9, aggregates.min_);
+  EXPECT_EQ(12, aggregates.max_);
+  EXPECT_EQ(4, aggregates.count_);
+  const std::vector<double> nulls_column = {BUSTUB_DECIMAL_NULL, BUSTUB_DECIMAL_NULL};
+  ColumnAggregates<double> null_aggregates = AggregateColumn(nulls_column.data(), nulls_column.size());
+  EXPECT_EQ(0, null_aggregates.count_);
+  EXPECT_TRUE(Value(TypeId::DECIMAL, null_aggregates.min_).IsNull());
+}
+// NOLINTNEXTLINE
+TEST(TypeTests, InlinedVarcharTest) {
+  // Scenario: strings on either side of the inline size survive copies, moves, assignment and serialization.
+  for (const std::string &str : {std::string(""), std::string("short"), std::string(15, 'x'), std::string(16, 'y'),
+                                 std::string("a string far too long to be inlined")}) {
+    Value value(TypeId::VARCHAR, str);
+    EXPECT_EQ(str, value.ToString());
+    EXPECT_EQ(str.size() + 1, value.GetLength());
+
+    Value copy(value);
+    EXPECT_EQ(str, copy.ToString());
+    EXPECT_EQ(CmpBool::CmpTrue, copy.CompareEquals(value));
+
+    Value moved(std::move(copy));
+    EXPECT_EQ(str, moved.ToString());
+    Value assigned = Value(TypeId::VARCHAR, "something else");
+    assigned = moved;
+    EXPECT_EQ(str, assigned.ToString());
+
+    std::vector<char> storage(sizeof(uint32_t) + value.GetLength());
+    value.SerializeTo(storage.data());
+    Value deserialized = Value::DeserializeFrom(storage.data(), TypeId::VARCHAR);
+    EXPECT_EQ(str, deserialized.ToString());
+    EXPECT_EQ(HashUtil::HashValue(&value), HashUtil::HashValue(&deserialized));
+  }
+
+  // Scenario: an unmanaged value still points into the data it was made from.
+  const char data[] = "borrowed";
+  Value borrowed(TypeId::VARCHAR, data, sizeof(data), false);
+  EXPECT_EQ(data, borrowed.GetData());
+  Value borrowed_copy(borrowed);
+  EXPECT_EQ(data, borrowed_copy.GetData());
+}
+namespace {
+
+/** Checks the selection kernels against SelectsNative for every comparison, on columns with NULLs and any tail. */
+template <typename T>
+void CheckSelectionKernels(const std::vector<T> &domain) {
+  std::vector<T> left;
+  std::vector<T> right;
+  for (size_t i = 0; i < 77; i++) {
+    left.push_back(domain[i % domain.size()]);
+    right.push_back(domain[(i * 7 + 3) % domain.size()]);
+  }
+  std::vector<uint64_t> bitmap(SelectionWords(left.size()));
+  std::vector<uint32_t> indices(left.size());
+  auto check = [&](auto op) {
+    using Op = decltype(op);
+    CompareColumns<Op>(left.data(), right.data(), left.size(), bitmap.data());
+    for (size_t i = 0; i < left.size(); i++) {
+      EXPECT_EQ(SelectsNative<Op>(left[i], right[i]), ((bitmap[i / 64] >> (i % 64)) & 1) == 1);
+    }
+    for (T constant : domain) {
+      CompareColumnConstant<Op>(left.data(), left.size(), constant, bitmap.data());
+      size_t count = SelectedIndices(bitmap.data(), left.size(), indices.data());
+      size_t expected = 0;
+      for (size_t i = 0; i < left.size(); i++) {
+        if (SelectsNative<Op>(left[i], constant)) {
+          ASSERT_LT(expected, count);
+          EXPECT_EQ(i, indices[expected++]);
+        }
+      }
+      EXPECT_EQ(expected, count);
+    }
+  };
+  check(std::equal_to<>{});
+  check(std::not_equal_to<>{});
+  check(std::less<>{});
+  check(std::less_equal<>{});
+  check(std::greater<>{});
+  check(std::greater_equal<>{});
+}
+
+/** Checks the aggregation kernels against the aggregates of the values one at a time, for every length up to n. */
+template <typename T>
+void CheckAggregationKernels(const std::vector<T> &column) {
+  for (size_t n = 0; n <= column.size(); n++) {
+    ColumnAggregates<T> expected;
+    for (size_t i = 0; i < n; i++) {
+      if (column[i] != NativeNull<T>()) {
+        expected.sum_ += column[i];
+        expected.min_ = expected.count_ == 0 ? column[i] : std::min(expected.min_, column[i]);
+        expected.max_ = expected.count_ == 0 ? column[i] : std::max(expected.max_, column[i]);
+        expected.count_++;
+      }
+    }
+    ColumnAggregates<T> aggregates = AggregateColumn(column.data(), n);
+    EXPECT_EQ(expected.sum_, aggregates.sum_);
+    EXPECT_EQ(expected.min_, aggregates.min_);
+    EXPECT_EQ(expected.max_, aggregates.max_);
+    EXPECT_EQ(expected.count_, aggregates.count_);
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(TypeTests, AggregationKernelsTest) {
+  // Scenario: the extremes of the types, NULLs among them, and a run of NULLs longer than a vector register.
+  std::vector<int32_t> integers;
+  std::vector<int64_t> bigints;
+  std::vector<double> decimals;
+  for (int i = 0; i < 70; i++) {
+    const bool null = i % 5 == 3 || (i >= 20 && i < 40);
+    const int32_t integer = i == 7 ? BUSTUB_INT32_MAX : i == 50 ? BUSTUB_INT32_MIN : i * 37 - 900;
+    integers.push_back(null ? BUSTUB_INT32_NULL : integer);
+    bigints.push_back(null ? BUSTUB_INT64_NULL : (int64_t{i} << 40) - (int64_t{1} << 45));
+    // Halves add up exactly in any order.
+    decimals.push_back(null ? BUSTUB_DECIMAL_NULL : i * 0.5 - 10);
+  }
+  CheckAggregationKernels(integers);
+  CheckAggregationKernels(bigints);
+  CheckAggregationKernels(decimals);
+  CheckAggregationKernels(std::vector<int16_t>{BUSTUB_INT16_NULL, -3, 9, BUSTUB_INT16_NULL, 4});
+}
+
+// NOLINTNEXTLINE
+TEST(TypeTests, SelectionKernelsTest) {
+  CheckSelectionKernels<int32_t>({BUSTUB_INT32_NULL, BUSTUB_INT32_MIN, -7, 0, 3, 3, BUSTUB_INT32_MAX});
+  CheckSelectionKernels<int64_t>({BUSTUB_INT64_NULL, BUSTUB_INT64_MIN, -7, 0, 3, int64_t{1} << 40, BUSTUB_INT64_MAX});
+  CheckSelectionKernels<double>({BUSTUB_DECIMAL_NULL, -2.5, -0.0, 0.0, 1.5, 1e300});
+  // TIMESTAMPs are unsigned, past the largest signed value too.
+  CheckSelectionKernels<uint64_t>({BUSTUB_TIMESTAMP_NULL, 0, 5, uint64_t{1} << 63, BUSTUB_TIMESTAMP_NULL - 1});
+  CheckSelectionKernels<int16_t>({BUSTUB_INT16_NULL, -7, 0, 3});
+}
 }  // namespace bustub
@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bench.cpp
+//
+// Identification: tools/bench/b_plus_tree_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "b_plus_tree_bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+
+#include "bench_driver.h"
+#include "bench_report.h"
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+namespace {
+
+constexpr const char *BTREE_BENCH_DB_FILE = "bustub_bench_btree.db";
+/** How far past the loaded keys the mixed phase draws the keys it inserts. */
+constexpr int64_t MIXED_KEY_SPACE = int64_t{1} << 40;
+
+template <size_t KeySize>
+class TreeBench {
+ public:
+  using Tree = BPlusTree<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+
+  explicit TreeBench(const BPlusTreeBenchOptions &options)
+      : options_(options), key_schema_({Column("key", TypeId::BIGINT)}), comparator_(&key_schema_) {
+    std::mt19937_64 random(KeySize);
+    shuffled_keys_.resize(options.num_keys_);
+    std::iota(shuffled_keys_.begin(), shuffled_keys_.end(), 0);
+    std::shuffle(shuffled_keys_.begin(), shuffled_keys_.end(), random);
+  }
+
+  void Run(size_t num_threads) {
+    RemoveDatabaseFiles(BTREE_BENCH_DB_FILE);
+    {
+      DiskManager disk_manager(BTREE_BENCH_DB_FILE);
+      BufferPoolManager bpm(options_.pool_size_, &disk_manager);
+      page_id_t header_page_id;
+      bpm.NewPage(&header_page_id);
+      bpm.UnpinPage(header_page_id, true);
+
+      Tree sequential("bench_sequential", &bpm, comparator_);
+      std::atomic<int64_t> next_key{0};
+      auto num_keys = static_cast<int64_t>(options_.num_keys_);
+      PrintPhase("seq_insert", num_threads, RunPhase(num_threads, FOREVER, [&](PhaseWorker *worker) {
+                   int64_t key = next_key++;
+                   if (key >= num_keys) {
+                     return false;
+                   }
+                   Insert(&sequential, key, &worker->txn_);
+                   return true;
+                 }));
+
+      Tree tree("bench_random", &bpm, comparator_);
+      std::atomic<size_t> next_index{0};
+      PrintPhase("rand_insert", num_threads, RunPhase(num_threads, FOREVER, [&](PhaseWorker *worker) {
+                   size_t index = next_index++;
+                   if (index >= shuffled_keys_.size()) {
+                     return false;
+                   }
+                   Insert(&tree, shuffled_keys_[index], &worker->txn_);
+                   return true;
+                 }));
+
+      PrintPhase("lookup", num_threads, RunPhase(num_threads, options_.duration_, [&](PhaseWorker *worker) {
+                   Lookup(&tree, PickKey(worker));
+                   return true;
+                 }));
+
+      PrintPhase("probe", num_threads, RunPhase(num_threads, options_.duration_, [&](PhaseWorker *worker) {
+                   // Each thread keeps a batch of its own.
+                   thread_local std::vector<GenericKey<KeySize>> batch;
+                   thread_local std::vector<std::vector<RID>> results;
+                   batch.clear();
+                   for (size_t i = 0; i < options_.probe_batch_; i++) {
+                     batch.push_back(MakeKey(PickKey(worker)));
+                   }
+                   tree.GetValuesInterleaved(batch, &results);
+                   return true;
+                 }));
+
+      PrintPhase("scan", num_threads, RunPhase(num_threads, options_.duration_, [&](PhaseWorker *worker) {
+                   int64_t lo = PickKey(worker);
+                   GenericKey<KeySize> lo_key = MakeKey(lo);
+                   GenericKey<KeySize> hi_key = MakeKey(lo + options_.scan_length_ - 1);
+                   for (auto iter = tree.Begin(lo_key, hi_key); !iter.isEnd(); ++iter) {
+                   }
+                   return true;
+                 }));
+
+      PrintPhase("mixed", num_threads, RunPhase(num_threads, options_.duration_, [&](PhaseWorker *worker) {
+                   if (std::uniform_int_distribution<int>(0, 99)(worker->random_) < options_.read_percent_) {
+                     Lookup(&tree, PickKey(worker));
+                   } else {
+                     // A key drawn twice is not inserted again, which still counts as an operation.
+                     Insert(&tree, std::uniform_int_distribution<int64_t>(num_keys, MIXED_KEY_SPACE)(worker->random_),
+                            &worker->txn_);
+                   }
+                   return true;
+                 }));
+    }
+    RemoveDatabaseFiles(BTREE_BENCH_DB_FILE);
+  }
+
+ private:
+  /** The duration of the phases that run until their operations are exhausted. */
+  static constexpr std::chrono::milliseconds FOREVER = std::chrono::hours(24);
+
+  /** Prints the result of a phase, and adds it to the report of the run if any. */
+  void PrintPhase(const char *phase, size_t num_threads, const PhaseResult &result) const {
+    auto micros = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+    double seconds = std::chrono::duration<double>(result.elapsed_).count();
+    double ops = static_cast<double>(result.num_ops_);
+    const HistogramSnapshot &latencies = result.latencies_ns_;
+    printf("%-12s %4zu %8zu %12.0f %10.2f %10.2f %10.2f %10.1f\n", phase, KeySize, num_threads, ops / seconds,
+           result.num_ops_ == 0 ? 0 : static_cast<double>(result.num_fetches_) / ops,
+           micros(latencies.Percentile(0.5)), micros(latencies.Percentile(0.99)), micros(latencies.max_));
+    fflush(stdout);
+    if (options_.report_ != nullptr) {
+      options_.report_->Add(std::string("btree/") + phase + "/key=" + std::to_string(KeySize) +
+                                "/threads=" + std::to_string(num_threads),
+                            ops / seconds, latencies.Percentile(0.5), latencies.Percentile(0.99));
+    }
+  }
+
+  static GenericKey<KeySize> MakeKey(int64_t key) {
+    GenericKey<KeySize> index_key;
+    index_key.SetFromInteger(key);
+    return index_key;
+  }
+
+  static void Insert(Tree *tree, int64_t key, Transaction *txn) {
+    tree->Insert(MakeKey(key), RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)), txn);
+  }
+
+  static void Lookup(Tree *tree, int64_t key) {
+    std::vector<RID> result;
+    tree->GetValue(MakeKey(key), &result);
+  }
+
+  int64_t PickKey(PhaseWorker *worker) const {
+    return std::uniform_int_distribution<int64_t>(0, static_cast<int64_t>(options_.num_keys_) - 1)(worker->random_);
+  }
+
+  const BPlusTreeBenchOptions &options_;
+  Schema key_schema_;
+  GenericComparator<KeySize> comparator_;
+  std::vector<int64_t> shuffled_keys_;
+};
+
+template <size_t KeySize>
+void RunKeySize(const BPlusTreeBenchOptions &options) {
+  TreeBench<KeySize> bench(options);
+  for (size_t num_threads : options.thread_counts_) {
+    bench.Run(num_threads);
+  }
+}
+
+}  // namespace
+
+bool IsBenchKeySize(size_t key_size) { return key_size == 8 || key_size == 16 || key_size == 32 || key_size == 64; }
+
+void RunBPlusTreeBench(const BPlusTreeBenchOptions &options) {
+  printf("%-12s %4s %8s %12s %10s %10s %10s %10s\n", "phase", "key", "threads", "ops/s", "fetch/op", "p50 us",
+         "p99 us", "max us");
+  for (size_t key_size : options.key_sizes_) {
+    switch (key_size) {
+      case 8:
+        RunKeySize<8>(options);
+        break;
+      case 16:
+        RunKeySize<16>(options);
+        break;
+      case 32:
+        RunKeySize<32>(options);
+        break;
+      case 64:
+        RunKeySize<64>(options);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+}  // namespace bustub
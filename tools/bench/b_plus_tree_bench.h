@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bench.h
+//
+// Identification: tools/bench/b_plus_tree_bench.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <vector>
+
+namespace bustub {
+
+class BenchReport;
+
+/**
+ * The options of the B+ tree benchmark. For every key size and thread count, it runs on a fresh tree, straight through
+ * BPlusTree<GenericKey<N>, RID, GenericComparator<N>>:
+ *
+ *   seq_insert   num_keys_ keys inserted in ascending order, the threads taking the next one in turns
+ *   rand_insert  the same keys in a random order, into another tree
+ *   lookup       point lookups of random keys of that tree
+ *   probe        batches of probe_batch_ random keys of that tree, looked up by BPlusTree::GetValuesInterleaved
+ *   scan         scans of scan_length_ keys from a random one, through IndexIterator
+ *   mixed        lookups of random keys, read_percent_ of the operations, and inserts of new keys
+ *
+ * The keys are 64-bit integers, padded to the key size, so that larger keys only make the pages hold fewer of them.
+ */
+struct BPlusTreeBenchOptions {
+  size_t num_keys_{100000};
+  std::vector<size_t> key_sizes_{8, 16, 32, 64};
+  std::vector<size_t> thread_counts_{1, 2, 4, 8};
+  /** The frames of the buffer pool of each tree. */
+  size_t pool_size_{4096};
+  int64_t scan_length_{100};
+  /** The keys of a batch of the probe phase, which is one operation. */
+  size_t probe_batch_{64};
+  int read_percent_{90};
+  /** How long the lookup, scan and mixed phases last; the inserts last until all the keys are in. */
+  std::chrono::milliseconds duration_{std::chrono::seconds(2)};
+  /** Where to add a record of each phase too, btree/PHASE/key=N/threads=N, none if nullptr. */
+  BenchReport *report_{nullptr};
+};
+
+/** @return whether the tree is instantiated with keys of key_size bytes: 8, 16, 32 or 64 */
+bool IsBenchKeySize(size_t key_size);
+
+/**
+ * Runs the B+ tree benchmark on a file of its own, and prints, for each phase, the operations per second, the pages
+ * an operation fetched from the buffer pool on average and the percentiles of the latency of an operation.
+ */
+void RunBPlusTreeBench(const BPlusTreeBenchOptions &options);
+
+}  // namespace bustub
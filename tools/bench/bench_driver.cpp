@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_driver.cpp
+//
+// Identification: tools/bench/bench_driver.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "bench_driver.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <thread>  // NOLINT
+
+#include "concurrency/transaction_manager.h"
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/plans/insert_plan.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+const AbstractExpression *PlanBuilder::ColumnValue(const Schema &schema, uint32_t tuple_idx,
+                                                   const std::string &col_name) {
+  uint32_t col_idx = schema.GetColIdx(col_name);
+  exprs_.emplace_back(std::make_unique<ColumnValueExpression>(tuple_idx, col_idx, schema.GetColumn(col_idx).GetType()));
+  return exprs_.back().get();
+}
+
+const AbstractExpression *PlanBuilder::Constant(const Value &val) {
+  exprs_.emplace_back(std::make_unique<ConstantValueExpression>(val));
+  return exprs_.back().get();
+}
+
+const AbstractExpression *PlanBuilder::Compare(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                               ComparisonType comp_type) {
+  exprs_.emplace_back(std::make_unique<ComparisonExpression>(lhs, rhs, comp_type));
+  return exprs_.back().get();
+}
+
+const AbstractExpression *PlanBuilder::AggregateValue(bool is_group_by_term, uint32_t term_idx, TypeId type) {
+  exprs_.emplace_back(std::make_unique<AggregateValueExpression>(is_group_by_term, term_idx, type));
+  return exprs_.back().get();
+}
+
+const Schema *PlanBuilder::OutputSchema(const std::vector<std::pair<std::string, const AbstractExpression *>> &exprs) {
+  std::vector<Column> cols;
+  cols.reserve(exprs.size());
+  for (const auto &[name, expr] : exprs) {
+    if (expr->GetReturnType() != TypeId::VARCHAR) {
+      cols.emplace_back(name, expr->GetReturnType(), expr);
+    } else {
+      cols.emplace_back(name, expr->GetReturnType(), MAX_VARCHAR_SIZE, expr);
+    }
+  }
+  schemas_.emplace_back(std::make_unique<Schema>(cols));
+  return schemas_.back().get();
+}
+
+const Schema *PlanBuilder::AllColumns(const Schema &schema) {
+  std::vector<std::pair<std::string, const AbstractExpression *>> exprs;
+  for (const Column &column : schema.GetColumns()) {
+    exprs.emplace_back(column.GetName(), ColumnValue(schema, 0, column.GetName()));
+  }
+  return OutputSchema(exprs);
+}
+
+const AbstractPlanNode *PlanBuilder::KeyScan(const TableMetadata *table, const IndexInfo *index, int32_t lower,
+                                             int32_t upper) {
+  // The bounds are exact on a key of one column, so the scan needs no predicate.
+  return MakePlan<IndexScanPlanNode>(AllColumns(table->schema_), nullptr, index->index_oid_, false,
+                                     ValueFactory::GetIntegerValue(lower), ValueFactory::GetIntegerValue(upper));
+}
+
+void InsertRows(ExecutionEngine *engine, ExecutorContext *exec_ctx, table_oid_t table_oid,
+                std::vector<std::vector<Value>> *rows) {
+  const size_t batch_size = 1024;
+  for (size_t begin = 0; begin < rows->size(); begin += batch_size) {
+    size_t end = std::min(rows->size(), begin + batch_size);
+    std::vector<std::vector<Value>> batch(std::make_move_iterator(rows->begin() + begin),
+                                          std::make_move_iterator(rows->begin() + end));
+    InsertPlanNode insert_plan{std::move(batch), table_oid};
+    engine->Execute(&insert_plan, nullptr, exec_ctx->GetTransaction(), exec_ctx);
+  }
+  rows->clear();
+}
+
+void RemoveDatabaseFiles(const std::string &db_file) {
+  remove(db_file.c_str());
+  std::string base_name = db_file.substr(0, db_file.rfind('.'));
+  for (const char *extension : {".log", ".fsm", ".mst", ".crc", ".dwb", ".bpd"}) {
+    remove((base_name + extension).c_str());
+  }
+}
+
+bool WritePageTrace(const PageAccessTracer &tracer, BustubInstance *instance, const std::string &file_name) {
+  PageTrace trace;
+  trace.accesses_ = tracer.Collect();
+  trace.ResolveOwners(instance->disk_manager_->GetExtentOwners());
+  for (TableMetadata *table : instance->catalog_->GetTables()) {
+    trace.owner_names_[table->table_->GetFirstPageId()] = table->name_;
+    for (IndexInfo *index : instance->catalog_->GetTableIndexes(table->name_)) {
+      if (index->index_->GetExtentOwner() != INVALID_PAGE_ID) {
+        trace.owner_names_[index->index_->GetExtentOwner()] = index->name_;
+      }
+    }
+  }
+  return trace.Write(file_name);
+}
+
+double BenchResult::Throughput() const {
+  return elapsed_.count() == 0 ? 0 : static_cast<double>(num_committed_) * 1e9 / static_cast<double>(elapsed_.count());
+}
+
+std::chrono::nanoseconds BenchResult::Percentile(double fraction) const {
+  if (latencies_.empty()) {
+    return std::chrono::nanoseconds(0);
+  }
+  auto rank = static_cast<size_t>(fraction * static_cast<double>(latencies_.size()));
+  return latencies_[std::min(rank, latencies_.size() - 1)];
+}
+
+BenchResult RunWorkload(BenchWorkload *workload, BustubInstance *instance, ExecutionEngine *engine, size_t num_threads,
+                        const BenchRunOptions &options) {
+  struct WorkerResult {
+    size_t num_aborted_{0};
+    std::vector<std::chrono::nanoseconds> latencies_;
+  };
+  std::vector<WorkerResult> results(num_threads);
+  TransactionManager *txn_mgr = instance->transaction_manager_;
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + options.duration_;
+  std::vector<std::thread> threads;
+  for (size_t id = 0; id < num_threads; id++) {
+    threads.emplace_back([&, id] {
+      BenchWorker worker(id, instance, engine);
+      WorkerResult &result = results[id];
+      while (std::chrono::steady_clock::now() < deadline) {
+        auto op_start = std::chrono::steady_clock::now();
+        Transaction *txn = txn_mgr->Begin(nullptr, IsolationLevel::REPEATABLE_READ, options.concurrency_mode_);
+        ExecutorContext exec_ctx(txn, instance->catalog_, instance->buffer_pool_manager_, txn_mgr,
+                                 instance->lock_manager_);
+        worker.exec_ctx_ = &exec_ctx;
+        bool committed = false;
+        bool validated = true;
+        try {
+          workload->RunOperation(&worker);
+          if (txn->GetState() != TransactionState::ABORTED) {
+            // Commit aborts an optimistic transaction that fails its validation itself.
+            committed = txn_mgr->Commit(txn);
+            validated = committed;
+          }
+        } catch (const TransactionAbortException &e) {
+        }
+        if (!committed && validated) {
+          txn_mgr->Abort(txn);
+        }
+        worker.exec_ctx_ = nullptr;
+        worker.plans_.Clear();
+        delete txn;
+        if (committed) {
+          result.latencies_.push_back(std::chrono::steady_clock::now() - op_start);
+        } else {
+          result.num_aborted_++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  BenchResult result{workload->Name(), num_threads, std::chrono::steady_clock::now() - start, 0, 0, {}};
+  for (auto &worker_result : results) {
+    result.num_aborted_ += worker_result.num_aborted_;
+    result.latencies_.insert(result.latencies_.end(), worker_result.latencies_.begin(),
+                             worker_result.latencies_.end());
+  }
+  result.num_committed_ = result.latencies_.size();
+  std::sort(result.latencies_.begin(), result.latencies_.end());
+  return result;
+}
+
+void PrintResultHeader() {
+  printf("%-12s %8s %12s %10s %10s %10s %10s %10s\n", "workload", "threads", "txn/s", "p50 us", "p95 us", "p99 us",
+         "max us", "aborts");
+}
+
+void PrintResult(const BenchResult &result) {
+  auto micros = [](std::chrono::nanoseconds latency) { return static_cast<double>(latency.count()) / 1000.0; };
+  printf("%-12s %8zu %12.0f %10.1f %10.1f %10.1f %10.1f %10zu\n", result.workload_.c_str(), result.num_threads_,
+         result.Throughput(), micros(result.Percentile(0.5)), micros(result.Percentile(0.95)),
+         micros(result.Percentile(0.99)), micros(result.Percentile(1.0)), result.num_aborted_);
+  fflush(stdout);
+}
+
+}  // namespace bustub
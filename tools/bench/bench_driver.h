@@ -0,0 +1,237 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_driver.h
+//
+// Identification: tools/bench/bench_driver.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_access_trace.h"
+#include "common/metrics.h"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
+#include "execution/execution_engine.h"
+#include "execution/executor_context.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/index_scan_plan.h"
+
+namespace bustub {
+
+/**
+ * PlanBuilder owns the expressions and output schemas of the plans of a workload, which the plan nodes only point to.
+ * A worker clears its builder after each operation.
+ */
+class PlanBuilder {
+ public:
+  const AbstractExpression *ColumnValue(const Schema &schema, uint32_t tuple_idx, const std::string &col_name);
+  const AbstractExpression *Constant(const Value &val);
+  const AbstractExpression *Compare(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                    ComparisonType comp_type);
+  const AbstractExpression *AggregateValue(bool is_group_by_term, uint32_t term_idx, TypeId type);
+  const Schema *OutputSchema(const std::vector<std::pair<std::string, const AbstractExpression *>> &exprs);
+
+  /** @return an output schema of all the columns of a table */
+  const Schema *AllColumns(const Schema &schema);
+
+  /** @return a plan node built from args, owned by the builder */
+  template <class Node, class... Args>
+  const Node *MakePlan(Args &&... args) {
+    auto plan = std::make_unique<Node>(std::forward<Args>(args)...);
+    const Node *node = plan.get();
+    plans_.push_back(std::move(plan));
+    return node;
+  }
+
+  /**
+   * @return a scan of the rows of a table whose key, its first column, an INTEGER indexed by index, is in [lower,
+   * upper]: SELECT * FROM table WHERE key BETWEEN lower AND upper
+   */
+  const AbstractPlanNode *KeyScan(const TableMetadata *table, const IndexInfo *index, int32_t lower, int32_t upper);
+
+  /** Frees the expressions, schemas and plans built so far. */
+  void Clear() {
+    plans_.clear();
+    exprs_.clear();
+    schemas_.clear();
+  }
+
+ private:
+  /** The length of the VARCHAR columns of output schemas. */
+  static constexpr uint32_t MAX_VARCHAR_SIZE = 128;
+
+  std::vector<std::unique_ptr<AbstractExpression>> exprs_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plans_;
+};
+
+/** The state of one thread running a workload. */
+struct BenchWorker {
+  BenchWorker(size_t id, BustubInstance *instance, ExecutionEngine *engine)
+      : id_(id), random_(id + 1), instance_(instance), engine_(engine) {}
+
+  /** Executes a plan in the transaction of the running operation. */
+  void Execute(const AbstractPlanNode *plan, std::vector<Tuple> *result_set) {
+    engine_->Execute(plan, result_set, exec_ctx_->GetTransaction(), exec_ctx_);
+  }
+
+  /** The index of the thread among those of the run. */
+  size_t id_;
+  std::mt19937_64 random_;
+  BustubInstance *instance_;
+  ExecutionEngine *engine_;
+  /** The context of the transaction of the running operation. */
+  ExecutorContext *exec_ctx_{nullptr};
+  PlanBuilder plans_;
+};
+
+/**
+ * A workload of the benchmark: it loads its tables once, then each worker thread runs its operations, one transaction
+ * each, until the run ends.
+ */
+class BenchWorkload {
+ public:
+  virtual ~BenchWorkload() = default;
+
+  /** @return the name of the workload in the report */
+  virtual std::string Name() const = 0;
+
+  /** Creates and fills the tables and indexes of the workload, in txn; called once, before any run. */
+  virtual void Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) = 0;
+
+  /**
+   * Runs one operation, in the transaction of the executor context of worker. A transaction that aborts, from a lock
+   * or a failed validation, is counted and the operation is not retried.
+   */
+  virtual void RunOperation(BenchWorker *worker) = 0;
+};
+
+/**
+ * Inserts rows into a table a batch at a time, which also go into its indexes, for the loads of the workloads.
+ * @param rows the rows to insert, consumed
+ */
+void InsertRows(ExecutionEngine *engine, ExecutorContext *exec_ctx, table_oid_t table_oid,
+                std::vector<std::vector<Value>> *rows);
+
+/** Removes a database file and the files the disk manager keeps next to it, e.g. its log. */
+void RemoveDatabaseFiles(const std::string &db_file);
+
+/**
+ * Writes the accesses a tracer kept to a trace file, each with the table or index its page belongs to, named after it,
+ * see PageTrace. Must be called once the tracer is unset from the buffer pool of the instance.
+ * @return false if the file cannot be written
+ */
+bool WritePageTrace(const PageAccessTracer &tracer, BustubInstance *instance, const std::string &file_name);
+
+/** The options of a run that are not those of a workload. */
+struct BenchRunOptions {
+  /** How long the workers run operations. */
+  std::chrono::milliseconds duration_{std::chrono::seconds(5)};
+  /** How the transactions of the operations keep their reads consistent. */
+  ConcurrencyMode concurrency_mode_{ConcurrencyMode::LOCKING};
+};
+
+/** What a run measured. */
+struct BenchResult {
+  std::string workload_;
+  size_t num_threads_;
+  std::chrono::nanoseconds elapsed_;
+  size_t num_committed_;
+  size_t num_aborted_;
+  /** The latency of each committed operation, sorted. */
+  std::vector<std::chrono::nanoseconds> latencies_;
+
+  /** @return the committed operations per second */
+  double Throughput() const;
+
+  /** @return the latency below which a fraction of the operations completed, e.g. 0.99 */
+  std::chrono::nanoseconds Percentile(double fraction) const;
+};
+
+/** Runs the operations of a loaded workload on num_threads threads for the duration of the run. */
+BenchResult RunWorkload(BenchWorkload *workload, BustubInstance *instance, ExecutionEngine *engine, size_t num_threads,
+                        const BenchRunOptions &options);
+
+/** Prints the header of the table of results. */
+void PrintResultHeader();
+
+/** Prints a result: its throughput and the percentiles of its latencies. */
+void PrintResult(const BenchResult &result);
+
+/** What a thread of a phase needs to run its operations. */
+struct PhaseWorker {
+  explicit PhaseWorker(size_t id) : random_(id + 1), txn_(static_cast<txn_id_t>(id)) {}
+
+  std::mt19937_64 random_;
+  /** The transaction of the operations that take one, e.g. a B+ tree insert, which holds the pages it latches. */
+  Transaction txn_;
+};
+
+/** What a phase of a microbenchmark measured. */
+struct PhaseResult {
+  std::chrono::nanoseconds elapsed_;
+  uint64_t num_ops_{0};
+  uint64_t num_fetches_{0};
+  HistogramSnapshot latencies_ns_;
+};
+
+/**
+ * Runs a phase of a microbenchmark: op, a bool(PhaseWorker *), on num_threads threads until the phase lasted duration
+ * or op returns false, its operations being exhausted. The latency of an operation includes the clock check that
+ * precedes it.
+ */
+template <class Op>
+PhaseResult RunPhase(size_t num_threads, std::chrono::milliseconds duration, const Op &op) {
+  std::vector<std::unique_ptr<Histogram>> latencies;
+  std::vector<BufferPoolManager::FetchStats> fetches(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    latencies.push_back(std::make_unique<Histogram>());
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + duration;
+  std::vector<std::thread> threads;
+  for (size_t id = 0; id < num_threads; id++) {
+    threads.emplace_back([&, id] {
+      PhaseWorker worker(id);
+      BufferPoolManager::FetchStats before = BufferPoolManager::GetThreadFetchStats();
+      auto op_start = std::chrono::steady_clock::now();
+      while (op_start < deadline && op(&worker)) {
+        auto op_end = std::chrono::steady_clock::now();
+        latencies[id]->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count());
+        op_start = op_end;
+      }
+      fetches[id].num_fetches_ = BufferPoolManager::GetThreadFetchStats().num_fetches_ - before.num_fetches_;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  PhaseResult result;
+  result.elapsed_ = std::chrono::steady_clock::now() - start;
+  for (size_t id = 0; id < num_threads; id++) {
+    result.num_fetches_ += fetches[id].num_fetches_;
+    result.latencies_ns_.Merge(latencies[id]->Snapshot());
+  }
+  result.num_ops_ = result.latencies_ns_.count_;
+  return result;
+}
+
+}  // namespace bustub
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_report.cpp
+//
+// Identification: tools/bench/bench_report.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace bustub {
+namespace {
+
+/** Reads the JSON that WriteJson writes: an object of an array of flat objects of strings and numbers. */
+class JsonReader {
+ public:
+  explicit JsonReader(std::string text) : text_(std::move(text)) {}
+
+  /** Skips the whitespace, then consumes c. @return false if the next character is not c */
+  bool Expect(char c) {
+    if (!Peek(c)) {
+      return false;
+    }
+    pos_++;
+    return true;
+  }
+
+  /** Skips the whitespace. @return whether the next character is c */
+  bool Peek(char c) {
+    SkipSpace();
+    return pos_ < text_.size() && text_[pos_] == c;
+  }
+
+  bool ReadString(std::string *out) {
+    if (!Expect('"')) {
+      return false;
+    }
+    out->clear();
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      if (text_[pos_] == '\\' && ++pos_ == text_.size()) {
+        return false;
+      }
+      out->push_back(text_[pos_++]);
+    }
+    return Expect('"');
+  }
+
+  bool ReadNumber(double *out) {
+    SkipSpace();
+    const char *start = text_.c_str() + pos_;
+    char *end;
+    *out = std::strtod(start, &end);
+    pos_ += end - start;
+    return end != start;
+  }
+
+  /** @return whether only whitespace is left */
+  bool AtEnd() {
+    SkipSpace();
+    return pos_ == text_.size();
+  }
+
+ private:
+  void SkipSpace() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])) != 0) {
+      pos_++;
+    }
+  }
+
+  std::string text_;
+  size_t pos_{0};
+};
+
+bool ReadRecord(JsonReader *reader, BenchRecord *record) {
+  if (!reader->Expect('{')) {
+    return false;
+  }
+  bool has_name = false;
+  bool has_throughput = false;
+  do {
+    std::string key;
+    if (!reader->ReadString(&key) || !reader->Expect(':')) {
+      return false;
+    }
+    if (key == "name") {
+      if (!reader->ReadString(&record->name_)) {
+        return false;
+      }
+      has_name = true;
+      continue;
+    }
+    double value;
+    if (!reader->ReadNumber(&value)) {
+      return false;
+    }
+    // The numbers this version does not know are skipped, so that older tools read newer reports.
+    if (key == "throughput") {
+      record->throughput_ = value;
+      has_throughput = true;
+    } else if (key == "p50_ns") {
+      record->p50_ns_ = static_cast<uint64_t>(value);
+    } else if (key == "p99_ns") {
+      record->p99_ns_ = static_cast<uint64_t>(value);
+    }
+  } while (reader->Expect(','));
+  return reader->Expect('}') && has_name && has_throughput;
+}
+
+}  // namespace
+
+void BenchReport::Add(std::string name, double throughput, uint64_t p50_ns, uint64_t p99_ns) {
+  records_.push_back({std::move(name), throughput, p50_ns, p99_ns});
+}
+
+bool BenchReport::WriteJson(const std::string &file_name) const {
+  std::vector<const BenchRecord *> sorted;
+  sorted.reserve(records_.size());
+  for (const auto &record : records_) {
+    sorted.push_back(&record);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const BenchRecord *a, const BenchRecord *b) { return a->name_ < b->name_; });
+
+  FILE *file = fopen(file_name.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file, "{\"benchmarks\": [");
+  for (size_t i = 0; i < sorted.size(); i++) {
+    std::string name;
+    for (char c : sorted[i]->name_) {
+      if (c == '"' || c == '\\') {
+        name.push_back('\\');
+      }
+      name.push_back(c);
+    }
+    fprintf(file, "%s\n  {\"name\": \"%s\", \"throughput\": %.1f, \"p50_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 "}",
+            i == 0 ? "" : ",", name.c_str(), sorted[i]->throughput_, sorted[i]->p50_ns_, sorted[i]->p99_ns_);
+  }
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
+
+bool BenchReport::ReadJson(const std::string &file_name, std::vector<BenchRecord> *records) {
+  std::ifstream file(file_name);
+  if (!file) {
+    return false;
+  }
+  JsonReader reader(std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()});
+  std::string key;
+  if (!reader.Expect('{') || !reader.ReadString(&key) || key != "benchmarks" || !reader.Expect(':') ||
+      !reader.Expect('[')) {
+    return false;
+  }
+  records->clear();
+  if (!reader.Peek(']')) {
+    do {
+      if (!ReadRecord(&reader, &records->emplace_back())) {
+        return false;
+      }
+    } while (reader.Expect(','));
+  }
+  return reader.Expect(']') && reader.Expect('}') && reader.AtEnd();
+}
+
+}  // namespace bustub
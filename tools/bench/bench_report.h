@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_report.h
+//
+// Identification: tools/bench/bench_report.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bustub {
+
+/** What one run of a benchmark measured, as the report keeps it. */
+struct BenchRecord {
+  /** The benchmark, its phase and its parameters, e.g. btree/lookup/key=8/threads=4, unique in a report. */
+  std::string name_;
+  /** The operations per second. */
+  double throughput_{0};
+  uint64_t p50_ns_{0};
+  uint64_t p99_ns_{0};
+};
+
+/**
+ * BenchReport collects the records of the runs of bustub_bench and writes them as JSON, for bench_compare to check a
+ * later report against, e.g.
+ *
+ *   {"benchmarks": [
+ *     {"name": "btree/lookup/key=8/threads=1", "throughput": 1523344.2, "p50_ns": 601, "p99_ns": 1870},
+ *     {"name": "oltp/threads=1", "throughput": 20411.9, "p50_ns": 40961, "p99_ns": 98303}
+ *   ]}
+ *
+ * The records are sorted by name, one per line, so that two reports of the same options diff line by line.
+ */
+class BenchReport {
+ public:
+  void Add(std::string name, double throughput, uint64_t p50_ns, uint64_t p99_ns);
+
+  const std::vector<BenchRecord> &GetRecords() const { return records_; }
+
+  /** @return false if the file cannot be written */
+  bool WriteJson(const std::string &file_name) const;
+
+  /**
+   * Reads the records of a report written by WriteJson.
+   * @return false if the file cannot be read or is not such a report
+   */
+  static bool ReadJson(const std::string &file_name, std::vector<BenchRecord> *records);
+
+ private:
+  std::vector<BenchRecord> records_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_bench.cpp
+//
+// Identification: tools/bench/buffer_pool_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer_pool_bench.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "bench_driver.h"
+#include "bench_report.h"
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/fetch_trace.h"
+#include "common/metrics.h"
+#include "common/util/hash_util.h"
+#include "common/util/zipf_distribution.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+namespace {
+
+constexpr const char *BPM_BENCH_DB_FILE = "bustub_bench_bpm.db";
+/** The accesses generated for each thread, which it goes through in a loop. */
+constexpr size_t GENERATED_TRACE_LENGTH = 1 << 20;
+
+const char *ReplacerName(ReplacerType replacer) {
+  switch (replacer) {
+    case ReplacerType::LRU:
+      return "lru";
+    case ReplacerType::LRU_K:
+      return "lru_k";
+    case ReplacerType::CLOCK:
+      return "clock";
+  }
+  return "";
+}
+
+/** @return the accesses of a thread, as indexes of the pages of the file */
+std::vector<size_t> GenerateTrace(const BufferPoolBenchOptions &options, size_t thread_id) {
+  std::vector<size_t> trace;
+  trace.reserve(GENERATED_TRACE_LENGTH);
+  size_t num_pages = options.num_pages_;
+  if (options.trace_ == "loop") {
+    for (size_t i = 0; i < GENERATED_TRACE_LENGTH; i++) {
+      trace.push_back((thread_id * num_pages / 8 + i) % num_pages);
+    }
+    return trace;
+  }
+
+  std::mt19937_64 random(thread_id + 1);
+  ZipfDistribution zipf(0, num_pages - 1, options.theta_);
+  std::uniform_int_distribution<size_t> uniform(0, num_pages - 1);
+  std::uniform_int_distribution<size_t> scan_length(100, 1000);
+  bool scans = options.trace_ == "scan";
+  while (trace.size() < GENERATED_TRACE_LENGTH) {
+    if (scans && uniform(random) % 100 == 0) {
+      size_t start = uniform(random);
+      for (size_t i = scan_length(random); i > 0 && trace.size() < GENERATED_TRACE_LENGTH; i--) {
+        trace.push_back(start++ % num_pages);
+      }
+      continue;
+    }
+    // Scrambled, so that the hot pages do not all sit at the start of the file.
+    trace.push_back(HashUtil::HashWords(zipf(random), 0) % num_pages);
+  }
+  return trace;
+}
+
+/** Writes num_pages empty pages to the file through a small pool. @return their ids */
+std::vector<page_id_t> CreatePages(DiskManager *disk_manager, size_t num_pages) {
+  BufferPoolManager bpm(64, disk_manager);
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    bpm.NewPage(&page_id);
+    bpm.UnpinPage(page_id, true);
+  }
+  bpm.FlushAllPages();
+  return page_ids;
+}
+
+struct RunResult {
+  std::chrono::nanoseconds elapsed_;
+  uint64_t num_fetches_{0};
+  uint64_t num_hits_{0};
+  HistogramSnapshot latencies_ns_;
+};
+
+/** Replays the traces, thread i going through traces[i % traces.size()] from offsets[i], until the run ends. */
+RunResult RunTrace(BufferPoolManager *bpm, const std::vector<std::vector<page_id_t>> &traces,
+                   const std::vector<size_t> &offsets, size_t num_threads, std::chrono::milliseconds duration) {
+  std::vector<std::unique_ptr<Histogram>> latencies;
+  std::vector<BufferPoolManager::FetchStats> stats(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    latencies.push_back(std::make_unique<Histogram>());
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + duration;
+  std::vector<std::thread> threads;
+  for (size_t id = 0; id < num_threads; id++) {
+    threads.emplace_back([&, id] {
+      const std::vector<page_id_t> &trace = traces[id % traces.size()];
+      Histogram *histogram = latencies[id].get();
+      BufferPoolManager::FetchStats before = BufferPoolManager::GetThreadFetchStats();
+      size_t next = offsets[id] % trace.size();
+      // Checking the clock every access would show in the latencies of hits.
+      while (std::chrono::steady_clock::now() < deadline) {
+        for (size_t i = 0; i < 1024; i++) {
+          page_id_t page_id = trace[next];
+          next = next + 1 == trace.size() ? 0 : next + 1;
+          auto op_start = std::chrono::steady_clock::now();
+          if (bpm->FetchPage(page_id) != nullptr) {
+            bpm->UnpinPage(page_id, false);
+          }
+          histogram->RecordSince<std::chrono::nanoseconds>(op_start);
+        }
+      }
+      BufferPoolManager::FetchStats after = BufferPoolManager::GetThreadFetchStats();
+      stats[id] = {after.num_fetches_ - before.num_fetches_, after.num_hits_ - before.num_hits_};
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  RunResult result;
+  result.elapsed_ = std::chrono::steady_clock::now() - start;
+  for (size_t id = 0; id < num_threads; id++) {
+    result.num_fetches_ += stats[id].num_fetches_;
+    result.num_hits_ += stats[id].num_hits_;
+    result.latencies_ns_.Merge(latencies[id]->Snapshot());
+  }
+  return result;
+}
+
+}  // namespace
+
+bool ParseReplacer(const std::string &name, ReplacerType *replacer) {
+  for (ReplacerType type : {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::CLOCK}) {
+    if (name == ReplacerName(type)) {
+      *replacer = type;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RunBufferPoolBench(const BufferPoolBenchOptions &options) {
+  size_t max_threads = 0;
+  for (size_t num_threads : options.thread_counts_) {
+    max_threads = std::max(max_threads, num_threads);
+  }
+
+  bool replayed = options.trace_.compare(0, 5, "file:") == 0;
+  std::vector<std::vector<page_id_t>> traces;
+  std::vector<size_t> offsets(max_threads, 0);
+  if (replayed) {
+    traces.push_back(FetchTraceWriter::Read(options.trace_.substr(5)));
+    if (traces[0].empty()) {
+      return false;
+    }
+  }
+
+  RemoveDatabaseFiles(BPM_BENCH_DB_FILE);
+  {
+    DiskManager disk_manager(BPM_BENCH_DB_FILE);
+    if (replayed) {
+      // One trace shared by all the threads, each starting its replay at a different point of it. The pages it
+      // fetches are created up to the largest id, so that the file holds all of them.
+      page_id_t max_page_id = 0;
+      for (page_id_t page_id : traces[0]) {
+        max_page_id = std::max(max_page_id, page_id);
+      }
+      CreatePages(&disk_manager, static_cast<size_t>(max_page_id) + 1);
+      for (size_t id = 0; id < max_threads; id++) {
+        offsets[id] = id * traces[0].size() / max_threads;
+      }
+    } else {
+      std::vector<page_id_t> page_ids = CreatePages(&disk_manager, options.num_pages_);
+      for (size_t id = 0; id < max_threads; id++) {
+        std::vector<page_id_t> &trace = traces.emplace_back();
+        for (size_t index : GenerateTrace(options, id)) {
+          trace.push_back(page_ids[index]);
+        }
+      }
+    }
+
+    printf("%-8s %8s %8s %12s %8s %10s %10s %10s\n", "replacer", "pool", "threads", "fetch/s", "hit %", "p50 ns",
+           "p99 ns", "max ns");
+    for (ReplacerType replacer : options.replacers_) {
+      for (size_t pool_size : options.pool_sizes_) {
+        for (size_t num_threads : options.thread_counts_) {
+          // A fresh pool each run, so that none starts warm from the one before.
+          BufferPoolManager bpm(pool_size, &disk_manager, nullptr, replacer);
+          RunResult result = RunTrace(&bpm, traces, offsets, num_threads, options.duration_);
+          double seconds = std::chrono::duration<double>(result.elapsed_).count();
+          double hit_ratio = result.num_fetches_ == 0 ? 0 : static_cast<double>(result.num_hits_) /
+                                                                static_cast<double>(result.num_fetches_);
+          double throughput = static_cast<double>(result.num_fetches_) / seconds;
+          const HistogramSnapshot &latencies = result.latencies_ns_;
+          printf("%-8s %8zu %8zu %12.0f %8.2f %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", ReplacerName(replacer),
+                 pool_size, num_threads, throughput, hit_ratio * 100, latencies.Percentile(0.5),
+                 latencies.Percentile(0.99), latencies.max_);
+          fflush(stdout);
+          if (options.report_ != nullptr) {
+            options.report_->Add("bpm/" + options.trace_ + "/" + ReplacerName(replacer) + "/pool=" +
+                                     std::to_string(pool_size) + "/threads=" + std::to_string(num_threads),
+                                 throughput, latencies.Percentile(0.5), latencies.Percentile(0.99));
+          }
+        }
+      }
+    }
+  }
+  RemoveDatabaseFiles(BPM_BENCH_DB_FILE);
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_bench.h
+//
+// Identification: tools/bench/buffer_pool_bench.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace bustub {
+
+class BenchReport;
+
+/**
+ * The options of the buffer pool microbenchmark. It fetches and unpins pages of a file, straight through
+ * BufferPoolManager, following an access trace, for every replacer, pool size and thread count.
+ */
+struct BufferPoolBenchOptions {
+  /**
+   * The access trace:
+   *   zipf       pages drawn from a Zipfian distribution of skew theta_, the hot pages spread over the file
+   *   scan       the zipf trace, with one sequential scan of 100 to 1000 pages in a hundred accesses
+   *   loop       each thread reads all the pages in turn, more of them than a pool usually holds
+   *   file:PATH  a trace recorded by FetchTraceWriter, replayed from a different offset by each thread
+   */
+  std::string trace_{"zipf"};
+  /** The pages of the file, for the generated traces. */
+  size_t num_pages_{10000};
+  /** The skew of the zipf and scan traces, in [0, 1). */
+  double theta_{0.99};
+  std::vector<size_t> pool_sizes_{256, 1024, 4096};
+  std::vector<ReplacerType> replacers_{ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K};
+  std::vector<size_t> thread_counts_{1, 2, 4, 8};
+  /** How long each run lasts. */
+  std::chrono::milliseconds duration_{std::chrono::seconds(2)};
+  /** Where to add a record of each run too, bpm/TRACE/REPLACER/pool=N/threads=N, none if nullptr. */
+  BenchReport *report_{nullptr};
+};
+
+/** @return the replacer named lru, clock or lru_k, in *replacer; false if the name is unknown */
+bool ParseReplacer(const std::string &name, ReplacerType *replacer);
+
+/**
+ * Runs the buffer pool microbenchmark on a file of its own, and prints, for each run, the fetches per second, the hit
+ * ratio and the percentiles of the latency of a fetch and its unpin.
+ * @return false if the trace cannot be read or is empty
+ */
+bool RunBufferPoolBench(const BufferPoolBenchOptions &options);
+
+}  // namespace bustub
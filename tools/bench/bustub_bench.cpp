@@ -0,0 +1,367 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bustub_bench.cpp
+//
+// Identification: tools/bench/bustub_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * bustub_bench runs workloads against a BustubInstance on a growing number of threads, and prints the throughput and
+ * latency percentiles of each run, e.g.
+ *
+ *   bustub_bench --workload=oltp --rows=100000 --skew=zipf_99 --threads=1,2,4,8 --duration=5
+ *   bustub_bench --workload=ycsb,tpcc --ycsb=AB --warehouses=2 --logging=on --pool=8192
+ *   bustub_bench --workload=bpm --trace=scan --skew=zipf_99 --pool-sizes=256,4096 --replacers=lru,clock
+ *   bustub_bench --workload=btree --rows=1000000 --key-sizes=8,64 --threads=1,16,64 --pool=32768
+ *   bustub_bench --workload=ycsb --ycsb=B --threads=4 --page-trace=ycsb.trace
+ *   bustub_bench --workload=hash,lock,log --threads=1,8 --duration=1 --json=bench.json
+ *
+ * With --json, the results are written to a report too, for bench_compare to check against a baseline; the bench and
+ * bench-check targets run it so, see tools/bench/CMakeLists.txt. See Usage for the options.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "b_plus_tree_bench.h"
+#include "bench_driver.h"
+#include "bench_report.h"
+#include "buffer_pool_bench.h"
+#include "component_bench.h"
+#include "concurrency/transaction_manager.h"
+#include "table_workload.h"
+#include "tpcc_workload.h"
+#include "ycsb_workload.h"
+
+namespace bustub {
+namespace {
+
+constexpr const char *BENCH_DB_FILE = "bustub_bench.db";
+
+struct BenchOptions {
+  std::vector<std::string> workloads_{"oltp", "scan"};
+  std::string ycsb_kinds_{"ABCDEF"};
+  int32_t num_warehouses_{4};
+  bool logging_{false};
+  uint32_t num_rows_{100000};
+  TableGenerator::Dist skew_{TableGenerator::Dist::Uniform};
+  std::vector<size_t> thread_counts_{1, 2, 4, 8};
+  int read_percent_{50};
+  int update_percent_{40};
+  size_t pool_size_{4096};
+  size_t num_bpm_instances_{1};
+  BenchRunOptions run_;
+  /** The buffer pool microbenchmark, run apart from the other workloads. */
+  bool buffer_pool_{false};
+  BufferPoolBenchOptions buffer_pool_options_;
+  /** The B+ tree benchmark, run apart from the other workloads too. */
+  bool b_plus_tree_{false};
+  BPlusTreeBenchOptions b_plus_tree_options_;
+  /** The microbenchmarks of the hash table, the lock manager and the log manager, run apart as well. */
+  bool hash_table_{false};
+  bool lock_manager_{false};
+  bool log_manager_{false};
+  ComponentBenchOptions component_options_;
+  /** Where to write the report of the runs, none if empty, see BenchReport. */
+  std::string json_file_;
+  /** Where to write the page accesses of the workload runs, none if empty, see page_trace_report. */
+  std::string page_trace_file_;
+  size_t page_trace_ring_size_{PAGE_ACCESS_RING_SIZE};
+};
+
+void Usage() {
+  fprintf(stderr,
+          "usage: bustub_bench [options]\n"
+          "  --workload=oltp,scan,ycsb,tpcc,bpm,btree,hash,lock,log\n"
+          "                               the workloads to run (oltp,scan)\n"
+          "  --rows=N                     the rows of oltp, scan, ycsb and lock, the keys of btree and hash (100000)\n"
+          "  --skew=uniform|zipf_50|zipf_75|zipf_95|zipf_99\n"
+          "                               the skew of the ids and pages accessed and of column k (uniform)\n"
+          "  --threads=1,2,4,8            the thread counts to run each workload with\n"
+          "  --duration=SECONDS           how long each run lasts (5)\n"
+          "  --read=PERCENT               the point reads of the OLTP mix (50) and of the btree mix (90)\n"
+          "  --update=PERCENT             the updates of the OLTP mix (40), the rest are inserts\n"
+          "  --ycsb=ABCDEF                the YCSB workloads to run (ABCDEF)\n"
+          "  --warehouses=N               the warehouses of TPC-C (4)\n"
+          "  --logging=on|off             write-ahead logging of the runs (off)\n"
+          "  --mode=locking|optimistic    how transactions keep their reads consistent (locking)\n"
+          "  --pool=FRAMES                the frames of each buffer pool instance, of btree and of hash (4096)\n"
+          "  --bpm-instances=N            the buffer pool instances (1)\n"
+          "  --trace=zipf|scan|loop|file:PATH\n"
+          "                               the page accesses of bpm (zipf)\n"
+          "  --pages=N                    the pages of the file of bpm (10000)\n"
+          "  --pool-sizes=256,1024,4096   the pool sizes to run bpm with\n"
+          "  --replacers=lru,clock,lru_k  the replacers to run bpm with\n"
+          "  --key-sizes=8,16,32,64       the key sizes to run btree with\n"
+          "  --scan-length=N              the keys of each btree scan (100)\n"
+          "  --probe-batch=N              the keys of each btree probe batch (64)\n"
+          "  --page-trace=FILE            write the page accesses of the runs to FILE, for page_trace_report\n"
+          "  --page-trace-ring=N          the last page accesses of each thread written (65536)\n"
+          "  --json=FILE                  write the results to FILE too, for bench_compare\n");
+}
+
+std::vector<std::string> Split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+bool ParseSkew(const std::string &value, TableGenerator::Dist *skew) {
+  static const std::pair<const char *, TableGenerator::Dist> SKEWS[] = {
+      {"uniform", TableGenerator::Dist::Uniform}, {"zipf_50", TableGenerator::Dist::Zipf_50},
+      {"zipf_75", TableGenerator::Dist::Zipf_75}, {"zipf_95", TableGenerator::Dist::Zipf_95},
+      {"zipf_99", TableGenerator::Dist::Zipf_99}};
+  for (const auto &[name, dist] : SKEWS) {
+    if (value == name) {
+      *skew = dist;
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Removes a workload run apart from the others from the list. @return whether the list had it */
+bool TakeWorkload(std::vector<std::string> *workloads, const std::string &name) {
+  auto end = std::remove(workloads->begin(), workloads->end(), name);
+  bool taken = end != workloads->end();
+  workloads->erase(end, workloads->end());
+  return taken;
+}
+
+/** @return false if an option is unknown or malformed */
+bool ParseOptions(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    size_t equals = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || equals == std::string::npos) {
+      return false;
+    }
+    std::string name = arg.substr(2, equals - 2);
+    std::string value = arg.substr(equals + 1);
+    if (name == "workload") {
+      options->workloads_ = Split(value);
+      for (const auto &workload : options->workloads_) {
+        if (workload != "oltp" && workload != "scan" && workload != "ycsb" && workload != "tpcc" &&
+            workload != "bpm" && workload != "btree" && workload != "hash" && workload != "lock" &&
+            workload != "log") {
+          return false;
+        }
+      }
+      options->buffer_pool_ = TakeWorkload(&options->workloads_, "bpm");
+      options->b_plus_tree_ = TakeWorkload(&options->workloads_, "btree");
+      options->hash_table_ = TakeWorkload(&options->workloads_, "hash");
+      options->lock_manager_ = TakeWorkload(&options->workloads_, "lock");
+      options->log_manager_ = TakeWorkload(&options->workloads_, "log");
+    } else if (name == "ycsb" && !value.empty() && value.find_first_not_of("ABCDEF") == std::string::npos) {
+      options->ycsb_kinds_ = value;
+    } else if (name == "warehouses") {
+      options->num_warehouses_ = std::stoi(value);
+    } else if (name == "logging" && (value == "on" || value == "off")) {
+      options->logging_ = value == "on";
+    } else if (name == "rows") {
+      options->num_rows_ = std::stoul(value);
+    } else if (name == "skew") {
+      if (!ParseSkew(value, &options->skew_)) {
+        return false;
+      }
+    } else if (name == "threads") {
+      options->thread_counts_.clear();
+      for (const auto &count : Split(value)) {
+        options->thread_counts_.push_back(std::stoul(count));
+      }
+    } else if (name == "duration") {
+      options->run_.duration_ = std::chrono::milliseconds(static_cast<int64_t>(std::stod(value) * 1000));
+    } else if (name == "read") {
+      options->read_percent_ = std::stoi(value);
+      options->b_plus_tree_options_.read_percent_ = options->read_percent_;
+    } else if (name == "update") {
+      options->update_percent_ = std::stoi(value);
+    } else if (name == "mode" && (value == "locking" || value == "optimistic")) {
+      options->run_.concurrency_mode_ = value == "locking" ? ConcurrencyMode::LOCKING : ConcurrencyMode::OPTIMISTIC;
+    } else if (name == "pool") {
+      options->pool_size_ = std::stoul(value);
+    } else if (name == "bpm-instances") {
+      options->num_bpm_instances_ = std::stoul(value);
+    } else if (name == "trace" &&
+               (value == "zipf" || value == "scan" || value == "loop" || value.compare(0, 5, "file:") == 0)) {
+      options->buffer_pool_options_.trace_ = value;
+    } else if (name == "pages") {
+      options->buffer_pool_options_.num_pages_ = std::stoul(value);
+    } else if (name == "pool-sizes") {
+      options->buffer_pool_options_.pool_sizes_.clear();
+      for (const auto &size : Split(value)) {
+        options->buffer_pool_options_.pool_sizes_.push_back(std::stoul(size));
+      }
+    } else if (name == "replacers") {
+      options->buffer_pool_options_.replacers_.clear();
+      for (const auto &replacer : Split(value)) {
+        if (!ParseReplacer(replacer, &options->buffer_pool_options_.replacers_.emplace_back())) {
+          return false;
+        }
+      }
+    } else if (name == "key-sizes") {
+      options->b_plus_tree_options_.key_sizes_.clear();
+      for (const auto &size : Split(value)) {
+        options->b_plus_tree_options_.key_sizes_.push_back(std::stoul(size));
+        if (!IsBenchKeySize(options->b_plus_tree_options_.key_sizes_.back())) {
+          return false;
+        }
+      }
+    } else if (name == "page-trace" && !value.empty()) {
+      options->page_trace_file_ = value;
+    } else if (name == "page-trace-ring") {
+      options->page_trace_ring_size_ = std::stoul(value);
+    } else if (name == "scan-length") {
+      options->b_plus_tree_options_.scan_length_ = std::stol(value);
+    } else if (name == "probe-batch") {
+      options->b_plus_tree_options_.probe_batch_ = std::stoul(value);
+    } else if (name == "json" && !value.empty()) {
+      options->json_file_ = value;
+    } else {
+      return false;
+    }
+  }
+  BufferPoolBenchOptions &buffer_pool = options->buffer_pool_options_;
+  buffer_pool.thread_counts_ = options->thread_counts_;
+  buffer_pool.duration_ = options->run_.duration_;
+  buffer_pool.theta_ = options->skew_ == TableGenerator::Dist::Uniform ? 0 : TableGenerator::ZipfTheta(options->skew_);
+  BPlusTreeBenchOptions &b_plus_tree = options->b_plus_tree_options_;
+  b_plus_tree.num_keys_ = options->num_rows_;
+  b_plus_tree.thread_counts_ = options->thread_counts_;
+  b_plus_tree.pool_size_ = options->pool_size_;
+  b_plus_tree.duration_ = options->run_.duration_;
+  ComponentBenchOptions &component = options->component_options_;
+  component.num_keys_ = options->num_rows_;
+  component.thread_counts_ = options->thread_counts_;
+  component.pool_size_ = options->pool_size_;
+  component.duration_ = options->run_.duration_;
+  return options->read_percent_ + options->update_percent_ <= 100 && options->num_warehouses_ > 0 &&
+         buffer_pool.num_pages_ > 0 && b_plus_tree.num_keys_ > 0 && b_plus_tree.scan_length_ > 0 &&
+         b_plus_tree.probe_batch_ > 0 && options->page_trace_ring_size_ > 0;
+}
+
+}  // namespace
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  using bustub::BenchWorkload;
+
+  bustub::BenchOptions options;
+  try {
+    if (!bustub::ParseOptions(argc, argv, &options)) {
+      bustub::Usage();
+      return 1;
+    }
+  } catch (const std::logic_error &e) {
+    bustub::Usage();
+    return 1;
+  }
+
+  bustub::BenchReport report;
+  bustub::BenchReport *report_to = options.json_file_.empty() ? nullptr : &report;
+  options.buffer_pool_options_.report_ = report_to;
+  options.b_plus_tree_options_.report_ = report_to;
+  options.component_options_.report_ = report_to;
+
+  if (options.buffer_pool_ && !bustub::RunBufferPoolBench(options.buffer_pool_options_)) {
+    fprintf(stderr, "can't read the trace %s\n", options.buffer_pool_options_.trace_.c_str());
+    return 1;
+  }
+  if (options.b_plus_tree_) {
+    bustub::RunBPlusTreeBench(options.b_plus_tree_options_);
+  }
+  if (options.hash_table_) {
+    bustub::RunHashTableBench(options.component_options_);
+  }
+  if (options.lock_manager_) {
+    bustub::RunLockManagerBench(options.component_options_);
+  }
+  if (options.log_manager_) {
+    bustub::RunLogManagerBench(options.component_options_);
+  }
+
+  bustub::RemoveDatabaseFiles(bustub::BENCH_DB_FILE);
+  if (!options.workloads_.empty()) {
+    bustub::BustubInstance instance(bustub::BENCH_DB_FILE, options.num_bpm_instances_, options.pool_size_);
+    bustub::ExecutionEngine engine(instance.buffer_pool_manager_, instance.transaction_manager_, instance.catalog_);
+    bustub::BenchTable table(options.num_rows_, options.skew_);
+    bustub::YcsbTable ycsb_table(options.num_rows_, options.skew_);
+
+    std::vector<std::unique_ptr<BenchWorkload>> workloads;
+    for (const auto &name : options.workloads_) {
+      if (name == "oltp") {
+        workloads.push_back(
+            std::make_unique<bustub::OltpWorkload>(&table, options.read_percent_, options.update_percent_));
+      } else if (name == "scan") {
+        workloads.push_back(std::make_unique<bustub::ScanWorkload>(&table));
+      } else if (name == "ycsb") {
+        for (char kind : options.ycsb_kinds_) {
+          workloads.push_back(std::make_unique<bustub::YcsbWorkload>(&ycsb_table, kind));
+        }
+      } else {
+        workloads.push_back(std::make_unique<bustub::TpccWorkload>(options.num_warehouses_));
+      }
+    }
+
+    bustub::Transaction *txn = instance.transaction_manager_->Begin();
+    for (auto &workload : workloads) {
+      workload->Load(&instance, &engine, txn);
+    }
+    instance.transaction_manager_->Commit(txn);
+    delete txn;
+    // After the load, so that only the runs are logged; the instance stops the flush thread.
+    if (options.logging_) {
+      instance.log_manager_->RunFlushThread();
+    }
+
+    std::unique_ptr<bustub::PageAccessTracer> tracer;
+    if (!options.page_trace_file_.empty()) {
+      tracer = std::make_unique<bustub::PageAccessTracer>(options.page_trace_ring_size_);
+      instance.buffer_pool_manager_->SetFetchTrace(tracer.get());
+    }
+
+    bustub::PrintResultHeader();
+    for (auto &workload : workloads) {
+      for (size_t num_threads : options.thread_counts_) {
+        bustub::BenchResult result = bustub::RunWorkload(workload.get(), &instance, &engine, num_threads, options.run_);
+        bustub::PrintResult(result);
+        report.Add(result.workload_ + "/threads=" + std::to_string(num_threads), result.Throughput(),
+                   result.Percentile(0.5).count(), result.Percentile(0.99).count());
+      }
+    }
+
+    if (tracer != nullptr) {
+      instance.buffer_pool_manager_->SetFetchTrace(nullptr);
+      if (!bustub::WritePageTrace(*tracer, &instance, options.page_trace_file_)) {
+        fprintf(stderr, "can't write the trace %s\n", options.page_trace_file_.c_str());
+      } else if (tracer->GetNumOverwritten() > 0) {
+        fprintf(stderr, "the trace lacks the %" PRIu64 " oldest page accesses, see --page-trace-ring\n",
+                tracer->GetNumOverwritten());
+      }
+    }
+  }
+  bustub::RemoveDatabaseFiles(bustub::BENCH_DB_FILE);
+
+  if (report_to != nullptr && !report.WriteJson(options.json_file_)) {
+    fprintf(stderr, "can't write the report %s\n", options.json_file_.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// component_bench.cpp
+//
+// Identification: tools/bench/component_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "component_bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_driver.h"
+#include "bench_report.h"
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_record.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+namespace {
+
+constexpr const char *HASH_BENCH_DB_FILE = "bustub_bench_hash.db";
+constexpr const char *LOG_BENCH_DB_FILE = "bustub_bench_log.db";
+/** The duration of the phases that run until their operations are exhausted. */
+constexpr std::chrono::milliseconds FOREVER = std::chrono::hours(24);
+/** The rows a transaction of the lock manager benchmark locks. */
+constexpr size_t LOCKS_PER_TXN = 4;
+/** The rows of a page, for the RIDs of the rows the lock manager benchmark locks. */
+constexpr uint32_t ROWS_PER_PAGE = 64;
+
+void PrintPhaseHeader() {
+  printf("%-6s %-18s %8s %12s %10s %10s %10s\n", "bench", "phase", "threads", "ops/s", "p50 us", "p99 us", "max us");
+}
+
+/** Prints the result of a phase, and adds it to the report if any, as BENCH/PHASE/threads=N. */
+void PrintPhase(const char *bench, const std::string &phase, size_t num_threads, const PhaseResult &result,
+                BenchReport *report) {
+  auto micros = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+  double throughput = static_cast<double>(result.num_ops_) / std::chrono::duration<double>(result.elapsed_).count();
+  const HistogramSnapshot &latencies = result.latencies_ns_;
+  printf("%-6s %-18s %8zu %12.0f %10.2f %10.2f %10.1f\n", bench, phase.c_str(), num_threads, throughput,
+         micros(latencies.Percentile(0.5)), micros(latencies.Percentile(0.99)), micros(latencies.max_));
+  fflush(stdout);
+  if (report != nullptr) {
+    report->Add(std::string(bench) + "/" + phase + "/threads=" + std::to_string(num_threads), throughput,
+                latencies.Percentile(0.5), latencies.Percentile(0.99));
+  }
+}
+
+/** @return the RID of a row the lock manager benchmark locks */
+RID RowRid(int64_t row) {
+  return RID(static_cast<page_id_t>(row / ROWS_PER_PAGE), static_cast<uint32_t>(row % ROWS_PER_PAGE));
+}
+
+int64_t PickKey(const ComponentBenchOptions &options, PhaseWorker *worker) {
+  return std::uniform_int_distribution<int64_t>(0, static_cast<int64_t>(options.num_keys_) - 1)(worker->random_);
+}
+
+}  // namespace
+
+void RunHashTableBench(const ComponentBenchOptions &options) {
+  using HashTable = LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+  Schema key_schema({Column("key", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  auto make_key = [](int64_t key) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    return index_key;
+  };
+
+  PrintPhaseHeader();
+  for (size_t num_threads : options.thread_counts_) {
+    RemoveDatabaseFiles(HASH_BENCH_DB_FILE);
+    {
+      DiskManager disk_manager(HASH_BENCH_DB_FILE);
+      BufferPoolManager bpm(options.pool_size_, &disk_manager);
+      // As many buckets as keys, so that the inserts measure the probes rather than the growth of the table.
+      HashTable table("bench_hash", &bpm, comparator, options.num_keys_, HashFunction<GenericKey<8>>());
+
+      std::atomic<int64_t> next_key{0};
+      auto num_keys = static_cast<int64_t>(options.num_keys_);
+      PrintPhase("hash", "insert", num_threads, RunPhase(num_threads, FOREVER, [&](PhaseWorker *worker) {
+                   int64_t key = next_key++;
+                   if (key >= num_keys) {
+                     return false;
+                   }
+                   table.Insert(&worker->txn_, make_key(key), RID(static_cast<int32_t>(key >> 32),
+                                                                  static_cast<uint32_t>(key)));
+                   return true;
+                 }),
+                 options.report_);
+
+      PrintPhase("hash", "lookup", num_threads, RunPhase(num_threads, options.duration_, [&](PhaseWorker *worker) {
+                   std::vector<RID> result;
+                   table.GetValue(&worker->txn_, make_key(PickKey(options, worker)), &result);
+                   return true;
+                 }),
+                 options.report_);
+    }
+    RemoveDatabaseFiles(HASH_BENCH_DB_FILE);
+  }
+}
+
+void RunLockManagerBench(const ComponentBenchOptions &options) {
+  PrintPhaseHeader();
+  for (size_t num_threads : options.thread_counts_) {
+    for (bool exclusive : {false, true}) {
+      LockManager lock_manager;
+      std::atomic<txn_id_t> next_txn_id{0};
+      PhaseResult result = RunPhase(num_threads, options.duration_, [&](PhaseWorker *worker) {
+        std::vector<int64_t> rows;
+        while (rows.size() < std::min(LOCKS_PER_TXN, options.num_keys_)) {
+          int64_t row = PickKey(options, worker);
+          if (std::find(rows.begin(), rows.end(), row) == rows.end()) {
+            rows.push_back(row);
+          }
+        }
+        // In the same order by every transaction, which then never wait for each other in a cycle.
+        std::sort(rows.begin(), rows.end());
+        Transaction txn(next_txn_id++);
+        for (int64_t row : rows) {
+          if (exclusive) {
+            lock_manager.LockExclusive(&txn, RowRid(row));
+          } else {
+            lock_manager.LockShared(&txn, RowRid(row));
+          }
+        }
+        for (int64_t row : rows) {
+          lock_manager.Unlock(&txn, RowRid(row));
+        }
+        return true;
+      });
+      PrintPhase("lock", exclusive ? "exclusive" : "shared", num_threads, result, options.report_);
+    }
+  }
+}
+
+void RunLogManagerBench(const ComponentBenchOptions &options) {
+  PrintPhaseHeader();
+  for (size_t num_threads : options.thread_counts_) {
+    for (LogBufferMode buffer_mode : {LogBufferMode::SHARED, LogBufferMode::PER_THREAD}) {
+      std::string mode = buffer_mode == LogBufferMode::SHARED ? "shared" : "per_thread";
+      RemoveDatabaseFiles(LOG_BENCH_DB_FILE);
+      {
+        DiskManager disk_manager(LOG_BENCH_DB_FILE);
+        LogManager log_manager(&disk_manager, buffer_mode);
+        log_manager.RunFlushThread();
+        std::atomic<txn_id_t> next_txn_id{0};
+
+        PrintPhase("log", "append/" + mode, num_threads,
+                   RunPhase(num_threads, options.duration_,
+                            [&](PhaseWorker * /*worker*/) {
+                              LogRecord record(next_txn_id++, INVALID_LSN, LogRecordType::COMMIT);
+                              log_manager.AppendLogRecord(&record);
+                              return true;
+                            }),
+                   options.report_);
+
+        PrintPhase("log", "commit/" + mode, num_threads,
+                   RunPhase(num_threads, options.duration_,
+                            [&](PhaseWorker * /*worker*/) {
+                              LogRecord record(next_txn_id++, INVALID_LSN, LogRecordType::COMMIT);
+                              log_manager.WaitUntilPersistent(log_manager.AppendLogRecord(&record));
+                              return true;
+                            }),
+                   options.report_);
+        log_manager.StopFlushThread();
+      }
+      RemoveDatabaseFiles(LOG_BENCH_DB_FILE);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// component_bench.h
+//
+// Identification: tools/bench/component_bench.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <vector>
+
+namespace bustub {
+
+class BenchReport;
+
+/**
+ * The options of the microbenchmarks of the components the executors build on, each run straight through the
+ * component, on a file of its own, for every thread count:
+ *
+ *   hash  LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>
+ *           insert  num_keys_ keys, the threads taking the next one in turns
+ *           lookup  point lookups of random keys among them
+ *   lock  LockManager, each operation a transaction of its own that locks 4 random rows of num_keys_, in order so
+ *         that it never deadlocks, then unlocks them
+ *           shared, exclusive  the mode of the locks
+ *   log   LogManager, its flush thread running, for each LogBufferMode
+ *           append  a COMMIT record appended
+ *           commit  a COMMIT record appended, then waited for until it is on disk
+ */
+struct ComponentBenchOptions {
+  size_t num_keys_{100000};
+  std::vector<size_t> thread_counts_{1, 2, 4, 8};
+  /** The frames of the buffer pool of the hash table. */
+  size_t pool_size_{4096};
+  /** How long the phases last, but for the inserts, which last until all the keys are in. */
+  std::chrono::milliseconds duration_{std::chrono::seconds(2)};
+  /** Where to add a record of each phase too, e.g. hash/lookup/threads=N, none if nullptr. */
+  BenchReport *report_{nullptr};
+};
+
+/**
+ * Each runs a microbenchmark, and prints, for each phase, the operations per second and the percentiles of the latency
+ * of an operation.
+ */
+void RunHashTableBench(const ComponentBenchOptions &options);
+void RunLockManagerBench(const ComponentBenchOptions &options);
+void RunLogManagerBench(const ComponentBenchOptions &options);
+
+}  // namespace bustub
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_workload.cpp
+//
+// Identification: tools/bench/table_workload.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "table_workload.h"
+
+#include <vector>
+
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+BenchTable::BenchTable(uint32_t num_rows, TableGenerator::Dist skew)
+    : num_rows_(num_rows), skew_(skew), next_id_(static_cast<int32_t>(num_rows)) {
+  if (skew != TableGenerator::Dist::Uniform && num_rows > 0) {
+    zipf_.emplace(0, num_rows - 1, TableGenerator::ZipfTheta(skew));
+  }
+}
+
+void BenchTable::Load(BustubInstance *instance, Transaction *txn) {
+  if (table_ != nullptr) {
+    return;
+  }
+  ExecutorContext exec_ctx(txn, instance->catalog_, instance->buffer_pool_manager_, instance->transaction_manager_,
+                           instance->lock_manager_);
+  TableGenerator gen{&exec_ctx};
+  using Dist = TableGenerator::Dist;
+  TableGenerator::TableInsertMeta table_meta{"bench_table",
+                                             num_rows_,
+                                             {{"id", TypeId::INTEGER, false, Dist::Serial, 0, 0},
+                                              {"k", TypeId::INTEGER, false, skew_, 0, 9999},
+                                              {"val", TypeId::INTEGER, false, Dist::Uniform, 0, 999999},
+                                              {"grp", TypeId::INTEGER, false, Dist::Uniform, 0, 99}}};
+  table_ = gen.GenerateTable(&table_meta);
+  Schema key_schema({Column("id", TypeId::INTEGER)});
+  id_index_ = instance->catalog_->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      txn, "bench_table_id", "bench_table", table_->schema_, key_schema, {0}, 8);
+}
+
+int32_t BenchTable::PickId(std::mt19937_64 *random) const {
+  if (zipf_.has_value()) {
+    // A copy, since drawing changes the state of the distribution and the workers share the table.
+    ZipfDistribution zipf = *zipf_;
+    return static_cast<int32_t>(zipf(*random));
+  }
+  return std::uniform_int_distribution<int32_t>(0, static_cast<int32_t>(num_rows_) - 1)(*random);
+}
+
+void OltpWorkload::Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) {
+  table_->Load(instance, txn);
+}
+
+void OltpWorkload::RunOperation(BenchWorker *worker) {
+  PlanBuilder &plans = worker->plans_;
+  const Schema &schema = table_->table_->schema_;
+  int percent = std::uniform_int_distribution<int>(0, 99)(worker->random_);
+  if (percent >= read_percent_ + update_percent_) {
+    int32_t id = table_->NextId();
+    auto draw = [worker](int32_t max) { return std::uniform_int_distribution<int32_t>(0, max)(worker->random_); };
+    std::vector<std::vector<Value>> raw_values{
+        {ValueFactory::GetIntegerValue(id), ValueFactory::GetIntegerValue(draw(9999)),
+         ValueFactory::GetIntegerValue(draw(999999)), ValueFactory::GetIntegerValue(draw(99))}};
+    InsertPlanNode insert_plan{std::move(raw_values), table_->table_->oid_};
+    worker->Execute(&insert_plan, nullptr);
+    return;
+  }
+
+  // SELECT id, val FROM bench_table WHERE id = ?, through the index
+  Value id = ValueFactory::GetIntegerValue(table_->PickId(&worker->random_));
+  auto *id_column = plans.ColumnValue(schema, 0, "id");
+  auto *predicate = plans.Compare(id_column, plans.Constant(id), ComparisonType::Equal);
+  auto *out_schema = plans.OutputSchema({{"id", id_column}, {"val", plans.ColumnValue(schema, 0, "val")}});
+  IndexScanPlanNode scan_plan{out_schema, predicate, table_->id_index_->index_oid_, false, id, id};
+  if (percent < read_percent_) {
+    std::vector<Tuple> result_set;
+    worker->Execute(&scan_plan, &result_set);
+    return;
+  }
+  // UPDATE bench_table SET val = val + 1 WHERE id = ?
+  UpdatePlanNode update_plan{&scan_plan, table_->table_->oid_, update_attrs_};
+  worker->Execute(&update_plan, nullptr);
+}
+
+void ScanWorkload::Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) {
+  table_->Load(instance, txn);
+}
+
+void ScanWorkload::RunOperation(BenchWorker *worker) {
+  PlanBuilder &plans = worker->plans_;
+  const Schema &schema = table_->table_->schema_;
+  std::vector<Tuple> result_set;
+  if (std::uniform_int_distribution<int>(0, 1)(worker->random_) == 0) {
+    // SELECT COUNT(*) FROM bench_table
+    auto *id = plans.ColumnValue(schema, 0, "id");
+    auto *scan_schema = plans.OutputSchema({{"id", id}});
+    SeqScanPlanNode scan_plan{scan_schema, nullptr, table_->table_->oid_};
+    auto *count = plans.AggregateValue(false, 0, TypeId::INTEGER);
+    auto *agg_schema = plans.OutputSchema({{"count", count}});
+    AggregationPlanNode agg_plan{agg_schema, &scan_plan, nullptr, {}, {id}, {AggregationType::CountAggregate}};
+    worker->Execute(&agg_plan, &result_set);
+    return;
+  }
+
+  // SELECT grp, COUNT(*), SUM(val) FROM bench_table WHERE k < 100 GROUP BY grp
+  auto *k = plans.ColumnValue(schema, 0, "k");
+  auto *predicate = plans.Compare(k, plans.Constant(ValueFactory::GetIntegerValue(100)), ComparisonType::LessThan);
+  auto *val = plans.ColumnValue(schema, 0, "val");
+  auto *grp = plans.ColumnValue(schema, 0, "grp");
+  auto *scan_schema = plans.OutputSchema({{"grp", grp}, {"val", val}});
+  SeqScanPlanNode scan_plan{scan_schema, predicate, table_->table_->oid_};
+  auto *scan_val = plans.ColumnValue(*scan_schema, 0, "val");
+  auto *scan_grp = plans.ColumnValue(*scan_schema, 0, "grp");
+  auto *agg_schema = plans.OutputSchema({{"grp", plans.AggregateValue(true, 0, TypeId::INTEGER)},
+                                         {"count", plans.AggregateValue(false, 0, TypeId::INTEGER)},
+                                         {"sum", plans.AggregateValue(false, 1, TypeId::INTEGER)}});
+  AggregationPlanNode agg_plan{agg_schema,
+                               &scan_plan,
+                               nullptr,
+                               {scan_grp},
+                               {scan_val, scan_val},
+                               {AggregationType::CountAggregate, AggregationType::SumAggregate}};
+  worker->Execute(&agg_plan, &result_set);
+}
+
+}  // namespace bustub
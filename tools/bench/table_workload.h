@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_workload.h
+//
+// Identification: tools/bench/table_workload.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "bench_driver.h"
+#include "catalog/table_generator.h"
+#include "common/util/zipf_distribution.h"
+#include "execution/plans/update_plan.h"
+
+namespace bustub {
+
+/**
+ * The table of the OLTP and scan workloads, generated by TableGenerator:
+ *
+ *   bench_table (id INTEGER, k INTEGER, val INTEGER, grp INTEGER), with a unique index on id
+ *
+ * id is serial, k is drawn from [0, 9999] with the skew of the run, val from [0, 999999] and grp from [0, 99]
+ * uniformly. The operations pick the ids they read and update with the same skew, the hot ids being the smallest.
+ */
+class BenchTable {
+ public:
+  BenchTable(uint32_t num_rows, TableGenerator::Dist skew);
+
+  /** Creates the table and its index and fills them; idempotent, so that both workloads may load the table. */
+  void Load(BustubInstance *instance, Transaction *txn);
+
+  /** @return an id of the loaded rows, drawn with the skew of the run */
+  int32_t PickId(std::mt19937_64 *random) const;
+
+  /** @return a new id, past those of all the rows */
+  int32_t NextId() { return next_id_++; }
+
+  uint32_t num_rows_;
+  TableGenerator::Dist skew_;
+  TableMetadata *table_{nullptr};
+  IndexInfo *id_index_{nullptr};
+
+ private:
+  std::optional<ZipfDistribution> zipf_;
+  std::atomic<int32_t> next_id_;
+};
+
+/**
+ * The OLTP mix: point reads and updates of a row by its id through the index, and inserts of new rows, which also go
+ * into the index. Each operation is a transaction of its own.
+ */
+class OltpWorkload : public BenchWorkload {
+ public:
+  /**
+   * @param read_percent the share of the operations that read a row
+   * @param update_percent the share of the operations that update a row; the others insert one
+   */
+  OltpWorkload(BenchTable *table, int read_percent, int update_percent)
+      : table_(table), read_percent_(read_percent), update_percent_(update_percent) {}
+
+  std::string Name() const override { return "oltp"; }
+  void Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) override;
+  void RunOperation(BenchWorker *worker) override;
+
+ private:
+  BenchTable *table_;
+  int read_percent_;
+  int update_percent_;
+  /** val = val + 1 */
+  const std::unordered_map<uint32_t, UpdateInfo> update_attrs_{{2, UpdateInfo(UpdateType::Add, 1)}};
+};
+
+/**
+ * The analytical queries, run in turns: a count of all the rows, and
+ *
+ *   SELECT grp, COUNT(*), SUM(val) FROM bench_table WHERE k < 100 GROUP BY grp
+ *
+ * whose selectivity grows with the skew of k.
+ */
+class ScanWorkload : public BenchWorkload {
+ public:
+  explicit ScanWorkload(BenchTable *table) : table_(table) {}
+
+  std::string Name() const override { return "scan"; }
+  void Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) override;
+  void RunOperation(BenchWorker *worker) override;
+
+ private:
+  BenchTable *table_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tpcc_workload.cpp
+//
+// Identification: tools/bench/tpcc_workload.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "tpcc_workload.h"
+
+#include <utility>
+
+#include "execution/plans/insert_plan.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return an INTEGER value */
+Value Int(int32_t value) { return ValueFactory::GetIntegerValue(value); }
+
+/** Rolls back the transaction of the running operation, which the driver then aborts. */
+void Rollback(BenchWorker *worker) { worker->exec_ctx_->GetTransaction()->SetState(TransactionState::ABORTED); }
+
+/** @return a value drawn uniformly from [min, max] */
+int32_t Uniform(std::mt19937_64 *random, int32_t min, int32_t max) {
+  return std::uniform_int_distribution<int32_t>(min, max)(*random);
+}
+
+}  // namespace
+
+TpccWorkload::Table TpccWorkload::CreateTable(BustubInstance *instance, ExecutionEngine *engine,
+                                              ExecutorContext *exec_ctx, const std::string &name,
+                                              const std::vector<std::string> &columns,
+                                              std::vector<std::vector<Value>> *rows, bool indexed) {
+  std::vector<Column> schema_columns;
+  for (const auto &column : columns) {
+    schema_columns.emplace_back(column, TypeId::INTEGER);
+  }
+  Table table;
+  table.table_ = instance->catalog_->CreateTable(exec_ctx->GetTransaction(), name, Schema(schema_columns));
+  ::bustub::InsertRows(engine, exec_ctx, table.table_->oid_, rows);
+  if (indexed) {
+    // Created once the table is filled, so that the index is bulk loaded.
+    Schema key_schema({Column(columns[0], TypeId::INTEGER)});
+    table.index_ = instance->catalog_->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+        exec_ctx->GetTransaction(), name + "_key", name, table.table_->schema_, key_schema, {0}, 8);
+  }
+  return table;
+}
+
+void TpccWorkload::Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) {
+  ExecutorContext exec_ctx(txn, instance->catalog_, instance->buffer_pool_manager_, instance->transaction_manager_,
+                           instance->lock_manager_);
+  std::mt19937_64 random(0);
+  std::vector<std::vector<Value>> warehouses;
+  std::vector<std::vector<Value>> districts;
+  std::vector<std::vector<Value>> customers;
+  std::vector<std::vector<Value>> items;
+  std::vector<std::vector<Value>> stocks;
+  for (int32_t i_id = 0; i_id < NUM_ITEMS; i_id++) {
+    items.push_back({Int(i_id), Int(Uniform(&random, 100, 10000))});
+  }
+  for (int32_t w_id = 1; w_id <= num_warehouses_; w_id++) {
+    warehouses.push_back({Int(w_id), Int(Uniform(&random, 0, 2000)), Int(30000000)});
+    for (int32_t d_id = 0; d_id < DISTRICTS_PER_WAREHOUSE; d_id++) {
+      int32_t d_key = w_id * DISTRICTS_PER_WAREHOUSE + d_id;
+      districts.push_back({Int(d_key), Int(Uniform(&random, 0, 2000)), Int(3000000), Int(1)});
+      for (int32_t c_id = 0; c_id < CUSTOMERS_PER_DISTRICT; c_id++) {
+        int32_t c_key = d_key * CUSTOMERS_PER_DISTRICT + c_id;
+        customers.push_back({Int(c_key), Int(Uniform(&random, 0, 5000)), Int(-1000), Int(1000), Int(1)});
+      }
+    }
+    for (int32_t i_id = 0; i_id < NUM_ITEMS; i_id++) {
+      stocks.push_back({Int(w_id * NUM_ITEMS + i_id), Int(Uniform(&random, 10, 100)), Int(0), Int(0)});
+    }
+  }
+  std::vector<std::vector<Value>> none;
+  warehouse_ = CreateTable(instance, engine, &exec_ctx, "warehouse", {"w_id", "w_tax", "w_ytd"}, &warehouses, true);
+  district_ = CreateTable(instance, engine, &exec_ctx, "district", {"d_key", "d_tax", "d_ytd", "d_next_o_id"},
+                          &districts, true);
+  customer_ = CreateTable(instance, engine, &exec_ctx, "customer",
+                          {"c_key", "c_discount", "c_balance", "c_ytd_payment", "c_payment_cnt"}, &customers, true);
+  item_ = CreateTable(instance, engine, &exec_ctx, "item", {"i_id", "i_price"}, &items, true);
+  stock_ = CreateTable(instance, engine, &exec_ctx, "stock", {"s_key", "s_quantity", "s_ytd", "s_order_cnt"}, &stocks,
+                       true);
+  orders_ = CreateTable(instance, engine, &exec_ctx, "orders", {"o_w_id", "o_d_id", "o_id", "o_c_id", "o_ol_cnt"},
+                        &none, false);
+  new_order_ = CreateTable(instance, engine, &exec_ctx, "new_order", {"no_w_id", "no_d_id", "no_o_id"}, &none, false);
+  order_line_ = CreateTable(instance, engine, &exec_ctx, "order_line",
+                            {"ol_w_id", "ol_d_id", "ol_o_id", "ol_number", "ol_i_id", "ol_quantity", "ol_amount"},
+                            &none, false);
+  history_ = CreateTable(instance, engine, &exec_ctx, "history", {"h_c_key", "h_w_id", "h_d_id", "h_amount"}, &none,
+                         false);
+}
+
+bool TpccWorkload::ReadRow(BenchWorker *worker, const Table &table, int32_t key, std::vector<int32_t> *row) {
+  const AbstractPlanNode *scan_plan = worker->plans_.KeyScan(table.table_, table.index_, key, key);
+  std::vector<Tuple> result_set;
+  worker->Execute(scan_plan, &result_set);
+  if (result_set.empty()) {
+    return false;
+  }
+  const Schema *schema = scan_plan->OutputSchema();
+  row->clear();
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    row->push_back(result_set[0].GetValue(schema, i).GetAs<int32_t>());
+  }
+  return true;
+}
+
+void TpccWorkload::UpdateRow(BenchWorker *worker, const Table &table, int32_t key,
+                             const std::unordered_map<uint32_t, UpdateInfo> &update_attrs) {
+  UpdatePlanNode update_plan{worker->plans_.KeyScan(table.table_, table.index_, key, key), table.table_->oid_,
+                             update_attrs};
+  worker->Execute(&update_plan, nullptr);
+}
+
+void TpccWorkload::Insert(BenchWorker *worker, const Table &table, std::vector<std::vector<Value>> &&rows) {
+  InsertPlanNode insert_plan{std::move(rows), table.table_->oid_};
+  worker->Execute(&insert_plan, nullptr);
+}
+
+void TpccWorkload::NewOrder(BenchWorker *worker, int32_t w_id) {
+  std::mt19937_64 *random = &worker->random_;
+  int32_t d_id = Uniform(random, 0, DISTRICTS_PER_WAREHOUSE - 1);
+  int32_t d_key = w_id * DISTRICTS_PER_WAREHOUSE + d_id;
+  int32_t c_id = Uniform(random, 0, CUSTOMERS_PER_DISTRICT - 1);
+  int32_t ol_cnt = Uniform(random, 5, 15);
+  bool rollback = Uniform(random, 0, 99) == 0;
+
+  std::vector<int32_t> row;
+  if (!ReadRow(worker, warehouse_, w_id, &row)) {
+    return Rollback(worker);
+  }
+  // The order id is the next of the district, which the district then moves past.
+  if (!ReadRow(worker, district_, d_key, &row)) {
+    return Rollback(worker);
+  }
+  int32_t o_id = row[3];
+  UpdateRow(worker, district_, d_key, {{3, UpdateInfo(UpdateType::Add, 1)}});
+  if (!ReadRow(worker, customer_, d_key * CUSTOMERS_PER_DISTRICT + c_id, &row)) {
+    return Rollback(worker);
+  }
+  Insert(worker, orders_, {{Int(w_id), Int(d_id), Int(o_id), Int(c_id), Int(ol_cnt)}});
+  Insert(worker, new_order_, {{Int(w_id), Int(d_id), Int(o_id)}});
+
+  std::vector<std::vector<Value>> order_lines;
+  for (int32_t ol_number = 0; ol_number < ol_cnt; ol_number++) {
+    bool unused_item = rollback && ol_number == ol_cnt - 1;
+    int32_t i_id = unused_item ? NUM_ITEMS : Uniform(random, 0, NUM_ITEMS - 1);
+    int32_t quantity = Uniform(random, 1, 10);
+    if (!ReadRow(worker, item_, i_id, &row)) {
+      // An item that does not exist rolls the order back.
+      return Rollback(worker);
+    }
+    int32_t amount = quantity * row[1];
+    int32_t s_key = w_id * NUM_ITEMS + i_id;
+    if (!ReadRow(worker, stock_, s_key, &row)) {
+      return Rollback(worker);
+    }
+    int32_t s_quantity = row[1] >= quantity + 10 ? row[1] - quantity : row[1] - quantity + 91;
+    UpdateRow(worker, stock_, s_key,
+              {{1, UpdateInfo(UpdateType::Set, s_quantity)},
+               {2, UpdateInfo(UpdateType::Add, quantity)},
+               {3, UpdateInfo(UpdateType::Add, 1)}});
+    order_lines.push_back(
+        {Int(w_id), Int(d_id), Int(o_id), Int(ol_number), Int(i_id), Int(quantity), Int(amount)});
+  }
+  Insert(worker, order_line_, std::move(order_lines));
+}
+
+void TpccWorkload::Payment(BenchWorker *worker, int32_t w_id) {
+  std::mt19937_64 *random = &worker->random_;
+  int32_t d_id = Uniform(random, 0, DISTRICTS_PER_WAREHOUSE - 1);
+  int32_t d_key = w_id * DISTRICTS_PER_WAREHOUSE + d_id;
+  int32_t c_key = d_key * CUSTOMERS_PER_DISTRICT + Uniform(random, 0, CUSTOMERS_PER_DISTRICT - 1);
+  int32_t amount = Uniform(random, 100, 500000);
+
+  UpdateRow(worker, warehouse_, w_id, {{2, UpdateInfo(UpdateType::Add, amount)}});
+  UpdateRow(worker, district_, d_key, {{2, UpdateInfo(UpdateType::Add, amount)}});
+  UpdateRow(worker, customer_, c_key,
+            {{2, UpdateInfo(UpdateType::Add, -amount)},
+             {3, UpdateInfo(UpdateType::Add, amount)},
+             {4, UpdateInfo(UpdateType::Add, 1)}});
+  Insert(worker, history_, {{Int(c_key), Int(w_id), Int(d_id), Int(amount)}});
+}
+
+void TpccWorkload::RunOperation(BenchWorker *worker) {
+  auto w_id = static_cast<int32_t>(worker->id_ % num_warehouses_) + 1;
+  if (Uniform(&worker->random_, 0, 1) == 0) {
+    NewOrder(worker, w_id);
+  } else {
+    Payment(worker, w_id);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tpcc_workload.h
+//
+// Identification: tools/bench/tpcc_workload.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_driver.h"
+#include "execution/plans/update_plan.h"
+
+namespace bustub {
+
+/**
+ * A reduced TPC-C: the NewOrder and Payment transactions, half of the operations each, on a smaller schema of INTEGER
+ * columns, amounts in cents:
+ *
+ *   warehouse (w_id, w_tax, w_ytd)
+ *   district (d_key, d_tax, d_ytd, d_next_o_id)                       d_key = w_id * 10 + d_id
+ *   customer (c_key, c_discount, c_balance, c_ytd_payment, c_payment_cnt)   c_key = d_key * 300 + c_id
+ *   item (i_id, i_price)
+ *   stock (s_key, s_quantity, s_ytd, s_order_cnt)                     s_key = w_id * NUM_ITEMS + i_id
+ *   orders (o_w_id, o_d_id, o_id, o_c_id, o_ol_cnt)
+ *   new_order (no_w_id, no_d_id, no_o_id)
+ *   order_line (ol_w_id, ol_d_id, ol_o_id, ol_number, ol_i_id, ol_quantity, ol_amount)
+ *   history (h_c_key, h_w_id, h_d_id, h_amount)
+ *
+ * The tables read are indexed on their first column, a key flattening the composite key of TPC-C; the tables only
+ * inserted into have no index. Each worker runs the transactions of its home warehouse, so that contention grows with
+ * the threads per warehouse, on the districts and warehouses above all. There are fewer customers and items than in
+ * TPC-C, customers are picked by id only and all the items come from the home warehouse. 1% of the NewOrders order an
+ * item that does not exist and roll back, as in TPC-C; they count as aborts.
+ */
+class TpccWorkload : public BenchWorkload {
+ public:
+  static constexpr int32_t DISTRICTS_PER_WAREHOUSE = 10;
+  static constexpr int32_t CUSTOMERS_PER_DISTRICT = 300;
+  static constexpr int32_t NUM_ITEMS = 10000;
+
+  explicit TpccWorkload(int32_t num_warehouses) : num_warehouses_(num_warehouses) {}
+
+  std::string Name() const override { return "tpcc"; }
+  void Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) override;
+  void RunOperation(BenchWorker *worker) override;
+
+ private:
+  /** A table, and the index on its first column if it is read. */
+  struct Table {
+    TableMetadata *table_{nullptr};
+    IndexInfo *index_{nullptr};
+  };
+
+  /** Creates a table of INTEGER columns, fills it with rows, and indexes its first column if indexed. */
+  static Table CreateTable(BustubInstance *instance, ExecutionEngine *engine, ExecutorContext *exec_ctx,
+                           const std::string &name, const std::vector<std::string> &columns,
+                           std::vector<std::vector<Value>> *rows, bool indexed);
+
+  /** Reads the row of a key into row. @return false if there is none */
+  static bool ReadRow(BenchWorker *worker, const Table &table, int32_t key, std::vector<int32_t> *row);
+
+  /** Updates the row of a key. */
+  static void UpdateRow(BenchWorker *worker, const Table &table, int32_t key,
+                        const std::unordered_map<uint32_t, UpdateInfo> &update_attrs);
+
+  /** Inserts rows into a table. */
+  static void Insert(BenchWorker *worker, const Table &table, std::vector<std::vector<Value>> &&rows);
+
+  void NewOrder(BenchWorker *worker, int32_t w_id);
+  void Payment(BenchWorker *worker, int32_t w_id);
+
+  int32_t num_warehouses_;
+  Table warehouse_;
+  Table district_;
+  Table customer_;
+  Table item_;
+  Table stock_;
+  Table orders_;
+  Table new_order_;
+  Table order_line_;
+  Table history_;
+};
+
+}  // namespace bustub
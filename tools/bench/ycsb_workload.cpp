@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ycsb_workload.cpp
+//
+// Identification: tools/bench/ycsb_workload.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "ycsb_workload.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/update_plan.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** The largest value of a field. */
+constexpr int32_t MAX_FIELD_VALUE = 999999;
+
+}  // namespace
+
+YcsbTable::YcsbTable(uint32_t num_records, TableGenerator::Dist skew)
+    : num_records_(num_records), skew_(skew), next_key_(static_cast<int32_t>(num_records)) {
+  if (skew != TableGenerator::Dist::Uniform && num_records > 0) {
+    zipf_.emplace(0, num_records - 1, TableGenerator::ZipfTheta(skew));
+  }
+}
+
+void YcsbTable::Load(BustubInstance *instance, Transaction *txn) {
+  if (table_ != nullptr) {
+    return;
+  }
+  ExecutorContext exec_ctx(txn, instance->catalog_, instance->buffer_pool_manager_, instance->transaction_manager_,
+                           instance->lock_manager_);
+  TableGenerator gen{&exec_ctx};
+  std::vector<TableGenerator::ColumnInsertMeta> columns{
+      {"ycsb_key", TypeId::INTEGER, false, TableGenerator::Dist::Serial, 0, 0}};
+  static const char *field_names[NUM_FIELDS] = {"field0", "field1", "field2", "field3", "field4",
+                                                "field5", "field6", "field7", "field8", "field9"};
+  for (const char *field_name : field_names) {
+    columns.emplace_back(field_name, TypeId::INTEGER, false, TableGenerator::Dist::Uniform, 0, MAX_FIELD_VALUE);
+  }
+  TableGenerator::TableInsertMeta table_meta{"usertable", num_records_, std::move(columns)};
+  table_ = gen.GenerateTable(&table_meta);
+  Schema key_schema({Column("ycsb_key", TypeId::INTEGER)});
+  key_index_ = instance->catalog_->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      txn, "usertable_key", "usertable", table_->schema_, key_schema, {0}, 8);
+}
+
+uint64_t YcsbTable::PickRank(std::mt19937_64 *random) const {
+  if (zipf_.has_value()) {
+    // A copy, since drawing changes the state of the distribution and the workers share the table.
+    ZipfDistribution zipf = *zipf_;
+    return zipf(*random);
+  }
+  return std::uniform_int_distribution<uint64_t>(0, num_records_ - 1)(*random);
+}
+
+int32_t YcsbTable::PickKey(std::mt19937_64 *random) const {
+  uint64_t rank = PickRank(random);
+  if (!zipf_.has_value()) {
+    return static_cast<int32_t>(rank);
+  }
+  return static_cast<int32_t>(HashUtil::HashWords(rank, 0) % num_records_);
+}
+
+int32_t YcsbTable::PickLatestKey(std::mt19937_64 *random) const {
+  auto key = static_cast<int64_t>(next_key_.load()) - 1 - static_cast<int64_t>(PickRank(random));
+  return static_cast<int32_t>(std::max<int64_t>(key, 0));
+}
+
+YcsbWorkload::YcsbWorkload(YcsbTable *table, char kind) : table_(table), kind_(kind) {
+  switch (kind) {
+    case 'A':
+      read_percent_ = 50;
+      update_percent_ = 50;
+      break;
+    case 'B':
+      read_percent_ = 95;
+      update_percent_ = 5;
+      break;
+    case 'C':
+      read_percent_ = 100;
+      break;
+    case 'D':
+      read_percent_ = 95;
+      insert_percent_ = 5;
+      break;
+    case 'E':
+      scan_percent_ = 95;
+      insert_percent_ = 5;
+      break;
+    case 'F':
+      // The other half are read-modify-writes.
+      read_percent_ = 50;
+      break;
+    default:
+      UNREACHABLE("YCSB has the workloads A to F");
+  }
+}
+
+void YcsbWorkload::Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) {
+  table_->Load(instance, txn);
+}
+
+void YcsbWorkload::Read(BenchWorker *worker, int32_t key) {
+  std::vector<Tuple> result_set;
+  worker->Execute(worker->plans_.KeyScan(table_->table_, table_->key_index_, key, key), &result_set);
+}
+
+void YcsbWorkload::Update(BenchWorker *worker, int32_t key) {
+  std::mt19937_64 &random = worker->random_;
+  auto field = std::uniform_int_distribution<uint32_t>(1, YcsbTable::NUM_FIELDS)(random);
+  const std::unordered_map<uint32_t, UpdateInfo> update_attrs{
+      {field, UpdateInfo(UpdateType::Set, std::uniform_int_distribution<int32_t>(0, MAX_FIELD_VALUE)(random))}};
+  UpdatePlanNode update_plan{worker->plans_.KeyScan(table_->table_, table_->key_index_, key, key),
+                             table_->table_->oid_, update_attrs};
+  worker->Execute(&update_plan, nullptr);
+}
+
+void YcsbWorkload::RunOperation(BenchWorker *worker) {
+  std::mt19937_64 &random = worker->random_;
+  int percent = std::uniform_int_distribution<int>(0, 99)(random);
+  if (percent < read_percent_) {
+    Read(worker, kind_ == 'D' ? table_->PickLatestKey(&random) : table_->PickKey(&random));
+    return;
+  }
+  percent -= read_percent_;
+  if (percent < update_percent_) {
+    Update(worker, table_->PickKey(&random));
+    return;
+  }
+  percent -= update_percent_;
+  if (percent < insert_percent_) {
+    std::vector<std::vector<Value>> raw_values(1);
+    raw_values[0].push_back(ValueFactory::GetIntegerValue(table_->NextKey()));
+    for (uint32_t field = 0; field < YcsbTable::NUM_FIELDS; field++) {
+      raw_values[0].push_back(
+          ValueFactory::GetIntegerValue(std::uniform_int_distribution<int32_t>(0, MAX_FIELD_VALUE)(random)));
+    }
+    InsertPlanNode insert_plan{std::move(raw_values), table_->table_->oid_};
+    worker->Execute(&insert_plan, nullptr);
+    return;
+  }
+  percent -= insert_percent_;
+  int32_t key = table_->PickKey(&random);
+  if (percent < scan_percent_) {
+    int32_t length = std::uniform_int_distribution<int32_t>(1, MAX_SCAN_LENGTH)(random);
+    std::vector<Tuple> result_set;
+    worker->Execute(worker->plans_.KeyScan(table_->table_, table_->key_index_, key, key + length - 1), &result_set);
+    return;
+  }
+  // A read-modify-write, in one transaction.
+  Read(worker, key);
+  Update(worker, key);
+}
+
+}  // namespace bustub
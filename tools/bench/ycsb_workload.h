@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ycsb_workload.h
+//
+// Identification: tools/bench/ycsb_workload.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string>
+
+#include "bench_driver.h"
+#include "catalog/table_generator.h"
+#include "common/util/zipf_distribution.h"
+
+namespace bustub {
+
+/**
+ * The key-value table of YCSB, generated by TableGenerator:
+ *
+ *   usertable (ycsb_key INTEGER, field0 INTEGER, ..., field9 INTEGER), with a B+ tree index on ycsb_key
+ *
+ * The fields are integers rather than the strings of YCSB, since updates only set integers. The keys of the loaded
+ * records are serial; the operations pick them with the skew of the run, scrambled by a hash so that the hot keys
+ * spread over the table, like YCSB's scrambled Zipfian.
+ */
+class YcsbTable {
+ public:
+  static constexpr uint32_t NUM_FIELDS = 10;
+
+  YcsbTable(uint32_t num_records, TableGenerator::Dist skew);
+
+  /** Creates the table and its index and fills them; idempotent, so that all the workloads may load the table. */
+  void Load(BustubInstance *instance, Transaction *txn);
+
+  /** @return a key of the loaded records, drawn with the skew of the run */
+  int32_t PickKey(std::mt19937_64 *random) const;
+
+  /** @return a key drawn with the skew of the run from the most recently inserted ones, the latest the hottest */
+  int32_t PickLatestKey(std::mt19937_64 *random) const;
+
+  /** @return a new key, past those of all the records */
+  int32_t NextKey() { return next_key_++; }
+
+  uint32_t num_records_;
+  TableGenerator::Dist skew_;
+  TableMetadata *table_{nullptr};
+  IndexInfo *key_index_{nullptr};
+
+ private:
+  /** @return the rank of a key in popularity, the hottest first */
+  uint64_t PickRank(std::mt19937_64 *random) const;
+
+  std::optional<ZipfDistribution> zipf_;
+  std::atomic<int32_t> next_key_;
+};
+
+/**
+ * One of the core workloads of YCSB, A to F, on usertable:
+ *
+ *   A: 50% reads, 50% updates          D: 95% reads of the latest keys, 5% inserts
+ *   B: 95% reads, 5% updates           E: 95% scans of up to 100 keys, 5% inserts
+ *   C: 100% reads                      F: 50% reads, 50% read-modify-writes
+ *
+ * A read fetches a record by its key through the index, an update sets one field of a record.
+ */
+class YcsbWorkload : public BenchWorkload {
+ public:
+  /** @param kind the workload, 'A' to 'F' */
+  YcsbWorkload(YcsbTable *table, char kind);
+
+  std::string Name() const override { return std::string("ycsb-") + static_cast<char>(kind_ - 'A' + 'a'); }
+  void Load(BustubInstance *instance, ExecutionEngine *engine, Transaction *txn) override;
+  void RunOperation(BenchWorker *worker) override;
+
+  /** The longest scan of workload E. */
+  static constexpr int32_t MAX_SCAN_LENGTH = 100;
+
+ private:
+  /** Reads the record of a key. */
+  void Read(BenchWorker *worker, int32_t key);
+
+  /** Sets a field of the record of a key to a random value. */
+  void Update(BenchWorker *worker, int32_t key);
+
+  YcsbTable *table_;
+  char kind_;
+  /** The shares of the operations, in percent. */
+  int read_percent_{0};
+  int update_percent_{0};
+  int insert_percent_{0};
+  int scan_percent_{0};
+};
+
+}  // namespace bustub
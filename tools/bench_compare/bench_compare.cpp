@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_compare.cpp
+//
+// Identification: tools/bench_compare/bench_compare.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * bench_compare checks a report of bustub_bench --json against a baseline report, and prints, for each benchmark of
+ * either, its throughput in both and the change. It fails if the throughput of a benchmark of both fell by more than
+ * the threshold, 10% by default; the benchmarks only one of them has are listed but do not fail it.
+ *
+ *   bench_compare baseline.json bench.json --threshold=5
+ *
+ * The bench-check target runs it against the report of the bench target, see tools/bench/CMakeLists.txt.
+ */
+
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_report.h"
+
+namespace bustub {
+namespace {
+
+void Usage() { fprintf(stderr, "usage: bench_compare BASELINE_FILE CURRENT_FILE [--threshold=PERCENT]\n"); }
+
+/** Prints the comparison of two reports. @return the number of benchmarks whose throughput regressed */
+size_t Compare(const std::vector<BenchRecord> &baseline, const std::vector<BenchRecord> &current, double threshold) {
+  std::map<std::string, std::pair<const BenchRecord *, const BenchRecord *>> records;
+  for (const auto &record : baseline) {
+    records[record.name_].first = &record;
+  }
+  for (const auto &record : current) {
+    records[record.name_].second = &record;
+  }
+
+  size_t num_regressed = 0;
+  printf("%-48s %14s %14s %9s\n", "benchmark", "baseline ops/s", "current ops/s", "change %");
+  for (const auto &[name, pair] : records) {
+    const auto &[before, after] = pair;
+    if (before == nullptr || after == nullptr) {
+      printf("%-48s %14s %14s %9s\n", name.c_str(), before == nullptr ? "-" : "", after == nullptr ? "-" : "",
+             before == nullptr ? "new" : "missing");
+      continue;
+    }
+    double change = before->throughput_ == 0 ? 0 : (after->throughput_ / before->throughput_ - 1) * 100;
+    bool regressed = change < -threshold;
+    num_regressed += regressed ? 1 : 0;
+    printf("%-48s %14.0f %14.0f %+9.1f%s\n", name.c_str(), before->throughput_, after->throughput_, change,
+           regressed ? "  REGRESSION" : "");
+  }
+  return num_regressed;
+}
+
+}  // namespace
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    bustub::Usage();
+    return 1;
+  }
+  double threshold = 10;
+  for (int i = 3; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 12, "--threshold=") != 0) {
+      bustub::Usage();
+      return 1;
+    }
+    try {
+      threshold = std::stod(arg.substr(12));
+    } catch (const std::logic_error &e) {
+      bustub::Usage();
+      return 1;
+    }
+  }
+
+  std::vector<bustub::BenchRecord> baseline;
+  std::vector<bustub::BenchRecord> current;
+  for (int i = 1; i <= 2; i++) {
+    if (!bustub::BenchReport::ReadJson(argv[i], i == 1 ? &baseline : &current)) {
+      fprintf(stderr, "can't read the report %s\n", argv[i]);
+      return 1;
+    }
+  }
+  size_t num_regressed = bustub::Compare(baseline, current, threshold);
+  if (num_regressed > 0) {
+    fprintf(stderr, "%zu benchmarks regressed by more than %.1f%%\n", num_regressed, threshold);
+    return 1;
+  }
+  return 0;
+}
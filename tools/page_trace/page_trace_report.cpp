@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_trace_report.cpp
+//
+// Identification: tools/page_trace/page_trace_report.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * page_trace_report reads a trace of page accesses written by PageTrace::Write, e.g. by bustub_bench --page-trace,
+ * and prints, for the whole trace and for each table and index:
+ *
+ *   - the hit ratio of the buffer pool that ran the trace, and that of an LRU pool of each of the given sizes,
+ *   - the histogram of the reuse distances of the accesses, in powers of two,
+ *   - the working set size, the distinct pages accessed in windows of a growing number of accesses.
+ *
+ *   page_trace_report bustub_bench.trace --pool-sizes=256,1024,4096
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "buffer/page_access_trace.h"
+#include "buffer/reuse_distance.h"
+
+namespace bustub {
+namespace {
+
+void Usage() { fprintf(stderr, "usage: page_trace_report TRACE_FILE [--pool-sizes=N,N,...]\n"); }
+
+std::string OwnerName(const PageTrace &trace, page_id_t owner) {
+  if (owner == INVALID_PAGE_ID) {
+    return "(none)";
+  }
+  auto iter = trace.owner_names_.find(owner);
+  return iter == trace.owner_names_.end() ? "page " + std::to_string(owner) : iter->second;
+}
+
+double ObservedHitRatio(const PageTrace &trace, page_id_t owner, bool all) {
+  uint64_t num_accesses = 0;
+  uint64_t num_hits = 0;
+  for (const PageAccess &access : trace.accesses_) {
+    if (all || access.owner_ == owner) {
+      num_accesses++;
+      num_hits += access.hit_ ? 1 : 0;
+    }
+  }
+  return num_accesses == 0 ? 0 : static_cast<double>(num_hits) / static_cast<double>(num_accesses);
+}
+
+void PrintReport(const PageTrace &trace, const std::vector<size_t> &pool_sizes) {
+  ReuseAnalysis analysis(trace.accesses_);
+  std::vector<std::pair<std::string, const ReuseProfile *>> profiles{{"(all)", &analysis.total_}};
+  std::vector<double> observed{ObservedHitRatio(trace, INVALID_PAGE_ID, true)};
+  for (const auto &[owner, profile] : analysis.owners_) {
+    profiles.emplace_back(OwnerName(trace, owner), &profile);
+    observed.push_back(ObservedHitRatio(trace, owner, false));
+  }
+  uint64_t num_accesses = analysis.total_.num_accesses_;
+
+  printf("hit ratio, in %%: observed, then of an LRU pool of each size\n");
+  printf("%-24s %10s %8s %9s", "object", "accesses", "pages", "observed");
+  for (size_t pool_size : pool_sizes) {
+    printf(" %9zu", pool_size);
+  }
+  printf("\n");
+  for (size_t i = 0; i < profiles.size(); i++) {
+    const ReuseProfile &profile = *profiles[i].second;
+    printf("%-24s %10" PRIu64 " %8" PRIu64 " %9.2f", profiles[i].first.c_str(), profile.num_accesses_,
+           profile.num_cold_, observed[i] * 100);
+    for (size_t pool_size : pool_sizes) {
+      printf(" %9.2f", profile.HitRatio(pool_size) * 100);
+    }
+    printf("\n");
+  }
+
+  printf("\nreuse distance histogram: accesses by distance, in [2^(i-1), 2^i); cold accesses apart\n");
+  for (const auto &[name, profile] : profiles) {
+    printf("%-24s cold=%" PRIu64, name.c_str(), profile->num_cold_);
+    std::vector<uint64_t> histogram = profile->DistanceLog2Histogram();
+    for (size_t bucket = 0; bucket < histogram.size(); bucket++) {
+      printf(" <%" PRIu64 "=%" PRIu64, uint64_t{1} << bucket, histogram[bucket]);
+    }
+    printf("\n");
+  }
+
+  printf("\nworking set size: distinct pages in a window of accesses\n");
+  printf("%-24s", "window");
+  std::vector<uint64_t> windows;
+  for (uint64_t window = 1; window <= num_accesses; window *= 4) {
+    windows.push_back(window);
+    printf(" %10" PRIu64, window);
+  }
+  printf("\n");
+  for (const auto &[name, profile] : profiles) {
+    printf("%-24s", name.c_str());
+    for (uint64_t window : windows) {
+      printf(" %10.1f", profile->WorkingSetSize(window, num_accesses));
+    }
+    printf("\n");
+  }
+}
+
+}  // namespace
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    bustub::Usage();
+    return 1;
+  }
+  std::vector<size_t> pool_sizes{64, 256, 1024, 4096, 16384};
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 13, "--pool-sizes=") != 0) {
+      bustub::Usage();
+      return 1;
+    }
+    pool_sizes.clear();
+    std::stringstream list(arg.substr(13));
+    std::string size;
+    try {
+      while (std::getline(list, size, ',')) {
+        pool_sizes.push_back(std::stoul(size));
+      }
+    } catch (const std::logic_error &e) {
+      bustub::Usage();
+      return 1;
+    }
+  }
+
+  bustub::PageTrace trace;
+  if (!bustub::PageTrace::Read(argv[1], &trace)) {
+    fprintf(stderr, "can't read the trace %s\n", argv[1]);
+    return 1;
+  }
+  bustub::PrintReport(trace, pool_sizes);
+  return 0;
+}